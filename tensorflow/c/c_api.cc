@@ -2318,6 +2318,51 @@ void TF_SessionRun(TF_Session* session, const TF_Buffer* run_options,
                 status);
 }
 
+void TF_SessionRunWithPreallocatedOutputs(
+    TF_Session* session, const TF_Buffer* run_options, const TF_Output* inputs,
+    TF_Tensor* const* input_values, int ninputs, const TF_Output* outputs,
+    TF_Tensor** output_values, int noutputs,
+    const TF_Operation* const* target_opers, int ntargets,
+    TF_Buffer* run_metadata, TF_Status* status) {
+  // Run into fresh tensors, which share the buffers of the fetched tensors,
+  // and only then move the results into the caller's tensors, so that these
+  // are left unmodified on failure.
+  std::vector<TF_Tensor*> fetched(noutputs, nullptr);
+  TF_SessionRun(session, run_options, inputs, input_values, ninputs, outputs,
+                fetched.data(), noutputs, target_opers, ntargets, run_metadata,
+                status);
+  if (!status->status.ok()) {
+    for (int i = 0; i < noutputs; ++i) {
+      if (fetched[i] != nullptr) TF_DeleteTensor(fetched[i]);
+    }
+    return;
+  }
+
+  for (int i = 0; i < noutputs; ++i) {
+    TF_Tensor* src = fetched[i];
+    TF_Tensor* dst = output_values[i];
+    if (dst == nullptr) {
+      output_values[i] = src;
+      continue;
+    }
+    if (dst->dtype == src->dtype && dst->dtype != TF_STRING &&
+        dst->shape == src->shape &&
+        dst->buffer->size() == src->buffer->size()) {
+      if (src->buffer->size() > 0) {
+        std::memcpy(dst->buffer->data(), src->buffer->data(),
+                    src->buffer->size());
+      }
+    } else {
+      // Hand the fetched buffer over to the caller's tensor; the caller's
+      // previous buffer is released with 'src' below.
+      std::swap(dst->dtype, src->dtype);
+      std::swap(dst->shape, src->shape);
+      std::swap(dst->buffer, src->buffer);
+    }
+    TF_DeleteTensor(src);
+  }
+}
+
 void TF_SessionPRunSetup(TF_Session* session, const TF_Output* inputs,
                          int ninputs, const TF_Output* outputs, int noutputs,
                          const TF_Operation* const* target_opers, int ntargets,
@@ -1093,6 +1093,39 @@ TF_CAPI_EXPORT extern void TF_SessionRun(
     // Output status
     TF_Status*);
 
+// Like TF_SessionRun, but output_values[] may hold tensors preallocated by the
+// caller, which are reused instead of allocating new ones.
+//
+// For each i in [0, noutputs-1]:
+//    - If output_values[i] is NULL, a new tensor is placed in output_values[i]
+//      exactly as TF_SessionRun does, and ownership is transferred to the
+//      caller.
+//    - If output_values[i] is non-NULL and has the same type, shape, and byte
+//      size as the fetched tensor (and the type is not TF_STRING), the fetched
+//      values are written into the data buffer of output_values[i].
+//    - Otherwise, output_values[i] is updated in place to share (without
+//      copying) the buffer of the fetched tensor, and its previous buffer is
+//      released. Any pointer previously returned by TF_TensorData for it is
+//      invalidated.
+//
+// The caller retains ownership of the tensors it passes in output_values[].
+// On failure, those tensors are left unmodified, and the remaining elements
+// of output_values[] are NULL.
+TF_CAPI_EXPORT extern void TF_SessionRunWithPreallocatedOutputs(
+    TF_Session* session,
+    // RunOptions
+    const TF_Buffer* run_options,
+    // Input tensors
+    const TF_Output* inputs, TF_Tensor* const* input_values, int ninputs,
+    // Output tensors
+    const TF_Output* outputs, TF_Tensor** output_values, int noutputs,
+    // Target operations
+    const TF_Operation* const* target_opers, int ntargets,
+    // RunMetadata
+    TF_Buffer* run_metadata,
+    // Output status
+    TF_Status*);
+
 // Set up the graph with the intended feeds (inputs) and fetches (outputs) for a
 // sequence of partial run calls.
 //
@@ -1044,6 +1044,67 @@ TEST(CAPI, Session) {
   TF_DeleteStatus(s);
 }
 
+TEST(CAPI, SessionRunWithPreallocatedOutputs) {
+  TF_Status* s = TF_NewStatus();
+  TF_Graph* graph = TF_NewGraph();
+
+  // Construct the graph: 2, A + 2 and -(A + 2).
+  TF_Operation* feed = Placeholder(graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* two = ScalarConst(2, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* add = Add(feed, two, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_Operation* neg = Neg(add, graph, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  TF_SessionOptions* opts = TF_NewSessionOptions();
+  TF_Session* sess = TF_NewSession(graph, opts, s);
+  TF_DeleteSessionOptions(opts);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  TF_Output feeds[] = {TF_Output{feed, 0}};
+  TF_Output fetches[] = {TF_Output{add, 0}, TF_Output{neg, 0},
+                         TF_Output{two, 0}};
+  TF_Tensor* feed_values[] = {Int32Tensor(5)};
+  // The first output matches the fetched tensor and is written into, the
+  // second has a different shape and is updated to share the fetched buffer,
+  // and the third is allocated by the run.
+  TF_Tensor* matching = Int32Tensor(0);
+  void* matching_data = TF_TensorData(matching);
+  const int64_t dims[] = {2};
+  TF_Tensor* mismatched =
+      TF_AllocateTensor(TF_INT32, dims, 1, 2 * sizeof(int32));
+  TF_Tensor* fetch_values[] = {matching, mismatched, nullptr};
+  TF_SessionRunWithPreallocatedOutputs(
+      sess, nullptr, feeds, feed_values, 1, fetches, fetch_values, 3, nullptr,
+      0, nullptr, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+
+  EXPECT_EQ(matching, fetch_values[0]);
+  EXPECT_EQ(matching_data, TF_TensorData(matching));
+  EXPECT_EQ(7, *static_cast<int32*>(TF_TensorData(matching)));
+
+  EXPECT_EQ(mismatched, fetch_values[1]);
+  EXPECT_EQ(TF_INT32, TF_TensorType(mismatched));
+  EXPECT_EQ(0, TF_NumDims(mismatched));
+  ASSERT_EQ(sizeof(int32), TF_TensorByteSize(mismatched));
+  EXPECT_EQ(-7, *static_cast<int32*>(TF_TensorData(mismatched)));
+
+  ASSERT_TRUE(fetch_values[2] != nullptr);
+  EXPECT_EQ(2, *static_cast<int32*>(TF_TensorData(fetch_values[2])));
+
+  // Clean up.
+  TF_DeleteTensor(feed_values[0]);
+  for (TF_Tensor* t : fetch_values) TF_DeleteTensor(t);
+  TF_CloseSession(sess, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteSession(sess, s);
+  ASSERT_EQ(TF_OK, TF_GetCode(s)) << TF_Message(s);
+  TF_DeleteGraph(graph);
+  TF_DeleteStatus(s);
+}
+
 TEST(CAPI, SessionPRun) {
   TF_Status* s = TF_NewStatus();
   TF_Graph* graph = TF_NewGraph();
@@ -45,6 +45,11 @@ constexpr char kSavedModelVariablesDirectory[] = "variables";
 /// SavedModel variables filename.
 constexpr char kSavedModelVariablesFilename[] = "variables";
 
+/// SavedModel warmup filename, in the assets.extra directory. The file is a
+/// TFRecord file of serialized RunStepRequest protos, which are replayed
+/// through the session right after the SavedModel is loaded.
+constexpr char kSavedModelWarmupFilename[] = "tf_warmup_requests";
+
 }  // namespace tensorflow
 
 #endif  // THIRD_PARTY_TENSORFLOW_CC_SAVED_MODEL_CONSTANTS_H_
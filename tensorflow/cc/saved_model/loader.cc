@@ -15,19 +15,26 @@ limitations under the License.
 
 #include "tensorflow/cc/saved_model/loader.h"
 
+#include <unordered_map>
 #include <unordered_set>
 
 #include "tensorflow/cc/saved_model/constants.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/protobuf_internal.h"
+#include "tensorflow/core/protobuf/master.pb.h"
 #include "tensorflow/core/protobuf/saved_model.pb.h"
 #include "tensorflow/core/protobuf/saver.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow/core/util/tensor_bundle/naming.h"
+#include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
 
 namespace tensorflow {
 namespace {
@@ -40,6 +47,10 @@ auto* load_latency = monitoring::Counter<1>::New(
     "/tensorflow/cc/saved_model/load_latency",
     "Latency in microseconds for SavedModels that were successfully loaded.",
     "model_path");
+auto* warmup_latency = monitoring::Counter<1>::New(
+    "/tensorflow/cc/saved_model/warmup_latency",
+    "Latency in microseconds for running the warmup requests of SavedModels.",
+    "model_path");
 constexpr char kLoadAttemptFail[] = "fail";
 constexpr char kLoadAttemptSuccess[] = "success";
 
@@ -147,10 +158,89 @@ Status RunMainOp(const RunOptions& run_options, const string& export_dir,
   return Status::OK();
 }
 
+// Looks up the value of the Const node that 'input' refers to in 'nodes'.
+// Returns false if 'input' is not the output of a Const node.
+bool GetConstInput(const std::unordered_map<string, const NodeDef*>& nodes,
+                   const string& input, Tensor* value) {
+  StringPiece node_name(input);
+  if (node_name.Consume("^")) {
+    return false;
+  }
+  const size_t colon = node_name.rfind(':');
+  if (colon != StringPiece::npos) {
+    if (node_name.substr(colon + 1) != "0") {
+      return false;
+    }
+    node_name = node_name.substr(0, colon);
+  }
+  const auto it = nodes.find(node_name.ToString());
+  if (it == nodes.end() || it->second->op() != "Const") {
+    return false;
+  }
+  const auto value_it = it->second->attr().find("value");
+  return value_it != it->second->attr().end() &&
+         value->FromProto(value_it->second.tensor());
+}
+
+// Adds feeds to 'inputs' that replace the outputs of the RestoreV2 ops in
+// 'graph_def' with tensors aliasing memory mappings of the checkpoint at
+// 'variables_path'. RestoreV2 ops that don't restore full tensors by constant
+// names, or whose tensors can't be looked up, are left to run and report their
+// own errors.
+Status AddMappedRestoreFeeds(const GraphDef& graph_def,
+                             const string& variables_path,
+                             std::vector<std::pair<string, Tensor>>* inputs) {
+  std::unordered_map<string, const NodeDef*> nodes;
+  for (const NodeDef& node : graph_def.node()) {
+    nodes[node.name()] = &node;
+  }
+  BundleReader reader(Env::Default(), variables_path);
+  TF_RETURN_IF_ERROR(reader.status());
+  int num_mapped_ops = 0;
+  for (const NodeDef& node : graph_def.node()) {
+    if (node.op() != "RestoreV2" || node.input_size() < 3) {
+      continue;
+    }
+    Tensor tensor_names;
+    Tensor shape_and_slices;
+    std::vector<DataType> dtypes;
+    if (!GetConstInput(nodes, node.input(1), &tensor_names) ||
+        !GetConstInput(nodes, node.input(2), &shape_and_slices) ||
+        !GetNodeAttr(node, "dtypes", &dtypes).ok() ||
+        tensor_names.dtype() != DT_STRING ||
+        shape_and_slices.dtype() != DT_STRING ||
+        tensor_names.NumElements() != dtypes.size() ||
+        shape_and_slices.NumElements() != dtypes.size()) {
+      continue;
+    }
+    const auto names_flat = tensor_names.flat<string>();
+    const auto slices_flat = shape_and_slices.flat<string>();
+    std::vector<Tensor> restored(dtypes.size());
+    bool mappable = true;
+    for (int i = 0; mappable && i < dtypes.size(); ++i) {
+      mappable = slices_flat(i).empty() &&
+                 reader.LookupAliased(names_flat(i), &restored[i]).ok() &&
+                 restored[i].dtype() == dtypes[i];
+    }
+    if (!mappable) {
+      continue;
+    }
+    for (int i = 0; i < restored.size(); ++i) {
+      inputs->push_back({strings::StrCat(node.name(), ":", i), restored[i]});
+    }
+    ++num_mapped_ops;
+  }
+  LOG(INFO) << "Restoring the outputs of " << num_mapped_ops
+            << " RestoreV2 ops from memory mapped variables.";
+  return Status::OK();
+}
+
 Status RunRestore(const RunOptions& run_options, const string& export_dir,
                   const StringPiece restore_op_name,
                   const StringPiece variable_filename_const_op_name,
                   const std::vector<AssetFileDef>& asset_file_defs,
+                  const GraphDef& graph_def,
+                  const SavedModelLoadOptions& load_options,
                   Session* session) {
   LOG(INFO) << "Restoring SavedModel bundle.";
   // Find path to variables to be restored in export directory.
@@ -178,6 +268,11 @@ Status RunRestore(const RunOptions& run_options, const string& export_dir,
 
   AddAssetsTensorsToInputs(export_dir, asset_file_defs, &inputs);
 
+  if (load_options.map_variables) {
+    TF_RETURN_IF_ERROR(
+        AddMappedRestoreFeeds(graph_def, variables_path, &inputs));
+  }
+
   RunMetadata run_metadata;
   return session->Run(run_options, inputs, {}, {restore_op_name.ToString()},
                       nullptr /* outputs */, &run_metadata);
@@ -207,6 +302,112 @@ Status RunLegacyInitOp(const RunOptions& run_options, const string& export_dir,
   return Status::OK();
 }
 
+Status ReadWarmupRequests(const string& warmup_path,
+                          std::vector<RunStepRequest>* requests) {
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(Env::Default()->NewRandomAccessFile(warmup_path, &file));
+  io::RecordReader reader(file.get());
+  uint64 offset = 0;
+  string record;
+  while (true) {
+    const Status status = reader.ReadRecord(&offset, &record);
+    if (errors::IsOutOfRange(status)) {
+      return Status::OK();
+    }
+    TF_RETURN_IF_ERROR(status);
+    requests->emplace_back();
+    if (!requests->back().ParseFromString(record)) {
+      return errors::DataLoss("Unable to parse warmup request ",
+                              requests->size() - 1, " in ", warmup_path);
+    }
+  }
+}
+
+Status RunWarmupRequest(const RunOptions& run_options,
+                        const RunStepRequest& request, Session* session) {
+  if (!request.partial_run_handle().empty()) {
+    return errors::InvalidArgument(
+        "Partial runs are not supported as warmup requests");
+  }
+  std::vector<std::pair<string, Tensor>> inputs;
+  for (const NamedTensorProto& feed : request.feed()) {
+    Tensor tensor;
+    if (!tensor.FromProto(feed.tensor())) {
+      return errors::InvalidArgument("Invalid tensor for warmup feed ",
+                                     feed.name());
+    }
+    inputs.emplace_back(feed.name(), tensor);
+  }
+  const std::vector<string> output_tensor_names(request.fetch().begin(),
+                                                request.fetch().end());
+  const std::vector<string> target_node_names(request.target().begin(),
+                                              request.target().end());
+  std::vector<Tensor> outputs;
+  RunMetadata run_metadata;
+  return session->Run(run_options, inputs, output_tensor_names,
+                      target_node_names, &outputs, &run_metadata);
+}
+
+Status RunWarmup(const RunOptions& run_options, const string& export_dir,
+                 const SavedModelLoadOptions& load_options, Session* session) {
+  const string warmup_path =
+      io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory,
+                   kSavedModelWarmupFilename);
+  if (!load_options.run_warmup ||
+      !Env::Default()->FileExists(warmup_path).ok()) {
+    return Status::OK();
+  }
+  if (load_options.num_warmup_threads < 1) {
+    return errors::InvalidArgument("num_warmup_threads must be positive; was ",
+                                   load_options.num_warmup_threads);
+  }
+  const uint64 start_microseconds = Env::Default()->NowMicros();
+  std::vector<RunStepRequest> requests;
+  TF_RETURN_IF_ERROR(ReadWarmupRequests(warmup_path, &requests));
+  LOG(INFO) << "Running " << requests.size()
+            << " warmup requests on SavedModel bundle.";
+
+  mutex mu;
+  Status status;
+  {
+    std::unique_ptr<thread::ThreadPool> pool;
+    if (load_options.num_warmup_threads > 1) {
+      pool.reset(new thread::ThreadPool(Env::Default(), "saved_model_warmup",
+                                        load_options.num_warmup_threads));
+    }
+    for (const RunStepRequest& request : requests) {
+      auto run_request = [&run_options, &request, session, &mu, &status]() {
+        const Status request_status =
+            RunWarmupRequest(run_options, request, session);
+        mutex_lock l(mu);
+        status.Update(request_status);
+      };
+      if (pool != nullptr) {
+        pool->Schedule(run_request);
+      } else {
+        run_request();
+      }
+    }
+    // Destroying the pool waits for the scheduled requests to finish.
+  }
+
+  const uint64 end_microseconds = Env::Default()->NowMicros();
+  // Avoid clock skew.
+  const uint64 warmup_latency_microsecs =
+      end_microseconds < start_microseconds
+          ? 0
+          : end_microseconds - start_microseconds;
+  LOG(INFO) << "Running warmup requests on SavedModel bundle took "
+            << warmup_latency_microsecs << " microseconds.";
+  warmup_latency->GetCell(export_dir)->IncrementBy(warmup_latency_microsecs);
+  if (!status.ok()) {
+    return Status(status.code(),
+                  strings::StrCat("Failed to run a warmup request of ",
+                                  export_dir, ": ", status.error_message()));
+  }
+  return Status::OK();
+}
+
 Status GetAssetFileDefs(const MetaGraphDef& meta_graph_def,
                         std::vector<AssetFileDef>* asset_file_defs) {
   const auto& collection_def_map = meta_graph_def.collection_def();
@@ -228,6 +429,7 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
                               const RunOptions& run_options,
                               const string& export_dir,
                               const std::unordered_set<string>& tags,
+                              const SavedModelLoadOptions& load_options,
                               SavedModelBundle* const bundle) {
   if (!MaybeSavedModelDirectory(export_dir)) {
     return Status(error::Code::NOT_FOUND,
@@ -251,7 +453,8 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
       RunRestore(run_options, export_dir,
                  bundle->meta_graph_def.saver_def().restore_op_name(),
                  bundle->meta_graph_def.saver_def().filename_tensor_name(),
-                 asset_file_defs, bundle->session.get()));
+                 asset_file_defs, bundle->meta_graph_def.graph_def(),
+                 load_options, bundle->session.get()));
   if (HasMainOp(bundle->meta_graph_def)) {
     TF_RETURN_IF_ERROR(RunMainOp(run_options, export_dir,
                                  bundle->meta_graph_def, asset_file_defs,
@@ -261,6 +464,8 @@ Status LoadSavedModelInternal(const SessionOptions& session_options,
                                        bundle->meta_graph_def, asset_file_defs,
                                        bundle->session.get()));
   }
+  TF_RETURN_IF_ERROR(RunWarmup(run_options, export_dir, load_options,
+                               bundle->session.get()));
   return Status::OK();
 }
 
@@ -270,10 +475,19 @@ Status LoadSavedModel(const SessionOptions& session_options,
                       const RunOptions& run_options, const string& export_dir,
                       const std::unordered_set<string>& tags,
                       SavedModelBundle* const bundle) {
+  return LoadSavedModel(session_options, run_options, export_dir, tags,
+                        SavedModelLoadOptions(), bundle);
+}
+
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options, const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      const SavedModelLoadOptions& load_options,
+                      SavedModelBundle* const bundle) {
   // TODO(robson): Add tests for the counters.
   const uint64 start_microseconds = Env::Default()->NowMicros();
-  const Status status = LoadSavedModelInternal(session_options, run_options,
-                                               export_dir, tags, bundle);
+  const Status status = LoadSavedModelInternal(
+      session_options, run_options, export_dir, tags, load_options, bundle);
   const uint64 load_latency_microsecs = [&]() -> uint64 {
     const uint64 end_microseconds = Env::Default()->NowMicros();
     // Avoid clock skew.
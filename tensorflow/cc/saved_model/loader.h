@@ -43,6 +43,28 @@ struct SavedModelBundle {
   SavedModelBundle() = default;
 };
 
+/// Options for loading a SavedModel, in addition to the session options.
+struct SavedModelLoadOptions {
+  /// If true, the variables are restored from tensors that alias read-only
+  /// memory mappings of the variables' data files, instead of from buffers the
+  /// restore op reads the whole checkpoint into. The variables still receive
+  /// their own copy of the data when they are assigned, but the checkpoint is
+  /// no longer held in memory twice while loading. String, partitioned and
+  /// misaligned tensors, and data files the Env can't map, are read as usual.
+  bool map_variables = false;
+
+  /// If true and the SavedModel has a warmup file (see
+  /// kSavedModelWarmupFilename), its requests are run before LoadSavedModel
+  /// returns, so that the first real requests don't pay for executor creation,
+  /// kernel construction or autotuning. The requests are run with the load's
+  /// RunOptions, and their outputs are discarded. A failing request fails the
+  /// load.
+  bool run_warmup = true;
+
+  /// The number of warmup requests to run concurrently.
+  int num_warmup_threads = 1;
+};
+
 /// Loads a SavedModel from the specified export directory. The meta graph def
 /// to be loaded is identified by the supplied tags, corresponding exactly to
 /// the set of tags used at SavedModel build time. Returns a SavedModel bundle
@@ -52,6 +74,13 @@ Status LoadSavedModel(const SessionOptions& session_options,
                       const std::unordered_set<string>& tags,
                       SavedModelBundle* const bundle);
 
+/// Like the above, with additional load options.
+Status LoadSavedModel(const SessionOptions& session_options,
+                      const RunOptions& run_options, const string& export_dir,
+                      const std::unordered_set<string>& tags,
+                      const SavedModelLoadOptions& load_options,
+                      SavedModelBundle* const bundle);
+
 /// Checks whether the provided directory could contain a SavedModel. Note that
 /// the method does not load any data by itself. If the method returns `false`,
 /// the export directory definitely does not contain a SavedModel. If the method
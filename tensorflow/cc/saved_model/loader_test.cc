@@ -24,7 +24,10 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/master.pb.h"
 
 namespace tensorflow {
 namespace {
@@ -91,6 +94,58 @@ class LoaderTest : public ::testing::Test {
         outputs[0],
         test::AsTensor<float>({2, 2.5, 3, 3.5}, TensorShape({4, 1})));
   }
+
+  // Returns a warmup request for the regression signature of 'bundle'.
+  RunStepRequest MakeWarmupRequest(const SavedModelBundle& bundle) {
+    const auto& signature_def =
+        bundle.meta_graph_def.signature_def().at("regress_x_to_y");
+    RunStepRequest request;
+    NamedTensorProto* feed = request.add_feed();
+    feed->set_name(signature_def.inputs().at(kRegressInputs).name());
+    test::AsTensor<string>({MakeSerializedExample(1)}, TensorShape({1}))
+        .AsProtoTensorContent(feed->mutable_tensor());
+    request.add_fetch(signature_def.outputs().at(kRegressOutputs).name());
+    return request;
+  }
+
+  // Copies the sharded test SavedModel to a temporary 'name' directory, adds a
+  // warmup file with 'requests' to it, and returns the copy's directory.
+  string CopyWithWarmupRequests(const string& name,
+                                const std::vector<RunStepRequest>& requests) {
+    Env* env = Env::Default();
+    const string source_dir =
+        io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+    const string export_dir = io::JoinPath(testing::TmpDir(), name);
+    for (const string& dir :
+         {kSavedModelAssetsDirectory, kSavedModelAssetsExtraDirectory,
+          kSavedModelVariablesDirectory}) {
+      TF_CHECK_OK(env->RecursivelyCreateDir(io::JoinPath(export_dir, dir)));
+    }
+    for (const string& filename :
+         {string(kSavedModelFilenamePb),
+          io::JoinPath(kSavedModelAssetsDirectory, "foo.txt"),
+          io::JoinPath(kSavedModelVariablesDirectory, "variables.index"),
+          io::JoinPath(kSavedModelVariablesDirectory,
+                       "variables.data-00000-of-00001")}) {
+      string contents;
+      TF_CHECK_OK(ReadFileToString(env, io::JoinPath(source_dir, filename),
+                                   &contents));
+      TF_CHECK_OK(WriteStringToFile(env, io::JoinPath(export_dir, filename),
+                                    contents));
+    }
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(
+        io::JoinPath(export_dir, kSavedModelAssetsExtraDirectory,
+                     kSavedModelWarmupFilename),
+        &file));
+    io::RecordWriter writer(file.get());
+    for (const RunStepRequest& request : requests) {
+      TF_CHECK_OK(writer.WriteRecord(request.SerializeAsString()));
+    }
+    TF_CHECK_OK(writer.Flush());
+    TF_CHECK_OK(file->Close());
+    return export_dir;
+  }
 };
 
 // Test for resource leaks related to TensorFlow session closing requirements
@@ -111,6 +166,68 @@ TEST_F(LoaderTest, ResourceLeakTest) {
   }
 }
 
+TEST_F(LoaderTest, MapVariables) {
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+  SavedModelLoadOptions load_options;
+  load_options.map_variables = true;
+
+  for (const char* test_data : {kTestDataSharded, kTestDataMainOp}) {
+    const string export_dir =
+        io::JoinPath(testing::TensorFlowSrcRoot(), test_data);
+    TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                                {kSavedModelTagServe}, load_options, &bundle));
+    CheckSavedModelBundle(export_dir, bundle);
+  }
+}
+
+TEST_F(LoaderTest, Warmup) {
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+
+  const string source_dir =
+      io::JoinPath(testing::TensorFlowSrcRoot(), kTestDataSharded);
+  TF_ASSERT_OK(LoadSavedModel(session_options, run_options, source_dir,
+                              {kSavedModelTagServe}, &bundle));
+  const std::vector<RunStepRequest> requests(4, MakeWarmupRequest(bundle));
+
+  for (int num_warmup_threads : {1, 4}) {
+    const string export_dir = CopyWithWarmupRequests(
+        strings::StrCat("warmup_", num_warmup_threads), requests);
+    SavedModelLoadOptions load_options;
+    load_options.num_warmup_threads = num_warmup_threads;
+    TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                                {kSavedModelTagServe}, load_options, &bundle));
+    CheckSavedModelBundle(export_dir, bundle);
+  }
+}
+
+TEST_F(LoaderTest, FailingWarmup) {
+  SavedModelBundle bundle;
+  SessionOptions session_options;
+  RunOptions run_options;
+
+  RunStepRequest request;
+  request.add_fetch("missing_tensor:0");
+  const string export_dir =
+      CopyWithWarmupRequests("failing_warmup", {request});
+  Status st = LoadSavedModel(session_options, run_options, export_dir,
+                             {kSavedModelTagServe}, &bundle);
+  EXPECT_FALSE(st.ok());
+  EXPECT_TRUE(StringPiece(st.error_message())
+                  .contains("Failed to run a warmup request"))
+      << st.error_message();
+
+  // Warmup can be turned off.
+  SavedModelLoadOptions load_options;
+  load_options.run_warmup = false;
+  TF_ASSERT_OK(LoadSavedModel(session_options, run_options, export_dir,
+                              {kSavedModelTagServe}, load_options, &bundle));
+  CheckSavedModelBundle(export_dir, bundle);
+}
+
 TEST_F(LoaderTest, TagMatch) {
   SavedModelBundle bundle;
   SessionOptions session_options;
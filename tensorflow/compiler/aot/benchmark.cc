@@ -107,6 +107,10 @@ void DumpStatsToStdout(const Stats& stats) {
     printf("  %-*s %*.3f us\n", max_label_size, g.first.c_str(), max_digits + 4,
            g.second);
   }
+  if (stats.total_us > 0) {
+    printf("  %-*s %.3f iterations/s\n", max_label_size, "Throughput:",
+           count_us * 1e6 / stats.total_us);
+  }
 }
 
 void Benchmark(const Options& options, const BenchmarkFn& fn, Stats* stats) {
@@ -170,6 +170,7 @@ def tf_library(name, graph, config,
           "//tensorflow/compiler/aot:runtime",
           "//tensorflow/compiler/tf2xla:xla_local_runtime_context",
           "//tensorflow/compiler/xla/service/cpu:runtime_conv2d",
+          "//tensorflow/compiler/xla/service/cpu:runtime_fork_join",
           "//tensorflow/compiler/xla/service/cpu:runtime_matmul",
           "//tensorflow/compiler/xla/service/cpu:runtime_single_threaded_conv2d",
           "//tensorflow/compiler/xla/service/cpu:runtime_single_threaded_matmul",
@@ -111,8 +111,10 @@ void XlaDeviceLaunchOp::Compute(OpKernelContext* ctx) {
   options.local_executable_has_hybrid_result = false;
 
   const XlaCompiler::CompilationResult* kernel;
-  OP_REQUIRES_OK(ctx, cache->Compile(options, function_, num_constant_args_,
-                                     variables, ctx, &kernel, nullptr));
+  XlaCompilationCache::EntryRef entry_ref;
+  OP_REQUIRES_OK(ctx,
+                 cache->Compile(options, function_, num_constant_args_,
+                                variables, ctx, &kernel, nullptr, &entry_ref));
 
   VLOG(1) << "XLA compilation complete...";
 
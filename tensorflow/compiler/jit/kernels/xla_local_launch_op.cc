@@ -218,8 +218,9 @@ void XlaLocalLaunchOp::Compute(OpKernelContext* ctx) {
 
   const XlaCompiler::CompilationResult* kernel;
   xla::LocalExecutable* executable;
+  XlaCompilationCache::EntryRef entry_ref;
   OP_REQUIRES_OK(ctx, cache->Compile(options, function_, num_constant_args_, {},
-                                     ctx, &kernel, &executable));
+                                     ctx, &kernel, &executable, &entry_ref));
 
   VLOG(1) << "Executing XLA Computation...";
 
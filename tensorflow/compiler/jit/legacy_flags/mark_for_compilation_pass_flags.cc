@@ -38,6 +38,7 @@ static void AllocateFlags() {
   flags->tf_xla_auto_jit = 0;
   flags->tf_xla_min_cluster_size = 2;
   flags->tf_xla_max_cluster_size = std::numeric_limits<int32>::max();
+  flags->tf_xla_min_cluster_benefit = 0;
   flags->tf_xla_clustering_debug = false;
   flag_list = new std::vector<Flag>({
       Flag("tf_xla_auto_jit", &flags->tf_xla_auto_jit,
@@ -51,6 +52,13 @@ static void AllocateFlags() {
            "for compilation."),
       Flag("tf_xla_max_cluster_size", &flags->tf_xla_max_cluster_size,
            "Maximum number of operators in an XLA compilation."),
+      Flag("tf_xla_min_cluster_benefit", &flags->tf_xla_min_cluster_benefit,
+           "Minimum estimated benefit of an XLA compilation, counted as the "
+           "number of operators XLA can fuse, excluding operators such as "
+           "MatMul and convolutions which are library calls either way, and "
+           "operators which only forward or describe their inputs. Ignored "
+           "for operators placed on an XLA device or operators explicitly "
+           "marked for compilation."),
       Flag("tf_xla_clustering_debug", &flags->tf_xla_clustering_debug,
            "Dump graphs during XLA compilation."),
   });
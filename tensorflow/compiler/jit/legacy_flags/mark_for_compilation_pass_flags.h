@@ -45,6 +45,12 @@ typedef struct {
                                   // marked for compilation.
   int32 tf_xla_max_cluster_size;  // Maximum number of operators in an XLA
                                   // compilation.
+  int32 tf_xla_min_cluster_benefit;  // Minimum estimated benefit, i.e.
+                                     // number of fusible operators, of an
+                                     // automatically formed XLA cluster.
+                                     // Ignored for operators placed on an XLA
+                                     // device or operators explicitly marked
+                                     // for compilation.
   bool tf_xla_clustering_debug;   // Dump graphs during XLA compilation.
 } MarkForCompilationPassFlags;
 
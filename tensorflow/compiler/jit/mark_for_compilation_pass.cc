@@ -277,6 +277,27 @@ static bool IsShapeConsumerOp(const Node& node) {
          node.type_string() == "Size";
 }
 
+// Returns the estimated benefit of compiling 'node' as part of an XLA
+// cluster: 1 for operators that XLA can fuse with their neighbors, and 0 for
+// operators which are library calls whether or not they are compiled, or which
+// just forward or describe their inputs. Clusters made only of the latter pay
+// the compilation and launch overheads of XLA without any gain.
+static int EstimatedBenefit(const Node& node) {
+  static const std::unordered_set<string>* kNoBenefitOps =
+      new std::unordered_set<string>({
+          // Library calls.
+          "BatchMatMul", "Conv2D", "Conv2DBackpropFilter",
+          "Conv2DBackpropInput", "Conv3D", "Conv3DBackpropFilterV2",
+          "Conv3DBackpropInputV2", "DepthwiseConv2dNative",
+          "DepthwiseConv2dNativeBackpropFilter",
+          "DepthwiseConv2dNativeBackpropInput", "MatMul",
+          // Operators that forward or describe their inputs.
+          "Const", "ExpandDims", "Identity", "NoOp", "Rank", "Reshape",
+          "Shape", "ShapeN", "Size", "Snapshot", "Squeeze", "StopGradient",
+      });
+  return kNoBenefitOps->count(node.type_string()) > 0 ? 0 : 1;
+}
+
 // Sequence number generator to ensure clusters have unique names.
 static std::atomic<int64> cluster_sequence_num;
 
@@ -459,11 +480,14 @@ Status MarkForCompilationPass::RunImpl(
     }
   }
 
-  // Count the number of elements in each cluster.
+  // Count the number of elements, and estimate the benefit of compilation,
+  // for each cluster.
   std::vector<int> cluster_sizes(graph->num_node_ids());
+  std::vector<int> cluster_benefits(graph->num_node_ids());
   for (const Node* n : compilation_candidates) {
     int cluster = clusters[n->id()].Get().representative;
     cluster_sizes[cluster]++;
+    cluster_benefits[cluster] += EstimatedBenefit(*n);
   }
 
   // Names for each cluster.
@@ -472,9 +496,11 @@ Status MarkForCompilationPass::RunImpl(
   // Mark clusters for compilation that:
   // * are placed on a device that requires compilation (an XlaDevice),
   // * are explicitly marked for compilation (_XlaCompile=true), or
-  // * have more than flags->tf_xla_min_cluster_size elements (applicable only
+  // * have more than flags->tf_xla_min_cluster_size elements, and an estimated
+  //   benefit of at least flags->tf_xla_min_cluster_benefit (applicable only
   //   if compilation is enabled, otherwise there will be no such candidates).
   const int min_cluster_size = flags->tf_xla_min_cluster_size;
+  const int min_cluster_benefit = flags->tf_xla_min_cluster_benefit;
   for (Node* n : compilation_candidates) {
     int cluster = clusters[n->id()].Get().representative;
 
@@ -497,9 +523,10 @@ Status MarkForCompilationPass::RunImpl(
     XlaOpRegistry::GetCompilationDevice(device_type.type(), &registration);
 
     // Or compile if this is a cluster of >= min_cluster_size compilable
-    // operators.
-    if (cluster_sizes[cluster] >= min_cluster_size || marked_for_compilation ||
-        registration->requires_compilation) {
+    // operators, which is expected to benefit from compilation.
+    if ((cluster_sizes[cluster] >= min_cluster_size &&
+         cluster_benefits[cluster] >= min_cluster_benefit) ||
+        marked_for_compilation || registration->requires_compilation) {
       string& name = cluster_names[cluster];
       if (name.empty()) {
         name = strings::StrCat("cluster_", cluster_sequence_num++);
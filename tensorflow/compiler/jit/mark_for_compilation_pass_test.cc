@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/jit/mark_for_compilation_pass.h"
 #include "tensorflow/compiler/jit/defs.h"
+#include "tensorflow/compiler/jit/legacy_flags/mark_for_compilation_pass_flags.h"
 
 #include "tensorflow/cc/framework/ops.h"
 #include "tensorflow/cc/ops/control_flow_ops_internal.h"
@@ -91,6 +92,38 @@ TEST(XlaCompilationTest, Chains) {
   EXPECT_TRUE(clusters.find("D") == clusters.cend());
 }
 
+TEST(XlaCompilationTest, ClustersWithoutBenefitAreNotCompiled) {
+  std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
+  GraphDef graphdef;
+  {
+    GraphDefBuilder builder(GraphDefBuilder::kFailImmediately);
+    Node* a =
+        ops::SourceOp("UncompilableNullary", builder.opts().WithName("A"));
+    Node* b = ops::BinaryOp("MatMul", a, a, builder.opts().WithName("B"));
+    Node* c = ops::UnaryOp("Identity", b, builder.opts().WithName("C"));
+    Node* d =
+        ops::UnaryOp("UncompilableUnary", c, builder.opts().WithName("D"));
+    Node* e = ops::UnaryOp("Relu", d, builder.opts().WithName("E"));
+    ops::UnaryOp("Relu", e, builder.opts().WithName("F"));
+    TF_EXPECT_OK(builder.ToGraph(graph.get()));
+  }
+
+  legacy_flags::MarkForCompilationPassFlags* flags =
+      legacy_flags::GetMarkForCompilationPassFlags();
+  const int32 old_min_cluster_benefit = flags->tf_xla_min_cluster_benefit;
+  flags->tf_xla_min_cluster_benefit = 2;
+  MarkForCompilation(&graph);
+  flags->tf_xla_min_cluster_benefit = old_min_cluster_benefit;
+
+  // The MatMul is a library call whether or not it is compiled, so only the
+  // cluster of {E, F} is compiled.
+  auto clusters = GetClusters(*graph);
+  EXPECT_EQ(2, clusters.size());
+  EXPECT_EQ(clusters["E"], clusters["F"]);
+  EXPECT_TRUE(clusters.find("B") == clusters.cend());
+  EXPECT_TRUE(clusters.find("C") == clusters.cend());
+}
+
 TEST(XlaCompilationTest, UncompilableCycles) {
   std::unique_ptr<Graph> graph(new Graph(OpRegistry::Global()));
   GraphDef graphdef;
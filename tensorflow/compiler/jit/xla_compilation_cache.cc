@@ -31,19 +31,89 @@ limitations under the License.
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/kernels/variable_ops.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
+namespace {
+
+auto* xla_compilation_cache_hits = monitoring::Counter<1>::New(
+    "/tensorflow/compiler/jit/xla_compilation_cache/hits",
+    "The number of XlaCompilationCache lookups that found an existing entry.",
+    "device_type");
+
+auto* xla_compilation_cache_misses = monitoring::Counter<1>::New(
+    "/tensorflow/compiler/jit/xla_compilation_cache/misses",
+    "The number of XlaCompilationCache lookups that required a compilation.",
+    "device_type");
+
+auto* xla_compilation_cache_evictions = monitoring::Counter<1>::New(
+    "/tensorflow/compiler/jit/xla_compilation_cache/evictions",
+    "The number of entries evicted from bounded XlaCompilationCaches.",
+    "device_type");
+
+auto* xla_compilation_cache_compile_time_usecs = monitoring::Counter<1>::New(
+    "/tensorflow/compiler/jit/xla_compilation_cache/compile_time_usecs",
+    "The total time XlaCompilationCaches spent compiling, in microseconds.",
+    "device_type");
+
+int64 CapacityFromEnv() {
+  int64 capacity;
+  Status status = ReadInt64FromEnvVar("TF_XLA_COMPILATION_CACHE_CAPACITY",
+                                      /*default_val=*/0, &capacity);
+  if (!status.ok()) {
+    LOG(ERROR) << "Ignoring the XlaCompilationCache capacity: " << status;
+    return 0;
+  }
+  return capacity;
+}
+
+}  // namespace
+
 XlaCompilationCache::XlaCompilationCache(xla::Client* client,
                                          DeviceType device_type)
-    : client_(client), device_type_(std::move(device_type)) {}
+    : XlaCompilationCache(client, std::move(device_type), CapacityFromEnv()) {}
+XlaCompilationCache::XlaCompilationCache(xla::Client* client,
+                                         DeviceType device_type,
+                                         int64 capacity)
+    : client_(client),
+      device_type_(std::move(device_type)),
+      capacity_(capacity) {}
 XlaCompilationCache::~XlaCompilationCache() = default;
 
 string XlaCompilationCache::DebugString() {
-  return "XLA JIT compilation cache";
+  mutex_lock lock(mu_);
+  return strings::StrCat(
+      "XLA JIT compilation cache: ", cache_.size(), " entries, capacity ",
+      capacity_, ", ", num_hits_, " hits, ", num_misses_, " misses, ",
+      num_evictions_, " evictions, ", compile_time_usecs_,
+      "us spent compiling");
+}
+
+void XlaCompilationCache::EvictEntries() {
+  while (static_cast<int64>(cache_.size()) > capacity_) {
+    auto victim = cache_.end();
+    for (auto it = cache_.begin(); it != cache_.end(); ++it) {
+      // Entries referenced by an EntryRef may still be in use.
+      if (it->second.use_count() > 1) continue;
+      if (victim == cache_.end() ||
+          it->second->last_use < victim->second->last_use) {
+        victim = it;
+      }
+    }
+    if (victim == cache_.end()) {
+      return;
+    }
+    VLOG(1) << "Evicting " << SignatureDebugString(victim->first);
+    cache_.erase(victim);
+    ++num_evictions_;
+    xla_compilation_cache_evictions->GetCell(device_type_.type())
+        ->IncrementBy(1);
+  }
 }
 
 // Compute a string signature which encodes the shapes of the
@@ -210,7 +280,7 @@ Status XlaCompilationCache::Compile(
     int num_constant_args, const std::vector<OptionalTensor>& variable_args,
     OpKernelContext* ctx,
     const XlaCompiler::CompilationResult** compilation_result,
-    xla::LocalExecutable** executable) {
+    xla::LocalExecutable** executable, EntryRef* entry_ref) {
   VLOG(1) << "XlaCompilationCache::Compile " << DebugString();
 
   if (VLOG_IS_ON(2)) {
@@ -235,6 +305,7 @@ Status XlaCompilationCache::Compile(
   }
 
   TF_RET_CHECK(num_constant_args + variable_args.size() <= ctx->num_inputs());
+  TF_RET_CHECK(entry_ref != nullptr);
 
   Signature signature;
   TF_RETURN_IF_ERROR(BuildSignature(function, num_constant_args, variable_args,
@@ -243,21 +314,32 @@ Status XlaCompilationCache::Compile(
   VLOG(2) << "Signature: " << SignatureDebugString(signature);
   // The outer lock protects the existence of the cache entry. It does not
   // protect the contents of the cache entry.
-  Entry* entry;
+  std::shared_ptr<Entry> entry;
   {
     mutex_lock lock(mu_);
     // Find or create a cache entry.
-    std::unique_ptr<Entry>& e = cache_[signature];
+    std::shared_ptr<Entry>& e = cache_[signature];
     if (!e) {
-      e.reset(new Entry);
+      e = std::make_shared<Entry>();
+      ++num_misses_;
+      xla_compilation_cache_misses->GetCell(device_type_.type())
+          ->IncrementBy(1);
+    } else {
+      ++num_hits_;
+      xla_compilation_cache_hits->GetCell(device_type_.type())->IncrementBy(1);
+    }
+    e->last_use = ++use_counter_;
+    entry = e;
+    if (capacity_ > 0) {
+      EvictEntries();
     }
-    entry = e.get();
   }
+  *entry_ref = entry;
 
   // Acquire the cache entry lock and compile, if necessary.
-  // TODO(phawkins): this locking will need to be restructured when we implement
-  // cache eviction.
   mutex_lock entry_lock(entry->mu);
+  const uint64 start_time_usecs = Env::Default()->NowMicros();
+  bool compiled = false;
   if (!entry->compiled) {
     // Do the actual JIT compilation without holding the lock (it can take
     // a long time.)
@@ -270,6 +352,7 @@ Status XlaCompilationCache::Compile(
     entry->compilation_status =
         compiler.CompileFunction(XlaCompiler::CompileOptions(), function, args,
                                  &entry->compilation_result);
+    compiled = true;
   }
   *compilation_result = &entry->compilation_result;
   if (entry->compilation_status.ok() && executable) {
@@ -278,9 +361,20 @@ Status XlaCompilationCache::Compile(
       XlaCompiler compiler(options);
       entry->compilation_status = compiler.BuildExecutable(
           entry->compilation_result, &entry->executable);
+      compiled = true;
     }
     *executable = entry->executable.get();
   }
+  if (compiled) {
+    const int64 compile_time_usecs =
+        Env::Default()->NowMicros() - start_time_usecs;
+    VLOG(1) << "Compiled " << signature.name << " in " << compile_time_usecs
+            << "us";
+    xla_compilation_cache_compile_time_usecs->GetCell(device_type_.type())
+        ->IncrementBy(compile_time_usecs);
+    mutex_lock lock(mu_);
+    compile_time_usecs_ += compile_time_usecs;
+  }
 
   Status status = entry->compilation_status;
   return status;
@@ -42,11 +42,22 @@ struct OptionalTensor {
 // Since XLA computations must have static shapes, the cache generates a new
 // XLA computation for each new set of input shapes.
 //
-// Currently no cache eviction policy is implemented and the cache grows without
-// bound.
+// By default the cache grows without bound. A cache with a positive capacity
+// evicts its least recently used entries once it holds more than `capacity`
+// of them; entries still referenced by an EntryRef are never evicted. The
+// hits, misses, evictions and compilation times of all caches are exported as
+// monitoring metrics.
 class XlaCompilationCache : public ResourceBase {
  public:
+  // Keeps the results of a Compile call alive while it is held.
+  using EntryRef = std::shared_ptr<const void>;
+
+  // The capacity of this constructor is read from the
+  // TF_XLA_COMPILATION_CACHE_CAPACITY environment variable, and defaults to 0,
+  // i.e. unbounded.
   XlaCompilationCache(xla::Client* client, DeviceType device_type);
+  XlaCompilationCache(xla::Client* client, DeviceType device_type,
+                      int64 capacity);
   ~XlaCompilationCache() override;
 
   // Compiles a function into a XlaCompiler::CompilationResult that can be used
@@ -60,13 +71,14 @@ class XlaCompilationCache : public ResourceBase {
   // be non-null. If `executable` is non-null, also builds an
   // xla::LocalExecutable and sets `executable to point to it. The resulting
   // executable pointer may be null if the computation has no non-constant
-  // outputs.
+  // outputs. Both results stay valid as long as `*entry_ref`, which must be
+  // non-null, is held.
   Status Compile(const XlaCompiler::Options& options,
                  const NameAttrList& function, int num_constant_args,
                  const std::vector<OptionalTensor>& variable_args,
                  OpKernelContext* ctx,
                  const XlaCompiler::CompilationResult** compilation_result,
-                 xla::LocalExecutable** executable);
+                 xla::LocalExecutable** executable, EntryRef* entry_ref);
 
   xla::Client* client() const { return client_; }
   const DeviceType& device_type() const { return device_type_; }
@@ -76,6 +88,7 @@ class XlaCompilationCache : public ResourceBase {
  private:
   xla::Client* const client_;
   const DeviceType device_type_;
+  const int64 capacity_;
 
   // Describes the types, shapes and any compile-time constant arguments
   // to a kernel. Key that uniquely identifies a compilation output.
@@ -117,11 +130,26 @@ class XlaCompilationCache : public ResourceBase {
     // The XLA executable compiled from <computation>. May be null if no
     // executable has been built.
     std::unique_ptr<xla::LocalExecutable> executable GUARDED_BY(mu);
+
+    // The value of use_counter_ when the entry was last looked up. Guarded by
+    // the cache's mu_.
+    uint64 last_use = 0;
   };
 
+  // Evicts least recently used entries that are not referenced outside of the
+  // cache until there are at most capacity_ entries left.
+  void EvictEntries() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   mutex mu_;
-  std::unordered_map<Signature, std::unique_ptr<Entry>, Signature::Hash> cache_
+  std::unordered_map<Signature, std::shared_ptr<Entry>, Signature::Hash> cache_
       GUARDED_BY(mu_);
+  uint64 use_counter_ GUARDED_BY(mu_) = 0;
+
+  // Statistics reported by DebugString.
+  int64 num_hits_ GUARDED_BY(mu_) = 0;
+  int64 num_misses_ GUARDED_BY(mu_) = 0;
+  int64 num_evictions_ GUARDED_BY(mu_) = 0;
+  int64 compile_time_usecs_ GUARDED_BY(mu_) = 0;
 
   TF_DISALLOW_COPY_AND_ASSIGN(XlaCompilationCache);
 };
@@ -33,6 +33,8 @@ struct DebugOptionsFlags {
 
   string xla_gpu_cuda_data_dir;
   bool xla_gpu_ftz;
+  string xla_object_code_cache_dir;
+  int32 xla_cpu_compile_threads;
 
   string xla_backend_extra_options;
 };
@@ -55,6 +57,8 @@ void AllocateFlags() {
   flag_values->xla_dump_debug_json_to = "";
   flag_values->xla_gpu_cuda_data_dir = "./cuda_sdk_lib";
   flag_values->xla_gpu_ftz = false;
+  flag_values->xla_object_code_cache_dir = "";
+  flag_values->xla_cpu_compile_threads = 1;
   flag_values->xla_backend_extra_options = "";
 
   flag_objects = new std::vector<tensorflow::Flag>(
@@ -86,6 +90,16 @@ void AllocateFlags() {
        tensorflow::Flag("xla_gpu_ftz", &flag_values->xla_gpu_ftz,
                         "If true, flush-to-zero semantics are enabled in the "
                         "code generated for GPUs."),
+       tensorflow::Flag("xla_object_code_cache_dir",
+                        &flag_values->xla_object_code_cache_dir,
+                        "If non-empty, the backends cache the object code "
+                        "they generate in this directory and reuse it across "
+                        "processes. Clear it after changing the compiler or "
+                        "xla_backend_extra_options."),
+       tensorflow::Flag("xla_cpu_compile_threads",
+                        &flag_values->xla_cpu_compile_threads,
+                        "Number of threads the CPU backend uses to optimize "
+                        "and generate code for a module."),
        tensorflow::Flag(
            "xla_dump_debug_json_to", &flag_values->xla_dump_debug_json_to,
            "Dump compilation artifacts as JSON into this directory."),
@@ -126,6 +140,9 @@ xla::DebugOptions GetDebugOptionsFromFlags() {
   options.set_xla_dump_debug_json_to(flag_values->xla_dump_debug_json_to);
   options.set_xla_gpu_cuda_data_dir(flag_values->xla_gpu_cuda_data_dir);
   options.set_xla_gpu_ftz(flag_values->xla_gpu_ftz);
+  options.set_xla_object_code_cache_dir(
+      flag_values->xla_object_code_cache_dir);
+  options.set_xla_cpu_compile_threads(flag_values->xla_cpu_compile_threads);
 
   std::vector<string> extra_options_parts =
       tensorflow::str_util::Split(flag_values->xla_backend_extra_options, ',');
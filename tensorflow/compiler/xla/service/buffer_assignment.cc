@@ -572,13 +572,25 @@ Status GatherComputationsByAllocationType(
 
 }  // namespace
 
+/* static */
+std::unique_ptr<HeapAlgorithm> BufferAssigner::DefaultHeapAlgorithm(
+    int64 alignment) {
+  std::vector<std::unique_ptr<HeapAlgorithm>> algorithms;
+  algorithms.push_back(MakeUnique<DecreasingSizeRunsHeap>(
+      MakeUnique<LazyBestFitHeap>(alignment)));
+  algorithms.push_back(MakeUnique<GlobalDecreasingSizeBestFitHeap>(alignment));
+  return MakeUnique<ChooseBestHeapAlgorithm>(std::move(algorithms));
+}
+
 /* static */
 StatusOr<std::unique_ptr<BufferAssignment>> BufferAssigner::Run(
     const HloModule* module, std::unique_ptr<HloOrdering> hlo_ordering,
     LogicalBuffer::SizeFunction buffer_size, int64 alignment,
-    bool allow_input_output_aliasing, TuplePointsToAnalysis::Colorer colorer) {
+    bool allow_input_output_aliasing, TuplePointsToAnalysis::Colorer colorer,
+    HeapAlgorithmFactory heap_algorithm_factory) {
   BufferAssigner assigner(alignment, allow_input_output_aliasing,
-                          std::move(colorer));
+                          std::move(colorer),
+                          std::move(heap_algorithm_factory));
   return assigner.CreateAssignment(module, std::move(hlo_ordering),
                                    std::move(buffer_size));
 }
@@ -941,8 +953,7 @@ Status BufferAssigner::AssignBuffersWithSequentialOrdering(
       VLOG(2) << "Simulating heap for color " << single_colored_set.first;
       TF_ASSIGN_OR_RETURN(
           const HeapSimulator::Result result,
-          HeapSimulator::Run(MakeUnique<DecreasingSizeRunsHeap>(
-                                 MakeUnique<LazyBestFitHeap>(alignment_)),
+          HeapSimulator::Run(heap_algorithm_factory_(alignment_),
                              assignment->module(), module_sequence,
                              assignment->points_to_analysis(),
                              assignment->buffer_size_,
@@ -966,8 +977,7 @@ Status BufferAssigner::AssignBuffersWithSequentialOrdering(
         VLOG(2) << "Simulating heap for color " << single_colored_set.first;
         TF_ASSIGN_OR_RETURN(
             const HeapSimulator::Result result,
-            HeapSimulator::Run(MakeUnique<DecreasingSizeRunsHeap>(
-                                   MakeUnique<LazyBestFitHeap>(alignment_)),
+            HeapSimulator::Run(heap_algorithm_factory_(alignment_),
                                *computation, *instruction_sequence,
                                assignment->points_to_analysis(),
                                assignment->buffer_size_,
@@ -416,24 +416,37 @@ class BufferAssignment {
 // A class which constructs a buffer assignment.
 class BufferAssigner {
  public:
+  // Returns a heap algorithm which assigns offsets aligned to the given
+  // alignment. Used to pack the buffers of sequentially ordered computations.
+  using HeapAlgorithmFactory =
+      std::function<std::unique_ptr<HeapAlgorithm>(int64 alignment)>;
+
+  // The default heap algorithm, which chooses the better packing out of
+  // LazyBestFitHeap and GlobalDecreasingSizeBestFitHeap.
+  static std::unique_ptr<HeapAlgorithm> DefaultHeapAlgorithm(int64 alignment);
+
   // Build and return a BufferAssignment for the given module. The given
   // HloOrdering is used to determine buffer liveness. buffer_size is a function
   // which returns the size of a LogicalBuffer. Alignment is the minimum
   // alignment of any buffer. allow_input_output_aliasing specifies whether
   // input buffer are allowed to be reused as outbut buffers by the client code.
+  // heap_algorithm_factory creates the algorithm packing temporary buffers.
   static StatusOr<std::unique_ptr<BufferAssignment>> Run(
       const HloModule* module, std::unique_ptr<HloOrdering> hlo_ordering,
       LogicalBuffer::SizeFunction buffer_size, int64 alignment,
       bool allow_input_output_aliasing = false,
       TuplePointsToAnalysis::Colorer colorer =
-          TuplePointsToAnalysis::DefaultColorer());
+          TuplePointsToAnalysis::DefaultColorer(),
+      HeapAlgorithmFactory heap_algorithm_factory = DefaultHeapAlgorithm);
 
  private:
   BufferAssigner(int64 alignment, bool allow_input_output_aliasing,
-                 TuplePointsToAnalysis::Colorer colorer)
+                 TuplePointsToAnalysis::Colorer colorer,
+                 HeapAlgorithmFactory heap_algorithm_factory)
       : alignment_(alignment),
         allow_input_output_aliasing_(allow_input_output_aliasing),
-        colorer_(colorer) {}
+        colorer_(colorer),
+        heap_algorithm_factory_(std::move(heap_algorithm_factory)) {}
   virtual ~BufferAssigner() = default;
 
   // Create a buffer assignment.
@@ -535,6 +548,9 @@ class BufferAssigner {
   // Functor used to assign colors to newly allocated logical buffers.
   TuplePointsToAnalysis::Colorer colorer_;
 
+  // Creates the heap algorithm for each heap simulation.
+  HeapAlgorithmFactory heap_algorithm_factory_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(BufferAssigner);
 };
 
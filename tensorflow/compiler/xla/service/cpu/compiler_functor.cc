@@ -30,6 +30,8 @@ limitations under the License.
 #include "external/llvm/include/llvm/IR/Verifier.h"
 #include "external/llvm/include/llvm/MC/MCContext.h"
 #include "external/llvm/include/llvm/Object/ObjectFile.h"
+#include "external/llvm/include/llvm/Support/Error.h"
+#include "external/llvm/include/llvm/Support/MemoryBuffer.h"
 #include "external/llvm/include/llvm/Support/raw_ostream.h"
 #include "external/llvm/include/llvm/Target/TargetMachine.h"
 #include "external/llvm/include/llvm/Transforms/IPO.h"
@@ -45,6 +47,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/types.h"
 #include "tensorflow/compiler/xla/util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 
@@ -76,6 +79,26 @@ operator()(llvm::Module& module) const {
     TF_CHECK_OK(f->Close());
   }
 
+  string cache_key;
+  if (object_code_cache_ != nullptr) {
+    cache_key = ObjectCodeCacheKey(llvm_ir::DumpModuleToString(module));
+    string object_code;
+    if (object_code_cache_->LookUp(cache_key, &object_code)) {
+      std::unique_ptr<llvm::MemoryBuffer> memory_buffer =
+          llvm::MemoryBuffer::getMemBufferCopy(object_code);
+      llvm::Expected<std::unique_ptr<llvm::object::ObjectFile>>
+          object_file_or_error = llvm::object::ObjectFile::createObjectFile(
+              memory_buffer->getMemBufferRef());
+      if (object_file_or_error) {
+        return llvm::object::OwningBinary<llvm::object::ObjectFile>(
+            std::move(object_file_or_error.get()), std::move(memory_buffer));
+      }
+      llvm::consumeError(object_file_or_error.takeError());
+      LOG(WARNING) << "Ignoring an invalid object file in the object code "
+                      "cache; recompiling.";
+    }
+  }
+
   // Build up optimization pipeline.
   AddOptimizationPasses(&module_passes, &function_passes);
 
@@ -123,10 +146,35 @@ operator()(llvm::Module& module) const {
     }
   }
 
+  if (object_code_cache_ != nullptr) {
+    tensorflow::Status status = object_code_cache_->Insert(
+        cache_key, string(memory_buffer->getBufferStart(),
+                          memory_buffer->getBufferSize()));
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to add an object file to the object code cache: "
+                   << status;
+    }
+  }
+
   return llvm::object::OwningBinary<llvm::object::ObjectFile>(
       std::move(object_file), std::move(memory_buffer));
 }
 
+string CompilerFunctor::ObjectCodeCacheKey(const string& ir) const {
+  const llvm::TargetOptions& options = target_machine_->Options;
+  legacy_flags::CpuRuntimeFlags* flags = legacy_flags::GetCpuRuntimeFlags();
+  return tensorflow::strings::StrCat(
+      "target=", target_machine_->getTargetTriple().str(),
+      " cpu=", target_machine_->getTargetCPU().str(),
+      " features=", target_machine_->getTargetFeatureString().str(),
+      " opt_level=", opt_level_,
+      " sse=", available_intrinsics_.sse_intrinsics,
+      " avx=", available_intrinsics_.avx_intrinsics,
+      " eigen=", flags->xla_cpu_use_eigen,
+      " fast_math=", options.UnsafeFPMath, options.NoInfsFPMath,
+      options.NoNaNsFPMath, options.NoSignedZerosFPMath, "\n", ir);
+}
+
 namespace {
 // Returns the set of vectorized library functions supported for the target.
 std::vector<llvm::VecDesc> VectorFunctionsForTargetLibraryInfoImpl(
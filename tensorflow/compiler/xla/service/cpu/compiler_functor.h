@@ -21,6 +21,7 @@ limitations under the License.
 #include "external/llvm/include/llvm/Object/ObjectFile.h"
 #include "external/llvm/include/llvm/Target/TargetMachine.h"
 #include "tensorflow/compiler/xla/service/cpu/disassembler.h"
+#include "tensorflow/compiler/xla/service/object_code_cache.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
@@ -39,15 +40,21 @@ class CompilerFunctor {
   // Returns a VectorIntrinsics where all intrinsics are available.
   static VectorIntrinsics AllIntrinsics();
 
+  // If object_code_cache is not null, the object files are looked up in and
+  // added to it. It must outlive the functor.
   explicit CompilerFunctor(llvm::TargetMachine* target_machine,
                            const Disassembler* disassembler, int opt_level,
-                           const VectorIntrinsics& available_intrinsics)
+                           const VectorIntrinsics& available_intrinsics,
+                           const ObjectCodeCache* object_code_cache = nullptr)
       : target_machine_(target_machine),
         disassembler_(CHECK_NOTNULL(disassembler)),
         opt_level_(opt_level),
-        available_intrinsics_(available_intrinsics) {}
+        available_intrinsics_(available_intrinsics),
+        object_code_cache_(object_code_cache) {}
 
-  // Compile a Module to an ObjectFile.
+  // Compile a Module to an ObjectFile. When a cache is given, the optimization
+  // and code generation passes are skipped if it already holds the object file
+  // of the same IR for the same target.
   llvm::object::OwningBinary<llvm::object::ObjectFile> operator()(
       llvm::Module& module) const;  // NOLINT
 
@@ -57,10 +64,14 @@ class CompilerFunctor {
       llvm::legacy::PassManagerBase* module_passes,
       llvm::legacy::FunctionPassManager* function_passes) const;
 
+  // Returns the object code cache key of the given unoptimized IR.
+  string ObjectCodeCacheKey(const string& ir) const;
+
   llvm::TargetMachine* target_machine_;
   const Disassembler* disassembler_;
   const unsigned opt_level_;
   const VectorIntrinsics available_intrinsics_;
+  const ObjectCodeCache* object_code_cache_;
 };
 
 }  // namespace cpu
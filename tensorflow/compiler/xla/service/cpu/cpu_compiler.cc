@@ -26,6 +26,7 @@ limitations under the License.
 
 // IWYU pragma: no_include "llvm/Config/Disassemblers.def.inc"
 // IWYU pragma: no_include "llvm/Config/Targets.def.inc"
+#include "external/llvm/include/llvm/ADT/SmallVector.h"
 #include "external/llvm/include/llvm/ADT/StringRef.h"
 #include "external/llvm/include/llvm/ADT/Triple.h"
 #include "external/llvm/include/llvm/IR/Function.h"
@@ -55,6 +56,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/ir_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/layout_assignment.h"
 #include "tensorflow/compiler/xla/service/cpu/parallel_cpu_executable.h"
+#include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
 #include "tensorflow/compiler/xla/service/cpu/simple_orc_jit.h"
 #include "tensorflow/compiler/xla/service/dfs_hlo_visitor_with_default.h"
 #include "tensorflow/compiler/xla/service/flatten_call_graph.h"
@@ -73,6 +75,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_verifier.h"
 #include "tensorflow/compiler/xla/service/inliner.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
+#include "tensorflow/compiler/xla/service/multi_output_fusion.h"
 #include "tensorflow/compiler/xla/service/reshape_mover.h"
 #include "tensorflow/compiler/xla/service/transpose_folding.h"
 #include "tensorflow/compiler/xla/status_macros.h"
@@ -274,6 +277,7 @@ Status CpuCompiler::RunHloPasses(HloModule* module, HloDumper dump_hlo) {
       TransposeFolding::NeverFoldTranspose);
   pipeline.AddPass<HloCSE>(/*is_layout_sensitive=*/false);
   pipeline.AddPass<CpuInstructionFusion>();
+  pipeline.AddPass<MultiOutputFusion>();
   pipeline.AddPass<CpuLayoutAssignment>(
       module->mutable_entry_computation_layout());
   // The LayoutAssignment pass may leave behind kCopy instructions which are
@@ -305,6 +309,12 @@ Status CpuCompiler::RunHloPasses(HloModule* module, HloDumper dump_hlo) {
     // computation.
     pipeline.AddPass<ParallelizationPreparation>(max_parallelism,
                                                  ShapeSizeBytesFunction());
+  } else {
+    // Outline the ops in the entry computation which are worth computing in
+    // parallel into calls, whose output partitions are computed on the
+    // intra-op thread pool.
+    pipeline.AddPass<ParallelTaskAssigner>(max_parallelism,
+                                           ShapeSizeBytesFunction());
   }
   pipeline.AddPass<HloDCE>();
   pipeline.AddPass<FlattenCallGraph>();
@@ -326,6 +336,21 @@ llvm::TargetOptions CompilerTargetOptions(
   return target_options;
 }
 
+// Returns the width in bytes of the vector registers of the target, which the
+// IR emitted for dots is tiled for.
+int64 VectorRegisterByteSize(const llvm::TargetMachine& target_machine) {
+  llvm::SmallVector<llvm::StringRef, 32> features;
+  target_machine.getTargetFeatureString().split(features, ',',
+                                                /*MaxSplit=*/-1,
+                                                /*KeepEmpty=*/false);
+  for (llvm::StringRef feature : features) {
+    if (feature == "+avx") {
+      return 32;
+    }
+  }
+  return 16;
+}
+
 llvm::CodeGenOpt::Level CodeGenOptLevel(const HloModuleConfig& module_config) {
   VLOG(2) << "backend_optimization_level: "
           << module_config.debug_options().xla_backend_optimization_level();
@@ -356,8 +381,11 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::Compile(
   auto llvm_context = MakeUnique<llvm::LLVMContext>();
   auto llvm_module =
       MakeUnique<llvm::Module>("__compute_module", *llvm_context);
-  auto jit = MakeUnique<SimpleOrcJIT>(CompilerTargetOptions(module->config()),
-                                      CodeGenOptLevel(module->config()));
+  auto jit = MakeUnique<SimpleOrcJIT>(
+      CompilerTargetOptions(module->config()),
+      CodeGenOptLevel(module->config()),
+      module->config().debug_options().xla_object_code_cache_dir(),
+      module->config().debug_options().xla_cpu_compile_threads());
   llvm_module->setDataLayout(jit->data_layout());
   llvm_module->setTargetTriple(jit->target_triple().getTriple());
 
@@ -430,7 +458,8 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::Compile(
     }
 
     IrEmitter ir_emitter(*module, *assignment, llvm_module.get(),
-                         &hlo_to_profile_idx);
+                         &hlo_to_profile_idx,
+                         VectorRegisterByteSize(jit->target_machine()));
 
     std::unique_ptr<std::map<HloInstruction*, string>> function_names(
         new std::map<HloInstruction*, string>());
@@ -502,7 +531,8 @@ StatusOr<std::unique_ptr<Executable>> CpuCompiler::Compile(
     // GetEmbeddedComputations guarantees that a called computation occurs
     // before a caller computation.
     IrEmitter ir_emitter(*module, *assignment, llvm_module.get(),
-                         &hlo_to_profile_idx);
+                         &hlo_to_profile_idx,
+                         VectorRegisterByteSize(jit->target_machine()));
 
     for (auto embedded_computation :
          computation->MakeEmbeddedComputationsList()) {
@@ -665,7 +695,8 @@ CpuCompiler::CompileAheadOfTime(std::vector<std::unique_ptr<HloModule>> modules,
     }
 
     IrEmitter ir_emitter(*module, *assignment, &llvm_module,
-                         /*hlo_to_profile_idx=*/nullptr);
+                         /*hlo_to_profile_idx=*/nullptr,
+                         VectorRegisterByteSize(*target_machine));
     HloComputation* computation = module->entry_computation();
     for (auto embedded_computation :
          computation->MakeEmbeddedComputationsList()) {
@@ -54,6 +54,8 @@ constexpr char kAcquireInfeedBufferForDequeueSymbolName[] =
     "__xla_cpu_runtime_AcquireInfeedBufferForDequeue";
 constexpr char kReleaseInfeedBufferAfterDequeueSymbolName[] =
     "__xla_cpu_runtime_ReleaseInfeedBufferAfterDequeue";
+constexpr char kParallelForkJoinSymbolName[] =
+    "__xla_cpu_runtime_ParallelForkJoin";
 
 // Returns the infeed manager used by the CPU runtime.
 InfeedManager* GetInfeedManager();
@@ -15,13 +15,17 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
 #include "external/llvm/include/llvm/IR/BasicBlock.h"
+#include "external/llvm/include/llvm/IR/Constants.h"
+#include "external/llvm/include/llvm/IR/DerivedTypes.h"
 #include "external/llvm/include/llvm/IR/Instructions.h"
 #include "external/llvm/include/llvm/IR/Module.h"
 #include "external/llvm/include/llvm/IR/Value.h"
+#include "tensorflow/compiler/xla/layout_util.h"
 #include "tensorflow/compiler/xla/legacy_flags/cpu_runtime_flags.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
@@ -38,12 +42,35 @@ using llvm_ir::SetToFirstInsertPoint;
 
 namespace cpu {
 
+namespace {
+
+// The largest number of multiply-adds of a dot that is emitted as tiled loops
+// rather than as a call to Eigen.
+const int64 kMaxTiledDotSize = 1 << 21;
+
+// The number of rows of the target accumulated together, which trades register
+// pressure for reuse of the loaded rows of the rhs.
+const int64 kTileRows = 4;
+
+// Returns true if the matrix shape is row major. Vectors and scalars are both
+// row and column major.
+bool IsRowMajor(const Shape& shape) {
+  return ShapeUtil::Rank(shape) < 2 || shape.layout().minor_to_major(0) == 1;
+}
+
+bool IsColumnMajor(const Shape& shape) {
+  return ShapeUtil::Rank(shape) < 2 || shape.layout().minor_to_major(0) == 0;
+}
+
+}  // namespace
+
 DotOpEmitter::DotOpEmitter(const HloInstruction& dot, bool transpose_lhs,
                            bool transpose_rhs,
                            const llvm_ir::IrArray& target_array,
                            const llvm_ir::IrArray& lhs_array,
                            const llvm_ir::IrArray& rhs_array,
                            llvm::Value* executable_run_options_value,
+                           int64 vector_register_byte_size,
                            llvm::IRBuilder<>* ir_builder)
     : dot_(dot),
       transpose_lhs_(transpose_lhs),
@@ -52,18 +79,20 @@ DotOpEmitter::DotOpEmitter(const HloInstruction& dot, bool transpose_lhs,
       lhs_array_(lhs_array),
       rhs_array_(rhs_array),
       executable_run_options_value_(executable_run_options_value),
+      vector_register_byte_size_(vector_register_byte_size),
       ir_builder_(ir_builder) {}
 
 /* static */ tensorflow::Status DotOpEmitter::EmitDotOperation(
     const HloInstruction& dot, bool transpose_lhs, bool transpose_rhs,
     const llvm_ir::IrArray& target_array, const llvm_ir::IrArray& lhs_array,
     const llvm_ir::IrArray& rhs_array,
-    llvm::Value* executable_run_options_value, llvm::IRBuilder<>* ir_builder) {
+    llvm::Value* executable_run_options_value,
+    int64 vector_register_byte_size, llvm::IRBuilder<>* ir_builder) {
   PrimitiveType type = target_array.GetShape().element_type();
   TF_RET_CHECK(F32 == type || F64 == type);
   DotOpEmitter dot_emitter(dot, transpose_lhs, transpose_rhs, target_array,
                            lhs_array, rhs_array, executable_run_options_value,
-                           ir_builder);
+                           vector_register_byte_size, ir_builder);
   return dot_emitter.Emit();
 }
 
@@ -102,9 +131,21 @@ tensorflow::Status DotOpEmitter::Emit() {
     return EmitScalarDot();
   }
 
+  // Small dots are dominated by the overhead of calling into Eigen, so they
+  // are emitted as tiled loops instead.
+  RowMajorMatMul matmul;
+  const bool can_emit_tiled_dot =
+      !transpose_lhs_ && !transpose_rhs_ && GetRowMajorMatMul(&matmul);
   if (PotentiallyImplementedAsEigenDot(dot_)) {
+    if (can_emit_tiled_dot &&
+        matmul.m * matmul.k * matmul.n <= kMaxTiledDotSize) {
+      return EmitTiledDot(matmul);
+    }
     return EmitCallToRuntime();
   }
+  if (can_emit_tiled_dot) {
+    return EmitTiledDot(matmul);
+  }
 
   // Reduce along dimension 0 of the LHS and 1 of the RHS. Vectors are a special
   // case where the reduction dimension is 0 for both LHS and RHS. This results
@@ -211,6 +252,271 @@ tensorflow::Status DotOpEmitter::Emit() {
   return tensorflow::Status::OK();
 }
 
+bool DotOpEmitter::GetRowMajorMatMul(RowMajorMatMul* matmul) const {
+  const Shape& lhs_shape = lhs_array_.GetShape();
+  const Shape& rhs_shape = rhs_array_.GetShape();
+  const Shape& target_shape = target_array_.GetShape();
+  if (ShapeUtil::Rank(lhs_shape) > 2 || ShapeUtil::Rank(rhs_shape) > 2 ||
+      LayoutUtil::IsPadded(lhs_shape) || LayoutUtil::IsPadded(rhs_shape) ||
+      LayoutUtil::IsPadded(target_shape)) {
+    return false;
+  }
+  const bool lhs_is_matrix = ShapeUtil::Rank(lhs_shape) == 2;
+  const bool rhs_is_matrix = ShapeUtil::Rank(rhs_shape) == 2;
+  int64 m = lhs_is_matrix ? lhs_shape.dimensions(0) : 1;
+  int64 k = lhs_shape.dimensions(lhs_is_matrix ? 1 : 0);
+  int64 n = rhs_is_matrix ? rhs_shape.dimensions(1) : 1;
+  if (m == 0 || k == 0 || n == 0) {
+    return false;
+  }
+
+  const llvm_ir::IrArray* a = &lhs_array_;
+  const llvm_ir::IrArray* b = &rhs_array_;
+  if (!IsRowMajor(lhs_shape) || !IsRowMajor(rhs_shape) ||
+      !IsRowMajor(target_shape)) {
+    if (!IsColumnMajor(lhs_shape) || !IsColumnMajor(rhs_shape) ||
+        !IsColumnMajor(target_shape)) {
+      return false;
+    }
+    // A column major matrix is the row major layout of its transpose.
+    std::swap(m, n);
+    std::swap(a, b);
+  }
+  *matmul = {m, k, n, a, b};
+  return true;
+}
+
+tensorflow::Status DotOpEmitter::EmitTiledDot(const RowMajorMatMul& matmul) {
+  const int64 element_byte_size = ShapeUtil::ByteSizeOfPrimitiveType(
+      target_array_.GetShape().element_type());
+  const int64 width =
+      std::max<int64>(1, vector_register_byte_size_ / element_byte_size);
+  const int64 tiled_rows = matmul.m - matmul.m % kTileRows;
+  if (matmul.n == 1) {
+    EmitRowDotTiles(matmul, 0, tiled_rows, kTileRows, width);
+    EmitRowDotTiles(matmul, tiled_rows, matmul.m, 1, width);
+  } else {
+    const int64 tiled_cols = matmul.n - matmul.n % width;
+    EmitOuterProductTiles(matmul, 0, tiled_rows, kTileRows, 0, tiled_cols,
+                          width);
+    EmitOuterProductTiles(matmul, 0, tiled_rows, kTileRows, tiled_cols,
+                          matmul.n, 1);
+    EmitOuterProductTiles(matmul, tiled_rows, matmul.m, 1, 0, tiled_cols,
+                          width);
+    EmitOuterProductTiles(matmul, tiled_rows, matmul.m, 1, tiled_cols,
+                          matmul.n, 1);
+  }
+  ir_builder_->SetInsertPoint(ir_builder_->GetInsertBlock());
+  return tensorflow::Status::OK();
+}
+
+void DotOpEmitter::EmitOuterProductTiles(const RowMajorMatMul& matmul,
+                                         int64 row_begin, int64 row_end,
+                                         int64 tile_rows, int64 col_begin,
+                                         int64 col_end, int64 width) {
+  if (row_begin >= row_end || col_begin >= col_end) {
+    return;
+  }
+  llvm::Type* tile_type = GetTileType(width);
+  std::vector<llvm::Value*> accumulators;
+  for (int64 r = 0; r < tile_rows; ++r) {
+    accumulators.push_back(EmitEntryBlockAlloca(tile_type, "accum_tile"));
+  }
+
+  std::unique_ptr<llvm_ir::ForLoop> row_loop = llvm_ir::ForLoop::EmitForLoop(
+      "dot.row", ir_builder_->getInt64(row_begin),
+      ir_builder_->getInt64(row_end), ir_builder_->getInt64(tile_rows),
+      ir_builder_);
+  SetToFirstInsertPoint(row_loop->GetBodyBasicBlock(), ir_builder_);
+  std::unique_ptr<llvm_ir::ForLoop> col_loop = llvm_ir::ForLoop::EmitForLoop(
+      "dot.col", ir_builder_->getInt64(col_begin),
+      ir_builder_->getInt64(col_end), ir_builder_->getInt64(width),
+      ir_builder_);
+  SetToFirstInsertPoint(col_loop->GetBodyBasicBlock(), ir_builder_);
+  for (llvm::Value* accumulator : accumulators) {
+    ir_builder_->CreateStore(llvm::Constant::getNullValue(tile_type),
+                             accumulator);
+  }
+
+  std::unique_ptr<llvm_ir::ForLoop> reduction_loop =
+      llvm_ir::ForLoop::EmitForLoop(
+          "dot.reduction", ir_builder_->getInt64(0),
+          ir_builder_->getInt64(matmul.k), ir_builder_->getInt64(1),
+          ir_builder_);
+  SetToFirstInsertPoint(reduction_loop->GetBodyBasicBlock(), ir_builder_);
+  llvm::Value* row = row_loop->GetIndVarValue();
+  llvm::Value* col = col_loop->GetIndVarValue();
+  llvm::Value* reduction = reduction_loop->GetIndVarValue();
+  llvm::Value* b_tile = EmitLoadTile(
+      *matmul.b,
+      ir_builder_->CreateAdd(
+          ir_builder_->CreateMul(reduction, ir_builder_->getInt64(matmul.n)),
+          col),
+      width);
+  for (int64 r = 0; r < tile_rows; ++r) {
+    llvm::Value* a_element = EmitLoadTile(
+        *matmul.a,
+        ir_builder_->CreateAdd(
+            ir_builder_->CreateMul(
+                ir_builder_->CreateAdd(row, ir_builder_->getInt64(r)),
+                ir_builder_->getInt64(matmul.k)),
+            reduction),
+        /*width=*/1);
+    llvm::Value* a_tile =
+        width == 1 ? a_element
+                   : ir_builder_->CreateVectorSplat(width, a_element);
+    llvm::Value* accum = ir_builder_->CreateLoad(accumulators[r]);
+    ir_builder_->CreateStore(
+        ir_builder_->CreateFAdd(accum, ir_builder_->CreateFMul(a_tile, b_tile)),
+        accumulators[r]);
+  }
+
+  SetToFirstInsertPoint(reduction_loop->GetExitBasicBlock(), ir_builder_);
+  for (int64 r = 0; r < tile_rows; ++r) {
+    llvm::Value* offset = ir_builder_->CreateAdd(
+        ir_builder_->CreateMul(
+            ir_builder_->CreateAdd(row, ir_builder_->getInt64(r)),
+            ir_builder_->getInt64(matmul.n)),
+        col);
+    EmitStoreTile(target_array_, offset,
+                  ir_builder_->CreateLoad(accumulators[r]), width);
+  }
+  SetToFirstInsertPoint(row_loop->GetExitBasicBlock(), ir_builder_);
+}
+
+void DotOpEmitter::EmitRowDotTiles(const RowMajorMatMul& matmul,
+                                   int64 row_begin, int64 row_end,
+                                   int64 tile_rows, int64 width) {
+  if (row_begin >= row_end) {
+    return;
+  }
+  // The reduction is vectorized up to the last multiple of width, and the
+  // remaining elements are accumulated as scalars.
+  const int64 vectorized_k = matmul.k - matmul.k % width;
+  llvm::Type* tile_type = GetTileType(width);
+  llvm::Type* element_type = GetTileType(1);
+  std::vector<llvm::Value*> tile_accumulators;
+  std::vector<llvm::Value*> element_accumulators;
+  for (int64 r = 0; r < tile_rows; ++r) {
+    tile_accumulators.push_back(EmitEntryBlockAlloca(tile_type, "accum_tile"));
+    element_accumulators.push_back(
+        EmitEntryBlockAlloca(element_type, "accum_element"));
+  }
+
+  std::unique_ptr<llvm_ir::ForLoop> row_loop = llvm_ir::ForLoop::EmitForLoop(
+      "dot.row", ir_builder_->getInt64(row_begin),
+      ir_builder_->getInt64(row_end), ir_builder_->getInt64(tile_rows),
+      ir_builder_);
+  SetToFirstInsertPoint(row_loop->GetBodyBasicBlock(), ir_builder_);
+  llvm::Value* row = row_loop->GetIndVarValue();
+  for (int64 r = 0; r < tile_rows; ++r) {
+    ir_builder_->CreateStore(llvm::Constant::getNullValue(tile_type),
+                             tile_accumulators[r]);
+    ir_builder_->CreateStore(llvm::Constant::getNullValue(element_type),
+                             element_accumulators[r]);
+  }
+
+  // Emits a loop over [begin, end) of the reduction accumulating width
+  // elements at a time into accumulators.
+  auto emit_reduction_loop = [&](int64 begin, int64 end, int64 step,
+                                 const std::vector<llvm::Value*>& accumulators,
+                                 tensorflow::StringPiece name) {
+    if (begin >= end) {
+      return;
+    }
+    std::unique_ptr<llvm_ir::ForLoop> reduction_loop =
+        llvm_ir::ForLoop::EmitForLoop(name, ir_builder_->getInt64(begin),
+                                      ir_builder_->getInt64(end),
+                                      ir_builder_->getInt64(step), ir_builder_);
+    SetToFirstInsertPoint(reduction_loop->GetBodyBasicBlock(), ir_builder_);
+    llvm::Value* reduction = reduction_loop->GetIndVarValue();
+    llvm::Value* b_tile = EmitLoadTile(*matmul.b, reduction, step);
+    for (int64 r = 0; r < tile_rows; ++r) {
+      llvm::Value* a_tile = EmitLoadTile(
+          *matmul.a,
+          ir_builder_->CreateAdd(
+              ir_builder_->CreateMul(
+                  ir_builder_->CreateAdd(row, ir_builder_->getInt64(r)),
+                  ir_builder_->getInt64(matmul.k)),
+              reduction),
+          step);
+      llvm::Value* accum = ir_builder_->CreateLoad(accumulators[r]);
+      ir_builder_->CreateStore(
+          ir_builder_->CreateFAdd(accum,
+                                  ir_builder_->CreateFMul(a_tile, b_tile)),
+          accumulators[r]);
+    }
+    SetToFirstInsertPoint(reduction_loop->GetExitBasicBlock(), ir_builder_);
+  };
+  emit_reduction_loop(0, vectorized_k, width, tile_accumulators,
+                      "dot.reduction");
+  emit_reduction_loop(vectorized_k, matmul.k, 1, element_accumulators,
+                      "dot.reduction.epilogue");
+
+  for (int64 r = 0; r < tile_rows; ++r) {
+    llvm::Value* result = ir_builder_->CreateLoad(element_accumulators[r]);
+    llvm::Value* tile = ir_builder_->CreateLoad(tile_accumulators[r]);
+    if (width == 1) {
+      result = ir_builder_->CreateFAdd(result, tile);
+    } else {
+      for (int64 i = 0; i < width; ++i) {
+        result = ir_builder_->CreateFAdd(
+            result, ir_builder_->CreateExtractElement(tile, i));
+      }
+    }
+    EmitStoreTile(target_array_,
+                  ir_builder_->CreateAdd(row, ir_builder_->getInt64(r)),
+                  result, /*width=*/1);
+  }
+  SetToFirstInsertPoint(row_loop->GetExitBasicBlock(), ir_builder_);
+}
+
+llvm::Type* DotOpEmitter::GetTileType(int64 width) const {
+  llvm::Type* element_type = target_array_.GetElementLlvmType();
+  if (width == 1) {
+    return element_type;
+  }
+  return llvm::VectorType::get(element_type, width);
+}
+
+llvm::Value* DotOpEmitter::EmitLoadTile(const llvm_ir::IrArray& array,
+                                        llvm::Value* offset, int64 width) {
+  llvm::Type* element_type = GetTileType(1);
+  llvm::Value* element_address = ir_builder_->CreateInBoundsGEP(
+      ir_builder_->CreateBitCast(array.GetBasePointer(),
+                                 element_type->getPointerTo()),
+      {offset});
+  // Tiles are only aligned to their elements.
+  return ir_builder_->CreateAlignedLoad(
+      ir_builder_->CreateBitCast(element_address,
+                                 GetTileType(width)->getPointerTo()),
+      ShapeUtil::ByteSizeOfPrimitiveType(array.GetShape().element_type()));
+}
+
+void DotOpEmitter::EmitStoreTile(const llvm_ir::IrArray& array,
+                                 llvm::Value* offset, llvm::Value* tile,
+                                 int64 width) {
+  llvm::Type* element_type = GetTileType(1);
+  llvm::Value* element_address = ir_builder_->CreateInBoundsGEP(
+      ir_builder_->CreateBitCast(array.GetBasePointer(),
+                                 element_type->getPointerTo()),
+      {offset});
+  ir_builder_->CreateAlignedStore(
+      tile,
+      ir_builder_->CreateBitCast(element_address,
+                                 GetTileType(width)->getPointerTo()),
+      ShapeUtil::ByteSizeOfPrimitiveType(array.GetShape().element_type()));
+}
+
+llvm::Value* DotOpEmitter::EmitEntryBlockAlloca(llvm::Type* type,
+                                                tensorflow::StringPiece name) {
+  llvm::IRBuilder<>::InsertPointGuard guard(*ir_builder_);
+  llvm::Function* function = ir_builder_->GetInsertBlock()->getParent();
+  SetToFirstInsertPoint(&function->getEntryBlock(), ir_builder_);
+  return ir_builder_->CreateAlloca(type, /*ArraySize=*/nullptr,
+                                   llvm_ir::AsStringRef(name));
+}
+
 tensorflow::Status DotOpEmitter::EmitScalarDot() {
   // A scalar dot is just a scalar multiply.
   llvm::Value* lhs_value =
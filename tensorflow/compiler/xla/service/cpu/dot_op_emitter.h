@@ -34,12 +34,14 @@ class DotOpEmitter {
   // Emit LLVM IR to perform the dot operation on lhs_array and rhs_array and
   // place the result in target_array. IR is emitted at current insert point of
   // the builder. Upon completion of the method, the insert point is set to the
-  // end of all instructions emitted for this operation.
+  // end of all instructions emitted for this operation. Dots emitted as loops
+  // are tiled for vector registers of vector_register_byte_size bytes.
   static tensorflow::Status EmitDotOperation(
       const HloInstruction& dot, bool transpose_lhs, bool transpose_rhs,
       const llvm_ir::IrArray& target_array, const llvm_ir::IrArray& lhs_array,
       const llvm_ir::IrArray& rhs_array,
-      llvm::Value* executable_run_options_value, llvm::IRBuilder<>* ir_builder);
+      llvm::Value* executable_run_options_value,
+      int64 vector_register_byte_size, llvm::IRBuilder<>* ir_builder);
 
  private:
   DotOpEmitter(const HloInstruction& dot, bool transpose_lhs,
@@ -47,11 +49,58 @@ class DotOpEmitter {
                const llvm_ir::IrArray& lhs_array,
                const llvm_ir::IrArray& rhs_array,
                llvm::Value* executable_run_options_value,
-               llvm::IRBuilder<>* ir_builder);
+               int64 vector_register_byte_size, llvm::IRBuilder<>* ir_builder);
 
   // Emits the IR to perform the dot operation.
   tensorflow::Status Emit();
 
+  // A dot computing the row major [m x n] matrix c = a x b, where a is a row
+  // major [m x k] matrix and b a row major [k x n] matrix. Vector operands are
+  // matrices with a single row or column.
+  struct RowMajorMatMul {
+    int64 m;
+    int64 k;
+    int64 n;
+    const llvm_ir::IrArray* a;
+    const llvm_ir::IrArray* b;
+  };
+
+  // Returns true and fills in matmul if the dot can be computed as a non-empty
+  // RowMajorMatMul. Column major dots are computed as c^T = b^T x a^T.
+  bool GetRowMajorMatMul(RowMajorMatMul* matmul) const;
+
+  // Emits the matrix multiply as loops over tiles of the target that are
+  // accumulated in vector registers.
+  tensorflow::Status EmitTiledDot(const RowMajorMatMul& matmul);
+
+  // Emits the loops computing the rows [row_begin, row_end) and the columns
+  // [col_begin, col_end) of c, tile_rows rows by width columns at a time. Each
+  // step of the reduction adds the outer product of a column of a and a row of
+  // b to the tile.
+  void EmitOuterProductTiles(const RowMajorMatMul& matmul, int64 row_begin,
+                             int64 row_end, int64 tile_rows, int64 col_begin,
+                             int64 col_end, int64 width);
+
+  // Emits the loops computing the rows [row_begin, row_end) of the column
+  // vector c, tile_rows rows at a time, as dot products of rows of a with b
+  // that are vectorized width elements at a time along the reduction.
+  void EmitRowDotTiles(const RowMajorMatMul& matmul, int64 row_begin,
+                       int64 row_end, int64 tile_rows, int64 width);
+
+  // Returns the type holding width elements, which is a scalar for width 1.
+  llvm::Type* GetTileType(int64 width) const;
+
+  // Loads or stores width elements starting at element offset of array.
+  llvm::Value* EmitLoadTile(const llvm_ir::IrArray& array, llvm::Value* offset,
+                            int64 width);
+  void EmitStoreTile(const llvm_ir::IrArray& array, llvm::Value* offset,
+                     llvm::Value* tile, int64 width);
+
+  // Emits an alloca in the entry block of the function, leaving the insert
+  // point unchanged.
+  llvm::Value* EmitEntryBlockAlloca(llvm::Type* type,
+                                    tensorflow::StringPiece name);
+
   // Emits instructions to perform a scalar dot product (a multiply of the
   // LHS and RHS) and store the results in the target.
   tensorflow::Status EmitScalarDot();
@@ -81,6 +130,7 @@ class DotOpEmitter {
   const llvm_ir::IrArray& lhs_array_;
   const llvm_ir::IrArray& rhs_array_;
   llvm::Value* executable_run_options_value_;
+  const int64 vector_register_byte_size_;
   llvm::IRBuilder<>* ir_builder_;
 };
 
@@ -40,6 +40,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/cpu/dot_op_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/elemental_ir_emitter.h"
 #include "tensorflow/compiler/xla/service/cpu/ir_emission_utils.h"
+#include "tensorflow/compiler/xla/service/cpu/shape_partition.h"
 #include "tensorflow/compiler/xla/service/cpu/simple_orc_jit.h"
 #include "tensorflow/compiler/xla/service/elemental_ir_emitter.h"
 #include "tensorflow/compiler/xla/service/hlo_opcode.h"
@@ -66,14 +67,16 @@ namespace cpu {
 IrEmitter::IrEmitter(
     const HloModule& hlo_module, const BufferAssignment& assignment,
     llvm::Module* llvm_module,
-    const std::unordered_map<const HloInstruction*, size_t>* hlo_to_profile_idx)
+    const std::unordered_map<const HloInstruction*, size_t>* hlo_to_profile_idx,
+    int64 vector_register_byte_size)
     : assignment_(assignment),
       module_(llvm_module),
       arch_type_(llvm::Triple(llvm_module->getTargetTriple()).getArch()),
       ir_builder_(llvm_module->getContext()),
       hlo_to_profile_idx_(hlo_to_profile_idx),
       alias_analysis_(hlo_module, assignment, &llvm_module->getContext()),
-      hlo_module_config_(hlo_module.config()) {
+      hlo_module_config_(hlo_module.config()),
+      vector_register_byte_size_(vector_register_byte_size) {
   ir_builder_.setFastMathFlags(llvm_ir::GetFastMathFlags(
       /*fast_math_enabled=*/hlo_module_config_.debug_options()
           .xla_enable_fast_math()));
@@ -777,7 +780,8 @@ Status IrEmitter::HandleDot(HloInstruction* dot, HloInstruction* lhs,
   // Dot operation is complicated so we delegate to a helper class.
   TF_RETURN_IF_ERROR(DotOpEmitter::EmitDotOperation(
       *dot, /*transpose_lhs=*/false, /*transpose_rhs=*/false, target_array,
-      lhs_array, rhs_array, GetExecutableRunOptionsArgument(), &ir_builder_));
+      lhs_array, rhs_array, GetExecutableRunOptionsArgument(),
+      vector_register_byte_size_, &ir_builder_));
 
   emitted_value_[dot] = target_address;
   return Status::OK();
@@ -1525,7 +1529,8 @@ Status IrEmitter::HandleFusion(HloInstruction* fusion) {
     TF_RETURN_IF_ERROR(DotOpEmitter::EmitDotOperation(
         *dot, dot->operand(0)->IsRank2Transpose(),
         dot->operand(1)->IsRank2Transpose(), target_array, lhs_array, rhs_array,
-        GetExecutableRunOptionsArgument(), &ir_builder_));
+        GetExecutableRunOptionsArgument(), vector_register_byte_size_,
+        &ir_builder_));
 
     emitted_value_[fusion] = target_address;
     return Status::OK();
@@ -1557,8 +1562,15 @@ Status IrEmitter::HandleCall(HloInstruction* call) {
   TF_ASSIGN_OR_RETURN(llvm::Value * output_address,
                       EmitTargetAddressForOp(call));
 
-  EmitArrayFunctionCallInto(call_ir_function, parameter_addresses,
-                            output_address, computation->name());
+  if (!computation->root_instruction()->outer_dimension_partitions().empty()) {
+    // ParallelTaskAssigner assigned partitions to the callee root, so the
+    // runtime computes the partitions of the output in parallel.
+    EmitParallelForkJoin(call_ir_function, parameter_addresses, output_address,
+                         *computation);
+  } else {
+    EmitArrayFunctionCallInto(call_ir_function, parameter_addresses,
+                              output_address, computation->name());
+  }
 
   emitted_value_[call] = output_address;
   return Status::OK();
@@ -1941,10 +1953,9 @@ llvm::Value* IrEmitter::EmitElementFunctionCall(
 //                 parameter_addresses_buffer,
 //                 temps)
 //   return return_value_buffer  -- address of the return value.
-void IrEmitter::EmitArrayFunctionCallInto(
-    llvm::Function* function,
+llvm::Value* IrEmitter::EmitParameterAddressesBuffer(
     tensorflow::gtl::ArraySlice<llvm::Value*> parameter_addresses,
-    llvm::Value* return_value_buffer, tensorflow::StringPiece name) {
+    tensorflow::StringPiece name) {
   llvm::Value* parameter_addresses_buffer =
       llvm_ir::EmitAllocaAtFunctionEntryWithCount(
           ir_builder_.getInt8PtrTy(),
@@ -1960,20 +1971,102 @@ void IrEmitter::EmitArrayFunctionCallInto(
         parameter_addresses_buffer, {ir_builder_.getInt64(i)});
     ir_builder_.CreateStore(parameter_as_i8ptr, slot_in_param_adresses);
   }
+  return parameter_addresses_buffer;
+}
 
+void IrEmitter::EmitArrayFunctionCallInto(
+    llvm::Function* function,
+    tensorflow::gtl::ArraySlice<llvm::Value*> parameter_addresses,
+    llvm::Value* return_value_buffer, tensorflow::StringPiece name) {
   const auto to_int8_ptr = [this](llvm::Value* ptr) {
     return ir_builder_.CreatePointerCast(ptr, ir_builder_.getInt8PtrTy());
   };
   std::vector<llvm::Value*> arguments{
       to_int8_ptr(return_value_buffer),
       to_int8_ptr(GetExecutableRunOptionsArgument()),
-      parameter_addresses_buffer, GetTempBuffersArgument()};
+      EmitParameterAddressesBuffer(parameter_addresses, name),
+      GetTempBuffersArgument()};
   if (auto* profile_counters = GetProfileCountersArgument()) {
     arguments.push_back(profile_counters);
   }
   ir_builder_.CreateCall(function, arguments);
 }
 
+void IrEmitter::EmitParallelForkJoin(
+    llvm::Function* function,
+    tensorflow::gtl::ArraySlice<llvm::Value*> parameter_addresses,
+    llvm::Value* return_value_buffer, const HloComputation& computation) {
+  const HloInstruction* root = computation.root_instruction();
+  llvm::Type* i8_ptr_type = ir_builder_.getInt8PtrTy();
+  llvm::Type* i8_ptr_ptr_type = i8_ptr_type->getPointerTo();
+  llvm::Type* int64_type = ir_builder_.getInt64Ty();
+  llvm::Type* int64_ptr_type = int64_type->getPointerTo();
+  llvm::Type* int32_type = ir_builder_.getInt32Ty();
+
+  // The runtime function receives the arguments of 'function', except for
+  // the dynamic loop bounds which it reads from the partitions array.
+  llvm::FunctionType* fork_join_type = llvm::FunctionType::get(
+      /*Result=*/ir_builder_.getVoidTy(),
+      /*Params=*/{i8_ptr_type, i8_ptr_type, i8_ptr_ptr_type, i8_ptr_ptr_type,
+                  int64_ptr_type, int32_type, int64_ptr_type, int32_type,
+                  i8_ptr_type},
+      /*isVarArg=*/false);
+  llvm::Function* fork_join_func =
+      llvm::cast<llvm::Function>(module_->getOrInsertFunction(
+          runtime::kParallelForkJoinSymbolName, fork_join_type));
+  fork_join_func->setCallingConv(llvm::CallingConv::C);
+  fork_join_func->setDoesNotThrow();
+
+  // Emit a constant array holding the [start, limit) bounds of each
+  // partitioned dimension, for each partition of the root.
+  ShapePartitionIterator partition_iterator(
+      root->shape(), root->outer_dimension_partitions());
+  const int64 num_partitions = partition_iterator.GetTotalPartitionCount();
+  const int64 num_partitioned_dims = root->outer_dimension_partitions().size();
+  llvm::ArrayType* partition_type =
+      llvm::ArrayType::get(int64_type, 2 * num_partitioned_dims);
+  std::vector<llvm::Constant*> partitions;
+  partitions.reserve(num_partitions);
+  for (int64 i = 0; i < num_partitions; ++i) {
+    std::vector<llvm::Constant*> dimension_bounds;
+    for (const auto& dimension_partition : partition_iterator.GetPartition(i)) {
+      const int64 start = dimension_partition.first;
+      const int64 limit = start + dimension_partition.second;
+      dimension_bounds.push_back(ir_builder_.getInt64(start));
+      dimension_bounds.push_back(ir_builder_.getInt64(limit));
+    }
+    partitions.push_back(
+        llvm::ConstantArray::get(partition_type, dimension_bounds));
+  }
+  llvm::ArrayType* partitions_type =
+      llvm::ArrayType::get(partition_type, num_partitions);
+  auto* partitions_array = new llvm::GlobalVariable(
+      /*Module=*/*module_,
+      /*Type=*/partitions_type,
+      /*isConstant=*/true,
+      /*Linkage=*/llvm::GlobalValue::PrivateLinkage,
+      /*Initializer=*/llvm::ConstantArray::get(partitions_type, partitions),
+      /*Name=*/llvm_ir::AsStringRef(tensorflow::strings::StrCat(
+          computation.name(), "_parallel_dimension_partitions")));
+
+  llvm::Value* profile_counters = GetProfileCountersArgument();
+  if (profile_counters == nullptr) {
+    profile_counters = llvm::Constant::getNullValue(int64_ptr_type);
+  }
+  std::vector<llvm::Value*> arguments{
+      ir_builder_.CreatePointerCast(return_value_buffer, i8_ptr_type),
+      ir_builder_.CreatePointerCast(GetExecutableRunOptionsArgument(),
+                                    i8_ptr_type),
+      EmitParameterAddressesBuffer(parameter_addresses, computation.name()),
+      GetTempBuffersArgument(),
+      profile_counters,
+      ir_builder_.getInt32(num_partitions),
+      ir_builder_.CreatePointerCast(partitions_array, int64_ptr_type),
+      ir_builder_.getInt32(num_partitioned_dims),
+      ir_builder_.CreatePointerCast(function, i8_ptr_type)};
+  ir_builder_.CreateCall(fork_join_func, arguments);
+}
+
 llvm::Value* IrEmitter::EmitArrayFunctionCall(
     llvm::Function* function, const Shape& return_shape, int64 element_count,
     tensorflow::gtl::ArraySlice<llvm::Value*> parameter_addresses,
@@ -2029,8 +2122,25 @@ Status IrEmitter::EmitTargetElementLoop(
   llvm_ir::IrArray target_array(target_address, target_shape);
   AddAliasingInformationToIrArray(*target_op, &target_array);
 
-  if (num_dynamic_loop_bounds_ > 0 &&
-      target_op == target_op->parent()->root_instruction()) {
+  if (ShapeUtil::IsTuple(target_shape)) {
+    // For a multi-output fusion, the element generator returns a struct of
+    // the output elements, which are written to the buffers of the tuple
+    // elements.
+    std::vector<llvm::Value*> output_addresses;
+    std::vector<llvm_ir::IrArray> output_arrays;
+    for (int64 i = 0; i < ShapeUtil::TupleElementCount(target_shape); ++i) {
+      const Shape& element_shape = target_shape.tuple_shapes(i);
+      TF_ASSIGN_OR_RETURN(const BufferAllocation::Slice slice,
+                          assignment_.GetUniqueSlice(target_op, {i}));
+      output_addresses.push_back(EmitTempBufferPointer(slice, element_shape));
+      output_arrays.emplace_back(output_addresses.back(), element_shape);
+    }
+    TF_RETURN_IF_ERROR(
+        llvm_ir::LoopEmitter(element_generator, output_arrays, &ir_builder_)
+            .EmitLoop());
+    llvm_ir::EmitTuple(target_array, output_addresses, &ir_builder_);
+  } else if (num_dynamic_loop_bounds_ > 0 &&
+             target_op == target_op->parent()->root_instruction()) {
     // Emit parallel loop for root instruction if dynamic outer-dimension loop
     // bounds were specified.
     TF_RETURN_IF_ERROR(EmitParallelTargetElementLoop(
@@ -60,10 +60,13 @@ class IrEmitter : public DfsHloVisitorWithDefault {
   // llvm_module: the LLVM module to emit IR into.
   // hlo_to_profile_idx: the mapping from HLO to its index in the profiling
   //                     array.
+  // vector_register_byte_size: the width in bytes of the vector registers of
+  //                            the target.
   IrEmitter(const HloModule& hlo_module, const BufferAssignment& assignment,
             llvm::Module* llvm_module,
             const std::unordered_map<const HloInstruction*, size_t>*
-                hlo_to_profile_idx);
+                hlo_to_profile_idx,
+            int64 vector_register_byte_size);
   ~IrEmitter() override;
 
   // Emit and return the given HLO computation as an LLVM IR
@@ -243,6 +246,21 @@ class IrEmitter : public DfsHloVisitorWithDefault {
       tensorflow::gtl::ArraySlice<llvm::Value*> parameter_addresses,
       llvm::Value* return_value, tensorflow::StringPiece name);
 
+  // Emits a call to the ParallelForkJoin runtime function, which computes the
+  // result of 'computation' into 'return_value' by calling 'function' for
+  // each partition of the outer dimensions assigned to the root of
+  // 'computation', in parallel.
+  void EmitParallelForkJoin(
+      llvm::Function* function,
+      tensorflow::gtl::ArraySlice<llvm::Value*> parameter_addresses,
+      llvm::Value* return_value, const HloComputation& computation);
+
+  // Emits an array holding 'parameter_addresses', in the form expected by the
+  // params argument of emitted functions.
+  llvm::Value* EmitParameterAddressesBuffer(
+      tensorflow::gtl::ArraySlice<llvm::Value*> parameter_addresses,
+      tensorflow::StringPiece name);
+
   // Array function call emitter.  Returns a Value for the function's return
   // value buffer address. The return value buffer is alloca'ed by this
   // function.
@@ -425,6 +443,8 @@ class IrEmitter : public DfsHloVisitorWithDefault {
 
   const HloModuleConfig& hlo_module_config_;
 
+  const int64 vector_register_byte_size_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(IrEmitter);
 };
 
@@ -0,0 +1,97 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/cpu/parallel_task_assignment.h"
+
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_matchers.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+
+namespace op = xla::testing::opcode_matchers;
+
+namespace xla {
+namespace cpu {
+namespace {
+
+using ::testing::ElementsAre;
+
+class ParallelTaskAssignerTest : public HloTestBase {
+ protected:
+  // Runs ParallelTaskAssigner with a maximum of 'max_parallelism' tasks per
+  // instruction, and returns whether it changed 'module'.
+  bool RunParallelTaskAssigner(HloModule* module, int64 max_parallelism) {
+    ParallelTaskAssigner assigner(max_parallelism, [](const Shape& shape) {
+      return ShapeUtil::ByteSizeOf(shape, /*pointer_size=*/8);
+    });
+    return assigner.Run(module).ValueOrDie();
+  }
+};
+
+TEST_F(ParallelTaskAssignerTest, LargeElementwiseOpIsPartitioned) {
+  const Shape shape = ShapeUtil::MakeShapeWithLayout(F32, {1024, 1024}, {1, 0});
+  HloComputation::Builder builder(TestName());
+  HloInstruction* lhs =
+      builder.AddInstruction(HloInstruction::CreateParameter(0, shape, "lhs"));
+  HloInstruction* rhs =
+      builder.AddInstruction(HloInstruction::CreateParameter(1, shape, "rhs"));
+  builder.AddInstruction(
+      HloInstruction::CreateBinary(shape, HloOpcode::kAdd, lhs, rhs));
+
+  auto module = CreateNewModule();
+  HloComputation* computation = module->AddEntryComputation(builder.Build());
+  EXPECT_TRUE(RunParallelTaskAssigner(module.get(), /*max_parallelism=*/4));
+
+  HloInstruction* call = computation->root_instruction();
+  EXPECT_THAT(call, op::Call(lhs, rhs));
+  HloInstruction* callee_root = call->to_apply()->root_instruction();
+  EXPECT_THAT(callee_root, op::Add(op::Parameter(), op::Parameter()));
+  EXPECT_THAT(callee_root->outer_dimension_partitions(), ElementsAre(4));
+}
+
+TEST_F(ParallelTaskAssignerTest, SmallElementwiseOpIsNotPartitioned) {
+  const Shape shape = ShapeUtil::MakeShapeWithLayout(F32, {4, 4}, {1, 0});
+  HloComputation::Builder builder(TestName());
+  HloInstruction* param =
+      builder.AddInstruction(HloInstruction::CreateParameter(0, shape, "p"));
+  HloInstruction* negate = builder.AddInstruction(
+      HloInstruction::CreateUnary(shape, HloOpcode::kNegate, param));
+
+  auto module = CreateNewModule();
+  HloComputation* computation = module->AddEntryComputation(builder.Build());
+  EXPECT_FALSE(RunParallelTaskAssigner(module.get(), /*max_parallelism=*/4));
+  EXPECT_EQ(negate, computation->root_instruction());
+}
+
+TEST_F(ParallelTaskAssignerTest, NoPartitionsWithoutParallelism) {
+  const Shape shape = ShapeUtil::MakeShapeWithLayout(F32, {1024, 1024}, {1, 0});
+  HloComputation::Builder builder(TestName());
+  HloInstruction* param =
+      builder.AddInstruction(HloInstruction::CreateParameter(0, shape, "p"));
+  HloInstruction* exp = builder.AddInstruction(
+      HloInstruction::CreateUnary(shape, HloOpcode::kExp, param));
+
+  auto module = CreateNewModule();
+  HloComputation* computation = module->AddEntryComputation(builder.Build());
+  EXPECT_FALSE(RunParallelTaskAssigner(module.get(), /*max_parallelism=*/1));
+  EXPECT_EQ(exp, computation->root_instruction());
+}
+
+}  // namespace
+}  // namespace cpu
+}  // namespace xla
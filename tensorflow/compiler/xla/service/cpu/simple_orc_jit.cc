@@ -21,21 +21,30 @@ limitations under the License.
 #include <list>
 #include <utility>
 
+#include "external/llvm/include/llvm/ADT/SmallString.h"
+#include "external/llvm/include/llvm/Bitcode/BitcodeReader.h"
+#include "external/llvm/include/llvm/Bitcode/BitcodeWriter.h"
 #include "external/llvm/include/llvm/ExecutionEngine/ExecutionEngine.h"
 #include "external/llvm/include/llvm/ExecutionEngine/SectionMemoryManager.h"
+#include "external/llvm/include/llvm/IR/LLVMContext.h"
 #include "external/llvm/include/llvm/IR/Mangler.h"
 #include "external/llvm/include/llvm/Support/CodeGen.h"
 #include "external/llvm/include/llvm/Support/Host.h"
+#include "external/llvm/include/llvm/Support/MemoryBuffer.h"
+#include "external/llvm/include/llvm/Support/raw_ostream.h"
+#include "external/llvm/include/llvm/Transforms/Utils/SplitModule.h"
 #include "tensorflow/compiler/xla/ptr_util.h"
-#include "tensorflow/compiler/xla/service/cpu/compiler_functor.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime_avx.h"
 #include "tensorflow/compiler/xla/service/cpu/cpu_runtime_sse4_1.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_conv2d.h"
+#include "tensorflow/compiler/xla/service/cpu/runtime_fork_join.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_matmul.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_single_threaded_conv2d.h"
 #include "tensorflow/compiler/xla/service/cpu/runtime_single_threaded_matmul.h"
 #include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace xla {
@@ -80,6 +89,8 @@ struct SimpleResolver : public llvm::JITSymbolResolver {
                runtime::kReleaseInfeedBufferAfterDequeueSymbolName) {
       func_addr = reinterpret_cast<void *>(
           __xla_cpu_runtime_ReleaseInfeedBufferAfterDequeue);
+    } else if (canonical_name == runtime::kParallelForkJoinSymbolName) {
+      func_addr = reinterpret_cast<void *>(__xla_cpu_runtime_ParallelForkJoin);
     } else if (canonical_name == runtime::kExpV4F32) {
       func_addr = reinterpret_cast<void *>(runtime::ExpV4F32);
     } else if (canonical_name == runtime::kExpV8F32) {
@@ -140,35 +151,99 @@ CompilerFunctor::VectorIntrinsics GetAvailableIntrinsics() {
   return intrinsics;
 }
 
+llvm::TargetMachine *CreateHostTargetMachine(
+    const llvm::TargetOptions &target_options,
+    llvm::CodeGenOpt::Level opt_level) {
+  return CHECK_NOTNULL(llvm::EngineBuilder()
+                           .setTargetOptions(target_options)
+                           .setOptLevel(opt_level)
+                           .selectTarget(
+                               /*TargetTriple=*/llvm::Triple(), /*MArch=*/"",
+                               /*MCPU=*/GetHostCpuName(),
+                               /*MAttrs=*/DetectMachineAttributes()));
+}
+
 }  // namespace
 
 SimpleOrcJIT::SimpleOrcJIT(const llvm::TargetOptions &target_options,
-                           llvm::CodeGenOpt::Level opt_level)
-    : target_machine_(
-          CHECK_NOTNULL(llvm::EngineBuilder()
-                            .setTargetOptions(target_options)
-                            .setOptLevel(opt_level)
-                            .selectTarget(
-                                /*TargetTriple=*/llvm::Triple(), /*MArch=*/"",
-                                /*MCPU=*/GetHostCpuName(),
-                                /*MAttrs=*/DetectMachineAttributes()))),
+                           llvm::CodeGenOpt::Level opt_level,
+                           const string &object_code_cache_dir,
+                           int compile_threads)
+    : target_options_(target_options),
+      opt_level_(opt_level),
+      compile_threads_(compile_threads),
+      target_machine_(CreateHostTargetMachine(target_options, opt_level)),
       disassembler_(*target_machine_),
       data_layout_(target_machine_->createDataLayout()),
-      compile_layer_(object_layer_,
-                     CompilerFunctor(target_machine_.get(), &disassembler_,
-                                     opt_level, GetAvailableIntrinsics())) {
+      object_code_cache_(object_code_cache_dir.empty()
+                             ? nullptr
+                             : new ObjectCodeCache(object_code_cache_dir)),
+      compiler_functor_(target_machine_.get(), &disassembler_, opt_level,
+                        GetAvailableIntrinsics(), object_code_cache_.get()) {
   VLOG(1) << "CPU target: " << target_machine_->getTargetCPU().str()
           << " features: " << target_machine_->getTargetFeatureString().str();
 }
 
+SimpleOrcJIT::ObjectFiles SimpleOrcJIT::CompileInParallel(
+    std::unique_ptr<llvm::Module> module) {
+  // LLVM contexts and target machines must not be shared between threads, so
+  // each partition is serialized to bitcode and compiled from its own context
+  // by its own target machine.
+  std::vector<llvm::SmallString<0>> partitions;
+  llvm::SplitModule(std::move(module), compile_threads_,
+                    [&partitions](std::unique_ptr<llvm::Module> partition) {
+                      partitions.emplace_back();
+                      llvm::raw_svector_ostream ostream(partitions.back());
+                      llvm::WriteBitcodeToFile(partition.get(), ostream);
+                    },
+                    /*PreserveLocals=*/true);
+  VLOG(2) << "Compiling " << partitions.size() << " module partitions";
+
+  std::vector<std::unique_ptr<llvm::TargetMachine>> target_machines;
+  for (int i = 0; i < partitions.size(); ++i) {
+    target_machines.emplace_back(
+        CreateHostTargetMachine(target_options_, opt_level_));
+  }
+  ObjectFiles object_files(partitions.size());
+  {
+    tensorflow::thread::ThreadPool pool(tensorflow::Env::Default(),
+                                        "xla_cpu_compile", partitions.size());
+    for (int i = 0; i < partitions.size(); ++i) {
+      pool.Schedule([this, i, &partitions, &target_machines, &object_files]() {
+        llvm::LLVMContext context;
+        llvm::Expected<std::unique_ptr<llvm::Module>> partition_or_error =
+            llvm::parseBitcodeFile(
+                llvm::MemoryBufferRef(partitions[i].str(), "partition"),
+                context);
+        CHECK(partition_or_error);
+        const Disassembler disassembler(*target_machines[i]);
+        CompilerFunctor compiler_functor(
+            target_machines[i].get(), &disassembler, opt_level_,
+            GetAvailableIntrinsics(), object_code_cache_.get());
+        object_files[i] =
+            MakeUnique<llvm::object::OwningBinary<llvm::object::ObjectFile>>(
+                compiler_functor(*partition_or_error.get()));
+      });
+    }
+    // The pool waits for all the partitions when it is destroyed.
+  }
+  return object_files;
+}
+
 SimpleOrcJIT::ModuleHandleT SimpleOrcJIT::AddModule(
     std::unique_ptr<llvm::Module> module) {
-  // The Orc API adds a whole iterable "set" of modules, so we wrap the module
-  // in a vector.
-  std::vector<std::unique_ptr<llvm::Module>> module_set;
-  module_set.push_back(std::move(module));
-  auto handle = compile_layer_.addModuleSet(
-      std::move(module_set), MakeUnique<llvm::SectionMemoryManager>(),
+  ObjectFiles object_files;
+  if (compile_threads_ > 1) {
+    object_files = CompileInParallel(std::move(module));
+  } else {
+    object_files.push_back(
+        MakeUnique<llvm::object::OwningBinary<llvm::object::ObjectFile>>(
+            compiler_functor_(*module)));
+  }
+  // All the object files of a module are linked together, so the partitions
+  // can refer to each other's symbols.
+  auto handle = object_layer_.addObjectSet(
+      std::move(object_files), MakeUnique<llvm::SectionMemoryManager>(),
       MakeUnique<SimpleResolver>());
   module_handles_.push_back(handle);
   return handle;
@@ -177,7 +252,7 @@ SimpleOrcJIT::ModuleHandleT SimpleOrcJIT::AddModule(
 void SimpleOrcJIT::RemoveModule(SimpleOrcJIT::ModuleHandleT handle) {
   module_handles_.erase(
       std::remove(module_handles_.begin(), module_handles_.end(), handle));
-  compile_layer_.removeModuleSet(handle);
+  object_layer_.removeObjectSet(handle);
 }
 
 llvm::JITSymbol SimpleOrcJIT::FindSymbol(const std::string &name) {
@@ -192,8 +267,8 @@ llvm::JITSymbol SimpleOrcJIT::FindSymbol(const std::string &name) {
   for (auto &handle :
        llvm::make_range(module_handles_.rbegin(), module_handles_.rend())) {
     if (auto symbol =
-            compile_layer_.findSymbolIn(handle, mangled_name,
-                                        /*ExportedSymbolsOnly=*/true)) {
+            object_layer_.findSymbolIn(handle, mangled_name,
+                                       /*ExportedSymbolsOnly=*/true)) {
       return symbol;
     }
   }
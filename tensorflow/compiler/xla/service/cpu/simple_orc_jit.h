@@ -21,11 +21,13 @@ limitations under the License.
 #include <vector>
 
 #include "external/llvm/include/llvm/ADT/Triple.h"
-#include "external/llvm/include/llvm/ExecutionEngine/Orc/IRCompileLayer.h"
 #include "external/llvm/include/llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
 #include "external/llvm/include/llvm/IR/Module.h"
+#include "external/llvm/include/llvm/Object/ObjectFile.h"
 #include "external/llvm/include/llvm/Target/TargetMachine.h"
+#include "tensorflow/compiler/xla/service/cpu/compiler_functor.h"
 #include "tensorflow/compiler/xla/service/cpu/disassembler.h"
+#include "tensorflow/compiler/xla/service/object_code_cache.h"
 #include "tensorflow/compiler/xla/types.h"
 
 namespace xla {
@@ -38,12 +40,12 @@ namespace cpu {
 //
 // Supports JIT-ing multiple modules but without cross-module linking.
 // Implements eager compilation - the module is lowered to binary as soon as
-// it's added to the JIT.
+// it's added to the JIT. Modules can be split into partitions that are
+// optimized and lowered in parallel, and linked back together.
 class SimpleOrcJIT {
  public:
   using ObjLayerT = llvm::orc::RTDyldObjectLinkingLayer<>;
-  using CompileLayerT = llvm::orc::IRCompileLayer<ObjLayerT>;
-  using ModuleHandleT = CompileLayerT::ModuleSetHandleT;
+  using ModuleHandleT = ObjLayerT::ObjSetHandleT;
 
   // Create a new JIT, targeting the host architecture.
   // The |target_options| parameter allows customization of certain code
@@ -51,8 +53,18 @@ class SimpleOrcJIT {
   // can be reassociated, etc.).
   // The |opt_level| parameter controls the optimization level of the code
   // generator.
+  // If |object_code_cache_dir| is not empty, the object files of the modules
+  // are cached in that directory and reused by later JITs, including those of
+  // other processes.
+  // If |compile_threads| is greater than 1, each module is split into that many
+  // partitions, which are compiled on as many threads. Internal functions and
+  // globals stay in the partition of their users, so splitting only loses
+  // optimizations across the externally visible functions, i.e. the entry
+  // points.
   SimpleOrcJIT(const llvm::TargetOptions& target_options,
-               llvm::CodeGenOpt::Level opt_level);
+               llvm::CodeGenOpt::Level opt_level,
+               const string& object_code_cache_dir = "",
+               int compile_threads = 1);
 
   // Data layout this JIT was created with.
   const llvm::DataLayout& data_layout() const { return data_layout_; }
@@ -62,6 +74,11 @@ class SimpleOrcJIT {
     return target_machine_->getTargetTriple();
   }
 
+  // Target machine (host) this JIT generates code for.
+  const llvm::TargetMachine& target_machine() const {
+    return *target_machine_;
+  }
+
   // Add a module to the JIT. Returns an opaque handle that can be used to later
   // remove this module.
   ModuleHandleT AddModule(std::unique_ptr<llvm::Module> module);
@@ -74,12 +91,23 @@ class SimpleOrcJIT {
   llvm::JITSymbol FindSymbol(const std::string& name);
 
  private:
+  using ObjectFiles = std::vector<
+      std::unique_ptr<llvm::object::OwningBinary<llvm::object::ObjectFile>>>;
+
+  // Splits the module into compile_threads_ partitions and compiles them in
+  // parallel.
+  ObjectFiles CompileInParallel(std::unique_ptr<llvm::Module> module);
+
   std::vector<ModuleHandleT> module_handles_;
+  const llvm::TargetOptions target_options_;
+  const llvm::CodeGenOpt::Level opt_level_;
+  const int compile_threads_;
   std::unique_ptr<llvm::TargetMachine> target_machine_;
   const Disassembler disassembler_;
   const llvm::DataLayout data_layout_;
+  std::unique_ptr<ObjectCodeCache> object_code_cache_;
+  const CompilerFunctor compiler_functor_;
   ObjLayerT object_layer_;
-  CompileLayerT compile_layer_;
 };
 
 }  // namespace cpu
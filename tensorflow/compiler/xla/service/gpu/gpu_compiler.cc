@@ -56,6 +56,8 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/hlo_subcomputation_unification.h"
 #include "tensorflow/compiler/xla/service/hlo_verifier.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
+#include "tensorflow/compiler/xla/service/multi_output_fusion.h"
+#include "tensorflow/compiler/xla/service/object_code_cache.h"
 #include "tensorflow/compiler/xla/service/reshape_mover.h"
 #include "tensorflow/compiler/xla/service/transpose_folding.h"
 #include "tensorflow/compiler/xla/status_macros.h"
@@ -63,6 +65,7 @@ limitations under the License.
 #include "tensorflow/compiler/xla/util.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cuda_libdevice_path.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
@@ -150,7 +153,14 @@ tensorflow::Status OptimizeHloModule(HloModule* hlo_module,
     fusion.AddPass<GpuInstructionFusion>(/*may_duplicate=*/false);
     fusion.AddPass<GpuInstructionFusion>(/*may_duplicate=*/true);
     fusion.AddPass<FusionMerger>();
-    return fusion.Run(hlo_module).status();
+    TF_RETURN_IF_ERROR(fusion.Run(hlo_module).status());
+  }
+  {
+    // Multi-output fusions are formed once the fusions above reach their fixed
+    // point, so that those passes never see fusions rooted at a tuple.
+    HloPassPipeline pipeline("multi-output-fusion", dump_hlo);
+    pipeline.AddPass<MultiOutputFusion>();
+    return pipeline.Run(hlo_module).status();
   }
 }
 
@@ -316,8 +326,35 @@ StatusOr<std::unique_ptr<Executable>> GpuCompiler::Compile(
     // Compute libdevice_dir_ just once and cache it in this member.
     libdevice_dir_ = GetLibdeviceDir(module->config());
   }
-  TF_ASSIGN_OR_RETURN(*ptx, CompileToPtx(&llvm_module, {cc_major, cc_minor},
-                                         module->config(), libdevice_dir_));
+
+  // The PTX only depends on the unoptimized IR, the compute capability and the
+  // options used by CompileToPtx, so it can be reused from the object code
+  // cache; the rest of the executable is cheaply rebuilt from the HLO.
+  const DebugOptions& debug_options = module->config().debug_options();
+  std::unique_ptr<ObjectCodeCache> object_code_cache;
+  string cache_key;
+  if (!debug_options.xla_object_code_cache_dir().empty()) {
+    object_code_cache =
+        MakeUnique<ObjectCodeCache>(debug_options.xla_object_code_cache_dir());
+    cache_key = tensorflow::strings::StrCat(
+        "target=", kTargetTriple, " sm_", cc_major, cc_minor,
+        " opt_level=", debug_options.xla_backend_optimization_level(),
+        " fast_math=", debug_options.xla_enable_fast_math(),
+        " ftz=", debug_options.xla_gpu_ftz(), " libdevice=", libdevice_dir_,
+        "\n", llvm_ir::DumpModuleToString(llvm_module));
+  }
+  if (object_code_cache == nullptr ||
+      !object_code_cache->LookUp(cache_key, ptx)) {
+    TF_ASSIGN_OR_RETURN(*ptx, CompileToPtx(&llvm_module, {cc_major, cc_minor},
+                                           module->config(), libdevice_dir_));
+    if (object_code_cache != nullptr) {
+      tensorflow::Status status = object_code_cache->Insert(cache_key, *ptx);
+      if (!status.ok()) {
+        LOG(WARNING) << "Failed to add PTX to the object code cache: "
+                     << status;
+      }
+    }
+  }
 
   VLOG(2) << "LLVM module after optimizations:";
   XLA_VLOG_LINES(2, llvm_ir::DumpModuleToString(llvm_module));
@@ -29,6 +29,10 @@ InfeedManager::InfeedManager() : host_to_device_executor_(nullptr) {}
 void InfeedManager::Reset() {
   tensorflow::mutex_lock l(mu_);
   CHECK(dequeued_buffer_.empty());
+  // Transfers into the enqueued buffers may still be in flight.
+  if (host_to_device_stream_ != nullptr) {
+    CHECK(host_to_device_stream_->BlockHostUntilDone());
+  }
   for (auto buffer : enqueued_buffer_) {
     buffer->Done();
   }
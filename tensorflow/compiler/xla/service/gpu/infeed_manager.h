@@ -44,15 +44,29 @@ namespace gpu {
 
 // Defines an infeed buffer that is passed to the runtime by
 // the client. The client manages the memory of the buffer.
+//
+// The host to device transfer into the buffer is asynchronous: the buffer is
+// enqueued as soon as the transfer is queued on the infeed stream, and the
+// runtime waits for transfer_done_event() on its own stream before reading
+// the buffer. This lets the transfer of the next buffer overlap with the
+// computation consuming the previous one. Since the client's data may be
+// released before the transfer completes, it is first copied into pinned
+// host memory owned by the buffer.
 class InfeedBuffer {
  public:
   InfeedBuffer(perftools::gputools::StreamExecutor* executor, int64 length)
-      : executor_(executor), length_(length) {
+      : executor_(executor), length_(length), transfer_done_event_(executor) {
     device_memory_ = executor_->AllocateArray<uint8>(length);
     CHECK(!device_memory_.is_null());
+    host_memory_ = executor_->HostMemoryAllocate(length);
+    CHECK(host_memory_ != nullptr);
+    CHECK(transfer_done_event_.Init());
   }
 
-  ~InfeedBuffer() { executor_->Deallocate(&device_memory_); }
+  ~InfeedBuffer() {
+    executor_->HostMemoryDeallocate(host_memory_);
+    executor_->Deallocate(&device_memory_);
+  }
 
   int64 length() const { return length_; }
 
@@ -64,10 +78,22 @@ class InfeedBuffer {
     return &device_memory_;
   }
 
+  // Pinned host memory of length() bytes that the data is transferred from.
+  // It must not be modified until transfer_done_event() has occurred.
+  void* host_memory() { return host_memory_; }
+
+  // Event recorded on the infeed stream once the data has been transferred
+  // into device_memory().
+  perftools::gputools::Event* transfer_done_event() {
+    return &transfer_done_event_;
+  }
+
  private:
   perftools::gputools::StreamExecutor* executor_;  // Not owned.
   const int64 length_;
   perftools::gputools::DeviceMemoryBase device_memory_;
+  void* host_memory_;
+  perftools::gputools::Event transfer_done_event_;
 };
 
 // Client-side class used to enqueue infeed buffers.
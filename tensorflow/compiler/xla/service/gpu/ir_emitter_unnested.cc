@@ -451,6 +451,36 @@ Status IrEmitterUnnested::HandleFusion(HloInstruction* fusion) {
                                launch_dimensions, &ir_builder_)
         .EmitLoop();
   }
+  if (fusion->IsMultiOutputFusion()) {
+    // The kernel of a multi-output loop fusion writes its outputs through the
+    // pointers in the output tuple, so the tuple is filled in first.
+    std::vector<BufferAllocation::Slice> output_buffers;
+    for (int64 i = 0; i < ShapeUtil::TupleElementCount(fusion->shape()); ++i) {
+      output_buffers.push_back(ir_emitter_context_->buffer_assignment()
+                                   .GetUniqueSlice(fusion, {i})
+                                   .ConsumeValueOrDie());
+    }
+    std::vector<std::unique_ptr<Thunk>> thunks;
+    thunks.emplace_back(MakeUnique<TupleThunk>(
+        output_buffers, GetAllocationSlice(*fusion), fusion));
+    thunks.emplace_back(BuildKernelThunk(fusion));
+    thunk_sequence_->emplace_back(
+        MakeUnique<SequentialThunk>(std::move(thunks), fusion));
+
+    std::vector<llvm_ir::IrArray> parameter_arrays;
+    for (HloInstruction* operand : fusion->operands()) {
+      parameter_arrays.push_back(GetIrArray(*operand));
+    }
+    GpuElementalIrEmitter elemental_emitter(hlo_module_config_,
+                                            ir_emitter_context_->llvm_module(),
+                                            &ir_builder_, GetNestedComputer());
+    FusedIrEmitter fused_emitter(parameter_arrays, &elemental_emitter);
+    TF_RETURN_IF_ERROR(root->Accept(&fused_emitter));
+    return EmitTargetElementLoopInThunk(
+        *fusion, fused_emitter.GetRootGenerator(),
+        static_cast<KernelThunk*>(
+            static_cast<SequentialThunk*>(LastThunk())->thunks().back().get()));
+  }
   if (ImplementedAsGemm(*fusion)) {
     thunk_sequence_->emplace_back(BuildGemmThunk(fusion));
     return Status::OK();
@@ -1886,6 +1916,26 @@ std::unique_ptr<Thunk> IrEmitterUnnested::BuildForThunk(
 Status IrEmitterUnnested::EmitTargetElementLoopInThunk(
     const HloInstruction& hlo,
     const llvm_ir::ElementGenerator& element_generator, KernelThunk* thunk) {
+  if (ShapeUtil::IsTuple(hlo.shape())) {
+    // The element generator of a multi-output fusion returns a struct of the
+    // output elements, which are written to the buffers of the tuple elements.
+    const Shape& element_shape = hlo.shape().tuple_shapes(0);
+    LaunchDimensions launch_dimensions = CalculateLaunchDimensions(
+        element_shape, ir_emitter_context_->device_description());
+    UpdateLaunchDimensions(launch_dimensions, thunk,
+                           ir_emitter_context_->llvm_module());
+    std::vector<llvm_ir::IrArray> output_arrays;
+    for (int64 i = 0; i < ShapeUtil::TupleElementCount(hlo.shape()); ++i) {
+      const Shape& output_shape = hlo.shape().tuple_shapes(i);
+      output_arrays.emplace_back(
+          llvm_ir::EmitGetTupleElement(output_shape, i, /*alignment=*/1,
+                                       GetBasePointer(hlo), &ir_builder_),
+          output_shape);
+    }
+    return ParallelLoopEmitter(element_generator, output_arrays,
+                               launch_dimensions, &ir_builder_)
+        .EmitLoop();
+  }
   LaunchDimensions launch_dimensions = CalculateLaunchDimensions(
       hlo.shape(), ir_emitter_context_->device_description());
   UpdateLaunchDimensions(launch_dimensions, thunk,
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/service/gpu_transfer_manager.h"
 
+#include <cstring>
 #include <string>
 #include <utility>
 #include <vector>
@@ -67,24 +68,12 @@ Status GpuTransferManager::TransferLiteralToInfeed(se::StreamExecutor* executor,
     buffers.push_back(buffer);
   }
 
-  gpu::InfeedManager* infeed_manager = gpu::GetOrCreateInfeedManager();
-  se::Stream* stream = infeed_manager->GetStream(executor);
+  // The buffers are enqueued while their transfers may still be in flight;
+  // the infeed thunk waits for their transfer done events before reading
+  // them, so the transfers overlap with any computation already running.
+  gpu::GetOrCreateInfeedManager()->EnqueueBuffers(buffers);
 
-  // TODO(b/30467474): Since this stream is shared across different
-  // infeed requests, blocking on the stream might be
-  // heavy-handed. Figure out if finer-grained acknowledgement is
-  // possible.
-  if (!stream->BlockHostUntilDone()) {
-    for (gpu::InfeedBuffer* b : buffers) {
-      b->Done();
-    }
-    return InternalError("Failed to complete data transfer on stream %p",
-                         stream);
-  }
-
-  infeed_manager->EnqueueBuffers(buffers);
-
-  VLOG(2) << "Infeed data transferred";
+  VLOG(2) << "Infeed data transfer queued";
 
   return Status::OK();
 }
@@ -124,8 +113,18 @@ StatusOr<gpu::InfeedBuffer*> GpuTransferManager::TransferBufferToInfeedInternal(
     return InternalError("Failed to obtain a stream");
   }
 
+  // The caller may release 'source' as soon as this returns, while the
+  // transfer is still in flight, so it is transferred from a copy that the
+  // buffer keeps until it is released by the infeed thunk.
   gpu::InfeedBuffer* buffer = new gpu::InfeedBuffer(executor, size);
-  stream->ThenMemcpy(buffer->device_memory(), source, size);
+  std::memcpy(buffer->host_memory(), source, size);
+  stream->ThenMemcpy(buffer->device_memory(), buffer->host_memory(), size);
+  stream->ThenRecordEvent(buffer->transfer_done_event());
+  if (!stream->ok()) {
+    buffer->Done();
+    return InternalError("Failed to queue infeed data transfer on stream %p",
+                         stream);
+  }
 
   VLOG(2) << "Queued infeed data on stream " << stream;
 
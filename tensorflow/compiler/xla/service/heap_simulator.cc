@@ -604,4 +604,126 @@ HeapSimulator::Result LazyBestFitHeap::Finish() {
   return result_;
 }
 
+void GlobalDecreasingSizeBestFitHeap::Alloc(const LogicalBuffer* buffer,
+                                            int64 size) {
+  const bool inserted =
+      buffer_intervals_
+          .emplace(buffer, BufferInterval{buffer, size, current_time_, -1})
+          .second;
+  CHECK(inserted) << "Alloc called twice on buffer: " << *buffer;
+  ++current_time_;
+}
+
+void GlobalDecreasingSizeBestFitHeap::Free(const LogicalBuffer* buffer,
+                                           int64 size) {
+  auto interval_it = buffer_intervals_.find(buffer);
+  CHECK(interval_it != buffer_intervals_.end())
+      << "Free called on non-allocated buffer: " << *buffer;
+  BufferInterval* interval = &interval_it->second;
+  CHECK_EQ(interval->size, size) << "Free with mismatched sizes: " << *buffer;
+  CHECK_EQ(interval->end, -1) << "Free called twice on buffer: " << *buffer;
+  interval->end = current_time_;
+  ++current_time_;
+}
+
+HeapSimulator::Result GlobalDecreasingSizeBestFitHeap::Finish() {
+  // Place buffers by decreasing size, breaking ties by longer live range and
+  // then by buffer id, so that the result is deterministic.
+  std::vector<BufferInterval> sorted_intervals;
+  sorted_intervals.reserve(buffer_intervals_.size());
+  for (const auto& buffer_interval : buffer_intervals_) {
+    CHECK_NE(buffer_interval.second.end, -1)
+        << "Finish called before Free on buffer: " << *buffer_interval.first;
+    sorted_intervals.push_back(buffer_interval.second);
+  }
+  std::sort(sorted_intervals.begin(), sorted_intervals.end(),
+            [](const BufferInterval& a, const BufferInterval& b) {
+              if (a.size != b.size) {
+                return a.size > b.size;
+              }
+              if (a.end - a.start != b.end - b.start) {
+                return a.end - a.start > b.end - b.start;
+              }
+              return a.buffer->id() < b.buffer->id();
+            });
+
+  Result result;
+  std::vector<BufferInterval> placed_intervals;
+  for (const BufferInterval& interval : sorted_intervals) {
+    // Degenerate case: 0-sized buffers are always allocated at offset 0.
+    if (interval.size == 0) {
+      result.chunk_map.emplace(interval.buffer, Chunk{0, 0});
+      continue;
+    }
+
+    // Collect the chunks of placed buffers that are live at the same time as
+    // this one, ordered by offset.
+    std::vector<Chunk> conflicting_chunks;
+    for (const BufferInterval& placed : placed_intervals) {
+      if (placed.start <= interval.end && interval.start <= placed.end) {
+        conflicting_chunks.push_back(
+            FindOrDie(result.chunk_map, placed.buffer));
+      }
+    }
+    std::sort(conflicting_chunks.begin(), conflicting_chunks.end(),
+              [](const Chunk& a, const Chunk& b) {
+                return a.offset < b.offset;
+              });
+
+    // Find the smallest gap between the conflicting chunks that fits the
+    // buffer, accounting for alignment.  Failing that, place the buffer after
+    // all of them.
+    int64 best_offset = -1;
+    int64 best_gap_size = 0;
+    int64 free_offset = 0;
+    for (const Chunk& conflicting : conflicting_chunks) {
+      const int64 gap_size = conflicting.offset - free_offset;
+      const int64 aligned_offset = RoundUpToNearest(free_offset, alignment_);
+      if (aligned_offset + interval.size <= conflicting.offset &&
+          (best_offset == -1 || gap_size < best_gap_size)) {
+        best_offset = aligned_offset;
+        best_gap_size = gap_size;
+      }
+      free_offset = std::max(free_offset, conflicting.chunk_end());
+    }
+    if (best_offset == -1) {
+      best_offset = RoundUpToNearest(free_offset, alignment_);
+    }
+
+    const Chunk chunk{best_offset, interval.size};
+    result.chunk_map.emplace(interval.buffer, chunk);
+    result.heap_size = std::max(result.heap_size, chunk.chunk_end());
+    placed_intervals.push_back(interval);
+  }
+  return result;
+}
+
+void ChooseBestHeapAlgorithm::Alloc(const LogicalBuffer* buffer, int64 size) {
+  for (const auto& algorithm : algorithms_) {
+    algorithm->Alloc(buffer, size);
+  }
+}
+
+void ChooseBestHeapAlgorithm::Free(const LogicalBuffer* buffer, int64 size) {
+  for (const auto& algorithm : algorithms_) {
+    algorithm->Free(buffer, size);
+  }
+}
+
+HeapSimulator::Result ChooseBestHeapAlgorithm::Finish() {
+  CHECK(!algorithms_.empty());
+  Result best_result = algorithms_[0]->Finish();
+  int64 best_index = 0;
+  for (int64 i = 1; i < algorithms_.size(); ++i) {
+    Result result = algorithms_[i]->Finish();
+    if (result.heap_size < best_result.heap_size) {
+      best_result = std::move(result);
+      best_index = i;
+    }
+  }
+  VLOG(2) << "Chose heap algorithm " << best_index << " of "
+          << algorithms_.size() << ", heap size " << best_result.heap_size;
+  return best_result;
+}
+
 }  // namespace xla
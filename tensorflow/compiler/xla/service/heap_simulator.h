@@ -279,6 +279,64 @@ class LazyBestFitHeap : public HeapAlgorithm {
   std::set<Chunk, OrderChunkByIncreasingSize> free_;
 };
 
+// GlobalDecreasingSizeBestFitHeap assigns offsets with full knowledge of the
+// live ranges of all buffers, which are only known once every Alloc and Free
+// call has been made; offsets are therefore assigned in Finish.  Buffers are
+// placed in order of decreasing size, each at the best-fitting gap between the
+// already placed buffers whose live ranges overlap its own:
+//
+//   time ->   |AAAAAAAAAAAAAA|          Large buffers are placed first, so
+//             |BBBB|    |CCCC|          small buffers fill the gaps left by
+//                  |DDDD|               them, such as D between B and C.
+//
+// Since placement follows the live ranges rather than the order of the calls,
+// a buffer only ever conflicts with the buffers live at the same time.
+class GlobalDecreasingSizeBestFitHeap : public HeapAlgorithm {
+ public:
+  GlobalDecreasingSizeBestFitHeap(int64 alignment) : alignment_(alignment) {}
+  ~GlobalDecreasingSizeBestFitHeap() override {}
+
+  void Alloc(const LogicalBuffer* buffer, int64 size) override;
+  void Free(const LogicalBuffer* buffer, int64 size) override;
+  Result Finish() override;
+
+ private:
+  // The live range of a buffer, in units of Alloc and Free calls.  The range
+  // is inclusive on both ends.
+  struct BufferInterval {
+    const LogicalBuffer* buffer;
+    int64 size;
+    int64 start;
+    int64 end;
+  };
+
+  const int64 alignment_;
+
+  // The number of Alloc and Free calls so far, which is the current time.
+  int64 current_time_ = 0;
+
+  tensorflow::gtl::FlatMap<const LogicalBuffer*, BufferInterval>
+      buffer_intervals_;
+};
+
+// ChooseBestHeapAlgorithm runs the same sequence of Alloc and Free calls on
+// several heap algorithms, and returns the result with the smallest heap size.
+// Ties are broken in favor of the earlier algorithm.
+class ChooseBestHeapAlgorithm : public HeapAlgorithm {
+ public:
+  ChooseBestHeapAlgorithm(
+      std::vector<std::unique_ptr<HeapAlgorithm>> algorithms)
+      : algorithms_(std::move(algorithms)) {}
+  ~ChooseBestHeapAlgorithm() override {}
+
+  void Alloc(const LogicalBuffer* buffer, int64 size) override;
+  void Free(const LogicalBuffer* buffer, int64 size) override;
+  Result Finish() override;
+
+ private:
+  const std::vector<std::unique_ptr<HeapAlgorithm>> algorithms_;
+};
+
 }  // namespace xla
 
 #endif  // TENSORFLOW_COMPILER_XLA_SERVICE_HEAP_SIMULATOR_H_
@@ -845,5 +845,107 @@ TEST_F(LazyBestFitHeapTest, Alignment) {
   EXPECT_EQ(128, result.chunk_map.at(buffer_e_).offset);
 }
 
+class GlobalDecreasingSizeBestFitHeapTest : public HeapAlgorithmTestBase {};
+
+TEST_F(GlobalDecreasingSizeBestFitHeapTest, Empty) {
+  GlobalDecreasingSizeBestFitHeap heap(/*alignment=*/1);
+  const HeapSimulator::Result result = heap.Finish();
+  EXPECT_EQ(0, result.heap_size);
+  EXPECT_EQ(0, result.chunk_map.size());
+}
+
+TEST_F(GlobalDecreasingSizeBestFitHeapTest, DecreasingSize) {
+  GlobalDecreasingSizeBestFitHeap heap(/*alignment=*/1);
+  heap.Alloc(buffer_a_, 30);  // A live = [0, 1]
+  heap.Free(buffer_a_, 30);
+  heap.Alloc(buffer_b_, 10);  // B live = [2, 4]
+  heap.Alloc(buffer_c_, 10);  // C live = [3, 6]
+  heap.Free(buffer_b_, 10);
+  heap.Alloc(buffer_d_, 20);  // D live = [5, 7]
+  heap.Free(buffer_c_, 10);
+  heap.Free(buffer_d_, 20);
+
+  // Placed in the order A, D, C, B.  LazyBestFitHeap would have placed B and
+  // C at the start of A's chunk, leaving no room for D within its size.
+  const HeapSimulator::Result result = heap.Finish();
+  EXPECT_EQ(30, result.heap_size);
+  EXPECT_EQ(30, result.chunk_map.at(buffer_a_).size);
+  EXPECT_EQ(10, result.chunk_map.at(buffer_b_).size);
+  EXPECT_EQ(10, result.chunk_map.at(buffer_c_).size);
+  EXPECT_EQ(20, result.chunk_map.at(buffer_d_).size);
+
+  EXPECT_EQ(0, result.chunk_map.at(buffer_a_).offset);
+  EXPECT_EQ(0, result.chunk_map.at(buffer_b_).offset);
+  EXPECT_EQ(20, result.chunk_map.at(buffer_c_).offset);
+  EXPECT_EQ(0, result.chunk_map.at(buffer_d_).offset);
+}
+
+TEST_F(GlobalDecreasingSizeBestFitHeapTest, BestFit) {
+  GlobalDecreasingSizeBestFitHeap heap(/*alignment=*/1);
+  heap.Alloc(buffer_a_, 40);  // A range = [0, 40)
+  heap.Alloc(buffer_b_, 18);  // B range = [60, 78)
+  heap.Alloc(buffer_c_, 16);  // C range = [95, 111)
+  heap.Alloc(buffer_d_, 20);  // D range = [40, 60)
+  heap.Alloc(buffer_e_, 17);  // E range = [78, 95)
+  heap.Free(buffer_d_, 20);   // gaps = [40, 60)
+  heap.Free(buffer_e_, 17);   // gaps = [40, 60), [78, 95)
+  heap.Alloc(buffer_f_, 15);  // F range = [78, 93), the smallest gap
+  heap.Free(buffer_f_, 15);
+  heap.Free(buffer_a_, 40);
+  heap.Free(buffer_b_, 18);
+  heap.Free(buffer_c_, 16);
+
+  const HeapSimulator::Result result = heap.Finish();
+  EXPECT_EQ(111, result.heap_size);
+  EXPECT_EQ(0, result.chunk_map.at(buffer_a_).offset);
+  EXPECT_EQ(60, result.chunk_map.at(buffer_b_).offset);
+  EXPECT_EQ(95, result.chunk_map.at(buffer_c_).offset);
+  EXPECT_EQ(40, result.chunk_map.at(buffer_d_).offset);
+  EXPECT_EQ(78, result.chunk_map.at(buffer_e_).offset);
+  EXPECT_EQ(78, result.chunk_map.at(buffer_f_).offset);
+}
+
+TEST_F(GlobalDecreasingSizeBestFitHeapTest, Alignment) {
+  GlobalDecreasingSizeBestFitHeap heap(/*alignment=*/64);
+  heap.Alloc(buffer_a_, 10);
+  heap.Alloc(buffer_b_, 10);
+  heap.Alloc(buffer_c_, 0);
+  heap.Free(buffer_a_, 10);
+  heap.Free(buffer_b_, 10);
+  heap.Free(buffer_c_, 0);
+
+  const HeapSimulator::Result result = heap.Finish();
+  EXPECT_EQ(74, result.heap_size);
+  EXPECT_EQ(0, result.chunk_map.at(buffer_a_).offset);
+  EXPECT_EQ(64, result.chunk_map.at(buffer_b_).offset);
+  EXPECT_EQ(0, result.chunk_map.at(buffer_c_).offset);
+  EXPECT_EQ(0, result.chunk_map.at(buffer_c_).size);
+}
+
+class ChooseBestHeapAlgorithmTest : public HeapAlgorithmTestBase {};
+
+TEST_F(ChooseBestHeapAlgorithmTest, ChoosesSmallestHeap) {
+  std::vector<std::unique_ptr<HeapAlgorithm>> algorithms;
+  algorithms.push_back(MakeUnique<LazyBestFitHeap>(/*alignment=*/1));
+  algorithms.push_back(
+      MakeUnique<GlobalDecreasingSizeBestFitHeap>(/*alignment=*/1));
+  ChooseBestHeapAlgorithm heap(std::move(algorithms));
+  // The sequence of the DecreasingSize test above, on which LazyBestFitHeap
+  // needs a heap of 40 bytes.
+  heap.Alloc(buffer_a_, 30);
+  heap.Free(buffer_a_, 30);
+  heap.Alloc(buffer_b_, 10);
+  heap.Alloc(buffer_c_, 10);
+  heap.Free(buffer_b_, 10);
+  heap.Alloc(buffer_d_, 20);
+  heap.Free(buffer_c_, 10);
+  heap.Free(buffer_d_, 20);
+
+  const HeapSimulator::Result result = heap.Finish();
+  EXPECT_EQ(30, result.heap_size);
+  EXPECT_EQ(20, result.chunk_map.at(buffer_c_).offset);
+  EXPECT_EQ(0, result.chunk_map.at(buffer_d_).offset);
+}
+
 }  // namespace
 }  // namespace xla
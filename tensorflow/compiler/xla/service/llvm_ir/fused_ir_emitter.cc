@@ -16,13 +16,17 @@ limitations under the License.
 #include "tensorflow/compiler/xla/service/llvm_ir/fused_ir_emitter.h"
 
 #include <functional>
+#include <vector>
 
 #include "external/llvm/include/llvm/IR/BasicBlock.h"
+#include "external/llvm/include/llvm/IR/Constants.h"
+#include "external/llvm/include/llvm/IR/DerivedTypes.h"
 #include "external/llvm/include/llvm/IR/Value.h"
 #include "tensorflow/compiler/xla/service/elemental_ir_emitter.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/ir_array.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_util.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/ops.h"
+#include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/status_macros.h"
 #include "tensorflow/compiler/xla/statusor.h"
 #include "tensorflow/compiler/xla/util.h"
@@ -128,6 +132,31 @@ Status FusedIrEmitter::HandleParameter(HloInstruction* parameter) {
   return Status::OK();
 }
 
+Status FusedIrEmitter::HandleTuple(
+    HloInstruction* tuple,
+    tensorflow::gtl::ArraySlice<HloInstruction*> operands) {
+  std::vector<HloInstruction*> elements(operands.begin(), operands.end());
+  std::vector<llvm::Type*> element_ir_types;
+  for (const HloInstruction* element : elements) {
+    TF_RET_CHECK(!ShapeUtil::IsTuple(element->shape()));
+    element_ir_types.push_back(llvm_ir::PrimitiveTypeToIrType(
+        element->shape().element_type(), ir_builder_));
+  }
+  llvm::StructType* tuple_ir_type =
+      llvm::StructType::get(ir_builder_->getContext(), element_ir_types);
+  generators_[tuple] =
+      [=](const IrArray::Index& index) -> StatusOr<llvm::Value*> {
+    llvm::Value* value = llvm::UndefValue::get(tuple_ir_type);
+    for (size_t i = 0; i < elements.size(); ++i) {
+      TF_ASSIGN_OR_RETURN(llvm::Value * element_value,
+                          generators_.at(elements[i])(index));
+      value = ir_builder_->CreateInsertValue(value, element_value, i);
+    }
+    return value;
+  };
+  return Status::OK();
+}
+
 Status FusedIrEmitter::FinishVisit(HloInstruction* root) {
   fused_root_ = root;
   return tensorflow::Status::OK();
@@ -54,6 +54,12 @@ class FusedIrEmitter : public DfsHloVisitorWithDefault {
 
   Status HandleParameter(HloInstruction* parameter) override;
 
+  // Emits the root tuple of a multi-output fusion, whose generator returns an
+  // LLVM struct holding the element of each operand at the given index.
+  Status HandleTuple(
+      HloInstruction* tuple,
+      tensorflow::gtl::ArraySlice<HloInstruction*> operands) override;
+
   Status FinishVisit(HloInstruction* root) override;
 
   // Returns the generator function for the root of the fused computation.
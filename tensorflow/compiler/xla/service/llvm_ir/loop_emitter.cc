@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/compiler/xla/service/llvm_ir/llvm_loop.h"
 #include "tensorflow/compiler/xla/shape_util.h"
@@ -51,6 +52,44 @@ LoopEmitter::LoopEmitter(const ElementGenerator& target_element_generator,
       shape_(target_array.GetShape()),
       ir_builder_(ir_builder) {}
 
+namespace {
+
+// Converts target_element_generator to a BodyEmitter that writes each field of
+// the generated struct to the corresponding target array.
+LoopEmitter::BodyEmitter MakeBodyEmitterForMultiOutput(
+    const ElementGenerator& target_element_generator,
+    const std::vector<IrArray>& target_arrays, llvm::IRBuilder<>* ir_builder) {
+  return [=](const llvm_ir::IrArray::Index array_index)
+             -> ::tensorflow::Status {
+    TF_ASSIGN_OR_RETURN(llvm::Value * target_element,
+                        target_element_generator(array_index));
+    for (int64 i = 0; i < target_arrays.size(); ++i) {
+      target_arrays[i].EmitWriteArrayElement(
+          array_index, ir_builder->CreateExtractValue(target_element, i),
+          ir_builder);
+    }
+    return tensorflow::Status::OK();
+  };
+}
+
+}  // namespace
+
+LoopEmitter::LoopEmitter(const ElementGenerator& target_element_generator,
+                         tensorflow::gtl::ArraySlice<IrArray> target_arrays,
+                         llvm::IRBuilder<>* ir_builder)
+    : body_emitter_(MakeBodyEmitterForMultiOutput(
+          target_element_generator,
+          std::vector<IrArray>(target_arrays.begin(), target_arrays.end()),
+          ir_builder)),
+      shape_(target_arrays[0].GetShape()),
+      ir_builder_(ir_builder) {
+  for (const IrArray& array : target_arrays) {
+    CHECK(ShapeUtil::SameDimensions(shape_, array.GetShape()))
+        << ShapeUtil::HumanString(shape_) << " vs "
+        << ShapeUtil::HumanString(array.GetShape());
+  }
+}
+
 IrArray::Index LoopEmitter::EmitIndexAndSetExitBasicBlock() {
   CHECK(!ShapeUtil::IsTuple(shape_));
   if (ShapeUtil::IsScalar(shape_)) {
@@ -23,6 +23,7 @@ limitations under the License.
 #include "external/llvm/include/llvm/IR/Value.h"
 #include "tensorflow/compiler/xla/service/llvm_ir/ir_array.h"
 #include "tensorflow/compiler/xla/statusor.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
 
 namespace xla {
 namespace llvm_ir {
@@ -47,6 +48,12 @@ class LoopEmitter {
   // element of the given target array.
   LoopEmitter(const ElementGenerator& target_element_generator,
               const IrArray& target_array, llvm::IRBuilder<>* ir_builder);
+  // Constructs a LoopEmitter from an element generator that generates an LLVM
+  // struct holding an element of each of the given target arrays, which must
+  // all have the same dimensions. This is how multi-output fusions are emitted.
+  LoopEmitter(const ElementGenerator& target_element_generator,
+              tensorflow::gtl::ArraySlice<IrArray> target_arrays,
+              llvm::IRBuilder<>* ir_builder);
   LoopEmitter(const LoopEmitter&) = delete;
   LoopEmitter& operator=(const LoopEmitter&) = delete;
   virtual ~LoopEmitter() = default;
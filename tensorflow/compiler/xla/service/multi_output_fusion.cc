@@ -0,0 +1,185 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/multi_output_fusion.h"
+
+#include <algorithm>
+#include <list>
+
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+
+constexpr int64 MultiOutputFusion::kMaxOutputs;
+
+bool MultiOutputFusion::IsFusible(const HloInstruction& instruction) const {
+  if (!instruction.IsFusable() || !instruction.control_predecessors().empty() ||
+      !instruction.control_successors().empty() ||
+      ShapeUtil::IsTuple(instruction.shape())) {
+    return false;
+  }
+  if (instruction.opcode() == HloOpcode::kFusion) {
+    // Loop fusions rooted at a dynamic update slice are emitted in place,
+    // which requires the update to be their only output.
+    return instruction.fusion_kind() == HloInstruction::FusionKind::kLoop &&
+           instruction.fused_expression_root()->opcode() !=
+               HloOpcode::kDynamicUpdateSlice;
+  }
+  // Random numbers must be generated once per element, not once per use.
+  return instruction.IsElementwise() && instruction.operand_count() > 0 &&
+         instruction.opcode() != HloOpcode::kMap &&
+         instruction.opcode() != HloOpcode::kRng;
+}
+
+bool MultiOutputFusion::IsCandidate(const HloInstruction* instruction) const {
+  if (original_instructions_.count(instruction) == 0 ||
+      !IsFusible(*instruction)) {
+    return false;
+  }
+  // Fusing instructions connected to previously fused ones could create a
+  // cycle through the earlier fusion, whose paths the reachability map of the
+  // sweep does not know about.
+  return std::none_of(fused_instructions_.begin(), fused_instructions_.end(),
+                      [this, instruction](const HloInstruction* fused) {
+                        return fused == instruction ||
+                               reachability_->IsConnected(fused, instruction);
+                      });
+}
+
+void MultiOutputFusion::Fuse(
+    HloComputation* computation,
+    tensorflow::gtl::ArraySlice<HloInstruction*> instructions) {
+  std::vector<HloInstruction*> outputs(instructions.begin(),
+                                       instructions.end());
+  HloInstruction* tuple =
+      computation->AddInstruction(HloInstruction::CreateTuple(outputs));
+  HloInstruction* fusion =
+      computation->AddInstruction(HloInstruction::CreateFusion(
+          tuple->shape(), HloInstruction::FusionKind::kLoop, tuple));
+  TF_CHECK_OK(computation->RemoveInstruction(tuple));
+  VLOG(2) << "Fusing " << outputs.size() << " outputs into "
+          << fusion->name();
+
+  for (int64 i = 0; i < outputs.size(); ++i) {
+    HloInstruction* instruction = outputs[i];
+    HloInstruction* output =
+        computation->AddInstruction(HloInstruction::CreateGetTupleElement(
+            instruction->shape(), fusion, i));
+    // Copy the users, which are updated by the replacements.
+    std::vector<HloInstruction*> users(instruction->users().begin(),
+                                       instruction->users().end());
+    for (HloInstruction* user : users) {
+      if (user != fusion) {
+        TF_CHECK_OK(instruction->ReplaceUseWith(user, output));
+      }
+    }
+    if (computation->root_instruction() == instruction) {
+      computation->set_root_instruction(output);
+    }
+    if (instruction->opcode() == HloOpcode::kFusion) {
+      fusion->MergeFusionInstruction(instruction);
+    } else {
+      fusion->FuseInstruction(instruction);
+    }
+    // The instruction is removed at the end of the sweep, so that the
+    // instructions visited by the sweep remain valid.
+    instruction->DetachFromOperands();
+    fused_instructions_.push_back(instruction);
+  }
+}
+
+bool MultiOutputFusion::FuseComputation(HloComputation* computation) {
+  const std::list<HloInstruction*> post_order =
+      computation->MakeInstructionPostOrder();
+  reachability_ = computation->ComputeTransitiveOperands();
+  original_instructions_.clear();
+  original_instructions_.insert(post_order.begin(), post_order.end());
+  fused_instructions_.clear();
+
+  for (HloInstruction* instruction : post_order) {
+    // Fuse the siblings reading instruction.
+    if (!ShapeUtil::IsTuple(instruction->shape()) &&
+        !ShapeUtil::IsScalar(instruction->shape())) {
+      std::vector<HloInstruction*> siblings;
+      for (HloInstruction* user : instruction->users()) {
+        if (siblings.size() == kMaxOutputs) {
+          break;
+        }
+        if (!IsCandidate(user) ||
+            (!siblings.empty() &&
+             !ShapeUtil::SameDimensions(siblings[0]->shape(), user->shape())) ||
+            std::any_of(siblings.begin(), siblings.end(),
+                        [this, user](const HloInstruction* sibling) {
+                          return reachability_->IsConnected(sibling, user);
+                        })) {
+          continue;
+        }
+        siblings.push_back(user);
+      }
+      if (siblings.size() >= 2) {
+        Fuse(computation, siblings);
+      }
+    }
+
+    // Fuse instruction into a loop fusion consuming it, when it has other
+    // users that prevented ordinary fusion from doing so.
+    if (instruction->user_count() < 2 || !IsCandidate(instruction)) {
+      continue;
+    }
+    for (HloInstruction* user : instruction->users()) {
+      if (user->opcode() != HloOpcode::kFusion || !IsCandidate(user) ||
+          !ShapeUtil::SameDimensions(user->shape(), instruction->shape())) {
+        continue;
+      }
+      // The user's other operands must not depend on instruction, which would
+      // be both an input and an output of the fusion.
+      if (std::any_of(user->operands().begin(), user->operands().end(),
+                      [this, instruction](const HloInstruction* operand) {
+                        return operand != instruction &&
+                               reachability_->IsReachable(operand, instruction);
+                      })) {
+        continue;
+      }
+      Fuse(computation, {user, instruction});
+      break;
+    }
+  }
+
+  for (HloInstruction* instruction : fused_instructions_) {
+    TF_CHECK_OK(computation->RemoveInstruction(instruction));
+  }
+  const bool changed = !fused_instructions_.empty();
+  reachability_.reset();
+  original_instructions_.clear();
+  fused_instructions_.clear();
+  return changed;
+}
+
+StatusOr<bool> MultiOutputFusion::Run(HloModule* module) {
+  bool changed = false;
+  for (auto& computation : module->computations()) {
+    // Each sweep only fuses instructions unconnected to those it fused before,
+    // so repeat until no more sweeps fuse anything.
+    while (FuseComputation(computation.get())) {
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+}  // namespace xla
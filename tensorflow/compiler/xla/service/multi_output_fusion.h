@@ -0,0 +1,88 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_MULTI_OUTPUT_FUSION_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_MULTI_OUTPUT_FUSION_H_
+
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_module.h"
+#include "tensorflow/compiler/xla/service/hlo_pass_interface.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace xla {
+
+// HLO pass which fuses instructions "horizontally" into multi-output loop
+// fusions, whose fused root is a tuple of the results of the fused
+// instructions. Code generation computes all the results in a single loop,
+// which saves the memory traffic of separate loops:
+//  * Siblings, i.e. fusible instructions of the same dimensions that read a
+//    common operand, are fused so the operand is read once.
+//  * A fusible producer with several users is fused into a consumer loop
+//    fusion, so its result is output for the other users instead of being
+//    written by one loop and read back by the consumer.
+// Users of the fused instructions read their results with GetTupleElement.
+// This pass runs after InstructionFusion, on the loop fusions it formed.
+class MultiOutputFusion : public HloPassInterface {
+ public:
+  MultiOutputFusion() {}
+  ~MultiOutputFusion() override = default;
+  tensorflow::StringPiece name() const override {
+    return "multi-output-fusion";
+  }
+
+  // Run multi-output fusion on the given module. Returns whether the module
+  // was changed.
+  StatusOr<bool> Run(HloModule* module) override;
+
+  // The largest number of outputs of a multi-output fusion formed by this
+  // pass. Each output is an array written by the fused loop.
+  static constexpr int64 kMaxOutputs = 8;
+
+ protected:
+  // Returns whether the instruction can be computed by a multi-output loop
+  // fusion. Derived classes can restrict this to what their backend emits.
+  virtual bool IsFusible(const HloInstruction& instruction) const;
+
+ private:
+  // Performs one sweep of fusions over computation, each fusing instructions
+  // that are not connected to those fused previously in the sweep. Returns
+  // whether anything was fused.
+  bool FuseComputation(HloComputation* computation);
+
+  // Returns whether instruction can still be fused during the current sweep.
+  bool IsCandidate(const HloInstruction* instruction) const;
+
+  // Replaces instructions, which are ordered such that users come before their
+  // operands, with a multi-output loop fusion. The fused instructions are left
+  // without users or operands in the computation.
+  void Fuse(HloComputation* computation,
+            tensorflow::gtl::ArraySlice<HloInstruction*> instructions);
+
+  // State of the current sweep over a computation.
+  std::unique_ptr<HloComputation::ReachabilityMap> reachability_;
+  std::unordered_set<const HloInstruction*> original_instructions_;
+  std::vector<HloInstruction*> fused_instructions_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MultiOutputFusion);
+};
+
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_MULTI_OUTPUT_FUSION_H_
@@ -0,0 +1,125 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/multi_output_fusion.h"
+
+#include "tensorflow/compiler/xla/service/hlo_computation.h"
+#include "tensorflow/compiler/xla/service/hlo_instruction.h"
+#include "tensorflow/compiler/xla/service/hlo_matchers.h"
+#include "tensorflow/compiler/xla/service/hlo_opcode.h"
+#include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/tests/hlo_test_base.h"
+
+namespace op = xla::testing::opcode_matchers;
+
+namespace xla {
+namespace {
+
+using MultiOutputFusionTest = HloTestBase;
+
+const Shape kShape = ShapeUtil::MakeShape(F32, {4, 4});
+
+TEST_F(MultiOutputFusionTest, SiblingsFused) {
+  HloComputation::Builder builder(TestName());
+  HloInstruction* param = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, kShape, "param"));
+  HloInstruction* negate = builder.AddInstruction(
+      HloInstruction::CreateUnary(kShape, HloOpcode::kNegate, param));
+  HloInstruction* exp = builder.AddInstruction(
+      HloInstruction::CreateUnary(kShape, HloOpcode::kExp, param));
+  builder.AddInstruction(HloInstruction::CreateTuple({negate, exp}));
+
+  auto module = CreateNewModule();
+  HloComputation* computation = module->AddEntryComputation(builder.Build());
+  EXPECT_TRUE(MultiOutputFusion().Run(module.get()).ValueOrDie());
+
+  HloInstruction* root = computation->root_instruction();
+  EXPECT_THAT(root, op::Tuple(op::GetTupleElement(op::Fusion(param)),
+                              op::GetTupleElement(op::Fusion(param))));
+  HloInstruction* fusion = root->mutable_operand(0)->mutable_operand(0);
+  EXPECT_EQ(fusion, root->operand(1)->operand(0));
+  EXPECT_TRUE(fusion->IsMultiOutputFusion());
+  EXPECT_THAT(fusion->fused_expression_root(),
+              op::Tuple(op::Negate(op::Parameter()), op::Exp(op::Parameter())));
+  EXPECT_EQ(0, root->operand(0)->tuple_index());
+  EXPECT_EQ(1, root->operand(1)->tuple_index());
+}
+
+TEST_F(MultiOutputFusionTest, ProducerWithOtherUsersFusedIntoConsumer) {
+  HloComputation::Builder builder(TestName());
+  HloInstruction* param = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, kShape, "param"));
+  HloInstruction* negate = builder.AddInstruction(
+      HloInstruction::CreateUnary(kShape, HloOpcode::kNegate, param));
+  HloInstruction* exp = builder.AddInstruction(
+      HloInstruction::CreateUnary(kShape, HloOpcode::kExp, negate));
+  builder.AddInstruction(HloInstruction::CreateTuple({negate, exp}));
+
+  auto module = CreateNewModule();
+  HloComputation* computation = module->AddEntryComputation(builder.Build());
+  computation->CreateFusionInstruction({exp},
+                                       HloInstruction::FusionKind::kLoop);
+  EXPECT_TRUE(MultiOutputFusion().Run(module.get()).ValueOrDie());
+
+  HloInstruction* root = computation->root_instruction();
+  EXPECT_THAT(root, op::Tuple(op::GetTupleElement(op::Fusion(param)),
+                              op::GetTupleElement(op::Fusion(param))));
+  HloInstruction* fusion = root->mutable_operand(0)->mutable_operand(0);
+  EXPECT_TRUE(fusion->IsMultiOutputFusion());
+  // The negation is both an output and the operand of the exponential.
+  EXPECT_THAT(fusion->fused_expression_root(),
+              op::Tuple(op::Exp(op::Negate(op::Parameter())),
+                        op::Negate(op::Parameter())));
+  EXPECT_EQ(1, root->operand(0)->tuple_index());
+  EXPECT_EQ(0, root->operand(1)->tuple_index());
+}
+
+TEST_F(MultiOutputFusionTest, ConnectedSiblingsNotFused) {
+  HloComputation::Builder builder(TestName());
+  HloInstruction* param = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, kShape, "param"));
+  HloInstruction* negate = builder.AddInstruction(
+      HloInstruction::CreateUnary(kShape, HloOpcode::kNegate, param));
+  HloInstruction* add = builder.AddInstruction(
+      HloInstruction::CreateBinary(kShape, HloOpcode::kAdd, param, negate));
+
+  auto module = CreateNewModule();
+  HloComputation* computation = module->AddEntryComputation(builder.Build());
+  EXPECT_FALSE(MultiOutputFusion().Run(module.get()).ValueOrDie());
+  EXPECT_EQ(add, computation->root_instruction());
+}
+
+TEST_F(MultiOutputFusionTest, SiblingsOfDifferentDimensionsNotFused) {
+  HloComputation::Builder builder(TestName());
+  HloInstruction* param = builder.AddInstruction(
+      HloInstruction::CreateParameter(0, kShape, "param"));
+  HloInstruction* negate = builder.AddInstruction(
+      HloInstruction::CreateUnary(kShape, HloOpcode::kNegate, param));
+  HloInstruction* broadcast =
+      builder.AddInstruction(HloInstruction::CreateBroadcast(
+          ShapeUtil::MakeShape(F32, {2, 4, 4}), param, {1, 2}));
+  HloInstruction* exp = builder.AddInstruction(HloInstruction::CreateUnary(
+      broadcast->shape(), HloOpcode::kExp, broadcast));
+  builder.AddInstruction(HloInstruction::CreateTuple({negate, exp}));
+
+  auto module = CreateNewModule();
+  HloComputation* computation = module->AddEntryComputation(builder.Build());
+  computation->CreateFusionInstruction({exp, broadcast},
+                                       HloInstruction::FusionKind::kLoop);
+  EXPECT_FALSE(MultiOutputFusion().Run(module.get()).ValueOrDie());
+}
+
+}  // namespace
+}  // namespace xla
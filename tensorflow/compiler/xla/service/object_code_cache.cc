@@ -0,0 +1,81 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/object_code_cache.h"
+
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace xla {
+
+ObjectCodeCache::ObjectCodeCache(const string& directory)
+    : directory_(directory) {}
+
+string ObjectCodeCache::EntryPath(const string& key) const {
+  const tensorflow::Fprint128 fingerprint = tensorflow::Fingerprint128(key);
+  return tensorflow::io::JoinPath(
+      directory_,
+      tensorflow::strings::StrCat(
+          tensorflow::strings::Hex(fingerprint.high64,
+                                   tensorflow::strings::ZERO_PAD_16),
+          tensorflow::strings::Hex(fingerprint.low64,
+                                   tensorflow::strings::ZERO_PAD_16)));
+}
+
+bool ObjectCodeCache::LookUp(const string& key, string* object_code) const {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  const string path = EntryPath(key);
+  if (!env->FileExists(path).ok()) {
+    VLOG(2) << "Object code cache miss: " << path;
+    return false;
+  }
+  tensorflow::Status status =
+      tensorflow::ReadFileToString(env, path, object_code);
+  if (!status.ok()) {
+    LOG(WARNING) << "Failed to read object code cache entry " << path << ": "
+                 << status;
+    return false;
+  }
+  VLOG(1) << "Object code cache hit: " << path;
+  return true;
+}
+
+tensorflow::Status ObjectCodeCache::Insert(const string& key,
+                                           const string& object_code) const {
+  tensorflow::Env* env = tensorflow::Env::Default();
+  if (!env->IsDirectory(directory_).ok()) {
+    TF_RETURN_IF_ERROR(env->RecursivelyCreateDir(directory_));
+  }
+  const string path = EntryPath(key);
+  // Other processes may be writing the same entry: each of them writes its own
+  // temporary file, and the last rename wins.
+  const string temp_path = tensorflow::strings::StrCat(
+      path, ".tmp.",
+      tensorflow::strings::Hex(tensorflow::random::New64(),
+                               tensorflow::strings::ZERO_PAD_16));
+  TF_RETURN_IF_ERROR(
+      tensorflow::WriteStringToFile(env, temp_path, object_code));
+  tensorflow::Status status = env->RenameFile(temp_path, path);
+  if (!status.ok()) {
+    env->DeleteFile(temp_path).IgnoreError();
+  }
+  return status;
+}
+
+}  // namespace xla
@@ -0,0 +1,60 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMPILER_XLA_SERVICE_OBJECT_CODE_CACHE_H_
+#define TENSORFLOW_COMPILER_XLA_SERVICE_OBJECT_CODE_CACHE_H_
+
+#include <string>
+
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+
+namespace xla {
+
+// A cache of backend object code (e.g. CPU object files or PTX) which is kept
+// in a directory, so that it survives process restarts and can be shared by
+// the processes of a job. Entries are indexed by a fingerprint of a key chosen
+// by the backend, which must describe everything the generated code depends
+// on: typically the LLVM IR before optimizations, the target machine and the
+// code generation options.
+//
+// The cache is safe to use from several threads and processes: an entry is
+// written to a temporary file which is then renamed, so readers either see the
+// whole entry or none of it.
+class ObjectCodeCache {
+ public:
+  explicit ObjectCodeCache(const string& directory);
+
+  // Sets *object_code to the code cached for the given key and returns true, or
+  // returns false if the key is not in the cache.
+  bool LookUp(const string& key, string* object_code) const;
+
+  // Stores object_code as the code of the given key, replacing any previous
+  // entry.
+  tensorflow::Status Insert(const string& key, const string& object_code) const;
+
+ private:
+  // Returns the path of the file holding the entry of the given key.
+  string EntryPath(const string& key) const;
+
+  const string directory_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ObjectCodeCache);
+};
+
+}  // namespace xla
+
+#endif  // TENSORFLOW_COMPILER_XLA_SERVICE_OBJECT_CODE_CACHE_H_
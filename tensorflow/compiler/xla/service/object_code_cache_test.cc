@@ -0,0 +1,83 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/compiler/xla/service/object_code_cache.h"
+
+#include <vector>
+
+#include "tensorflow/compiler/xla/test.h"
+#include "tensorflow/compiler/xla/types.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace xla {
+namespace {
+
+string CacheDirectory(const string& name) {
+  return tensorflow::io::JoinPath(tensorflow::testing::TmpDir(),
+                                  "object_code_cache", name);
+}
+
+TEST(ObjectCodeCacheTest, MissingKey) {
+  ObjectCodeCache cache(CacheDirectory("missing_key"));
+  string object_code = "unchanged";
+  EXPECT_FALSE(cache.LookUp("key", &object_code));
+  EXPECT_EQ("unchanged", object_code);
+}
+
+TEST(ObjectCodeCacheTest, InsertAndLookUp) {
+  ObjectCodeCache cache(CacheDirectory("insert_and_look_up"));
+  TF_ASSERT_OK(cache.Insert("key1", string("code\0one", 8)));
+  TF_ASSERT_OK(cache.Insert("key2", "code two"));
+
+  string object_code;
+  ASSERT_TRUE(cache.LookUp("key1", &object_code));
+  EXPECT_EQ(string("code\0one", 8), object_code);
+  ASSERT_TRUE(cache.LookUp("key2", &object_code));
+  EXPECT_EQ("code two", object_code);
+  EXPECT_FALSE(cache.LookUp("key3", &object_code));
+}
+
+TEST(ObjectCodeCacheTest, InsertReplacesEntry) {
+  ObjectCodeCache cache(CacheDirectory("insert_replaces_entry"));
+  TF_ASSERT_OK(cache.Insert("key", "old code"));
+  TF_ASSERT_OK(cache.Insert("key", "new code"));
+
+  string object_code;
+  ASSERT_TRUE(cache.LookUp("key", &object_code));
+  EXPECT_EQ("new code", object_code);
+
+  // Only the entry is left in the directory, not the temporary files.
+  std::vector<string> children;
+  TF_ASSERT_OK(tensorflow::Env::Default()->GetChildren(
+      CacheDirectory("insert_replaces_entry"), &children));
+  EXPECT_EQ(1, children.size());
+}
+
+TEST(ObjectCodeCacheTest, EntriesOutliveTheCache) {
+  const string directory = CacheDirectory("entries_outlive_the_cache");
+  {
+    ObjectCodeCache cache(directory);
+    TF_ASSERT_OK(cache.Insert("key", "code"));
+  }
+  ObjectCodeCache cache(directory);
+  string object_code;
+  ASSERT_TRUE(cache.LookUp("key", &object_code));
+  EXPECT_EQ("code", object_code);
+}
+
+}  // namespace
+}  // namespace xla
@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "tensorflow/compiler/xla/array2d.h"
 #include "tensorflow/compiler/xla/array3d.h"
+#include "tensorflow/compiler/xla/client/client_library.h"
 #include "tensorflow/compiler/xla/client/computation_builder.h"
 #include "tensorflow/compiler/xla/client/local_client.h"
 #include "tensorflow/compiler/xla/legacy_flags/cpu_runtime_flags.h"
@@ -25,15 +26,24 @@ limitations under the License.
 #include "tensorflow/compiler/xla/legacy_flags/layout_util_flags.h"
 #include "tensorflow/compiler/xla/primitive_util.h"
 #include "tensorflow/compiler/xla/reference_util.h"
+#include "tensorflow/compiler/xla/service/device_memory_allocator.h"
+#include "tensorflow/compiler/xla/service/platform_util.h"
+#include "tensorflow/compiler/xla/service/shaped_buffer.h"
+#include "tensorflow/compiler/xla/service/transfer_manager.h"
 #include "tensorflow/compiler/xla/shape_util.h"
+#include "tensorflow/compiler/xla/test_helpers.h"
 #include "tensorflow/compiler/xla/tests/client_library_test_base.h"
 #include "tensorflow/compiler/xla/tests/literal_test_util.h"
 #include "tensorflow/compiler/xla/tests/test_macros.h"
 #include "tensorflow/compiler/xla/tests/test_utils.h"
+#include "tensorflow/core/platform/stream_executor_no_cuda.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/command_line_flags.h"
 
+namespace se = ::perftools::gputools;
+
 namespace xla {
 namespace {
 
@@ -259,6 +269,24 @@ XLA_TEST_F(DotOperationTest, MatrixDotF32_260_3_520_MinorToMajorFF) {
   TestMatrixDot(260, 3, 520, false, false);
 }
 
+// The sizes below are not multiples of the vector or tile sizes of the
+// emitted dot loops, so that their remainders are exercised too.
+XLA_TEST_F(DotOperationTest, MatrixDotF32_13_37_19_MinorToMajorTT) {
+  TestMatrixDot(13, 37, 19, true, true);
+}
+
+XLA_TEST_F(DotOperationTest, MatrixDotF32_13_37_19_MinorToMajorFF) {
+  TestMatrixDot(13, 37, 19, false, false);
+}
+
+XLA_TEST_F(DotOperationTest, MatrixVectorDotF32_13_37_1_MinorToMajorTT) {
+  TestMatrixDot(13, 37, 1, true, true);
+}
+
+XLA_TEST_F(DotOperationTest, VectorMatrixDotF32_1_37_19_MinorToMajorTT) {
+  TestMatrixDot(1, 37, 19, true, true);
+}
+
 XLA_TEST_F(DotOperationTest, SquareMatrixDotF32MinorToMajorFF) {
   constexpr bool kLhsRowMajor = false;
   constexpr bool kRhsRowMajor = false;
@@ -454,6 +482,76 @@ TEST_F(DotOperationTest, TransposeFolding) {
   }
 }
 
+// Benchmarks the dot of a [m x k] by a [k x n] matrix, with k equal to m.
+void BM_MatrixDotF32(int num_iters, int m, int n) {
+  tensorflow::testing::StopTiming();
+
+  se::Platform* platform = PlatformUtil::GetDefaultPlatform().ValueOrDie();
+  auto executors = PlatformUtil::GetStreamExecutors(platform).ValueOrDie();
+  StreamExecutorMemoryAllocator allocator(platform, executors);
+  LocalClient* client =
+      ClientLibrary::GetOrCreateLocalClient(platform).ValueOrDie();
+  auto* transfer_manager =
+      TransferManager::GetForPlatform(platform).ValueOrDie();
+  int device_ordinal = client->default_device_ordinal();
+
+  const int k = m;
+  ComputationBuilder builder(client, "MatrixDot");
+  Shape lhs_shape = ShapeUtil::MakeShape(F32, {m, k});
+  Shape rhs_shape = ShapeUtil::MakeShape(F32, {k, n});
+  builder.Dot(builder.Parameter(0, lhs_shape, "lhs"),
+              builder.Parameter(1, rhs_shape, "rhs"));
+  auto computation = builder.Build().ConsumeValueOrDie();
+
+  // Initialize and transfer the parameter buffers.
+  auto lhs_buffer =
+      ScopedShapedBuffer::MakeScopedShapedBuffer(lhs_shape, &allocator, 0)
+          .ConsumeValueOrDie();
+  auto rhs_buffer =
+      ScopedShapedBuffer::MakeScopedShapedBuffer(rhs_shape, &allocator, 0)
+          .ConsumeValueOrDie();
+  ASSERT_IS_OK(transfer_manager->TransferLiteralToDevice(
+      executors[device_ordinal],
+      *Literal::CreateR2FromArray2D(*MakeLinspaceArray2D(0.0, 1.0, m, k)),
+      lhs_buffer->mutable_buffer({})));
+  ASSERT_IS_OK(transfer_manager->TransferLiteralToDevice(
+      executors[device_ordinal],
+      *Literal::CreateR2FromArray2D(*MakeLinspaceArray2D(0.0, 1.0, k, n)),
+      rhs_buffer->mutable_buffer({})));
+
+  std::unique_ptr<LocalExecutable> executable =
+      client
+          ->Compile(computation, {&lhs_buffer->shape(), &rhs_buffer->shape()},
+                    ExecutableBuildOptions())
+          .ConsumeValueOrDie();
+
+  // Run some warm-up executions.
+  ExecutableRunOptions options;
+  options.set_allocator(&allocator);
+  const int kWarmups = 2;
+  for (int i = 0; i < kWarmups; ++i) {
+    auto result =
+        executable->Run({lhs_buffer.get(), rhs_buffer.get()}, options);
+    ASSERT_TRUE(result.ok());
+  }
+
+  // Run benchmark.
+  tensorflow::testing::ItemsProcessed(static_cast<int64>(num_iters) * m * k *
+                                      n);
+  tensorflow::testing::StartTiming();
+  for (int i = 0; i < num_iters; ++i) {
+    auto result =
+        executable->Run({lhs_buffer.get(), rhs_buffer.get()}, options);
+    ASSERT_TRUE(result.ok());
+  }
+}
+BENCHMARK(BM_MatrixDotF32)
+    ->ArgPair(16, 1)
+    ->ArgPair(256, 1)
+    ->ArgPair(16, 16)
+    ->ArgPair(64, 64)
+    ->ArgPair(128, 128);
+
 }  // namespace
 }  // namespace xla
 
@@ -473,5 +571,6 @@ int main(int argc, char** argv) {
     LOG(ERROR) << "Unknown argument " << argv[1] << "\n" << usage;
     return 2;
   }
+  tensorflow::testing::RunBenchmarks();
   return RUN_ALL_TESTS();
 }
@@ -0,0 +1,198 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Ring all-reduce of tensors across devices, built from graph ops.
+
+The ring is made of ordinary ops placed on the devices of its members, so the
+tensors move between them through the Send/Recv pairs that graph partitioning
+inserts: within a process through the local rendezvous, and between workers
+through the RecvTensor calls of the distributed runtime (gRPC, verbs or MPI).
+No parameter server takes part, and each member sends and receives
+`2 * (n - 1) / n` times the size of the data, whatever the number `n` of
+members.
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.python.framework import device
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
+
+
+def ring_all_sum(tensors):
+  """Returns the sum of `tensors` on each of their devices.
+
+  The flattened tensors are split into `n = len(tensors)` chunks. In the
+  reduce-scatter phase, for `n - 1` steps, each device adds the chunk it
+  receives from its predecessor in the ring to its own and passes the sum on,
+  after which each device holds the full sum of one chunk. In the all-gather
+  phase, the summed chunks go round the ring for another `n - 1` steps.
+
+  Args:
+    tensors: The tensors to sum, in ring order. They must be assigned to
+      different devices, typically the devices of different workers, and have
+      the same dtype and fully defined shape.
+
+  Returns:
+    List of tensors, where tensor i has the same device as `tensors[i]` and
+    holds the sum of `tensors`.
+
+  Raises:
+    ValueError: If `tensors` is empty, has tensors without device assignment,
+      or has tensors of different dtypes or shapes.
+  """
+  if not tensors:
+    raise ValueError('Must pass >0 tensors to ring_all_sum')
+  shape = tensors[0].get_shape()
+  dtype = tensors[0].dtype
+  if not shape.is_fully_defined():
+    raise ValueError('ring_all_sum requires fully defined shapes, got %s' %
+                     shape)
+  for t in tensors:
+    if not device.canonical_name(t.device):
+      raise ValueError('Device assignment required for ring_all_sum')
+    if t.dtype != dtype:
+      raise ValueError('All tensors must have the same dtype, got %s and %s' %
+                       (dtype, t.dtype))
+    if not shape.is_compatible_with(t.get_shape()):
+      raise ValueError('All tensors must have the same shape, got %s and %s' %
+                       (shape, t.get_shape()))
+  n = len(tensors)
+  if n == 1:
+    with ops.device(tensors[0].device):
+      return [array_ops.identity(tensors[0])]
+
+  # Pad the flattened tensors so that they split evenly into n chunks.
+  num_elements = shape.num_elements()
+  padding = -num_elements % n
+  chunks = []
+  for t in tensors:
+    with ops.device(t.device):
+      flat = array_ops.reshape(t, [-1])
+      if padding:
+        flat = array_ops.concat([flat, array_ops.zeros([padding], dtype)], 0)
+      chunks.append(array_ops.split(flat, n))
+
+  # Reduce-scatter: at step s, device i passes its partial sum of chunk
+  # (i - s) % n to device i + 1, which adds its own. Chunk (i + 1) % n is
+  # complete on device i after n - 1 steps.
+  for step in range(n - 1):
+    new_chunks = [list(c) for c in chunks]
+    for i in range(n):
+      dst = (i + 1) % n
+      c = (i - step) % n
+      with ops.device(tensors[dst].device):
+        new_chunks[dst][c] = math_ops.add(chunks[i][c], chunks[dst][c])
+    chunks = new_chunks
+
+  # All-gather: at step s, device i passes the complete chunk (i + 1 - s) % n
+  # to device i + 1.
+  for step in range(n - 1):
+    new_chunks = [list(c) for c in chunks]
+    for i in range(n):
+      dst = (i + 1) % n
+      c = (i + 1 - step) % n
+      with ops.device(tensors[dst].device):
+        new_chunks[dst][c] = array_ops.identity(chunks[i][c])
+    chunks = new_chunks
+
+  res = []
+  for t, device_chunks in zip(tensors, chunks):
+    with ops.device(t.device):
+      flat = array_ops.concat(device_chunks, 0)
+      if padding:
+        flat = array_ops.slice(flat, [0], [num_elements])
+      res.append(array_ops.reshape(flat, shape))
+  return res
+
+
+def fused_ring_all_sum(tensor_lists, fusion_threshold_bytes=4 * 1024 * 1024):
+  """Sums lists of tensors, such as gradients, with `ring_all_sum`.
+
+  Consecutive small tensors are concatenated into buckets of up to
+  `fusion_threshold_bytes` that go round the ring together, so that the
+  transfers aren't dominated by their fixed cost. Each bucket is summed as soon
+  as its own tensors are computed, so passing the gradients in the order that
+  backprop produces them, i.e. from the last layer to the first, overlaps the
+  transfers of the first buckets with the computation of the others.
+
+  Args:
+    tensor_lists: A list with, for each device, the list of tensors to sum on
+      that device. The lists of all the devices must have tensors of the same
+      shapes and dtypes in the same order.
+    fusion_threshold_bytes: The maximum size of a bucket. Tensors that are
+      larger are summed on their own.
+
+  Returns:
+    A list with the same structure as `tensor_lists`, holding the sums.
+
+  Raises:
+    ValueError: If `tensor_lists` is empty or its lists don't match.
+  """
+  if not tensor_lists:
+    raise ValueError('Must pass >0 devices to fused_ring_all_sum')
+  reference = tensor_lists[0]
+  for tensors in tensor_lists:
+    if len(tensors) != len(reference):
+      raise ValueError('All devices must have the same number of tensors')
+
+  res = [[None] * len(reference) for _ in tensor_lists]
+  for bucket in _fusion_buckets(reference, fusion_threshold_bytes):
+    shapes = [reference[k].get_shape() for k in bucket]
+    sizes = [s.num_elements() for s in shapes]
+    fused = []
+    for tensors in tensor_lists:
+      with ops.device(tensors[bucket[0]].device):
+        if len(bucket) == 1:
+          fused.append(tensors[bucket[0]])
+        else:
+          fused.append(
+              array_ops.concat(
+                  [array_ops.reshape(tensors[k], [-1]) for k in bucket], 0))
+    sums = ring_all_sum(fused)
+    for i, t in enumerate(sums):
+      if len(bucket) == 1:
+        res[i][bucket[0]] = t
+        continue
+      with ops.device(t.device):
+        for k, part, s in zip(bucket, array_ops.split(t, sizes), shapes):
+          res[i][k] = array_ops.reshape(part, s)
+  return res
+
+
+def _fusion_buckets(tensors, fusion_threshold_bytes):
+  """Returns lists of the indices of `tensors` to concatenate together.
+
+  Consecutive tensors of the same dtype share a bucket as long as the bucket
+  is at most `fusion_threshold_bytes`.
+  """
+  buckets = []
+  bucket_bytes = 0
+  bucket_dtype = None
+  for k, t in enumerate(tensors):
+    shape = t.get_shape()
+    if not shape.is_fully_defined():
+      raise ValueError('Fusion requires fully defined shapes, got %s' % shape)
+    num_bytes = shape.num_elements() * t.dtype.size
+    if (not buckets or t.dtype != bucket_dtype or
+        bucket_bytes + num_bytes > fusion_threshold_bytes):
+      buckets.append([])
+      bucket_bytes = 0
+      bucket_dtype = t.dtype
+    buckets[-1].append(k)
+    bucket_bytes += num_bytes
+  return buckets
@@ -0,0 +1,112 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the ring all-reduce."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import numpy as np
+
+from tensorflow.contrib.all_reduce.python import all_reduce
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import device as pydev
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
+from tensorflow.python.platform import test
+
+_NUM_DEVICES = 3
+
+
+class RingAllSumTest(test.TestCase):
+
+  def _config(self):
+    return config_pb2.ConfigProto(device_count={'CPU': _NUM_DEVICES})
+
+  def _devices(self, n):
+    return ['/cpu:%d' % i for i in range(n)]
+
+  def _constants(self, values, devices):
+    tensors = []
+    for v, d in zip(values, devices):
+      with ops.device(d):
+        tensors.append(constant_op.constant(v))
+    return tensors
+
+  def testRingAllSum(self):
+    # The shapes exercise the padding of chunks that don't split evenly.
+    for n in range(1, _NUM_DEVICES + 1):
+      for shape in [[1], [7], [3, 4], [2, 5, 3]]:
+        with self.test_session(config=self._config()) as sess:
+          values = [np.random.random_sample(shape).astype(np.float32)
+                    for _ in range(n)]
+          devices = self._devices(n)
+          sums = all_reduce.ring_all_sum(self._constants(values, devices))
+          self.assertEqual(n, len(sums))
+          for t, d in zip(sums, devices):
+            self.assertEqual(pydev.canonical_name(d),
+                             pydev.canonical_name(t.device))
+          expected = np.sum(values, axis=0)
+          for result in sess.run(sums):
+            self.assertAllClose(expected, result)
+
+  def testFusedRingAllSum(self):
+    shapes = [[4], [2, 3], [1000], [5]]
+    dtypes_list = [np.float32, np.float32, np.float32, np.int32]
+    with self.test_session(config=self._config()) as sess:
+      devices = self._devices(_NUM_DEVICES)
+      value_lists = [[np.random.randint(0, 10, s).astype(dt)
+                      for s, dt in zip(shapes, dtypes_list)]
+                     for _ in devices]
+      tensor_lists = [self._constants(values, [d] * len(values))
+                      for values, d in zip(value_lists, devices)]
+      # A threshold that puts the first two tensors in one bucket and the
+      # large one in its own.
+      sums = all_reduce.fused_ring_all_sum(tensor_lists,
+                                           fusion_threshold_bytes=100)
+      for results in sess.run(sums):
+        for k, result in enumerate(results):
+          expected = np.sum([values[k] for values in value_lists], axis=0)
+          self.assertEqual(dtypes_list[k], result.dtype)
+          self.assertAllEqual(expected, result)
+
+  def testFusionBuckets(self):
+    tensors = [array_ops.zeros([4]), array_ops.zeros([2, 3]),
+               array_ops.zeros([1000]), array_ops.zeros([5], dtypes.int32),
+               array_ops.zeros([5], dtypes.int32)]
+    self.assertEqual([[0, 1], [2], [3, 4]],
+                     all_reduce._fusion_buckets(tensors, 100))
+
+  def testErrors(self):
+    with self.assertRaisesRegexp(ValueError, 'Must pass >0'):
+      all_reduce.ring_all_sum([])
+    with self.assertRaisesRegexp(ValueError, 'Device assignment required'):
+      all_reduce.ring_all_sum([array_ops.zeros([4])])
+    with ops.device('/cpu:0'):
+      a = array_ops.zeros([4])
+      b = array_ops.zeros([5])
+      c = array_ops.zeros([4], dtypes.int32)
+    with self.assertRaisesRegexp(ValueError, 'same shape'):
+      all_reduce.ring_all_sum([a, b])
+    with self.assertRaisesRegexp(ValueError, 'same dtype'):
+      all_reduce.ring_all_sum([a, c])
+    with self.assertRaisesRegexp(ValueError, 'same number of tensors'):
+      all_reduce.fused_ring_all_sum([[a], [a, a]])
+
+
+if __name__ == '__main__':
+  test.main()
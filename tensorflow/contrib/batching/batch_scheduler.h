@@ -62,6 +62,12 @@ class BatchTask {
   // Returns the size of the task, in terms of how much it contributes to the
   // size of a batch. (A batch's size is the sum of its task sizes.)
   virtual size_t size() const = 0;
+
+  // Returns the time (in terms of Env::NowMicros()) by which the task's batch
+  // should be processed, or 0 if the task has no deadline. Schedulers that
+  // support deadlines reject tasks whose deadline has passed, and process
+  // batches early to meet the deadlines of their tasks.
+  virtual uint64 deadline_micros() const { return 0; }
 };
 
 // A thread-safe collection of BatchTasks, to be executed together in some
@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+
 #include "tensorflow/contrib/batching/shared_batch_scheduler.h"
 #include "tensorflow/contrib/batching/util/periodic_function.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -25,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/kernels/split_lib.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/macros.h"
 
 namespace tensorflow {
@@ -93,6 +96,88 @@ Status Concat(OpKernelContext* context, const gtl::ArraySlice<Tensor>& inputs,
   return Status::OK();
 }
 
+// Like Concat(), but for inputs of rank at least two that may differ in the
+// first dimension (the sequence length): each input is zero-padded at the end
+// of that dimension to 'padded_length', which must be at least as large as
+// the first dimension of every input. The remaining dimensions must match.
+template <typename T>
+Status ConcatPadded(OpKernelContext* context,
+                    const gtl::ArraySlice<Tensor>& inputs, int64 padded_length,
+                    int output_index) {
+  const TensorShape& input_shape = inputs[0].shape();
+  if (input_shape.dims() < 2) {
+    return errors::InvalidArgument(
+        "Bucketed batching inputs must have at least two dimensions; got ",
+        input_shape.DebugString());
+  }
+  int64 inner_size = 1;
+  for (int j = 2; j < input_shape.dims(); ++j) {
+    inner_size *= input_shape.dim_size(j);
+  }
+  int64 output_dim0 = 0;
+  for (int i = 0; i < inputs.size(); ++i) {
+    const TensorShape& shape = inputs[i].shape();
+    bool dims_match = shape.dims() == input_shape.dims();
+    for (int j = 2; dims_match && j < shape.dims(); ++j) {
+      dims_match = shape.dim_size(j) == input_shape.dim_size(j);
+    }
+    if (!dims_match) {
+      return errors::InvalidArgument(
+          "Dimensions of inputs should match except for the sequence length: "
+          "shape[0] = ",
+          input_shape.DebugString(), " vs. shape[", i,
+          "] = ", shape.DebugString());
+    }
+    if (shape.dim_size(1) > padded_length) {
+      return errors::InvalidArgument("Sequence length of shape[", i, "] = ",
+                                     shape.DebugString(),
+                                     " exceeds the bucket length ",
+                                     padded_length);
+    }
+    output_dim0 += shape.dim_size(0);
+  }
+
+  TensorShape output_shape(input_shape);
+  output_shape.set_dim(0, output_dim0);
+  output_shape.set_dim(1, padded_length);
+  Tensor* output = nullptr;
+  TF_RETURN_IF_ERROR(
+      context->allocate_output(output_index, output_shape, &output));
+  if (output->NumElements() == 0) {
+    return Status::OK();
+  }
+
+  // Copy each input into its rows of the output, and fill the rest of those
+  // rows with zeros, so that every output element is written exactly once.
+  const CPUDevice& device = context->eigen_device<CPUDevice>();
+  auto output_shaped =
+      output->shaped<T, 3>({output_dim0, padded_length, inner_size});
+  int64 position = 0;
+  for (const Tensor& input : inputs) {
+    const int64 rows = input.dim_size(0);
+    const int64 length = input.dim_size(1);
+    if (rows == 0) {
+      continue;
+    }
+    if (length > 0) {
+      Eigen::DSizes<Eigen::DenseIndex, 3> offsets{position, 0, 0};
+      Eigen::DSizes<Eigen::DenseIndex, 3> sizes{rows, length, inner_size};
+      output_shaped.slice(offsets, sizes).device(device) =
+          input.shaped<T, 3>({rows, length, inner_size});
+    }
+    if (length < padded_length) {
+      Eigen::DSizes<Eigen::DenseIndex, 3> offsets{position, length, 0};
+      Eigen::DSizes<Eigen::DenseIndex, 3> sizes{rows, padded_length - length,
+                                                inner_size};
+      output_shaped.slice(offsets, sizes).device(device) =
+          output_shaped.slice(offsets, sizes).constant(T());
+    }
+    position += rows;
+  }
+
+  return Status::OK();
+}
+
 // The Split*() functions split 'input' with element type T into 'sizes.size()'
 // tensors along the zeroth dimension, with the ith split having zeroth-
 // dimension size 'sizes[i]'. They allocate the output tensors using 'context',
@@ -209,6 +294,7 @@ class BatchResource : public ResourceBase {
   static Status Create(int32 num_batch_threads, int32 max_batch_size,
                        int32 batch_timeout_micros,
                        const std::vector<int32>& allowed_batch_sizes,
+                       const std::vector<int32>& sequence_length_buckets,
                        std::unique_ptr<BatchResource>* resource) {
     std::unique_ptr<BatchResource> new_resource(new BatchResource);
 
@@ -222,6 +308,7 @@ class BatchResource : public ResourceBase {
         batch_timeout_micros;
 
     new_resource->allowed_batch_sizes_ = allowed_batch_sizes;
+    new_resource->sequence_length_buckets_ = sequence_length_buckets;
 
     *resource = std::move(new_resource);
     return Status::OK();
@@ -230,7 +317,8 @@ class BatchResource : public ResourceBase {
   string DebugString() final { return "BatchResource"; }
 
   // Ingests data from one invocation of the batch op. The data is enqueued to
-  // be combined with others into a batch, asynchronously.
+  // be combined with others into a batch, asynchronously. With sequence length
+  // buckets, the data goes to the queue of the smallest bucket that fits it.
   Status RegisterInput(int64 guid, OpKernelContext* context,
                        const string& batcher_queue_name,
                        AsyncOpKernel::DoneCallback done_callback) {
@@ -255,9 +343,14 @@ class BatchResource : public ResourceBase {
     batch_components->context = context;
     batch_components->done_callback = std::move(done_callback);
 
+    string queue_name = batcher_queue_name;
+    if (!sequence_length_buckets_.empty()) {
+      TF_RETURN_IF_ERROR(
+          SelectBucket(batch_components->inputs, &batch_components->bucket));
+      strings::StrAppend(&queue_name, "/bucket_", batch_components->bucket);
+    }
     BatcherQueue* batcher_queue;
-    TF_RETURN_IF_ERROR(
-        LookupOrCreateBatcherQueue(batcher_queue_name, &batcher_queue));
+    TF_RETURN_IF_ERROR(LookupOrCreateBatcherQueue(queue_name, &batcher_queue));
     return batcher_queue->Schedule(&batch_components);
   }
 
@@ -271,6 +364,10 @@ class BatchResource : public ResourceBase {
 
     std::vector<Tensor> inputs;
     OpKernelContext* context;
+
+    // If the op uses sequence length buckets, the length to which the inputs
+    // of rank two or more are padded in their first dimension. Otherwise 0.
+    int64 bucket = 0;
     AsyncOpKernel::DoneCallback done_callback;
 
     size_t size() const override { return inputs[0].shape().dim_size(0); }
@@ -295,6 +392,28 @@ class BatchResource : public ResourceBase {
     return Status::OK();
   }
 
+  // Sets 'bucket' to the smallest entry in 'sequence_length_buckets_' that is
+  // greater than or equal to the sequence length, i.e. the first dimension, of
+  // every input of rank two or more.
+  Status SelectBucket(const std::vector<Tensor>& inputs, int64* bucket) const {
+    int64 sequence_length = 0;
+    for (const Tensor& input : inputs) {
+      if (input.dims() >= 2) {
+        sequence_length = std::max(sequence_length, input.dim_size(1));
+      }
+    }
+    for (int32 bound : sequence_length_buckets_) {
+      if (bound >= sequence_length) {
+        *bucket = bound;
+        return Status::OK();
+      }
+    }
+    return errors::InvalidArgument(
+        "Sequence length ", sequence_length,
+        " exceeds the largest sequence length bucket ",
+        sequence_length_buckets_.back());
+  }
+
   // Returns the smallest entry in 'allowed_batch_sizes_' that is greater than
   // or equal to 'batch_size'. If 'allowed_batch_sizes_' is empty, simply
   // returns 'batch_size'.
@@ -328,16 +447,25 @@ class BatchResource : public ResourceBase {
     OP_REQUIRES_OK_ASYNC(last_task_context, ValidateBatch(*batch),
                          last_task_callback);
 
-    // All tasks should have the same number of input edges.
+    // All tasks should have the same number of input edges, and come from the
+    // queue of the same bucket.
     const int num_input_edges = batch->task(0).inputs.size();
+    const int64 bucket = batch->task(0).bucket;
 
     // Process each input edge one at a time (the typical case has just one).
     for (int i = 0; i < num_input_edges; ++i) {
+      // Inputs of rank two or more are padded to the bucket's sequence length.
+      const bool pad_sequences =
+          bucket > 0 && batch->task(0).inputs.at(i).dims() >= 2;
+
       // Emit batch->num_tasks() - 1 empty output tensors.
       for (int task_idx = 0; task_idx < batch->num_tasks() - 1; ++task_idx) {
         const BatchTask& task = batch->task(task_idx);
         TensorShape output_shape(task.inputs.at(i).shape());
         output_shape.set_dim(0, 0);
+        if (pad_sequences) {
+          output_shape.set_dim(1, bucket);
+        }
         Tensor* output = nullptr;
         OP_REQUIRES_OK_ASYNC(
             task.context,
@@ -345,6 +473,15 @@ class BatchResource : public ResourceBase {
             task.done_callback);
       }
 
+      // A batch of a single unpadded task is its own concatenation, so forward
+      // the task's input tensor without copying it.
+      if (batch->num_tasks() == 1 && padding_amount == 0 &&
+          (!pad_sequences ||
+           batch->task(0).inputs.at(i).dim_size(1) == bucket)) {
+        last_task_context->set_output(i, batch->task(0).inputs.at(i));
+        continue;
+      }
+
       // Concatenate the tasks ith input tensors into a big output tensor.
       std::vector<Tensor> to_concatenate;
       to_concatenate.reserve(batch->num_tasks());
@@ -353,7 +490,8 @@ class BatchResource : public ResourceBase {
       }
 
       // Add padding as needed. Use the first row of the first task's tensor as
-      // the data for padding.
+      // the data for padding. Split() takes that row as an aliasing slice when
+      // the tensor is aligned, and only copies it otherwise.
       if (padding_amount > 0) {
         const Tensor& padding_source = batch->task(0).inputs.at(i);
         Tensor padding;
@@ -367,8 +505,8 @@ class BatchResource : public ResourceBase {
           switch (type) {
 #define CASE(type)                                                   \
   case DataTypeToEnum<type>::value:                                  \
-    slice_status = SplitCPU<type>(last_task_context, padding_source, \
-                                  slice_sizes, &slices);             \
+    slice_status = Split<type>(last_task_context, padding_source,    \
+                               slice_sizes, &slices);                \
     break;
             TF_CALL_ALL_TYPES(CASE);
 #undef CASE
@@ -389,9 +527,13 @@ class BatchResource : public ResourceBase {
       const DataType type = to_concatenate[0].dtype();
       Status concat_status;
       switch (type) {
-#define CASE(type)                                                      \
-  case DataTypeToEnum<type>::value:                                     \
-    concat_status = Concat<type>(last_task_context, to_concatenate, i); \
+#define CASE(type)                                                          \
+  case DataTypeToEnum<type>::value:                                         \
+    concat_status =                                                         \
+        pad_sequences                                                       \
+            ? ConcatPadded<type>(last_task_context, to_concatenate, bucket, \
+                                 i)                                         \
+            : Concat<type>(last_task_context, to_concatenate, i);           \
     break;
         TF_CALL_ALL_TYPES(CASE);
 #undef CASE
@@ -496,6 +638,10 @@ class BatchResource : public ResourceBase {
       GUARDED_BY(batcher_queues_mu_);
 
   std::vector<int32> allowed_batch_sizes_;
+
+  // The sequence length buckets, in increasing order, or empty if the inputs
+  // are batched without bucketing.
+  std::vector<int32> sequence_length_buckets_;
 };
 
 class BatchKernel : public AsyncOpKernel {
@@ -515,6 +661,9 @@ class BatchKernel : public AsyncOpKernel {
                    c->GetAttr("batch_timeout_micros", &batch_timeout_micros_));
     OP_REQUIRES_OK(c, c->GetAttr("allowed_batch_sizes", &allowed_batch_sizes_));
     OP_REQUIRES_OK(c, ValidateAllowedBatchSizes());
+    OP_REQUIRES_OK(
+        c, c->GetAttr("sequence_length_buckets", &sequence_length_buckets_));
+    OP_REQUIRES_OK(c, ValidateSequenceLengthBuckets());
   }
 
   void ComputeAsync(OpKernelContext* c, DoneCallback done) final {
@@ -524,7 +673,8 @@ class BatchKernel : public AsyncOpKernel {
           std::unique_ptr<BatchResource> new_resource;
           TF_RETURN_IF_ERROR(BatchResource::Create(
               num_batch_threads_, max_batch_size_, batch_timeout_micros_,
-              allowed_batch_sizes_, &new_resource));
+              allowed_batch_sizes_, sequence_length_buckets_,
+              &new_resource));
           *r = new_resource.release();
           return Status::OK();
         };
@@ -563,6 +713,21 @@ class BatchKernel : public AsyncOpKernel {
     return Status::OK();
   }
 
+  // Validates 'sequence_length_buckets_'. The entries must be positive and
+  // increase monotonically.
+  Status ValidateSequenceLengthBuckets() const {
+    int32 last_bound = 0;
+    for (const int32 bound : sequence_length_buckets_) {
+      if (bound <= last_bound) {
+        return errors::InvalidArgument(
+            "sequence_length_buckets entries must be positive and "
+            "monotonically increasing");
+      }
+      last_bound = bound;
+    }
+    return Status::OK();
+  }
+
  private:
   string container_;
   string shared_name_;
@@ -571,6 +736,7 @@ class BatchKernel : public AsyncOpKernel {
   int32 max_batch_size_;
   int32 batch_timeout_micros_;
   std::vector<int32> allowed_batch_sizes_;
+  std::vector<int32> sequence_length_buckets_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("Batch").Device(DEVICE_CPU), BatchKernel);
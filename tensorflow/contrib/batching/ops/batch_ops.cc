@@ -32,14 +32,23 @@ REGISTER_OP("Batch")
     .Attr("container: string = ''")
     .Attr("shared_name: string = ''")
     .Attr("batching_queue: string = ''")
+    .Attr("sequence_length_buckets: list(int) = []")
     .Attr("T: list(type)")
     .SetShapeFn([](shape_inference::InferenceContext* c) {
+      std::vector<int32> sequence_length_buckets;
+      TF_RETURN_IF_ERROR(
+          c->GetAttr("sequence_length_buckets", &sequence_length_buckets));
       std::vector<shape_inference::ShapeHandle> in_shapes;
       TF_RETURN_IF_ERROR(c->input("in_tensors", &in_shapes));
       std::vector<shape_inference::ShapeHandle> out_shapes(in_shapes.size());
       for (int i = 0; i < in_shapes.size(); ++i) {
         TF_RETURN_IF_ERROR(
             c->ReplaceDim(in_shapes[i], 0, c->UnknownDim(), &out_shapes[i]));
+        if (!sequence_length_buckets.empty() && c->RankKnown(out_shapes[i]) &&
+            c->Rank(out_shapes[i]) >= 2) {
+          TF_RETURN_IF_ERROR(c->ReplaceDim(out_shapes[i], 1, c->UnknownDim(),
+                                           &out_shapes[i]));
+        }
       }
       TF_RETURN_IF_ERROR(c->set_output("batched_tensors", out_shapes));
       TF_RETURN_IF_ERROR(c->set_output("id", {c->Scalar()}));
@@ -69,6 +78,14 @@ start, and length of elements of each set of Tensors present in batched_tensors.
 Batched tensors are concatenated along the first dimension, and all tensors in
 in_tensors must have the first dimension of the same size.
 
+Variable-length sequences can be batched by supplying sequence_length_buckets.
+The sequence length of an invocation is the largest second dimension of its
+tensors of rank two or more. Each invocation is then batched only with others
+of the same bucket, i.e. whose sequence length rounds up to the same entry of
+sequence_length_buckets, and its tensors of rank two or more are zero-padded in
+the second dimension to that entry when the batch is formed. Each bucket forms
+its batches independently and pads them according to allowed_batch_sizes.
+
 in_tensors: The tensors to be batched.
 num_batch_threads: Number of scheduling threads for processing batches of work.
  Determines the number of batches processed in parallel.
@@ -80,6 +97,9 @@ allowed_batch_sizes: Optional list of allowed batch sizes. If left empty, does
  batches up to one of those sizes. The entries must increase monotonically, and
  the final entry must equal max_batch_size.
 grad_timeout_micros: The timeout to use for the gradient. See Unbatch.
+sequence_length_buckets: Optional list of sequence lengths. If left empty, does
+ nothing. Otherwise, the entries must be positive and increase monotonically,
+ and no invocation may have a sequence length greater than the final entry.
 batched_tensors: Either empty tensors or a batch of concatenated Tensors.
 batch_index: If out_tensors is non-empty, has information to invert it.
 container: Controls the scope of sharing of this batch.
@@ -62,7 +62,8 @@ def _UnbatchGrad(op, grad):   # pylint: disable=invalid-name
 def batch_function(num_batch_threads, max_batch_size, batch_timeout_micros,
                    allowed_batch_sizes=None,
                    grad_timeout_micros=60 * 1000 * 1000,
-                   unbatch_timeout_micros=60 * 1000 * 1000):
+                   unbatch_timeout_micros=60 * 1000 * 1000,
+                   sequence_length_buckets=None):
   """Batches the computation done by the decorated function.
 
   So, for example, in the following code
@@ -100,6 +101,11 @@ def batch_function(num_batch_threads, max_batch_size, batch_timeout_micros,
      documentation of the unbatch op for more details. Defaults to 60s.
     unbatch_timeout_micros: The timeout to use for unbatching. See the
      documentation of the unbatch op for more details. Defaults to 60s.
+    sequence_length_buckets: Optional list of sequence lengths. If left empty,
+     does nothing. Otherwise, arguments of rank two or more may differ in their
+     second dimension; calls are only batched with others in the same bucket,
+     and those arguments are zero-padded to the bucket's length. See the
+     documentation of the `Batch` op for more details.
 
   Returns:
     The decorated function will return the unbatched computation output Tensors.
@@ -119,6 +125,7 @@ def batch_function(num_batch_threads, max_batch_size, batch_timeout_micros,
             batch_timeout_micros=batch_timeout_micros,
             allowed_batch_sizes=allowed_batch_sizes,
             grad_timeout_micros=grad_timeout_micros,
+            sequence_length_buckets=sequence_length_buckets,
             shared_name=name)
         outputs = f(*batched_tensors)
         if isinstance(outputs, ops.Tensor):
@@ -17,6 +17,7 @@ limitations under the License.
 #define THIRD_PARTY_TENSORFLOW_CONTRIB_BATCHING_SHARED_BATCH_SCHEDULER_H_
 
 #include <stddef.h>
+#include <algorithm>
 #include <deque>
 #include <functional>
 #include <list>
@@ -26,6 +27,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/contrib/batching/batch_scheduler.h"
+#include "tensorflow/contrib/batching/util/adaptive_batch_controller.h"
 #include "tensorflow/contrib/batching/util/periodic_function.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -69,10 +71,19 @@ namespace serving {
 // dynamically, to accommodate e.g. versions of a model being brought up and
 // down over the lifetime of a server.
 //
-// The batch thread pool round-robins through the queues, running one batch
-// from a queue and then moving to the next queue. Each queue behaves like a
-// BasicBatchScheduler instance, in the sense that it has maximum batch size and
-// timeout parameters, which govern when a batch is eligible to be processed.
+// The batch thread pool round-robins through the queues, running 'share'
+// batches from a queue and then moving to the next queue. (E.g. with queues A
+// and B having shares 1 and 2 respectively, the servicing pattern is ABBABB...)
+// Queues are further grouped into strict priority classes: while any queue of
+// a higher 'priority' has a batch eligible to be processed, queues of lower
+// priority are passed over. Each queue behaves like a BasicBatchScheduler
+// instance, in the sense that it has maximum batch size and timeout
+// parameters, which govern when a batch is eligible to be processed.
+//
+// Tasks may carry deadlines (see BatchTask::deadline_micros()). A task whose
+// deadline is too close to be met is rejected by Schedule(), and a batch is
+// made eligible to be processed early, ahead of its timeout, to meet the
+// earliest deadline among its tasks.
 //
 // Each queue is independently configured with a maximum size (in terms of the
 // maximum number of batches worth of enqueued tasks). For online serving, it is
@@ -90,10 +101,6 @@ namespace serving {
 // For bulk processing jobs and throughput-oriented benchmarks, you may want to
 // set the maximum queue size to a large value.
 //
-// TODO(b/26539183): Support queue servicing policies other than round-robin.
-// E.g. let each queue specify a "share" (an int >= 1), so e.g. with queues A
-// and B having shares 1 and 2 respectively, the servicing pattern is ABBABB...
-//
 //
 // PERFORMANCE TUNING: See README.md.
 //
@@ -157,6 +164,29 @@ class SharedBatchScheduler
     // See the class documentation above for guidelines on how to tune this
     // parameter.
     int max_enqueued_batches = 10;
+
+    // EXPERIMENTAL: If non-null, the queue forms batches of up to the
+    // controller's target batch size (capped by 'max_batch_size'), uses the
+    // controller's batch timeout in place of 'batch_timeout_micros', and
+    // reports every processed batch to the controller. A controller must not
+    // be shared between queues.
+    std::shared_ptr<AdaptiveBatchController> adaptive_batch_controller;
+
+    // The number of consecutive batches the batch threads take from this queue
+    // before moving on to the next queue of the same priority. Must be >= 1.
+    int share = 1;
+
+    // The strict priority class of this queue. Queues of a lower priority are
+    // only serviced when no queue of a higher priority has a batch that is
+    // eligible to be processed. E.g. interactive traffic may be given a higher
+    // priority than bulk traffic sharing the same batch threads.
+    int priority = 0;
+
+    // The time (in microseconds) reserved before a task's deadline for
+    // processing its batch. Schedule() rejects with a DEADLINE_EXCEEDED error
+    // tasks whose deadline is less than this far away, and a batch becomes
+    // eligible to be processed once any of its tasks' deadlines is this close.
+    int64 deadline_margin_micros = 0;
   };
   Status AddQueue(const QueueOptions& options,
                   std::function<void(std::unique_ptr<Batch<TaskType>>)>
@@ -190,6 +220,11 @@ class SharedBatchScheduler
   // available batch thread should grab work.
   typename QueueList::iterator next_queue_to_schedule_ GUARDED_BY(mu_);
 
+  // The number of batches taken from '*next_queue_to_schedule_' since the
+  // iterator last moved. The iterator moves on once this reaches the queue's
+  // share.
+  int num_batches_from_next_queue_ GUARDED_BY(mu_) = 0;
+
   // Used by idle batch threads to wait for work to enter the system. Notified
   // whenever a batch becomes schedulable.
   condition_variable schedulable_batch_cv_;
@@ -251,11 +286,14 @@ class Queue {
   // Called by a thread that is ready to process a batch, to request one from
   // this queue. Either returns a batch that is ready to be processed, or
   // nullptr if the queue declines to schedule a batch at this time. If it
-  // returns a batch, the batch is guaranteed to be closed.
-  std::unique_ptr<Batch<TaskType>> ScheduleBatch();
+  // returns a batch, the batch is guaranteed to be closed, and
+  // '*queueing_micros' is set to the time its first task waited in the queue.
+  std::unique_ptr<Batch<TaskType>> ScheduleBatch(int64* queueing_micros);
 
-  // Processes a batch that has been returned earlier by ScheduleBatch().
-  void ProcessBatch(std::unique_ptr<Batch<TaskType>> batch);
+  // Processes a batch that has been returned earlier by ScheduleBatch(), along
+  // with the 'queueing_micros' returned for it.
+  void ProcessBatch(std::unique_ptr<Batch<TaskType>> batch,
+                    int64 queueing_micros);
 
   // Determines whether the queue is empty, i.e. has no tasks waiting or being
   // processed.
@@ -269,6 +307,12 @@ class Queue {
     return closed_;
   }
 
+  // Determines whether ScheduleBatch() would currently return a batch.
+  bool HasSchedulableBatch() const;
+
+  int share() const { return options_.share; }
+  int priority() const { return options_.priority; }
+
  private:
   // Same as IsEmpty(), but assumes the caller already holds a lock on 'mu_'.
   bool IsEmptyInternal() const EXCLUSIVE_LOCKS_REQUIRED(mu_);
@@ -281,6 +325,12 @@ class Queue {
   // currently schedulable.
   bool IsOpenBatchSchedulable() const EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
+  // The size at which batches are closed, and the batch timeout. These come
+  // from 'options_.adaptive_batch_controller' if set, and are otherwise the
+  // static options.
+  int TargetBatchSize() const;
+  int64 BatchTimeoutMicros() const;
+
   const typename SharedBatchScheduler<TaskType>::QueueOptions options_;
 
   // The environment to use.
@@ -308,6 +358,15 @@ class Queue {
   // in 'batches_'. Valid iff that batch contains at least one task.
   uint64 open_batch_start_time_micros_ GUARDED_BY(mu_);
 
+  // The earliest deadline of the tasks in the open (back-most) batch in
+  // 'batches_', or 0 if none of them has a deadline.
+  uint64 open_batch_deadline_micros_ GUARDED_BY(mu_) = 0;
+
+  // The times at which the first task was added to each of the closed batches
+  // in 'batches_', front-most first. Only maintained if
+  // 'options_.adaptive_batch_controller' is set.
+  std::deque<uint64> closed_batch_start_times_micros_ GUARDED_BY(mu_);
+
   // Whether this queue contains a batch that is eligible to be scheduled. Used
   // to keep track of when to call 'schedulable_batch_callback_'.
   bool schedulable_batch_ GUARDED_BY(mu_) = false;
@@ -402,6 +461,15 @@ Status SharedBatchScheduler<TaskType>::AddQueue(
         "max_enqueued_batches must be non-negative; was ",
         options.max_enqueued_batches);
   }
+  if (options.share < 1) {
+    return errors::InvalidArgument("share must be positive; was ",
+                                   options.share);
+  }
+  if (options.deadline_margin_micros < 0) {
+    return errors::InvalidArgument(
+        "deadline_margin_micros must be non-negative; was ",
+        options.deadline_margin_micros);
+  }
 
   auto schedulable_batch_callback = [this] {
     mutex_lock l(mu_);
@@ -446,35 +514,56 @@ void SharedBatchScheduler<TaskType>::ThreadLogic() {
   std::unique_ptr<Batch<TaskType>> batch_to_process;
   // The queue with which 'batch_to_process' is associated.
   internal::Queue<TaskType>* queue_for_batch = nullptr;
+  // The time the first task of 'batch_to_process' waited in the queue.
+  int64 queueing_micros = 0;
   {
     mutex_lock l(mu_);
 
+    // Find the highest priority class that has a batch to process. Queues of
+    // lower priorities are passed over below.
+    bool have_schedulable_batch = false;
+    int top_priority = 0;
+    for (const auto& queue : queues_) {
+      if ((!have_schedulable_batch || queue->priority() > top_priority) &&
+          queue->HasSchedulableBatch()) {
+        have_schedulable_batch = true;
+        top_priority = queue->priority();
+      }
+    }
+
     const int num_queues = queues_.size();
     for (int num_queues_tried = 0;
          batch_to_process == nullptr && num_queues_tried < num_queues;
          ++num_queues_tried) {
       DCHECK(next_queue_to_schedule_ != queues_.end());
+      internal::Queue<TaskType>* queue = next_queue_to_schedule_->get();
 
       // If a closed queue responds to ScheduleBatch() with nullptr, the queue
       // will never yield any further batches so we can drop it. To avoid a
       // race, we take a snapshot of the queue's closedness state *before*
       // calling ScheduleBatch().
-      const bool queue_closed = (*next_queue_to_schedule_)->closed();
+      const bool queue_closed = queue->closed();
 
-      // Ask '*next_queue_to_schedule_' if it wants us to process a batch.
-      batch_to_process = (*next_queue_to_schedule_)->ScheduleBatch();
+      // Ask 'queue' if it wants us to process a batch.
+      if (!have_schedulable_batch || queue->priority() == top_priority) {
+        batch_to_process = queue->ScheduleBatch(&queueing_micros);
+      }
       if (batch_to_process != nullptr) {
-        queue_for_batch = next_queue_to_schedule_->get();
+        queue_for_batch = queue;
+        ++num_batches_from_next_queue_;
       }
 
-      // Advance 'next_queue_to_schedule_'.
-      if (queue_closed && (*next_queue_to_schedule_)->IsEmpty() &&
-          batch_to_process == nullptr) {
+      // Advance 'next_queue_to_schedule_', unless 'queue' has batches left in
+      // its share.
+      if (queue_closed && queue->IsEmpty() && batch_to_process == nullptr) {
         // We've encountered a closed queue with no work to do. Drop it.
-        DCHECK_NE(queue_for_batch, next_queue_to_schedule_->get());
+        DCHECK_NE(queue_for_batch, queue);
         next_queue_to_schedule_ = queues_.erase(next_queue_to_schedule_);
-      } else {
+        num_batches_from_next_queue_ = 0;
+      } else if (batch_to_process == nullptr ||
+                 num_batches_from_next_queue_ >= queue->share()) {
         ++next_queue_to_schedule_;
+        num_batches_from_next_queue_ = 0;
       }
       if (next_queue_to_schedule_ == queues_.end() && !queues_.empty()) {
         // We've hit the end. Wrap to the first queue.
@@ -491,7 +580,7 @@ void SharedBatchScheduler<TaskType>::ThreadLogic() {
     }
   }
 
-  queue_for_batch->ProcessBatch(std::move(batch_to_process));
+  queue_for_batch->ProcessBatch(std::move(batch_to_process), queueing_micros);
 }
 
 namespace internal {
@@ -532,7 +621,18 @@ Status Queue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
 
     DCHECK(!closed_);
 
-    if (batches_.back()->size() + (*task)->size() > options_.max_batch_size) {
+    const uint64 deadline_micros = (*task)->deadline_micros();
+    if (deadline_micros != 0 &&
+        static_cast<int64>(env_->NowMicros()) +
+                options_.deadline_margin_micros >=
+            static_cast<int64>(deadline_micros)) {
+      return errors::DeadlineExceeded(
+          "The deadline of the task submitted to the batch scheduling queue "
+          "cannot be met");
+    }
+
+    if (!batches_.back()->empty() &&
+        batches_.back()->size() + (*task)->size() > TargetBatchSize()) {
       if (batches_.size() >= options_.max_enqueued_batches) {
         return errors::Unavailable(
             "The batch scheduling queue to which this task was submitted is "
@@ -542,6 +642,12 @@ Status Queue<TaskType>::Schedule(std::unique_ptr<TaskType>* task) {
     }
     if (batches_.back()->empty()) {
       open_batch_start_time_micros_ = env_->NowMicros();
+      open_batch_deadline_micros_ = 0;
+    }
+    if (deadline_micros != 0 &&
+        (open_batch_deadline_micros_ == 0 ||
+         deadline_micros < open_batch_deadline_micros_)) {
+      open_batch_deadline_micros_ = deadline_micros;
     }
     batches_.back()->AddTask(std::move(*task));
 
@@ -575,14 +681,17 @@ size_t Queue<TaskType>::SchedulingCapacity() const {
   mutex_lock l(mu_);
   const int num_new_batches_schedulable =
       options_.max_enqueued_batches - batches_.size();
+  const int target_batch_size = TargetBatchSize();
+  const int open_batch_size = batches_.back()->size();
   const int open_batch_capacity =
-      options_.max_batch_size - batches_.back()->size();
-  return (num_new_batches_schedulable * options_.max_batch_size) +
+      std::max(0, target_batch_size - open_batch_size);
+  return (num_new_batches_schedulable * target_batch_size) +
          open_batch_capacity;
 }
 
 template <typename TaskType>
-std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatch() {
+std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatch(
+    int64* queueing_micros) {
   // The batch to schedule, which we may populate below. (If left as nullptr,
   // that means we are electing not to schedule a batch at this time.)
   std::unique_ptr<Batch<TaskType>> batch_to_schedule;
@@ -600,6 +709,13 @@ std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatch() {
       ++num_batches_being_processed_;
       batch_to_schedule = std::move(batches_.front());
       batches_.pop_front();
+      if (options_.adaptive_batch_controller != nullptr) {
+        *queueing_micros =
+            env_->NowMicros() - closed_batch_start_times_micros_.front();
+        closed_batch_start_times_micros_.pop_front();
+      } else {
+        *queueing_micros = 0;
+      }
     } else {
       schedulable_batch_ = false;
     }
@@ -609,8 +725,17 @@ std::unique_ptr<Batch<TaskType>> Queue<TaskType>::ScheduleBatch() {
 }
 
 template <typename TaskType>
-void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch) {
-  process_batch_callback_(std::move(batch));
+void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch,
+                                   int64 queueing_micros) {
+  if (options_.adaptive_batch_controller != nullptr) {
+    const int batch_size = batch->size();
+    const uint64 start_time_micros = env_->NowMicros();
+    process_batch_callback_(std::move(batch));
+    options_.adaptive_batch_controller->RecordBatch(
+        batch_size, queueing_micros, env_->NowMicros() - start_time_micros);
+  } else {
+    process_batch_callback_(std::move(batch));
+  }
 
   {
     mutex_lock l(mu_);
@@ -621,6 +746,12 @@ void Queue<TaskType>::ProcessBatch(std::unique_ptr<Batch<TaskType>> batch) {
   }
 }
 
+template <typename TaskType>
+bool Queue<TaskType>::HasSchedulableBatch() const {
+  mutex_lock l(mu_);
+  return batches_.size() >= 2 || IsOpenBatchSchedulable();
+}
+
 template <typename TaskType>
 bool Queue<TaskType>::IsEmpty() const {
   mutex_lock l(mu_);
@@ -652,6 +783,9 @@ bool Queue<TaskType>::IsEmptyInternal() const {
 template <typename TaskType>
 void Queue<TaskType>::StartNewBatch() {
   batches_.back()->Close();
+  if (options_.adaptive_batch_controller != nullptr) {
+    closed_batch_start_times_micros_.push_back(open_batch_start_time_micros_);
+  }
   batches_.emplace_back(new Batch<TaskType>);
 }
 
@@ -661,9 +795,31 @@ bool Queue<TaskType>::IsOpenBatchSchedulable() const {
   if (open_batch->empty()) {
     return false;
   }
-  return closed_ || open_batch->size() >= options_.max_batch_size ||
-         env_->NowMicros() >=
-             open_batch_start_time_micros_ + options_.batch_timeout_micros;
+  const uint64 now_micros = env_->NowMicros();
+  if (open_batch_deadline_micros_ != 0 &&
+      static_cast<int64>(now_micros) + options_.deadline_margin_micros >=
+          static_cast<int64>(open_batch_deadline_micros_)) {
+    return true;
+  }
+  return closed_ || open_batch->size() >= TargetBatchSize() ||
+         now_micros >= open_batch_start_time_micros_ + BatchTimeoutMicros();
+}
+
+template <typename TaskType>
+int Queue<TaskType>::TargetBatchSize() const {
+  if (options_.adaptive_batch_controller == nullptr) {
+    return options_.max_batch_size;
+  }
+  return std::min(options_.max_batch_size,
+                  options_.adaptive_batch_controller->target_batch_size());
+}
+
+template <typename TaskType>
+int64 Queue<TaskType>::BatchTimeoutMicros() const {
+  if (options_.adaptive_batch_controller == nullptr) {
+    return options_.batch_timeout_micros;
+  }
+  return options_.adaptive_batch_controller->batch_timeout_micros();
 }
 
 template <typename TaskType>
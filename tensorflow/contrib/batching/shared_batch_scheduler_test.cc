@@ -28,14 +28,18 @@ namespace {
 
 class FakeTask : public BatchTask {
  public:
-  explicit FakeTask(size_t size) : size_(size) {}
+  explicit FakeTask(size_t size, uint64 deadline_micros = 0)
+      : size_(size), deadline_micros_(deadline_micros) {}
 
   ~FakeTask() override = default;
 
   size_t size() const override { return size_; }
 
+  uint64 deadline_micros() const override { return deadline_micros_; }
+
  private:
   const size_t size_;
+  const uint64 deadline_micros_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(FakeTask);
 };
@@ -131,6 +135,48 @@ TEST(SharedBatchSchedulerTest, Basic) {
   }
 }
 
+TEST(SharedBatchSchedulerTest, ObeyAdaptiveBatchController) {
+  mutex mu;
+  std::vector<size_t> batch_sizes;
+  auto callback = [&mu, &batch_sizes](std::unique_ptr<Batch<FakeTask>> batch) {
+    ASSERT_TRUE(batch->IsClosed());
+    mutex_lock l(mu);
+    batch_sizes.push_back(batch->size());
+  };
+  {
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+
+    // The controller starts out with a target batch size of 2 (smaller than
+    // the queue's 'max_batch_size'), and a timeout long enough that only the
+    // batch size closes batches.
+    AdaptiveBatchController::Options controller_options;
+    controller_options.max_batch_size = 2;
+    controller_options.min_batch_timeout_micros = 10 * 1000 * 1000;
+    controller_options.max_batch_timeout_micros = 10 * 1000 * 1000;
+    std::unique_ptr<AdaptiveBatchController> controller;
+    TF_ASSERT_OK(
+        AdaptiveBatchController::Create(controller_options, &controller));
+
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.max_batch_size = 10;
+    queue_options.max_enqueued_batches = 3;
+    queue_options.adaptive_batch_controller = std::move(controller);
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+    // A task larger than the target batch size, but within 'max_batch_size',
+    // is still accepted.
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+    TF_ASSERT_OK(ScheduleTask(5, queue.get()));
+    TF_ASSERT_OK(ScheduleTask(1, queue.get()));
+  }
+  EXPECT_EQ((std::vector<size_t>{2, 5, 1}), batch_sizes);
+}
+
 TEST(SharedBatchSchedulerTest, ObeyBatchSizeConstraint) {
   // Set up a callback that captures the batches' task sizes.
   mutex mu;
@@ -408,6 +454,140 @@ TEST(SharedBatchSchedulerTest, Fairness) {
   stop_teardown.Notify();
 }
 
+// Runs one batch thread over a blocking queue followed by queues with the
+// given options, each of which has 'num_batches[i]' full batches enqueued
+// while the batch thread is blocked. Returns the indices of the queues in the
+// order in which their batches were processed.
+std::vector<int> ServicingOrder(
+    const std::vector<SharedBatchScheduler<FakeTask>::QueueOptions>&
+        queue_options,
+    const std::vector<int>& num_batches) {
+  mutex mu;
+  std::vector<int> order;
+  {
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_CHECK_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+
+    Notification blocked, proceed;
+    SharedBatchScheduler<FakeTask>::QueueOptions blocking_queue_options;
+    blocking_queue_options.max_batch_size = 1;
+    std::unique_ptr<BatchScheduler<FakeTask>> blocking_queue;
+    TF_CHECK_OK(scheduler->AddQueue(
+        blocking_queue_options,
+        [&blocked, &proceed](std::unique_ptr<Batch<FakeTask>> batch) {
+          blocked.Notify();
+          proceed.WaitForNotification();
+        },
+        &blocking_queue));
+
+    std::vector<std::unique_ptr<BatchScheduler<FakeTask>>> queues(
+        queue_options.size());
+    for (int i = 0; i < queue_options.size(); ++i) {
+      TF_CHECK_OK(scheduler->AddQueue(
+          queue_options[i],
+          [&mu, &order, i](std::unique_ptr<Batch<FakeTask>> batch) {
+            mutex_lock l(mu);
+            order.push_back(i);
+          },
+          &queues[i]));
+    }
+
+    TF_CHECK_OK(ScheduleTask(1, blocking_queue.get()));
+    blocked.WaitForNotification();
+    for (int i = 0; i < queues.size(); ++i) {
+      for (int j = 0; j < num_batches[i]; ++j) {
+        TF_CHECK_OK(ScheduleTask(queue_options[i].max_batch_size,
+                                 queues[i].get()));
+      }
+    }
+    proceed.Notify();
+  }
+  return order;
+}
+
+SharedBatchScheduler<FakeTask>::QueueOptions ServicingQueueOptions(
+    int share, int priority) {
+  SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+  queue_options.max_batch_size = 10;
+  queue_options.batch_timeout_micros = 10 * 1000 * 1000;  // 10 seconds
+  queue_options.max_enqueued_batches = 100;
+  queue_options.share = share;
+  queue_options.priority = priority;
+  return queue_options;
+}
+
+TEST(SharedBatchSchedulerTest, ObeysShares) {
+  // With shares 1 and 2, the servicing pattern is ABBABB...
+  EXPECT_EQ((std::vector<int>{0, 1, 1, 0, 1, 1, 0}),
+            ServicingOrder({ServicingQueueOptions(1, 0),
+                            ServicingQueueOptions(2, 0)},
+                           {3, 4}));
+}
+
+TEST(SharedBatchSchedulerTest, ObeysPriorities) {
+  // Queue 1 has the highest priority, and queues 0 and 2 share the lower one.
+  // The round-robin position moves past queue 0 while it is passed over.
+  EXPECT_EQ((std::vector<int>{1, 1, 2, 0, 2, 0}),
+            ServicingOrder({ServicingQueueOptions(1, 0),
+                            ServicingQueueOptions(1, 1),
+                            ServicingQueueOptions(1, 0)},
+                           {2, 2, 2}));
+}
+
+TEST(SharedBatchSchedulerTest, ObeysDeadlines) {
+  test_util::FakeClockEnv env(Env::Default());
+  Notification start_teardown, stop_teardown;
+  std::unique_ptr<Thread> teardown_thread =
+      CreateFakeClockAdvancerThread(&env, &start_teardown, &stop_teardown);
+
+  {
+    Notification batch_processed;
+    auto callback =
+        [&batch_processed](std::unique_ptr<Batch<FakeTask>> batch) {
+          ASSERT_TRUE(batch->IsClosed());
+          EXPECT_EQ(2, batch->num_tasks());
+          batch_processed.Notify();
+        };
+
+    SharedBatchScheduler<FakeTask>::Options options;
+    options.num_batch_threads = 1;
+    options.env = &env;
+    std::shared_ptr<SharedBatchScheduler<FakeTask>> scheduler;
+    TF_ASSERT_OK(SharedBatchScheduler<FakeTask>::Create(options, &scheduler));
+    SharedBatchScheduler<FakeTask>::QueueOptions queue_options;
+    queue_options.max_batch_size = 10;
+    queue_options.batch_timeout_micros = 10 * 1000 * 1000;  // 10 seconds
+    queue_options.deadline_margin_micros = 100;
+    std::unique_ptr<BatchScheduler<FakeTask>> queue;
+    TF_ASSERT_OK(scheduler->AddQueue(queue_options, callback, &queue));
+
+    env.AdvanceByMicroseconds(1000);
+
+    // A task whose deadline is within the margin is rejected.
+    std::unique_ptr<FakeTask> task(new FakeTask(1, 1050));
+    Status status = queue->Schedule(&task);
+    EXPECT_EQ(error::DEADLINE_EXCEEDED, status.code());
+    EXPECT_TRUE(task != nullptr);
+
+    // The batch is processed ahead of its timeout, once the earliest deadline
+    // of its tasks is within the margin.
+    task.reset(new FakeTask(1, 3000));
+    TF_ASSERT_OK(queue->Schedule(&task));
+    task.reset(new FakeTask(1, 2000));
+    TF_ASSERT_OK(queue->Schedule(&task));
+    env.AdvanceByMicroseconds(800);
+    Env::Default()->SleepForMicroseconds(10 * 1000 /* 10 milliseconds */);
+    EXPECT_FALSE(batch_processed.HasBeenNotified());
+    env.AdvanceByMicroseconds(100);
+    batch_processed.WaitForNotification();
+
+    start_teardown.Notify();
+  }
+  stop_teardown.Notify();
+}
+
 TEST(SharedBatchSchedulerTest, ConstMethods) {
   for (const int max_enqueued_batches : {1, 2, 5}) {
     Notification processing, proceed;
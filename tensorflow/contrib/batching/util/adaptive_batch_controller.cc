@@ -0,0 +1,157 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/batching/util/adaptive_batch_controller.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace serving {
+
+namespace {
+
+auto* adaptive_target_batch_size = monitoring::Sampler<1>::New(
+    {"/tensorflow/contrib/batching/adaptive_target_batch_size",
+     "The target batch sizes chosen by adaptive batch controllers.",
+     "controller"},
+    {1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096});
+
+auto* adaptive_batch_timeout_micros = monitoring::Sampler<1>::New(
+    {"/tensorflow/contrib/batching/adaptive_batch_timeout_micros",
+     "The batch timeouts chosen by adaptive batch controllers, in "
+     "microseconds.",
+     "controller"},
+    {10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000,
+     200000, 500000, 1000000});
+
+// Returns the 99th percentile of 'values', reordering them.
+int64 P99(std::vector<int64>* values) {
+  const size_t index = (values->size() * 99) / 100;
+  std::nth_element(values->begin(), values->begin() + index, values->end());
+  return (*values)[index];
+}
+
+}  // namespace
+
+Status AdaptiveBatchController::Create(
+    const Options& options,
+    std::unique_ptr<AdaptiveBatchController>* controller) {
+  if (options.latency_slo_micros <= 0) {
+    return errors::InvalidArgument("latency_slo_micros must be positive; was ",
+                                   options.latency_slo_micros);
+  }
+  if (options.min_batch_size <= 0 ||
+      options.min_batch_size > options.max_batch_size) {
+    return errors::InvalidArgument(
+        "min_batch_size must be positive and at most max_batch_size; was ",
+        options.min_batch_size, " (max_batch_size ", options.max_batch_size,
+        ")");
+  }
+  if (options.min_batch_timeout_micros < 0 ||
+      options.min_batch_timeout_micros > options.max_batch_timeout_micros) {
+    return errors::InvalidArgument(
+        "min_batch_timeout_micros must be non-negative and at most "
+        "max_batch_timeout_micros; was ",
+        options.min_batch_timeout_micros, " (max_batch_timeout_micros ",
+        options.max_batch_timeout_micros, ")");
+  }
+  if (options.adjustment_interval_batches <= 0) {
+    return errors::InvalidArgument(
+        "adjustment_interval_batches must be positive; was ",
+        options.adjustment_interval_batches);
+  }
+  controller->reset(new AdaptiveBatchController(options));
+  return Status::OK();
+}
+
+AdaptiveBatchController::AdaptiveBatchController(const Options& options)
+    : options_(options),
+      target_batch_size_(options.max_batch_size),
+      batch_timeout_micros_(options.min_batch_timeout_micros),
+      interval_start_micros_(options.env->NowMicros()) {
+  latencies_micros_.reserve(options.adjustment_interval_batches);
+  processing_micros_.reserve(options.adjustment_interval_batches);
+}
+
+void AdaptiveBatchController::RecordBatch(int batch_size,
+                                          int64 queueing_micros,
+                                          int64 processing_micros) {
+  mutex_lock l(mu_);
+  latencies_micros_.push_back(queueing_micros + processing_micros);
+  processing_micros_.push_back(processing_micros);
+  num_tasks_ += batch_size;
+  if (latencies_micros_.size() >= options_.adjustment_interval_batches) {
+    Adjust();
+  }
+}
+
+void AdaptiveBatchController::Adjust() {
+  const uint64 now_micros = options_.env->NowMicros();
+  const int64 elapsed_micros = now_micros - interval_start_micros_;
+  const int64 p99_latency_micros = P99(&latencies_micros_);
+  const int64 p99_processing_micros = P99(&processing_micros_);
+
+  // Additive increase, multiplicative decrease of the target batch size. The
+  // band between 3/4 of the SLO and the SLO is left alone to avoid
+  // oscillating around the SLO.
+  int target_batch_size = target_batch_size_.load();
+  if (p99_latency_micros > options_.latency_slo_micros) {
+    target_batch_size -= std::max(1, target_batch_size / 4);
+  } else if (p99_latency_micros * 4 < options_.latency_slo_micros * 3) {
+    target_batch_size += std::max(1, target_batch_size / 8);
+  }
+  target_batch_size = std::min(
+      options_.max_batch_size, std::max(options_.min_batch_size,
+                                        target_batch_size));
+
+  // Wait about as long as it takes for a full target batch to arrive, within
+  // the latency budget left over by processing. The task rate observed by the
+  // batch threads equals the arrival rate, as long as the queue keeps up.
+  int64 batch_timeout_micros = options_.max_batch_timeout_micros;
+  if (num_tasks_ > 0 && elapsed_micros > 0) {
+    batch_timeout_micros = (target_batch_size * elapsed_micros) / num_tasks_;
+  }
+  batch_timeout_micros =
+      std::min(batch_timeout_micros,
+               options_.latency_slo_micros - p99_processing_micros);
+  batch_timeout_micros =
+      std::min(options_.max_batch_timeout_micros,
+               std::max(options_.min_batch_timeout_micros,
+                        batch_timeout_micros));
+
+  VLOG(2) << "AdaptiveBatchController " << options_.name
+          << ": p99 latency " << p99_latency_micros << "us, p99 processing "
+          << p99_processing_micros << "us, " << num_tasks_ << " tasks in "
+          << elapsed_micros << "us; target batch size " << target_batch_size
+          << ", batch timeout " << batch_timeout_micros << "us";
+
+  target_batch_size_.store(target_batch_size);
+  batch_timeout_micros_.store(batch_timeout_micros);
+  adaptive_target_batch_size->GetCell(options_.name)->Add(target_batch_size);
+  adaptive_batch_timeout_micros->GetCell(options_.name)
+      ->Add(batch_timeout_micros);
+
+  latencies_micros_.clear();
+  processing_micros_.clear();
+  num_tasks_ = 0;
+  interval_start_micros_ = now_micros;
+}
+
+}  // namespace serving
+}  // namespace tensorflow
@@ -0,0 +1,127 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// AdaptiveBatchController chooses the target batch size and the batch timeout
+// of a batching queue from the load it observes, in place of hand-tuned static
+// values. Its goal is to form batches as large as possible (for throughput)
+// while keeping the 99th percentile task latency, i.e. the time from a task's
+// batch being started to the batch being processed, under a configured SLO.
+//
+// The batch threads report each processed batch via RecordBatch(). Every
+// 'adjustment_interval_batches' batches the controller revises its decisions:
+//  - The target batch size follows an additive-increase/multiplicative-
+//    decrease rule: it shrinks by a quarter if the observed p99 latency
+//    exceeds the SLO, and grows by an eighth if the latency is well under it.
+//  - The batch timeout is set to the time needed to accumulate a full target
+//    batch at the observed task rate, but no more than the latency budget left
+//    over by the observed p99 processing time.
+//
+// The decisions are exported to the '/tensorflow/contrib/batching/adaptive_*'
+// metrics, labeled with the controller's name.
+//
+// This object is thread-safe.
+
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_BATCHING_UTIL_ADAPTIVE_BATCH_CONTROLLER_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_BATCHING_UTIL_ADAPTIVE_BATCH_CONTROLLER_H_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace serving {
+
+class AdaptiveBatchController {
+ public:
+  struct Options {
+    // The name of the controller, used to label its metrics.
+    string name = "default";
+
+    // The target for the 99th percentile task latency, in microseconds.
+    int64 latency_slo_micros = 100 * 1000;
+
+    // The range of target batch sizes the controller may choose from. The
+    // initial target batch size is 'max_batch_size'.
+    int min_batch_size = 1;
+    int max_batch_size = 1000;
+
+    // The range of batch timeouts the controller may choose from. The initial
+    // batch timeout is 'min_batch_timeout_micros'.
+    int64 min_batch_timeout_micros = 0;
+    int64 max_batch_timeout_micros = 10 * 1000;
+
+    // The number of processed batches between two adjustments.
+    int adjustment_interval_batches = 100;
+
+    // The environment to use. Does not take ownership, but must remain alive
+    // for as long as the controller exists.
+    Env* env = Env::Default();
+  };
+  static Status Create(const Options& options,
+                       std::unique_ptr<AdaptiveBatchController>* controller);
+
+  ~AdaptiveBatchController() = default;
+
+  // The current target batch size, in [min_batch_size, max_batch_size].
+  int target_batch_size() const { return target_batch_size_.load(); }
+
+  // The current batch timeout, in [min_batch_timeout_micros,
+  // max_batch_timeout_micros].
+  int64 batch_timeout_micros() const { return batch_timeout_micros_.load(); }
+
+  // Records a processed batch of 'batch_size' task units, whose oldest task
+  // waited 'queueing_micros' for the batch to be scheduled, and whose
+  // processing took 'processing_micros'. Called from the batch threads.
+  void RecordBatch(int batch_size, int64 queueing_micros,
+                   int64 processing_micros);
+
+ private:
+  explicit AdaptiveBatchController(const Options& options);
+
+  // Revises the target batch size and the batch timeout from the batches
+  // recorded since the previous adjustment.
+  void Adjust() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const Options options_;
+
+  std::atomic<int> target_batch_size_;
+  std::atomic<int64> batch_timeout_micros_;
+
+  mutex mu_;
+
+  // The latencies (queueing plus processing) and processing times of the
+  // batches recorded since the previous adjustment.
+  std::vector<int64> latencies_micros_ GUARDED_BY(mu_);
+  std::vector<int64> processing_micros_ GUARDED_BY(mu_);
+
+  // The number of task units recorded since the previous adjustment, and the
+  // time of that adjustment.
+  int64 num_tasks_ GUARDED_BY(mu_) = 0;
+  uint64 interval_start_micros_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AdaptiveBatchController);
+};
+
+}  // namespace serving
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_BATCHING_UTIL_ADAPTIVE_BATCH_CONTROLLER_H_
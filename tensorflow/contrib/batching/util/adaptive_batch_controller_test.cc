@@ -0,0 +1,120 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/batching/util/adaptive_batch_controller.h"
+
+#include "tensorflow/contrib/batching/test_util/fake_clock_env.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace serving {
+namespace {
+
+AdaptiveBatchController::Options TestOptions(Env* env) {
+  AdaptiveBatchController::Options options;
+  options.latency_slo_micros = 10 * 1000;
+  options.min_batch_size = 1;
+  options.max_batch_size = 64;
+  options.min_batch_timeout_micros = 0;
+  options.max_batch_timeout_micros = 5 * 1000;
+  options.adjustment_interval_batches = 10;
+  options.env = env;
+  return options;
+}
+
+// Records one adjustment interval worth of identical batches, spread evenly
+// over 'interval_micros'.
+void RecordInterval(test_util::FakeClockEnv* env,
+                    AdaptiveBatchController* controller, int batch_size,
+                    int64 queueing_micros, int64 processing_micros,
+                    int interval_micros) {
+  for (int i = 0; i < 10; ++i) {
+    env->AdvanceByMicroseconds(interval_micros / 10);
+    controller->RecordBatch(batch_size, queueing_micros, processing_micros);
+  }
+}
+
+TEST(AdaptiveBatchControllerTest, InvalidOptions) {
+  std::unique_ptr<AdaptiveBatchController> controller;
+  AdaptiveBatchController::Options options = TestOptions(Env::Default());
+  options.min_batch_size = 128;
+  EXPECT_FALSE(AdaptiveBatchController::Create(options, &controller).ok());
+
+  options = TestOptions(Env::Default());
+  options.min_batch_timeout_micros = -1;
+  EXPECT_FALSE(AdaptiveBatchController::Create(options, &controller).ok());
+
+  options = TestOptions(Env::Default());
+  options.adjustment_interval_batches = 0;
+  EXPECT_FALSE(AdaptiveBatchController::Create(options, &controller).ok());
+}
+
+TEST(AdaptiveBatchControllerTest, InitialDecisions) {
+  std::unique_ptr<AdaptiveBatchController> controller;
+  const AdaptiveBatchController::Options options = TestOptions(Env::Default());
+  TF_ASSERT_OK(AdaptiveBatchController::Create(options, &controller));
+  EXPECT_EQ(64, controller->target_batch_size());
+  EXPECT_EQ(0, controller->batch_timeout_micros());
+}
+
+TEST(AdaptiveBatchControllerTest, AdjustsToLatency) {
+  test_util::FakeClockEnv env(Env::Default());
+  std::unique_ptr<AdaptiveBatchController> controller;
+  TF_ASSERT_OK(AdaptiveBatchController::Create(TestOptions(&env), &controller));
+
+  // Above the SLO: the target batch size shrinks by a quarter.
+  RecordInterval(&env, controller.get(), 64, 8000, 4000, 10 * 1000);
+  EXPECT_EQ(48, controller->target_batch_size());
+  RecordInterval(&env, controller.get(), 48, 8000, 4000, 10 * 1000);
+  EXPECT_EQ(36, controller->target_batch_size());
+
+  // Close to the SLO: the target batch size is left alone.
+  RecordInterval(&env, controller.get(), 36, 5000, 4000, 10 * 1000);
+  EXPECT_EQ(36, controller->target_batch_size());
+
+  // Well under the SLO: the target batch size grows by an eighth.
+  RecordInterval(&env, controller.get(), 36, 1000, 1000, 10 * 1000);
+  EXPECT_EQ(40, controller->target_batch_size());
+
+  // Batches recorded between adjustments don't change the decisions.
+  controller->RecordBatch(40, 100 * 1000, 100 * 1000);
+  EXPECT_EQ(40, controller->target_batch_size());
+}
+
+TEST(AdaptiveBatchControllerTest, TimeoutFollowsTaskRate) {
+  test_util::FakeClockEnv env(Env::Default());
+  std::unique_ptr<AdaptiveBatchController> controller;
+  TF_ASSERT_OK(AdaptiveBatchController::Create(TestOptions(&env), &controller));
+
+  // 10 batches of 8 tasks in 2ms, i.e. 40 tasks per ms, under the SLO. The
+  // target batch size grows to 64 + 8, capped at 64, which takes 1.6ms to
+  // arrive.
+  RecordInterval(&env, controller.get(), 8, 100, 100, 2 * 1000);
+  EXPECT_EQ(64, controller->target_batch_size());
+  EXPECT_EQ(1600, controller->batch_timeout_micros());
+
+  // At a tenth of the rate, the timeout is bounded by the maximum.
+  RecordInterval(&env, controller.get(), 8, 100, 100, 20 * 1000);
+  EXPECT_EQ(5 * 1000, controller->batch_timeout_micros());
+
+  // Processing that takes most of the SLO leaves little budget for waiting.
+  RecordInterval(&env, controller.get(), 8, 100, 7000, 20 * 1000);
+  EXPECT_EQ(3000, controller->batch_timeout_micros());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace tensorflow
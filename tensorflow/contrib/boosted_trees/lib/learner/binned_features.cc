@@ -0,0 +1,104 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#include "tensorflow/contrib/boosted_trees/lib/learner/binned_features.h"
+
+#include <algorithm>
+
+#include "tensorflow/contrib/boosted_trees/lib/utils/macros.h"
+#include "tensorflow/contrib/boosted_trees/lib/utils/parallel_for.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace learner {
+
+namespace {
+
+template <typename Bin>
+void Bucketize(TTypes<float>::ConstMatrix values,
+               const std::vector<float>& boundaries, std::vector<Bin>* bins) {
+  bins->resize(values.dimension(0));
+  for (int64 example = 0; example < values.dimension(0); ++example) {
+    (*bins)[example] = static_cast<Bin>(
+        std::lower_bound(boundaries.begin(), boundaries.end(),
+                         values(example, 0)) -
+        boundaries.begin());
+  }
+}
+
+}  // namespace
+
+constexpr int BinnedFeatures::kMaxBins;
+
+Status BinnedFeatures::Initialize(
+    const std::vector<Tensor>& dense_float_feature_columns,
+    const std::vector<std::vector<float>>& boundaries,
+    thread::ThreadPool* thread_pool) {
+  const int num_features = dense_float_feature_columns.size();
+  TF_CHECK_AND_RETURN_IF_ERROR(
+      num_features > 0,
+      errors::InvalidArgument("Must have at least one feature column."));
+  TF_CHECK_AND_RETURN_IF_ERROR(
+      static_cast<int>(boundaries.size()) == num_features,
+      errors::InvalidArgument("Need boundaries for each of the ",
+                              num_features, " feature columns, got ",
+                              boundaries.size()));
+  batch_size_ = dense_float_feature_columns[0].dim_size(0);
+  for (int feature = 0; feature < num_features; ++feature) {
+    const Tensor& column = dense_float_feature_columns[feature];
+    TF_CHECK_AND_RETURN_IF_ERROR(
+        TensorShapeUtils::IsMatrix(column.shape()) && column.dim_size(1) == 1,
+        errors::InvalidArgument(
+            "Dense float feature must be a [batch_size, 1] matrix: ",
+            column.shape().DebugString()));
+    TF_CHECK_AND_RETURN_IF_ERROR(
+        column.dim_size(0) == batch_size_,
+        errors::InvalidArgument(
+            "Dense float feature must have batch_size rows: ", batch_size_,
+            " vs. ", column.dim_size(0)));
+    TF_CHECK_AND_RETURN_IF_ERROR(
+        boundaries[feature].size() < kMaxBins,
+        errors::InvalidArgument("Too many boundaries for feature ", feature,
+                                ": ", boundaries[feature].size()));
+    TF_CHECK_AND_RETURN_IF_ERROR(
+        std::is_sorted(boundaries[feature].begin(), boundaries[feature].end()),
+        errors::InvalidArgument("Boundaries of feature ", feature,
+                                " must be sorted."));
+  }
+
+  boundaries_ = boundaries;
+  bins8_.assign(num_features, std::vector<uint8>());
+  bins16_.assign(num_features, std::vector<uint16>());
+  auto do_work = [this, &dense_float_feature_columns](int64 start,
+                                                       int64 end) {
+    for (int64 feature = start; feature < end; ++feature) {
+      const auto values = dense_float_feature_columns[feature].matrix<float>();
+      if (num_bins(feature) <= 256) {
+        Bucketize(values, boundaries_[feature], &bins8_[feature]);
+      } else {
+        Bucketize(values, boundaries_[feature], &bins16_[feature]);
+      }
+    }
+  };
+  utils::ParallelFor(num_features,
+                     thread_pool == nullptr ? 0 : thread_pool->NumThreads(),
+                     thread_pool, do_work);
+  return Status::OK();
+}
+
+}  // namespace learner
+}  // namespace boosted_trees
+}  // namespace tensorflow
@@ -0,0 +1,90 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_LEARNER_BINNED_FEATURES_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_LEARNER_BINNED_FEATURES_H_
+
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace learner {
+
+// Dense float feature columns bucketized once into compact bins, to gather
+// split statistics from histograms over the bins rather than from the
+// feature values of every example.
+//
+// Bin i of a column holds the values in (boundaries[i - 1], boundaries[i]],
+// and the last bin the values above all the boundaries, so that
+// value <= boundaries[i] exactly when bin <= i, the rule of a
+// DenseFloatBinarySplit with threshold boundaries[i]. The bins take one byte
+// per example for up to 256 bins and two bytes for up to 65536 bins.
+class BinnedFeatures {
+ public:
+  // The most bins a column can have.
+  static constexpr int kMaxBins = 65536;
+
+  BinnedFeatures() {}
+
+  // Disallow copy and assign.
+  BinnedFeatures(const BinnedFeatures& other) = delete;
+  BinnedFeatures& operator=(const BinnedFeatures& other) = delete;
+
+  // Bucketizes the dense float feature columns, each shaped [batch_size, 1],
+  // by the sorted bucket boundaries of each column, e.g. as generated by
+  // WeightedQuantilesStream::GenerateBoundaries. The columns are bucketized
+  // in parallel on "thread_pool" if it is not null.
+  Status Initialize(const std::vector<Tensor>& dense_float_feature_columns,
+                    const std::vector<std::vector<float>>& boundaries,
+                    thread::ThreadPool* thread_pool);
+
+  int64 batch_size() const { return batch_size_; }
+  int num_features() const { return boundaries_.size(); }
+
+  // The bucket boundaries of a column, which has one bin more than that.
+  const std::vector<float>& boundaries(int feature) const {
+    return boundaries_[feature];
+  }
+  int num_bins(int feature) const { return boundaries_[feature].size() + 1; }
+
+  // The bins of the examples of a column, of which exactly one is non-empty
+  // depending on the number of bins.
+  const std::vector<uint8>& bins8(int feature) const { return bins8_[feature]; }
+  const std::vector<uint16>& bins16(int feature) const {
+    return bins16_[feature];
+  }
+
+  // Returns the bin of an example in a column.
+  int32 bin(int feature, int64 example) const {
+    return bins8_[feature].empty() ? bins16_[feature][example]
+                                   : bins8_[feature][example];
+  }
+
+ private:
+  int64 batch_size_ = 0;
+  std::vector<std::vector<float>> boundaries_;
+  std::vector<std::vector<uint8>> bins8_;
+  std::vector<std::vector<uint16>> bins16_;
+};
+
+}  // namespace learner
+}  // namespace boosted_trees
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_LEARNER_BINNED_FEATURES_H_
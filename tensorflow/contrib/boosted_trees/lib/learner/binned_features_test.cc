@@ -0,0 +1,82 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#include "tensorflow/contrib/boosted_trees/lib/learner/binned_features.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace learner {
+namespace {
+
+class BinnedFeaturesTest : public ::testing::Test {};
+
+TEST_F(BinnedFeaturesTest, Bucketize) {
+  auto dense_float_tensor1 = test::AsTensor<float>(
+      {7.0f, -2.0f, 8.0f, 1.0f, 0.0f, -4.0f, 7.5f, -2.0f}, {8, 1});
+  auto dense_float_tensor2 = test::AsTensor<float>(
+      {0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f}, {8, 1});
+  std::vector<float> boundaries2(300);
+  for (int i = 0; i < 300; ++i) {
+    boundaries2[i] = i * 0.5f;
+  }
+  thread::ThreadPool thread_pool(Env::Default(), "test", 2);
+  BinnedFeatures features;
+  TF_EXPECT_OK(features.Initialize({dense_float_tensor1, dense_float_tensor2},
+                                   {{-2.0f, 0.0f, 7.0f}, boundaries2},
+                                   &thread_pool));
+  EXPECT_EQ(8, features.batch_size());
+  EXPECT_EQ(2, features.num_features());
+  EXPECT_EQ(4, features.num_bins(0));
+  EXPECT_EQ(301, features.num_bins(1));
+
+  // Values equal to a boundary fall into its bin.
+  EXPECT_EQ(8, features.bins8(0).size());
+  EXPECT_TRUE(features.bins16(0).empty());
+  const std::vector<int32> expected_bins = {2, 0, 3, 2, 1, 0, 3, 0};
+  for (int example = 0; example < 8; ++example) {
+    EXPECT_EQ(expected_bins[example], features.bin(0, example));
+  }
+
+  // Columns with more than 256 bins take two bytes per example.
+  EXPECT_TRUE(features.bins8(1).empty());
+  EXPECT_EQ(8, features.bins16(1).size());
+  for (int example = 0; example < 8; ++example) {
+    EXPECT_EQ(2 * example, features.bin(1, example));
+  }
+}
+
+TEST_F(BinnedFeaturesTest, InvalidBoundaries) {
+  auto dense_float_tensor = test::AsTensor<float>({1.0f, 2.0f}, {2, 1});
+  BinnedFeatures features;
+  EXPECT_FALSE(features.Initialize({dense_float_tensor}, {}, nullptr).ok());
+  EXPECT_FALSE(
+      features.Initialize({dense_float_tensor}, {{2.0f, 1.0f}}, nullptr).ok());
+  EXPECT_FALSE(features
+                   .Initialize({dense_float_tensor},
+                               {std::vector<float>(BinnedFeatures::kMaxBins)},
+                               nullptr)
+                   .ok());
+  auto multivalent_tensor = test::AsTensor<float>({1.0f, 2.0f}, {1, 2});
+  EXPECT_FALSE(
+      features.Initialize({multivalent_tensor}, {{1.0f}}, nullptr).ok());
+}
+
+}  // namespace
+}  // namespace learner
+}  // namespace boosted_trees
+}  // namespace tensorflow
@@ -0,0 +1,212 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#include "tensorflow/contrib/boosted_trees/lib/learner/gradient_histogram.h"
+
+#include <algorithm>
+
+#include "tensorflow/contrib/boosted_trees/lib/utils/parallel_for.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace learner {
+
+namespace {
+
+// The fewest examples worth accumulating into a histogram of their own.
+constexpr int64 kMinExamplesPerBlock = 4096;
+
+template <typename Bin>
+void AccumulateBins(const std::vector<Bin>& bins,
+                    gtl::ArraySlice<float> gradients,
+                    gtl::ArraySlice<float> hessians,
+                    gtl::ArraySlice<int64> examples, int64 start, int64 end,
+                    GradientStats* stats) {
+  for (int64 i = start; i < end; ++i) {
+    const int64 example = examples[i];
+    GradientStats& bin_stats = stats[bins[example]];
+    bin_stats.gradient += gradients[example];
+    bin_stats.hessian += hessians[example];
+    ++bin_stats.count;
+  }
+}
+
+}  // namespace
+
+float ComputeLeafWeight(const GradientStats& stats,
+                        const TreeRegularizationConfig& regularization,
+                        double* gain) {
+  // L1 shrinks the gradient towards zero.
+  double gradient = stats.gradient;
+  if (gradient > regularization.l1()) {
+    gradient -= regularization.l1();
+  } else if (gradient < -regularization.l1()) {
+    gradient += regularization.l1();
+  } else {
+    gradient = 0;
+  }
+  const double hessian = stats.hessian + regularization.l2();
+  if (hessian <= 0) {
+    *gain = 0;
+    return 0;
+  }
+  *gain = gradient * gradient / hessian;
+  return -gradient / hessian;
+}
+
+GradientHistogram::GradientHistogram(const BinnedFeatures& features) {
+  offsets_.reserve(features.num_features());
+  int64 num_bins = 0;
+  for (int feature = 0; feature < features.num_features(); ++feature) {
+    offsets_.push_back(num_bins);
+    num_bins += features.num_bins(feature);
+  }
+  stats_.resize(num_bins);
+}
+
+void GradientHistogram::Accumulate(const BinnedFeatures& features,
+                                   gtl::ArraySlice<float> gradients,
+                                   gtl::ArraySlice<float> hessians,
+                                   gtl::ArraySlice<int64> examples,
+                                   thread::ThreadPool* thread_pool) {
+  const int num_features = features.num_features();
+  const int64 num_examples = examples.size();
+  if (num_examples == 0) return;
+  const int num_threads =
+      thread_pool == nullptr ? 0 : thread_pool->NumThreads();
+
+  // With fewer columns than threads, the examples are split into blocks as
+  // well. The first block is accumulated in place and each other block into
+  // a histogram of its own, merged at the end.
+  int64 num_blocks = 1;
+  if (num_threads > num_features) {
+    num_blocks = std::max<int64>(
+        1, std::min<int64>((num_threads + num_features - 1) / num_features,
+                           num_examples / kMinExamplesPerBlock));
+  }
+  const int64 block_size = (num_examples + num_blocks - 1) / num_blocks;
+  std::vector<std::vector<GradientStats>> block_stats(
+      num_blocks - 1, std::vector<GradientStats>(stats_.size()));
+
+  auto do_work = [&](int64 start_task, int64 end_task) {
+    for (int64 task = start_task; task < end_task; ++task) {
+      const int feature = task / num_blocks;
+      const int64 block = task % num_blocks;
+      GradientStats* stats =
+          (block == 0 ? stats_.data() : block_stats[block - 1].data()) +
+          offsets_[feature];
+      const int64 start = block * block_size;
+      const int64 end = std::min(start + block_size, num_examples);
+      if (features.bins8(feature).empty()) {
+        AccumulateBins(features.bins16(feature), gradients, hessians,
+                       examples, start, end, stats);
+      } else {
+        AccumulateBins(features.bins8(feature), gradients, hessians, examples,
+                       start, end, stats);
+      }
+    }
+  };
+  utils::ParallelFor(num_features * num_blocks, num_threads, thread_pool,
+                     do_work);
+
+  for (const auto& stats : block_stats) {
+    for (size_t i = 0; i < stats_.size(); ++i) {
+      stats_[i] += stats[i];
+    }
+  }
+}
+
+void GradientHistogram::Subtract(const GradientHistogram& other) {
+  QCHECK_EQ(stats_.size(), other.stats_.size());
+  for (size_t i = 0; i < stats_.size(); ++i) {
+    stats_[i] -= other.stats_[i];
+  }
+}
+
+GradientStats GradientHistogram::Total() const {
+  GradientStats total;
+  const int64 end = offsets_.size() > 1 ? offsets_[1] : stats_.size();
+  for (int64 bin = 0; bin < end; ++bin) {
+    total += stats_[bin];
+  }
+  return total;
+}
+
+bool GradientHistogram::FindBestSplit(const BinnedFeatures& features,
+                                      const LearnerConfig& config,
+                                      SplitCandidate* best) const {
+  const GradientStats total = Total();
+  const TreeRegularizationConfig& regularization = config.regularization();
+  const float min_node_weight = config.constraints().min_node_weight();
+  double parent_gain;
+  ComputeLeafWeight(total, regularization, &parent_gain);
+
+  bool found = false;
+  double best_gain = 0;
+  for (int feature = 0; feature < features.num_features(); ++feature) {
+    GradientStats left;
+    // The last bin can't go left, or nothing would go right.
+    for (int bin = 0; bin + 1 < features.num_bins(feature); ++bin) {
+      left += stats(feature, bin);
+      if (left.count == 0) continue;
+      GradientStats right = total;
+      right -= left;
+      if (right.count == 0) break;
+      if (left.hessian < min_node_weight || right.hessian < min_node_weight) {
+        continue;
+      }
+      double left_gain, right_gain;
+      ComputeLeafWeight(left, regularization, &left_gain);
+      ComputeLeafWeight(right, regularization, &right_gain);
+      const double gain = left_gain + right_gain - parent_gain -
+                          regularization.tree_complexity();
+      if (gain > best_gain) {
+        found = true;
+        best_gain = gain;
+        best->split.set_feature_column(feature);
+        best->split.set_threshold(features.boundaries(feature)[bin]);
+        best->left_stats = left;
+        best->right_stats = right;
+      }
+    }
+  }
+  best->gain = best_gain;
+  return found;
+}
+
+void PartitionExamples(const BinnedFeatures& features,
+                       const trees::DenseFloatBinarySplit& split,
+                       gtl::ArraySlice<int64> examples,
+                       std::vector<int64>* left_examples,
+                       std::vector<int64>* right_examples) {
+  const std::vector<float>& boundaries =
+      features.boundaries(split.feature_column());
+  const int32 threshold_bin =
+      std::lower_bound(boundaries.begin(), boundaries.end(),
+                       split.threshold()) -
+      boundaries.begin();
+  left_examples->clear();
+  right_examples->clear();
+  for (const int64 example : examples) {
+    if (features.bin(split.feature_column(), example) <= threshold_bin) {
+      left_examples->push_back(example);
+    } else {
+      right_examples->push_back(example);
+    }
+  }
+}
+
+}  // namespace learner
+}  // namespace boosted_trees
+}  // namespace tensorflow
@@ -0,0 +1,125 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_LEARNER_GRADIENT_HISTOGRAM_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_LEARNER_GRADIENT_HISTOGRAM_H_
+
+#include <vector>
+
+#include "tensorflow/contrib/boosted_trees/lib/learner/binned_features.h"
+#include "tensorflow/contrib/boosted_trees/proto/learner.pb.h"  // NOLINT
+#include "tensorflow/contrib/boosted_trees/proto/tree_config.pb.h"  // NOLINT
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace learner {
+
+// The sums of the gradients and hessians of a set of examples.
+struct GradientStats {
+  double gradient = 0;
+  double hessian = 0;
+  int64 count = 0;
+
+  GradientStats& operator+=(const GradientStats& other) {
+    gradient += other.gradient;
+    hessian += other.hessian;
+    count += other.count;
+    return *this;
+  }
+  GradientStats& operator-=(const GradientStats& other) {
+    gradient -= other.gradient;
+    hessian -= other.hessian;
+    count -= other.count;
+    return *this;
+  }
+};
+
+// Returns the weight of a leaf holding examples with the given stats, and
+// sets "gain" to its contribution to the loss reduction, under the L1 and L2
+// regularization of "regularization".
+float ComputeLeafWeight(const GradientStats& stats,
+                        const TreeRegularizationConfig& regularization,
+                        double* gain);
+
+// The best split of a node found from its gradient histogram.
+struct SplitCandidate {
+  // The split, without the ids of its children.
+  trees::DenseFloatBinarySplit split;
+  // The loss reduction of the split, net of the tree complexity penalty.
+  float gain = 0;
+  GradientStats left_stats;
+  GradientStats right_stats;
+};
+
+// The per-bin sums of the gradients and hessians of the examples of a tree
+// node, for each feature column of a BinnedFeatures.
+//
+// The histogram of a node is read in a single pass over its examples, and
+// the histogram of its sibling then follows by subtraction from the histogram
+// of the parent, so that only the smaller child of a split needs a pass.
+class GradientHistogram {
+ public:
+  // Creates an empty histogram over the bins of "features".
+  explicit GradientHistogram(const BinnedFeatures& features);
+
+  // Adds the gradients and hessians, indexed by example, of the given
+  // examples to the histogram. The columns, and for few columns also the
+  // examples, are processed in parallel on "thread_pool" if it is not null.
+  void Accumulate(const BinnedFeatures& features,
+                  gtl::ArraySlice<float> gradients,
+                  gtl::ArraySlice<float> hessians,
+                  gtl::ArraySlice<int64> examples,
+                  thread::ThreadPool* thread_pool);
+
+  // Subtracts the histogram of a subset of the examples, e.g. turning the
+  // histogram of a parent node into the one of the sibling of a child.
+  void Subtract(const GradientHistogram& other);
+
+  const GradientStats& stats(int feature, int bin) const {
+    return stats_[offsets_[feature] + bin];
+  }
+
+  // The stats of all the examples of the histogram.
+  GradientStats Total() const;
+
+  // Finds the split of the examples over one of the feature columns with the
+  // highest gain, subject to the regularization and constraints of
+  // "config". Returns false if no split has positive gain.
+  bool FindBestSplit(const BinnedFeatures& features,
+                     const LearnerConfig& config,
+                     SplitCandidate* best) const;
+
+ private:
+  // The offset of the bins of each feature column in stats_.
+  std::vector<int64> offsets_;
+  std::vector<GradientStats> stats_;
+};
+
+// Partitions the examples of a node by a split of "features" of which the
+// threshold is one of the bucket boundaries, as for the splits found by
+// GradientHistogram::FindBestSplit.
+void PartitionExamples(const BinnedFeatures& features,
+                       const trees::DenseFloatBinarySplit& split,
+                       gtl::ArraySlice<int64> examples,
+                       std::vector<int64>* left_examples,
+                       std::vector<int64>* right_examples);
+
+}  // namespace learner
+}  // namespace boosted_trees
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_LEARNER_GRADIENT_HISTOGRAM_H_
@@ -0,0 +1,194 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#include "tensorflow/contrib/boosted_trees/lib/learner/gradient_histogram.h"
+
+#include <numeric>
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace learner {
+namespace {
+
+class GradientHistogramTest : public ::testing::Test {
+ protected:
+  // Creates a batch of random features in [0, 1) with "num_boundaries"
+  // uniform boundaries, and random gradients and hessians.
+  void Initialize(int64 batch_size, int num_features, int num_boundaries) {
+    random::PhiloxRandom philox(42);
+    random::SimplePhilox rng(&philox);
+    std::vector<Tensor> columns;
+    std::vector<std::vector<float>> boundaries;
+    for (int feature = 0; feature < num_features; ++feature) {
+      Tensor column(DT_FLOAT, TensorShape({batch_size, 1}));
+      auto values = column.matrix<float>();
+      for (int64 example = 0; example < batch_size; ++example) {
+        values(example, 0) = rng.RandFloat();
+      }
+      columns.push_back(column);
+      std::vector<float> feature_boundaries;
+      for (int i = 1; i <= num_boundaries; ++i) {
+        feature_boundaries.push_back(static_cast<float>(i) /
+                                     (num_boundaries + 1));
+      }
+      boundaries.push_back(feature_boundaries);
+    }
+    TF_ASSERT_OK(features_.Initialize(columns, boundaries, nullptr));
+    columns_ = columns;
+    gradients_.resize(batch_size);
+    hessians_.resize(batch_size);
+    examples_.resize(batch_size);
+    for (int64 example = 0; example < batch_size; ++example) {
+      // Make the gradients depend on the first feature.
+      gradients_[example] = rng.RandFloat() - 0.5f +
+                            (columns[0].matrix<float>()(example, 0) > 0.3f);
+      hessians_[example] = 0.5f + rng.RandFloat();
+    }
+    std::iota(examples_.begin(), examples_.end(), 0);
+  }
+
+  void ExpectEqual(const GradientHistogram& expected,
+                   const GradientHistogram& actual) {
+    for (int feature = 0; feature < features_.num_features(); ++feature) {
+      for (int bin = 0; bin < features_.num_bins(feature); ++bin) {
+        const GradientStats& a = expected.stats(feature, bin);
+        const GradientStats& b = actual.stats(feature, bin);
+        EXPECT_NEAR(a.gradient, b.gradient, 1e-6);
+        EXPECT_NEAR(a.hessian, b.hessian, 1e-6);
+        EXPECT_EQ(a.count, b.count);
+      }
+    }
+  }
+
+  BinnedFeatures features_;
+  std::vector<Tensor> columns_;
+  std::vector<float> gradients_;
+  std::vector<float> hessians_;
+  std::vector<int64> examples_;
+};
+
+TEST_F(GradientHistogramTest, ParallelAccumulate) {
+  Initialize(20000, 2, 300);
+  GradientHistogram serial(features_);
+  serial.Accumulate(features_, gradients_, hessians_, examples_, nullptr);
+  // More threads than features also splits the examples into blocks.
+  thread::ThreadPool thread_pool(Env::Default(), "test", 8);
+  GradientHistogram parallel(features_);
+  parallel.Accumulate(features_, gradients_, hessians_, examples_,
+                      &thread_pool);
+  ExpectEqual(serial, parallel);
+  EXPECT_EQ(20000, parallel.Total().count);
+  EXPECT_NEAR(std::accumulate(hessians_.begin(), hessians_.end(), 0.0),
+              parallel.Total().hessian, 1e-3);
+}
+
+TEST_F(GradientHistogramTest, SubtractSibling) {
+  Initialize(1000, 3, 20);
+  GradientHistogram parent(features_);
+  parent.Accumulate(features_, gradients_, hessians_, examples_, nullptr);
+  LearnerConfig config;
+  SplitCandidate best;
+  ASSERT_TRUE(parent.FindBestSplit(features_, config, &best));
+
+  std::vector<int64> left_examples, right_examples;
+  PartitionExamples(features_, best.split, examples_, &left_examples,
+                    &right_examples);
+  EXPECT_EQ(best.left_stats.count, left_examples.size());
+  EXPECT_EQ(best.right_stats.count, right_examples.size());
+  GradientHistogram left(features_);
+  left.Accumulate(features_, gradients_, hessians_, left_examples, nullptr);
+  GradientHistogram right(features_);
+  right.Accumulate(features_, gradients_, hessians_, right_examples, nullptr);
+  GradientHistogram sibling = parent;
+  sibling.Subtract(left);
+  ExpectEqual(right, sibling);
+}
+
+TEST_F(GradientHistogramTest, FindBestSplit) {
+  Initialize(2000, 3, 30);
+  GradientHistogram histogram(features_);
+  histogram.Accumulate(features_, gradients_, hessians_, examples_, nullptr);
+  LearnerConfig config;
+  config.mutable_regularization()->set_l1(1.0f);
+  config.mutable_regularization()->set_l2(2.0f);
+  config.mutable_regularization()->set_tree_complexity(0.5f);
+  SplitCandidate best;
+  ASSERT_TRUE(histogram.FindBestSplit(features_, config, &best));
+  EXPECT_EQ(0, best.split.feature_column());
+  EXPECT_NEAR(0.3f, best.split.threshold(), 1.0f / 31);
+
+  // Compare with the gain of every threshold, computed from the examples.
+  double best_exact_gain = 0;
+  GradientStats total;
+  for (int64 example : examples_) {
+    total.gradient += gradients_[example];
+    total.hessian += hessians_[example];
+    ++total.count;
+  }
+  double parent_gain;
+  ComputeLeafWeight(total, config.regularization(), &parent_gain);
+  for (int feature = 0; feature < features_.num_features(); ++feature) {
+    for (float threshold : features_.boundaries(feature)) {
+      GradientStats left;
+      for (int64 example : examples_) {
+        if (columns_[feature].matrix<float>()(example, 0) <= threshold) {
+          left.gradient += gradients_[example];
+          left.hessian += hessians_[example];
+          ++left.count;
+        }
+      }
+      GradientStats right = total;
+      right -= left;
+      double left_gain, right_gain;
+      ComputeLeafWeight(left, config.regularization(), &left_gain);
+      ComputeLeafWeight(right, config.regularization(), &right_gain);
+      best_exact_gain =
+          std::max(best_exact_gain, left_gain + right_gain - parent_gain -
+                                        config.regularization()
+                                            .tree_complexity());
+    }
+  }
+  EXPECT_NEAR(best_exact_gain, best.gain, 1e-3);
+
+  // The minimum node weight rules out all splits.
+  config.mutable_constraints()->set_min_node_weight(total.hessian);
+  EXPECT_FALSE(histogram.FindBestSplit(features_, config, &best));
+}
+
+TEST_F(GradientHistogramTest, ComputeLeafWeight) {
+  GradientStats stats;
+  stats.gradient = 3;
+  stats.hessian = 1;
+  TreeRegularizationConfig regularization;
+  regularization.set_l1(1);
+  regularization.set_l2(1);
+  double gain;
+  EXPECT_FLOAT_EQ(-1.0f, ComputeLeafWeight(stats, regularization, &gain));
+  EXPECT_DOUBLE_EQ(2.0, gain);
+  stats.gradient = 0.5;
+  EXPECT_FLOAT_EQ(0.0f, ComputeLeafWeight(stats, regularization, &gain));
+  EXPECT_DOUBLE_EQ(0.0, gain);
+}
+
+}  // namespace
+}  // namespace learner
+}  // namespace boosted_trees
+}  // namespace tensorflow
@@ -13,7 +13,9 @@
 // limitations under the License.
 // =============================================================================
 #include "tensorflow/contrib/boosted_trees/lib/models/multiple_additive_trees.h"
-#include "tensorflow/contrib/boosted_trees/lib/trees/decision_tree.h"
+
+#include <algorithm>
+
 #include "tensorflow/contrib/boosted_trees/lib/utils/batch_features.h"
 #include "tensorflow/contrib/boosted_trees/lib/utils/parallel_for.h"
 
@@ -22,6 +24,10 @@ namespace boosted_trees {
 namespace models {
 
 namespace {
+
+// The number of examples evaluated together, tree by tree.
+constexpr int64 kExamplesPerBlock = 64;
+
 void CalculateTreesToKeep(
     const boosted_trees::trees::DecisionTreeEnsembleConfig& config,
     const std::vector<int32>& trees_to_drop, const int32 num_trees,
@@ -55,33 +61,19 @@ void UpdatePredictions(
 
 void UpdatePredictionsBasedOnTree(
     const boosted_trees::trees::DecisionTreeEnsembleConfig& config,
+    const boosted_trees::trees::FlatDecisionTreeEnsemble& flat_ensemble,
     const int32 tree_idx, const boosted_trees::utils::Example& example,
     tensorflow::TTypes<float>::Matrix* output_predictions,
     tensorflow::TTypes<float>::Matrix* additional_output_predictions) {
-  const boosted_trees::trees::DecisionTreeConfig& tree = config.trees(tree_idx);
   const float tree_weight = config.tree_weights(tree_idx);
-  const int leaf_idx = trees::DecisionTree::Traverse(tree, 0, example);
-  QCHECK(leaf_idx >= 0) << "Invalid tree: " << tree.DebugString();
-  const auto& leaf_node = tree.nodes(leaf_idx);
-  QCHECK(leaf_node.has_leaf())
-      << "Invalid leaf node: " << leaf_node.DebugString();
-  if (leaf_node.leaf().has_sparse_vector()) {
-    const auto& leaf = leaf_node.leaf().sparse_vector();
-    QCHECK_EQ(leaf.index_size(), leaf.value_size());
-    for (size_t class_idx = 0; class_idx < leaf.index_size(); ++class_idx) {
-      const float value = tree_weight * leaf.value(class_idx);
-
-      UpdatePredictions(example.example_idx, leaf.index(class_idx), value,
-                        output_predictions, additional_output_predictions);
-    }
-  } else {
-    QCHECK(leaf_node.leaf().has_vector()) << "Unknown leaf type";
-    const auto& leaf = leaf_node.leaf().vector();
-    for (size_t i = 0; i < leaf.value_size(); ++i) {
-      const float value = tree_weight * leaf.value(i);
-      UpdatePredictions(example.example_idx, i, value, output_predictions,
-                        additional_output_predictions);
-    }
+  const int32 leaf = flat_ensemble.Traverse(tree_idx, example);
+  QCHECK(leaf >= 0) << "Invalid tree: " << config.trees(tree_idx).DebugString();
+  const auto classes = flat_ensemble.leaf_classes(leaf);
+  const auto values = flat_ensemble.leaf_values(leaf);
+  for (size_t i = 0; i < values.size(); ++i) {
+    UpdatePredictions(example.example_idx, classes[i],
+                      tree_weight * values[i], output_predictions,
+                      additional_output_predictions);
   }
 }
 
@@ -94,6 +86,19 @@ void MultipleAdditiveTrees::Predict(
     tensorflow::thread::ThreadPool* worker_threads,
     tensorflow::TTypes<float>::Matrix output_predictions,
     tensorflow::TTypes<float>::Matrix no_dropout_predictions) {
+  const boosted_trees::trees::FlatDecisionTreeEnsemble flat_ensemble(config);
+  Predict(config, flat_ensemble, only_finalized_trees, trees_to_drop, features,
+          worker_threads, output_predictions, no_dropout_predictions);
+}
+
+void MultipleAdditiveTrees::Predict(
+    const boosted_trees::trees::DecisionTreeEnsembleConfig& config,
+    const boosted_trees::trees::FlatDecisionTreeEnsemble& flat_ensemble,
+    const bool only_finalized_trees, const std::vector<int32>& trees_to_drop,
+    const boosted_trees::utils::BatchFeatures& features,
+    tensorflow::thread::ThreadPool* worker_threads,
+    tensorflow::TTypes<float>::Matrix output_predictions,
+    tensorflow::TTypes<float>::Matrix no_dropout_predictions) {
   // Zero out predictions as the model is additive.
   output_predictions.setZero();
   no_dropout_predictions.setZero();
@@ -109,22 +114,39 @@ void MultipleAdditiveTrees::Predict(
   CalculateTreesToKeep(config, trees_to_drop, config.trees_size(),
                        only_finalized_trees, &trees_to_keep);
 
-  // Lambda for doing a block of work.
-  auto update_predictions = [&config, &features, &trees_to_keep, &trees_to_drop,
+  // Lambda for doing a block of work. The examples are evaluated in small
+  // blocks, tree by tree, so that the nodes of a tree stay in cache for all
+  // the examples of a block.
+  auto update_predictions = [&config, &flat_ensemble, &features,
+                             &trees_to_keep, &trees_to_drop,
                              &output_predictions,
                              &no_dropout_predictions](int64 start, int64 end) {
+    std::vector<boosted_trees::utils::Example> block(
+        std::min(kExamplesPerBlock, end - start));
     auto examples_iterable = features.examples_iterable(start, end);
-    for (const auto& example : examples_iterable) {
+    auto example_it = examples_iterable.begin();
+    const auto examples_end = examples_iterable.end();
+    while (example_it != examples_end) {
+      size_t block_size = 0;
+      for (; block_size < block.size() && example_it != examples_end;
+           ++block_size, ++example_it) {
+        block[block_size] = *example_it;
+      }
       for (const int32 tree_idx : trees_to_keep) {
-        UpdatePredictionsBasedOnTree(config, tree_idx, example,
-                                     &output_predictions,
-                                     &no_dropout_predictions);
+        for (size_t i = 0; i < block_size; ++i) {
+          UpdatePredictionsBasedOnTree(config, flat_ensemble, tree_idx,
+                                       block[i], &output_predictions,
+                                       &no_dropout_predictions);
+        }
       }
 
       // Now do predictions for dropped trees
       for (const int32 tree_idx : trees_to_drop) {
-        UpdatePredictionsBasedOnTree(config, tree_idx, example,
-                                     &no_dropout_predictions, nullptr);
+        for (size_t i = 0; i < block_size; ++i) {
+          UpdatePredictionsBasedOnTree(config, flat_ensemble, tree_idx,
+                                       block[i], &no_dropout_predictions,
+                                       nullptr);
+        }
       }
     }
   };
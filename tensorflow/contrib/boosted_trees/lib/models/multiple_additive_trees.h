@@ -17,6 +17,7 @@
 
 #include <vector>
 
+#include "tensorflow/contrib/boosted_trees/lib/trees/flat_decision_tree_ensemble.h"
 #include "tensorflow/contrib/boosted_trees/lib/utils/batch_features.h"
 #include "tensorflow/contrib/boosted_trees/proto/tree_config.pb.h"  // NOLINT
 #include "tensorflow/core/framework/tensor_types.h"
@@ -41,6 +42,18 @@ class MultipleAdditiveTrees {
       thread::ThreadPool* const thread_pool,
       TTypes<float>::Matrix output_predictions,
       TTypes<float>::Matrix no_dropout_predictions);
+
+  // Same as above, with the trees of "config" already compiled into
+  // "flat_ensemble", so that callers predicting many batches with the same
+  // ensemble compile it only once.
+  static void Predict(
+      const boosted_trees::trees::DecisionTreeEnsembleConfig& config,
+      const boosted_trees::trees::FlatDecisionTreeEnsemble& flat_ensemble,
+      const bool only_finalized_trees, const std::vector<int32>& trees_to_drop,
+      const boosted_trees::utils::BatchFeatures& features,
+      thread::ThreadPool* const thread_pool,
+      TTypes<float>::Matrix output_predictions,
+      TTypes<float>::Matrix no_dropout_predictions);
 };
 
 }  // namespace models
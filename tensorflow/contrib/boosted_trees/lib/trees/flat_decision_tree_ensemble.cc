@@ -0,0 +1,149 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#include "tensorflow/contrib/boosted_trees/lib/trees/flat_decision_tree_ensemble.h"
+
+#include "tensorflow/contrib/boosted_trees/lib/trees/decision_tree.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace trees {
+
+FlatDecisionTreeEnsemble::FlatDecisionTreeEnsemble(
+    const DecisionTreeEnsembleConfig& config) {
+  leaf_starts_.push_back(0);
+  feature_id_starts_.push_back(0);
+  for (const DecisionTreeConfig& tree : config.trees()) {
+    AddTree(tree);
+  }
+}
+
+void FlatDecisionTreeEnsemble::AddTree(const DecisionTreeConfig& tree) {
+  if (tree.nodes_size() == 0) {
+    tree_roots_.push_back(-1);
+    return;
+  }
+  const int32 root = kinds_.size();
+  tree_roots_.push_back(root);
+
+  // Order the nodes reachable from the root depth first, left child first.
+  std::vector<int32> flat_ids(tree.nodes_size(), -1);
+  std::vector<int32> order;
+  std::vector<int32> stack = {0};
+  while (!stack.empty()) {
+    const int32 node_id = stack.back();
+    stack.pop_back();
+    QCHECK(node_id >= 0 && node_id < tree.nodes_size())
+        << "Invalid child id " << node_id << " in tree: " << tree.DebugString();
+    QCHECK_EQ(flat_ids[node_id], -1)
+        << "Malformed tree, node " << node_id
+        << " has several parents: " << tree.DebugString();
+    flat_ids[node_id] = root + order.size();
+    order.push_back(node_id);
+    const std::vector<int32> children =
+        DecisionTree::GetChildren(tree.nodes(node_id));
+    stack.insert(stack.end(), children.rbegin(), children.rend());
+  }
+
+  for (const int32 node_id : order) {
+    const TreeNode& node = tree.nodes(node_id);
+    NodeKind kind = kLeaf;
+    const DenseFloatBinarySplit* float_split = nullptr;
+    int32 feature_column = 0;
+    int32 right_id = 0;
+    int32 aux = 0;
+    switch (node.node_case()) {
+      case TreeNode::kLeaf: {
+        aux = leaf_node_ids_.size();
+        leaf_node_ids_.push_back(node_id);
+        const Leaf& leaf = node.leaf();
+        if (leaf.has_sparse_vector()) {
+          const auto& values = leaf.sparse_vector();
+          QCHECK_EQ(values.index_size(), values.value_size());
+          leaf_classes_.insert(leaf_classes_.end(), values.index().begin(),
+                               values.index().end());
+          leaf_values_.insert(leaf_values_.end(), values.value().begin(),
+                              values.value().end());
+        } else {
+          const auto& values = leaf.vector();
+          for (int32 i = 0; i < values.value_size(); ++i) {
+            leaf_classes_.push_back(i);
+          }
+          leaf_values_.insert(leaf_values_.end(), values.value().begin(),
+                              values.value().end());
+        }
+        leaf_starts_.push_back(leaf_values_.size());
+        break;
+      }
+      case TreeNode::kDenseFloatBinarySplit: {
+        kind = kDenseFloatSplit;
+        float_split = &node.dense_float_binary_split();
+        break;
+      }
+      case TreeNode::kSparseFloatBinarySplitDefaultLeft: {
+        kind = kSparseFloatSplitDefaultLeft;
+        float_split = &node.sparse_float_binary_split_default_left().split();
+        break;
+      }
+      case TreeNode::kSparseFloatBinarySplitDefaultRight: {
+        kind = kSparseFloatSplitDefaultRight;
+        float_split = &node.sparse_float_binary_split_default_right().split();
+        break;
+      }
+      case TreeNode::kCategoricalIdBinarySplit: {
+        kind = kCategoricalIdSplit;
+        const auto& split = node.categorical_id_binary_split();
+        feature_column = split.feature_column();
+        right_id = split.right_id();
+        aux = feature_id_starts_.size() - 1;
+        feature_ids_.push_back(split.feature_id());
+        feature_id_starts_.push_back(feature_ids_.size());
+        break;
+      }
+      case TreeNode::kCategoricalIdSetMembershipBinarySplit: {
+        kind = kCategoricalIdSetMembershipSplit;
+        const auto& split = node.categorical_id_set_membership_binary_split();
+        feature_column = split.feature_column();
+        right_id = split.right_id();
+        aux = feature_id_starts_.size() - 1;
+        feature_ids_.insert(feature_ids_.end(), split.feature_ids().begin(),
+                            split.feature_ids().end());
+        feature_id_starts_.push_back(feature_ids_.size());
+        break;
+      }
+      case TreeNode::NODE_NOT_SET: {
+        QCHECK(false) << "Invalid node in tree: " << node.DebugString();
+        break;
+      }
+    }
+    if (float_split != nullptr) {
+      feature_column = float_split->feature_column();
+      right_id = float_split->right_id();
+    }
+    if (kind != kDenseFloatSplit && kind != kLeaf) {
+      dense_only_ = false;
+    }
+    kinds_.push_back(kind);
+    feature_columns_.push_back(feature_column);
+    thresholds_.push_back(float_split != nullptr ? float_split->threshold()
+                                                 : 0);
+    right_children_.push_back(kind == kLeaf ? -1 : flat_ids[right_id]);
+    aux_.push_back(aux);
+  }
+}
+
+}  // namespace trees
+}  // namespace boosted_trees
+}  // namespace tensorflow
@@ -0,0 +1,176 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_TREES_FLAT_DECISION_TREE_ENSEMBLE_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_TREES_FLAT_DECISION_TREE_ENSEMBLE_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/contrib/boosted_trees/lib/utils/example.h"
+#include "tensorflow/contrib/boosted_trees/proto/tree_config.pb.h"  // NOLINT
+#include "tensorflow/core/lib/gtl/array_slice.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace trees {
+
+// A decision tree ensemble compiled into flat arrays for fast traversal.
+//
+// The nodes of all the trees are laid out as a struct of arrays in depth
+// first order, so that the left child of a split immediately follows it and
+// only the right child needs an index. Traversal reads a few compact arrays
+// instead of dispatching on the oneof of each TreeNode proto, and evaluates
+// dense float splits, the most common ones, in a tight loop when the whole
+// ensemble only has those. The values of all the leaves are flattened too.
+//
+// The ensemble is immutable and thread safe.
+class FlatDecisionTreeEnsemble {
+ public:
+  explicit FlatDecisionTreeEnsemble(const DecisionTreeEnsembleConfig& config);
+
+  int32 num_trees() const { return tree_roots_.size(); }
+  int32 num_leaves() const { return leaf_node_ids_.size(); }
+
+  // Returns the leaf of the tree that the example falls into, or -1 if the
+  // tree is empty.
+  int32 Traverse(int32 tree, const utils::Example& example) const;
+
+  // Returns the id of a leaf in the nodes of its DecisionTreeConfig.
+  int32 leaf_node_id(int32 leaf) const { return leaf_node_ids_[leaf]; }
+
+  // Returns the class indices of the values of a leaf, and the values.
+  gtl::ArraySlice<int32> leaf_classes(int32 leaf) const {
+    return gtl::ArraySlice<int32>(leaf_classes_.data() + leaf_starts_[leaf],
+                                  leaf_starts_[leaf + 1] - leaf_starts_[leaf]);
+  }
+  gtl::ArraySlice<float> leaf_values(int32 leaf) const {
+    return gtl::ArraySlice<float>(leaf_values_.data() + leaf_starts_[leaf],
+                                  leaf_starts_[leaf + 1] - leaf_starts_[leaf]);
+  }
+
+ private:
+  enum NodeKind : uint8 {
+    kLeaf,
+    kDenseFloatSplit,
+    kSparseFloatSplitDefaultLeft,
+    kSparseFloatSplitDefaultRight,
+    kCategoricalIdSplit,
+    kCategoricalIdSetMembershipSplit,
+  };
+
+  // Appends the nodes of a tree in depth first order.
+  void AddTree(const DecisionTreeConfig& tree);
+
+  // Returns the child of a split that the example goes to.
+  int32 NextNode(int32 node, const utils::Example& example) const;
+
+  // The first node of each tree, or -1 for an empty tree.
+  std::vector<int32> tree_roots_;
+
+  // The nodes. For leaves, aux_ indexes the leaves; for categorical splits,
+  // it indexes the ranges of feature ids of the splits.
+  std::vector<NodeKind> kinds_;
+  std::vector<int32> feature_columns_;
+  std::vector<float> thresholds_;
+  std::vector<int32> right_children_;
+  std::vector<int32> aux_;
+
+  // The sorted feature ids of the categorical splits, and where the ids of
+  // each split start, with a final end.
+  std::vector<int64> feature_ids_;
+  std::vector<int32> feature_id_starts_;
+
+  // Where the values of each leaf start in leaf_classes_ and leaf_values_,
+  // with a final end, and the node ids of the leaves.
+  std::vector<int32> leaf_starts_;
+  std::vector<int32> leaf_classes_;
+  std::vector<float> leaf_values_;
+  std::vector<int32> leaf_node_ids_;
+
+  // Whether all the splits are dense float splits.
+  bool dense_only_ = true;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FlatDecisionTreeEnsemble);
+};
+
+inline int32 FlatDecisionTreeEnsemble::NextNode(
+    int32 node, const utils::Example& example) const {
+  const int32 feature_column = feature_columns_[node];
+  switch (kinds_[node]) {
+    case kDenseFloatSplit:
+      return example.dense_float_features[feature_column] <= thresholds_[node]
+                 ? node + 1
+                 : right_children_[node];
+    case kSparseFloatSplitDefaultLeft: {
+      const auto& feature = example.sparse_float_features[feature_column];
+      return !feature.has_value() || feature.get_value() <= thresholds_[node]
+                 ? node + 1
+                 : right_children_[node];
+    }
+    case kSparseFloatSplitDefaultRight: {
+      const auto& feature = example.sparse_float_features[feature_column];
+      return feature.has_value() && feature.get_value() <= thresholds_[node]
+                 ? node + 1
+                 : right_children_[node];
+    }
+    case kCategoricalIdSplit:
+      return example.sparse_int_features[feature_column].count(
+                 feature_ids_[feature_id_starts_[aux_[node]]]) > 0
+                 ? node + 1
+                 : right_children_[node];
+    case kCategoricalIdSetMembershipSplit: {
+      const auto begin = feature_ids_.begin() + feature_id_starts_[aux_[node]];
+      const auto end =
+          feature_ids_.begin() + feature_id_starts_[aux_[node] + 1];
+      for (const int64 feature_id :
+           example.sparse_int_features[feature_column]) {
+        if (std::binary_search(begin, end, feature_id)) return node + 1;
+      }
+      return right_children_[node];
+    }
+    case kLeaf:
+      break;
+  }
+  return node;
+}
+
+inline int32 FlatDecisionTreeEnsemble::Traverse(
+    int32 tree, const utils::Example& example) const {
+  int32 node = tree_roots_[tree];
+  if (TF_PREDICT_FALSE(node < 0)) {
+    return -1;
+  }
+  if (dense_only_) {
+    while (kinds_[node] != kLeaf) {
+      node = example.dense_float_features[feature_columns_[node]] <=
+                     thresholds_[node]
+                 ? node + 1
+                 : right_children_[node];
+    }
+  } else {
+    while (kinds_[node] != kLeaf) {
+      node = NextNode(node, example);
+    }
+  }
+  return aux_[node];
+}
+
+}  // namespace trees
+}  // namespace boosted_trees
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_BOOSTED_TREES_LIB_TREES_FLAT_DECISION_TREE_ENSEMBLE_H_
@@ -0,0 +1,161 @@
+// Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// =============================================================================
+#include "tensorflow/contrib/boosted_trees/lib/trees/flat_decision_tree_ensemble.h"
+#include "tensorflow/contrib/boosted_trees/lib/testutil/batch_features_testutil.h"
+#include "tensorflow/contrib/boosted_trees/lib/testutil/random_tree_gen.h"
+#include "tensorflow/contrib/boosted_trees/lib/trees/decision_tree.h"
+#include "tensorflow/contrib/boosted_trees/lib/utils/batch_features.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace boosted_trees {
+namespace trees {
+namespace {
+
+class FlatDecisionTreeEnsembleTest : public ::testing::Test {
+ protected:
+  FlatDecisionTreeEnsembleTest() : batch_features_(2) {
+    // Create a batch of two examples having one dense float, one sparse float
+    // and one sparse int features.
+    // Instance | DenseF1 | SparseF1 | SparseI1 |
+    // 0        |   7     |   -3     |   3, 5   |
+    // 1        |  -2     |          |          |
+    auto dense_float_matrix = test::AsTensor<float>({7.0f, -2.0f}, {2, 1});
+    auto sparse_float_indices = test::AsTensor<int64>({0, 0}, {1, 2});
+    auto sparse_float_values = test::AsTensor<float>({-3.0f});
+    auto sparse_float_shape = test::AsTensor<int64>({2, 1});
+    auto sparse_int_indices = test::AsTensor<int64>({0, 0, 0, 1}, {2, 2});
+    auto sparse_int_values = test::AsTensor<int64>({3, 5});
+    auto sparse_int_shape = test::AsTensor<int64>({2, 2});
+    TF_EXPECT_OK(batch_features_.Initialize(
+        {dense_float_matrix}, {sparse_float_indices}, {sparse_float_values},
+        {sparse_float_shape}, {sparse_int_indices}, {sparse_int_values},
+        {sparse_int_shape}));
+  }
+
+  // Expects the flat ensemble to reach the same leaves as DecisionTree.
+  void ExpectSameLeaves(const DecisionTreeEnsembleConfig& config,
+                        const utils::BatchFeatures& features) {
+    const FlatDecisionTreeEnsemble flat_ensemble(config);
+    ASSERT_EQ(config.trees_size(), flat_ensemble.num_trees());
+    for (const auto& example :
+         features.examples_iterable(0, features.batch_size())) {
+      for (int32 tree = 0; tree < config.trees_size(); ++tree) {
+        const int32 leaf = flat_ensemble.Traverse(tree, example);
+        ASSERT_GE(leaf, 0);
+        EXPECT_EQ(DecisionTree::Traverse(config.trees(tree), 0, example),
+                  flat_ensemble.leaf_node_id(leaf));
+      }
+    }
+  }
+
+  utils::BatchFeatures batch_features_;
+};
+
+TEST_F(FlatDecisionTreeEnsembleTest, EmptyTree) {
+  DecisionTreeEnsembleConfig config;
+  config.add_trees();
+  const FlatDecisionTreeEnsemble flat_ensemble(config);
+  auto example = (*batch_features_.examples_iterable(0, 1).begin());
+  EXPECT_EQ(-1, flat_ensemble.Traverse(0, example));
+}
+
+TEST_F(FlatDecisionTreeEnsembleTest, DenseSplits) {
+  // Nodes out of depth first order, with the left child of the root last.
+  DecisionTreeEnsembleConfig config;
+  auto* tree = config.add_trees();
+  auto* split = tree->add_nodes()->mutable_dense_float_binary_split();
+  split->set_feature_column(0);
+  split->set_threshold(0.0f);
+  split->set_left_id(2);
+  split->set_right_id(1);
+  tree->add_nodes()->mutable_leaf()->mutable_vector()->add_value(1.0f);
+  auto* sparse_leaf =
+      tree->add_nodes()->mutable_leaf()->mutable_sparse_vector();
+  sparse_leaf->add_index(3);
+  sparse_leaf->add_value(-1.0f);
+  sparse_leaf->add_index(1);
+  sparse_leaf->add_value(2.0f);
+  ExpectSameLeaves(config, batch_features_);
+
+  const FlatDecisionTreeEnsemble flat_ensemble(config);
+  auto example_iterable = batch_features_.examples_iterable(0, 2);
+  auto example_it = example_iterable.begin();
+  // 7 > 0 goes right.
+  const int32 right_leaf = flat_ensemble.Traverse(0, *example_it);
+  EXPECT_EQ(1, flat_ensemble.leaf_node_id(right_leaf));
+  EXPECT_EQ(std::vector<int32>({0}),
+            std::vector<int32>(flat_ensemble.leaf_classes(right_leaf).begin(),
+                               flat_ensemble.leaf_classes(right_leaf).end()));
+  EXPECT_EQ(1.0f, flat_ensemble.leaf_values(right_leaf)[0]);
+  // -2 <= 0 goes left.
+  const int32 left_leaf = flat_ensemble.Traverse(0, *++example_it);
+  EXPECT_EQ(2, flat_ensemble.leaf_node_id(left_leaf));
+  ASSERT_EQ(2, flat_ensemble.leaf_values(left_leaf).size());
+  EXPECT_EQ(3, flat_ensemble.leaf_classes(left_leaf)[0]);
+  EXPECT_EQ(-1.0f, flat_ensemble.leaf_values(left_leaf)[0]);
+  EXPECT_EQ(1, flat_ensemble.leaf_classes(left_leaf)[1]);
+  EXPECT_EQ(2.0f, flat_ensemble.leaf_values(left_leaf)[1]);
+}
+
+TEST_F(FlatDecisionTreeEnsembleTest, MixedSplits) {
+  DecisionTreeEnsembleConfig config;
+  // Sparse float split defaulting right, then a categorical id split.
+  auto* tree1 = config.add_trees();
+  auto* sparse_split = tree1->add_nodes()
+                           ->mutable_sparse_float_binary_split_default_right()
+                           ->mutable_split();
+  sparse_split->set_feature_column(0);
+  sparse_split->set_threshold(0.0f);
+  sparse_split->set_left_id(1);
+  sparse_split->set_right_id(2);
+  auto* categorical_split =
+      tree1->add_nodes()->mutable_categorical_id_binary_split();
+  categorical_split->set_feature_column(0);
+  categorical_split->set_feature_id(5);
+  categorical_split->set_left_id(3);
+  categorical_split->set_right_id(4);
+  for (int i = 0; i < 3; ++i) {
+    tree1->add_nodes()->mutable_leaf();
+  }
+  // Categorical set membership split.
+  auto* tree2 = config.add_trees();
+  auto* set_split =
+      tree2->add_nodes()->mutable_categorical_id_set_membership_binary_split();
+  set_split->set_feature_column(0);
+  set_split->add_feature_ids(1);
+  set_split->add_feature_ids(3);
+  set_split->set_left_id(1);
+  set_split->set_right_id(2);
+  tree2->add_nodes()->mutable_leaf();
+  tree2->add_nodes()->mutable_leaf();
+  ExpectSameLeaves(config, batch_features_);
+}
+
+TEST_F(FlatDecisionTreeEnsembleTest, RandomEnsemble) {
+  random::PhiloxRandom philox(1234);
+  random::SimplePhilox rng(&philox);
+  utils::BatchFeatures features(100);
+  testutil::RandomlyInitializeBatchFeatures(&rng, 5, 5, 0.3, 0.7, &features);
+  testutil::RandomTreeGen tree_gen(&rng, 5, 5);
+  ExpectSameLeaves(tree_gen.GenerateEnsemble(6, 10), features);
+}
+
+}  // namespace
+}  // namespace trees
+}  // namespace boosted_trees
+}  // namespace tensorflow
@@ -75,12 +75,11 @@ class BigQueryReader : public ReaderBase {
       return Status::OK();
     }
 
-    Example example;
     int64 row_id;
-    TF_RETURN_IF_ERROR(bigquery_table_accessor_->ReadRow(&row_id, &example));
+    TF_RETURN_IF_ERROR(bigquery_table_accessor_->ReadRow(&row_id, &example_));
 
     *key = std::to_string(row_id);
-    *value = example.SerializeAsString();
+    example_.SerializeToString(value);
     *produced = true;
     return Status::OK();
   }
@@ -88,6 +87,9 @@ class BigQueryReader : public ReaderBase {
  private:
   // Not owned.
   BigQueryTableAccessor* bigquery_table_accessor_;
+
+  // The last row read, kept around to reuse its memory.
+  Example example_;
 };
 
 class BigQueryReaderOp : public ReaderOpKernel {
@@ -142,9 +142,7 @@ BigQueryTableAccessor::BigQueryTableAccessor(
           project_id, dataset_id, table_id, timestamp_millis, row_buffer_size,
           end_point, columns, partition,
           std::unique_ptr<AuthProvider>(new GoogleAuthProvider()),
-          std::unique_ptr<HttpRequest::Factory>(new HttpRequest::Factory())) {
-  row_buffer_.resize(row_buffer_size);
-}
+          std::unique_ptr<HttpRequest::Factory>(new HttpRequest::Factory())) {}
 
 BigQueryTableAccessor::BigQueryTableAccessor(
     const string& project_id, const string& dataset_id, const string& table_id,
@@ -159,12 +157,19 @@ BigQueryTableAccessor::BigQueryTableAccessor(
       columns_(columns.begin(), columns.end()),
       bigquery_end_point_(end_point),
       partition_(partition),
+      row_buffer_size_(row_buffer_size),
       auth_provider_(std::move(auth_provider)),
-      http_request_factory_(std::move(http_request_factory)) {
-  row_buffer_.resize(row_buffer_size);
+      http_request_factory_(std::move(http_request_factory)),
+      prefetch_thread_(new thread::ThreadPool(
+          Env::Default(), "bigquery_table_accessor_prefetch", 1)) {
   Reset();
 }
 
+BigQueryTableAccessor::~BigQueryTableAccessor() {
+  mutex_lock l(mu_);
+  WaitForPrefetch(&l);
+}
+
 Status BigQueryTableAccessor::SetPartition(
     const BigQueryTablePartition& partition) {
   if (partition.start_index() < 0) {
@@ -178,7 +183,18 @@ Status BigQueryTableAccessor::SetPartition(
 void BigQueryTableAccessor::Reset() {
   first_buffered_row_index_ = partition_.start_index();
   next_row_in_buffer_ = -1;
-  next_page_token_ = "";
+  row_buffer_.num_rows = 0;
+  row_buffer_.next_page_token = "";
+  // Drop the page prefetched for the previous partition, if any.
+  mutex_lock l(mu_);
+  WaitForPrefetch(&l);
+  has_prefetched_page_ = false;
+}
+
+void BigQueryTableAccessor::WaitForPrefetch(mutex_lock* lock) {
+  while (prefetch_in_flight_) {
+    prefetch_done_.wait(*lock);
+  }
 }
 
 Status BigQueryTableAccessor::ReadRow(int64* row_id, Example* example) {
@@ -187,66 +203,132 @@ Status BigQueryTableAccessor::ReadRow(int64* row_id, Example* example) {
   }
 
   // If the next row is already fetched and cached, return the row from the
-  // buffer. Otherwise, fill up the row buffer from BigQuery and return a row.
-  if (next_row_in_buffer_ != -1 &&
-      next_row_in_buffer_ < ComputeMaxResultsArg()) {
-    *row_id = first_buffered_row_index_ + next_row_in_buffer_;
-    *example = row_buffer_[next_row_in_buffer_];
-    next_row_in_buffer_++;
+  // buffer. Otherwise, move on to the next page of rows and return its first
+  // row.
+  if (next_row_in_buffer_ == -1 ||
+      next_row_in_buffer_ >=
+          std::min(row_buffer_.num_rows, ComputeMaxResultsArg())) {
+    TF_RETURN_IF_ERROR(ReadNextPage());
+  }
+  *row_id = first_buffered_row_index_ + next_row_in_buffer_;
+  // Each row is returned once, so hand it over instead of copying it.
+  example->Swap(&row_buffer_.rows[next_row_in_buffer_]);
+  next_row_in_buffer_++;
+  return Status::OK();
+}
+
+Status BigQueryTableAccessor::ReadNextPage() {
+  int64 start_index = first_buffered_row_index_;
+  if (next_row_in_buffer_ != -1) {
+    start_index += std::min(row_buffer_.num_rows, ComputeMaxResultsArg());
+  }
+
+  bool prefetched;
+  Status prefetch_status;
+  {
+    mutex_lock l(mu_);
+    WaitForPrefetch(&l);
+    prefetched = has_prefetched_page_;
+    prefetch_status = prefetch_status_;
+    has_prefetched_page_ = false;
+  }
+  if (prefetched) {
+    TF_RETURN_IF_ERROR(prefetch_status);
   } else {
-    string auth_token;
-    TF_RETURN_IF_ERROR(
-        AuthProvider::GetToken(auth_provider_.get(), &auth_token));
-
-    std::unique_ptr<HttpRequest> request(http_request_factory_->Create());
-    std::vector<char> output_buffer;
-    output_buffer.reserve(kBufferSize);
-    TF_RETURN_IF_ERROR(request->Init());
-
-    // The first time that we access BigQuery there is no page token. After that
-    // we use the page token (which returns rows faster).
-    if (!next_page_token_.empty()) {
-      TF_RETURN_IF_ERROR(request->SetUri(strings::StrCat(
-          BigQueryUriPrefix(), "data?maxResults=", ComputeMaxResultsArg(),
-          "&pageToken=", request->EscapeString(next_page_token_))));
-      first_buffered_row_index_ += row_buffer_.size();
-    } else {
-      TF_RETURN_IF_ERROR(request->SetUri(strings::StrCat(
-          BigQueryUriPrefix(), "data?maxResults=", ComputeMaxResultsArg(),
-          "&startIndex=", first_buffered_row_index_)));
-    }
-    TF_RETURN_IF_ERROR(request->AddAuthBearerHeader(auth_token));
-    TF_RETURN_IF_ERROR(request->SetResultBuffer(&output_buffer));
-    TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when reading rows from ",
-                                    FullTableName());
-
-    // Parse the returned row.
-    StringPiece response_piece =
-        StringPiece(&output_buffer[0], output_buffer.size());
-    Json::Value root;
-    TF_RETURN_IF_ERROR(ParseJson(response_piece, &root));
-    for (unsigned int i = 0; i < root["rows"].size(); ++i) {
-      row_buffer_[i].Clear();
-      TF_RETURN_IF_ERROR(
-          ParseColumnValues(root["rows"][i], schema_root_, &row_buffer_[i]));
-    }
+    // Nothing was prefetched, so read the page here, into the page the
+    // prefetch thread would have used.
+    TF_RETURN_IF_ERROR(ReadPage(start_index, row_buffer_.next_page_token,
+                                ComputeMaxResultsArg(), &prefetched_page_));
+  }
+  std::swap(row_buffer_, prefetched_page_);
+  if (row_buffer_.num_rows == 0) {
+    return errors::Internal("BigQuery returned no rows at row ", start_index,
+                            " of ", FullTableName());
+  }
+  first_buffered_row_index_ = start_index;
+  next_row_in_buffer_ = 0;
+  MaybePrefetchNextPage();
+  return Status::OK();
+}
+
+void BigQueryTableAccessor::MaybePrefetchNextPage() {
+  const int64 start_index =
+      first_buffered_row_index_ +
+      std::min(row_buffer_.num_rows, ComputeMaxResultsArg());
+  if (start_index >= total_num_rows_ ||
+      (partition_.end_index() != -1 && start_index > partition_.end_index())) {
+    return;
+  }
+  const string page_token = row_buffer_.next_page_token;
+  const int64 max_results = ComputeMaxResultsArg();
+  mutex_lock l(mu_);
+  prefetch_in_flight_ = true;
+  prefetch_thread_->Schedule([this, start_index, page_token, max_results]() {
+    const Status status =
+        ReadPage(start_index, page_token, max_results, &prefetched_page_);
+    mutex_lock l(mu_);
+    prefetch_status_ = status;
+    has_prefetched_page_ = true;
+    prefetch_in_flight_ = false;
+    prefetch_done_.notify_all();
+  });
+}
+
+Status BigQueryTableAccessor::ReadPage(int64 start_index,
+                                       const string& page_token,
+                                       int64 max_results, Page* page) {
+  string auth_token;
+  TF_RETURN_IF_ERROR(AuthProvider::GetToken(auth_provider_.get(), &auth_token));
+
+  std::unique_ptr<HttpRequest> request(http_request_factory_->Create());
+  std::vector<char> output_buffer;
+  output_buffer.reserve(kBufferSize);
+  TF_RETURN_IF_ERROR(request->Init());
+
+  // The first time that we access BigQuery there is no page token. After that
+  // we use the page token (which returns rows faster).
+  if (!page_token.empty()) {
+    TF_RETURN_IF_ERROR(request->SetUri(strings::StrCat(
+        BigQueryUriPrefix(), "data?maxResults=", max_results,
+        "&pageToken=", request->EscapeString(page_token))));
+  } else {
+    TF_RETURN_IF_ERROR(request->SetUri(
+        strings::StrCat(BigQueryUriPrefix(), "data?maxResults=", max_results,
+                        "&startIndex=", start_index)));
+  }
+  TF_RETURN_IF_ERROR(request->AddAuthBearerHeader(auth_token));
+  TF_RETURN_IF_ERROR(request->SetResultBuffer(&output_buffer));
+  TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when reading rows from ",
+                                  FullTableName());
 
-    next_page_token_ = root["pageToken"].asString();
-    *row_id = first_buffered_row_index_;
-    *example = row_buffer_[0];
-    next_row_in_buffer_ = 1;
+  // Parse the returned rows, reusing the examples of the page.
+  StringPiece response_piece =
+      StringPiece(&output_buffer[0], output_buffer.size());
+  Json::Value root;
+  TF_RETURN_IF_ERROR(ParseJson(response_piece, &root));
+  const Json::Value& rows = root["rows"];
+  page->num_rows = 0;
+  if (page->rows.size() < rows.size()) {
+    page->rows.resize(rows.size());
+  }
+  for (unsigned int i = 0; i < rows.size(); ++i) {
+    page->rows[i].Clear();
+    TF_RETURN_IF_ERROR(
+        ParseColumnValues(rows[i], schema_root_, &page->rows[i]));
   }
+  page->num_rows = rows.size();
+  page->next_page_token = root["pageToken"].asString();
   return Status::OK();
 }
 
 int64 BigQueryTableAccessor::ComputeMaxResultsArg() {
   if (partition_.end_index() == -1) {
-    return row_buffer_.size();
+    return row_buffer_size_;
   }
   if (IsPartitionEmpty(partition_)) {
     return 0;
   }
-  return std::min(static_cast<int64>(row_buffer_.size()),
+  return std::min(row_buffer_size_,
                   static_cast<int64>(partition_.end_index() -
                                      partition_.start_index() + 1));
 }
@@ -257,25 +339,26 @@ Status BigQueryTableAccessor::ParseColumnValues(
   if (value.empty()) {
     return Status::OK();
   }
-  if (value["f"].isNull()) {
+  // Look up the fields once per row, as each lookup searches the object.
+  const Json::Value& fields = value["f"];
+  if (fields.isNull()) {
     return Status::OK();
   }
   int value_index = 0;
   for (const auto& schema_node : root_schema_node.schema_nodes) {
-    if (value["f"][value_index].isNull()) {
+    const Json::Value& field = fields[value_index];
+    if (field.isNull()) {
       value_index++;
       continue;
     }
 
     if (schema_node.type == ColumnType::kRecord) {
-      TF_RETURN_IF_ERROR(ParseColumnValues(value["f"][value_index]["v"],
-                                           schema_node, example));
+      TF_RETURN_IF_ERROR(ParseColumnValues(field["v"], schema_node, example));
     } else {
       // Append the column value only if user has requested the column.
       if (columns_.empty() ||
           columns_.find(schema_node.name) != columns_.end()) {
-        TF_RETURN_IF_ERROR(AppendValueToExample(schema_node.name,
-                                                value["f"][value_index]["v"],
+        TF_RETURN_IF_ERROR(AppendValueToExample(schema_node.name, field["v"],
                                                 schema_node.type, example));
       }
     }
@@ -350,6 +433,8 @@ Status BigQueryTableAccessor::AppendValueToExample(
   }
   auto& feature =
       (*example->mutable_features()->mutable_feature())[column_name];
+  // BigQuery sends all the values as strings.
+  const string value = column_value.asString();
 
   switch (type) {
     case BigQueryTableAccessor::ColumnType::kNone:
@@ -361,28 +446,23 @@ Status BigQueryTableAccessor::AppendValueToExample(
     case BigQueryTableAccessor::ColumnType::kDatetime:
     case BigQueryTableAccessor::ColumnType::kString:
     case BigQueryTableAccessor::ColumnType::kBytes:
-      feature.mutable_bytes_list()->add_value(column_value.asString());
+      feature.mutable_bytes_list()->add_value(value);
       break;
     case BigQueryTableAccessor::ColumnType::kBoolean:
-      feature.mutable_int64_list()->add_value(
-          column_value.asString() == "false" ? 0 : 1);
+      feature.mutable_int64_list()->add_value(value == "false" ? 0 : 1);
       break;
     case BigQueryTableAccessor::ColumnType::kInteger:
       int64 column_value_int64;
-      if (!strings::safe_strto64(column_value.asString().c_str(),
-                                 &column_value_int64)) {
-        return errors::Internal("Cannot convert value to integer ",
-                                column_value.asString().c_str());
+      if (!strings::safe_strto64(value.c_str(), &column_value_int64)) {
+        return errors::Internal("Cannot convert value to integer ", value);
       }
       feature.mutable_int64_list()->add_value(column_value_int64);
       break;
     case BigQueryTableAccessor::ColumnType::kFloat:
       // BigQuery float is actually a double.
       double column_value_double;
-      if (!strings::safe_strtod(column_value.asString().c_str(),
-                                &column_value_double)) {
-        return errors::Internal("Cannot convert value to double: ",
-                                column_value.asString().c_str());
+      if (!strings::safe_strtod(value.c_str(), &column_value_double)) {
+        return errors::Internal("Cannot convert value to double: ", value);
       }
       feature.mutable_float_list()->add_value(
           static_cast<float>(column_value_double));
@@ -23,8 +23,11 @@ limitations under the License.
 #include "tensorflow/contrib/cloud/kernels/bigquery_table_partition.pb.h"
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/cloud/google_auth_provider.h"
 #include "tensorflow/core/platform/cloud/http_request.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 
@@ -38,6 +41,8 @@ namespace tensorflow {
 ///  - It is possible for a table snapshot to go out-of-scope in the BigQuery
 ///    service while accessing the table if a very old timestamp is used. For
 ///    exact details, see 'Table Decorators' in BigQuery docs.
+///  - While the rows of a page are read, the next page of the partition is
+///    fetched and decoded on a background thread.
 class BigQueryTableAccessor {
  public:
   // Column types supported by BigQuery.
@@ -85,7 +90,7 @@ class BigQueryTableAccessor {
   /// \brief Returns total number of rows in the table.
   int64 total_num_rows() { return total_num_rows_; }
 
-  virtual ~BigQueryTableAccessor() {}
+  virtual ~BigQueryTableAccessor();
 
  private:
   friend class BigQueryTableAccessorTest;
@@ -100,6 +105,14 @@ class BigQueryTableAccessor {
     std::vector<SchemaNode> schema_nodes;
   };
 
+  // A page of rows read from BigQuery, decoded into examples.
+  struct Page {
+    std::vector<Example> rows;
+    // Number of rows of the page, at the front of rows.
+    int64 num_rows = 0;
+    string next_page_token;
+  };
+
   /// If nullptr is passed for http_request_factory and auth_provider the
   /// default production ones are used. This can be used by tests to override
   /// these two variables.
@@ -147,6 +160,22 @@ class BigQueryTableAccessor {
                               const BigQueryTableAccessor::ColumnType type,
                               Example* example);
 
+  /// \brief Reads up to max_results rows into page, starting at row
+  /// start_index, or at the page referenced by page_token if it isn't empty.
+  Status ReadPage(int64 start_index, const string& page_token,
+                  int64 max_results, Page* page);
+
+  /// \brief Makes the next page of the partition the buffered one, taking it
+  /// from the prefetch thread if it was prefetched.
+  Status ReadNextPage();
+
+  /// \brief Starts reading the page after the buffered one on the prefetch
+  /// thread, unless the partition ends before it.
+  void MaybePrefetchNextPage();
+
+  /// \brief Waits for the prefetch thread to be done with the page it reads.
+  void WaitForPrefetch(mutex_lock* lock) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
   /// \brief Resets internal counters for reading a partition.
   void Reset();
 
@@ -188,12 +217,26 @@ class BigQueryTableAccessor {
   // is invalid.
   int next_row_in_buffer_ = -1;
 
-  // This buffer holds next rows to improve performance. Its size will be
-  // based on how much buffering was requested.
-  std::vector<Example> row_buffer_;
+  // Maximum number of rows to read in one page.
+  const int64 row_buffer_size_;
 
-  // If next_page is set, it will used to read next batch of data.
-  string next_page_token_;
+  // This buffer holds the rows of the page being read. Its next_page_token
+  // is used to read the next page.
+  Page row_buffer_;
+
+  mutex mu_;
+  condition_variable prefetch_done_;
+
+  // Whether the prefetch thread is reading prefetched_page_.
+  bool prefetch_in_flight_ GUARDED_BY(mu_) = false;
+
+  // Whether prefetched_page_ holds the page after the buffered one.
+  bool has_prefetched_page_ GUARDED_BY(mu_) = false;
+
+  // The page after the buffered one, owned by the prefetch thread while
+  // prefetch_in_flight_ is set.
+  Page prefetched_page_;
+  Status prefetch_status_ GUARDED_BY(mu_);
 
   // A tree representing the schema for the underlying table.
   SchemaNode schema_root_;
@@ -201,6 +244,9 @@ class BigQueryTableAccessor {
   std::unique_ptr<AuthProvider> auth_provider_;
   std::unique_ptr<HttpRequest::Factory> http_request_factory_;
 
+  // Reads the next page ahead of time.
+  std::unique_ptr<thread::ThreadPool> prefetch_thread_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(BigQueryTableAccessor);
 };
 
@@ -491,6 +491,57 @@ TEST_F(BigQueryTableAccessorTest, SwitchingPartitionsTest) {
             2222);
 }
 
+TEST_F(BigQueryTableAccessorTest, SwitchingPartitionsWhilePrefetchingTest) {
+  requests_.emplace_back(new FakeHttpRequest(
+      "Uri: https://www.googleapis.com/bigquery/v2/projects/test-project/"
+      "datasets/test-dataset/tables/test-table/\n"
+      "Auth Token: fake_token\n",
+      kSampleSchema));
+  requests_.emplace_back(new FakeHttpRequest(
+      "Uri: https://www.googleapis.com/bigquery/v2/projects/test-project/"
+      "datasets/test-dataset/tables/test-table/data?maxResults=2&startIndex=0\n"
+      "Auth Token: fake_token\n",
+      kTestTwoRows));
+  // The page after the first one is prefetched, and then dropped when the
+  // partition changes.
+  requests_.emplace_back(new FakeHttpRequest(
+      "Uri: https://www.googleapis.com/bigquery/v2/projects/test-project/"
+      "datasets/test-dataset/tables/test-table/"
+      "data?maxResults=2&pageToken=next_page\n"
+      "Auth Token: fake_token\n",
+      kTestRowWithNulls));
+  requests_.emplace_back(new FakeHttpRequest(
+      "Uri: https://www.googleapis.com/bigquery/v2/projects/test-project/"
+      "datasets/test-dataset/tables/test-table/data?maxResults=2&startIndex=3\n"
+      "Auth Token: fake_token\n",
+      kTestRowWithNulls));
+
+  BigQueryTablePartition partition;
+  partition.set_start_index(0);
+  partition.set_end_index(-1);
+  TF_EXPECT_OK(CreateTableAccessor(kTestProject, kTestDataset, kTestTable, 1, 2,
+                                   {}, partition));
+
+  int64 row_id;
+  Example example;
+  TF_EXPECT_OK(accessor_->ReadRow(&row_id, &example));
+  EXPECT_EQ(0, row_id);
+  EXPECT_FALSE(accessor_->Done());
+  EXPECT_EQ(example.features().feature().at("int_field").int64_list().value(0),
+            1111);
+
+  partition.set_start_index(3);
+  TF_EXPECT_OK(accessor_->SetPartition(partition));
+  TF_EXPECT_OK(accessor_->ReadRow(&row_id, &example));
+  EXPECT_EQ(3, row_id);
+  EXPECT_TRUE(accessor_->Done());
+  Example expected_example;
+  ASSERT_TRUE(protobuf::TextFormat::ParseFromString(kTestExampleProtoWithNulls,
+                                                    &expected_example));
+  EXPECT_EQ(DeterministicSerialization(expected_example),
+            DeterministicSerialization(example));
+}
+
 TEST_F(BigQueryTableAccessorTest, EmptyPartitionTest) {
   requests_.emplace_back(new FakeHttpRequest(
       "Uri: https://www.googleapis.com/bigquery/v2/projects/test-project/"
@@ -27,10 +27,13 @@ else(tensorflow_BUILD_ALL_KERNELS)
      "${tensorflow_source_dir}/tensorflow/core/kernels/bounds_check.h"
      "${tensorflow_source_dir}/tensorflow/core/kernels/constant_op.h"
      "${tensorflow_source_dir}/tensorflow/core/kernels/constant_op.cc"
+     "${tensorflow_source_dir}/tensorflow/core/kernels/cpu_isa_dispatch.h"
+     "${tensorflow_source_dir}/tensorflow/core/kernels/cpu_isa_dispatch.cc"
      "${tensorflow_source_dir}/tensorflow/core/kernels/fill_functor.h"
      "${tensorflow_source_dir}/tensorflow/core/kernels/fill_functor.cc"
      "${tensorflow_source_dir}/tensorflow/core/kernels/matmul_op.h"
      "${tensorflow_source_dir}/tensorflow/core/kernels/matmul_op.cc"
+     "${tensorflow_source_dir}/tensorflow/core/kernels/matmul_op_isa.h"
      "${tensorflow_source_dir}/tensorflow/core/kernels/no_op.h"
      "${tensorflow_source_dir}/tensorflow/core/kernels/no_op.cc"
      "${tensorflow_source_dir}/tensorflow/core/kernels/sendrecv_ops.h"
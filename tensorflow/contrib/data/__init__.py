@@ -15,11 +15,14 @@
 """`tf.contrib.data.Dataset` API for input pipelines.
 
 @@Dataset
+@@DevicePrefetchIterator
 @@Iterator
 @@TFRecordDataset
 @@FixedLengthRecordDataset
+@@LMDBDataset
 @@TextLineDataset
 
+@@prefetch_to_device
 @@read_batch_features
 @@rejection_resample
 """
@@ -30,8 +33,11 @@ from __future__ import print_function
 
 # pylint: disable=unused-import
 from tensorflow.contrib.data.python.ops.dataset_ops import Dataset
+from tensorflow.contrib.data.python.ops.dataset_ops import DevicePrefetchIterator
 from tensorflow.contrib.data.python.ops.dataset_ops import FixedLengthRecordDataset
 from tensorflow.contrib.data.python.ops.dataset_ops import Iterator
+from tensorflow.contrib.data.python.ops.dataset_ops import LMDBDataset
+from tensorflow.contrib.data.python.ops.dataset_ops import prefetch_to_device
 from tensorflow.contrib.data.python.ops.dataset_ops import read_batch_features
 from tensorflow.contrib.data.python.ops.dataset_ops import rejection_resample
 from tensorflow.contrib.data.python.ops.dataset_ops import TextLineDataset
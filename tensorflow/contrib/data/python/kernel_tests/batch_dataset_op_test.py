@@ -271,6 +271,140 @@ class BatchDatasetTest(test.TestCase):
                                    "larger than the row shape"):
         sess.run(get_next)
 
+  def testMapAndBatchDataset(self):
+    """Test a dataset that maps a TF function across its input elements."""
+    # The pipeline is TensorSliceDataset -> RepeatDataset(count) ->
+    # MapAndBatchDataset(square_3, batch_size).
+    components = (np.arange(7),
+                  np.array([[1, 2, 3]]) * np.arange(7)[:, np.newaxis],
+                  np.array(37.0) * np.arange(7))
+
+    count = array_ops.placeholder(dtypes.int64, shape=[])
+    batch_size = array_ops.placeholder(dtypes.int64, shape=[])
+    num_threads = array_ops.placeholder(dtypes.int32, shape=[])
+    num_parallel_batches = array_ops.placeholder(dtypes.int64, shape=[])
+
+    def _map_fn(x, y, z):
+      return math_ops.square(x), math_ops.square(y), math_ops.square(z)
+
+    iterator = (dataset_ops.Dataset.from_tensor_slices(components)
+                .repeat(count)
+                .map_and_batch(_map_fn, batch_size, num_threads,
+                               num_parallel_batches)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    self.assertEqual([[None] + list(c.shape[1:]) for c in components],
+                     [t.shape.as_list() for t in get_next])
+
+    with self.test_session() as sess:
+      for threads, parallel_batches in [(1, 1), (4, 1), (4, 3), (16, 2)]:
+        # Batch of a finite input, where the batch_size does not
+        # divide the total number of elements.
+        sess.run(init_op, feed_dict={count: 14, batch_size: 8,
+                                     num_threads: threads,
+                                     num_parallel_batches: parallel_batches})
+
+        num_batches = int(math.ceil((14 * 7) / 8))
+        for i in range(num_batches):
+          result = sess.run(get_next)
+          num_elements = (8 if i < num_batches - 1 else (14 * 7) % 8)
+          for component, result_component in zip(components, result):
+            self.assertEqual(num_elements, len(result_component))
+            for j in range(num_elements):
+              self.assertAllEqual(component[(i*8 + j) % 7]**2,
+                                  result_component[j])
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+
+      # Batch of an empty input should fail straight away.
+      sess.run(init_op, feed_dict={count: 0, batch_size: 8, num_threads: 2,
+                                   num_parallel_batches: 2})
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+      # Empty batch should be an initialization time error.
+      with self.assertRaises(errors.InvalidArgumentError):
+        sess.run(init_op, feed_dict={count: 14, batch_size: 0, num_threads: 2,
+                                     num_parallel_batches: 2})
+
+  def testMapAndBatchDatasetPropagatesErrors(self):
+    iterator = (dataset_ops.Dataset.from_tensor_slices([1., 2., 0., 4.])
+                .map_and_batch(
+                    lambda x: array_ops.check_numerics(1. / x, "error"),
+                    batch_size=2, num_threads=2)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+      self.assertAllEqual([1., 0.5], sess.run(get_next))
+      # The batch containing the bad element is dropped.
+      with self.assertRaises(errors.InvalidArgumentError):
+        sess.run(get_next)
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testMapAndBatchDatasetShapeMismatch(self):
+    iterator = (dataset_ops.Dataset.range(4)
+                .map_and_batch(lambda x: array_ops.fill([x], x), batch_size=2)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+      with self.assertRaisesRegexp(errors.InvalidArgumentError,
+                                   "different shapes"):
+        sess.run(get_next)
+
+  def testBatchOfElementWiseMapIsVectorized(self):
+    components = (np.arange(10, dtype=np.int64),
+                  np.arange(30, dtype=np.float32).reshape(10, 3))
+    offset = constant_op.constant(2.0)
+
+    def _map_fn(x, y):
+      return x * x + 1, math_ops.maximum(y - offset, 0.0) / 2.0
+
+    dataset = dataset_ops.Dataset.from_tensor_slices(components).map(_map_fn)
+    self.assertTrue(dataset.vectorizable)
+    batched = dataset.batch(4)
+    self.assertIsInstance(batched, dataset_ops.MapDataset)
+    self.assertIsInstance(batched._input_dataset, dataset_ops.BatchDataset)
+    self.assertEqual([[None], [None, 3]],
+                     [s.as_list() for s in batched.output_shapes])
+
+    iterator = batched.make_one_shot_iterator()
+    get_next = iterator.get_next()
+    with self.test_session() as sess:
+      for start in range(0, 10, 4):
+        x, y = sess.run(get_next)
+        end = min(start + 4, 10)
+        self.assertAllEqual(components[0][start:end]**2 + 1, x)
+        self.assertAllClose(
+            np.maximum(components[1][start:end] - 2.0, 0.0) / 2.0, y)
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testBatchOfNonElementWiseMapIsNotVectorized(self):
+    components = np.arange(12, dtype=np.int64).reshape(4, 3)
+    map_fns = [
+        # Reduces the element.
+        math_ops.reduce_sum,
+        # Broadcasts the element against a non-scalar constant.
+        lambda x: x + constant_op.constant([[1], [2]], dtype=dtypes.int64),
+        # Returns a tensor that does not depend on the element.
+        lambda x: (x, constant_op.constant(1)),
+        # Uses an op that is not element-wise.
+        lambda x: string_ops.as_string(x),
+    ]
+    for map_fn in map_fns:
+      dataset = dataset_ops.Dataset.from_tensor_slices(components).map(map_fn)
+      self.assertFalse(dataset.vectorizable)
+      self.assertIsInstance(dataset.batch(2), dataset_ops.BatchDataset)
+
   def testUnbatchDataset(self):
     data = [math_ops.range(10) for _ in range(3)]
     data = dataset_ops.Dataset.from_tensor_slices(data)
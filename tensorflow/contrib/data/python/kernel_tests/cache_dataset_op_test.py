@@ -197,6 +197,34 @@ class FilesystemCacheDatasetTest(test.TestCase):
       self.assertAllEqual(elements, elements_itr1)
       self.assertAllEqual(elements, elements_itr2)
 
+  def testShardedCacheDataset(self):
+    components = (np.arange(7),
+                  np.array(["a", "bb", "", "ccc", "d", "ee", "f"]),
+                  np.array([[1.0, 2.0]]) * np.arange(7)[:, np.newaxis])
+    count_placeholder = array_ops.placeholder_with_default(
+        constant_op.constant(1, dtypes.int64), shape=[])
+
+    cache_dataset = (dataset_ops.Dataset.from_tensor_slices(components)
+                     .repeat(count_placeholder)
+                     .cache(self.cache_prefix, num_shards=3))
+    iterator = cache_dataset.make_initializable_iterator()
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      # The first iteration writes the cache, and each later iteration
+      # (with an empty upstream) reads it back.
+      for count in [1, 0, 0]:
+        sess.run(init_op, feed_dict={count_placeholder: count})
+        for i in range(7):
+          result = sess.run(get_next)
+          for component, result_component in zip(components, result):
+            self.assertAllEqual(component[i], result_component)
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+        self.assertTrue(
+            path.exists(self.cache_prefix + ".cache-00002-of-00003"))
+
 
 class MemoryCacheDatasetTest(test.TestCase):
 
@@ -324,5 +324,29 @@ class MapDatasetTest(test.TestCase):
       # Randomness is repeatable given same seed
       self.assertAllClose(random_values, random_values_2)
 
+  def testMapSharedIntermediateAndCapturedInput(self):
+    # `y` is consumed by several ops, so no kernel may update it in place.
+    offset = constant_op.constant(1.0)
+
+    def _map_fn(x):
+      y = x + offset
+      return y * y + y, x
+
+    components = np.arange(100, dtype=np.float32).reshape(10, 10)
+    iterator = (dataset_ops.Dataset.from_tensor_slices(components)
+                .map(_map_fn).make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+      for i in range(10):
+        result, x = sess.run(get_next)
+        y = components[i] + 1.0
+        self.assertAllClose(y * y + y, result)
+        self.assertAllEqual(components[i], x)
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
 if __name__ == "__main__":
   test.main()
@@ -0,0 +1,132 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the experimental input pipeline ops."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+import numpy as np
+
+from tensorflow.contrib.data.python.ops import dataset_ops
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
+from tensorflow.python.lib.io import python_io
+from tensorflow.python.ops import array_ops
+from tensorflow.python.platform import test
+from tensorflow.python.util import compat
+
+
+class ParallelInterleaveDatasetTest(test.TestCase):
+
+  def _repeatedElements(self, input_values, cycle_length, block_length,
+                        sloppy=False):
+    iterator = (
+        dataset_ops.Dataset.from_tensor_slices(
+            np.array(input_values, dtype=np.int64))
+        .parallel_interleave(
+            lambda x: dataset_ops.Dataset.from_tensors(x).repeat(x),
+            cycle_length, block_length, sloppy)
+        .make_initializable_iterator())
+    get_next = iterator.get_next()
+
+    results = []
+    with self.test_session() as sess:
+      sess.run(iterator.initializer)
+      while True:
+        try:
+          results.append(sess.run(get_next))
+        except errors.OutOfRangeError:
+          break
+    return results
+
+  def testInterleaveOrder(self):
+    # When the dataset for 4 is exhausted, its slot is reopened with the
+    # dataset for 6, which is first read on the following turn.
+    self.assertEqual([4, 5, 4, 5, 4, 5, 4, 5, 5, 6, 6, 6, 6, 6, 6],
+                     self._repeatedElements([4, 5, 6], cycle_length=2,
+                                            block_length=1))
+    self.assertEqual([4, 4, 5, 5, 4, 4, 5, 5, 5, 6, 6, 6, 6, 6, 6],
+                     self._repeatedElements([4, 5, 6], cycle_length=2,
+                                            block_length=2))
+    # A cycle longer than the input.
+    self.assertEqual([1, 2, 3, 2, 3, 3],
+                     self._repeatedElements([1, 2, 3], cycle_length=5,
+                                            block_length=1))
+
+  def testSloppyInterleave(self):
+    for cycle_length in [1, 2, 3]:
+      self.assertEqual(
+          [1, 2, 2, 3, 3, 3, 4, 4, 4, 4],
+          sorted(self._repeatedElements([1, 2, 3, 4],
+                                        cycle_length=cycle_length,
+                                        block_length=2, sloppy=True)))
+
+  def testEmptyInput(self):
+    self.assertEqual([], self._repeatedElements([0, 0], cycle_length=2,
+                                                block_length=1))
+
+  def testInterleaveTFRecordFiles(self):
+    num_files = 3
+    num_records = 5
+    filenames = []
+    for i in range(num_files):
+      fn = os.path.join(self.get_temp_dir(), "tf_record.%d.txt" % i)
+      filenames.append(fn)
+      writer = python_io.TFRecordWriter(fn)
+      for j in range(num_records):
+        writer.write(compat.as_bytes("Record %d of file %d" % (j, i)))
+      writer.close()
+
+    iterator = (
+        dataset_ops.Dataset.from_tensor_slices(filenames)
+        .parallel_interleave(dataset_ops.TFRecordDataset,
+                             cycle_length=num_files,
+                             buffer_output_elements=2)
+        .make_initializable_iterator())
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(iterator.initializer)
+      for j in range(num_records):
+        for i in range(num_files):
+          self.assertEqual(compat.as_bytes("Record %d of file %d" % (j, i)),
+                           sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testInvalidArguments(self):
+    cycle_length_t = array_ops.placeholder(dtypes.int64, shape=[])
+    block_length_t = array_ops.placeholder(dtypes.int64, shape=[])
+    iterator = (
+        dataset_ops.Dataset.range(10)
+        .parallel_interleave(dataset_ops.Dataset.from_tensors,
+                             cycle_length_t, block_length_t)
+        .make_initializable_iterator())
+
+    with self.test_session() as sess:
+      with self.assertRaisesRegexp(errors.InvalidArgumentError,
+                                   "cycle_length"):
+        sess.run(iterator.initializer,
+                 feed_dict={cycle_length_t: 0, block_length_t: 1})
+      with self.assertRaisesRegexp(errors.InvalidArgumentError,
+                                   "block_length"):
+        sess.run(iterator.initializer,
+                 feed_dict={cycle_length_t: 1, block_length_t: 0})
+
+
+if __name__ == "__main__":
+  test.main()
@@ -0,0 +1,120 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the experimental input pipeline ops."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from tensorflow.contrib.data.python.ops import dataset_ops
+from tensorflow.core.example import example_pb2
+from tensorflow.core.example import feature_pb2
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import parsing_ops
+from tensorflow.python.platform import test
+
+
+class ParseExampleDatasetTest(test.TestCase):
+
+  def _serializedExamples(self, num_examples):
+    serialized = []
+    for i in range(num_examples):
+      example = example_pb2.Example(features=feature_pb2.Features(feature={
+          "label": feature_pb2.Feature(
+              int64_list=feature_pb2.Int64List(value=[i])),
+          "words": feature_pb2.Feature(
+              bytes_list=feature_pb2.BytesList(
+                  value=[("w%d" % j).encode() for j in range(i)])),
+      }))
+      serialized.append(example.SerializeToString())
+    return serialized
+
+  def testParseExampleDataset(self):
+    features = {
+        "label": parsing_ops.FixedLenFeature([], dtypes.int64),
+        "missing": parsing_ops.FixedLenFeature([2], dtypes.float32,
+                                               default_value=[1.0, 2.0]),
+        "words": parsing_ops.VarLenFeature(dtypes.string),
+    }
+    num_parallel_calls_t = array_ops.placeholder(dtypes.int64, shape=[])
+
+    iterator = (dataset_ops.Dataset.from_tensor_slices(
+        self._serializedExamples(5))
+                .batch(2)
+                .parse_example(features, num_parallel_calls_t)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    self.assertEqual([None], get_next["label"].shape.as_list())
+    self.assertEqual([None, 2], get_next["missing"].shape.as_list())
+    self.assertEqual(dtypes.string, get_next["words"][1].dtype)
+
+    with self.test_session() as sess:
+      for num_parallel_calls in [1, 2, 4]:
+        sess.run(init_op, feed_dict={num_parallel_calls_t: num_parallel_calls})
+        for i in range(3):
+          labels = list(range(2 * i, min(2 * i + 2, 5)))
+          result = sess.run(get_next)
+          self.assertAllEqual(labels, result["label"])
+          self.assertAllEqual([[1.0, 2.0]] * len(labels), result["missing"])
+          indices, values, dense_shape = result["words"]
+          self.assertAllEqual(
+              [[b, j] for b, l in enumerate(labels) for j in range(l)],
+              indices)
+          self.assertAllEqual(
+              [("w%d" % j).encode() for l in labels for j in range(l)], values)
+          self.assertAllEqual([len(labels), max(labels)], dense_shape)
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+
+  def testParseExampleDatasetPropagatesErrors(self):
+    features = {"label": parsing_ops.FixedLenFeature([], dtypes.int64)}
+    iterator = (dataset_ops.Dataset.from_tensor_slices(
+        [[b"not an example"]])
+                .parse_example(features)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+      with self.assertRaises(errors.InvalidArgumentError):
+        sess.run(get_next)
+
+  def testInvalidNumParallelCalls(self):
+    features = {"label": parsing_ops.FixedLenFeature([], dtypes.int64)}
+    num_parallel_calls_t = array_ops.placeholder(dtypes.int64, shape=[])
+    iterator = (dataset_ops.Dataset.from_tensor_slices(
+        self._serializedExamples(4))
+                .batch(2)
+                .parse_example(features, num_parallel_calls_t)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+
+    with self.test_session() as sess:
+      with self.assertRaisesRegexp(errors.InvalidArgumentError,
+                                   "num_parallel_calls"):
+        sess.run(init_op, feed_dict={num_parallel_calls_t: 0})
+
+  def testRequiresStringInput(self):
+    features = {"label": parsing_ops.FixedLenFeature([], dtypes.int64)}
+    with self.assertRaises(TypeError):
+      dataset_ops.Dataset.range(10).batch(2).parse_example(features)
+
+
+if __name__ == "__main__":
+  test.main()
@@ -0,0 +1,255 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the experimental input pipeline ops."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import threading
+import time
+
+import numpy as np
+
+from tensorflow.contrib.data.python.ops import dataset_ops
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
+from tensorflow.python.ops import script_ops
+from tensorflow.python.platform import test
+from tensorflow.python.training import coordinator
+from tensorflow.python.training import queue_runner
+
+
+class PrefetchDatasetTest(test.TestCase):
+
+  def testPrefetchDataset(self):
+    components = (np.arange(7),
+                  np.array([[1, 2, 3]]) * np.arange(7)[:, np.newaxis],
+                  np.array(37.0) * np.arange(7))
+    buffer_size_t = array_ops.placeholder(dtypes.int64, shape=[])
+
+    iterator = (dataset_ops.Dataset.from_tensor_slices(components)
+                .map(lambda x, y, z: (x, math_ops.square(y), z))
+                .batch(2)
+                .prefetch(buffer_size_t)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    self.assertEqual([[None] + list(c.shape[1:]) for c in components],
+                     [t.shape.as_list() for t in get_next])
+
+    with self.test_session() as sess:
+      for buffer_size in [1, 2, 10]:
+        sess.run(init_op, feed_dict={buffer_size_t: buffer_size})
+        for i in range(3):
+          result = sess.run(get_next)
+          for component, result_component in zip(components, result):
+            expected = component[2 * i:2 * i + 2]
+            if component.ndim == 2:
+              expected = np.square(expected)
+            self.assertAllEqual(expected, result_component)
+        result = sess.run(get_next)
+        self.assertAllEqual([6], result[0])
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+
+  def testPrefetchPropagatesErrors(self):
+    iterator = (dataset_ops.Dataset.from_tensor_slices([1., 2., 0., 4.])
+                .map(lambda x: array_ops.check_numerics(1. / x, "error"))
+                .prefetch(2)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+      self.assertEqual(1., sess.run(get_next))
+      self.assertEqual(0.5, sess.run(get_next))
+      with self.assertRaises(errors.InvalidArgumentError):
+        sess.run(get_next)
+      self.assertEqual(0.25, sess.run(get_next))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+  def testPrefetchConcurrentGetNext(self):
+    iterator = (dataset_ops.Dataset.range(100)
+                .prefetch(1)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+      results = []
+      results_lock = threading.Lock()
+
+      def consume():
+        while True:
+          try:
+            value = sess.run(get_next)
+          except errors.OutOfRangeError:
+            return
+          with results_lock:
+            results.append(value)
+
+      threads = [self.checkedThread(target=consume) for _ in range(4)]
+      for t in threads:
+        t.start()
+      for t in threads:
+        t.join()
+      self.assertAllEqual(list(range(100)), sorted(results))
+
+  def testPrefetchEndOfSequenceReachesQueuedCalls(self):
+    produce = threading.Event()
+
+    def wait_and_return(x):
+      produce.wait()
+      return x
+
+    iterator = (dataset_ops.Dataset.range(1)
+                .map(lambda x: script_ops.py_func(
+                    wait_and_return, [x], dtypes.int64, stateful=False))
+                .prefetch(1)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+      results = []
+      results_lock = threading.Lock()
+
+      def consume():
+        try:
+          value = sess.run(get_next)
+        except errors.OutOfRangeError:
+          value = None
+        with results_lock:
+          results.append(value)
+
+      # The calls wait for the prefetch thread, which is blocked in the
+      # input until `produce` is set.
+      threads = [self.checkedThread(target=consume) for _ in range(3)]
+      for t in threads:
+        t.start()
+      time.sleep(0.5)
+      produce.set()
+      for t in threads:
+        t.join()
+      self.assertEqual(1, results.count(0))
+      self.assertEqual(2, results.count(None))
+
+  def testPrefetchDisposeCancelsQueuedCalls(self):
+    produce = threading.Event()
+
+    def wait_and_return(x):
+      produce.wait()
+      return x
+
+    iterator = (dataset_ops.Dataset.range(10)
+                .map(lambda x: script_ops.py_func(
+                    wait_and_return, [x], dtypes.int64, stateful=False))
+                .prefetch(1)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+    dispose_op = iterator.dispose_op()
+
+    with self.test_session() as sess:
+      sess.run(init_op)
+
+      def consume():
+        with self.assertRaises(errors.CancelledError):
+          sess.run(get_next)
+
+      consumer = self.checkedThread(target=consume)
+      consumer.start()
+      time.sleep(0.5)
+      # Destroying the iterator completes the queued call right away, and
+      # then waits for the prefetch thread to leave the input.
+      disposer = self.checkedThread(target=lambda: sess.run(dispose_op))
+      disposer.start()
+      consumer.join()
+      produce.set()
+      disposer.join()
+      with self.assertRaises(errors.FailedPreconditionError):
+        sess.run(get_next)
+
+  def testPrefetchGetNextMany(self):
+    for num_threads in [None, 2]:
+      iterator = (dataset_ops.Dataset.range(10)
+                  .map(lambda x: x * x, num_threads=num_threads)
+                  .prefetch(3)
+                  .batch(4)
+                  .make_initializable_iterator())
+      init_op = iterator.initializer
+      get_next = iterator.get_next()
+
+      with self.test_session() as sess:
+        sess.run(init_op)
+        self.assertAllEqual([0, 1, 4, 9], sess.run(get_next))
+        self.assertAllEqual([16, 25, 36, 49], sess.run(get_next))
+        self.assertAllEqual([64, 81], sess.run(get_next))
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+
+  def testInvalidBufferSize(self):
+    buffer_size_t = array_ops.placeholder(dtypes.int64, shape=[])
+    iterator = (dataset_ops.Dataset.range(10).prefetch(buffer_size_t)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+
+    with self.test_session() as sess:
+      with self.assertRaisesRegexp(errors.InvalidArgumentError, "buffer_size"):
+        sess.run(init_op, feed_dict={buffer_size_t: 0})
+
+  def testPrefetchToDevice(self):
+    components = (np.arange(10), np.array(37.0) * np.arange(10))
+    iterator = (dataset_ops.Dataset.from_tensor_slices(components)
+                .batch(3)
+                .make_one_shot_iterator())
+    prefetcher = dataset_ops.prefetch_to_device(
+        iterator, test.gpu_device_name(), buffer_size=2)
+    get_next = prefetcher.get_next()
+
+    self.assertEqual([[None], [None]], [t.shape.as_list() for t in get_next])
+    self.assertEqual(
+        [prefetcher.queue_runner],
+        ops.get_collection(ops.GraphKeys.QUEUE_RUNNERS))
+
+    with self.test_session(use_gpu=True) as sess:
+      coord = coordinator.Coordinator()
+      threads = queue_runner.start_queue_runners(sess, coord=coord)
+      for i in range(4):
+        result = sess.run(get_next)
+        for component, result_component in zip(components, result):
+          self.assertAllEqual(component[3 * i:3 * i + 3], result_component)
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+      coord.request_stop()
+      coord.join(threads)
+
+  def testPrefetchToDeviceRejectsStrings(self):
+    iterator = (dataset_ops.Dataset.from_tensors("a")
+                .make_one_shot_iterator())
+    with self.assertRaisesRegexp(TypeError, "tf.string"):
+      dataset_ops.prefetch_to_device(iterator, "/cpu:0")
+
+
+if __name__ == "__main__":
+  test.main()
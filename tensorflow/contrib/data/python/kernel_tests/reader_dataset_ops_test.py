@@ -19,6 +19,7 @@ from __future__ import print_function
 
 import gzip
 import os
+import shutil
 import zlib
 
 from tensorflow.contrib.data.python.ops import dataset_ops
@@ -336,6 +337,43 @@ class TFRecordDatasetTest(test.TestCase):
       with self.assertRaises(errors.OutOfRangeError):
         sess.run(self.get_next)
 
+  def testReadWithBuffer(self):
+    for buffer_size in [1, 10, 1024 * 1024]:
+      dataset = dataset_ops.TFRecordDataset(
+          self.test_filenames, buffer_size=buffer_size)
+      iterator = dataset.make_one_shot_iterator()
+      get_next = iterator.get_next()
+      with self.test_session() as sess:
+        for j in range(self._num_files):
+          for i in range(self._num_records):
+            self.assertAllEqual(self._record(j, i), sess.run(get_next))
+        with self.assertRaises(errors.OutOfRangeError):
+          sess.run(get_next)
+
+  def testReadWithoutVerifyingChecksums(self):
+    # Corrupt the last byte of the data of the first record, which is
+    # followed by its 4-byte data checksum.
+    with open(self.test_filenames[0], "rb") as f:
+      contents = bytearray(f.read())
+    record_length = len(self._record(0, 0))
+    contents[12 + record_length - 1] ^= 1
+    corrupt_filename = os.path.join(self.get_temp_dir(), "corrupt.tfrecord")
+    with open(corrupt_filename, "wb") as f:
+      f.write(contents)
+
+    with self.test_session() as sess:
+      get_next = dataset_ops.TFRecordDataset(
+          [corrupt_filename]).make_one_shot_iterator().get_next()
+      with self.assertRaises(errors.DataLossError):
+        sess.run(get_next)
+
+      get_next = dataset_ops.TFRecordDataset(
+          [corrupt_filename],
+          verify_checksums=False).make_one_shot_iterator().get_next()
+      self.assertEqual(record_length, len(sess.run(get_next)))
+      for i in range(1, self._num_records):
+        self.assertAllEqual(self._record(0, i), sess.run(get_next))
+
 
 class ReadBatchFeaturesTest(test.TestCase):
 
@@ -521,5 +559,65 @@ class ReadBatchFeaturesTest(test.TestCase):
         sess.run(next_element)
 
 
+class LMDBDatasetTest(test.TestCase):
+
+  def setUp(self):
+    super(LMDBDatasetTest, self).setUp()
+    # Copy database out because we need the path to be writable to use locks.
+    path = os.path.join("tensorflow", "core", "lib", "lmdb", "testdata",
+                        "data.mdb")
+    self.db_path = os.path.join(self.get_temp_dir(), "data.mdb")
+    shutil.copy(path, self.db_path)
+
+  def _assertReadsBatches(self, dataset, batches):
+    iterator = dataset.make_one_shot_iterator()
+    next_element = iterator.get_next()
+    with self.test_session() as sess:
+      for batch in batches:
+        keys, values = sess.run(next_element)
+        self.assertAllEqual([compat.as_bytes(str(i)) for i in batch], keys)
+        self.assertAllEqual(
+            [compat.as_bytes(chr(ord("a") + i)) for i in batch], values)
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(next_element)
+
+  def testReadBatches(self):
+    dataset = dataset_ops.LMDBDataset(self.db_path, batch_size=3)
+    self.assertEqual((dtypes.string, dtypes.string), dataset.output_types)
+    self._assertReadsBatches(dataset, [[0, 1, 2], [3, 4, 5], [6, 7, 8], [9]])
+
+  def testReadKeyRange(self):
+    dataset = dataset_ops.LMDBDataset(
+        self.db_path, start_key="3", end_key="7", batch_size=2)
+    self._assertReadsBatches(dataset, [[3, 4], [5, 6]])
+
+  def testReadOpenEndedKeyRanges(self):
+    self._assertReadsBatches(
+        dataset_ops.LMDBDataset(self.db_path, end_key="2"), [[0, 1]])
+    self._assertReadsBatches(
+        dataset_ops.LMDBDataset(self.db_path, start_key="8"), [[8, 9]])
+
+  def testBatchesDoNotSpanFiles(self):
+    dataset = dataset_ops.LMDBDataset(
+        [self.db_path, self.db_path], start_key="6", batch_size=3)
+    self._assertReadsBatches(dataset, [[6, 7, 8], [9], [6, 7, 8], [9]])
+
+  def testReadMissingFile(self):
+    dataset = dataset_ops.LMDBDataset(
+        os.path.join(self.get_temp_dir(), "missing.mdb"))
+    iterator = dataset.make_one_shot_iterator()
+    next_element = iterator.get_next()
+    with self.test_session() as sess:
+      with self.assertRaises(errors.InternalError):
+        sess.run(next_element)
+
+  def testInvalidBatchSize(self):
+    dataset = dataset_ops.LMDBDataset(self.db_path, batch_size=0)
+    iterator = dataset.make_initializable_iterator()
+    with self.test_session() as sess:
+      with self.assertRaises(errors.InvalidArgumentError):
+        sess.run(iterator.initializer)
+
+
 if __name__ == "__main__":
   test.main()
@@ -147,6 +147,76 @@ class ShuffleDatasetTest(test.TestCase):
     for i in range(5):
       self.assertEqual(10, counts[i])
 
+  def testShuffleAndRepeat(self):
+    components = np.arange(10)
+    count_placeholder = array_ops.placeholder(dtypes.int64, shape=[])
+    buffer_size_placeholder = array_ops.placeholder(dtypes.int64, shape=[])
+    seed_placeholder = array_ops.placeholder(dtypes.int64, shape=[])
+
+    iterator = (dataset_ops.Dataset.from_tensor_slices(components)
+                .shuffle_and_repeat(buffer_size_placeholder, count_placeholder,
+                                    seed_placeholder)
+                .make_initializable_iterator())
+    init_op = iterator.initializer
+    get_next = iterator.get_next()
+
+    def run_to_end(sess):
+      elements = []
+      while True:
+        try:
+          elements.append(sess.run(get_next))
+        except errors.OutOfRangeError:
+          return elements
+
+    with self.test_session() as sess:
+      # Every element is produced once per repetition, regardless of the
+      # size of the buffer.
+      for buffer_size in [1, 3, 10, 100]:
+        sess.run(init_op, feed_dict={buffer_size_placeholder: buffer_size,
+                                     count_placeholder: 3,
+                                     seed_placeholder: 37})
+        elements = run_to_end(sess)
+        self.assertAllEqual(sorted(list(components) * 3), sorted(elements))
+        if buffer_size == 1:
+          self.assertAllEqual(list(components) * 3, elements)
+
+      # The same seed gives the same sequence.
+      sess.run(init_op, feed_dict={buffer_size_placeholder: 5,
+                                   count_placeholder: 3,
+                                   seed_placeholder: 37})
+      shuffled_elements = run_to_end(sess)
+      sess.run(init_op, feed_dict={buffer_size_placeholder: 5,
+                                   count_placeholder: 3,
+                                   seed_placeholder: 37})
+      self.assertEqual(shuffled_elements, run_to_end(sess))
+
+      # Zero repetitions give an empty dataset.
+      sess.run(init_op, feed_dict={buffer_size_placeholder: 5,
+                                   count_placeholder: 0,
+                                   seed_placeholder: 37})
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
+      # Infinite repetition.
+      sess.run(init_op, feed_dict={buffer_size_placeholder: 5,
+                                   count_placeholder: -1,
+                                   seed_placeholder: 37})
+      counts = collections.defaultdict(lambda: 0)
+      for _ in range(100):
+        counts[sess.run(get_next)] += 1
+      self.assertEqual(100, sum(counts.values()))
+      self.assertEqual(set(components), set(counts.keys()))
+
+  def testShuffleAndRepeatEmptyDataset(self):
+    # Repeating an empty dataset indefinitely must not loop forever.
+    iterator = (dataset_ops.Dataset.range(0).shuffle_and_repeat(5)
+                .make_one_shot_iterator())
+    get_next = iterator.get_next()
+
+    with self.test_session() as sess:
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(get_next)
+
 
 if __name__ == "__main__":
   test.main()
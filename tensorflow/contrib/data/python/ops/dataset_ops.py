@@ -32,6 +32,7 @@ from tensorflow.python.framework import tensor_shape
 from tensorflow.python.framework import tensor_util
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import control_flow_ops
+from tensorflow.python.ops import data_flow_ops
 from tensorflow.python.ops import gen_dataset_ops
 from tensorflow.python.ops import gen_io_ops
 from tensorflow.python.ops import logging_ops
@@ -40,6 +41,7 @@ from tensorflow.python.ops import parsing_ops
 from tensorflow.python.ops import random_ops
 from tensorflow.python.ops import resource_variable_ops
 from tensorflow.python.platform import gfile
+from tensorflow.python.training import queue_runner
 
 
 class Iterator(object):
@@ -282,6 +284,122 @@ class Iterator(object):
     return self._output_types
 
 
+def prefetch_to_device(iterator, device, buffer_size=1):
+  """Prefetches the elements of `iterator` into the memory of `device`.
+
+  The elements are copied to `device`, typically a GPU, ahead of time, by a
+  `tf.train.QueueRunner` that is added to the `tf.GraphKeys.QUEUE_RUNNERS`
+  collection. It starts with `tf.train.start_queue_runners()`, or when a
+  `tf.train.MonitoredSession` is created. The copies run on the stream that
+  the device dedicates to host-to-device copies, from pinned staging buffers,
+  so that the steps that consume the elements don't wait for them.
+
+  For example:
+
+  ```python
+  iterator = dataset.make_one_shot_iterator()
+  images, labels = tf.contrib.data.prefetch_to_device(
+      iterator, "/gpu:0").get_next()
+  ```
+
+  Args:
+    iterator: An `Iterator` whose elements don't contain `tf.string`
+      components.
+    device: The device to copy the elements to.
+    buffer_size: (Optional.) The number of elements to keep on `device`.
+
+  Returns:
+    A `DevicePrefetchIterator`.
+  """
+  return DevicePrefetchIterator(iterator, device, buffer_size)
+
+
+class DevicePrefetchIterator(object):
+  """Gets the elements of an `Iterator` from a buffer on a device.
+
+  See `prefetch_to_device()`.
+  """
+
+  def __init__(self, iterator, device, buffer_size):
+    """Creates a new device prefetch iterator.
+
+    Args:
+      iterator: An `Iterator` whose elements don't contain `tf.string`
+        components.
+      device: The device to copy the elements to.
+      buffer_size: The number of elements to keep on `device`.
+
+    Raises:
+      TypeError: If an element of `iterator` contains a `tf.string` component.
+      ValueError: If `buffer_size` is not positive.
+    """
+    if dtypes.string in nest.flatten(iterator.output_types):
+      raise TypeError("Elements with tf.string components can't be copied to "
+                      "a device, got output types %r." %
+                      (iterator.output_types,))
+    if buffer_size < 1:
+      raise ValueError("buffer_size must be positive, got %d." % buffer_size)
+    self._output_types = iterator.output_types
+    self._output_shapes = iterator.output_shapes
+    self._device = device
+    # The iterator stays on its own device, so that the executor copies its
+    # outputs to `device`.
+    next_element = iterator.get_next()
+    with ops.device(device):
+      self._staging_area = data_flow_ops.StagingArea(
+          nest.flatten(self._output_types),
+          shapes=nest.flatten(self._output_shapes),
+          capacity=buffer_size)
+      prefetch_op = self._staging_area.put(nest.flatten(next_element))
+    self._queue_runner = queue_runner.QueueRunner(self._staging_area,
+                                                  [prefetch_op])
+    queue_runner.add_queue_runner(self._queue_runner)
+
+  def get_next(self, name=None):
+    """Returns a nested structure of `tf.Tensor`s containing the next element.
+
+    The tensors are on the device given to `prefetch_to_device()`, and the op
+    fails with `tf.errors.OutOfRangeError` once the elements of the iterator
+    are exhausted.
+
+    Args:
+      name: (Optional.) A name for the created operation.
+
+    Returns:
+      A nested structure of `tf.Tensor` objects.
+    """
+    with ops.device(self._device):
+      flat_element = self._staging_area.get(name=name)
+    if not isinstance(flat_element, list):
+      flat_element = [flat_element]
+    return nest.pack_sequence_as(self._output_types, flat_element)
+
+  @property
+  def queue_runner(self):
+    """The `tf.train.QueueRunner` that copies the elements to the device."""
+    return self._queue_runner
+
+  @property
+  def output_shapes(self):
+    """Returns the shape of each component of an element of this iterator.
+
+    Returns:
+      A nested structure of `tf.TensorShape` objects corresponding to each
+      component of an element of this iterator.
+    """
+    return self._output_shapes
+
+  @property
+  def output_types(self):
+    """Returns the type of each component of an element of this iterator.
+
+    Returns:
+      A nested structure of `tf.DType` objects corresponding to each component
+      of an element of this iterator.
+    """
+    return self._output_types
+
+
 def _calculate_acceptance_probs(initial_probs, target_probs):
   """Calculate the per-class acceptance rates.
 
@@ -681,18 +799,67 @@ class Dataset(object):
     """
     return ShuffleDataset(self, buffer_size, seed)
 
-  def cache(self, filename=""):
+  def shuffle_and_repeat(self, buffer_size, count=None, seed=None):
+    """Shuffles and repeats the elements of this dataset.
+
+    This is equivalent to `dataset.repeat(count).shuffle(buffer_size, seed)`,
+    but it does not destroy and refill the shuffle buffer at the end of each
+    repetition, as `dataset.shuffle(buffer_size, seed).repeat(count)` does.
+    As a consequence, elements from consecutive repetitions may be mixed.
+
+    Args:
+      buffer_size: A `tf.int64` scalar `tf.Tensor`, representing the
+        number of elements from this dataset from which the new
+        dataset will sample.
+      count: (Optional.) A `tf.int64` scalar `tf.Tensor`, representing the
+        number of times the elements of this dataset should be repeated. The
+        default behavior (if `count` is `None` or `-1`) is for the elements to
+        be repeated indefinitely.
+      seed: (Optional.) A `tf.int64` scalar `tf.Tensor`, representing the
+        random seed that will be used to create the distribution. See
+        @{tf.set_random_seed} for behavior.
+
+    Returns:
+      A `Dataset`.
+    """
+    return ShuffleAndRepeatDataset(self, buffer_size, count, seed)
+
+  def cache(self, filename="", num_shards=1):
     """Caches the elements in this dataset.
 
+    When caching to the filesystem, the first iteration writes the elements to
+    `num_shards` files, each on its own thread. Later iterations map those
+    files into memory, and produce tensors that alias the mapped files instead
+    of copying their contents.
+
     Args:
       filename: A `tf.string` scalar `tf.Tensor`, representing the name of a
         directory on the filesystem to use for caching tensors in this Dataset.
         If a filename is not provided, the dataset will be cached in memory.
+      num_shards: (Optional.) A Python integer, representing the number of
+        files that the cache is written to in parallel. Ignored when caching
+        in memory.
 
     Returns:
       A `Dataset`.
     """
-    return CacheDataset(self, filename)
+    return CacheDataset(self, filename, num_shards)
+
+  def prefetch(self, buffer_size):
+    """Creates a `Dataset` that prefetches elements from this dataset.
+
+    An iterator over the new dataset reads ahead from this dataset on a
+    background thread, so that producing elements (e.g. reading and
+    decoding input) overlaps with the computation that consumes them.
+
+    Args:
+      buffer_size: A `tf.int64` scalar `tf.Tensor`, representing the
+        maximum number of elements that will be buffered when prefetching.
+
+    Returns:
+      A `Dataset`.
+    """
+    return PrefetchDataset(self, buffer_size)
 
   def take(self, count):
     """Creates a `Dataset` with at most `count` elements from this dataset.
@@ -726,6 +893,12 @@ class Dataset(object):
   def batch(self, batch_size):
     """Combines consecutive elements of this dataset into batches.
 
+    When this dataset is the result of `Dataset.map()` with a function made
+    only of element-wise ops on fixed-shape elements (see
+    `MapDataset.vectorizable`), the map is moved after the batching, so
+    that the function runs once per batch rather than once per element.
+    This produces the same elements.
+
     Args:
       batch_size: A `tf.int64` scalar `tf.Tensor`, representing the number of
         consecutive elements of this dataset to combine in a single batch.
@@ -733,6 +906,9 @@ class Dataset(object):
     Returns:
       A `Dataset`.
     """
+    if isinstance(self, MapDataset) and self.vectorizable:
+      return self._input_dataset.batch(batch_size).map(
+          self._py_map_func, self._num_threads, self._output_buffer_size)
     return BatchDataset(self, batch_size)
 
   def padded_batch(self, batch_size, padded_shapes, padding_values=None):
@@ -806,6 +982,39 @@ class Dataset(object):
     """
     return DenseToSparseBatchDataset(self, batch_size, row_shape)
 
+  def parse_example(self, features, num_parallel_calls=1):
+    """Parses batches of serialized `Example` protos in this dataset.
+
+    Each element of this dataset must be a `tf.string` vector of
+    serialized `Example` protos, such as the result of `Dataset.batch()`
+    on a dataset of records. Each batch is parsed without calling a
+    function, as if by `tf.parse_example()`, and the parsing work for a
+    batch is divided between `num_parallel_calls` threads. For example:
+
+    ```python
+    dataset = (Dataset.from_tensor_slices(filenames)
+               .flat_map(TFRecordDataset)
+               .batch(32)
+               .parse_example({"label": tf.FixedLenFeature([], tf.int64),
+                               "words": tf.VarLenFeature(tf.string)}))
+    ```
+
+    Each element of the resulting dataset is a `dict` mapping each key
+    in `features` to a `tf.Tensor` (for a `FixedLenFeature` or
+    `FixedLenSequenceFeature`), or to an `(indices, values, dense_shape)`
+    tuple for a `VarLenFeature`, which comprise a `tf.SparseTensor`.
+
+    Args:
+      features: A `dict` mapping feature keys to `FixedLenFeature`,
+        `FixedLenSequenceFeature`, or `VarLenFeature` values.
+      num_parallel_calls: A `tf.int64` scalar `tf.Tensor`, representing
+        the number of threads that parse each batch.
+
+    Returns:
+      A `Dataset`.
+    """
+    return ParseExampleDataset(self, features, num_parallel_calls)
+
   def group_by_window(self, key_func, reduce_func, window_size):
     """Performs a windowed "group-by" operation on this dataset.
 
@@ -850,6 +1059,35 @@ class Dataset(object):
     """
     return MapDataset(self, map_func, num_threads, output_buffer_size)
 
+  def map_and_batch(self, map_func, batch_size, num_threads=None,
+                    num_parallel_batches=None):
+    """Maps `map_func` across this dataset, and batches the results.
+
+    This produces the same elements as
+    `dataset.map(map_func, num_threads).batch(batch_size)`, but each result
+    of `map_func` is copied into its slice of the batch on the thread that
+    computed it, instead of being buffered and then copied again when the
+    batch is formed.
+
+    Args:
+      map_func: A function mapping a nested structure of tensors (having
+        shapes and types defined by `self.output_shapes` and
+       `self.output_types`) to another nested structure of tensors.
+      batch_size: A `tf.int64` scalar `tf.Tensor`, representing the number of
+        consecutive elements of this dataset to combine in a single batch.
+      num_threads: (Optional.) A `tf.int32` scalar `tf.Tensor`, representing
+        the number of threads to use for processing elements in parallel.
+        Defaults to 1.
+      num_parallel_batches: (Optional.) A `tf.int64` scalar `tf.Tensor`,
+        representing the number of batches to fill (and buffer) concurrently.
+        Defaults to 1.
+
+    Returns:
+      A `Dataset`.
+    """
+    return MapAndBatchDataset(self, map_func, batch_size, num_threads,
+                              num_parallel_batches)
+
   def flat_map(self, map_func):
     """Maps `map_func` across this dataset and flattens the result.
 
@@ -863,6 +1101,49 @@ class Dataset(object):
     """
     return FlatMapDataset(self, map_func)
 
+  def parallel_interleave(self, map_func, cycle_length, block_length=1,
+                          sloppy=False, buffer_output_elements=None):
+    """Maps `map_func` across this dataset and interleaves the results.
+
+    Unlike `Dataset.flat_map()`, which reads the dataset returned by
+    `map_func` for one element before moving on to the next element, this
+    transformation reads `cycle_length` of those datasets concurrently,
+    each on its own background thread. It is useful for reading many files
+    from storage where a single stream is slow, e.g.:
+
+    ```python
+    filenames = Dataset.from_tensor_slices(["/var/data/file1.tfrecord", ...])
+    records = filenames.parallel_interleave(TFRecordDataset, cycle_length=4)
+    ```
+
+    The output takes `block_length` consecutive elements from each of the
+    `cycle_length` datasets in turn. When one of them is exhausted, the
+    dataset for the next input element takes its place in the cycle.
+
+    Args:
+      map_func: A function mapping a nested structure of tensors (having shapes
+        and types defined by `self.output_shapes` and `self.output_types`) to a
+        `Dataset`.
+      cycle_length: A `tf.int64` scalar `tf.Tensor`, representing the number of
+        input elements that are processed concurrently.
+      block_length: (Optional.) A `tf.int64` scalar `tf.Tensor`, representing
+        the number of consecutive elements to take from each input element
+        before cycling to the next one.
+      sloppy: (Optional.) A `tf.bool` scalar `tf.Tensor`. If true, the order of
+        the output is not deterministic: when the dataset at the current
+        position in the cycle has no element ready, an element is taken from
+        another one instead of waiting.
+      buffer_output_elements: (Optional.) A `tf.int64` scalar `tf.Tensor`,
+        representing the maximum number of elements that are buffered from
+        each input element. Defaults to `block_length`.
+
+    Returns:
+      A `Dataset`.
+    """
+    return ParallelInterleaveDataset(self, map_func, cycle_length,
+                                     block_length, sloppy,
+                                     buffer_output_elements)
+
   def unbatch(self):
     """Splits elements of this dataset into sequences of consecutive elements.
 
@@ -1093,18 +1374,46 @@ class RangeDataset(Dataset):
 class CacheDataset(Dataset):
   """A `Dataset` that caches elements of its input."""
 
-  def __init__(self, input_dataset, filename):
+  def __init__(self, input_dataset, filename, num_shards=1):
     """See `Dataset.cache()` for details."""
     super(CacheDataset, self).__init__()
     self._input_dataset = input_dataset
     self._filename = ops.convert_to_tensor(
         filename, dtype=dtypes.string, name="filename")
+    self._num_shards = num_shards
 
   def make_dataset_resource(self):
     return gen_dataset_ops.cache_dataset(
         self._input_dataset.make_dataset_resource(),
         filename=self._filename,
         output_shapes=nest.flatten(self.output_shapes),
+        output_types=nest.flatten(self.output_types),
+        num_shards=self._num_shards)
+
+  @property
+  def output_shapes(self):
+    return self._input_dataset.output_shapes
+
+  @property
+  def output_types(self):
+    return self._input_dataset.output_types
+
+
+class PrefetchDataset(Dataset):
+  """A `Dataset` that asynchronously prefetches its input."""
+
+  def __init__(self, input_dataset, buffer_size):
+    """See `Dataset.prefetch()` for details."""
+    super(PrefetchDataset, self).__init__()
+    self._input_dataset = input_dataset
+    self._buffer_size = ops.convert_to_tensor(
+        buffer_size, dtype=dtypes.int64, name="buffer_size")
+
+  def make_dataset_resource(self):
+    return gen_dataset_ops.prefetch_dataset(
+        self._input_dataset.make_dataset_resource(),
+        buffer_size=self._buffer_size,
+        output_shapes=nest.flatten(self.output_shapes),
         output_types=nest.flatten(self.output_types))
 
   @property
@@ -1154,6 +1463,50 @@ class ShuffleDataset(Dataset):
     return self._input_dataset.output_types
 
 
+class ShuffleAndRepeatDataset(Dataset):
+  """A `Dataset` that shuffles and repeats the elements of its input."""
+
+  def __init__(self, input_dataset, buffer_size, count=None, seed=None):
+    """See `Dataset.shuffle_and_repeat()` for details."""
+    super(ShuffleAndRepeatDataset, self).__init__()
+    self._input_dataset = input_dataset
+    self._buffer_size = ops.convert_to_tensor(
+        buffer_size, dtype=dtypes.int64, name="buffer_size")
+    if count is None:
+      self._count = constant_op.constant(-1, dtype=dtypes.int64, name="count")
+    else:
+      self._count = ops.convert_to_tensor(
+          count, dtype=dtypes.int64, name="count")
+    seed, seed2 = random_seed.get_seed(seed)
+    if seed is None:
+      self._seed = constant_op.constant(0, dtype=dtypes.int64, name="seed")
+    else:
+      self._seed = ops.convert_to_tensor(seed, dtype=dtypes.int64, name="seed")
+    if seed2 is None:
+      self._seed2 = constant_op.constant(0, dtype=dtypes.int64, name="seed2")
+    else:
+      self._seed2 = ops.convert_to_tensor(seed2, dtype=dtypes.int64,
+                                          name="seed2")
+
+  def make_dataset_resource(self):
+    return gen_dataset_ops.shuffle_and_repeat_dataset(
+        self._input_dataset.make_dataset_resource(),
+        buffer_size=self._buffer_size,
+        seed=self._seed,
+        seed2=self._seed2,
+        count=self._count,
+        output_shapes=nest.flatten(self.output_shapes),
+        output_types=nest.flatten(self.output_types))
+
+  @property
+  def output_shapes(self):
+    return self._input_dataset.output_shapes
+
+  @property
+  def output_types(self):
+    return self._input_dataset.output_types
+
+
 class TakeDataset(Dataset):
   """A `Dataset` containing the first `count` elements from its input."""
 
@@ -1357,6 +1710,64 @@ class DenseToSparseBatchDataset(Dataset):
     return (dtypes.int64, self._input_dataset.output_types, dtypes.int64)
 
 
+class ParseExampleDataset(Dataset):
+  """A `Dataset` that parses batches of serialized `Example` protos."""
+
+  def __init__(self, input_dataset, features, num_parallel_calls):
+    """See `Dataset.parse_example()` for more details."""
+    super(ParseExampleDataset, self).__init__()
+    if input_dataset.output_types != dtypes.string:
+      raise TypeError("ParseExampleDataset requires an input whose elements "
+                      "are `tf.string` vectors, whereas the input has %r."
+                      % input_dataset.output_types)
+    self._input_dataset = input_dataset
+    # pylint: disable=protected-access
+    (self._sparse_keys, self._sparse_types, self._dense_keys,
+     self._dense_types, dense_defaults, dense_shapes) = (
+         parsing_ops._features_to_raw_params(
+             features, [parsing_ops.VarLenFeature,
+                        parsing_ops.FixedLenFeature,
+                        parsing_ops.FixedLenSequenceFeature]))
+    self._dense_shapes = [tensor_shape.as_shape(s) for s in dense_shapes]
+    self._dense_defaults = parsing_ops._dense_defaults_to_list(
+        self._dense_keys, self._dense_types, dense_defaults,
+        self._dense_shapes)
+    # pylint: enable=protected-access
+    self._num_parallel_calls = ops.convert_to_tensor(
+        num_parallel_calls, dtype=dtypes.int64, name="num_parallel_calls")
+
+  def make_dataset_resource(self):
+    return gen_dataset_ops.parse_example_dataset(
+        self._input_dataset.make_dataset_resource(),
+        self._num_parallel_calls,
+        self._dense_defaults,
+        sparse_keys=self._sparse_keys,
+        dense_keys=self._dense_keys,
+        sparse_types=self._sparse_types,
+        dense_shapes=[s.as_proto() for s in self._dense_shapes],
+        output_types=nest.flatten(self.output_types),
+        output_shapes=nest.flatten(self.output_shapes))
+
+  @property
+  def output_shapes(self):
+    batch_size = self._input_dataset.output_shapes.with_rank(1)[0]
+    shapes = {}
+    for key, shape in zip(self._dense_keys, self._dense_shapes):
+      shapes[key] = tensor_shape.vector(batch_size).concatenate(shape)
+    for key in self._sparse_keys:
+      shapes[key] = (tensor_shape.matrix(None, 2),
+                     tensor_shape.vector(None),
+                     tensor_shape.vector(2))
+    return shapes
+
+  @property
+  def output_types(self):
+    types = dict(zip(self._dense_keys, self._dense_types))
+    for key, dtype in zip(self._sparse_keys, self._sparse_types):
+      types[key] = (dtypes.int64, dtype, dtypes.int64)
+    return types
+
+
 class _ResourceDataset(Dataset):
   """A Dataset wrapper for a tf.resource-typed function argument."""
 
@@ -1459,6 +1870,59 @@ def _most_specific_compatible_shape(s1, s2):
   return tensor_shape.TensorShape(dims)
 
 
+# Element-wise ops whose results on a batch of elements are exactly the
+# batch of their results on each element. Transcendental functions are
+# left out, since their vectorized and scalar kernels may round differently.
+_ELEMENT_WISE_OPS = frozenset([
+    "Abs", "Add", "BitwiseAnd", "BitwiseOr", "BitwiseXor", "Cast", "Ceil",
+    "Div", "Equal", "Floor", "FloorDiv", "FloorMod", "Greater",
+    "GreaterEqual", "Identity", "IsFinite", "IsInf", "IsNan", "Less",
+    "LessEqual", "LogicalAnd", "LogicalNot", "LogicalOr", "Maximum",
+    "Minimum", "Mul", "Neg", "NotEqual", "RealDiv", "Rint", "Round", "Sign",
+    "Sqrt", "Square", "SquaredDifference", "Sub", "TruncateDiv",
+    "TruncateMod"
+])
+
+
+def _is_element_wise(graph, args, rets):
+  """Returns whether a traced map function can be applied to a batch.
+
+  This is the case when every op computed from the elements is an op of
+  `_ELEMENT_WISE_OPS` on fixed-shape tensors, whose other inputs (computed
+  from constants and captured tensors only) are scalars or have the shape
+  of the element, and when every return value is computed from the elements.
+
+  Args:
+    graph: The graph of the traced function.
+    args: The argument tensors of the function in `graph`.
+    rets: The returned tensors of the function in `graph`.
+
+  Returns:
+    A boolean.
+  """
+  from_elements = set(args)
+  for op in graph.get_operations():
+    if op.type in ("Const", "Placeholder", "PlaceholderV2"):
+      continue
+    if op.type not in _ELEMENT_WISE_OPS or op.control_inputs:
+      return False
+    from_element = [t in from_elements for t in op.inputs]
+    if not any(from_element):
+      continue
+    shape = op.outputs[0].get_shape()
+    if not shape.is_fully_defined():
+      return False
+    for t, t_from_element in zip(op.inputs, from_element):
+      t_shape = t.get_shape()
+      if not t_shape.is_fully_defined():
+        return False
+      if t_from_element or t_shape.ndims != 0:
+        if t_shape != shape:
+          return False
+    from_elements.update(op.outputs)
+  return all(t in from_elements for t in rets)
+
+
 class MapDataset(Dataset):
   """A `Dataset` that maps a function over elements in its input."""
 
@@ -1473,6 +1937,8 @@ class MapDataset(Dataset):
 
     self._output_shapes = None
     self._output_types = None
+    self._py_map_func = map_func
+    self._vectorizable = False
 
     @function.Defun(*nest.flatten(input_dataset.output_types))
     def tf_map_func(*args):
@@ -1494,6 +1960,8 @@ class MapDataset(Dataset):
           ret, [t.get_shape() for t in flattened_ret])
       self._output_types = nest.pack_sequence_as(
           ret, [t.dtype for t in flattened_ret])
+      self._vectorizable = _is_element_wise(
+          ops.get_default_graph(), args, flattened_ret)
 
       return flattened_ret
 
@@ -1539,6 +2007,53 @@ class MapDataset(Dataset):
   def output_types(self):
     return self._output_types
 
+  @property
+  def vectorizable(self):
+    """Whether the function gives the same results when applied to batches.
+
+    Returns:
+      A boolean, true when the function is made only of element-wise ops on
+      fixed-shape elements.
+    """
+    return self._vectorizable
+
+
+class MapAndBatchDataset(MapDataset):
+  """A `Dataset` that maps a function over its input and batches the results."""
+
+  def __init__(self, input_dataset, map_func, batch_size, num_threads,
+               num_parallel_batches):
+    """See `Dataset.map_and_batch()` for details."""
+    super(MapAndBatchDataset, self).__init__(input_dataset, map_func)
+    # The elements are already batched.
+    self._vectorizable = False
+    self._batch_size = ops.convert_to_tensor(
+        batch_size, dtype=dtypes.int64, name="batch_size")
+    self._num_threads = ops.convert_to_tensor(
+        num_threads if num_threads is not None else 1, dtype=dtypes.int32,
+        name="num_threads")
+    self._num_parallel_batches = ops.convert_to_tensor(
+        num_parallel_batches if num_parallel_batches is not None else 1,
+        dtype=dtypes.int64, name="num_parallel_batches")
+
+  def make_dataset_resource(self):
+    return gen_dataset_ops.map_and_batch_dataset(
+        self._input_dataset.make_dataset_resource(),
+        self._map_func.captured_inputs,
+        f=self._map_func,
+        batch_size=self._batch_size,
+        num_threads=self._num_threads,
+        num_parallel_batches=self._num_parallel_batches,
+        output_types=nest.flatten(self.output_types),
+        output_shapes=nest.flatten(self.output_shapes))
+
+  @property
+  def output_shapes(self):
+    return nest.pack_sequence_as(self._output_shapes, [
+        tensor_shape.vector(None).concatenate(s)
+        for s in nest.flatten(self._output_shapes)
+    ])
+
 
 class FlatMapDataset(Dataset):
   """A `Dataset` that maps a function over its input and flattens the result."""
@@ -1592,6 +2107,40 @@ class FlatMapDataset(Dataset):
     return self._output_types
 
 
+class ParallelInterleaveDataset(FlatMapDataset):
+  """A `Dataset` that maps a function over its input and interleaves the result.
+  """
+
+  def __init__(self, input_dataset, map_func, cycle_length, block_length,
+               sloppy, buffer_output_elements):
+    """See `Dataset.parallel_interleave()` for details."""
+    super(ParallelInterleaveDataset, self).__init__(input_dataset, map_func)
+    self._cycle_length = ops.convert_to_tensor(
+        cycle_length, dtype=dtypes.int64, name="cycle_length")
+    self._block_length = ops.convert_to_tensor(
+        block_length, dtype=dtypes.int64, name="block_length")
+    self._sloppy = ops.convert_to_tensor(
+        sloppy, dtype=dtypes.bool, name="sloppy")
+    if buffer_output_elements is None:
+      self._buffer_output_elements = self._block_length
+    else:
+      self._buffer_output_elements = ops.convert_to_tensor(
+          buffer_output_elements, dtype=dtypes.int64,
+          name="buffer_output_elements")
+
+  def make_dataset_resource(self):
+    return gen_dataset_ops.parallel_interleave_dataset(
+        self._input_dataset.make_dataset_resource(),
+        self._map_func.captured_inputs,
+        self._cycle_length,
+        self._block_length,
+        self._sloppy,
+        self._buffer_output_elements,
+        f=self._map_func,
+        output_types=nest.flatten(self.output_types),
+        output_shapes=nest.flatten(self.output_shapes))
+
+
 class FilterDataset(Dataset):
   """A `Dataset` that filters its input according to a predicate function."""
 
@@ -1669,15 +2218,24 @@ class TextLineDataset(Dataset):
 class TFRecordDataset(Dataset):
   """A `Dataset` comprising records from one or more TFRecord files."""
 
-  def __init__(self, filenames, compression_type=None):
+  def __init__(self, filenames, compression_type=None, buffer_size=None,
+               verify_checksums=True):
     """Creates a `TFRecordDataset`.
 
     Args:
       filenames: A `tf.string` tensor containing one or more filenames.
       compression_type: A `tf.string` scalar evaluating to one of `""` (no
-        compression), `"ZLIB"`, or `"GZIP"`.
+        compression), `"ZLIB"`, `"GZIP"`, or `"SNAPPY"`.
+      buffer_size: (Optional.) A Python integer representing the number of
+        bytes to read from each file at a time. If greater than zero, the next
+        block of each file is read ahead in the background.
+      verify_checksums: (Optional.) A Python boolean. If `False`, the
+        checksums of the records are not verified, which saves CPU time when
+        the files are known to be intact.
     """
     super(TFRecordDataset, self).__init__()
+    self._buffer_size = buffer_size or 0
+    self._verify_checksums = verify_checksums
     self._filenames = ops.convert_to_tensor(filenames, name="filenames")
     if compression_type is not None:
       self._compression_type = ops.convert_to_tensor(
@@ -1686,8 +2244,11 @@ class TFRecordDataset(Dataset):
       self._compression_type = constant_op.constant("", name="compression_type")
 
   def make_dataset_resource(self):
-    return gen_dataset_ops.tf_record_dataset(self._filenames,
-                                             self._compression_type)
+    return gen_dataset_ops.tf_record_dataset(
+        self._filenames,
+        self._compression_type,
+        buffer_size=self._buffer_size,
+        verify_checksums=self._verify_checksums)
 
   @property
   def output_shapes(self):
@@ -1749,6 +2310,63 @@ class FixedLengthRecordDataset(Dataset):
     return dtypes.string
 
 
+class LMDBDataset(Dataset):
+  """A `Dataset` of batches of the records of one or more LMDB files.
+
+  Each element is a pair of `tf.string` vectors, holding the keys and values
+  of up to `batch_size` consecutive records of one file, in key order. The
+  cursor of each file is walked a batch at a time, which is much cheaper than
+  reading the records one by one with a `tf.LMDBReader`.
+
+  Large databases can be read in parallel by giving each reader a separate
+  range of keys, e.g.:
+
+  ```python
+  shards = Dataset.from_tensor_slices((start_keys, end_keys))
+  records = shards.parallel_interleave(
+      lambda start, end: LMDBDataset(filename, start, end), cycle_length=4)
+  ```
+  """
+
+  def __init__(self, filenames, start_key=None, end_key=None,
+               batch_size=None):
+    """Creates an `LMDBDataset`.
+
+    Args:
+      filenames: A `tf.string` tensor containing one or more filenames, each
+        one either an LMDB directory or its data file.
+      start_key: (Optional.) A `tf.string` scalar containing the first key to
+        read from each file. Defaults to the first key of the file.
+      end_key: (Optional.) A `tf.string` scalar containing the key at which
+        to stop reading each file (exclusive). Defaults to reading up to the
+        last key of the file.
+      batch_size: (Optional.) A `tf.int64` scalar representing the maximum
+        number of records in each element. Defaults to 256.
+    """
+    super(LMDBDataset, self).__init__()
+    self._filenames = ops.convert_to_tensor(
+        filenames, dtype=dtypes.string, name="filenames")
+    self._start_key = ops.convert_to_tensor(
+        start_key or "", dtype=dtypes.string, name="start_key")
+    self._end_key = ops.convert_to_tensor(
+        end_key or "", dtype=dtypes.string, name="end_key")
+    self._batch_size = ops.convert_to_tensor(
+        256 if batch_size is None else batch_size, dtype=dtypes.int64,
+        name="batch_size")
+
+  def make_dataset_resource(self):
+    return gen_dataset_ops.lmdb_dataset(
+        self._filenames, self._start_key, self._end_key, self._batch_size)
+
+  @property
+  def output_shapes(self):
+    return (tensor_shape.vector(None), tensor_shape.vector(None))
+
+  @property
+  def output_types(self):
+    return (dtypes.string, dtypes.string)
+
+
 def rejection_resample(dataset, class_func, target_dist,
                        initial_dist=None, seed=None):
   """Resamples this dataset to achieve a target class distribution.
@@ -29,11 +29,11 @@
 #include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/threadpool.h"
-#include "tensorflow/core/lib/gtl/top_n.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -56,6 +56,10 @@ const int64 kDefaultL3CachePerCpu = 1 << 20;
 const int64 kNearestNeighborsCentersMaxBlockSize = 1024;
 const int64 kNearestNeighborsPointsMinBlockSize = 16;
 
+// Number of rows of points whose distances to the sampled points are computed
+// together by KmeansPlusPlusInitializationOp.
+const int64 kKmeansPlusPlusPointsBlockSize = 256;
+
 // Returns the smallest multiple of a that is not smaller than b.
 int64 NextMultiple(int64 a, int64 b) {
   const int64 remainder = b % a;
@@ -162,32 +166,98 @@ class KmeansPlusPlusInitializationOp : public OpKernel {
       return index;
     };
 
+    // The distance updates are sharded over fixed blocks of points, so that the
+    // results don't depend on the number of threads.
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    const int64 num_blocks =
+        CeilOfRatio(num_points, kKmeansPlusPlusPointsBlockSize);
+    auto shard_blocks = [&](int64 cost_per_block,
+                            std::function<void(int64, int64)> work) {
+      Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+            cost_per_block, std::move(work));
+    };
+
+    // Updates min_distances with the distances to the point at "index".
+    auto update_min_distances = [&](int64 index) {
+      const Eigen::RowVectorXf y = points.row(index);
+      const float y_half_squared_norm = points_half_squared_norm(index);
+      shard_blocks(
+          kKmeansPlusPlusPointsBlockSize * point_dimensions,
+          [&](int64 start_block, int64 limit_block) {
+            const int64 start_row =
+                start_block * kKmeansPlusPlusPointsBlockSize;
+            const int64 num_rows =
+                std::min(num_points,
+                         limit_block * kKmeansPlusPlusPointsBlockSize) -
+                start_row;
+            auto min_distances_shard =
+                min_distances.segment(start_row, num_rows);
+            min_distances_shard = min_distances_shard.cwiseMin(
+                GetHalfSquaredDistancesToY(
+                    points.middleRows(start_row, num_rows),
+                    points_half_squared_norm.segment(start_row, num_rows), y,
+                    y_half_squared_norm));
+          });
+    };
+
     auto sample_one_point = [&]() {
       const int64 sampled_index = draw_one_sample();
-      min_distances = min_distances.cwiseMin(GetHalfSquaredDistancesToY(
-          points, points_half_squared_norm, points.row(sampled_index),
-          points_half_squared_norm(sampled_index)));
+      update_min_distances(sampled_index);
       return sampled_index;
     };
 
+    // Draws all the candidates first, since the draws don't depend on each
+    // other, then computes the potential of every candidate with a single
+    // pass over the points.
     auto sample_one_point_with_retries = [&]() {
-      Eigen::VectorXf best_new_min_distances(num_points);
-      float best_potential = std::numeric_limits<float>::infinity();
-      int64 best_sampled_index = 0;
-      for (int i = 1 + num_retries_per_sample; i > 0; --i) {
-        const int64 sampled_index = draw_one_sample();
-        Eigen::VectorXf new_min_distances =
-            min_distances.cwiseMin(GetHalfSquaredDistancesToY(
-                points, points_half_squared_norm, points.row(sampled_index),
-                points_half_squared_norm(sampled_index)));
-        const float potential = new_min_distances.sum();
-        if (potential < best_potential) {
-          best_potential = potential;
-          best_sampled_index = sampled_index;
-          best_new_min_distances.swap(new_min_distances);
+      const int64 num_candidates = 1 + num_retries_per_sample;
+      std::vector<int64> candidates(num_candidates);
+      MatrixXfRowMajor candidate_points(num_candidates, point_dimensions);
+      Eigen::RowVectorXf candidates_half_squared_norm(num_candidates);
+      for (int64 j = 0; j < num_candidates; ++j) {
+        candidates[j] = draw_one_sample();
+        candidate_points.row(j) = points.row(candidates[j]);
+        candidates_half_squared_norm(j) =
+            points_half_squared_norm(candidates[j]);
+      }
+      Eigen::MatrixXd block_potentials(num_blocks, num_candidates);
+      shard_blocks(
+          kKmeansPlusPlusPointsBlockSize * point_dimensions * num_candidates,
+          [&](int64 start_block, int64 limit_block) {
+            MatrixXfRowMajor inner_product;
+            for (int64 block = start_block; block < limit_block; ++block) {
+              const int64 start_row = block * kKmeansPlusPlusPointsBlockSize;
+              const int64 num_rows = std::min(kKmeansPlusPlusPointsBlockSize,
+                                              num_points - start_row);
+              inner_product.noalias() =
+                  points.middleRows(start_row, num_rows) *
+                  candidate_points.transpose();
+              Eigen::RowVectorXd potentials =
+                  Eigen::RowVectorXd::Zero(num_candidates);
+              for (int64 i = 0; i < num_rows; ++i) {
+                const float point_half_squared_norm =
+                    points_half_squared_norm(start_row + i);
+                const float min_distance = min_distances(start_row + i);
+                for (int64 j = 0; j < num_candidates; ++j) {
+                  potentials(j) += std::min(
+                      min_distance, point_half_squared_norm -
+                                        inner_product(i, j) +
+                                        candidates_half_squared_norm(j));
+                }
+              }
+              block_potentials.row(block) = potentials;
+            }
+          });
+      const Eigen::RowVectorXd potentials = block_potentials.colwise().sum();
+      double best_potential = std::numeric_limits<double>::infinity();
+      int64 best_sampled_index = candidates[0];
+      for (int64 j = 0; j < num_candidates; ++j) {
+        if (potentials(j) < best_potential) {
+          best_potential = potentials(j);
+          best_sampled_index = candidates[j];
         }
       }
-      min_distances.swap(best_new_min_distances);
+      update_min_distances(best_sampled_index);
       return best_sampled_index;
     };
 
@@ -208,7 +278,6 @@ class KmeansPlusPlusInitializationOp : public OpKernel {
   // Returns a column vector with the i-th element set to half the squared
   // euclidean distance between the i-th row of xs, and y. Precomputed norms for
   // each row of xs and y must be provided for efficiency.
-  // TODO(ands): Parallelize this for large xs.
   static Eigen::VectorXf GetHalfSquaredDistancesToY(
       const Eigen::Ref<const MatrixXfRowMajor>& xs,
       const Eigen::Ref<const Eigen::VectorXf>& xs_half_squared_norm,
@@ -413,23 +482,24 @@ class NearestNeighborsOp : public OpKernel {
         nearest_center_indices(i, 0) = index;
       }
     } else {
-      // Select k nearest centers for each point.
+      // Select k nearest centers for each point. Ties are broken by the
+      // center index.
       using Center = std::pair<float, int64>;
       const int64 num_centers = centers.rows();
-      gtl::TopN<Center, std::less<Center>> selector(k);
-      std::unique_ptr<std::vector<Center>> nearest_centers;
+      std::vector<Center> nearest_centers(num_centers);
       for (int i = 0; i < num_points; ++i) {
-        selector.reserve(num_centers);
         for (int j = 0; j < num_centers; ++j) {
           const float partial_distance =
               centers_half_squared_norm(j) - inner_product(i, j);
-          selector.push(Center(partial_distance, j));
+          nearest_centers[j] = Center(partial_distance, j);
         }
-        nearest_centers.reset(selector.Extract());
-        selector.Reset();
+        std::nth_element(nearest_centers.begin(),
+                         nearest_centers.begin() + (k - 1),
+                         nearest_centers.end());
+        std::sort(nearest_centers.begin(), nearest_centers.begin() + k);
         const float point_half_squared_norm = points_half_squared_norm(i);
         for (int j = 0; j < k; ++j) {
-          const Center& center = (*nearest_centers)[j];
+          const Center& center = nearest_centers[j];
           nearest_center_distances(i, j) =
               2.0 * (point_half_squared_norm + center.first);
           nearest_center_indices(i, j) = center.second;
@@ -510,9 +580,11 @@ class NearestNeighborsOp : public OpKernel {
           }
           nearest_center_indices.row(i) = merged_indices;
           nearest_center_distances.row(i) = merged_distances;
-          out_k = std::min(k, out_k + block_k);
         }
       }
+      // Every row now holds the merged nearest centers of all the blocks so
+      // far.
+      out_k = std::min(k, out_k + block_k);
     }
   }
 };
@@ -20,18 +20,14 @@
 #include <numeric>
 #include <vector>
 
-// This is only used for std::this_thread::get_id()
-#include <thread>  // NOLINT
-
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
-#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/threadpool.h"
-#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 using tensorflow::DEVICE_CPU;
 using tensorflow::DT_BOOL;
@@ -141,8 +137,8 @@ class WALSComputePartialLhsAndRhsOp : public OpKernel {
     std::vector<int64> perm(num_nonzero_elements);
     std::iota(perm.begin(), perm.end(), 0);
 
-    typedef std::pair<int64, int64> Shard;
-    std::vector<Shard> shards;
+    typedef std::pair<int64, int64> Range;
+    std::vector<Range> shards;
     auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
     int64 shard_total = 0;
     // Compute a permutation such that get_input_index(perm[i]) is sorted, use
@@ -173,42 +169,10 @@ class WALSComputePartialLhsAndRhsOp : public OpKernel {
     // Batch the rank-one updates into a rank-k update to lower memory traffic
     const int kMaxBatchSize = 128;
 
-    // Since we do not have an easy way of generating thread id's within the
-    // range [0,num_threads), we can instead call out to an std::unordered_map
-    // of matrices and initialize the matrix on the first call.
-    // However, this might have a performance penalty, as memory allocation can
-    // cause the OS kernel to enter a critical section and temporarily disable
-    // parallelism, and the unordered_map must be protected with a read/write
-    // mutex.
-    //
-    // TODO(jpoulson): Simplify after the thread rank can be queried
-    std::unordered_map<size_t, Eigen::MatrixXf> factor_batch_map;
-    mutex map_mutex;
-
-    BlockingCounter counter(shards.size());
-    // Lambda encapsulating the per-shard computation.
-    auto work = [&](const Shard& shard) {
-      const std::thread::id thread_id = std::this_thread::get_id();
-      const size_t id_hash = std::hash<std::thread::id>()(thread_id);
-      // If this thread's unique factors_mat.rows() x kMaxBatchSize
-      // batching matrix has not yet been created, then emplace it into the
-      // map using the hash of the thread id as the key.
-      //
-      // TODO(jpoulson): Switch to try_emplace once C++17 is supported
-      map_mutex.lock();
-      const auto key_count = factor_batch_map.count(id_hash);
-      map_mutex.unlock();
-      if (!key_count) {
-        map_mutex.lock();
-        factor_batch_map.emplace(
-            std::piecewise_construct, std::forward_as_tuple(id_hash),
-            std::forward_as_tuple(factors_mat.rows(), kMaxBatchSize));
-        map_mutex.unlock();
-      }
-      map_mutex.lock();
-      auto& factor_batch = factor_batch_map[id_hash];
-      map_mutex.unlock();
-
+    // Lambda encapsulating the per-shard computation, with a
+    // factors_mat.rows() x kMaxBatchSize batching matrix owned by the caller.
+    auto work = [&](const Range& shard, Eigen::MatrixXf* factor_batch_ptr) {
+      Eigen::MatrixXf& factor_batch = *factor_batch_ptr;
       CHECK_GE(shard.first, 0);
       CHECK_LE(shard.second, perm.size());
       CHECK_LE(shard.first, shard.second);
@@ -249,14 +213,19 @@ class WALSComputePartialLhsAndRhsOp : public OpKernel {
       // Copy lower triangular to upper triangular part of normal equation
       // matrix.
       lhs_mat = lhs_symm;
-      counter.DecrementCount();
     };
-    for (size_t i = 1; i < shards.size(); ++i) {
-      worker_threads.workers->Schedule(std::bind(work, shards[i]));
-    }
-    // Inline execute the 1st shard.
-    work(shards[0]);
-    counter.Wait();
+    // Each unit of work is a contiguous range of shards, which shares one
+    // batching matrix. The cost of a shard is dominated by its rank-k
+    // updates.
+    const int64 cost_per_shard =
+        (num_nonzero_elements / shards.size() + 1) * factor_dim * factor_dim;
+    Shard(worker_threads.num_threads, worker_threads.workers, shards.size(),
+          cost_per_shard, [&](int64 start_shard, int64 limit_shard) {
+            Eigen::MatrixXf factor_batch(factors_mat.rows(), kMaxBatchSize);
+            for (int64 i = start_shard; i < limit_shard; ++i) {
+              work(shards[i], &factor_batch);
+            }
+          });
   }
 };
 
@@ -86,6 +86,26 @@ class NearestCentersTest(test.TestCase):
                           [[0., 2.], [5., 5.], [1., 5.], [0., 2.]])
 
 
+# A test with more nearest centers than fit in one block of centers, and exactly
+# representable distances.
+class NearestCentersManyBlocksTest(test.TestCase):
+
+  def setUp(self):
+    self._points = np.array([[0.], [1499.]]).astype(np.float32)
+    self._centers = np.arange(1500).reshape([1500, 1]).astype(np.float32)
+
+  def testNearest1200(self):
+    with self.test_session():
+      [indices, distances] = clustering_ops.nearest_neighbors(self._points,
+                                                              self._centers,
+                                                              1200)
+      expected_indices = np.array([np.arange(1200), 1499 - np.arange(1200)])
+      self.assertAllEqual(indices.eval(), expected_indices)
+      self.assertAllEqual(distances.eval(),
+                          np.square(np.arange(1200)[np.newaxis, :]).repeat(
+                              2, axis=0))
+
+
 # A test with large inputs.
 class NearestCentersLargeTest(test.TestCase):
 
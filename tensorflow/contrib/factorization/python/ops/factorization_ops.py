@@ -828,7 +828,9 @@ class WALSModel(object):
         values=sp_input.values,
         dense_shape=new_sp_shape)
 
-    # Compute lhs and rhs of the normal equations
+    # Compute lhs and rhs of the normal equations. The lhs matrices are
+    # symmetric positive definite, so they are solved by Cholesky
+    # factorization, batched over the rows.
     total_lhs = (self._unobserved_weight * gramian)
     if self._regularization_matrix is not None:
       total_lhs += self._regularization_matrix
@@ -837,11 +839,11 @@ class WALSModel(object):
       total_rhs = (self._unobserved_weight *
                    sparse_ops.sparse_tensor_dense_matmul(
                        new_sp_input, right, adjoint_a=transpose_input))
-      # TODO(rmlarsen): handle transposing in tf.matrix_solve instead of
+      # TODO(rmlarsen): handle transposing in tf.cholesky_solve instead of
       # transposing explicitly.
-      # TODO(rmlarsen): multi-thread tf.matrix_solve.
       new_left_values = array_ops.transpose(
-          linalg_ops.matrix_solve(total_lhs, array_ops.transpose(total_rhs)))
+          linalg_ops.cholesky_solve(
+              linalg_ops.cholesky(total_lhs), array_ops.transpose(total_rhs)))
     else:
       if row_weights is None:
         # TODO(yifanchen): Add special handling for single shard without using
@@ -874,7 +876,8 @@ class WALSModel(object):
       total_lhs = array_ops.expand_dims(total_lhs, 0) + partial_lhs
       total_rhs = array_ops.expand_dims(total_rhs, -1)
       new_left_values = array_ops.squeeze(
-          linalg_ops.matrix_solve(total_lhs, total_rhs), [2])
+          linalg_ops.cholesky_solve(linalg_ops.cholesky(total_lhs), total_rhs),
+          [2])
 
     update_op_name = "row_update" if update_row_factors else "col_update"
     update_op = self.scatter_update(left, update_indices, new_left_values,
@@ -18,6 +18,7 @@ limitations under the License.
 // \
 // --in_graph=graph_def.pb
 
+#include <set>
 #include <unordered_set>
 
 #include "tensorflow/core/framework/graph.pb.h"
@@ -117,6 +118,7 @@ static void CheckOpsSupport(const GraphDef& graph_def,
             << ", dump_shape_and_tpye = " << dump_shape_and_type;
 
   std::unordered_set<string> unsupported_ops;
+  std::set<string> supported_ops;
   bool all_supported = true;
   bool contains_remote_graph = false;
   for (const NodeDef& node : graph_def.node()) {
@@ -132,6 +134,8 @@ static void CheckOpsSupport(const GraphDef& graph_def,
       LOG(ERROR) << "OP type: " << node.op() << " is not supported on hvx. "
                  << "Name = " << node.name();
       unsupported_ops.emplace(node.op());
+    } else {
+      supported_ops.emplace(node.op());
     }
   }
 
@@ -146,6 +150,12 @@ static void CheckOpsSupport(const GraphDef& graph_def,
   } else {
     LOG(INFO) << count << " ops are not supported.";
   }
+  if (!supported_ops.empty()) {
+    // The supported ops can be fused into hvx subgraphs, leaving the others
+    // on the CPU, by the fuse_remote_graph transform with this argument.
+    LOG(INFO) << "fused_op_types=\"" << str_util::Join(supported_ops, ",")
+              << "\"";
+  }
 
   if (contains_remote_graph || dump_all_nodes) {
     for (const NodeDef& node : graph_def.node()) {
@@ -30,6 +30,8 @@
 @@HashTable
 @@MutableHashTable
 @@MutableDenseHashTable
+@@MappedHashTable
+@@DynamicEmbeddingTable
 @@TableInitializerBase
 @@KeyValueTensorInitializer
 @@TextFileIndex
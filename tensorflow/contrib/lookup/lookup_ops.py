@@ -21,6 +21,7 @@ from __future__ import print_function
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import ops
 from tensorflow.python.framework import tensor_shape
+from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import gen_lookup_ops
 from tensorflow.python.ops import lookup_ops
 # pylint: disable=unused-import
@@ -683,3 +684,360 @@ class MutableDenseHashTable(LookupInterface):
       with ops.colocate_with(self.op._table_ref):
         return gen_lookup_ops._lookup_table_import_v2(
             self.op._table_ref, restored_tensors[0], restored_tensors[1])
+
+
+class MappedHashTable(LookupInterface):
+  """An immutable hash table served in place from a memory mapped file.
+
+  The table file is built offline by the
+  `tensorflow/contrib/util:build_mapped_hash_table` tool, e.g. from a
+  vocabulary file. Opening the table does not parse its entries into memory,
+  so it takes constant time, and the pages of the file are shared by all the
+  processes of a host that serve the same table.
+
+  Example usage:
+
+  ```python
+  table = tf.contrib.lookup.MappedHashTable("vocab.table",
+                                            key_dtype=tf.string,
+                                            value_dtype=tf.int64,
+                                            default_value=-1)
+  out = table.lookup(query_keys)
+  print out.eval()
+  ```
+  """
+
+  def __init__(self,
+               filename,
+               key_dtype,
+               value_dtype,
+               default_value,
+               shared_name=None,
+               name="MappedHashTable"):
+    """Creates a `MappedHashTable` object.
+
+    Args:
+      filename: A scalar string `Tensor`, the name of the table file.
+      key_dtype: the type of the key tensors. Must match the keys of the file.
+      value_dtype: the type of the value tensors. Must match the values of the
+        file.
+      default_value: The value to use if a key is missing in the table.
+      shared_name: If non-empty, this table will be shared under
+        the given name across multiple sessions.
+      name: A name for the operation (optional).
+
+    Returns:
+      A `MappedHashTable` object.
+    """
+    self._default_value = ops.convert_to_tensor(
+        default_value, dtype=value_dtype)
+    self._default_value.get_shape().merge_with(tensor_shape.scalar())
+    filename = ops.convert_to_tensor(filename, dtype=dtypes.string)
+    # pylint: disable=protected-access
+    self._table_ref = gen_lookup_ops._mapped_hash_table_v2(
+        filename=filename,
+        shared_name=shared_name,
+        key_dtype=key_dtype,
+        value_dtype=value_dtype,
+        name=name)
+    # pylint: enable=protected-access
+    super(MappedHashTable, self).__init__(
+        key_dtype, value_dtype, self._table_ref.op.name.split("/")[-1])
+
+  def size(self, name=None):
+    """Compute the number of elements in this table.
+
+    Args:
+      name: A name for the operation (optional).
+
+    Returns:
+      A scalar tensor containing the number of elements in this table.
+    """
+    with ops.name_scope(name, "%s_Size" % self._name,
+                        [self._table_ref]) as name:
+      with ops.colocate_with(self._table_ref):
+        # pylint: disable=protected-access
+        return gen_lookup_ops._lookup_table_size_v2(self._table_ref, name=name)
+
+  def lookup(self, keys, name=None):
+    """Looks up `keys` in a table, outputs the corresponding values.
+
+    The `default_value` is used for keys not present in the table.
+
+    Args:
+      keys: Keys to look up. Can be a tensor of any shape. Must match the
+        table's key_dtype.
+      name: A name for the operation (optional).
+
+    Returns:
+      A tensor containing the values in the same shape as `keys` using the
+        table's value type.
+
+    Raises:
+      TypeError: when `keys` do not match the table data types.
+    """
+    if keys.dtype != self._key_dtype:
+      raise TypeError("Signature mismatch. Keys must be dtype %s, got %s." %
+                      (self._key_dtype, keys.dtype))
+
+    with ops.name_scope(name, "%s_lookup_table_find" % self._name,
+                        [self._table_ref, keys]) as name:
+      with ops.colocate_with(self._table_ref):
+        # pylint: disable=protected-access
+        values = gen_lookup_ops._lookup_table_find_v2(
+            self._table_ref, keys, self._default_value, name=name)
+
+    values.set_shape(keys.get_shape())
+    return values
+
+
+class DynamicEmbeddingTable(LookupInterface):
+  """A table of trainable embeddings for a huge, sparse space of IDs.
+
+  Unlike a `Variable` of a fixed number of rows, indexed by hashing the IDs,
+  the table only holds the embeddings of the IDs that are actually used, so
+  rare IDs don't take memory and distinct IDs don't collide:
+
+  * Looking up an ID that is not in the table counts it, and admits it once it
+    has been looked up `min_frequency` times. Until then, the lookup returns
+    `default_value`.
+  * Newly admitted IDs are initialized lazily, to `initial_stddev` times a
+    standard normal that only depends on `seed` and the ID, or to
+    `default_value` if `initial_stddev` is 0.
+  * If `max_num_entries` is positive, admitting an ID into a full table evicts
+    the least recently used ID, or the least frequently used one if
+    `eviction_policy` is "lfu".
+
+  The table is trained in place by `apply_gradients`, with plain SGD or with
+  Adagrad, whose accumulators are kept in the table too. Its contents, including
+  the lookup frequencies and the accumulators, are saved to and restored from
+  checkpoints.
+
+  Example usage:
+
+  ```python
+  table = tf.contrib.lookup.DynamicEmbeddingTable(key_dtype=tf.int64,
+                                                  value_dtype=tf.float32,
+                                                  embedding_dim=64,
+                                                  min_frequency=2,
+                                                  max_num_entries=10000000,
+                                                  initial_stddev=0.01)
+  embeddings = table.lookup(ids)
+  loss = ...
+  gradients = tf.gradients(loss, embeddings)[0]
+  train_op = table.apply_gradients(ids, gradients, learning_rate=0.1)
+  ```
+  """
+
+  def __init__(self,
+               key_dtype,
+               value_dtype,
+               embedding_dim,
+               default_value=None,
+               min_frequency=1,
+               max_num_entries=0,
+               eviction_policy="lru",
+               initial_stddev=0.0,
+               seed=0,
+               optimizer="sgd",
+               initial_accumulator_value=0.1,
+               shared_name=None,
+               name="DynamicEmbeddingTable",
+               checkpoint=True):
+    """Creates an empty `DynamicEmbeddingTable` object.
+
+    Args:
+      key_dtype: the type of the key tensors, `tf.int64` or `tf.string`.
+      value_dtype: the type of the embeddings, `tf.float32` or `tf.float64`.
+      embedding_dim: the size of the embeddings.
+      default_value: The embedding to use for IDs that are not admitted yet,
+        and to initialize admitted IDs with when `initial_stddev` is 0. Zeros
+        if None.
+      min_frequency: the number of lookups of an ID before it is admitted.
+      max_num_entries: the maximum number of IDs in the table, or 0 for no
+        limit.
+      eviction_policy: "lru" or "lfu", which ID to evict from a full table.
+      initial_stddev: the standard deviation of the random initial embeddings.
+      seed: the seed of the random initial embeddings.
+      optimizer: "sgd" or "adagrad", the optimizer of `apply_gradients`.
+      initial_accumulator_value: the initial Adagrad accumulators.
+      shared_name: If non-empty, this table will be shared under
+        the given name across multiple sessions.
+      name: A name for the operation (optional).
+      checkpoint: if True, the contents of the table are saved to and restored
+        from checkpoints. If `shared_name` is empty for a checkpointed table, it
+        is shared using the table node name.
+
+    Returns:
+      A `DynamicEmbeddingTable` object.
+    """
+    if default_value is None:
+      default_value = array_ops.zeros([embedding_dim], dtype=value_dtype)
+    self._default_value = ops.convert_to_tensor(
+        default_value, dtype=value_dtype)
+    self._default_value.get_shape().merge_with(
+        tensor_shape.TensorShape([embedding_dim]))
+    self._value_shape = self._default_value.get_shape()
+
+    # The table must be shared if checkpointing is requested for multi-worker
+    # training to work correctly. Use the node name if no shared_name has been
+    # explicitly specified.
+    use_node_name_sharing = checkpoint and shared_name is None
+    # pylint: disable=protected-access
+    self._table_ref = gen_lookup_ops._dynamic_embedding_table_v2(
+        shared_name=shared_name,
+        use_node_name_sharing=use_node_name_sharing,
+        key_dtype=key_dtype,
+        value_dtype=value_dtype,
+        embedding_dim=embedding_dim,
+        min_frequency=min_frequency,
+        max_num_entries=max_num_entries,
+        eviction_policy=eviction_policy,
+        initial_stddev=initial_stddev,
+        seed=seed,
+        optimizer=optimizer,
+        initial_accumulator_value=initial_accumulator_value,
+        name=name)
+    # pylint: enable=protected-access
+    super(DynamicEmbeddingTable, self).__init__(
+        key_dtype, value_dtype, self._table_ref.op.name.split("/")[-1])
+
+    if checkpoint:
+      saveable = DynamicEmbeddingTable._Saveable(self, name)
+      ops.add_to_collection(ops.GraphKeys.SAVEABLE_OBJECTS, saveable)
+
+  def size(self, name=None):
+    """Compute the number of elements in this table.
+
+    Args:
+      name: A name for the operation (optional).
+
+    Returns:
+      A scalar tensor containing the number of elements in this table.
+    """
+    with ops.name_scope(name, "%s_Size" % self._name,
+                        [self._table_ref]) as name:
+      with ops.colocate_with(self._table_ref):
+        # pylint: disable=protected-access
+        return gen_lookup_ops._lookup_table_size_v2(self._table_ref, name=name)
+
+  def lookup(self, keys, name=None):
+    """Looks up `keys` in a table, outputs the corresponding embeddings.
+
+    Counts the lookups of `keys` that are not in the table, and admits those
+    looked up `min_frequency` times.
+
+    Args:
+      keys: Keys to look up. Can be a tensor of any shape. Must match the
+        table's key_dtype.
+      name: A name for the operation (optional).
+
+    Returns:
+      A tensor of shape `keys.shape + [embedding_dim]`, of the table's value
+        type.
+
+    Raises:
+      TypeError: when `keys` do not match the table data types.
+    """
+    if keys.dtype != self._key_dtype:
+      raise TypeError("Signature mismatch. Keys must be dtype %s, got %s." %
+                      (self._key_dtype, keys.dtype))
+
+    with ops.name_scope(name, "%s_lookup_table_find" % self._name,
+                        [self._table_ref, keys]) as name:
+      with ops.colocate_with(self._table_ref):
+        # pylint: disable=protected-access
+        values = gen_lookup_ops._lookup_table_find_v2(
+            self._table_ref, keys, self._default_value, name=name)
+
+    values.set_shape(keys.get_shape().concatenate(self._value_shape))
+    return values
+
+  def insert(self, keys, values, name=None):
+    """Sets the embeddings of `keys`, admitting them if needed.
+
+    Args:
+      keys: Keys to insert. Can be a tensor of any shape. Must match the
+        table's key type.
+      values: Embeddings of shape `keys.shape + [embedding_dim]`, of the
+        table's value type.
+      name: A name for the operation (optional).
+
+    Returns:
+      The created Operation.
+    """
+    with ops.name_scope(name, "%s_lookup_table_insert" % self._name,
+                        [self._table_ref, keys, values]) as name:
+      with ops.colocate_with(self._table_ref):
+        # pylint: disable=protected-access
+        return gen_lookup_ops._lookup_table_insert_v2(
+            self._table_ref, keys, values, name=name)
+
+  def apply_gradients(self, keys, gradients, learning_rate, name=None):
+    """Updates the embeddings of `keys` by the table's optimizer.
+
+    Keys that are not in the table, e.g. because they are not admitted yet or
+    were evicted since they were looked up, are ignored.
+
+    Args:
+      keys: Keys of the embeddings to update. Can be a tensor of any shape.
+      gradients: The gradients of the loss with respect to the embeddings of
+        `keys`, of shape `keys.shape + [embedding_dim]`.
+      learning_rate: A scalar.
+      name: A name for the operation (optional).
+
+    Returns:
+      The created Operation.
+    """
+    with ops.name_scope(name, "%s_apply_gradients" % self._name,
+                        [self._table_ref, keys, gradients,
+                         learning_rate]) as name:
+      learning_rate = ops.convert_to_tensor(
+          learning_rate, dtype=self._value_dtype)
+      with ops.colocate_with(self._table_ref):
+        # pylint: disable=protected-access
+        return gen_lookup_ops._dynamic_embedding_table_apply_gradients_v2(
+            self._table_ref, keys, gradients, learning_rate, name=name)
+
+  def export(self, name=None):
+    """Returns tensors of all keys, embeddings, frequencies and accumulators.
+
+    Args:
+      name: A name for the operation (optional).
+
+    Returns:
+      A tuple of the keys, a matrix of their embeddings, a vector of their
+      lookup frequencies and a matrix of their Adagrad accumulators.
+    """
+    with ops.name_scope(name, "%s_lookup_table_export_values" % self._name,
+                        [self._table_ref]) as name:
+      with ops.colocate_with(self._table_ref):
+        # pylint: disable=protected-access
+        keys, values, frequencies, accumulators = (
+            gen_lookup_ops._dynamic_embedding_table_export_v2(
+                self._table_ref, self._key_dtype, self._value_dtype,
+                name=name))
+
+    values.set_shape(keys.get_shape().concatenate(self._value_shape))
+    return keys, values, frequencies, accumulators
+
+  class _Saveable(BaseSaverBuilder.SaveableObject):
+    """SaveableObject implementation for DynamicEmbeddingTable."""
+
+    def __init__(self, table, name):
+      tensors = table.export()
+      specs = [
+          BaseSaverBuilder.SaveSpec(tensors[0], "", name + "-keys"),
+          BaseSaverBuilder.SaveSpec(tensors[1], "", name + "-values"),
+          BaseSaverBuilder.SaveSpec(tensors[2], "", name + "-frequencies"),
+          BaseSaverBuilder.SaveSpec(tensors[3], "", name + "-accumulators")
+      ]
+      # pylint: disable=protected-access
+      super(DynamicEmbeddingTable._Saveable, self).__init__(table, specs, name)
+
+    def restore(self, restored_tensors, unused_restored_shapes):
+      # pylint: disable=protected-access
+      with ops.colocate_with(self.op._table_ref):
+        return gen_lookup_ops._dynamic_embedding_table_import_v2(
+            self.op._table_ref, restored_tensors[0], restored_tensors[1],
+            restored_tensors[2], restored_tensors[3])
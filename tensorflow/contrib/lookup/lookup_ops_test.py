@@ -880,6 +880,34 @@ class MutableDenseHashTableOpTest(test.TestCase):
       output = table.lookup(keys3)
       self.assertAllEqual([-1, 0, 1, 3, 4, 5, 6, 7, -1], output.eval())
 
+  def testIncrementalResize(self):
+    with self.test_session():
+      table = lookup.MutableDenseHashTable(
+          dtypes.int64,
+          dtypes.int64,
+          default_value=-1,
+          empty_key=0,
+          initial_num_buckets=2048)
+      keys = np.arange(1, 1601, dtype=np.int64)
+      table.insert(keys, keys).run()
+      self.assertAllEqual(1600, table.size().eval())
+
+      # This insert grows the table, and only moves part of the old buckets.
+      # It updates keys that haven't been moved yet.
+      keys2 = np.arange(1501, 1651, dtype=np.int64)
+      table.insert(keys2, keys2 + 10000).run()
+      self.assertAllEqual(1650, table.size().eval())
+
+      all_keys = np.arange(1, 1652, dtype=np.int64)
+      expected = np.concatenate([np.arange(1, 1501), np.arange(11501, 11651),
+                                 [-1]])
+      self.assertAllEqual(expected, table.lookup(all_keys).eval())
+
+      # Exporting completes the growth.
+      self.assertAllEqual(4096, len(table.export()[0].eval()))
+      self.assertAllEqual(1650, table.size().eval())
+      self.assertAllEqual(expected, table.lookup(all_keys).eval())
+
   def testExport(self):
     with self.test_session():
       keys = constant_op.constant([11, 12, 13], dtypes.int64)
@@ -1168,6 +1196,138 @@ class MutableDenseHashTableOpTest(test.TestCase):
         self.assertAllEqual(0, table2.size().eval())
 
 
+class DynamicEmbeddingTableOpTest(test.TestCase):
+
+  def testAdmitsAfterMinFrequency(self):
+    with self.test_session():
+      table = lookup.DynamicEmbeddingTable(
+          dtypes.int64,
+          dtypes.float32,
+          embedding_dim=2,
+          default_value=[-1.0, -1.0],
+          min_frequency=2)
+      ids = constant_op.constant([7, 8], dtypes.int64)
+      output = table.lookup(ids)
+      self.assertAllEqual([2, 2], output.get_shape())
+      self.assertAllEqual([[-1, -1], [-1, -1]], output.eval())
+      self.assertAllEqual(0, table.size().eval())
+
+      # The second lookup admits the IDs, with the default value.
+      output.eval()
+      self.assertAllEqual(2, table.size().eval())
+
+      table.insert(ids, constant_op.constant([[1, 2], [3, 4]],
+                                             dtypes.float32)).run()
+      self.assertAllEqual([[1, 2], [3, 4]], output.eval())
+
+  def testRandomInitialization(self):
+    embeddings = []
+    for _ in range(2):
+      with self.test_session(graph=ops.Graph()):
+        table = lookup.DynamicEmbeddingTable(
+            dtypes.string,
+            dtypes.float32,
+            embedding_dim=6,
+            initial_stddev=1.0,
+            seed=17)
+        embeddings.append(
+            table.lookup(constant_op.constant(["a", "b"])).eval())
+    # The initial embeddings only depend on the seed and the keys.
+    self.assertAllEqual(embeddings[0], embeddings[1])
+    self.assertFalse(np.array_equal(embeddings[0][0], embeddings[0][1]))
+    self.assertTrue(np.all(embeddings[0] != 0))
+
+  def testLruEviction(self):
+    with self.test_session():
+      table = lookup.DynamicEmbeddingTable(
+          dtypes.int64, dtypes.float32, embedding_dim=1, max_num_entries=2)
+      for ids in [[1, 2], [1], [3]]:
+        table.lookup(constant_op.constant(ids, dtypes.int64)).eval()
+      self.assertAllEqual(2, table.size().eval())
+      self.assertAllEqual([1, 3], sorted(table.export()[0].eval()))
+
+  def testLfuEviction(self):
+    with self.test_session():
+      table = lookup.DynamicEmbeddingTable(
+          dtypes.int64,
+          dtypes.float32,
+          embedding_dim=1,
+          max_num_entries=2,
+          eviction_policy="lfu")
+      for ids in [[1, 2], [2], [1], [2], [3]]:
+        table.lookup(constant_op.constant(ids, dtypes.int64)).eval()
+      self.assertAllEqual([2, 3], sorted(table.export()[0].eval()))
+
+  def testApplyGradients(self):
+    with self.test_session():
+      ids = constant_op.constant([5, 6], dtypes.int64)
+      sgd_table = lookup.DynamicEmbeddingTable(
+          dtypes.int64, dtypes.float32, embedding_dim=2)
+      adagrad_table = lookup.DynamicEmbeddingTable(
+          dtypes.int64,
+          dtypes.float32,
+          embedding_dim=2,
+          optimizer="adagrad",
+          initial_accumulator_value=0.1)
+      gradients = constant_op.constant([[1, 2], [3, 4]], dtypes.float32)
+      for table in [sgd_table, adagrad_table]:
+        # Only 5 is in the table, so the gradient of 6 is ignored.
+        table.insert(
+            constant_op.constant([5], dtypes.int64),
+            constant_op.constant([[1, 1]], dtypes.float32)).run()
+        table.apply_gradients(ids, gradients, 0.5).run()
+        self.assertAllEqual(1, table.size().eval())
+
+      self.assertAllClose([[0.5, 0.0]], sgd_table.export()[1].eval())
+      self.assertAllClose(
+          [[1 - 0.5 / np.sqrt(1.1), 1 - 1.0 / np.sqrt(4.1)]],
+          adagrad_table.export()[1].eval())
+      self.assertAllClose([[1.1, 4.1]], adagrad_table.export()[3].eval())
+
+  def testSaveRestore(self):
+    save_dir = os.path.join(self.get_temp_dir(), "save_restore")
+    save_path = os.path.join(tempfile.mkdtemp(prefix=save_dir), "embeddings")
+
+    with self.test_session(graph=ops.Graph()) as sess:
+      table = lookup.DynamicEmbeddingTable(
+          dtypes.int64,
+          dtypes.float32,
+          embedding_dim=2,
+          optimizer="adagrad",
+          name="t1",
+          checkpoint=True)
+      ids = constant_op.constant([11, 12], dtypes.int64)
+      table.lookup(ids).eval()
+      table.apply_gradients(
+          ids, constant_op.constant([[1, 1], [2, 2]], dtypes.float32),
+          1.0).run()
+      expected = [tensor.eval() for tensor in table.export()]
+
+      save = saver.Saver()
+      val = save.save(sess, save_path)
+      self.assertTrue(isinstance(val, six.string_types))
+      self.assertEqual(save_path, val)
+
+    with self.test_session(graph=ops.Graph()) as sess:
+      table = lookup.DynamicEmbeddingTable(
+          dtypes.int64,
+          dtypes.float32,
+          embedding_dim=2,
+          optimizer="adagrad",
+          name="t1",
+          checkpoint=True)
+      table.lookup(constant_op.constant([13], dtypes.int64)).eval()
+
+      save = saver.Saver()
+      save.restore(sess, save_path)
+
+      restored = [tensor.eval() for tensor in table.export()]
+      order = np.argsort(restored[0])
+      expected_order = np.argsort(expected[0])
+      for r, e in zip(restored, expected):
+        self.assertAllClose(e[expected_order], r[order])
+
+
 class IndexTableFromFile(test.TestCase):
 
   def _createVocabFile(self, basename, values=("brain", "salad", "surgery")):
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow/contrib/mpi/mpi_rendezvous_mgr.h"
 
+#include <algorithm>
 #include <chrono>
 #include <functional>
 #include <memory>
@@ -32,6 +33,13 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+// The data of a tensor sent on the optimal path is split into messages of at
+// most this many bytes. This lets MPI pipeline the transfer of large
+// tensors, and lifts the limit that the int counts of MPI put on their size.
+const size_t kMaxChunkBytes = 1 << 24;
+}  // namespace
+
 MPIRendezvousMgr::MPIRendezvousMgr(const WorkerEnv* env)
     : BaseRendezvousMgr(env), worker_env_2(env), use_optimal_transfer_(false) {
 
@@ -122,10 +130,21 @@ void MPIRemoteRendezvous::RecvFromRemoteAsync(
       tr.InitAlloc(dst_device, recv_args.alloc_attrs);
       tr.InitPartial(mpi_response.response());
       const size_t nBytes = tr.tensor().TotalBytes();
-      void* data = const_cast<void*>(DMAHelper::base(&tr.tensor()));
-      MPI_Status status;
-      MPI_CHECK(MPI_Recv(data, static_cast<int>(nBytes), MPI_BYTE, dst,
-                         TAG_SENDTENSOR2, MPI_COMM_WORLD, &status));
+      char* data =
+          static_cast<char*>(const_cast<void*>(DMAHelper::base(&tr.tensor())));
+      // Messages with the same source and tag arrive in the order they were
+      // sent, so the chunks can all be received at once.
+      std::vector<MPI_Request> requests;
+      for (size_t offset = 0; offset < nBytes; offset += kMaxChunkBytes) {
+        const int chunk_size =
+            static_cast<int>(std::min(kMaxChunkBytes, nBytes - offset));
+        requests.emplace_back();
+        MPI_CHECK(MPI_Irecv(data + offset, chunk_size, MPI_BYTE, dst,
+                            TAG_SENDTENSOR2, MPI_COMM_WORLD,
+                            &requests.back()));
+      }
+      MPI_CHECK(MPI_Waitall(static_cast<int>(requests.size()),
+                            requests.data(), MPI_STATUSES_IGNORE));
       val = std::move(tr.tensor());
     }
 
@@ -177,17 +196,24 @@ void MPIRendezvousMgr::AddRequest(RecvTensorRequest request,
                        MPI_STATUS_IGNORE));
 
     if (!mpi_send_call->mRes_.singlesend()) {
-      const int tensor_size = static_cast<int>(val.TotalBytes());
-      void* temp = const_cast<void*>(DMAHelper::base(&val));
+      const size_t tensor_size = val.TotalBytes();
+      char* temp = static_cast<char*>(const_cast<void*>(DMAHelper::base(&val)));
 
       // If the MPI library is not GPU aware there should be a data transfer
       // here to get the data on the host.
       // if(src_dev->tensorflow_gpu_device_info()) //memcpy to send_buffer2_
 
-      // TODO(jbedorf)  this should be a loop over max size
-      MPI_CHECK(MPI_Isend(temp, tensor_size, MPI_CHAR, mpi_dst, TAG_SENDTENSOR2,
-                          MPI_COMM_WORLD, &mpi_send_call->msg2_));
-      mpi_send_call->done2_ = 0;
+      std::vector<MPI_Request>& requests = mpi_send_call->msg2_;
+      requests.reserve((tensor_size + kMaxChunkBytes - 1) / kMaxChunkBytes);
+      for (size_t offset = 0; offset < tensor_size; offset += kMaxChunkBytes) {
+        const int chunk_size =
+            static_cast<int>(std::min(kMaxChunkBytes, tensor_size - offset));
+        requests.emplace_back();
+        MPI_CHECK(MPI_Isend(temp + offset, chunk_size, MPI_CHAR, mpi_dst,
+                            TAG_SENDTENSOR2, MPI_COMM_WORLD,
+                            &requests.back()));
+      }
+      mpi_send_call->done2_ = requests.empty() ? 1 : 0;
     }
     return mpi_send_call;
   };
@@ -29,6 +29,7 @@ limitations under the License.
 #include <vector>
 
 #include <iostream>
+#include <vector>
 
 #include "tensorflow/contrib/mpi/mpi_utils.h"
 #include "tensorflow/core/distributed_runtime/base_rendezvous_mgr.h"
@@ -48,7 +49,7 @@ class MPISendTensorCall {
   char* send_buffer2_;
 
   MPI_Request msg1_;
-  MPI_Request msg2_;
+  std::vector<MPI_Request> msg2_;  // One request per chunk of tensor data
   int done1_;  // Int instead of bool for simpler IsFinished logic
   int done2_;
   MPIRecvTensorResponse mRes_;
@@ -80,7 +81,10 @@ class MPISendTensorCall {
   bool IsFinished() {
     MPI_Status status;
     if (!done1_) MPI_CHECK(MPI_Test(&msg1_, &done1_, &status));
-    if (!done2_) MPI_CHECK(MPI_Test(&msg2_, &done2_, &status));
+    if (!done2_) {
+      MPI_CHECK(MPI_Testall(static_cast<int>(msg2_.size()), msg2_.data(),
+                            &done2_, MPI_STATUSES_IGNORE));
+    }
     return done1_ && done2_;
   }
 };
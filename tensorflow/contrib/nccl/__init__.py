@@ -14,11 +14,15 @@
 # ==============================================================================
 """Functions for using NVIDIA nccl collective ops.
 
+@@all_gather
 @@all_max
 @@all_min
 @@all_prod
 @@all_sum
 @@broadcast
+@@fused_hierarchical_all_sum
+@@hierarchical_all_sum
+@@reduce_scatter_sum
 
 """
 
@@ -26,11 +30,15 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+from tensorflow.contrib.nccl.python.ops.nccl_ops import all_gather
 from tensorflow.contrib.nccl.python.ops.nccl_ops import all_max
 from tensorflow.contrib.nccl.python.ops.nccl_ops import all_min
 from tensorflow.contrib.nccl.python.ops.nccl_ops import all_prod
 from tensorflow.contrib.nccl.python.ops.nccl_ops import all_sum
 from tensorflow.contrib.nccl.python.ops.nccl_ops import broadcast
+from tensorflow.contrib.nccl.python.ops.nccl_ops import fused_hierarchical_all_sum
+from tensorflow.contrib.nccl.python.ops.nccl_ops import hierarchical_all_sum
+from tensorflow.contrib.nccl.python.ops.nccl_ops import reduce_scatter_sum
 
 from tensorflow.python.util.all_util import remove_undocumented
 remove_undocumented(__name__)
@@ -130,6 +130,9 @@ struct NcclManager::Participant {
   NcclManager::DoneCallback done_callback;
 
   bool root = false;
+
+  // The rank requested by the caller, or -1 to let NcclManager pick one.
+  int rank = -1;
 };
 
 // A Collective tracks a single communicator operation (e.g., a single
@@ -178,10 +181,12 @@ NcclManager* NcclManager::instance() {
 
 NcclManager::Communicator* NcclManager::GetCommunicator(
     NcclManager::Collective* collective) {
-  // Sort by executor to make ordering of executors deterministic.
+  // Sort by the requested ranks, or else by executor to make ordering of
+  // executors deterministic.
   std::sort(collective->participants.begin(), collective->participants.end(),
             [](const std::unique_ptr<Participant>& a,
                const std::unique_ptr<Participant>& b) {
+              if (a->rank != b->rank) return a->rank < b->rank;
               return a->executor < b->executor;
             });
   const int num_devices = collective->participants.size();
@@ -307,6 +312,33 @@ void NcclManager::AddBroadcastRecv(
                  kBroadcast, ncclSum /* unused */);
 }
 
+void NcclManager::AddToReduceScatter(
+    int num_devices, int rank, const string& key, ncclRedOp_t reduction_op,
+    perftools::gputools::StreamExecutor* executor, int gpu_device_id,
+    EventMgr* event_mgr, perftools::gputools::Stream* tensor_stream,
+    const Tensor* in_t, Tensor* out_t, const DoneCallback& done_callback) {
+  std::unique_ptr<Participant> participant(
+      new Participant(in_t, out_t, event_mgr, tensor_stream, executor,
+                      gpu_device_id, done_callback));
+  participant->rank = rank;
+  AddParticipant(num_devices, key, std::move(participant), in_t->dtype(),
+                 kReduceScatter, reduction_op);
+}
+
+void NcclManager::AddToAllGather(int num_devices, int rank, const string& key,
+                                 perftools::gputools::StreamExecutor* executor,
+                                 int gpu_device_id, EventMgr* event_mgr,
+                                 perftools::gputools::Stream* tensor_stream,
+                                 const Tensor* in_t, Tensor* out_t,
+                                 const DoneCallback& done_callback) {
+  std::unique_ptr<Participant> participant(
+      new Participant(in_t, out_t, event_mgr, tensor_stream, executor,
+                      gpu_device_id, done_callback));
+  participant->rank = rank;
+  AddParticipant(num_devices, key, std::move(participant), in_t->dtype(),
+                 kAllGather, ncclSum /* unused */);
+}
+
 void NcclManager::AddParticipant(int num_devices, const string& key,
                                  std::unique_ptr<Participant> participant,
                                  DataType data_type,
@@ -431,6 +463,21 @@ void NcclManager::LoopKernelLaunches(NcclStream* nccl_stream) {
                                 collective->root_rank, nccl_comm, *cu_stream);
         break;
       }
+      case kReduceScatter: {
+        const void* sendbuff = p->in_t->tensor_data().data();
+        void* recvbuff = const_cast<char*>(p->out_t->tensor_data().data());
+        nccl_result = ncclReduceScatter(
+            sendbuff, recvbuff, p->out_t->NumElements(), data_type,
+            collective->reduction_op, nccl_comm, *cu_stream);
+        break;
+      }
+      case kAllGather: {
+        const void* sendbuff = p->in_t->tensor_data().data();
+        void* recvbuff = const_cast<char*>(p->out_t->tensor_data().data());
+        nccl_result = ncclAllGather(sendbuff, p->in_t->NumElements(),
+                                    data_type, recvbuff, nccl_comm, *cu_stream);
+        break;
+      }
     }
 
     // Run the done_callback when the nccl kernel finishes running.
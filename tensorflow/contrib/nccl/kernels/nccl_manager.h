@@ -75,10 +75,33 @@ class NcclManager {
                         perftools::gputools::Stream* tensor_stream,
                         Tensor* out_t, DoneCallback done_callback);
 
+  // Add one participant to a reduce-scatter. The participant with rank <rank>
+  // receives in <out_t> the reduction of the <rank>-th of <num_devices> equal
+  // chunks of the flattened inputs. Ranks go from 0 to <num_devices>-1 and
+  // must be the same for the all-gather that puts the chunks back together.
+  void AddToReduceScatter(int num_devices, int rank, const string& key,
+                          ncclRedOp_t reduction_op,
+                          perftools::gputools::StreamExecutor* executor,
+                          int gpu_device_id, EventMgr* event_mgr,
+                          perftools::gputools::Stream* tensor_stream,
+                          const Tensor* in_t, Tensor* out_t,
+                          const DoneCallback& done_callback);
+
+  // Add one participant to an all-gather. Every participant receives in
+  // <out_t> the concatenation of the flattened inputs, ordered by rank.
+  void AddToAllGather(int num_devices, int rank, const string& key,
+                      perftools::gputools::StreamExecutor* executor,
+                      int gpu_device_id, EventMgr* event_mgr,
+                      perftools::gputools::Stream* tensor_stream,
+                      const Tensor* in_t, Tensor* out_t,
+                      const DoneCallback& done_callback);
+
  private:
   enum CollectiveType {
     kAllReduce = 1,
     kBroadcast = 2,
+    kReduceScatter = 3,
+    kAllGather = 4,
   };
   struct Collective;
   struct Communicator;
@@ -203,6 +203,49 @@ TEST_F(NcclManagerTest, BasicSumReduction) {
   }
 }
 
+// Test that a reduce-scatter followed by an all-gather with the same ranks
+// gives the all-reduce result.
+TEST_F(NcclManagerTest, ReduceScatterThenAllGather) {
+  const int num_ranks = 3;
+
+  std::unique_ptr<TestCase> test_case(
+      MakeTestCase(num_ranks, ncclSum, TensorShape({2, 3}), 0));
+  std::vector<Tensor> chunks;
+  for (int rank = 0; rank < num_ranks; ++rank) {
+    auto* device = devices->at(rank % devices->size());
+    chunks.emplace_back(gpu_allocator(device), DT_FLOAT, TensorShape({2}));
+  }
+  TestCase scatter_done;
+  for (int rank = 0; rank < num_ranks; ++rank) {
+    auto* device = devices->at(rank % devices->size());
+    auto* event_mgr = device->tensorflow_gpu_device_info()->event_mgr;
+    auto* stream = device->tensorflow_gpu_device_info()->stream;
+    NcclManager::instance()->AddToReduceScatter(
+        num_ranks, rank, "reducescatter", ncclSum, device->executor(),
+        device->gpu_id(), event_mgr, stream, &test_case->ins[rank],
+        &chunks[rank], CreateDoneCallback(&scatter_done));
+  }
+  scatter_done.mu.lock();
+  while (scatter_done.num_completed != num_ranks) {
+    scatter_done.mu.unlock();
+    Env::Default()->SleepForMicroseconds(10);
+    scatter_done.mu.lock();
+  }
+  scatter_done.mu.unlock();
+  TF_ASSERT_OK(scatter_done.final_status);
+
+  for (int rank = 0; rank < num_ranks; ++rank) {
+    auto* device = devices->at(rank % devices->size());
+    auto* event_mgr = device->tensorflow_gpu_device_info()->event_mgr;
+    auto* stream = device->tensorflow_gpu_device_info()->stream;
+    NcclManager::instance()->AddToAllGather(
+        num_ranks, rank, "allgather", device->executor(), device->gpu_id(),
+        event_mgr, stream, &chunks[rank], &test_case->outs[rank],
+        CreateDoneCallback(test_case.get()));
+  }
+  VerifyResults("test_case", test_case.get());
+}
+
 // Same as the Basic test, but with multiple threads launching parts of many
 // reductions.
 //
@@ -58,25 +58,33 @@ class NcclAsyncOpBase : public AsyncOpKernel {
   TF_DISALLOW_COPY_AND_ASSIGN(NcclAsyncOpBase);
 };
 
+namespace {
+
+Status GetReductionOp(OpKernelConstruction* c, ncclRedOp_t* reduction_op) {
+  string reduction;
+  TF_RETURN_IF_ERROR(c->GetAttr("reduction", &reduction));
+  if (reduction == "min") {
+    *reduction_op = ncclMin;
+  } else if (reduction == "max") {
+    *reduction_op = ncclMax;
+  } else if (reduction == "sum") {
+    *reduction_op = ncclSum;
+  } else if (reduction == "prod") {
+    *reduction_op = ncclProd;
+  } else {
+    return errors::InvalidArgument("Invalid reduction: ", reduction);
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
 // To execute a single all-reduce, this kernel is called once for each of the
 // <k> devices in the communicator.
 class NcclAllReduceOpKernel : public NcclAsyncOpBase {
  public:
   explicit NcclAllReduceOpKernel(OpKernelConstruction* c) : NcclAsyncOpBase(c) {
-    string reduction;
-    OP_REQUIRES_OK(c, c->GetAttr("reduction", &reduction));
-    if (reduction == "min") {
-      reduction_op_ = ncclMin;
-    } else if (reduction == "max") {
-      reduction_op_ = ncclMax;
-    } else if (reduction == "sum") {
-      reduction_op_ = ncclSum;
-    } else if (reduction == "prod") {
-      reduction_op_ = ncclProd;
-    } else {
-      OP_REQUIRES_OK(c,
-                     errors::InvalidArgument("Invalid reduction: ", reduction));
-    }
+    OP_REQUIRES_OK(c, GetReductionOp(c, &reduction_op_));
   }
 
   void ComputeAsync(OpKernelContext* c, DoneCallback done) override {
@@ -104,6 +112,95 @@ class NcclAllReduceOpKernel : public NcclAsyncOpBase {
 REGISTER_KERNEL_BUILDER(Name("NcclAllReduce").Device(DEVICE_GPU),
                         NcclAllReduceOpKernel);
 
+// Like NcclAllReduceOpKernel, but the output of the kernel with rank <r> only
+// holds the <r>-th chunk of the flattened reduction.
+class NcclReduceScatterOpKernel : public NcclAsyncOpBase {
+ public:
+  explicit NcclReduceScatterOpKernel(OpKernelConstruction* c)
+      : NcclAsyncOpBase(c) {
+    OP_REQUIRES_OK(c, GetReductionOp(c, &reduction_op_));
+    OP_REQUIRES_OK(c, c->GetAttr("rank", &rank_));
+    OP_REQUIRES(c, rank_ >= 0 && rank_ < num_devices(),
+                errors::InvalidArgument("rank must be in [0, ", num_devices(),
+                                        "), got ", rank_));
+  }
+
+  void ComputeAsync(OpKernelContext* c, DoneCallback done) override {
+    const Tensor* in_t = &c->input(0);
+    OP_REQUIRES_ASYNC(
+        c, in_t->NumElements() % num_devices() == 0,
+        errors::InvalidArgument("The number of elements of the input, ",
+                                in_t->NumElements(),
+                                ", must be a multiple of num_devices, ",
+                                num_devices()),
+        done);
+    Tensor* out_t;
+    OP_REQUIRES_OK_ASYNC(
+        c,
+        c->allocate_output(
+            0, TensorShape({in_t->NumElements() / num_devices()}), &out_t),
+        done);
+
+    auto actual_done = [c, done](Status s) {
+      OP_REQUIRES_OK_ASYNC(c, s, done);
+      done();
+    };
+
+    auto* compute_stream = c->op_device_context()->stream();
+    auto* gpu_info = c->device()->tensorflow_gpu_device_info();
+    NcclManager::instance()->AddToReduceScatter(
+        num_devices(), rank_, GetCollectiveKey(c), reduction_op_,
+        compute_stream->parent(), gpu_info->gpu_id, gpu_info->event_mgr,
+        compute_stream, in_t, out_t, actual_done);
+  }
+
+ private:
+  ncclRedOp_t reduction_op_;
+  int rank_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("NcclReduceScatter").Device(DEVICE_GPU),
+                        NcclReduceScatterOpKernel);
+
+class NcclAllGatherOpKernel : public NcclAsyncOpBase {
+ public:
+  explicit NcclAllGatherOpKernel(OpKernelConstruction* c)
+      : NcclAsyncOpBase(c) {
+    OP_REQUIRES_OK(c, c->GetAttr("rank", &rank_));
+    OP_REQUIRES(c, rank_ >= 0 && rank_ < num_devices(),
+                errors::InvalidArgument("rank must be in [0, ", num_devices(),
+                                        "), got ", rank_));
+  }
+
+  void ComputeAsync(OpKernelContext* c, DoneCallback done) override {
+    const Tensor* in_t = &c->input(0);
+    Tensor* out_t;
+    OP_REQUIRES_OK_ASYNC(
+        c,
+        c->allocate_output(
+            0, TensorShape({in_t->NumElements() * num_devices()}), &out_t),
+        done);
+
+    auto actual_done = [c, done](Status s) {
+      OP_REQUIRES_OK_ASYNC(c, s, done);
+      done();
+    };
+
+    auto* compute_stream = c->op_device_context()->stream();
+    auto* gpu_info = c->device()->tensorflow_gpu_device_info();
+    NcclManager::instance()->AddToAllGather(
+        num_devices(), rank_, GetCollectiveKey(c), compute_stream->parent(),
+        gpu_info->gpu_id, gpu_info->event_mgr, compute_stream, in_t, out_t,
+        actual_done);
+  }
+
+ private:
+  int rank_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("NcclAllGather").Device(DEVICE_GPU),
+                        NcclAllGatherOpKernel);
+
 class NcclBroadcastSendKernel : public NcclAsyncOpBase {
  public:
   explicit NcclBroadcastSendKernel(OpKernelConstruction* c)
@@ -18,6 +18,7 @@ limitations under the License.
 
 namespace tensorflow {
 
+using shape_inference::DimensionHandle;
 using shape_inference::InferenceContext;
 using shape_inference::ShapeHandle;
 
@@ -45,6 +46,75 @@ num_devices: The number of devices participating in this reduction.
 shared_name: Identifier that shared between ops of the same reduction.
 )doc");
 
+REGISTER_OP("NcclReduceScatter")
+    .Input("input: T")
+    .Output("data: T")
+    .Attr("reduction: {'min', 'max', 'prod', 'sum'}")
+    .Attr("T: {float, float64, int32, int64}")
+    .Attr("num_devices: int")
+    .Attr("rank: int")
+    .Attr("shared_name: string")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      int num_devices;
+      TF_RETURN_IF_ERROR(c->GetAttr("num_devices", &num_devices));
+      DimensionHandle num_elements = c->NumElements(c->input(0));
+      DimensionHandle out;
+      TF_RETURN_IF_ERROR(c->Divide(num_elements, num_devices,
+                                   true /* evenly_divisible */, &out));
+      c->set_output(0, c->Vector(out));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Outputs one chunk of the reduction across all input tensors passed to ops
+within the same `shared_name`.
+
+The inputs are flattened and split into `num_devices` chunks of equal size, and
+the op with rank `r` outputs the reduction of the `r`-th chunks. The graph
+should be constructed so that `num_devices` ops, with ranks 0 to
+`num_devices`-1, run with the same shared_name value.
+
+input: the input to the reduction; its number of elements must be a multiple
+  of `num_devices`.
+data: the `rank`-th chunk of the reduction across all `num_devices` devices.
+reduction: the reduction operation to perform.
+num_devices: The number of devices participating in this reduction.
+rank: The index of the chunk this device receives.
+shared_name: Identifier that shared between ops of the same reduction.
+)doc");
+
+REGISTER_OP("NcclAllGather")
+    .Input("input: T")
+    .Output("data: T")
+    .Attr("T: {float, float64, int32, int64}")
+    .Attr("num_devices: int")
+    .Attr("rank: int")
+    .Attr("shared_name: string")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      int num_devices;
+      TF_RETURN_IF_ERROR(c->GetAttr("num_devices", &num_devices));
+      DimensionHandle out;
+      TF_RETURN_IF_ERROR(
+          c->Multiply(c->NumElements(c->input(0)), num_devices, &out));
+      c->set_output(0, c->Vector(out));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Outputs the concatenation of the flattened input tensors passed to ops within
+the same `shared_name`, ordered by rank.
+
+The graph should be constructed so that `num_devices` ops, with ranks 0 to
+`num_devices`-1, run with the same shared_name value. All the inputs must have
+the same number of elements.
+
+input: the input to gather.
+data: the concatenation of the inputs of all `num_devices` devices.
+num_devices: The number of devices participating in this gather.
+rank: The position of this device's input in the output.
+shared_name: Identifier that shared between ops of the same gather.
+)doc");
+
 REGISTER_OP("NcclBroadcastSend")
     .Input("input: T")
     .Attr("T: {float, float64, int32, int64}")
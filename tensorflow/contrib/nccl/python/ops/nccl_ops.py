@@ -25,6 +25,7 @@ from tensorflow.python.framework import device
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import ops
 from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
 from tensorflow.python.platform import resource_loader
 
 _nccl_ops_so = loader.load_op_library(
@@ -137,6 +138,227 @@ def broadcast(src_tensor, dst_devices):
   return send, recvs
 
 
+def reduce_scatter_sum(tensors):
+  """Returns the chunks of the all-reduce sum across `tensors`.
+
+  The sum of the flattened `tensors` is split into `len(tensors)` chunks of
+  equal size, and each device only receives its own chunk. This moves half the
+  data of `all_sum`. If only some of the returned tensors are evaluated then the
+  computation will hang.
+
+  Args:
+    tensors: The input tensors across which to sum; must be assigned to GPU
+      devices, and have a number of elements that is a multiple of
+      `len(tensors)`.
+
+  Returns:
+    List of 1-D tensors, where tensor i has the same device as `tensors[i]` and
+    holds the i-th chunk of the flattened sum.
+  """
+  if not tensors:
+    raise ValueError('Must pass >0 tensors to reduce_scatter_sum')
+  shared_name = _get_shared_name()
+  res = []
+  for rank, t in enumerate(tensors):
+    if not device.canonical_name(t.device):
+      raise ValueError('Device assignment required for nccl collective ops')
+    with ops.device(t.device):
+      res.append(
+          gen_nccl_ops.nccl_reduce_scatter(
+              t,
+              reduction='sum',
+              num_devices=len(tensors),
+              rank=rank,
+              shared_name=shared_name))
+  return res
+
+
+def all_gather(tensors):
+  """Returns a list of tensors with the concatenation of `tensors`.
+
+  If only some of the returned tensors are evaluated then the computation will
+  hang.
+
+  Args:
+    tensors: The input tensors to gather; must be assigned to GPU devices and
+      have the same number of elements.
+
+  Returns:
+    List of 1-D tensors, where tensor i has the same device as `tensors[i]` and
+    holds the concatenation of the flattened `tensors`, in order.
+  """
+  if not tensors:
+    raise ValueError('Must pass >0 tensors to all_gather')
+  shared_name = _get_shared_name()
+  res = []
+  for rank, t in enumerate(tensors):
+    if not device.canonical_name(t.device):
+      raise ValueError('Device assignment required for nccl collective ops')
+    with ops.device(t.device):
+      res.append(
+          gen_nccl_ops.nccl_all_gather(
+              t,
+              num_devices=len(tensors),
+              rank=rank,
+              shared_name=shared_name))
+  return res
+
+
+def hierarchical_all_sum(per_node_tensors):
+  """Returns the all-reduce sum across the GPUs of several nodes.
+
+  Within each node, the tensors are reduce-scattered with nccl, so that GPU j
+  of every node holds chunk j of the sum of its node. Chunk j is then summed
+  across the nodes on GPU j of node `j % num_nodes`, through the distributed
+  runtime, and the sum is gathered back into a full tensor on every GPU with
+  nccl. Each node thus only sends and receives one copy of the data over the
+  network, spread over all its GPUs, instead of sending every tensor to a
+  parameter server.
+
+  Args:
+    per_node_tensors: A list with, for each node, the list of tensors to sum
+      that are on the GPUs of that node. All the nodes must have the same number
+      of tensors, and all the tensors must have the same fully defined shape.
+
+  Returns:
+    A list with, for each node, the list of the sums, where
+    `per_node_tensors[i][j]` and the returned tensor `[i][j]` have the same
+    device.
+  """
+  if not per_node_tensors or not per_node_tensors[0]:
+    raise ValueError('Must pass >0 nodes with >0 tensors to '
+                     'hierarchical_all_sum')
+  num_nodes = len(per_node_tensors)
+  num_gpus = len(per_node_tensors[0])
+  shape = per_node_tensors[0][0].get_shape()
+  if not shape.is_fully_defined():
+    raise ValueError('hierarchical_all_sum requires fully defined shapes, got '
+                     '%s' % shape)
+  for node in per_node_tensors:
+    if len(node) != num_gpus:
+      raise ValueError('All nodes must have the same number of tensors')
+    for t in node:
+      if not shape.is_compatible_with(t.get_shape()):
+        raise ValueError('All tensors must have the same shape, got %s and %s'
+                         % (shape, t.get_shape()))
+
+  # Pad the flattened tensors so that they split evenly across the GPUs.
+  num_elements = shape.num_elements()
+  padding = -num_elements % num_gpus
+  per_node_flat = []
+  for node in per_node_tensors:
+    flats = []
+    for t in node:
+      with ops.device(t.device):
+        flat = array_ops.reshape(t, [-1])
+        if padding:
+          flat = array_ops.concat(
+              [flat, array_ops.zeros([padding], dtype=t.dtype)], 0)
+      flats.append(flat)
+    per_node_flat.append(flats)
+
+  per_node_chunks = [reduce_scatter_sum(flats) for flats in per_node_flat]
+
+  per_node_sums = [[None] * num_gpus for _ in range(num_nodes)]
+  for j in range(num_gpus):
+    chunks = [node_chunks[j] for node_chunks in per_node_chunks]
+    if num_nodes == 1:
+      per_node_sums[0][j] = chunks[0]
+      continue
+    with ops.device(chunks[j % num_nodes].device):
+      total = math_ops.add_n(chunks)
+    for i in range(num_nodes):
+      with ops.device(chunks[i].device):
+        per_node_sums[i][j] = array_ops.identity(total)
+
+  res = []
+  for node_sums in per_node_sums:
+    gathered = all_gather(node_sums)
+    node_res = []
+    for t in gathered:
+      with ops.device(t.device):
+        if padding:
+          t = array_ops.slice(t, [0], [num_elements])
+        node_res.append(array_ops.reshape(t, shape))
+    res.append(node_res)
+  return res
+
+
+def fused_hierarchical_all_sum(per_node_tensor_lists,
+                               fusion_threshold_bytes=4 * 1024 * 1024):
+  """Sums lists of tensors, such as gradients, with `hierarchical_all_sum`.
+
+  Small tensors are concatenated into buckets of up to `fusion_threshold_bytes`
+  that are summed together, so that the nccl kernels and the transfers between
+  nodes aren't dominated by their fixed cost.
+
+  Args:
+    per_node_tensor_lists: A list with, for each node, a list with, for each
+      GPU of the node, the list of tensors to sum on that GPU. The lists of all
+      the GPUs must have tensors of the same shapes and dtypes in the same
+      order.
+    fusion_threshold_bytes: The maximum size of a bucket. Tensors that are
+      larger are summed on their own.
+
+  Returns:
+    A list with the same structure as `per_node_tensor_lists`, holding the sums.
+  """
+  if not per_node_tensor_lists or not per_node_tensor_lists[0]:
+    raise ValueError('Must pass >0 nodes with >0 GPUs to '
+                     'fused_hierarchical_all_sum')
+  reference = per_node_tensor_lists[0][0]
+  for node in per_node_tensor_lists:
+    for tensors in node:
+      if len(tensors) != len(reference):
+        raise ValueError('All GPUs must have the same number of tensors')
+
+  res = [[[None] * len(reference) for _ in node]
+         for node in per_node_tensor_lists]
+  for bucket in _fusion_buckets(reference, fusion_threshold_bytes):
+    shapes = [reference[k].get_shape() for k in bucket]
+    sizes = [s.num_elements() for s in shapes]
+    per_node_fused = []
+    for node in per_node_tensor_lists:
+      fused = []
+      for tensors in node:
+        with ops.device(tensors[bucket[0]].device):
+          fused.append(
+              array_ops.concat(
+                  [array_ops.reshape(tensors[k], [-1]) for k in bucket], 0))
+      per_node_fused.append(fused)
+    per_node_sums = hierarchical_all_sum(per_node_fused)
+    for i, node_sums in enumerate(per_node_sums):
+      for j, t in enumerate(node_sums):
+        with ops.device(t.device):
+          for k, part, s in zip(bucket, array_ops.split(t, sizes), shapes):
+            res[i][j][k] = array_ops.reshape(part, s)
+  return res
+
+
+def _fusion_buckets(tensors, fusion_threshold_bytes):
+  """Returns lists of the indices of `tensors` to concatenate together.
+
+  Consecutive tensors of the same dtype share a bucket as long as the bucket
+  is at most `fusion_threshold_bytes`.
+  """
+  buckets = []
+  bucket_bytes = 0
+  bucket_dtype = None
+  for k, t in enumerate(tensors):
+    shape = t.get_shape()
+    if not shape.is_fully_defined():
+      raise ValueError('Fusion requires fully defined shapes, got %s' % shape)
+    num_bytes = shape.num_elements() * t.dtype.size
+    if (not buckets or t.dtype != bucket_dtype or
+        bucket_bytes + num_bytes > fusion_threshold_bytes):
+      buckets.append([])
+      bucket_bytes = 0
+      bucket_dtype = t.dtype
+    buckets[-1].append(k)
+    bucket_bytes += num_bytes
+  return buckets
+
+
 def _apply_all_reduce(reduction_op, tensors):
   if not tensors:
     raise ValueError('Must pass >0 tensors to all reduce operations')
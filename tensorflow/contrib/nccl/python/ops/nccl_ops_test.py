@@ -21,6 +21,8 @@ from __future__ import print_function
 import numpy as np
 
 from tensorflow.contrib import nccl
+from tensorflow.contrib.nccl.python.ops import nccl_ops
+from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import ops
 from tensorflow.python.ops import array_ops
 from tensorflow.python.platform import test
@@ -147,5 +149,111 @@ class CombinedTest(test.TestCase):
             self.assertAllClose(r, np_ans)
 
 
+class HierarchicalAllSumTest(test.TestCase):
+
+  def testReduceScatterAllGather(self):
+    if not test.is_gpu_available():
+      return  # Test requires access to a GPU
+
+    with self.test_session(use_gpu=True) as sess:
+      devices = ['/gpu:0', '/gpu:0', '/gpu:0']
+      np_ans = np.zeros(shape=(3, 4), dtype=np.float32)
+      tensors = []
+      for d in devices:
+        with ops.device(d):
+          t = np.random.random_sample((3, 4)).astype(np.float32)
+          np_ans += t
+          tensors.append(array_ops.identity(t))
+      chunks = nccl.reduce_scatter_sum(tensors)
+      for c in chunks:
+        self.assertEqual((4,), c.get_shape())
+      gathered = nccl.all_gather(chunks)
+      for g in gathered:
+        self.assertEqual((12,), g.get_shape())
+
+      results = sess.run(chunks + gathered)
+      for i, r in enumerate(results[:len(devices)]):
+        self.assertAllClose(r, np_ans.flatten()[4 * i:4 * (i + 1)])
+      for r in results[len(devices):]:
+        self.assertAllClose(r, np_ans.flatten())
+
+  def testHierarchicalAllSum(self):
+    if not test.is_gpu_available():
+      return  # Test requires access to a GPU
+
+    with self.test_session(use_gpu=True) as sess:
+      # Two nodes of two GPUs. The number of elements is not a multiple of the
+      # number of GPUs, to test the padding.
+      shape = (3, 5)
+      np_ans = np.zeros(shape=shape, dtype=np.float32)
+      per_node_tensors = []
+      for _ in range(2):
+        node = []
+        for _ in range(2):
+          with ops.device('/gpu:0'):
+            t = np.random.random_sample(shape).astype(np.float32)
+            np_ans += t
+            node.append(array_ops.identity(t))
+        per_node_tensors.append(node)
+      sums = nccl.hierarchical_all_sum(per_node_tensors)
+      results = sess.run(sums)
+      for node in results:
+        for r in node:
+          self.assertAllClose(r, np_ans)
+
+  def testFusedHierarchicalAllSum(self):
+    if not test.is_gpu_available():
+      return  # Test requires access to a GPU
+
+    with self.test_session(use_gpu=True) as sess:
+      shapes = [(2, 3), (5,), (4, 4), (1,)]
+      np_ans = [np.zeros(shape=s, dtype=np.float32) for s in shapes]
+      per_node_tensor_lists = []
+      for _ in range(2):
+        node = []
+        for _ in range(2):
+          tensors = []
+          with ops.device('/gpu:0'):
+            for k, s in enumerate(shapes):
+              t = np.random.random_sample(s).astype(np.float32)
+              np_ans[k] += t
+              tensors.append(array_ops.identity(t))
+          node.append(tensors)
+        per_node_tensor_lists.append(node)
+      sums = nccl.fused_hierarchical_all_sum(
+          per_node_tensor_lists, fusion_threshold_bytes=64)
+      results = sess.run(sums)
+      for node in results:
+        for tensors in node:
+          for k, r in enumerate(tensors):
+            self.assertAllClose(r, np_ans[k])
+
+  def testFusionBuckets(self):
+    tensors = [
+        array_ops.zeros([4], dtype=dtypes.float32),
+        array_ops.zeros([8], dtype=dtypes.float32),
+        array_ops.zeros([2], dtype=dtypes.float64),
+        array_ops.zeros([16], dtype=dtypes.float64),
+        array_ops.zeros([1], dtype=dtypes.float64),
+    ]
+    self.assertEqual([[0, 1], [2], [3], [4]],
+                     nccl_ops._fusion_buckets(tensors, 64))
+    self.assertEqual([[0, 1], [2, 3, 4]],
+                     nccl_ops._fusion_buckets(tensors, 1024))
+    self.assertEqual([[0], [1], [2], [3], [4]],
+                     nccl_ops._fusion_buckets(tensors, 1))
+
+  def testErrors(self):
+    with self.assertRaisesRegexp(ValueError, 'Must pass >0 nodes'):
+      nccl.hierarchical_all_sum([])
+    with ops.device('/gpu:0'):
+      a = array_ops.zeros([3])
+      b = array_ops.zeros([4])
+    with self.assertRaisesRegexp(ValueError, 'same number of tensors'):
+      nccl.hierarchical_all_sum([[a, a], [a]])
+    with self.assertRaisesRegexp(ValueError, 'same shape'):
+      nccl.hierarchical_all_sum([[a, b]])
+
+
 if __name__ == '__main__':
   test.main()
@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/contrib/rnn/kernels/lstm_ops.h"
 
 #include <memory>
+#include <type_traits>
 #include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -618,6 +619,132 @@ class SliceHelper {
   const Device& device_;
 };
 
+// The forward pass of BlockLSTM on the CPU. The input projections x * w_x + b
+// of all the timesteps are computed up front by one matrix multiplication,
+// which packs w_x once, leaving only h_prev * w_h in the loop over time. The
+// time slices are addressed in place through unaligned maps, so nothing is
+// copied whatever the alignment of batch_size * cell_size.
+template <typename T>
+void BlockLSTMFpropCPU(const CPUDevice& d, const int64 seq_len_max,
+                       const int64 batch_size, const int64 input_size,
+                       const int64 cell_size, const T forget_bias,
+                       const T cell_clip, const bool use_peephole,
+                       const Tensor& x, const Tensor& cs_prev,
+                       const Tensor& h_prev, const Tensor& w,
+                       const Tensor& wci, const Tensor& wcf, const Tensor& wco,
+                       const Tensor& b, Tensor* icfo_seq, Tensor* i_out,
+                       Tensor* cs_out, Tensor* f_out, Tensor* o_out,
+                       Tensor* ci_out, Tensor* co_out, Tensor* h_out) {
+  typedef typename TTypes<T>::UnalignedMatrix Matrix;
+  typedef typename TTypes<T>::UnalignedConstMatrix ConstMatrix;
+
+  const int64 gates_size = cell_size * 4;
+  const int64 step_size = batch_size * cell_size;
+  Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1> contract_pairs;
+  contract_pairs[0] = Eigen::IndexPair<Eigen::DenseIndex>(1, 0);
+
+  // The first input_size rows of w multiply x, and the others h_prev.
+  const T* w_data = w.flat<T>().data();
+  ConstMatrix w_x(w_data, input_size, gates_size);
+  ConstMatrix w_h(w_data + input_size * gates_size, cell_size, gates_size);
+
+  // icfo[t] = x[t] * w_x + b, for all t at once.
+  Matrix icfo_all(icfo_seq->flat<T>().data(), seq_len_max * batch_size,
+                  gates_size);
+  ConstMatrix x_all(x.flat<T>().data(), seq_len_max * batch_size, input_size);
+  icfo_all.device(d) = x_all.contract(w_x, contract_pairs);
+  Eigen::array<Eigen::DenseIndex, 2> b_shape({1, gates_size});
+  Eigen::array<Eigen::DenseIndex, 2> b_broadcast_shape(
+      {seq_len_max * batch_size, 1});
+  icfo_all.device(d) +=
+      b.vec<T>().reshape(b_shape).broadcast(b_broadcast_shape);
+
+  auto wci_t = wci.vec<T>();
+  auto wcf_t = wcf.vec<T>();
+  auto wco_t = wco.vec<T>();
+  Eigen::array<Eigen::DenseIndex, 2> p_shape({1, cell_size});
+  Eigen::array<Eigen::DenseIndex, 2> p_broadcast_shape({batch_size, 1});
+  Eigen::array<Eigen::DenseIndex, 2> cell_extents({batch_size, cell_size});
+  Eigen::array<Eigen::DenseIndex, 2> i_offsets({0, 0});
+  Eigen::array<Eigen::DenseIndex, 2> c_offsets({0, cell_size});
+  Eigen::array<Eigen::DenseIndex, 2> f_offsets({0, cell_size * 2});
+  Eigen::array<Eigen::DenseIndex, 2> o_offsets({0, cell_size * 3});
+
+  auto step = [batch_size, cell_size, step_size](Tensor* t, int64 time) {
+    return Matrix(t->flat<T>().data() + time * step_size, batch_size,
+                  cell_size);
+  };
+  for (int64 t = 0; t < seq_len_max; ++t) {
+    const T* cs_prev_data =
+        t == 0 ? cs_prev.flat<T>().data()
+               : cs_out->flat<T>().data() + (t - 1) * step_size;
+    const T* h_prev_data =
+        t == 0 ? h_prev.flat<T>().data()
+               : h_out->flat<T>().data() + (t - 1) * step_size;
+    ConstMatrix cs_prev_t(cs_prev_data, batch_size, cell_size);
+    ConstMatrix h_prev_t(h_prev_data, batch_size, cell_size);
+    Matrix icfo(icfo_all.data() + t * batch_size * gates_size, batch_size,
+                gates_size);
+    Matrix i = step(i_out, t);
+    Matrix cs = step(cs_out, t);
+    Matrix f = step(f_out, t);
+    Matrix o = step(o_out, t);
+    Matrix ci = step(ci_out, t);
+    Matrix co = step(co_out, t);
+    Matrix h = step(h_out, t);
+
+    // icfo[t] += h_prev * w_h
+    icfo.device(d) += h_prev_t.contract(w_h, contract_pairs);
+
+    // Input gate.
+    if (use_peephole) {
+      auto i_peep =
+          cs_prev_t * wci_t.reshape(p_shape).broadcast(p_broadcast_shape);
+      i.device(d) = (icfo.slice(i_offsets, cell_extents) + i_peep).sigmoid();
+    } else {
+      i.device(d) = icfo.slice(i_offsets, cell_extents).sigmoid();
+    }
+
+    // Cell input.
+    ci.device(d) = icfo.slice(c_offsets, cell_extents).tanh();
+
+    // Forget gate (w/ bias).
+    if (use_peephole) {
+      auto f_peep =
+          cs_prev_t * wcf_t.reshape(p_shape).broadcast(p_broadcast_shape);
+      f.device(d) = (icfo.slice(f_offsets, cell_extents) +
+                     f.constant(forget_bias) + f_peep)
+                        .sigmoid();
+    } else {
+      f.device(d) =
+          (icfo.slice(f_offsets, cell_extents) + f.constant(forget_bias))
+              .sigmoid();
+    }
+
+    // cs = ci .* i + f .* cs_prev
+    cs.device(d) = i * ci + f * cs_prev_t;
+
+    if (cell_clip > 0.0f) {
+      cs.device(d) =
+          cs.binaryExpr(cs.constant(cell_clip), Eigen::scalar_clip_op<T>());
+    }
+
+    // co = tanh(cs)
+    co.device(d) = cs.tanh();
+
+    // Output gate.
+    if (use_peephole) {
+      auto o_peep = cs * wco_t.reshape(p_shape).broadcast(p_broadcast_shape);
+      o.device(d) = (icfo.slice(o_offsets, cell_extents) + o_peep).sigmoid();
+    } else {
+      o.device(d) = icfo.slice(o_offsets, cell_extents).sigmoid();
+    }
+
+    // h = o .* co
+    h.device(d) = o * co;
+  }
+}
+
 }  // namespace
 
 template <typename Device, typename T, bool USE_CUBLAS>
@@ -745,49 +872,68 @@ class BlockLSTMOp : public OpKernel {
     Tensor* h_out;
     OP_REQUIRES_OK(ctx, ctx->allocate_output("h", batch_cell_shape, &h_out));
 
-    Tensor xh_tensor;
-    OP_REQUIRES_OK(ctx, ctx->allocate_temp(
-                            DataTypeToEnum<T>::v(),
-                            TensorShape({batch_size, input_size + cell_size}),
-                            &xh_tensor));
-
-    Tensor icfo_tensor;
-    OP_REQUIRES_OK(ctx,
-                   ctx->allocate_temp(DataTypeToEnum<T>::v(),
-                                      TensorShape({batch_size, cell_size * 4}),
-                                      &icfo_tensor));
-
     const Device& device = ctx->eigen_device<Device>();
 
     const int64 seq_len_max = seq_len_max_tensor->scalar<int64>()();
-    SliceHelper<Device, T> slicer(ctx);
-    for (int64 t = 0; t < seq_len_max; ++t) {
-      const Tensor x_tensor = slicer.InputSlice(*x, t, "x");
-      const Tensor& cs_prev_tensor2 =
-          t == 0 ? *cs_prev_tensor
-                 : slicer.OutputSlice(cs_out, t - 1, "cs_prev");
-      const Tensor& h_prev_tensor2 =
-          t == 0 ? *h_prev_tensor : slicer.OutputSlice(h_out, t - 1, "h_prev");
-
-      Tensor i_tensor = slicer.OutputSlice(i_out, t, "i_out");
-      Tensor cs_tensor = slicer.OutputSlice(cs_out, t, "cs_out");
-      Tensor f_tensor = slicer.OutputSlice(f_out, t, "f_out");
-      Tensor o_tensor = slicer.OutputSlice(o_out, t, "o_out");
-      Tensor ci_tensor = slicer.OutputSlice(ci_out, t, "ci_out");
-      Tensor co_tensor = slicer.OutputSlice(co_out, t, "co_out");
-      Tensor h_tensor = slicer.OutputSlice(h_out, t, "h_out");
-
-      functor::LSTMBlockCellFprop<Device, T, USE_CUBLAS>(batch_size, input_size,
-                                                         cell_size)(
-          ctx, device, forget_bias_, cell_clip_, use_peephole_,
-          x_tensor.matrix<T>(), cs_prev_tensor2.matrix<T>(),
-          h_prev_tensor2.matrix<T>(), w_tensor->matrix<T>(),
-          wci_tensor->vec<T>(), wcf_tensor->vec<T>(), wco_tensor->vec<T>(),
-          b_tensor->vec<T>(), xh_tensor.matrix<T>(), i_tensor.matrix<T>(),
-          cs_tensor.matrix<T>(), f_tensor.matrix<T>(), o_tensor.matrix<T>(),
-          ci_tensor.matrix<T>(), co_tensor.matrix<T>(), icfo_tensor.matrix<T>(),
-          h_tensor.matrix<T>());
-      slicer.FinishTimeStep();
+    OP_REQUIRES(ctx, seq_len_max <= timelen,
+                errors::InvalidArgument("seq_len_max > timelen: ", seq_len_max,
+                                        " vs. ", timelen));
+    if (std::is_same<Device, CPUDevice>::value) {
+      Tensor icfo_seq_tensor;
+      OP_REQUIRES_OK(
+          ctx, ctx->allocate_temp(
+                   DataTypeToEnum<T>::v(),
+                   TensorShape({seq_len_max * batch_size, cell_size * 4}),
+                   &icfo_seq_tensor));
+      BlockLSTMFpropCPU<T>(
+          ctx->eigen_device<CPUDevice>(), seq_len_max, batch_size, input_size,
+          cell_size, forget_bias_, cell_clip_, use_peephole_, *x,
+          *cs_prev_tensor, *h_prev_tensor, *w_tensor, *wci_tensor, *wcf_tensor,
+          *wco_tensor, *b_tensor, &icfo_seq_tensor, i_out, cs_out, f_out,
+          o_out, ci_out, co_out, h_out);
+    } else {
+      Tensor xh_tensor;
+      OP_REQUIRES_OK(ctx, ctx->allocate_temp(
+                              DataTypeToEnum<T>::v(),
+                              TensorShape({batch_size, input_size + cell_size}),
+                              &xh_tensor));
+
+      Tensor icfo_tensor;
+      OP_REQUIRES_OK(
+          ctx, ctx->allocate_temp(DataTypeToEnum<T>::v(),
+                                  TensorShape({batch_size, cell_size * 4}),
+                                  &icfo_tensor));
+
+      SliceHelper<Device, T> slicer(ctx);
+      for (int64 t = 0; t < seq_len_max; ++t) {
+        const Tensor x_tensor = slicer.InputSlice(*x, t, "x");
+        const Tensor& cs_prev_tensor2 =
+            t == 0 ? *cs_prev_tensor
+                   : slicer.OutputSlice(cs_out, t - 1, "cs_prev");
+        const Tensor& h_prev_tensor2 =
+            t == 0 ? *h_prev_tensor
+                   : slicer.OutputSlice(h_out, t - 1, "h_prev");
+
+        Tensor i_tensor = slicer.OutputSlice(i_out, t, "i_out");
+        Tensor cs_tensor = slicer.OutputSlice(cs_out, t, "cs_out");
+        Tensor f_tensor = slicer.OutputSlice(f_out, t, "f_out");
+        Tensor o_tensor = slicer.OutputSlice(o_out, t, "o_out");
+        Tensor ci_tensor = slicer.OutputSlice(ci_out, t, "ci_out");
+        Tensor co_tensor = slicer.OutputSlice(co_out, t, "co_out");
+        Tensor h_tensor = slicer.OutputSlice(h_out, t, "h_out");
+
+        functor::LSTMBlockCellFprop<Device, T, USE_CUBLAS>(
+            batch_size, input_size, cell_size)(
+            ctx, device, forget_bias_, cell_clip_, use_peephole_,
+            x_tensor.matrix<T>(), cs_prev_tensor2.matrix<T>(),
+            h_prev_tensor2.matrix<T>(), w_tensor->matrix<T>(),
+            wci_tensor->vec<T>(), wcf_tensor->vec<T>(), wco_tensor->vec<T>(),
+            b_tensor->vec<T>(), xh_tensor.matrix<T>(), i_tensor.matrix<T>(),
+            cs_tensor.matrix<T>(), f_tensor.matrix<T>(), o_tensor.matrix<T>(),
+            ci_tensor.matrix<T>(), co_tensor.matrix<T>(),
+            icfo_tensor.matrix<T>(), h_tensor.matrix<T>());
+        slicer.FinishTimeStep();
+      }
     }
 
     if (seq_len_max < timelen) {
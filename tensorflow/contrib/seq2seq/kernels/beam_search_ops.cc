@@ -21,7 +21,10 @@ limitations under the License.
 
 #include "tensorflow/contrib/seq2seq/kernels/beam_search_ops.h"
 
+#include <algorithm>
+#include <limits>
 #include <memory>
+#include <type_traits>
 #include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -31,6 +34,8 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/lib/gtl/top_n.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/util/work_sharder.h"
@@ -144,8 +149,275 @@ struct GatherTree<CPUDevice, int32> {
   }
 };
 
+template <typename T>
+struct BeamSearchStep<CPUDevice, T> {
+  // A continuation of a beam: its score, total log probability, and
+  // beam * vocab_size + word index.
+  struct Candidate {
+    T score;
+    T log_prob;
+    int32 index;
+  };
+
+  Status operator()(OpKernelContext* ctx, const CPUDevice& d,
+                    typename TTypes<T, 3>::ConstTensor logits,
+                    typename TTypes<T>::ConstMatrix log_probs,
+                    typename TTypes<int32>::ConstMatrix lengths,
+                    typename TTypes<bool>::ConstMatrix finished,
+                    bool first_step, int32 end_token, T length_penalty_weight,
+                    typename TTypes<T>::Matrix scores,
+                    typename TTypes<int32>::Matrix predicted_ids,
+                    typename TTypes<int32>::Matrix parent_ids,
+                    typename TTypes<T>::Matrix next_log_probs,
+                    typename TTypes<int32>::Matrix next_lengths,
+                    typename TTypes<bool>::Matrix next_finished) {
+    const int64 batch_size = logits.dimension(0);
+    const int64 beam_width = logits.dimension(1);
+    const int32 vocab_size = logits.dimension(2);
+    const int64 num_beams = first_step ? 1 : beam_width;
+    const T lowest = Eigen::NumTraits<T>::lowest();
+
+    auto DoWork = [&](int64 start_batch, int64 limit_batch) {
+      const auto comp = [](const Candidate& a, const Candidate& b) {
+        return a.score > b.score || (a.score == b.score && a.index < b.index);
+      };
+      std::vector<T> log_norms(num_beams);
+      for (int64 b = start_batch; b < limit_batch; ++b) {
+        // The log softmax normalizers of the unfinished beams.
+        for (int64 j = 0; j < num_beams; ++j) {
+          if (finished(b, j)) continue;
+          const T* row = &logits(b, j, 0);
+          const T max_logit = *std::max_element(row, row + vocab_size);
+          T sum = T(0);
+          for (int32 v = 0; v < vocab_size; ++v) {
+            sum += Eigen::numext::exp(row[v] - max_logit);
+          }
+          log_norms[j] = max_logit + Eigen::numext::log(sum);
+        }
+
+        gtl::TopN<Candidate, decltype(comp)> filter(beam_width, comp);
+        for (int64 j = 0; j < num_beams; ++j) {
+          const T* row = &logits(b, j, 0);
+          const bool beam_finished = finished(b, j);
+          for (int32 v = 0; v < vocab_size; ++v) {
+            // Finished beams put all their probability on end_token.
+            T step_log_prob;
+            int32 length = lengths(b, j);
+            if (beam_finished) {
+              step_log_prob = v == end_token ? T(0) : lowest;
+            } else {
+              step_log_prob = row[v] - log_norms[j];
+              if (v != end_token) ++length;
+            }
+            Candidate candidate;
+            candidate.log_prob = log_probs(b, j) + step_log_prob;
+            candidate.score =
+                candidate.log_prob /
+                BeamSearchLengthPenalty(length, length_penalty_weight);
+            candidate.index = static_cast<int32>(j * vocab_size + v);
+            filter.push(candidate);
+          }
+        }
+
+        std::unique_ptr<std::vector<Candidate>> best(filter.Extract());
+        for (int64 i = 0; i < beam_width; ++i) {
+          const Candidate& candidate = (*best)[i];
+          const int32 word = candidate.index % vocab_size;
+          const int32 parent = candidate.index / vocab_size;
+          const bool now_finished = finished(b, parent) || word == end_token;
+          scores(b, i) = candidate.score;
+          predicted_ids(b, i) = word;
+          parent_ids(b, i) = parent;
+          next_log_probs(b, i) = candidate.log_prob;
+          next_finished(b, i) = now_finished;
+          next_lengths(b, i) = lengths(b, parent) + (now_finished ? 0 : 1);
+        }
+      }
+    };
+    // Guesstimate of cost; an exp for the normalizer, then a division and a
+    // few comparisons to score and filter each candidate.
+    int64 candidate_cost = 20 * Eigen::TensorOpCost::MulCost<T>() +
+                           Eigen::TensorOpCost::DivCost<T>() +
+                           8 * Eigen::TensorOpCost::AddCost<T>();
+    if (length_penalty_weight != T(0)) {
+      candidate_cost += 40 * Eigen::TensorOpCost::MulCost<T>();
+    }
+    const int64 batch_cost = num_beams * vocab_size * candidate_cost;
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+          batch_cost, DoWork);
+    return Status::OK();
+  }
+};
+
+template <typename T>
+struct GatherBeams<CPUDevice, T> {
+  void operator()(const CPUDevice& d, typename TTypes<T, 3>::ConstTensor params,
+                  typename TTypes<int32>::ConstMatrix indices,
+                  typename TTypes<T, 3>::Tensor output) {
+    const int64 batch_size = params.dimension(0);
+    const int64 beam_width = params.dimension(1);
+    const int64 depth = params.dimension(2);
+    // When the output reuses the buffer of params, the beams of a batch entry
+    // are gathered from a copy of them.
+    const bool in_place = params.data() == output.data();
+    std::unique_ptr<T[]> scratch(in_place ? new T[beam_width * depth]
+                                          : nullptr);
+    for (int64 b = 0; b < batch_size; ++b) {
+      const T* source = &params(b, 0, 0);
+      if (in_place) {
+        bool identity = true;
+        for (int64 j = 0; j < beam_width && identity; ++j) {
+          identity = indices(b, j) == j;
+        }
+        if (identity) continue;
+        std::copy(source, source + beam_width * depth, scratch.get());
+        source = scratch.get();
+      }
+      for (int64 j = 0; j < beam_width; ++j) {
+        const T* beam = source + indices(b, j) * depth;
+        std::copy(beam, beam + depth, &output(b, j, 0));
+      }
+    }
+  }
+};
+
 }  // namespace functor
 
+template <typename Device, typename T>
+class BeamSearchStepOp : public OpKernel {
+ public:
+  explicit BeamSearchStepOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& logits = ctx->input(0);
+    const Tensor& log_probs = ctx->input(1);
+    const Tensor& lengths = ctx->input(2);
+    const Tensor& finished = ctx->input(3);
+    const Tensor& time = ctx->input(4);
+    const Tensor& end_token = ctx->input(5);
+    const Tensor& length_penalty_weight = ctx->input(6);
+    OP_REQUIRES(
+        ctx, logits.dims() == 3,
+        errors::InvalidArgument("logits must be a 3-tensor, saw shape: ",
+                                logits.shape().DebugString()));
+    const TensorShape beams_shape(
+        {logits.dim_size(0), logits.dim_size(1)});
+    for (const Tensor* t : {&log_probs, &lengths, &finished}) {
+      OP_REQUIRES(
+          ctx, t->shape() == beams_shape,
+          errors::InvalidArgument(
+              "log_probs, lengths and finished must be shaped ",
+              beams_shape.DebugString(), ", saw shape: ",
+              t->shape().DebugString()));
+    }
+    for (const Tensor* t : {&time, &end_token, &length_penalty_weight}) {
+      OP_REQUIRES(
+          ctx, TensorShapeUtils::IsScalar(t->shape()),
+          errors::InvalidArgument(
+              "time, end_token and length_penalty_weight must be scalars, "
+              "saw shape: ",
+              t->shape().DebugString()));
+    }
+    const bool first_step = time.scalar<int32>()() == 0;
+    const int64 vocab_size = logits.dim_size(2);
+    const int64 beam_width = logits.dim_size(1);
+    const int64 num_candidates =
+        first_step ? vocab_size : beam_width * vocab_size;
+    OP_REQUIRES(ctx, num_candidates >= beam_width,
+                errors::InvalidArgument(
+                    "Only ", num_candidates, " candidates for ", beam_width,
+                    " beams, the vocabulary is too small"));
+    OP_REQUIRES(
+        ctx, beam_width * vocab_size <= std::numeric_limits<int32>::max(),
+        errors::InvalidArgument("Too many candidates: ", beam_width, " * ",
+                                vocab_size));
+
+    Tensor* outputs[6];
+    for (int i = 0; i < 6; ++i) {
+      OP_REQUIRES_OK(ctx, ctx->allocate_output(i, beams_shape, &outputs[i]));
+    }
+    if (beams_shape.num_elements() == 0) return;
+    functor::BeamSearchStep<Device, T> step;
+    OP_REQUIRES_OK(
+        ctx, step(ctx, ctx->eigen_device<Device>(), logits.tensor<T, 3>(),
+                  log_probs.matrix<T>(), lengths.matrix<int32>(),
+                  finished.matrix<bool>(), first_step,
+                  end_token.scalar<int32>()(),
+                  length_penalty_weight.scalar<T>()(), outputs[0]->matrix<T>(),
+                  outputs[1]->matrix<int32>(), outputs[2]->matrix<int32>(),
+                  outputs[3]->matrix<T>(), outputs[4]->matrix<int32>(),
+                  outputs[5]->matrix<bool>()));
+  }
+};
+
+#define REGISTER_KERNEL(T)                                              \
+  REGISTER_KERNEL_BUILDER(                                              \
+      Name("BeamSearchStep").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      BeamSearchStepOp<CPUDevice, T>);
+REGISTER_KERNEL(float);
+REGISTER_KERNEL(double);
+#undef REGISTER_KERNEL
+
+template <typename Device, typename T>
+class GatherBeamsOp : public OpKernel {
+ public:
+  explicit GatherBeamsOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& params = ctx->input(0);
+    const Tensor& parent_ids = ctx->input(1);
+    OP_REQUIRES(
+        ctx, params.dims() >= 2,
+        errors::InvalidArgument("params must have rank >= 2, saw shape: ",
+                                params.shape().DebugString()));
+    OP_REQUIRES(ctx,
+                TensorShapeUtils::IsMatrix(parent_ids.shape()) &&
+                    parent_ids.dim_size(0) == params.dim_size(0) &&
+                    parent_ids.dim_size(1) == params.dim_size(1),
+                errors::InvalidArgument(
+                    "parent_ids must be shaped [batch_size, beam_width] as "
+                    "the first dimensions of params, saw shapes: ",
+                    parent_ids.shape().DebugString(), " and ",
+                    params.shape().DebugString()));
+    const int64 beam_width = params.dim_size(1);
+    if (std::is_same<Device, CPUDevice>::value) {
+      const auto parent_ids_flat = parent_ids.flat<int32>();
+      for (int64 i = 0; i < parent_ids_flat.size(); ++i) {
+        OP_REQUIRES(ctx, FastBoundsCheck(parent_ids_flat(i), beam_width),
+                    errors::InvalidArgument("parent_ids[", i / beam_width,
+                                            ", ", i % beam_width, "] = ",
+                                            parent_ids_flat(i),
+                                            " is not in [0, ", beam_width,
+                                            ")"));
+      }
+    }
+
+    Tensor* output;
+    if (std::is_same<Device, CPUDevice>::value) {
+      OP_REQUIRES_OK(ctx, ctx->forward_input_or_allocate_output(
+                              {0}, 0, params.shape(), &output));
+    } else {
+      OP_REQUIRES_OK(ctx, ctx->allocate_output(0, params.shape(), &output));
+    }
+    if (params.NumElements() == 0) return;
+    const int64 batch_size = params.dim_size(0);
+    const int64 depth = params.NumElements() / (batch_size * beam_width);
+    functor::GatherBeams<Device, T>()(
+        ctx->eigen_device<Device>(),
+        params.shaped<T, 3>({batch_size, beam_width, depth}),
+        parent_ids.matrix<int32>(),
+        output->shaped<T, 3>({batch_size, beam_width, depth}));
+  }
+};
+
+#define REGISTER_KERNEL(T)                                           \
+  REGISTER_KERNEL_BUILDER(                                           \
+      Name("GatherBeams").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      GatherBeamsOp<CPUDevice, T>);
+TF_CALL_POD_TYPES(REGISTER_KERNEL);
+#undef REGISTER_KERNEL
+
 #if GOOGLE_CUDA
 namespace functor {
 #define DECLARE_GPU_SPEC(T)                            \
@@ -160,6 +432,41 @@ namespace functor {
 
 DECLARE_GPU_SPEC(int32);
 #undef DECLARE_GPU_SPEC
+
+#define DECLARE_GPU_SPEC(T)                                                \
+  template <>                                                              \
+  Status BeamSearchStep<GPUDevice, T>::operator()(                         \
+      OpKernelContext* ctx, const GPUDevice& d,                            \
+      typename TTypes<T, 3>::ConstTensor logits,                           \
+      typename TTypes<T>::ConstMatrix log_probs,                           \
+      typename TTypes<int32>::ConstMatrix lengths,                         \
+      typename TTypes<bool>::ConstMatrix finished, bool first_step,        \
+      int32 end_token, T length_penalty_weight,                            \
+      typename TTypes<T>::Matrix scores,                                   \
+      typename TTypes<int32>::Matrix predicted_ids,                        \
+      typename TTypes<int32>::Matrix parent_ids,                           \
+      typename TTypes<T>::Matrix next_log_probs,                           \
+      typename TTypes<int32>::Matrix next_lengths,                         \
+      typename TTypes<bool>::Matrix next_finished);                        \
+  extern template struct BeamSearchStep<GPUDevice, T>;
+
+DECLARE_GPU_SPEC(float);
+DECLARE_GPU_SPEC(double);
+#undef DECLARE_GPU_SPEC
+
+#define DECLARE_GPU_SPEC(T)                                      \
+  template <>                                                    \
+  void GatherBeams<GPUDevice, T>::operator()(                    \
+      const GPUDevice& d, typename TTypes<T, 3>::ConstTensor params, \
+      typename TTypes<int32>::ConstMatrix indices,               \
+      typename TTypes<T, 3>::Tensor output);                     \
+  extern template struct GatherBeams<GPUDevice, T>;
+
+TF_CALL_GPU_NUMBER_TYPES(DECLARE_GPU_SPEC);
+TF_CALL_int32(DECLARE_GPU_SPEC);
+TF_CALL_int64(DECLARE_GPU_SPEC);
+TF_CALL_bool(DECLARE_GPU_SPEC);
+#undef DECLARE_GPU_SPEC
 }  // end namespace functor
 
 #define REGISTER_GPU_KERNEL(T)                                      \
@@ -169,6 +476,30 @@ DECLARE_GPU_SPEC(int32);
 
 REGISTER_GPU_KERNEL(int32);
 #undef REGISTER_GPU_KERNEL
+
+#define REGISTER_GPU_KERNEL(T)                               \
+  REGISTER_KERNEL_BUILDER(Name("BeamSearchStep")             \
+                              .Device(DEVICE_GPU)            \
+                              .HostMemory("time")            \
+                              .HostMemory("end_token")       \
+                              .HostMemory("length_penalty_weight") \
+                              .TypeConstraint<T>("T"),       \
+                          BeamSearchStepOp<GPUDevice, T>);
+
+REGISTER_GPU_KERNEL(float);
+REGISTER_GPU_KERNEL(double);
+#undef REGISTER_GPU_KERNEL
+
+#define REGISTER_GPU_KERNEL(T)                                       \
+  REGISTER_KERNEL_BUILDER(                                           \
+      Name("GatherBeams").Device(DEVICE_GPU).TypeConstraint<T>("T"), \
+      GatherBeamsOp<GPUDevice, T>);
+
+TF_CALL_GPU_NUMBER_TYPES(REGISTER_GPU_KERNEL);
+TF_CALL_int32(REGISTER_GPU_KERNEL);
+TF_CALL_int64(REGISTER_GPU_KERNEL);
+TF_CALL_bool(REGISTER_GPU_KERNEL);
+#undef REGISTER_GPU_KERNEL
 #endif  // GOOGLE_CUDA
 
 }  // end namespace tensorflow
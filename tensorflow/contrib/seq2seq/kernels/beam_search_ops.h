@@ -19,6 +19,7 @@ limitations under the License.
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/kernels/eigen_activations.h"
+#include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -35,6 +36,46 @@ struct GatherTree {
                   typename TTypes<T, 3>::Tensor beams);
 };
 
+// The length penalty of https://arxiv.org/abs/1609.08144, by which the log
+// probability of a hypothesis of the given length is divided to get its
+// score.
+template <typename T>
+EIGEN_DEVICE_FUNC EIGEN_ALWAYS_INLINE T BeamSearchLengthPenalty(
+    int32 length, T length_penalty_weight) {
+  if (length_penalty_weight == T(0)) return T(1);
+  return Eigen::numext::pow((T(5) + T(length)) / T(6), length_penalty_weight);
+}
+
+// Selects the beam_width best continuations of each batch entry out of all
+// the beam_width * vocab_size candidates (only the vocab_size candidates of
+// the first beam on the first step), from the logits of the current step.
+// Candidates are ordered by score, ties going to the lower beam * vocab_size
+// + word index.
+template <typename Device, typename T>
+struct BeamSearchStep {
+  Status operator()(OpKernelContext* ctx, const Device& d,
+                    typename TTypes<T, 3>::ConstTensor logits,
+                    typename TTypes<T>::ConstMatrix log_probs,
+                    typename TTypes<int32>::ConstMatrix lengths,
+                    typename TTypes<bool>::ConstMatrix finished,
+                    bool first_step, int32 end_token, T length_penalty_weight,
+                    typename TTypes<T>::Matrix scores,
+                    typename TTypes<int32>::Matrix predicted_ids,
+                    typename TTypes<int32>::Matrix parent_ids,
+                    typename TTypes<T>::Matrix next_log_probs,
+                    typename TTypes<int32>::Matrix next_lengths,
+                    typename TTypes<bool>::Matrix next_finished);
+};
+
+// Sets output(b, j, :) to params(b, indices(b, j), :). indices must be in
+// [0, beam_width).
+template <typename Device, typename T>
+struct GatherBeams {
+  void operator()(const Device& d, typename TTypes<T, 3>::ConstTensor params,
+                  typename TTypes<int32>::ConstMatrix indices,
+                  typename TTypes<T, 3>::Tensor output);
+};
+
 }  // namespace functor
 }  // namespace tensorflow
 
@@ -18,6 +18,9 @@ limitations under the License.
 #define EIGEN_USE_GPU
 
 #include "tensorflow/contrib/seq2seq/kernels/beam_search_ops.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/util/cuda_kernel_helper.h"
 
 namespace tensorflow {
@@ -83,6 +86,277 @@ struct GatherTree<GPUDevice, T> {
 DEFINE_GPU_SPECS(int32);
 #undef DEFINE_GPU_SPECS
 
+namespace {
+
+// The number of threads of the blocks reducing over a row of logits or over
+// the candidates of a batch entry.
+constexpr int kBeamSearchBlockSize = 256;
+
+// A candidate continuation, as its score and beam * vocab_size + word index.
+// An index of -1 marks the lack of a candidate.
+template <typename T>
+struct ScoredIndex {
+  T score;
+  int32 index;
+};
+
+template <typename T>
+__device__ EIGEN_ALWAYS_INLINE bool IsBetter(const ScoredIndex<T>& a,
+                                             const ScoredIndex<T>& b) {
+  return a.index >= 0 &&
+         (b.index < 0 || a.score > b.score ||
+          (a.score == b.score && a.index < b.index));
+}
+
+// Sets log_norms[r] to the log softmax normalizer of row r of the logits,
+// with one block per row.
+template <typename T>
+__global__ void BeamSearchLogNormKernel(const T* logits, const int32 vocab_size,
+                                        T* log_norms) {
+  __shared__ T shared[kBeamSearchBlockSize];
+  const T* row = logits + static_cast<int64>(blockIdx.x) * vocab_size;
+
+  T max_logit = Eigen::NumTraits<T>::lowest();
+  for (int32 v = threadIdx.x; v < vocab_size; v += blockDim.x) {
+    max_logit = max(max_logit, ldg(row + v));
+  }
+  shared[threadIdx.x] = max_logit;
+  __syncthreads();
+  for (int stride = blockDim.x / 2; stride > 0; stride /= 2) {
+    if (threadIdx.x < stride) {
+      shared[threadIdx.x] =
+          max(shared[threadIdx.x], shared[threadIdx.x + stride]);
+    }
+    __syncthreads();
+  }
+  max_logit = shared[0];
+  __syncthreads();
+
+  T sum = T(0);
+  for (int32 v = threadIdx.x; v < vocab_size; v += blockDim.x) {
+    sum += exp(ldg(row + v) - max_logit);
+  }
+  shared[threadIdx.x] = sum;
+  __syncthreads();
+  for (int stride = blockDim.x / 2; stride > 0; stride /= 2) {
+    if (threadIdx.x < stride) {
+      shared[threadIdx.x] += shared[threadIdx.x + stride];
+    }
+    __syncthreads();
+  }
+  if (threadIdx.x == 0) {
+    log_norms[blockIdx.x] = max_logit + log(shared[0]);
+  }
+}
+
+// Computes the total log probability of a candidate, and its length.
+template <typename T>
+__device__ EIGEN_ALWAYS_INLINE T CandidateLogProb(
+    const T* logits, const T* log_probs, const int32* lengths,
+    const bool* finished, const T* log_norms, const int32 vocab_size,
+    const int32 end_token, const int64 beam, const int32 word,
+    int32* length) {
+  *length = ldg(lengths + beam);
+  T step_log_prob;
+  if (finished[beam]) {
+    // Finished beams put all their probability on end_token.
+    step_log_prob =
+        word == end_token ? T(0) : Eigen::NumTraits<T>::lowest();
+  } else {
+    step_log_prob = ldg(logits + beam * vocab_size + word) - log_norms[beam];
+    if (word != end_token) ++*length;
+  }
+  return ldg(log_probs + beam) + step_log_prob;
+}
+
+// Scores the num_candidates candidates of each of the batch_size entries.
+template <typename T>
+__global__ void BeamSearchScoresKernel(
+    const int32 batch_size, const int32 beam_width, const int32 vocab_size,
+    const int32 num_candidates, const T* logits, const T* log_probs,
+    const int32* lengths, const bool* finished, const T* log_norms,
+    const int32 end_token, const T length_penalty_weight, T* scores) {
+  CUDA_1D_KERNEL_LOOP(i, batch_size * num_candidates) {
+    const int32 batch = i / num_candidates;
+    const int32 index = i % num_candidates;
+    const int64 beam = static_cast<int64>(batch) * beam_width +
+                       index / vocab_size;
+    int32 length;
+    const T log_prob = CandidateLogProb(
+        logits, log_probs, lengths, finished, log_norms, vocab_size,
+        end_token, beam, index % vocab_size, &length);
+    scores[i] =
+        log_prob / BeamSearchLengthPenalty(length, length_penalty_weight);
+  }
+}
+
+// Selects the beam_width best candidates of each batch entry, with one
+// block per entry. Each pass selects the best candidate ordered after the
+// one of the previous pass, so that no candidate is selected twice; the beam
+// width is small enough for this to be cheaper than a sort.
+template <typename T>
+__global__ void BeamSearchSelectKernel(
+    const int32 beam_width, const int32 vocab_size,
+    const int32 num_candidates, const T* logits, const T* log_probs,
+    const int32* lengths, const bool* finished, const T* log_norms,
+    const int32 end_token, const T* scores, T* out_scores,
+    int32* predicted_ids, int32* parent_ids, T* next_log_probs,
+    int32* next_lengths, bool* next_finished) {
+  __shared__ ScoredIndex<T> shared[kBeamSearchBlockSize];
+  const int32 batch = blockIdx.x;
+  const T* batch_scores =
+      scores + static_cast<int64>(batch) * num_candidates;
+
+  ScoredIndex<T> previous;
+  previous.index = -1;
+  for (int32 i = 0; i < beam_width; ++i) {
+    ScoredIndex<T> best;
+    best.index = -1;
+    for (int32 c = threadIdx.x; c < num_candidates; c += blockDim.x) {
+      ScoredIndex<T> candidate;
+      candidate.score = batch_scores[c];
+      candidate.index = c;
+      if ((previous.index < 0 || IsBetter(previous, candidate)) &&
+          IsBetter(candidate, best)) {
+        best = candidate;
+      }
+    }
+    shared[threadIdx.x] = best;
+    __syncthreads();
+    for (int stride = blockDim.x / 2; stride > 0; stride /= 2) {
+      if (threadIdx.x < stride &&
+          IsBetter(shared[threadIdx.x + stride], shared[threadIdx.x])) {
+        shared[threadIdx.x] = shared[threadIdx.x + stride];
+      }
+      __syncthreads();
+    }
+    previous = shared[0];
+    __syncthreads();
+
+    if (threadIdx.x == 0) {
+      const int64 out = static_cast<int64>(batch) * beam_width + i;
+      // Only NaN scores leave no candidate to select.
+      const int32 index = previous.index < 0 ? 0 : previous.index;
+      const int32 word = index % vocab_size;
+      const int32 parent = index / vocab_size;
+      const int64 beam = static_cast<int64>(batch) * beam_width + parent;
+      int32 unused_length;
+      const bool now_finished = finished[beam] || word == end_token;
+      out_scores[out] = previous.score;
+      predicted_ids[out] = word;
+      parent_ids[out] = parent;
+      next_log_probs[out] = CandidateLogProb(
+          logits, log_probs, lengths, finished, log_norms, vocab_size,
+          end_token, beam, word, &unused_length);
+      next_finished[out] = now_finished;
+      next_lengths[out] = ldg(lengths + beam) + (now_finished ? 0 : 1);
+    }
+  }
+}
+
+template <typename T>
+__global__ void GatherBeamsKernel(const int64 size, const int32 beam_width,
+                                  const int64 depth, const T* params,
+                                  const int32* indices, T* output) {
+  CUDA_1D_KERNEL_LOOP(i, size) {
+    const int64 row = i / depth;
+    const int64 batch = row / beam_width;
+    const int32 parent = ldg(indices + row);
+    if (parent < 0 || parent >= beam_width) {
+      output[i] = T();
+    } else {
+      output[i] = params[(batch * beam_width + parent) * depth + i % depth];
+    }
+  }
+}
+
+}  // namespace
+
+template <typename T>
+struct BeamSearchStep<GPUDevice, T> {
+  Status operator()(OpKernelContext* ctx, const GPUDevice& d,
+                    typename TTypes<T, 3>::ConstTensor logits,
+                    typename TTypes<T>::ConstMatrix log_probs,
+                    typename TTypes<int32>::ConstMatrix lengths,
+                    typename TTypes<bool>::ConstMatrix finished,
+                    bool first_step, int32 end_token, T length_penalty_weight,
+                    typename TTypes<T>::Matrix scores,
+                    typename TTypes<int32>::Matrix predicted_ids,
+                    typename TTypes<int32>::Matrix parent_ids,
+                    typename TTypes<T>::Matrix next_log_probs,
+                    typename TTypes<int32>::Matrix next_lengths,
+                    typename TTypes<bool>::Matrix next_finished) {
+    const int32 batch_size = logits.dimension(0);
+    const int32 beam_width = logits.dimension(1);
+    const int32 vocab_size = logits.dimension(2);
+    const int32 num_candidates =
+        first_step ? vocab_size : beam_width * vocab_size;
+
+    // The normalizers of all the beams, followed by the candidate scores.
+    Tensor scratch;
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        DataTypeToEnum<T>::value,
+        TensorShape({batch_size * beam_width +
+                     static_cast<int64>(batch_size) * num_candidates}),
+        &scratch));
+    T* log_norms = scratch.flat<T>().data();
+    T* candidate_scores = log_norms + batch_size * beam_width;
+
+    // clang-format off
+    BeamSearchLogNormKernel<T>
+        <<<batch_size * beam_width, kBeamSearchBlockSize, 0, d.stream()>>>(
+            logits.data(), vocab_size, log_norms);
+    CudaLaunchConfig config =
+        GetCudaLaunchConfig(batch_size * num_candidates, d);
+    BeamSearchScoresKernel<T>
+        <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+            batch_size, beam_width, vocab_size, num_candidates,
+            logits.data(), log_probs.data(), lengths.data(), finished.data(),
+            log_norms, end_token, length_penalty_weight, candidate_scores);
+    BeamSearchSelectKernel<T>
+        <<<batch_size, kBeamSearchBlockSize, 0, d.stream()>>>(
+            beam_width, vocab_size, num_candidates, logits.data(),
+            log_probs.data(), lengths.data(), finished.data(), log_norms,
+            end_token, candidate_scores, scores.data(), predicted_ids.data(),
+            parent_ids.data(), next_log_probs.data(), next_lengths.data(),
+            next_finished.data());
+    // clang-format on
+    const cudaError_t err = cudaGetLastError();
+    if (err != cudaSuccess) {
+      return errors::Internal("Could not launch BeamSearchStep kernels: ",
+                              cudaGetErrorString(err));
+    }
+    return Status::OK();
+  }
+};
+
+template <typename T>
+struct GatherBeams<GPUDevice, T> {
+  void operator()(const GPUDevice& d, typename TTypes<T, 3>::ConstTensor params,
+                  typename TTypes<int32>::ConstMatrix indices,
+                  typename TTypes<T, 3>::Tensor output) {
+    const int64 size = params.size();
+    CudaLaunchConfig config = GetCudaLaunchConfig(size, d);
+    // clang-format off
+    GatherBeamsKernel<T>
+        <<<config.block_count, config.thread_per_block, 0, d.stream()>>>(
+            size, params.dimension(1), params.dimension(2), params.data(),
+            indices.data(), output.data());
+    // clang-format on
+  }
+};
+
+template struct BeamSearchStep<GPUDevice, float>;
+template struct BeamSearchStep<GPUDevice, double>;
+
+#define DEFINE_GPU_SPECS(T) template struct GatherBeams<GPUDevice, T>;
+
+TF_CALL_GPU_NUMBER_TYPES(DEFINE_GPU_SPECS);
+TF_CALL_int32(DEFINE_GPU_SPECS);
+TF_CALL_int64(DEFINE_GPU_SPECS);
+TF_CALL_bool(DEFINE_GPU_SPECS);
+#undef DEFINE_GPU_SPECS
+
 }  // end namespace functor
 }  // end namespace tensorflow
 #endif  // GOOGLE_CUDA
@@ -65,4 +65,98 @@ sequence_length: `[batch_size, beam_width]`.
 beams: `[max_time, batch_size, beam_width]`.
 )doc");
 
+REGISTER_OP("BeamSearchStep")
+    .Input("logits: T")
+    .Input("log_probs: T")
+    .Input("lengths: int32")
+    .Input("finished: bool")
+    .Input("time: int32")
+    .Input("end_token: int32")
+    .Input("length_penalty_weight: T")
+    .Output("scores: T")
+    .Output("predicted_ids: int32")
+    .Output("parent_ids: int32")
+    .Output("next_log_probs: T")
+    .Output("next_lengths: int32")
+    .Output("next_finished: bool")
+    .Attr("T: {float, double}")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle logits, beams, unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 3, &logits));
+      TF_RETURN_IF_ERROR(c->Subshape(logits, 0, 2, &beams));
+      for (int i = 1; i < 4; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 2, &unused));
+        TF_RETURN_IF_ERROR(c->Merge(beams, c->input(i), &beams));
+      }
+      for (int i = 4; i < 7; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+      }
+      for (int i = 0; i < 6; ++i) {
+        c->set_output(i, beams);
+      }
+      return tensorflow::Status::OK();
+    })
+    .Doc(R"doc(
+Performs one step of beam search decoding.
+
+Computes the log softmax of the logits, masks the finished beams so that
+they can only be continued by `end_token`, scores every continuation by its
+total log probability divided by the length penalty, and selects the
+`beam_width` best continuations of each batch entry. On the first step
+(`time == 0`) only the continuations of the first beam are considered, since
+all the beams are equal.
+
+logits: `[batch_size, beam_width, vocab_size]`, the logits of this step.
+log_probs: `[batch_size, beam_width]`, the log probabilities of the beams.
+lengths: `[batch_size, beam_width]`, the lengths of the beams.
+finished: `[batch_size, beam_width]`, whether the beams are finished.
+time: The step, starting at 0.
+end_token: The end token.
+length_penalty_weight: The weight of the length penalty, disabled with 0.
+scores: `[batch_size, beam_width]`, the scores of the selected
+  continuations, in decreasing order.
+predicted_ids: `[batch_size, beam_width]`, the words that continue the beams.
+parent_ids: `[batch_size, beam_width]`, the beams that are continued.
+next_log_probs: `[batch_size, beam_width]`, the log probabilities of the new
+  beams.
+next_lengths: `[batch_size, beam_width]`, the lengths of the new beams.
+next_finished: `[batch_size, beam_width]`, whether the new beams are finished.
+)doc");
+
+REGISTER_OP("GatherBeams")
+    .Input("params: T")
+    .Input("parent_ids: int32")
+    .Output("output: T")
+    .Attr("T: type")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle params, beams;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 2, &params));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &beams));
+      ShapeHandle params_beams;
+      TF_RETURN_IF_ERROR(c->Subshape(params, 0, 2, &params_beams));
+      TF_RETURN_IF_ERROR(c->Merge(params_beams, beams, &beams));
+      ShapeHandle inner;
+      TF_RETURN_IF_ERROR(c->Subshape(params, 2, &inner));
+      ShapeHandle output;
+      TF_RETURN_IF_ERROR(c->Concatenate(beams, inner, &output));
+      c->set_output(0, output);
+      return tensorflow::Status::OK();
+    })
+    .Doc(R"doc(
+Reorders the beams of a decoder state by their parent beams.
+
+The beams of the output are gathered from the beams of `params` of the same
+batch entry:
+
+```python
+output[b, j, ...] = params[b, parent_ids[b, j], ...]
+```
+
+The output may reuse the buffer of `params`.
+
+params: `[batch_size, beam_width, ...]`.
+parent_ids: `[batch_size, beam_width]`, in `[0, beam_width)`.
+output: `[batch_size, beam_width, ...]`.
+)doc");
+
 }  // end namespace tensorflow
@@ -149,5 +149,111 @@ class GatherTreeTest(test.TestCase):
       self.assertAllEqual(expected_beams, beams.eval())
 
 
+def _beam_search_step(logits, log_probs, lengths, finished, time, end_token,
+                      length_penalty_weight):
+  """A NumPy reference of the beam_search_step op."""
+  batch_size, beam_width, vocab_size = logits.shape
+  shifted = logits - logits.max(axis=2, keepdims=True)
+  step_log_probs = shifted - np.log(
+      np.exp(shifted).sum(axis=2, keepdims=True))
+  finished_row = np.full(vocab_size, np.finfo(logits.dtype).min, logits.dtype)
+  finished_row[end_token] = 0
+  step_log_probs[finished] = finished_row
+  total = log_probs[:, :, None] + step_log_probs
+  not_end = (np.arange(vocab_size) != end_token).astype(np.int32)
+  new_lengths = lengths[:, :, None] + (~finished)[:, :, None] * not_end
+  penalty = ((5. + new_lengths) / 6.)**length_penalty_weight
+  scores = (total / penalty).reshape(batch_size, -1)
+  if time == 0:
+    scores = scores[:, :vocab_size]
+  outputs = [np.zeros((batch_size, beam_width), dtype)
+             for dtype in (logits.dtype, np.int32, np.int32, logits.dtype,
+                           np.int32, np.bool)]
+  for b in range(batch_size):
+    # Sort by decreasing score, then increasing index.
+    order = np.lexsort((np.arange(scores.shape[1]), -scores[b]))
+    for i, index in enumerate(order[:beam_width]):
+      word, parent = index % vocab_size, index // vocab_size
+      now_finished = finished[b, parent] or word == end_token
+      outputs[0][b, i] = scores[b, index]
+      outputs[1][b, i] = word
+      outputs[2][b, i] = parent
+      outputs[3][b, i] = total[b, parent, word]
+      outputs[4][b, i] = lengths[b, parent] + (0 if now_finished else 1)
+      outputs[5][b, i] = now_finished
+  return outputs
+
+
+class BeamSearchStepTest(test.TestCase):
+
+  def _testStep(self, time, length_penalty_weight, dtype):
+    np.random.seed(time)
+    batch_size, beam_width, vocab_size, end_token = 3, 4, 7, 2
+    logits = np.random.randn(batch_size, beam_width, vocab_size).astype(dtype)
+    log_probs = -np.random.rand(batch_size, beam_width).astype(dtype)
+    lengths = np.random.randint(1, 5, (batch_size, beam_width)).astype(
+        np.int32)
+    finished = np.random.rand(batch_size, beam_width) < 0.3
+    expected = _beam_search_step(logits, log_probs, lengths, finished, time,
+                                 end_token, length_penalty_weight)
+    with self.test_session(use_gpu=True):
+      outputs = beam_search_ops.beam_search_step(
+          logits=logits, log_probs=log_probs, lengths=lengths,
+          finished=finished, time=time, end_token=end_token,
+          length_penalty_weight=length_penalty_weight)
+      for expected_output, output in zip(expected, outputs):
+        if expected_output.dtype == dtype:
+          self.assertAllClose(expected_output, output.eval(), rtol=1e-5)
+        else:
+          self.assertAllEqual(expected_output, output.eval())
+
+  def testFirstStep(self):
+    self._testStep(time=0, length_penalty_weight=0., dtype=np.float32)
+
+  def testStep(self):
+    self._testStep(time=3, length_penalty_weight=0., dtype=np.float32)
+
+  def testStepWithLengthPenalty(self):
+    self._testStep(time=3, length_penalty_weight=0.6, dtype=np.float32)
+    self._testStep(time=5, length_penalty_weight=0.6, dtype=np.float64)
+
+  def testVocabularyTooSmall(self):
+    logits = np.zeros((1, 4, 3), np.float32)
+    beams = np.zeros((1, 4))
+    with self.test_session():
+      outputs = beam_search_ops.beam_search_step(
+          logits=logits, log_probs=beams.astype(np.float32),
+          lengths=beams.astype(np.int32), finished=beams.astype(np.bool),
+          time=0, end_token=0, length_penalty_weight=0.)
+      with self.assertRaisesOpError("the vocabulary is too small"):
+        outputs[0].eval()
+
+
+class GatherBeamsTest(test.TestCase):
+
+  def testGatherBeams(self):
+    params = np.arange(2 * 3 * 4).reshape(2, 3, 4).astype(np.float32)
+    parent_ids = np.array([[2, 0, 0], [1, 2, 0]], np.int32)
+    expected = np.stack([params[b, parent_ids[b]] for b in range(2)])
+    with self.test_session(use_gpu=True):
+      output = beam_search_ops.gather_beams(params, parent_ids)
+      self.assertAllEqual(expected, output.eval())
+
+  def testGatherBeamsMatrix(self):
+    params = np.array([[True, False], [False, True]])
+    parent_ids = np.array([[1, 1], [0, 1]], np.int32)
+    with self.test_session(use_gpu=True):
+      output = beam_search_ops.gather_beams(params, parent_ids)
+      self.assertAllEqual([[False, False], [False, True]], output.eval())
+
+  def testBadParentValuesOnCPU(self):
+    with ops.device("/cpu:0"):
+      output = beam_search_ops.gather_beams(
+          np.zeros((1, 2, 3), np.float32), np.array([[0, 2]], np.int32))
+    with self.test_session():
+      with self.assertRaisesOpError(r"parent_ids\[0, 1\] = 2"):
+        output.eval()
+
+
 if __name__ == "__main__":
   test.main()
@@ -473,6 +473,15 @@ def _beam_search_step(time, logits, next_cell_state, beam_state, batch_size,
   Returns:
     A new beam state.
   """
+  if logits.dtype in (dtypes.float32, dtypes.float64):
+    return _fused_beam_search_step(
+        time=time,
+        logits=logits,
+        next_cell_state=next_cell_state,
+        beam_state=beam_state,
+        end_token=end_token,
+        length_penalty_weight=length_penalty_weight)
+
   static_batch_size = tensor_util.constant_value(batch_size)
 
   # Calculate the current lengths of the predictions
@@ -587,6 +596,80 @@ def _beam_search_step(time, logits, next_cell_state, beam_state, batch_size,
   return output, next_state
 
 
+def _fused_beam_search_step(time, logits, next_cell_state, beam_state,
+                            end_token, length_penalty_weight):
+  """Performs a single step of Beam Search Decoding with native kernels.
+
+  This computes the same step as `_beam_search_step`, with a single
+  `BeamSearchStep` op selecting the continuations of the beams and a
+  `GatherBeams` op reordering each tensor of the cell state, instead of a
+  graph of generic ops.
+
+  Args:
+    time: Beam search time step, should start at 0.
+    logits: Logits at the current time step. A tensor of shape
+      `[batch_size, beam_width, vocab_size]`
+    next_cell_state: The next state from the cell.
+    beam_state: Current state of the beam search.
+      An instance of `BeamSearchDecoderState`.
+    end_token: The int32 end token.
+    length_penalty_weight: Float weight to penalize length. Disabled with 0.0.
+
+  Returns:
+    A new beam state.
+  """
+  (next_beam_scores, next_word_ids, next_beam_ids, next_beam_probs,
+   next_prediction_len, next_finished) = beam_search_ops.beam_search_step(
+       logits=logits,
+       log_probs=beam_state.log_probs,
+       lengths=beam_state.lengths,
+       finished=beam_state.finished,
+       time=ops.convert_to_tensor(time, dtype=dtypes.int32, name="time"),
+       end_token=end_token,
+       length_penalty_weight=math_ops.cast(length_penalty_weight,
+                                           logits.dtype))
+
+  next_cell_state = nest.map_structure(
+      lambda gather_from: _maybe_gather_beams(gather_from, next_beam_ids),
+      next_cell_state)
+
+  next_state = BeamSearchDecoderState(
+      cell_state=next_cell_state,
+      log_probs=next_beam_probs,
+      lengths=next_prediction_len,
+      finished=next_finished)
+
+  output = BeamSearchDecoderOutput(
+      scores=next_beam_scores,
+      predicted_ids=next_word_ids,
+      parent_ids=next_beam_ids)
+
+  return output, next_state
+
+
+def _maybe_gather_beams(gather_from, parent_ids):
+  """Applies `gather_beams` to the tensors that have beams.
+
+  This is the counterpart of `_maybe_tensor_gather_helper` for the native
+  kernels.
+
+  Args:
+    gather_from: The tensor that we are gathering from, of shape
+      `[batch_size, beam_width, ...]` if it has beams.
+    parent_ids: The beams to gather, a tensor of shape
+      `[batch_size, beam_width]`.
+
+  Returns:
+    output: The reordered tensor, or the original tensor if its dimensions are
+      too small.
+  """
+  _check_maybe(gather_from)
+  if gather_from.shape.ndims >= 2:
+    return beam_search_ops.gather_beams(gather_from, parent_ids)
+  else:
+    return gather_from
+
+
 def _get_scores(log_probs, sequence_lengths, length_penalty_weight):
   """Calculates scores for beam search hypotheses.
 
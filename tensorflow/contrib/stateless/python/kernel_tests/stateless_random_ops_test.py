@@ -20,6 +20,7 @@ from __future__ import print_function
 
 import numpy as np
 from tensorflow.contrib import stateless
+from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import random_seed
 from tensorflow.python.ops import array_ops
@@ -79,6 +80,27 @@ class StatelessOpsTest(test.TestCase):
             for s1, v1 in values:
               self.assertEqual(s0 == s1, np.all(v0 == v1))
 
+  def testMatchAcrossDevices(self):
+    # The GPU kernels should produce the same values as the CPU kernels, for
+    # shapes of either type, including ones that end in a partial group.
+    if not test.is_gpu_available():
+      self.skipTest('No GPU available')
+    seed = (7, 17)
+    for stateless_op, _ in CASES:
+      for shape_dtype in dtypes.int32, dtypes.int64:
+        for shape in (), (3,), (2, 5), (1001,):
+          shape_t = constant_op.constant(shape, dtype=shape_dtype)
+          with self.test_session(use_gpu=False):
+            cpu = stateless_op(shape_t, seed=seed).eval()
+          with self.test_session(force_gpu=True):
+            gpu = stateless_op(shape_t, seed=seed).eval()
+          if stateless_op is stateless.stateless_random_uniform:
+            self.assertAllEqual(cpu, gpu)
+          else:
+            # The log, sin and cos of the GPU may differ from the CPU ones in
+            # the last bit.
+            self.assertAllClose(cpu, gpu, rtol=1e-6, atol=1e-6)
+
 
 if __name__ == '__main__':
   test.main()
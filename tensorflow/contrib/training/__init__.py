@@ -27,6 +27,8 @@ See @{$python/contrib.training} guide.
 @@bucket_by_sequence_length
 @@GreedyLoadBalancingStrategy
 @@byte_size_load_fn
+@@bandwidth_load_fn
+@@access_bytes_from_run_metadata
 @@FailureTolerator
 @@rejection_sample
 @@stratified_sample
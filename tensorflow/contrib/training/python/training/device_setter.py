@@ -19,9 +19,12 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import collections
+
 import numpy as np
 
 from tensorflow.python.framework import tensor_shape
+from tensorflow.python.util import compat
 
 
 class GreedyLoadBalancingStrategy(object):
@@ -37,9 +40,16 @@ class GreedyLoadBalancingStrategy(object):
 
   One reasonable heuristic is the `byte_size_load_fn`, which
   estimates load as the number of bytes that would be used to store and
-  transmit the entire variable.  More advanced load functions
-  could consider the difference in access patterns across ops, or trade
-  off CPU-intensive ops with RAM-intensive ops with network bandwidth.
+  transmit the entire variable.  `bandwidth_load_fn` also accounts for
+  the traffic measured in a previous run, so that e.g. a large embedding
+  of which few rows are read per step doesn't count as a hot variable.
+  More advanced load functions could trade off CPU-intensive ops with
+  RAM-intensive ops with network bandwidth.
+
+  A variable too large for the share of any one ps task can't be balanced
+  by placement alone; create it with a partitioner such as
+  `tf.variable_axis_size_partitioner(max_shard_bytes, max_shards=num_tasks)`
+  so its shards are placed independently.
 
   This class is intended to be used as a `ps_strategy` in
   `tf.train.replica_device_setter`.
@@ -105,3 +115,102 @@ def byte_size_load_fn(op):
     shape = tensor_shape.TensorShape(op.get_attr("shape"))
   shape.assert_is_fully_defined()
   return shape.num_elements() * elem_size
+
+
+def _colocation_group(node_def):
+  """Returns the name of the op `node_def` is colocated with, or its own."""
+  if "_class" in node_def.attr:
+    for s in node_def.attr["_class"].list.s:
+      s = compat.as_str(s)
+      if s.startswith("loc:@"):
+        return s[len("loc:@"):]
+  return node_def.name
+
+
+def _parse_input(name):
+  """Returns the node name and output slot of a non-control input."""
+  node, _, slot = name.partition(":")
+  return node, int(slot) if slot else 0
+
+
+def access_bytes_from_run_metadata(run_metadata):
+  """Returns the bytes transferred for each variable in a traced step.
+
+  The tensors each `_Send` op of the step's partitions sent are charged to
+  the colocation group of the op that produced them, and the tensors each
+  `_Recv` op received to that of the ops that consume them.  Ops that read
+  or update a variable (its `read` identity, the `Gather`s of an embedding,
+  the updates of an optimizer, ...) are colocated with it, so this is the
+  network traffic of the variable's ps task due to the variable.
+
+  Args:
+    run_metadata: A `RunMetadata` from a step run with
+      `RunOptions(trace_level=RunOptions.FULL_TRACE,
+      output_partition_graphs=True)`.
+
+  Returns:
+    A dict from op name to the number of bytes sent or received in the step
+    for it and for the ops colocated with it.
+  """
+  output_bytes = {}
+  for dev_stats in run_metadata.step_stats.dev_stats:
+    for node_stats in dev_stats.node_stats:
+      for output in node_stats.output:
+        output_bytes[(node_stats.node_name, output.slot)] = (
+            output.tensor_description.allocation_description.requested_bytes)
+
+  nodes = {}
+  for graph_def in run_metadata.partition_graphs:
+    for node_def in graph_def.node:
+      nodes[node_def.name] = node_def
+
+  access_bytes = collections.defaultdict(int)
+  received = set()
+  for node_def in nodes.values():
+    for input_name in node_def.input:
+      if input_name.startswith("^"):
+        continue
+      src, slot = _parse_input(input_name)
+      src_def = nodes.get(src)
+      if node_def.op in ("_Send", "_HostSend"):
+        group = _colocation_group(src_def) if src_def is not None else src
+      elif src_def is not None and src_def.op in ("_Recv", "_HostRecv"):
+        # A received tensor counts once for each group consuming it.
+        group = _colocation_group(node_def)
+        if (group, src) in received:
+          continue
+        received.add((group, src))
+      else:
+        continue
+      access_bytes[group] += output_bytes.get((src, slot), 0)
+  return dict(access_bytes)
+
+
+def bandwidth_load_fn(access_bytes=None, storage_weight=1.0):
+  """Returns a load function of the storage and traffic of variables.
+
+  The load of a variable is `storage_weight` times its byte size, as
+  computed by `byte_size_load_fn`, plus the bytes transferred for it per
+  step.  The latter is taken from `access_bytes`, e.g. as returned by
+  `access_bytes_from_run_metadata` for a step of a previous run.  Variables
+  not in `access_bytes` are assumed to be read and updated entirely once
+  per step.
+
+  Intended to be used with `GreedyLoadBalancingStrategy`.
+
+  Args:
+    access_bytes: A dict from op name to the number of bytes transferred
+      for it per step, or `None`.
+    storage_weight: How much the bytes needed to hold a variable count
+      relative to the bytes transferred for it per step.
+
+  Returns:
+    A function that takes an `Operation` and returns its load.
+  """
+  access_bytes = access_bytes or {}
+
+  def _load_fn(op):
+    size = byte_size_load_fn(op)
+    return storage_weight * size + access_bytes.get(op.name, 2 * size)
+
+  return _load_fn
@@ -18,12 +18,14 @@ from __future__ import division
 from __future__ import print_function
 
 from tensorflow.contrib.training.python.training import device_setter as device_setter_lib
+from tensorflow.core.protobuf import config_pb2
 from tensorflow.python.framework import ops
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import variables
 from tensorflow.python.platform import test
 from tensorflow.python.training import device_setter
 from tensorflow.python.training import server_lib
+from tensorflow.python.util import compat
 
 
 class GreedyLoadBalancingStrategyTest(test.TestCase):
@@ -92,6 +94,57 @@ class GreedyLoadBalancingStrategyTest(test.TestCase):
       self.assertDeviceEqual("/job:ps/task:0", u.device)
       self.assertDeviceEqual("/job:ps/task:0", u.initializer.device)
 
+  def testBandwidthLoadFn(self):
+    # "emb" is large but only a few bytes of it are transferred per step.
+    load_fn = device_setter_lib.bandwidth_load_fn(
+        access_bytes={"emb": 80}, storage_weight=0.0)
+    with ops.device(
+        device_setter.replica_device_setter(
+            cluster=self._cluster_spec,
+            ps_strategy=device_setter_lib.GreedyLoadBalancingStrategy(
+                2, load_fn))):
+      u = variables.Variable(array_ops.zeros([100, 10]), name="emb")
+      v = variables.Variable(array_ops.zeros([10, 10]))
+      w = variables.Variable(array_ops.zeros([10, 10]))
+      x = variables.Variable(array_ops.zeros([10, 10]))
+      self.assertDeviceEqual("/job:ps/task:0", u.device)
+      self.assertDeviceEqual("/job:ps/task:1", v.device)
+      self.assertDeviceEqual("/job:ps/task:0", w.device)
+      self.assertDeviceEqual("/job:ps/task:1", x.device)
+
+  def testAccessBytesFromRunMetadata(self):
+    run_metadata = config_pb2.RunMetadata()
+    graph_def = run_metadata.partition_graphs.add()
+
+    def _add_node(name, op, inputs=(), colocate_with=None):
+      node_def = graph_def.node.add(name=name, op=op, input=inputs)
+      if colocate_with:
+        node_def.attr["_class"].list.s.append(
+            compat.as_bytes("loc:@" + colocate_with))
+
+    _add_node("emb", "VariableV2")
+    _add_node("emb/read", "Identity", ["emb"], "emb")
+    _add_node("ids", "_Recv")
+    _add_node("gather", "Gather", ["emb/read", "ids"], "emb")
+    _add_node("gather/_S0", "_Send", ["gather"])
+    _add_node("grad", "_Recv")
+    _add_node("update", "ScatterSub", ["emb", "ids", "grad:0"], "emb")
+    _add_node("v", "VariableV2")
+    _add_node("v/read", "Identity", ["v", "^update"], "v")
+    _add_node("v/read/_S1", "_Send", ["v/read"])
+
+    dev_stats = run_metadata.step_stats.dev_stats.add(
+        device="/job:ps/replica:0/task:0/cpu:0")
+    for name, num_bytes in [("emb/read", 4000), ("ids", 8), ("gather", 40),
+                            ("grad", 40), ("v/read", 400)]:
+      output = dev_stats.node_stats.add(node_name=name).output.add(slot=0)
+      output.tensor_description.allocation_description.requested_bytes = (
+          num_bytes)
+
+    self.assertEqual({"emb": 8 + 40 + 40, "v": 400},
+                     device_setter_lib.access_bytes_from_run_metadata(
+                         run_metadata))
+
 
 if __name__ == "__main__":
   test.main()
@@ -0,0 +1,114 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Utility that converts a vocabulary text file into a mapped hash table file,
+// which MappedHashTableV2 ops serve lookups from in place.
+//
+//  tensorflow/contrib/util/build_mapped_hash_table
+//        --in_vocabulary=vocab.txt --out_table=vocab.table
+//
+// Parameters:
+// in_vocabulary - name of the text file with the table entries.
+// out_table - name of the output file, where the table will be saved.
+// key_dtype, value_dtype - the types of the keys and values, e.g. string and
+// int64.
+// key_index, value_index - the fields of the lines holding the keys and values,
+// counting from 0, or -2 for the whole line and -1 for the line number.
+// delimiter - the delimiter of the fields of a line.
+// vocab_size - the number of lines to read, or -1 to read them all.
+
+#include <vector>
+
+#include "tensorflow/contrib/util/build_mapped_hash_table_lib.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace {
+
+int ParseFlagsAndBuildTable(int argc, char* argv[]) {
+  string in_vocabulary = "";
+  string out_table = "";
+  string key_dtype = "string";
+  string value_dtype = "int64";
+  int32 key_index = -2;
+  int32 value_index = -1;
+  string delimiter = "\t";
+  int64 vocab_size = -1;
+  std::vector<Flag> flag_list = {
+      Flag("in_vocabulary", &in_vocabulary, "input vocabulary file"),
+      Flag("out_table", &out_table, "output table file"),
+      Flag("key_dtype", &key_dtype, "type of the keys"),
+      Flag("value_dtype", &value_dtype, "type of the values"),
+      Flag("key_index", &key_index,
+           "field of the keys, -2 for the whole line, -1 for the line number"),
+      Flag("value_index", &value_index,
+           "field of the values, -2 for the whole line, -1 for the line "
+           "number"),
+      Flag("delimiter", &delimiter, "delimiter of the fields"),
+      Flag("vocab_size", &vocab_size, "number of lines to read, -1 for all"),
+  };
+  string usage = Flags::Usage(argv[0], flag_list);
+  const bool parse_result = Flags::Parse(&argc, argv, flag_list);
+  // We need to call this to set up global state for TensorFlow.
+  port::InitMain(usage.c_str(), &argc, &argv);
+  if (!parse_result) {
+    LOG(ERROR) << "\n" << usage;
+    return -1;
+  }
+  if (argc > 1) {
+    LOG(ERROR) << "Unknown argument " << argv[1] << "\n" << usage;
+    return -1;
+  }
+  if (in_vocabulary.empty()) {
+    LOG(ERROR) << "in_vocabulary can't be empty";
+    return -1;
+  }
+  if (out_table.empty()) {
+    LOG(ERROR) << "out_table can't be empty";
+    return -1;
+  }
+  if (delimiter.size() != 1) {
+    LOG(ERROR) << "delimiter must be a single character";
+    return -1;
+  }
+  DataType key_type;
+  DataType value_type;
+  if (!DataTypeFromString(key_dtype, &key_type)) {
+    LOG(ERROR) << "Unknown key_dtype " << key_dtype;
+    return -1;
+  }
+  if (!DataTypeFromString(value_dtype, &value_type)) {
+    LOG(ERROR) << "Unknown value_dtype " << value_dtype;
+    return -1;
+  }
+  const auto result = BuildMappedHashTableFromTextFile(
+      in_vocabulary, out_table, key_type, value_type, key_index, value_index,
+      delimiter[0], vocab_size);
+  if (!result.ok()) {
+    LOG(ERROR) << "Conversion failed " << result.error_message();
+    return -1;
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace tensorflow
+
+int main(int argc, char* argv[]) {
+  return tensorflow::ParseFlagsAndBuildTable(argc, argv);
+}
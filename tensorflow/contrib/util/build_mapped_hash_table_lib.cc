@@ -0,0 +1,96 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/util/build_mapped_hash_table_lib.h"
+
+#include <memory>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/initializable_lookup_table.h"
+#include "tensorflow/core/kernels/lookup_table_init_op.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/util/mapped_hash_table.h"
+
+namespace tensorflow {
+namespace {
+
+// A table that forwards the entries it is initialized with to a
+// MappedHashTableWriter, so that the text file is parsed exactly as it is by
+// the text file initializer ops.
+class MappedHashTableBuilder : public lookup::InitializableLookupTable {
+ public:
+  MappedHashTableBuilder(DataType key_dtype, DataType value_dtype,
+                         std::unique_ptr<MappedHashTableWriter> writer)
+      : key_dtype_(key_dtype),
+        value_dtype_(value_dtype),
+        writer_(std::move(writer)) {}
+
+  size_t size() const override { return size_; }
+
+  DataType key_dtype() const override { return key_dtype_; }
+
+  DataType value_dtype() const override { return value_dtype_; }
+
+  string DebugString() override { return "MappedHashTableBuilder"; }
+
+  MappedHashTableWriter* writer() { return writer_.get(); }
+
+ protected:
+  Status DoPrepare(size_t expected_num_elements) override {
+    return Status::OK();
+  }
+
+  Status DoInsert(const Tensor& keys, const Tensor& values) override {
+    TF_RETURN_IF_ERROR(writer_->Add(keys, values));
+    size_ += keys.NumElements();
+    return Status::OK();
+  }
+
+  Status DoFind(const Tensor& keys, Tensor* values,
+                const Tensor& default_value) override {
+    return errors::Unimplemented(
+        "MappedHashTableBuilder does not support Find");
+  }
+
+ private:
+  const DataType key_dtype_;
+  const DataType value_dtype_;
+  std::unique_ptr<MappedHashTableWriter> writer_;
+  size_t size_ = 0;
+};
+
+}  // namespace
+
+Status BuildMappedHashTableFromTextFile(const string& in_filename,
+                                        const string& out_filename,
+                                        DataType key_dtype,
+                                        DataType value_dtype, int32 key_index,
+                                        int32 value_index, char delimiter,
+                                        int64 vocab_size) {
+  std::unique_ptr<MappedHashTableWriter> writer;
+  TF_RETURN_IF_ERROR(
+      MappedHashTableWriter::Create(key_dtype, value_dtype, &writer));
+  MappedHashTableBuilder* builder =
+      new MappedHashTableBuilder(key_dtype, value_dtype, std::move(writer));
+  core::ScopedUnref unref(builder);
+  Env* env = Env::Default();
+  TF_RETURN_IF_ERROR(lookup::InitializeTableFromTextFile(
+      in_filename, vocab_size, delimiter, key_index, value_index, env,
+      builder));
+  return builder->writer()->Finish(env, out_filename);
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,42 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_UTIL_BUILD_MAPPED_HASH_TABLE_LIB_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_UTIL_BUILD_MAPPED_HASH_TABLE_LIB_H_
+
+#include <string>
+
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+
+// Builds a mapped hash table file, as described in
+// tensorflow/core/util/mapped_hash_table.h, from a text file, for use by
+// MappedHashTableV2 ops. The text file is parsed
+// as by InitializeTableFromTextFile ops: "key_index" and "value_index" select
+// the fields of each line split by "delimiter", or -2 for the whole line and -1
+// for the line number, and "vocab_size" limits the number of lines read, or is
+// -1 to read them all.
+Status BuildMappedHashTableFromTextFile(const string& in_filename,
+                                        const string& out_filename,
+                                        DataType key_dtype,
+                                        DataType value_dtype, int32 key_index,
+                                        int32 value_index, char delimiter,
+                                        int64 vocab_size);
+
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_UTIL_BUILD_MAPPED_HASH_TABLE_LIB_H_
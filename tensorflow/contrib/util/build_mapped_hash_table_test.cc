@@ -0,0 +1,69 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/util/build_mapped_hash_table_lib.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/mapped_hash_table.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(BuildMappedHashTableTest, WordsToLineNumbers) {
+  Env* env = Env::Default();
+  const string vocabulary = io::JoinPath(testing::TmpDir(), "words.txt");
+  const string table = io::JoinPath(testing::TmpDir(), "words.table");
+  TF_ASSERT_OK(WriteStringToFile(env, vocabulary, "brain\nsalad\nsurgery\n"));
+  TF_ASSERT_OK(BuildMappedHashTableFromTextFile(vocabulary, table, DT_STRING,
+                                                DT_INT64, -2, -1, '\t', -1));
+
+  std::unique_ptr<MappedHashTableReader> reader;
+  TF_ASSERT_OK(MappedHashTableReader::Open(env, table, &reader));
+  EXPECT_EQ(3, reader->size());
+  const MappedHashTableBucket* bucket;
+  TF_ASSERT_OK(reader->Find("surgery", &bucket));
+  ASSERT_NE(nullptr, bucket);
+  EXPECT_EQ(2, reader->Int64Value(*bucket));
+  TF_ASSERT_OK(reader->Find("brain", &bucket));
+  ASSERT_NE(nullptr, bucket);
+  EXPECT_EQ(0, reader->Int64Value(*bucket));
+  TF_ASSERT_OK(reader->Find("tarkus", &bucket));
+  EXPECT_EQ(nullptr, bucket);
+}
+
+TEST(BuildMappedHashTableTest, Fields) {
+  Env* env = Env::Default();
+  const string vocabulary = io::JoinPath(testing::TmpDir(), "ids.txt");
+  const string table = io::JoinPath(testing::TmpDir(), "ids.table");
+  TF_ASSERT_OK(WriteStringToFile(env, vocabulary, "7,seven\n42,forty two\n"));
+  TF_ASSERT_OK(BuildMappedHashTableFromTextFile(vocabulary, table, DT_INT64,
+                                                DT_STRING, 0, 1, ',', -1));
+
+  std::unique_ptr<MappedHashTableReader> reader;
+  TF_ASSERT_OK(MappedHashTableReader::Open(env, table, &reader));
+  EXPECT_EQ(2, reader->size());
+  const MappedHashTableBucket* bucket;
+  TF_ASSERT_OK(reader->Find(42, &bucket));
+  ASSERT_NE(nullptr, bucket);
+  StringPiece value;
+  TF_ASSERT_OK(reader->StringValue(*bucket, &value));
+  EXPECT_EQ("forty two", value);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -27,13 +27,18 @@ limitations under the License.
 // be saved.
 // min_conversion_size_bytes - tensors with fewer than this many bytes of data
 // will not be converted to ImmutableConst format, and kept in the graph.
+// page_aligned - whether to save the tensors at page-aligned offsets, so that
+// each of them can be paged in on its own. With min_conversion_tensor_size=1,
+// this packages all the weights of the model.
 
 #include <vector>
 
 #include "tensorflow/contrib/util/convert_graphdef_memmapped_format_lib.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/platform/init_main.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/util/command_line_flags.h"
+#include "tensorflow/core/util/memmapped_file_system_writer.h"
 
 namespace tensorflow {
 namespace {
@@ -42,12 +47,15 @@ int ParseFlagsAndConvertGraph(int argc, char* argv[]) {
   string in_graph = "";
   string out_graph = "";
   int min_conversion_tensor_size = 10000;
+  bool page_aligned = false;
   std::vector<Flag> flag_list = {
       Flag("in_graph", &in_graph, "input graph"),
       Flag("out_graph", &out_graph, "output graph"),
       Flag("min_conversion_tensor_size", &min_conversion_tensor_size,
            "constants with tensors that have less than this number elements "
            "won't be converted into ImmutableConst (be memmapped)"),
+      Flag("page_aligned", &page_aligned,
+           "save the tensors at page-aligned offsets of the package"),
   };
   string usage = Flags::Usage(argv[0], flag_list);
   const bool parse_result = Flags::Parse(&argc, argv, flag_list);
@@ -73,8 +81,10 @@ int ParseFlagsAndConvertGraph(int argc, char* argv[]) {
     LOG(ERROR) << "min_conversion_tensor_size must be > 0";
     return -1;
   }
-  const auto result = ConvertConstantsToImmutable(in_graph, out_graph,
-                                                  min_conversion_tensor_size);
+  const auto result = ConvertConstantsToImmutable(
+      in_graph, out_graph, min_conversion_tensor_size,
+      page_aligned ? MemmappedFileSystemWriter::kPageAlignment
+                   : Allocator::kAllocatorAlignment);
   if (!result.ok()) {
     LOG(ERROR) << "Conversion failed " << result.error_message();
     return -1;
@@ -36,7 +36,8 @@ class NodeConverter {
   Status ConvertConstantsToImmutable(NodeDef* node_def,
                                      MemmappedFileSystemWriter* writer,
                                      int* convert_counter,
-                                     int min_conversion_size_bytes) {
+                                     int min_conversion_size_bytes,
+                                     uint64 tensor_alignment) {
     // Check the size.
     const AttrValue& value = node_def->attr().at("value");
     const TensorProto& tensor_proto = value.tensor();
@@ -67,7 +68,9 @@ class NodeConverter {
       return errors::InvalidArgument("Cannot parse tensor from proto: ",
                                      tensor_proto.DebugString());
     }
-    if (parsed.TotalBytes() < static_cast<size_t>(min_conversion_size_bytes)) {
+    // Empty tensors can't be memmapped.
+    if (parsed.TotalBytes() == 0 ||
+        parsed.TotalBytes() < static_cast<size_t>(min_conversion_size_bytes)) {
       return Status::OK();
     }
 
@@ -75,7 +78,8 @@ class NodeConverter {
         MemmappedFileSystem::kMemmappedPackagePrefix +
         ConvertVariableNameToUniqueRegionName(node_def->name());
 
-    TF_RETURN_IF_ERROR(writer->SaveTensor(parsed, memmapped_region_name));
+    TF_RETURN_IF_ERROR(writer->SaveTensor(parsed, memmapped_region_name,
+                                          tensor_alignment));
 
     node_def->set_op("ImmutableConst");
 
@@ -130,10 +134,19 @@ class NodeConverter {
 
 }  // namespace
 
-// Loads the graph, replaces operators, and writes it out.
 Status ConvertConstantsToImmutable(const string& in_graph_filename,
                                    const string& out_graph_filename,
                                    int min_conversion_size_bytes) {
+  return ConvertConstantsToImmutable(in_graph_filename, out_graph_filename,
+                                     min_conversion_size_bytes,
+                                     Allocator::kAllocatorAlignment);
+}
+
+// Loads the graph, replaces operators, and writes it out.
+Status ConvertConstantsToImmutable(const string& in_graph_filename,
+                                   const string& out_graph_filename,
+                                   int min_conversion_size_bytes,
+                                   uint64 tensor_alignment) {
   Env* default_env = Env::Default();
   GraphDef graph_def;
   const auto load_graph_status =
@@ -159,7 +172,7 @@ Status ConvertConstantsToImmutable(const string& in_graph_filename,
       // Try to convert to ImmutableConst
       TF_RETURN_IF_ERROR(node_converter.ConvertConstantsToImmutable(
           graph_def.mutable_node(i), &writer, &convert_counter,
-          min_conversion_size_bytes));
+          min_conversion_size_bytes, tensor_alignment));
     }
   }
   TF_RETURN_IF_ERROR(writer.SaveProtobuf(
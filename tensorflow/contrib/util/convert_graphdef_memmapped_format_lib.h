@@ -19,6 +19,7 @@ limitations under the License.
 #include <string>
 
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
 
@@ -29,6 +30,15 @@ Status ConvertConstantsToImmutable(const string& in_graph_filename,
                                    const string& out_graph_filename,
                                    int min_conversion_size_bytes);
 
+// Like above, saving the tensors at offsets of the package aligned to
+// "tensor_alignment", e.g. MemmappedFileSystemWriter::kPageAlignment. A
+// "min_conversion_size_bytes" of 1 converts all the constants that can be
+// memmapped, so that no weights are left in the graph.
+Status ConvertConstantsToImmutable(const string& in_graph_filename,
+                                   const string& out_graph_filename,
+                                   int min_conversion_size_bytes,
+                                   uint64 tensor_alignment);
+
 }  // namespace tensorflow
 
 #endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_UTIL_CONVERT_GRAPHDEF_MEMMAPPED_FORMAT_LIB_H_
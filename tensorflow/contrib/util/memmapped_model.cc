@@ -0,0 +1,61 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/util/memmapped_model.h"
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+
+namespace tensorflow {
+
+Status MemmappedModel::Load(const string& filename,
+                            const MemmappedModelOptions& options,
+                            std::unique_ptr<MemmappedModel>* model) {
+  std::unique_ptr<MemmappedModel> result(new MemmappedModel);
+  Env* base_env = options.session_options.env != nullptr
+                      ? options.session_options.env
+                      : Env::Default();
+  result->env_.reset(new MemmappedEnv(base_env));
+  TF_RETURN_IF_ERROR(result->env_->InitializeFromFile(filename));
+  if (options.prefault) {
+    TF_RETURN_IF_ERROR(result->env_->Prefault());
+  }
+
+  GraphDef graph_def;
+  TF_RETURN_IF_ERROR(ReadBinaryProto(
+      result->env_.get(), MemmappedFileSystem::kMemmappedPackageDefaultGraphDef,
+      &graph_def));
+
+  SessionOptions session_options = options.session_options;
+  session_options.env = result->env_.get();
+  session_options.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_opt_level(OptimizerOptions::L0);
+  Session* session = nullptr;
+  TF_RETURN_IF_ERROR(NewSession(session_options, &session));
+  result->session_.reset(session);
+  TF_RETURN_IF_ERROR(session->Create(graph_def));
+  *model = std::move(result);
+  return Status::OK();
+}
+
+MemmappedModel::~MemmappedModel() {
+  if (session_ != nullptr) {
+    session_->Close().IgnoreError();
+    session_.reset();
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,70 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_CONTRIB_UTIL_MEMMAPPED_MODEL_H_
+#define THIRD_PARTY_TENSORFLOW_CONTRIB_UTIL_MEMMAPPED_MODEL_H_
+
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/memmapped_file_system.h"
+
+namespace tensorflow {
+
+// Options for MemmappedModel::Load().
+struct MemmappedModelOptions {
+  // The options of the session. Its "env" is replaced by a MemmappedEnv
+  // wrapping it (or Env::Default() if null), and its graph optimizations are
+  // turned off, so that constant folding doesn't copy the weights out of the
+  // package.
+  SessionOptions session_options;
+
+  // Whether to read all the pages of the package before creating the session,
+  // so that the first runs don't wait for the weights to be paged in.
+  bool prefault = false;
+};
+
+// A model packaged by convert_graphdef_memmapped_format, loaded into a
+// session. The weights of the converted constants stay in the mapping of the
+// package: loading is not proportional to their size, and the processes of a
+// host that load the same package share their pages.
+class MemmappedModel {
+ public:
+  static Status Load(const string& filename,
+                     const MemmappedModelOptions& options,
+                     std::unique_ptr<MemmappedModel>* model);
+
+  ~MemmappedModel();
+
+  Session* session() { return session_.get(); }
+  MemmappedEnv* env() { return env_.get(); }
+
+ private:
+  MemmappedModel() {}
+
+  // The session must be closed before the package is unmapped.
+  std::unique_ptr<MemmappedEnv> env_;
+  std::unique_ptr<Session> session_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemmappedModel);
+};
+
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CONTRIB_UTIL_MEMMAPPED_MODEL_H_
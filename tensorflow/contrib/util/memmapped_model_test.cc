@@ -0,0 +1,83 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/contrib/util/memmapped_model.h"
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/contrib/util/convert_graphdef_memmapped_format_lib.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/util/memmapped_file_system_writer.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(MemmappedModelTest, LoadAndRun) {
+  const string dir = testing::TmpDir();
+  const string filename_pb = io::JoinPath(dir, "memmapped_model.pb");
+
+  Tensor weights(DT_FLOAT, TensorShape({100, 10}));
+  test::FillFn<float>(&weights, [](int) -> float { return 2.0; });
+  Tensor bias(DT_FLOAT, TensorShape({10}));
+  test::FillFn<float>(&bias, [](int i) -> float { return i; });
+  Tensor input(DT_FLOAT, TensorShape({1, 100}));
+  test::FillFn<float>(&input, [](int) -> float { return 1.0; });
+
+  auto root = Scope::NewRootScope().ExitOnError();
+  auto x = ops::Placeholder(root.WithOpName("x"), DT_FLOAT);
+  auto y = ops::Add(root.WithOpName("y"), ops::MatMul(root, x, weights), bias);
+  GraphDef graph_def;
+  TF_ASSERT_OK(root.ToGraphDef(&graph_def));
+  TF_ASSERT_OK(WriteBinaryProto(Env::Default(), filename_pb, graph_def));
+
+  // Packages all the weights, however small.
+  const string filename_mmap = io::JoinPath(dir, "memmapped_model.mmap");
+  TF_ASSERT_OK(ConvertConstantsToImmutable(
+      filename_pb, filename_mmap, 1,
+      MemmappedFileSystemWriter::kPageAlignment));
+
+  MemmappedModelOptions options;
+  options.prefault = true;
+  std::unique_ptr<MemmappedModel> model;
+  TF_ASSERT_OK(MemmappedModel::Load(filename_mmap, options, &model));
+  GraphDef loaded_graph_def;
+  TF_ASSERT_OK(ReadBinaryProto(
+      model->env(), MemmappedFileSystem::kMemmappedPackageDefaultGraphDef,
+      &loaded_graph_def));
+  for (const NodeDef& node : loaded_graph_def.node()) {
+    EXPECT_NE("Const", node.op()) << node.name();
+  }
+
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(model->session()->Run({{"x", input}}, {"y"}, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  test::ExpectTensorEqual<float>(
+      test::AsTensor<float>({200, 201, 202, 203, 204, 205, 206, 207, 208, 209},
+                            {1, 10}),
+      outputs[0]);
+}
+
+TEST(MemmappedModelTest, NotAPackage) {
+  const string filename = io::JoinPath(testing::TmpDir(), "not_a_package");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename, "not a package"));
+  std::unique_ptr<MemmappedModel> model;
+  EXPECT_FALSE(
+      MemmappedModel::Load(filename, MemmappedModelOptions(), &model).ok());
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -16,12 +16,16 @@ limitations under the License.
 #ifdef TENSORFLOW_USE_VERBS
 
 #include "tensorflow/contrib/verbs/rdma.h"
+#include <algorithm>
 #include <cstdlib>
+#include <set>
 #include "tensorflow/contrib/verbs/verbs_util.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
+#include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_util.h"
 #include "tensorflow/core/common_runtime/gpu/process_state.h"
+#include "tensorflow/core/common_runtime/gpu_device_context.h"
 #include "tensorflow/core/distributed_runtime/rendezvous_mgr_interface.h"
 #include "tensorflow/core/distributed_runtime/session_mgr.h"
 #include "tensorflow/core/framework/rendezvous.h"
@@ -30,6 +34,8 @@ limitations under the License.
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/util/env_var.h"
 
 namespace tensorflow {
 
@@ -64,6 +70,18 @@ string MessageTypeToString(RdmaMessageType rmt) {
       return "UNKNOWN MESSAGE";
   }
 }
+
+// Tensors are copied into their RDMA buffer in at most kMaxCopyChunks chunks
+// of at least kMinCopyChunkBytes, and each chunk is written to the remote
+// as soon as it is in the buffer, so that the copy overlaps with the
+// transfer.
+const size_t kMinCopyChunkBytes = 1 << 20;
+const size_t kMaxCopyChunks = 8;
+
+size_t CopyChunkBytes(size_t tensor_bytes) {
+  return std::max(kMinCopyChunkBytes,
+                  (tensor_bytes + kMaxCopyChunks - 1) / kMaxCopyChunks);
+}
 }  // namespace
 
 ibv_context* open_default_device() {
@@ -97,10 +115,40 @@ RdmaAdapter::RdmaAdapter(const WorkerEnv* worker_env)
   polling_thread_.reset(Env::Default()->StartThread(
       ThreadOptions(), "RdmaAdapterCQThread", [this] { Process_CQ(); }));
   VLOG(2) << "Start RdmaAdapter: " << name();
+
+  // GPUDirect RDMA needs a peer memory module (e.g. nv_peer_mem) that lets
+  // the adapter register GPU memory, so it is opt-in.
+  bool use_gpudirect = false;
+  Status s = ReadBoolFromEnvVar("TF_VERBS_USE_GPUDIRECT", false,
+                                &use_gpudirect);
+  if (!s.ok()) {
+    LOG(ERROR) << s.error_message();
+  }
+  if (use_gpudirect) {
+    std::set<int> bus_ids;
+    for (const Device* d : worker_env_->device_mgr->ListDevices()) {
+      if (d->tensorflow_gpu_device_info() != nullptr) {
+        bus_ids.insert(d->attributes().locality().bus_id());
+      }
+    }
+    for (int bus_id : bus_ids) {
+      ProcessState::singleton()->AddGPUAllocVisitor(
+          bus_id, [this](void* ptr, size_t num_bytes) {
+            RegisterGPUMemoryRegion(ptr, num_bytes);
+          });
+    }
+  }
 }
 
 RdmaAdapter::~RdmaAdapter() {
   polling_thread_.reset();
+  {
+    mutex_lock l(mr_mu_);
+    for (ibv_mr* mr : gpu_mrs_) {
+      CHECK(!ibv_dereg_mr(mr)) << "ibv_dereg_mr failed";
+    }
+    gpu_mrs_.clear();
+  }
   CHECK(!ibv_destroy_cq(cq_)) << "Failed to destroy CQ";
   CHECK(!ibv_destroy_comp_channel(event_channel_))
       << "Failed to destroy channel";
@@ -110,6 +158,40 @@ RdmaAdapter::~RdmaAdapter() {
 
 string RdmaAdapter::name() const { return string(context_->device->name); }
 
+void RdmaAdapter::RegisterGPUMemoryRegion(void* ptr, size_t size) {
+  mutex_lock l(mr_mu_);
+  if (gpu_mr_failed_) return;
+  ibv_mr* mr = ibv_reg_mr(pd_, ptr, size,
+                          IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE);
+  if (mr == nullptr) {
+    LOG(WARNING) << "Could not register GPU memory with " << name()
+                 << ", GPU tensors are sent through host memory. Is a peer "
+                 << "memory module such as nv_peer_mem loaded?";
+    gpu_mr_failed_ = true;
+    return;
+  }
+  VLOG(1) << "Registered GPU memory region of " << size << " bytes at "
+          << ptr;
+  auto it = std::upper_bound(
+      gpu_mrs_.begin(), gpu_mrs_.end(), mr,
+      [](const ibv_mr* a, const ibv_mr* b) { return a->addr < b->addr; });
+  gpu_mrs_.insert(it, mr);
+}
+
+ibv_mr* RdmaAdapter::FindGPUMemoryRegion(const void* ptr, size_t size) const {
+  mutex_lock l(mr_mu_);
+  const char* begin = static_cast<const char*>(ptr);
+  auto it = std::upper_bound(
+      gpu_mrs_.begin(), gpu_mrs_.end(), begin,
+      [](const char* p, const ibv_mr* mr) {
+        return p < static_cast<const char*>(mr->addr);
+      });
+  if (it == gpu_mrs_.begin()) return nullptr;
+  ibv_mr* mr = *(it - 1);
+  const char* mr_end = static_cast<const char*>(mr->addr) + mr->length;
+  return begin + size <= mr_end ? mr : nullptr;
+}
+
 // Function to process incoming messages
 // There are two types of messages:
 // 1. IBV_WC_RECV_RDMA_WITH_IMM (receive)
@@ -219,6 +301,7 @@ void RdmaAdapter::Process_CQ() {
         }
       } else if (wc_[i].opcode == IBV_WC_RDMA_WRITE) {
         RdmaBuffer* rb = reinterpret_cast<RdmaBuffer*>(wc_[i].wr_id);
+        rb->ReleasePayload();
         rb->SetBufferStatus(local, idle);
         RdmaMessage rm;
         RdmaMessage::ParseMessage(rm, rb->buffer_);
@@ -242,7 +325,9 @@ RdmaChannel::RdmaChannel(const RdmaAdapter* adapter, const string local_name,
     attr.recv_cq = adapter_->cq_;
     attr.cap.max_send_wr = RdmaAdapter::MAX_CONCURRENT_WRITES;
     attr.cap.max_recv_wr = RdmaAdapter::MAX_CONCURRENT_WRITES;
-    attr.cap.max_send_sge = 1;
+    // A tensor sent with GPUDirect RDMA follows its message in a second
+    // scatter/gather entry.
+    attr.cap.max_send_sge = 2;
     attr.cap.max_recv_sge = 1;
     attr.qp_type = IBV_QPT_RC;
 
@@ -534,7 +619,12 @@ RdmaBuffer::~RdmaBuffer() {
 
 void RdmaBuffer::FreeBuffer() {
   if ((buffer_ != nullptr) && buffer_on_host_) {
-    free(buffer_);
+    if (buffer_allocator_ != nullptr) {
+      buffer_allocator_->DeallocateRaw(buffer_);
+      buffer_allocator_ = nullptr;
+    } else {
+      free(buffer_);
+    }
   }
   // TODO
   // release buffer if it is on device.
@@ -545,9 +635,10 @@ void RdmaBuffer::FreeBuffer() {
 // Args:
 //   size: to-be-allocated memory size
 //   lock: whether or not mutex_lock the process to protect concurrency.
+//   pinned: whether or not to allocate page-locked memory for GPU copies.
 // Returns:
 //   None
-void RdmaBuffer::CreateCPUBuffer(size_t size, bool lock) {
+void RdmaBuffer::CreateCPUBuffer(size_t size, bool lock, bool pinned) {
   CHECK(size > 0);
   if (lock) {
     mu_.lock();
@@ -558,7 +649,14 @@ void RdmaBuffer::CreateCPUBuffer(size_t size, bool lock) {
     FreeBuffer();
   }
   size_ = size;
-  buffer_ = malloc(size_);
+  if (pinned) {
+    buffer_allocator_ = ProcessState::singleton()->GetCUDAHostAllocator(0);
+    buffer_ = buffer_allocator_->AllocateRaw(Allocator::kAllocatorAlignment,
+                                             size_);
+    CHECK(buffer_) << "Failed to allocate pinned memory";
+  } else {
+    buffer_ = malloc(size_);
+  }
   self_ = ibv_reg_mr(channel_->adapter_->pd_, buffer_, size_,
                      IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE);
   CHECK(self_) << "Failed to register memory region";
@@ -595,20 +693,46 @@ void RdmaBuffer::EnqueueItem(string item) {
 
 // Rdma-Write the content of the buffer
 void RdmaBuffer::Write(uint32_t imm_data, size_t buffer_size) {
+  WriteRange(0, buffer_size, true, imm_data);
+}
+
+void RdmaBuffer::WriteRange(size_t offset, size_t length, bool last,
+                            uint32_t imm_data) {
   struct ibv_sge list;
-  list.addr = (uint64_t)buffer_;
-  list.length = buffer_size;
+  list.addr = (uint64_t)buffer_ + offset;
+  list.length = length;
   list.lkey = self_->lkey;
+  PostWrite(&list, 1, offset, last, imm_data);
+}
+
+void RdmaBuffer::WriteWithPayload(uint32_t imm_data, size_t buffer_size,
+                                  const void* payload, size_t payload_size,
+                                  uint32_t payload_lkey) {
+  struct ibv_sge list[2];
+  list[0].addr = (uint64_t)buffer_;
+  list[0].length = buffer_size;
+  list[0].lkey = self_->lkey;
+  list[1].addr = (uint64_t)payload;
+  list[1].length = payload_size;
+  list[1].lkey = payload_lkey;
+  PostWrite(list, 2, 0, true, imm_data);
+}
 
+void RdmaBuffer::PostWrite(ibv_sge* sg_list, int num_sge, size_t remote_offset,
+                           bool signaled, uint32_t imm_data) {
   struct ibv_send_wr wr;
   memset(&wr, 0, sizeof(wr));
   wr.wr_id = (uint64_t)this;
-  wr.sg_list = &list;
-  wr.num_sge = 1;
-  wr.opcode = IBV_WR_RDMA_WRITE_WITH_IMM;
-  wr.send_flags = IBV_SEND_SIGNALED;
-  wr.imm_data = imm_data;
-  wr.wr.rdma.remote_addr = (uint64_t)remote_.remote_addr;
+  wr.sg_list = sg_list;
+  wr.num_sge = num_sge;
+  if (signaled) {
+    wr.opcode = IBV_WR_RDMA_WRITE_WITH_IMM;
+    wr.send_flags = IBV_SEND_SIGNALED;
+    wr.imm_data = imm_data;
+  } else {
+    wr.opcode = IBV_WR_RDMA_WRITE;
+  }
+  wr.wr.rdma.remote_addr = (uint64_t)remote_.remote_addr + remote_offset;
   wr.wr.rdma.rkey = remote_.rkey;
 
   struct ibv_send_wr* bad_wr;
@@ -706,9 +830,12 @@ void RdmaTensorBuffer::SendNextItem() {
 
       bool can_memcpy = DataTypeCanUseMemcpy(in.dtype());
       // string tensor needs to be serialized
-      Tensor copy;
       StringPiece copy_buf;
       TensorProto proto;
+      // Whether the tensor is sent straight from GPU memory by SendGPUTensor,
+      // and whether its buffer is pinned for that.
+      bool from_gpu = false;
+      bool send_from_gpu = false;
       if (src_dev->tensorflow_gpu_device_info() &&
           (!send_args.alloc_attrs.on_host())) {
         CHECK(send_args.device_context)
@@ -716,15 +843,8 @@ void RdmaTensorBuffer::SendNextItem() {
           << " gpu_info: " << src_dev->tensorflow_gpu_device_info();
 
         if (can_memcpy) {
-          AllocatorAttributes host_alloc_attrs;
-          host_alloc_attrs.set_gpu_compatible(true);
-          host_alloc_attrs.set_on_host(true);
-          Allocator* alloc = ProcessState::singleton()->GetCUDAHostAllocator(0);
-          copy = Tensor(alloc, in.dtype(), in.shape());
-          s = VerbsUtil::CopyGPUTensorToCPUSync(
-              src_dev, send_args.device_context, &in, &copy);
-          CHECK(s.ok()) << "copy tensor from gpu sync";
-          copy_buf = copy.tensor_data();
+          from_gpu = true;
+          send_from_gpu = !is_dead && in.TotalBytes() > 0;
         } else {
           // "val" is on a GPU. Uses GPUUtil to fill the proto.
           s = VerbsUtil::SetProtoFromGPUSync(
@@ -763,8 +883,11 @@ void RdmaTensorBuffer::SendNextItem() {
         if ((local_status_ != none) && (buffer_size > size_)) {
           CHECK(rm.data_type_ == DT_STRING)
               << "Only string tensor allows to change size";
+          // Grow geometrically, so that a string tensor whose size keeps
+          // increasing doesn't re-register its buffers on every step.
+          rm.buffer_size_ = std::max(buffer_size, 2 * size_);
         }
-        CreateCPUBuffer(buffer_size, false);
+        CreateCPUBuffer(rm.buffer_size_, false, from_gpu);
         mu_.unlock();
         // put back the key since it is not sent;
         EnqueueItem(key_with_step_id);
@@ -791,11 +914,16 @@ void RdmaTensorBuffer::SendNextItem() {
         rm.type_ = RDMA_MESSAGE_TENSOR_WRITE;
         string message = RdmaMessage::CreateMessage(rm);
         memcpy(buffer_, message.data(), message.size());
+        if (send_from_gpu) {
+          SendGPUTensor(imm_data, in, src_dev, send_args.device_context);
+          return;
+        }
+        // bytes of the buffer already written to the remote
+        size_t written = 0;
         if (!is_dead) {
           // copy the tensor buffer content
-          void* output =
-              static_cast<void*>(static_cast<char*>(buffer_) +
-                                 RdmaMessage::kTensorBufferStartIndex);
+          char* output = static_cast<char*>(buffer_) +
+                         RdmaMessage::kTensorBufferStartIndex;
           CHECK(tensor_bytes + RdmaMessage::kTensorBufferStartIndex <= size_);
           if (can_memcpy) {
             CHECK(copy_buf.size() == tensor_bytes)
@@ -803,14 +931,25 @@ void RdmaTensorBuffer::SendNextItem() {
                << copy_buf.size()
                << " != "
                << tensor_bytes;
-            memcpy(output, copy_buf.data(), tensor_bytes);
+            const size_t chunk_bytes = CopyChunkBytes(tensor_bytes);
+            for (size_t copied = 0; copied < tensor_bytes;) {
+              const size_t n = std::min(chunk_bytes, tensor_bytes - copied);
+              memcpy(output + copied, copy_buf.data() + copied, n);
+              copied += n;
+              if (copied < tensor_bytes) {
+                const size_t end =
+                    RdmaMessage::kTensorBufferStartIndex + copied;
+                WriteRange(written, end - written, false, imm_data);
+                written = end;
+              }
+            }
           } else {
             proto.SerializeToArray(output, tensor_bytes);
           }
         } else {
           buffer_size = RdmaMessage::kMessageTotalBytes;
         }
-        Write(imm_data, buffer_size);
+        WriteRange(written, buffer_size - written, true, imm_data);
       } else {
         mu_.unlock();
         // put back the key since it is not sent;
@@ -822,6 +961,79 @@ void RdmaTensorBuffer::SendNextItem() {
   }
 }
 
+// Send a tensor in GPU memory after the message already in the buffer.
+// With GPUDirect RDMA, the adapter reads the tensor from the GPU once the
+// stream that produced it is done. Otherwise the tensor is copied into the
+// pinned buffer in chunks, and each chunk is written to the remote buffer
+// as soon as it is there, so that copies and writes overlap.
+void RdmaTensorBuffer::SendGPUTensor(uint32_t imm_data, const Tensor& in,
+                                     Device* src_dev,
+                                     const DeviceContext* device_context) {
+  const DeviceBase::GpuDeviceInfo* dev_info =
+      src_dev->tensorflow_gpu_device_info();
+  gpu::Stream* send_stream = device_context->stream();
+  const size_t header_bytes = RdmaMessage::kTensorBufferStartIndex;
+  const size_t tensor_bytes = in.TotalBytes();
+  const void* src = DMAHelper::base(&in);
+  {
+    mutex_lock lock{mu_};
+    payload_ = in;
+  }
+
+  ibv_mr* mr = channel_->adapter_->FindGPUMemoryRegion(src, tensor_bytes);
+  if (mr != nullptr) {
+    const uint32_t lkey = mr->lkey;
+    dev_info->event_mgr->ThenExecute(
+        send_stream, [this, imm_data, header_bytes, src, tensor_bytes, lkey]() {
+          WriteWithPayload(imm_data, header_bytes, src, tensor_bytes, lkey);
+        });
+    return;
+  }
+
+  gpu::Stream* copy_stream =
+      static_cast<const GPUDeviceContext*>(device_context)
+          ->device_to_host_stream();
+  CHECK(copy_stream) << "No send gpu copy-out-stream is available.";
+  // Wait for the sender's main stream to make sure the data are available.
+  copy_stream->ThenWaitFor(send_stream);
+  const size_t chunk_bytes = CopyChunkBytes(tensor_bytes);
+  char* dst = static_cast<char*>(buffer_) + header_bytes;
+  // The copies complete in order, but the EventMgr may run their callbacks
+  // in any order, so each callback writes everything that has landed and
+  // hasn't been written yet. The first write also carries the message.
+  struct WriteState {
+    mutex mu;
+    size_t written GUARDED_BY(mu) = 0;
+  };
+  auto state = std::make_shared<WriteState>();
+  for (size_t copied = 0; copied < tensor_bytes;) {
+    const size_t n = std::min(chunk_bytes, tensor_bytes - copied);
+    perftools::gputools::DeviceMemoryBase chunk(
+        const_cast<char*>(static_cast<const char*>(src)) + copied, n);
+    copy_stream->ThenMemcpy(dst + copied, chunk, n);
+    copied += n;
+    const size_t end = header_bytes + copied;
+    const bool last = copied == tensor_bytes;
+    dev_info->event_mgr->ThenExecute(
+        copy_stream, [this, copy_stream, state, end, last, imm_data]() {
+          CHECK(copy_stream->ok()) << "GPU->CPU Memcpy failed";
+          mutex_lock l(state->mu);
+          if (end > state->written) {
+            WriteRange(state->written, end - state->written, last, imm_data);
+            state->written = end;
+          }
+        });
+  }
+}
+
+void RdmaTensorBuffer::ReleasePayload() {
+  Tensor payload;
+  {
+    mutex_lock lock{mu_};
+    std::swap(payload, payload_);
+  }
+}
+
 // Create a RdmaMessage according to the pre-defined format
 // Args:
 //   rm: the message structure
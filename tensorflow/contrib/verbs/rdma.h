@@ -27,7 +27,9 @@ limitations under the License.
 #include <unordered_map>
 #include <vector>
 
+#include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/distributed_runtime/worker_env.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/platform/env.h"
@@ -78,6 +80,13 @@ class RdmaAdapter {
   // Adapter name, e.g. mlx5_0.
   string name() const;
   void Process_CQ();
+  // Registers a region of GPU memory with the adapter, so that tensors in it
+  // can be sent with GPUDirect RDMA. Does nothing if the driver can't
+  // register GPU memory.
+  void RegisterGPUMemoryRegion(void* ptr, size_t size);
+  // Returns the registered GPU memory region that holds [ptr, ptr + size),
+  // or nullptr.
+  ibv_mr* FindGPUMemoryRegion(const void* ptr, size_t size) const;
 
  protected:
   static const int MAX_CONCURRENT_WRITES = 1000;
@@ -94,6 +103,10 @@ class RdmaAdapter {
   const WorkerEnv* worker_env_;
   // thread for cq.
   std::unique_ptr<Thread> polling_thread_;
+  // GPU memory regions registered for GPUDirect RDMA, sorted by address.
+  mutable mutex mr_mu_;
+  std::vector<ibv_mr*> gpu_mrs_ GUARDED_BY(mr_mu_);
+  bool gpu_mr_failed_ GUARDED_BY(mr_mu_) = false;
 };
 
 // Class that represents a connection to a remote Rdma peer.
@@ -182,17 +195,37 @@ class RdmaBuffer {
   void FreeBuffer();
   void EnqueueItem(string Item);
   virtual void SendNextItem(){};
-  void CreateCPUBuffer(size_t size, bool lock = true);
+  // Releases what a write kept alive once it has completed.
+  virtual void ReleasePayload() {}
+  // Allocates the buffer. If 'pinned' is true, the memory comes from the
+  // CUDA host allocator, so that GPUs can copy into it asynchronously.
+  void CreateCPUBuffer(size_t size, bool lock = true, bool pinned = false);
   void SetRemoteMR(RemoteMR rmi, bool override);
   uint32_t LookupBufferIndex(const string& buffer_name) {
     return const_cast<RdmaChannel*>(channel_)->LookupBufferIndex(buffer_name);
   }
   void Write(uint32_t imm_data, size_t buffer_size);
+  // Rdma-Writes bytes [offset, offset + length) of the buffer to the same
+  // place in the remote buffer. Only the last write of a message carries
+  // imm_data and is signaled; the writes of a queue pair arrive in order,
+  // so the remote sees the whole message with it.
+  void WriteRange(size_t offset, size_t length, bool last, uint32_t imm_data);
+  // Rdma-Writes the first 'buffer_size' bytes of the buffer followed by
+  // 'payload_size' bytes at 'payload', which belong to the memory region
+  // with key 'payload_lkey'.
+  void WriteWithPayload(uint32_t imm_data, size_t buffer_size,
+                        const void* payload, size_t payload_size,
+                        uint32_t payload_lkey);
 
  protected:
+  void PostWrite(ibv_sge* sg_list, int num_sge, size_t remote_offset,
+                 bool signaled, uint32_t imm_data);
+
   const RdmaChannel* channel_;
   void* buffer_ = nullptr;
   bool buffer_on_host_ = true;
+  // The allocator of a pinned buffer, or nullptr if it was malloc'ed.
+  Allocator* buffer_allocator_ = nullptr;
   size_t size_ = 0;
   const string name_;
   ibv_mr* self_ = nullptr;
@@ -225,6 +258,16 @@ class RdmaTensorBuffer : public RdmaBuffer {
   explicit RdmaTensorBuffer(RdmaChannel* channel, string name);
   virtual ~RdmaTensorBuffer() override {}
   void SendNextItem() override;
+  void ReleasePayload() override;
+
+ private:
+  // Sends 'in', which is in the memory of GPU 'src_dev', after the message
+  // already in the buffer.
+  void SendGPUTensor(uint32_t imm_data, const Tensor& in, Device* src_dev,
+                     const DeviceContext* device_context);
+
+  // A GPU tensor that is being sent; kept alive until the write completes.
+  Tensor payload_ GUARDED_BY(mu_);
 };
 
 struct RdmaMessage {
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/bfc_allocator.h"
 
+#include <thread>
+
 #include "tensorflow/core/common_runtime/allocator_retry.h"
 #include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
@@ -27,12 +29,21 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// The stream the allocations of the calling thread are for, or -1.
+thread_local int current_stream_id = -1;
+
+}  // namespace
+
 BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
-                           bool allow_growth, const string& name)
+                           bool allow_growth, const string& name,
+                           size_t thread_cache_bytes)
     : suballocator_(sub_allocator),
       name_(name),
       free_chunks_list_(kInvalidChunkHandle),
-      next_allocation_id_(1) {
+      next_allocation_id_(1),
+      thread_cache_bytes_(thread_cache_bytes) {
   if (allow_growth) {
     // 1MiB smallest initial allocation, unless total memory available
     // is less.
@@ -63,6 +74,14 @@ BFCAllocator::BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
       CHECK_NE(BinForSize(bin_size * 2), BinFromIndex(b));
     }
   }
+
+  if (thread_caches_enabled()) {
+    VLOG(1) << "Enabling thread caches of "
+            << strings::HumanReadableNumBytes(thread_cache_bytes_);
+    thread_caches_.reset(new ThreadCache[kNumThreadCaches]);
+    live_chunks_.reset(new LiveChunkShard[kNumLiveChunkShards]);
+  }
+  stream_free_lists_.resize(kMaxStreams);
 }
 
 BFCAllocator::~BFCAllocator() {
@@ -249,10 +268,78 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   // so all memory addresses are nicely byte aligned.
   size_t rounded_bytes = RoundedBytes(num_bytes);
 
+  const bool cacheable =
+      thread_caches_enabled() && rounded_bytes <= kMaxCachedChunkSize;
+  if (cacheable) {
+    void* ptr = AllocateFromThreadCache(rounded_bytes, num_bytes);
+    if (ptr != nullptr) {
+      return ptr;
+    }
+  }
+
+  const bool stream_ordered = stream_ordered_reuse_enabled();
+  const int stream_id = stream_ordered ? CurrentStreamId() : -1;
+  size_t chunk_size = 0;
+  int64 allocation_id = -1;
+  void* ptr = nullptr;
+  {
+    mutex_lock l(lock_);
+    if (stream_id >= 0) {
+      ptr = AllocateFromStreamLocked(stream_id, rounded_bytes, num_bytes);
+      if (ptr != nullptr) {
+        return ptr;
+      }
+    }
+    if (stream_ordered) {
+      ReleaseStreamFreedChunks(false);
+    }
+    ptr = AllocateRawLocked(rounded_bytes, num_bytes);
+    if (ptr == nullptr && thread_caches_enabled() && FlushThreadCaches()) {
+      // Chunks held by the thread caches may coalesce into one that fits.
+      ptr = AllocateRawLocked(rounded_bytes, num_bytes);
+    }
+    if (ptr == nullptr && stream_ordered && ReleaseStreamFreedChunks(true)) {
+      ptr = AllocateRawLocked(rounded_bytes, num_bytes);
+    }
+    if (ptr == nullptr) {
+      // We searched all bins for an existing free chunk to use and
+      // couldn't find one.  This means we must have run out of memory,
+      // Dump the memory log for analysis.
+      if (dump_log_on_failure) {
+        LOG(WARNING) << "Allocator (" << Name() << ") ran out of memory trying "
+                     << "to allocate "
+                     << strings::HumanReadableNumBytes(num_bytes)
+                     << ".  Current allocation summary follows.";
+        DumpMemoryLog(rounded_bytes);
+        LOG(WARNING) << RenderOccupancy();
+      }
+      return nullptr;
+    }
+    if (stream_id >= 0) {
+      ChunkFromHandle(region_manager_.get_handle(ptr))->stream_mask =
+          uint64{1} << stream_id;
+    }
+    if (cacheable) {
+      const Chunk* c = ChunkFromHandle(region_manager_.get_handle(ptr));
+      chunk_size = c->size;
+      allocation_id = c->allocation_id;
+    }
+  }
+
+  if (cacheable) {
+    ++num_cache_misses_;
+    // A chunk that was not split may be larger than the largest size class.
+    if (chunk_size <= kMaxCachedChunkSize) {
+      AddLiveChunk(ptr, chunk_size, num_bytes, allocation_id);
+    }
+  }
+  return ptr;
+}
+
+void* BFCAllocator::AllocateRawLocked(size_t rounded_bytes, size_t num_bytes) {
   // The BFC allocator tries to find the best fit first.
   BinNum bin_num = BinNumForSize(rounded_bytes);
 
-  mutex_lock l(lock_);
   void* ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
   if (ptr != nullptr) {
     return ptr;
@@ -261,22 +348,8 @@ void* BFCAllocator::AllocateRawInternal(size_t unused_alignment,
   // Try to extend
   if (Extend(rounded_bytes)) {
     ptr = FindChunkPtr(bin_num, rounded_bytes, num_bytes);
-    if (ptr != nullptr) {
-      return ptr;
-    }
-  }
-
-  // We searched all bins for an existing free chunk to use and
-  // couldn't find one.  This means we must have run out of memory,
-  // Dump the memory log for analysis.
-  if (dump_log_on_failure) {
-    LOG(WARNING) << "Allocator (" << Name() << ") ran out of memory trying "
-                 << "to allocate " << strings::HumanReadableNumBytes(num_bytes)
-                 << ".  Current allocation summary follows.";
-    DumpMemoryLog(rounded_bytes);
-    LOG(WARNING) << RenderOccupancy();
   }
-  return nullptr;
+  return ptr;
 }
 
 void* BFCAllocator::FindChunkPtr(BinNum bin_num, size_t rounded_bytes,
@@ -378,10 +451,24 @@ void BFCAllocator::DeallocateRawInternal(void* ptr) {
     LOG(ERROR) << "tried to deallocate nullptr";
     return;
   }
+  if (thread_caches_enabled() && DeallocateToThreadCache(ptr)) {
+    return;
+  }
+  BFCAllocator::ChunkHandle h;
+  if (stream_ordered_reuse_enabled()) {
+    {
+      mutex_lock l(lock_);
+      h = region_manager_.get_handle(ptr);
+      CHECK(h != kInvalidChunkHandle);
+    }
+    if (DeallocateStreamOrdered(h)) {
+      return;
+    }
+  }
   mutex_lock l(lock_);
 
   // Find the chunk from the ptr.
-  BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
+  h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle);
 
   // Consider coalescing it.
@@ -464,6 +551,7 @@ void BFCAllocator::FreeAndMaybeCoalesce(BFCAllocator::ChunkHandle h) {
 
   // Mark the chunk as no longer in use
   c->allocation_id = -1;
+  c->stream_mask = 0;
 
   // Updates the stats.
   stats_.bytes_in_use -= c->size;
@@ -507,6 +595,268 @@ void BFCAllocator::FreeAndMaybeCoalesce(BFCAllocator::ChunkHandle h) {
   InsertFreeChunkIntoBin(chunk_to_reassign);
 }
 
+BFCAllocator::ThreadCache* BFCAllocator::ThreadCacheForCurrentThread() {
+  // Thread ids are often aligned addresses, so mix all their bits into the
+  // cache index.
+  const uint64 h = std::hash<std::thread::id>()(std::this_thread::get_id());
+  return &thread_caches_[((h * 0x9E3779B97F4A7C15ULL) >> 32) % kNumThreadCaches];
+}
+
+BFCAllocator::LiveChunkShard* BFCAllocator::LiveChunkShardFor(
+    const void* ptr) {
+  const uint64 p = reinterpret_cast<std::uintptr_t>(ptr) >> kMinAllocationBits;
+  return &live_chunks_[p % kNumLiveChunkShards];
+}
+
+void* BFCAllocator::AllocateFromThreadCache(size_t rounded_bytes,
+                                            size_t num_bytes) {
+  ThreadCache* cache = ThreadCacheForCurrentThread();
+  void* ptr;
+  {
+    mutex_lock l(cache->mu);
+    std::vector<void*>& free_chunks =
+        cache->free_chunks[CacheSizeClass(rounded_bytes)];
+    if (free_chunks.empty()) {
+      return nullptr;
+    }
+    ptr = free_chunks.back();
+    free_chunks.pop_back();
+    cache->bytes -= rounded_bytes;
+  }
+  bytes_in_cache_ -= rounded_bytes;
+  ++num_cache_hits_;
+  AddLiveChunk(ptr, rounded_bytes, num_bytes, next_allocation_id_++);
+  return ptr;
+}
+
+void BFCAllocator::AddLiveChunk(void* ptr, size_t chunk_size, size_t num_bytes,
+                                int64 allocation_id) {
+  LiveChunkShard* shard = LiveChunkShardFor(ptr);
+  mutex_lock l(shard->mu);
+  LiveChunk& chunk = shard->chunks[ptr];
+  chunk.size = chunk_size;
+  chunk.requested_size = num_bytes;
+  chunk.allocation_id = allocation_id;
+}
+
+bool BFCAllocator::DeallocateToThreadCache(void* ptr) {
+  size_t chunk_size;
+  {
+    LiveChunkShard* shard = LiveChunkShardFor(ptr);
+    mutex_lock l(shard->mu);
+    auto it = shard->chunks.find(ptr);
+    if (it == shard->chunks.end()) {
+      return false;
+    }
+    chunk_size = it->second.size;
+    shard->chunks.erase(it);
+  }
+
+  ThreadCache* cache = ThreadCacheForCurrentThread();
+  {
+    mutex_lock l(cache->mu);
+    if (cache->bytes + chunk_size <= thread_cache_bytes_) {
+      cache->free_chunks[CacheSizeClass(chunk_size)].push_back(ptr);
+      cache->bytes += chunk_size;
+      bytes_in_cache_ += chunk_size;
+      return true;
+    }
+  }
+
+  // The cache is full: return the chunk to the bins.
+  mutex_lock l(lock_);
+  FreeAndMaybeCoalesce(region_manager_.get_handle(ptr));
+  return true;
+}
+
+bool BFCAllocator::FlushThreadCaches() {
+  bool flushed = false;
+  for (int i = 0; i < kNumThreadCaches; ++i) {
+    ThreadCache* cache = &thread_caches_[i];
+    mutex_lock l(cache->mu);
+    for (std::vector<void*>& free_chunks : cache->free_chunks) {
+      for (void* ptr : free_chunks) {
+        FreeAndMaybeCoalesce(region_manager_.get_handle(ptr));
+        flushed = true;
+      }
+      free_chunks.clear();
+    }
+    bytes_in_cache_ -= cache->bytes;
+    cache->bytes = 0;
+  }
+  if (flushed) {
+    VLOG(1) << "Flushed thread caches of allocator " << Name();
+  }
+  return flushed;
+}
+
+bool BFCAllocator::LookupLiveChunk(const void* ptr, LiveChunk* chunk) {
+  if (!thread_caches_enabled()) {
+    return false;
+  }
+  LiveChunkShard* shard = LiveChunkShardFor(ptr);
+  mutex_lock l(shard->mu);
+  auto it = shard->chunks.find(ptr);
+  if (it == shard->chunks.end()) {
+    return false;
+  }
+  *chunk = it->second;
+  return true;
+}
+
+BFCAllocator::ScopedStream::ScopedStream(int stream_id)
+    : previous_stream_id_(current_stream_id) {
+  current_stream_id = stream_id;
+}
+
+BFCAllocator::ScopedStream::~ScopedStream() {
+  current_stream_id = previous_stream_id_;
+}
+
+// static
+int BFCAllocator::CurrentStreamId() {
+  return current_stream_id < kMaxStreams ? current_stream_id : -1;
+}
+
+bool BFCAllocator::EnableStreamOrderedReuse(StreamFenceFactory fence_factory) {
+  if (thread_caches_enabled()) {
+    return false;
+  }
+  mutex_lock l(lock_);
+  fence_factory_ = std::move(fence_factory);
+  stream_ordered_reuse_enabled_.store(true, std::memory_order_release);
+  return true;
+}
+
+bool BFCAllocator::RecordStreamUse(const void* ptr, int stream_id) {
+  if (!stream_ordered_reuse_enabled() || stream_id < 0 ||
+      stream_id >= kMaxStreams) {
+    return false;
+  }
+  mutex_lock l(lock_);
+  bool in_region = false;
+  for (const auto& region : region_manager_.regions()) {
+    if (ptr >= region.ptr() && ptr < region.end_ptr()) {
+      in_region = true;
+      break;
+    }
+  }
+  if (!in_region) {
+    return false;
+  }
+  ChunkHandle h = region_manager_.get_handle(ptr);
+  if (h == kInvalidChunkHandle) {
+    return false;
+  }
+  Chunk* c = ChunkFromHandle(h);
+  if (!c->in_use() || c->ptr != ptr || stream_freed_index_.count(h) != 0) {
+    return false;
+  }
+  c->stream_mask |= uint64{1} << stream_id;
+  return true;
+}
+
+void* BFCAllocator::AllocateFromStreamLocked(int stream_id,
+                                             size_t rounded_bytes,
+                                             size_t num_bytes) {
+  std::multimap<size_t, ChunkHandle>& free_list =
+      stream_free_lists_[stream_id];
+  auto candidate = free_list.lower_bound(rounded_bytes);
+  if (candidate == free_list.end() || candidate->first >= 2 * rounded_bytes) {
+    return nullptr;
+  }
+  const ChunkHandle h = candidate->second;
+  RemoveStreamFreedChunk(stream_freed_index_.at(h));
+
+  Chunk* c = ChunkFromHandle(h);
+  c->requested_size = num_bytes;
+  c->allocation_id = next_allocation_id_++;
+  c->stream_mask = uint64{1} << stream_id;
+  ++stats_.num_allocs;
+  return c->ptr;
+}
+
+bool BFCAllocator::DeallocateStreamOrdered(ChunkHandle h) {
+  uint64 stream_mask;
+  StreamFenceFactory fence_factory;
+  {
+    mutex_lock l(lock_);
+    stream_mask = ChunkFromHandle(h)->stream_mask;
+    if (stream_mask == 0) {
+      return false;
+    }
+    fence_factory = fence_factory_;
+  }
+
+  // Fences may take a while to create, e.g. if they record events on
+  // device streams, so create them without holding the lock.
+  StreamFreedChunk freed;
+  freed.h = h;
+  freed.stream_id = -1;
+  for (int i = 0; i < kMaxStreams; ++i) {
+    if ((stream_mask >> i) & 1) {
+      freed.fences.push_back(fence_factory(i));
+      freed.stream_id = freed.fences.size() == 1 ? i : -1;
+    }
+  }
+
+  mutex_lock l(lock_);
+  Chunk* c = ChunkFromHandle(h);
+  stream_freed_chunks_.push_back(std::move(freed));
+  stream_freed_index_[h] = std::prev(stream_freed_chunks_.end());
+  const int stream_id = stream_freed_chunks_.back().stream_id;
+  if (stream_id >= 0) {
+    stream_free_lists_[stream_id].emplace(c->size, h);
+  }
+  return true;
+}
+
+bool BFCAllocator::ReleaseStreamFreedChunks(bool check_all) {
+  bool released = false;
+  auto it = stream_freed_chunks_.begin();
+  while (it != stream_freed_chunks_.end()) {
+    bool passed = true;
+    for (const StreamFence& fence : it->fences) {
+      if (!fence()) {
+        passed = false;
+        break;
+      }
+    }
+    if (!passed) {
+      if (!check_all) {
+        break;
+      }
+      ++it;
+      continue;
+    }
+    const ChunkHandle h = it->h;
+    auto next = std::next(it);
+    RemoveStreamFreedChunk(it);
+    it = next;
+    FreeAndMaybeCoalesce(h);
+    released = true;
+  }
+  return released;
+}
+
+void BFCAllocator::RemoveStreamFreedChunk(
+    std::list<StreamFreedChunk>::iterator it) {
+  const ChunkHandle h = it->h;
+  if (it->stream_id >= 0) {
+    std::multimap<size_t, ChunkHandle>& free_list =
+        stream_free_lists_[it->stream_id];
+    auto range = free_list.equal_range(ChunkFromHandle(h)->size);
+    for (auto entry = range.first; entry != range.second; ++entry) {
+      if (entry->second == h) {
+        free_list.erase(entry);
+        break;
+      }
+    }
+  }
+  stream_freed_index_.erase(h);
+  stream_freed_chunks_.erase(it);
+}
+
 void BFCAllocator::AddAllocVisitor(Visitor visitor) {
   VLOG(1) << "AddVisitor";
   mutex_lock l(lock_);
@@ -519,6 +869,10 @@ void BFCAllocator::AddAllocVisitor(Visitor visitor) {
 bool BFCAllocator::TracksAllocationSizes() { return true; }
 
 size_t BFCAllocator::RequestedSize(void* ptr) {
+  LiveChunk live_chunk;
+  if (LookupLiveChunk(ptr, &live_chunk)) {
+    return live_chunk.requested_size;
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -528,6 +882,10 @@ size_t BFCAllocator::RequestedSize(void* ptr) {
 }
 
 size_t BFCAllocator::AllocatedSize(void* ptr) {
+  LiveChunk live_chunk;
+  if (LookupLiveChunk(ptr, &live_chunk)) {
+    return live_chunk.size;
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -537,6 +895,10 @@ size_t BFCAllocator::AllocatedSize(void* ptr) {
 }
 
 int64 BFCAllocator::AllocationId(void* ptr) {
+  LiveChunk live_chunk;
+  if (LookupLiveChunk(ptr, &live_chunk)) {
+    return live_chunk.allocation_id;
+  }
   mutex_lock l(lock_);
   BFCAllocator::ChunkHandle h = region_manager_.get_handle(ptr);
   CHECK(h != kInvalidChunkHandle)
@@ -702,9 +1064,26 @@ void BFCAllocator::DumpMemoryLog(size_t num_bytes) {
   LOG(INFO) << "Stats: \n" << stats_.DebugString();
 }
 
+bool BFCAllocator::Reserve(size_t num_bytes) {
+  if (num_bytes == 0) return true;
+  mutex_lock l(lock_);
+  return Extend(RoundedBytes(num_bytes));
+}
+
 void BFCAllocator::GetStats(AllocatorStats* stats) {
   mutex_lock l(lock_);
   *stats = stats_;
+  stats->bytes_reserved = total_region_allocated_bytes_;
+  // Chunks held by the thread caches are in use as far as the bins are
+  // concerned, but are free for the client.
+  const int64 bytes_in_cache = bytes_in_cache_.load();
+  const int64 num_cache_hits = num_cache_hits_.load();
+  stats->bytes_in_use -= bytes_in_cache;
+  stats->num_allocs += num_cache_hits;
+  stats->num_cache_hits = num_cache_hits;
+  stats->num_cache_misses = num_cache_misses_.load();
+  stats->bytes_in_cache = bytes_in_cache;
+  stats->bytes_in_scratch = bytes_in_scratch_.load();
 }
 
 }  // namespace tensorflow
@@ -16,6 +16,10 @@ limitations under the License.
 #ifndef TENSORFLOW_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 #define TENSORFLOW_COMMON_RUNTIME_BFC_ALLOCATOR_H_
 
+#include <atomic>
+#include <functional>
+#include <list>
+#include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -41,11 +45,21 @@ namespace tensorflow {
 // coalescing.  One assumption we make is that the process using this
 // allocator owns pretty much all of the memory, and that nearly
 // all requests to allocate memory go through this interface.
+//
+// If 'thread_cache_bytes' is positive, small chunks freed by a thread are
+// kept (up to that many bytes) in a cache in front of the bins, and
+// allocations of the same size are served from it without taking the
+// allocator lock.  Cached chunks are not coalesced; all caches are flushed
+// back into the bins before an allocation is allowed to fail.
+//
+// See EnableStreamOrderedReuse() for the reuse of memory freed while
+// device streams may still access it.
 class BFCAllocator : public VisitableAllocator {
  public:
   // Takes ownership of sub_allocator.
   BFCAllocator(SubAllocator* sub_allocator, size_t total_memory,
-               bool allow_growth, const string& name);
+               bool allow_growth, const string& name,
+               size_t thread_cache_bytes = 0);
   ~BFCAllocator() override;
 
   string Name() override { return name_; }
@@ -69,11 +83,64 @@ class BFCAllocator : public VisitableAllocator {
 
   void GetStats(AllocatorStats* stats) override;
 
+  void RecordScratchBytes(int64 num_bytes) override {
+    bytes_in_scratch_ += num_bytes;
+  }
+
+  // Obtains a region of at least 'num_bytes' from the sub-allocator right
+  // away, so that the allocations it can hold don't grow the allocator one
+  // region at a time. This matters when growing is expensive, e.g. for
+  // pinned host memory, which the driver has to register. Returns false if
+  // the memory limit or the sub-allocator doesn't allow it.
+  bool Reserve(size_t num_bytes);
+
+  // Stream-ordered reuse.
+  //
+  // Once enabled, every chunk remembers the device streams it was allocated
+  // for (see ScopedStream) or recorded as used by (see RecordStreamUse).
+  // When such a chunk is freed, a fence is created on each of its streams,
+  // and the chunk only returns to the bins once all of them have passed.
+  // Until then, a chunk that a single stream used serves the allocations
+  // made for that stream right away: work enqueued later on the stream runs
+  // after the last use of the memory. Chunks that no stream used are freed
+  // immediately, as before.
+  //
+  // A fence returns true once all the work that was enqueued on its stream
+  // before it was created is done.
+  typedef std::function<bool()> StreamFence;
+  typedef std::function<StreamFence(int stream_id)> StreamFenceFactory;
+  static const int kMaxStreams = 64;
+
+  // Enables stream-ordered reuse, or replaces the fence factory if it is
+  // already enabled. Returns false, and does nothing, if the thread caches
+  // are enabled, since they hand out chunks without looking at streams.
+  bool EnableStreamOrderedReuse(StreamFenceFactory fence_factory);
+
+  // Records that work enqueued on stream 'stream_id' accesses the chunk
+  // starting at 'ptr'. Returns false if stream-ordered reuse is disabled or
+  // if 'ptr' isn't a chunk in use of this allocator; the caller must then
+  // keep the memory alive until the stream is done with it.
+  bool RecordStreamUse(const void* ptr, int stream_id);
+
+  // While in scope, the allocations made by the calling thread are for work
+  // enqueued on stream 'stream_id'.
+  class ScopedStream {
+   public:
+    explicit ScopedStream(int stream_id);
+    ~ScopedStream();
+
+   private:
+    const int previous_stream_id_;
+    TF_DISALLOW_COPY_AND_ASSIGN(ScopedStream);
+  };
+
  private:
   struct Bin;
 
   void* AllocateRawInternal(size_t alignment, size_t num_bytes,
                             bool dump_log_on_failure);
+  void* AllocateRawLocked(size_t rounded_bytes, size_t num_bytes)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
   void DeallocateRawInternal(void* ptr);
 
   // A ChunkHandle is an index into the chunks_ vector in BFCAllocator
@@ -119,6 +186,10 @@ class BFCAllocator : public VisitableAllocator {
     // What bin are we in?
     BinNum bin_num = kInvalidBinNum;
 
+    // Bit i is set if stream i used the chunk. Only maintained with
+    // stream-ordered reuse.
+    uint64 stream_mask = 0;
+
     bool in_use() const { return allocation_id != -1; }
 
     string DebugString(BFCAllocator* a,
@@ -344,6 +415,99 @@ class BFCAllocator : public VisitableAllocator {
 
   Chunk* ChunkFromHandle(ChunkHandle h) EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Thread caches.
+  //
+  // Chunks of at most kMaxCachedChunkSize bytes handed out while the caches
+  // are enabled are registered in live_chunks_, so that DeallocateRaw() can
+  // find their size without taking lock_.  A freed chunk stays in use as
+  // far as the bins are concerned and is pushed onto the free list of its
+  // size in the cache of the freeing thread.  Threads are mapped onto
+  // kNumThreadCaches caches by hashing their id.
+  static const size_t kMaxCachedChunkSize = 64 << 10;
+  static const int kNumCacheSizeClasses =
+      kMaxCachedChunkSize / kMinAllocationSize;
+  static const int kNumThreadCaches = 16;
+  static const int kNumLiveChunkShards = 16;
+
+  struct LiveChunk {
+    size_t size = 0;
+    size_t requested_size = 0;
+    int64 allocation_id = -1;
+  };
+
+  struct LiveChunkShard {
+    mutex mu;
+    std::unordered_map<const void*, LiveChunk> chunks GUARDED_BY(mu);
+  };
+
+  struct ThreadCache {
+    mutex mu;
+    // Indexed by CacheSizeClass().
+    std::vector<void*> free_chunks[kNumCacheSizeClasses] GUARDED_BY(mu);
+    size_t bytes GUARDED_BY(mu) = 0;
+  };
+
+  bool thread_caches_enabled() const { return thread_cache_bytes_ > 0; }
+  static int CacheSizeClass(size_t rounded_bytes) {
+    return rounded_bytes / kMinAllocationSize - 1;
+  }
+  ThreadCache* ThreadCacheForCurrentThread();
+  LiveChunkShard* LiveChunkShardFor(const void* ptr);
+
+  // Returns a chunk of exactly 'rounded_bytes' from the cache of the
+  // calling thread, or nullptr.
+  void* AllocateFromThreadCache(size_t rounded_bytes, size_t num_bytes);
+
+  // Records that 'ptr' was handed out for a request of 'num_bytes'.
+  void AddLiveChunk(void* ptr, size_t chunk_size, size_t num_bytes,
+                    int64 allocation_id);
+
+  // Returns true iff 'ptr' was a registered chunk, which is now owned by a
+  // thread cache or has been returned to the bins.
+  bool DeallocateToThreadCache(void* ptr);
+
+  // Returns the chunks held by all thread caches to the bins.  Returns
+  // true iff any chunk was returned.
+  bool FlushThreadCaches() EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns true and fills in '*chunk' iff 'ptr' is a registered chunk.
+  bool LookupLiveChunk(const void* ptr, LiveChunk* chunk);
+
+  // Stream-ordered reuse.
+  //
+  // A chunk freed while streams may still use it. It stays in use as far as
+  // the bins are concerned.
+  struct StreamFreedChunk {
+    ChunkHandle h;
+    // The only stream that used the chunk, or -1 if several streams did.
+    int stream_id;
+    std::vector<StreamFence> fences;
+  };
+
+  bool stream_ordered_reuse_enabled() const {
+    return stream_ordered_reuse_enabled_.load(std::memory_order_acquire);
+  }
+  static int CurrentStreamId();
+
+  // Returns a chunk that only 'stream_id' used, of at least 'rounded_bytes'
+  // and less than twice that, or nullptr.
+  void* AllocateFromStreamLocked(int stream_id, size_t rounded_bytes,
+                                 size_t num_bytes)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Returns true iff 'h' was used by some stream, in which case it is now
+  // owned by stream_freed_chunks_.
+  bool DeallocateStreamOrdered(ChunkHandle h);
+
+  // Returns the stream freed chunks whose fences have passed to the bins.
+  // The chunks are checked in the order they were freed, and the check
+  // stops at the first chunk that is still in use, unless 'check_all'.
+  // Returns true iff any chunk was returned.
+  bool ReleaseStreamFreedChunks(bool check_all) EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  void RemoveStreamFreedChunk(std::list<StreamFreedChunk>::iterator it)
+      EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
   AllocatorRetry retry_helper_;
 
   // Structures immutable after construction
@@ -405,12 +569,36 @@ class BFCAllocator : public VisitableAllocator {
   std::vector<Visitor> region_visitors_;
 
   // Counter containing the next unique identifier to assign to a
-  // newly-created chunk.
-  int64 next_allocation_id_ GUARDED_BY(lock_);
+  // newly-created chunk.  Atomic because allocations served by the thread
+  // caches do not hold lock_.
+  std::atomic<int64> next_allocation_id_;
 
   // Stats.
   AllocatorStats stats_ GUARDED_BY(lock_);
 
+  // Thread cache state; see ThreadCache.
+  const size_t thread_cache_bytes_;
+  std::unique_ptr<ThreadCache[]> thread_caches_;
+  std::unique_ptr<LiveChunkShard[]> live_chunks_;
+  std::atomic<int64> num_cache_hits_{0};
+  std::atomic<int64> num_cache_misses_{0};
+  std::atomic<int64> bytes_in_cache_{0};
+
+  // See AllocatorStats::bytes_in_scratch.
+  std::atomic<int64> bytes_in_scratch_{0};
+
+  // Stream-ordered reuse state; see StreamFreedChunk.
+  std::atomic<bool> stream_ordered_reuse_enabled_{false};
+  StreamFenceFactory fence_factory_ GUARDED_BY(lock_);
+  // In the order the chunks were freed.
+  std::list<StreamFreedChunk> stream_freed_chunks_ GUARDED_BY(lock_);
+  std::unordered_map<ChunkHandle, std::list<StreamFreedChunk>::iterator>
+      stream_freed_index_ GUARDED_BY(lock_);
+  // The chunks of stream_freed_chunks_ that a single stream used, by stream
+  // and size.
+  std::vector<std::multimap<size_t, ChunkHandle>> stream_free_lists_
+      GUARDED_BY(lock_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(BFCAllocator);
 };
 
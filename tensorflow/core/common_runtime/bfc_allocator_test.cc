@@ -0,0 +1,305 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+class TestSubAllocator : public SubAllocator {
+ public:
+  void* Alloc(size_t alignment, size_t num_bytes) override {
+    return port::AlignedMalloc(num_bytes, alignment);
+  }
+  void Free(void* ptr, size_t num_bytes) override { port::AlignedFree(ptr); }
+};
+
+AllocatorStats GetStats(Allocator* a) {
+  AllocatorStats stats;
+  a->GetStats(&stats);
+  LOG(INFO) << "Alloc stats: \n" << stats.DebugString();
+  return stats;
+}
+
+TEST(BFCAllocatorTest, ThreadCacheReusesFreedChunks) {
+  BFCAllocator a(new TestSubAllocator, 1 << 20, true, "test", 1 << 16);
+  void* p = a.AllocateRaw(1, 1000);
+  const int64 first_id = a.AllocationId(p);
+  a.DeallocateRaw(p);
+
+  AllocatorStats stats = GetStats(&a);
+  EXPECT_EQ(0, stats.bytes_in_use);
+  EXPECT_EQ(1024, stats.bytes_in_cache);
+
+  // Same size class: served from the cache.
+  void* q = a.AllocateRaw(1, 900);
+  EXPECT_EQ(p, q);
+  EXPECT_EQ(900, a.RequestedSize(q));
+  EXPECT_EQ(1024, a.AllocatedSize(q));
+  EXPECT_NE(first_id, a.AllocationId(q));
+
+  stats = GetStats(&a);
+  EXPECT_EQ(2, stats.num_allocs);
+  EXPECT_EQ(1, stats.num_cache_hits);
+  EXPECT_EQ(1, stats.num_cache_misses);
+  EXPECT_EQ(1024, stats.bytes_in_use);
+  EXPECT_EQ(0, stats.bytes_in_cache);
+  a.DeallocateRaw(q);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheDisabledByDefault) {
+  BFCAllocator a(new TestSubAllocator, 1 << 20, true, "test");
+  a.DeallocateRaw(a.AllocateRaw(1, 1000));
+  AllocatorStats stats = GetStats(&a);
+  EXPECT_EQ(0, stats.num_cache_hits);
+  EXPECT_EQ(0, stats.num_cache_misses);
+  EXPECT_EQ(0, stats.bytes_in_cache);
+}
+
+TEST(BFCAllocatorTest, LargeAllocationsBypassThreadCache) {
+  BFCAllocator a(new TestSubAllocator, 1 << 24, true, "test", 1 << 20);
+  a.DeallocateRaw(a.AllocateRaw(1, 1 << 20));
+  AllocatorStats stats = GetStats(&a);
+  EXPECT_EQ(0, stats.num_cache_misses);
+  EXPECT_EQ(0, stats.bytes_in_cache);
+  EXPECT_EQ(0, stats.bytes_in_use);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheRespectsLimit) {
+  BFCAllocator a(new TestSubAllocator, 1 << 20, true, "test", 2048);
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 3; ++i) {
+    ptrs.push_back(a.AllocateRaw(1, 1024));
+  }
+  for (void* p : ptrs) {
+    a.DeallocateRaw(p);
+  }
+  AllocatorStats stats = GetStats(&a);
+  EXPECT_EQ(2048, stats.bytes_in_cache);
+  EXPECT_EQ(0, stats.bytes_in_use);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheFlushedWhenOutOfMemory) {
+  BFCAllocator a(new TestSubAllocator, 4096, false, "test", 4096);
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 4; ++i) {
+    ptrs.push_back(a.AllocateRaw(1, 1024));
+    ASSERT_NE(nullptr, ptrs.back());
+  }
+  for (void* p : ptrs) {
+    a.DeallocateRaw(p);
+  }
+  EXPECT_EQ(4096, GetStats(&a).bytes_in_cache);
+
+  // Only fits once the cached chunks are coalesced again.
+  void* p = a.AllocateRaw(1, 4096);
+  ASSERT_NE(nullptr, p);
+  AllocatorStats stats = GetStats(&a);
+  EXPECT_EQ(0, stats.bytes_in_cache);
+  EXPECT_EQ(4096, stats.bytes_in_use);
+  a.DeallocateRaw(p);
+}
+
+TEST(BFCAllocatorTest, ReserveAvoidsGrowing) {
+  BFCAllocator a(new TestSubAllocator, 1 << 24, true, "test");
+  EXPECT_EQ(0, GetStats(&a).bytes_reserved);
+  EXPECT_TRUE(a.Reserve(1 << 22));
+  EXPECT_EQ(1 << 22, GetStats(&a).bytes_reserved);
+
+  std::vector<void*> ptrs;
+  for (int i = 0; i < 3; ++i) {
+    ptrs.push_back(a.AllocateRaw(1, 1 << 20));
+    ASSERT_NE(nullptr, ptrs.back());
+  }
+  EXPECT_EQ(1 << 22, GetStats(&a).bytes_reserved);
+  for (void* p : ptrs) {
+    a.DeallocateRaw(p);
+  }
+
+  EXPECT_FALSE(a.Reserve(1 << 24));
+  EXPECT_EQ(1 << 22, GetStats(&a).bytes_reserved);
+}
+
+TEST(BFCAllocatorTest, ThreadCacheConcurrentAllocations) {
+  BFCAllocator a(new TestSubAllocator, 1 << 26, true, "test", 1 << 18);
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 8);
+    for (int t = 0; t < 8; ++t) {
+      pool.Schedule([&a, t]() {
+        random::PhiloxRandom philox(123, t);
+        random::SimplePhilox rand(&philox);
+        std::vector<void*> ptrs;
+        for (int i = 0; i < 10000; ++i) {
+          if (ptrs.empty() || rand.OneIn(2)) {
+            const size_t size = 1 + rand.Uniform(1 << 14);
+            void* p = a.AllocateRaw(1, size);
+            CHECK(p != nullptr);
+            CHECK_GE(a.AllocatedSize(p), size);
+            ptrs.push_back(p);
+          } else {
+            const int j = rand.Uniform(ptrs.size());
+            a.DeallocateRaw(ptrs[j]);
+            ptrs[j] = ptrs.back();
+            ptrs.pop_back();
+          }
+        }
+        for (void* p : ptrs) {
+          a.DeallocateRaw(p);
+        }
+      });
+    }
+  }
+  AllocatorStats stats = GetStats(&a);
+  EXPECT_EQ(0, stats.bytes_in_use);
+  EXPECT_GT(stats.num_cache_hits, 0);
+  EXPECT_EQ(stats.num_allocs, stats.num_cache_hits + stats.num_cache_misses);
+}
+
+// Fences that pass once the test says that their stream is done.
+class TestStreams {
+ public:
+  TestStreams() : done_(BFCAllocator::kMaxStreams, false) {}
+
+  BFCAllocator::StreamFenceFactory FenceFactory() {
+    return [this](int stream_id) -> BFCAllocator::StreamFence {
+      return [this, stream_id]() { return done_[stream_id]; };
+    };
+  }
+  void SetDone(int stream_id) { done_[stream_id] = true; }
+
+ private:
+  std::vector<bool> done_;
+};
+
+TEST(BFCAllocatorTest, StreamOrderedReuseOnSameStream) {
+  TestStreams streams;
+  BFCAllocator a(new TestSubAllocator, 1 << 20, true, "test");
+  ASSERT_TRUE(a.EnableStreamOrderedReuse(streams.FenceFactory()));
+
+  void* p;
+  {
+    BFCAllocator::ScopedStream stream(0);
+    p = a.AllocateRaw(1, 1000);
+    a.DeallocateRaw(p);
+    // Stream 0 may still be using p, but later work on it runs after.
+    void* q = a.AllocateRaw(1, 900);
+    EXPECT_EQ(p, q);
+    EXPECT_EQ(900, a.RequestedSize(q));
+    a.DeallocateRaw(q);
+  }
+  {
+    // Other streams have to wait for the fence.
+    BFCAllocator::ScopedStream stream(1);
+    void* q = a.AllocateRaw(1, 1000);
+    EXPECT_NE(p, q);
+    a.DeallocateRaw(q);
+  }
+  // Both chunks are still held for their streams.
+  EXPECT_EQ(2048, GetStats(&a).bytes_in_use);
+
+  streams.SetDone(0);
+  streams.SetDone(1);
+  a.DeallocateRaw(a.AllocateRaw(1, 1000));
+  EXPECT_EQ(0, GetStats(&a).bytes_in_use);
+}
+
+TEST(BFCAllocatorTest, StreamOrderedReuseAfterUseByOtherStream) {
+  TestStreams streams;
+  BFCAllocator a(new TestSubAllocator, 1 << 20, true, "test");
+  ASSERT_TRUE(a.EnableStreamOrderedReuse(streams.FenceFactory()));
+
+  void* p;
+  {
+    BFCAllocator::ScopedStream stream(0);
+    p = a.AllocateRaw(1, 1000);
+    EXPECT_TRUE(a.RecordStreamUse(p, 1));
+    a.DeallocateRaw(p);
+    // Stream 1 may still be reading p.
+    void* q = a.AllocateRaw(1, 1000);
+    EXPECT_NE(p, q);
+    a.DeallocateRaw(q);
+  }
+
+  streams.SetDone(0);
+  void* q = a.AllocateRaw(1, 1000);
+  EXPECT_NE(p, q);
+  a.DeallocateRaw(q);
+  streams.SetDone(1);
+  a.DeallocateRaw(a.AllocateRaw(1, 1000));
+  EXPECT_EQ(0, GetStats(&a).bytes_in_use);
+}
+
+TEST(BFCAllocatorTest, StreamOrderedReuseWithoutStreams) {
+  TestStreams streams;
+  BFCAllocator a(new TestSubAllocator, 1 << 20, true, "test");
+  ASSERT_TRUE(a.EnableStreamOrderedReuse(streams.FenceFactory()));
+
+  // Memory that no stream used is freed right away.
+  void* p = a.AllocateRaw(1, 1000);
+  a.DeallocateRaw(p);
+  EXPECT_EQ(0, GetStats(&a).bytes_in_use);
+
+  int local;
+  EXPECT_FALSE(a.RecordStreamUse(&local, 0));
+  p = a.AllocateRaw(1, 1000);
+  EXPECT_FALSE(a.RecordStreamUse(static_cast<char*>(p) + 256, 0));
+  a.DeallocateRaw(p);
+  EXPECT_EQ(0, GetStats(&a).bytes_in_use);
+}
+
+TEST(BFCAllocatorTest, StreamOrderedReuseChecksAllFencesWhenOutOfMemory) {
+  TestStreams streams;
+  BFCAllocator a(new TestSubAllocator, 4096, false, "test");
+  ASSERT_TRUE(a.EnableStreamOrderedReuse(streams.FenceFactory()));
+
+  void* p;
+  void* q;
+  {
+    BFCAllocator::ScopedStream stream(0);
+    p = a.AllocateRaw(1, 2048);
+  }
+  {
+    BFCAllocator::ScopedStream stream(1);
+    q = a.AllocateRaw(1, 2048);
+  }
+  a.DeallocateRaw(p);
+  a.DeallocateRaw(q);
+  // Only stream 1, whose chunk was freed last, is done.
+  streams.SetDone(1);
+
+  BFCAllocator::ScopedStream stream(2);
+  void* r = a.AllocateRaw(1, 2048);
+  EXPECT_EQ(q, r);
+  a.DeallocateRaw(r);
+}
+
+TEST(BFCAllocatorTest, StreamOrderedReuseExcludesThreadCaches) {
+  TestStreams streams;
+  BFCAllocator a(new TestSubAllocator, 1 << 20, true, "test", 1 << 16);
+  EXPECT_FALSE(a.EnableStreamOrderedReuse(streams.FenceFactory()));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,96 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/critical_path.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+
+namespace tensorflow {
+
+int64 EstimateNodeCostMicros(const Node* node, const DeviceProperties& device) {
+  if (!node->IsOp()) return 1;
+  OpInfo op_info;
+  op_info.set_op(node->type_string());
+  for (const auto& attr : node->attrs()) {
+    (*op_info.mutable_attr())[attr.first] = attr.second;
+  }
+  *op_info.mutable_device() = device;
+
+  const int num_inputs = node->num_inputs();
+  for (int i = 0; i < num_inputs; ++i) {
+    auto* input = op_info.add_inputs();
+    input->set_dtype(BaseType(node->input_type(i)));
+    input->mutable_shape()->set_unknown_rank(true);
+  }
+  for (const Edge* e : node->in_edges()) {
+    if (e->IsControlEdge()) continue;
+    const AttrValue* shapes = e->src()->attrs().Find("_output_shapes");
+    if (shapes != nullptr && e->src_output() < shapes->list().shape_size()) {
+      *op_info.mutable_inputs(e->dst_input())->mutable_shape() =
+          shapes->list().shape(e->src_output());
+    }
+  }
+  const AttrValue* shapes = node->attrs().Find("_output_shapes");
+  if (shapes != nullptr) {
+    for (int i = 0; i < node->num_outputs(); ++i) {
+      auto* output = op_info.add_outputs();
+      output->set_dtype(BaseType(node->output_type(i)));
+      if (i < shapes->list().shape_size()) {
+        *output->mutable_shape() = shapes->list().shape(i);
+      } else {
+        output->mutable_shape()->set_unknown_rank(true);
+      }
+    }
+  }
+
+  static const grappler::OpLevelCostEstimator* estimator =
+      new grappler::OpLevelCostEstimator;
+  const grappler::Costs costs = estimator->PredictCosts(op_info);
+  const int64 usecs = costs.execution_time.asMicroSeconds().count();
+  return std::max<int64>(usecs, 1);
+}
+
+void ComputeCriticalPathLengths(const Graph& graph,
+                                const std::function<int64(const Node*)>& cost,
+                                std::vector<int64>* lengths) {
+  // In a depth-first post order every node comes after all of its
+  // successors, except the ones reached through a back edge.
+  std::vector<Node*> order;
+  GetPostOrder(graph, &order);
+
+  lengths->assign(graph.num_node_ids(), 0);
+  std::vector<bool> done(graph.num_node_ids(), false);
+  for (const Node* n : order) {
+    int64 longest_successor = 0;
+    if (!n->IsNextIteration()) {
+      for (const Edge* e : n->out_edges()) {
+        const int dst_id = e->dst()->id();
+        if (!done[dst_id]) continue;
+        longest_successor = std::max(longest_successor, (*lengths)[dst_id]);
+      }
+    }
+    (*lengths)[n->id()] = cost(n) + longest_successor;
+    done[n->id()] = true;
+  }
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,44 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_CRITICAL_PATH_H_
+#define TENSORFLOW_COMMON_RUNTIME_CRITICAL_PATH_H_
+
+#include <functional>
+#include <vector>
+
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/device_properties.pb.h"
+
+namespace tensorflow {
+
+// Returns the estimated time, in microseconds, to run "node" on "device"
+// according to grappler's analytical OpLevelCostEstimator. Input shapes are
+// taken from the "_output_shapes" attribute of the producing nodes when it
+// is present, and are otherwise unknown. Never returns less than 1.
+int64 EstimateNodeCostMicros(const Node* node, const DeviceProperties& device);
+
+// Computes, for every node of "graph", the cost of the most expensive path
+// from that node to the sink, where the cost of a path is the sum of
+// "cost(n)" over the nodes n on it. The back edges of while loops
+// (NextIteration -> Merge) are ignored. "*lengths" is indexed by node id.
+void ComputeCriticalPathLengths(const Graph& graph,
+                                const std::function<int64(const Node*)>& cost,
+                                std::vector<int64>* lengths);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_CRITICAL_PATH_H_
@@ -0,0 +1,96 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/critical_path.h"
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+Tensor Scalar(float v) {
+  Tensor t(DT_FLOAT, TensorShape({}));
+  t.scalar<float>()() = v;
+  return t;
+}
+
+// Every op node costs 10, except "expensive", which costs 1000.
+std::function<int64(const Node*)> TestCost(const Node* expensive) {
+  return [expensive](const Node* n) -> int64 {
+    if (!n->IsOp()) return 0;
+    return n == expensive ? 1000 : 10;
+  };
+}
+
+TEST(CriticalPathTest, LongestPathWins) {
+  Graph g(OpRegistry::Global());
+  Node* a = test::graph::Constant(&g, Scalar(1), "a");
+  // Short but expensive branch: a -> expensive -> out.
+  Node* expensive = test::graph::Identity(&g, a);
+  // Long but cheap branch: a -> c1 -> c2 -> c3 -> out.
+  Node* c = a;
+  for (int i = 0; i < 3; ++i) c = test::graph::Identity(&g, c);
+  Node* out = test::graph::Add(&g, expensive, c);
+  FixupSourceAndSinkEdges(&g);
+
+  std::vector<int64> lengths;
+  ComputeCriticalPathLengths(g, TestCost(expensive), &lengths);
+  EXPECT_EQ(10, lengths[out->id()]);
+  EXPECT_EQ(1010, lengths[expensive->id()]);
+  EXPECT_EQ(40, lengths[c->id()]);
+  EXPECT_EQ(1020, lengths[a->id()]);
+  EXPECT_EQ(0, lengths[g.sink_node()->id()]);
+  EXPECT_EQ(1020, lengths[g.source_node()->id()]);
+}
+
+TEST(CriticalPathTest, IgnoresLoopBackEdges) {
+  Graph g(OpRegistry::Global());
+  Node* a = test::graph::Constant(&g, Scalar(1), "a");
+  Node* enter = test::graph::Enter(&g, a, "loop");
+  Node* merge = test::graph::Merge(&g, enter, {"next"});
+  Node* body = test::graph::Identity(&g, merge);
+  Node* next = test::graph::Next(&g, "next", body);
+  g.AddEdge(next, 0, merge, 1);
+  Node* exit = test::graph::Exit(&g, merge);
+  FixupSourceAndSinkEdges(&g);
+
+  std::vector<int64> lengths;
+  ComputeCriticalPathLengths(g, TestCost(nullptr), &lengths);
+  EXPECT_EQ(10, lengths[next->id()]);
+  EXPECT_EQ(20, lengths[body->id()]);
+  EXPECT_EQ(10, lengths[exit->id()]);
+  EXPECT_EQ(30, lengths[merge->id()]);
+  EXPECT_EQ(40, lengths[enter->id()]);
+  EXPECT_EQ(50, lengths[a->id()]);
+}
+
+TEST(CriticalPathTest, EstimateNodeCostIsPositive) {
+  Graph g(OpRegistry::Global());
+  Node* a = test::graph::Constant(&g, Scalar(1));
+  Node* b = test::graph::Matmul(&g, a, a, false, false);
+  DeviceProperties cpu;
+  cpu.set_type("CPU");
+  cpu.set_num_cores(1);
+  cpu.set_frequency(1000);
+  EXPECT_GE(EstimateNodeCostMicros(b, cpu), 1);
+  EXPECT_EQ(1, EstimateNodeCostMicros(g.source_node(), cpu));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -27,6 +27,8 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/graph_optimizer.h"
 #include "tensorflow/core/common_runtime/memory_types.h"
 #include "tensorflow/core/common_runtime/optimization_registry.h"
+#include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/common_runtime/shared_kernel_cache.h"
 #include "tensorflow/core/common_runtime/simple_placer.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/function.h"
@@ -52,7 +54,6 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
-#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
@@ -72,17 +73,19 @@ auto* direct_session_runs = monitoring::Counter<0>::New(
     "The number of times DirectSession::Run() has been called.");
 
 int32 NumInterOpThreadsFromSessionOptions(const SessionOptions& options) {
-  const int32 t = options.config.inter_op_parallelism_threads();
-  if (t != 0) return t;
-  // Default to using the number of cores available in the process.
-  return port::NumSchedulableCPUs();
+  return NumThreadsOrDefault(options.config.inter_op_parallelism_threads(),
+                             options.config.inter_op_thread_pool_options());
 }
 
 thread::ThreadPool* NewThreadPoolFromSessionOptions(
     const SessionOptions& options) {
   const int32 num_threads = NumInterOpThreadsFromSessionOptions(options);
   VLOG(1) << "Direct session inter op parallelism threads: " << num_threads;
-  return new thread::ThreadPool(options.env, "Compute", num_threads);
+  const ThreadPoolOptionProto& pool_options =
+      options.config.inter_op_thread_pool_options();
+  return new thread::ThreadPool(
+      options.env, ThreadOptionsFromPoolOptions(pool_options), "Compute",
+      num_threads, !pool_options.disable_spinning());
 }
 
 thread::ThreadPool* NewThreadPoolFromThreadPoolOptions(
@@ -90,12 +93,16 @@ thread::ThreadPool* NewThreadPoolFromThreadPoolOptions(
     const ThreadPoolOptionProto& thread_pool_options, int pool_number) {
   int32 num_threads = thread_pool_options.num_threads();
   if (num_threads == 0) {
-    num_threads = NumInterOpThreadsFromSessionOptions(options);
+    num_threads = thread_pool_options.cpu_affinity_size() > 0
+                      ? thread_pool_options.cpu_affinity_size()
+                      : NumInterOpThreadsFromSessionOptions(options);
   }
   VLOG(1) << "Direct session inter op parallelism threads for pool "
           << pool_number << ": " << num_threads;
   return new thread::ThreadPool(
-      options.env, strings::StrCat("Compute", pool_number), num_threads);
+      options.env, ThreadOptionsFromPoolOptions(thread_pool_options),
+      strings::StrCat("Compute", pool_number), num_threads,
+      !thread_pool_options.disable_spinning());
 }
 
 thread::ThreadPool* GlobalThreadPool(const SessionOptions& options) {
@@ -104,6 +111,16 @@ thread::ThreadPool* GlobalThreadPool(const SessionOptions& options) {
   return thread_pool;
 }
 
+FairThreadPool* GlobalFairThreadPool(const SessionOptions& options) {
+  const ThreadPoolOptionProto& pool_options =
+      options.config.inter_op_thread_pool_options();
+  static FairThreadPool* const thread_pool = new FairThreadPool(
+      options.env, ThreadOptionsFromPoolOptions(pool_options), "FairCompute",
+      NumInterOpThreadsFromSessionOptions(options),
+      !pool_options.disable_spinning());
+  return thread_pool;
+}
+
 // TODO(vrv): Figure out how to unify the many different functions
 // that generate RendezvousKey, since many of them have to be
 // consistent with each other.
@@ -217,7 +234,11 @@ void DirectSession::SchedClosure(thread::ThreadPool* pool,
   // safe given the reasoning above.
   c();
 #else
-  pool->Schedule(std::move(c));
+  if (inter_op_client_ != nullptr) {
+    inter_op_client_->Schedule(std::move(c));
+  } else {
+    pool->Schedule(std::move(c));
+  }
 #endif  // __ANDROID__
 }
 
@@ -239,6 +260,15 @@ DirectSession::DirectSession(const SessionOptions& options,
   } else if (options_.config.use_per_session_threads()) {
     thread_pools_.push_back(NewThreadPoolFromSessionOptions(options_));
     owns_thread_pools_ = true;
+  } else if (options_.config.inter_op_scheduling_weight() > 0) {
+    static std::atomic<int64> next_label_id(0);
+    FairThreadPool* fair_pool = GlobalFairThreadPool(options_);
+    string label = options_.config.inter_op_scheduling_label();
+    if (label.empty()) label = strings::StrCat("session_", next_label_id++);
+    inter_op_client_ = fair_pool->NewClient(
+        label, options_.config.inter_op_scheduling_weight());
+    thread_pools_.push_back(fair_pool->pool());
+    owns_thread_pools_ = false;
   } else {
     thread_pools_.push_back(GlobalThreadPool(options));
     owns_thread_pools_ = false;
@@ -283,6 +313,7 @@ DirectSession::~DirectSession() {
   for (auto& it : partial_runs_) {
     it.second.reset(nullptr);
   }
+  callables_.clear();
   for (auto& it : executors_) {
     it.second.reset();
   }
@@ -429,8 +460,7 @@ Status DirectSession::Run(const RunOptions& run_options,
   ExecutorsAndKeys* executors_and_keys;
   RunStateArgs run_state_args(run_options.debug_options());
 
-  Executor::Args args;
-  args.step_id = step_id_counter_.fetch_add(1);
+  const int64 step_id = step_id_counter_.fetch_add(1);
 
   TF_RETURN_IF_ERROR(
       GetOrCreateExecutors(pool, input_tensor_names, output_names, target_nodes,
@@ -440,7 +470,7 @@ Status DirectSession::Run(const RunOptions& run_options,
   std::unique_ptr<DebuggerStateInterface> debugger_state;
   if (!run_options.debug_options().debug_tensor_watch_opts().empty()) {
     TF_RETURN_IF_ERROR(CreateDebuggerState(
-        run_options.debug_options(), args.step_id, executor_step_count,
+        run_options.debug_options(), step_id, executor_step_count,
         input_tensor_names, output_names, target_nodes, &debugger_state));
   }
 
@@ -467,11 +497,49 @@ Status DirectSession::Run(const RunOptions& run_options,
     return s;
   }
 
+  TF_RETURN_IF_ERROR(RunInternal(step_id, run_options, &call_frame,
+                                 executors_and_keys, executor_step_count,
+                                 output_names, run_state_args.handle,
+                                 run_metadata));
+
+  // Receive outputs.
+  if (outputs) {
+    std::vector<Tensor> sorted_outputs;
+    Status s = call_frame.ConsumeRetvals(&sorted_outputs);
+    if (errors::IsInternal(s)) {
+      return errors::InvalidArgument(s.error_message());
+    } else if (!s.ok()) {
+      return s;
+    }
+    outputs->clear();
+    outputs->reserve(sorted_outputs.size());
+    for (const string& output_name : output_names) {
+      outputs->emplace_back(
+          std::move(sorted_outputs[executors_and_keys
+                                       ->output_name_to_index[output_name]]));
+    }
+  }
+
+  return Status::OK();
+}
+
+Status DirectSession::RunInternal(int64 step_id, const RunOptions& run_options,
+                                  FunctionCallFrame* call_frame,
+                                  ExecutorsAndKeys* executors_and_keys,
+                                  int64 executor_step_count,
+                                  const std::vector<string>& output_names,
+                                  const string& handle,
+                                  RunMetadata* run_metadata) {
+  Executor::Args args;
+  args.step_id = step_id;
+
+  thread::ThreadPool* pool = thread_pools_[run_options.inter_op_thread_pool()];
+
   // Create a run state and start execution.
   RunState run_state(args.step_id, &devices_);
   run_state.rendez = new IntraProcessRendezvous(device_mgr_.get());
   CancellationManager step_cancellation_manager;
-  args.call_frame = &call_frame;
+  args.call_frame = call_frame;
 
   // Start parallel Executors.
   const size_t num_executors = executors_and_keys->items.size();
@@ -493,11 +561,18 @@ Status DirectSession::Run(const RunOptions& run_options,
   args.tensor_store = &run_state.tensor_store;
   args.step_container = &run_state.step_container;
   if (LogMemory::IsEnabled()) {
-    LogMemory::RecordStep(args.step_id, run_state_args.handle);
+    LogMemory::RecordStep(args.step_id, handle);
   }
   args.sync_on_finish = sync_on_finish_;
+  args.max_intra_op_parallelism = run_options.max_intra_op_parallelism();
 
-  const bool do_trace = (run_options.trace_level() > RunOptions::NO_TRACE);
+  bool do_trace = (run_options.trace_level() > RunOptions::NO_TRACE);
+  if (do_trace && run_options.trace_sample_period() > 1) {
+    // Only every trace_sample_period-th step asking for a trace is traced.
+    do_trace = trace_request_counter_.fetch_add(1) %
+                   run_options.trace_sample_period() ==
+               0;
+  }
 
   bool update_cost_model = false;
   if (options_.config.graph_options().build_cost_model() > 0) {
@@ -512,15 +587,21 @@ Status DirectSession::Run(const RunOptions& run_options,
     }
   }
   if (do_trace || update_cost_model) {
+    // The cost model needs the outputs and memory of the nodes.
+    const bool compact = run_options.compact_trace() && !update_cost_model;
     run_state.collector.reset(
-        new StepStatsCollector(run_metadata->mutable_step_stats()));
+        new StepStatsCollector(run_metadata->mutable_step_stats(), compact));
     args.stats_collector = run_state.collector.get();
   }
 
 #if GOOGLE_CUDA
   std::unique_ptr<GPUTracer> tracer;
-  if (run_options.trace_level() >= RunOptions::HARDWARE_TRACE) {
-    tracer.reset(CreateGPUTracer());
+  if (do_trace && run_options.trace_level() >= RunOptions::HARDWARE_TRACE) {
+    GPUTracerOptions tracer_options;
+    tracer_options.name_filter = run_options.gpu_trace_filter();
+    tracer_options.stream_ids.assign(run_options.gpu_trace_streams().begin(),
+                                     run_options.gpu_trace_streams().end());
+    tracer.reset(CreateGPUTracer(tracer_options));
     // tracer will be NULL on non-GPU platforms.
     // TODO(b/32704451): Don't just ignore the ::tensorflow::Status object!
     if (tracer) tracer->Start().IgnoreError();
@@ -560,6 +641,10 @@ Status DirectSession::Run(const RunOptions& run_options,
     run_state.status.Update(errors::Cancelled("Run call was cancelled"));
   }
 
+  if (args.stats_collector) {
+    args.stats_collector->Finalize();
+  }
+
 #if GOOGLE_CUDA
   if (tracer) {
     // TODO(b/32704451): Don't just ignore the ::tensorflow::Status object!
@@ -573,31 +658,13 @@ Status DirectSession::Run(const RunOptions& run_options,
     TF_RETURN_IF_ERROR(run_state.status);
   }
 
-  // Receive outputs.
-  if (outputs) {
-    std::vector<Tensor> sorted_outputs;
-    Status s = call_frame.ConsumeRetvals(&sorted_outputs);
-    if (errors::IsInternal(s)) {
-      return errors::InvalidArgument(s.error_message());
-    } else if (!s.ok()) {
-      return s;
-    }
-    outputs->clear();
-    outputs->reserve(sorted_outputs.size());
-    for (const string& output_name : output_names) {
-      outputs->emplace_back(
-          std::move(sorted_outputs[executors_and_keys
-                                       ->output_name_to_index[output_name]]));
-    }
-  }
-
   // Save the output tensors of this run we choose to keep.
   TF_RETURN_IF_ERROR(
       run_state.tensor_store.SaveTensors(output_names, &session_state_));
 
   // Build and return the cost model as instructed.
-  mutex_lock l(executor_lock_);
   if (update_cost_model) {
+    mutex_lock l(executor_lock_);
     // Build the cost model
     std::unordered_map<string, const Graph*> device_to_graph;
     for (const PerPartitionExecutorsAndLib& partition :
@@ -630,10 +697,176 @@ Status DirectSession::Run(const RunOptions& run_options,
   return Status::OK();
 }
 
+Status DirectSession::MakeCallable(const std::vector<string>& feed_names,
+                                   const std::vector<string>& fetch_names,
+                                   const std::vector<string>& target_nodes,
+                                   CallableHandle* out_handle) {
+  TF_RETURN_IF_ERROR(CheckNotClosed());
+  {
+    mutex_lock l(graph_def_lock_);
+    if (!graph_created_) {
+      return errors::InvalidArgument(
+          "Session was not created with a graph before MakeCallable()!");
+    }
+  }
+
+  std::shared_ptr<Callable> callable(new Callable);
+  RunStateArgs run_state_args(DebugOptions::default_instance());
+  TF_RETURN_IF_ERROR(GetOrCreateExecutors(thread_pools_[0], feed_names,
+                                          fetch_names, target_nodes,
+                                          &callable->executors_and_keys,
+                                          &run_state_args));
+  ExecutorsAndKeys* executors_and_keys = callable->executors_and_keys;
+
+  // Resolve the feed and fetch names to call frame indices once, so that
+  // RunCallable() can index the call frame directly.
+  callable->feed_arg_index.reserve(feed_names.size());
+  for (const string& feed_name : feed_names) {
+    callable->feed_arg_index.push_back(
+        executors_and_keys->input_name_to_index[feed_name]);
+  }
+  callable->fetch_retval_index.reserve(fetch_names.size());
+  for (const string& fetch_name : fetch_names) {
+    callable->fetch_retval_index.push_back(
+        executors_and_keys->output_name_to_index[fetch_name]);
+  }
+  callable->fetch_names = fetch_names;
+  callable->handle = run_state_args.handle;
+
+  mutex_lock l(callables_lock_);
+  *out_handle = next_callable_handle_++;
+  callables_[*out_handle] = std::move(callable);
+  return Status::OK();
+}
+
+Status DirectSession::RunCallable(CallableHandle handle,
+                                  const std::vector<Tensor>& feed_tensors,
+                                  std::vector<Tensor>* fetch_tensors,
+                                  RunMetadata* run_metadata) {
+  TF_RETURN_IF_ERROR(CheckNotClosed());
+  direct_session_runs->GetCell()->IncrementBy(1);
+
+  std::shared_ptr<Callable> callable;
+  {
+    mutex_lock l(callables_lock_);
+    auto it = callables_.find(handle);
+    if (it == callables_.end()) {
+      return errors::InvalidArgument("No such callable handle: ", handle);
+    }
+    callable = it->second;
+  }
+  ExecutorsAndKeys* executors_and_keys = callable->executors_and_keys;
+
+  if (feed_tensors.size() != callable->feed_arg_index.size()) {
+    return errors::InvalidArgument(
+        "Invalid number of feed tensors passed to RunCallable(): expected ",
+        callable->feed_arg_index.size(), ", got ", feed_tensors.size());
+  }
+
+  const int64 step_id = step_id_counter_.fetch_add(1);
+  const int64 executor_step_count = executors_and_keys->step_count.fetch_add(1);
+
+  FunctionCallFrame call_frame(executors_and_keys->input_types,
+                               executors_and_keys->output_types);
+  gtl::InlinedVector<Tensor, 4> feed_args(feed_tensors.size());
+  for (size_t i = 0; i < feed_tensors.size(); ++i) {
+    const Tensor& tensor = feed_tensors[i];
+    if (tensor.dtype() == DT_RESOURCE) {
+      TF_RETURN_IF_ERROR(ResourceHandleToInputTensor(
+          tensor, &feed_args[callable->feed_arg_index[i]]));
+    } else {
+      feed_args[callable->feed_arg_index[i]] = tensor;
+    }
+  }
+  Status s = call_frame.SetArgs(feed_args);
+  if (errors::IsInternal(s)) {
+    return errors::InvalidArgument(s.error_message());
+  } else if (!s.ok()) {
+    return s;
+  }
+
+  RunMetadata unused_run_metadata;
+  TF_RETURN_IF_ERROR(RunInternal(
+      step_id, RunOptions::default_instance(), &call_frame, executors_and_keys,
+      executor_step_count, callable->fetch_names, callable->handle,
+      run_metadata != nullptr ? run_metadata : &unused_run_metadata));
+
+  if (fetch_tensors) {
+    std::vector<Tensor> sorted_outputs;
+    Status s = call_frame.ConsumeRetvals(&sorted_outputs);
+    if (errors::IsInternal(s)) {
+      return errors::InvalidArgument(s.error_message());
+    } else if (!s.ok()) {
+      return s;
+    }
+    fetch_tensors->clear();
+    fetch_tensors->reserve(sorted_outputs.size());
+    for (size_t index : callable->fetch_retval_index) {
+      fetch_tensors->emplace_back(std::move(sorted_outputs[index]));
+    }
+  }
+
+  return Status::OK();
+}
+
+Status DirectSession::ReleaseCallable(CallableHandle handle) {
+  mutex_lock l(callables_lock_);
+  if (callables_.erase(handle) == 0) {
+    return errors::InvalidArgument("No such callable handle: ", handle);
+  }
+  return Status::OK();
+}
+
 Status DirectSession::PRunSetup(const std::vector<string>& input_names,
                                 const std::vector<string>& output_names,
                                 const std::vector<string>& target_nodes,
                                 string* handle) {
+  return PRunSetupInternal(input_names, output_names, target_nodes, nullptr,
+                           handle);
+}
+
+Status DirectSession::StagedPRunSetup(
+    const std::vector<PartialRunStage>& stages,
+    const std::vector<string>& target_nodes, string* handle) {
+  if (stages.empty()) {
+    return errors::InvalidArgument(
+        "A staged partial run must have at least one stage.");
+  }
+  // Each feed and fetch belongs to one stage, as it can be fed or fetched
+  // only once.
+  std::vector<string> input_names;
+  std::vector<string> output_names;
+  std::unordered_set<string> seen_names;
+  for (const PartialRunStage& stage : stages) {
+    for (const string& name : stage.feed_names) {
+      if (!seen_names.insert(name).second) {
+        return errors::InvalidArgument("The feed ", name,
+                                       " is in more than one stage of the "
+                                       "partial run.");
+      }
+      input_names.push_back(name);
+    }
+  }
+  seen_names.clear();
+  for (const PartialRunStage& stage : stages) {
+    for (const string& name : stage.fetch_names) {
+      if (!seen_names.insert(name).second) {
+        return errors::InvalidArgument("The fetch ", name,
+                                       " is in more than one stage of the "
+                                       "partial run.");
+      }
+      output_names.push_back(name);
+    }
+  }
+  return PRunSetupInternal(input_names, output_names, target_nodes, &stages,
+                           handle);
+}
+
+Status DirectSession::PRunSetupInternal(
+    const std::vector<string>& input_names,
+    const std::vector<string>& output_names,
+    const std::vector<string>& target_nodes,
+    const std::vector<PartialRunStage>* stages, string* handle) {
   TF_RETURN_IF_ERROR(CheckNotClosed());
   {
     mutex_lock l(graph_def_lock_);
@@ -659,14 +892,17 @@ Status DirectSession::PRunSetup(const std::vector<string>& input_names,
   // Create the run state and save it for future PRun calls.
   Executor::Args args;
   args.step_id = step_id_counter_.fetch_add(1);
-  RunState* run_state =
-      new RunState(input_names, output_names, args.step_id, &devices_);
+  std::unique_ptr<RunState> new_run_state(
+      new RunState(input_names, output_names, args.step_id, &devices_));
+  if (stages != nullptr) {
+    TF_RETURN_IF_ERROR(
+        PlanPRunStages(*stages, executors_and_keys, new_run_state.get()));
+  }
+  RunState* run_state = new_run_state.get();
   run_state->rendez = new IntraProcessRendezvous(device_mgr_.get());
   {
     mutex_lock l(executor_lock_);
-    if (!partial_runs_
-             .emplace(run_state_args.handle,
-                      std::unique_ptr<RunState>(run_state))
+    if (!partial_runs_.emplace(run_state_args.handle, std::move(new_run_state))
              .second) {
       return errors::Internal("The handle '", run_state_args.handle,
                               "' created for this partial run is not unique.");
@@ -734,6 +970,11 @@ Status DirectSession::PRun(const string& handle, const NamedTensorList& inputs,
           "Must run 'setup' before performing partial runs!");
     }
     run_state = prun_it->second.get();
+    if (!run_state->stages.empty()) {
+      return errors::InvalidArgument(
+          "The partial run was set up with stages, so it must be run with "
+          "StagedPRun().");
+    }
 
     // Make sure that this is a new set of feeds that are still pending.
     for (const auto& input : inputs) {
@@ -810,6 +1051,80 @@ Status DirectSession::PRun(const string& handle, const NamedTensorList& inputs,
   return s;
 }
 
+Status DirectSession::StagedPRun(const string& handle, int stage,
+                                 const std::vector<Tensor>& feed_tensors,
+                                 std::vector<Tensor>* fetch_tensors) {
+  TF_RETURN_IF_ERROR(CheckNotClosed());
+  RunState* run_state;
+  {
+    mutex_lock l(executor_lock_);  // could use reader lock
+    auto prun_it = partial_runs_.find(handle);
+    if (prun_it == partial_runs_.end() || prun_it->second->stages.empty()) {
+      return errors::InvalidArgument(
+          "Must run 'StagedPRunSetup' before performing staged partial runs!");
+    }
+    run_state = prun_it->second.get();
+  }
+  const int num_stages = run_state->stages.size();
+  if (stage < 0 || stage >= num_stages) {
+    return errors::InvalidArgument("Invalid stage ", stage,
+                                   " of a partial run with ", num_stages,
+                                   " stages.");
+  }
+  const RunState::Stage& planned_stage = run_state->stages[stage];
+  if (feed_tensors.size() != planned_stage.feed_keys.size()) {
+    return errors::InvalidArgument(
+        "Stage ", stage, " of the partial run expects ",
+        planned_stage.feed_keys.size(), " feeds, but ", feed_tensors.size(),
+        " were provided.");
+  }
+  {
+    mutex_lock l(run_state->mu_);
+    if (stage != run_state->next_stage) {
+      return errors::InvalidArgument("Stage ", stage,
+                                     " of the partial run can't run before "
+                                     "stage ",
+                                     run_state->next_stage, ".");
+    }
+    ++run_state->next_stage;
+  }
+
+  // Send inputs.
+  Status s;
+  for (size_t i = 0; i < feed_tensors.size() && s.ok(); ++i) {
+    s = SendPRunInput(planned_stage.feed_keys[i], feed_tensors[i],
+                      run_state->rendez);
+  }
+
+  // Receive outputs.
+  if (s.ok()) {
+    fetch_tensors->resize(planned_stage.fetch_keys.size());
+    for (size_t i = 0; i < planned_stage.fetch_keys.size() && s.ok(); ++i) {
+      s = RecvPRunOutput(planned_stage.fetch_keys[i],
+                         planned_stage.fetch_names[i], run_state->rendez,
+                         &(*fetch_tensors)[i]);
+    }
+    if (!s.ok()) {
+      fetch_tensors->clear();
+    }
+  }
+
+  // Save the output tensors of this run we choose to keep.
+  if (s.ok()) {
+    s = run_state->tensor_store.SaveTensors(planned_stage.fetch_names,
+                                            &session_state_);
+  }
+
+  // Delete the run state if there is an error or all stages are done.
+  if (!s.ok() || stage + 1 == num_stages) {
+    mutex_lock l(executor_lock_);
+    WaitForNotification(run_state, cancellation_manager_,
+                        operation_timeout_in_ms_);
+    partial_runs_.erase(handle);
+  }
+  return s;
+}
+
 Status DirectSession::ResourceHandleToInputTensor(const Tensor& resource_tensor,
                                                   Tensor* retrieved_tensor) {
   if (resource_tensor.dtype() != DT_RESOURCE) {
@@ -831,6 +1146,44 @@ Status DirectSession::ResourceHandleToInputTensor(const Tensor& resource_tensor,
   }
 }
 
+Status DirectSession::SendPRunInput(const Rendezvous::ParsedKey& input_key,
+                                    const Tensor& input,
+                                    IntraProcessRendezvous* rendez) {
+  Status s;
+  if (input.dtype() == DT_RESOURCE) {
+    Tensor tensor_from_handle;
+    s = ResourceHandleToInputTensor(input, &tensor_from_handle);
+    if (s.ok()) {
+      s = rendez->Send(input_key, Rendezvous::Args(), tensor_from_handle,
+                       false);
+    }
+  } else {
+    s = rendez->Send(input_key, Rendezvous::Args(), input, false);
+  }
+  if (!s.ok()) {
+    rendez->StartAbort(s);
+  }
+  return s;
+}
+
+Status DirectSession::RecvPRunOutput(const Rendezvous::ParsedKey& output_key,
+                                     const string& output_name,
+                                     IntraProcessRendezvous* rendez,
+                                     Tensor* output) {
+  bool is_dead;
+  // Fetch data from the Rendezvous.
+  Status s = rendez->Recv(output_key, Rendezvous::Args(), output, &is_dead,
+                          operation_timeout_in_ms_);
+  if (is_dead && s.ok()) {
+    s = errors::InvalidArgument("The tensor returned for ", output_name,
+                                " was not valid.");
+  }
+  if (!s.ok()) {
+    rendez->StartAbort(s);
+  }
+  return s;
+}
+
 Status DirectSession::SendPRunInputs(const NamedTensorList& inputs,
                                      const ExecutorsAndKeys* executors_and_keys,
                                      IntraProcessRendezvous* rendez) {
@@ -851,21 +1204,7 @@ Status DirectSession::SendPRunInputs(const NamedTensorList& inputs,
       rendez->StartAbort(s);
       return s;
     }
-
-    if (input.second.dtype() == DT_RESOURCE) {
-      Tensor tensor_from_handle;
-      s = ResourceHandleToInputTensor(input.second, &tensor_from_handle);
-      if (s.ok()) {
-        s = rendez->Send(parsed, Rendezvous::Args(), tensor_from_handle, false);
-      }
-    } else {
-      s = rendez->Send(parsed, Rendezvous::Args(), input.second, false);
-    }
-
-    if (!s.ok()) {
-      rendez->StartAbort(s);
-      return s;
-    }
+    TF_RETURN_IF_ERROR(SendPRunInput(parsed, input.second, rendez));
   }
   return Status::OK();
 }
@@ -892,21 +1231,15 @@ Status DirectSession::RecvPRunOutputs(
     }
     const string& output_key = it->second;
     Tensor output_tensor;
-    bool is_dead;
     IntraProcessRendezvous* rendez = run_state->rendez;
 
     s = Rendezvous::ParseKey(output_key, &parsed);
     if (s.ok()) {
-      // Fetch data from the Rendezvous.
-      s = rendez->Recv(parsed, Rendezvous::Args(), &output_tensor, &is_dead,
-                       operation_timeout_in_ms_);
-      if (is_dead && s.ok()) {
-        s = errors::InvalidArgument("The tensor returned for ", output_name,
-                                    " was not valid.");
-      }
+      s = RecvPRunOutput(parsed, output_name, rendez, &output_tensor);
+    } else {
+      rendez->StartAbort(s);
     }
     if (!s.ok()) {
-      rendez->StartAbort(s);
       outputs->clear();
       return s;
     }
@@ -920,7 +1253,6 @@ Status DirectSession::CheckFetch(const NamedTensorList& feeds,
                                  const std::vector<string>& fetches,
                                  const ExecutorsAndKeys* executors_and_keys,
                                  const RunState* run_state) {
-  const Graph* graph = executors_and_keys->graph.get();
   const NameNodeMap* name_to_node = &executors_and_keys->name_to_node;
 
   // Build the set of pending feeds that we haven't seen.
@@ -942,6 +1274,16 @@ Status DirectSession::CheckFetch(const NamedTensorList& feeds,
     TensorId id(ParseTensorName(it.first));
     pending_feeds.erase(id);
   }
+  return CheckFetchWithPendingFeeds(pending_feeds, fetches,
+                                    executors_and_keys);
+}
+
+Status DirectSession::CheckFetchWithPendingFeeds(
+    const std::unordered_set<TensorId, TensorId::Hasher>& pending_feeds,
+    const std::vector<string>& fetches,
+    const ExecutorsAndKeys* executors_and_keys) {
+  const Graph* graph = executors_and_keys->graph.get();
+  const NameNodeMap* name_to_node = &executors_and_keys->name_to_node;
 
   // Initialize the stack with the fetch nodes.
   std::vector<const Node*> stack;
@@ -977,6 +1319,55 @@ Status DirectSession::CheckFetch(const NamedTensorList& feeds,
   return Status::OK();
 }
 
+Status DirectSession::PlanPRunStages(
+    const std::vector<PartialRunStage>& stages,
+    const ExecutorsAndKeys* executors_and_keys, RunState* run_state) {
+  const NameNodeMap* name_to_node = &executors_and_keys->name_to_node;
+  // Initially all the feeds are pending.
+  std::unordered_set<TensorId, TensorId::Hasher> pending_feeds;
+  for (const PartialRunStage& stage : stages) {
+    for (const string& feed : stage.feed_names) {
+      TensorId id(ParseTensorName(feed));
+      if (name_to_node->find(id.first) == name_to_node->end()) {
+        return errors::NotFound("Feed ", feed, ": not found");
+      }
+      pending_feeds.insert(id);
+    }
+  }
+
+  run_state->stages.resize(stages.size());
+  for (size_t i = 0; i < stages.size(); ++i) {
+    const PartialRunStage& stage = stages[i];
+    RunState::Stage* planned_stage = &run_state->stages[i];
+    planned_stage->feed_keys.resize(stage.feed_names.size());
+    for (size_t j = 0; j < stage.feed_names.size(); ++j) {
+      const string& feed = stage.feed_names[j];
+      TF_RETURN_IF_ERROR(Rendezvous::ParseKey(
+          executors_and_keys->input_name_to_rendezvous_key.at(feed),
+          &planned_stage->feed_keys[j]));
+      pending_feeds.erase(ParseTensorName(feed));
+    }
+    // The fetches of this stage can only use the feeds of the stages up to
+    // it.
+    Status s = CheckFetchWithPendingFeeds(pending_feeds, stage.fetch_names,
+                                          executors_and_keys);
+    if (!s.ok()) {
+      return Status(s.code(), strings::StrCat("Stage ", i,
+                                              " of the partial run: ",
+                                              s.error_message()));
+    }
+    planned_stage->fetch_keys.resize(stage.fetch_names.size());
+    for (size_t j = 0; j < stage.fetch_names.size(); ++j) {
+      TF_RETURN_IF_ERROR(Rendezvous::ParseKey(
+          executors_and_keys->output_name_to_rendezvous_key.at(
+              stage.fetch_names[j]),
+          &planned_stage->fetch_keys[j]));
+    }
+    planned_stage->fetch_names = stage.fetch_names;
+  }
+  return Status::OK();
+}
+
 Status DirectSession::GetOrCreateExecutors(
     thread::ThreadPool* pool, gtl::ArraySlice<string> inputs,
     gtl::ArraySlice<string> outputs, gtl::ArraySlice<string> target_nodes,
@@ -1107,10 +1498,22 @@ Status DirectSession::GetOrCreateExecutors(
     params.function_library = item->flib.get();
     auto lib = item->flib.get();
     auto opseg = device->op_segment();
-    params.create_kernel = [this, lib, opseg](const NodeDef& ndef,
-                                              OpKernel** kernel) {
-      // Caches the kernel only if the node is stateful.
+    const bool share_kernels =
+        options_.config.executor_options().share_constant_kernels();
+    params.create_kernel = [this, lib, opseg, device, share_kernels](
+        const NodeDef& ndef, OpKernel** kernel) {
+      // Caches the kernel only if the node is stateful, or in the kernel
+      // cache shared with other sessions if it is a stateless node that
+      // builds tensors from its attrs (e.g. a Const).
       if (!lib->IsStateful(ndef.op())) {
+        if (share_kernels && SharedKernelCache::IsShareable(ndef) &&
+            lib->GetFunctionLibraryDefinition()->Find(ndef.op()) == nullptr) {
+          return SharedKernelCache::Global()->FindOrCreate(
+              device->attributes(), lib->graph_def_version(), ndef, kernel,
+              [lib, &ndef](OpKernel** kernel) {
+                return lib->CreateKernel(ndef, kernel);
+              });
+        }
         return lib->CreateKernel(ndef, kernel);
       }
       auto create_fn = [lib, &ndef](OpKernel** kernel) {
@@ -1122,13 +1525,33 @@ Status DirectSession::GetOrCreateExecutors(
       return opseg->FindOrCreate(session_handle_, ndef.name(), kernel,
                                  create_fn);
     };
-    params.delete_kernel = [lib](OpKernel* kernel) {
-      // If the node is stateful, opseg owns it. Otherwise, delete it.
-      if (kernel && !lib->IsStateful(kernel->type_string())) {
+    params.delete_kernel = [lib, share_kernels](OpKernel* kernel) {
+      // If the node is stateful, opseg owns it. If it is shared with other
+      // sessions, the kernel cache owns it. Otherwise, delete it.
+      if (kernel && !lib->IsStateful(kernel->type_string()) &&
+          !(share_kernels && SharedKernelCache::Global()->Release(kernel))) {
         delete kernel;
       }
     };
+    params.create_kernel_runner = [this, pool](Executor::Args::Closure c) {
+      SchedClosure(pool, std::move(c));
+    };
     params.node_outputs_cb = node_outputs_callback_;
+    params.scheduler = options_.config.executor_options().scheduler();
+    params.max_scheduler_workers = pool->NumThreads();
+    params.priority_measurement_steps =
+        options_.config.executor_options().priority_measurement_steps();
+    params.use_step_arena =
+        options_.config.executor_options().use_step_arena();
+    params.plan_memory = options_.config.executor_options().plan_memory();
+    params.export_op_metrics =
+        options_.config.executor_options().export_op_metrics();
+    params.export_executor_stats =
+        options_.config.executor_options().export_executor_stats();
+    params.count_kernel_cycles =
+        options_.config.executor_options().count_kernel_cycles();
+    params.count_kernel_perf_events =
+        options_.config.executor_options().count_kernel_perf_events();
 
     optimizer.Optimize(lib, options_.env, device, &iter->second);
 
@@ -1315,6 +1738,12 @@ Status DirectSession::CreateGraphs(
     // There are internal operations (e.g., send/recv) that we now allow.
     device_opts.allow_internal_ops = true;
     device_opts.expect_device_spec = true;
+    // The partitions were built from a valid graph.
+    device_opts.trusted = true;
+    device_opts.runner = [this](std::function<void()> c) {
+      SchedClosure(thread_pools_[0], std::move(c));
+    };
+    device_opts.max_parallelism = thread_pools_[0]->NumThreads();
     TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(device_opts, partition.second,
                                               device_graph.get()));
     outputs->emplace(partition.first, std::move(device_graph));
@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/device_set.h"
 #include "tensorflow/core/common_runtime/executor.h"
+#include "tensorflow/core/common_runtime/fair_thread_pool.h"
 #include "tensorflow/core/common_runtime/rendezvous_mgr.h"
 #include "tensorflow/core/common_runtime/session_factory.h"
 #include "tensorflow/core/common_runtime/simple_graph_execution_state.h"
@@ -35,6 +36,7 @@ limitations under the License.
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/session_state.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/tensor_id.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
@@ -91,6 +93,48 @@ class DirectSession : public Session {
                             const std::vector<string>& output_names,
                             std::vector<Tensor>* outputs) override;
 
+  // NOTE: MakeCallable, RunCallable and ReleaseCallable are experimental and
+  // subject to change.
+  //
+  // A callable runs the subgraph for a fixed signature of 'feed_names',
+  // 'fetch_names' and 'target_nodes', which MakeCallable() resolves once.
+  // RunCallable() takes the feeds positionally, in the order of 'feed_names',
+  // and returns the fetches in the order of 'fetch_names', without the
+  // per-step signature lookup performed by Run(). Callables are run with the
+  // default RunOptions; 'run_metadata' may be nullptr.
+  typedef int64 CallableHandle;
+  ::tensorflow::Status MakeCallable(const std::vector<string>& feed_names,
+                                    const std::vector<string>& fetch_names,
+                                    const std::vector<string>& target_nodes,
+                                    CallableHandle* out_handle);
+  ::tensorflow::Status RunCallable(CallableHandle handle,
+                                   const std::vector<Tensor>& feed_tensors,
+                                   std::vector<Tensor>* fetch_tensors,
+                                   RunMetadata* run_metadata);
+  ::tensorflow::Status ReleaseCallable(CallableHandle handle);
+
+  // NOTE: StagedPRunSetup and StagedPRun are experimental and subject to
+  // change.
+  //
+  // A staged partial run is a partial run whose sequence of feeds and fetches
+  // is declared up front, as 'stages'. StagedPRun(handle, i, ...) takes the
+  // feeds of stages[i] positionally, in the order of its 'feed_names', and
+  // returns its fetches in the order of its 'fetch_names'. The stages run in
+  // order, each one once. StagedPRunSetup() checks that the fetches of each
+  // stage can be computed from the feeds of the stages up to it, and parses
+  // their rendezvous keys, so that StagedPRun() does none of the per-call
+  // name lookups and checks performed by PRun().
+  struct PartialRunStage {
+    std::vector<string> feed_names;
+    std::vector<string> fetch_names;
+  };
+  ::tensorflow::Status StagedPRunSetup(
+      const std::vector<PartialRunStage>& stages,
+      const std::vector<string>& target_nodes, string* handle);
+  ::tensorflow::Status StagedPRun(const string& handle, int stage,
+                                  const std::vector<Tensor>& feed_tensors,
+                                  std::vector<Tensor>* fetch_tensors);
+
   // Reset clears 'containers' from the device_mgr of the DirectSession.
   // If 'containers' is empty, then Reset clears the default container.
   ::tensorflow::Status Reset(const std::vector<string>& containers);
@@ -155,6 +199,15 @@ class DirectSession : public Session {
     Notification executors_done;
     std::unordered_map<string, bool> pending_inputs;   // true if fed
     std::unordered_map<string, bool> pending_outputs;  // true if fetched
+    // For a staged partial run, the rendezvous keys of the feeds and fetches
+    // of each stage, and the index of the next stage to run.
+    struct Stage {
+      std::vector<Rendezvous::ParsedKey> feed_keys;
+      std::vector<Rendezvous::ParsedKey> fetch_keys;
+      std::vector<string> fetch_names;
+    };
+    std::vector<Stage> stages;
+    int next_stage GUARDED_BY(mu_) = 0;
     TensorStore tensor_store;
     ScopedStepContainer step_container;
 
@@ -179,6 +232,19 @@ class DirectSession : public Session {
     const DebugOptions& debug_options;
   };
 
+  // A Callable is created by MakeCallable() for a given set of
+  // feeds/fetches/targets. 'executors_and_keys' is owned by 'executors_'.
+  // 'feed_arg_index[i]' is the call frame argument index of the i-th feed,
+  // and 'fetch_retval_index[i]' is the call frame return value index of the
+  // i-th fetch.
+  struct Callable {
+    ExecutorsAndKeys* executors_and_keys = nullptr;  // not owned
+    std::vector<size_t> feed_arg_index;
+    std::vector<size_t> fetch_retval_index;
+    std::vector<string> fetch_names;
+    string handle;
+  };
+
   // Initializes the base execution state given the 'graph',
   // if not already initialized.
   Status MaybeInitializeExecutionState(const GraphDef& graph,
@@ -208,6 +274,42 @@ class DirectSession : public Session {
   ::tensorflow::Status ResourceHandleToInputTensor(
       const Tensor& resource_tensor, Tensor* retrieved_tensor);
 
+  // Runs the executors in 'executors_and_keys' for one step, feeding and
+  // fetching values through 'call_frame'. Shared by Run() and RunCallable().
+  ::tensorflow::Status RunInternal(int64 step_id, const RunOptions& run_options,
+                                   FunctionCallFrame* call_frame,
+                                   ExecutorsAndKeys* executors_and_keys,
+                                   int64 executor_step_count,
+                                   const std::vector<string>& output_names,
+                                   const string& handle,
+                                   RunMetadata* run_metadata);
+
+  // Sets up a partial run, with the plan of its 'stages' if they are not
+  // nullptr. Shared by PRunSetup() and StagedPRunSetup().
+  ::tensorflow::Status PRunSetupInternal(
+      const std::vector<string>& input_names,
+      const std::vector<string>& output_names,
+      const std::vector<string>& target_nodes,
+      const std::vector<PartialRunStage>* stages, string* handle);
+
+  // Checks the 'stages' of a staged partial run and fills in their
+  // rendezvous keys in 'run_state'.
+  ::tensorflow::Status PlanPRunStages(
+      const std::vector<PartialRunStage>& stages,
+      const ExecutorsAndKeys* executors_and_keys, RunState* run_state);
+
+  // Feeds one more input to the executors, under its rendezvous key.
+  ::tensorflow::Status SendPRunInput(const Rendezvous::ParsedKey& input_key,
+                                     const Tensor& input,
+                                     IntraProcessRendezvous* rendez);
+
+  // Fetches one more output from the executors, under its rendezvous key. It
+  // waits until the output tensor is computed.
+  ::tensorflow::Status RecvPRunOutput(const Rendezvous::ParsedKey& output_key,
+                                      const string& output_name,
+                                      IntraProcessRendezvous* rendez,
+                                      Tensor* output);
+
   // Feeds more inputs to the executors, triggering further execution.
   ::tensorflow::Status SendPRunInputs(
       const std::vector<std::pair<string, Tensor>>& inputs,
@@ -228,6 +330,13 @@ class DirectSession : public Session {
       const std::vector<string>& fetches,
       const ExecutorsAndKeys* executors_and_keys, const RunState* run_state);
 
+  // Check if the specified fetches can be computed without the
+  // 'pending_feeds', which have not been fed yet.
+  ::tensorflow::Status CheckFetchWithPendingFeeds(
+      const std::unordered_set<TensorId, TensorId::Hasher>& pending_feeds,
+      const std::vector<string>& fetches,
+      const ExecutorsAndKeys* executors_and_keys);
+
   // Use the appropriate WaitForNotification function based on whether
   // operation_timeout_in_ms is greater than 0.
   //
@@ -269,6 +378,9 @@ class DirectSession : public Session {
   // The thread-pools to use for running ops.
   std::vector<thread::ThreadPool*> thread_pools_;
   bool owns_thread_pools_ = false;
+  // If set, ops are scheduled through this client of the global fair thread
+  // pool, which thread_pools_ then holds.
+  std::unique_ptr<FairThreadPool::Client> inter_op_client_;
 
   // If true, blocks until device has finished all queued operations in a step.
   bool sync_on_finish_ = true;
@@ -288,6 +400,14 @@ class DirectSession : public Session {
   std::unordered_map<string, std::unique_ptr<RunState>> partial_runs_
       GUARDED_BY(executor_lock_);
 
+  mutex callables_lock_;  // protects callables_
+  // Holds mappings from callable handle to the resolved callable. The map
+  // value is a shared_ptr so that ReleaseCallable() may run concurrently with
+  // RunCallable() on the same handle.
+  std::unordered_map<CallableHandle, std::shared_ptr<Callable>> callables_
+      GUARDED_BY(callables_lock_);
+  CallableHandle next_callable_handle_ GUARDED_BY(callables_lock_) = 0;
+
   // This holds all the tensors that are currently alive in the session.
   SessionState session_state_;
 
@@ -318,6 +438,10 @@ class DirectSession : public Session {
   std::atomic<int64> edge_name_counter_ = {0};
   std::atomic<int64> handle_name_counter_ = {0};
 
+  // The number of steps run with a "trace_level", for
+  // RunOptions.trace_sample_period.
+  std::atomic<int64> trace_request_counter_ = {0};
+
   // For generating step ids that are unique across all sessions.
   static std::atomic_int_fast64_t step_id_counter_;
 
@@ -22,10 +22,14 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/common_runtime/device_factory.h"
+#include "tensorflow/core/common_runtime/shared_kernel_cache.h"
+#include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_description.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/graph/costmodel.h"
@@ -137,6 +141,46 @@ TEST_F(DirectSessionMinusAXTest, TestFeed) {
   EXPECT_FLOAT_EQ(39.0, mat(1, 0));
 }
 
+TEST_F(DirectSessionMinusAXTest, TestFeedWithCallable) {
+  Initialize({1, 2, 3, 4});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  DirectSession* direct_session = static_cast<DirectSession*>(session.get());
+
+  TF_ASSERT_OK(session->Create(def_));
+
+  // Fetch in an order different from the sorted order of the names, to check
+  // that the fetches are returned positionally.
+  DirectSession::CallableHandle handle;
+  TF_ASSERT_OK(direct_session->MakeCallable({x_}, {y_neg_ + ":0", y_ + ":0"},
+                                            {}, &handle));
+
+  for (int i = 0; i < 2; ++i) {
+    Tensor t(DT_FLOAT, TensorShape({2, 1}));
+    t.matrix<float>()(0, 0) = 5 + i;
+    t.matrix<float>()(1, 0) = 6;
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(direct_session->RunCallable(handle, {t}, &outputs, nullptr));
+
+    ASSERT_EQ(2, outputs.size());
+    // Expect y to be; 1*(5+i) + 2*6, 3*(5+i) + 4*6
+    EXPECT_FLOAT_EQ(-(17.0 + i), outputs[0].matrix<float>()(0, 0));
+    EXPECT_FLOAT_EQ(17.0 + i, outputs[1].matrix<float>()(0, 0));
+    EXPECT_FLOAT_EQ(39.0 + 3 * i, outputs[1].matrix<float>()(1, 0));
+  }
+
+  // Passing the wrong number of feeds is an error.
+  std::vector<Tensor> outputs;
+  Status s = direct_session->RunCallable(handle, {}, &outputs, nullptr);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+
+  TF_ASSERT_OK(direct_session->ReleaseCallable(handle));
+  s = direct_session->RunCallable(handle, {}, &outputs, nullptr);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+  s = direct_session->ReleaseCallable(handle);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+}
+
 TEST_F(DirectSessionMinusAXTest, TestConcurrency) {
   Initialize({1, 2, 3, 4});
   auto session = CreateSession();
@@ -206,6 +250,147 @@ TEST_F(DirectSessionMinusAXTest, TestPerSessionThreads) {
   delete tp;
 }
 
+TEST_F(DirectSessionMinusAXTest, TestPinnedNonSpinningSessionThreads) {
+  Initialize({1, 2, 3, 4});
+
+  SessionOptions options;
+  options.config.set_use_per_session_threads(true);
+  options.config.mutable_inter_op_thread_pool_options()->add_cpu_affinity(0);
+  options.config.mutable_inter_op_thread_pool_options()->set_disable_spinning(
+      true);
+  (*options.config.mutable_device_count())["CPU"] = 2;
+  std::unique_ptr<Session> session(NewSession(options));
+
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run({}, {y_ + ":0"}, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_FLOAT_EQ(3.0, outputs[0].matrix<float>()(0, 0));
+}
+
+TEST_F(DirectSessionMinusAXTest, SharesConstantKernelsAcrossSessions) {
+  Initialize({1, 2, 3, 4});
+  SessionOptions options;
+  (*options.config.mutable_device_count())["CPU"] = 2;
+  options.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_opt_level(OptimizerOptions::L0);
+  options.config.mutable_executor_options()->set_share_constant_kernels(true);
+
+  const int64 initial_size = SharedKernelCache::Global()->size();
+  std::vector<string> output_names = {y_ + ":0"};
+  auto run = [&output_names](Session* session) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, output_names, {}, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    EXPECT_FLOAT_EQ(3.0, outputs[0].matrix<float>()(0, 0));
+  };
+
+  std::unique_ptr<Session> session1(NewSession(options));
+  TF_ASSERT_OK(session1->Create(def_));
+  run(session1.get());
+  // The two constants of the graph.
+  EXPECT_EQ(initial_size + 2, SharedKernelCache::Global()->size());
+
+  std::unique_ptr<Session> session2(NewSession(options));
+  TF_ASSERT_OK(session2->Create(def_));
+  run(session2.get());
+  EXPECT_EQ(initial_size + 2, SharedKernelCache::Global()->size());
+
+  // The kernels outlive the session that created them.
+  session1.reset();
+  run(session2.get());
+  EXPECT_EQ(initial_size + 2, SharedKernelCache::Global()->size());
+  session2.reset();
+  EXPECT_EQ(initial_size, SharedKernelCache::Global()->size());
+}
+
+TEST(DirectSessionTest, DoesNotShareConstantKernelsAcrossPhysicalGPUs) {
+  {
+    std::unique_ptr<Session> session(NewSession(SessionOptions()));
+    std::vector<DeviceAttributes> devices;
+    TF_ASSERT_OK(session->ListDevices(&devices));
+    int num_gpus = 0;
+    for (const DeviceAttributes& device : devices) {
+      if (device.device_type() == DEVICE_GPU) ++num_gpus;
+    }
+    if (num_gpus < 2) {
+      LOG(INFO) << "Skipping test, which needs two GPUs";
+      return;
+    }
+  }
+
+  Graph g(OpRegistry::Global());
+  Tensor a_tensor(DT_FLOAT, TensorShape({2}));
+  test::FillValues<float>(&a_tensor, {1, 2});
+  Node* a = test::graph::Constant(&g, a_tensor);
+  a->set_assigned_device_name("/job:localhost/replica:0/task:0/gpu:0");
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+
+  // Both sessions name their only GPU "gpu:0", but they are different GPUs.
+  auto make_session = [&def](const string& visible_device_list) {
+    SessionOptions options;
+    options.config.mutable_gpu_options()->set_visible_device_list(
+        visible_device_list);
+    options.config.mutable_graph_options()
+        ->mutable_optimizer_options()
+        ->set_opt_level(OptimizerOptions::L0);
+    options.config.mutable_executor_options()->set_share_constant_kernels(
+        true);
+    std::unique_ptr<Session> session(NewSession(options));
+    TF_CHECK_OK(session->Create(def));
+    return session;
+  };
+  auto run = [&a](Session* session) {
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, {a->name() + ":0"}, {}, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    test::ExpectTensorEqual<float>(
+        test::AsTensor<float>({1, 2}, TensorShape({2})), outputs[0]);
+  };
+
+  const int64 initial_size = SharedKernelCache::Global()->size();
+  std::unique_ptr<Session> session1 = make_session("0");
+  run(session1.get());
+  EXPECT_EQ(initial_size + 1, SharedKernelCache::Global()->size());
+  std::unique_ptr<Session> session2 = make_session("1");
+  run(session2.get());
+  EXPECT_EQ(initial_size + 2, SharedKernelCache::Global()->size());
+
+  // A session on the same GPU as the first one shares its kernel.
+  std::unique_ptr<Session> session3 = make_session("0");
+  run(session3.get());
+  EXPECT_EQ(initial_size + 2, SharedKernelCache::Global()->size());
+}
+
+TEST(DirectSessionTest, CreatesKernelsOfLargeGraphsInParallel) {
+  // A chain long enough for its kernels to be created in parallel.
+  Graph graph(OpRegistry::Global());
+  Tensor zero(DT_FLOAT, TensorShape({}));
+  zero.scalar<float>()() = 0.0;
+  Node* n = test::graph::Constant(&graph, zero);
+  Tensor one(DT_FLOAT, TensorShape({}));
+  one.scalar<float>()() = 1.0;
+  for (int i = 0; i < 3000; ++i) {
+    n = test::graph::Add(&graph, n, test::graph::Constant(&graph, one));
+  }
+  GraphDef def;
+  test::graph::ToGraphDef(&graph, &def);
+
+  SessionOptions options;
+  options.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_opt_level(OptimizerOptions::L0);
+  std::unique_ptr<Session> session(NewSession(options));
+  TF_ASSERT_OK(session->Create(def));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run({}, {n->name() + ":0"}, {}, &outputs));
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_FLOAT_EQ(3000.0, outputs[0].scalar<float>()());
+}
+
 TEST_F(DirectSessionMinusAXTest, TwoCreateCallsFails) {
   Initialize({1, 2, 3, 4});
   auto session = CreateSession();
@@ -294,6 +479,44 @@ TEST_F(DirectSessionMinusAXTest, RunSimpleNetworkWithOpts) {
   EXPECT_EQ(run_metadata.step_stats().dev_stats_size(), 2);
 }
 
+TEST_F(DirectSessionMinusAXTest, RunSimpleNetworkWithSampledCompactTrace) {
+  Initialize({3, 2, -1, 0});
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  TF_ASSERT_OK(session->Create(def_));
+  std::vector<std::pair<string, Tensor>> inputs;
+  std::vector<string> output_names = {y_ + ":0"};
+  std::vector<string> target_nodes = {y_neg_};
+
+  RunOptions run_options;
+  run_options.set_trace_level(RunOptions::SOFTWARE_TRACE);
+  run_options.set_trace_sample_period(2);
+  run_options.set_compact_trace(true);
+  int num_traced_steps = 0;
+  for (int i = 0; i < 4; ++i) {
+    std::vector<Tensor> outputs;
+    RunMetadata run_metadata;
+    TF_ASSERT_OK(session->Run(run_options, inputs, output_names, target_nodes,
+                              &outputs, &run_metadata));
+    ASSERT_EQ(1, outputs.size());
+    EXPECT_FLOAT_EQ(5.0, outputs[0].matrix<float>()(0, 0));
+    if (run_metadata.step_stats().dev_stats_size() == 0) continue;
+    ++num_traced_steps;
+    EXPECT_EQ(run_metadata.step_stats().dev_stats_size(), 2);
+    for (const auto& dev_stats : run_metadata.step_stats().dev_stats()) {
+      ASSERT_GT(dev_stats.node_stats_size(), 0);
+      for (const auto& node_stats : dev_stats.node_stats()) {
+        EXPECT_FALSE(node_stats.node_name().empty());
+        EXPECT_GT(node_stats.all_start_micros(), 0);
+        EXPECT_EQ(0, node_stats.output_size());
+        EXPECT_TRUE(StringPiece(node_stats.timeline_label())
+                        .starts_with(node_stats.node_name() + " = "));
+      }
+    }
+  }
+  EXPECT_EQ(2, num_traced_steps);
+}
+
 TEST(DirectSessionTest, KeepsStateAcrossRunsOfSession) {
   GraphDef def;
   Graph g(OpRegistry::Global());
@@ -439,6 +662,83 @@ TEST(DirectSessionTest, DarthKernel) {
   EXPECT_TRUE(errors::IsInternal(s));
 }
 
+REGISTER_OP("AddOneIfStepArena")
+    .Input("x: float")
+    .Output("y: float")
+    .Doc("");
+
+// Outputs x + 1 if a scratch buffer scoped to the step comes from the step
+// arena, or x otherwise.
+class AddOneIfStepArenaOp : public OpKernel {
+ public:
+  explicit AddOneIfStepArenaOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+  void Compute(OpKernelContext* ctx) override {
+    AllocatorAttributes attr;
+    attr.set_scoped_to_step(true);
+    Tensor scratch;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(DT_FLOAT, TensorShape({16}),
+                                           &scratch, attr));
+    TensorDescription description;
+    scratch.FillDescription(&description);
+    const bool from_arena =
+        description.allocation_description().allocator_name() ==
+        "step_arena";
+    Tensor* y = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &y));
+    y->scalar<float>()() =
+        ctx->input(0).scalar<float>()() + (from_arena ? 1.0f : 0.0f);
+  }
+};
+REGISTER_KERNEL_BUILDER(Name("AddOneIfStepArena").Device(DEVICE_CPU),
+                        AddOneIfStepArenaOp);
+
+TEST(DirectSessionTest, StepArenaIsNotUsedInLoops) {
+  Graph g(OpRegistry::Global());
+  Tensor zero(DT_FLOAT, TensorShape({}));
+  zero.scalar<float>()() = 0.0;
+  Tensor one(DT_FLOAT, TensorShape({}));
+  one.scalar<float>()() = 1.0;
+  Tensor limit(DT_FLOAT, TensorShape({}));
+  limit.scalar<float>()() = 5.0;
+
+  // Outside of loops, scratch buffers come from the arena.
+  Node* outside =
+      test::graph::Unary(&g, "AddOneIfStepArena",
+                         test::graph::Constant(&g, zero, "outside_zero"));
+
+  // i = 0; while (i < 5) i = AddOneIfStepArena(i) + 1;
+  Node* enter = test::graph::Enter(&g, test::graph::Constant(&g, zero),
+                                   "loop");
+  Node* merge = test::graph::Merge(&g, enter, {"next"});
+  Node* limit_node = test::graph::Constant(&g, limit, "limit");
+  g.AddControlEdge(merge, limit_node);
+  Node* cond =
+      test::graph::LoopCond(&g, test::graph::Less(&g, merge, limit_node));
+  Node* switch_node = test::graph::Switch(&g, merge, cond);
+  Node* body = test::graph::Unary(&g, "AddOneIfStepArena",
+                                  test::graph::Identity(&g, switch_node, 1));
+  Node* one_node = test::graph::Constant(&g, one, "one");
+  g.AddControlEdge(merge, one_node);
+  Node* next =
+      test::graph::Next(&g, "next", test::graph::Add(&g, body, one_node));
+  g.AddEdge(next, 0, merge, 1);
+  Node* exit = test::graph::Exit(&g, switch_node);
+
+  GraphDef def;
+  test::graph::ToGraphDef(&g, &def);
+  SessionOptions options;
+  options.config.mutable_executor_options()->set_use_step_arena(true);
+  std::unique_ptr<Session> session(NewSession(options));
+  TF_ASSERT_OK(session->Create(def));
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session->Run({}, {outside->name() + ":0", exit->name() + ":0"},
+                            {}, &outputs));
+  ASSERT_EQ(2, outputs.size());
+  EXPECT_EQ(1.0, outputs[0].scalar<float>()());
+  // Each iteration added only 1, so the loop ran all 5 iterations.
+  EXPECT_EQ(5.0, outputs[1].scalar<float>()());
+}
+
 // Have the Darth op in the graph placed on GPU, but don't run it.
 TEST(DirectSessionTest, PlacePrunedGraph) {
   {
@@ -537,6 +837,119 @@ TEST(DirectSessionTest, PartialRunTest) {
   ASSERT_EQ(11.0 + 22.0, outputs[1].flat<float>()(0));
 }
 
+TEST(DirectSessionTest, StagedPartialRunTest) {
+  GraphDef def;
+  Graph g(OpRegistry::Global());
+
+  Tensor first_value(DT_FLOAT, TensorShape({}));
+  first_value.scalar<float>()() = 1.0;
+  Node* first_const = test::graph::Constant(&g, first_value);
+  Node* first_identity = test::graph::Identity(&g, first_const);
+
+  Tensor second_value(DT_FLOAT, TensorShape({}));
+  second_value.scalar<float>()() = 2.0;
+  Node* second_const = test::graph::Constant(&g, second_value);
+  Node* second_identity = test::graph::Identity(&g, second_const);
+
+  Node* third = test::graph::Add(&g, first_identity, second_identity);
+  Node* third_identity = test::graph::Identity(&g, third);
+
+  test::graph::ToGraphDef(&g, &def);
+
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  DirectSession* direct_session = static_cast<DirectSession*>(session.get());
+  TF_ASSERT_OK(session->Create(def));
+
+  // Feed first_const and fetch first_identity, then feed second_const and
+  // fetch third_identity and second_identity, in that order.
+  std::vector<DirectSession::PartialRunStage> stages(2);
+  stages[0].feed_names = {first_const->name()};
+  stages[0].fetch_names = {first_identity->name() + ":0"};
+  stages[1].feed_names = {second_const->name()};
+  stages[1].fetch_names = {third_identity->name() + ":0",
+                           second_identity->name() + ":0"};
+
+  Tensor value_11(DT_FLOAT, TensorShape({}));
+  value_11.scalar<float>()() = 11.0;
+  Tensor value_22(DT_FLOAT, TensorShape({}));
+  value_22.scalar<float>()() = 22.0;
+
+  for (int i = 0; i < 2; ++i) {
+    string handle;
+    TF_ASSERT_OK(direct_session->StagedPRunSetup(stages, {}, &handle));
+
+    // Stages run in order.
+    std::vector<Tensor> outputs;
+    Status s = direct_session->StagedPRun(handle, 1, {value_22}, &outputs);
+    EXPECT_TRUE(errors::IsInvalidArgument(s));
+
+    TF_ASSERT_OK(direct_session->StagedPRun(handle, 0, {value_11}, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    ASSERT_EQ(11.0, outputs[0].flat<float>()(0));
+
+    // A staged partial run can't be run with PRun().
+    s = session->PRun(handle, {{second_const->name(), value_22}},
+                      {second_identity->name() + ":0"}, &outputs);
+    EXPECT_TRUE(errors::IsInvalidArgument(s));
+
+    TF_ASSERT_OK(direct_session->StagedPRun(handle, 1, {value_22}, &outputs));
+    ASSERT_EQ(2, outputs.size());
+    ASSERT_EQ(11.0 + 22.0, outputs[0].flat<float>()(0));
+    ASSERT_EQ(22.0, outputs[1].flat<float>()(0));
+
+    // The partial run is done once its last stage has run.
+    s = direct_session->StagedPRun(handle, 1, {value_22}, &outputs);
+    EXPECT_TRUE(errors::IsInvalidArgument(s));
+  }
+}
+
+TEST(DirectSessionTest, StagedPartialRunChecksStagesUpFront) {
+  GraphDef def;
+  Graph g(OpRegistry::Global());
+
+  Tensor first_value(DT_FLOAT, TensorShape({}));
+  first_value.scalar<float>()() = 1.0;
+  Node* first_const = test::graph::Constant(&g, first_value);
+  Node* first_identity = test::graph::Identity(&g, first_const);
+
+  Tensor second_value(DT_FLOAT, TensorShape({}));
+  second_value.scalar<float>()() = 2.0;
+  Node* second_const = test::graph::Constant(&g, second_value);
+  Node* second_identity = test::graph::Identity(&g, second_const);
+
+  Node* third = test::graph::Add(&g, first_identity, second_identity);
+  Node* third_identity = test::graph::Identity(&g, third);
+
+  test::graph::ToGraphDef(&g, &def);
+
+  auto session = CreateSession();
+  ASSERT_TRUE(session != nullptr);
+  DirectSession* direct_session = static_cast<DirectSession*>(session.get());
+  TF_ASSERT_OK(session->Create(def));
+
+  // third_identity can't be fetched before second_const is fed.
+  std::vector<DirectSession::PartialRunStage> stages(2);
+  stages[0].feed_names = {first_const->name()};
+  stages[0].fetch_names = {third_identity->name() + ":0"};
+  stages[1].feed_names = {second_const->name()};
+  string handle;
+  Status s = direct_session->StagedPRunSetup(stages, {}, &handle);
+  ASSERT_TRUE(errors::IsInvalidArgument(s));
+  EXPECT_TRUE(StringPiece(s.error_message())
+                  .contains("can't be computed from the feeds"));
+
+  // Each feed belongs to one stage.
+  stages[0].fetch_names.clear();
+  stages[1].feed_names.push_back(first_const->name());
+  s = direct_session->StagedPRunSetup(stages, {}, &handle);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+
+  stages.clear();
+  s = direct_session->StagedPRunSetup(stages, {}, &handle);
+  EXPECT_TRUE(errors::IsInvalidArgument(s));
+}
+
 TEST(DirectSessionTest, PartialRunMissingFeed) {
   GraphDef def;
   Graph g(OpRegistry::Global());
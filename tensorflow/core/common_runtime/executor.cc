@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/executor.h"
 
+#include <algorithm>
 #include <atomic>
 #include <deque>
 #include <memory>
@@ -23,8 +24,12 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/common_runtime/costmodel_manager.h"
+#include "tensorflow/core/common_runtime/critical_path.h"
+#include "tensorflow/core/common_runtime/memory_planner.h"
 #include "tensorflow/core/common_runtime/pending_counts.h"
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
+#include "tensorflow/core/common_runtime/work_stealing_queue.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/cancellation.h"
@@ -41,6 +46,8 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/graph/edgeset.h"
+#include "tensorflow/core/grappler/clusters/utils.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
@@ -50,15 +57,22 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/manual_constructor.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/profile_utils/cpu_utils.h"
+#include "tensorflow/core/platform/profile_utils/perf_event_counters.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/tensor_slice_reader_cache.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 namespace {
@@ -66,6 +80,61 @@ namespace {
 // 1-D, 0 element tensor.
 static const Tensor* const kEmptyTensor = new Tensor;
 
+// Per-op metrics, recorded with LocalExecutorParams::export_op_metrics.
+auto* op_compute_usecs = monitoring::Sampler<2>::New(
+    {"/tensorflow/core/executor/op_compute_usecs",
+     "The time from the start of the computation of an op to its completion, "
+     "in microseconds.",
+     "op", "device"},
+    {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000,
+     50000, 100000, 200000, 500000, 1000000, 2000000, 5000000});
+
+auto* op_queueing_usecs = monitoring::Sampler<2>::New(
+    {"/tensorflow/core/executor/op_queueing_usecs",
+     "The time from an op becoming ready to the start of its computation, in "
+     "microseconds.",
+     "op", "device"},
+    {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000,
+     50000, 100000, 200000, 500000, 1000000});
+
+auto* op_output_bytes = monitoring::Sampler<2>::New(
+    {"/tensorflow/core/executor/op_output_bytes",
+     "The total size of the tensors output by an op, in bytes.", "op",
+     "device"},
+    {64, 256, 1024, 4096, 16384, 65536, 262144, 1048576, 4194304, 16777216,
+     67108864, 268435456, 1073741824});
+
+// Executor overhead metrics, recorded with
+// LocalExecutorParams::export_executor_stats.
+auto* executor_phase_usecs = monitoring::Counter<1>::New(
+    "/tensorflow/core/executor/phase_usecs",
+    "The time the executors spend in each phase of the processing of nodes "
+    "around their kernels, in microseconds.",
+    "phase");
+
+auto* executor_phase_count = monitoring::Counter<1>::New(
+    "/tensorflow/core/executor/phase_count",
+    "The number of times the executors run each phase of the processing of "
+    "nodes around their kernels.",
+    "phase");
+
+auto* executor_nodes = monitoring::Counter<1>::New(
+    "/tensorflow/core/executor/nodes",
+    "The number of nodes the executors schedule, either inline on the thread "
+    "that made them ready or dispatched to another thread.",
+    "scheduling");
+
+auto* executor_frames = monitoring::Counter<1>::New(
+    "/tensorflow/core/executor/frames",
+    "The number of frames the executors create and delete.", "event");
+
+auto* executor_max_ready_nodes = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/executor/max_ready_nodes",
+     "The largest number of nodes made ready at once (\"ready\"), and queued "
+     "to run inline on one thread (\"inline\"), in each step.",
+     "queue"},
+    {1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096});
+
 bool IsInitializationOp(const Node* node) {
   return node->op_def().allows_uninitialized_input();
 }
@@ -125,6 +194,24 @@ inline int64 NowInUsec() { return Env::Default()->NowMicros(); }
 
 void SetScheduled(NodeExecStats* nt, int64 t) { nt->set_scheduled_micros(t); }
 
+// The same timings, for the compact records of a StepStatsCollector.
+void SetAllStart(NodeExecRecord* nr) { nr->all_start_micros = NowInUsec(); }
+
+void SetOpStart(NodeExecRecord* nr) {
+  DCHECK_NE(nr->all_start_micros, 0);
+  nr->op_start_rel_micros = NowInUsec() - nr->all_start_micros;
+}
+
+void SetOpEnd(NodeExecRecord* nr) {
+  DCHECK_NE(nr->all_start_micros, 0);
+  nr->op_end_rel_micros = NowInUsec() - nr->all_start_micros;
+}
+
+void SetAllEnd(NodeExecRecord* nr) {
+  DCHECK_NE(nr->all_start_micros, 0);
+  nr->all_end_rel_micros = NowInUsec() - nr->all_start_micros;
+}
+
 void SetAllStart(NodeExecStats* nt) { nt->set_all_start_micros(NowInUsec()); }
 
 void SetOpStart(NodeExecStats* nt) {
@@ -347,6 +434,9 @@ class ExecutorImpl : public Executor {
     for (auto fiter : frame_info_) {
       delete fiter.second;
     }
+    // Tensors still using the plan or the recorder keep them alive.
+    if (memory_plan_ != nullptr) memory_plan_->Unref();
+    if (output_size_recorder_ != nullptr) output_size_recorder_->Unref();
     delete graph_;
   }
 
@@ -362,6 +452,53 @@ class ExecutorImpl : public Executor {
  private:
   friend class ExecutorState;
 
+  // Computes the initial node priorities for the PRIORITY scheduler from
+  // analytical cost estimates.
+  void InitializePriorities();
+
+  // Creates the kernels of all nodes, in parallel with
+  // params_.create_kernel_runner if it is set and the graph is large.
+  Status CreateKernels();
+
+  // Returns the current node priorities, or nullptr if the executor does
+  // not use the PRIORITY scheduler.
+  std::shared_ptr<const std::vector<int64>> priorities() const {
+    mutex_lock l(priorities_mu_);
+    return priorities_;
+  }
+
+  // Returns true iff the step about to start should measure node compute
+  // times.
+  bool StartPriorityStep() const {
+    return params_.priority_measurement_steps > 0 &&
+           num_priority_steps_started_.fetch_add(1) <
+               params_.priority_measurement_steps;
+  }
+
+  void RecordNodeCost(int id, int64 usecs) const {
+    measured_usecs_[id].fetch_add(usecs, std::memory_order_relaxed);
+    measured_counts_[id].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Called at the end of every step that measured node compute times. Once
+  // all measured steps are done, recomputes the priorities from the
+  // measurements, using the analytical estimates for nodes that were not
+  // measured (e.g. asynchronous kernels).
+  void FinishPriorityStep() const;
+
+  // Sets up the recording of output sizes for LocalExecutorParams::
+  // plan_memory, unless the graph contains loops, whose nodes run many
+  // times per step.
+  void InitializeMemoryPlanning();
+
+  // Called when a step starts. Returns a reference to the memory plan in
+  // "*plan" once there is one. Otherwise, the first step gets a reference
+  // to the recorder in "*recorder", and must call FinishMemoryRecording()
+  // when it is done.
+  void StartMemoryPlanStep(MemoryPlan** plan,
+                           OutputSizeRecorder** recorder) const;
+  void FinishMemoryRecording() const;
+
   struct ControlFlowInfo {
     gtl::FlatSet<string, HashStr> unique_frame_names;
     std::vector<string> frame_names;
@@ -417,6 +554,16 @@ class ExecutorImpl : public Executor {
   // A cached value of params_
   bool device_record_tensor_accesses_ = false;
 
+  // With LocalExecutorParams::export_op_metrics, the cells of the per-op
+  // metrics of every node, indexed by node id. Looked up once, so that steps
+  // don't go through the label maps of the metrics.
+  struct OpMetricCells {
+    monitoring::SamplerCell* compute_usecs = nullptr;
+    monitoring::SamplerCell* queueing_usecs = nullptr;
+    monitoring::SamplerCell* output_bytes = nullptr;
+  };
+  std::vector<OpMetricCells> op_metric_cells_;
+
   // Root nodes (with no in edges) that should form the initial ready queue
   std::vector<const Node*> root_nodes_;
 
@@ -425,6 +572,26 @@ class ExecutorImpl : public Executor {
   // the overhead of constructing it for each executor instance.
   gtl::FlatMap<string, FrameInfo*, HashStr> frame_info_;
 
+  // State of the PRIORITY scheduler, indexed by node id. The priority of a
+  // node is the cost (in microseconds) of the longest path from the node to
+  // the sink. Steps update it through the const ExecutorImpl they run.
+  std::vector<int64> estimated_costs_;
+  std::unique_ptr<std::atomic<int64>[]> measured_usecs_;
+  std::unique_ptr<std::atomic<int64>[]> measured_counts_;
+  mutable std::atomic<int64> num_priority_steps_started_{0};
+  mutable std::atomic<int64> num_priority_steps_finished_{0};
+  mutable mutex priorities_mu_;
+  mutable std::shared_ptr<const std::vector<int64>> priorities_
+      GUARDED_BY(priorities_mu_);
+
+  // State of the static memory plan. Both objects are owned by one
+  // reference each.
+  mutable mutex memory_plan_mu_;
+  mutable OutputSizeRecorder* output_size_recorder_
+      GUARDED_BY(memory_plan_mu_) = nullptr;
+  mutable bool memory_recording_started_ GUARDED_BY(memory_plan_mu_) = false;
+  mutable MemoryPlan* memory_plan_ GUARDED_BY(memory_plan_mu_) = nullptr;
+
   TF_DISALLOW_COPY_AND_ASSIGN(ExecutorImpl);
 };
 
@@ -619,8 +786,9 @@ Status ExecutorImpl::Initialize() {
     EnsureFrameInfo(it)->nodes = new std::vector<const Node*>;
   }
 
-  // Preprocess every node in the graph to create an instance of op
-  // kernel for each node.
+  TF_RETURN_IF_ERROR(CreateKernels());
+
+  // Preprocess every node in the graph.
   for (const Node* n : graph_->nodes()) {
     const int id = n->id();
     const string& frame_name = cf_info.frame_names[id];
@@ -637,13 +805,6 @@ Status ExecutorImpl::Initialize() {
     item->input_start = frame_info->total_inputs;
     frame_info->total_inputs += n->num_inputs();
 
-    Status s = params_.create_kernel(n->def(), &item->kernel);
-    if (!s.ok()) {
-      item->kernel = nullptr;
-      s = AttachDef(s, *n);
-      LOG(ERROR) << "Executor failed to create kernel. " << s;
-      return s;
-    }
     CHECK(item->kernel);
     item->kernel_is_expensive = item->kernel->IsExpensive();
     item->kernel_is_async = (item->kernel->AsAsync() != nullptr);
@@ -677,9 +838,192 @@ Status ExecutorImpl::Initialize() {
   // all nodes.
   InitializePending(graph_, cf_info);
 
+  if (params_.scheduler == ExecutorOptions::PRIORITY) {
+    InitializePriorities();
+  }
+
+  if (params_.plan_memory) {
+    InitializeMemoryPlanning();
+  }
+
+  if (params_.export_op_metrics) {
+    op_metric_cells_.resize(graph_->num_node_ids());
+    const string& device = params_.device->name();
+    for (const Node* n : graph_->nodes()) {
+      OpMetricCells& cells = op_metric_cells_[n->id()];
+      cells.compute_usecs = op_compute_usecs->GetCell(n->type_string(), device);
+      cells.queueing_usecs =
+          op_queueing_usecs->GetCell(n->type_string(), device);
+      cells.output_bytes = op_output_bytes->GetCell(n->type_string(), device);
+    }
+  }
+
   return gview_.SetAllocAttrs(graph_, params_.device);
 }
 
+namespace {
+
+// Graphs with fewer nodes have their kernels created sequentially.
+const int kMinNodesForParallelKernelCreation = 1024;
+
+// The number of nodes whose kernels are created by one closure at a time.
+const int kKernelCreationChunk = 128;
+
+// The progress of the parallel creation of the kernels of a graph. It is
+// shared with the closures, some of which may only start after the
+// executor is initialized, when they find no work left.
+struct KernelCreation {
+  KernelCreation(std::vector<const Node*> n, int num_chunks)
+      : nodes(std::move(n)), statuses(nodes.size()), done(num_chunks) {}
+
+  const std::vector<const Node*> nodes;
+  std::vector<Status> statuses;
+  std::atomic<int> next{0};
+  BlockingCounter done;  // Counts the chunks still to be created.
+};
+
+}  // namespace
+
+Status ExecutorImpl::CreateKernels() {
+  auto create = [this](const Node* n) {
+    NodeItem* item = gview_.node(n->id());
+    Status s = params_.create_kernel(n->def(), &item->kernel);
+    if (!s.ok()) {
+      item->kernel = nullptr;
+      s = AttachDef(s, *n);
+      LOG(ERROR) << "Executor failed to create kernel. " << s;
+    }
+    return s;
+  };
+  if (params_.create_kernel_runner == nullptr ||
+      graph_->num_nodes() < kMinNodesForParallelKernelCreation) {
+    for (const Node* n : graph_->nodes()) {
+      TF_RETURN_IF_ERROR(create(n));
+    }
+    return Status::OK();
+  }
+
+  std::vector<const Node*> nodes;
+  nodes.reserve(graph_->num_nodes());
+  for (const Node* n : graph_->nodes()) nodes.push_back(n);
+  const int num_nodes = nodes.size();
+  const int num_chunks =
+      (num_nodes + kKernelCreationChunk - 1) / kKernelCreationChunk;
+  auto creation =
+      std::make_shared<KernelCreation>(std::move(nodes), num_chunks);
+  auto work = [creation, create, num_nodes]() {
+    for (;;) {
+      const int start = creation->next.fetch_add(kKernelCreationChunk);
+      if (start >= num_nodes) return;
+      const int end = std::min(start + kKernelCreationChunk, num_nodes);
+      for (int i = start; i < end; ++i) {
+        creation->statuses[i] = create(creation->nodes[i]);
+      }
+      creation->done.DecrementCount();
+    }
+  };
+  int num_closures = params_.max_scheduler_workers > 0
+                         ? params_.max_scheduler_workers
+                         : port::NumSchedulableCPUs();
+  num_closures = std::min(num_closures, num_chunks - 1);
+  for (int i = 0; i < num_closures; ++i) {
+    params_.create_kernel_runner(work);
+  }
+  // The calling thread works too, so that the kernels are created even if
+  // all threads of the runner are busy.
+  work();
+  creation->done.Wait();
+
+  // Reports the error of the first node, as the sequential creation does.
+  for (const Status& s : creation->statuses) {
+    TF_RETURN_IF_ERROR(s);
+  }
+  return Status::OK();
+}
+
+void ExecutorImpl::InitializeMemoryPlanning() {
+  for (const Node* n : graph_->nodes()) {
+    if (IsEnter(n)) {
+      VLOG(1) << "Not planning memory for a graph with loops";
+      return;
+    }
+  }
+  mutex_lock l(memory_plan_mu_);
+  output_size_recorder_ = new OutputSizeRecorder(
+      *graph_, params_.device->GetAllocator(AllocatorAttributes()));
+}
+
+void ExecutorImpl::StartMemoryPlanStep(MemoryPlan** plan,
+                                       OutputSizeRecorder** recorder) const {
+  mutex_lock l(memory_plan_mu_);
+  if (memory_plan_ != nullptr) {
+    memory_plan_->Ref();
+    *plan = memory_plan_;
+  } else if (output_size_recorder_ != nullptr && !memory_recording_started_) {
+    memory_recording_started_ = true;
+    output_size_recorder_->Ref();
+    *recorder = output_size_recorder_;
+  }
+}
+
+void ExecutorImpl::FinishMemoryRecording() const {
+  OutputSizeRecorder* recorder;
+  {
+    mutex_lock l(memory_plan_mu_);
+    recorder = output_size_recorder_;
+    output_size_recorder_ = nullptr;
+  }
+  MemoryPlan* plan = MemoryPlan::Create(
+      *graph_, recorder->RecordedBuffers(*graph_),
+      params_.device->GetAllocator(AllocatorAttributes()));
+  recorder->Unref();
+  mutex_lock l(memory_plan_mu_);
+  memory_plan_ = plan;
+}
+
+void ExecutorImpl::InitializePriorities() {
+  const int num_ids = graph_->num_node_ids();
+  const DeviceProperties device =
+      grappler::GetDeviceInfo(params_.device->parsed_name());
+  estimated_costs_.assign(num_ids, 0);
+  measured_usecs_.reset(new std::atomic<int64>[num_ids]);
+  measured_counts_.reset(new std::atomic<int64>[num_ids]);
+  for (int id = 0; id < num_ids; ++id) {
+    measured_usecs_[id] = 0;
+    measured_counts_[id] = 0;
+  }
+  for (const Node* n : graph_->nodes()) {
+    estimated_costs_[n->id()] = EstimateNodeCostMicros(n, device);
+  }
+  auto priorities = std::make_shared<std::vector<int64>>();
+  ComputeCriticalPathLengths(
+      *graph_,
+      [this](const Node* n) { return estimated_costs_[n->id()]; },
+      priorities.get());
+  mutex_lock l(priorities_mu_);
+  priorities_ = std::move(priorities);
+}
+
+void ExecutorImpl::FinishPriorityStep() const {
+  if (num_priority_steps_finished_.fetch_add(1) + 1 !=
+      params_.priority_measurement_steps) {
+    return;
+  }
+  auto priorities = std::make_shared<std::vector<int64>>();
+  ComputeCriticalPathLengths(
+      *graph_,
+      [this](const Node* n) {
+        const int64 count = measured_counts_[n->id()].load();
+        if (count == 0) return estimated_costs_[n->id()];
+        return std::max<int64>(measured_usecs_[n->id()].load() / count, 1);
+      },
+      priorities.get());
+  VLOG(1) << "Updated node priorities from "
+          << params_.priority_measurement_steps << " measured steps";
+  mutex_lock l(priorities_mu_);
+  priorities_ = std::move(priorities);
+}
+
 Status GraphView::SetAllocAttrs(const Graph* g, const Device* device) {
   Status s;
   DeviceNameUtils::ParsedName local_dev_name = device->parsed_name();
@@ -776,6 +1120,145 @@ Status InferAllocAttr(const Node* n, const Node* dst,
   return s;
 }
 
+// The phases of the processing of a node that ExecutorOverheadStats times.
+enum ExecutorPhase {
+  PREPARE_INPUTS,
+  PROCESS_OUTPUTS,
+  PROPAGATE_OUTPUTS,
+  SCHEDULE_READY,
+  NUM_EXECUTOR_PHASES,
+};
+
+const char* const kExecutorPhaseNames[NUM_EXECUTOR_PHASES] = {
+    "prepare_inputs", "process_outputs", "propagate_outputs",
+    "schedule_ready"};
+
+// The overhead of the executor in one step, with
+// LocalExecutorParams::export_executor_stats. Updated concurrently by the
+// threads running the step, and exported to lib/monitoring when it is done.
+struct ExecutorOverheadStats {
+  ExecutorOverheadStats() {
+    for (int i = 0; i < NUM_EXECUTOR_PHASES; ++i) {
+      phase_cycles[i] = 0;
+      phase_count[i] = 0;
+    }
+  }
+
+  // Raises "*max" to "value".
+  static void UpdateMax(std::atomic<int64>* max, int64 value) {
+    int64 current = max->load(std::memory_order_relaxed);
+    while (value > current &&
+           !max->compare_exchange_weak(current, value,
+                                       std::memory_order_relaxed)) {
+    }
+  }
+
+  void Export() const;
+
+  std::atomic<int64> phase_cycles[NUM_EXECUTOR_PHASES];
+  std::atomic<int64> phase_count[NUM_EXECUTOR_PHASES];
+  std::atomic<int64> inline_nodes{0};
+  std::atomic<int64> dispatched_nodes{0};
+  std::atomic<int64> frames_created{0};
+  std::atomic<int64> frames_deleted{0};
+  std::atomic<int64> max_ready_nodes{0};
+  std::atomic<int64> max_inline_ready_nodes{0};
+};
+
+void ExecutorOverheadStats::Export() const {
+  const double usecs_per_cycle = profile_utils::CpuUtils::GetMicroSecPerClock();
+  for (int i = 0; i < NUM_EXECUTOR_PHASES; ++i) {
+    const int64 count = phase_count[i].load(std::memory_order_relaxed);
+    if (count == 0) continue;
+    executor_phase_count->GetCell(kExecutorPhaseNames[i])->IncrementBy(count);
+    if (usecs_per_cycle > 0) {
+      executor_phase_usecs->GetCell(kExecutorPhaseNames[i])
+          ->IncrementBy(static_cast<int64>(
+              phase_cycles[i].load(std::memory_order_relaxed) *
+              usecs_per_cycle));
+    }
+  }
+  executor_nodes->GetCell("inline")->IncrementBy(inline_nodes);
+  executor_nodes->GetCell("dispatched")->IncrementBy(dispatched_nodes);
+  executor_frames->GetCell("created")->IncrementBy(frames_created);
+  executor_frames->GetCell("deleted")->IncrementBy(frames_deleted);
+  executor_max_ready_nodes->GetCell("ready")->Add(max_ready_nodes);
+  executor_max_ready_nodes->GetCell("inline")->Add(max_inline_ready_nodes);
+}
+
+// Adds the clock cycles spent in its scope to a phase of "stats", unless
+// "stats" is null.
+class ScopedExecutorPhase {
+ public:
+  ScopedExecutorPhase(ExecutorOverheadStats* stats, ExecutorPhase phase)
+      : stats_(stats),
+        phase_(phase),
+        start_(stats ? profile_utils::CpuUtils::GetCurrentClockCycle() : 0) {}
+
+  ~ScopedExecutorPhase() {
+    if (stats_ == nullptr) return;
+    stats_->phase_cycles[phase_].fetch_add(
+        profile_utils::CpuUtils::GetCurrentClockCycle() - start_,
+        std::memory_order_relaxed);
+    stats_->phase_count[phase_].fetch_add(1, std::memory_order_relaxed);
+  }
+
+ private:
+  ExecutorOverheadStats* const stats_;
+  const ExecutorPhase phase_;
+  const uint64 start_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedExecutorPhase);
+};
+
+// Sets the counters of "stats" to the hardware events of the calling thread
+// in its scope, with LocalExecutorParams::count_kernel_cycles and
+// count_kernel_perf_events. Does nothing if "stats" is null.
+class ScopedKernelCounters {
+ public:
+  ScopedKernelCounters(NodeExecStats* stats, bool count_cycles,
+                       bool count_perf_events)
+      : stats_(stats), count_cycles_(stats && count_cycles) {
+    if (stats && count_perf_events) {
+      perf_counters_ = profile_utils::PerfEventCounters::ForCurrentThread();
+      if (perf_counters_ && !perf_counters_->Read(&start_counts_)) {
+        perf_counters_ = nullptr;
+      }
+    }
+    if (count_cycles_) {
+      start_cycles_ = profile_utils::CpuUtils::GetCurrentClockCycle();
+    }
+  }
+
+  ~ScopedKernelCounters() {
+    if (count_cycles_) {
+      stats_->mutable_counters()->set_cycles(
+          profile_utils::CpuUtils::GetCurrentClockCycle() - start_cycles_);
+    }
+    profile_utils::PerfEventCounters::Counts end_counts;
+    if (perf_counters_ && perf_counters_->Read(&end_counts)) {
+      NodeExecCounters* counters = stats_->mutable_counters();
+      counters->set_cpu_cycles(end_counts.cpu_cycles -
+                               start_counts_.cpu_cycles);
+      counters->set_instructions(end_counts.instructions -
+                                 start_counts_.instructions);
+      counters->set_cache_references(end_counts.cache_references -
+                                     start_counts_.cache_references);
+      counters->set_cache_misses(end_counts.cache_misses -
+                                 start_counts_.cache_misses);
+    }
+  }
+
+ private:
+  NodeExecStats* const stats_;
+  const bool count_cycles_;
+  uint64 start_cycles_ = 0;
+  const profile_utils::PerfEventCounters* perf_counters_ = nullptr;
+  profile_utils::PerfEventCounters::Counts start_counts_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedKernelCounters);
+};
+
 // The state associated with one invocation of ExecutorImpl::Run.
 // ExecutorState dispatches nodes when they become ready and keeps
 // track of how many predecessors of a node have not done (pending_).
@@ -1155,6 +1638,7 @@ class ExecutorState {
       }
     }
     bool empty() const { return ready_.empty(); }
+    size_t size() const { return ready_.size() - front_index_; }
     const TaggedNode* begin() const { return ready_.begin() + front_index_; }
     const TaggedNode* end() const { return ready_.end(); }
 
@@ -1163,6 +1647,17 @@ class ExecutorState {
     int front_index_;
   };
 
+  // A ready node waiting in the work-stealing queues, together with the
+  // time it was scheduled at (for step stats).
+  struct ScheduledNode {
+    ScheduledNode() : tagged_node(nullptr, nullptr, -1, false) {}
+    ScheduledNode(const TaggedNode& node, int64 usec)
+        : tagged_node(node), scheduled_usec(usec) {}
+
+    TaggedNode tagged_node;
+    int64 scheduled_usec = 0;
+  };
+
   struct AsyncState;
 
   const bool vlog_;  // true if VLOG_IS_ON(1). Used to check vlog cheaply.
@@ -1181,11 +1676,36 @@ class ExecutorState {
   // QUESTION: Make it a checkpoint::TensorSliceReaderCacheWrapper
   // instead of a pointer?  (avoids having to delete).
   checkpoint::TensorSliceReaderCacheWrapper* slice_reader_cache_;
+  // Not null iff LocalExecutorParams::use_step_arena applies to this step.
+  StepArenaAllocator* step_arena_allocator_ = nullptr;
+  // With LocalExecutorParams::plan_memory, at most one of the two is set:
+  // the plan serving node outputs, or the recorder measuring them.
+  MemoryPlan* memory_plan_ = nullptr;
+  OutputSizeRecorder* output_size_recorder_ = nullptr;
   FunctionCallFrame* call_frame_;
   const ExecutorImpl* impl_;
   CancellationManager* cancellation_manager_;
   Executor::Args::Runner runner_;
   bool sync_on_finish_;
+  const int max_intra_op_parallelism_;
+
+  // Non-null iff the executor uses the WORK_STEALING scheduler. The
+  // workers draining the queues hold references to them, since they may
+  // still be looking for work when this ExecutorState is deleted.
+  std::shared_ptr<WorkStealingQueues<ScheduledNode>> work_queues_;
+
+  // Non-null iff the executor uses the PRIORITY scheduler: the priority of
+  // each node, indexed by node id. A snapshot taken when the step starts.
+  std::shared_ptr<const std::vector<int64>> priorities_;
+  // True iff this step measures node compute times for the PRIORITY
+  // scheduler.
+  bool measure_node_costs_ = false;
+
+  // A cached value of impl_->params_.export_op_metrics.
+  bool export_op_metrics_ = false;
+
+  // Not null iff LocalExecutorParams::export_executor_stats is set.
+  std::unique_ptr<ExecutorOverheadStats> overhead_stats_;
 
   // Owned.
 
@@ -1231,8 +1751,9 @@ class ExecutorState {
   void CleanupFramesIterations(FrameState* frame, int64 iter,
                                TaggedNodeSeq* ready);
 
-  // Process a ready node in current thread.
-  void Process(TaggedNode node, int64 scheduled_usec);
+  // Process a ready node in current thread. "worker_id" is the id of the
+  // work-stealing worker running the node, or -1.
+  void Process(TaggedNode node, int64 scheduled_usec, int worker_id);
 
   // Before invoking item->kernel, fills in its "inputs".
   Status PrepareInputs(const NodeItem& item, Entry* first_input,
@@ -1245,21 +1766,38 @@ class ExecutorState {
   Status ProcessOutputs(const NodeItem& item, OpKernelContext* ctx,
                         EntryVector* outputs, NodeExecStats* stats);
 
+  // With export_op_metrics_, records the time from "scheduled_usecs" to
+  // "start_usecs" as the queueing delay of the node of "item".
+  void RecordOpQueueing(const NodeItem& item, int64 scheduled_usecs,
+                        int64 start_usecs);
+
+  // With export_op_metrics_, records the compute time since "start_usecs"
+  // and the size of "outputs" for the node of "item".
+  void RecordOpCompute(const NodeItem& item, int64 start_usecs,
+                       const EntryVector& outputs);
+
   // After processing the outputs, propagates the outputs to their dsts.
   // Contents of *outputs are left in an indeterminate state after
   // returning from this method.
   void PropagateOutputs(const TaggedNode& tagged_node, const NodeItem* item,
                         EntryVector* outputs, TaggedNodeSeq* ready);
 
-  // "node" just finishes. Takes ownership of "stats". Returns true if
-  // execution has completed.
+  // "node" just finishes. Takes ownership of "stats", and saves "record" if it
+  // is not null. Returns true if execution has completed.
   bool NodeDone(const Status& s, const Node* node, const TaggedNodeSeq& ready,
-                NodeExecStats* stats, TaggedNodeReadyQueue* inline_ready);
+                NodeExecStats* stats, NodeExecRecord* record,
+                TaggedNodeReadyQueue* inline_ready, int worker_id);
 
   // Schedule all the expensive nodes in 'ready', and put all the inexpensive
   // nodes in 'ready' into 'inline_ready'.
   void ScheduleReady(const TaggedNodeSeq& ready,
-                     TaggedNodeReadyQueue* inline_ready);
+                     TaggedNodeReadyQueue* inline_ready, int worker_id);
+
+  // Runs 'tagged_node' on some other thread: either by handing a closure to
+  // the runner, or by queueing it on the deque of 'worker_id' when the
+  // work-stealing scheduler is in use.
+  void Dispatch(const TaggedNode& tagged_node, int64 scheduled_usec,
+                int worker_id);
 
   // For debugging/logging only.
   inline void MaybeMarkCompleted(FrameState* frame, int64 iter, int64 id);
@@ -1305,10 +1843,43 @@ ExecutorState::ExecutorState(const Executor::Args& args, ExecutorImpl* impl)
       cancellation_manager_(args.cancellation_manager),
       runner_(args.runner),
       sync_on_finish_(args.sync_on_finish),
+      max_intra_op_parallelism_(args.max_intra_op_parallelism > 0
+                                    ? args.max_intra_op_parallelism
+                                    : kint32max),
       num_outstanding_ops_(0) {
   // We start the entire execution in iteration 0 of the root frame
   // so let us create the root frame and the state for iteration 0.
   // We assume root_frame_->frame_name.empty().
+  if (impl_->params_.scheduler == ExecutorOptions::WORK_STEALING) {
+    const int max_workers = impl_->params_.max_scheduler_workers > 0
+                                ? impl_->params_.max_scheduler_workers
+                                : port::NumSchedulableCPUs();
+    work_queues_ = WorkStealingQueues<ScheduledNode>::Create(
+        max_workers, runner_,
+        [this](const ScheduledNode& node, int worker_id) {
+          Process(node.tagged_node, node.scheduled_usec, worker_id);
+        });
+  }
+
+  if (impl_->params_.use_step_arena &&
+      impl_->params_.device->device_type() == DEVICE_CPU) {
+    step_arena_allocator_ = new StepArenaAllocator;
+  }
+
+  export_op_metrics_ = impl_->params_.export_op_metrics;
+  if (impl_->params_.export_executor_stats) {
+    overhead_stats_.reset(new ExecutorOverheadStats);
+  }
+
+  if (impl_->params_.scheduler == ExecutorOptions::PRIORITY) {
+    priorities_ = impl_->priorities();
+    measure_node_costs_ = impl_->StartPriorityStep();
+  }
+
+  if (impl_->params_.plan_memory) {
+    impl_->StartMemoryPlanStep(&memory_plan_, &output_size_recorder_);
+  }
+
   root_frame_ = new FrameState(impl_, 1);
   root_frame_->frame_id = 0;  // must be 0
   root_frame_->InitializeFrameInfo(root_frame_->frame_name);
@@ -1329,6 +1900,10 @@ ExecutorState::~ExecutorState() {
     it->Unref();
   }
   delete slice_reader_cache_;
+  // Buffers that are still alive keep the arena around.
+  if (step_arena_allocator_ != nullptr) step_arena_allocator_->Unref();
+  if (memory_plan_ != nullptr) memory_plan_->Unref();
+  if (output_size_recorder_ != nullptr) output_size_recorder_->Unref();
 }
 
 Status ExecutorImpl::BuildControlFlowInfo(const Graph* g,
@@ -1437,7 +2012,7 @@ void ExecutorState::RunAsync(Executor::DoneCallback done) {
     root_frame_->iterations[0]->outstanding_ops = ready.size();
     done_cb_ = std::move(done);
     // Schedule to run all the ready ops in thread pool.
-    ScheduleReady(ready, nullptr);
+    ScheduleReady(ready, nullptr, -1);
   }
 }
 
@@ -1449,7 +2024,8 @@ void ExecutorState::RunAsync(Executor::DoneCallback done) {
 // sync kernels because these vectors are kept on the stack.
 struct ExecutorState::AsyncState {
   AsyncState(const OpKernelContext::Params& p, const TaggedNode& _tagged_node,
-             const NodeItem* _item, Entry* _first_input, NodeExecStats* _stats)
+             const NodeItem* _item, Entry* _first_input, NodeExecStats* _stats,
+             const NodeExecRecord* _record)
       : saved_inputs(*p.inputs),
         saved_input_device_contexts(*p.input_device_contexts),
         saved_input_alloc_attrs(*p.input_alloc_attrs),
@@ -1460,7 +2036,9 @@ struct ExecutorState::AsyncState {
         // ParamsButClearingEigenGPUDevice does equivalent of
         //   params.eigen_gpu_device = nullptr;
         ctx(ParamsButClearingEigenGPUDevice(&params), item->num_outputs),
-        stats(_stats) {
+        stats(_stats),
+        record(_record ? *_record : NodeExecRecord()),
+        has_record(_record != nullptr) {
     params.inputs = &saved_inputs;
     params.input_device_contexts = &saved_input_device_contexts;
     params.input_alloc_attrs = &saved_input_alloc_attrs;
@@ -1475,6 +2053,10 @@ struct ExecutorState::AsyncState {
   Entry* first_input;
   OpKernelContext ctx;
   NodeExecStats* stats;
+  NodeExecRecord record;
+  const bool has_record;
+  // The start of the computation, with export_op_metrics_.
+  int64 op_metrics_start_usecs = 0;
 
  private:
   OpKernelContext::Params* ParamsButClearingEigenGPUDevice(
@@ -1486,11 +2068,15 @@ struct ExecutorState::AsyncState {
   }
 };
 
-void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
+void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec,
+                            int worker_id) {
   const GraphView& gview = impl_->gview_;
   TaggedNodeSeq ready;
   TaggedNodeReadyQueue inline_ready;
 
+  // Limits the intra-op parallelism of the kernels run on this thread.
+  ScopedPerThreadMaxParallelism parallelism_limit(max_intra_op_parallelism_);
+
   // Parameters passed to OpKernel::Compute.
   TensorValueVec inputs;
   DeviceContextVec input_device_contexts;
@@ -1518,6 +2104,10 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
 
   Status s;
   NodeExecStats* stats = nullptr;
+  // The compact record of the node, in "record_storage", if the collector is
+  // compact.
+  NodeExecRecord record_storage;
+  NodeExecRecord* record = nullptr;
   EntryVector outputs;
   bool completed = false;
   inline_ready.push_back(tagged_node);
@@ -1542,9 +2132,27 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
       params.op_device_context = device_context_map_[id];
     }
 
+    // The arena frees nothing before the step ends, so the buffers of nodes
+    // that run once per loop iteration would grow it with the number of
+    // iterations.
+    params.step_arena_allocator =
+        input_frame == root_frame_ ? step_arena_allocator_ : nullptr;
+
     params.track_allocations = false;
     stats = nullptr;
-    if (stats_collector_ && !tagged_node.is_dead) {
+    record = nullptr;
+    if (stats_collector_ && !tagged_node.is_dead &&
+        stats_collector_->compact()) {
+      // Compact records hold only the timings, and don't need allocations
+      // to be tracked.
+      record = &record_storage;
+      *record = NodeExecRecord();
+      record->device = &device->name();
+      record->node_name = &node->name();
+      record->node_type = &node->type_string();
+      record->scheduled_micros = scheduled_usec;
+      nodestats::SetAllStart(record);
+    } else if (stats_collector_ && !tagged_node.is_dead) {
       // track allocations if and only if we are collecting statistics
       params.track_allocations = true;
       stats = new NodeExecStats;
@@ -1573,8 +2181,11 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
     } else {
       // Prepares inputs.
       bool is_input_dead = false;
-      s = PrepareInputs(item, first_input, &inputs, &input_device_contexts,
-                        &input_alloc_attrs, &is_input_dead);
+      {
+        ScopedExecutorPhase phase(overhead_stats_.get(), PREPARE_INPUTS);
+        s = PrepareInputs(item, first_input, &inputs, &input_device_contexts,
+                          &input_alloc_attrs, &is_input_dead);
+      }
       if (!s.ok()) {
         // Clear inputs.
         int num_inputs = item.num_inputs;
@@ -1583,7 +2194,9 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         }
         MaybeMarkCompleted(input_frame, input_iter, id);
         // Continue to process the nodes in 'inline_ready'.
-        completed = NodeDone(s, item.node, ready, stats, &inline_ready);
+        completed =
+            NodeDone(s, item.node, ready, stats, record, &inline_ready,
+                     worker_id);
         continue;
       }
 
@@ -1593,6 +2206,11 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
       params.frame_iter = FrameAndIter(input_frame->frame_id, input_iter);
       params.is_input_dead = is_input_dead;
       params.output_attr_array = item.output_attrs();
+      if (memory_plan_ != nullptr) {
+        params.output_allocators = memory_plan_->output_allocators(id);
+      } else if (output_size_recorder_ != nullptr) {
+        params.output_allocators = output_size_recorder_->output_allocators(id);
+      }
 
       if (item.kernel_is_async) {
         // Asynchronous computes.
@@ -1600,11 +2218,14 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         DCHECK(async != nullptr);
         launched_asynchronously = true;
         AsyncState* state =
-            new AsyncState(params, tagged_node, &item, first_input, stats);
+            new AsyncState(params, tagged_node, &item, first_input, stats,
+                           record);
 
         auto done = [this, state]() {
           Device* device = impl_->params_.device;
           NodeExecStats* stats = state->stats;      // Shorthand
+          NodeExecRecord* record =
+              state->has_record ? &state->record : nullptr;  // Shorthand
           Entry* first_input = state->first_input;  // Shorthand
 
           if (vlog_) {
@@ -1612,8 +2233,17 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
                     << SummarizeNode(*state->item->node);
           }
           if (stats) nodestats::SetOpEnd(stats);
+          if (record) nodestats::SetOpEnd(record);
           EntryVector outputs;
-          Status s = ProcessOutputs(*state->item, &state->ctx, &outputs, stats);
+          Status s;
+          {
+            ScopedExecutorPhase phase(overhead_stats_.get(), PROCESS_OUTPUTS);
+            s = ProcessOutputs(*state->item, &state->ctx, &outputs, stats);
+          }
+          if (export_op_metrics_) {
+            RecordOpCompute(*state->item, state->op_metrics_start_usecs,
+                            outputs);
+          }
           if (stats) nodestats::SetMemory(stats, &state->ctx);
           // Clears inputs.
           const int num_inputs = state->item->num_inputs;
@@ -1626,6 +2256,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
           MaybeMarkCompleted(input_frame, input_iter, id);
           TaggedNodeSeq ready;
           if (s.ok()) {
+            ScopedExecutorPhase phase(overhead_stats_.get(), PROPAGATE_OUTPUTS);
             PropagateOutputs(state->tagged_node, state->item, &outputs, &ready);
           }
           outputs.clear();
@@ -1639,20 +2270,49 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
                                                  accessed);
           }
           bool completed =
-              NodeDone(s, state->item->node, ready, stats, nullptr);
+              NodeDone(s, state->item->node, ready, stats, record, nullptr, -1);
           delete state;
           if (completed) Finish();
         };
         if (stats) nodestats::SetOpStart(stats);
+        if (record) nodestats::SetOpStart(record);
+        if (export_op_metrics_) {
+          state->op_metrics_start_usecs = Env::Default()->NowMicros();
+          RecordOpQueueing(item, scheduled_usec, state->op_metrics_start_usecs);
+        }
         device->ComputeAsync(async, &state->ctx, done);
       } else {
         // Synchronous computes.
         OpKernelContext ctx(&params, item.num_outputs);
         if (stats) nodestats::SetOpStart(stats);
-        device->Compute(CHECK_NOTNULL(op_kernel), &ctx);
+        if (record) nodestats::SetOpStart(record);
+        const uint64 compute_start_usecs =
+            (measure_node_costs_ || export_op_metrics_)
+                ? Env::Default()->NowMicros()
+                : 0;
+        if (export_op_metrics_) {
+          RecordOpQueueing(item, scheduled_usec, compute_start_usecs);
+        }
+        {
+          ScopedKernelCounters counters(
+              stats, impl_->params_.count_kernel_cycles,
+              impl_->params_.count_kernel_perf_events);
+          device->Compute(CHECK_NOTNULL(op_kernel), &ctx);
+        }
+        if (measure_node_costs_) {
+          impl_->RecordNodeCost(
+              id, Env::Default()->NowMicros() - compute_start_usecs);
+        }
         if (stats) nodestats::SetOpEnd(stats);
+        if (record) nodestats::SetOpEnd(record);
 
-        s = ProcessOutputs(item, &ctx, &outputs, stats);
+        {
+          ScopedExecutorPhase phase(overhead_stats_.get(), PROCESS_OUTPUTS);
+          s = ProcessOutputs(item, &ctx, &outputs, stats);
+        }
+        if (export_op_metrics_) {
+          RecordOpCompute(item, compute_start_usecs, outputs);
+        }
         if (s.ok() && impl_->device_record_tensor_accesses_) {
           // Get the list of all tensors accessed during the execution
           ctx.retrieve_accessed_tensors(&accessed_tensors);
@@ -1671,6 +2331,7 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
       MaybeMarkCompleted(input_frame, input_iter, id);
       // Propagates outputs.
       if (s.ok()) {
+        ScopedExecutorPhase phase(overhead_stats_.get(), PROPAGATE_OUTPUTS);
         PropagateOutputs(tagged_node, &item, &outputs, &ready);
       }
       outputs.clear();
@@ -1679,11 +2340,13 @@ void ExecutorState::Process(TaggedNode tagged_node, int64 scheduled_usec) {
         // device_context is set above in synchronous computes
         device->ConsumeListOfAccessedTensors(device_context, accessed_tensors);
       }
-      if (stats) {
+      if (stats || record || export_op_metrics_) {
         scheduled_usec = nodestats::NowInUsec();
       }
       // Postprocess.
-      completed = NodeDone(s, item.node, ready, stats, &inline_ready);
+      completed =
+          NodeDone(s, item.node, ready, stats, record, &inline_ready,
+                   worker_id);
     }
   }  // while !inline_ready.empty()
 
@@ -1770,6 +2433,31 @@ Status ExecutorState::PrepareInputs(const NodeItem& item, Entry* first_input,
   return Status::OK();
 }
 
+void ExecutorState::RecordOpQueueing(const NodeItem& item,
+                                     int64 scheduled_usecs,
+                                     int64 start_usecs) {
+  // Nodes run inline right after the previous one may not have a scheduled
+  // time.
+  if (scheduled_usecs <= 0) return;
+  impl_->op_metric_cells_[item.node->id()].queueing_usecs->Add(
+      start_usecs - scheduled_usecs);
+}
+
+void ExecutorState::RecordOpCompute(const NodeItem& item, int64 start_usecs,
+                                    const EntryVector& outputs) {
+  const ExecutorImpl::OpMetricCells& cells =
+      impl_->op_metric_cells_[item.node->id()];
+  cells.compute_usecs->Add(Env::Default()->NowMicros() - start_usecs);
+  int64 output_bytes = 0;
+  for (const Entry& output : outputs) {
+    // Reference outputs only forward existing tensors.
+    if (output.val_field_is_set) {
+      output_bytes += output.val->TotalBytes();
+    }
+  }
+  cells.output_bytes->Add(output_bytes);
+}
+
 Status ExecutorState::ProcessOutputs(const NodeItem& item, OpKernelContext* ctx,
                                      EntryVector* outputs,
                                      NodeExecStats* stats) {
@@ -1996,7 +2684,14 @@ void ExecutorState::PropagateOutputs(const TaggedNode& tagged_node,
 
 bool ExecutorState::NodeDone(const Status& s, const Node* node,
                              const TaggedNodeSeq& ready, NodeExecStats* stats,
-                             TaggedNodeReadyQueue* inline_ready) {
+                             NodeExecRecord* record,
+                             TaggedNodeReadyQueue* inline_ready,
+                             int worker_id) {
+  if (record && !IsSend(node) && !IsRecv(node)) {
+    // Like below, only record non-transfer nodes.
+    nodestats::SetAllEnd(record);
+    stats_collector_->SaveRecord(*record);
+  }
   if (stats) {
     nodestats::SetAllEnd(stats);
     if (!SetTimelineLabel(node, stats)) {
@@ -2036,39 +2731,69 @@ bool ExecutorState::NodeDone(const Status& s, const Node* node,
 
   // Schedule the ready nodes in 'ready'.
   if (s.ok()) {
-    ScheduleReady(ready, inline_ready);
+    ScheduleReady(ready, inline_ready, worker_id);
   }
   return completed;
 }
 
 void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
-                                  TaggedNodeReadyQueue* inline_ready) {
+                                  TaggedNodeReadyQueue* inline_ready,
+                                  int worker_id) {
   if (ready.empty()) return;
+  ScopedExecutorPhase phase(overhead_stats_.get(), SCHEDULE_READY);
+  if (overhead_stats_) {
+    ExecutorOverheadStats::UpdateMax(&overhead_stats_->max_ready_nodes,
+                                     ready.size());
+  }
 
   int64 scheduled_usec = 0;
-  if (stats_collector_) {
+  if (stats_collector_ || export_op_metrics_) {
     scheduled_usec = nodestats::NowInUsec();
   }
+
+  // With the PRIORITY scheduler, consider the nodes on the longest
+  // remaining paths first: they are dispatched first, and the most critical
+  // expensive node is the one kept for this thread.
+  const TaggedNodeSeq* nodes = &ready;
+  TaggedNodeSeq sorted;
+  if (priorities_ != nullptr && ready.size() > 1) {
+    sorted = ready;
+    const std::vector<int64>& priority = *priorities_;
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [&priority](const TaggedNode& a, const TaggedNode& b) {
+                       return priority[a.node->id()] > priority[b.node->id()];
+                     });
+    nodes = &sorted;
+  }
+
   if (inline_ready == nullptr) {
     // Schedule to run all the ready ops in thread pool.
-    for (auto& tagged_node : ready) {
-      runner_([=]() { Process(tagged_node, scheduled_usec); });
+    for (auto& tagged_node : *nodes) {
+      Dispatch(tagged_node, scheduled_usec, worker_id);
     }
     return;
   }
   const GraphView& gview = impl_->gview_;
   const TaggedNode* curr_expensive_node = nullptr;
-  for (auto& tagged_node : ready) {
+  for (auto& tagged_node : *nodes) {
     const NodeItem& item = *gview.node(tagged_node.node->id());
     if (tagged_node.is_dead || !item.kernel_is_expensive) {
       // Inline this inexpensive node.
       inline_ready->push_back(tagged_node);
+      if (overhead_stats_) {
+        overhead_stats_->inline_nodes.fetch_add(1, std::memory_order_relaxed);
+      }
+    } else if (priorities_ != nullptr) {
+      if (curr_expensive_node) {
+        Dispatch(tagged_node, scheduled_usec, worker_id);
+      } else {
+        curr_expensive_node = &tagged_node;
+      }
     } else {
       if (curr_expensive_node) {
         // Dispatch to another thread since there is plenty of work to
         // do for this thread.
-        runner_(std::bind(&ExecutorState::Process, this, *curr_expensive_node,
-                          scheduled_usec));
+        Dispatch(*curr_expensive_node, scheduled_usec, worker_id);
       }
       curr_expensive_node = &tagged_node;
     }
@@ -2077,13 +2802,34 @@ void ExecutorState::ScheduleReady(const TaggedNodeSeq& ready,
     if (inline_ready->empty()) {
       // Tail recursion optimization
       inline_ready->push_back(*curr_expensive_node);
+      if (overhead_stats_) {
+        overhead_stats_->inline_nodes.fetch_add(1, std::memory_order_relaxed);
+      }
     } else {
       // There are inline nodes to run already. We dispatch this expensive
       // node to other thread.
-      runner_(std::bind(&ExecutorState::Process, this, *curr_expensive_node,
-                        scheduled_usec));
+      Dispatch(*curr_expensive_node, scheduled_usec, worker_id);
     }
   }
+  if (overhead_stats_) {
+    ExecutorOverheadStats::UpdateMax(&overhead_stats_->max_inline_ready_nodes,
+                                     inline_ready->size());
+  }
+}
+
+void ExecutorState::Dispatch(const TaggedNode& tagged_node,
+                             int64 scheduled_usec, int worker_id) {
+  if (overhead_stats_) {
+    overhead_stats_->dispatched_nodes.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (work_queues_) {
+    // The node stays in this worker's deque, where it is picked up by this
+    // thread once it runs out of inline work, or stolen by an idle worker.
+    work_queues_->Push(ScheduledNode(tagged_node, scheduled_usec), worker_id);
+  } else {
+    runner_(std::bind(&ExecutorState::Process, this, tagged_node,
+                      scheduled_usec, -1));
+  }
 }
 
 inline void ExecutorState::MaybeMarkCompleted(FrameState* frame, int64 iter,
@@ -2218,6 +2964,13 @@ void ExecutorState::DumpState() {
 }
 
 void ExecutorState::Finish() {
+  if (measure_node_costs_) {
+    impl_->FinishPriorityStep();
+  }
+  if (output_size_recorder_ != nullptr) {
+    impl_->FinishMemoryRecording();
+  }
+  if (overhead_stats_) overhead_stats_->Export();
   mu_.lock();
   auto status = status_;
   auto done_cb = std::move(done_cb_);
@@ -2284,12 +3037,19 @@ void ExecutorState::FindOrCreateChildFrame(FrameState* frame, int64 iter,
       outstanding_frames_[child_name] = temp;
       *child = temp;
       temp = nullptr;
+      if (overhead_stats_) {
+        overhead_stats_->frames_created.fetch_add(1,
+                                                  std::memory_order_relaxed);
+      }
     }
   }
   delete temp;  // Not used so delete it.
 }
 
 void ExecutorState::DeleteFrame(FrameState* frame, TaggedNodeSeq* ready) {
+  if (overhead_stats_) {
+    overhead_stats_->frames_deleted.fetch_add(1, std::memory_order_relaxed);
+  }
   // First, propagate dead_exits (if any) to the parent frame.
   FrameState* parent_frame = frame->parent_frame;
   int64 parent_iter = frame->parent_iter;
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 
 namespace tensorflow {
 
@@ -93,6 +94,10 @@ class Executor {
     // If true, calls Sync() on the device.
     bool sync_on_finish = false;
 
+    // If positive, limits the intra-op parallelism of the step's kernels. See
+    // RunOptions.max_intra_op_parallelism.
+    int max_intra_op_parallelism = 0;
+
     typedef std::function<void()> Closure;
     typedef std::function<void(Closure)> Runner;
     Runner runner = nullptr;
@@ -140,7 +145,54 @@ struct LocalExecutorParams {
   std::function<Status(const NodeDef&, OpKernel**)> create_kernel;
   std::function<void(OpKernel*)> delete_kernel;
 
+  // If set, the kernels of large graphs are created in parallel, by up to
+  // max_scheduler_workers closures passed to this runner and the calling
+  // thread, when the executor is initialized. create_kernel must then be
+  // thread-safe.
+  Executor::Args::Runner create_kernel_runner = nullptr;
+
   Executor::Args::NodeOutputsCallback node_outputs_cb;
+
+  // The policy used to schedule ready nodes.
+  ExecutorOptions::SchedulerType scheduler = ExecutorOptions::DEFAULT;
+
+  // With the WORK_STEALING scheduler, the maximum number of closures the
+  // executor keeps outstanding in Args::runner for a step. It should
+  // normally be the number of threads backing the runner. 0 means
+  // port::NumSchedulableCPUs().
+  int max_scheduler_workers = 0;
+
+  // With the PRIORITY scheduler, the number of steps for which node compute
+  // times are measured before priorities are recomputed from them.
+  int priority_measurement_steps = 0;
+
+  // If true and the device is a CPU, every step allocates buffers requested
+  // with AllocatorAttributes::scoped_to_step() from a StepArenaAllocator.
+  // Nodes in loop frames allocate them from the device as usual.
+  bool use_step_arena = false;
+
+  // If true, the sizes of node outputs are recorded during the first step,
+  // and later steps allocate them at precomputed offsets of one slab (see
+  // memory_planner.h).
+  bool plan_memory = false;
+
+  // If true, every node updates the per-op compute time, queueing delay and
+  // output size histograms of lib/monitoring, labelled by op type and device.
+  bool export_op_metrics = false;
+
+  // If true, every step measures the time the executor spends preparing
+  // inputs, processing and propagating outputs and scheduling ready nodes,
+  // counts the nodes run inline and dispatched and the frames created and
+  // deleted, and exports them to lib/monitoring when it is done.
+  bool export_executor_stats = false;
+
+  // If true, steps that collect stats record the time stamp counter cycles
+  // of every synchronous kernel in NodeExecStats.counters. With
+  // count_kernel_perf_events, they also record the CPU cycles, instructions,
+  // and cache references and misses of the thread running the kernel, when
+  // profile_utils::PerfEventCounters are available.
+  bool count_kernel_cycles = false;
+  bool count_kernel_perf_events = false;
 };
 ::tensorflow::Status NewLocalExecutor(const LocalExecutorParams& params,
                                       const Graph* graph, Executor** executor);
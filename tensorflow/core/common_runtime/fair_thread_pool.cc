@@ -0,0 +1,125 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/fair_thread_pool.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+auto* queueing_delay_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/fair_thread_pool/queueing_delay_usecs",
+     "The time closures wait for a thread of a shared fair thread pool, in "
+     "microseconds.",
+     "client"},
+    {10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000,
+     200000, 500000, 1000000});
+
+}  // namespace
+
+FairThreadPool::FairThreadPool(Env* env, const string& name, int num_threads)
+    : env_(env), pool_(env, name, num_threads) {}
+
+FairThreadPool::FairThreadPool(Env* env, const ThreadOptions& thread_options,
+                               const string& name, int num_threads,
+                               bool low_latency_hint)
+    : env_(env),
+      pool_(env, thread_options, name, num_threads, low_latency_hint) {}
+
+FairThreadPool::~FairThreadPool() {
+  mutex_lock l(mu_);
+  while (!clients_.empty()) {
+    clients_cv_.wait(l);
+  }
+}
+
+std::unique_ptr<FairThreadPool::Client> FairThreadPool::NewClient(
+    const string& label, double weight) {
+  CHECK_GT(weight, 0) << "Client " << label << " of a FairThreadPool";
+  std::unique_ptr<Client> client(new Client(this, label, weight));
+  mutex_lock l(mu_);
+  clients_.push_back(client.get());
+  return client;
+}
+
+void FairThreadPool::RemoveClient(Client* client) {
+  mutex_lock l(mu_);
+  while (client->num_pending_ > 0) {
+    client->done_cv_.wait(l);
+  }
+  clients_.erase(std::find(clients_.begin(), clients_.end(), client));
+  clients_cv_.notify_all();
+}
+
+void FairThreadPool::Enqueue(Client* client, std::function<void()> fn) {
+  {
+    mutex_lock l(mu_);
+    if (client->queue_.empty()) {
+      client->virtual_start_ = std::max(client->virtual_start_, virtual_time_);
+    }
+    client->queue_.push_back({std::move(fn), env_->NowMicros()});
+    ++client->num_pending_;
+  }
+  pool_.Schedule([this]() { RunNext(); });
+}
+
+void FairThreadPool::RunNext() {
+  Client* next = nullptr;
+  Item item;
+  {
+    mutex_lock l(mu_);
+    // Ties go to the client created first.
+    for (Client* client : clients_) {
+      if (!client->queue_.empty() &&
+          (next == nullptr || client->virtual_start_ < next->virtual_start_)) {
+        next = client;
+      }
+    }
+    // There is one RunNext() per enqueued closure, so some client has one.
+    DCHECK(next != nullptr);
+    if (next == nullptr) return;
+    item = std::move(next->queue_.front());
+    next->queue_.pop_front();
+    virtual_time_ = next->virtual_start_;
+    next->virtual_start_ += 1.0 / next->weight_;
+  }
+  next->queueing_delay_->Add(env_->NowMicros() - item.enqueue_micros);
+  item.fn();
+  mutex_lock l(mu_);
+  if (--next->num_pending_ == 0) {
+    // Notified under mu_, since the client may be destroyed as soon as the
+    // lock is released.
+    next->done_cv_.notify_all();
+  }
+}
+
+FairThreadPool::Client::Client(FairThreadPool* pool, const string& label,
+                               double weight)
+    : pool_(pool),
+      label_(label),
+      weight_(weight),
+      queueing_delay_(queueing_delay_usecs->GetCell(label)) {}
+
+FairThreadPool::Client::~Client() { pool_->RemoveClient(this); }
+
+void FairThreadPool::Client::Schedule(std::function<void()> fn) {
+  pool_->Enqueue(this, std::move(fn));
+}
+
+}  // namespace tensorflow
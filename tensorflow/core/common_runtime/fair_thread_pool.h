@@ -0,0 +1,139 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_FAIR_THREAD_POOL_H_
+#define TENSORFLOW_COMMON_RUNTIME_FAIR_THREAD_POOL_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A thread pool shared by several clients (e.g. the sessions of a process),
+// each with its own queue of closures and a weight. When the threads are
+// overloaded, they are divided between the clients with pending closures in
+// proportion to the clients' weights, rather than in the FIFO order of a
+// plain thread::ThreadPool, so a single busy client cannot starve the others.
+//
+// The next closure to run is chosen by start-time fair queueing: every client
+// carries a virtual start time, the client with the smallest one runs next
+// and its virtual start time then advances by 1 / weight. A client that was
+// idle resumes at the current virtual time, so it cannot save up credit.
+//
+// The time each closure waits for a thread is exported to the
+// "/tensorflow/core/fair_thread_pool/queueing_delay_usecs" metric, labeled
+// with the client's label.
+//
+// This class is thread-safe.
+class FairThreadPool {
+ public:
+  class Client;
+
+  // Creates a pool of "num_threads" threads named "name". The threads are
+  // started with "thread_options", and spin for work before blocking if
+  // "low_latency_hint" is true, like for thread::ThreadPool.
+  FairThreadPool(Env* env, const string& name, int num_threads);
+  FairThreadPool(Env* env, const ThreadOptions& thread_options,
+                 const string& name, int num_threads, bool low_latency_hint);
+
+  // Waits for all the clients to go away.
+  ~FairThreadPool();
+
+  // Returns a new client with the given "weight", which must be positive.
+  // "label" identifies the client in the queueing delay metric. The client
+  // must be destroyed before the pool.
+  std::unique_ptr<Client> NewClient(const string& label, double weight);
+
+  // The underlying threads. Closures scheduled on it directly bypass the fair
+  // queueing; it is exposed for thread::ThreadPool-based interfaces such as
+  // NumThreads().
+  thread::ThreadPool* pool() { return &pool_; }
+
+  int NumThreads() const { return pool_.NumThreads(); }
+
+ private:
+  struct Item {
+    std::function<void()> fn;
+    uint64 enqueue_micros;
+  };
+
+  void Enqueue(Client* client, std::function<void()> fn);
+
+  // Runs the closure of the client with the smallest virtual start time.
+  // Scheduled on pool_ once per enqueued closure.
+  void RunNext();
+
+  void RemoveClient(Client* client);
+
+  Env* const env_;
+
+  mutex mu_;
+  condition_variable clients_cv_;
+  std::vector<Client*> clients_ GUARDED_BY(mu_);
+  // The virtual start time of the last closure dispatched.
+  double virtual_time_ GUARDED_BY(mu_) = 0;
+
+  // Declared last so that its threads are joined before mu_ goes away.
+  thread::ThreadPool pool_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FairThreadPool);
+};
+
+// A client's view of a FairThreadPool.
+class FairThreadPool::Client {
+ public:
+  // Waits for the closures scheduled by this client to finish.
+  ~Client();
+
+  // Schedules "fn" to run on the pool's threads.
+  void Schedule(std::function<void()> fn);
+
+  const string& label() const { return label_; }
+  double weight() const { return weight_; }
+
+ private:
+  friend class FairThreadPool;
+
+  Client(FairThreadPool* pool, const string& label, double weight);
+
+  FairThreadPool* const pool_;
+  const string label_;
+  const double weight_;
+  monitoring::SamplerCell* const queueing_delay_;
+
+  // Guarded by pool_->mu_.
+  std::deque<Item> queue_;
+  double virtual_start_ = 0;
+  // The number of closures queued or running.
+  int64 num_pending_ = 0;
+  condition_variable done_cv_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(Client);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_FAIR_THREAD_POOL_H_
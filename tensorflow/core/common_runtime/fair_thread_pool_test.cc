@@ -0,0 +1,122 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/fair_thread_pool.h"
+
+#include <atomic>
+#include <string>
+
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(FairThreadPoolTest, RunsAllClosures) {
+  FairThreadPool pool(Env::Default(), "test", 4);
+  EXPECT_EQ(4, pool.NumThreads());
+  std::atomic<int> count(0);
+  {
+    std::unique_ptr<FairThreadPool::Client> a = pool.NewClient("a", 1);
+    std::unique_ptr<FairThreadPool::Client> b = pool.NewClient("b", 2);
+    for (int i = 0; i < 100; ++i) {
+      a->Schedule([&count]() { ++count; });
+      b->Schedule([&count]() { ++count; });
+    }
+    // Destroying the clients waits for their closures.
+  }
+  EXPECT_EQ(200, count);
+}
+
+TEST(FairThreadPoolTest, SharesThreadsByWeight) {
+  FairThreadPool pool(Env::Default(), "test", 1);
+  std::unique_ptr<FairThreadPool::Client> gate = pool.NewClient("gate", 1);
+  std::unique_ptr<FairThreadPool::Client> a = pool.NewClient("a", 1);
+  std::unique_ptr<FairThreadPool::Client> b = pool.NewClient("b", 3);
+
+  // Occupy the only thread while both clients queue up work.
+  Notification started;
+  Notification release;
+  gate->Schedule([&started, &release]() {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  started.WaitForNotification();
+
+  mutex mu;
+  string order;
+  for (int i = 0; i < 4; ++i) {
+    a->Schedule([&mu, &order]() {
+      mutex_lock l(mu);
+      order += "a";
+    });
+    b->Schedule([&mu, &order]() {
+      mutex_lock l(mu);
+      order += "b";
+    });
+  }
+  release.Notify();
+  a.reset();
+  b.reset();
+
+  // "b" gets three turns for each of "a"'s until it runs out of work.
+  EXPECT_EQ("abbbabaa", order);
+}
+
+TEST(FairThreadPoolTest, IdleClientDoesNotSaveUpCredit) {
+  FairThreadPool pool(Env::Default(), "test", 1);
+  std::unique_ptr<FairThreadPool::Client> gate = pool.NewClient("gate", 1);
+  std::unique_ptr<FairThreadPool::Client> a = pool.NewClient("a", 1);
+  std::unique_ptr<FairThreadPool::Client> b = pool.NewClient("b", 1);
+
+  // "b" runs alone for a while, then "a" joins.
+  for (int i = 0; i < 10; ++i) {
+    Notification done;
+    b->Schedule([&done]() { done.Notify(); });
+    done.WaitForNotification();
+  }
+
+  Notification started;
+  Notification release;
+  gate->Schedule([&started, &release]() {
+    started.Notify();
+    release.WaitForNotification();
+  });
+  started.WaitForNotification();
+
+  mutex mu;
+  string order;
+  for (int i = 0; i < 3; ++i) {
+    b->Schedule([&mu, &order]() {
+      mutex_lock l(mu);
+      order += "b";
+    });
+    a->Schedule([&mu, &order]() {
+      mutex_lock l(mu);
+      order += "a";
+    });
+  }
+  release.Notify();
+  a.reset();
+  b.reset();
+
+  // "a" resumes at the current virtual time and alternates with "b", rather
+  // than running all its closures first to make up for the ten it missed.
+  // (It goes first, as "b" was already charged for the closure it ran last.)
+  EXPECT_EQ("aababb", order);
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -29,6 +29,10 @@ GPUBFCAllocator::GPUBFCAllocator(int device_id, size_t total_memory,
           new GPUMemAllocator(
               GPUMachineManager()->ExecutorForDevice(device_id).ValueOrDie()),
           total_memory, gpu_options.allow_growth(),
-          strings::StrCat("GPU_", device_id, "_bfc")) {}
+          strings::StrCat("GPU_", device_id, "_bfc"),
+          // Thread caches don't know about streams.
+          gpu_options.stream_ordered_allocation()
+              ? 0
+              : gpu_options.bfc_thread_cache_bytes()) {}
 
 }  // namespace tensorflow
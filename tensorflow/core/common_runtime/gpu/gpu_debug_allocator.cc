@@ -138,6 +138,10 @@ void GPUDebugAllocator::GetStats(AllocatorStats* stats) {
   base_allocator_->GetStats(stats);
 }
 
+void GPUDebugAllocator::RecordScratchBytes(int64 num_bytes) {
+  base_allocator_->RecordScratchBytes(num_bytes);
+}
+
 bool GPUDebugAllocator::CheckHeader(void* ptr) {
   return CheckMask(stream_exec_, static_cast<char*>(ptr) - MASK_BYTES,
                    before_mask);
@@ -210,4 +214,8 @@ void GPUNanResetAllocator::GetStats(AllocatorStats* stats) {
   base_allocator_->GetStats(stats);
 }
 
+void GPUNanResetAllocator::RecordScratchBytes(int64 num_bytes) {
+  base_allocator_->RecordScratchBytes(num_bytes);
+}
+
 }  // namespace tensorflow
@@ -44,6 +44,7 @@ class GPUDebugAllocator : public VisitableAllocator {
   size_t AllocatedSize(void* ptr) override;
   int64 AllocationId(void* ptr) override;
   void GetStats(AllocatorStats* stats) override;
+  void RecordScratchBytes(int64 num_bytes) override;
 
   // For testing.
   bool CheckHeader(void* ptr);
@@ -72,6 +73,7 @@ class GPUNanResetAllocator : public VisitableAllocator {
   size_t RequestedSize(void* ptr) override;
   size_t AllocatedSize(void* ptr) override;
   void GetStats(AllocatorStats* stats) override;
+  void RecordScratchBytes(int64 num_bytes) override;
 
  private:
   VisitableAllocator* base_allocator_ = nullptr;  // owned
@@ -29,6 +29,7 @@ limitations under the License.
 #include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 #include "tensorflow/core/common_runtime/gpu/gpu_init.h"
@@ -56,6 +57,7 @@ limitations under the License.
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/autotune_cache.h"
 #include "tensorflow/core/util/device_name_utils.h"
 #include "tensorflow/core/util/stream_executor_util.h"
 
@@ -295,6 +297,38 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
         i, streams_.back()->compute, streams_.back()->host_to_device,
         streams_.back()->device_to_host, streams_.back()->device_to_device));
   }
+  if (max_streams_ > 1 &&
+      options.config.gpu_options().stream_ordered_allocation()) {
+    BFCAllocator* bfc_allocator = dynamic_cast<BFCAllocator*>(gpu_allocator_);
+    const int gpu_id = gpu_id_;
+    gpu::StreamExecutor* executor = executor_;
+    // The allocator outlives this device, so the fences only refer to the
+    // process-wide streams and executor.
+    auto fence_factory = [gpu_id, executor](int stream_id) {
+      gpu::Stream* stream =
+          StreamGroupFactory::Global()
+              .GetOrCreate(gpu_id, stream_id, executor)
+              ->compute;
+      std::shared_ptr<gpu::Event> event(new gpu::Event(executor));
+      if (!event->Init() || !stream->ThenRecordEvent(event.get()).ok()) {
+        LOG(WARNING) << "Failed to record an event on GPU " << gpu_id
+                     << " stream " << stream_id << ", waiting for the stream";
+        stream->BlockHostUntilDone();
+        return BFCAllocator::StreamFence([]() { return true; });
+      }
+      return BFCAllocator::StreamFence([event]() {
+        return event->PollForStatus() == gpu::Event::Status::kComplete;
+      });
+    };
+    if (bfc_allocator != nullptr &&
+        bfc_allocator->EnableStreamOrderedReuse(fence_factory)) {
+      stream_ordered_allocator_ = bfc_allocator;
+    } else {
+      LOG(WARNING) << "Ignoring stream_ordered_allocation, which the "
+                   << "allocator of GPU " << gpu_id_ << " doesn't support.";
+    }
+  }
+
   gpu_device_info_ = new GpuDeviceInfo;
   gpu_device_info_->stream = streams_[0]->compute;
   gpu_device_info_->default_context = device_contexts_[0];
@@ -302,6 +336,23 @@ Status BaseGPUDevice::Init(const SessionOptions& options) {
   gpu_device_info_->gpu_id = gpu_id_;
   set_tensorflow_gpu_device_info(gpu_device_info_);
 
+  // Autotune results that outlive the process are keyed by the model of the
+  // device and the version of cuDNN rather than by the device ordinal.
+  AutotuneCache* autotune_cache = AutotuneCache::Global();
+  if (autotune_cache != nullptr) {
+    string dnn_version = "unknown";
+    gpu::dnn::DnnSupport* dnn = executor_->AsDnn();
+    if (dnn != nullptr) {
+      auto version = dnn->GetVersion();
+      if (version.ok()) {
+        dnn_version = version.ValueOrDie();
+      }
+    }
+    autotune_cache->RegisterDevice(
+        gpu_id_, strings::StrCat(executor_->GetDeviceDescription().name(),
+                                 " cudnn ", dnn_version));
+  }
+
   return Status::OK();
 }
 
@@ -327,6 +378,9 @@ Status BaseGPUDevice::FillContextMap(const Graph* graph,
   std::unordered_map<int, int> node_to_stream_id;
   TF_RETURN_IF_ERROR(
       gpu_stream_util::AssignStreams(graph, opts, &node_to_stream_id));
+  std::unordered_map<int, std::vector<int>> node_to_control_streams;
+  gpu_stream_util::ControlInputStreams(*graph, node_to_stream_id,
+                                       &node_to_control_streams);
   int64 elapsed = Env::Default()->NowMicros() - before;
   VLOG(3) << "AssignStreams took " << elapsed << "us";
 
@@ -335,13 +389,27 @@ Status BaseGPUDevice::FillContextMap(const Graph* graph,
   device_context_map->resize(graph->num_node_ids());
   for (Node* n : graph->nodes()) {
     auto mapped_stream = node_to_stream_id[n->id()];
-    CHECK_LE(mapped_stream, num_streams);
+    CHECK_LT(mapped_stream, num_streams);
     auto ctx = device_contexts_[mapped_stream];
     VLOG(3) << "Assigned stream " << node_to_stream_id[n->id()]
             << " ==> stream[" << ctx->stream_id() << "] for node id " << n->id()
             << " " << n->type_string() << " " << n->name();
-    ctx->Ref();
-    (*device_context_map)[n->id()] = ctx;
+    auto control_streams = node_to_control_streams.find(n->id());
+    if (control_streams == node_to_control_streams.end()) {
+      ctx->Ref();
+      (*device_context_map)[n->id()] = ctx;
+      continue;
+    }
+    // The node gets a context of its own, which the map owns, listing the
+    // streams of its control inputs.
+    std::vector<gpu::Stream*> control_input_streams;
+    for (int stream_id : control_streams->second) {
+      control_input_streams.push_back(device_contexts_[stream_id]->stream());
+    }
+    (*device_context_map)[n->id()] = new GPUDeviceContext(
+        ctx->stream_id(), ctx->stream(), ctx->host_to_device_stream(),
+        ctx->device_to_host_stream(), ctx->device_to_device_stream(),
+        std::move(control_input_streams));
   }
 
   return Status::OK();
@@ -395,39 +463,13 @@ void BaseGPUDevice::ComputeHelper(OpKernel* op_kernel,
             << stream_id << "]";
   }
 
-  const auto num_streams = streams_.size();
-  if (num_streams > 1) {
-    // If this op's device context is different from the other contexts,
-    // we must wait on the stream.
-    for (int i = 0; i < context->num_inputs(); ++i) {
-      const GPUDeviceContext* idc =
-          static_cast<GPUDeviceContext*>(context->input_device_context(i));
-      OP_REQUIRES(context, idc != nullptr,
-                  errors::Internal("Input device context ", i,
-                                   " was not set properly."));
-      if (vlog_2) {
-        const void* base;
-        size_t len;
-        if (context->has_input(i)) {
-          if (IsRefType(context->input_dtype(i))) {
-            Tensor tensor = context->mutable_input(i, false);
-            base = DMAHelper::base(&tensor);
-            len = tensor.TotalBytes();
-          } else {
-            const Tensor& tensor = context->input(i);
-            base = DMAHelper::base(&tensor);
-            len = tensor.TotalBytes();
-          }
-          LOG(INFO) << "Input " << i << " " << base << "  " << len;
-          LOG(INFO) << "  stream[" << stream_id << "].ThenWaitFor(stream["
-                    << idc->stream_id() << "])"
-                    << ((idc->stream() == stream) ? " not needed" : "");
-        }
-      }
-      if (idc->stream() != stream) stream->ThenWaitFor(idc->stream());
-    }
+  if (streams_.size() > 1) {
+    OP_REQUIRES_OK(context,
+                   WaitForInputStreams(context, gpu_device_context, vlog_2));
   }
   gpu::cuda::ScopedActivateExecutorContext scoped_activation{stream->parent()};
+  BFCAllocator::ScopedStream scoped_stream(
+      stream_ordered_allocator_ != nullptr ? stream_id : -1);
   op_kernel->Compute(context);
   if (context->status().ok()) {
     if (sync_every_op_) {
@@ -440,6 +482,64 @@ void BaseGPUDevice::ComputeHelper(OpKernel* op_kernel,
   }
 }
 
+Status BaseGPUDevice::WaitForInputStreams(OpKernelContext* context,
+                                          GPUDeviceContext* gpu_device_context,
+                                          bool log_inputs) {
+  gpu::Stream* stream = gpu_device_context->stream();
+  // If an input was produced on another stream, this op's stream must wait
+  // for it. Every other stream is waited for at most once, however many of
+  // the inputs it produced.
+  gtl::InlinedVector<gpu::Stream*, 4> waited_for;
+  for (int i = 0; i < context->num_inputs(); ++i) {
+    const GPUDeviceContext* idc =
+        static_cast<GPUDeviceContext*>(context->input_device_context(i));
+    if (idc == nullptr) {
+      return errors::Internal("Input device context ", i,
+                              " was not set properly.");
+    }
+    const bool needed =
+        idc->stream() != stream &&
+        std::find(waited_for.begin(), waited_for.end(), idc->stream()) ==
+            waited_for.end();
+    if (log_inputs && context->has_input(i)) {
+      const void* base;
+      size_t len;
+      if (IsRefType(context->input_dtype(i))) {
+        Tensor tensor = context->mutable_input(i, false);
+        base = DMAHelper::base(&tensor);
+        len = tensor.TotalBytes();
+      } else {
+        const Tensor& tensor = context->input(i);
+        base = DMAHelper::base(&tensor);
+        len = tensor.TotalBytes();
+      }
+      LOG(INFO) << "Input " << i << " " << base << "  " << len;
+      LOG(INFO) << "  stream[" << gpu_device_context->stream_id()
+                << "].ThenWaitFor(stream[" << idc->stream_id() << "])"
+                << (needed ? "" : " not needed");
+    }
+    if (needed) {
+      stream->ThenWaitFor(idc->stream());
+      waited_for.push_back(idc->stream());
+    }
+  }
+  // The control inputs have enqueued all their work by now, as the op only
+  // runs once they are done.
+  for (gpu::Stream* control_stream :
+       gpu_device_context->control_input_streams()) {
+    if (std::find(waited_for.begin(), waited_for.end(), control_stream) ==
+        waited_for.end()) {
+      if (log_inputs) {
+        LOG(INFO) << "  stream[" << gpu_device_context->stream_id()
+                  << "].ThenWaitFor(control input stream)";
+      }
+      stream->ThenWaitFor(control_stream);
+      waited_for.push_back(control_stream);
+    }
+  }
+  return Status::OK();
+}
+
 void BaseGPUDevice::ConsumeListOfAccessedTensors(
     DeviceContext* device_context, const TensorReferenceVector& tensor_refs) {
   GPUDeviceContext* gpu_device_context = device_contexts_[0];
@@ -447,7 +547,25 @@ void BaseGPUDevice::ConsumeListOfAccessedTensors(
     gpu_device_context = static_cast<GPUDeviceContext*>(device_context);
   }
   gpu::Stream* stream = gpu_device_context->stream();
-  em_->ThenDeleteTensors(stream, tensor_refs);
+  if (stream_ordered_allocator_ == nullptr) {
+    em_->ThenDeleteTensors(stream, tensor_refs);
+    return;
+  }
+  // The allocator keeps the memory that this stream may still access from
+  // the other streams, so only the tensors it doesn't know about need to be
+  // held until the stream is done.
+  TensorReferenceVector unrecorded_refs;
+  for (const TensorReference& ref : tensor_refs) {
+    if (stream_ordered_allocator_->RecordStreamUse(
+            ref.data(), gpu_device_context->stream_id())) {
+      ref.Unref();
+    } else {
+      unrecorded_refs.push_back(ref);
+    }
+  }
+  if (!unrecorded_refs.empty()) {
+    em_->ThenDeleteTensors(stream, unrecorded_refs);
+  }
 }
 
 // Based on the semantics of Device::Sync this call should wait for
@@ -472,6 +590,13 @@ void BaseGPUDevice::ComputeAsync(AsyncOpKernel* op_kernel,
   // following TraceMe constructor is simply a conditional test of
   // false value. Measurements show that its overhead is negligible.
   port::Tracing::TraceMe activity(op_kernel->name(), op_kernel->type_string());
+  if (streams_.size() > 1) {
+    OP_REQUIRES_OK_ASYNC(
+        context, WaitForInputStreams(context, gpu_device_context, false),
+        done);
+  }
+  BFCAllocator::ScopedStream scoped_stream(
+      stream_ordered_allocator_ != nullptr ? stream_id : -1);
   op_kernel->ComputeAsync(context, done);
 }
 
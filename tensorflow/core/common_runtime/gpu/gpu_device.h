@@ -42,6 +42,8 @@ limitations under the License.
 
 namespace tensorflow {
 
+class BFCAllocator;
+
 class BaseGPUDevice : public LocalDevice {
  public:
   BaseGPUDevice(const SessionOptions& options, const string& name,
@@ -116,11 +118,21 @@ class BaseGPUDevice : public LocalDevice {
   const bool sync_every_op_ = false;
   const int32 max_streams_;
   std::unique_ptr<EventMgr> em_;
+  // Set if the GPU allocator reuses memory in stream order; see
+  // GPUOptions.stream_ordered_allocation.
+  BFCAllocator* stream_ordered_allocator_ = nullptr;  // not owned
 
   void ReinitializeDevice(OpKernelContext* context, PerOpGpuDevice* device,
                           int stream_id, Allocator* allocator);
 
   void ComputeHelper(OpKernel* op_kernel, OpKernelContext* context);
+
+  // Makes the stream of 'gpu_device_context' wait for the streams that
+  // produced the inputs of 'context', and for the streams its control inputs
+  // ran on. If 'log_inputs', logs every input.
+  Status WaitForInputStreams(OpKernelContext* context,
+                             GPUDeviceContext* gpu_device_context,
+                             bool log_inputs);
 };
 
 class BaseGPUDeviceFactory : public DeviceFactory {
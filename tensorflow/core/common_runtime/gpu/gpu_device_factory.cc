@@ -17,6 +17,8 @@ limitations under the License.
 
 #define EIGEN_USE_GPU
 
+#include <algorithm>
+
 #include "tensorflow/core/common_runtime/gpu/gpu_device.h"
 #include "tensorflow/core/common_runtime/gpu/process_state.h"
 #include "tensorflow/core/common_runtime/threadpool_device.h"
@@ -31,7 +33,7 @@ class GPUDevice : public BaseGPUDevice {
             Allocator* cpu_allocator)
       : BaseGPUDevice(options, name, memory_limit, locality, gpu_id,
                       physical_device_desc, gpu_allocator, cpu_allocator,
-                      false /* sync every op */, 1 /* max_streams */) {
+                      false /* sync every op */, MaxStreams(options)) {
     if (options.config.has_gpu_options()) {
       force_gpu_compatible_ =
           options.config.gpu_options().force_gpu_compatible();
@@ -52,6 +54,10 @@ class GPUDevice : public BaseGPUDevice {
   }
 
  private:
+  static int32 MaxStreams(const SessionOptions& options) {
+    return std::max(1, options.config.gpu_options().num_compute_streams());
+  }
+
   bool force_gpu_compatible_ = false;
 };
 
@@ -78,8 +84,9 @@ class GPUCompatibleCPUDevice : public ThreadPoolDevice {
  public:
   GPUCompatibleCPUDevice(const SessionOptions& options, const string& name,
                          Bytes memory_limit, const DeviceLocality& locality,
-                         Allocator* allocator)
-      : ThreadPoolDevice(options, name, memory_limit, locality, allocator) {
+                         Allocator* allocator, int numa_node)
+      : ThreadPoolDevice(options, name, memory_limit, locality, allocator,
+                         numa_node) {
     if (options.config.has_gpu_options()) {
       force_gpu_compatible_ =
           options.config.gpu_options().force_gpu_compatible();
@@ -98,6 +105,10 @@ class GPUCompatibleCPUDevice : public ThreadPoolDevice {
   }
 
  private:
+  static int32 MaxStreams(const SessionOptions& options) {
+    return std::max(1, options.config.gpu_options().num_compute_streams());
+  }
+
   bool force_gpu_compatible_ = false;
 };
 
@@ -106,15 +117,12 @@ class GPUCompatibleCPUDeviceFactory : public DeviceFactory {
  public:
   Status CreateDevices(const SessionOptions& options, const string& name_prefix,
                        std::vector<Device*>* devices) override {
-    int n = 1;
-    auto iter = options.config.device_count().find("CPU");
-    if (iter != options.config.device_count().end()) {
-      n = iter->second;
-    }
-    for (int i = 0; i < n; i++) {
+    const std::vector<int> numa_nodes = CPUDeviceNUMANodes(options);
+    for (int i = 0; i < numa_nodes.size(); i++) {
       string name = strings::StrCat(name_prefix, "/cpu:", i);
       devices->push_back(new GPUCompatibleCPUDevice(
-          options, name, Bytes(256 << 20), DeviceLocality(), cpu_allocator()));
+          options, name, Bytes(256 << 20), CPUDeviceLocality(numa_nodes[i]),
+          CPUDeviceAllocator(numa_nodes[i]), numa_nodes[i]));
     }
 
     return Status::OK();
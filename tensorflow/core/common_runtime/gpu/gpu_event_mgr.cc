@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
 
+#include <thread>
+
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #include "tensorflow/core/protobuf/config.pb.h"
 
@@ -22,6 +25,16 @@ namespace gpu = ::perftools::gputools;
 
 namespace tensorflow {
 
+namespace {
+
+auto* event_completion_delay = monitoring::Sampler<0>::New(
+    {"/tensorflow/core/gpu_event_mgr_completion_delay_usecs",
+     "An upper bound of the time between the completion of a GPU event and "
+     "its detection by the EventMgr, in microseconds."},
+    {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000});
+
+}  // namespace
+
 EventMgr::EventMgr(gpu::StreamExecutor* se, const GPUOptions& gpu_options)
     : exec_(se),
       deferred_bytes_threshold_(gpu_options.deferred_deletion_bytes()
@@ -34,6 +47,7 @@ EventMgr::EventMgr(gpu::StreamExecutor* se, const GPUOptions& gpu_options)
           gpu_options.polling_inactive_delay_msecs()
               ? gpu_options.polling_inactive_delay_msecs()
               : 1),
+      polling_spin_usecs_(gpu_options.polling_spin_usecs()),
       accumulated_stream_(nullptr),
       accumulated_tensors_(new TensorReferenceVector),
       accumulated_tensor_bytes_(0),
@@ -126,21 +140,38 @@ void EventMgr::FlushAccumulatedTensors() {
 // little delay between calls, and minimizing CPU use and lock
 // contention, which argue for longer delay.  The current strategy is
 // to poll frequently when the queue is non-empty, and infrequently
-// otherwise.
+// otherwise.  Sleeping between polls can add much more than
+// polling_active_delay_usecs_ to the latency of a callback, so with
+// polling_spin_usecs_ set the loop only yields between polls while the
+// queue is changing, and sleeps again once nothing has happened for that
+// long.
 void EventMgr::PollLoop() {
+  Env* env = Env::Default();
   bool queue_empty = false;
+  size_t queue_size = 0;
+  uint64 last_activity_micros = 0;
   while (!stop_polling_->HasBeenNotified()) {
     if (queue_empty) {
       mutex_lock l(mu_);
       WaitForMilliseconds(&l, &events_pending_, polling_inactive_delay_msecs_);
+    } else if (polling_spin_usecs_ > 0 &&
+               env->NowMicros() - last_activity_micros <
+                   static_cast<uint64>(polling_spin_usecs_)) {
+      std::this_thread::yield();
     } else {
-      Env::Default()->SleepForMicroseconds(polling_active_delay_usecs_);
+      env->SleepForMicroseconds(polling_active_delay_usecs_);
     }
     ToFreeVector to_free;
+    bool activity;
     {
       mutex_lock l(mu_);
       PollEvents(true, &to_free);
-      queue_empty = used_events_.empty();
+      activity = !to_free.empty() || used_events_.size() != queue_size;
+      queue_size = used_events_.size();
+      queue_empty = queue_size == 0;
+    }
+    if (activity && polling_spin_usecs_ > 0) {
+      last_activity_micros = env->NowMicros();
     }
     FreeMemory(to_free);
   }
@@ -160,6 +191,7 @@ void EventMgr::QueueInUse(gpu::Stream* stream, InUse iu) {
   free_events_.pop_back();
   stream->ThenRecordEvent(e);
   iu.event = e;
+  iu.checked_micros = Env::Default()->NowMicros();
   bool was_empty = used_events_.empty();
   used_events_.push_back(iu);
   // Maybe wake up the polling thread
@@ -192,6 +224,9 @@ void EventMgr::PollEvents(bool is_dedicated_poller,
   // Sweep the remaining events in order.  If this is the dedicated
   // polling thread, check the entire set.  Otherwise, just sweep up to
   // the first non-complete record that is still pending.
+  static monitoring::SamplerCell* delay_cell =
+      event_completion_delay->GetCell();
+  const uint64 now = Env::Default()->NowMicros();
   for (auto& iu : used_events_) {
     if (iu.event == nullptr) continue;
     gpu::Event::Status s = iu.event->PollForStatus();
@@ -203,9 +238,13 @@ void EventMgr::PollEvents(bool is_dedicated_poller,
         LOG(FATAL) << "Unexpected Event status: " << static_cast<int>(s);
         break;
       case gpu::Event::Status::kPending:
+        iu.checked_micros = now;
         if (!is_dedicated_poller) return;  // quit processing queue
         break;
       case gpu::Event::Status::kComplete:
+        // The event completed at some point since it was last seen pending.
+        delay_cell->Add(now > iu.checked_micros ? now - iu.checked_micros
+                                                : 0);
         // Make a copy of the InUse record so we can free it after releasing
         // the lock
         to_free->push_back(iu);
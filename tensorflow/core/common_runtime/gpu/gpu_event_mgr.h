@@ -95,6 +95,7 @@ class EventMgr {
   const int64 deferred_bytes_threshold_;
   const int32 polling_active_delay_usecs_;
   const int32 polling_inactive_delay_msecs_;
+  const int32 polling_spin_usecs_;
   mutex mu_;
   condition_variable events_pending_ GUARDED_BY(mu_);
 
@@ -105,6 +106,8 @@ class EventMgr {
     TensorReferenceVector* mem;
     BufRec bufrec;
     std::function<void()> func;
+    // When the event was queued or last seen pending.
+    uint64 checked_micros;
   };
 
   typedef gtl::InlinedVector<InUse, 4> ToFreeVector;
@@ -139,17 +142,17 @@ class EventMgr {
   void QueueTensors(perftools::gputools::Stream* stream,
                     TensorReferenceVector* tensors)
       EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    QueueInUse(stream, {nullptr, tensors, BufRec(), nullptr});
+    QueueInUse(stream, {nullptr, tensors, BufRec(), nullptr, 0});
   }
 
   void QueueBuffer(perftools::gputools::Stream* stream, BufRec bufrec)
       EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    QueueInUse(stream, {nullptr, nullptr, bufrec, nullptr});
+    QueueInUse(stream, {nullptr, nullptr, bufrec, nullptr, 0});
   }
 
   void QueueFunc(perftools::gputools::Stream* stream,
                  std::function<void()> func) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    QueueInUse(stream, {nullptr, nullptr, BufRec(), std::move(func)});
+    QueueInUse(stream, {nullptr, nullptr, BufRec(), std::move(func), 0});
   }
 
   // This function should be called at roughly the same tempo as
@@ -161,7 +164,8 @@ class EventMgr {
       EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
   // An internal polling loop that runs at a low frequency to clear
-  // straggler Events.
+  // straggler Events, or without sleeping for a while after events are
+  // queued or complete if polling_spin_usecs_ is positive.
   void PollLoop();
 
   // Setup/Teardown functions for the polling loop.
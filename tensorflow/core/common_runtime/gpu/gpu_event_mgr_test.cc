@@ -246,6 +246,24 @@ TEST(EventMgr, NonEmptyShutdown) {
   }
 }
 
+// The callbacks of a polling loop that spins are run too.
+TEST(EventMgr, SpinningPollLoop) {
+  auto stream_exec = GPUMachineManager()->ExecutorForDevice(0).ValueOrDie();
+  GPUOptions gpu_options;
+  gpu_options.set_polling_spin_usecs(1000);
+  EventMgr em(stream_exec, gpu_options);
+  std::unique_ptr<gpu::Stream> stream(new gpu::Stream(stream_exec));
+  CHECK(stream.get());
+  stream->Init();
+  for (int i = 0; i < 10; ++i) {
+    Notification done;
+    em.ThenExecute(stream.get(), [&done]() { done.Notify(); });
+    done.WaitForNotification();
+    // Let the loop go back to sleeping now and then.
+    if (i % 2 == 0) Env::Default()->SleepForMicroseconds(2000);
+  }
+}
+
 }  // namespace
 }  // namespace tensorflow
 
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/common_runtime/gpu/gpu_stream_util.h"
 
+#include <algorithm>
 #include <set>
 #include <string>
 #include <unordered_set>
@@ -65,29 +66,37 @@ Status AssignStreams(const Graph* graph, const AssignStreamsOpts& opts,
   // stream IDs and then map these down to the required number of streams
   // using simple round-robin.
   // Stream Assignment strategy:
-  // 1. Nodes with zero inputs are always be executed on a
-  // fresh stream.
-  // 2. Try to execute a node on the same stream as one of its
-  // inputs to avoid inter-stream dependencies.
-  // 3. If any input comes from a node with a large fanout then
-  // perhaps an indication that it is shared between parallel
-  // streams of work. We choose a new stream here so that all consumers
-  // of the tensor are likely to run in parallel.
+  // 1. Nodes without data inputs are always executed on a fresh stream,
+  // so that independent branches of the graph start on different streams.
+  // 2. Try to execute a node on the same stream as one of its data inputs
+  // to avoid inter-stream dependencies.
+  // 3. Only one consumer of each node continues on its stream. The other
+  // consumers of a node with a large fanout are parallel streams of work,
+  // and are started on fresh streams so that they run concurrently.
+  // Control edges are not followed here; the streams they cross are waited
+  // for as given by ControlInputStreams().
   int highest_stream_id = -1;
+  // The stream of every node before the overrides and the round-robin, and
+  // the nodes that a consumer already continues the stream of.
+  std::unordered_map<int, int> candidate_stream;
+  std::unordered_set<int> continued;
   for (Node* n : order) {
     VLOG(3) << "Inspecting node " << n->DebugString();
     const int node_id = n->id();
     const string& op = n->type_string();
 
     // Determine a suitable stream to use.
-    int stream_id = highest_stream_id + 1;
+    int stream_id = -1;
     for (const Edge* e : n->in_edges()) {
-      const size_t fanout = e->src()->out_edges().size();
-      if (fanout == 1) {
-        stream_id = (*node_to_stream_id)[e->src()->id()];
+      if (e->IsControlEdge()) continue;
+      const int src_id = e->src()->id();
+      if (continued.insert(src_id).second) {
+        stream_id = candidate_stream[src_id];
         break;
       }
     }
+    if (stream_id < 0) stream_id = highest_stream_id + 1;
+    candidate_stream[node_id] = stream_id;
     // Override stream for specific op types.
     if (op == "_Send") {
       if (opts.send_stream >= 0) stream_id = opts.send_stream;
@@ -108,5 +117,30 @@ Status AssignStreams(const Graph* graph, const AssignStreamsOpts& opts,
   return Status::OK();
 }
 
+void ControlInputStreams(
+    const Graph& graph, const std::unordered_map<int, int>& node_to_stream_id,
+    std::unordered_map<int, std::vector<int>>* node_to_control_streams) {
+  for (const Node* n : graph.nodes()) {
+    auto node_stream = node_to_stream_id.find(n->id());
+    if (node_stream == node_to_stream_id.end()) continue;
+    std::vector<int> streams;
+    for (const Edge* e : n->in_edges()) {
+      // The source node is never run, so it leaves nothing to wait for.
+      if (!e->IsControlEdge() || e->src()->IsSource()) continue;
+      auto src_stream = node_to_stream_id.find(e->src()->id());
+      if (src_stream == node_to_stream_id.end() ||
+          src_stream->second == node_stream->second ||
+          std::find(streams.begin(), streams.end(), src_stream->second) !=
+              streams.end()) {
+        continue;
+      }
+      streams.push_back(src_stream->second);
+    }
+    if (!streams.empty()) {
+      (*node_to_control_streams)[n->id()] = std::move(streams);
+    }
+  }
+}
+
 }  // namespace gpu_stream_util
 }  // namespace tensorflow
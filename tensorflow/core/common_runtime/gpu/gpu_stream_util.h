@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_COMMON_RUNTIME_GPU_GPU_STREAM_UTIL_H_
 
 #include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -39,6 +40,19 @@ struct AssignStreamsOpts {
 Status AssignStreams(const Graph* graph, const AssignStreamsOpts& opts,
                      std::unordered_map<int, int>* node_to_stream_id);
 
+// Given the streams assigned by AssignStreams, sets
+// (*node_to_control_streams)[id] to the streams that the node with that id
+// must wait for because of its control inputs: the distinct streams of the
+// sources of its control edges, other than its own. Nodes that need no such
+// wait are left out.
+//
+// Data inputs carry the stream that produced them to their consumer, but
+// control inputs don't, e.g. an Assign ordered before a read of the same
+// variable only by a control dependency.
+void ControlInputStreams(
+    const Graph& graph, const std::unordered_map<int, int>& node_to_stream_id,
+    std::unordered_map<int, std::vector<int>>* node_to_control_streams);
+
 }  // namespace gpu_stream_util
 }  // namespace tensorflow
 
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session.h"
 
 namespace tensorflow {
 namespace {
@@ -103,6 +104,105 @@ TEST_F(GpuStreamUtilTest, SimpleGraphManyStreams) {
   }
 }
 
+TEST_F(GpuStreamUtilTest, IndependentBranches) {
+  auto root = Scope::NewRootScope().ExitOnError();
+  Output a = ops::Const(root.WithOpName("a"), 1.0f);
+  Output b1 = ops::Square(root.WithOpName("b1"), a);
+  Output c1 = ops::Square(root.WithOpName("c1"), b1);
+  Output b2 = ops::Square(root.WithOpName("b2"), a);
+  Output c2 = ops::Square(root.WithOpName("c2"), b2);
+  ops::Add(root.WithOpName("d"), c1, c2);
+  ops::Square(root.WithOpName("e"), ops::Const(root.WithOpName("f"), 2.0f));
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(root.ToGraph(&g));
+
+  std::unordered_map<int, int> node_to_stream_id;
+  gpu_stream_util::AssignStreamsOpts opts;
+  opts.max_streams = 10;
+  TF_ASSERT_OK(gpu_stream_util::AssignStreams(&g, opts, &node_to_stream_id));
+  std::unordered_map<string, int> stream;
+  for (const auto& it : node_to_stream_id) {
+    stream[g.FindNodeId(it.first)->name()] = it.second;
+  }
+
+  // Chains stay on one stream, and each branch gets its own.
+  EXPECT_EQ(stream["b1"], stream["c1"]);
+  EXPECT_EQ(stream["b2"], stream["c2"]);
+  EXPECT_NE(stream["c1"], stream["c2"]);
+  EXPECT_TRUE(stream["a"] == stream["b1"] || stream["a"] == stream["b2"]);
+  EXPECT_EQ(stream["d"], stream["c1"]);
+  // Nodes without data inputs start independent streams.
+  EXPECT_EQ(stream["f"], stream["e"]);
+  EXPECT_NE(stream["a"], stream["f"]);
+  EXPECT_NE(stream["c2"], stream["f"]);
+}
+
+TEST_F(GpuStreamUtilTest, ControlInputStreams) {
+  auto root = Scope::NewRootScope().ExitOnError();
+  Output var = ops::Variable(root.WithOpName("var"), {10}, DT_FLOAT);
+  Output assign = ops::Assign(root.WithOpName("assign"), var,
+                              ops::Const(root.WithOpName("value"), 1.0f,
+                                         {10}));
+  // "read" is only ordered after "assign" by a control edge.
+  Output read = ops::Square(
+      root.WithOpName("read").WithControlDependencies({assign}), var);
+  Graph g(OpRegistry::Global());
+  TF_ASSERT_OK(root.ToGraph(&g));
+
+  std::unordered_map<string, int> ids;
+  for (const Node* n : g.nodes()) ids[n->name()] = n->id();
+  std::unordered_map<int, int> node_to_stream_id;
+  for (const Node* n : g.nodes()) node_to_stream_id[n->id()] = 0;
+  node_to_stream_id[ids["assign"]] = 1;
+
+  std::unordered_map<int, std::vector<int>> node_to_control_streams;
+  gpu_stream_util::ControlInputStreams(g, node_to_stream_id,
+                                       &node_to_control_streams);
+  // Only "read" waits, and only for the stream of "assign". The roots don't
+  // wait for the stream of the source node.
+  ASSERT_EQ(1, node_to_control_streams.size());
+  EXPECT_EQ(std::vector<int>({1}), node_to_control_streams[ids["read"]]);
+
+  // Nothing to wait for on a single stream.
+  node_to_stream_id[ids["assign"]] = 0;
+  node_to_control_streams.clear();
+  gpu_stream_util::ControlInputStreams(g, node_to_stream_id,
+                                       &node_to_control_streams);
+  EXPECT_TRUE(node_to_control_streams.empty());
+}
+
+TEST_F(GpuStreamUtilTest, ControlOrderedAssignAndReadOnManyStreams) {
+  // Whatever the streams they are assigned, the read of the variable must
+  // see the value assigned before it.
+  auto root = Scope::NewRootScope().ExitOnError();
+  const int kSize = 1 << 20;
+  Output var = ops::Variable(root.WithOpName("var"), {kSize}, DT_FLOAT);
+  Output init = ops::Assign(root.WithOpName("init"), var,
+                            ops::Fill(root, {kSize}, 0.0f));
+  Output assign = ops::Assign(root.WithOpName("assign"), var,
+                              ops::Fill(root, {kSize}, 1.0f));
+  ops::Sum(root.WithOpName("read").WithControlDependencies({assign}), var,
+           {0});
+  GraphDef def;
+  TF_ASSERT_OK(root.ToGraphDef(&def));
+  for (NodeDef& node : *def.mutable_node()) {
+    node.set_device("/gpu:0");
+  }
+
+  SessionOptions options;
+  options.config.set_allow_soft_placement(true);
+  options.config.mutable_gpu_options()->set_num_compute_streams(4);
+  std::unique_ptr<Session> session(NewSession(options));
+  TF_ASSERT_OK(session->Create(def));
+  for (int i = 0; i < 10; ++i) {
+    TF_ASSERT_OK(session->Run({}, {}, {"init"}, nullptr));
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session->Run({}, {"read:0"}, {}, &outputs));
+    ASSERT_EQ(1, outputs.size());
+    EXPECT_EQ(static_cast<float>(kSize), outputs[0].scalar<float>()());
+  }
+}
+
 TEST_F(GpuStreamUtilTest, StreamOverrides) {
   auto root = Scope::NewRootScope().ExitOnError();
   ops::_Recv(root.WithOpName("input"), DT_FLOAT, "input", "/cpu:0", 0,
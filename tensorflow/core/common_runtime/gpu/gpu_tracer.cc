@@ -18,6 +18,10 @@ limitations under the License.
 #if GOOGLE_CUDA
 
 #include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
 
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
@@ -28,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/regexp.h"
 #include "tensorflow/core/platform/tracing.h"
 
 namespace {
@@ -131,10 +136,11 @@ class CUPTIManager {
     CUPTI_CALL(ActivityRegisterCallbacks(BufferRequested, BufferCompleted));
   }
 
-  // Enables tracing and delivers event callbacks to 'client'.
+  // Enables tracing and delivers event callbacks to 'client', with CUPTI
+  // activity buffers of 'buffer_bytes'.
   // Does not take ownership of client.  Client's lifetime must persist
   // until tracing is disabled.
-  Status EnableTrace(CUPTIClient *client);
+  Status EnableTrace(CUPTIClient *client, size_t buffer_bytes);
 
   // Disable tracing.  No further events will be delivered to 'client'.
   Status DisableTrace();
@@ -156,11 +162,12 @@ class CUPTIManager {
   void InternalBufferCompleted(CUcontext ctx, uint32_t streamId,
                                uint8_t *buffer, size_t size, size_t validSize);
 
-  // Size of buffers used for CUPTI tracing.
-  static constexpr size_t kBufferSize = 32 * 1024;
   // Required alignment of CUPTI buffers.
   static constexpr size_t kBufferAlignment = 8;
 
+  // Size of buffers used for CUPTI tracing.
+  std::atomic<size_t> buffer_bytes_{1 << 20};
+
   mutex mu_;
   CUPTIClient *client_ GUARDED_BY(mu_);
   std::unique_ptr<perftools::gputools::profiler::CuptiWrapper> cupti_wrapper_;
@@ -168,8 +175,9 @@ class CUPTIManager {
   TF_DISALLOW_COPY_AND_ASSIGN(CUPTIManager);
 };
 
-Status CUPTIManager::EnableTrace(CUPTIClient *client) {
+Status CUPTIManager::EnableTrace(CUPTIClient *client, size_t buffer_bytes) {
   mutex_lock l(mu_);
+  buffer_bytes_ = buffer_bytes;
   // TODO(pbar) Work out the minimal set to trace.
   // We can currently manage without driver/runtime tracing.
   // CUPTI_CALL(ActivityEnable(CUPTI_ACTIVITY_KIND_CONTEXT));
@@ -215,8 +223,9 @@ Status CUPTIManager::DisableTrace() {
 void CUPTIManager::InternalBufferRequested(uint8_t **buffer, size_t *size,
                                            size_t *maxNumRecords) {
   VLOG(2) << "BufferRequested";
-  void *p = port::AlignedMalloc(kBufferSize, kBufferAlignment);
-  *size = kBufferSize;
+  const size_t buffer_bytes = buffer_bytes_;
+  void *p = port::AlignedMalloc(buffer_bytes, kBufferAlignment);
+  *size = buffer_bytes;
   *buffer = reinterpret_cast<uint8_t *>(p);
   *maxNumRecords = 0;
 }
@@ -278,16 +287,15 @@ CUPTIManager *GetCUPTIManager() {
   }  // namespace
 
 // Thread-local state recording the most recent annotation (if any).
-// When non-null, this points to a string in the active annotation
-// of the current thread.  The annotation is guaranteed to remain live
-// for the duration of the CUPTI API callback.
+// When non-null, this points to the interned name of the active annotation
+// of the current thread, which lives as long as the tracer.
 TF_STATIC_THREAD_LOCAL_POD(const char *, tls_current_annotation);
 
 class GPUTracerImpl : public GPUTracer,
                       public CUPTIClient,
                       public port::Tracing::Engine {
  public:
-  GPUTracerImpl();
+  explicit GPUTracerImpl(const GPUTracerOptions &options);
   ~GPUTracerImpl() override;
 
   // GPUTracer interface:
@@ -303,14 +311,13 @@ class GPUTracerImpl : public GPUTracer,
   Annotation *PushAnnotation(StringPiece name) override {
     VLOG(2) << "PushAnnotation " << name;
     struct Impl : public port::Tracing::Engine::Annotation {
-      string annotation;
-      explicit Impl(StringPiece n) : annotation(n.ToString()) {
+      explicit Impl(const char *annotation) {
         // Remember the most recent ScopedAnnotation for each thread.
-        tls_current_annotation.get() = annotation.c_str();
+        tls_current_annotation.get() = annotation;
       }
       ~Impl() override { tls_current_annotation.get() = nullptr; }
     };
-    return new Impl(name);
+    return new Impl(Intern(name));
   }
   Tracer *StartTracing(StringPiece label) override {
     // We don't do anything with 'TraceMe' regions yet.
@@ -330,6 +337,15 @@ class GPUTracerImpl : public GPUTracer,
     uint32 device_id;
     uint32 stream_id;
     uint32 correlation_id;
+    // Interned.
+    const char *kernel_name;
+  };
+  // Internal struct to record the annotation active when a kernel or copy
+  // was issued.
+  struct CorrelationRecord {
+    uint32 correlation_id;
+    // Interned.
+    const char *annotation;
   };
   // Internal struct to record memcpy operations.
   struct MemcpyRecord {
@@ -349,19 +365,37 @@ class GPUTracerImpl : public GPUTracer,
   static void CUPTIAPI ApiCallback(void *userdata, CUpti_CallbackDomain domain,
                                    CUpti_CallbackId cbid, const void *cbdata);
 
-  // Records the mapping between correlation ID and kernel name.
-  void AddCorrelationId(uint32 correlation_id, const string &name);
+  // Records the annotation of a correlation ID.
+  void AddCorrelationId(uint32 correlation_id, const char *annotation);
+
+  // Returns a copy of 'name' which lives as long as the tracer. Each distinct
+  // name is only copied once.
+  const char *Intern(StringPiece name);
+
+  // Whether the activities of 'stream_id' are recorded.
+  bool TracesStream(uint32 stream_id) const {
+    return options_.stream_ids.empty() ||
+           std::find(options_.stream_ids.begin(), options_.stream_ids.end(),
+                     stream_id) != options_.stream_ids.end();
+  }
 
   // Returns the current system time in microseconds.
   inline int64 NowInUsec() { return Env::Default()->NowMicros(); }
 
+  const GPUTracerOptions options_;
+  // Compiled from options_.name_filter, or null.
+  std::unique_ptr<RE2> name_filter_;
   CUPTIManager *cupti_manager_;
   std::unique_ptr<perftools::gputools::profiler::CuptiWrapper> cupti_wrapper_;
   CUpti_SubscriberHandle subscriber_;
 
+  mutex intern_mu_;
+  std::unordered_map<StringPiece, std::unique_ptr<string>, StringPiece::Hasher>
+      interned_ GUARDED_BY(intern_mu_);
+
   mutex trace_mu_;
   static constexpr size_t kMaxRecords = 1024 * 1024;
-  std::map<uint32, string> correlations_ GUARDED_BY(trace_mu_);
+  std::vector<CorrelationRecord> correlations_ GUARDED_BY(trace_mu_);
   std::vector<KernelRecord> kernel_records_ GUARDED_BY(trace_mu_);
   std::vector<MemcpyRecord> memcpy_records_ GUARDED_BY(trace_mu_);
 
@@ -375,8 +409,17 @@ class GPUTracerImpl : public GPUTracer,
   TF_DISALLOW_COPY_AND_ASSIGN(GPUTracerImpl);
 };
 
-GPUTracerImpl::GPUTracerImpl() {
+GPUTracerImpl::GPUTracerImpl(const GPUTracerOptions &options)
+    : options_(options) {
   VLOG(1) << "GPUTracer created.";
+  if (!options_.name_filter.empty()) {
+    name_filter_.reset(new RE2(options_.name_filter));
+    if (!name_filter_->ok()) {
+      LOG(ERROR) << "Invalid GPU trace name filter " << options_.name_filter
+                 << ": " << name_filter_->error();
+      name_filter_.reset();
+    }
+  }
   cupti_manager_ = GetCUPTIManager();
   CHECK(cupti_manager_);
   cupti_wrapper_.reset(new perftools::gputools::profiler::CuptiWrapper());
@@ -440,7 +483,8 @@ Status GPUTracerImpl::Start() {
                             CUPTI_CB_DOMAIN_DRIVER_API,
                             CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoDAsync_v2));
 
-  TF_RETURN_IF_ERROR(cupti_manager_->EnableTrace(this));
+  TF_RETURN_IF_ERROR(
+      cupti_manager_->EnableTrace(this, options_.buffer_bytes));
 
   CUPTI_CALL(GetTimestamp(&start_timestamp_));
   start_walltime_us_ = NowInUsec();
@@ -464,11 +508,20 @@ Status GPUTracerImpl::Stop() {
 }
 
 void GPUTracerImpl::AddCorrelationId(uint32 correlation_id,
-                                     const string &name) {
-  VLOG(2) << correlation_id << " : " << name;
+                                     const char *annotation) {
+  VLOG(2) << correlation_id << " : " << annotation;
   mutex_lock l(trace_mu_);
   if (correlations_.size() >= kMaxRecords) return;
-  correlations_.emplace(correlation_id, name);
+  correlations_.push_back(CorrelationRecord{correlation_id, annotation});
+}
+
+const char *GPUTracerImpl::Intern(StringPiece name) {
+  mutex_lock l(intern_mu_);
+  auto it = interned_.find(name);
+  if (it != interned_.end()) return it->second->c_str();
+  string *copy = new string(name.data(), name.size());
+  interned_.emplace(StringPiece(*copy), std::unique_ptr<string>(copy));
+  return copy->c_str();
 }
 
 /*static*/ void GPUTracerImpl::ApiCallback(void *userdata,
@@ -494,9 +547,11 @@ void GPUTracerImpl::AddCorrelationId(uint32 correlation_id,
         VLOG(2) << "LAUNCH stream " << params->hStream << " correllation "
                 << cbInfo->correlationId << " kernel " << cbInfo->symbolName;
       }
-      const string annotation =
-          tls_annotation ? tls_annotation : cbInfo->symbolName;
-      tracer->AddCorrelationId(cbInfo->correlationId, annotation);
+      // Kernels launched outside of ops are named after their kernel
+      // function, from the activity record.
+      if (tls_annotation) {
+        tracer->AddCorrelationId(cbInfo->correlationId, tls_annotation);
+      }
     }
   } else if ((domain == CUPTI_CB_DOMAIN_RUNTIME_API) &&
              (cbid == CUPTI_RUNTIME_TRACE_CBID_cudaMemcpy_v3020 ||
@@ -510,8 +565,7 @@ void GPUTracerImpl::AddCorrelationId(uint32 correlation_id,
         VLOG(2) << "MEMCPY count " << count << " kind " << kind;
       }
       if (tls_annotation) {
-        const string annotation = tls_annotation;
-        tracer->AddCorrelationId(cbInfo->correlationId, annotation);
+        tracer->AddCorrelationId(cbInfo->correlationId, tls_annotation);
       }
     }
   } else if ((domain == CUPTI_CB_DOMAIN_DRIVER_API) &&
@@ -522,8 +576,7 @@ void GPUTracerImpl::AddCorrelationId(uint32 correlation_id,
               cbid == CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoHAsync_v2 ||
               cbid == CUPTI_DRIVER_TRACE_CBID_cuMemcpyDtoDAsync_v2)) {
     if (cbInfo->callbackSite == CUPTI_API_EXIT && tls_annotation) {
-      const string annotation = tls_annotation;
-      tracer->AddCorrelationId(cbInfo->correlationId, annotation);
+      tracer->AddCorrelationId(cbInfo->correlationId, tls_annotation);
     }
   } else {
     VLOG(1) << "Unhandled API Callback for " << domain << " " << cbid;
@@ -532,11 +585,12 @@ void GPUTracerImpl::AddCorrelationId(uint32 correlation_id,
 
 void GPUTracerImpl::ActivityCallback(const CUpti_Activity &record) {
   VLOG(2) << "ActivityCallback " << record.kind;
-  mutex_lock l(trace_mu_);
   switch (record.kind) {
     case CUPTI_ACTIVITY_KIND_MEMCPY: {
-      if (memcpy_records_.size() >= kMaxRecords) return;
       auto *memcpy = reinterpret_cast<const CUpti_ActivityMemcpy *>(&record);
+      if (!TracesStream(memcpy->streamId)) return;
+      mutex_lock l(trace_mu_);
+      if (memcpy_records_.size() >= kMaxRecords) return;
       memcpy_records_.push_back(MemcpyRecord{
           memcpy->start, memcpy->end, memcpy->deviceId, memcpy->streamId,
           memcpy->correlationId, memcpy->copyKind, memcpy->srcKind,
@@ -545,11 +599,16 @@ void GPUTracerImpl::ActivityCallback(const CUpti_Activity &record) {
     }
     case CUPTI_ACTIVITY_KIND_KERNEL:
     case CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL: {
-      if (kernel_records_.size() >= kMaxRecords) return;
       auto *kernel = reinterpret_cast<const CUpti_ActivityKernel3 *>(&record);
-      kernel_records_.push_back(KernelRecord{kernel->start, kernel->end,
-                                             kernel->deviceId, kernel->streamId,
-                                             kernel->correlationId});
+      if (!TracesStream(kernel->streamId)) return;
+      // Activity buffers are processed off the path of the kernel launches.
+      const char *kernel_name =
+          kernel->name ? Intern(kernel->name) : Intern("unknown");
+      mutex_lock l(trace_mu_);
+      if (kernel_records_.size() >= kMaxRecords) return;
+      kernel_records_.push_back(
+          KernelRecord{kernel->start, kernel->end, kernel->deviceId,
+                       kernel->streamId, kernel->correlationId, kernel_name});
       break;
     }
     default:
@@ -570,9 +629,19 @@ Status GPUTracerImpl::Collect(StepStatsCollector *collector) {
   const string memcpy_device = strings::StrCat(prefix, "/gpu:", id, "/memcpy");
 
   mutex_lock l2(trace_mu_);
+  std::unordered_map<uint32, const char *> annotations;
+  annotations.reserve(correlations_.size());
+  for (const auto &rec : correlations_) {
+    annotations.emplace(rec.correlation_id, rec.annotation);
+  }
   for (const auto &rec : kernel_records_) {
-    auto it = correlations_.find(rec.correlation_id);
-    const string name = (it != correlations_.cend()) ? it->second : "unknown";
+    auto it = annotations.find(rec.correlation_id);
+    const char *name =
+        (it != annotations.cend()) ? it->second : rec.kernel_name;
+    if (name_filter_ && !RE2::PartialMatch(name, *name_filter_) &&
+        !RE2::PartialMatch(rec.kernel_name, *name_filter_)) {
+      continue;
+    }
     NodeExecStats *ns = new NodeExecStats;
     ns->set_all_start_micros(start_walltime_us_ +
                              ((rec.start_timestamp - start_timestamp_) / 1000));
@@ -582,16 +651,16 @@ Status GPUTracerImpl::Collect(StepStatsCollector *collector) {
     ns->set_op_end_rel_micros(elapsed_us);
     ns->set_all_end_rel_micros(elapsed_us);
     ns->set_node_name(name);
-    // TODO(pbar) Generate details based on the kernel activity record.
-    // ns->set_timeline_label(details);
+    ns->set_timeline_label(rec.kernel_name);
     auto nscopy = new NodeExecStats;
     *nscopy = *ns;
     collector->Save(strings::StrCat(stream_device, "all"), ns);
     collector->Save(strings::StrCat(stream_device, rec.stream_id), nscopy);
   }
   for (const auto &rec : memcpy_records_) {
-    auto it = correlations_.find(rec.correlation_id);
-    const string name = (it != correlations_.cend()) ? it->second : "unknown";
+    auto it = annotations.find(rec.correlation_id);
+    const char *name = (it != annotations.cend()) ? it->second : "unknown";
+    if (name_filter_ && !RE2::PartialMatch(name, *name_filter_)) continue;
     NodeExecStats *ns = new NodeExecStats;
     ns->set_all_start_micros(start_walltime_us_ +
                              ((rec.start_timestamp - start_timestamp_) / 1000));
@@ -619,7 +688,9 @@ Status GPUTracerImpl::Collect(StepStatsCollector *collector) {
 
 }  // namespace gputracer
 
-GPUTracer *CreateGPUTracer() { return new gputracer::GPUTracerImpl(); }
+GPUTracer *CreateGPUTracer(const GPUTracerOptions &options) {
+  return new gputracer::GPUTracerImpl(options);
+}
 
 }  // namespace tensorflow
 
@@ -627,8 +698,14 @@ GPUTracer *CreateGPUTracer() { return new gputracer::GPUTracerImpl(); }
 
 namespace tensorflow {
 
-GPUTracer *CreateGPUTracer() { return nullptr; }
+GPUTracer *CreateGPUTracer(const GPUTracerOptions &options) { return nullptr; }
 
 }  // namespace tensorflow
 
 #endif  // GOOGLE_CUDA
+
+namespace tensorflow {
+
+GPUTracer *CreateGPUTracer() { return CreateGPUTracer(GPUTracerOptions()); }
+
+}  // namespace tensorflow
@@ -16,7 +16,10 @@ limitations under the License.
 #ifndef TENSORFLOW_COMMON_RUNTIME_GPU_GPU_TRACER_H_
 #define TENSORFLOW_COMMON_RUNTIME_GPU_GPU_TRACER_H_
 
+#include <vector>
+
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
 
@@ -68,9 +71,24 @@ class GPUTracer {
   virtual Status Collect(StepStatsCollector* collector) = 0;
 };
 
+// Options of a GPUTracer.
+struct GPUTracerOptions {
+  // The size of the buffers which CUPTI fills with activity records. Larger
+  // buffers are handed back to the tracer less often.
+  size_t buffer_bytes = 1 << 20;
+
+  // If not empty, only the kernels and copies whose op annotation or kernel
+  // name partially matches this regular expression are collected.
+  string name_filter;
+
+  // If not empty, only the activities of these CUDA streams are recorded.
+  std::vector<uint32> stream_ids;
+};
+
 // Creates a platform-specific GPUTracer.
 // Returns 'nullptr' on platforms where tracing is not supported.
 GPUTracer* CreateGPUTracer();
+GPUTracer* CreateGPUTracer(const GPUTracerOptions& options);
 
 }  // namespace tensorflow
 
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/log_memory.h"
 #include "tensorflow/core/framework/tracking_allocator.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -237,9 +238,30 @@ Allocator* ProcessState::GetCUDAHostAllocator(int numa_node) {
       LOG(ERROR) << "GetCUDAHostAllocator: " << status.error_message();
     }
     int64 cuda_host_mem_limit = cuda_host_mem_limit_in_mb * (1LL << 20);
-    Allocator* allocator =
+    // Registering pinned memory with the driver is slow, so the region that
+    // most receive and feed buffers fit in can be registered once up front,
+    // instead of growing from 1MB on the first steps.
+    int64 cuda_host_mem_reserved_in_mb = 0;
+    status = ReadInt64FromEnvVar("TF_CUDA_HOST_MEM_RESERVED_IN_MB", 0,
+                                 &cuda_host_mem_reserved_in_mb);
+    if (!status.ok()) {
+      LOG(ERROR) << "GetCUDAHostAllocator: " << status.error_message();
+    }
+    BFCAllocator* bfc_allocator =
         new BFCAllocator(new CUDAHostAllocator(se), cuda_host_mem_limit,
                          true /*allow_growth*/, "cuda_host_bfc" /*name*/);
+    if (cuda_host_mem_reserved_in_mb > 0) {
+      const size_t reserved = cuda_host_mem_reserved_in_mb * (1LL << 20);
+      if (bfc_allocator->Reserve(reserved)) {
+        VLOG(1) << "Reserved " << strings::HumanReadableNumBytes(reserved)
+                << " of pinned host memory";
+      } else {
+        LOG(WARNING) << "Could not reserve "
+                     << strings::HumanReadableNumBytes(reserved)
+                     << " of pinned host memory, growing on demand instead";
+      }
+    }
+    Allocator* allocator = bfc_allocator;
 
     if (LogMemory::IsEnabled()) {
       // Wrap the allocator to track allocation ids for better logging
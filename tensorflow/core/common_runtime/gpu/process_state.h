@@ -156,6 +156,9 @@ class RecordingAllocator : public Allocator {
   size_t RequestedSize(void* p) override { return a_->RequestedSize(p); }
   size_t AllocatedSize(void* p) override { return a_->AllocatedSize(p); }
   void GetStats(AllocatorStats* stats) override { return a_->GetStats(stats); }
+  void RecordScratchBytes(int64 num_bytes) override {
+    a_->RecordScratchBytes(num_bytes);
+  }
   ProcessState::MDMap* mm_;  // not owned
   Allocator* a_;             // not owned
   ProcessState::MemDesc md_;
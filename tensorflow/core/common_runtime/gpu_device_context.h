@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_COMMON_RUNTIME_GPU_DEVICE_CONTEXT_H_
 #define TENSORFLOW_COMMON_RUNTIME_GPU_DEVICE_CONTEXT_H_
 
+#include <vector>
+
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/device_base.h"
 
@@ -42,6 +44,18 @@ class GPUDeviceContext : public DeviceContext {
         device_to_host_stream_(device_to_host_stream),
         device_to_device_stream_(device_to_device_stream) {}
 
+  // Also makes the ops run with this context wait for the work enqueued on
+  // "control_input_streams", as their control inputs ran there.
+  GPUDeviceContext(int stream_id, gpu::Stream* stream,
+                   gpu::Stream* host_to_device_stream,
+                   gpu::Stream* device_to_host_stream,
+                   gpu::Stream* device_to_device_stream,
+                   std::vector<gpu::Stream*> control_input_streams)
+      : GPUDeviceContext(stream_id, stream, host_to_device_stream,
+                         device_to_host_stream, device_to_device_stream) {
+    control_input_streams_ = std::move(control_input_streams);
+  }
+
   ~GPUDeviceContext() override {}
 
   gpu::Stream* stream() const override { return stream_; }
@@ -51,6 +65,9 @@ class GPUDeviceContext : public DeviceContext {
     return device_to_device_stream_;
   }
   int stream_id() const { return stream_id_; }
+  const std::vector<gpu::Stream*>& control_input_streams() const {
+    return control_input_streams_;
+  }
 
   void CopyCPUTensorToDevice(const Tensor* cpu_tensor, Device* device,
                              Tensor* device_tensor,
@@ -74,6 +91,8 @@ class GPUDeviceContext : public DeviceContext {
   gpu::Stream* device_to_host_stream_;
   // The stream to use for copy data between GPU.
   gpu::Stream* device_to_device_stream_;
+  // The streams that the control inputs of the op ran on.
+  std::vector<gpu::Stream*> control_input_streams_;
 };
 
 }  // namespace tensorflow
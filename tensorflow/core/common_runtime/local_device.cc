@@ -16,12 +16,19 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 
 #include "tensorflow/core/common_runtime/local_device.h"
+
+#include <algorithm>
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/common_runtime/eigen_thread_pool.h"
+#include "tensorflow/core/common_runtime/process_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/cpu_feature_guard.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session_options.h"
 
@@ -31,55 +38,106 @@ namespace tensorflow {
 bool LocalDevice::use_global_threadpool_ = true;
 
 struct LocalDevice::EigenThreadPoolInfo {
-  explicit EigenThreadPoolInfo(const SessionOptions& options) {
+  EigenThreadPoolInfo(const SessionOptions& options, int numa_node) {
+    const ThreadPoolOptionProto& pool_options =
+        options.config.intra_op_thread_pool_options();
     int32 intra_op_parallelism_threads =
         options.config.intra_op_parallelism_threads();
-    if (intra_op_parallelism_threads == 0) {
+    if (pool_options.cpu_affinity_size() > 0) {
+      // The affinity takes precedence over the NUMA node.
+      numa_node = port::kNUMANoAffinity;
+      intra_op_parallelism_threads =
+          NumThreadsOrDefault(intra_op_parallelism_threads, pool_options);
+    } else if (numa_node != port::kNUMANoAffinity) {
+      // Each node gets its share of the threads.
+      if (intra_op_parallelism_threads == 0) {
+        intra_op_parallelism_threads = port::NUMANumSchedulableCPUs(numa_node);
+      } else {
+        intra_op_parallelism_threads = std::max(
+            1, intra_op_parallelism_threads / port::NUMANumNodes());
+      }
+    } else if (intra_op_parallelism_threads == 0) {
       intra_op_parallelism_threads = port::NumSchedulableCPUs();
     }
     VLOG(1) << "Local device intra op parallelism threads: "
-            << intra_op_parallelism_threads;
+            << intra_op_parallelism_threads << " on NUMA node " << numa_node;
+    ThreadOptions thread_options = ThreadOptionsFromPoolOptions(pool_options);
+    thread_options.numa_node = numa_node;
     eigen_worker_threads_.num_threads = intra_op_parallelism_threads;
     eigen_worker_threads_.workers = new thread::ThreadPool(
-        options.env, "Eigen", intra_op_parallelism_threads);
+        options.env, thread_options, "Eigen", intra_op_parallelism_threads,
+        !pool_options.disable_spinning());
     eigen_threadpool_wrapper_.reset(
         new EigenThreadPoolWrapper(eigen_worker_threads_.workers));
     eigen_device_.reset(new Eigen::ThreadPoolDevice(
         eigen_threadpool_wrapper_.get(), eigen_worker_threads_.num_threads));
+    // Devices with fewer threads, for steps that limit their intra-op
+    // parallelism.
+    for (int i = 1; i < eigen_worker_threads_.num_threads; ++i) {
+      eigen_devices_by_parallelism_.emplace_back(
+          new Eigen::ThreadPoolDevice(eigen_threadpool_wrapper_.get(), i));
+    }
   }
 
   ~EigenThreadPoolInfo() {
     eigen_threadpool_wrapper_.reset();
     eigen_device_.reset();
+    eigen_devices_by_parallelism_.clear();
     delete eigen_worker_threads_.workers;
   }
 
+  std::vector<Eigen::ThreadPoolDevice*> eigen_devices_by_parallelism() const {
+    std::vector<Eigen::ThreadPoolDevice*> devices;
+    for (const auto& device : eigen_devices_by_parallelism_) {
+      devices.push_back(device.get());
+    }
+    return devices;
+  }
+
   DeviceBase::CpuWorkerThreads eigen_worker_threads_;
   std::unique_ptr<Eigen::ThreadPoolInterface> eigen_threadpool_wrapper_;
   std::unique_ptr<Eigen::ThreadPoolDevice> eigen_device_;
+  std::vector<std::unique_ptr<Eigen::ThreadPoolDevice>>
+      eigen_devices_by_parallelism_;
 };
 
 LocalDevice::LocalDevice(const SessionOptions& options,
-                         const DeviceAttributes& attributes)
+                         const DeviceAttributes& attributes, int numa_node)
     : Device(options.env, attributes), owned_tp_info_(nullptr) {
   // If we're running on the CPU, log warnings if we're not compiled using the
   // best flags for performance.
   port::WarnAboutUnusedCPUFeatures();
   LocalDevice::EigenThreadPoolInfo* tp_info;
-  if (use_global_threadpool_) {
+  if (use_global_threadpool_ && numa_node != port::kNUMANoAffinity) {
+    // All the devices of a NUMA node use the node's fixed sized threadpool.
+    static mutex* numa_mu = new mutex;
+    static std::vector<LocalDevice::EigenThreadPoolInfo*>* numa_tp_info =
+        new std::vector<LocalDevice::EigenThreadPoolInfo*>(
+            port::NUMANumNodes());
+    mutex_lock l(*numa_mu);
+    LocalDevice::EigenThreadPoolInfo*& node_tp_info =
+        (*numa_tp_info)[numa_node];
+    if (node_tp_info == nullptr) {
+      node_tp_info = new LocalDevice::EigenThreadPoolInfo(options, numa_node);
+    }
+    tp_info = node_tp_info;
+  } else if (use_global_threadpool_) {
     // All ThreadPoolDevices in the process will use this single fixed
     // sized threadpool for numerical computations.
     static LocalDevice::EigenThreadPoolInfo* global_tp_info =
-        new LocalDevice::EigenThreadPoolInfo(options);
+        new LocalDevice::EigenThreadPoolInfo(options, port::kNUMANoAffinity);
     tp_info = global_tp_info;
   } else {
     // Each LocalDevice owns a separate ThreadPoolDevice for numerical
     // computations.
-    owned_tp_info_.reset(new LocalDevice::EigenThreadPoolInfo(options));
+    owned_tp_info_.reset(
+        new LocalDevice::EigenThreadPoolInfo(options, numa_node));
     tp_info = owned_tp_info_.get();
   }
   set_tensorflow_cpu_worker_threads(&tp_info->eigen_worker_threads_);
   set_eigen_cpu_device(tp_info->eigen_device_.get());
+  set_eigen_cpu_devices_by_parallelism(
+      tp_info->eigen_devices_by_parallelism());
 }
 
 LocalDevice::~LocalDevice() {}
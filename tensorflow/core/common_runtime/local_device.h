@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/numa.h"
 
 namespace tensorflow {
 
@@ -31,10 +32,14 @@ struct SessionOptions;
 // initializes a shared Eigen compute device used by both.  This
 // should eventually be removed once we refactor ThreadPoolDevice and
 // GPUDevice into more 'process-wide' abstractions.
+//
+// If numa_node is a node of port::NUMANumNodes(), the Eigen device runs on
+// a pool of threads bound to that node, shared by all the devices of the
+// node.
 class LocalDevice : public Device {
  public:
-  LocalDevice(const SessionOptions& options,
-              const DeviceAttributes& attributes);
+  LocalDevice(const SessionOptions& options, const DeviceAttributes& attributes,
+              int numa_node = port::kNUMANoAffinity);
   ~LocalDevice() override;
 
  private:
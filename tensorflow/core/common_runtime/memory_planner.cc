@@ -0,0 +1,368 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/memory_planner.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Above this many nodes, the ancestor sets are too large to compute and
+// planned buffers are not shared.
+const int kMaxNodesForSharing = 16384;
+
+int64 AlignedBytes(int64 bytes) {
+  const int64 alignment = Allocator::kAllocatorAlignment;
+  return (bytes + alignment - 1) / alignment * alignment;
+}
+
+// The strict ancestors of every node, as one bit set per node id.
+class AncestorSets {
+ public:
+  explicit AncestorSets(const Graph& graph)
+      : num_words_((graph.num_node_ids() + 63) / 64),
+        bits_(graph.num_node_ids() * num_words_, 0) {
+    std::vector<Node*> order;
+    GetReversePostOrder(graph, &order);
+    for (const Node* n : order) {
+      uint64* dst = Set(n->id());
+      for (const Edge* e : n->in_edges()) {
+        const int src_id = e->src()->id();
+        const uint64* src = Set(src_id);
+        for (int w = 0; w < num_words_; ++w) dst[w] |= src[w];
+        dst[src_id / 64] |= uint64{1} << (src_id % 64);
+      }
+    }
+  }
+
+  // Returns true iff "a" is a strict ancestor of "b".
+  bool IsAncestor(int a, int b) const {
+    return (Set(b)[a / 64] >> (a % 64)) & 1;
+  }
+
+ private:
+  uint64* Set(int id) { return &bits_[id * num_words_]; }
+  const uint64* Set(int id) const { return &bits_[id * num_words_]; }
+
+  const int num_words_;
+  std::vector<uint64> bits_;
+};
+
+// Returns the ids of the nodes reading output "slot" of "node".
+std::vector<int> Uses(const Node* node, int slot) {
+  std::vector<int> uses;
+  for (const Edge* e : node->out_edges()) {
+    if (e->src_output() == slot) uses.push_back(e->dst()->id());
+  }
+  return uses;
+}
+
+bool HasRefInput(const Node* node) {
+  for (int i = 0; i < node->num_inputs(); ++i) {
+    if (IsRefType(node->input_type(i))) return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+bool CanPlanOutput(const Node* node, int slot) {
+  if (!node->IsOp() || node->IsControlFlow() || IsTransferNode(node)) {
+    return false;
+  }
+  const DataType dtype = node->output_type(slot);
+  if (IsRefType(dtype) || !DataTypeCanUseMemcpy(dtype)) {
+    return false;
+  }
+  for (const Edge* e : node->out_edges()) {
+    if (e->src_output() != slot) continue;
+    const Node* dst = e->dst();
+    // Stateful consumers may keep their inputs beyond the step (e.g.
+    // enqueue ops), as may ops updating a ref (e.g. Assign), and _Retval
+    // returns them to the caller.
+    if (!dst->IsOp() || dst->op_def().is_stateful() ||
+        dst->type_string() == "_Retval" || HasRefInput(dst)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int64 AssignBufferOffsets(const Graph& graph,
+                          std::vector<PlannedBuffer>* buffers) {
+  const int n = buffers->size();
+  std::unique_ptr<AncestorSets> ancestors;
+  if (graph.num_node_ids() <= kMaxNodesForSharing) {
+    ancestors.reset(new AncestorSets(graph));
+  }
+
+  // The producer and the readers of each buffer.
+  std::vector<std::vector<int>> lifetimes(n);
+  for (int i = 0; i < n; ++i) {
+    const PlannedBuffer& b = (*buffers)[i];
+    lifetimes[i] = Uses(graph.FindNodeId(b.node_id), b.slot);
+    lifetimes[i].push_back(b.node_id);
+  }
+  // Returns true iff buffer "a" is dead whenever buffer "b" is allocated.
+  auto precedes = [&](int a, int b) {
+    const int producer = (*buffers)[b].node_id;
+    for (int id : lifetimes[a]) {
+      if (!ancestors->IsAncestor(id, producer)) return false;
+    }
+    return true;
+  };
+
+  std::vector<int> order(n);
+  for (int i = 0; i < n; ++i) order[i] = i;
+  std::sort(order.begin(), order.end(), [buffers](int a, int b) {
+    const PlannedBuffer& ba = (*buffers)[a];
+    const PlannedBuffer& bb = (*buffers)[b];
+    if (ba.bytes != bb.bytes) return ba.bytes > bb.bytes;
+    if (ba.node_id != bb.node_id) return ba.node_id < bb.node_id;
+    return ba.slot < bb.slot;
+  });
+
+  // Largest buffers first, each at the lowest offset that does not overlap
+  // a placed buffer it may be live with.
+  int64 slab_bytes = 0;
+  std::vector<int> placed;
+  std::vector<int> conflicts;
+  for (int i : order) {
+    PlannedBuffer* b = &(*buffers)[i];
+    const int64 bytes = AlignedBytes(b->bytes);
+    conflicts.clear();
+    for (int j : placed) {
+      if (ancestors == nullptr || !(precedes(i, j) || precedes(j, i))) {
+        conflicts.push_back(j);
+      }
+    }
+    std::sort(conflicts.begin(), conflicts.end(), [buffers](int x, int y) {
+      return (*buffers)[x].offset < (*buffers)[y].offset;
+    });
+    int64 offset = 0;
+    for (int j : conflicts) {
+      const PlannedBuffer& c = (*buffers)[j];
+      if (offset + bytes <= c.offset) break;
+      offset = std::max(offset, c.offset + AlignedBytes(c.bytes));
+    }
+    b->offset = offset;
+    slab_bytes = std::max(slab_bytes, offset + bytes);
+    placed.push_back(i);
+  }
+  return slab_bytes;
+}
+
+// Forwards allocations and records the size of the largest one. Every
+// live allocation holds a reference to the recorder.
+class OutputSizeRecorder::RecordingAllocator : public Allocator {
+ public:
+  RecordingAllocator(OutputSizeRecorder* recorder, Allocator* allocator)
+      : recorder_(recorder), allocator_(allocator) {}
+
+  string Name() override { return allocator_->Name(); }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    void* ptr = allocator_->AllocateRaw(alignment, num_bytes);
+    if (ptr != nullptr) {
+      recorder_->Ref();
+      int64 prev = max_bytes_.load(std::memory_order_relaxed);
+      while (static_cast<int64>(num_bytes) > prev &&
+             !max_bytes_.compare_exchange_weak(prev, num_bytes)) {
+      }
+    }
+    return ptr;
+  }
+
+  void DeallocateRaw(void* ptr) override {
+    allocator_->DeallocateRaw(ptr);
+    recorder_->Unref();
+  }
+
+  int64 max_bytes() const { return max_bytes_.load(); }
+
+ private:
+  OutputSizeRecorder* const recorder_;
+  Allocator* const allocator_;
+  std::atomic<int64> max_bytes_{0};
+};
+
+OutputSizeRecorder::OutputSizeRecorder(const Graph& graph,
+                                       Allocator* allocator) {
+  node_allocators_.resize(graph.num_node_ids());
+  for (const Node* n : graph.nodes()) {
+    std::vector<Allocator*>* node_allocators = &node_allocators_[n->id()];
+    node_allocators->resize(n->num_outputs(), nullptr);
+    for (int slot = 0; slot < n->num_outputs(); ++slot) {
+      if (!CanPlanOutput(n, slot)) continue;
+      allocators_.emplace_back(new RecordingAllocator(this, allocator));
+      (*node_allocators)[slot] = allocators_.back().get();
+    }
+  }
+}
+
+OutputSizeRecorder::~OutputSizeRecorder() {}
+
+std::vector<PlannedBuffer> OutputSizeRecorder::RecordedBuffers(
+    const Graph& graph) const {
+  std::vector<PlannedBuffer> buffers;
+  for (const Node* n : graph.nodes()) {
+    const std::vector<Allocator*>& node_allocators = node_allocators_[n->id()];
+    for (int slot = 0; slot < node_allocators.size(); ++slot) {
+      if (node_allocators[slot] == nullptr) continue;
+      const int64 bytes =
+          static_cast<RecordingAllocator*>(node_allocators[slot])->max_bytes();
+      if (bytes == 0) continue;
+      PlannedBuffer b;
+      b.node_id = n->id();
+      b.slot = slot;
+      b.bytes = bytes;
+      buffers.push_back(b);
+    }
+  }
+  return buffers;
+}
+
+// Serves one planned buffer, or falls back to the device allocator. Every
+// live allocation holds a reference to the plan.
+class MemoryPlan::PlannedBufferAllocator : public Allocator {
+ public:
+  PlannedBufferAllocator(MemoryPlan* plan, int index)
+      : plan_(plan),
+        index_(index),
+        ptr_(plan->slab_ + plan->buffers_[index].offset),
+        bytes_(plan->buffers_[index].bytes) {}
+
+  string Name() override { return "memory_plan"; }
+
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    plan_->Ref();
+    if (num_bytes <= bytes_ && alignment <= kAllocatorAlignment &&
+        plan_->TryAcquire(index_)) {
+      ++plan_->num_planned_;
+      return ptr_;
+    }
+    ++plan_->num_fallbacks_;
+    void* ptr = plan_->allocator_->AllocateRaw(alignment, num_bytes);
+    if (ptr == nullptr) plan_->Unref();
+    return ptr;
+  }
+
+  void DeallocateRaw(void* ptr) override {
+    if (ptr == ptr_) {
+      plan_->Release(index_);
+    } else {
+      plan_->allocator_->DeallocateRaw(ptr);
+    }
+    plan_->Unref();
+  }
+
+ private:
+  MemoryPlan* const plan_;
+  const int index_;
+  char* const ptr_;
+  const size_t bytes_;
+};
+
+// static
+MemoryPlan* MemoryPlan::Create(const Graph& graph,
+                               std::vector<PlannedBuffer> buffers,
+                               Allocator* allocator) {
+  if (buffers.empty()) return nullptr;
+  const int64 slab_bytes = AssignBufferOffsets(graph, &buffers);
+  void* slab = allocator->AllocateRaw(Allocator::kAllocatorAlignment,
+                                      slab_bytes);
+  if (slab == nullptr) {
+    LOG(WARNING) << "Could not allocate a slab of "
+                 << strings::HumanReadableNumBytes(slab_bytes)
+                 << " for the memory plan of " << buffers.size()
+                 << " buffers";
+    return nullptr;
+  }
+
+  MemoryPlan* plan = new MemoryPlan;
+  plan->allocator_ = allocator;
+  plan->slab_ = static_cast<char*>(slab);
+  plan->slab_bytes_ = slab_bytes;
+  plan->buffers_ = std::move(buffers);
+  const int n = plan->buffers_.size();
+  plan->in_use_.resize(n, false);
+
+  // Buffers sharing memory, found by sweeping over them by offset.
+  std::vector<int> by_offset(n);
+  for (int i = 0; i < n; ++i) by_offset[i] = i;
+  std::sort(by_offset.begin(), by_offset.end(), [plan](int a, int b) {
+    return plan->buffers_[a].offset < plan->buffers_[b].offset;
+  });
+  plan->overlapping_.resize(n);
+  for (int x = 0; x < n; ++x) {
+    const PlannedBuffer& a = plan->buffers_[by_offset[x]];
+    for (int y = x + 1; y < n; ++y) {
+      const PlannedBuffer& b = plan->buffers_[by_offset[y]];
+      if (b.offset >= a.offset + a.bytes) break;
+      plan->overlapping_[by_offset[x]].push_back(by_offset[y]);
+      plan->overlapping_[by_offset[y]].push_back(by_offset[x]);
+    }
+  }
+
+  plan->node_allocators_.resize(graph.num_node_ids());
+  for (int i = 0; i < n; ++i) {
+    const PlannedBuffer& b = plan->buffers_[i];
+    std::vector<Allocator*>* node_allocators =
+        &plan->node_allocators_[b.node_id];
+    if (node_allocators->empty()) {
+      node_allocators->resize(graph.FindNodeId(b.node_id)->num_outputs(),
+                              nullptr);
+    }
+    plan->allocators_.emplace_back(new PlannedBufferAllocator(plan, i));
+    (*node_allocators)[b.slot] = plan->allocators_.back().get();
+  }
+
+  VLOG(1) << "Planned " << n << " buffers in a slab of "
+          << strings::HumanReadableNumBytes(slab_bytes);
+  return plan;
+}
+
+MemoryPlan::MemoryPlan() {}
+
+MemoryPlan::~MemoryPlan() {
+  VLOG(1) << "Memory plan served " << num_planned_.load()
+          << " allocations from its slab, " << num_fallbacks_.load()
+          << " fell back";
+  allocator_->DeallocateRaw(slab_);
+}
+
+bool MemoryPlan::TryAcquire(int index) {
+  mutex_lock l(mu_);
+  if (in_use_[index]) return false;
+  for (int other : overlapping_[index]) {
+    if (in_use_[other]) return false;
+  }
+  in_use_[index] = true;
+  return true;
+}
+
+void MemoryPlan::Release(int index) {
+  mutex_lock l(mu_);
+  in_use_[index] = false;
+}
+
+}  // namespace tensorflow
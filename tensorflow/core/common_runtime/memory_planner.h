@@ -0,0 +1,161 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_MEMORY_PLANNER_H_
+#define TENSORFLOW_COMMON_RUNTIME_MEMORY_PLANNER_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// Static memory planning for the outputs of the nodes of a graph.
+//
+// During one step, an OutputSizeRecorder observes how many bytes every
+// node output allocates.  Those sizes are turned into a MemoryPlan, which
+// places the outputs at fixed offsets of one preallocated slab, and later
+// steps allocate their outputs from the plan (see
+// OpKernelContext::Params::output_allocators).
+//
+// Two outputs share memory only if every use of one of them precedes the
+// producer of the other in the graph, so the plan is valid under any
+// schedule.  Outputs that escape the step (e.g. are fetched or stored by a
+// stateful op) are not planned.  Because kernels may still forward a
+// buffer to a longer-lived tensor, a planned buffer is only handed out
+// when no overlapping buffer is in use; otherwise, and for outputs larger
+// than planned, allocation falls back to the device allocator.
+
+// A node output placed by AssignBufferOffsets().
+struct PlannedBuffer {
+  int node_id = -1;
+  int slot = -1;
+  int64 bytes = 0;
+  int64 offset = -1;
+};
+
+// Returns true iff output "slot" of "node" may be placed in a memory plan:
+// its value does not obviously escape the step.
+bool CanPlanOutput(const Node* node, int slot);
+
+// Assigns "offset" of every buffer such that buffers whose lifetimes may
+// overlap in some execution of "graph" do not overlap in memory.  Offsets
+// are multiples of Allocator::kAllocatorAlignment.  Returns the total size
+// of the slab.  All buffers must be outputs of nodes of "graph".
+int64 AssignBufferOffsets(const Graph& graph,
+                          std::vector<PlannedBuffer>* buffers);
+
+// Records the largest allocation requested for each node output through
+// the allocators returned by output_allocators().  Like MemoryPlan, it is
+// kept alive by the allocations made through it.
+//
+// This class is thread-safe.
+class OutputSizeRecorder : public core::RefCounted {
+ public:
+  // Allocations are forwarded to "allocator", which must outlive the
+  // recorder.
+  OutputSizeRecorder(const Graph& graph, Allocator* allocator);
+
+  // Returns an array indexed by output slot for node "node_id".
+  Allocator* const* output_allocators(int node_id) const {
+    return node_allocators_[node_id].data();
+  }
+
+  // Returns the outputs that allocated memory and may be planned.
+  std::vector<PlannedBuffer> RecordedBuffers(const Graph& graph) const;
+
+ private:
+  class RecordingAllocator;
+
+  ~OutputSizeRecorder() override;
+
+  std::vector<std::unique_ptr<RecordingAllocator>> allocators_;
+  std::vector<std::vector<Allocator*>> node_allocators_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(OutputSizeRecorder);
+};
+
+// A set of node outputs placed in one slab.  Each planned buffer holds a
+// reference to the plan while it is in use, so the slab outlives tensors
+// that escape their step.
+class MemoryPlan : public core::RefCounted {
+ public:
+  // Places "buffers" with AssignBufferOffsets() and allocates the slab
+  // from "allocator", which also serves fallback allocations and must
+  // outlive the plan.  Returns nullptr if there is nothing to plan, or if
+  // the slab cannot be allocated.
+  static MemoryPlan* Create(const Graph& graph,
+                            std::vector<PlannedBuffer> buffers,
+                            Allocator* allocator);
+
+  // Returns an array indexed by output slot for node "node_id", or nullptr
+  // if none of its outputs is planned.  Entries of outputs that are not
+  // planned are nullptr.
+  Allocator* const* output_allocators(int node_id) const {
+    if (node_id >= node_allocators_.size() ||
+        node_allocators_[node_id].empty()) {
+      return nullptr;
+    }
+    return node_allocators_[node_id].data();
+  }
+
+  int64 slab_bytes() const { return slab_bytes_; }
+  int num_buffers() const { return buffers_.size(); }
+
+  // Number of allocations served from the slab, and number that fell back
+  // to the device allocator.
+  int64 num_planned_allocations() const { return num_planned_.load(); }
+  int64 num_fallback_allocations() const { return num_fallbacks_.load(); }
+
+ private:
+  class PlannedBufferAllocator;
+
+  MemoryPlan();
+  ~MemoryPlan() override;
+
+  // Marks buffer "index" as in use iff it and every buffer overlapping it
+  // are free.
+  bool TryAcquire(int index);
+  void Release(int index);
+
+  Allocator* allocator_ = nullptr;
+  char* slab_ = nullptr;
+  int64 slab_bytes_ = 0;
+  std::vector<PlannedBuffer> buffers_;
+  std::vector<std::vector<int>> overlapping_;
+  std::vector<std::unique_ptr<PlannedBufferAllocator>> allocators_;
+  std::vector<std::vector<Allocator*>> node_allocators_;
+
+  mutex mu_;
+  std::vector<bool> in_use_ GUARDED_BY(mu_);
+
+  std::atomic<int64> num_planned_{0};
+  std::atomic<int64> num_fallbacks_{0};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemoryPlan);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_MEMORY_PLANNER_H_
@@ -0,0 +1,151 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/memory_planner.h"
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/testlib.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+Tensor Scalar(float v) {
+  Tensor t(DT_FLOAT, TensorShape({}));
+  t.scalar<float>()() = v;
+  return t;
+}
+
+PlannedBuffer Buffer(const Node* n, int64 bytes) {
+  PlannedBuffer b;
+  b.node_id = n->id();
+  b.slot = 0;
+  b.bytes = bytes;
+  return b;
+}
+
+// a -> b -> c -> d
+struct Chain {
+  Chain() : g(OpRegistry::Global()) {
+    a = test::graph::Constant(&g, Scalar(1), "a");
+    b = test::graph::Identity(&g, a);
+    c = test::graph::Identity(&g, b);
+    d = test::graph::Identity(&g, c);
+    FixupSourceAndSinkEdges(&g);
+  }
+
+  std::vector<PlannedBuffer> Buffers(int64 bytes) const {
+    return {Buffer(a, bytes), Buffer(b, bytes), Buffer(c, bytes),
+            Buffer(d, bytes)};
+  }
+
+  Graph g;
+  Node* a;
+  Node* b;
+  Node* c;
+  Node* d;
+};
+
+TEST(MemoryPlannerTest, ChainSharesMemory) {
+  Chain chain;
+  std::vector<PlannedBuffer> buffers = chain.Buffers(1024);
+  EXPECT_EQ(2048, AssignBufferOffsets(chain.g, &buffers));
+  // "a" is dead once "c" runs, and "b" once "d" runs.
+  EXPECT_EQ(buffers[0].offset, buffers[2].offset);
+  EXPECT_EQ(buffers[1].offset, buffers[3].offset);
+  EXPECT_NE(buffers[0].offset, buffers[1].offset);
+}
+
+TEST(MemoryPlannerTest, ConcurrentBranchesDoNotShare) {
+  Graph g(OpRegistry::Global());
+  Node* a = test::graph::Constant(&g, Scalar(1), "a");
+  Node* x = test::graph::Identity(&g, a);
+  Node* y = test::graph::Identity(&g, a);
+  Node* out = test::graph::Add(&g, x, y);
+  FixupSourceAndSinkEdges(&g);
+
+  std::vector<PlannedBuffer> buffers = {Buffer(a, 100), Buffer(x, 256),
+                                        Buffer(y, 256), Buffer(out, 512)};
+  const int64 slab_bytes = AssignBufferOffsets(g, &buffers);
+  // "x" and "y" may be live at the same time in any order; "out" can reuse
+  // the memory of "a" but not of its inputs.
+  EXPECT_TRUE(buffers[1].offset + 256 <= buffers[2].offset ||
+              buffers[2].offset + 256 <= buffers[1].offset);
+  for (int i = 1; i < 3; ++i) {
+    EXPECT_TRUE(buffers[i].offset + 256 <= buffers[3].offset ||
+                buffers[3].offset + 512 <= buffers[i].offset);
+  }
+  EXPECT_EQ(1024, slab_bytes);
+  for (const PlannedBuffer& b : buffers) {
+    EXPECT_EQ(0, b.offset % Allocator::kAllocatorAlignment);
+  }
+}
+
+TEST(MemoryPlannerTest, DoesNotPlanEscapingOutputs) {
+  Graph g(OpRegistry::Global());
+  Node* a = test::graph::Constant(&g, Scalar(1), "a");
+  Node* b = test::graph::Identity(&g, a);
+  // "b" is stored in a variable, whose own output is a ref.
+  Node* var = test::graph::Var(&g, DT_FLOAT, TensorShape({}));
+  test::graph::Assign(&g, var, b);
+  FixupSourceAndSinkEdges(&g);
+  EXPECT_TRUE(CanPlanOutput(a, 0));
+  EXPECT_FALSE(CanPlanOutput(b, 0));
+  EXPECT_FALSE(CanPlanOutput(var, 0));
+  EXPECT_FALSE(CanPlanOutput(g.source_node(), 0));
+}
+
+TEST(MemoryPlannerTest, FallsBackWhenBufferIsBusy) {
+  Chain chain;
+  MemoryPlan* plan =
+      MemoryPlan::Create(chain.g, chain.Buffers(1024), cpu_allocator());
+  ASSERT_NE(nullptr, plan);
+  EXPECT_EQ(2048, plan->slab_bytes());
+  EXPECT_EQ(4, plan->num_buffers());
+
+  Allocator* a = plan->output_allocators(chain.a->id())[0];
+  Allocator* c = plan->output_allocators(chain.c->id())[0];
+  void* pa = a->AllocateRaw(Allocator::kAllocatorAlignment, 1024);
+  // "a" escaped past the producer of "c", which shares its memory.
+  void* pc = c->AllocateRaw(Allocator::kAllocatorAlignment, 1024);
+  EXPECT_NE(pa, pc);
+  EXPECT_EQ(1, plan->num_planned_allocations());
+  EXPECT_EQ(1, plan->num_fallback_allocations());
+  c->DeallocateRaw(pc);
+  a->DeallocateRaw(pa);
+
+  pc = c->AllocateRaw(Allocator::kAllocatorAlignment, 1024);
+  EXPECT_EQ(pa, pc);
+  EXPECT_EQ(2, plan->num_planned_allocations());
+  // Larger than planned.
+  void* big = a->AllocateRaw(Allocator::kAllocatorAlignment, 4096);
+  EXPECT_NE(nullptr, big);
+  EXPECT_EQ(2, plan->num_fallback_allocations());
+
+  // Live buffers keep the plan alive.
+  plan->Unref();
+  c->DeallocateRaw(pc);
+  a->DeallocateRaw(big);
+}
+
+TEST(MemoryPlannerTest, NoPlanWithoutBuffers) {
+  Chain chain;
+  EXPECT_EQ(nullptr, MemoryPlan::Create(chain.g, {}, cpu_allocator()));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,208 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <map>
+#include <set>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/common_runtime/optimization_registry.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/device_name_utils.h"
+
+namespace tensorflow {
+namespace {
+
+// An optimizer update that has a multi-variable counterpart. The inputs of
+// the multi-variable op are those of the update in the same order, with every
+// input that isn't in 'shared_inputs' turned into a list.
+struct MultiApplySpec {
+  const char* op;
+  const char* multi_op;
+  std::set<int> shared_inputs;
+};
+
+const std::vector<MultiApplySpec>& MultiApplySpecs() {
+  static const std::vector<MultiApplySpec>* specs =
+      new std::vector<MultiApplySpec>{
+          {"ApplyMomentum", "_MultiApplyMomentum", {2, 4}},
+          {"ApplyAdam", "_MultiApplyAdam", {3, 4, 5, 6, 7, 8}},
+      };
+  return *specs;
+}
+
+// Replaces groups of independent ApplyMomentum or ApplyAdam ops on the same
+// GPU, which share their hyperparameters, with one _MultiApplyMomentum or
+// _MultiApplyAdam op. GPUs then update all the variables of a typical
+// optimizer with a few kernel launches instead of a few per variable.
+//
+// Only updates whose output isn't used are grouped, since the multi-variable
+// ops have no outputs, and an update is left alone if it depends on another
+// update of its group, which would make a cycle.
+class MultiApplyPass : public GraphOptimizationPass {
+ public:
+  Status Run(const GraphOptimizationPassOptions& options) override {
+    if (options.graph == nullptr || options.graph->get() == nullptr) {
+      return Status::OK();
+    }
+    if (options.session_options != nullptr &&
+        options.session_options->config.graph_options()
+                .optimizer_options()
+                .opt_level() == OptimizerOptions::L0) {
+      return Status::OK();
+    }
+    Graph* g = options.graph->get();
+    for (const MultiApplySpec& spec : MultiApplySpecs()) {
+      for (auto& group : FindGroups(g, spec)) {
+        TF_RETURN_IF_ERROR(Rewrite(g, spec, RemoveDependent(group.second)));
+      }
+    }
+    return Status::OK();
+  }
+
+ private:
+  // Identifies the updates that can share a multi-variable op: the device,
+  // the attrs, and the sources of the shared inputs.
+  typedef std::tuple<string, DataType, bool, bool,
+                     std::vector<std::pair<int, int>>>
+      GroupKey;
+
+  static std::map<GroupKey, std::vector<Node*>> FindGroups(
+      Graph* g, const MultiApplySpec& spec) {
+    std::map<GroupKey, std::vector<Node*>> groups;
+    for (Node* n : g->op_nodes()) {
+      if (n->type_string() != spec.op) continue;
+      DeviceNameUtils::ParsedName device;
+      if (!DeviceNameUtils::ParseFullName(n->assigned_device_name(),
+                                          &device) ||
+          device.type != DEVICE_GPU) {
+        continue;
+      }
+      bool output_used = false;
+      for (const Edge* e : n->out_edges()) {
+        if (!e->IsControlEdge()) output_used = true;
+      }
+      if (output_used) continue;
+      DataType dtype;
+      bool use_locking, use_nesterov;
+      if (!GetNodeAttr(n->attrs(), "T", &dtype).ok() ||
+          !GetNodeAttr(n->attrs(), "use_locking", &use_locking).ok() ||
+          !GetNodeAttr(n->attrs(), "use_nesterov", &use_nesterov).ok()) {
+        continue;
+      }
+      std::vector<const Edge*> inputs;
+      if (!n->input_edges(&inputs).ok()) continue;
+      std::vector<std::pair<int, int>> shared;
+      for (int i : spec.shared_inputs) {
+        shared.emplace_back(inputs[i]->src()->id(), inputs[i]->src_output());
+      }
+      groups[GroupKey(n->assigned_device_name(), dtype, use_locking,
+                      use_nesterov, shared)]
+          .push_back(n);
+    }
+    return groups;
+  }
+
+  // Returns the members of 'group' that don't depend on other members.
+  static std::vector<Node*> RemoveDependent(const std::vector<Node*>& group) {
+    if (group.size() < 2) return {};
+    std::unordered_set<const Node*> reached;
+    std::vector<const Node*> stack;
+    for (const Node* n : group) {
+      for (const Node* out : n->out_nodes()) stack.push_back(out);
+    }
+    while (!stack.empty()) {
+      const Node* n = stack.back();
+      stack.pop_back();
+      if (!reached.insert(n).second) continue;
+      for (const Node* out : n->out_nodes()) stack.push_back(out);
+    }
+    std::vector<Node*> independent;
+    for (Node* n : group) {
+      if (reached.count(n) == 0) independent.push_back(n);
+    }
+    return independent;
+  }
+
+  static Status Rewrite(Graph* g, const MultiApplySpec& spec,
+                        const std::vector<Node*>& group) {
+    if (group.size() < 2) return Status::OK();
+    Node* first = group[0];
+    std::vector<const Edge*> first_inputs;
+    TF_RETURN_IF_ERROR(first->input_edges(&first_inputs));
+
+    NodeBuilder builder(g->NewName(strings::StrCat(first->name(), "/Multi")),
+                        spec.multi_op);
+    std::set<Node*> control_inputs;
+    std::set<Node*> control_outputs;
+    std::vector<std::vector<NodeBuilder::NodeOut>> lists(first_inputs.size());
+    for (Node* n : group) {
+      std::vector<const Edge*> inputs;
+      TF_RETURN_IF_ERROR(n->input_edges(&inputs));
+      for (size_t i = 0; i < inputs.size(); ++i) {
+        lists[i].emplace_back(inputs[i]->src(), inputs[i]->src_output());
+      }
+      for (const Edge* e : n->in_edges()) {
+        if (e->IsControlEdge()) control_inputs.insert(e->src());
+      }
+      for (const Edge* e : n->out_edges()) {
+        control_outputs.insert(e->dst());
+      }
+    }
+    for (size_t i = 0; i < first_inputs.size(); ++i) {
+      if (spec.shared_inputs.count(i) != 0) {
+        builder.Input(first_inputs[i]->src(), first_inputs[i]->src_output());
+      } else {
+        builder.Input(lists[i]);
+      }
+    }
+    for (Node* n : control_inputs) {
+      builder.ControlInput(n);
+    }
+    DataType dtype;
+    TF_RETURN_IF_ERROR(GetNodeAttr(first->attrs(), "T", &dtype));
+    bool use_locking, use_nesterov;
+    TF_RETURN_IF_ERROR(
+        GetNodeAttr(first->attrs(), "use_locking", &use_locking));
+    TF_RETURN_IF_ERROR(
+        GetNodeAttr(first->attrs(), "use_nesterov", &use_nesterov));
+    Node* multi;
+    TF_RETURN_IF_ERROR(builder.Attr("N", static_cast<int>(group.size()))
+                           .Attr("T", dtype)
+                           .Attr("use_locking", use_locking)
+                           .Attr("use_nesterov", use_nesterov)
+                           .Finalize(g, &multi));
+    multi->set_assigned_device_name(first->assigned_device_name());
+    for (Node* n : control_outputs) {
+      g->AddControlEdge(multi, n);
+    }
+    VLOG(1) << "Replaced " << group.size() << " " << spec.op << " ops with "
+            << multi->name();
+    for (Node* n : group) {
+      g->RemoveNode(n);
+    }
+    return Status::OK();
+  }
+};
+REGISTER_OPTIMIZATION(OptimizationPassRegistry::POST_REWRITE_FOR_EXEC, 0,
+                      MultiApplyPass);
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,153 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/optimization_registry.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+const char kGpu[] = "/job:localhost/replica:0/task:0/gpu:0";
+
+class MultiApplyTest : public ::testing::Test {
+ protected:
+  MultiApplyTest() : g_(new Graph(OpRegistry::Global())) {}
+
+  Node* Var(const string& name) {
+    Node* n;
+    TF_CHECK_OK(NodeBuilder(name, "VariableV2")
+                    .Attr("shape", TensorShape({2}))
+                    .Attr("dtype", DT_FLOAT)
+                    .Finalize(g_.get(), &n));
+    n->set_assigned_device_name(kGpu);
+    return n;
+  }
+
+  Node* Placeholder(const string& name) {
+    Node* n;
+    TF_CHECK_OK(NodeBuilder(name, "Placeholder")
+                    .Attr("dtype", DT_FLOAT)
+                    .Finalize(g_.get(), &n));
+    n->set_assigned_device_name(kGpu);
+    return n;
+  }
+
+  Node* ApplyMomentum(const string& name, Node* lr, Node* momentum) {
+    Node* n;
+    TF_CHECK_OK(NodeBuilder(name, "ApplyMomentum")
+                    .Input(Var(strings::StrCat(name, "/var")))
+                    .Input(Var(strings::StrCat(name, "/accum")))
+                    .Input(lr)
+                    .Input(Placeholder(strings::StrCat(name, "/grad")))
+                    .Input(momentum)
+                    .Finalize(g_.get(), &n));
+    n->set_assigned_device_name(kGpu);
+    return n;
+  }
+
+  void Optimize() {
+    GraphOptimizationPassOptions opts;
+    opts.graph = &g_;
+    TF_CHECK_OK(OptimizationPassRegistry::Global()->RunGrouping(
+        OptimizationPassRegistry::POST_REWRITE_FOR_EXEC, opts));
+  }
+
+  int Count(const string& op) {
+    int count = 0;
+    for (const Node* n : g_->op_nodes()) {
+      if (n->type_string() == op) ++count;
+    }
+    return count;
+  }
+
+  std::unique_ptr<Graph> g_;
+};
+
+TEST_F(MultiApplyTest, GroupsIndependentUpdates) {
+  Node* lr = Placeholder("lr");
+  Node* momentum = Placeholder("momentum");
+  Node* train;
+  TF_ASSERT_OK(NodeBuilder("train", "NoOp").Finalize(g_.get(), &train));
+  for (int i = 0; i < 3; ++i) {
+    Node* update = ApplyMomentum(strings::StrCat("update", i), lr, momentum);
+    g_->AddControlEdge(update, train);
+  }
+  Optimize();
+  EXPECT_EQ(0, Count("ApplyMomentum"));
+  ASSERT_EQ(1, Count("_MultiApplyMomentum"));
+  for (const Node* n : g_->op_nodes()) {
+    if (n->type_string() != "_MultiApplyMomentum") continue;
+    EXPECT_EQ(kGpu, n->assigned_device_name());
+    // 3 variables, 3 accumulators, lr, 3 gradients and momentum.
+    EXPECT_EQ(11, n->num_inputs());
+    ASSERT_EQ(1, n->out_edges().size());
+    const Edge* out = *n->out_edges().begin();
+    EXPECT_TRUE(out->IsControlEdge());
+    EXPECT_EQ(train, out->dst());
+  }
+}
+
+TEST_F(MultiApplyTest, KeepsUpdatesWithDifferentHyperparameters) {
+  Node* momentum = Placeholder("momentum");
+  ApplyMomentum("update0", Placeholder("lr0"), momentum);
+  ApplyMomentum("update1", Placeholder("lr1"), momentum);
+  Optimize();
+  EXPECT_EQ(2, Count("ApplyMomentum"));
+  EXPECT_EQ(0, Count("_MultiApplyMomentum"));
+}
+
+TEST_F(MultiApplyTest, KeepsUpdatesOnCpu) {
+  Node* lr = Placeholder("lr");
+  Node* momentum = Placeholder("momentum");
+  ApplyMomentum("update0", lr, momentum)
+      ->set_assigned_device_name("/job:localhost/replica:0/task:0/cpu:0");
+  ApplyMomentum("update1", lr, momentum)
+      ->set_assigned_device_name("/job:localhost/replica:0/task:0/cpu:0");
+  Optimize();
+  EXPECT_EQ(2, Count("ApplyMomentum"));
+}
+
+TEST_F(MultiApplyTest, KeepsDependentUpdates) {
+  Node* lr = Placeholder("lr");
+  Node* momentum = Placeholder("momentum");
+  Node* first = ApplyMomentum("update0", lr, momentum);
+  Node* second = ApplyMomentum("update1", lr, momentum);
+  g_->AddControlEdge(first, second);
+  Optimize();
+  // 'second' depends on 'first', so only one update is independent.
+  EXPECT_EQ(2, Count("ApplyMomentum"));
+  EXPECT_EQ(0, Count("_MultiApplyMomentum"));
+}
+
+TEST_F(MultiApplyTest, KeepsUpdatesWithUsedOutputs) {
+  Node* lr = Placeholder("lr");
+  Node* momentum = Placeholder("momentum");
+  Node* update = ApplyMomentum("update0", lr, momentum);
+  ApplyMomentum("update1", lr, momentum);
+  Node* identity;
+  TF_ASSERT_OK(NodeBuilder("identity", "Identity")
+                   .Input(update)
+                   .Finalize(g_.get(), &identity));
+  Optimize();
+  EXPECT_EQ(2, Count("ApplyMomentum"));
+}
+
+}  // namespace
+}  // namespace tensorflow
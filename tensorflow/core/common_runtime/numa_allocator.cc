@@ -0,0 +1,48 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/numa_allocator.h"
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/bfc_allocator.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+namespace {
+
+// The BFC regions of a node grow as needed up to this many bytes.
+constexpr size_t kMaxNUMANodeMemory = static_cast<size_t>(1) << 40;
+
+}  // namespace
+
+Allocator* NUMACPUAllocator(int numa_node) {
+  static const std::vector<Allocator*>* allocators = [] {
+    auto* allocators = new std::vector<Allocator*>;
+    for (int node = 0; node < port::NUMANumNodes(); ++node) {
+      allocators->push_back(new BFCAllocator(
+          new NUMASubAllocator(node), kMaxNUMANodeMemory,
+          /*allow_growth=*/true, strings::StrCat("numa_cpu_", node)));
+    }
+    return allocators;
+  }();
+  CHECK_GE(numa_node, 0);
+  CHECK_LT(numa_node, allocators->size());
+  return (*allocators)[numa_node];
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,47 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_NUMA_ALLOCATOR_H_
+#define TENSORFLOW_COMMON_RUNTIME_NUMA_ALLOCATOR_H_
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/platform/numa.h"
+
+namespace tensorflow {
+
+// A SubAllocator of host memory placed on one NUMA node.
+class NUMASubAllocator : public SubAllocator {
+ public:
+  explicit NUMASubAllocator(int numa_node) : numa_node_(numa_node) {}
+  ~NUMASubAllocator() override {}
+
+  void* Alloc(size_t alignment, size_t num_bytes) override {
+    return port::NUMAMalloc(numa_node_, num_bytes, alignment);
+  }
+  void Free(void* ptr, size_t num_bytes) override {
+    port::NUMAFree(ptr, num_bytes);
+  }
+
+ private:
+  const int numa_node_;
+};
+
+// Returns the process-wide allocator of host memory on the given node of
+// port::NUMANumNodes(): a growing BFCAllocator over a NUMASubAllocator.
+Allocator* NUMACPUAllocator(int numa_node);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_NUMA_ALLOCATOR_H_
@@ -28,19 +28,36 @@ namespace tensorflow {
 namespace {
 
 static thread::ThreadPool* InitComputePool(const SessionOptions& options) {
-  int32 inter_op_parallelism_threads =
-      options.config.inter_op_parallelism_threads();
-  if (inter_op_parallelism_threads == 0) {
-    // Default to using the number of cores available in the process.
-    inter_op_parallelism_threads = port::NumSchedulableCPUs();
-  }
+  const ThreadPoolOptionProto& pool_options =
+      options.config.inter_op_thread_pool_options();
+  const int32 inter_op_parallelism_threads = NumThreadsOrDefault(
+      options.config.inter_op_parallelism_threads(), pool_options);
 
-  return new thread::ThreadPool(Env::Default(), "Compute",
-                                inter_op_parallelism_threads);
+  return new thread::ThreadPool(
+      Env::Default(), ThreadOptionsFromPoolOptions(pool_options), "Compute",
+      inter_op_parallelism_threads, !pool_options.disable_spinning());
 }
 
 }  // namespace
 
+ThreadOptions ThreadOptionsFromPoolOptions(
+    const ThreadPoolOptionProto& pool_options) {
+  ThreadOptions thread_options;
+  thread_options.cpu_affinity.assign(pool_options.cpu_affinity().begin(),
+                                     pool_options.cpu_affinity().end());
+  return thread_options;
+}
+
+int32 NumThreadsOrDefault(int32 num_threads,
+                          const ThreadPoolOptionProto& pool_options) {
+  if (num_threads != 0) return num_threads;
+  if (pool_options.cpu_affinity_size() > 0) {
+    return pool_options.cpu_affinity_size();
+  }
+  // Default to using the number of cores available in the process.
+  return port::NumSchedulableCPUs();
+}
+
 thread::ThreadPool* ComputePool(const SessionOptions& options) {
   static thread::ThreadPool* compute_pool = InitComputePool(options);
   return compute_pool;
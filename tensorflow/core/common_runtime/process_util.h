@@ -30,6 +30,18 @@ namespace tensorflow {
 // using 'options'.  Caller does not take ownership over threadpool.
 thread::ThreadPool* ComputePool(const SessionOptions& options);
 
+// Returns the options of the threads of a pool configured by
+// "pool_options": its cpu_affinity. Whether they spin is up to the pool, see
+// ThreadPoolOptionProto.disable_spinning.
+ThreadOptions ThreadOptionsFromPoolOptions(
+    const ThreadPoolOptionProto& pool_options);
+
+// Returns "num_threads" if it is not 0, and otherwise the default size of
+// a pool configured by "pool_options": one thread per CPU of its
+// cpu_affinity, or per CPU the process may be scheduled on.
+int32 NumThreadsOrDefault(int32 num_threads,
+                          const ThreadPoolOptionProto& pool_options);
+
 // Schedule "closure" in the default thread queue.
 void SchedClosure(std::function<void()> closure);
 
@@ -57,12 +57,9 @@ class IntraProcessRendezvous : public Rendezvous {
 
  private:
   const DeviceMgr* device_mgr_;
-  Rendezvous* local_;  // Owns a Ref on this object.
-
-  mutable mutex mu_;
-
-  // Status given by StartAbort() if any.
-  Status status_ GUARDED_BY(mu_);
+  // Owns a Ref on this object. Aborts are recorded by local_, which
+  // Send() and RecvAsync() forward to without extra locking.
+  Rendezvous* local_;
 
   ~IntraProcessRendezvous() override;
 
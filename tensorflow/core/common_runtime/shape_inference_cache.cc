@@ -0,0 +1,152 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/shape_inference_cache.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/protobuf.h"
+
+namespace tensorflow {
+
+using shape_inference::InferenceContext;
+using shape_inference::ShapeHandle;
+
+namespace {
+
+// Appends the rank and the dimensions of "s" to "*key".
+void AppendShape(InferenceContext* c, ShapeHandle s, string* key) {
+  const int32 rank = c->Rank(s);
+  core::PutVarint32(key, rank == InferenceContext::kUnknownRank
+                             ? 0
+                             : static_cast<uint32>(rank) + 1);
+  for (int32 i = 0; i < rank; ++i) {
+    // Unknown dimensions are -1; shift them to stay unsigned.
+    core::PutVarint64(key, c->Value(c->Dim(s, i)) + 1);
+  }
+}
+
+}  // namespace
+
+ShapeInferenceCache::ShapeInferenceCache(int64 max_entries)
+    : max_entries_(max_entries) {}
+
+/* static */ ShapeInferenceCache* ShapeInferenceCache::Global() {
+  static ShapeInferenceCache* cache = new ShapeInferenceCache(1 << 20);
+  return cache;
+}
+
+/* static */ Fprint128 ShapeInferenceCache::Key(int graph_def_version,
+                                                const NodeDef& ndef,
+                                                InferenceContext* c) {
+  string key = strings::StrCat(graph_def_version, "|", ndef.op(), "|");
+  // Attrs starting with '_' are not op attrs, so shape functions don't
+  // read them, and they often differ between otherwise identical nodes
+  // (e.g. "_output_shapes"). The others are added in name order, each
+  // value serialized deterministically.
+  std::vector<const string*> names;
+  names.reserve(ndef.attr_size());
+  for (const auto& kv : ndef.attr()) {
+    if (kv.first.empty() || kv.first[0] != '_') names.push_back(&kv.first);
+  }
+  std::sort(names.begin(), names.end(),
+            [](const string* a, const string* b) { return *a < *b; });
+  for (const string* name : names) {
+    const AttrValue& value = ndef.attr().at(*name);
+    strings::StrAppend(&key, *name, "=");
+    const int size = value.ByteSize();
+    core::PutVarint32(&key, size);
+    const size_t offset = key.size();
+    key.resize(offset + size);
+    protobuf::io::ArrayOutputStream array_stream(&key[offset], size);
+    protobuf::io::CodedOutputStream output_stream(&array_stream);
+    output_stream.SetSerializationDeterministic(true);
+    value.SerializeWithCachedSizes(&output_stream);
+  }
+  key.push_back('|');
+  for (int i = 0; i < c->num_inputs(); ++i) {
+    AppendShape(c, c->input(i), &key);
+  }
+  return Fingerprint128(key);
+}
+
+/* static */ std::vector<ShapeInferenceCache::Output>
+ShapeInferenceCache::Outputs(InferenceContext* c) {
+  std::vector<Output> outputs(c->num_outputs());
+  for (int i = 0; i < c->num_outputs(); ++i) {
+    const ShapeHandle s = c->output(i);
+    outputs[i].input = -1;
+    for (int j = 0; j < c->num_inputs(); ++j) {
+      if (s.SameHandle(c->input(j))) {
+        outputs[i].input = j;
+        break;
+      }
+    }
+    if (outputs[i].input < 0 && c->RankKnown(s)) {
+      std::vector<int64> dims(c->Rank(s));
+      for (int d = 0; d < dims.size(); ++d) {
+        dims[d] = c->Value(c->Dim(s, d));
+      }
+      outputs[i].shape = PartialTensorShape(dims);
+    }
+  }
+  return outputs;
+}
+
+/* static */ Status ShapeInferenceCache::SetOutputs(
+    const std::vector<Output>& outputs, InferenceContext* c) {
+  if (outputs.size() != c->num_outputs()) {
+    return errors::Internal("Cached ", outputs.size(),
+                            " output shapes for a node with ",
+                            c->num_outputs(), " outputs");
+  }
+  for (int i = 0; i < outputs.size(); ++i) {
+    ShapeHandle s;
+    if (outputs[i].input >= 0) {
+      s = c->input(outputs[i].input);
+    } else {
+      TF_RETURN_IF_ERROR(
+          c->MakeShapeFromPartialTensorShape(outputs[i].shape, &s));
+    }
+    c->set_output(i, s);
+  }
+  return Status::OK();
+}
+
+bool ShapeInferenceCache::Lookup(const Fprint128& key,
+                                 std::vector<Output>* outputs) const {
+  mutex_lock l(mu_);
+  auto it = outputs_.find(key);
+  if (it == outputs_.end()) return false;
+  *outputs = it->second;
+  return true;
+}
+
+void ShapeInferenceCache::Insert(const Fprint128& key,
+                                 std::vector<Output> outputs) {
+  mutex_lock l(mu_);
+  if (outputs_.size() >= max_entries_) return;
+  outputs_.emplace(key, std::move(outputs));
+}
+
+int64 ShapeInferenceCache::size() const {
+  mutex_lock l(mu_);
+  return outputs_.size();
+}
+
+}  // namespace tensorflow
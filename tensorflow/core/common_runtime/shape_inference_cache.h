@@ -0,0 +1,99 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_SHAPE_INFERENCE_CACHE_H_
+#define TENSORFLOW_COMMON_RUNTIME_SHAPE_INFERENCE_CACHE_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/shape_inference.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A cache of the results of shape functions, keyed by the op and attrs of
+// the node and the shapes of its inputs, which ShapeRefiners of a process
+// can share.
+//
+// Importing a graph runs the shape function of every node, and grappler
+// imports the same graph again for each optimization pass, so startup
+// repeats the same inference many times for large models.
+//
+// Only the results of shape functions which didn't ask for the values of
+// input tensors, and which neither consume nor produce the shapes of
+// resource handles, are cached, since those depend on more than the key.
+// An output which was the shape of an input is replayed as that input's
+// shape; other outputs are replayed as new shapes, without the identity of
+// the unknown dimensions they shared with inputs or other outputs.
+//
+// This class is thread-safe.
+class ShapeInferenceCache {
+ public:
+  // The cache stops adding entries once it holds "max_entries".
+  explicit ShapeInferenceCache(int64 max_entries);
+
+  // Returns the cache shared by the ShapeRefiners of the process which
+  // opted in.
+  static ShapeInferenceCache* Global();
+
+  // The shape of an output of a node: either the shape of its input "input",
+  // or "shape" if "input" is -1.
+  struct Output {
+    int input;
+    PartialTensorShape shape;
+  };
+
+  // Returns the key of running the shape function of "ndef" in "c", given
+  // the shapes of its inputs in "c" and "graph_def_version".
+  static Fprint128 Key(int graph_def_version, const NodeDef& ndef,
+                       shape_inference::InferenceContext* c);
+
+  // Returns the outputs of "c" as they are cached.
+  static std::vector<Output> Outputs(shape_inference::InferenceContext* c);
+
+  // Sets the outputs of "c" to "outputs".
+  static Status SetOutputs(const std::vector<Output>& outputs,
+                           shape_inference::InferenceContext* c);
+
+  // If the cache holds the outputs for "key", copies them to "*outputs" and
+  // returns true.
+  bool Lookup(const Fprint128& key, std::vector<Output>* outputs) const;
+
+  // Caches "outputs" for "key", unless the cache is full.
+  void Insert(const Fprint128& key, std::vector<Output> outputs);
+
+  // Returns the number of cached keys.
+  int64 size() const;
+
+ private:
+  const int64 max_entries_;
+
+  mutable mutex mu_;
+  std::unordered_map<Fprint128, std::vector<Output>, Fprint128Hasher> outputs_
+      GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ShapeInferenceCache);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_SHAPE_INFERENCE_CACHE_H_
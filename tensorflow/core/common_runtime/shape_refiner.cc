@@ -102,9 +102,41 @@ Status ShapeRefiner::AddNode(const Node* node) {
     return c->construction_status();
   }
 
+  // Results involving the shapes of resource handles are not cached.
+  bool use_cache = shape_inference_cache_ != nullptr &&
+                   op_reg_data->shape_inference_fn != nullptr;
+  for (int i = 0; use_cache && i < c->num_inputs(); ++i) {
+    use_cache = c->input_handle_shapes_and_types(i) == nullptr;
+  }
+  Fprint128 cache_key;
+  std::vector<ShapeInferenceCache::Output> cached_outputs;
+  if (use_cache) {
+    cache_key =
+        ShapeInferenceCache::Key(graph_def_version_, node->def(), c.get());
+    if (shape_inference_cache_->Lookup(cache_key, &cached_outputs)) {
+      TF_RETURN_IF_ERROR(
+          ShapeInferenceCache::SetOutputs(cached_outputs, c.get()));
+      node_to_context_[node].swap(c);
+      return Status::OK();
+    }
+  }
+
   // Run the shape inference function, and return if there was an error.
   TF_RETURN_IF_ERROR(RunShapeFn(node, op_reg_data, c.get()));
 
+  // The result can be cached if it only depends on the input shapes.
+  for (int i = 0; use_cache && i < c->num_inputs(); ++i) {
+    use_cache = !c->requested_input_tensor(i) &&
+                !c->requested_input_tensor_as_partial_shape(i);
+  }
+  for (int i = 0; use_cache && i < c->num_outputs(); ++i) {
+    use_cache = c->output_handle_shapes_and_types(i) == nullptr;
+  }
+  if (use_cache) {
+    shape_inference_cache_->Insert(cache_key,
+                                   ShapeInferenceCache::Outputs(c.get()));
+  }
+
   // Store the resulting InferenceContext object in the map.
   node_to_context_[node].swap(c);
 
@@ -18,6 +18,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/common_runtime/graph_runner.h"
+#include "tensorflow/core/common_runtime/shape_inference_cache.h"
 #include "tensorflow/core/framework/shape_inference.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -85,6 +86,13 @@ class ShapeRefiner {
     require_shape_inference_fns_ = require_shape_inference_fns;
   }
 
+  // Makes AddNode() reuse the results of shape functions cached in "cache",
+  // which must outlive *this, and cache the results it computes. See
+  // ShapeInferenceCache for what is cached.
+  void set_shape_inference_cache(ShapeInferenceCache* cache) {
+    shape_inference_cache_ = cache;
+  }
+
  private:
   friend class ShapeRefinerTest;
   friend class ::tensorflow::grappler::GraphProperties;
@@ -174,6 +182,8 @@ class ShapeRefiner {
 
   bool require_shape_inference_fns_ = true;
 
+  ShapeInferenceCache* shape_inference_cache_ = nullptr;  // Not owned.
+
   TF_DISALLOW_COPY_AND_ASSIGN(ShapeRefiner);
 };
 
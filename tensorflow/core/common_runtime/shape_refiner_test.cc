@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow/cc/framework/scope.h"
 #include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/common_runtime/shape_inference_cache.h"
 #include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/graph/testlib.h"
@@ -91,6 +92,39 @@ TEST_F(ShapeRefinerTest, MatMul) {
   EXPECT_SHAPE("[2,2]", m, mm, 0);
 }
 
+TEST_F(ShapeRefinerTest, ShapeInferenceCache) {
+  Scope root = Scope::NewRootScope();
+  auto a = ops::Placeholder(
+      root, DT_FLOAT, ops::Placeholder::Shape(PartialTensorShape({-1, 2})));
+  auto neg = ops::Neg(root, a);
+  auto b = ops::Const(root, {{1.0f}, {2.0f}});
+  auto mm = ops::MatMul(root, neg, b);
+  // Reshape asks for the value of its shape input, so it isn't cached.
+  auto shape = ops::Const(root, {1, 2});
+  auto reshape = ops::Reshape(root, b, shape);
+
+  ShapeInferenceCache cache(100);
+  for (int i = 0; i < 2; ++i) {
+    ShapeRefiner m(TF_GRAPH_DEF_VERSION, OpRegistry::Global());
+    m.set_shape_inference_cache(&cache);
+    TF_ASSERT_OK(m.AddNode(a.node()));
+    TF_ASSERT_OK(m.AddNode(neg.node()));
+    TF_ASSERT_OK(m.AddNode(b.node()));
+    TF_ASSERT_OK(m.AddNode(mm.node()));
+    TF_ASSERT_OK(m.AddNode(shape.node()));
+    TF_ASSERT_OK(m.AddNode(reshape.node()));
+    // The second refiner only runs the shape function of Reshape.
+    EXPECT_EQ(5, cache.size());
+
+    EXPECT_SHAPE("[?,2]", m, a, 0);
+    EXPECT_SHAPE("[?,2]", m, neg, 0);
+    shape_inference::InferenceContext* ctx = m.GetContext(neg.node());
+    EXPECT_TRUE(SameHandle(ctx->input(0), ctx->output(0)));
+    EXPECT_SHAPE("[?,1]", m, mm, 0);
+    EXPECT_SHAPE("[1,2]", m, reshape, 0);
+  }
+}
+
 TEST_F(ShapeRefinerTest, InvalidOrder) {
   ShapeRefiner m(TF_GRAPH_DEF_VERSION, OpRegistry::Global());
   Scope root = Scope::NewRootScope();
@@ -0,0 +1,117 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/shared_kernel_cache.h"
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/protobuf.h"
+
+namespace tensorflow {
+
+namespace {
+
+// Returns the fingerprint of "ndef" for "device" and "graph_def_version",
+// with the attrs of "ndef" serialized in a deterministic order.
+Fprint128 KernelKey(const DeviceAttributes& device, int graph_def_version,
+                    const NodeDef& ndef) {
+  string buf =
+      strings::StrCat(device.name(), "|", device.physical_device_desc(), "|",
+                      graph_def_version, "|");
+  const int size = ndef.ByteSize();
+  const size_t offset = buf.size();
+  buf.resize(offset + size);
+  protobuf::io::ArrayOutputStream array_stream(&buf[offset], size);
+  protobuf::io::CodedOutputStream output_stream(&array_stream);
+  output_stream.SetSerializationDeterministic(true);
+  ndef.SerializeWithCachedSizes(&output_stream);
+  return Fingerprint128(buf);
+}
+
+}  // namespace
+
+SharedKernelCache::~SharedKernelCache() {
+  for (auto& kv : by_key_) {
+    delete kv.second->kernel;
+    delete kv.second;
+  }
+}
+
+/* static */ SharedKernelCache* SharedKernelCache::Global() {
+  static SharedKernelCache* cache = new SharedKernelCache;
+  return cache;
+}
+
+/* static */ bool SharedKernelCache::IsShareable(const NodeDef& ndef) {
+  for (const auto& kv : ndef.attr()) {
+    if (kv.second.value_case() == AttrValue::kTensor) return true;
+  }
+  return false;
+}
+
+Status SharedKernelCache::FindOrCreate(const DeviceAttributes& device,
+                                       int graph_def_version,
+                                       const NodeDef& ndef, OpKernel** kernel,
+                                       CreateKernelFn create_fn) {
+  const Fprint128 key = KernelKey(device, graph_def_version, ndef);
+  {
+    mutex_lock l(mu_);
+    auto it = by_key_.find(key);
+    if (it != by_key_.end()) {
+      ++it->second->refs;
+      *kernel = it->second->kernel;
+      return Status::OK();
+    }
+  }
+  // The kernel is created without holding the lock, since that is the
+  // expensive part. If another thread created it in the meantime, ours is
+  // dropped.
+  OpKernel* created = nullptr;
+  TF_RETURN_IF_ERROR(create_fn(&created));
+  mutex_lock l(mu_);
+  Entry*& entry = by_key_[key];
+  if (entry == nullptr) {
+    entry = new Entry{key, created, 0};
+    by_kernel_[created] = entry;
+  } else {
+    delete created;
+  }
+  ++entry->refs;
+  *kernel = entry->kernel;
+  return Status::OK();
+}
+
+bool SharedKernelCache::Release(OpKernel* kernel) {
+  Entry* entry;
+  {
+    mutex_lock l(mu_);
+    auto it = by_kernel_.find(kernel);
+    if (it == by_kernel_.end()) return false;
+    entry = it->second;
+    if (--entry->refs > 0) return true;
+    by_kernel_.erase(it);
+    by_key_.erase(entry->key);
+  }
+  delete entry->kernel;
+  delete entry;
+  return true;
+}
+
+int64 SharedKernelCache::size() const {
+  mutex_lock l(mu_);
+  return by_key_.size();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,105 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_SHARED_KERNEL_CACHE_H_
+#define TENSORFLOW_COMMON_RUNTIME_SHARED_KERNEL_CACHE_H_
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+#include "tensorflow/core/framework/device_attributes.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A process-wide cache of OpKernels that are shared by the executors of
+// all sessions, keyed by the content of their NodeDef.
+//
+// OpSegment only shares kernels between the executors of one session.
+// Sessions created for the same model construct every kernel again, which
+// is expensive for kernels that convert large attributes in their
+// constructor, like the tensor of a Const. Such kernels have no state
+// beyond what they compute from their NodeDef, so one instance can serve
+// every session with an identical node on the same physical device.
+//
+// The entries are reference counted by the executors holding them, and the
+// kernels are deleted when the last one releases them.
+//
+// This class is thread-safe.
+class SharedKernelCache {
+ public:
+  SharedKernelCache() {}
+  ~SharedKernelCache();
+
+  // Returns the cache shared by the sessions of the process.
+  static SharedKernelCache* Global();
+
+  // Returns true if kernels of "ndef" are worth sharing: those with a
+  // tensor-valued attr. The caller must check that the op is stateless
+  // and is not a function call, whose kernel refers to the function
+  // library of its session.
+  static bool IsShareable(const NodeDef& ndef);
+
+  // Sets "*kernel" to a kernel of "ndef" for the device "device" and the
+  // graph version "graph_def_version", created by "create_fn" if the cache
+  // holds none, and takes a reference on it. If "create_fn" fails, returns
+  // the error and nothing is cached.
+  //
+  // Devices are told apart by their name and their physical device: the
+  // sessions of a process may give the same name to different GPUs (see
+  // GPUOptions.visible_device_list), and a kernel may hold memory of the
+  // device it was created for.
+  //
+  // The cache keeps the ownership of "*kernel": callers must Release() it
+  // instead of deleting it.
+  typedef std::function<Status(OpKernel**)> CreateKernelFn;
+  Status FindOrCreate(const DeviceAttributes& device, int graph_def_version,
+                      const NodeDef& ndef, OpKernel** kernel,
+                      CreateKernelFn create_fn);
+
+  // Drops a reference on "kernel", and deletes it when it was the last
+  // one. Returns false, without doing anything, if "kernel" was not
+  // returned by FindOrCreate().
+  bool Release(OpKernel* kernel);
+
+  // Returns the number of kernels in the cache.
+  int64 size() const;
+
+ private:
+  struct Entry {
+    Fprint128 key;
+    OpKernel* kernel;
+    int64 refs;
+  };
+
+  mutable mutex mu_;
+  std::unordered_map<Fprint128, Entry*, Fprint128Hasher> by_key_
+      GUARDED_BY(mu_);
+  std::unordered_map<const OpKernel*, Entry*> by_kernel_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(SharedKernelCache);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_SHARED_KERNEL_CACHE_H_
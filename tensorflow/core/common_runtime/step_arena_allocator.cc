@@ -0,0 +1,59 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <algorithm>
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+
+StepArenaAllocator::StepArenaAllocator(size_t block_size)
+    : arena_(block_size) {}
+
+void* StepArenaAllocator::AllocateRaw(size_t alignment, size_t num_bytes) {
+  void* ptr;
+  {
+    mutex_lock l(mu_);
+    // The arena returns nullptr for empty requests, which callers would
+    // take for an allocation failure.
+    ptr = arena_.AllocAligned(std::max<size_t>(num_bytes, 1), alignment);
+    if (ptr == nullptr) {
+      return nullptr;
+    }
+    ++stats_.num_allocs;
+    // Memory is only reclaimed when the arena goes away, so bytes_in_use
+    // counts every byte handed out.
+    stats_.bytes_in_use += num_bytes;
+    stats_.max_bytes_in_use = stats_.bytes_in_use;
+    stats_.max_alloc_size =
+        std::max<int64>(stats_.max_alloc_size, static_cast<int64>(num_bytes));
+  }
+  Ref();
+  return ptr;
+}
+
+void StepArenaAllocator::DeallocateRaw(void* ptr) {
+  // The memory is reclaimed with the rest of the arena.
+  Unref();
+}
+
+void StepArenaAllocator::GetStats(AllocatorStats* stats) {
+  mutex_lock l(mu_);
+  *stats = stats_;
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,65 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+#define TENSORFLOW_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
+
+#include <string>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/lib/core/arena.h"
+#include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// An allocator for host buffers that die with the step that created
+// them.  Allocations bump a pointer in a core::Arena, deallocations are
+// free, and all memory is released at once when the allocator goes away.
+//
+// The allocator is reference counted: the step holds one reference, and
+// every live allocation holds another one.  A buffer that escapes its step
+// (despite being requested with AllocatorAttributes::scoped_to_step()) thus
+// keeps the arena alive rather than being freed under its user.
+//
+// This class is thread-safe.
+class StepArenaAllocator : public Allocator, public core::RefCounted {
+ public:
+  // "block_size" is the size of the chunks requested from the system.
+  explicit StepArenaAllocator(size_t block_size = kDefaultBlockSize);
+
+  string Name() override { return "step_arena"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override;
+  void DeallocateRaw(void* ptr) override;
+  void GetStats(AllocatorStats* stats) override;
+
+  static const size_t kDefaultBlockSize = 1 << 20;
+
+ private:
+  ~StepArenaAllocator() override {}
+
+  mutex mu_;
+  core::Arena arena_ GUARDED_BY(mu_);
+  AllocatorStats stats_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(StepArenaAllocator);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_STEP_ARENA_ALLOCATOR_H_
@@ -0,0 +1,77 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/step_arena_allocator.h"
+
+#include <cstring>
+#include <vector>
+
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(StepArenaAllocatorTest, AlignedAllocations) {
+  StepArenaAllocator* a = new StepArenaAllocator(4096);
+  std::vector<void*> ptrs;
+  for (int i = 1; i < 100; ++i) {
+    void* p = a->AllocateRaw(Allocator::kAllocatorAlignment, i * 97);
+    ASSERT_NE(nullptr, p);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(p) % Allocator::kAllocatorAlignment);
+    memset(p, i, i * 97);
+    ptrs.push_back(p);
+  }
+  // Larger than a block.
+  void* big = a->AllocateRaw(Allocator::kAllocatorAlignment, 1 << 16);
+  ASSERT_NE(nullptr, big);
+  memset(big, 0, 1 << 16);
+  ptrs.push_back(big);
+
+  AllocatorStats stats;
+  a->GetStats(&stats);
+  EXPECT_EQ(100, stats.num_allocs);
+  EXPECT_EQ(1 << 16, stats.max_alloc_size);
+
+  for (int i = 1; i < 100; ++i) {
+    EXPECT_EQ(static_cast<char>(i), static_cast<char*>(ptrs[i - 1])[0]);
+  }
+  for (void* p : ptrs) {
+    a->DeallocateRaw(p);
+  }
+  EXPECT_TRUE(a->RefCountIsOne());
+  a->Unref();
+}
+
+TEST(StepArenaAllocatorTest, LiveAllocationsKeepArena) {
+  StepArenaAllocator* a = new StepArenaAllocator;
+  void* p = a->AllocateRaw(Allocator::kAllocatorAlignment, 128);
+  EXPECT_FALSE(a->RefCountIsOne());
+  // The step ends while "p" escaped it.
+  a->Unref();
+  EXPECT_TRUE(a->RefCountIsOne());
+  memset(p, 0, 128);
+  a->DeallocateRaw(p);
+}
+
+TEST(StepArenaAllocatorTest, ZeroSizedAllocation) {
+  StepArenaAllocator* a = new StepArenaAllocator;
+  void* p = a->AllocateRaw(Allocator::kAllocatorAlignment, 0);
+  EXPECT_NE(nullptr, p);
+  a->DeallocateRaw(p);
+  a->Unref();
+}
+
+}  // namespace
+}  // namespace tensorflow
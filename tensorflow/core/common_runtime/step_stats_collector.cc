@@ -19,11 +19,27 @@ limitations under the License.
 #include "tensorflow/core/graph/costmodel.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/lib/strings/scanner.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 
 namespace tensorflow {
 
-StepStatsCollector::StepStatsCollector(StepStats* ss) : step_stats_(ss) {}
+StepStatsCollector::StepStatsCollector(StepStats* ss)
+    : StepStatsCollector(ss, false) {}
+
+StepStatsCollector::StepStatsCollector(StepStats* ss, bool compact)
+    : step_stats_(ss), compact_(compact), num_records_(0) {
+  for (auto& chunk : record_chunks_) {
+    chunk.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+StepStatsCollector::~StepStatsCollector() {
+  Finalize();
+  for (auto& chunk : record_chunks_) {
+    delete[] chunk.load(std::memory_order_relaxed);
+  }
+}
 
 static int ExtractGpuWithStreamAll(string device_name) {
   // Check if the device name matches the ".*gpu:(\\d+)/stream:all$" regexp,
@@ -89,6 +105,7 @@ void StepStatsCollector::BuildCostModel(
     CostModelManager* cost_model_manager,
     const std::unordered_map<string, const Graph*>& device_map) {
   mutex_lock lock(mu_);
+  FinalizeLocked();
 
   // Hardware stats for gpu are available under a fake device named
   // "gpu:<id>/stream::all.
@@ -234,9 +251,81 @@ void StepStatsCollector::Save(const string& device, NodeExecStats* nt) {
   delete nt;
 }
 
+void StepStatsCollector::SaveRecord(const NodeExecRecord& record) {
+  const uint64 index = num_records_.fetch_add(1, std::memory_order_relaxed);
+  if (index >= static_cast<uint64>(kMaxRecordChunks) * kRecordChunkSize) {
+    VLOG(1) << "Already collected too many node records.";
+    return;
+  }
+  std::atomic<NodeExecRecord*>& slot = record_chunks_[index / kRecordChunkSize];
+  NodeExecRecord* chunk = slot.load(std::memory_order_acquire);
+  if (chunk == nullptr) {
+    NodeExecRecord* new_chunk = new NodeExecRecord[kRecordChunkSize];
+    if (slot.compare_exchange_strong(chunk, new_chunk,
+                                     std::memory_order_acq_rel)) {
+      chunk = new_chunk;
+    } else {
+      // Another thread allocated the chunk first; "chunk" now holds it.
+      delete[] new_chunk;
+    }
+  }
+  chunk[index % kRecordChunkSize] = record;
+}
+
+void StepStatsCollector::Finalize() {
+  mutex_lock l(mu_);
+  FinalizeLocked();
+}
+
+void StepStatsCollector::FinalizeLocked() {
+  const uint64 num_records =
+      std::min(num_records_.load(std::memory_order_acquire),
+               static_cast<uint64>(kMaxRecordChunks) * kRecordChunkSize);
+  if (!step_stats_ || num_finalized_records_ >= num_records) {
+    return;
+  }
+  // The records of a step are usually of a few devices, whose names are
+  // shared by all their records.
+  std::unordered_map<const string*, DeviceStepStats*> device_stats;
+  for (uint64 i = num_finalized_records_; i < num_records; ++i) {
+    if (collectedNodes >= kMaxCollectedNodes) {
+      VLOG(1) << "Already collected too many nodes.";
+      break;
+    }
+    const NodeExecRecord& record =
+        record_chunks_[i / kRecordChunkSize].load(std::memory_order_relaxed)
+                      [i % kRecordChunkSize];
+    DeviceStepStats*& dss = device_stats[record.device];
+    if (dss == nullptr) {
+      for (auto& ds : *step_stats_->mutable_dev_stats()) {
+        if (ds.device() == *record.device) {
+          dss = &ds;
+          break;
+        }
+      }
+      if (dss == nullptr) {
+        dss = step_stats_->add_dev_stats();
+        dss->set_device(*record.device);
+      }
+    }
+    NodeExecStats* nt = dss->add_node_stats();
+    nt->set_node_name(*record.node_name);
+    nt->set_scheduled_micros(record.scheduled_micros);
+    nt->set_all_start_micros(record.all_start_micros);
+    nt->set_op_start_rel_micros(record.op_start_rel_micros);
+    nt->set_op_end_rel_micros(record.op_end_rel_micros);
+    nt->set_all_end_rel_micros(record.all_end_rel_micros);
+    nt->set_timeline_label(
+        strings::StrCat(*record.node_name, " = ", *record.node_type, "()"));
+    collectedNodes++;
+  }
+  num_finalized_records_ = num_records;
+}
+
 void StepStatsCollector::Swap(StepStats* ss) {
   mutex_lock l(mu_);
   CHECK(step_stats_);
+  FinalizeLocked();
   ss->Swap(step_stats_);
   collectedNodes = 0;
 }
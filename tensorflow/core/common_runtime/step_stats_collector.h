@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_STEP_STATS_COLLECTOR_H_
 #define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_STEP_STATS_COLLECTOR_H_
 
+#include <atomic>
 #include <unordered_map>
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/thread_annotations.h"
@@ -27,6 +28,22 @@ class Graph;
 class NodeExecStats;
 class StepStats;
 
+// A compact record of the execution of one node, saved by
+// StepStatsCollector::SaveRecord() without allocating or locking. Only the
+// timings of the node are recorded.
+struct NodeExecRecord {
+  // Not owned. Must outlive the conversion of the record by the collector's
+  // Finalize().
+  const string* device = nullptr;
+  const string* node_name = nullptr;
+  const string* node_type = nullptr;
+  int64 scheduled_micros = 0;
+  int64 all_start_micros = 0;
+  int64 op_start_rel_micros = 0;
+  int64 op_end_rel_micros = 0;
+  int64 all_end_rel_micros = 0;
+};
+
 // StepStatsCollector manages the collection of a StepStats object.
 // The StepStats object holds multiple DeviceStats.
 // Each DeviceStats object holds multiple NodeExecStats.
@@ -34,6 +51,16 @@ class StepStatsCollector {
  public:
   explicit StepStatsCollector(StepStats* ss);
 
+  // If "compact" is true, executors record the timings of nodes with
+  // SaveRecord() instead of saving a full NodeExecStats with Save(), and
+  // don't track the allocations, outputs and memory of the nodes.
+  StepStatsCollector(StepStats* ss, bool compact);
+
+  // Finalizes the collection.
+  ~StepStatsCollector();
+
+  bool compact() const { return compact_; }
+
   // BuildCostModel builds or updates a CostModel managed by cost_model_manager,
   // using the currently collected DeviceStats associated with the devices in
   // device_map.
@@ -44,16 +71,39 @@ class StepStatsCollector {
   // Save saves nt to the DeviceStats object associated with device.
   void Save(const string& device, NodeExecStats* nt);
 
+  // SaveRecord appends "record" to a preallocated log without taking a lock,
+  // and converts it to a NodeExecStats of the DeviceStats of
+  // "record.device" on Finalize().
+  void SaveRecord(const NodeExecRecord& record);
+
+  // Converts the records saved by SaveRecord() so far to NodeExecStats in the
+  // step stats. Must not run concurrently with SaveRecord(); BuildCostModel(),
+  // Swap() and the destructor call it.
+  void Finalize();
+
   // Swap replaces the current step stats with ss.
   void Swap(StepStats* ss);
 
  private:
+  void FinalizeLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // The records are appended to chunks of kRecordChunkSize, which are
+  // allocated the first time a record lands in them.
+  static const int kRecordChunkSize = 1024;
+  static const int kMaxRecordChunks = (1 << 20) / kRecordChunkSize;
+
   // TODO(suharshs): Make this configurable if its not possible to find a value
   //                 that works for all cases.
   const uint64 kMaxCollectedNodes = 1 << 20;
   mutex mu_;
   StepStats* step_stats_ GUARDED_BY(mu_);
   uint64 collectedNodes GUARDED_BY(mu_) = 0;
+
+  const bool compact_;
+  std::atomic<uint64> num_records_;
+  std::atomic<NodeExecRecord*> record_chunks_[kMaxRecordChunks];
+  // The number of records converted by Finalize().
+  uint64 num_finalized_records_ GUARDED_BY(mu_) = 0;
 };
 
 }  // namespace tensorflow
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/threadpool_device.h"
 
 #include "tensorflow/core/common_runtime/local_device.h"
+#include "tensorflow/core/common_runtime/numa_allocator.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/allocator_registry.h"
 #include "tensorflow/core/framework/device_base.h"
@@ -24,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/graph/types.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session_options.h"
@@ -37,9 +39,11 @@ namespace tensorflow {
 ThreadPoolDevice::ThreadPoolDevice(const SessionOptions& options,
                                    const string& name, Bytes memory_limit,
                                    const DeviceLocality& locality,
-                                   Allocator* allocator)
-    : LocalDevice(options, Device::BuildDeviceAttributes(
-                               name, DEVICE_CPU, memory_limit, locality)),
+                                   Allocator* allocator, int numa_node)
+    : LocalDevice(options,
+                  Device::BuildDeviceAttributes(name, DEVICE_CPU, memory_limit,
+                                                locality),
+                  numa_node),
       allocator_(allocator) {}
 
 ThreadPoolDevice::~ThreadPoolDevice() {}
@@ -69,7 +73,7 @@ Status ThreadPoolDevice::MakeTensorFromProto(
     Tensor* tensor) {
   if (tensor_proto.dtype() > 0 && tensor_proto.dtype() <= DataType_MAX) {
     Tensor parsed(tensor_proto.dtype());
-    if (parsed.FromProto(cpu_allocator(), tensor_proto)) {
+    if (parsed.FromProto(allocator_, tensor_proto)) {
       *tensor = parsed;
       return Status::OK();
     }
@@ -78,6 +82,39 @@ Status ThreadPoolDevice::MakeTensorFromProto(
                                  ProtoDebugString(tensor_proto));
 }
 
+std::vector<int> CPUDeviceNUMANodes(const SessionOptions& options) {
+  const bool use_numa =
+      options.config.use_numa_affinity() && port::NUMAEnabled();
+  int n = use_numa ? port::NUMANumNodes() : 1;
+  auto iter = options.config.device_count().find("CPU");
+  if (iter != options.config.device_count().end()) {
+    n = iter->second;
+  }
+  std::vector<int> numa_nodes(n, port::kNUMANoAffinity);
+  if (use_numa) {
+    for (int i = 0; i < n; i++) {
+      numa_nodes[i] = i % port::NUMANumNodes();
+    }
+  }
+  return numa_nodes;
+}
+
+DeviceLocality CPUDeviceLocality(int numa_node) {
+  DeviceLocality locality;
+  if (numa_node != port::kNUMANoAffinity) {
+    // Bus ids are indexed from 1.
+    locality.set_bus_id(numa_node + 1);
+  }
+  return locality;
+}
+
+Allocator* CPUDeviceAllocator(int numa_node) {
+  if (numa_node == port::kNUMANoAffinity) {
+    return cpu_allocator();
+  }
+  return NUMACPUAllocator(numa_node);
+}
+
 #ifdef INTEL_MKL
 REGISTER_MEM_ALLOCATOR("MklCPUAllocator", 200, MklCPUAllocator);
 #endif
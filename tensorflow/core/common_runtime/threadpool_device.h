@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_COMMON_RUNTIME_THREADPOOL_DEVICE_H_
 #define TENSORFLOW_COMMON_RUNTIME_THREADPOOL_DEVICE_H_
 
+#include <vector>
+
 #include "tensorflow/core/common_runtime/device_factory.h"
 #include "tensorflow/core/common_runtime/local_device.h"
 
@@ -26,7 +28,8 @@ class ThreadPoolDevice : public LocalDevice {
  public:
   ThreadPoolDevice(const SessionOptions& options, const string& name,
                    Bytes memory_limit, const DeviceLocality& locality,
-                   Allocator* allocator);
+                   Allocator* allocator,
+                   int numa_node = port::kNUMANoAffinity);
   ~ThreadPoolDevice() override;
 
   void Compute(OpKernel* op_kernel, OpKernelContext* context) override;
@@ -41,6 +44,17 @@ class ThreadPoolDevice : public LocalDevice {
   Allocator* allocator_;  // Not owned
 };
 
+// Returns the NUMA node of each CPU device that options ask for, or
+// port::kNUMANoAffinity for devices that aren't bound to a node. If
+// options.config.use_numa_affinity() is set on a NUMA host, there is one
+// device per node unless device_count says otherwise, and device i is bound
+// to node i modulo port::NUMANumNodes().
+std::vector<int> CPUDeviceNUMANodes(const SessionOptions& options);
+
+// Returns the locality and allocator of a CPU device bound to numa_node.
+DeviceLocality CPUDeviceLocality(int numa_node);
+Allocator* CPUDeviceAllocator(int numa_node);
+
 }  // namespace tensorflow
 
 #endif  // TENSORFLOW_COMMON_RUNTIME_THREADPOOL_DEVICE_H_
@@ -28,17 +28,12 @@ class ThreadPoolDeviceFactory : public DeviceFactory {
  public:
   Status CreateDevices(const SessionOptions& options, const string& name_prefix,
                        std::vector<Device*>* devices) override {
-    // TODO(zhifengc/tucker): Figure out the number of available CPUs
-    // and/or NUMA configuration.
-    int n = 1;
-    auto iter = options.config.device_count().find("CPU");
-    if (iter != options.config.device_count().end()) {
-      n = iter->second;
-    }
-    for (int i = 0; i < n; i++) {
+    const std::vector<int> numa_nodes = CPUDeviceNUMANodes(options);
+    for (int i = 0; i < numa_nodes.size(); i++) {
       string name = strings::StrCat(name_prefix, "/cpu:", i);
       devices->push_back(new ThreadPoolDevice(
-          options, name, Bytes(256 << 20), DeviceLocality(), cpu_allocator()));
+          options, name, Bytes(256 << 20), CPUDeviceLocality(numa_nodes[i]),
+          CPUDeviceAllocator(numa_nodes[i]), numa_nodes[i]));
     }
 
     return Status::OK();
@@ -0,0 +1,197 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_COMMON_RUNTIME_WORK_STEALING_QUEUE_H_
+#define TENSORFLOW_COMMON_RUNTIME_WORK_STEALING_QUEUE_H_
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// WorkStealingQueues is an internal helper class of the executor. It keeps
+// items of pending work (ready nodes) in one deque per worker, so that
+// scheduling a node does not require a trip through the shared queue of the
+// inter-op thread pool.
+//
+// The owner of a deque pushes and pops at its back, so producer/consumer
+// chains run back-to-back on the same thread. Idle workers steal from the
+// front of other workers' deques, which holds the oldest work.
+//
+// Workers are started lazily through "runner": Push() starts a new worker
+// only if fewer than "max_workers" are active, and a worker returns to the
+// pool as soon as every deque is empty. Each running worker holds a
+// reference to the queues, so instances must be owned by a std::shared_ptr
+// (see Create()).  "process" must not be called on an instance after the
+// last item has been processed; the queues may thus outlive the state that
+// "process" refers to.
+//
+//   auto queues = WorkStealingQueues<Item>::Create(
+//       num_threads, runner, [](const Item& item, int worker_id) {...});
+//   queues->Push(item, -1);
+template <typename T>
+class WorkStealingQueues
+    : public std::enable_shared_from_this<WorkStealingQueues<T>> {
+ public:
+  typedef std::function<void()> Closure;
+  typedef std::function<void(Closure)> Runner;
+
+  // Called by a worker for every item it pops or steals. "worker_id" is in
+  // [0, max_workers) and is meant to be passed back to Push() for any work
+  // created while processing "item".
+  typedef std::function<void(const T& item, int worker_id)> ProcessFn;
+
+  static std::shared_ptr<WorkStealingQueues<T>> Create(int max_workers,
+                                                       Runner runner,
+                                                       ProcessFn process) {
+    return std::shared_ptr<WorkStealingQueues<T>>(new WorkStealingQueues<T>(
+        max_workers, std::move(runner), std::move(process)));
+  }
+
+  // Adds "item" to the deque of "worker_id". A negative "worker_id" means
+  // the caller is not one of our workers (e.g. the completion callback of an
+  // asynchronous kernel); such items are spread round-robin over all deques.
+  // Starts a new worker if there is idle capacity.
+  void Push(const T& item, int worker_id) {
+    if (worker_id < 0) {
+      worker_id = next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                  queues_.size();
+    }
+    DCHECK_LT(worker_id, queues_.size());
+    Queue* q = queues_[worker_id].get();
+    {
+      mutex_lock l(q->mu);
+      q->items.push_back(item);
+    }
+    num_queued_.fetch_add(1);
+    MaybeStartWorker();
+  }
+
+  int max_workers() const { return queues_.size(); }
+
+  // Number of workers currently running. For testing.
+  int num_active_workers() const { return num_active_.load(); }
+
+ private:
+  struct Queue {
+    mutex mu;
+    std::deque<T> items GUARDED_BY(mu);
+  };
+
+  WorkStealingQueues(int max_workers, Runner runner, ProcessFn process)
+      : runner_(std::move(runner)),
+        process_(std::move(process)),
+        claimed_(new std::atomic<bool>[max_workers]),
+        num_active_(0),
+        num_queued_(0),
+        next_queue_(0) {
+    CHECK_GT(max_workers, 0);
+    queues_.reserve(max_workers);
+    for (int i = 0; i < max_workers; ++i) {
+      queues_.emplace_back(new Queue);
+      claimed_[i] = false;
+    }
+  }
+
+  // Reserves a worker slot if fewer than max_workers() are active.
+  bool TryReserveWorker() {
+    int active = num_active_.load();
+    while (active < max_workers()) {
+      if (num_active_.compare_exchange_weak(active, active + 1)) return true;
+    }
+    return false;
+  }
+
+  // Returns the id of a worker slot nobody else holds. Must be preceded by a
+  // successful TryReserveWorker(), which guarantees that a slot is free.
+  int ClaimWorkerId() {
+    for (;;) {
+      for (int i = 0; i < max_workers(); ++i) {
+        bool expected = false;
+        if (!claimed_[i].load(std::memory_order_relaxed) &&
+            claimed_[i].compare_exchange_strong(expected, true)) {
+          return i;
+        }
+      }
+    }
+  }
+
+  void MaybeStartWorker() {
+    if (!TryReserveWorker()) return;
+    const int worker_id = ClaimWorkerId();
+    std::shared_ptr<WorkStealingQueues<T>> self = this->shared_from_this();
+    runner_([self, worker_id]() { self->WorkerLoop(worker_id); });
+  }
+
+  // Pops from the back of our own deque, or steals from the front of the
+  // deque of another worker.
+  bool PopOrSteal(int worker_id, T* item) {
+    const int n = max_workers();
+    for (int i = 0; i < n; ++i) {
+      Queue* q = queues_[(worker_id + i) % n].get();
+      mutex_lock l(q->mu);
+      if (q->items.empty()) continue;
+      if (i == 0) {
+        *item = q->items.back();
+        q->items.pop_back();
+      } else {
+        *item = q->items.front();
+        q->items.pop_front();
+      }
+      num_queued_.fetch_sub(1);
+      return true;
+    }
+    return false;
+  }
+
+  void WorkerLoop(int worker_id) {
+    T item;
+    for (;;) {
+      while (PopOrSteal(worker_id, &item)) {
+        process_(item, worker_id);
+      }
+      claimed_[worker_id].store(false);
+      num_active_.fetch_sub(1);
+      // A producer that pushed after our last scan may have observed us as
+      // still active and not started a replacement. Either it sees the
+      // decrement above and starts a worker, or we see its item here.
+      if (num_queued_.load() == 0 || !TryReserveWorker()) return;
+      worker_id = ClaimWorkerId();
+    }
+  }
+
+  const Runner runner_;
+  const ProcessFn process_;
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::unique_ptr<std::atomic<bool>[]> claimed_;
+  std::atomic<int> num_active_;
+  std::atomic<int64> num_queued_;
+  std::atomic<uint32> next_queue_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(WorkStealingQueues);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_COMMON_RUNTIME_WORK_STEALING_QUEUE_H_
@@ -0,0 +1,101 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/work_stealing_queue.h"
+
+#include <atomic>
+
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(WorkStealingQueuesTest, ProcessesAllItems) {
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  const int kNumItems = 1000;
+  BlockingCounter counter(kNumItems);
+  std::atomic<int64> sum(0);
+  auto queues = WorkStealingQueues<int>::Create(
+      4, [&pool](std::function<void()> fn) { pool.Schedule(std::move(fn)); },
+      [&sum, &counter](const int& item, int worker_id) {
+        EXPECT_GE(worker_id, 0);
+        EXPECT_LT(worker_id, 4);
+        sum += item;
+        counter.DecrementCount();
+      });
+  for (int i = 0; i < kNumItems; ++i) {
+    queues->Push(i, -1);
+  }
+  counter.Wait();
+  EXPECT_EQ(kNumItems * (kNumItems - 1) / 2, sum.load());
+  EXPECT_LE(queues->num_active_workers(), 4);
+}
+
+// Each item pushes its children onto the deque of the worker processing it,
+// which is how the executor uses the queues.
+TEST(WorkStealingQueuesTest, RecursivePush) {
+  thread::ThreadPool pool(Env::Default(), "test", 8);
+  const int kDepth = 12;
+  BlockingCounter counter((1 << (kDepth + 1)) - 1);
+  std::shared_ptr<WorkStealingQueues<int>> queues;
+  queues = WorkStealingQueues<int>::Create(
+      8, [&pool](std::function<void()> fn) { pool.Schedule(std::move(fn)); },
+      [&queues, &counter](const int& depth, int worker_id) {
+        if (depth < kDepth) {
+          queues->Push(depth + 1, worker_id);
+          queues->Push(depth + 1, worker_id);
+        }
+        counter.DecrementCount();
+      });
+  queues->Push(0, -1);
+  counter.Wait();
+}
+
+TEST(WorkStealingQueuesTest, BoundsOutstandingClosures) {
+  thread::ThreadPool pool(Env::Default(), "test", 8);
+  std::atomic<int> num_closures(0);
+  std::atomic<int> max_concurrent(0);
+  std::atomic<int> concurrent(0);
+  const int kNumItems = 200;
+  BlockingCounter counter(kNumItems);
+  auto queues = WorkStealingQueues<int>::Create(
+      2,
+      [&pool, &num_closures](std::function<void()> fn) {
+        ++num_closures;
+        pool.Schedule(std::move(fn));
+      },
+      [&](const int& item, int worker_id) {
+        int now = ++concurrent;
+        int prev = max_concurrent.load();
+        while (now > prev && !max_concurrent.compare_exchange_weak(prev, now)) {
+        }
+        Env::Default()->SleepForMicroseconds(10);
+        --concurrent;
+        counter.DecrementCount();
+      });
+  for (int i = 0; i < kNumItems; ++i) {
+    queues->Push(i, -1);
+  }
+  counter.Wait();
+  EXPECT_LE(max_concurrent.load(), 2);
+  // Far fewer closures than items go through the thread pool.
+  EXPECT_LT(num_closures.load(), kNumItems);
+}
+
+}  // namespace
+}  // namespace tensorflow
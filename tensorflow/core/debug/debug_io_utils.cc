@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/debug/debug_io_utils.h"
 
+#include <algorithm>
+#include <deque>
+#include <functional>
 #include <vector>
 
 #if defined(PLATFORM_GOOGLE)
@@ -28,11 +31,14 @@ limitations under the License.
 
 #include "tensorflow/core/debug/debugger_event_metadata.pb.h"
 #include "tensorflow/core/framework/summary.pb.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/util/env_var.h"
 #include "tensorflow/core/util/event.pb.h"
 
 #define GRPC_OSS_UNIMPLEMENTED_ERROR \
@@ -113,6 +119,159 @@ string AppendTimestampToFilePath(const string& in, const uint64 timestamp) {
   return out;
 }
 
+DebugIO::AsyncPublishOptions AsyncPublishOptionsFromEnv() {
+  DebugIO::AsyncPublishOptions options;
+  int64 num_threads = options.num_threads;
+  Status status;
+  status.Update(
+      ReadBoolFromEnvVar("TFDBG_ASYNC_PUBLISH", false, &options.enabled));
+  status.Update(ReadInt64FromEnvVar("TFDBG_ASYNC_PUBLISH_THREADS",
+                                    num_threads, &num_threads));
+  status.Update(ReadInt64FromEnvVar("TFDBG_ASYNC_PUBLISH_MAX_QUEUED_BYTES",
+                                    options.max_queued_bytes,
+                                    &options.max_queued_bytes));
+  status.Update(ReadBoolFromEnvVar("TFDBG_ASYNC_PUBLISH_DROP_WHEN_FULL",
+                                   false, &options.drop_when_full));
+  status.Update(ReadInt64FromEnvVar("TFDBG_PUBLISH_EVERY_N",
+                                    options.publish_every_n,
+                                    &options.publish_every_n));
+  if (!status.ok()) {
+    LOG(ERROR) << "Invalid tfdbg publishing options: "
+               << status.error_message();
+  }
+  options.num_threads = static_cast<int>(num_threads);
+  return options;
+}
+
+// Process-wide state for publishing debug tensors: the sampling counters and
+// the bounded queue of tensors staged for publishing, which is drained by a
+// pool of background threads.
+class DebugTensorPublisher {
+ public:
+  static DebugTensorPublisher* Global() {
+    static DebugTensorPublisher* publisher = new DebugTensorPublisher;
+    return publisher;
+  }
+
+  DebugIO::AsyncPublishOptions options() {
+    mutex_lock l(mu_);
+    return options_;
+  }
+
+  void set_options(const DebugIO::AsyncPublishOptions& options) {
+    mutex_lock l(mu_);
+    options_ = options;
+    options_.num_threads = std::max(1, options_.num_threads);
+    // Wake up the threads that may have been idle, as well as the debug
+    // ops that may be waiting for room in the queue.
+    cv_.notify_all();
+  }
+
+  // Returns whether this is one of the tensors of the debug node that
+  // should be published, given the publish_every_n option.
+  bool ShouldPublish(const DebugNodeKey& debug_node_key,
+                     const int64 publish_every_n) {
+    if (publish_every_n <= 1) {
+      return true;
+    }
+    mutex_lock l(mu_);
+    int64& count = publish_counts_[strings::StrCat(
+        debug_node_key.device_name, ";", debug_node_key.debug_node_name)];
+    return (count++ % publish_every_n) == 0;
+  }
+
+  // Stages publish_fn, which holds on to num_bytes of tensor data, to be run
+  // on a background thread. If the queue is full, waits for it to drain, or
+  // drops publish_fn and returns false if the drop_when_full option is set.
+  bool Schedule(const int64 num_bytes, std::function<Status()> publish_fn) {
+    mutex_lock l(mu_);
+    while (queued_bytes_ > 0 &&
+           queued_bytes_ + num_bytes > options_.max_queued_bytes) {
+      if (options_.drop_when_full) {
+        ++num_dropped_;
+        return false;
+      }
+      cv_.wait(l);
+    }
+    queue_.emplace_back(num_bytes, std::move(publish_fn));
+    queued_bytes_ += num_bytes;
+    while (workers_.size() < static_cast<size_t>(options_.num_threads)) {
+      const int index = workers_.size();
+      workers_.emplace_back(Env::Default()->StartThread(
+          ThreadOptions(), strings::StrCat("tfdbg_publisher_", index),
+          [this, index]() { PublishStagedTensors(index); }));
+    }
+    cv_.notify_all();
+    return true;
+  }
+
+  Status Flush() {
+    mutex_lock l(mu_);
+    while (!queue_.empty() || num_in_flight_ > 0) {
+      cv_.wait(l);
+    }
+    if (num_dropped_ > 0) {
+      LOG(WARNING) << "Dropped " << num_dropped_
+                   << " debug tensors, because the queue of tensors staged "
+                   << "for publishing was full";
+      num_dropped_ = 0;
+    }
+    Status status = status_;
+    status_ = Status::OK();
+    return status;
+  }
+
+ private:
+  DebugTensorPublisher() : options_(AsyncPublishOptionsFromEnv()) {
+    options_.num_threads = std::max(1, options_.num_threads);
+  }
+
+  // Run by the background thread with the given index, for as long as the
+  // process lives. Threads beyond the num_threads option stay idle.
+  void PublishStagedTensors(const int index) {
+    mutex_lock l(mu_);
+    while (true) {
+      while (queue_.empty() || index >= options_.num_threads) {
+        cv_.wait(l);
+      }
+      const int64 num_bytes = queue_.front().first;
+      std::function<Status()> publish_fn = std::move(queue_.front().second);
+      queue_.pop_front();
+      ++num_in_flight_;
+
+      Status status;
+      {
+        l.unlock();
+        status = publish_fn();
+        // Release the staged tensor before reporting it as freed.
+        publish_fn = nullptr;
+        l.lock();
+      }
+      if (!status.ok()) {
+        LOG(ERROR) << "Failed to publish a staged debug tensor, due to: "
+                   << status.error_message();
+        status_.Update(status);
+      }
+      queued_bytes_ -= num_bytes;
+      --num_in_flight_;
+      cv_.notify_all();
+    }
+  }
+
+  mutex mu_;
+  condition_variable cv_;
+  DebugIO::AsyncPublishOptions options_ GUARDED_BY(mu_);
+  std::unordered_map<string, int64> publish_counts_ GUARDED_BY(mu_);
+  std::deque<std::pair<int64, std::function<Status()>>> queue_
+      GUARDED_BY(mu_);
+  // Bytes held by the queued and in-flight tensors.
+  int64 queued_bytes_ GUARDED_BY(mu_) = 0;
+  int64 num_in_flight_ GUARDED_BY(mu_) = 0;
+  int64 num_dropped_ GUARDED_BY(mu_) = 0;
+  Status status_ GUARDED_BY(mu_);
+  std::vector<std::unique_ptr<Thread>> workers_ GUARDED_BY(mu_);
+};
+
 #if defined(PLATFORM_GOOGLE)
 Status PublishEncodedGraphDefInChunks(const string& encoded_graph_def,
                                       const string& device_name,
@@ -307,6 +466,48 @@ Status DebugIO::PublishDebugTensor(const DebugNodeKey& debug_node_key,
                                    const uint64 wall_time_us,
                                    const gtl::ArraySlice<string>& debug_urls,
                                    const bool gated_grpc) {
+  DebugTensorPublisher* publisher = DebugTensorPublisher::Global();
+  const AsyncPublishOptions options = publisher->options();
+  if (!publisher->ShouldPublish(debug_node_key, options.publish_every_n)) {
+    return Status::OK();
+  }
+  if (!options.enabled) {
+    return PublishDebugTensorNow(debug_node_key, tensor, wall_time_us,
+                                 debug_urls, gated_grpc);
+  }
+
+  // Reject bad URLs right away, as nobody would hear about them otherwise.
+  for (const string& url : debug_urls) {
+    if (str_util::Lowercase(url).find(kGrpcURLScheme) == 0) {
+#if !defined(PLATFORM_GOOGLE)
+      GRPC_OSS_UNIMPLEMENTED_ERROR;
+#endif
+    } else if (str_util::Lowercase(url).find(kFileURLScheme) != 0) {
+      return Status(error::UNAVAILABLE,
+                    strings::StrCat("Invalid debug target URL: ", url));
+    }
+  }
+
+  // The debug op's input may be overwritten once the op is done, so the
+  // staged tensor needs a buffer of its own.
+  const Tensor staged_tensor =
+      tensor.IsInitialized() ? tensor::DeepCopy(tensor) : tensor;
+  const std::vector<string> urls(debug_urls.begin(), debug_urls.end());
+  publisher->Schedule(
+      staged_tensor.TotalBytes(),
+      [debug_node_key, staged_tensor, wall_time_us, urls, gated_grpc]() {
+        return PublishDebugTensorNow(debug_node_key, staged_tensor,
+                                     wall_time_us, urls, gated_grpc);
+      });
+  return Status::OK();
+}
+
+// static
+Status DebugIO::PublishDebugTensorNow(const DebugNodeKey& debug_node_key,
+                                      const Tensor& tensor,
+                                      const uint64 wall_time_us,
+                                      const gtl::ArraySlice<string>& debug_urls,
+                                      const bool gated_grpc) {
   int32 num_failed_urls = 0;
   std::vector<Status> fail_statuses;
   for (const string& url : debug_urls) {
@@ -455,18 +656,34 @@ bool DebugIO::IsDebugURLGateOpen(const string& watch_key,
 #endif
 }
 
+// static
+DebugIO::AsyncPublishOptions DebugIO::GetAsyncPublishOptions() {
+  return DebugTensorPublisher::Global()->options();
+}
+
+// static
+void DebugIO::SetAsyncPublishOptions(const AsyncPublishOptions& options) {
+  DebugTensorPublisher::Global()->set_options(options);
+}
+
+// static
+Status DebugIO::FlushAsyncPublishing() {
+  return DebugTensorPublisher::Global()->Flush();
+}
+
 // static
 Status DebugIO::CloseDebugURL(const string& debug_url) {
+  // Tensors staged for publishing may still be on their way to debug_url.
+  Status status = FlushAsyncPublishing();
   if (debug_url.find(DebugIO::kGrpcURLScheme) == 0) {
 #if defined(PLATFORM_GOOGLE)
-    return DebugGrpcIO::CloseGrpcStream(debug_url);
+    status.Update(DebugGrpcIO::CloseGrpcStream(debug_url));
 #else
     GRPC_OSS_UNIMPLEMENTED_ERROR;
 #endif
-  } else {
-    // No-op for non-gRPC URLs.
-    return Status::OK();
   }
+  // Otherwise there is nothing more to do for non-gRPC URLs.
+  return status;
 }
 
 // static
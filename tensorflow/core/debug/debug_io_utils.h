@@ -84,6 +84,41 @@ class DebugIO {
                                    const uint64 wall_time_us,
                                    const gtl::ArraySlice<string>& debug_urls);
 
+  // Options for publishing debug tensors from background threads, so that
+  // the debug ops don't have to wait for the files to be written or the gRPC
+  // streams to be sent.
+  struct AsyncPublishOptions {
+    // Whether PublishDebugTensor() stages a copy of the tensor and returns
+    // right away, instead of publishing it before returning.
+    bool enabled = false;
+    // Number of background threads. With a single thread, the tensors reach
+    // each debug URL in the order they were published.
+    int num_threads = 1;
+    // Upper bound on the total size of the staged tensors, in bytes. A tensor
+    // larger than that is still staged when nothing else is.
+    int64 max_queued_bytes = 256 << 20;
+    // Whether to drop tensors that don't fit into the staging queue, rather
+    // than blocking the debug op until they do.
+    bool drop_when_full = false;
+    // Only publish every n-th tensor of each debug node. This applies to
+    // synchronous publishing as well.
+    int64 publish_every_n = 1;
+  };
+
+  // Get or set the options for publishing tensors. Until they are set, the
+  // options come from the environment variables TFDBG_ASYNC_PUBLISH,
+  // TFDBG_ASYNC_PUBLISH_THREADS, TFDBG_ASYNC_PUBLISH_MAX_QUEUED_BYTES,
+  // TFDBG_ASYNC_PUBLISH_DROP_WHEN_FULL and TFDBG_PUBLISH_EVERY_N.
+  static AsyncPublishOptions GetAsyncPublishOptions();
+  static void SetAsyncPublishOptions(const AsyncPublishOptions& options);
+
+  // Wait for all the staged tensors to be published.
+  //
+  // Returns:
+  //   The first error the background threads ran into since the last call,
+  //   or OK if there was none.
+  static Status FlushAsyncPublishing();
+
   // Publish a graph to a set of debug URLs.
   //
   // Args:
@@ -137,6 +172,7 @@ class DebugIO {
   static bool IsDebugURLGateOpen(const string& watch_key,
                                  const string& debug_url);
 
+  // Close a debug URL, once all the tensors staged for publishing are out.
   static Status CloseDebugURL(const string& debug_url);
 
   static const char* const kMetadataFilePrefix;
@@ -147,6 +183,14 @@ class DebugIO {
 
   static const char* const kFileURLScheme;
   static const char* const kGrpcURLScheme;
+
+ private:
+  // Publish a tensor to all of debug_urls before returning.
+  static Status PublishDebugTensorNow(const DebugNodeKey& debug_node_key,
+                                      const Tensor& tensor,
+                                      const uint64 wall_time_us,
+                                      const gtl::ArraySlice<string>& debug_urls,
+                                      const bool gated_grpc);
 };
 
 // Helper class for debug ops.
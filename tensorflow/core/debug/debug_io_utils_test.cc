@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/core/debug/debugger_event_metadata.pb.h"
 #include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
@@ -385,5 +386,147 @@ TEST_F(DebugIOUtilsTest, PublishTensorConcurrentlyToPartiallyOverlappingPaths) {
   }
 }
 
+class DebugIOUtilsAsyncTest : public DebugIOUtilsTest {
+ protected:
+  void SetUp() override {
+    Initialize();
+    original_options_ = DebugIO::GetAsyncPublishOptions();
+    DebugIO::AsyncPublishOptions options;
+    options.enabled = true;
+    DebugIO::SetAsyncPublishOptions(options);
+  }
+
+  void TearDown() override {
+    TF_EXPECT_OK(DebugIO::FlushAsyncPublishing());
+    DebugIO::SetAsyncPublishOptions(original_options_);
+  }
+
+  // Returns the number of files dumped for debug_node_key under dump_root.
+  int CountDumpFiles(const string& dump_root,
+                     const DebugNodeKey& debug_node_key) {
+    std::vector<string> children;
+    const string dir = io::JoinPath(dump_root, debug_node_key.device_path);
+    if (!env_->GetChildren(dir, &children).ok()) {
+      return 0;
+    }
+    return children.size();
+  }
+
+  void DeleteDumpRoot(const string& dump_root) {
+    int64 undeleted_files = 0;
+    int64 undeleted_dirs = 0;
+    TF_ASSERT_OK(
+        env_->DeleteRecursively(dump_root, &undeleted_files, &undeleted_dirs));
+    ASSERT_EQ(0, undeleted_files);
+    ASSERT_EQ(0, undeleted_dirs);
+  }
+
+  DebugIO::AsyncPublishOptions original_options_;
+};
+
+TEST_F(DebugIOUtilsAsyncTest, PublishTensorToFileURL) {
+  const DebugNodeKey kDebugNodeKey("/job:localhost/replica:0/task:0/cpu:0",
+                                   "async_tensor_a", 0, "DebugIdentity");
+  const string dump_root = io::JoinPath(testing::TmpDir(), "async_dump");
+  const uint64 wall_time = env_->NowMicros();
+  const string dump_file_path =
+      DebugFileIO::GetDumpFilePath(dump_root, kDebugNodeKey, wall_time);
+  const Tensor expected = tensor::DeepCopy(*tensor_a_);
+
+  const std::vector<string> urls = {strings::StrCat("file://", dump_root)};
+  TF_ASSERT_OK(
+      DebugIO::PublishDebugTensor(kDebugNodeKey, *tensor_a_, wall_time, urls));
+  // The staged tensor must not be affected by later changes to the input.
+  tensor_a_->flat<float>().setZero();
+  TF_ASSERT_OK(DebugIO::FlushAsyncPublishing());
+
+  Event event;
+  TF_ASSERT_OK(ReadEventFromFile(dump_file_path, &event));
+  ASSERT_EQ(1, event.summary().value().size());
+  EXPECT_EQ(kDebugNodeKey.debug_node_name,
+            event.summary().value(0).node_name());
+  Tensor a_prime(DT_FLOAT);
+  ASSERT_TRUE(a_prime.FromProto(event.summary().value(0).tensor()));
+  test::ExpectTensorEqual<float>(expected, a_prime);
+
+  DeleteDumpRoot(dump_root);
+}
+
+TEST_F(DebugIOUtilsAsyncTest, PublishTensorsThroughFullQueue) {
+  const int kNumTensors = 10;
+  DebugIO::AsyncPublishOptions options;
+  options.enabled = true;
+  options.num_threads = 2;
+  options.max_queued_bytes = 1;
+  DebugIO::SetAsyncPublishOptions(options);
+
+  const DebugNodeKey kDebugNodeKey("/job:localhost/replica:0/task:0/cpu:0",
+                                   "async_tensor_b", 0, "DebugIdentity");
+  const string dump_root = io::JoinPath(testing::TmpDir(), "async_full_dump");
+  const uint64 wall_time = env_->NowMicros();
+  for (int i = 0; i < kNumTensors; ++i) {
+    TF_ASSERT_OK(DebugIO::PublishDebugTensor(
+        kDebugNodeKey, *tensor_a_, wall_time + i,
+        {strings::StrCat("file://", dump_root)}));
+  }
+  TF_ASSERT_OK(DebugIO::FlushAsyncPublishing());
+  EXPECT_EQ(kNumTensors, CountDumpFiles(dump_root, kDebugNodeKey));
+
+  DeleteDumpRoot(dump_root);
+}
+
+TEST_F(DebugIOUtilsAsyncTest, ReportErrorsOnFlush) {
+  const DebugNodeKey kDebugNodeKey("/job:localhost/replica:0/task:0/cpu:0",
+                                   "async_tensor_c", 0, "DebugIdentity");
+  // Dumping under a regular file fails, as it can't be made a directory.
+  const string txt_file_name =
+      io::JoinPath(testing::TmpDir(), "async_not_a_dir");
+  std::unique_ptr<WritableFile> file;
+  TF_ASSERT_OK(env_->NewWritableFile(txt_file_name, &file));
+  TF_ASSERT_OK(file->Append("text in async_not_a_dir"));
+  TF_ASSERT_OK(file->Close());
+
+  TF_ASSERT_OK(DebugIO::PublishDebugTensor(
+      kDebugNodeKey, *tensor_a_, env_->NowMicros(),
+      {strings::StrCat("file://", io::JoinPath(txt_file_name, "dump"))}));
+  EXPECT_FALSE(DebugIO::FlushAsyncPublishing().ok());
+  // The error is only reported once.
+  TF_EXPECT_OK(DebugIO::FlushAsyncPublishing());
+
+  TF_ASSERT_OK(env_->DeleteFile(txt_file_name));
+}
+
+TEST_F(DebugIOUtilsAsyncTest, RejectInvalidURLRightAway) {
+  const DebugNodeKey kDebugNodeKey("/job:localhost/replica:0/task:0/cpu:0",
+                                   "async_tensor_d", 0, "DebugIdentity");
+  const Status s = DebugIO::PublishDebugTensor(
+      kDebugNodeKey, *tensor_a_, env_->NowMicros(), {"foo://bar"});
+  EXPECT_EQ(error::UNAVAILABLE, s.code());
+}
+
+TEST_F(DebugIOUtilsAsyncTest, PublishEveryNthTensor) {
+  const int kNumTensors = 7;
+  DebugIO::AsyncPublishOptions options;
+  options.publish_every_n = 3;
+  DebugIO::SetAsyncPublishOptions(options);
+
+  const DebugNodeKey kDebugNodeKey("/job:localhost/replica:0/task:0/cpu:0",
+                                   "sampled_tensor", 0, "DebugIdentity");
+  const string dump_root = io::JoinPath(testing::TmpDir(), "sampled_dump");
+  const uint64 wall_time = env_->NowMicros();
+  for (int i = 0; i < kNumTensors; ++i) {
+    TF_ASSERT_OK(DebugIO::PublishDebugTensor(
+        kDebugNodeKey, *tensor_a_, wall_time + i,
+        {strings::StrCat("file://", dump_root)}));
+  }
+  // Tensors 0, 3 and 6 are published.
+  EXPECT_EQ(3, CountDumpFiles(dump_root, kDebugNodeKey));
+  TF_EXPECT_OK(env_->FileExists(io::JoinPath(
+      dump_root, kDebugNodeKey.device_path,
+      strings::StrCat("sampled_tensor_0_DebugIdentity_", wall_time + 3))));
+
+  DeleteDumpRoot(dump_root);
+}
+
 }  // namespace
 }  // namespace tensorflow
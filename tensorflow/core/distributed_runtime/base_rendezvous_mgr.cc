@@ -78,6 +78,14 @@ void BaseRendezvousMgr::RecvLocalAsync(int64 step_id,
   rendez->RecvLocalAsync(parsed, std::move(done_cb));
 }
 
+bool BaseRendezvousMgr::RecvLocalAsyncIfSent(
+    int64 step_id, const Rendezvous::ParsedKey& parsed,
+    Rendezvous::DoneCallback done) {
+  BaseRemoteRendezvous* rendez = FindOrCreate(step_id);
+  core::ScopedUnref unref(rendez);
+  return rendez->RecvLocalAsyncIfSent(parsed, std::move(done));
+}
+
 Status BaseRendezvousMgr::RecvLocal(int64 step_id,
                                     const Rendezvous::ParsedKey& parsed,
                                     Tensor* val, bool* is_dead) {
@@ -340,6 +348,20 @@ void BaseRemoteRendezvous::RecvLocalAsync(const ParsedKey& parsed,
   RecvLocalAsyncInternal(parsed, std::move(done));
 }
 
+bool BaseRemoteRendezvous::RecvLocalAsyncIfSent(const ParsedKey& parsed,
+                                                DoneCallback done) {
+  if (!is_initialized()) {
+    // Nothing was sent before the step started here.
+    return false;
+  }
+  Status s = ValidateDevices(parsed, true /* is_src */);
+  if (!s.ok()) {
+    done(s, Args(), Args(), Tensor(), false);
+    return true;
+  }
+  return local_->RecvAsyncIfSent(parsed, Args(), std::move(done));
+}
+
 void BaseRemoteRendezvous::RecvLocalAsyncInternal(const ParsedKey& parsed,
                                                   DoneCallback done) {
   Status s = ValidateDevices(parsed, true /* is_src */);
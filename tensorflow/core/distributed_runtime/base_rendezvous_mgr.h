@@ -78,6 +78,11 @@ class BaseRendezvousMgr : public RendezvousMgrInterface {
   void RecvLocalAsync(int64 step_id, const Rendezvous::ParsedKey& parsed,
                       Rendezvous::DoneCallback done) override;
 
+  // Runs "done" and returns true if the tensor for "key" has already been
+  // produced in "step_id", and returns false otherwise.
+  bool RecvLocalAsyncIfSent(int64 step_id, const Rendezvous::ParsedKey& parsed,
+                            Rendezvous::DoneCallback done) override;
+
   // Synchronous wrapper for RecvLocalAsync.
   Status RecvLocal(int64 step_id, const Rendezvous::ParsedKey& parsed,
                    Tensor* val, bool* is_dead) override;
@@ -150,6 +155,12 @@ class BaseRemoteRendezvous : public RemoteRendezvous {
   // REQUIRES: "parsed" is one that will be Saved into the local rendezvous.
   void RecvLocalAsync(const ParsedKey& parsed, DoneCallback done);
 
+  // Like RecvLocalAsync(), but runs "done" and returns true only if the
+  // tensor for "parsed" is already available or an error is detected.
+  // Returns false, dropping "done", otherwise, including when this
+  // rendezvous is not yet fully initialized.
+  bool RecvLocalAsyncIfSent(const ParsedKey& parsed, DoneCallback done);
+
  protected:
   virtual void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
                                    const Rendezvous::Args& args,
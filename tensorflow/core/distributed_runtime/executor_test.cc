@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/monitoring/collection_registry.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
@@ -67,6 +68,12 @@ class ExecutorTest : public ::testing::Test {
     params.delete_kernel = [](OpKernel* kernel) {
       DeleteNonCachedKernel(kernel);
     };
+    params.scheduler = scheduler_;
+    params.max_scheduler_workers = thread_pool_->NumThreads();
+    params.priority_measurement_steps = priority_measurement_steps_;
+    params.plan_memory = plan_memory_;
+    params.export_op_metrics = export_op_metrics_;
+    params.export_executor_stats = export_executor_stats_;
     delete exec_;
     TF_CHECK_OK(NewLocalExecutor(params, graph, &exec_));
     runner_ = [this](std::function<void()> fn) { thread_pool_->Schedule(fn); };
@@ -88,6 +95,11 @@ class ExecutorTest : public ::testing::Test {
   StepStats step_stats_;
   Executor::Args::Runner runner_;
   Rendezvous* rendez_ = nullptr;
+  ExecutorOptions::SchedulerType scheduler_ = ExecutorOptions::DEFAULT;
+  int priority_measurement_steps_ = 0;
+  bool plan_memory_ = false;
+  bool export_op_metrics_ = false;
+  bool export_executor_stats_ = false;
 };
 
 // A float val -> Tensor<float>
@@ -162,6 +174,103 @@ TEST_F(ExecutorTest, SimpleAdd) {
   EXPECT_EQ(2.0, V(out));  // out = 1.0 + 1.0 = 2.0
 }
 
+// Returns the number of samples of the metric "name" labelled by "op" and
+// "device".
+int64 NumOpMetricSamples(const string& name, const string& op,
+                         const string& device) {
+  auto metrics = monitoring::CollectionRegistry::Default()->CollectMetrics(
+      monitoring::CollectionRegistry::CollectMetricsOptions());
+  auto it = metrics->point_set_map.find(name);
+  if (it == metrics->point_set_map.end()) return 0;
+  for (const auto& point : it->second->points) {
+    if (point->labels.size() == 2 && point->labels[0].value == op &&
+        point->labels[1].value == device) {
+      return static_cast<int64>(point->histogram_value.num());
+    }
+  }
+  return 0;
+}
+
+TEST_F(ExecutorTest, ExportOpMetrics) {
+  export_op_metrics_ = true;
+  Graph* g = new Graph(OpRegistry::Global());
+  auto in0 = test::graph::Recv(g, "a", "float", ALICE, 1, BOB);
+  auto in1 = test::graph::Recv(g, "b", "float", ALICE, 1, BOB);
+  auto tmp = test::graph::Add(g, in0, in1);
+  test::graph::Send(g, tmp, "c", BOB, 1, ALICE);
+  Create(g);
+  const string& device = device_->name();
+  const int64 num_compute =
+      NumOpMetricSamples("/tensorflow/core/executor/op_compute_usecs", "Add",
+                         device);
+  const int64 num_output_bytes = NumOpMetricSamples(
+      "/tensorflow/core/executor/op_output_bytes", "Add", device);
+  Rendezvous::Args args;
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0),
+                             false));
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "b"), args, V(1.0),
+                             false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "c"), args, &out, &is_dead));
+  EXPECT_EQ(2.0, V(out));
+  EXPECT_EQ(num_compute + 1,
+            NumOpMetricSamples("/tensorflow/core/executor/op_compute_usecs",
+                               "Add", device));
+  EXPECT_EQ(num_output_bytes + 1,
+            NumOpMetricSamples("/tensorflow/core/executor/op_output_bytes",
+                               "Add", device));
+}
+
+// Returns the value of the counter "name" labelled by "label".
+int64 CounterValue(const string& name, const string& label) {
+  auto metrics = monitoring::CollectionRegistry::Default()->CollectMetrics(
+      monitoring::CollectionRegistry::CollectMetricsOptions());
+  auto it = metrics->point_set_map.find(name);
+  if (it == metrics->point_set_map.end()) return 0;
+  for (const auto& point : it->second->points) {
+    if (point->labels.size() == 1 && point->labels[0].value == label) {
+      return point->int64_value;
+    }
+  }
+  return 0;
+}
+
+TEST_F(ExecutorTest, ExportExecutorStats) {
+  export_executor_stats_ = true;
+  Graph* g = new Graph(OpRegistry::Global());
+  auto in0 = test::graph::Recv(g, "a", "float", ALICE, 1, BOB);
+  auto in1 = test::graph::Recv(g, "b", "float", ALICE, 1, BOB);
+  auto tmp = test::graph::Add(g, in0, in1);
+  test::graph::Send(g, tmp, "c", BOB, 1, ALICE);
+  const int num_nodes = g->num_nodes();
+  Create(g);
+  const string kNodes = "/tensorflow/core/executor/nodes";
+  const string kPhaseCount = "/tensorflow/core/executor/phase_count";
+  auto num_scheduled_nodes = [&kNodes]() {
+    return CounterValue(kNodes, "inline") + CounterValue(kNodes, "dispatched");
+  };
+  const int64 num_scheduled = num_scheduled_nodes();
+  const int64 num_prepare_inputs = CounterValue(kPhaseCount, "prepare_inputs");
+  Rendezvous::Args args;
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0),
+                             false));
+  TF_ASSERT_OK(rendez_->Send(Key(ALICE, kIncarnation, BOB, "b"), args, V(1.0),
+                             false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "c"), args, &out, &is_dead));
+  EXPECT_EQ(2.0, V(out));
+  // Every node is scheduled and prepares its inputs exactly once.
+  EXPECT_EQ(num_scheduled + num_nodes, num_scheduled_nodes());
+  EXPECT_EQ(num_prepare_inputs + num_nodes,
+            CounterValue(kPhaseCount, "prepare_inputs"));
+}
+
 TEST_F(ExecutorTest, SelfAdd) {
   // v0 <- a
   // v1 = v0 + v0
@@ -242,6 +351,66 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, RandomTreeWorkStealing) {
+  scheduler_ = ExecutorOptions::WORK_STEALING;
+  Graph* g = new Graph(OpRegistry::Global());
+  BuildTree(4096, g);
+  Create(g);
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+}
+
+TEST_F(ExecutorTest, RandomTreePriority) {
+  scheduler_ = ExecutorOptions::PRIORITY;
+  priority_measurement_steps_ = 2;
+  Graph* g = new Graph(OpRegistry::Global());
+  BuildTree(4096, g);
+  Create(g);
+  // The first two steps measure compute times, the third one runs with the
+  // recomputed priorities.
+  for (int iters = 0; iters < 3; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    Rendezvous::Args args;
+    TF_ASSERT_OK(
+        rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(Run(rendez));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(
+        rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+    EXPECT_EQ(4096.0, V(out));
+    rendez->Unref();
+  }
+}
+
+TEST_F(ExecutorTest, RandomTreePlanMemory) {
+  plan_memory_ = true;
+  Graph* g = new Graph(OpRegistry::Global());
+  BuildTree(4096, g);
+  Create(g);
+  // The first step records output sizes, later ones run with the plan.
+  for (int iters = 0; iters < 3; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    Rendezvous::Args args;
+    TF_ASSERT_OK(
+        rendez->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+    TF_ASSERT_OK(Run(rendez));
+    Tensor out = V(-1);
+    bool is_dead = false;
+    TF_ASSERT_OK(
+        rendez->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+    EXPECT_EQ(4096.0, V(out));
+    rendez->Unref();
+  }
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -277,6 +446,24 @@ TEST_F(ExecutorTest, ConcurrentAddAssign) {
     rendez->Unref();
   }
 }
+
+TEST_F(ExecutorTest, ConcurrentAddAssignWorkStealing) {
+  scheduler_ = ExecutorOptions::WORK_STEALING;
+  Graph* g = new Graph(OpRegistry::Global());
+  BuildConcurrentAddAssign(g);
+  Create(g);
+  for (int iters = 0; iters < 16; ++iters) {
+    Rendezvous* rendez = NewLocalRendezvous();
+    TF_ASSERT_OK(Run(rendez));
+    Rendezvous::Args args;
+    Tensor out;
+    bool is_dead;
+    TF_ASSERT_OK(rendez->Recv(Key(ALICE, kIncarnation, BOB, "out"), args, &out,
+                              &is_dead));
+    EXPECT_LE(V(out), 1025.0);
+    rendez->Unref();
+  }
+}
 #endif
 
 TEST_F(ExecutorTest, SimpleSwitchLive) {
@@ -36,13 +36,16 @@ limitations under the License.
 #include "tensorflow/core/graph/graph_partition.h"
 #include "tensorflow/core/graph/validate.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
 #include "tensorflow/core/util/env_var.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -114,6 +117,58 @@ Status GraphMgr::DecorateAndPublishGraphForDebug(
 //
 // "executors" are filled with one executor per device if success and
 // the caller takes the ownership of returned executors.
+Status GraphMgr::InitUnit(const string& session,
+                          const FunctionDefLibrary& library,
+                          const GraphOptions& graph_options,
+                          const DebugOptions& debug_options,
+                          GraphOptimizer* optimizer,
+                          std::unique_ptr<Graph>* subgraph,
+                          ExecutionUnit* unit) {
+  // Give the device an opportunity to rewrite its subgraph.
+  TF_RETURN_IF_ERROR(unit->device->MaybeRewriteGraph(library, subgraph));
+
+  // Construct the root executor for the subgraph.
+  LocalExecutorParams params;
+  params.device = unit->device;
+  auto lib = unit->lib;
+  auto opseg = unit->device->op_segment();
+  params.function_library = lib;
+  params.create_kernel = [session, lib, opseg](const NodeDef& ndef,
+                                               OpKernel** kernel) {
+    // Caches the kernel only if the node is stateful.
+    if (!lib->IsStateful(ndef.op())) {
+      return lib->CreateKernel(ndef, kernel);
+    }
+    auto create_fn = [lib, &ndef](OpKernel** kernel) {
+      return lib->CreateKernel(ndef, kernel);
+    };
+    // Kernels created for subgraph nodes need to be cached.  On
+    // cache miss, create_fn() is invoked to create a kernel based
+    // on the function library here + global op registry.
+    return opseg->FindOrCreate(session, ndef.name(), kernel, create_fn);
+  };
+  params.delete_kernel = [lib](OpKernel* kernel) {
+    // If the node is stateful, opseg owns it. Otherwise, delete it.
+    if (kernel && !lib->IsStateful(kernel->type_string())) {
+      delete kernel;
+    }
+  };
+
+  optimizer->Optimize(lib, worker_env_->env, params.device, subgraph);
+
+  // EXPERIMENTAL: tfdbg inserts debug nodes (i.e., probes) to the graph.
+  if (!debug_options.debug_tensor_watch_opts().empty()) {
+    TF_RETURN_IF_ERROR(DecorateAndPublishGraphForDebug(
+        debug_options, subgraph->get(), params.device));
+  }
+
+  TF_RETURN_IF_ERROR(EnsureMemoryTypes(DeviceType(unit->device->device_type()),
+                                       unit->device->name(), subgraph->get()));
+  unit->graph = subgraph->get();
+  unit->build_cost_model = graph_options.build_cost_model();
+  return NewLocalExecutor(params, subgraph->release(), &unit->root);
+}
+
 Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
                           const GraphOptions& graph_options,
                           const DebugOptions& debug_options, Item* item) {
@@ -136,6 +191,16 @@ Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
   opts.expect_device_spec = true;
   TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(opts, gdef, &graph));
 
+  // The partitions are built, optimized and compiled concurrently on the
+  // compute pool, since each belongs to a different device.
+  std::function<void(std::function<void()>)> runner = nullptr;
+  int max_parallelism = 1;
+  if (worker_env_->compute_pool != nullptr) {
+    thread::ThreadPool* pool = worker_env_->compute_pool;
+    runner = [pool](std::function<void()> c) { pool->Schedule(std::move(c)); };
+    max_parallelism = pool->NumThreads();
+  }
+
   // Splits "graph" into multiple subgraphs by device names.
   std::unordered_map<string, GraphDef> partitions;
   PartitionOptions popts;
@@ -155,21 +220,41 @@ Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
   };
   popts.control_flow_added = true;
   popts.scheduling_for_recvs = graph_options.enable_recv_scheduling();
+  popts.runner = runner;
+  popts.max_parallelism = max_parallelism;
   TF_RETURN_IF_ERROR(Partition(popts, &graph, &partitions));
   if (popts.scheduling_for_recvs) {
     TF_RETURN_IF_ERROR(AddControlEdges(popts, &partitions));
   }
 
-  std::unordered_map<string, std::unique_ptr<Graph>> partition_graphs;
+  std::vector<const string*> device_names;
+  std::vector<const GraphDef*> device_defs;
   for (const auto& partition : partitions) {
-    std::unique_ptr<Graph> device_graph(new Graph(OpRegistry::Global()));
+    device_names.push_back(&partition.first);
+    device_defs.push_back(&partition.second);
+  }
+  const int num_partitions = device_names.size();
+  std::vector<std::unique_ptr<Graph>> device_graphs(num_partitions);
+  std::vector<Status> statuses(num_partitions);
+  ShardWithRunner(max_parallelism, runner, num_partitions, [&](int64 i) {
+    device_graphs[i].reset(new Graph(OpRegistry::Global()));
     GraphConstructorOptions device_opts;
     // There are internal operations (e.g., send/recv) that we now allow.
     device_opts.allow_internal_ops = true;
     device_opts.expect_device_spec = true;
-    TF_RETURN_IF_ERROR(ConvertGraphDefToGraph(device_opts, partition.second,
-                                              device_graph.get()));
-    partition_graphs.emplace(partition.first, std::move(device_graph));
+    // The partitions were built from the graph validated above.
+    device_opts.trusted = true;
+    device_opts.runner = runner;
+    device_opts.max_parallelism = max_parallelism;
+    statuses[i] = ConvertGraphDefToGraph(device_opts, *device_defs[i],
+                                         device_graphs[i].get());
+  });
+  for (const Status& s : statuses) {
+    TF_RETURN_IF_ERROR(s);
+  }
+  std::unordered_map<string, std::unique_ptr<Graph>> partition_graphs;
+  for (int i = 0; i < num_partitions; ++i) {
+    partition_graphs.emplace(*device_names[i], std::move(device_graphs[i]));
   }
 
   GraphOptimizationPassOptions optimization_options;
@@ -178,12 +263,9 @@ Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
   TF_RETURN_IF_ERROR(OptimizationPassRegistry::Global()->RunGrouping(
       OptimizationPassRegistry::POST_PARTITIONING, optimization_options));
 
-  LocalExecutorParams params;
-
-  item->units.reserve(partitions.size());
+  item->units.reserve(partition_graphs.size());
   item->graph_mgr = this;
-  const auto& optimizer_opts = graph_options.optimizer_options();
-  GraphOptimizer optimizer(optimizer_opts);
+  std::vector<std::unique_ptr<Graph>*> subgraphs;
   for (auto& p : partition_graphs) {
     const string& device_name = p.first;
     std::unique_ptr<Graph>& subgraph = p.second;
@@ -199,72 +281,87 @@ Status GraphMgr::InitItem(const string& session, const GraphDef& gdef,
       return s;
     }
 
-    // Give the device an opportunity to rewrite its subgraph.
-    TF_RETURN_IF_ERROR(
-        unit->device->MaybeRewriteGraph(gdef.library(), &subgraph));
-
     // Top-level nodes in the graph uses the op segment to cache
     // kernels. Therefore, as long as the executor is alive, we need
     // to ensure the kernels cached for the session are alive.
-    auto opseg = unit->device->op_segment();
-    opseg->AddHold(session);
+    unit->device->op_segment()->AddHold(session);
 
     // Function library runtime.
     unit->lib = NewFunctionLibraryRuntime(
         device_mgr_, worker_env_->env, unit->device,
         subgraph->versions().producer(), item->lib_def,
         graph_options.optimizer_options());
+    subgraphs.push_back(&subgraph);
+  }
 
-    // Construct the root executor for the subgraph.
-    params.device = unit->device;
-    auto lib = unit->lib;
-    params.function_library = lib;
-    params.create_kernel = [session, lib, opseg](const NodeDef& ndef,
-                                                 OpKernel** kernel) {
-      // Caches the kernel only if the node is stateful.
-      if (!lib->IsStateful(ndef.op())) {
-        return lib->CreateKernel(ndef, kernel);
-      }
-      auto create_fn = [lib, &ndef](OpKernel** kernel) {
-        return lib->CreateKernel(ndef, kernel);
-      };
-      // Kernels created for subgraph nodes need to be cached.  On
-      // cache miss, create_fn() is invoked to create a kernel based
-      // on the function library here + global op registry.
-      return opseg->FindOrCreate(session, ndef.name(), kernel, create_fn);
-    };
-    params.delete_kernel = [lib](OpKernel* kernel) {
-      // If the node is stateful, opseg owns it. Otherwise, delete it.
-      if (kernel && !lib->IsStateful(kernel->type_string())) {
-        delete kernel;
-      }
-    };
-
-    optimizer.Optimize(lib, worker_env_->env, params.device, &subgraph);
-
-    // EXPERIMENTAL: tfdbg inserts debug nodes (i.e., probes) to the graph.
-    if (!debug_options.debug_tensor_watch_opts().empty()) {
-      TF_RETURN_IF_ERROR(DecorateAndPublishGraphForDebug(
-          debug_options, subgraph.get(), params.device));
-    }
-
-    TF_RETURN_IF_ERROR(
-        EnsureMemoryTypes(DeviceType(unit->device->device_type()),
-                          unit->device->name(), subgraph.get()));
-    unit->graph = subgraph.get();
-    unit->build_cost_model = graph_options.build_cost_model();
-    if (unit->build_cost_model > 0) {
+  const auto& optimizer_opts = graph_options.optimizer_options();
+  GraphOptimizer optimizer(optimizer_opts);
+  const int num_units = item->units.size();
+  statuses.assign(num_units, Status::OK());
+  ShardWithRunner(max_parallelism, runner, num_units, [&](int64 i) {
+    ExecutionUnit* unit = &item->units[i];
+    std::unique_ptr<Graph>& subgraph = *subgraphs[i];
+    statuses[i] = InitUnit(session, gdef.library(), graph_options,
+                           debug_options, &optimizer, &subgraph, unit);
+  });
+  for (const ExecutionUnit& unit : item->units) {
+    if (unit.build_cost_model > 0) {
       skip_cost_models_ = false;
     }
-    TF_RETURN_IF_ERROR(
-        NewLocalExecutor(params, subgraph.release(), &unit->root));
+  }
+  for (const Status& s : statuses) {
+    TF_RETURN_IF_ERROR(s);
   }
   return Status::OK();
 }
 
+namespace {
+
+// Appends the serialization of "msg" to "out", with the fields of
+// maps (e.g. the attrs of a NodeDef) in a deterministic order.
+template <typename T>
+void AppendDeterministicSerialization(const T& msg, string* out) {
+  const int size = msg.ByteSize();
+  const size_t offset = out->size();
+  out->resize(offset + size);
+  protobuf::io::ArrayOutputStream array_stream(&(*out)[offset], size);
+  protobuf::io::CodedOutputStream output_stream(&array_stream);
+  output_stream.SetSerializationDeterministic(true);
+  msg.SerializeWithCachedSizes(&output_stream);
+}
+
+Fprint128 FingerprintRegistration(const string& session, const GraphDef& gdef,
+                                  const GraphOptions& graph_options,
+                                  const DebugOptions& debug_options) {
+  string buf = session;
+  AppendDeterministicSerialization(gdef, &buf);
+  AppendDeterministicSerialization(graph_options, &buf);
+  AppendDeterministicSerialization(debug_options, &buf);
+  return Fingerprint128(buf);
+}
+
+}  // namespace
+
 Status GraphMgr::Register(const string& session, const GraphDef& gdef,
                           const GraphOptions& graph_options,
                           const DebugOptions& debug_options, string* handle) {
+  const Fprint128 fingerprint =
+      FingerprintRegistration(session, gdef, graph_options, debug_options);
+  {
+    mutex_lock l(mu_);
+    Item* item = gtl::FindPtrOrNull(items_by_fingerprint_, fingerprint);
+    if (item != nullptr) {
+      // Shares the item built for the identical registration.
+      item->Ref();
+      ++item->num_handles;
+      *handle = strings::Printf("%016llx", ++next_id_);
+      CHECK(table_.insert({*handle, item}).second);
+      VLOG(1) << "Graph " << *handle << " shares the graph of "
+              << item->handle;
+      return Status::OK();
+    }
+  }
+
   Item* item = new Item;
   Status s = InitItem(session, gdef, graph_options, debug_options, item);
   if (!s.ok()) {
@@ -277,7 +374,11 @@ Status GraphMgr::Register(const string& session, const GraphDef& gdef,
     mutex_lock l(mu_);
     *handle = strings::Printf("%016llx", ++next_id_);
     item->handle = *handle;
+    item->fingerprint = fingerprint;
     CHECK(table_.insert({*handle, item}).second);
+    // An identical registration that raced with this one may have been
+    // inserted first, in which case this item is simply not shared.
+    items_by_fingerprint_.insert({fingerprint, item});
   }
   return Status::OK();
 }
@@ -294,6 +395,12 @@ Status GraphMgr::Deregister(const string& handle) {
     }
     item = iter->second;
     table_.erase(iter);
+    if (--item->num_handles == 0) {
+      auto fp_iter = items_by_fingerprint_.find(item->fingerprint);
+      if (fp_iter != items_by_fingerprint_.end() && fp_iter->second == item) {
+        items_by_fingerprint_.erase(fp_iter);
+      }
+    }
   }
   item->Unref();
   return Status::OK();
@@ -306,8 +413,10 @@ Status GraphMgr::DeregisterAll() {
     mutex_lock l(mu_);
     for (const auto& entry : table_) {
       items.push_back(entry.second);
+      entry.second->num_handles = 0;
     }
     table_.clear();
+    items_by_fingerprint_.clear();
   }
   for (auto item : items) {
     item->Unref();
@@ -477,9 +586,16 @@ void GraphMgr::ExecuteAsync(const string& handle, const int64 step_id,
     return;
   }
 
+  if (collector != nullptr) {
+    rendezvous->SetStepStatsCollector(collector);
+  }
   StartParallelExecutors(handle, step_id, item, rendezvous, collector,
                          cost_graph, cancellation_manager,
-                         [this, item, rendezvous, done](const Status& s) {
+                         [this, item, rendezvous, collector,
+                          done](const Status& s) {
+                           if (collector != nullptr) {
+                             rendezvous->SetStepStatsCollector(nullptr);
+                           }
                            done(s);
                            rendezvous->Unref();
                            item->Unref();
@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/cost_graph.pb.h"
 #include "tensorflow/core/lib/core/refcount.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -38,6 +39,7 @@ class ExecutorOpts;
 class StepStatsCollector;
 class RendezvousMgrInterface;
 class DeviceMgr;
+class GraphOptimizer;
 struct WorkerSession;
 
 // GraphMgr keeps track of a set of graphs that are registered with a
@@ -68,6 +70,11 @@ class GraphMgr {
   ~GraphMgr();
 
   // Registers a graph. Fills in "handle"
+  //
+  // A registration identical to one still registered, with the same
+  // session, graph and options, gets a handle of its own to the graph that
+  // is already built, which is only released when all its handles are
+  // deregistered.
   Status Register(const string& session, const GraphDef& gdef,
                   const GraphOptions& graph_options,
                   const DebugOptions& debug_options, string* handle);
@@ -119,6 +126,13 @@ class GraphMgr {
     // Graph handle.
     string handle;
 
+    // Identifies the registration request, see Register().
+    Fprint128 fingerprint = {0, 0};
+
+    // The number of handles that share this item.  Guarded by
+    // GraphMgr::mu_.
+    int num_handles = 1;
+
     // The definition of the library is shared by all partitions.
     FunctionLibraryDefinition* lib_def = nullptr;
 
@@ -150,6 +164,11 @@ class GraphMgr {
   // mechanism to gc these graphs.
   std::unordered_map<string, Item*> table_;
 
+  // The registered items by the fingerprint of their registration.  Not
+  // owned: an item leaves this map when its last handle is deregistered.
+  std::unordered_map<Fprint128, Item*, Fprint128Hasher> items_by_fingerprint_
+      GUARDED_BY(mu_);
+
   void StartParallelExecutors(const string& handle, int64 step_id, Item* item,
                               Rendezvous* rendezvous,
                               StepStatsCollector* collector,
@@ -173,6 +192,13 @@ class GraphMgr {
                   const GraphOptions& graph_options,
                   const DebugOptions& debug_options, Item* item);
 
+  // Optimizes "*subgraph" for the device of "unit", whose "lib" is set,
+  // and creates its executor.  Safe to call for several units at once.
+  Status InitUnit(const string& session, const FunctionDefLibrary& library,
+                  const GraphOptions& graph_options,
+                  const DebugOptions& debug_options, GraphOptimizer* optimizer,
+                  std::unique_ptr<Graph>* subgraph, ExecutionUnit* unit);
+
   Status DecorateAndPublishGraphForDebug(const DebugOptions& debug_options,
                                          Graph* graph, Device* device);
 
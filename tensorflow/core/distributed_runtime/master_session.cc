@@ -44,12 +44,16 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/public/session_options.h"
+#include "tensorflow/core/util/device_name_utils.h"
 
 namespace tensorflow {
 
@@ -177,6 +181,10 @@ class MasterSession::ReffedClientGraph : public core::RefCounted {
   // `done` when all cleanup RPCs have completed.
   void CleanupPartitionsAsync(int64 step_id, StatusCallback done);
 
+  // Shifts the timestamps reported by each task in "pss" to the clock of the
+  // master, so that events of different machines can be compared.
+  void AlignStepStatsClocks(PerStepState* pss);
+
   // Post-processing of any runtime statistics gathered during execution.
   void ProcessStats(int64 step_id, PerStepState* pss,
                     ProfileHandler* ph, const RunOptions& options,
@@ -437,12 +445,17 @@ class RunManyGraphs {
     CallOptions opts;
     std::unique_ptr<MutableRunGraphRequestWrapper> req;
     std::unique_ptr<MutableRunGraphResponseWrapper> resp;
+    // When the call was issued and when it completed, on the clock of the
+    // master.
+    int64 start_micros = 0;
+    int64 end_micros = 0;
   };
   Call* get(int index) { return &calls_[index]; }
 
   // When the index-th call is done, updates the overall status.
   void WhenDone(int index, const Status& s) {
     TRACEPRINTF("Partition %d %s", index, s.ToString().c_str());
+    calls_[index].end_micros = Env::Default()->NowMicros();
     if (!s.ok()) {
       mutex_lock l(mu_);
       UpdateStatusLocked(s);
@@ -513,6 +526,10 @@ Status MasterSession::ReffedClientGraph::RunPartitions(
   if (pss->collect_costs || pss->collect_timeline) {
     pss->step_stats.resize(partitions_.size());
   }
+  if (pss->collect_timeline) {
+    pss->run_graph_start_micros.resize(partitions_.size());
+    pss->run_graph_end_micros.resize(partitions_.size());
+  }
 
   const int num = partitions_.size();
   RunManyGraphs calls(num);
@@ -586,6 +603,7 @@ Status MasterSession::ReffedClientGraph::RunPartitions(
     const Part& part = partitions_[i];
     RunManyGraphs::Call* call = calls.get(i);
     TRACEPRINTF("Partition %d %s", i, part.name.c_str());
+    call->start_micros = Env::Default()->NowMicros();
     part.worker->RunGraphAsync(
         &call->opts, call->req.get(), call->resp.get(),
         std::bind(&RunManyGraphs::WhenDone, &calls, i, std::placeholders::_1));
@@ -628,6 +646,8 @@ Status MasterSession::ReffedClientGraph::RunPartitions(
       }
       if (pss->collect_timeline) {
         pss->step_stats[i].Swap(calls.get(i)->resp->mutable_step_stats());
+        pss->run_graph_start_micros[i] = calls.get(i)->start_micros;
+        pss->run_graph_end_micros[i] = calls.get(i)->end_micros;
       }
       if (pss->collect_costs) {
         CostGraphDef* cost_graph = calls.get(i)->resp->mutable_cost_graph();
@@ -708,6 +728,81 @@ void MasterSession::ReffedClientGraph::CleanupPartitionsAsync(
   }
 }
 
+void MasterSession::ReffedClientGraph::AlignStepStatsClocks(
+    PerStepState* pss) {
+  // The events of a partition happened between the issue (t0) and the
+  // completion (t3) of its RunGraph call. Assuming that the request and the
+  // response took as long, the offset of the clock of the worker is
+  // ((first_event - t0) + (last_event - t3)) / 2, within half the time of the
+  // call not covered by the events. The most precise estimate of each task is
+  // used.
+  struct TaskClock {
+    int64 offset = 0;
+    int64 error = kint64max;
+  };
+  std::unordered_map<string, TaskClock> clocks;
+  string task;
+  string device;
+  for (size_t i = 0; i < pss->step_stats.size(); ++i) {
+    if (i >= pss->run_graph_start_micros.size()) break;
+    const int64 t0 = pss->run_graph_start_micros[i];
+    const int64 t3 = pss->run_graph_end_micros[i];
+    int64 first_event = kint64max;
+    int64 last_event = kint64min;
+    task.clear();
+    for (const auto& ds : pss->step_stats[i].dev_stats()) {
+      if (task.empty() &&
+          !DeviceNameUtils::SplitDeviceName(ds.device(), &task, &device)) {
+        task.clear();
+      }
+      for (const auto& ns : ds.node_stats()) {
+        first_event = std::min<int64>(first_event, ns.all_start_micros());
+        last_event = std::max<int64>(
+            last_event, ns.all_start_micros() + ns.all_end_rel_micros());
+      }
+    }
+    if (task.empty() || t3 <= t0 || first_event > last_event) continue;
+    TaskClock estimate;
+    estimate.offset = ((first_event - t0) + (last_event - t3)) / 2;
+    estimate.error =
+        std::max<int64>(0, ((t3 - t0) - (last_event - first_event)) / 2);
+    TaskClock* clock = &clocks[task];
+    if (estimate.error < clock->error) *clock = estimate;
+  }
+
+  // Clocks that can't be told apart from the one of the master, e.g. those
+  // of tasks in the same process, are left alone.
+  for (auto it = clocks.begin(); it != clocks.end();) {
+    VLOG(1) << "Clock of " << it->first << " is " << it->second.offset
+            << " +/- " << it->second.error << "us ahead of the master";
+    if (std::abs(it->second.offset) <= it->second.error) {
+      it = clocks.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  if (clocks.empty()) return;
+
+  auto align = [&clocks, &task, &device](StepStats* ss) {
+    for (auto& ds : *ss->mutable_dev_stats()) {
+      if (!DeviceNameUtils::SplitDeviceName(ds.device(), &task, &device)) {
+        continue;
+      }
+      auto it = clocks.find(task);
+      if (it == clocks.end()) continue;
+      for (auto& ns : *ds.mutable_node_stats()) {
+        ns.set_all_start_micros(ns.all_start_micros() - it->second.offset);
+      }
+    }
+  };
+  for (StepStats& ss : pss->step_stats) {
+    align(&ss);
+  }
+  // RPCs are logged by the workers that receive the tensors, under the
+  // device they are received on.
+  align(&pss->rpc_stats);
+}
+
 void MasterSession::ReffedClientGraph::ProcessStats(int64 step_id,
                                                     PerStepState* pss,
                                                     ProfileHandler* ph,
@@ -719,6 +814,7 @@ void MasterSession::ReffedClientGraph::ProcessStats(int64 step_id,
   if (pss->collect_timeline) {
     SetRPCLogging(false);
     RetrieveLogs(step_id, &pss->rpc_stats);
+    AlignStepStatsClocks(pss);
   }
   for (size_t i = 0; i < partitions_.size(); ++i) {
     const StepStats& ss = pss->step_stats[i];
@@ -953,6 +1049,32 @@ uint64 HashBuildGraphOptions(const BuildGraphOptions& opts) {
   return h;
 }
 
+// Returns a fingerprint of the client graph "cg" built for "opts".  Two
+// signatures get the same fingerprint if their pruned graphs are identical,
+// in which case they partition and register alike.
+uint64 FingerprintClientGraph(const SimpleClientGraph& cg,
+                              const BuildGraphOptions& opts) {
+  GraphDef gdef;
+  cg.graph.ToGraphDef(&gdef);
+  // The attrs of the nodes are maps, which only serialize in a
+  // deterministic order on request.
+  string buf(gdef.ByteSize(), '\0');
+  protobuf::io::ArrayOutputStream array_stream(&buf[0], buf.size());
+  protobuf::io::CodedOutputStream output_stream(&array_stream);
+  output_stream.SetSerializationDeterministic(true);
+  gdef.SerializeWithCachedSizes(&output_stream);
+  uint64 h = Fingerprint64(buf);
+
+  // The debug watches are added by the workers when they register the
+  // partitions.
+  if (!opts.debug_options.debug_tensor_watch_opts().empty()) {
+    const string watch_summary = SummarizeDebugTensorWatches(
+        opts.debug_options.debug_tensor_watch_opts());
+    h = FingerprintCat64(h, Fingerprint64(watch_summary));
+  }
+  return h;
+}
+
 string BuildGraphOptionsString(const BuildGraphOptions& opts) {
   string buf;
   for (const string& name : opts.feed_endpoints) {
@@ -1184,13 +1306,26 @@ Status MasterSession::StartStep(const BuildGraphOptions& opts, int64* count,
               << "\n";
       std::unique_ptr<SimpleClientGraph> client_graph;
       TF_RETURN_IF_ERROR(execution_state_->BuildGraph(opts, &client_graph));
-      WorkerCacheInterface* worker_cache = get_worker_cache();
-      auto entry = new ReffedClientGraph(
-          handle_, opts, std::move(client_graph), session_opts_,
-          stats_publisher_factory_, execution_state_.get(), is_partial,
-          worker_cache);
+      RCGMap* by_fingerprint = is_partial ? &partial_run_graphs_by_fingerprint_
+                                          : &run_graphs_by_fingerprint_;
+      const uint64 fingerprint = FingerprintClientGraph(*client_graph, opts);
+      ReffedClientGraph* entry =
+          gtl::FindPtrOrNull(*by_fingerprint, fingerprint);
+      if (entry != nullptr) {
+        // Another signature prunes to the same graph: reuse its partitions,
+        // which are already registered with the workers.
+        VLOG(1) << "Sharing the graph of fingerprint " << fingerprint;
+        entry->Ref();
+      } else {
+        WorkerCacheInterface* worker_cache = get_worker_cache();
+        entry = new ReffedClientGraph(
+            handle_, opts, std::move(client_graph), session_opts_,
+            stats_publisher_factory_, execution_state_.get(), is_partial,
+            worker_cache);
+        by_fingerprint->insert({fingerprint, entry});
+        VLOG(1) << "Preparing to execute new graph";
+      }
       iter = m->insert({hash, entry}).first;
-      VLOG(1) << "Preparing to execute new graph";
     }
     *rcg = iter->second;
     (*rcg)->Ref();
@@ -1317,6 +1452,9 @@ Status MasterSession::BuildAndRegisterPartitions(ReffedClientGraph* rcg) {
     popts.scheduling_for_recvs = true;
     popts.need_to_record_start_times = true;
   }
+  // The partitions of the workers are built concurrently.
+  popts.runner = SchedClosure;
+  popts.max_parallelism = port::NumSchedulableCPUs();
 
   TF_RETURN_IF_ERROR(
       rcg->RegisterPartitions(popts, *rcg->client_graph()->flib_def));
@@ -1570,6 +1708,8 @@ Status MasterSession::Close() {
     }
     ClearRunsTable(&to_unref, &run_graphs_);
     ClearRunsTable(&to_unref, &partial_run_graphs_);
+    run_graphs_by_fingerprint_.clear();
+    partial_run_graphs_by_fingerprint_.clear();
   }
   for (ReffedClientGraph* rcg : to_unref) rcg->Unref();
   return Status::OK();
@@ -141,6 +141,13 @@ class MasterSession : public core::RefCounted {
   RCGMap run_graphs_ GUARDED_BY(mu_);
   RCGMap partial_run_graphs_ GUARDED_BY(mu_);
 
+  // The entries of run_graphs_ and partial_run_graphs_ by the fingerprint
+  // of their client graph (see FingerprintClientGraph()).  Signatures whose
+  // pruned graphs are identical share one ReffedClientGraph, and so its
+  // partitions and their registrations.  Not owned.
+  RCGMap run_graphs_by_fingerprint_ GUARDED_BY(mu_);
+  RCGMap partial_run_graphs_by_fingerprint_ GUARDED_BY(mu_);
+
   struct PerStepState {
     bool collect_costs = false;
     bool collect_timeline = false;
@@ -149,6 +156,10 @@ class MasterSession : public core::RefCounted {
     Microseconds end_micros = Microseconds(0);
     std::vector<StepStats> step_stats;  // per partition
     StepStats rpc_stats;                // for RPC layer
+    // Per partition, when its RunGraph call was issued and when it completed,
+    // on the clock of the master.
+    std::vector<int64> run_graph_start_micros;
+    std::vector<int64> run_graph_end_micros;
     CostGraphDef cost_graph;
   };
 
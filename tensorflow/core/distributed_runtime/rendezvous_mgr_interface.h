@@ -25,6 +25,7 @@ limitations under the License.
 
 namespace tensorflow {
 
+class StepStatsCollector;
 struct WorkerSession;
 
 // RemoteRendezvous follow a 2-part initialization. First the objects are
@@ -40,6 +41,11 @@ class RemoteRendezvous : public Rendezvous {
  public:
   // Fully construct the RemoteRendezvous.
   virtual Status Initialize(WorkerSession* session) = 0;
+
+  // Records statistics about the transfers of the step, e.g. the sizes of
+  // compressed tensors, into "collector" until it is reset to nullptr.
+  // The caller retains ownership of "collector".
+  virtual void SetStepStatsCollector(StepStatsCollector* collector) {}
 };
 
 // RendezvousMgr keeps track of a set of local rendezvous instances.
@@ -81,6 +87,17 @@ class RendezvousMgrInterface {
                               const Rendezvous::ParsedKey& parsed,
                               Rendezvous::DoneCallback done) = 0;
 
+  // Like RecvLocalAsync(), but only if the tensor for "key" has already
+  // been produced, in which case it runs "done" and returns true.
+  // Otherwise returns false without waiting for the tensor.
+  //
+  // This method is used by the rpc handler of RecvTensorBatch.
+  virtual bool RecvLocalAsyncIfSent(int64 step_id,
+                                    const Rendezvous::ParsedKey& parsed,
+                                    Rendezvous::DoneCallback done) {
+    return false;
+  }
+
   // Synchronous wrapper for RecvLocalAsync.
   virtual Status RecvLocal(int64 step_id, const Rendezvous::ParsedKey& parsed,
                            Tensor* val, bool* is_dead) = 0;
@@ -57,6 +57,11 @@ Status ValidateHostPortPair(const string& host_port) {
 
 Status NewHostPortGrpcChannel(const string& target,
                               SharedGrpcChannelPtr* channel_pointer) {
+  return NewHostPortGrpcPoolChannel(target, 0, channel_pointer);
+}
+
+Status NewHostPortGrpcPoolChannel(const string& target, int index,
+                                  SharedGrpcChannelPtr* channel_pointer) {
   // Minimally ensure that the target is valid
   TF_RETURN_IF_ERROR(ValidateHostPortPair(target));
 
@@ -66,6 +71,11 @@ Status NewHostPortGrpcChannel(const string& target,
   // NOTE(mrry): Some versions of gRPC use a 20-second minimum backoff
   // on connection failure, which makes our tests time out.
   args.SetInt("grpc.testing.fixed_reconnect_backoff_ms", 1000);
+  // gRPC shares the connections of channels with the same arguments, so
+  // an argument of our own keeps the connections of a pool apart.
+  if (index > 0) {
+    args.SetInt("tensorflow.grpc_connection_index", index);
+  }
   *channel_pointer = ::grpc::CreateCustomChannel(
       target, ::grpc::InsecureChannelCredentials(), args);
   return Status::OK();
@@ -84,6 +94,20 @@ ChannelCreationFunction ConvertToChannelCreationFunction(
   };
 }
 
+ChannelPoolCreationFunction ConvertToChannelPoolCreationFunction(
+    const std::function<Status(string, int, SharedGrpcChannelPtr*)>&
+        new_channel_func_ptr) {
+  return [new_channel_func_ptr](const string& target,
+                                int index) -> SharedGrpcChannelPtr {
+    SharedGrpcChannelPtr channel_ptr;
+    if (new_channel_func_ptr(target, index, &channel_ptr).ok()) {
+      return channel_ptr;
+    } else {
+      return nullptr;
+    }
+  };
+}
+
 Status GrpcChannelSpec::AddHostPortsJob(const string& job_id,
                                         const std::vector<string>& host_ports) {
   std::map<int, string> host_ports_map;
@@ -116,32 +140,40 @@ class CachingGrpcChannelCache : public GrpcChannelCache {
   ~CachingGrpcChannelCache() override {}
 
   SharedGrpcChannelPtr FindWorkerChannel(const string& target) override {
+    return FindWorkerPoolChannel(target, 0);
+  }
+
+  SharedGrpcChannelPtr FindWorkerPoolChannel(const string& target,
+                                             int index) override {
+    const std::pair<string, int> key(target, index);
     SharedGrpcChannelPtr ch = nullptr;
     {
       mutex_lock l(mu_);  // could use reader lock
-      ch = gtl::FindPtrOrNull(channels_, target);
+      ch = gtl::FindPtrOrNull(channels_, key);
       if (ch) {
         return ch;
       }
     }
-    ch = FindChannelOnce(target);
+    ch = FindChannelOnce(target, index);
     if (ch) {
       mutex_lock l(mu_);
-      channels_.insert({target, ch});
+      channels_.insert({key, ch});
     }
     return ch;
   }
 
  protected:
-  // Find the ClientChannel for "target".  Only called when no channel was
-  // found in the channels_ cache for "target".  A non nullptr result will be
-  // cached in channels_.
-  virtual SharedGrpcChannelPtr FindChannelOnce(const string& target) = 0;
+  // Find the ClientChannel for the "index"th connection to "target".  Only
+  // called when no channel was found in the channels_ cache for them.  A
+  // non nullptr result will be cached in channels_.
+  virtual SharedGrpcChannelPtr FindChannelOnce(const string& target,
+                                               int index) = 0;
 
  private:
   // TODO(zhifengc): Eviction when the map becomes too big.
   mutex mu_;
-  std::unordered_map<string, SharedGrpcChannelPtr> channels_ GUARDED_BY(mu_);
+  std::map<std::pair<string, int>, SharedGrpcChannelPtr> channels_
+      GUARDED_BY(mu_);
 };
 
 // A ChannelCache that is the union of multiple ChannelCaches.
@@ -182,9 +214,10 @@ class MultiGrpcChannelCache : public CachingGrpcChannelCache {
   }
 
  protected:
-  SharedGrpcChannelPtr FindChannelOnce(const string& target) override {
+  SharedGrpcChannelPtr FindChannelOnce(const string& target,
+                                       int index) override {
     for (GrpcChannelCache* cache : caches_) {
-      SharedGrpcChannelPtr ch(cache->FindWorkerChannel(target));
+      SharedGrpcChannelPtr ch(cache->FindWorkerPoolChannel(target, index));
       if (ch) {
         mutex_lock l(mu_);
         target_caches_.insert({target, cache});
@@ -208,7 +241,7 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
  public:
   SparseGrpcChannelCache(const string& job_id,
                          const std::map<int, string>& host_ports,
-                         ChannelCreationFunction channel_func)
+                         ChannelPoolCreationFunction channel_func)
       : job_id_(job_id),
         host_ports_(host_ports),
         channel_func_(std::move(channel_func)) {
@@ -248,12 +281,13 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
   }
 
  protected:
-  SharedGrpcChannelPtr FindChannelOnce(const string& target) override {
+  SharedGrpcChannelPtr FindChannelOnce(const string& target,
+                                       int index) override {
     const string host_port = TranslateTask(target);
     if (host_port.empty()) {
       return nullptr;
     }
-    return channel_func_(host_port);
+    return channel_func_(host_port, index);
   }
 
  private:
@@ -270,7 +304,7 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
 
   const string job_id_;
   const std::map<int, string> host_ports_;
-  const ChannelCreationFunction channel_func_;
+  const ChannelPoolCreationFunction channel_func_;
   TF_DISALLOW_COPY_AND_ASSIGN(SparseGrpcChannelCache);
 };
 
@@ -278,6 +312,14 @@ class SparseGrpcChannelCache : public CachingGrpcChannelCache {
 
 GrpcChannelCache* NewGrpcChannelCache(const GrpcChannelSpec& spec,
                                       ChannelCreationFunction channel_func) {
+  return NewGrpcChannelPoolCache(
+      spec, [channel_func](const string& target, int index) {
+        return channel_func(target);
+      });
+}
+
+GrpcChannelCache* NewGrpcChannelPoolCache(
+    const GrpcChannelSpec& spec, ChannelPoolCreationFunction channel_func) {
   const int num_jobs = spec.host_ports_jobs().size();
   if (!num_jobs) {
     LOG(ERROR) << "Empty channel spec.";
@@ -73,24 +73,51 @@ class GrpcChannelCache {
   // E.g., /job:mnist/task:2
   virtual SharedGrpcChannelPtr FindWorkerChannel(const string& target) = 0;
 
+  // Returns the channel for the 'index'th connection to the remote worker
+  // named by 'target'.  Index 0 is the channel of FindWorkerChannel().
+  // Channels of different indices use different connections if the
+  // channel creation function makes them so (see
+  // NewHostPortGrpcPoolChannel).
+  virtual SharedGrpcChannelPtr FindWorkerPoolChannel(const string& target,
+                                                     int index) = 0;
+
   // Translates a string in the form `/job:X/task:Z` into a host_port.
   virtual string TranslateTask(const string& task) = 0;
 };
 
 typedef std::function<SharedGrpcChannelPtr(string)> ChannelCreationFunction;
 
+// Creates the channel for a connection index to a host:port.
+typedef std::function<SharedGrpcChannelPtr(string, int)>
+    ChannelPoolCreationFunction;
+
+// The channels of all the indices of FindWorkerPoolChannel() come from
+// 'channel_func', and so share their connection.
 GrpcChannelCache* NewGrpcChannelCache(const GrpcChannelSpec& channel_spec,
                                       ChannelCreationFunction channel_func);
 
+GrpcChannelCache* NewGrpcChannelPoolCache(
+    const GrpcChannelSpec& channel_spec,
+    ChannelPoolCreationFunction channel_func);
+
 // Below here are internal-only functions.
 
 ChannelCreationFunction ConvertToChannelCreationFunction(
     const std::function<Status(string, SharedGrpcChannelPtr*)>&
         new_channel_func_ptr);
 
+ChannelPoolCreationFunction ConvertToChannelPoolCreationFunction(
+    const std::function<Status(string, int, SharedGrpcChannelPtr*)>&
+        new_channel_func_ptr);
+
 Status NewHostPortGrpcChannel(const string& target,
                               SharedGrpcChannelPtr* channel_pointer);
 
+// Like NewHostPortGrpcChannel(), for the 'index'th connection to 'target':
+// gRPC gives channels of different indices connections of their own.
+Status NewHostPortGrpcPoolChannel(const string& target, int index,
+                                  SharedGrpcChannelPtr* channel_pointer);
+
 }  // namespace tensorflow
 
 #endif  // THIRD_PARTY_TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_CHANNEL_H_
@@ -144,6 +144,32 @@ TEST(GrpcChannelTest, SparseHostPorts) {
             workers);
 }
 
+TEST(GrpcChannelTest, PoolChannels) {
+  GrpcChannelSpec spec;
+  TF_EXPECT_OK(spec.AddHostPortsJob("mnist", {"a:1", "b:2", "c:3"}));
+  ChannelPoolCreationFunction channel_func =
+      ConvertToChannelPoolCreationFunction(NewHostPortGrpcPoolChannel);
+  std::unique_ptr<GrpcChannelCache> cc(
+      NewGrpcChannelPoolCache(spec, channel_func));
+
+  EXPECT_EQ(nullptr, cc->FindWorkerPoolChannel("invalid_target", 1));
+  EXPECT_EQ(nullptr,
+            cc->FindWorkerPoolChannel("/job:mnist/replica:0/task:3", 1));
+
+  auto a_0 = cc->FindWorkerChannel("/job:mnist/replica:0/task:0");
+  auto a_0_pool = cc->FindWorkerPoolChannel("/job:mnist/replica:0/task:0", 0);
+  auto a_1 = cc->FindWorkerPoolChannel("/job:mnist/replica:0/task:0", 1);
+  auto a_1_again = cc->FindWorkerPoolChannel("/job:mnist/replica:0/task:0", 1);
+  auto a_2 = cc->FindWorkerPoolChannel("/job:mnist/replica:0/task:0", 2);
+  auto b_1 = cc->FindWorkerPoolChannel("/job:mnist/replica:0/task:1", 1);
+
+  EXPECT_EQ(a_0.get(), a_0_pool.get());
+  EXPECT_EQ(a_1.get(), a_1_again.get());
+  EXPECT_NE(a_0.get(), a_1.get());
+  EXPECT_NE(a_1.get(), a_2.get());
+  EXPECT_NE(a_1.get(), b_1.get());
+}
+
 TEST(GrpcChannelTest, NewHostPortGrpcChannelValidation) {
   SharedGrpcChannelPtr mock_ptr;
 
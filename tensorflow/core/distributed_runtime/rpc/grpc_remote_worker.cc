@@ -36,21 +36,31 @@ namespace tensorflow {
 
 class GrpcRemoteWorker : public WorkerInterface {
  public:
-  explicit GrpcRemoteWorker(SharedGrpcChannelPtr channel,
-                            ::grpc::CompletionQueue* completion_queue,
-                            WorkerCacheLogger* logger)
-      : channel_(std::move(channel)),
+  // RunGraph, RecvTensor and RecvTensorBatch calls use "data_channel",
+  // and the other calls "control_channel".
+  GrpcRemoteWorker(SharedGrpcChannelPtr data_channel,
+                   SharedGrpcChannelPtr control_channel,
+                   ::grpc::CompletionQueue* completion_queue,
+                   WorkerCacheLogger* logger)
+      : data_channel_(std::move(data_channel)),
+        control_channel_(std::move(control_channel)),
         cq_(completion_queue),
-        getstatus_(Method(GrpcWorkerMethod::kGetStatus)),
-        createworkersession_(Method(GrpcWorkerMethod::kCreateWorkerSession)),
-        registergraph_(Method(GrpcWorkerMethod::kRegisterGraph)),
-        deregistergraph_(Method(GrpcWorkerMethod::kDeregisterGraph)),
-        rungraph_(Method(GrpcWorkerMethod::kRunGraph)),
-        cleanupgraph_(Method(GrpcWorkerMethod::kCleanupGraph)),
-        cleanupall_(Method(GrpcWorkerMethod::kCleanupAll)),
-        recvtensor_(Method(GrpcWorkerMethod::kRecvTensor)),
-        logging_(Method(GrpcWorkerMethod::kLogging)),
-        tracing_(Method(GrpcWorkerMethod::kTracing)),
+        getstatus_(Method(GrpcWorkerMethod::kGetStatus, control_channel_)),
+        createworkersession_(Method(GrpcWorkerMethod::kCreateWorkerSession,
+                                    control_channel_)),
+        registergraph_(
+            Method(GrpcWorkerMethod::kRegisterGraph, control_channel_)),
+        deregistergraph_(
+            Method(GrpcWorkerMethod::kDeregisterGraph, control_channel_)),
+        rungraph_(Method(GrpcWorkerMethod::kRunGraph, data_channel_)),
+        cleanupgraph_(
+            Method(GrpcWorkerMethod::kCleanupGraph, control_channel_)),
+        cleanupall_(Method(GrpcWorkerMethod::kCleanupAll, control_channel_)),
+        recvtensor_(Method(GrpcWorkerMethod::kRecvTensor, data_channel_)),
+        logging_(Method(GrpcWorkerMethod::kLogging, control_channel_)),
+        tracing_(Method(GrpcWorkerMethod::kTracing, control_channel_)),
+        recvtensorbatch_(
+            Method(GrpcWorkerMethod::kRecvTensorBatch, data_channel_)),
         logger_(logger) {}
 
   ~GrpcRemoteWorker() override {}
@@ -81,13 +91,15 @@ class GrpcRemoteWorker : public WorkerInterface {
 
   void RunGraphAsync(CallOptions* call_opts, const RunGraphRequest* request,
                      RunGraphResponse* response, StatusCallback done) override {
-    IssueRequest(request, response, rungraph_, std::move(done), call_opts);
+    IssueRequest(data_channel_.get(), request, response, rungraph_,
+                 std::move(done), call_opts);
   }
   void RunGraphAsync(CallOptions* call_opts, RunGraphRequestWrapper* request,
                      MutableRunGraphResponseWrapper* response,
                      StatusCallback done) override {
-    IssueRequest(&request->ToProto(), get_proto_from_wrapper(response),
-                 rungraph_, std::move(done), call_opts);
+    IssueRequest(data_channel_.get(), &request->ToProto(),
+                 get_proto_from_wrapper(response), rungraph_, std::move(done),
+                 call_opts);
   }
 
   void CleanupGraphAsync(const CleanupGraphRequest* request,
@@ -172,8 +184,8 @@ class GrpcRemoteWorker : public WorkerInterface {
       cb_to_use = &wrapper_done;
     }
 
-    IssueRequest(req_copy ? req_copy : request, response, recvtensor_,
-                 *cb_to_use, call_opts);
+    IssueRequest(data_channel_.get(), req_copy ? req_copy : request, response,
+                 recvtensor_, *cb_to_use, call_opts);
   }
 
   void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
@@ -186,6 +198,26 @@ class GrpcRemoteWorker : public WorkerInterface {
     IssueRequest(request, response, tracing_, done);
   }
 
+  void RecvTensorBatchAsync(CallOptions* call_opts,
+                            const RecvTensorBatchRequest* request,
+                            RecvTensorBatchResponse* response,
+                            StatusCallback done) override {
+    // Don't propagate dma_ok over gRPC.
+    if (request->dma_ok()) {
+      RecvTensorBatchRequest* req_copy = new RecvTensorBatchRequest(*request);
+      req_copy->set_dma_ok(false);
+      IssueRequest(data_channel_.get(), req_copy, response, recvtensorbatch_,
+                   [req_copy, done](const Status& s) {
+                     delete req_copy;
+                     done(s);
+                   },
+                   call_opts);
+      return;
+    }
+    IssueRequest(data_channel_.get(), request, response, recvtensorbatch_,
+                 std::move(done), call_opts);
+  }
+
  private:
   // Object allocated per active RPC.
   template <class RequestMessage, class ResponseMessage>
@@ -234,24 +266,38 @@ class GrpcRemoteWorker : public WorkerInterface {
     }
   };
 
-  // Utility method for issuing a generic asynchronous request. The
-  // given callback, `done`, will be called when the RPC completes.
+  // Utility method for issuing a generic asynchronous request on
+  // `channel`, which must be the channel of `method`. The given
+  // callback, `done`, will be called when the RPC completes.
   template <class RequestMessage, class ResponseMessage>
-  void IssueRequest(const RequestMessage* request, ResponseMessage* response,
+  void IssueRequest(::grpc::ChannelInterface* channel,
+                    const RequestMessage* request, ResponseMessage* response,
                     const ::grpc::RpcMethod& method, StatusCallback done,
                     CallOptions* call_opts = nullptr) {
     auto state = new RPCState<RequestMessage, ResponseMessage>(
-        channel_.get(), cq_, method, *request, std::move(done), call_opts);
+        channel, cq_, method, *request, std::move(done), call_opts);
     state->StartRPC(response);
   }
 
+  // As above, for a request on the control channel.
+  template <class RequestMessage, class ResponseMessage>
+  void IssueRequest(const RequestMessage* request, ResponseMessage* response,
+                    const ::grpc::RpcMethod& method, StatusCallback done,
+                    CallOptions* call_opts = nullptr) {
+    IssueRequest(control_channel_.get(), request, response, method,
+                 std::move(done), call_opts);
+  }
+
   // Helper function for initializing the RpcMethod objects below.
-  ::grpc::RpcMethod Method(GrpcWorkerMethod id) {
+  ::grpc::RpcMethod Method(GrpcWorkerMethod id,
+                           const SharedGrpcChannelPtr& channel) {
     return ::grpc::RpcMethod(GrpcWorkerMethodName(id),
-                             ::grpc::RpcMethod::NORMAL_RPC, channel_);
+                             ::grpc::RpcMethod::NORMAL_RPC, channel);
   }
 
-  SharedGrpcChannelPtr channel_;
+  // The two are the same channel unless the worker cache separates them.
+  SharedGrpcChannelPtr data_channel_;
+  SharedGrpcChannelPtr control_channel_;
   ::grpc::CompletionQueue* cq_;
 
   const ::grpc::RpcMethod getstatus_;
@@ -264,6 +310,7 @@ class GrpcRemoteWorker : public WorkerInterface {
   const ::grpc::RpcMethod recvtensor_;
   const ::grpc::RpcMethod logging_;
   const ::grpc::RpcMethod tracing_;
+  const ::grpc::RpcMethod recvtensorbatch_;
 
   // Support for logging.
   WorkerCacheLogger* logger_;
@@ -274,7 +321,18 @@ class GrpcRemoteWorker : public WorkerInterface {
 WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
                                      ::grpc::CompletionQueue* completion_queue,
                                      WorkerCacheLogger* logger) {
-  return new GrpcRemoteWorker(std::move(channel), completion_queue, logger);
+  SharedGrpcChannelPtr control_channel = channel;
+  return new GrpcRemoteWorker(std::move(channel), std::move(control_channel),
+                              completion_queue, logger);
+}
+
+WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr data_channel,
+                                     SharedGrpcChannelPtr control_channel,
+                                     ::grpc::CompletionQueue* completion_queue,
+                                     WorkerCacheLogger* logger) {
+  return new GrpcRemoteWorker(std::move(data_channel),
+                              std::move(control_channel), completion_queue,
+                              logger);
 }
 
 }  // namespace tensorflow
@@ -33,6 +33,13 @@ WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr channel,
                                      ::grpc::CompletionQueue* completion_queue,
                                      WorkerCacheLogger* logger);
 
+// As above, with the RunGraph, RecvTensor and RecvTensorBatch calls on
+// "data_channel" and the other calls on "control_channel".
+WorkerInterface* NewGrpcRemoteWorker(SharedGrpcChannelPtr data_channel,
+                                     SharedGrpcChannelPtr control_channel,
+                                     ::grpc::CompletionQueue* completion_queue,
+                                     WorkerCacheLogger* logger);
+
 }  // namespace tensorflow
 
 #endif  // THIRD_PARTY_TENSORFLOW_DISTRIBUTED_RUNTIME_RPC_GRPC_REMOTE_WORKER_H_
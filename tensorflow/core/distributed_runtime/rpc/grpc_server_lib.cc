@@ -62,11 +62,6 @@ class NoReusePortOption : public ::grpc::ServerBuilderOption {
                          plugins) override {}
 };
 
-// static utility function
-RendezvousMgrInterface* NewRpcRendezvousMgr(const WorkerEnv* env) {
-  return new RpcRendezvousMgr(env);
-}
-
 }  // namespace
 
 GrpcServer::GrpcServer(const ServerDef& server_def, Env* env)
@@ -123,9 +118,10 @@ Status GrpcServer::Init(
                                                &master_env_.local_devices));
   worker_env_.local_devices = master_env_.local_devices;
   worker_env_.device_mgr = new DeviceMgr(worker_env_.local_devices);
-  worker_env_.rendezvous_mgr = rendezvous_mgr_func == nullptr
-                                   ? new RpcRendezvousMgr(&worker_env_)
-                                   : rendezvous_mgr_func(&worker_env_);
+  worker_env_.rendezvous_mgr =
+      rendezvous_mgr_func == nullptr
+          ? new RpcRendezvousMgr(&worker_env_, config.rpc_options())
+          : rendezvous_mgr_func(&worker_env_);
   string unused;
   string default_worker_name;
   if (!DeviceNameUtils::SplitDeviceName(master_env_.local_devices[0]->name(),
@@ -278,8 +274,15 @@ Status GrpcServer::WorkerCacheFactory(const WorkerCacheFactoryOptions& options,
   GrpcChannelSpec channel_spec;
   TF_RETURN_IF_ERROR(ParseChannelSpec(options, &channel_spec));
 
+  const RPCOptions& rpc_options =
+      server_def_.default_session_config().rpc_options();
+  const bool use_channel_pool = rpc_options.num_channels_per_target() > 1 ||
+                                rpc_options.separate_control_channel();
   std::unique_ptr<GrpcChannelCache> channel_cache(
-      NewGrpcChannelCache(channel_spec, GetChannelCreationFunction()));
+      use_channel_pool
+          ? NewGrpcChannelPoolCache(channel_spec,
+                                    GetChannelPoolCreationFunction())
+          : NewGrpcChannelCache(channel_spec, GetChannelCreationFunction()));
 
   string name_prefix = strings::StrCat("/job:", *options.job_name, "/replica:0",
                                        "/task:", options.task_index);
@@ -298,7 +301,7 @@ Status GrpcServer::WorkerCacheFactory(const WorkerCacheFactoryOptions& options,
   }
 
   *worker_cache = NewGrpcWorkerCacheWithLocalWorker(
-      channel_cache.release(), worker_impl_.get(), name_prefix);
+      channel_cache.release(), worker_impl_.get(), name_prefix, rpc_options);
   return Status::OK();
 }
 
@@ -375,6 +378,10 @@ ChannelCreationFunction GrpcServer::GetChannelCreationFunction() const {
   return ConvertToChannelCreationFunction(NewHostPortGrpcChannel);
 }
 
+ChannelPoolCreationFunction GrpcServer::GetChannelPoolCreationFunction() const {
+  return ConvertToChannelPoolCreationFunction(NewHostPortGrpcPoolChannel);
+}
+
 std::unique_ptr<Master> GrpcServer::CreateMaster(MasterEnv* master_env) {
   return std::unique_ptr<Master>(new Master(master_env, 0.0));
 }
@@ -385,7 +392,9 @@ Status GrpcServer::Create(const ServerDef& server_def, Env* env,
   std::unique_ptr<GrpcServer> ret(
       new GrpcServer(server_def, env == nullptr ? Env::Default() : env));
   ServiceInitFunction service_func = nullptr;
-  TF_RETURN_IF_ERROR(ret->Init(service_func, NewRpcRendezvousMgr));
+  // A null creation function selects an RpcRendezvousMgr configured from
+  // the server's default session config.
+  TF_RETURN_IF_ERROR(ret->Init(service_func, nullptr));
   *out_server = std::move(ret);
   return Status::OK();
 }
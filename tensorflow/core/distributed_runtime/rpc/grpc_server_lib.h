@@ -75,6 +75,11 @@ class GrpcServer : public ServerInterface {
 
   virtual ChannelCreationFunction GetChannelCreationFunction() const;
 
+  // Used instead of GetChannelCreationFunction() when the RPCOptions of
+  // the server ask for more than one connection to each remote worker.  A
+  // subclass that overrides one of the two should override the other.
+  virtual ChannelPoolCreationFunction GetChannelPoolCreationFunction() const;
+
   virtual std::unique_ptr<Master> CreateMaster(MasterEnv* master_env);
 
   // Creates a WorkerCacheInterface for a session.
@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_worker_cache.h"
 
+#include <algorithm>
+#include <unordered_map>
+
 #include "tensorflow/core/distributed_runtime/rpc/grpc_channel.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_client_cq_tag.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_remote_worker.h"
@@ -22,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/worker_cache_partial.h"
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 
@@ -31,10 +35,13 @@ class GrpcWorkerCache : public WorkerCachePartial {
  public:
   explicit GrpcWorkerCache(GrpcChannelCache* channel_cache,
                            WorkerInterface* local_worker,
-                           const string& local_target)
+                           const string& local_target,
+                           const RPCOptions& options)
       : local_target_(local_target),
         local_worker_(local_worker),
-        channel_cache_(channel_cache) {
+        channel_cache_(channel_cache),
+        num_data_channels_(std::max(1, options.num_channels_per_target())),
+        separate_control_channel_(options.separate_control_channel()) {
     // TODO(mrry): Investigate possible performance improvements by
     // replacing this thread with a threadpool.
     polling_thread_ = Env::Default()->StartThread(
@@ -63,11 +70,23 @@ class GrpcWorkerCache : public WorkerCachePartial {
     if (target == local_target_) {
       return local_worker_;
     } else {
-      SharedGrpcChannelPtr channel = channel_cache_->FindWorkerChannel(target);
-      if (!channel) return nullptr;
-      WorkerInterface* ret =
-          NewGrpcRemoteWorker(channel, &completion_queue_, &logger_);
-      return ret;
+      SharedGrpcChannelPtr control_channel =
+          channel_cache_->FindWorkerChannel(target);
+      if (!control_channel) return nullptr;
+      if (num_data_channels_ == 1 && !separate_control_channel_) {
+        return NewGrpcRemoteWorker(control_channel, &completion_queue_,
+                                   &logger_);
+      }
+      // The rendezvous creates a worker for each of its calls, so handing
+      // out the data channels in turn spreads the calls over them.  The
+      // control channel, if separate, is channel 0.
+      const int index = NextDataChannel(target) +
+                        (separate_control_channel_ ? 1 : 0);
+      SharedGrpcChannelPtr data_channel =
+          channel_cache_->FindWorkerPoolChannel(target, index);
+      if (!data_channel) return nullptr;
+      return NewGrpcRemoteWorker(data_channel, control_channel,
+                                 &completion_queue_, &logger_);
     }
   }
 
@@ -89,9 +108,21 @@ class GrpcWorkerCache : public WorkerCachePartial {
   }
 
  private:
+  int NextDataChannel(const string& target) {
+    mutex_lock l(mu_);
+    int& next = next_data_channel_[target];
+    const int index = next;
+    next = (next + 1) % num_data_channels_;
+    return index;
+  }
+
   const string local_target_;
   WorkerInterface* const local_worker_;  // Not owned.
   GrpcChannelCache* channel_cache_;  // Owned.
+  const int num_data_channels_;
+  const bool separate_control_channel_;
+  mutex mu_;
+  std::unordered_map<string, int> next_data_channel_ GUARDED_BY(mu_);
   ::grpc::CompletionQueue completion_queue_;
   Thread* polling_thread_;  // Owned.
   WorkerCacheLogger logger_;
@@ -100,13 +131,19 @@ class GrpcWorkerCache : public WorkerCachePartial {
 }  // namespace
 
 WorkerCacheInterface* NewGrpcWorkerCache(GrpcChannelCache* cc) {
-  return new GrpcWorkerCache(cc, nullptr, "");
+  return new GrpcWorkerCache(cc, nullptr, "", RPCOptions());
 }
 
 WorkerCacheInterface* NewGrpcWorkerCacheWithLocalWorker(
     GrpcChannelCache* cc, WorkerInterface* local_worker,
     const string& local_target) {
-  return new GrpcWorkerCache(cc, local_worker, local_target);
+  return new GrpcWorkerCache(cc, local_worker, local_target, RPCOptions());
+}
+
+WorkerCacheInterface* NewGrpcWorkerCacheWithLocalWorker(
+    GrpcChannelCache* cc, WorkerInterface* local_worker,
+    const string& local_target, const RPCOptions& options) {
+  return new GrpcWorkerCache(cc, local_worker, local_target, options);
 }
 
 }  // namespace tensorflow
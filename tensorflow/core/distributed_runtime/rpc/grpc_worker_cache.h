@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/grpc_channel.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 
 namespace tensorflow {
 
@@ -28,5 +29,14 @@ WorkerCacheInterface* NewGrpcWorkerCacheWithLocalWorker(
     GrpcChannelCache* cc, WorkerInterface* local_worker,
     const string& local_target);
 
+// As above, with the connections to the remote workers configured by
+// "options".  If options.num_channels_per_target() is more than one or
+// options.separate_control_channel() is set, "cc" should come from
+// NewGrpcChannelPoolCache() so that its channels of different indices
+// have connections of their own.
+WorkerCacheInterface* NewGrpcWorkerCacheWithLocalWorker(
+    GrpcChannelCache* cc, WorkerInterface* local_worker,
+    const string& local_target, const RPCOptions& options);
+
 }  // namespace tensorflow
 #endif  // THIRD_PARTY_TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_RPC_GRPC_WORKER_CACHE_H_
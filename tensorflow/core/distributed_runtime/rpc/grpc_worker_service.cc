@@ -31,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/distributed_runtime/graph_mgr.h"
 #include "tensorflow/core/distributed_runtime/rendezvous_mgr_interface.h"
+#include "tensorflow/core/distributed_runtime/tensor_compression.h"
 #include "tensorflow/core/distributed_runtime/rpc/async_service_interface.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_call.h"
 #include "tensorflow/core/distributed_runtime/rpc/grpc_tensor_coding.h"
@@ -42,14 +43,58 @@ limitations under the License.
 #include "tensorflow/core/framework/cancellation.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/tracing.h"
 #include "tensorflow/core/protobuf/worker.pb.h"
+#include "tensorflow/core/util/device_name_utils.h"
 
 namespace tensorflow {
 
 namespace {
 
+// Metrics of the RecvTensor calls served, by the task of the requesting
+// device.
+const std::vector<double> kRecvTensorUsecsBuckets = {
+    10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000,
+    100000, 200000, 500000, 1000000, 2000000, 5000000, 10000000};
+
+auto* recv_tensor_wait_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/rpc_recv_tensor_server_wait_usecs",
+     "The time served RecvTensor calls waited for the tensor to be produced, "
+     "in microseconds.",
+     "peer_task"},
+    kRecvTensorUsecsBuckets);
+
+auto* recv_tensor_copy_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/rpc_recv_tensor_server_copy_usecs",
+     "The time served RecvTensor calls spent copying the tensor from its "
+     "device to the host, in microseconds.",
+     "peer_task"},
+    kRecvTensorUsecsBuckets);
+
+auto* recv_tensor_encode_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/rpc_recv_tensor_server_encode_usecs",
+     "The time served RecvTensor calls spent compressing and serializing "
+     "the tensor, in microseconds.",
+     "peer_task"},
+    kRecvTensorUsecsBuckets);
+
+auto* recv_tensor_bytes = monitoring::Counter<1>::New(
+    "/tensorflow/core/rpc_recv_tensor_server_bytes",
+    "The number of bytes of the responses to RecvTensor calls.", "peer_task");
+
+// The task of "device", which labels the metrics above.
+string PeerTask(StringPiece device) {
+  string task;
+  string unused_device;
+  if (!DeviceNameUtils::SplitDeviceName(device, &task, &unused_device)) {
+    return "unknown";
+  }
+  return task;
+}
+
 class GrpcWorkerService : public AsyncServiceInterface {
  public:
   GrpcWorkerService(GrpcWorker* worker, ::grpc::ServerBuilder* builder)
@@ -130,6 +175,10 @@ class GrpcWorkerService : public AsyncServiceInterface {
       ENQUEUE_REQUEST(CleanupGraph, false);
     }
 
+    for (int i = 0; i < 100; ++i) {
+      ENQUEUE_REQUEST(RecvTensorBatch, true);
+    }
+
     ENQUEUE_REQUEST(Logging, false);
     ENQUEUE_REQUEST(Tracing, false);
 
@@ -255,6 +304,21 @@ class GrpcWorkerService : public AsyncServiceInterface {
     EnqueueRecvTensorRequestRaw();
   }
 
+  void RecvTensorBatchHandler(
+      WorkerCall<RecvTensorBatchRequest, RecvTensorBatchResponse>* call) {
+    Schedule([this, call]() {
+      CallOptions* call_opts = new CallOptions;
+      call->SetCancelCallback([call_opts]() { call_opts->StartCancel(); });
+      worker_->RecvTensorBatchAsync(call_opts, &call->request, &call->response,
+                                    [call, call_opts](const Status& s) {
+                                      call->ClearCancelCallback();
+                                      delete call_opts;
+                                      call->SendResponse(ToGrpcStatus(s));
+                                    });
+    });
+    ENQUEUE_REQUEST(RecvTensorBatch, true);
+  }
+
   void CleanupGraphHandler(
       WorkerCall<CleanupGraphRequest, CleanupGraphResponse>* call) {
     Schedule([this, call]() {
@@ -297,6 +361,24 @@ class GrpcWorkerService : public AsyncServiceInterface {
   TF_DISALLOW_COPY_AND_ASSIGN(GrpcWorkerService);
 };
 
+// Replaces the tensor of "response", copied from a GPU, with its encoding
+// with "compression" when that applies.
+void CompressResponse(RPCOptions::TensorCompression compression,
+                      int64 min_bytes, RecvTensorResponse* response) {
+  const TensorProto& proto = response->tensor();
+  if (compression == RPCOptions::NO_COMPRESSION || response->is_dead() ||
+      !TensorShape::IsValid(proto.tensor_shape())) {
+    return;
+  }
+  if (CompressTensorContent(proto.dtype(), TensorShape(proto.tensor_shape()),
+                            proto.tensor_content(), compression, min_bytes,
+                            response->mutable_compressed_tensor())) {
+    response->clear_tensor();
+  } else {
+    response->clear_compressed_tensor();
+  }
+}
+
 }  // namespace
 
 GrpcWorker::GrpcWorker(WorkerEnv* worker_env) : Worker(worker_env) {}
@@ -310,6 +392,8 @@ void GrpcWorker::RecvTensorAsync(CallOptions* opts,
                                  StatusCallback done) {
   const int64 step_id = request->step_id();
   const string& key = request->rendezvous_key();
+  const RPCOptions::TensorCompression compression = request->compression();
+  const int64 compression_min_bytes = request->compression_min_bytes();
   TRACEPRINTF("RecvTensor: %lld %s", step_id, key.c_str());
   Rendezvous::ParsedKey parsed;
   Status s = Rendezvous::ParseKey(key, &parsed);
@@ -327,14 +411,20 @@ void GrpcWorker::RecvTensorAsync(CallOptions* opts,
   // of execution of the callback lambda body below, an RPC
   // cancellation should abort the rendezvous.
   opts->SetCancelCallback([this, step_id]() { AbortStep(step_id); });
+  const int64 start_micros = Env::Default()->NowMicros();
+  const string peer_task = PeerTask(parsed.dst_device);
   env_->rendezvous_mgr->RecvLocalAsync(
       step_id, parsed,
-      [opts, response, done, src_dev](const Status& status,
-                                      const Rendezvous::Args& send_args,
-                                      const Rendezvous::Args& recv_args,
-                                      const Tensor& val, const bool is_dead) {
+      [opts, response, done, src_dev, compression, compression_min_bytes,
+       start_micros, peer_task](const Status& status,
+                                const Rendezvous::Args& send_args,
+                                const Rendezvous::Args& recv_args,
+                                const Tensor& val, const bool is_dead) {
         opts->ClearCancelCallback();
         if (status.ok()) {
+          const int64 ready_micros = Env::Default()->NowMicros();
+          recv_tensor_wait_usecs->GetCell(peer_task)->Add(ready_micros -
+                                                          start_micros);
           // DMA can only be used for Tensors that do not fall into
           // the following three odd edge cases: 1) a zero-size
           // buffer, 2) a dead tensor which has an uninit value, and
@@ -353,12 +443,25 @@ void GrpcWorker::RecvTensorAsync(CallOptions* opts,
                   << "send dev name: " << src_dev->name()
                   << " gpu_info: " << src_dev->tensorflow_gpu_device_info();
               // "val" is on a GPU. Uses GPUUtil to fill the response proto.
-              StatusCallback response_ready = [response, done,
-                                               tmp](const Status& s) {
+              StatusCallback response_ready = [response, done, tmp,
+                                               compression,
+                                               compression_min_bytes,
+                                               ready_micros, peer_task](
+                                                  const Status& s) {
                 // The value is now ready to be returned on the wire.
+                const int64 copied_micros = Env::Default()->NowMicros();
+                recv_tensor_copy_usecs->GetCell(peer_task)->Add(
+                    copied_micros - ready_micros);
+                if (s.ok()) {
+                  CompressResponse(compression, compression_min_bytes, tmp);
+                }
                 tmp->set_send_start_micros(Env::Default()->NowMicros());
 
                 grpc::EncodeRecvTensorResponseToByteBuffer(*tmp, response);
+                recv_tensor_encode_usecs->GetCell(peer_task)->Add(
+                    Env::Default()->NowMicros() - copied_micros);
+                recv_tensor_bytes->GetCell(peer_task)->IncrementBy(
+                    response->Length());
                 done(s);
                 delete tmp;
               };
@@ -377,7 +480,20 @@ void GrpcWorker::RecvTensorAsync(CallOptions* opts,
               done(errors::Internal("No GPU device in process"));
 #endif  // GOOGLE_CUDA
             } else {
-              grpc::EncodeTensorToByteBuffer(is_dead, val, response);
+              RecvTensorResponse compressed;
+              if (!is_dead &&
+                  CompressTensor(val, compression, compression_min_bytes,
+                                 compressed.mutable_compressed_tensor())) {
+                compressed.set_send_start_micros(Env::Default()->NowMicros());
+                grpc::EncodeRecvTensorResponseToByteBuffer(compressed,
+                                                           response);
+              } else {
+                grpc::EncodeTensorToByteBuffer(is_dead, val, response);
+              }
+              recv_tensor_encode_usecs->GetCell(peer_task)->Add(
+                  Env::Default()->NowMicros() - ready_micros);
+              recv_tensor_bytes->GetCell(peer_task)->IncrementBy(
+                  response->Length());
               done(Status::OK());
             }
           }
@@ -388,6 +504,117 @@ void GrpcWorker::RecvTensorAsync(CallOptions* opts,
       });
 }
 
+// RecvTensorBatchAsync: the response carries one RecvTensorResponse per
+// requested key.  Tensors are encoded as protos, which is cheap for the
+// small tensors that are worth batching.  Only the tensors that have already
+// been produced are returned: waiting for the others could deadlock the step
+// if they depend on the receipt of tensors of the same batch, so they are
+// listed as unsent and the caller receives them one by one.
+void GrpcWorker::RecvTensorBatchAsync(CallOptions* opts,
+                                      const RecvTensorBatchRequest* request,
+                                      RecvTensorBatchResponse* response,
+                                      StatusCallback done) {
+  const int64 step_id = request->step_id();
+  const int num_keys = request->rendezvous_key_size();
+  const RPCOptions::TensorCompression compression = request->compression();
+  const int64 compression_min_bytes = request->compression_min_bytes();
+  TRACEPRINTF("RecvTensorBatch: %lld %d", step_id, num_keys);
+  std::vector<Rendezvous::ParsedKey> parsed(num_keys);
+  std::vector<Device*> src_devs(num_keys, nullptr);
+  for (int i = 0; i < num_keys; ++i) {
+    Status s = Rendezvous::ParseKey(request->rendezvous_key(i), &parsed[i]);
+    if (s.ok()) {
+      s = PrepareRecvTensor(parsed[i], &src_devs[i]);
+    }
+    if (!s.ok()) {
+      done(s);
+      return;
+    }
+  }
+  response->mutable_response()->Reserve(num_keys);
+  for (int i = 0; i < num_keys; ++i) {
+    response->add_response();
+  }
+  if (num_keys == 0) {
+    done(Status::OK());
+    return;
+  }
+
+  // Calls "done" once every tensor has been filled in, with the first
+  // error encountered.
+  struct BatchState {
+    mutex mu;
+    int pending GUARDED_BY(mu);
+    Status status GUARDED_BY(mu);
+  };
+  BatchState* state = new BatchState;
+  state->pending = num_keys;
+  auto tensor_done = [state, done](const Status& s) {
+    Status status;
+    {
+      mutex_lock l(state->mu);
+      state->status.Update(s);
+      if (--state->pending > 0) return;
+      status = state->status;
+    }
+    delete state;
+    done(status);
+  };
+
+  for (int i = 0; i < num_keys; ++i) {
+    RecvTensorResponse* out = response->mutable_response(i);
+    Device* src_dev = src_devs[i];
+    const bool sent = env_->rendezvous_mgr->RecvLocalAsyncIfSent(
+        step_id, parsed[i],
+        [out, src_dev, tensor_done, compression, compression_min_bytes](
+            const Status& status, const Rendezvous::Args& send_args,
+            const Rendezvous::Args& recv_args, const Tensor& val,
+            const bool is_dead) {
+          if (!status.ok()) {
+            tensor_done(status);
+            return;
+          }
+          out->set_is_dead(is_dead);
+          const bool on_host = send_args.alloc_attrs.on_host();
+          if (src_dev->tensorflow_gpu_device_info() && (!on_host)) {
+#if GOOGLE_CUDA
+            const DeviceContext* send_dev_context = send_args.device_context;
+            CHECK(send_dev_context)
+                << "send dev name: " << src_dev->name()
+                << " gpu_info: " << src_dev->tensorflow_gpu_device_info();
+            GPUUtil::SetProtoFromGPU(
+                val, src_dev, send_dev_context, out->mutable_tensor(), is_dead,
+                [out, tensor_done, compression,
+                 compression_min_bytes](const Status& s) {
+                  if (s.ok()) {
+                    CompressResponse(compression, compression_min_bytes, out);
+                  }
+                  out->set_send_start_micros(Env::Default()->NowMicros());
+                  tensor_done(s);
+                });
+#else
+            tensor_done(errors::Internal("No GPU device in process"));
+#endif  // GOOGLE_CUDA
+          } else {
+            if (is_dead ||
+                !CompressTensor(val, compression, compression_min_bytes,
+                                out->mutable_compressed_tensor())) {
+              out->clear_compressed_tensor();
+              val.AsProtoTensorContent(out->mutable_tensor());
+            }
+            out->set_send_start_micros(Env::Default()->NowMicros());
+            tensor_done(Status::OK());
+          }
+        });
+    if (!sent) {
+      // "done" runs once every key is accounted for, so the response is not
+      // sent before this.
+      response->add_unsent_index(i);
+      tensor_done(Status::OK());
+    }
+  }
+}
+
 WorkerEnv* GrpcWorker::env() { return env_; }
 
 std::unique_ptr<GrpcWorker> NewGrpcWorker(WorkerEnv* env) {
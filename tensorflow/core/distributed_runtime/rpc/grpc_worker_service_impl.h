@@ -118,9 +118,10 @@ enum class GrpcWorkerMethod {
   kRecvTensor,
   kLogging,
   kTracing,
+  kRecvTensorBatch,
 };
 static const int kGrpcNumWorkerMethods =
-    static_cast<int>(GrpcWorkerMethod::kTracing) + 1;
+    static_cast<int>(GrpcWorkerMethod::kRecvTensorBatch) + 1;
 
 const char* GrpcWorkerMethodName(GrpcWorkerMethod id);
 
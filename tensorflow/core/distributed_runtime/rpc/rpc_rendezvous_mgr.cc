@@ -15,19 +15,26 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <atomic>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "tensorflow/core/common_runtime/device.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/dma_helper.h"
 #include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 #include "tensorflow/core/distributed_runtime/worker_cache.h"
 #include "tensorflow/core/distributed_runtime/worker_interface.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
@@ -36,10 +43,53 @@ namespace tensorflow {
 
 namespace {
 
+// Metrics of the RecvTensor and RecvTensorBatch calls issued, by the task
+// they are sent to.
+auto* recv_tensor_latency_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/rpc_recv_tensor_latency_usecs",
+     "The time from issuing a RecvTensor or RecvTensorBatch call to its "
+     "response, in microseconds.",
+     "peer_task"},
+    {10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000,
+     200000, 500000, 1000000, 2000000, 5000000, 10000000});
+
+auto* recv_tensor_bytes = monitoring::Counter<1>::New(
+    "/tensorflow/core/rpc_recv_tensor_bytes",
+    "The number of bytes of the tensors received by RecvTensor and "
+    "RecvTensorBatch calls.",
+    "peer_task");
+
+// A receive waiting to be sent to a remote worker as part of a
+// RecvTensorBatch call.
+struct PendingRecv {
+  string key;
+  Device* dst_device;
+  Rendezvous::Args recv_args;
+  Rendezvous::DoneCallback done;
+};
+
 class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  public:
-  RpcRemoteRendezvous(const WorkerEnv* env, int64 step_id)
-      : BaseRemoteRendezvous(env, step_id, false) {}
+  RpcRemoteRendezvous(const WorkerEnv* env, int64 step_id,
+                      const RPCOptions& options)
+      : BaseRemoteRendezvous(env, step_id, false),
+        recv_batch_window_us_(options.recv_tensor_batch_window_us()),
+        compression_(options.recv_tensor_compression()),
+        compression_min_bytes_(options.recv_tensor_compression_min_bytes()) {}
+
+  // Also fails the receives waiting to be batched right away, rather than
+  // when their batch would have been flushed.
+  void StartAbort(const Status& status) override;
+
+  void SetStepStatsCollector(StepStatsCollector* collector) override {
+    mutex_lock l(stats_mu_);
+    stats_collector_ = collector;
+  }
+
+  // Records the compression of the tensor of "response", received for
+  // "key" into "dst_device" since "start_micros", in the step stats.
+  void RecordCompression(Device* dst_device, const string& key,
+                         const TensorResponse& response, int64 start_micros);
 
  protected:
   void RecvFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
@@ -49,6 +99,33 @@ class RpcRemoteRendezvous : public BaseRemoteRendezvous {
  private:
   ~RpcRemoteRendezvous() override {}
 
+  // Receives one tensor with a RecvTensor call.
+  void RecvTensorFromRemoteAsync(const Rendezvous::ParsedKey& parsed,
+                                 const Rendezvous::Args& recv_args,
+                                 DoneCallback done);
+
+  // Adds "recv" to the batch for "src_worker", which is flushed
+  // recv_batch_window_us_ after its first receive was added.
+  void AddToBatch(const string& src_worker, PendingRecv recv);
+  void FlushBatch(const string& src_worker);
+
+  const int64 recv_batch_window_us_;
+  const RPCOptions::TensorCompression compression_;
+  const int64 compression_min_bytes_;
+
+  mutex stats_mu_;
+  StepStatsCollector* stats_collector_ GUARDED_BY(stats_mu_) = nullptr;
+
+  // Set when a remote worker does not implement RecvTensorBatch, after
+  // which the receives of this step are issued one by one.
+  std::atomic<bool> batching_unsupported_{false};
+
+  mutex batch_mu_;
+  // Set by StartAbort(), after which receives are no longer batched.
+  Status batch_status_ GUARDED_BY(batch_mu_);
+  std::unordered_map<string, std::vector<PendingRecv>> pending_batches_
+      GUARDED_BY(batch_mu_);
+
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRemoteRendezvous);
 };
 
@@ -202,10 +279,254 @@ static RpcRecvTensorFreeList* get_call_freelist() {
   return call_freelist;
 }
 
+// Used to retrieve several tensors from the same remote process with one
+// RecvTensorBatch call.
+class RpcRecvTensorBatchCall : public BaseRecvTensorCall {
+ public:
+  RpcRecvTensorBatchCall(WorkerInterface* wi, const string& src_worker,
+                         int64 step_id, std::vector<PendingRecv> recvs,
+                         RPCOptions::TensorCompression compression,
+                         int64 compression_min_bytes)
+      : wi_(wi), src_worker_(src_worker), recvs_(std::move(recvs)) {
+    req_.set_step_id(step_id);
+    for (const PendingRecv& recv : recvs_) {
+      req_.add_rendezvous_key(recv.key);
+    }
+    req_.set_compression(compression);
+    req_.set_compression_min_bytes(compression_min_bytes);
+  }
+
+  void Start(std::function<void()> recv_done) override {
+    start_micros_ = Env::Default()->NowMicros();
+    // Don't issue the call if the rendezvous was aborted while the
+    // receives were waiting to be flushed.
+    if (!status().ok()) {
+      recv_done();
+      return;
+    }
+    wi_->RecvTensorBatchAsync(&opts_, &req_, &resp_,
+                              [this, recv_done](const Status& s) {
+                                if (!s.ok()) {
+                                  mutex_lock l(mu_);
+                                  status_.Update(s);
+                                }
+                                recv_done();
+                              });
+  }
+
+  void StartAbort(const Status& s) override {
+    {
+      mutex_lock l(mu_);
+      status_.Update(s);
+    }
+    opts_.StartCancel();
+  }
+
+  Status status() const override {
+    mutex_lock l(mu_);
+    return status_;
+  }
+
+  // Decodes the received tensors and runs the done callback of every
+  // receive with them, or with "s" if it is an error.  The receives of the
+  // tensors the remote worker had not produced yet are moved to *unsent
+  // instead.
+  void RunCallbacks(Status s, RpcRemoteRendezvous* rendezvous,
+                    std::vector<PendingRecv>* unsent) {
+    const int num_recvs = recvs_.size();
+    if (s.ok() && resp_.response_size() != num_recvs) {
+      s = errors::Internal("RecvTensorBatch returned ", resp_.response_size(),
+                           " tensors for ", num_recvs, " keys");
+    }
+    std::vector<bool> is_unsent(num_recvs, false);
+    for (int index : resp_.unsent_index()) {
+      if (!s.ok()) break;
+      if (index < 0 || index >= num_recvs) {
+        s = errors::Internal("RecvTensorBatch returned unsent index ", index,
+                             " for ", num_recvs, " keys");
+        break;
+      }
+      is_unsent[index] = true;
+    }
+    if (s.ok()) {
+      recv_tensor_latency_usecs->GetCell(src_worker_)
+          ->Add(Env::Default()->NowMicros() - start_micros_);
+    }
+    monitoring::CounterCell* bytes_cell =
+        recv_tensor_bytes->GetCell(src_worker_);
+    for (int i = 0; i < num_recvs; ++i) {
+      PendingRecv& recv = recvs_[i];
+      if (!s.ok()) {
+        recv.done(s, Rendezvous::Args(), recv.recv_args, Tensor{}, false);
+        continue;
+      }
+      if (is_unsent[i]) {
+        unsent->push_back(std::move(recv));
+        continue;
+      }
+      TensorResponse tensor_resp;
+      tensor_resp.InitAlloc(recv.dst_device, recv.recv_args.alloc_attrs);
+      Status decode_status = tensor_resp.InitFrom(resp_.mutable_response(i));
+      if (decode_status.ok()) {
+        bytes_cell->IncrementBy(tensor_resp.tensor().TotalBytes());
+        rendezvous->RecordCompression(recv.dst_device, recv.key, tensor_resp,
+                                      start_micros_);
+      }
+      recv.done(decode_status, Rendezvous::Args(), recv.recv_args,
+                tensor_resp.tensor(), tensor_resp.metadata().is_dead());
+    }
+  }
+
+  WorkerInterface* wi() const { return wi_; }
+  const string& src_worker() const { return src_worker_; }
+  std::vector<PendingRecv>* recvs() { return &recvs_; }
+
+ private:
+  WorkerInterface* const wi_;
+  const string src_worker_;
+  std::vector<PendingRecv> recvs_;
+  CallOptions opts_;
+  RecvTensorBatchRequest req_;
+  RecvTensorBatchResponse resp_;
+  int64 start_micros_ = 0;
+
+  mutable mutex mu_;
+  Status status_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(RpcRecvTensorBatchCall);
+};
+
 void RpcRemoteRendezvous::RecvFromRemoteAsync(
     const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
     DoneCallback done) {
   CHECK(is_initialized());
+  if (recv_batch_window_us_ <= 0 || batching_unsupported_) {
+    RecvTensorFromRemoteAsync(parsed, recv_args, std::move(done));
+    return;
+  }
+
+  string src_worker;
+  string src_rel_device;
+  Status s;
+  if (!DeviceNameUtils::SplitDeviceName(parsed.src_device, &src_worker,
+                                        &src_rel_device)) {
+    s = errors::Internal(parsed.src_device,
+                         " is invalid remote source device.");
+  }
+  Device* dst_device;
+  if (s.ok()) {
+    s = session()->device_mgr->LookupDevice(parsed.dst_device, &dst_device);
+  }
+  if (!s.ok()) {
+    done(s, Args(), recv_args, Tensor{}, false);
+    return;
+  }
+  AddToBatch(src_worker, {parsed.FullKey().ToString(), dst_device, recv_args,
+                          std::move(done)});
+}
+
+void RpcRemoteRendezvous::StartAbort(const Status& status) {
+  BaseRemoteRendezvous::StartAbort(status);
+  std::unordered_map<string, std::vector<PendingRecv>> batches;
+  {
+    mutex_lock l(batch_mu_);
+    if (batch_status_.ok()) {
+      batch_status_ = status;
+    }
+    batches.swap(pending_batches_);
+  }
+  for (const auto& batch : batches) {
+    for (const PendingRecv& recv : batch.second) {
+      recv.done(status, Args(), recv.recv_args, Tensor{}, false);
+    }
+  }
+}
+
+void RpcRemoteRendezvous::AddToBatch(const string& src_worker,
+                                     PendingRecv recv) {
+  bool first = false;
+  Status s;
+  {
+    mutex_lock l(batch_mu_);
+    s = batch_status_;
+    if (s.ok()) {
+      std::vector<PendingRecv>* batch = &pending_batches_[src_worker];
+      first = batch->empty();
+      batch->push_back(std::move(recv));
+    }
+  }
+  if (!s.ok()) {
+    recv.done(s, Args(), recv.recv_args, Tensor{}, false);
+    return;
+  }
+  if (first) {
+    Ref();
+    env_->env->SchedClosureAfter(recv_batch_window_us_, [this, src_worker]() {
+      FlushBatch(src_worker);
+      Unref();
+    });
+  }
+}
+
+void RpcRemoteRendezvous::FlushBatch(const string& src_worker) {
+  std::vector<PendingRecv> recvs;
+  {
+    mutex_lock l(batch_mu_);
+    auto it = pending_batches_.find(src_worker);
+    if (it == pending_batches_.end()) return;
+    recvs.swap(it->second);
+    pending_batches_.erase(it);
+  }
+
+  WorkerSession* sess = session();
+  WorkerInterface* rwi = sess->worker_cache->CreateWorker(src_worker);
+  if (rwi == nullptr) {
+    Status s = errors::Internal("No worker known as ", src_worker);
+    for (const PendingRecv& recv : recvs) {
+      recv.done(s, Args(), recv.recv_args, Tensor{}, false);
+    }
+    return;
+  }
+
+  RpcRecvTensorBatchCall* call =
+      new RpcRecvTensorBatchCall(rwi, src_worker, step_id_, std::move(recvs),
+                                 compression_, compression_min_bytes_);
+
+  // Record "call" in active_ so that it can be aborted cleanly.
+  RegisterCall(call);
+
+  Ref();
+  call->Start([this, call]() {
+    DeregisterCall(call);
+    session()->worker_cache->ReleaseWorker(call->src_worker(), call->wi());
+    Status s = call->status();
+    std::vector<PendingRecv> unsent;
+    if (errors::IsUnimplemented(s)) {
+      // The remote worker predates RecvTensorBatch.
+      batching_unsupported_ = true;
+      unsent.swap(*call->recvs());
+    } else {
+      call->RunCallbacks(s, this, &unsent);
+    }
+    // The tensors the remote worker had not produced yet are not batched
+    // again, so that each is returned as soon as it is produced.
+    for (PendingRecv& recv : unsent) {
+      Rendezvous::ParsedKey parsed;
+      Status parse_status = Rendezvous::ParseKey(recv.key, &parsed);
+      if (parse_status.ok()) {
+        RecvTensorFromRemoteAsync(parsed, recv.recv_args, std::move(recv.done));
+      } else {
+        recv.done(parse_status, Args(), recv.recv_args, Tensor{}, false);
+      }
+    }
+    delete call;
+    Unref();
+  });
+}
+
+void RpcRemoteRendezvous::RecvTensorFromRemoteAsync(
+    const Rendezvous::ParsedKey& parsed, const Rendezvous::Args& recv_args,
+    DoneCallback done) {
   Status s;
 
   // Prepare a RecvTensor call that can handle being aborted.
@@ -238,18 +559,29 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
 
   call->Init(rwi, step_id_, parsed.FullKey(), recv_args.alloc_attrs, dst_device,
              recv_args, std::move(done));
+  call->req_.set_compression(compression_);
+  call->req_.set_compression_min_bytes(compression_min_bytes_);
 
   // Record "call" in active_ so that it can be aborted cleanly.
   RegisterCall(call);
 
   // Start "call".
   Ref();
-  call->Start([this, call]() {
+  const int64 start_micros = env_->env->NowMicros();
+  call->Start([this, call, start_micros]() {
     // Removes "call" from active_. Prevent StartAbort().
     DeregisterCall(call);
     // If StartAbort was called prior to DeregisterCall, then the
     // current status should be bad.
     Status s = call->status();
+    if (s.ok()) {
+      recv_tensor_latency_usecs->GetCell(call->src_worker_)
+          ->Add(env_->env->NowMicros() - start_micros);
+      recv_tensor_bytes->GetCell(call->src_worker_)
+          ->IncrementBy(call->tensor().TotalBytes());
+      RecordCompression(call->dst_device(), call->req_.rendezvous_key(),
+                        call->resp_, start_micros);
+    }
     call->done()(s, Args(), call->recv_args(), call->tensor(), call->is_dead());
     session()->worker_cache->ReleaseWorker(call->src_worker_, call->wi_);
     call->wi_ = nullptr;
@@ -258,14 +590,42 @@ void RpcRemoteRendezvous::RecvFromRemoteAsync(
   });
 }
 
+void RpcRemoteRendezvous::RecordCompression(Device* dst_device,
+                                            const string& key,
+                                            const TensorResponse& response,
+                                            int64 start_micros) {
+  if (!response.metadata().has_compressed_tensor()) return;
+  mutex_lock l(stats_mu_);
+  if (stats_collector_ == nullptr) return;
+  Rendezvous::ParsedKey parsed;
+  if (!Rendezvous::ParseKey(key, &parsed).ok()) return;
+  const CompressedTensor& compressed = response.metadata().compressed_tensor();
+  const int64 end_micros = env_->env->NowMicros();
+  NodeExecStats* ns = new NodeExecStats;
+  ns->set_node_name(parsed.edge_name.ToString());
+  ns->set_all_start_micros(start_micros);
+  ns->set_op_end_rel_micros(end_micros - start_micros);
+  ns->set_all_end_rel_micros(end_micros - start_micros);
+  ns->set_timeline_label(strings::StrCat(
+      parsed.edge_name, " = RecvTensor(", parsed.src_device, ", ",
+      RPCOptions::TensorCompression_Name(compressed.compression()), ": ",
+      response.tensor().TotalBytes(), " -> ", response.compressed_bytes(),
+      " bytes)"));
+  stats_collector_->Save(dst_device->name(), ns);
+}
+
 }  // namespace
 
 RpcRendezvousMgr::RpcRendezvousMgr(const WorkerEnv* env)
-    : BaseRendezvousMgr(env) {}
+    : RpcRendezvousMgr(env, RPCOptions()) {}
+
+RpcRendezvousMgr::RpcRendezvousMgr(const WorkerEnv* env,
+                                   const RPCOptions& options)
+    : BaseRendezvousMgr(env), options_(options) {}
 
 BaseRemoteRendezvous* RpcRendezvousMgr::Create(int64 step_id,
                                                const WorkerEnv* worker_env) {
-  return new RpcRemoteRendezvous(worker_env, step_id);
+  return new RpcRemoteRendezvous(worker_env, step_id, options_);
 }
 
 }  // end namespace tensorflow
@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/distributed_runtime/base_rendezvous_mgr.h"
 #include "tensorflow/core/distributed_runtime/worker_env.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 
 namespace tensorflow {
 
@@ -46,10 +47,17 @@ class RpcRendezvousMgr : public BaseRendezvousMgr {
  public:
   explicit RpcRendezvousMgr(const WorkerEnv* env);
 
+  // Receives tensors from other workers as configured by "options": see
+  // RPCOptions.recv_tensor_batch_window_us and
+  // RPCOptions.recv_tensor_compression.
+  RpcRendezvousMgr(const WorkerEnv* env, const RPCOptions& options);
+
  protected:
   BaseRemoteRendezvous* Create(int64 step_id, const WorkerEnv* worker_env);
 
  private:
+  const RPCOptions options_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(RpcRendezvousMgr);
 };
 
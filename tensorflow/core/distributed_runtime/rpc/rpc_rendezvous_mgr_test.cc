@@ -15,13 +15,22 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/rpc/rpc_rendezvous_mgr.h"
 
+#include <map>
+#include <set>
+
+#include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/common_runtime/process_util.h"
+#include "tensorflow/core/distributed_runtime/tensor_coding.h"
+#include "tensorflow/core/distributed_runtime/worker_interface.h"
 #include "tensorflow/core/framework/control_flow.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -198,6 +207,301 @@ TEST_F(RpcRendezvousMgrTest, TransferDummyDeviceContext) {
   dc->Unref();
 }
 
+namespace {
+// A remote worker that answers each receive with the name of the requested
+// tensor, once it has been produced.
+class FakeRemoteWorker : public WorkerInterface {
+ public:
+  ~FakeRemoteWorker() override {}
+
+  // The tensor called "name" is not produced until Produce(name) is called.
+  void set_unproduced(const string& name) {
+    mutex_lock l(mu_);
+    unproduced_.insert(name);
+  }
+  // Answers the pending RecvTensor call for "name", if any.
+  void Produce(const string& name) {
+    StatusCallback done;
+    {
+      mutex_lock l(mu_);
+      unproduced_.erase(name);
+      auto it = parked_.find(name);
+      if (it == parked_.end()) return;
+      done = std::move(it->second);
+      parked_.erase(it);
+    }
+    done(Status::OK());
+  }
+
+  void set_supports_batch(bool supports_batch) {
+    supports_batch_ = supports_batch;
+  }
+  int num_recv_calls() const { return num_recv_calls_; }
+  int num_batch_calls() const { return num_batch_calls_; }
+  int num_fp16_requests() const { return num_fp16_requests_; }
+
+  void GetStatusAsync(const GetStatusRequest* request,
+                      GetStatusResponse* response,
+                      StatusCallback done) override {
+    done(errors::Unimplemented("GetStatus"));
+  }
+  void CreateWorkerSessionAsync(const CreateWorkerSessionRequest* request,
+                                CreateWorkerSessionResponse* response,
+                                StatusCallback done) override {
+    done(errors::Unimplemented("CreateWorkerSession"));
+  }
+  void RegisterGraphAsync(const RegisterGraphRequest* request,
+                          RegisterGraphResponse* response,
+                          StatusCallback done) override {
+    done(errors::Unimplemented("RegisterGraph"));
+  }
+  void DeregisterGraphAsync(const DeregisterGraphRequest* request,
+                            DeregisterGraphResponse* response,
+                            StatusCallback done) override {
+    done(errors::Unimplemented("DeregisterGraph"));
+  }
+  void RunGraphAsync(CallOptions* opts, RunGraphRequestWrapper* request,
+                     MutableRunGraphResponseWrapper* response,
+                     StatusCallback done) override {
+    done(errors::Unimplemented("RunGraph"));
+  }
+  void CleanupGraphAsync(const CleanupGraphRequest* request,
+                         CleanupGraphResponse* response,
+                         StatusCallback done) override {
+    done(errors::Unimplemented("CleanupGraph"));
+  }
+  void CleanupAllAsync(const CleanupAllRequest* request,
+                       CleanupAllResponse* response,
+                       StatusCallback done) override {
+    done(errors::Unimplemented("CleanupAll"));
+  }
+  void LoggingAsync(const LoggingRequest* request, LoggingResponse* response,
+                    StatusCallback done) override {
+    done(errors::Unimplemented("Logging"));
+  }
+  void TracingAsync(const TracingRequest* request, TracingResponse* response,
+                    StatusCallback done) override {
+    done(errors::Unimplemented("Tracing"));
+  }
+
+  void RecvTensorAsync(CallOptions* opts, const RecvTensorRequest* request,
+                       TensorResponse* response, StatusCallback done) override {
+    ++num_recv_calls_;
+    if (request->compression() == RPCOptions::FP16) ++num_fp16_requests_;
+    const string key = request->rendezvous_key();
+    StatusCallback fill_done = [key, response, done](const Status& s) {
+      RecvTensorResponse proto;
+      Fill(key, &proto);
+      done(response->InitFrom(&proto));
+    };
+    {
+      mutex_lock l(mu_);
+      const string name = MakeKey(key).edge_name.ToString();
+      if (unproduced_.count(name) > 0) {
+        parked_[name] = std::move(fill_done);
+        return;
+      }
+    }
+    fill_done(Status::OK());
+  }
+
+  void RecvTensorBatchAsync(CallOptions* opts,
+                            const RecvTensorBatchRequest* request,
+                            RecvTensorBatchResponse* response,
+                            StatusCallback done) override {
+    if (!supports_batch_) {
+      WorkerInterface::RecvTensorBatchAsync(opts, request, response, done);
+      return;
+    }
+    ++num_batch_calls_;
+    if (request->compression() == RPCOptions::FP16) ++num_fp16_requests_;
+    {
+      mutex_lock l(mu_);
+      for (int i = 0; i < request->rendezvous_key_size(); ++i) {
+        const string& key = request->rendezvous_key(i);
+        RecvTensorResponse* tensor_response = response->add_response();
+        if (unproduced_.count(MakeKey(key).edge_name.ToString()) > 0) {
+          response->add_unsent_index(i);
+        } else {
+          Fill(key, tensor_response);
+        }
+      }
+    }
+    done(Status::OK());
+  }
+
+ private:
+  static void Fill(const string& key, RecvTensorResponse* response) {
+    V(MakeKey(key).edge_name.ToString())
+        .AsProtoTensorContent(response->mutable_tensor());
+  }
+
+  bool supports_batch_ = true;
+  mutex mu_;
+  std::set<string> unproduced_ GUARDED_BY(mu_);
+  std::map<string, StatusCallback> parked_ GUARDED_BY(mu_);
+  std::atomic<int> num_recv_calls_{0};
+  std::atomic<int> num_batch_calls_{0};
+  std::atomic<int> num_fp16_requests_{0};
+};
+
+class FakeWorkerCache : public WorkerCacheInterface {
+ public:
+  explicit FakeWorkerCache(WorkerInterface* worker) : worker_(worker) {}
+
+  void ListWorkers(std::vector<string>* workers) const override {}
+  WorkerInterface* CreateWorker(const string& target) override {
+    return worker_;
+  }
+  void ReleaseWorker(const string& target, WorkerInterface* worker) override {}
+  bool GetDeviceLocalityNonBlocking(const string& device,
+                                    DeviceLocality* locality) override {
+    return false;
+  }
+  void GetDeviceLocalityAsync(const string& device, DeviceLocality* locality,
+                              StatusCallback done) override {}
+
+ private:
+  WorkerInterface* const worker_;  // Not owned.
+};
+
+class FakeDevice : public Device {
+ public:
+  explicit FakeDevice(const DeviceAttributes& attr) : Device(nullptr, attr) {}
+  Status Sync() override { return Status::OK(); }
+  Allocator* GetAllocator(AllocatorAttributes attr) override {
+    return cpu_allocator();
+  }
+};
+
+std::unique_ptr<DeviceMgr> NewLocalDeviceMgr() {
+  DeviceAttributes attr;
+  attr.set_name("/job:mnist/replica:1/task:2/cpu:0");
+  attr.set_device_type("CPU");
+  return std::unique_ptr<DeviceMgr>(new DeviceMgr({new FakeDevice(attr)}));
+}
+
+RPCOptions BatchOptions() {
+  RPCOptions options;
+  options.set_recv_tensor_batch_window_us(10 * 1000);
+  options.set_recv_tensor_compression(RPCOptions::FP16);
+  return options;
+}
+}  // namespace
+
+class RpcRendezvousBatchTest : public ::testing::Test {
+ protected:
+  RpcRendezvousBatchTest()
+      : worker_session_("/job:mnist/replica:1/task:2",
+                        std::unique_ptr<WorkerCacheInterface>(
+                            new FakeWorkerCache(&remote_)),
+                        NewLocalDeviceMgr(), std::unique_ptr<GraphMgr>()),
+        rmgr_(&env, BatchOptions()) {
+    env.env = Env::Default();
+  }
+
+  // Receives the tensors called "names" from another worker in one step,
+  // calling "on_recv" with the name of each tensor once it is received.
+  std::vector<string> RecvFromRemote(
+      int64 step_id, const std::vector<string>& names,
+      std::function<void(const string&)> on_recv = nullptr) {
+    RemoteRendezvous* rendez = rmgr_.Find(step_id);
+    core::ScopedUnref unref(rendez);
+    TF_CHECK_OK(rendez->Initialize(&worker_session_));
+    std::vector<string> values(names.size());
+    BlockingCounter counter(names.size());
+    for (size_t i = 0; i < names.size(); ++i) {
+      const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
+          "/job:mnist/replica:1/task:1/cpu:0", 7890,
+          "/job:mnist/replica:1/task:2/cpu:0", names[i], FrameAndIter(0, 0)));
+      rendez->RecvAsync(
+          key, Rendezvous::Args(),
+          [&values, &counter, &names, &on_recv, i](
+              const Status& s, const Rendezvous::Args& send_args,
+              const Rendezvous::Args& recv_args, const Tensor& val,
+              bool is_dead) {
+            TF_EXPECT_OK(s);
+            if (s.ok()) values[i] = V(val);
+            if (on_recv) on_recv(names[i]);
+            counter.DecrementCount();
+          });
+    }
+    counter.Wait();
+    rmgr_.Cleanup(step_id);
+    return values;
+  }
+
+  FakeRemoteWorker remote_;
+  WorkerEnv env;
+
+  WorkerSession worker_session_;
+  RpcRendezvousMgr rmgr_;
+};
+
+TEST_F(RpcRendezvousBatchTest, CoalescesReceivesFromOneWorker) {
+  const std::vector<string> names = {"a", "b", "c", "d"};
+  EXPECT_EQ(names, RecvFromRemote(123, names));
+  EXPECT_EQ(1, remote_.num_batch_calls());
+  EXPECT_EQ(0, remote_.num_recv_calls());
+}
+
+TEST_F(RpcRendezvousBatchTest, FallsBackWithoutBatchSupport) {
+  remote_.set_supports_batch(false);
+  const std::vector<string> names = {"a", "b", "c"};
+  EXPECT_EQ(names, RecvFromRemote(123, names));
+  EXPECT_EQ(0, remote_.num_batch_calls());
+  EXPECT_EQ(3, remote_.num_recv_calls());
+}
+
+TEST_F(RpcRendezvousBatchTest, DoesNotWaitForDependentReceives) {
+  // "b" is only produced once "a" has been received, so a batch waiting for
+  // both would never complete.
+  remote_.set_unproduced("b");
+  const std::vector<string> names = {"a", "b"};
+  EXPECT_EQ(names, RecvFromRemote(123, names, [this](const string& name) {
+              if (name == "a") remote_.Produce("b");
+            }));
+  EXPECT_EQ(1, remote_.num_batch_calls());
+  EXPECT_EQ(1, remote_.num_recv_calls());
+}
+
+TEST_F(RpcRendezvousBatchTest, AbortFailsBatchedReceivesRightAway) {
+  const int64 step_id = 123;
+  RemoteRendezvous* rendez = rmgr_.Find(step_id);
+  core::ScopedUnref unref(rendez);
+  TF_ASSERT_OK(rendez->Initialize(&worker_session_));
+  const Rendezvous::ParsedKey key = MakeKey(Rendezvous::CreateKey(
+      "/job:mnist/replica:1/task:1/cpu:0", 7890,
+      "/job:mnist/replica:1/task:2/cpu:0", "a", FrameAndIter(0, 0)));
+  auto recv = [rendez, &key](Notification* n) {
+    rendez->RecvAsync(key, Rendezvous::Args(),
+                      [n](const Status& s, const Rendezvous::Args& send_args,
+                          const Rendezvous::Args& recv_args, const Tensor& val,
+                          bool is_dead) {
+                        EXPECT_TRUE(errors::IsAborted(s)) << s;
+                        n->Notify();
+                      });
+  };
+  Notification queued;
+  recv(&queued);
+  rendez->StartAbort(errors::Aborted("Step aborted"));
+  // Without waiting for the batch window.
+  EXPECT_TRUE(queued.HasBeenNotified());
+  Notification after_abort;
+  recv(&after_abort);
+  EXPECT_TRUE(after_abort.HasBeenNotified());
+  rmgr_.Cleanup(step_id);
+  EXPECT_EQ(0, remote_.num_batch_calls());
+}
+
+TEST_F(RpcRendezvousBatchTest, RequestsCompression) {
+  EXPECT_EQ(std::vector<string>{"a"}, RecvFromRemote(123, {"a"}));
+  EXPECT_EQ(1, remote_.num_fp16_requests());
+  remote_.set_supports_batch(false);
+  EXPECT_EQ(std::vector<string>{"b"}, RecvFromRemote(124, {"b"}));
+  EXPECT_EQ(2, remote_.num_fp16_requests());
+}
+
 // NOTE: Remote Send/Recv is better tested in worker_test.cc
 
 }  // namespace tensorflow
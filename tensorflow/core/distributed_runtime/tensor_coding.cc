@@ -17,6 +17,8 @@ limitations under the License.
 
 #include "google/protobuf/any.pb.h"
 #include "tensorflow/core/common_runtime/device.h"
+#include "tensorflow/core/distributed_runtime/tensor_compression.h"
+#include "tensorflow/core/lib/core/notification.h"
 
 namespace tensorflow {
 
@@ -27,6 +29,7 @@ void TensorResponse::Clear() {
   device_ = nullptr;
   alloc_attrs_ = AllocatorAttributes();
   allocator_ = nullptr;
+  staging_allocator_ = nullptr;
   already_used_ = false;
   ClearTensor();
 }
@@ -34,6 +37,7 @@ void TensorResponse::Clear() {
 void TensorResponse::ClearTensor() {
   meta_.Clear();
   tensor_ = Tensor();
+  compressed_bytes_ = 0;
 }
 
 void TensorResponse::InitAlloc(DeviceBase* d, const AllocatorAttributes& aa) {
@@ -45,11 +49,21 @@ void TensorResponse::InitAlloc(DeviceBase* d, const AllocatorAttributes& aa) {
     on_host_ = true;
   }
   allocator_ = device_->GetAllocator(alloc_attrs_);
+  const DeviceBase::GpuDeviceInfo* gpu_info = d->tensorflow_gpu_device_info();
+  if (!on_host_ && gpu_info != nullptr && gpu_info->default_context != nullptr) {
+    AllocatorAttributes staging_attrs;
+    staging_attrs.set_on_host(true);
+    staging_attrs.set_gpu_compatible(true);
+    staging_allocator_ = device_->GetAllocator(staging_attrs);
+  }
 }
 
 Status TensorResponse::InitFrom(RecvTensorResponse* response) {
   Status s;
   meta_.Swap(response);
+  if (meta_.has_compressed_tensor()) {
+    return DecodeCompressedTensor();
+  }
   if (on_host_) {
     if (!tensor_.FromProto(allocator_, meta_.tensor())) {
       s = errors::InvalidArgument("Cannot parse tensor from response");
@@ -76,6 +90,14 @@ void TensorResponse::InitPartial(const RecvTensorResponse& response) {
 }
 
 Status TensorResponse::ParseFrom(Source* source) {
+  if (!on_host_ && staging_allocator_ != nullptr) {
+    if (already_used_) {
+      ClearTensor();
+    }
+    already_used_ = true;
+    if (ParseFast(source)) return CopyStagedTensorToDevice();
+    meta_.Clear();
+  }
   if (!on_host_) {
     protobuf::io::CodedInputStream input(source->contents());
     input.SetTotalBytesLimit(INT_MAX, INT_MAX);  // Unlimited
@@ -84,6 +106,9 @@ Status TensorResponse::ParseFrom(Source* source) {
     if (!meta_.ParseFromCodedStream(&input) || !input.ConsumedEntireMessage()) {
       return errors::InvalidArgument("Cannot parse tensor from response");
     }
+    if (meta_.has_compressed_tensor()) {
+      return DecodeCompressedTensor();
+    }
     Status s =
         device_->MakeTensorFromProto(meta_.tensor(), alloc_attrs_, &tensor_);
     // Reduce memory usage for big tensors.
@@ -152,7 +177,7 @@ bool TensorResponse::ParseTensorSubmessage(
       if (ok && !seen_tensor_content) {
         // No tensor content: could be because it's a zero-length tensor
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
+        Tensor t(decode_allocator(), tensor_meta->dtype(), shape);
         tensor_ = std::move(t);
       }
       return ok;
@@ -192,7 +217,7 @@ bool TensorResponse::ParseTensorSubmessage(
         if (!ReadVarintSizeAsInt(input, &num_bytes)) return false;
         seen_tensor_content = true;
         TensorShape shape(tensor_meta->tensor_shape());
-        Tensor t(allocator_, tensor_meta->dtype(), shape);
+        Tensor t(decode_allocator(), tensor_meta->dtype(), shape);
         StringPiece buf = t.tensor_data();
         if (static_cast<size_t>(num_bytes) != buf.size()) return false;
         // TODO(jeff,sanjay): Figure out a way to avoid this copy if
@@ -267,10 +292,61 @@ bool TensorResponse::ParseFast(Source* source) {
   return false;
 }
 
+Status TensorResponse::DecodeCompressedTensor() {
+  const CompressedTensor& compressed = meta_.compressed_tensor();
+  if (on_host_) {
+    TF_RETURN_IF_ERROR(DecompressTensor(compressed, allocator_, &tensor_));
+  } else if (staging_allocator_ != nullptr) {
+    TF_RETURN_IF_ERROR(
+        DecompressTensor(compressed, staging_allocator_, &tensor_));
+    TF_RETURN_IF_ERROR(CopyStagedTensorToDevice());
+  } else {
+    Tensor decoded;
+    TF_RETURN_IF_ERROR(DecompressTensor(compressed, cpu_allocator(), &decoded));
+    TensorProto proto;
+    decoded.AsProtoTensorContent(&proto);
+    TF_RETURN_IF_ERROR(
+        device_->MakeTensorFromProto(proto, alloc_attrs_, &tensor_));
+  }
+  // Keep the description of the encoding, without its content.
+  compressed_bytes_ = compressed.content().size();
+  meta_.mutable_compressed_tensor()->clear_content();
+  return Status::OK();
+}
+
+Status TensorResponse::CopyStagedTensorToDevice() {
+  Tensor staged = std::move(tensor_);
+  Tensor copy(allocator_, staged.dtype(), staged.shape());
+  // If the tensor is not initialized, we likely ran out of memory.
+  if (!copy.IsInitialized()) {
+    return errors::ResourceExhausted(
+        "OOM when allocating tensor of shape ", staged.shape().DebugString(),
+        " and type ", DataTypeString(staged.dtype()));
+  }
+  Status status;
+  if (staged.TotalBytes() > 0) {
+    // gpu_device_info is only set on Devices.
+    Notification n;
+    device_->tensorflow_gpu_device_info()
+        ->default_context->CopyCPUTensorToDevice(
+            &staged, static_cast<Device*>(device_), &copy,
+            [&n, &status](const Status& s) {
+              status = s;
+              n.Notify();
+            });
+    n.WaitForNotification();
+  }
+  tensor_ = std::move(copy);
+  return status;
+}
+
 bool TensorResponse::ParseSlow(Source* source) {
   if (!meta_.ParseFromZeroCopyStream(source->contents())) {
     return false;
   }
+  if (meta_.has_compressed_tensor()) {
+    return DecodeCompressedTensor().ok();
+  }
 
   Tensor parsed(meta_.tensor().dtype());
   if (!parsed.FromProto(allocator_, meta_.tensor())) {
@@ -44,6 +44,10 @@ class TensorResponse {
   void ClearTensor();
 
   // Initialize memory allocation related members.
+  //
+  // Contents destined for host memory are decoded straight into buffers
+  // of the allocator for "aa".  For GPU destinations, they are decoded
+  // into pinned host memory and then copied to the device.
   void InitAlloc(DeviceBase* d, const AllocatorAttributes& aa);
 
   // Source provides a way for a particular RPC implementation to provide
@@ -87,19 +91,39 @@ class TensorResponse {
   // modified.
   const RecvTensorResponse& metadata() const { return meta_; }
 
+  // The number of bytes of the encoding of the tensor, if it was
+  // compressed (see metadata().compressed_tensor()), and 0 otherwise.
+  int64 compressed_bytes() const { return compressed_bytes_; }
+
  private:
   bool ParseTensorSubmessage(protobuf::io::CodedInputStream* input,
                              TensorProto* tensor_meta);
   bool ParseFast(Source* source);
   bool ParseSlow(Source* source);
 
+  // Copies tensor_, decoded by ParseFast() into staging memory, to the
+  // device.
+  Status CopyStagedTensorToDevice();
+
+  // Decodes meta_.compressed_tensor() into tensor_.
+  Status DecodeCompressedTensor();
+
+  // The allocator for the buffers ParseFast() decodes into.
+  Allocator* decode_allocator() const {
+    return on_host_ ? allocator_ : staging_allocator_;
+  }
+
   bool on_host_ = false;
   DeviceBase* device_ = nullptr;
   AllocatorAttributes alloc_attrs_;
   Allocator* allocator_ = nullptr;
+  // Pinned host memory for contents destined for a GPU.  nullptr if the
+  // device cannot copy from host memory.
+  Allocator* staging_allocator_ = nullptr;
   bool already_used_ = false;
   Tensor tensor_;
   RecvTensorResponse meta_;
+  int64 compressed_bytes_ = 0;
 };
 
 }  // namespace tensorflow
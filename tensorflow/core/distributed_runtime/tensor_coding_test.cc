@@ -15,9 +15,11 @@ limitations under the License.
 
 #include "tensorflow/core/distributed_runtime/tensor_coding.h"
 
+#include "tensorflow/core/distributed_runtime/tensor_compression.h"
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
@@ -155,6 +157,95 @@ TEST_F(TensorResponseTest, Simple) {
 
 TEST_F(TensorResponseTest, StringTensor) { DoTestForStrings(DT_STRING); }
 
+// Copies to the "device" with memcpy.
+class DummyGpuDeviceContext : public DeviceContext {
+ public:
+  void CopyCPUTensorToDevice(const Tensor* cpu_tensor, Device* device,
+                             Tensor* device_tensor,
+                             StatusCallback done) const override {
+    StringPiece src = cpu_tensor->tensor_data();
+    memcpy(const_cast<char*>(device_tensor->tensor_data().data()), src.data(),
+           src.size());
+    ++num_copies;
+    done(Status::OK());
+  }
+
+  mutable int num_copies = 0;
+};
+
+// Records which allocators are asked for.
+class DummyGpuDevice : public DeviceBase {
+ public:
+  explicit DummyGpuDevice(Env* env)
+      : DeviceBase(env), context_(new DummyGpuDeviceContext) {
+    attr_.set_device_type("GPU");
+    gpu_info_.default_context = context_;
+    set_tensorflow_gpu_device_info(&gpu_info_);
+  }
+  ~DummyGpuDevice() override { context_->Unref(); }
+
+  const DeviceAttributes& attributes() const override { return attr_; }
+
+  Allocator* GetAllocator(AllocatorAttributes attr) override {
+    if (attr.on_host() && attr.gpu_compatible()) ++num_pinned_allocators;
+    return cpu_allocator();
+  }
+
+  DummyGpuDeviceContext* const context_;
+  int num_pinned_allocators = 0;
+
+ private:
+  DeviceAttributes attr_;
+  GpuDeviceInfo gpu_info_;
+};
+
+TEST_F(TensorResponseTest, GpuDestinationIsStagedInPinnedMemory) {
+  Tensor src(DT_FLOAT, TensorShape({2, 3}));
+  test::FillValues<float>(&src, {1, 2, 3, 4, 5, 6});
+  RecvTensorResponse proto;
+  src.AsProtoTensorContent(proto.mutable_tensor());
+  string encoded;
+  proto.AppendToString(&encoded);
+
+  DummyGpuDevice gpu_device(Env::Default());
+  TensorResponse response;
+  response.InitAlloc(&gpu_device, AllocatorAttributes());
+  EXPECT_EQ(1, gpu_device.num_pinned_allocators);
+  StringSource source(&encoded, 4);
+  TF_EXPECT_OK(response.ParseFrom(&source));
+  EXPECT_EQ(1, gpu_device.context_->num_copies);
+  test::ExpectTensorEqual<float>(src, response.tensor());
+}
+
+TEST_F(TensorResponseTest, CompressedTensor) {
+  Tensor src(DT_FLOAT, TensorShape({4, 256}));
+  src.flat<float>().setZero();
+  src.flat<float>()(17) = 2.5f;
+  RecvTensorResponse proto;
+  proto.set_send_start_micros(123456);
+  ASSERT_TRUE(CompressTensor(src, RPCOptions::FP16, 0,
+                             proto.mutable_compressed_tensor()));
+  const int64 compressed_bytes = proto.compressed_tensor().content().size();
+  string encoded;
+  proto.AppendToString(&encoded);
+
+  DummyDevice cpu_device(Env::Default());
+  DummyGpuDevice gpu_device(Env::Default());
+  for (DeviceBase* device :
+       std::vector<DeviceBase*>{&cpu_device, &gpu_device}) {
+    TensorResponse response;
+    response.InitAlloc(device, AllocatorAttributes());
+    StringSource source(&encoded, 1024);
+    TF_EXPECT_OK(response.ParseFrom(&source));
+    test::ExpectTensorEqual<float>(src, response.tensor());
+    EXPECT_EQ(123456, response.metadata().send_start_micros());
+    EXPECT_EQ(RPCOptions::SPARSE,
+              response.metadata().compressed_tensor().compression());
+    EXPECT_EQ(compressed_bytes, response.compressed_bytes());
+  }
+  EXPECT_EQ(1, gpu_device.context_->num_copies);
+}
+
 string MakeFloatTensorTestCase(int num_elems) {
   std::vector<int8> v(num_elems);
   for (int i = 0; i < num_elems; i++) {
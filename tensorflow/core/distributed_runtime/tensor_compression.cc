@@ -0,0 +1,219 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/tensor_compression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "tensorflow/core/framework/bfloat16.h"
+#include "tensorflow/core/framework/numeric_types.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+namespace {
+
+const int64 kDefaultMinBytes = 1024;
+
+// The largest finite 16-bit float.
+const float kMaxHalf = 65504.0f;
+
+// The bytes per element of the dense encoding for "compression".
+int64 DenseElementBytes(RPCOptions::TensorCompression compression) {
+  switch (compression) {
+    case RPCOptions::FP16:
+    case RPCOptions::BFLOAT16:
+      return sizeof(uint16);
+    case RPCOptions::QUANTIZED_8BIT:
+      return sizeof(uint8);
+    default:
+      return sizeof(float);
+  }
+}
+
+}  // namespace
+
+bool CompressTensorContent(DataType dtype, const TensorShape& shape,
+                           StringPiece content,
+                           RPCOptions::TensorCompression compression,
+                           int64 min_bytes, CompressedTensor* out) {
+  if (compression == RPCOptions::NO_COMPRESSION || dtype != DT_FLOAT) {
+    return false;
+  }
+  if (min_bytes <= 0) min_bytes = kDefaultMinBytes;
+  const int64 n = shape.num_elements();
+  const int64 num_bytes = content.size();
+  if (num_bytes != n * static_cast<int64>(sizeof(float)) ||
+      num_bytes < min_bytes) {
+    return false;
+  }
+  const float* data = reinterpret_cast<const float*>(content.data());
+  int64 num_nonzero = 0;
+  float lo = std::numeric_limits<float>::infinity();
+  float hi = -std::numeric_limits<float>::infinity();
+  bool finite = true;
+  for (int64 i = 0; i < n; ++i) {
+    const float v = data[i];
+    if (v != 0.0f) ++num_nonzero;
+    finite &= std::isfinite(v);
+    lo = std::min(lo, v);
+    hi = std::max(hi, v);
+  }
+
+  out->Clear();
+  out->set_dtype(dtype);
+  shape.AsProto(out->mutable_shape());
+  string* bytes = out->mutable_content();
+  const int64 sparse_bytes = num_nonzero * (sizeof(int32) + sizeof(float));
+  if (sparse_bytes < n * DenseElementBytes(compression) &&
+      n <= std::numeric_limits<int32>::max()) {
+    out->set_compression(RPCOptions::SPARSE);
+    out->set_num_nonzero(num_nonzero);
+    bytes->resize(sparse_bytes);
+    int32* indices = reinterpret_cast<int32*>(&(*bytes)[0]);
+    float* values = reinterpret_cast<float*>(indices + num_nonzero);
+    int64 k = 0;
+    for (int64 i = 0; i < n; ++i) {
+      if (data[i] != 0.0f) {
+        indices[k] = static_cast<int32>(i);
+        values[k] = data[i];
+        ++k;
+      }
+    }
+    return true;
+  }
+
+  switch (compression) {
+    case RPCOptions::FP16: {
+      // Values out of the range of 16-bit floats would become infinite.
+      if (!finite || std::max(-lo, hi) > kMaxHalf) return false;
+      bytes->resize(n * sizeof(uint16));
+      uint16* dst = reinterpret_cast<uint16*>(&(*bytes)[0]);
+      for (int64 i = 0; i < n; ++i) {
+        dst[i] = Eigen::half(data[i]).x;
+      }
+      break;
+    }
+    case RPCOptions::BFLOAT16:
+      bytes->resize(n * sizeof(bfloat16));
+      FloatToBFloat16(data, reinterpret_cast<bfloat16*>(&(*bytes)[0]), n);
+      break;
+    case RPCOptions::QUANTIZED_8BIT: {
+      if (!finite) return false;
+      out->set_min(lo);
+      out->set_max(hi);
+      const double scale =
+          hi > lo ? 255.0 / (static_cast<double>(hi) - lo) : 0.0;
+      bytes->resize(n);
+      uint8* dst = reinterpret_cast<uint8*>(&(*bytes)[0]);
+      for (int64 i = 0; i < n; ++i) {
+        const long q = std::lround((data[i] - static_cast<double>(lo)) * scale);
+        dst[i] = static_cast<uint8>(std::min(255L, std::max(0L, q)));
+      }
+      break;
+    }
+    default:
+      // SPARSE, for a tensor that isn't sparse enough.
+      return false;
+  }
+  out->set_compression(compression);
+  return true;
+}
+
+bool CompressTensor(const Tensor& tensor,
+                    RPCOptions::TensorCompression compression,
+                    int64 min_bytes, CompressedTensor* out) {
+  return CompressTensorContent(tensor.dtype(), tensor.shape(),
+                               tensor.tensor_data(), compression, min_bytes,
+                               out);
+}
+
+Status DecompressTensor(const CompressedTensor& in, Allocator* allocator,
+                        Tensor* out) {
+  if (in.dtype() != DT_FLOAT) {
+    return errors::InvalidArgument("Unsupported compressed tensor type ",
+                                   DataTypeString(in.dtype()));
+  }
+  if (!TensorShape::IsValid(in.shape())) {
+    return errors::InvalidArgument("Invalid compressed tensor shape ",
+                                   in.shape().DebugString());
+  }
+  const TensorShape shape(in.shape());
+  const int64 n = shape.num_elements();
+  const string& bytes = in.content();
+  const int64 num_bytes = bytes.size();
+  Tensor result(allocator, DT_FLOAT, shape);
+  float* dst = result.flat<float>().data();
+  switch (in.compression()) {
+    case RPCOptions::SPARSE: {
+      const int64 num_nonzero = in.num_nonzero();
+      if (num_nonzero < 0 || num_nonzero > n ||
+          num_bytes != num_nonzero * static_cast<int64>(sizeof(int32) +
+                                                        sizeof(float))) {
+        return errors::DataLoss("Malformed sparse tensor of ", num_nonzero,
+                                " values in ", num_bytes, " bytes");
+      }
+      const int32* indices = reinterpret_cast<const int32*>(bytes.data());
+      const float* values =
+          reinterpret_cast<const float*>(indices + num_nonzero);
+      std::fill(dst, dst + n, 0.0f);
+      for (int64 k = 0; k < num_nonzero; ++k) {
+        if (indices[k] < 0 || indices[k] >= n) {
+          return errors::DataLoss("Sparse tensor index ", indices[k],
+                                  " out of range for ", n, " elements");
+        }
+        dst[indices[k]] = values[k];
+      }
+      break;
+    }
+    case RPCOptions::FP16:
+    case RPCOptions::BFLOAT16:
+    case RPCOptions::QUANTIZED_8BIT: {
+      const int64 expected = n * DenseElementBytes(in.compression());
+      if (num_bytes != expected) {
+        return errors::DataLoss("Compressed tensor of ", n, " elements has ",
+                                num_bytes, " bytes instead of ", expected);
+      }
+      if (in.compression() == RPCOptions::FP16) {
+        const uint16* src = reinterpret_cast<const uint16*>(bytes.data());
+        for (int64 i = 0; i < n; ++i) {
+          dst[i] = static_cast<float>(
+              Eigen::half(Eigen::half_impl::raw_uint16_to_half(src[i])));
+        }
+      } else if (in.compression() == RPCOptions::BFLOAT16) {
+        BFloat16ToFloat(reinterpret_cast<const bfloat16*>(bytes.data()), dst,
+                        n);
+      } else {
+        const uint8* src = reinterpret_cast<const uint8*>(bytes.data());
+        const double scale =
+            (static_cast<double>(in.max()) - in.min()) / 255.0;
+        for (int64 i = 0; i < n; ++i) {
+          dst[i] = static_cast<float>(in.min() + src[i] * scale);
+        }
+      }
+      break;
+    }
+    default:
+      return errors::InvalidArgument("Unknown tensor compression ",
+                                     in.compression());
+  }
+  *out = result;
+  return Status::OK();
+}
+
+}  // namespace tensorflow
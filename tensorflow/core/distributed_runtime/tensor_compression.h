@@ -0,0 +1,55 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_COMPRESSION_H_
+#define TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_COMPRESSION_H_
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/protobuf/worker.pb.h"
+
+namespace tensorflow {
+
+// Encodes the "dtype" tensor of "shape", whose elements are "content" in
+// the layout of TensorProto.tensor_content, with "compression" into *out.
+//
+// Only DT_FLOAT tensors of at least "min_bytes" bytes (1024 if
+// "min_bytes" is not positive) are compressed.  Mostly-zero tensors are
+// encoded as SPARSE whenever that is smaller than the encoding of
+// "compression".  Returns false, leaving *out unspecified, if the tensor
+// should be sent unchanged.
+bool CompressTensorContent(DataType dtype, const TensorShape& shape,
+                           StringPiece content,
+                           RPCOptions::TensorCompression compression,
+                           int64 min_bytes, CompressedTensor* out);
+
+// As above, for the contents of "tensor".
+bool CompressTensor(const Tensor& tensor,
+                    RPCOptions::TensorCompression compression,
+                    int64 min_bytes, CompressedTensor* out);
+
+// Decodes "in" into a tensor whose buffer comes from "allocator".
+Status DecompressTensor(const CompressedTensor& in, Allocator* allocator,
+                        Tensor* out);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DISTRIBUTED_RUNTIME_TENSOR_COMPRESSION_H_
@@ -0,0 +1,128 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/distributed_runtime/tensor_compression.h"
+
+#include <limits>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// A dense tensor of 1024 floats in [-2, 2).
+Tensor DenseTensor() {
+  Tensor t(DT_FLOAT, TensorShape({32, 32}));
+  auto flat = t.flat<float>();
+  for (int i = 0; i < flat.size(); ++i) {
+    flat(i) = (i % 64) / 16.0f - 2.0f + 1e-3f;
+  }
+  return t;
+}
+
+Tensor RoundTrip(const Tensor& t, RPCOptions::TensorCompression compression,
+                 RPCOptions::TensorCompression expected) {
+  CompressedTensor compressed;
+  EXPECT_TRUE(CompressTensor(t, compression, 0, &compressed));
+  EXPECT_EQ(expected, compressed.compression());
+  Tensor result;
+  TF_EXPECT_OK(DecompressTensor(compressed, cpu_allocator(), &result));
+  EXPECT_EQ(t.shape(), result.shape());
+  return result;
+}
+
+TEST(TensorCompressionTest, Fp16) {
+  Tensor t = DenseTensor();
+  test::ExpectTensorNear<float>(
+      t, RoundTrip(t, RPCOptions::FP16, RPCOptions::FP16), 2e-3);
+}
+
+TEST(TensorCompressionTest, Bfloat16) {
+  Tensor t = DenseTensor();
+  test::ExpectTensorNear<float>(
+      t, RoundTrip(t, RPCOptions::BFLOAT16, RPCOptions::BFLOAT16), 2e-2);
+}
+
+TEST(TensorCompressionTest, Quantized8Bit) {
+  Tensor t = DenseTensor();
+  CompressedTensor compressed;
+  EXPECT_TRUE(CompressTensor(t, RPCOptions::QUANTIZED_8BIT, 0, &compressed));
+  EXPECT_EQ(t.NumElements(), compressed.content().size());
+  test::ExpectTensorNear<float>(
+      t, RoundTrip(t, RPCOptions::QUANTIZED_8BIT, RPCOptions::QUANTIZED_8BIT),
+      4.0 / 255 / 2 + 1e-6);
+}
+
+TEST(TensorCompressionTest, Sparse) {
+  Tensor t(DT_FLOAT, TensorShape({1000}));
+  t.flat<float>().setZero();
+  t.flat<float>()(3) = 1.5f;
+  t.flat<float>()(999) = -7.25f;
+  // Sparse tensors are sent exactly, whatever the requested compression.
+  for (auto compression : {RPCOptions::SPARSE, RPCOptions::FP16,
+                           RPCOptions::BFLOAT16, RPCOptions::QUANTIZED_8BIT}) {
+    test::ExpectTensorEqual<float>(
+        t, RoundTrip(t, compression, RPCOptions::SPARSE));
+  }
+}
+
+TEST(TensorCompressionTest, LeavesOtherTensorsUnchanged) {
+  CompressedTensor compressed;
+  // Dense tensors don't get smaller with the sparse encoding.
+  EXPECT_FALSE(CompressTensor(DenseTensor(), RPCOptions::SPARSE, 0,
+                              &compressed));
+  EXPECT_FALSE(CompressTensor(DenseTensor(), RPCOptions::NO_COMPRESSION, 0,
+                              &compressed));
+  // Small tensors.
+  EXPECT_FALSE(CompressTensor(DenseTensor(), RPCOptions::FP16, 8192,
+                              &compressed));
+  Tensor small(DT_FLOAT, TensorShape({10}));
+  small.flat<float>().setZero();
+  EXPECT_FALSE(CompressTensor(small, RPCOptions::FP16, 0, &compressed));
+  // Other types.
+  Tensor ints(DT_INT32, TensorShape({1024}));
+  ints.flat<int32>().setZero();
+  EXPECT_FALSE(CompressTensor(ints, RPCOptions::SPARSE, 0, &compressed));
+  // Values that 16-bit floats or quantization can't represent.
+  Tensor t = DenseTensor();
+  t.flat<float>()(0) = 1e6f;
+  EXPECT_FALSE(CompressTensor(t, RPCOptions::FP16, 0, &compressed));
+  t.flat<float>()(0) = std::numeric_limits<float>::infinity();
+  EXPECT_FALSE(CompressTensor(t, RPCOptions::QUANTIZED_8BIT, 0, &compressed));
+}
+
+TEST(TensorCompressionTest, RejectsMalformedInput) {
+  Tensor t(DT_FLOAT, TensorShape({1000}));
+  t.flat<float>().setZero();
+  t.flat<float>()(3) = 1.5f;
+  CompressedTensor compressed;
+  ASSERT_TRUE(CompressTensor(t, RPCOptions::SPARSE, 0, &compressed));
+  Tensor result;
+  CompressedTensor bad = compressed;
+  bad.mutable_content()->resize(4);
+  EXPECT_FALSE(DecompressTensor(bad, cpu_allocator(), &result).ok());
+  bad = compressed;
+  bad.mutable_shape()->mutable_dim(0)->set_size(2);
+  EXPECT_FALSE(DecompressTensor(bad, cpu_allocator(), &result).ok());
+  bad = compressed;
+  bad.set_dtype(DT_INT32);
+  EXPECT_FALSE(DecompressTensor(bad, cpu_allocator(), &result).ok());
+}
+
+}  // namespace
+}  // namespace tensorflow
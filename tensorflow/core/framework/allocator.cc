@@ -31,10 +31,15 @@ void AllocatorStats::Clear() {
   this->max_bytes_in_use = 0;
   this->max_alloc_size = 0;
   this->bytes_limit = 0;
+  this->num_cache_hits = 0;
+  this->num_cache_misses = 0;
+  this->bytes_in_cache = 0;
+  this->bytes_reserved = 0;
+  this->bytes_in_scratch = 0;
 }
 
 string AllocatorStats::DebugString() const {
-  return strings::Printf(
+  string s = strings::Printf(
       "Limit:        %20lld\n"
       "InUse:        %20lld\n"
       "MaxInUse:     %20lld\n"
@@ -42,6 +47,21 @@ string AllocatorStats::DebugString() const {
       "MaxAllocSize: %20lld\n",
       this->bytes_limit, this->bytes_in_use, this->max_bytes_in_use,
       this->num_allocs, this->max_alloc_size);
+  if (this->num_cache_hits + this->num_cache_misses > 0) {
+    strings::Appendf(&s,
+                     "CacheHits:    %20lld\n"
+                     "CacheMisses:  %20lld\n"
+                     "InCache:      %20lld\n",
+                     this->num_cache_hits, this->num_cache_misses,
+                     this->bytes_in_cache);
+  }
+  if (this->bytes_reserved > 0) {
+    strings::Appendf(&s, "Reserved:     %20lld\n", this->bytes_reserved);
+  }
+  if (this->bytes_in_scratch > 0) {
+    strings::Appendf(&s, "InScratch:    %20lld\n", this->bytes_in_scratch);
+  }
+  return s;
 }
 
 constexpr size_t Allocator::kAllocatorAlignment;
@@ -102,6 +122,10 @@ class CPUAllocator : public Allocator {
     return port::MallocExtension_GetAllocatedSize(ptr);
   }
 
+  bool AllowsInlineTensorStorage() override {
+    return !cpu_allocator_collect_stats;
+  }
+
  private:
   mutex mu_;
   AllocatorStats stats_ GUARDED_BY(mu_);
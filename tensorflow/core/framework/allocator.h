@@ -56,6 +56,22 @@ struct AllocatorStats {
   // unknown.
   int64 bytes_limit;
 
+  // For allocators with a cache in front of their main free lists (e.g.
+  // the thread caches of BFCAllocator): the number of allocations served
+  // by and missing the cache, and the number of free bytes it holds.
+  int64 num_cache_hits;
+  int64 num_cache_misses;
+  int64 bytes_in_cache;
+
+  // For allocators that obtain their memory in large regions from the system
+  // (e.g. BFCAllocator): the total size of those regions.
+  int64 bytes_reserved;
+
+  // The bytes in use that kernels keep across invocations as workspace (e.g.
+  // the scratch arenas of the GPU streams), as recorded with
+  // Allocator::RecordScratchBytes.
+  int64 bytes_in_scratch;
+
   AllocatorStats() { Clear(); }
 
   void Clear();
@@ -146,6 +162,12 @@ class Allocator {
   // usage.
   virtual bool ShouldAllocateEmptyTensors() { return false; }
 
+  // Returns true if small tensors may store their data inline in their
+  // heap-allocated buffer object instead of calling this allocator. This is
+  // only sound for allocators of plain host memory which don't need to see
+  // every allocation, e.g. to collect stats.
+  virtual bool AllowsInlineTensorStorage() { return false; }
+
   // Returns the user-requested size of the data allocated at
   // 'ptr'.  Note that the actual buffer allocated might be larger
   // than requested, but this function returns the size requested by
@@ -197,6 +219,11 @@ class Allocator {
   // Fills in 'stats' with statistics collected by this allocator.
   virtual void GetStats(AllocatorStats* stats) { stats->Clear(); }
 
+  // Records that num_bytes more (or fewer, if negative) of the buffers
+  // allocated by this allocator are held as long-lived workspace, for
+  // allocators that report it as bytes_in_scratch in their stats.
+  virtual void RecordScratchBytes(int64 num_bytes) {}
+
  private:
   // No constructors or destructors are run for simple types
   template <typename T>
@@ -337,6 +364,12 @@ struct AllocatorAttributes {
   bool gpu_compatible() const { return value & (0x1 << 2); }
   void set_track_sizes(bool v) { value |= (static_cast<int>(v) << 3); }
   bool track_sizes() const { return value & (0x1 << 3); }
+  // The caller guarantees that the buffer does not outlive the current
+  // step, e.g. because it is scratch space that never leaves the kernel
+  // (like the column buffers of the CPU convolution backprops).  Such
+  // buffers may come from a per-step arena, except in loop frames.
+  void set_scoped_to_step(bool v) { value |= (static_cast<int>(v) << 4); }
+  bool scoped_to_step() const { return value & (0x1 << 4); }
   void Merge(AllocatorAttributes other) { value |= other.value; }
   // Returns true if the fields set in *this is a subset of or equal to
   // those set in other.
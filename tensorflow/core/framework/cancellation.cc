@@ -23,68 +23,68 @@ namespace tensorflow {
 const CancellationToken CancellationManager::kInvalidToken = -1;
 
 CancellationManager::CancellationManager()
-    : is_cancelling_(false), is_cancelled_(0), next_cancellation_token_(0) {}
+    : is_cancelling_(false),
+      is_cancelled_(false),
+      next_cancellation_token_(0) {}
 
 void CancellationManager::StartCancel() {
-  gtl::FlatMap<CancellationToken, CancelCallback> callbacks_to_run;
-  {
-    mutex_lock l(mu_);
-    if (is_cancelled_.load(std::memory_order_relaxed) || is_cancelling_) {
-      return;
-    }
-    is_cancelling_ = true;
-    std::swap(callbacks_, callbacks_to_run);
+  bool was_cancelling = false;
+  if (!is_cancelling_.compare_exchange_strong(was_cancelling, true)) {
+    return;
+  }
+  std::unique_ptr<CallbackMap> callbacks_to_run[kNumShards];
+  for (int i = 0; i < kNumShards; ++i) {
+    mutex_lock l(shards_[i].mu);
+    callbacks_to_run[i] = std::move(shards_[i].callbacks);
   }
-  // We call these callbacks without holding mu_, so that concurrent
+  // We call these callbacks without holding any lock, so that concurrent
   // calls to DeregisterCallback, which can happen asynchronously, do
   // not block. The callbacks remain valid because any concurrent call
   // to DeregisterCallback will block until the
   // cancelled_notification_ is notified.
-  for (auto key_and_value : callbacks_to_run) {
-    key_and_value.second();
-  }
-  {
-    mutex_lock l(mu_);
-    is_cancelling_ = false;
-    is_cancelled_.store(true, std::memory_order_release);
+  for (const auto& callbacks : callbacks_to_run) {
+    if (callbacks == nullptr) continue;
+    for (const auto& key_and_value : *callbacks) {
+      key_and_value.second();
+    }
   }
+  is_cancelled_.store(true, std::memory_order_release);
   cancelled_notification_.Notify();
 }
 
-CancellationToken CancellationManager::get_cancellation_token() {
-  mutex_lock l(mu_);
-  return next_cancellation_token_++;
-}
-
 bool CancellationManager::RegisterCallback(CancellationToken token,
                                            CancelCallback callback) {
-  mutex_lock l(mu_);
-  CHECK_LT(token, next_cancellation_token_) << "Invalid cancellation token";
-  bool should_register = !is_cancelled_ && !is_cancelling_;
-  if (should_register) {
-    std::swap(callbacks_[token], callback);
+  CHECK_LT(token, next_cancellation_token_.load(std::memory_order_relaxed))
+      << "Invalid cancellation token";
+  Shard* s = shard(token);
+  mutex_lock l(s->mu);
+  if (is_cancelling_.load()) {
+    return false;
+  }
+  if (s->callbacks == nullptr) {
+    s->callbacks.reset(new CallbackMap);
   }
-  return should_register;
+  std::swap((*s->callbacks)[token], callback);
+  return true;
 }
 
 bool CancellationManager::DeregisterCallback(CancellationToken token) {
-  mu_.lock();
-  if (is_cancelled_) {
-    mu_.unlock();
-    return false;
-  } else if (is_cancelling_) {
-    mu_.unlock();
+  Shard* s = shard(token);
+  s->mu.lock();
+  if (is_cancelling_.load()) {
+    s->mu.unlock();
     // Wait for all of the cancellation callbacks to be called. This
     // wait ensures that the caller of DeregisterCallback does not
     // return immediately and free objects that may be used in the
     // execution of any currently pending callbacks in StartCancel.
     cancelled_notification_.WaitForNotification();
     return false;
-  } else {
-    callbacks_.erase(token);
-    mu_.unlock();
-    return true;
   }
+  if (s->callbacks != nullptr) {
+    s->callbacks->erase(token);
+  }
+  s->mu.unlock();
+  return true;
 }
 
 CancellationManager::~CancellationManager() { StartCancel(); }
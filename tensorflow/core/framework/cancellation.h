@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <atomic>
 #include <functional>
+#include <memory>
 
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -58,7 +59,9 @@ class CancellationManager {
 
   // Returns a token that must be used in calls to RegisterCallback
   // and DeregisterCallback.
-  CancellationToken get_cancellation_token();
+  CancellationToken get_cancellation_token() {
+    return next_cancellation_token_.fetch_add(1, std::memory_order_relaxed);
+  }
 
   // Attempts to register the given callback to be invoked when this
   // manager is cancelled. Returns true if the callback was
@@ -123,13 +126,31 @@ class CancellationManager {
   bool DeregisterCallback(CancellationToken token);
 
  private:
-  bool is_cancelling_;
+  // The callbacks are spread over shards by token, each with its own lock,
+  // so that async kernels registering and deregistering callbacks on every
+  // invocation from many threads rarely contend. The shards are only
+  // walked when the manager is cancelled.
+  static constexpr int kNumShards = 8;
+  typedef gtl::FlatMap<CancellationToken, CancelCallback> CallbackMap;
+  struct Shard {
+    mutex mu;
+    // Allocated on the first registration, since many managers have few.
+    std::unique_ptr<CallbackMap> callbacks GUARDED_BY(mu);
+  };
+
+  Shard* shard(CancellationToken token) {
+    return &shards_[token % kNumShards];
+  }
+
+  // Set once by StartCancel(), before it empties the shards. Registrations
+  // check it under the lock of their shard.
+  std::atomic_bool is_cancelling_;
+  // Set once all the callbacks have run.
   std::atomic_bool is_cancelled_;
 
-  mutex mu_;
   Notification cancelled_notification_;
-  CancellationToken next_cancellation_token_ GUARDED_BY(mu_);
-  gtl::FlatMap<CancellationToken, CancelCallback> callbacks_ GUARDED_BY(mu_);
+  std::atomic<CancellationToken> next_cancellation_token_;
+  Shard shards_[kNumShards];
 };
 
 }  // namespace tensorflow
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/cancellation.h"
 
+#include <atomic>
 #include <vector>
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/threadpool.h"
@@ -115,4 +116,42 @@ TEST(Cancellation, IsCancelled) {
   delete cm;
 }
 
+TEST(Cancellation, ConcurrentRegisterDeregisterAndCancel) {
+  CancellationManager cm;
+  const int kThreads = 8;
+  const int kCallbacksPerThread = 1000;
+  // Each callback either is deregistered, or runs exactly once.
+  std::vector<std::atomic<int>> runs(kThreads * kCallbacksPerThread);
+  std::vector<int> deregistered(runs.size());
+  std::vector<int> registered(runs.size());
+  {
+    thread::ThreadPool w(Env::Default(), "test", kThreads);
+    for (int t = 0; t < kThreads; ++t) {
+      w.Schedule([&cm, &runs, &registered, &deregistered, t]() {
+        for (int j = 0; j < kCallbacksPerThread; ++j) {
+          const int i = t * kCallbacksPerThread + j;
+          runs[i] = 0;
+          std::atomic<int>* run = &runs[i];
+          auto token = cm.get_cancellation_token();
+          registered[i] =
+              cm.RegisterCallback(token, [run]() { run->fetch_add(1); });
+          if (registered[i] && j % 2 == 0) {
+            deregistered[i] = cm.DeregisterCallback(token);
+          }
+        }
+      });
+    }
+    Env::Default()->SleepForMicroseconds(1000);
+    cm.StartCancel();
+  }
+  EXPECT_TRUE(cm.IsCancelled());
+  for (int i = 0; i < runs.size(); ++i) {
+    if (!registered[i] || deregistered[i]) {
+      EXPECT_EQ(0, runs[i]) << i;
+    } else {
+      EXPECT_EQ(1, runs[i]) << i;
+    }
+  }
+}
+
 }  // namespace tensorflow
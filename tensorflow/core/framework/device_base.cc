@@ -15,8 +15,19 @@ limitations under the License.
 
 #include "tensorflow/core/framework/device_base.h"
 
+#include "tensorflow/core/util/work_sharder.h"
+
 namespace tensorflow {
 
 DeviceBase::~DeviceBase() {}
 
+const Eigen::ThreadPoolDevice* DeviceBase::eigen_cpu_device() {
+  CHECK(eigen_cpu_device_ != nullptr);
+  const int max_parallelism = GetPerThreadMaxParallelism();
+  if (max_parallelism <= eigen_cpu_devices_by_parallelism_.size()) {
+    return eigen_cpu_devices_by_parallelism_[max_parallelism - 1];
+  }
+  return eigen_cpu_device_;
+}
+
 }  // namespace tensorflow
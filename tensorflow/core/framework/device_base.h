@@ -18,6 +18,7 @@ limitations under the License.
 
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -149,6 +150,15 @@ class DeviceBase {
     eigen_cpu_device_ = d;
   }
 
+  // Sets devices that share the thread pool of the Eigen CPU device, where
+  // devices[i] uses at most i + 1 threads. eigen_cpu_device() returns them to
+  // threads that limit their parallelism (see SetPerThreadMaxParallelism()).
+  // Does not take ownership.
+  void set_eigen_cpu_devices_by_parallelism(
+      std::vector<Eigen::ThreadPoolDevice*> devices) {
+    eigen_cpu_devices_by_parallelism_ = std::move(devices);
+  }
+
 #ifdef TENSORFLOW_USE_SYCL
   void set_eigen_sycl_device(Eigen::SyclDevice* d) { eigen_sycl_device_ = d; }
 #endif
@@ -170,10 +180,9 @@ class DeviceBase {
     return GetAllocator(attr);
   }
 
-  virtual const Eigen::ThreadPoolDevice* eigen_cpu_device() {
-    CHECK(eigen_cpu_device_ != nullptr);
-    return eigen_cpu_device_;
-  }
+  // Returns the Eigen CPU device, or one with fewer threads if the calling
+  // thread limits its parallelism.
+  virtual const Eigen::ThreadPoolDevice* eigen_cpu_device();
 
 #ifdef TENSORFLOW_USE_SYCL
   virtual const Eigen::SyclDevice* eigen_sycl_device() const {
@@ -218,6 +227,7 @@ class DeviceBase {
   CpuWorkerThreads* cpu_worker_threads_ = nullptr;
   GpuDeviceInfo* gpu_device_info_ = nullptr;
   Eigen::ThreadPoolDevice* eigen_cpu_device_ = nullptr;
+  std::vector<Eigen::ThreadPoolDevice*> eigen_cpu_devices_by_parallelism_;
 #ifdef TENSORFLOW_USE_SYCL
   Eigen::SyclDevice* eigen_sycl_device_ = nullptr;
 #endif
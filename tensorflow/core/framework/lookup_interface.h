@@ -26,9 +26,10 @@ class OpKernelContext;
 
 namespace lookup {
 
-// Forward declaration so we can define GetInitializableLookupTable() in
-// LookupInterface.
+// Forward declarations so we can define GetInitializableLookupTable() and
+// GetDynamicEmbeddingTable() in LookupInterface.
 class InitializableLookupTable;
+class DynamicEmbeddingTableBase;
 
 // Lookup interface for batch lookups used by table lookup ops.
 class LookupInterface : public ResourceBase {
@@ -124,6 +125,12 @@ class LookupInterface : public ResourceBase {
     return nullptr;
   }
 
+  // Returns a DynamicEmbeddingTableBase, a subclass of LookupInterface, if the
+  // current object is a DynamicEmbeddingTableBase. Otherwise, returns nullptr.
+  virtual DynamicEmbeddingTableBase* GetDynamicEmbeddingTable() {
+    return nullptr;
+  }
+
  protected:
   virtual ~LookupInterface() = default;
 
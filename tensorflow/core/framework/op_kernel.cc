@@ -246,7 +246,9 @@ OpKernelContext::~OpKernelContext() {
 
 Allocator* OpKernelContext::get_allocator(AllocatorAttributes attr) {
   Allocator* allocator =
-      params_->device->GetStepAllocator(attr, resource_manager());
+      (attr.scoped_to_step() && params_->step_arena_allocator != nullptr)
+          ? params_->step_arena_allocator
+          : params_->device->GetStepAllocator(attr, resource_manager());
   if (track_allocations()) {
     mutex_lock lock(mu_);
     for (const auto& wrapped : wrapped_allocators_) {
@@ -589,7 +591,13 @@ Status OpKernelContext::allocate_output(StringPiece name,
 Status OpKernelContext::allocate_tensor(
     DataType type, const TensorShape& shape, Tensor* out_tensor,
     AllocatorAttributes attr, const AllocationAttributes& allocation_attr) {
-  Allocator* a = get_allocator(attr);
+  return allocate_tensor(get_allocator(attr), type, shape, out_tensor,
+                         allocation_attr);
+}
+
+Status OpKernelContext::allocate_tensor(
+    Allocator* a, DataType type, const TensorShape& shape, Tensor* out_tensor,
+    const AllocationAttributes& allocation_attr) {
   AllocationAttributes logged_attr(allocation_attr);
   logged_attr.allocation_will_be_logged = true;
   Tensor new_tensor(a, type, shape, logged_attr);
@@ -616,7 +624,15 @@ Status OpKernelContext::allocate_output(int index, const TensorShape& shape,
   DCHECK(!IsRefType(type));
   DCHECK(mutable_output(index) == nullptr);
   Tensor* output_tensor = new Tensor();
-  Status s = allocate_tensor(type, shape, output_tensor, attr);
+  Allocator* output_allocator =
+      (params_->output_allocators != nullptr && attr.value == 0 &&
+       !track_allocations())
+          ? params_->output_allocators[index]
+          : nullptr;
+  Status s = output_allocator != nullptr
+                 ? allocate_tensor(output_allocator, type, shape,
+                                   output_tensor, AllocationAttributes())
+                 : allocate_tensor(type, shape, output_tensor, attr);
   if (s.ok()) {
     outputs_[index] = TensorValue(output_tensor);
     *output = outputs_[index].tensor;
@@ -517,6 +517,12 @@ class OpKernelContext {
     // Array indexed by output number for this node
     const AllocatorAttributes* output_attr_array = nullptr;
 
+    // If not null, an array indexed by output number for this node. A
+    // non-null entry replaces the device allocator for allocate_output()
+    // calls that use the default AllocatorAttributes, e.g. to serve
+    // outputs from a precomputed memory plan.
+    Allocator* const* output_allocators = nullptr;
+
     // Shared resources accessible by this op kernel invocation.
     ResourceMgr* resource_manager = nullptr;
 
@@ -560,6 +566,11 @@ class OpKernelContext {
 
     // TensorSliceReaderCache support.
     checkpoint::TensorSliceReaderCacheWrapper* slice_reader_cache = nullptr;
+
+    // If not null, serves allocations with
+    // AllocatorAttributes::scoped_to_step(). Its memory must be usable by
+    // the device, i.e. it is only set for CPU devices.
+    Allocator* step_arena_allocator = nullptr;
   };
 
   // params must outlive the OpKernelContext.
@@ -1087,6 +1098,11 @@ class OpKernelContext {
                          Tensor* out_tensor, AllocatorAttributes allocator_attr,
                          const AllocationAttributes& allocation_attr);
 
+  // Same as above, but with an explicit allocator.
+  Status allocate_tensor(Allocator* a, DataType type, const TensorShape& shape,
+                         Tensor* out_tensor,
+                         const AllocationAttributes& allocation_attr);
+
   // This is called by PersistentTensor::AccessTensor whenever the
   // wrapped tensor is retrieved, to ensure the runtime knows that the
   // Tensor is being accessed within an Op. This is necessary for
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/framework/rendezvous.h"
 
+#include <atomic>
 #include <functional>
 #include <utility>
 #include <vector>
@@ -24,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/flatmap.h"
 #include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -44,9 +46,27 @@ Rendezvous::ParsedKey& Rendezvous::ParsedKey::operator=(const ParsedKey& b) {
   dst = b.dst;
   edge_name.set(buf_.data() + (b.edge_name.data() - b_base),
                 b.edge_name.size());
+  hash_ = b.hash_;
   return *this;
 }
 
+void Rendezvous::ParsedKey::WithFrameIter(const FrameAndIter& frame_iter,
+                                          ParsedKey* out) const {
+  DCHECK_NE(this, out);
+  // The frame and iteration follow the edge name and its delimiter.
+  const char* base = buf_.data();
+  out->buf_.assign(base, edge_name.data() + edge_name.size() + 1 - base);
+  strings::StrAppend(&out->buf_, frame_iter.frame_id, ":", frame_iter.iter_id);
+  const char* out_base = out->buf_.data();
+  out->src_device.set(out_base + (src_device.data() - base), src_device.size());
+  out->src = src;
+  out->src_incarnation = src_incarnation;
+  out->dst_device.set(out_base + (dst_device.data() - base), dst_device.size());
+  out->dst = dst;
+  out->edge_name.set(out_base + (edge_name.data() - base), edge_name.size());
+  out->hash_ = Hash64(out->buf_.data(), out->buf_.size());
+}
+
 /*  static */
 string Rendezvous::CreateKey(const string& src_device, uint64 src_incarnation,
                              const string& dst_device, const string& name,
@@ -106,6 +126,7 @@ Status Rendezvous::ParseKey(StringPiece key, ParsedKey* out) {
     out->src_device.set(parts[0].data(), parts[0].size());
     out->dst_device.set(parts[2].data(), parts[2].size());
     out->edge_name.set(parts[3].data(), parts[3].size());
+    out->hash_ = Hash64(out->buf_.data(), out->buf_.size());
     return Status::OK();
   }
   return errors::InvalidArgument("Invalid  rendezvous key: ", key);
@@ -154,16 +175,17 @@ class LocalRendezvousImpl : public Rendezvous {
               const bool is_dead) override {
     DoneCallback waiter = nullptr;
     Args recv_args;
-    uint64 key_hash = KeyHash(key.FullKey());
+    const uint64 key_hash = key.hash();
     VLOG(2) << "Send " << this << " " << key_hash << " " << key.FullKey();
+    Shard* shard = GetShard(key_hash);
     {
-      mutex_lock l(mu_);
-      if (!status_.ok()) {
-        return status_;
+      mutex_lock l(shard->mu);
+      if (aborted_.load(std::memory_order_acquire)) {
+        return GetStatus();
       }
       Item* item = nullptr;
-      Table::iterator iter = table_.find(key_hash);
-      if (iter == table_.end()) {
+      Table::iterator iter = shard->table.find(key_hash);
+      if (iter == shard->table.end()) {
         // There is no waiter for this message. Insert the message
         // into the waiters table. The waiter will pick it up when
         // arrives.
@@ -180,7 +202,7 @@ class LocalRendezvousImpl : public Rendezvous {
         // The allocator attributes of item->value.
         item->send_alloc_attrs = send_args.alloc_attrs;
 
-        CHECK(table_.insert({key_hash, item}).second);
+        CHECK(shard->table.insert({key_hash, item}).second);
         return Status::OK();
       } else {
         item = iter->second;
@@ -222,21 +244,21 @@ class LocalRendezvousImpl : public Rendezvous {
 
   void RecvAsync(const ParsedKey& key, const Args& recv_args,
                  DoneCallback done) override {
-    uint64 key_hash = KeyHash(key.FullKey());
+    const uint64 key_hash = key.hash();
     VLOG(2) << "Recv " << this << " " << key_hash << " " << key.FullKey();
-    mu_.lock();
-    if (!status_.ok()) {
+    Shard* shard = GetShard(key_hash);
+    shard->mu.lock();
+    if (aborted_.load(std::memory_order_acquire)) {
       // Rendezvous has been aborted.
-      Status s = status_;
-      mu_.unlock();
-      done(s, Args(), recv_args, Tensor(), false);
+      shard->mu.unlock();
+      done(GetStatus(), Args(), recv_args, Tensor(), false);
       return;
     }
-    Table::iterator iter = table_.find(key_hash);
-    if (iter != table_.end()) {
+    Table::iterator iter = shard->table.find(key_hash);
+    if (iter != shard->table.end()) {
       Item* item = iter->second;
       if (item->has_been_recvd && !tolerate_dup_recv_) {
-        mu_.unlock();
+        shard->mu.unlock();
         done(errors::Aborted("Duplicated recv: ", key.FullKey()), Args(),
              recv_args, Tensor(), false);
       } else if (item->waiter == nullptr || tolerate_dup_recv_) {
@@ -259,13 +281,13 @@ class LocalRendezvousImpl : public Rendezvous {
         Args send_args;
         send_args.device_context = item->send_dev_context;
         send_args.alloc_attrs = item->send_alloc_attrs;
-        mu_.unlock();
+        shard->mu.unlock();
         done(Status::OK(), send_args, recv_args, v, is_dead);
         if (send_dev_context) send_dev_context->Unref();
       } else {
         // Already have a waiter in the waiters table under this key,
         // which should not happen.
-        mu_.unlock();
+        shard->mu.unlock();
         done(errors::Aborted("Duplicated recv: ", key.FullKey()), Args(),
              recv_args, Tensor(), false);
       }
@@ -281,20 +303,43 @@ class LocalRendezvousImpl : public Rendezvous {
       item->recv_dev_context = recv_args.device_context;
       item->recv_dev_context->Ref();
     }
-    CHECK(table_.insert({key_hash, item}).second);
-    mu_.unlock();
+    CHECK(shard->table.insert({key_hash, item}).second);
+    shard->mu.unlock();
+  }
+
+  bool RecvAsyncIfSent(const ParsedKey& key, const Args& recv_args,
+                       DoneCallback done) override {
+    const uint64 key_hash = key.hash();
+    Shard* shard = GetShard(key_hash);
+    {
+      mutex_lock l(shard->mu);
+      if (!aborted_.load(std::memory_order_acquire) &&
+          shard->table.find(key_hash) == shard->table.end()) {
+        return false;
+      }
+    }
+    // Only another Recv of the same key, which is an error RecvAsync()
+    // reports, or an abort, which it reports too, can remove the item from
+    // the table in the meantime. So this runs "done" right away.
+    RecvAsync(key, recv_args, std::move(done));
+    return true;
   }
 
   void StartAbort(const Status& status) override {
     CHECK(!status.ok());
-    std::vector<Item*> items;
     {
-      mutex_lock l(mu_);
+      mutex_lock l(status_mu_);
       if (!status_.ok()) return;
       status_ = status;
-      items.reserve(table_.size());
-      for (const auto& p : table_) items.push_back(p.second);
-      table_.clear();
+    }
+    // Send and RecvAsync check aborted_ under their shard's lock, so once
+    // a shard has been cleared below, no item is added to it again.
+    aborted_.store(true, std::memory_order_release);
+    std::vector<Item*> items;
+    for (Shard& shard : shards_) {
+      mutex_lock l(shard.mu);
+      for (const auto& p : shard.table) items.push_back(p.second);
+      shard.table.clear();
     }
     for (Item* item : items) {
       if (item->waiter != nullptr) {
@@ -327,21 +372,39 @@ class LocalRendezvousImpl : public Rendezvous {
       }
     }
   };
-  // We key the hash table by KeyHash of the Rendezvous::CreateKey string
-  static uint64 KeyHash(const StringPiece& k) {
-    return Hash64(k.data(), k.size());
-  }
 
+  // We key the hash table by ParsedKey::hash(), the Hash64 of the
+  // Rendezvous::CreateKey string.
   typedef gtl::FlatMap<uint64, Item*> Table;
 
-  // TODO(zhifengc): shard table_.
-  mutex mu_;
-  Table table_ GUARDED_BY(mu_);
-  Status status_;
+  // The table is split in shards by key hash so that the Send/Recv pairs
+  // of a step, which mostly use distinct keys, do not contend on one lock.
+  static const int kNumShards = 16;
+  struct Shard {
+    mutex mu;
+    Table table GUARDED_BY(mu);
+  };
+  Shard* GetShard(uint64 key_hash) {
+    // The low bits also pick the FlatMap bucket; use the high ones.
+    return &shards_[(key_hash >> 32) % kNumShards];
+  }
+  Shard shards_[kNumShards];
+
+  Status GetStatus() {
+    mutex_lock l(status_mu_);
+    return status_;
+  }
+
+  // Set once StartAbort() has stored status_.
+  std::atomic<bool> aborted_{false};
+  mutex status_mu_;
+  Status status_ GUARDED_BY(status_mu_);
 
   ~LocalRendezvousImpl() override {
-    for (auto i : table_) {
-      delete i.second;
+    for (Shard& shard : shards_) {
+      for (auto i : shard.table) {
+        delete i.second;
+      }
     }
   }
 
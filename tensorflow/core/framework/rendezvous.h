@@ -67,11 +67,24 @@ class Rendezvous : public core::RefCounted {
     ParsedKey& operator=(const ParsedKey& b);
     StringPiece FullKey() const { return buf_; }
 
+    // Hash64 of FullKey(), computed once by ParseKey() so that kernels
+    // caching their key do not rehash it on every step.
+    uint64 hash() const { return hash_; }
+
+    // Sets "*out" to this key with its frame and iteration replaced by
+    // "frame_iter". Unlike ParseKey(), doesn't parse the device names, so
+    // that Send and Recv kernels in loops can derive the keys of every
+    // iteration from the key they parsed once.
+    //
+    // REQUIRES: out != this
+    void WithFrameIter(const FrameAndIter& frame_iter, ParsedKey* out) const;
+
    private:
     friend class Rendezvous;
     friend class SendOp;
     friend class RecvOp;
     string buf_;
+    uint64 hash_ = 0;
   };
   static Status ParseKey(StringPiece key, ParsedKey* out);
 
@@ -102,6 +115,16 @@ class Rendezvous : public core::RefCounted {
   virtual void RecvAsync(const ParsedKey& key, const Args& args,
                          DoneCallback done) = 0;
 
+  // Like RecvAsync(), but only if the tensor for "key" has already been
+  // sent or the rendezvous has been aborted, in which case it runs "done"
+  // and returns true. Otherwise returns false without waiting for the
+  // tensor, and drops "done". The default implementation always returns
+  // false.
+  virtual bool RecvAsyncIfSent(const ParsedKey& key, const Args& args,
+                               DoneCallback done) {
+    return false;
+  }
+
   // Synchronous wrapper for RecvAsync.
   Status Recv(const ParsedKey& key, const Args& args, Tensor* val,
               bool* is_dead, int64 timeout_ms);
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/notification.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
@@ -52,6 +53,23 @@ TEST(RendezvousTest, Key) {
   EXPECT_EQ(parsed.src.type, "CPU");
   EXPECT_EQ(parsed.dst_device, "/job:mnist/replica:1/task:2/GPU:0");
   EXPECT_EQ(parsed.dst.type, "GPU");
+  EXPECT_EQ(parsed.hash(), Hash64(key));
+  Rendezvous::ParsedKey copy = parsed;
+  EXPECT_EQ(copy.hash(), parsed.hash());
+
+  Rendezvous::ParsedKey in_loop;
+  parsed.WithFrameIter(FrameAndIter(12, 345), &in_loop);
+  const string in_loop_key = Rendezvous::CreateKey(
+      "/job:mnist/replica:1/task:2/CPU:0", 7890,
+      "/job:mnist/replica:1/task:2/GPU:0", "var0", FrameAndIter(12, 345));
+  EXPECT_EQ(in_loop.FullKey(), in_loop_key);
+  EXPECT_EQ(in_loop.src_device, parsed.src_device);
+  EXPECT_EQ(in_loop.src_incarnation, 7890);
+  EXPECT_EQ(in_loop.src.type, "CPU");
+  EXPECT_EQ(in_loop.dst_device, parsed.dst_device);
+  EXPECT_EQ(in_loop.dst.type, "GPU");
+  EXPECT_EQ(in_loop.edge_name, "var0");
+  EXPECT_EQ(in_loop.hash(), Hash64(in_loop_key));
 
   EXPECT_FALSE(Rendezvous::ParseKey("foo;bar;baz", &parsed).ok());
   EXPECT_FALSE(Rendezvous::ParseKey("/job:mnist/replica:1/task:2/CPU:0;"
@@ -135,6 +153,37 @@ TEST_F(LocalRendezvousTest, RecvSend) {
   EXPECT_EQ("hello", V(val));
 }
 
+TEST_F(LocalRendezvousTest, RecvIfSent) {
+  Rendezvous::Args args;
+  auto recv_if_sent = [this, &args](string* val) {
+    return rendez_->RecvAsyncIfSent(
+        KeyFoo(), args,
+        [val](const Status& s, const Rendezvous::Args& send_args,
+              const Rendezvous::Args& recv_args, const Tensor& v,
+              const bool dead) {
+          TF_EXPECT_OK(s);
+          *val = V(v);
+        });
+  };
+  string val;
+  EXPECT_FALSE(recv_if_sent(&val));
+  // Nothing was consumed or left waiting.
+  TF_ASSERT_OK(rendez_->Send(KeyFoo(), args, V("hello"), false));
+  EXPECT_TRUE(recv_if_sent(&val));
+  EXPECT_EQ("hello", val);
+}
+
+TEST_F(LocalRendezvousTest, RecvIfSentAfterAbort) {
+  rendez_->StartAbort(errors::Aborted(""));
+  Status status;
+  EXPECT_TRUE(rendez_->RecvAsyncIfSent(
+      KeyFoo(), Rendezvous::Args(),
+      [&status](const Status& s, const Rendezvous::Args& send_args,
+                const Rendezvous::Args& recv_args, const Tensor& v,
+                const bool dead) { status = s; }));
+  EXPECT_TRUE(errors::IsAborted(status));
+}
+
 TEST_F(LocalRendezvousTest, DuplicateWaiterRecv) {
   SchedClosure([this]() {
     Tensor t(DT_STRING);
@@ -261,6 +310,30 @@ TEST_F(LocalRendezvousTest, AbortThenRecvOrSend) {
       errors::IsAborted(rendez_->Recv(KeyFoo(), args, &val, &val_dead)));
 }
 
+TEST_F(LocalRendezvousTest, AbortWakesAllPendingRecvs) {
+  // Enough keys to put waiters in every shard of the table.
+  static const int N = 256;
+  BlockingState state;
+  state.counter = N;
+  for (int i = 0; i < N; ++i) {
+    rendez_->RecvAsync(
+        MakeKey(strings::StrCat(i)), Rendezvous::Args(),
+        [&state](const Status& s, const Rendezvous::Args& send_args,
+                 const Rendezvous::Args& recv_args, const Tensor& v,
+                 bool is_dead) {
+          EXPECT_TRUE(errors::IsAborted(s));
+          bool done = false;
+          {
+            mutex_lock l(state.lock);
+            done = --state.counter == 0;
+          }
+          if (done) state.done.Notify();
+        });
+  }
+  rendez_->StartAbort(errors::Aborted(""));
+  state.done.WaitForNotification();
+}
+
 class DummyDeviceContext : public DeviceContext {
  public:
   explicit DummyDeviceContext(int stream_id) : stream_id_(stream_id) {}
@@ -96,6 +96,7 @@ void ResourceMgr::Clear() {
   mutex_lock l(mu_);
   for (const auto& p : containers_) {
     for (const auto& q : *p.second) {
+      q.second->removed_.store(true, std::memory_order_release);
       q.second->Unref();
     }
     delete p.second;
@@ -189,6 +190,7 @@ Status ResourceMgr::DoDelete(const string& container, uint64 type_hash_code,
     b->erase(iter);
   }
   CHECK(base != nullptr);
+  base->removed_.store(true, std::memory_order_release);
   base->Unref();
   return Status::OK();
 }
@@ -217,6 +219,7 @@ Status ResourceMgr::Cleanup(const string& container) {
   }
   CHECK(b != nullptr);
   for (const auto& p : *b) {
+    p.second->removed_.store(true, std::memory_order_release);
     p.second->Unref();
   }
   delete b;
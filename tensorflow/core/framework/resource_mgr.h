@@ -16,10 +16,13 @@ limitations under the License.
 #ifndef TENSORFLOW_FRAMEWORK_RESOURCE_MGR_H_
 #define TENSORFLOW_FRAMEWORK_RESOURCE_MGR_H_
 
+#include <atomic>
+#include <memory>
 #include <string>
 #include <typeindex>
 #include <typeinfo>
 #include <unordered_map>
+#include <vector>
 
 #include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -80,6 +83,16 @@ class ResourceBase : public core::RefCounted {
 
   // Returns memory used by this resource.
   virtual int64 MemoryUsed() const { return 0; };
+
+ private:
+  friend class ResourceMgr;
+  template <typename T>
+  friend class ResourceLookupCache;
+
+  // Set when *this is deleted from a container of a ResourceMgr. It is never
+  // reset, so a ResourceLookupCache doesn't trust a resource that was deleted
+  // and created again, possibly under another name.
+  std::atomic<bool> removed_{false};
 };
 
 // Container used for per-step resources.
@@ -233,6 +246,63 @@ Status CreateResource(OpKernelContext* ctx, const ResourceHandle& p, T* value);
 template <typename T>
 Status LookupResource(OpKernelContext* ctx, const ResourceHandle& p, T** value);
 
+// Looks up resources pointed by resource handles on behalf of one kernel,
+// resolving a handle once instead of on every call.
+//
+// A kernel that looks up the resource of the same handle on every step can
+// keep a ResourceLookupCache as a member. After the first lookup, Lookup()
+// compares the handle with the one it resolved and returns the resource it
+// holds a ref on, without taking the lock of the ResourceMgr or hashing
+// the handle. If the handle differs, or the resource was deleted from its
+// container since, it looks the handle up with LookupResource() again.
+//
+// Deleted resources stay alive until the cache is destroyed, since other
+// threads may still be using them. To bound their number, the cache stops
+// caching after kMaxEntries resolutions and then behaves like
+// LookupResource().
+//
+// Thread-safe.
+template <typename T>
+class ResourceLookupCache {
+ public:
+  ResourceLookupCache() {}
+  ~ResourceLookupCache();
+
+  // Same as LookupResource(ctx, p, value): on success, the caller takes the
+  // ownership of one ref on "*value".
+  Status Lookup(OpKernelContext* ctx, const ResourceHandle& p, T** value)
+      TF_MUST_USE_RESULT;
+
+  // Same as above, for the handle of the numbered op input.
+  Status Lookup(OpKernelContext* ctx, int input, T** value) TF_MUST_USE_RESULT {
+    return Lookup(ctx, ctx->input(input).flat<ResourceHandle>()(0), value);
+  }
+
+ private:
+  static constexpr int kMaxEntries = 4;
+
+  struct Entry {
+    const ResourceMgr* rmgr;
+    string device;
+    string container;
+    string name;
+    uint64 hash_code;
+    T* resource;  // The cache owns one ref.
+  };
+
+  static bool Matches(const Entry& entry, OpKernelContext* ctx,
+                      const ResourceHandle& p);
+
+  // The entry of the last resolution, read without taking "mu_". Entries
+  // are immutable and owned by "entries_".
+  std::atomic<Entry*> entry_{nullptr};
+
+  mutex mu_;
+  std::vector<std::unique_ptr<Entry>> entries_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ResourceLookupCache);
+};
+
 // Looks up or creates a resource.
 template <typename T>
 Status LookupOrCreateResource(OpKernelContext* ctx, const ResourceHandle& p,
@@ -471,6 +541,46 @@ Status LookupResource(OpKernelContext* ctx, const ResourceHandle& p,
   return ctx->resource_manager()->Lookup(p.container(), p.name(), value);
 }
 
+template <typename T>
+ResourceLookupCache<T>::~ResourceLookupCache() {
+  for (const auto& entry : entries_) {
+    entry->resource->Unref();
+  }
+}
+
+template <typename T>
+bool ResourceLookupCache<T>::Matches(const Entry& entry, OpKernelContext* ctx,
+                                     const ResourceHandle& p) {
+  // The device and type of the handle were validated when the entry was made.
+  return entry.rmgr == ctx->resource_manager() &&
+         entry.hash_code == p.hash_code() && entry.name == p.name() &&
+         entry.container == p.container() && entry.device == p.device() &&
+         !entry.resource->removed_.load(std::memory_order_acquire);
+}
+
+template <typename T>
+Status ResourceLookupCache<T>::Lookup(OpKernelContext* ctx,
+                                      const ResourceHandle& p, T** value) {
+  Entry* entry = entry_.load(std::memory_order_acquire);
+  if (entry != nullptr && Matches(*entry, ctx, p)) {
+    entry->resource->Ref();
+    *value = entry->resource;
+    return Status::OK();
+  }
+  TF_RETURN_IF_ERROR(LookupResource(ctx, p, value));
+  mutex_lock l(mu_);
+  if (entries_.size() < kMaxEntries &&
+      !(*value)->removed_.load(std::memory_order_acquire)) {
+    (*value)->Ref();
+    Entry* new_entry =
+        new Entry{ctx->resource_manager(), p.device(),    p.container(),
+                  p.name(),                p.hash_code(), *value};
+    entries_.emplace_back(new_entry);
+    entry_.store(new_entry, std::memory_order_release);
+  }
+  return Status::OK();
+}
+
 template <typename T>
 Status LookupOrCreateResource(OpKernelContext* ctx, const ResourceHandle& p,
                               T** value, std::function<Status(T**)> creator) {
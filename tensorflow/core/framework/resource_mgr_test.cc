@@ -319,4 +319,59 @@ TEST(ResourceHandleTest, DeleteUsingResourceHandle) {
   r->Unref();
 }
 
+TEST(ResourceHandleTest, LookupCache) {
+  ResourceMgr resource_mgr("");
+  OpKernelContext::Params params;
+  params.resource_manager = &resource_mgr;
+  StubDevice device("device_name");
+  params.device = &device;
+  OpKernelContext ctx(&params, 0);
+
+  ResourceHandle p =
+      MakeResourceHandle<StubResource>(&ctx, "container", "name");
+  ResourceHandle q =
+      MakeResourceHandle<StubResource>(&ctx, "container", "other");
+  ResourceLookupCache<StubResource> cache;
+  StubResource* r = nullptr;
+  EXPECT_FALSE(cache.Lookup(&ctx, p, &r).ok());
+
+  auto* first = new StubResource;
+  TF_ASSERT_OK(CreateResource(&ctx, p, first));
+  TF_ASSERT_OK(cache.Lookup(&ctx, p, &r));
+  EXPECT_EQ(first, r);
+  r->Unref();
+  // Served by the cache, which holds a ref on the resource.
+  TF_ASSERT_OK(cache.Lookup(&ctx, p, &r));
+  EXPECT_EQ(first, r);
+  EXPECT_FALSE(r->RefCountIsOne());
+  r->Unref();
+
+  // A different handle is looked up again.
+  auto* second = new StubResource;
+  TF_ASSERT_OK(CreateResource(&ctx, q, second));
+  TF_ASSERT_OK(cache.Lookup(&ctx, q, &r));
+  EXPECT_EQ(second, r);
+  r->Unref();
+
+  // Deleting the resource invalidates its entry, though the cache keeps it
+  // alive.
+  TF_ASSERT_OK(DeleteResource<StubResource>(&ctx, q));
+  EXPECT_FALSE(cache.Lookup(&ctx, q, &r).ok());
+  auto* third = new StubResource;
+  TF_ASSERT_OK(CreateResource(&ctx, q, third));
+  TF_ASSERT_OK(cache.Lookup(&ctx, q, &r));
+  EXPECT_EQ(third, r);
+  r->Unref();
+
+  // A handle of another type isn't served by the cache.
+  ResourceHandle wrong_type =
+      MakeResourceHandle<OtherStubResource>(&ctx, "container", "other");
+  EXPECT_FALSE(cache.Lookup(&ctx, wrong_type, &r).ok());
+
+  // So does cleaning up its container.
+  TF_ASSERT_OK(resource_mgr.Cleanup("container"));
+  EXPECT_FALSE(cache.Lookup(&ctx, q, &r).ok());
+  EXPECT_FALSE(cache.Lookup(&ctx, p, &r).ok());
+}
+
 }  // end namespace tensorflow
@@ -27,6 +27,7 @@ limitations under the License.
 
 namespace tensorflow {
 
+class ShapeInferenceCache;
 class ShapeRefinerTest;
 
 namespace grappler {
@@ -106,6 +107,7 @@ class ShapeHandle {
   friend class InferenceContext;
   friend class ShapeInferenceTest;
   friend class ShapeInferenceTestutil;
+  friend class ::tensorflow::ShapeInferenceCache;
   friend class ::tensorflow::ShapeRefinerTest;
   friend class ShapeManager;
 
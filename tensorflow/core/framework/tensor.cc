@@ -23,6 +23,9 @@ limitations under the License.
 //   default constructors and destructors when T is not a simple type
 //   (e.g., string.), and skips them otherwise.
 //
+// * InlineBuffer: provides the storage of small tensors of simple types
+//   inline, for allocators which allow it.
+//
 // * Helper<T>: provides various routines given type T.  The routines
 //   includes running the constructor and destructor of T[], encoding
 //   an decoding T[] into/from a Cord, etc.
@@ -41,6 +44,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/platform/types.h"
@@ -101,6 +105,55 @@ class Buffer : public BufferBase {
   TF_DISALLOW_COPY_AND_ASSIGN(Buffer);
 };
 
+// Ref-counted buffer of at most kMaxBytes, stored in the buffer object itself.
+// Scalars and small shape or index tensors are created and destroyed on
+// every step, and storing them inline saves an allocator call and a heap
+// allocation per tensor.
+class InlineBuffer : public TensorBuffer {
+ public:
+  static constexpr size_t kMaxBytes = 64;
+
+  InlineBuffer(Allocator* alloc, size_t size) : alloc_(alloc), size_(size) {}
+
+  void* data() const override { return const_cast<char*>(data_); }
+  size_t size() const override { return size_; }
+
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(size_);
+    proto->set_allocator_name(alloc_->Name());
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data_));
+  }
+
+  // The new-expression doesn't honor the alignment of data_ before C++17.
+  static void* operator new(size_t size) noexcept {
+    return port::AlignedMalloc(size, Allocator::kAllocatorAlignment);
+  }
+  static void operator delete(void* ptr) { port::AlignedFree(ptr); }
+
+ private:
+  ~InlineBuffer() override {}
+
+  Allocator* const alloc_;
+  const size_t size_;
+  alignas(Allocator::kAllocatorAlignment) char data_[kMaxBytes];
+
+  TF_DISALLOW_COPY_AND_ASSIGN(InlineBuffer);
+};
+
+// Allocates the buffer of a T[n] tensor, inline if it is small enough and
+// "a" allows it. Allocations are only logged by the allocator, so
+// tensors aren't stored inline while LogMemory is enabled.
+template <typename T>
+TensorBuffer* NewBuffer(Allocator* a, int64 n,
+                        const AllocationAttributes& allocation_attr) {
+  if (is_simple_type<T>::value && n * sizeof(T) <= InlineBuffer::kMaxBytes &&
+      a->AllowsInlineTensorStorage() && !LogMemory::IsEnabled()) {
+    return new InlineBuffer(a, n * sizeof(T));
+  }
+  return new Buffer<T>(a, n, allocation_attr);
+}
+
 void LogUnexpectedSize(int64 actual, int64 expected) {
   LOG(ERROR) << "Input size was " << actual << " and expected " << expected;
 }
@@ -582,7 +635,8 @@ Tensor::Tensor(Allocator* a, DataType type, const TensorShape& shape)
   set_dtype(type);
   CHECK_NOTNULL(a);
   if (shape_.num_elements() > 0 || a->ShouldAllocateEmptyTensors()) {
-    CASES(type, buf_ = new Buffer<T>(a, shape.num_elements()));
+    CASES(type, buf_ = NewBuffer<T>(a, shape.num_elements(),
+                                    AllocationAttributes()));
   }
   if (buf_ != nullptr && buf_->data() != nullptr && LogMemory::IsEnabled()) {
     LogMemory::RecordTensorAllocation("Unknown", LogMemory::UNKNOWN_STEP_ID,
@@ -596,7 +650,8 @@ Tensor::Tensor(Allocator* a, DataType type, const TensorShape& shape,
   set_dtype(type);
   CHECK_NOTNULL(a);
   if (shape_.num_elements() > 0 || a->ShouldAllocateEmptyTensors()) {
-    CASES(type, buf_ = new Buffer<T>(a, shape.num_elements(), allocation_attr));
+    CASES(type,
+          buf_ = NewBuffer<T>(a, shape.num_elements(), allocation_attr));
   }
   if (!allocation_attr.allocation_will_be_logged && buf_ != nullptr &&
       buf_->data() != nullptr && LogMemory::IsEnabled()) {
@@ -428,10 +428,11 @@ class Tensor {
   void UnsafeCopyFromInternal(const Tensor&, DataType dtype,
                               const TensorShape&);
 
- private:
   // Returns true if the refcount on buf_ and any possible underlying root
-  // buffer is one.
+  // buffer is one, i.e. if no other tensor shares the buffer.
   bool RefCountIsOne() const;
+
+ private:
   void CheckType(DataType expected_dtype) const;
   void CheckTypeAndIsAligned(DataType expected_dtype) const;
   void CheckIsAlignedAndSingleElement() const;
@@ -458,9 +459,12 @@ class Tensor {
   friend class TensorTestHelper;      // For access to set_shape
   template <typename Device, typename T>
   friend class CreateVariableOp;
-  friend class OpKernelContext;  // For access to RefCountIsOne().
   friend class NumpyTensorBuffer;  // For access to the private constructor
                                    // taking the buffer.
+  friend class MemmappedTensorBuffer;  // For access to the private
+                                       // constructor taking the buffer.
+  friend class BundleReader;  // For access to the private constructor taking
+                              // the buffer.
 
   // Creates a tensor with the input datatype, shape and buf.
   //
@@ -59,6 +59,9 @@ class TensorReference {
     return buf_ == (t.buf_ ? t.buf_->root_buffer() : nullptr);
   }
 
+  // The start of the memory being kept alive, or nullptr.
+  const void* data() const { return buf_ ? buf_->data() : nullptr; }
+
   // Convenience function for de-duplicating tensor references.
   size_t BufferHash() const { return std::hash<TensorBuffer*>()(buf_); }
 
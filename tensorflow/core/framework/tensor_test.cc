@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/logging.h"
@@ -1046,6 +1047,56 @@ TEST(Tensor, EmptyTensorData) {
   EXPECT_EQ(empty.tensor_data().size(), 0);
 }
 
+// Allocator which counts its allocations and lets small tensors be stored
+// inline instead.
+class InlineStorageAllocator : public Allocator {
+ public:
+  string Name() override { return "inline_storage"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    ++num_allocs_;
+    return cpu_allocator()->AllocateRaw(alignment, num_bytes);
+  }
+  void DeallocateRaw(void* ptr) override {
+    cpu_allocator()->DeallocateRaw(ptr);
+  }
+  bool AllowsInlineTensorStorage() override { return true; }
+
+  int num_allocs_ = 0;
+};
+
+TEST(Tensor, InlineStorage) {
+  InlineStorageAllocator allocator;
+  for (int64 n : {1, 16, 17}) {
+    Tensor t(&allocator, DT_FLOAT, TensorShape({n}));
+    EXPECT_TRUE(t.IsAligned());
+    for (int64 i = 0; i < n; ++i) {
+      t.flat<float>()(i) = i;
+    }
+    Tensor copy = t;
+    EXPECT_TRUE(copy.SharesBufferWith(t));
+    Tensor slice = t.Slice(0, 1);
+    EXPECT_TRUE(slice.SharesBufferWith(t));
+    test::ExpectTensorEqual<float>(t, tensor::DeepCopy(copy));
+    EXPECT_EQ(n * sizeof(float), t.AllocatedBytes());
+  }
+  // Only the 17 floats didn't fit in 64 bytes.
+  EXPECT_EQ(1, allocator.num_allocs_);
+
+  // Strings are never stored inline.
+  Tensor s(&allocator, DT_STRING, TensorShape({}));
+  EXPECT_EQ(2, allocator.num_allocs_);
+}
+
+// Benchmark create and destroy a scalar tensor.
+static void BM_CreateAndDestroyScalar(int iters) {
+  TensorShape shape({});
+  Allocator* allocator = cpu_allocator();
+  while (--iters) {
+    Tensor a(allocator, DT_INT32, shape);
+  }
+}
+BENCHMARK(BM_CreateAndDestroyScalar);
+
 // Benchmark create and destroy a tensor, with an allocated buffer.
 static void BM_CreateAndDestroyWithBuf(int iters) {
   TensorShape shape({10, 20});
@@ -151,6 +151,10 @@ void TrackingAllocator::GetStats(AllocatorStats* stats) {
   allocator_->GetStats(stats);
 }
 
+void TrackingAllocator::RecordScratchBytes(int64 num_bytes) {
+  allocator_->RecordScratchBytes(num_bytes);
+}
+
 std::tuple<size_t, size_t, size_t> TrackingAllocator::GetSizesAndUnRef() {
   size_t high_watermark;
   size_t total_bytes;
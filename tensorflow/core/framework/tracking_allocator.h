@@ -57,6 +57,7 @@ class TrackingAllocator : public Allocator {
   size_t AllocatedSize(void* ptr) override;
   int64 AllocationId(void* ptr) override;
   void GetStats(AllocatorStats* stats) override;
+  void RecordScratchBytes(int64 num_bytes) override;
 
   // If the underlying allocator tracks allocation sizes, this returns
   // a tuple where the first value is the total number of bytes
@@ -304,6 +304,14 @@ Node* Graph::AddNode(const NodeDef& node_def, Status* status) {
   return node;
 }
 
+Node* Graph::AddNode(NodeDef* node_def, const OpDef* op_def,
+                     const DataTypeSlice inputs, const DataTypeSlice outputs) {
+  Node::Properties* props =
+      new Node::Properties(op_def, NodeDef(), inputs, outputs);
+  props->node_def_.Swap(node_def);
+  return AllocateNode(props, nullptr);
+}
+
 Node* Graph::CopyNode(Node* node) {
   DCHECK(!node->IsSource());
   DCHECK(!node->IsSink());
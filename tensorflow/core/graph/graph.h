@@ -393,6 +393,14 @@ class Graph {
   // Returns nullptr and sets *status on error.
   Node* AddNode(const NodeDef& node_def, Status* status);
 
+  // Adds a new node for "*node_def", whose op "op_def" is in the registry
+  // of this graph and whose input and output types are "inputs" and
+  // "outputs", and returns it. Takes the content of "*node_def", leaving it
+  // empty. Lets importers copy NodeDefs and infer their types concurrently
+  // (see GraphConstructorOptions::trusted).
+  Node* AddNode(NodeDef* node_def, const OpDef* op_def,
+                const DataTypeSlice inputs, const DataTypeSlice outputs);
+
   // Copies *node, which may belong to another graph, to a new node,
   // which is returned.  Does not copy any edges.  *this owns the
   // returned instance.
@@ -21,6 +21,7 @@ limitations under the License.
 #include <unordered_map>
 #include <vector>
 
+#include "tensorflow/core/common_runtime/shape_inference_cache.h"
 #include "tensorflow/core/common_runtime/shape_refiner.h"
 #include "tensorflow/core/framework/function.h"
 #include "tensorflow/core/framework/function.pb.h"
@@ -36,6 +37,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/scanner.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -60,10 +62,15 @@ class GraphConstructor {
     Options(const GraphConstructorOptions& in)  // NOLINT(runtime/explicit)
         : allow_internal_ops(in.allow_internal_ops),
           expect_device_spec(in.expect_device_spec),
+          trusted(in.trusted),
+          runner(in.runner),
+          max_parallelism(in.max_parallelism),
           importing(false) {}
     Options(const ImportGraphDefOptions& in)  // NOLINT(runtime/explicit)
         : allow_internal_ops(false),
           expect_device_spec(false),
+          trusted(false),
+          max_parallelism(1),
           prefix(in.prefix.empty() || StringPiece(in.prefix).ends_with("/")
                      ? in.prefix
                      : in.prefix + "/"),
@@ -74,6 +81,9 @@ class GraphConstructor {
 
     bool allow_internal_ops;
     bool expect_device_spec;
+    bool trusted;
+    std::function<void(std::function<void()>)> runner;
+    int max_parallelism;
 
     string prefix;
     std::map<TensorId, TensorId> input_map;
@@ -130,8 +140,14 @@ class GraphConstructor {
     TF_RETURN_IF_ERROR(EnsureNoNameCollisions());
     TF_RETURN_IF_ERROR(ValidateInputMapAndControlDependencies());
     TF_RETURN_IF_ERROR(BuildNodeIndex());
-    TF_RETURN_IF_ERROR(InitFromEdges());
-    TF_RETURN_IF_ERROR(Convert());
+    if (opts_.trusted) {
+      TF_RETURN_IF_ERROR(ParseNodes());
+      TF_RETURN_IF_ERROR(InitFromParsedEdges());
+      TF_RETURN_IF_ERROR(ConvertParsed());
+    } else {
+      TF_RETURN_IF_ERROR(InitFromEdges());
+      TF_RETURN_IF_ERROR(Convert());
+    }
     TF_RETURN_IF_ERROR(AddBackEdges());
     TF_RETURN_IF_ERROR(UpdateVersionDef());
     TF_RETURN_IF_ERROR(PopulateReturnTensors());
@@ -144,6 +160,11 @@ class GraphConstructor {
   Status BuildNodeIndex();
   Status InitFromEdges();
   Status Convert();
+  // With opts_.trusted, parse the NodeDefs into parsed_ concurrently, and
+  // use them instead of InitFromEdges() and Convert().
+  Status ParseNodes();
+  Status InitFromParsedEdges();
+  Status ConvertParsed();
   Status AddBackEdges();
   Status UpdateVersionDef();
   Status PopulateReturnTensors();
@@ -194,6 +215,24 @@ class GraphConstructor {
   // alternative implementation of std::unordered_map.
   std::unordered_map<StringPiece, NodeInfo, StringPiece::Hasher> gdef_nodes_;
 
+  // With opts_.trusted, the entry of gdef_nodes_ of every NodeDef, by index
+  // within node_defs_.
+  std::vector<NodeInfo*> node_infos_;
+
+  // With opts_.trusted, the inputs of a NodeDef, as the index within
+  // node_defs_ of their node and their output index (or
+  // Graph::kControlSlot), and the copy of the NodeDef and the types of its
+  // Node until it is added to g_.
+  struct ParsedNode {
+    gtl::InlinedVector<std::pair<int, int>, 4> inputs;
+    const OpDef* op_def = nullptr;
+    NodeDef node_def;
+    DataTypeVector input_types;
+    DataTypeVector output_types;
+    Status status;
+  };
+  std::vector<ParsedNode> parsed_;
+
   // Mapping from node name to the existing node in g_
   std::unordered_map<StringPiece, Node*, StringPiece::Hasher> existing_nodes_;
 
@@ -325,6 +364,26 @@ Status GraphConstructor::ValidateInputMapAndControlDependencies() {
 }
 
 Status GraphConstructor::BuildNodeIndex() {
+  gdef_nodes_.reserve(node_defs_.size());
+  if (opts_.trusted) {
+    node_infos_.reserve(node_defs_.size());
+    for (int n = 0; n < node_defs_.size(); ++n) {
+      const NodeDef& node_def = *node_defs_[n];
+      auto result = gdef_nodes_.insert(
+          std::make_pair(StringPiece(node_def.name()), NodeInfo(n)));
+      if (!result.second) {
+        return errors::InvalidArgument("Node '", node_def.name(),
+                                       "' is not unique");
+      }
+      node_infos_.push_back(&result.first->second);
+      if (opts_.expect_device_spec && node_def.device().empty()) {
+        return errors::InvalidArgument("Node '", node_def.name(),
+                                       "' is missing a device specification");
+      }
+    }
+    return Status::OK();
+  }
+
   // Validate the node names and add them to gdef_nodes_.
   for (int n = 0; n < node_defs_.size(); ++n) {
     const NodeDef& node_def = *node_defs_[n];
@@ -404,6 +463,158 @@ Status GraphConstructor::InitFromEdges() {
   return Status::OK();
 }
 
+Status GraphConstructor::ParseNodes() {
+  // Functions are ops of the graph, so they are added first.
+  if (library_) {
+    TF_RETURN_IF_ERROR(g_->AddFunctionLibrary(*library_));
+  }
+
+  // Every op is looked up once: lookups in the registry take a lock.
+  const int num_nodes = node_defs_.size();
+  parsed_.resize(num_nodes);
+  std::unordered_map<StringPiece, const OpDef*, StringPiece::Hasher> op_defs;
+  for (int n = 0; n < num_nodes; ++n) {
+    const string& op = node_defs_[n]->op();
+    const OpDef*& op_def = op_defs[op];
+    if (op_def == nullptr) {
+      TF_RETURN_IF_ERROR(g_->op_registry()->LookUpOpDef(op, &op_def));
+    }
+    parsed_[n].op_def = op_def;
+  }
+
+  auto parse = [this](int n) {
+    const NodeDef& node_def = *node_defs_[n];
+    ParsedNode* parsed = &parsed_[n];
+    parsed->inputs.reserve(node_def.input_size());
+    for (int i = 0; i < node_def.input_size(); ++i) {
+      TensorId id(ParseTensorName(node_def.input(i)));
+      auto iter = gdef_nodes_.find(id.first);
+      if (iter == gdef_nodes_.end()) {
+        parsed->status = errors::InvalidArgument(
+            "Node '", node_def.name(), "': Unknown input node '",
+            node_def.input(i), "'");
+        return;
+      }
+      parsed->inputs.emplace_back(iter->second.gdef_index, id.second);
+    }
+    Status s = InOutTypesForNode(node_def, *parsed->op_def,
+                                 &parsed->input_types, &parsed->output_types);
+    if (!s.ok()) {
+      parsed->status = AttachDef(s, node_def);
+      return;
+    }
+    parsed->node_def = node_def;
+  };
+  const int kNodesPerShard = 256;
+  const int num_shards = (num_nodes + kNodesPerShard - 1) / kNodesPerShard;
+  ShardWithRunner(opts_.max_parallelism, opts_.runner, num_shards,
+                  [num_nodes, &parse](int64 shard) {
+                    const int end = std::min<int64>(
+                        (shard + 1) * kNodesPerShard, num_nodes);
+                    for (int n = shard * kNodesPerShard; n < end; ++n) {
+                      parse(n);
+                    }
+                  });
+  for (const ParsedNode& parsed : parsed_) {
+    TF_RETURN_IF_ERROR(parsed.status);
+  }
+  return Status::OK();
+}
+
+Status GraphConstructor::InitFromParsedEdges() {
+  const int num_nodes = node_defs_.size();
+  pending_count_.reserve(num_nodes);
+  outputs_.resize(num_nodes);
+  for (int n = 0; n < num_nodes; ++n) {
+    const ParsedNode& parsed = parsed_[n];
+    if (IsMerge(*node_defs_[n])) {
+      // for merge only wait for one non-control input.
+      int32 num_control_edges = 0;
+      for (const auto& input : parsed.inputs) {
+        if (input.second == Graph::kControlSlot) num_control_edges++;
+      }
+      pending_count_.push_back(num_control_edges + 1);
+    } else {
+      pending_count_.push_back(parsed.inputs.size());
+    }
+    if (parsed.inputs.empty()) {
+      ready_.push_back(n);
+      continue;
+    }
+    for (const auto& input : parsed.inputs) {
+      outputs_[input.first].push_back(n);
+    }
+  }
+  return Status::OK();
+}
+
+Status GraphConstructor::ConvertParsed() {
+  int processed = 0;
+  // Process the NodeDefs in topological order, as Convert() does.
+  while (!ready_.empty()) {
+    int o = ready_.back();
+    ready_.pop_back();
+    ++processed;
+    const NodeDef& node_def = *node_defs_[o];
+    ParsedNode& parsed = parsed_[o];
+
+    bool has_data_back_edge = false;
+    for (const auto& input : parsed.inputs) {
+      const Node* src_node = node_infos_[input.first]->node;
+      if (src_node == nullptr) {
+        has_data_back_edge = true;
+      } else if (input.second >= src_node->num_outputs()) {
+        return errors::InvalidArgument(
+            "Node '", node_def.name(), "': Connecting to invalid output ",
+            input.second, " of source node ", src_node->name(), " which has ",
+            src_node->num_outputs(), " outputs");
+      }
+    }
+    if (has_data_back_edge && !IsMerge(node_def)) {
+      return errors::InvalidArgument(
+          "Node '", node_def.name(),
+          "' had a back edge, but only Merge nodes can have back edges.");
+    }
+
+    Node* node = g_->AddNode(&parsed.node_def, parsed.op_def,
+                             parsed.input_types, parsed.output_types);
+    if (opts_.expect_device_spec) {
+      node->set_assigned_device_name(node_def.device());
+    }
+    node_infos_[o]->node = node;
+
+    // Add edges from inputs to *node to the graph.
+    for (int i = 0; i < parsed.inputs.size(); ++i) {
+      const int src = parsed.inputs[i].first;
+      const int src_index = parsed.inputs[i].second;
+      Node* src_node = node_infos_[src]->node;
+      if (src_node == nullptr) {
+        back_edges_.push_back(
+            EdgeInfo(node_defs_[src]->name(), src_index, node, i));
+      } else if (src_index == Graph::kControlSlot) {
+        g_->AddControlEdge(src_node, node);
+      } else {
+        g_->AddEdge(src_node, src_index, node, i);
+      }
+    }
+
+    // Update pending_count_ for outputs.
+    for (size_t i = 0; i < outputs_[o].size(); ++i) {
+      const int output = outputs_[o][i];
+      pending_count_[output]--;
+      if (pending_count_[output] == 0) {
+        ready_.push_back(output);
+      }
+    }
+  }
+
+  if (processed < node_defs_.size()) {
+    return errors::InvalidArgument(node_defs_.size() - processed,
+                                   " nodes in a cycle");
+  }
+  return Status::OK();
+}
+
 Status GraphConstructor::ValidateColocationConstraints(
     const NodeDef& node_def) {
   if (!opts_.importing) return Status::OK();
@@ -902,6 +1113,9 @@ Status ImportGraphDef(const ImportGraphDefOptions& opts, const GraphDef& gdef,
 
   ShapeRefiner default_refiner(gdef.versions().producer(), g->op_registry());
   if (refiner == nullptr) {
+    // The shapes only validate the import, so reusing the results of other
+    // imports is fine.
+    default_refiner.set_shape_inference_cache(ShapeInferenceCache::Global());
     refiner = &default_refiner;
   } else {
     // Log a warning if we are importing a GraphDef at an older
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_GRAPH_GRAPH_CONSTRUCTOR_H_
 #define TENSORFLOW_GRAPH_GRAPH_CONSTRUCTOR_H_
 
+#include <functional>
+
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/tensor_id.h"
@@ -42,6 +44,17 @@ struct GraphConstructorOptions {
   //
   // TODO(zhifengc): if possible, consider removing this option.
   bool expect_device_spec = false;
+
+  // If true, the GraphDef is expected to be valid, e.g. because it was
+  // produced from a Graph by this process, and the checks of node names,
+  // of the order of control inputs and of the types of edges are skipped.
+  // The NodeDefs are then parsed, and the properties of their nodes built,
+  // concurrently on the calling thread and up to "max_parallelism - 1"
+  // closures passed to "runner", if it is set. Each op is looked up in the
+  // registry once.
+  bool trusted = false;
+  std::function<void(std::function<void()>)> runner = nullptr;
+  int max_parallelism = 1;
 };
 extern Status ConvertGraphDefToGraph(const GraphConstructorOptions& opts,
                                      const GraphDef& gdef, Graph* g);
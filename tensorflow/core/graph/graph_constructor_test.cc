@@ -24,13 +24,17 @@ limitations under the License.
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/node_builder.h"
 #include "tensorflow/core/kernels/ops_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/version.h"
 
@@ -89,9 +93,20 @@ class GraphConstructorTest : public ::testing::Test {
   }
 
   void ExpectOK(const string& gdef_ascii) {
+    const bool was_empty = graph_.num_nodes() == 2;
     Convert(gdef_ascii);
     GraphConstructorOptions opts;
     TF_CHECK_OK(ConvertGraphDefToGraph(opts, gdef_, &graph_));
+
+    // A trusted conversion builds the same graph.
+    if (was_empty) {
+      Graph trusted_graph(OpRegistry::Global());
+      opts.trusted = true;
+      TF_CHECK_OK(ConvertGraphDefToGraph(opts, gdef_, &trusted_graph));
+      GraphDef trusted_def;
+      trusted_graph.ToGraphDef(&trusted_def);
+      EXPECT_EQ(GraphDebugString(), trusted_def.DebugString());
+    }
   }
 
   void ExpectOK(const string& gdef_ascii, const ImportGraphDefOptions& opts,
@@ -892,6 +907,104 @@ TEST_F(GraphConstructorTest, Error_ControlEdgeBeforeRealInput) {
       {"Node 't2': Control dependencies must come after regular dependencies"});
 }
 
+// Returns a chain of "num_nodes" TestMul nodes, each also depending on the
+// node 10 steps before it through a control edge.
+GraphDef TestMulChain(int num_nodes) {
+  GraphDef gdef;
+  NodeDef* input = gdef.add_node();
+  input->set_name("input");
+  input->set_op("TestInput");
+  string prev = "input";
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* mul = gdef.add_node();
+    mul->set_name(strings::StrCat("mul", i));
+    mul->set_op("TestMul");
+    mul->add_input(prev);
+    mul->add_input("input:1");
+    if (i >= 10) mul->add_input(strings::StrCat("^mul", i - 10));
+    prev = mul->name();
+  }
+  return gdef;
+}
+
+TEST_F(GraphConstructorTest, TrustedInParallel) {
+  const GraphDef gdef = TestMulChain(5000);
+  GraphConstructorOptions opts;
+  TF_ASSERT_OK(ConvertGraphDefToGraph(opts, gdef, &graph_));
+
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  Graph trusted_graph(OpRegistry::Global());
+  opts.trusted = true;
+  opts.runner = [&pool](std::function<void()> c) { pool.Schedule(c); };
+  opts.max_parallelism = 4;
+  TF_ASSERT_OK(ConvertGraphDefToGraph(opts, gdef, &trusted_graph));
+  GraphDef trusted_def;
+  trusted_graph.ToGraphDef(&trusted_def);
+  EXPECT_EQ(GraphDebugString(), trusted_def.DebugString());
+}
+
+TEST_F(GraphConstructorTest, TrustedErrors) {
+  GraphConstructorOptions opts;
+  opts.trusted = true;
+  const string original_graph_description = GraphDebugString();
+  auto expect_error = [this, &opts, &original_graph_description](
+      const string& gdef_ascii, const string& expected_error) {
+    GraphDef gdef;
+    CHECK(protobuf::TextFormat::ParseFromString(gdef_ascii, &gdef));
+    Status status = ConvertGraphDefToGraph(opts, gdef, &graph_);
+    EXPECT_FALSE(status.ok());
+    EXPECT_TRUE(StringPiece(status.error_message()).contains(expected_error))
+        << status;
+    EXPECT_EQ(original_graph_description, GraphDebugString());
+  };
+  expect_error(
+      "node { name: 'W1' op: 'TestParams' }"
+      "node { name: 't1' op: 'TestMul' input: [ 'W1', 'W2' ] }",
+      "Node 't1': Unknown input node 'W2'");
+  expect_error(
+      "node { name: 'W1' op: 'TestParams' }"
+      "node { name: 't1' op: 'TestMul' input: [ 'W1', 'W1:1' ] }",
+      "Connecting to invalid output 1");
+  expect_error(
+      "node { name: 'input' op: 'TestInput' }"
+      "node { name: 't1' op: 'TestMul' input: [ 'input:0', 't2' ] }"
+      "node { name: 't2' op: 'TestMul' input: [ 'input:1', 't1' ] }",
+      "cycle");
+  expect_error("node { name: 'a' op: 'ABCDE' }", "ABCDE");
+  expect_error(
+      "node { name: 'a' op: 'ABC' }"
+      "node { name: 'a' op: 'ABC' }",
+      "Node 'a' is not unique");
+}
+
+static void BM_ConvertGraphDefToGraph(int iters, int num_nodes, bool trusted) {
+  testing::StopTiming();
+  const GraphDef gdef = TestMulChain(num_nodes);
+  thread::ThreadPool pool(Env::Default(), "bench", port::NumSchedulableCPUs());
+  GraphConstructorOptions opts;
+  if (trusted) {
+    opts.trusted = true;
+    opts.runner = [&pool](std::function<void()> c) { pool.Schedule(c); };
+    opts.max_parallelism = pool.NumThreads();
+  }
+  testing::ItemsProcessed(static_cast<int64>(iters) * num_nodes);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    Graph graph(OpRegistry::Global());
+    TF_CHECK_OK(ConvertGraphDefToGraph(opts, gdef, &graph));
+  }
+  testing::StopTiming();
+}
+
+static void BM_ConvertGraphDefToGraph_Untrusted(int iters, int num_nodes) {
+  BM_ConvertGraphDefToGraph(iters, num_nodes, false);
+}
+static void BM_ConvertGraphDefToGraph_Trusted(int iters, int num_nodes) {
+  BM_ConvertGraphDefToGraph(iters, num_nodes, true);
+}
+BENCHMARK(BM_ConvertGraphDefToGraph_Untrusted)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_ConvertGraphDefToGraph_Trusted)->Arg(1000)->Arg(100000);
+
 TEST_F(GraphConstructorTest, ImportGraphDef) {
   GraphDef def;
   ImportGraphDefOptions opts;
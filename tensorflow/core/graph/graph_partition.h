@@ -71,6 +71,14 @@ struct PartitionOptions {
   // in the graph as a node attribute.
   bool need_to_record_start_times = false;
   std::vector<Microseconds> start_times;
+
+  // If set, and "max_parallelism" is more than one, the partitions of
+  // different locations are built concurrently, on the calling thread and
+  // on closures passed to "runner".  The functions above must then be
+  // thread-safe.
+  typedef std::function<void(std::function<void()>)> Runner;
+  Runner runner = nullptr;
+  int max_parallelism = 1;
 };
 
 // Partition "input" graph into a set of graphs, one per location.
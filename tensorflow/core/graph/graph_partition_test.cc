@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/core/graph/graph_partition.h"
 
+#include <algorithm>
 #include <unordered_map>
 #include <utility>
 
@@ -31,7 +32,9 @@ limitations under the License.
 #include "tensorflow/core/graph/graph_def_builder.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/public/version.h"
@@ -435,5 +438,61 @@ TEST_F(GraphPartitionTest, Functions) {
   ExpectFunctions(partitions_[b].library(), {"XTimesTwo", "XTimesFour"});
 }
 
+// The sorted ops of each partition of "partitions".
+std::unordered_map<string, std::vector<string>> PartitionOps(
+    const std::unordered_map<string, GraphDef>& partitions) {
+  std::unordered_map<string, std::vector<string>> ops;
+  for (const auto& it : partitions) {
+    std::vector<string>* v = &ops[it.first];
+    for (const NodeDef& ndef : it.second.node()) v->push_back(ndef.op());
+    std::sort(v->begin(), v->end());
+  }
+  return ops;
+}
+
+TEST_F(GraphPartitionTest, Parallel) {
+  using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+  std::vector<Output> outputs;
+  for (int i = 0; i < 20; ++i) {
+    const string device(1, 'A' + i % 3);
+    auto input = FloatInput(in_.WithOpName(strings::StrCat(device, "In", i)));
+    if (outputs.empty()) {
+      outputs.push_back(input);
+    } else {
+      auto prev = outputs.back();
+      outputs.push_back(
+          Combine(in_.WithOpName(strings::StrCat(device, "Comb", i))
+                      .WithControlDependencies(outputs.front()),
+                  prev, input));
+    }
+  }
+  const GraphDef& graph_def = ToGraphDef();
+  Partition(graph_def, &partitions_);
+  EXPECT_EQ(3, partitions_.size());
+
+  Graph g(OpRegistry::Global());
+  GraphConstructorOptions opts;
+  TF_ASSERT_OK(ConvertGraphDefToGraph(opts, graph_def, &g));
+  for (Node* node : g.nodes()) {
+    node->set_assigned_device_name(DeviceName(node));
+  }
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  mutex mu;
+  PartitionOptions popts;
+  popts.node_to_loc = SplitByDevice;
+  popts.new_name = [&g, &mu](const string& prefix) {
+    mutex_lock l(mu);
+    return g.NewName(prefix);
+  };
+  popts.get_incarnation = [](const string& name) {
+    return (name[0] - 'A') + 100;
+  };
+  popts.runner = [&pool](std::function<void()> c) { pool.Schedule(c); };
+  popts.max_parallelism = 4;
+  std::unordered_map<string, GraphDef> parallel;
+  TF_ASSERT_OK(Partition(popts, &g, &parallel));
+  EXPECT_EQ(PartitionOps(partitions_), PartitionOps(parallel));
+}
+
 }  // namespace
 }  // namespace tensorflow
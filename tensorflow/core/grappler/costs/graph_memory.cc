@@ -15,10 +15,15 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/costs/graph_memory.h"
 
+#include <algorithm>
+#include <map>
+
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/virtual_placer.h"
+#include "tensorflow/core/grappler/utils.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -55,6 +60,99 @@ Status GraphMemory::InferFromGraphProperties(GraphProperties* properties) {
   return Status::OK();
 }
 
+Status GraphMemory::InferPeakMemoryUsage(
+    const Cluster* cluster,
+    const std::unordered_map<string, Costs::NanoSeconds>& completion_times) {
+  GraphProperties properties(item_);
+  TF_RETURN_IF_ERROR(properties.InferStatically());
+  VirtualPlacer placer(cluster);
+
+  // Collect the tensors of every device, together with the time at which
+  // they're last used.
+  std::map<std::pair<string, int>, LiveTensor> tensors;
+  std::unordered_map<string, string> devices;
+  for (const auto& node : item_.graph.node()) {
+    auto it = completion_times.find(node.name());
+    if (it == completion_times.end()) {
+      continue;
+    }
+    devices[node.name()] = placer.get_canonical_device_name(node);
+    std::vector<OpInfo::TensorProperties> outputs =
+        properties.GetOutputProperties(node.name());
+    for (int i = 0; i < outputs.size(); ++i) {
+      LiveTensor& tensor = tensors[std::make_pair(node.name(), i)];
+      tensor.node = node.name();
+      tensor.output_id = i;
+      tensor.memory_used = InferMemUsageForNeighbors({outputs[i]});
+      tensor.allocation_time = it->second;
+      tensor.deallocation_time = it->second;
+    }
+  }
+  for (const auto& node : item_.graph.node()) {
+    auto it = completion_times.find(node.name());
+    if (it == completion_times.end()) {
+      continue;
+    }
+    for (const string& input : node.input()) {
+      int position;
+      string input_node = ParseNodeName(input, &position);
+      auto tensor = tensors.find(std::make_pair(input_node, position));
+      if (tensor == tensors.end()) {
+        continue;
+      }
+      tensor->second.deallocation_time =
+          std::max(tensor->second.deallocation_time, it->second);
+    }
+  }
+
+  // Replay the allocations and deallocations of each device in order. A node
+  // needs its inputs until it completes, so the tensors it produces are
+  // accounted for before the ones it releases.
+  std::unordered_map<string, std::vector<std::pair<Costs::NanoSeconds, int64>>>
+      events;
+  for (const auto& tensor : tensors) {
+    const LiveTensor& t = tensor.second;
+    auto& device_events = events[devices[t.node]];
+    device_events.emplace_back(t.allocation_time, t.memory_used);
+    device_events.emplace_back(t.deallocation_time, -t.memory_used);
+  }
+  peak_usage_.clear();
+  peak_usage_time_.clear();
+  for (auto& device : events) {
+    std::sort(device.second.begin(), device.second.end(),
+              [](const std::pair<Costs::NanoSeconds, int64>& a,
+                 const std::pair<Costs::NanoSeconds, int64>& b) {
+                return a.first < b.first ||
+                       (a.first == b.first && a.second > b.second);
+              });
+    int64 used_memory = 0;
+    int64 peak_memory = -1;
+    Costs::NanoSeconds peak_time = 0;
+    for (const auto& event : device.second) {
+      used_memory += event.second;
+      if (used_memory > peak_memory) {
+        peak_memory = used_memory;
+        peak_time = event.first;
+      }
+    }
+    MemoryUsage& usage = peak_usage_[device.first];
+    usage.used_memory = peak_memory;
+    peak_usage_time_[device.first] = peak_time;
+    for (const auto& tensor : tensors) {
+      const LiveTensor& t = tensor.second;
+      if (devices[t.node] == device.first && t.allocation_time <= peak_time &&
+          t.deallocation_time >= peak_time) {
+        usage.live_tensors.push_back(t);
+      }
+    }
+    std::stable_sort(usage.live_tensors.begin(), usage.live_tensors.end(),
+                     [](const LiveTensor& a, const LiveTensor& b) {
+                       return a.memory_used > b.memory_used;
+                     });
+  }
+  return Status::OK();
+}
+
 void GraphMemory::InferMemUsageForNodes(
     const std::vector<const NodeDef*>& nodes, GraphProperties* properties,
     int64* worst_case_memory_usage, int64* best_case_memory_usage) const {
@@ -16,8 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_GRAPPLER_COSTS_GRAPH_MEMORY_H_
 #define TENSORFLOW_GRAPPLER_COSTS_GRAPH_MEMORY_H_
 
+#include <unordered_map>
+
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/costs/cost_estimator.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 
@@ -42,6 +45,41 @@ class GraphMemory {
   // that which is needed for a single node to perform its computations.
   int64 GetBestCaseMemoryUsage() const { return best_case_memory_usage_; }
 
+  // A tensor that is held in memory: it is allocated when the node that
+  // produces it completes and released when its last consumer completes.
+  struct LiveTensor {
+    string node;
+    int output_id;
+    int64 memory_used;
+    Costs::NanoSeconds allocation_time;
+    Costs::NanoSeconds deallocation_time;
+  };
+  struct MemoryUsage {
+    int64 used_memory = 0;
+    std::vector<LiveTensor> live_tensors;
+  };
+
+  // Infers the peak memory usage of each device of the cluster given the time
+  // at which each node completes, as estimated by a static schedule.
+  Status InferPeakMemoryUsage(
+      const Cluster* cluster,
+      const std::unordered_map<string, Costs::NanoSeconds>& completion_times);
+
+  // The peak memory usage of a device, along with the tensors that are live at
+  // that time, sorted by decreasing size. Only available after a call to
+  // InferPeakMemoryUsage.
+  const MemoryUsage& GetPeakMemoryUsage(const string& device) const {
+    static const MemoryUsage* unknown_usage = new MemoryUsage();
+    auto it = peak_usage_.find(device);
+    return it == peak_usage_.end() ? *unknown_usage : it->second;
+  }
+
+  // Time at which the peak memory usage of a device is reached.
+  Costs::NanoSeconds GetPeakMemoryUsageTime(const string& device) const {
+    auto it = peak_usage_time_.find(device);
+    return it == peak_usage_time_.end() ? Costs::NanoSeconds(0) : it->second;
+  }
+
  private:
   void InferMemUsageForNodes(const std::vector<const NodeDef*>& nodes,
                              GraphProperties* properties, int64* worst_case,
@@ -53,6 +91,8 @@ class GraphMemory {
   GrapplerItem item_;
   int64 worst_case_memory_usage_;
   int64 best_case_memory_usage_;
+  std::unordered_map<string, MemoryUsage> peak_usage_;
+  std::unordered_map<string, Costs::NanoSeconds> peak_usage_time_;
 };
 
 }  // end namespace grappler
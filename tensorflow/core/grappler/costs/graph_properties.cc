@@ -18,6 +18,7 @@ limitations under the License.
 #include <queue>
 #include <unordered_map>
 #include <unordered_set>
+#include "tensorflow/core/common_runtime/shape_inference_cache.h"
 #include "tensorflow/core/common_runtime/shape_refiner.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/graph/graph_constructor.h"
@@ -181,6 +182,7 @@ Status GraphProperties::InferStatically() {
   Graph graph(OpRegistry::Global());
   ShapeRefiner shape_refiner(graph.versions().producer(), graph.op_registry());
   shape_refiner.set_require_shape_inference_fns(false);
+  shape_refiner.set_shape_inference_cache(ShapeInferenceCache::Global());
   ImportGraphDefOptions options;
   Status s = ImportGraphDef(options, item_.graph, &graph, &shape_refiner);
   TF_RETURN_IF_ERROR(s);
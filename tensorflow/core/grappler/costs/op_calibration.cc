@@ -0,0 +1,253 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_calibration.h"
+
+#include <algorithm>
+#include <map>
+
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/costs/robust_stats.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace tensorflow {
+namespace grappler {
+
+constexpr int OpCalibrationDatabase::kMaxSamplesPerOp;
+
+namespace {
+
+// Returns the key of the measurements of "op_info". The values of the inputs
+// and of the attributes are ignored, since they rarely affect the execution
+// time of an op.
+string CalibrationKey(const OpInfo& op_info) {
+  string key = strings::StrCat(op_info.op(), ";", op_info.device().type(), ";",
+                               op_info.device().model(), ";");
+  for (const auto& input : op_info.inputs()) {
+    strings::StrAppend(&key, DataTypeString(input.dtype()),
+                       PartialTensorShape::DebugString(input.shape()), ",");
+  }
+  // The attributes are sorted, so that the key doesn't depend on the order of
+  // the map.
+  std::map<string, string> attrs;
+  for (const auto& attr : op_info.attr()) {
+    if (attr.first.empty() || attr.first[0] == '_' ||
+        attr.second.has_tensor()) {
+      continue;
+    }
+    attrs[attr.first] = SummarizeAttrValue(attr.second);
+  }
+  for (const auto& attr : attrs) {
+    strings::StrAppend(&key, ";", attr.first, "=", attr.second);
+  }
+  return key;
+}
+
+// Returns the name of the node whose GPU kernel is described by the hardware
+// stats "node_stats", whose node name is of the form "<node>:<op>".
+string GetKernelNodeName(const NodeExecStats& node_stats) {
+  const string& name = node_stats.node_name();
+  return name.substr(0, name.find(':'));
+}
+
+}  // namespace
+
+void OpCalibrationDatabase::AddOpPerformance(const OpPerformance& perf) {
+  std::deque<OpPerformance>& samples = entries_[CalibrationKey(perf.op())];
+  samples.push_back(perf);
+  // The values of the inputs can be large, and are ignored anyway.
+  for (auto& input : *samples.back().mutable_op()->mutable_inputs()) {
+    input.clear_value();
+  }
+  if (samples.size() > kMaxSamplesPerOp) {
+    samples.pop_front();
+  }
+}
+
+void OpCalibrationDatabase::AddOpPerformanceList(
+    const OpPerformanceList& perfs) {
+  for (const auto& perf : perfs.op_performance()) {
+    AddOpPerformance(perf);
+  }
+}
+
+Status OpCalibrationDatabase::AddStepStats(const GraphDef& graph,
+                                           const StepStats& step_stats) {
+  std::unordered_map<string, const NodeDef*> name_to_node;
+  for (const auto& node : graph.node()) {
+    name_to_node[node.name()] = &node;
+  }
+
+  // Like the cost model, prefer the hardware stats of the GPU kernels, that
+  // are recorded in the "/stream:all" pseudo device, to the time it took to
+  // launch them. An op may run several kernels.
+  std::unordered_map<string, int64> kernel_micros;
+  // The outputs of the nodes, from which the inputs of their consumers are
+  // deduced.
+  std::unordered_map<string, std::vector<OpInfo::TensorProperties>> outputs;
+  for (const auto& dev_stats : step_stats.dev_stats()) {
+    const bool is_stream = dev_stats.device().find("/stream") != string::npos;
+    if (is_stream) {
+      // The kernels are also recorded in their actual stream: only count them
+      // once.
+      if (StringPiece(dev_stats.device()).ends_with("/stream:all")) {
+        for (const auto& node_stats : dev_stats.node_stats()) {
+          kernel_micros[GetKernelNodeName(node_stats)] +=
+              node_stats.op_end_rel_micros();
+        }
+      }
+      continue;
+    }
+    for (const auto& node_stats : dev_stats.node_stats()) {
+      auto& node_outputs = outputs[node_stats.node_name()];
+      for (const auto& output : node_stats.output()) {
+        if (output.slot() < 0) {
+          continue;
+        }
+        if (output.slot() >= node_outputs.size()) {
+          node_outputs.resize(output.slot() + 1);
+        }
+        OpInfo::TensorProperties& properties = node_outputs[output.slot()];
+        properties.set_dtype(output.tensor_description().dtype());
+        *properties.mutable_shape() = output.tensor_description().shape();
+      }
+    }
+  }
+
+  int num_recorded = 0;
+  for (const auto& dev_stats : step_stats.dev_stats()) {
+    if (dev_stats.device().find("/stream") != string::npos ||
+        dev_stats.device().find("/memcpy") != string::npos) {
+      continue;
+    }
+    const DeviceProperties device = GetDeviceInfo(dev_stats.device());
+    if (device.type() == "UNKNOWN") {
+      continue;
+    }
+    for (const auto& node_stats : dev_stats.node_stats()) {
+      auto it = name_to_node.find(node_stats.node_name());
+      if (it == name_to_node.end()) {
+        continue;
+      }
+      const NodeDef& node = *it->second;
+
+      std::vector<OpInfo::TensorProperties> inputs;
+      bool known_inputs = true;
+      for (const string& input : node.input()) {
+        if (IsControlInput(input)) {
+          break;
+        }
+        int position;
+        const string input_node = ParseNodeName(input, &position);
+        auto outputs_it = outputs.find(input_node);
+        if (outputs_it == outputs.end() ||
+            position >= outputs_it->second.size() ||
+            outputs_it->second[position].dtype() == DT_INVALID) {
+          // A dead input of a Merge node, or stats recorded without the
+          // outputs.
+          known_inputs = false;
+          break;
+        }
+        inputs.push_back(outputs_it->second[position]);
+      }
+      if (!known_inputs) {
+        continue;
+      }
+
+      OpPerformance perf;
+      perf.set_node(node.name());
+      *perf.mutable_op() = BuildOpInfoWithoutDevice(node, name_to_node, inputs);
+      *perf.mutable_op()->mutable_device() = device;
+      auto kernel_it = kernel_micros.find(node.name());
+      const int64 micros =
+          kernel_it != kernel_micros.end()
+              ? kernel_it->second
+              : node_stats.op_end_rel_micros() -
+                    node_stats.op_start_rel_micros();
+      // OpPerformance.compute_cost is in nanoseconds.
+      perf.set_compute_cost(std::max<int64>(0, micros) * 1000);
+      AddOpPerformance(perf);
+      ++num_recorded;
+    }
+  }
+  if (num_recorded == 0 && step_stats.dev_stats_size() > 0) {
+    return errors::InvalidArgument(
+        "None of the nodes in the step stats were found in the graph");
+  }
+  return Status::OK();
+}
+
+bool OpCalibrationDatabase::GetExecutionTime(
+    const OpInfo& op_info, Costs::Duration* execution_time) const {
+  auto it = entries_.find(CalibrationKey(op_info));
+  if (it == entries_.end() || it->second.empty()) {
+    return false;
+  }
+  std::vector<double> samples;
+  samples.reserve(it->second.size());
+  for (const auto& perf : it->second) {
+    samples.push_back(perf.compute_cost());
+  }
+  *execution_time = Costs::Duration(RobustStats(std::move(samples)).mean());
+  return true;
+}
+
+OpPerformanceList OpCalibrationDatabase::ToProto() const {
+  // Sort the ops so that the saved files are deterministic.
+  std::map<string, const std::deque<OpPerformance>*> sorted;
+  for (const auto& entry : entries_) {
+    sorted[entry.first] = &entry.second;
+  }
+  OpPerformanceList perfs;
+  for (const auto& entry : sorted) {
+    for (const auto& perf : *entry.second) {
+      *perfs.add_op_performance() = perf;
+    }
+  }
+  return perfs;
+}
+
+Status OpCalibrationDatabase::Load(const string& filename) {
+  OpPerformanceList perfs;
+  TF_RETURN_IF_ERROR(ReadBinaryProto(Env::Default(), filename, &perfs));
+  AddOpPerformanceList(perfs);
+  return Status::OK();
+}
+
+Status OpCalibrationDatabase::Save(const string& filename) const {
+  return WriteBinaryProto(Env::Default(), filename, ToProto());
+}
+
+Costs CalibratedOpLevelCostEstimator::PredictCosts(
+    const OpInfo& op_features) const {
+  Costs costs = OpLevelCostEstimator::PredictCosts(op_features);
+  Costs::Duration execution_time;
+  if (calibration_->GetExecutionTime(op_features, &execution_time)) {
+    // Keep the analytical compute and memory times, that show whether the op
+    // is compute or memory bound.
+    costs.execution_time = execution_time;
+    costs.inaccurate = false;
+  }
+  return costs;
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
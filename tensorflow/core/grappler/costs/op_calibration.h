@@ -0,0 +1,95 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_COSTS_OP_CALIBRATION_H_
+#define TENSORFLOW_GRAPPLER_COSTS_OP_CALIBRATION_H_
+
+#include <deque>
+#include <unordered_map>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
+#include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// The measured execution times of ops, indexed by the op, its attributes, the
+// types and shapes of its inputs, and the type and model of the device that
+// ran it. The measurements are stored as the data points of an
+// OpPerformanceList, so the calibrations of several runs can be merged.
+class OpCalibrationDatabase {
+ public:
+  // At most this many measurements are kept for each op, the most recent
+  // ones.
+  static constexpr int kMaxSamplesPerOp = 64;
+
+  OpCalibrationDatabase() {}
+
+  // Records the execution time of "perf.op()", which must be set along with
+  // "perf.compute_cost()".
+  void AddOpPerformance(const OpPerformance& perf);
+  void AddOpPerformanceList(const OpPerformanceList& perfs);
+
+  // Records the execution time of the nodes of "graph" in "step_stats",
+  // collected with RunOptions::FULL_TRACE. The time of a GPU node is the time
+  // of its kernels, and the time of other nodes the time spent in their
+  // Compute method. The nodes missing from "graph", such as those added by the
+  // graph partitioning, are ignored.
+  Status AddStepStats(const GraphDef& graph, const StepStats& step_stats);
+
+  // Returns true and sets "execution_time" to the robust mean of the
+  // measurements of "op_info" if there are any.
+  bool GetExecutionTime(const OpInfo& op_info,
+                        Costs::Duration* execution_time) const;
+
+  // Returns the measurements, so that they can be saved or merged.
+  OpPerformanceList ToProto() const;
+
+  // Adds the measurements of the binary OpPerformanceList in "filename".
+  Status Load(const string& filename);
+  Status Save(const string& filename) const;
+
+  // The number of measured ops.
+  int size() const { return entries_.size(); }
+
+ private:
+  std::unordered_map<string, std::deque<OpPerformance>> entries_;
+};
+
+// Predicts the cost of the ops measured in a calibration database from their
+// measured execution time, and falls back to the analytical estimates of
+// OpLevelCostEstimator for the other ops.
+class CalibratedOpLevelCostEstimator : public OpLevelCostEstimator {
+ public:
+  // Does not take ownership of "calibration".
+  explicit CalibratedOpLevelCostEstimator(
+      const OpCalibrationDatabase* calibration)
+      : calibration_(calibration) {}
+  ~CalibratedOpLevelCostEstimator() override {}
+
+  Costs PredictCosts(const OpInfo& op_features) const override;
+
+ private:
+  const OpCalibrationDatabase* calibration_;  // Not owned.
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_COSTS_OP_CALIBRATION_H_
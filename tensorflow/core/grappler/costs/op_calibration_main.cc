@@ -0,0 +1,132 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Records the execution times of ops measured in real runs into a calibration
+// file for CalibratedOpLevelCostEstimator, or merges calibration files.
+//
+// To record the step stats of RunMetadata protos collected with
+// RunOptions::FULL_TRACE from runs of a graph:
+//
+// bazel-bin/tensorflow/core/grappler/costs/op_calibration \
+//   --graph=graph.pbtxt --run_metadata=step1.pb,step2.pb \
+//   --output=calibration.pb
+//
+// The measurements are added to those already in the output file, if it
+// exists. To merge calibration files:
+//
+// bazel-bin/tensorflow/core/grappler/costs/op_calibration \
+//   --merge=gpu0.pb,gpu1.pb --output=calibration.pb
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/grappler/costs/op_calibration.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/protobuf/config.pb.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+Status ReadGraph(const string& filename, GraphDef* graph) {
+  if (ReadBinaryProto(Env::Default(), filename, graph).ok()) {
+    return Status::OK();
+  }
+  return ReadTextProto(Env::Default(), filename, graph);
+}
+
+Status UpdateCalibration(const string& graph_file,
+                         const std::vector<string>& run_metadata_files,
+                         const std::vector<string>& merge_files,
+                         const string& output_file) {
+  OpCalibrationDatabase calibration;
+  if (Env::Default()->FileExists(output_file).ok()) {
+    TF_RETURN_IF_ERROR(calibration.Load(output_file));
+  }
+  for (const string& filename : merge_files) {
+    TF_RETURN_IF_ERROR(calibration.Load(filename));
+  }
+  if (!run_metadata_files.empty()) {
+    GraphDef graph;
+    TF_RETURN_IF_ERROR(ReadGraph(graph_file, &graph));
+    for (const string& filename : run_metadata_files) {
+      RunMetadata run_metadata;
+      TF_RETURN_IF_ERROR(
+          ReadBinaryProto(Env::Default(), filename, &run_metadata));
+      TF_RETURN_IF_ERROR(
+          calibration.AddStepStats(graph, run_metadata.step_stats()));
+    }
+  }
+  LOG(INFO) << "Saving the calibration of " << calibration.size()
+            << " ops to " << output_file;
+  return calibration.Save(output_file);
+}
+
+int ParseFlagsAndUpdateCalibration(int argc, char* argv[]) {
+  string graph;
+  string run_metadata;
+  string merge;
+  string output;
+  std::vector<Flag> flag_list = {
+      Flag("graph", &graph, "the GraphDef that was run"),
+      Flag("run_metadata", &run_metadata,
+           "comma separated RunMetadata files with the step stats of the runs"),
+      Flag("merge", &merge, "comma separated calibration files to merge"),
+      Flag("output", &output,
+           "the calibration file, updated with the new measurements"),
+  };
+  string usage = Flags::Usage(argv[0], flag_list);
+
+  const bool parse_result = Flags::Parse(&argc, argv, flag_list);
+  // We need to call this to set up global state for TensorFlow.
+  port::InitMain(argv[0], &argc, &argv);
+
+  if (!parse_result) {
+    LOG(ERROR) << usage;
+    return -1;
+  }
+  if (argc > 1) {
+    LOG(ERROR) << "Unknown argument " << argv[1] << ".\n" << usage;
+    return -1;
+  }
+  if (output.empty()) {
+    LOG(ERROR) << "output can't be empty.\n" << usage;
+    return -1;
+  }
+  if (!run_metadata.empty() && graph.empty()) {
+    LOG(ERROR) << "graph is needed to record run_metadata.\n" << usage;
+    return -1;
+  }
+
+  Status status = UpdateCalibration(
+      graph, str_util::Split(run_metadata, ',', str_util::SkipEmpty()),
+      str_util::Split(merge, ',', str_util::SkipEmpty()), output);
+  if (!status.ok()) {
+    LOG(ERROR) << status.error_message() << "\n" << usage;
+    return -1;
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
+
+int main(int argc, char* argv[]) {
+  return tensorflow::grappler::ParseFlagsAndUpdateCalibration(argc, argv);
+}
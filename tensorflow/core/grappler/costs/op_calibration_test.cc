@@ -0,0 +1,178 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/op_calibration.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class OpCalibrationTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    NodeDef* x = graph_.add_node();
+    x->set_name("x");
+    x->set_op("Placeholder");
+    (*x->mutable_attr())["dtype"].set_type(DT_FLOAT);
+    NodeDef* y = graph_.add_node();
+    y->set_name("y");
+    y->set_op("MatMul");
+    y->add_input("x");
+    y->add_input("x:0");
+    (*y->mutable_attr())["T"].set_type(DT_FLOAT);
+    (*y->mutable_attr())["transpose_a"].set_b(false);
+    (*y->mutable_attr())["transpose_b"].set_b(true);
+  }
+
+  // Adds the stats of a run of "node" that took "micros" on "dev_stats".
+  NodeExecStats* AddNodeStats(const string& node, int64 micros,
+                              DeviceStepStats* dev_stats) {
+    NodeExecStats* node_stats = dev_stats->add_node_stats();
+    node_stats->set_node_name(node);
+    node_stats->set_op_start_rel_micros(5);
+    node_stats->set_op_end_rel_micros(5 + micros);
+    NodeOutput* output = node_stats->add_output();
+    output->set_slot(0);
+    output->mutable_tensor_description()->set_dtype(DT_FLOAT);
+    output->mutable_tensor_description()->mutable_shape()->add_dim()->set_size(
+        16);
+    output->mutable_tensor_description()->mutable_shape()->add_dim()->set_size(
+        16);
+    return node_stats;
+  }
+
+  StepStats CreateStepStats(const string& device, int64 micros) {
+    StepStats step_stats;
+    DeviceStepStats* dev_stats = step_stats.add_dev_stats();
+    dev_stats->set_device(device);
+    AddNodeStats("x", 1, dev_stats);
+    AddNodeStats("y", micros, dev_stats);
+    // Nodes added by the runtime aren't in the graph.
+    AddNodeStats("_SOURCE", 1, dev_stats);
+    return step_stats;
+  }
+
+  // Returns the OpInfo of "y" on "device".
+  OpInfo GetOpInfo(const string& device) {
+    OpInfo op_info;
+    op_info.set_op("MatMul");
+    *op_info.mutable_attr() = graph_.node(1).attr();
+    for (int i = 0; i < 2; ++i) {
+      OpInfo::TensorProperties* input = op_info.add_inputs();
+      input->set_dtype(DT_FLOAT);
+      input->mutable_shape()->add_dim()->set_size(16);
+      input->mutable_shape()->add_dim()->set_size(16);
+    }
+    *op_info.mutable_device() = GetDeviceInfo(device);
+    return op_info;
+  }
+
+  GraphDef graph_;
+};
+
+const char kCpu[] = "/job:localhost/replica:0/task:0/cpu:0";
+const char kGpu[] = "/job:localhost/replica:0/task:0/gpu:0";
+
+TEST_F(OpCalibrationTest, RecordsStepStats) {
+  OpCalibrationDatabase calibration;
+  TF_EXPECT_OK(calibration.AddStepStats(graph_, CreateStepStats(kCpu, 40)));
+  TF_EXPECT_OK(calibration.AddStepStats(graph_, CreateStepStats(kCpu, 40)));
+  EXPECT_EQ(2, calibration.size());
+
+  Costs::Duration execution_time;
+  ASSERT_TRUE(calibration.GetExecutionTime(GetOpInfo(kCpu), &execution_time));
+  EXPECT_EQ(40000, execution_time.count());
+
+  // The measurements depend on the attributes of the op.
+  OpInfo transposed = GetOpInfo(kCpu);
+  (*transposed.mutable_attr())["transpose_b"].set_b(false);
+  EXPECT_FALSE(calibration.GetExecutionTime(transposed, &execution_time));
+
+  GraphDef other_graph;
+  EXPECT_FALSE(
+      calibration.AddStepStats(other_graph, CreateStepStats(kCpu, 40)).ok());
+}
+
+TEST_F(OpCalibrationTest, PrefersKernelTimes) {
+  StepStats step_stats = CreateStepStats(kGpu, 40);
+  DeviceStepStats* stream_all = step_stats.add_dev_stats();
+  stream_all->set_device(strings::StrCat(kGpu, "/stream:all"));
+  DeviceStepStats* stream = step_stats.add_dev_stats();
+  stream->set_device(strings::StrCat(kGpu, "/stream:12"));
+  // The MatMul runs two kernels, recorded in both streams.
+  for (DeviceStepStats* dev_stats : {stream_all, stream}) {
+    for (int64 micros : {7, 3}) {
+      NodeExecStats* kernel_stats = dev_stats->add_node_stats();
+      kernel_stats->set_node_name("y:MatMul");
+      kernel_stats->set_op_end_rel_micros(micros);
+    }
+  }
+
+  OpCalibrationDatabase calibration;
+  TF_EXPECT_OK(calibration.AddStepStats(graph_, step_stats));
+  Costs::Duration execution_time;
+  ASSERT_TRUE(calibration.GetExecutionTime(GetOpInfo(kGpu), &execution_time));
+  EXPECT_EQ(10000, execution_time.count());
+  EXPECT_FALSE(calibration.GetExecutionTime(GetOpInfo(kCpu), &execution_time));
+}
+
+TEST_F(OpCalibrationTest, SavesAndMergesCalibrations) {
+  OpCalibrationDatabase calibration1;
+  OpCalibrationDatabase calibration2;
+  for (int i = 0; i < OpCalibrationDatabase::kMaxSamplesPerOp; ++i) {
+    TF_EXPECT_OK(calibration1.AddStepStats(graph_, CreateStepStats(kCpu, 10)));
+    TF_EXPECT_OK(calibration2.AddStepStats(graph_, CreateStepStats(kCpu, 30)));
+  }
+  const string filename =
+      io::JoinPath(testing::TmpDir(), "op_calibration_test.pb");
+  TF_ASSERT_OK(calibration2.Save(filename));
+
+  // Only the most recent measurements are kept.
+  TF_ASSERT_OK(calibration1.Load(filename));
+  Costs::Duration execution_time;
+  ASSERT_TRUE(calibration1.GetExecutionTime(GetOpInfo(kCpu), &execution_time));
+  EXPECT_EQ(30000, execution_time.count());
+  OpPerformanceList perfs = calibration1.ToProto();
+  EXPECT_EQ(2 * OpCalibrationDatabase::kMaxSamplesPerOp,
+            perfs.op_performance_size());
+}
+
+TEST_F(OpCalibrationTest, EstimatesFromCalibration) {
+  OpCalibrationDatabase calibration;
+  TF_EXPECT_OK(calibration.AddStepStats(graph_, CreateStepStats(kCpu, 40)));
+  CalibratedOpLevelCostEstimator estimator(&calibration);
+  OpLevelCostEstimator analytical_estimator;
+
+  Costs costs = estimator.PredictCosts(GetOpInfo(kCpu));
+  EXPECT_EQ(40000, costs.execution_time.count());
+  EXPECT_FALSE(costs.inaccurate);
+
+  // Falls back to the analytical estimates.
+  OpInfo other = GetOpInfo(kCpu);
+  other.mutable_inputs(0)->mutable_shape()->mutable_dim(0)->set_size(32);
+  EXPECT_EQ(analytical_estimator.PredictCosts(other).execution_time,
+            estimator.PredictCosts(other).execution_time);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
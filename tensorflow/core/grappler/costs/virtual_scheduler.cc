@@ -17,6 +17,8 @@ limitations under the License.
 
 #include <math.h>
 
+#include <deque>
+
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/grappler/clusters/utils.h"
@@ -71,6 +73,16 @@ VirtualScheduler::VirtualScheduler(const GrapplerItem* grappler_item,
   initialized_ = false;
 }
 
+VirtualScheduler::VirtualScheduler(const GrapplerItem* grappler_item,
+                                   const bool use_static_shapes,
+                                   Cluster* cluster,
+                                   ReadyNodeManager* ready_nodes)
+    : VirtualScheduler(grappler_item, use_static_shapes, cluster) {
+  if (ready_nodes != nullptr) {
+    ready_nodes_.reset(ready_nodes);
+  }
+}
+
 Status VirtualScheduler::Init() {
   // Init() preprocesses the input grappler_item and graph_properties to extract
   // necessary information for emulating tensorflow op scheduling and
@@ -108,6 +120,7 @@ Status VirtualScheduler::Init() {
 
   // Build node_map; for each node, create its NodeState and connect its inputs
   // and outputs.
+  std::vector<const NodeDef*> initial_nodes;
   for (const auto* curr_node : nodes) {
     auto& curr_node_state = GetNodeStateOrCreateIt(curr_node);
     const string curr_node_device = DeviceName(curr_node);
@@ -161,7 +174,7 @@ Status VirtualScheduler::Init() {
     if (curr_node->input().empty()) {
       // Node without input: ready at time 0.
       curr_node_state.time_ready = Costs::Duration();
-      ready_nodes_->AddNode(curr_node);
+      initial_nodes.push_back(curr_node);
     }
 
     if (IsPersistentNode(curr_node)) {
@@ -174,9 +187,15 @@ Status VirtualScheduler::Init() {
     }
   }
 
-  if (ready_nodes_->Empty()) {
+  if (initial_nodes.empty()) {
     return Status(error::UNAVAILABLE, "No ready nodes in the graph.");
   }
+  // The ReadyNodeManager may look at the whole graph, e.g. to prioritize the
+  // ready nodes.
+  ready_nodes_->Init(this);
+  for (const auto* node : initial_nodes) {
+    ready_nodes_->AddNode(node);
+  }
 
   initialized_ = true;
   return Status::OK();
@@ -308,8 +327,10 @@ std::pair<const NodeDef*, const NodeDef*> VirtualScheduler::CreateSendRecv(
 }
 
 NodeInfo VirtualScheduler::GetCurrNodeInfo() const {
-  const NodeDef* node = ready_nodes_->GetCurrNode();
+  return GetNodeInfo(ready_nodes_->GetCurrNode());
+}
 
+NodeInfo VirtualScheduler::GetNodeInfo(const NodeDef* node) const {
   // Get the device from the placer.
   DeviceProperties device;
   device = placer_.get_device(*node);
@@ -517,6 +538,7 @@ bool VirtualScheduler::MarkCurrNodeExecuted(const Costs& node_costs) {
       device.mem_usage_snapshot_at_peak = device.nodes_in_memory;
     }
   }
+  device.memory_usage_timeline.push_back(device.memory_usage);
 
   // Remove the current node; assume FIFO.
   ready_nodes_->RemoveCurrNode();
@@ -524,6 +546,41 @@ bool VirtualScheduler::MarkCurrNodeExecuted(const Costs& node_costs) {
   return !ready_nodes_->Empty();
 }
 
+int64 VirtualScheduler::GetMemoryFreedByExecuting(const NodeDef* node) const {
+  const auto& node_state = node_map_.at(node);
+  int64 freed = 0;
+  if (!IsPersistentNode(node)) {
+    for (const auto& port_num_output_pair : node_state.outputs) {
+      if (!port_num_output_pair.second.empty()) {
+        freed -= CalculateOutputSize(node_state.output_properties,
+                                     port_num_output_pair.first);
+      }
+    }
+  }
+  // The same output may be consumed several times by the node.
+  std::map<std::pair<const NodeDef*, int>, int> uses;
+  for (const auto& input_port : node_state.inputs) {
+    uses[input_port]++;
+  }
+  for (const auto& input_uses : uses) {
+    const auto* input = input_uses.first.first;
+    const int port = input_uses.first.second;
+    if (IsPersistentNode(input)) {
+      continue;
+    }
+    const auto& input_state = node_map_.at(input);
+    const auto executed = input_state.num_outputs_executed.find(port);
+    const int num_executed =
+        executed == input_state.num_outputs_executed.end() ? 0
+                                                            : executed->second;
+    if (num_executed + input_uses.second ==
+        input_state.outputs.at(port).size()) {
+      freed += CalculateOutputSize(input_state.output_properties, port);
+    }
+  }
+  return freed;
+}
+
 Costs VirtualScheduler::Summary() const {
   // Print out basic execution summary.
   VLOG(1) << "Expected execution time: " << graph_costs_.execution_time.count();
@@ -625,7 +682,9 @@ Costs VirtualScheduler::Summary(StepStats* stepstats) {
     for (const auto& device : device_) {
       DeviceStepStats* device_stepstats = stepstats->add_dev_stats();
       device_stepstats->set_device(device.first);
-      for (const auto& node_def : device.second.nodes_executed) {
+      const auto& nodes_executed = device.second.nodes_executed;
+      for (int i = 0; i < nodes_executed.size(); ++i) {
+        const NodeDef* node_def = nodes_executed[i];
         const NodeState& nodestate = node_map_.at(node_def);
         NodeExecStats* node_stats = device_stepstats->add_node_stats();
         node_stats->set_node_name(node_def->op());
@@ -639,11 +698,91 @@ Costs VirtualScheduler::Summary(StepStats* stepstats) {
         node_stats->set_all_end_rel_micros(
             nodestate.time_finished.asMicroSeconds().count() -
             nodestate.time_scheduled.asMicroSeconds().count());
+        AllocatorMemoryUsed* memory = node_stats->add_memory();
+        memory->set_allocator_name(device.first);
+        memory->set_allocator_bytes_in_use(
+            device.second.memory_usage_timeline[i]);
       }
     }
   }
   return Summary();
 }
 
+void CriticalPathManager::Init(const VirtualScheduler* scheduler) {
+  scheduler_ = scheduler;
+  critical_paths_.clear();
+  nodes_.clear();
+  curr_node_ = nodes_.end();
+
+  // Visits the graph from its last nodes: the critical path of a node is its
+  // own cost plus the longest critical path of its outputs.
+  const auto& node_states = scheduler->GetNodeStates();
+  std::unordered_map<const NodeDef*, int> num_outputs_pending;
+  std::unordered_map<const NodeDef*, Costs::Duration> longest_output_path;
+  std::deque<const NodeDef*> queue;
+  for (const auto& node_state : node_states) {
+    int num_outputs = 0;
+    for (const auto& port_num_output_pair : node_state.second.outputs) {
+      num_outputs += port_num_output_pair.second.size();
+    }
+    num_outputs_pending[node_state.first] = num_outputs;
+    if (num_outputs == 0) {
+      queue.push_back(node_state.first);
+    }
+  }
+  auto node_cost = [this](const NodeDef* node) {
+    return estimator_->PredictCosts(scheduler_->GetNodeInfo(node).op_info)
+        .execution_time;
+  };
+  while (!queue.empty()) {
+    const NodeDef* node = queue.front();
+    queue.pop_front();
+    const Costs::Duration path = node_cost(node) + longest_output_path[node];
+    critical_paths_[node] = path;
+    for (const auto& input_port : node_states.at(node).inputs) {
+      const NodeDef* input = input_port.first;
+      auto& longest = longest_output_path[input];
+      longest = std::max(longest, path);
+      if (--num_outputs_pending[input] == 0) {
+        queue.push_back(input);
+      }
+    }
+  }
+  // The nodes of loops are never visited: only count their own cost.
+  for (const auto& node_state : node_states) {
+    if (critical_paths_.find(node_state.first) == critical_paths_.end()) {
+      critical_paths_[node_state.first] = node_cost(node_state.first);
+    }
+  }
+}
+
+void CriticalPathManager::AddNode(const NodeDef* node) {
+  nodes_.emplace(critical_paths_.at(node), node);
+}
+
+const NodeDef* CriticalPathManager::GetCurrNode() {
+  if (curr_node_ == nodes_.end()) {
+    const auto range = nodes_.equal_range(nodes_.begin()->first);
+    curr_node_ = range.first;
+    int64 max_freed = scheduler_->GetMemoryFreedByExecuting(curr_node_->second);
+    for (auto it = std::next(range.first); it != range.second; ++it) {
+      const int64 freed = scheduler_->GetMemoryFreedByExecuting(it->second);
+      if (freed > max_freed) {
+        max_freed = freed;
+        curr_node_ = it;
+      }
+    }
+  }
+  return curr_node_->second;
+}
+
+void CriticalPathManager::RemoveCurrNode() {
+  if (curr_node_ == nodes_.end()) {
+    GetCurrNode();
+  }
+  nodes_.erase(curr_node_);
+  curr_node_ = nodes_.end();
+}
+
 }  // end namespace grappler
 }  // end namespace tensorflow
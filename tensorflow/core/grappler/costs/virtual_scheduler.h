@@ -17,6 +17,7 @@ limitations under the License.
 #define THIRD_PARTY_TENSORFLOW_CORE_GRAPPLER_COSTS_VIRTUAL_SCHEDULER_H_
 
 #include <list>
+#include <map>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
@@ -25,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/grappler/costs/cost_estimator.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
 #include "tensorflow/core/grappler/costs/virtual_placer.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 
@@ -105,6 +107,10 @@ struct DeviceState {
   std::unordered_set<std::pair<const NodeDef*, int>, NodePairHash>
       mem_usage_snapshot_at_peak;
 
+  // Memory usage, without the persistent nodes, after the execution of each
+  // node of nodes_executed: the simulated memory timeline of the device.
+  std::vector<int64> memory_usage_timeline;
+
   Costs device_costs;
   std::map<string, Costs> op_to_cost;    // Per-op cost.
   std::map<string, int64> op_to_memory;  // Per-op memory usage at peak usage.
@@ -120,12 +126,17 @@ struct DeviceState {
   Costs::Duration GetCurrTime() const { return device_costs.execution_time; }
 };
 
+class VirtualScheduler;
+
 // ReadyNodeManager (abstract class):
 // Keeps ready nodes and picks the best one to be scheduled.
 class ReadyNodeManager {
  public:
   ReadyNodeManager() {}
   virtual ~ReadyNodeManager() {}
+  // Called once the NodeStates of "scheduler" are built, before any node is
+  // added.
+  virtual void Init(const VirtualScheduler* scheduler) {}
   virtual void AddNode(const NodeDef* node) = 0;
   virtual const NodeDef* GetCurrNode() = 0;
   virtual void RemoveCurrNode() = 0;
@@ -179,6 +190,43 @@ class LIFOManager : public ReadyNodeManager {
   std::list<const NodeDef*>::iterator curr_pos_ = nodes_.end();
 };
 
+// The CriticalPathManager schedules first the ready node with the longest path
+// to the end of the graph, the critical path of the remaining nodes, using the
+// costs predicted by an OpLevelCostEstimator. Among the nodes with the same
+// critical path, such as nodes that take no time, it schedules first the one
+// that frees the most memory, then the first one added.
+class CriticalPathManager : public ReadyNodeManager {
+ public:
+  // Does not take ownership of "estimator".
+  explicit CriticalPathManager(const OpLevelCostEstimator* estimator)
+      : ReadyNodeManager(), estimator_(estimator) {}
+  ~CriticalPathManager() override {}
+  void Init(const VirtualScheduler* scheduler) override;
+  void AddNode(const NodeDef* node) override;
+  const NodeDef* GetCurrNode() override;
+  void RemoveCurrNode() override;
+  bool Empty() const override { return nodes_.empty(); }
+
+  // Returns the estimated time from the start of "node" to the end of the
+  // graph.
+  Costs::Duration GetCriticalPath(const NodeDef* node) const {
+    return critical_paths_.at(node);
+  }
+
+ private:
+  typedef std::multimap<Costs::Duration, const NodeDef*,
+                        std::greater<Costs::Duration>>
+      ReadyNodes;
+
+  const OpLevelCostEstimator* estimator_;  // Not owned.
+  const VirtualScheduler* scheduler_ = nullptr;  // Not owned.
+  std::unordered_map<const NodeDef*, Costs::Duration> critical_paths_;
+  ReadyNodes nodes_;
+  // The node returned by GetCurrNode, until it's removed: nodes may be added
+  // while it executes.
+  ReadyNodes::iterator curr_node_ = nodes_.end();
+};
+
 // A wrapper struct to OpInfo proto.
 // TODO(dyoon): once we extend OpInfo or implement a better interface, and  then
 // delete this wrapper struct.
@@ -194,25 +242,32 @@ class VirtualScheduler {
  public:
   VirtualScheduler(const GrapplerItem* grappler_item,
                    const bool use_static_shapes, Cluster* cluster);
+  // Like the above, but schedules the ready nodes in the order picked by
+  // "ready_nodes", which it takes ownership of, instead of FIFO if not null.
+  VirtualScheduler(const GrapplerItem* grappler_item,
+                   const bool use_static_shapes, Cluster* cluster,
+                   ReadyNodeManager* ready_nodes);
 
   // Initializes NodeState and DeviceState from grappler_item_ and
   // graph_properties_.
   Status Init();
 
   NodeInfo GetCurrNodeInfo() const;
+  NodeInfo GetNodeInfo(const NodeDef* node) const;
 
   // Returns true if there is any node to be scheduled.
   bool MarkCurrNodeExecuted(const Costs& node_costs);
 
   // Prints out summary of execution (timing, memory usage, etc.)
   Costs Summary() const;
-  // Like the above, but writes detailed stats to stepstats.
+  // Like the above, but writes detailed stats to stepstats, including the
+  // memory usage of the devices after each node in the allocator_bytes_in_use
+  // of the node's memory stats.
   // If stepstats is nullptr, then just calls and return Summary().
   Costs Summary(StepStats* stepstats);
 
- protected:
-  // GetDeviceStates and GetNodeStates are currently for testing purpuse only.
-  // Retrieves detailed scheduling results.
+  // Retrieves detailed scheduling results, such as the memory_usage_timeline
+  // of the devices, or the graph for ReadyNodeManagers.
   const std::unordered_map<string, DeviceState>& GetDeviceStates() const {
     return device_;
   }
@@ -220,6 +275,13 @@ class VirtualScheduler {
     return node_map_;
   }
 
+  // Returns how much the memory usage of the device of "node" would decrease
+  // if it was executed now: the size of the inputs that only it still uses
+  // minus the size of its outputs. Negative if it allocates more than it
+  // frees.
+  int64 GetMemoryFreedByExecuting(const NodeDef* node) const;
+
+ protected:
   // Returns the size of output at port_num (unit: bytes). A special case is
   // port_num -1, which is for control dependency and assumed to be 4 bytes.
   int64 CalculateOutputSize(
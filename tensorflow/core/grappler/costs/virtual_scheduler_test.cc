@@ -17,6 +17,7 @@ limitations under the License.
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
 #include "tensorflow/core/grappler/costs/virtual_placer.h"
+#include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -26,8 +27,10 @@ namespace grappler {
 class TestVirtualScheduler : public VirtualScheduler {
  public:
   TestVirtualScheduler(const GrapplerItem* grappler_item,
-                       const bool use_static_shapes, Cluster* cluster)
-      : VirtualScheduler(grappler_item, use_static_shapes, cluster) {}
+                       const bool use_static_shapes, Cluster* cluster,
+                       ReadyNodeManager* ready_nodes)
+      : VirtualScheduler(grappler_item, use_static_shapes, cluster,
+                         ready_nodes) {}
 
   FRIEND_TEST(VirtualSchedulerTest, CalculateOutputSize);
   FRIEND_TEST(VirtualSchedulerTest, MemoryUsage);
@@ -36,6 +39,23 @@ class TestVirtualScheduler : public VirtualScheduler {
   FRIEND_TEST(VirtualSchedulerTest, Variable);
 };
 
+// Returns cost based on op.
+class TestOpLevelCostEstimator : public OpLevelCostEstimator {
+ public:
+  Costs PredictCosts(const OpInfo& op_features) const override {
+    Costs c;
+    int64 exec_cost = 0;
+    if (op_features.op() == "MatMul") {
+      exec_cost = 2000000000;
+    }
+    if (op_features.op() == "RandomUniform") {
+      exec_cost = 1000000000;
+    }
+    c.execution_time = Costs::NanoSeconds(exec_cost);
+    return c;
+  }
+};
+
 class VirtualSchedulerTest : public ::testing::Test {
  protected:
   NodeDef node1_, node2_, node3_, node4_, node5_, node6_;
@@ -253,25 +273,81 @@ class VirtualSchedulerTest : public ::testing::Test {
     dependency_["z4"] = {"bn"};
   }
 
+  // Two chains of different lengths: "short" -> "out" and
+  // "long" -> "mm" -> "out".
+  void CreateGrapplerItemWithUnevenPaths() {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(kCPU0);
+    auto short_path =
+        tensorflow::ops::RandomUniform(s.WithOpName("short"), {10, 10},
+                                       DT_FLOAT);
+    auto long_path =
+        tensorflow::ops::RandomUniform(s.WithOpName("long"), {10, 10},
+                                       DT_FLOAT);
+    auto mm = tensorflow::ops::MatMul(s.WithOpName("mm"), long_path,
+                                      long_path);
+    auto out = tensorflow::ops::AddN(s.WithOpName("out"),
+                                     tensorflow::OutputList{short_path, mm});
+    GraphDef def;
+    TF_CHECK_OK(s.ToGraphDef(&def));
+
+    grappler_item_.reset(new GrapplerItem);
+    grappler_item_->id = "test_uneven_paths_graph";
+    grappler_item_->graph = def;
+    grappler_item_->fetch = {"out"};
+
+    dependency_["mm"] = {"long"};
+    dependency_["out"] = {"short", "mm"};
+  }
+
+  // "sb" frees the 100x100 output of "b" while "ia" only forwards "a".
+  void CreateGrapplerItemWithShapeAndIdentity() {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(kCPU0);
+    auto a = tensorflow::ops::RandomUniform(s.WithOpName("a"), {100, 100},
+                                            DT_FLOAT);
+    auto b = tensorflow::ops::RandomUniform(s.WithOpName("b"), {100, 100},
+                                            DT_FLOAT);
+    auto ia = tensorflow::ops::Identity(s.WithOpName("ia"), a);
+    auto sb = tensorflow::ops::Shape(s.WithOpName("sb"), b);
+    auto na = tensorflow::ops::Neg(s.WithOpName("na"), ia);
+    auto nb = tensorflow::ops::Neg(s.WithOpName("nb"), sb);
+    GraphDef def;
+    TF_CHECK_OK(s.ToGraphDef(&def));
+
+    grappler_item_.reset(new GrapplerItem);
+    grappler_item_->id = "test_shape_and_identity_graph";
+    grappler_item_->graph = def;
+    grappler_item_->fetch = {"na", "nb"};
+
+    dependency_["na"] = {"ia"};
+    dependency_["nb"] = {"sb"};
+  }
+
   // Call this after creating grappler_item_ and setting up dependency_.
-  void InitScheduler() {
+  // Schedules the ready nodes in FIFO order if ready_nodes is null.
+  void InitScheduler(ReadyNodeManager* ready_nodes = nullptr) {
     scheduler_.reset(new TestVirtualScheduler(
-        grappler_item_.get(), true /* use_static_shapes */, cluster_.get()));
+        grappler_item_.get(), true /* use_static_shapes */, cluster_.get(),
+        ready_nodes));
     TF_CHECK_OK(scheduler_->Init());
   }
 
-  // Returns cost based on op.
   Costs SimplePredictCosts(const NodeInfo& info) const {
-    Costs c;
-    int64 exec_cost = 0;
-    if (info.op_info.op() == "MatMul") {
-      exec_cost = 2000000000;
-    }
-    if (info.op_info.op() == "RandomUniform") {
-      exec_cost = 1000000000;
+    return estimator_.PredictCosts(info.op_info);
+  }
+
+  // Returns the names of the nodes executed on the CPU, in execution order.
+  std::vector<string> ExecutionOrder() const {
+    std::vector<string> names;
+    for (const auto* node :
+         scheduler_->GetDeviceStates().at(kCPU0).nodes_executed) {
+      names.push_back(node->name());
     }
-    c.execution_time = Costs::NanoSeconds(exec_cost);
-    return c;
+    return names;
+  }
+
+  // Returns the position of "name" in "names".
+  int Position(const std::vector<string>& names, const string& name) const {
+    return std::find(names.begin(), names.end(), name) - names.begin();
   }
 
   // Call this after init scheduler_. Scheduler stops after executing
@@ -375,6 +451,7 @@ class VirtualSchedulerTest : public ::testing::Test {
   // case.
   std::unique_ptr<GrapplerItem> grappler_item_;
   std::unique_ptr<TestVirtualScheduler> scheduler_;
+  TestOpLevelCostEstimator estimator_;
   // Node name -> its preceding nodes map for testing scheduling order.
   std::unordered_map<string, std::vector<string>> dependency_;
 
@@ -599,6 +676,43 @@ TEST_F(VirtualSchedulerTest, SummaryCostStepStatsTest) {
   }
 }
 
+// Test that CriticalPathManager returns the nodes with the longest expected
+// time to the end of the graph first.
+TEST_F(VirtualSchedulerTest, CriticalPathManagerPrefersLongestPath) {
+  CreateGrapplerItemWithUnevenPaths();
+  auto* manager = new CriticalPathManager(&estimator_);
+  InitScheduler(manager);
+
+  NodeMap node_map(&grappler_item_->graph);
+  EXPECT_EQ(Costs::NanoSeconds(3000000000),
+            manager->GetCriticalPath(node_map.GetNode("long")));
+  EXPECT_EQ(Costs::NanoSeconds(2000000000),
+            manager->GetCriticalPath(node_map.GetNode("mm")));
+  EXPECT_EQ(Costs::NanoSeconds(1000000000),
+            manager->GetCriticalPath(node_map.GetNode("short")));
+  EXPECT_EQ(Costs::Duration(),
+            manager->GetCriticalPath(node_map.GetNode("out")));
+
+  RunScheduler("");
+  // FIFO would run "short" first.
+  const std::vector<string> order = ExecutionOrder();
+  EXPECT_LT(Position(order, "long"), Position(order, "short"));
+  EXPECT_LT(Position(order, "mm"), Position(order, "short"));
+}
+
+// Test that CriticalPathManager picks the node that frees the most memory
+// among the nodes with the same critical path.
+TEST_F(VirtualSchedulerTest, CriticalPathManagerPrefersFreeingMemory) {
+  CreateGrapplerItemWithShapeAndIdentity();
+  InitScheduler(new CriticalPathManager(&estimator_));
+
+  RunScheduler("");
+  const std::vector<string> order = ExecutionOrder();
+  EXPECT_LT(Position(order, "sb"), Position(order, "ia"));
+  EXPECT_LT(Position(order, "nb"), Position(order, "ia"));
+  EXPECT_EQ(6 + 2 /* shapes */, order.size());
+}
+
 TEST_F(VirtualSchedulerTest, InitAndBasicScheduling) {
   // Init.
   CreateGrapplerItemWithConv2Ds();
@@ -683,6 +797,33 @@ TEST_F(VirtualSchedulerTest, MemoryUsage) {
                               cpu_state.mem_usage_snapshot_at_peak);
 }
 
+TEST_F(VirtualSchedulerTest, MemoryUsageTimeline) {
+  CreateGrapplerItemWithAddN();
+  InitScheduler();
+  RunScheduler("");
+
+  const auto& cpu_state = scheduler_->GetDeviceStates().at(kCPU0);
+  const auto& timeline = cpu_state.memory_usage_timeline;
+  ASSERT_EQ(cpu_state.nodes_executed.size(), timeline.size());
+  EXPECT_EQ(cpu_state.max_memory_usage,
+            *std::max_element(timeline.begin(), timeline.end()));
+  // Executing out frees all the inputs, and nothing consumes its output.
+  EXPECT_EQ("out", cpu_state.nodes_executed.back()->name());
+  EXPECT_EQ(0, timeline.back());
+
+  StepStats stepstats;
+  scheduler_->Summary(&stepstats);
+  ASSERT_EQ(1, stepstats.dev_stats_size());
+  const auto& node_stats = stepstats.dev_stats(0).node_stats();
+  ASSERT_EQ(timeline.size(), node_stats.size());
+  for (int i = 0; i < node_stats.size(); ++i) {
+    ASSERT_EQ(1, node_stats.Get(i).memory_size());
+    EXPECT_EQ(kCPU0, node_stats.Get(i).memory(0).allocator_name());
+    EXPECT_EQ(timeline[i],
+              node_stats.Get(i).memory(0).allocator_bytes_in_use());
+  }
+}
+
 TEST_F(VirtualSchedulerTest, ControlDependency) {
   // Init.
   CreateGrapplerItemWithControlDependency();
@@ -24,8 +24,12 @@ namespace grappler {
 bool IsConcat(const NodeDef& node);
 bool IsConstant(const NodeDef& node);
 bool IsDequeueOp(const NodeDef& node);
+bool IsEnter(const NodeDef& node);
+bool IsExit(const NodeDef& node);
 bool IsIdentity(const NodeDef& node);
+bool IsLoopCond(const NodeDef& node);
 bool IsMerge(const NodeDef& node);
+bool IsNextIteration(const NodeDef& node);
 bool IsNoOp(const NodeDef& node);
 bool IsPlaceholder(const NodeDef& node);
 bool IsRecv(const NodeDef& node);
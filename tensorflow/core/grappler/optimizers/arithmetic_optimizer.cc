@@ -0,0 +1,692 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+bool IsControlFlow(const NodeDef& node) {
+  static const std::unordered_set<string>* control_flow_ops =
+      new std::unordered_set<string>(
+          {"Enter", "RefEnter", "Exit", "RefExit", "NextIteration",
+           "RefNextIteration", "Merge", "RefMerge", "Switch", "RefSwitch",
+           "LoopCond", "ControlTrigger"});
+  return control_flow_ops->count(node.op()) > 0;
+}
+
+// Returns true if the order of the data inputs of "node" doesn't matter.
+bool IsCommutative(const NodeDef& node) {
+  static const std::unordered_set<string>* commutative_ops =
+      new std::unordered_set<string>({"Add", "AddN", "Mul", "Maximum",
+                                      "Minimum", "LogicalAnd", "LogicalOr",
+                                      "Equal", "NotEqual"});
+  if (commutative_ops->count(node.op()) == 0) {
+    return false;
+  }
+  // Adding strings concatenates them.
+  auto it = node.attr().find("T");
+  return it == node.attr().end() || it->second.type() != DT_STRING;
+}
+
+// The data inputs of a node, sorted if it is commutative, followed by its
+// sorted control inputs, so that equivalent nodes have equal signatures.
+std::vector<string> InputSignature(const NodeDef& node) {
+  std::vector<string> inputs;
+  std::vector<string> controls;
+  for (const string& input : node.input()) {
+    int position;
+    const string name = ParseNodeName(input, &position);
+    if (position < 0) {
+      controls.push_back(name);
+    } else {
+      inputs.push_back(strings::StrCat(name, ":", position));
+    }
+  }
+  if (IsCommutative(node)) {
+    std::sort(inputs.begin(), inputs.end());
+  }
+  std::sort(controls.begin(), controls.end());
+  controls.erase(std::unique(controls.begin(), controls.end()),
+                 controls.end());
+  inputs.push_back("^");
+  inputs.insert(inputs.end(), controls.begin(), controls.end());
+  return inputs;
+}
+
+bool SameAttrs(const NodeDef& a, const NodeDef& b) {
+  if (a.attr_size() != b.attr_size()) {
+    return false;
+  }
+  for (const auto& attr : a.attr()) {
+    auto it = b.attr().find(attr.first);
+    if (it == b.attr().end() || !AreAttrValuesEqual(attr.second, it->second)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the name of the "position" output of "node", or of a control
+// dependency on it if "position" is negative.
+string OutputName(const string& node, int position) {
+  if (position < 0) {
+    return strings::StrCat("^", node);
+  }
+  if (position == 0) {
+    return node;
+  }
+  return strings::StrCat(node, ":", position);
+}
+
+bool GetVectorConst(const NodeDef& node, std::vector<int64>* values) {
+  if (!IsConstant(node) || node.attr().count("value") == 0) {
+    return false;
+  }
+  Tensor tensor;
+  if (!tensor.FromProto(node.attr().at("value").tensor()) ||
+      tensor.dims() != 1) {
+    return false;
+  }
+  values->clear();
+  if (tensor.dtype() == DT_INT32) {
+    for (int64 i = 0; i < tensor.NumElements(); ++i) {
+      values->push_back(tensor.vec<int32>()(i));
+    }
+  } else if (tensor.dtype() == DT_INT64) {
+    for (int64 i = 0; i < tensor.NumElements(); ++i) {
+      values->push_back(tensor.vec<int64>()(i));
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Returns true if every value of type "from" can be cast to type "to" and
+// back unchanged.
+bool IsLosslessCast(DataType from, DataType to) {
+  static const std::unordered_map<int, std::vector<DataType>>* lossless =
+      new std::unordered_map<int, std::vector<DataType>>({
+          {DT_BOOL,
+           {DT_UINT8, DT_INT8, DT_UINT16, DT_INT16, DT_INT32, DT_INT64,
+            DT_HALF, DT_FLOAT, DT_DOUBLE}},
+          {DT_UINT8,
+           {DT_UINT16, DT_INT16, DT_INT32, DT_INT64, DT_HALF, DT_FLOAT,
+            DT_DOUBLE}},
+          {DT_INT8,
+           {DT_INT16, DT_INT32, DT_INT64, DT_HALF, DT_FLOAT, DT_DOUBLE}},
+          {DT_UINT16, {DT_INT32, DT_INT64, DT_FLOAT, DT_DOUBLE}},
+          {DT_INT16, {DT_INT32, DT_INT64, DT_FLOAT, DT_DOUBLE}},
+          {DT_INT32, {DT_INT64, DT_DOUBLE}},
+          {DT_HALF, {DT_FLOAT, DT_DOUBLE}},
+          {DT_FLOAT, {DT_DOUBLE}},
+      });
+  auto it = lossless->find(from);
+  return it != lossless->end() &&
+         std::find(it->second.begin(), it->second.end(), to) !=
+             it->second.end();
+}
+
+bool HasControlInputs(const NodeDef& node) {
+  for (const string& input : node.input()) {
+    if (IsControlInput(input)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool IsStateful(const NodeDef& node) {
+  const OpDef* op_def = nullptr;
+  return !OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() ||
+         op_def->is_stateful();
+}
+
+bool HasRefOutput(const NodeDef& node) {
+  const OpDef* op_def = nullptr;
+  if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok()) {
+    return true;
+  }
+  for (const auto& arg : op_def->output_arg()) {
+    if (arg.is_ref()) return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+bool ArithmeticOptimizer::CanDedup(const NodeDef& node) const {
+  if (nodes_to_preserve_.count(node.name()) > 0 || IsPlaceholder(node) ||
+      IsControlFlow(node)) {
+    return false;
+  }
+  const OpDef* op_def = nullptr;
+  if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() ||
+      op_def->is_stateful()) {
+    return false;
+  }
+  // Nodes that read or produce references may see different values.
+  for (const auto& arg : op_def->input_arg()) {
+    if (arg.is_ref()) return false;
+  }
+  for (const auto& arg : op_def->output_arg()) {
+    if (arg.is_ref()) return false;
+  }
+  return true;
+}
+
+void ArithmeticOptimizer::DedupComputations(GraphDef* graph) {
+  // The graph is sorted, so the inputs of a node are deduplicated before the
+  // node itself, and a single pass finds the chains of duplicates.
+  std::unordered_map<string, string> replacements;
+  auto rename_inputs = [&replacements](NodeDef* node) {
+    for (string& input : *node->mutable_input()) {
+      int position;
+      const string name = ParseNodeName(input, &position);
+      auto it = replacements.find(name);
+      if (it != replacements.end()) {
+        input = OutputName(it->second, position);
+      }
+    }
+  };
+  std::unordered_map<uint64, std::vector<const NodeDef*>> representatives;
+  for (int i = 0; i < graph->node_size(); ++i) {
+    NodeDef* node = graph->mutable_node(i);
+    rename_inputs(node);
+    if (!CanDedup(*node)) {
+      continue;
+    }
+    const std::vector<string> signature = InputSignature(*node);
+    uint64 hash = Hash64Combine(Hash64(node->op()), Hash64(node->device()));
+    for (const string& input : signature) {
+      hash = Hash64Combine(hash, Hash64(input));
+    }
+    std::vector<const NodeDef*>& candidates = representatives[hash];
+    const NodeDef* representative = nullptr;
+    for (const NodeDef* candidate : candidates) {
+      if (candidate->op() == node->op() &&
+          candidate->device() == node->device() &&
+          InputSignature(*candidate) == signature &&
+          SameAttrs(*candidate, *node)) {
+        representative = candidate;
+        break;
+      }
+    }
+    if (representative == nullptr) {
+      candidates.push_back(node);
+    } else {
+      replacements[node->name()] = representative->name();
+    }
+  }
+  if (replacements.empty()) {
+    return;
+  }
+
+  GraphDef deduped;
+  for (NodeDef& node : *graph->mutable_node()) {
+    if (replacements.count(node.name()) == 0) {
+      // Loops make the inputs of some nodes come later in the graph.
+      rename_inputs(&node);
+      deduped.add_node()->Swap(&node);
+    }
+  }
+  VLOG(1) << "Removed " << replacements.size() << " duplicated nodes.";
+  graph->mutable_node()->Swap(deduped.mutable_node());
+}
+
+NodeDef* ArithmeticOptimizer::GetSimpleInput(const NodeDef& node, int input,
+                                             const string& op) {
+  if (node.input_size() <= input || IsControlInput(node.input(input))) {
+    return nullptr;
+  }
+  int position;
+  NodeDef* producer =
+      node_map_->GetNode(ParseNodeName(node.input(input), &position));
+  if (producer == nullptr || producer->op() != op || position != 0 ||
+      HasControlInputs(*producer)) {
+    return nullptr;
+  }
+  return producer;
+}
+
+void ArithmeticOptimizer::ForwardOutputs(const NodeDef& node,
+                                         const string& input) {
+  const string input_node = NodeName(input);
+  // Copy the consumers, since they are added to the outputs of the input.
+  const std::set<NodeDef*> consumers = node_map_->GetOutputs(node.name());
+  for (NodeDef* consumer : consumers) {
+    bool changed = false;
+    for (string& consumer_input : *consumer->mutable_input()) {
+      int position;
+      if (ParseNodeName(consumer_input, &position) != node.name()) {
+        continue;
+      }
+      // Only the first output is forwarded, and a control dependency on the
+      // node becomes a control dependency on its input.
+      if (position > 0) {
+        continue;
+      }
+      consumer_input = position < 0 ? OutputName(input_node, -1) : input;
+      changed = true;
+    }
+    if (changed) {
+      node_map_->AddOutput(input_node, consumer->name());
+    }
+  }
+  maybe_unused_.insert(node.name());
+}
+
+void ArithmeticOptimizer::ReplaceWithIdentity(NodeDef* node,
+                                              const string& input,
+                                              DataType type) {
+  std::vector<string> control_inputs;
+  for (const string& node_input : node->input()) {
+    if (IsControlInput(node_input)) {
+      control_inputs.push_back(node_input);
+    } else {
+      maybe_unused_.insert(NodeName(node_input));
+    }
+  }
+  node->set_op("Identity");
+  node->clear_input();
+  node->add_input(input);
+  for (const string& control_input : control_inputs) {
+    node->add_input(control_input);
+  }
+  node->mutable_attr()->clear();
+  (*node->mutable_attr())["T"].set_type(type);
+  node_map_->AddOutput(NodeName(input), node->name());
+  RemoveIdentity(node);
+}
+
+bool ArithmeticOptimizer::RemoveIdentity(NodeDef* node) {
+  if (node->op() != "Identity" || node->input_size() != 1 ||
+      IsControlInput(node->input(0)) ||
+      nodes_to_preserve_.count(node->name()) > 0) {
+    return false;
+  }
+  const NodeDef* producer = node_map_->GetNode(NodeName(node->input(0)));
+  // Identities move tensors across devices, take snapshots of variables and
+  // serve as the pivots of conditionals and loops.
+  if (producer == nullptr || producer->device() != node->device() ||
+      IsVariable(*producer) || HasRefOutput(*producer) ||
+      IsControlFlow(*producer)) {
+    return false;
+  }
+  ForwardOutputs(*node, node->input(0));
+  return true;
+}
+
+bool ArithmeticOptimizer::RemoveInvolution(NodeDef* node) {
+  static const std::unordered_set<string>* involutions =
+      new std::unordered_set<string>({"Neg", "Conj", "LogicalNot", "Invert"});
+  if (involutions->count(node->op()) == 0) {
+    return false;
+  }
+  const NodeDef* inner = GetSimpleInput(*node, 0, node->op());
+  if (inner == nullptr || inner->input_size() != 1) {
+    return false;
+  }
+  const DataType type = node->op() == "LogicalNot"
+                            ? DT_BOOL
+                            : node->attr().at("T").type();
+  ReplaceWithIdentity(node, inner->input(0), type);
+  return true;
+}
+
+bool ArithmeticOptimizer::FoldTransposes(NodeDef* node) {
+  if (!IsTranspose(*node) || node->input_size() < 2) {
+    return false;
+  }
+  const NodeDef* inner = GetSimpleInput(*node, 0, "Transpose");
+  if (inner == nullptr || inner->input_size() != 2) {
+    return false;
+  }
+  const NodeDef* outer_perm_node = node_map_->GetNode(NodeName(node->input(1)));
+  const NodeDef* inner_perm_node =
+      node_map_->GetNode(NodeName(inner->input(1)));
+  std::vector<int64> outer_perm;
+  std::vector<int64> inner_perm;
+  if (outer_perm_node == nullptr || inner_perm_node == nullptr ||
+      !GetVectorConst(*outer_perm_node, &outer_perm) ||
+      !GetVectorConst(*inner_perm_node, &inner_perm) ||
+      outer_perm.size() != inner_perm.size()) {
+    return false;
+  }
+  // Transposing x by p and then by q gives z[i] = x[p[q[i]]].
+  const int rank = outer_perm.size();
+  Tensor perm(DT_INT32, TensorShape({rank}));
+  bool is_identity = true;
+  for (int i = 0; i < rank; ++i) {
+    if (outer_perm[i] < 0 || outer_perm[i] >= rank ||
+        inner_perm[i] < 0 || inner_perm[i] >= rank) {
+      return false;
+    }
+    perm.vec<int32>()(i) = inner_perm[outer_perm[i]];
+    is_identity &= perm.vec<int32>()(i) == i;
+  }
+  if (is_identity) {
+    ReplaceWithIdentity(node, inner->input(0), node->attr().at("T").type());
+    return true;
+  }
+
+  const string perm_name =
+      strings::StrCat(node->name(), "/", kArithmeticOptimizer, "/perm");
+  if (node_map_->GetNode(perm_name) != nullptr) {
+    return false;
+  }
+  NodeDef* perm_node = graph_.add_node();
+  perm_node->set_name(perm_name);
+  perm_node->set_op("Const");
+  perm_node->set_device(node->device());
+  (*perm_node->mutable_attr())["dtype"].set_type(DT_INT32);
+  perm.AsProtoTensorContent(
+      (*perm_node->mutable_attr())["value"].mutable_tensor());
+  node_map_->AddNode(perm_name, perm_node);
+
+  maybe_unused_.insert(inner->name());
+  maybe_unused_.insert(outer_perm_node->name());
+  node->set_input(0, inner->input(0));
+  node->set_input(1, perm_name);
+  (*node->mutable_attr())["Tperm"].set_type(DT_INT32);
+  node_map_->AddOutput(NodeName(node->input(0)), node->name());
+  node_map_->AddOutput(perm_name, node->name());
+  return true;
+}
+
+bool ArithmeticOptimizer::FoldReshapes(NodeDef* node) {
+  if (node->op() != "Reshape" || node->input_size() < 2) {
+    return false;
+  }
+  // Only the final shape matters.
+  const NodeDef* inner = GetSimpleInput(*node, 0, "Reshape");
+  if (inner == nullptr || inner->input_size() != 2) {
+    return false;
+  }
+  maybe_unused_.insert(inner->name());
+  node->set_input(0, inner->input(0));
+  node_map_->AddOutput(NodeName(node->input(0)), node->name());
+  return true;
+}
+
+bool ArithmeticOptimizer::FoldCasts(NodeDef* node) {
+  if (node->op() != "Cast" || node->input_size() < 1) {
+    return false;
+  }
+  const NodeDef* inner = GetSimpleInput(*node, 0, "Cast");
+  if (inner == nullptr || inner->input_size() != 1) {
+    return false;
+  }
+  // Casting to a type that represents all the values of the input exactly,
+  // and then to another type, is the same as casting to the latter.
+  const DataType src_type = inner->attr().at("SrcT").type();
+  const DataType dst_type = node->attr().at("DstT").type();
+  if (!IsLosslessCast(src_type, inner->attr().at("DstT").type())) {
+    return false;
+  }
+  if (src_type == dst_type) {
+    ReplaceWithIdentity(node, inner->input(0), src_type);
+    return true;
+  }
+  maybe_unused_.insert(inner->name());
+  node->set_input(0, inner->input(0));
+  (*node->mutable_attr())["SrcT"].set_type(src_type);
+  node_map_->AddOutput(NodeName(node->input(0)), node->name());
+  return true;
+}
+
+bool ArithmeticOptimizer::HoistCommonFactor(NodeDef* node) {
+  if (node->op() != "AddN" || node->input_size() < 2) {
+    return false;
+  }
+  // All the data inputs must be products only used by this node.
+  std::vector<const NodeDef*> products;
+  for (int i = 0; i < node->input_size() && !IsControlInput(node->input(i));
+       ++i) {
+    const NodeDef* product = GetSimpleInput(*node, i, "Mul");
+    if (product == nullptr || product->input_size() != 2 ||
+        nodes_to_preserve_.count(product->name()) > 0 ||
+        node_map_->GetOutputs(product->name()).size() != 1) {
+      return false;
+    }
+    products.push_back(product);
+  }
+  if (products.size() < 2) {
+    return false;
+  }
+  string common_factor;
+  for (int i = 0; i < 2 && common_factor.empty(); ++i) {
+    const string& candidate = products[0]->input(i);
+    bool is_common = true;
+    for (const NodeDef* product : products) {
+      is_common &= IsSameInput(product->input(0), candidate) ||
+                   IsSameInput(product->input(1), candidate);
+    }
+    if (is_common) {
+      common_factor = candidate;
+    }
+  }
+  if (common_factor.empty()) {
+    return false;
+  }
+  std::vector<string> factors;
+  for (const NodeDef* product : products) {
+    factors.push_back(IsSameInput(product->input(0), common_factor)
+                          ? product->input(1)
+                          : product->input(0));
+  }
+
+  // AddN requires all the other factors to have the same shape, which must
+  // then be the shape of the products.
+  if (!has_properties_) {
+    has_properties_ = true;
+    properties_.reset(new GraphProperties(*item_));
+    if (!properties_->InferStatically().ok()) {
+      properties_.reset();
+    }
+  }
+  if (properties_ == nullptr) {
+    return false;
+  }
+  TensorShapeProto shape;
+  for (int i = 0; i < factors.size(); ++i) {
+    int position;
+    const string name = ParseNodeName(factors[i], &position);
+    if (!properties_->HasOutputProperties(name)) {
+      return false;
+    }
+    const auto outputs = properties_->GetOutputProperties(name);
+    if (position >= outputs.size()) {
+      return false;
+    }
+    const TensorShapeProto& factor_shape = outputs[position].shape();
+    if (factor_shape.unknown_rank()) {
+      return false;
+    }
+    for (const auto& dim : factor_shape.dim()) {
+      if (dim.size() < 0) {
+        return false;
+      }
+    }
+    if (i == 0) {
+      shape = factor_shape;
+    } else if (shape.dim_size() != factor_shape.dim_size()) {
+      return false;
+    } else {
+      for (int d = 0; d < shape.dim_size(); ++d) {
+        if (shape.dim(d).size() != factor_shape.dim(d).size()) {
+          return false;
+        }
+      }
+    }
+  }
+
+  const string sum_name =
+      strings::StrCat(node->name(), "/", kArithmeticOptimizer, "/AddN");
+  if (node_map_->GetNode(sum_name) != nullptr) {
+    return false;
+  }
+  NodeDef* sum = graph_.add_node();
+  sum->set_name(sum_name);
+  sum->set_op("AddN");
+  sum->set_device(node->device());
+  for (const string& factor : factors) {
+    sum->add_input(factor);
+  }
+  *sum->mutable_attr() = node->attr();
+  node_map_->AddNode(sum_name, sum);
+  for (const string& factor : factors) {
+    node_map_->AddOutput(NodeName(factor), sum_name);
+  }
+
+  // The AddN node becomes the product, which keeps its consumers.
+  std::vector<string> control_inputs;
+  for (const string& input : node->input()) {
+    if (IsControlInput(input)) {
+      control_inputs.push_back(input);
+    }
+  }
+  for (const NodeDef* product : products) {
+    maybe_unused_.insert(product->name());
+  }
+  const AttrValue type = node->attr().at("T");
+  node->set_op("Mul");
+  node->clear_input();
+  node->add_input(sum_name);
+  node->add_input(common_factor);
+  for (const string& control_input : control_inputs) {
+    node->add_input(control_input);
+  }
+  node->mutable_attr()->clear();
+  (*node->mutable_attr())["T"] = type;
+  node_map_->AddOutput(sum_name, node->name());
+  node_map_->AddOutput(NodeName(common_factor), node->name());
+  return true;
+}
+
+bool ArithmeticOptimizer::SimplifyNode(NodeDef* node) {
+  return RemoveIdentity(node) || RemoveInvolution(node) ||
+         FoldTransposes(node) || FoldReshapes(node) || FoldCasts(node) ||
+         HoistCommonFactor(node);
+}
+
+void ArithmeticOptimizer::PruneUnused(const GraphDef& graph,
+                                      GraphDef* optimized_graph) {
+  std::unordered_map<string, int> num_consumers;
+  std::unordered_map<string, const NodeDef*> nodes;
+  for (const NodeDef& node : graph.node()) {
+    nodes[node.name()] = &node;
+    for (const string& input : node.input()) {
+      ++num_consumers[NodeName(input)];
+    }
+  }
+  std::unordered_set<string> removed;
+  std::vector<string> queue(maybe_unused_.begin(), maybe_unused_.end());
+  while (!queue.empty()) {
+    const string name = queue.back();
+    queue.pop_back();
+    auto it = nodes.find(name);
+    if (it == nodes.end() || removed.count(name) > 0 ||
+        num_consumers[name] > 0 || nodes_to_preserve_.count(name) > 0 ||
+        IsStateful(*it->second) || IsPlaceholder(*it->second) ||
+        IsControlFlow(*it->second)) {
+      continue;
+    }
+    removed.insert(name);
+    for (const string& input : it->second->input()) {
+      const string input_name = NodeName(input);
+      if (--num_consumers[input_name] == 0) {
+        queue.push_back(input_name);
+      }
+    }
+  }
+  for (const NodeDef& node : graph.node()) {
+    if (removed.count(node.name()) == 0) {
+      *optimized_graph->add_node() = node;
+    }
+  }
+  VLOG(1) << "Removed " << removed.size() << " unused nodes.";
+}
+
+Status ArithmeticOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                     GraphDef* optimized_graph) {
+  graph_ = item.graph;
+  item_ = &item;
+  properties_.reset();
+  has_properties_ = false;
+  nodes_to_preserve_.clear();
+  maybe_unused_.clear();
+  for (const auto& node : item.fetch) {
+    nodes_to_preserve_.insert(NodeName(node));
+  }
+  for (const auto& node : item.feed) {
+    nodes_to_preserve_.insert(NodeName(node.first));
+  }
+  for (const auto& node : item.init_ops) {
+    nodes_to_preserve_.insert(NodeName(node));
+  }
+
+  TopologicalSort(&graph_);
+  DedupComputations(&graph_);
+
+  // Simplify the nodes in topological order, so that chains are folded one
+  // node at a time. The nodes added by the rewrites don't need to be
+  // simplified.
+  node_map_.reset(new NodeMap(&graph_));
+  int num_simplified = 0;
+  const int num_nodes = graph_.node_size();
+  for (int i = 0; i < num_nodes; ++i) {
+    if (SimplifyNode(graph_.mutable_node(i))) {
+      ++num_simplified;
+    }
+  }
+  VLOG(1) << "Simplified " << num_simplified << " nodes.";
+
+  *optimized_graph = GraphDef();
+  PruneUnused(graph_, optimized_graph);
+  *optimized_graph->mutable_library() = item.graph.library();
+  *optimized_graph->mutable_versions() = item.graph.versions();
+
+  node_map_.reset();
+  properties_.reset();
+  item_ = nullptr;
+  return Status::OK();
+}
+
+void ArithmeticOptimizer::Feedback(Cluster* cluster, const GrapplerItem& item,
+                                   const GraphDef& optimized_graph,
+                                   double result) {
+  // Nothing to do for ArithmeticOptimizer.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
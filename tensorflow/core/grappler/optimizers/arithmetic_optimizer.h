@@ -0,0 +1,91 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_ARITHMETIC_OPTIMIZER_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_ARITHMETIC_OPTIMIZER_H_
+
+#include <memory>
+#include <unordered_set>
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+#include "tensorflow/core/grappler/utils.h"
+
+namespace tensorflow {
+namespace grappler {
+
+const char kArithmeticOptimizer[] = "ArithmeticOptimizer";
+
+// Removes the redundant arithmetic of a graph:
+//  * Common subexpressions: stateless nodes that compute the same op with the
+//    same attributes on the same inputs and device are merged.
+//  * Chains of Reshape, Transpose and lossless Cast nodes are folded into a
+//    single node, or removed when they cancel out, as are pairs of
+//    involutions such as Neg(Neg(x)).
+//  * AddN(a * x, b * x, ...) becomes AddN(a, b, ...) * x when the a, b, ...
+//    have the same static shape.
+//  * Identity nodes that neither cross devices nor follow control flow ops
+//    are bypassed.
+// Nodes that are fed or fetched are never removed.
+class ArithmeticOptimizer : public GraphOptimizer {
+ public:
+  ArithmeticOptimizer() {}
+  ~ArithmeticOptimizer() override {}
+
+  string name() const override { return "arithmetic_optimizer"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+
+ private:
+  bool CanDedup(const NodeDef& node) const;
+  void DedupComputations(GraphDef* graph);
+
+  // Rewrites "node", whose consumers are left unchanged, and returns true if
+  // anything changed.
+  bool SimplifyNode(NodeDef* node);
+  bool RemoveIdentity(NodeDef* node);
+  bool FoldTransposes(NodeDef* node);
+  bool FoldReshapes(NodeDef* node);
+  bool FoldCasts(NodeDef* node);
+  bool RemoveInvolution(NodeDef* node);
+  bool HoistCommonFactor(NodeDef* node);
+
+  // Returns the node producing the only data input of "node" if it is an
+  // "op" node without control inputs, and nullptr otherwise.
+  NodeDef* GetSimpleInput(const NodeDef& node, int input, const string& op);
+  // Turns "node" into an identity of "input", and bypasses it if possible.
+  void ReplaceWithIdentity(NodeDef* node, const string& input, DataType type);
+  // Makes the consumers of "node" use "input" instead.
+  void ForwardOutputs(const NodeDef& node, const string& input);
+  // Removes the nodes that became unused, and copies the result.
+  void PruneUnused(const GraphDef& graph, GraphDef* optimized_graph);
+
+  GraphDef graph_;
+  std::unique_ptr<NodeMap> node_map_;
+  std::unique_ptr<GraphProperties> properties_;
+  const GrapplerItem* item_ = nullptr;
+  bool has_properties_ = false;
+  std::unordered_set<string> nodes_to_preserve_;
+  // The nodes whose outputs may have lost all their consumers.
+  std::unordered_set<string> maybe_unused_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_ARITHMETIC_OPTIMIZER_H_
@@ -0,0 +1,207 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class ArithmeticOptimizerTest : public ::testing::Test {
+ protected:
+  GraphDef Optimize(const Scope& s, const std::vector<string>& fetch) {
+    GrapplerItem item;
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    item.fetch = fetch;
+    ArithmeticOptimizer optimizer;
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+    return output;
+  }
+
+  const NodeDef* FindNode(const GraphDef& graph, const string& name) {
+    for (const NodeDef& node : graph.node()) {
+      if (node.name() == name) {
+        return &node;
+      }
+    }
+    return nullptr;
+  }
+
+  int CountOps(const GraphDef& graph, const string& op) {
+    int count = 0;
+    for (const NodeDef& node : graph.node()) {
+      count += node.op() == op;
+    }
+    return count;
+  }
+};
+
+TEST_F(ArithmeticOptimizerTest, DedupsComputations) {
+  Scope s = Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output y = ops::Placeholder(s.WithOpName("y"), DT_FLOAT);
+  Output c1 = ops::Const(s.WithOpName("c1"), 2.0f, {});
+  Output c2 = ops::Const(s.WithOpName("c2"), 2.0f, {});
+  Output add1 = ops::Add(s.WithOpName("add1"), x, y);
+  Output add2 = ops::Add(s.WithOpName("add2"), y, x);
+  Output mul1 = ops::Mul(s.WithOpName("mul1"), add1, c1);
+  Output mul2 = ops::Mul(s.WithOpName("mul2"), add2, c2);
+  ops::Sub(s.WithOpName("sub"), mul1, mul2);
+  GraphDef output = Optimize(s, {"sub"});
+
+  EXPECT_EQ(1, CountOps(output, "Const"));
+  EXPECT_EQ(1, CountOps(output, "Add"));
+  EXPECT_EQ(1, CountOps(output, "Mul"));
+  const NodeDef* sub = FindNode(output, "sub");
+  ASSERT_NE(nullptr, sub);
+  EXPECT_EQ(sub->input(0), sub->input(1));
+}
+
+TEST_F(ArithmeticOptimizerTest, KeepsStatefulAndFetchedNodes) {
+  Scope s = Scope::NewRootScope();
+  Output shape = ops::Const(s.WithOpName("shape"), {2, 2}, {2});
+  Output r1 = ops::RandomUniform(s.WithOpName("r1"), shape, DT_FLOAT);
+  Output r2 = ops::RandomUniform(s.WithOpName("r2"), shape, DT_FLOAT);
+  Output a1 = ops::Abs(s.WithOpName("a1"), r1);
+  Output a2 = ops::Abs(s.WithOpName("a2"), r1);
+  ops::Add(s.WithOpName("add"), r1, r2);
+  GraphDef output = Optimize(s, {"add", "a1", "a2"});
+
+  EXPECT_EQ(2, CountOps(output, "RandomUniform"));
+  EXPECT_EQ(2, CountOps(output, "Abs"));
+}
+
+TEST_F(ArithmeticOptimizerTest, FoldsTransposes) {
+  Scope s = Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output t1 = ops::Transpose(s.WithOpName("t1"), x, {1, 0});
+  Output t2 = ops::Transpose(s.WithOpName("t2"), t1, {1, 0});
+  Output y = ops::Placeholder(s.WithOpName("y"), DT_FLOAT);
+  Output t3 = ops::Transpose(s.WithOpName("t3"), y, {0, 2, 1});
+  Output t4 = ops::Transpose(s.WithOpName("t4"), t3, {1, 0, 2});
+  ops::Exp(s.WithOpName("exp1"), t2);
+  ops::Exp(s.WithOpName("exp2"), t4);
+  GraphDef output = Optimize(s, {"exp1", "exp2"});
+
+  EXPECT_EQ(nullptr, FindNode(output, "t1"));
+  EXPECT_EQ(nullptr, FindNode(output, "t2"));
+  EXPECT_EQ(nullptr, FindNode(output, "t3"));
+  EXPECT_EQ("x", FindNode(output, "exp1")->input(0));
+
+  const NodeDef* t4_node = FindNode(output, "t4");
+  ASSERT_NE(nullptr, t4_node);
+  EXPECT_EQ("y", t4_node->input(0));
+  const NodeDef* perm = FindNode(output, t4_node->input(1));
+  ASSERT_NE(nullptr, perm);
+  Tensor value;
+  ASSERT_TRUE(value.FromProto(perm->attr().at("value").tensor()));
+  ASSERT_EQ(3, value.NumElements());
+  EXPECT_EQ(2, value.vec<int32>()(0));
+  EXPECT_EQ(0, value.vec<int32>()(1));
+  EXPECT_EQ(1, value.vec<int32>()(2));
+}
+
+TEST_F(ArithmeticOptimizerTest, FoldsReshapesAndCasts) {
+  Scope s = Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_INT32);
+  Output r1 = ops::Reshape(s.WithOpName("r1"), x, {4, 4});
+  Output r2 = ops::Reshape(s.WithOpName("r2"), r1, {2, 8});
+  Output c1 = ops::Cast(s.WithOpName("c1"), r2, DT_INT64);
+  Output c2 = ops::Cast(s.WithOpName("c2"), c1, DT_INT32);
+  Output c3 = ops::Cast(s.WithOpName("c3"), c2, DT_FLOAT);
+  Output c4 = ops::Cast(s.WithOpName("c4"), c3, DT_INT32);
+  ops::Neg(s.WithOpName("neg"), c4);
+  GraphDef output = Optimize(s, {"neg"});
+
+  EXPECT_EQ(nullptr, FindNode(output, "r1"));
+  EXPECT_EQ(nullptr, FindNode(output, "c1"));
+  EXPECT_EQ(nullptr, FindNode(output, "c2"));
+  EXPECT_EQ("x", FindNode(output, "r2")->input(0));
+  // Casting integers to floats loses precision.
+  EXPECT_EQ("r2", FindNode(output, "c3")->input(0));
+  EXPECT_EQ("c3", FindNode(output, "c4")->input(0));
+}
+
+TEST_F(ArithmeticOptimizerTest, RemovesInvolutionsAndIdentities) {
+  Scope s = Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output neg1 = ops::Neg(s.WithOpName("neg1"), x);
+  Output neg2 = ops::Neg(s.WithOpName("neg2"), neg1);
+  Output id = ops::Identity(s.WithOpName("id"), neg2);
+  Output var = ops::Variable(s.WithOpName("var"), {2}, DT_FLOAT);
+  Output read = ops::Identity(s.WithOpName("read"), var);
+  ops::Add(s.WithOpName("add"), id, read);
+  GraphDef output = Optimize(s, {"add"});
+
+  EXPECT_EQ(nullptr, FindNode(output, "neg1"));
+  EXPECT_EQ(nullptr, FindNode(output, "neg2"));
+  EXPECT_EQ(nullptr, FindNode(output, "id"));
+  const NodeDef* add = FindNode(output, "add");
+  ASSERT_NE(nullptr, add);
+  EXPECT_EQ("x", add->input(0));
+  // Reading a variable takes a snapshot of its value.
+  EXPECT_EQ("read", add->input(1));
+}
+
+TEST_F(ArithmeticOptimizerTest, HoistsCommonFactor) {
+  Scope s = Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                              ops::Placeholder::Shape({2, 2}));
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT,
+                              ops::Placeholder::Shape({2, 2}));
+  Output b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT,
+                              ops::Placeholder::Shape({2, 2}));
+  Output c = ops::Placeholder(s.WithOpName("c"), DT_FLOAT,
+                              ops::Placeholder::Shape({2, 2}));
+  Output d = ops::Placeholder(s.WithOpName("d"), DT_FLOAT,
+                              ops::Placeholder::Shape({2}));
+  Output ax = ops::Mul(s.WithOpName("ax"), a, x);
+  Output xb = ops::Mul(s.WithOpName("xb"), x, b);
+  Output cx = ops::Mul(s.WithOpName("cx"), c, x);
+  Output dx = ops::Mul(s.WithOpName("dx"), d, x);
+  ops::AddN(s.WithOpName("sum1"), {ax, xb});
+  // The factors of the second sum have different shapes.
+  ops::AddN(s.WithOpName("sum2"), {cx, dx});
+  GraphDef output = Optimize(s, {"sum1", "sum2"});
+
+  const NodeDef* sum1 = FindNode(output, "sum1");
+  ASSERT_NE(nullptr, sum1);
+  EXPECT_EQ("Mul", sum1->op());
+  ASSERT_EQ(2, sum1->input_size());
+  EXPECT_EQ("x", sum1->input(1));
+  const NodeDef* factors = FindNode(output, sum1->input(0));
+  ASSERT_NE(nullptr, factors);
+  EXPECT_EQ("AddN", factors->op());
+  ASSERT_EQ(2, factors->input_size());
+  EXPECT_EQ("a", factors->input(0));
+  EXPECT_EQ("b", factors->input(1));
+  EXPECT_EQ(nullptr, FindNode(output, "xb"));
+
+  const NodeDef* sum2 = FindNode(output, "sum2");
+  ASSERT_NE(nullptr, sum2);
+  EXPECT_EQ("AddN", sum2->op());
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
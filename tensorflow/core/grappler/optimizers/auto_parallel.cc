@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/auto_parallel.h"
 
+#include <algorithm>
+
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
@@ -60,6 +62,22 @@ NodeDef* AutoParallel::AddNodeDiv(const string& name, const string& input_a,
   return node;
 }
 
+NodeDef* AutoParallel::AddNodeSum(const string& name, const string& gradient) {
+  NodeDef* node = graph_.add_node();
+  node->set_name(strings::StrCat(kAutoParallelPrefix, "-AddN-", name));
+  node->set_op("AddN");
+  // AddSharedNodes() replaces the input by the gradients of all the replicas.
+  node->add_input(gradient);
+  gradient_sums_[node->name()] = gradient;
+  AttrValue attr_n;
+  attr_n.set_i(num_replicas_);
+  node->mutable_attr()->insert({"N", attr_n});
+  AttrValue attr_type;
+  attr_type.set_type(DT_FLOAT);
+  node->mutable_attr()->insert({"T", attr_type});
+  return node;
+}
+
 NodeDef* AutoParallel::AddNodeControl(const string& name,
                                       const std::set<string>& deps,
                                       GraphDef* graph) {
@@ -72,9 +90,27 @@ NodeDef* AutoParallel::AddNodeControl(const string& name,
   return node;
 }
 
-Status AutoParallel::Initialize(const GrapplerItem& item) {
-  num_gpus_ = GetNumAvailableGPUs();
-  LOG(INFO) << "Number of GPUs: " << num_gpus_;
+Status AutoParallel::Initialize(Cluster* cluster, const GrapplerItem& item) {
+  replica_devices_.clear();
+  if (cluster) {
+    for (const auto& device : cluster->GetDevices()) {
+      if (device.second.type() == "GPU") {
+        replica_devices_.push_back(device.first);
+      }
+    }
+    std::sort(replica_devices_.begin(), replica_devices_.end());
+  } else {
+    for (int i = 0; i < GetNumAvailableGPUs(); i++) {
+      replica_devices_.push_back(strings::StrCat("/gpu:", i));
+    }
+  }
+  LOG(INFO) << "Number of GPUs: " << replica_devices_.size();
+  num_replicas_ = requested_replicas_ > 0 ? requested_replicas_
+                                          : replica_devices_.size();
+  if (num_replicas_ < 2) {
+    // Nothing to parallelize.
+    return Status::OK();
+  }
   item_ = &item;
   graph_ = item.graph;
   LOG(INFO) << "Original graph size: " << graph_.node_size();
@@ -119,8 +155,10 @@ Status AutoParallel::Initialize(const GrapplerItem& item) {
     }
   }
 
+  std::set<string> dont_replicate_nodes;
   auto div_const_node = AddNodeDivConst();
   all_nodes_.insert(std::make_pair(div_const_node->name(), div_const_node));
+  dont_replicate_nodes.insert(div_const_node->name());
   std::map<string, int> gradient_pos = {{"ApplyGradientDescent", 2},
                                         {"ApplyProximalGradientDescent", 4},
                                         {"ApplyAdadelta", 6},
@@ -132,24 +170,33 @@ Status AutoParallel::Initialize(const GrapplerItem& item) {
                                         {"ApplyAdam", 9},
                                         {"ApplyRMSProp", 7},
                                         {"ApplyCenteredRMSProp", 8}};
+  // The gradients are applied once, next to the variables, with the average of
+  // the gradients of all the replicas.
   for (const auto& apply_gradient_node_name : apply_gradients_nodes_) {
     auto apply_gradients_op = all_nodes_[apply_gradient_node_name]->op();
     auto apply_gradients_node = all_nodes_[apply_gradient_node_name];
 
-    auto div_node = AddNodeDiv(
+    auto sum_node = AddNodeSum(
         apply_gradient_node_name,
-        apply_gradients_node->input(gradient_pos[apply_gradients_op]),
-        div_const_node->name());
+        apply_gradients_node->input(gradient_pos[apply_gradients_op]));
+    sum_node->set_device(apply_gradients_node->device());
+    all_nodes_.insert(std::make_pair(sum_node->name(), sum_node));
+    auto div_node = AddNodeDiv(apply_gradient_node_name, sum_node->name(),
+                               div_const_node->name());
+    div_node->set_device(apply_gradients_node->device());
     all_nodes_.insert(std::make_pair(div_node->name(), div_node));
     *apply_gradients_node->mutable_input(gradient_pos[apply_gradients_op]) =
         div_node->name();
+    dont_replicate_nodes.insert(apply_gradient_node_name);
+    dont_replicate_nodes.insert(sum_node->name());
+    dont_replicate_nodes.insert(div_node->name());
   }
   LOG(INFO) << "Graph size after adding div nodes: " << all_nodes_.size();
 
   auto train_nodes = ComputeTransitiveFanin(graph_, item.fetch);
   LOG(INFO) << "Number of training nodes: " << train_nodes.size();
 
-  const NodeDef* dequeue_node;
+  const NodeDef* dequeue_node = nullptr;
   for (const auto& train_node : train_nodes) {
     if (IsDequeueOp(*train_node)) {
       dequeue_node = train_node;
@@ -164,7 +211,6 @@ Status AutoParallel::Initialize(const GrapplerItem& item) {
   }
   LOG(INFO) << "Number of input nodes: " << input_nodes.size();
 
-  std::set<string> dont_replicate_nodes;
   for (const auto& variable : item.MainVariables()) {
     dont_replicate_nodes.insert(variable->name());
   }
@@ -205,6 +251,16 @@ void AutoParallel::AddSharedNodes(GraphDef* graph) {
   for (const auto& node : shared_nodes_) {
     auto new_node = graph->add_node();
     *new_node = *all_nodes_[node];
+    auto gradient = gradient_sums_.find(node);
+    if (gradient != gradient_sums_.end()) {
+      new_node->clear_input();
+      for (int i = 0; i < num_replicas_; i++) {
+        new_node->add_input(AddPrefixToNodeName(
+            gradient->second,
+            strings::StrCat(kAutoParallelPrefix, "-Replica-", i)));
+      }
+      continue;
+    }
     for (int i = 0; i < new_node->input_size(); i++) {
       if (NotSharedNode(NodeName(new_node->input(i)))) {
         string new_name = AddPrefixToNodeName(new_node->input(i), prefix);
@@ -221,8 +277,9 @@ void AutoParallel::AddOneReplica(GraphDef* graph, int number) {
     *new_node = *all_nodes_[node];
     if (NotSharedNode(new_node->name())) {
       new_node->set_name(AddPrefixToNodeName(new_node->name(), prefix));
-      if (num_gpus_ > 0) {
-        new_node->set_device(strings::StrCat("/gpu:", number % num_gpus_));
+      if (!replica_devices_.empty()) {
+        new_node->set_device(
+            replica_devices_[number % replica_devices_.size()]);
       }
       for (int i = 0; i < new_node->input_size(); i++) {
         if (NotSharedNode(NodeName(new_node->input(i)))) {
@@ -239,20 +296,30 @@ void AutoParallel::BuildGraph(GraphDef* graph) {
   for (int i = 0; i < num_replicas_; i++) {
     AddOneReplica(graph, i);
   }
+  // The replicated fetch nodes are replaced by a node that waits for all their
+  // replicas. The shared ones, such as the nodes applying the gradients, are
+  // kept.
   std::set<string> fetches;
+  std::vector<string> replicated_fetches;
   for (size_t i = 0; i < item_->fetch.size(); i++) {
+    if (!NotSharedNode(NodeName(item_->fetch[i]))) {
+      continue;
+    }
+    replicated_fetches.push_back(item_->fetch[i]);
     for (int j = 0; j < num_replicas_; j++) {
       string prefix = strings::StrCat(kAutoParallelPrefix, "-Replica-", j);
       string fetch = AddPrefixToNodeName(item_->fetch[i], prefix);
       fetches.insert(fetch);
     }
   }
-  string name_control =
-      strings::StrCat(kAutoParallelPrefix, "-Control-", "Fetch");
-  auto control = AddNodeControl(name_control, fetches, graph);
+  if (!replicated_fetches.empty()) {
+    string name_control =
+        strings::StrCat(kAutoParallelPrefix, "-Control-", "Fetch");
+    auto control = AddNodeControl(name_control, fetches, graph);
 
-  for (const auto& fetch : item_->fetch) {
-    AddNodeControl(fetch, {control->name()}, graph);
+    for (const auto& fetch : replicated_fetches) {
+      AddNodeControl(fetch, {control->name()}, graph);
+    }
   }
   *graph->mutable_library() = item_->graph.library();
   *graph->mutable_versions() = item_->graph.versions();
@@ -261,7 +328,11 @@ void AutoParallel::BuildGraph(GraphDef* graph) {
 
 Status AutoParallel::Optimize(Cluster* cluster, const GrapplerItem& item,
                               GraphDef* output) {
-  TF_RETURN_IF_ERROR(Initialize(item));
+  TF_RETURN_IF_ERROR(Initialize(cluster, item));
+  if (num_replicas_ < 2) {
+    *output = item.graph;
+    return Status::OK();
+  }
   BuildGraph(output);
   return Status::OK();
 }
@@ -24,10 +24,16 @@ namespace tensorflow {
 namespace grappler {
 
 // Automatically parallelize a graph by splitting in the batch dimension.
+// Each replica dequeues its own batch and computes its own gradients, which are
+// averaged across the replicas before being applied once to the variables.
+// The variables and the nodes applying the gradients stay on the device they
+// were placed on. A num_replicas of 0 creates one replica per GPU of the
+// cluster.
 class AutoParallel : public GraphOptimizer {
  public:
-  AutoParallel(int num_replicas) : num_replicas_(num_replicas) {
-    CHECK(num_replicas_ >= 2);
+  AutoParallel(int num_replicas)
+      : requested_replicas_(num_replicas), num_replicas_(num_replicas) {
+    CHECK(num_replicas_ == 0 || num_replicas_ >= 2);
   }
   ~AutoParallel() override {}
 
@@ -45,13 +51,19 @@ class AutoParallel : public GraphOptimizer {
   std::set<string> apply_gradients_nodes_;
   std::set<string> replica_nodes_;
   std::set<string> shared_nodes_;
+  // The AddN nodes summing the gradients of the replicas, mapped to the
+  // gradient they sum.
+  std::map<string, string> gradient_sums_;
   const GrapplerItem* item_;
+  const int requested_replicas_;
   int num_replicas_;
-  int num_gpus_;
-  Status Initialize(const GrapplerItem& item);
+  // The devices of the replicas, in order; empty to keep the original devices.
+  std::vector<string> replica_devices_;
+  Status Initialize(Cluster* cluster, const GrapplerItem& item);
   NodeDef* AddNodeDivConst();
   NodeDef* AddNodeDiv(const string& name, const string& input_a,
                       const string& input_b);
+  NodeDef* AddNodeSum(const string& name, const string& gradient);
   NodeDef* AddNodeControl(const string& name, const std::set<string>& deps,
                           GraphDef* graph);
   bool NotSharedNode(const string& name);
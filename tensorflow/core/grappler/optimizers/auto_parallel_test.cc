@@ -16,9 +16,11 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/auto_parallel.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/clusters/virtual_cluster.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -52,78 +54,146 @@ TEST_F(AutoParallelTest, SimpleParallel) {
   GraphDef output;
   Status status = parallel.Optimize(nullptr, item, &output);
   TF_EXPECT_OK(status);
-  EXPECT_EQ(21, output.node_size());
+  EXPECT_EQ(17, output.node_size());
+
+  // The gradients of the replicas are averaged and applied once.
+  const NodeDef& node_sum = output.node(0);
+  EXPECT_EQ("AutoParallel-AddN-apply_gradient", node_sum.name());
+  EXPECT_EQ("AddN", node_sum.op());
+  EXPECT_EQ(2, node_sum.attr().at("N").i());
+  ASSERT_EQ(2, node_sum.input_size());
+  EXPECT_EQ("AutoParallel-Replica-0/add", node_sum.input(0));
+  EXPECT_EQ("AutoParallel-Replica-1/add", node_sum.input(1));
+
+  const NodeDef& node_div_const = output.node(1);
+  EXPECT_EQ("AutoParallel-Div-Const", node_div_const.name());
+
+  const NodeDef& node_div = output.node(2);
+  EXPECT_EQ("AutoParallel-Div-apply_gradient", node_div.name());
+  EXPECT_EQ("AutoParallel-AddN-apply_gradient", node_div.input(0));
+  EXPECT_EQ("AutoParallel-Div-Const", node_div.input(1));
+
+  const NodeDef& node_gradient = output.node(3);
+  EXPECT_EQ("apply_gradient", node_gradient.name());
+  EXPECT_EQ("var", node_gradient.input(0));
+  EXPECT_EQ("AutoParallel-Replica-0/learning_rate", node_gradient.input(1));
+  EXPECT_EQ("AutoParallel-Div-apply_gradient", node_gradient.input(2));
 
-  const NodeDef& node_assign = output.node(0);
+  const NodeDef& node_assign = output.node(4);
   EXPECT_EQ("assign", node_assign.name());
   EXPECT_EQ("AutoParallel-Replica-0/constant_a", node_assign.input(1));
 
-  const NodeDef& node_constant_b = output.node(1);
+  const NodeDef& node_constant_b = output.node(5);
   EXPECT_EQ("constant_b", node_constant_b.name());
 
-  const NodeDef& node_fifo_queue = output.node(2);
+  const NodeDef& node_fifo_queue = output.node(6);
   EXPECT_EQ("fifo_queue", node_fifo_queue.name());
 
-  const NodeDef& node_identity = output.node(3);
+  const NodeDef& node_identity = output.node(7);
   EXPECT_EQ("identity", node_identity.name());
   EXPECT_EQ("var", node_identity.input(0));
 
-  const NodeDef& node_var = output.node(4);
+  const NodeDef& node_var = output.node(8);
   EXPECT_EQ("var", node_var.name());
 
-  const NodeDef& node_div_const0 = output.node(5);
-  EXPECT_EQ("AutoParallel-Replica-0/AutoParallel-Div-Const",
-            node_div_const0.name());
-
-  const NodeDef& node_div0 = output.node(6);
-  EXPECT_EQ("AutoParallel-Replica-0/AutoParallel-Div-apply_gradient",
-            node_div0.name());
-  const NodeDef& node_add0 = output.node(7);
-  EXPECT_EQ("AutoParallel-Replica-0/add", node_add0.name());
-
-  const NodeDef& node_gradient0 = output.node(8);
-  EXPECT_EQ("AutoParallel-Replica-0/apply_gradient", node_gradient0.name());
-
-  const NodeDef& node_constant_a0 = output.node(9);
-  EXPECT_EQ("AutoParallel-Replica-0/constant_a", node_constant_a0.name());
+  for (int i = 0; i < 2; i++) {
+    const string prefix = strings::StrCat("AutoParallel-Replica-", i, "/");
+    const NodeDef& node_add = output.node(9 + 4 * i);
+    EXPECT_EQ(prefix + "add", node_add.name());
+    EXPECT_EQ(prefix + "constant_a", node_add.input(0));
+    EXPECT_EQ(prefix + "dequeue", node_add.input(1));
 
-  const NodeDef& node_dequeue0 = output.node(10);
-  EXPECT_EQ("AutoParallel-Replica-0/dequeue", node_dequeue0.name());
+    const NodeDef& node_constant_a = output.node(10 + 4 * i);
+    EXPECT_EQ(prefix + "constant_a", node_constant_a.name());
 
-  const NodeDef& node_learning_rate0 = output.node(11);
-  EXPECT_EQ("AutoParallel-Replica-0/learning_rate", node_learning_rate0.name());
+    // Each replica dequeues its own batch.
+    const NodeDef& node_dequeue = output.node(11 + 4 * i);
+    EXPECT_EQ(prefix + "dequeue", node_dequeue.name());
+    EXPECT_EQ("fifo_queue", node_dequeue.input(0));
 
-  const NodeDef& node_div_const1 = output.node(12);
-  EXPECT_EQ("AutoParallel-Replica-1/AutoParallel-Div-Const",
-            node_div_const1.name());
-
-  const NodeDef& node_div1 = output.node(13);
-  EXPECT_EQ("AutoParallel-Replica-1/AutoParallel-Div-apply_gradient",
-            node_div1.name());
+    const NodeDef& node_learning_rate = output.node(12 + 4 * i);
+    EXPECT_EQ(prefix + "learning_rate", node_learning_rate.name());
+  }
+}
 
-  const NodeDef& node_add1 = output.node(14);
-  EXPECT_EQ("AutoParallel-Replica-1/add", node_add1.name());
+TEST_F(AutoParallelTest, ReplicasFromCluster) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output constant_a = ops::Const(s.WithOpName("constant_a"), 1.0f, {1});
+  Output var = ops::Variable(s.WithOpName("var"), {1}, DT_FLOAT);
+  Output assign = ops::Assign(s.WithOpName("assign"), {var}, {constant_a});
+  Output identity = ops::Identity(s.WithOpName("identity"), {var});
+  Output gradient = ops::Neg(s.WithOpName("gradient"), {identity});
+  Output learning_rate = ops::Const(s.WithOpName("learning_rate"), 0.01f, {1});
+  Output apply_gradient = ops::ApplyGradientDescent(
+      s.WithOpName("apply_gradient").WithDevice("/cpu:0"), {var},
+      {learning_rate}, {gradient});
+  Output train = ops::NoOp(
+      s.WithOpName("train").WithControlDependencies(apply_gradient));
 
-  const NodeDef& node_gradient1 = output.node(15);
-  EXPECT_EQ("AutoParallel-Replica-1/apply_gradient", node_gradient1.name());
+  GrapplerItem item;
+  item.init_ops.push_back("assign");
+  item.fetch.push_back("train");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
 
-  const NodeDef& node_constant_a1 = output.node(16);
-  EXPECT_EQ("AutoParallel-Replica-1/constant_a", node_constant_a1.name());
+  DeviceProperties cpu_device;
+  cpu_device.set_type("CPU");
+  DeviceProperties gpu_device;
+  gpu_device.set_type("GPU");
+  std::unordered_map<string, DeviceProperties> devices = {
+      {"/job:localhost/replica:0/task:0/cpu:0", cpu_device},
+      {"/job:localhost/replica:0/task:0/gpu:0", gpu_device},
+      {"/job:localhost/replica:0/task:0/gpu:1", gpu_device}};
+  VirtualCluster cluster(devices);
+
+  AutoParallel parallel(0);
+  GraphDef output;
+  TF_EXPECT_OK(parallel.Optimize(&cluster, item, &output));
+  NodeMap node_map(&output);
+
+  for (int i = 0; i < 2; i++) {
+    const string prefix = strings::StrCat("AutoParallel-Replica-", i, "/");
+    const NodeDef* replica_gradient = node_map.GetNode(prefix + "gradient");
+    ASSERT_NE(nullptr, replica_gradient);
+    EXPECT_EQ(strings::StrCat("/job:localhost/replica:0/task:0/gpu:", i),
+              replica_gradient->device());
+  }
+  // The gradients are averaged on the parameter device.
+  const NodeDef* sum = node_map.GetNode("AutoParallel-AddN-apply_gradient");
+  ASSERT_NE(nullptr, sum);
+  EXPECT_EQ("/cpu:0", sum->device());
+  EXPECT_EQ(2, sum->input_size());
+  const NodeDef* apply = node_map.GetNode("apply_gradient");
+  ASSERT_NE(nullptr, apply);
+  EXPECT_EQ("/cpu:0", apply->device());
+  EXPECT_EQ("AutoParallel-Div-apply_gradient", apply->input(2));
+
+  // The replicated fetch node waits for all the replicas.
+  const NodeDef* train_node = node_map.GetNode("train");
+  ASSERT_NE(nullptr, train_node);
+  EXPECT_EQ("^AutoParallel-Control-Fetch", train_node->input(0));
+}
 
-  const NodeDef& node_dequeue1 = output.node(17);
-  EXPECT_EQ("AutoParallel-Replica-1/dequeue", node_dequeue1.name());
+TEST_F(AutoParallelTest, SingleGPUIsNotParallelized) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output constant_a = ops::Const(s.WithOpName("constant_a"), 1.0f, {1});
+  Output var = ops::Variable(s.WithOpName("var"), {1}, DT_FLOAT);
+  Output learning_rate = ops::Const(s.WithOpName("learning_rate"), 0.01f, {1});
+  Output apply_gradient = ops::ApplyGradientDescent(
+      s.WithOpName("apply_gradient"), {var}, {learning_rate}, {constant_a});
 
-  const NodeDef& node_learning_rate1 = output.node(18);
-  EXPECT_EQ("AutoParallel-Replica-1/learning_rate", node_learning_rate1.name());
+  GrapplerItem item;
+  item.fetch.push_back("apply_gradient");
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
 
-  const NodeDef& node_fetch = output.node(19);
-  EXPECT_EQ("AutoParallel-Control-Fetch", node_fetch.name());
-  EXPECT_EQ("^AutoParallel-Replica-0/apply_gradient", node_fetch.input(0));
-  EXPECT_EQ("^AutoParallel-Replica-1/apply_gradient", node_fetch.input(1));
+  DeviceProperties gpu_device;
+  gpu_device.set_type("GPU");
+  VirtualCluster cluster(
+      {{"/job:localhost/replica:0/task:0/gpu:0", gpu_device}});
 
-  const NodeDef& node_gradient = output.node(20);
-  EXPECT_EQ("apply_gradient", node_gradient.name());
-  EXPECT_EQ("^AutoParallel-Control-Fetch", node_gradient.input(0));
+  AutoParallel parallel(0);
+  GraphDef output;
+  TF_EXPECT_OK(parallel.Optimize(&cluster, item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
 }
 
 }  // namespace
@@ -0,0 +1,219 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/bias_activation_fusion.h"
+#include <unordered_set>
+#include <vector>
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Returns the type attr "T" of `node`, or DT_INVALID.
+DataType GetType(const NodeDef& node) {
+  auto it = node.attr().find("T");
+  return it == node.attr().end() ? DT_INVALID : it->second.type();
+}
+
+// Returns the data format of a Conv2D or BiasAdd node.
+string GetDataFormat(const NodeDef& node) {
+  auto it = node.attr().find("data_format");
+  return it == node.attr().end() ? "NHWC" : it->second.s();
+}
+
+// Returns true if the op of `node` has a fused kernel of type `type`.
+bool IsFusable(const NodeDef& node, DataType type) {
+  if (node.op() == "Conv2D") {
+    return type == DT_HALF || type == DT_FLOAT;
+  }
+  if (node.op() == "MatMul") {
+    return type == DT_HALF || type == DT_FLOAT || type == DT_DOUBLE;
+  }
+  return false;
+}
+
+bool IsFusableActivation(const NodeDef& node) {
+  return node.op() == "Relu" || node.op() == "Relu6" || node.op() == "Elu";
+}
+
+// Returns the node whose only consumer is `consumer`, through the data input
+// `input`, or nullptr if there is no such node that can be removed.
+NodeDef* GetFusableInput(const NodeDef& consumer, int input,
+                         const NodeMap& node_map,
+                         const std::unordered_set<string>& nodes_to_preserve) {
+  if (consumer.input_size() <= input ||
+      IsControlInput(consumer.input(input))) {
+    return nullptr;
+  }
+  int position;
+  const string name = ParseNodeName(consumer.input(input), &position);
+  NodeDef* node = node_map.GetNode(name);
+  if (position != 0 || node == nullptr || nodes_to_preserve.count(name) > 0 ||
+      node->device() != consumer.device() ||
+      node_map.GetOutputs(name).size() != 1) {
+    return nullptr;
+  }
+  for (int i = 0; i < consumer.input_size(); ++i) {
+    if (i != input && NodeName(consumer.input(i)) == name) {
+      return nullptr;
+    }
+  }
+  return node;
+}
+
+// Returns the only consumer of `node`, which must use it as its first input.
+NodeDef* GetOnlyConsumer(const NodeDef& node, const NodeMap& node_map) {
+  const std::set<NodeDef*>& outputs = node_map.GetOutputs(node.name());
+  if (outputs.size() != 1) {
+    return nullptr;
+  }
+  NodeDef* consumer = *outputs.begin();
+  if (consumer->input_size() < 1 || consumer->input(0) != node.name()) {
+    return nullptr;
+  }
+  for (int i = 1; i < consumer->input_size(); ++i) {
+    if (NodeName(consumer->input(i)) == node.name()) {
+      return nullptr;
+    }
+  }
+  return consumer;
+}
+
+}  // namespace
+
+Status BiasActivationFusion::Optimize(Cluster* cluster,
+                                      const GrapplerItem& item,
+                                      GraphDef* optimized_graph) {
+  GraphDef graph = item.graph;
+  NodeMap node_map(&graph);
+
+  std::unordered_set<string> nodes_to_preserve;
+  for (const auto& node : item.fetch) {
+    nodes_to_preserve.insert(NodeName(node));
+  }
+  for (const auto& feed : item.feed) {
+    nodes_to_preserve.insert(NodeName(feed.first));
+  }
+  for (const auto& node : item.init_ops) {
+    nodes_to_preserve.insert(NodeName(node));
+  }
+
+  std::unordered_set<string> nodes_to_delete;
+  const int num_nodes = graph.node_size();
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* bias_add = graph.mutable_node(i);
+    if (bias_add->op() != "BiasAdd" || bias_add->input_size() < 2 ||
+        IsControlInput(bias_add->input(1))) {
+      continue;
+    }
+    const DataType type = GetType(*bias_add);
+    NodeDef* op = GetFusableInput(*bias_add, 0, node_map, nodes_to_preserve);
+    if (op == nullptr || !IsFusable(*op, type) || GetType(*op) != type ||
+        op->input_size() < 2 || IsControlInput(op->input(1))) {
+      continue;
+    }
+    // The bias of a product is added to its columns, like in the NHWC format.
+    const string conv_format =
+        op->op() == "Conv2D" ? GetDataFormat(*op) : "NHWC";
+    if (GetDataFormat(*bias_add) != conv_format) {
+      continue;
+    }
+
+    // The activation, if any, becomes the fused node.
+    NodeDef* fused = bias_add;
+    std::vector<string> fused_ops = {"BiasAdd"};
+    NodeDef* activation = GetOnlyConsumer(*bias_add, node_map);
+    if (activation != nullptr && IsFusableActivation(*activation) &&
+        GetType(*activation) == type &&
+        activation->device() == bias_add->device() &&
+        nodes_to_preserve.count(bias_add->name()) == 0) {
+      fused = activation;
+      fused_ops.push_back(activation->op());
+      nodes_to_delete.insert(bias_add->name());
+    }
+    nodes_to_delete.insert(op->name());
+    VLOG(1) << "Fusing " << op->name() << " with "
+            << str_util::Join(fused_ops, ", ") << " into " << fused->name();
+
+    std::vector<string> inputs = {op->input(0), op->input(1),
+                                  bias_add->input(1)};
+    for (int j = 2; j < op->input_size(); ++j) {
+      inputs.push_back(op->input(j));
+    }
+    for (int j = 2; j < bias_add->input_size(); ++j) {
+      inputs.push_back(bias_add->input(j));
+    }
+    if (fused != bias_add) {
+      for (int j = 1; j < fused->input_size(); ++j) {
+        inputs.push_back(fused->input(j));
+      }
+    }
+
+    // The fused node has the attributes of the convolution or the product,
+    // but keeps its own internal ones, such as its colocation constraints.
+    auto* attrs = fused->mutable_attr();
+    for (auto it = attrs->begin(); it != attrs->end();) {
+      if (StringPiece(it->first).starts_with("_")) {
+        ++it;
+      } else {
+        it = attrs->erase(it);
+      }
+    }
+    for (const auto& attr : op->attr()) {
+      if (!StringPiece(attr.first).starts_with("_")) {
+        (*attrs)[attr.first] = attr.second;
+      }
+    }
+    (*attrs)["num_args"].set_i(1);
+    AttrValue attr_fused_ops;
+    for (const string& fused_op : fused_ops) {
+      attr_fused_ops.mutable_list()->add_s(fused_op);
+    }
+    (*attrs)["fused_ops"] = attr_fused_ops;
+    fused->set_op(op->op() == "Conv2D" ? "_FusedConv2D" : "_FusedMatMul");
+    fused->clear_input();
+    for (const string& input : inputs) {
+      fused->add_input(input);
+    }
+  }
+
+  for (const auto& node : graph.node()) {
+    if (nodes_to_delete.find(node.name()) == nodes_to_delete.end()) {
+      *optimized_graph->add_node() = node;
+    }
+  }
+
+  *optimized_graph->mutable_library() = item.graph.library();
+  *optimized_graph->mutable_versions() = item.graph.versions();
+
+  return Status::OK();
+}
+
+void BiasActivationFusion::Feedback(Cluster* cluster, const GrapplerItem& item,
+                                    const GraphDef& optimized_graph,
+                                    double result) {
+  // Nothing to do for BiasActivationFusion.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
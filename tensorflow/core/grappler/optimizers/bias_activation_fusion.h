@@ -0,0 +1,57 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_BIAS_ACTIVATION_FUSION_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_BIAS_ACTIVATION_FUSION_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Replaces the convolutions and matrix products that are followed by a bias,
+// and optionally by an activation, with fused nodes that apply the bias and
+// the activation in place:
+//
+//   Relu(BiasAdd(Conv2D(input, filter), bias))
+//     => _FusedConv2D(input, filter, bias, fused_ops=["BiasAdd", "Relu"])
+//   BiasAdd(MatMul(a, b), bias)
+//     => _FusedMatMul(a, b, bias, fused_ops=["BiasAdd"])
+//
+// The supported activations are Relu, Relu6 and Elu. The fused node keeps the
+// name of the last node of the pattern, whose intermediate results must have
+// no other consumers.
+//
+// Since any Conv2D or MatMul with a bias may be fused, the CPU kernels of the
+// fused ops are registered in every build, even where the unfused kernel of
+// a type is not.
+class BiasActivationFusion : public GraphOptimizer {
+ public:
+  BiasActivationFusion() {}
+  ~BiasActivationFusion() override {}
+
+  string name() const override { return "bias_activation_fusion"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_BIAS_ACTIVATION_FUSION_H_
@@ -0,0 +1,132 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/bias_activation_fusion.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class BiasActivationFusionTest : public ::testing::Test {
+ protected:
+  GraphDef Optimize(const Scope& s, const std::vector<string>& fetch) {
+    GrapplerItem item;
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    item.fetch = fetch;
+    BiasActivationFusion optimizer;
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(nullptr, item, &output));
+    return output;
+  }
+
+  const NodeDef* FindNode(const GraphDef& graph, const string& name) {
+    for (const NodeDef& node : graph.node()) {
+      if (node.name() == name) {
+        return &node;
+      }
+    }
+    return nullptr;
+  }
+
+  std::vector<string> FusedOps(const NodeDef& node) {
+    const auto& list = node.attr().at("fused_ops").list();
+    return std::vector<string>(list.s().begin(), list.s().end());
+  }
+};
+
+TEST_F(BiasActivationFusionTest, FusesConvBiasAndRelu) {
+  Scope s = Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output w = ops::Placeholder(s.WithOpName("w"), DT_FLOAT);
+  Output b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT);
+  Output conv = ops::Conv2D(s.WithOpName("conv"), x, w, {1, 2, 2, 1}, "SAME");
+  Output bias = ops::BiasAdd(s.WithOpName("bias"), conv, b);
+  ops::Relu(s.WithOpName("relu"), bias);
+  GraphDef output = Optimize(s, {"relu"});
+
+  EXPECT_EQ(nullptr, FindNode(output, "conv"));
+  EXPECT_EQ(nullptr, FindNode(output, "bias"));
+  const NodeDef* relu = FindNode(output, "relu");
+  ASSERT_NE(nullptr, relu);
+  EXPECT_EQ("_FusedConv2D", relu->op());
+  ASSERT_EQ(3, relu->input_size());
+  EXPECT_EQ("x", relu->input(0));
+  EXPECT_EQ("w", relu->input(1));
+  EXPECT_EQ("b", relu->input(2));
+  EXPECT_EQ(1, relu->attr().at("num_args").i());
+  EXPECT_EQ("SAME", relu->attr().at("padding").s());
+  EXPECT_EQ(4, relu->attr().at("strides").list().i_size());
+  EXPECT_EQ(std::vector<string>({"BiasAdd", "Relu"}), FusedOps(*relu));
+}
+
+TEST_F(BiasActivationFusionTest, FusesMatMulAndSharedBias) {
+  Scope s = Scope::NewRootScope();
+  Output a = ops::Placeholder(s.WithOpName("a"), DT_FLOAT);
+  Output w = ops::Placeholder(s.WithOpName("w"), DT_FLOAT);
+  Output b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT);
+  Output matmul = ops::MatMul(s.WithOpName("matmul"), a, w,
+                              ops::MatMul::TransposeB(true));
+  Output bias = ops::BiasAdd(s.WithOpName("bias"), matmul, b);
+  // The bias has two consumers, so the activation can't be fused.
+  ops::Relu6(s.WithOpName("relu6"), bias);
+  ops::Exp(s.WithOpName("exp"), bias);
+  GraphDef output = Optimize(s, {"relu6", "exp"});
+
+  EXPECT_EQ(nullptr, FindNode(output, "matmul"));
+  const NodeDef* fused = FindNode(output, "bias");
+  ASSERT_NE(nullptr, fused);
+  EXPECT_EQ("_FusedMatMul", fused->op());
+  ASSERT_EQ(3, fused->input_size());
+  EXPECT_EQ("a", fused->input(0));
+  EXPECT_TRUE(fused->attr().at("transpose_b").b());
+  EXPECT_EQ(std::vector<string>({"BiasAdd"}), FusedOps(*fused));
+  EXPECT_EQ("Relu6", FindNode(output, "relu6")->op());
+}
+
+TEST_F(BiasActivationFusionTest, KeepsUsedIntermediates) {
+  Scope s = Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT);
+  Output w = ops::Placeholder(s.WithOpName("w"), DT_FLOAT);
+  Output b = ops::Placeholder(s.WithOpName("b"), DT_FLOAT);
+  Output conv1 =
+      ops::Conv2D(s.WithOpName("conv1"), x, w, {1, 1, 1, 1}, "VALID");
+  Output bias1 = ops::BiasAdd(s.WithOpName("bias1"), conv1, b);
+  ops::Exp(s.WithOpName("exp"), conv1);
+  Output conv2 =
+      ops::Conv2D(s.WithOpName("conv2"), x, w, {1, 1, 1, 1}, "VALID");
+  Output bias2 = ops::BiasAdd(s.WithOpName("bias2"), conv2, b);
+  ops::Elu(s.WithOpName("elu"), bias2);
+  // The fetched bias2 can't be removed.
+  GraphDef output = Optimize(s, {"bias1", "exp", "bias2", "elu"});
+
+  EXPECT_EQ("Conv2D", FindNode(output, "conv1")->op());
+  EXPECT_EQ("BiasAdd", FindNode(output, "bias1")->op());
+  EXPECT_EQ(nullptr, FindNode(output, "conv2"));
+  const NodeDef* fused = FindNode(output, "bias2");
+  ASSERT_NE(nullptr, fused);
+  EXPECT_EQ("_FusedConv2D", fused->op());
+  EXPECT_EQ(std::vector<string>({"BiasAdd"}), FusedOps(*fused));
+  EXPECT_EQ("Elu", FindNode(output, "elu")->op());
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -96,6 +96,79 @@ string AsControlDependency(const NodeDef& node) {
   return strings::StrCat("^", node.name());
 }
 
+// Sets "shape" to the shape encoded by the output of "node", a Const node or a
+// Shape node, if its rank is known statically.
+bool GetShapeValue(const NodeDef& node, const GraphProperties& properties,
+                   PartialTensorShape* shape) {
+  if (IsConstant(node)) {
+    Tensor value;
+    if (!value.FromProto(node.attr().at("value").tensor()) ||
+        value.dims() != 1) {
+      return false;
+    }
+    std::vector<int64> dims;
+    for (int i = 0; i < value.NumElements(); ++i) {
+      if (value.dtype() == DT_INT32) {
+        dims.push_back(value.vec<int32>()(i));
+      } else if (value.dtype() == DT_INT64) {
+        dims.push_back(value.vec<int64>()(i));
+      } else {
+        return false;
+      }
+    }
+    *shape = PartialTensorShape(dims);
+  } else if (node.op() == "Shape") {
+    std::vector<OpInfo::TensorProperties> input =
+        properties.GetInputProperties(node.name());
+    if (input.size() != 1) {
+      return false;
+    }
+    *shape = PartialTensorShape(input[0].shape());
+  } else {
+    return false;
+  }
+  return !shape->unknown_rank();
+}
+
+// Sets "reduction_indices" to the dimensions along which BroadcastGradientArgs
+// reduces the gradient of a tensor of shape "x" broadcast against a tensor of
+// shape "y", and returns false if they aren't known statically.
+bool GetReductionIndices(const PartialTensorShape& x,
+                         const PartialTensorShape& y,
+                         std::vector<int64>* reduction_indices) {
+  const int rank = std::max(x.dims(), y.dims());
+  // Broadcasting identical shapes doesn't reduce anything, not even their
+  // dimensions of size 1.
+  bool identical = x.dims() == y.dims();
+  bool maybe_identical = identical;
+  reduction_indices->clear();
+  for (int i = 0; i < rank; ++i) {
+    // The missing leading dimensions have size 1.
+    const int x_index = i - rank + x.dims();
+    const int y_index = i - rank + y.dims();
+    const int64 x_dim = x_index < 0 ? 1 : x.dim_size(x_index);
+    const int64 y_dim = y_index < 0 ? 1 : y.dim_size(y_index);
+    if (x_dim < 0) {
+      return false;
+    }
+    if (y_dim >= 0 && x_dim != y_dim && x_dim != 1 && y_dim != 1) {
+      // Leave the error to the BroadcastGradientArgs kernel.
+      return false;
+    }
+    if (x_dim == 1) {
+      reduction_indices->push_back(i);
+    }
+    identical &= x_dim == y_dim;
+    maybe_identical &= y_dim < 0 || x_dim == y_dim;
+  }
+  if (identical) {
+    reduction_indices->clear();
+  } else if (maybe_identical && !reduction_indices->empty()) {
+    return false;
+  }
+  return true;
+}
+
 }  // namespace
 
 ConstantFolding::ConstantFolding() {
@@ -144,8 +217,15 @@ string ConstantFolding::AddControlDependency(const string& input_name) {
 }
 
 Status ConstantFolding::MaterializeShapes(const GrapplerItem& item) {
-  GraphProperties properties(item);
-  TF_RETURN_IF_ERROR(properties.InferStatically());
+  properties_.reset(new GraphProperties(item));
+  Status status = properties_->InferStatically();
+  if (!status.ok()) {
+    // Fold the nodes whose inputs are constants anyway.
+    VLOG(1) << "Failed to infer the shapes of the graph: " << status;
+    properties_.reset();
+    return Status::OK();
+  }
+  const GraphProperties& properties = *properties_;
   // We may add some nodes to the graph to encode control dependencies: there is
   // no need to process these, so only iterate over the nodes of the input
   // graph.
@@ -232,9 +312,83 @@ Status ConstantFolding::MaterializeShapes(const GrapplerItem& item) {
       }
     }
   }
+  // The shapes materialized above may be the inputs of BroadcastGradientArgs
+  // nodes.
+  for (int i = 0; i < node_count; ++i) {
+    if (graph_.node(i).op() == "BroadcastGradientArgs") {
+      MaterializeBroadcastGradientArgs(graph_.node(i));
+    }
+  }
   return Status::OK();
 }
 
+void ConstantFolding::MaterializeBroadcastGradientArgs(const NodeDef& node) {
+  if (node.input_size() < 2 || IsControlInput(node.input(0)) ||
+      IsControlInput(node.input(1))) {
+    return;
+  }
+  const NodeDef* shape_nodes[2] = {node_map_->GetNode(node.input(0)),
+                                   node_map_->GetNode(node.input(1))};
+  std::vector<int64> reduction_indices[2];
+  bool known[2] = {false, false};
+  if (shape_nodes[0]->op() == "Shape" && shape_nodes[1]->op() == "Shape" &&
+      IsSameInput(shape_nodes[0]->input(0), shape_nodes[1]->input(0))) {
+    // The shapes are identical even if they aren't known.
+    known[0] = known[1] = true;
+  } else {
+    PartialTensorShape shapes[2];
+    if (!GetShapeValue(*shape_nodes[0], *properties_, &shapes[0]) ||
+        !GetShapeValue(*shape_nodes[1], *properties_, &shapes[1])) {
+      return;
+    }
+    known[0] = GetReductionIndices(shapes[0], shapes[1], &reduction_indices[0]);
+    known[1] = GetReductionIndices(shapes[1], shapes[0], &reduction_indices[1]);
+  }
+
+  const DataType type = node.attr().at("T").type();
+  for (int output = 0; output < 2; ++output) {
+    const string const_name = AddPrefixToNodeName(
+        strings::StrCat(node.name(), "-", output), kConstantFoldingConst);
+    if (!known[output] || node_map_->GetNode(const_name) != nullptr) {
+      continue;
+    }
+    const std::vector<int64>& indices = reduction_indices[output];
+    Tensor value(type, TensorShape({static_cast<int64>(indices.size())}));
+    for (int i = 0; i < indices.size(); ++i) {
+      if (type == DT_INT32) {
+        value.vec<int32>()(i) = indices[i];
+      } else {
+        value.vec<int64>()(i) = indices[i];
+      }
+    }
+    NodeDef* const_node = graph_.add_node();
+    const_node->set_name(const_name);
+    const_node->set_op("Const");
+    const_node->set_device(node.device());
+    (*const_node->mutable_attr())["dtype"].set_type(type);
+    value.AsProtoTensorContent(
+        (*const_node->mutable_attr())["value"].mutable_tensor());
+    // Like the materialized shapes, the constant must only be generated when
+    // the node would have run.
+    *const_node->add_input() = AddControlDependency(node.input(0));
+    *const_node->add_input() = AddControlDependency(node.input(1));
+    node_map_->AddNode(const_name, const_node);
+    node_map_->AddOutput(NodeName(node.input(0)), const_name);
+    node_map_->AddOutput(NodeName(node.input(1)), const_name);
+
+    for (NodeDef* consumer : node_map_->GetOutputs(node.name())) {
+      for (int i = 0; i < consumer->input_size(); ++i) {
+        int position;
+        if (ParseNodeName(consumer->input(i), &position) == node.name() &&
+            position == output) {
+          *consumer->mutable_input(i) = const_name;
+          node_map_->AddOutput(const_name, consumer->name());
+        }
+      }
+    }
+  }
+}
+
 bool ConstantFolding::IsFoldable(const NodeDef& node) const {
   // Skips nodes that must be preserved, and op_types that don't benefit from
   // folding
@@ -260,6 +414,18 @@ bool ConstantFolding::IsFoldable(const NodeDef& node) const {
     return false;
   }
 
+  // Don't create constants that would bloat the graph.
+  if (properties_ != nullptr) {
+    for (const auto& output : properties_->GetOutputProperties(node.name())) {
+      const PartialTensorShape shape(output.shape());
+      if (shape.IsFullyDefined() &&
+          shape.num_elements() * DataTypeSize(output.dtype()) >
+              kMaxConstantSize) {
+        return false;
+      }
+    }
+  }
+
   DeviceTypeVector device_types;
   status = SupportedDeviceTypesForNode({DeviceType(DEVICE_CPU)}, node,
                                        &device_types);
@@ -388,6 +554,15 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
   if (output_tensors.empty()) {
     Status(error::INVALID_ARGUMENT, "Expected at least one output.");
   }
+  for (const auto& output : output_tensors) {
+    if (output.tensor && output->TotalBytes() > kMaxConstantSize) {
+      // The shape wasn't known statically: leave the node as is.
+      for (const auto& output : output_tensors) {
+        delete output.tensor;
+      }
+      return Status::OK();
+    }
+  }
   for (int i = 0; i < output_tensors.size(); i++) {
     string node_name = AddPrefixToNodeName(node.name(), kConstantFoldingConst);
     if (output_tensors.size() > 1) {
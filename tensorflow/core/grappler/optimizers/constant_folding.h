@@ -19,6 +19,7 @@ limitations under the License.
 #include <regex>
 #include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/grappler/utils.h"
 
@@ -27,8 +28,13 @@ namespace grappler {
 
 const char kConstantFoldingConst[] = "ConstantFolding";
 const char kConstantFoldingCtrl[] = "ConstantFoldingCtrl";
+const int64 kMaxConstantSize = 10 * 1024 * 1024;
 
-// Constant folding optimization for a graph.
+// Constant folding optimization for a graph. The Shape, Size and Rank nodes,
+// and the outputs of BroadcastGradientArgs nodes, whose values follow from the
+// statically inferred shapes are replaced by constants first, so that their
+// consumers can be folded as well. No constant larger than kMaxConstantSize
+// bytes is created.
 class ConstantFolding : public GraphOptimizer {
  public:
   ConstantFolding();
@@ -46,6 +52,7 @@ class ConstantFolding : public GraphOptimizer {
  private:
   string AddControlDependency(const string& input_name);
   Status MaterializeShapes(const GrapplerItem& item);
+  void MaterializeBroadcastGradientArgs(const NodeDef& node);
 
   bool IsFoldable(const NodeDef& node) const;
 
@@ -68,6 +75,9 @@ class ConstantFolding : public GraphOptimizer {
   std::unique_ptr<DeviceBase> device_;
   GraphDef graph_;
   std::unique_ptr<NodeMap> node_map_;
+  // The statically inferred properties of the nodes of the input graph, or
+  // nullptr if the inference failed.
+  std::unique_ptr<GraphProperties> properties_;
   std::set<string> nodes_to_preserve_;
   std::regex ops_to_preserve_;
 };
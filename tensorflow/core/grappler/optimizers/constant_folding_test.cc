@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
+#include "tensorflow/cc/ops/array_ops_internal.h"
 #include "tensorflow/cc/ops/standard_ops.h"
 #include "tensorflow/core/framework/node_def.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
@@ -323,6 +324,80 @@ TEST_F(ConstantFoldingTest, ShapeMaterialization) {
   EXPECT_EQ(3, found);
 }
 
+TEST_F(ConstantFoldingTest, BroadcastGradientArgsMaterialization) {
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(scope.WithOpName("x"), DT_FLOAT,
+                              ops::Placeholder::Shape({-1, 3}));
+  Output y = ops::Placeholder(scope.WithOpName("y"), DT_FLOAT,
+                              ops::Placeholder::Shape({3}));
+  Output shape_x = ops::Shape(scope.WithOpName("shape_x"), x);
+  Output shape_y = ops::Shape(scope.WithOpName("shape_y"), y);
+  Output shape_x2 = ops::Shape(scope.WithOpName("shape_x2"), x);
+  auto args1 = ops::internal::BroadcastGradientArgs(scope.WithOpName("args1"),
+                                                    shape_x, shape_y);
+  auto args2 = ops::internal::BroadcastGradientArgs(scope.WithOpName("args2"),
+                                                    shape_x, shape_x2);
+  ops::Identity(scope.WithOpName("r1_x"), args1.r0);
+  ops::Identity(scope.WithOpName("r1_y"), args1.r1);
+  ops::Identity(scope.WithOpName("r2_x"), args2.r0);
+  ops::Identity(scope.WithOpName("r2_y"), args2.r1);
+
+  GrapplerItem item;
+  item.fetch = {"r1_x", "r1_y", "r2_x", "r2_y"};
+  TF_CHECK_OK(scope.ToGraphDef(&item.graph));
+
+  ConstantFolding fold;
+  GraphDef output;
+  Status status = fold.Optimize(nullptr, item, &output);
+  TF_EXPECT_OK(status);
+
+  std::map<string, const NodeDef*> nodes;
+  for (const auto& node : output.node()) {
+    nodes[node.name()] = &node;
+  }
+  // The dimensions of x along which its gradient is reduced depend on its
+  // unknown first dimension.
+  EXPECT_EQ("args1", nodes["r1_x"]->input(0));
+  // The reductions are known for the other inputs.
+  const std::vector<std::pair<string, int>> expected = {
+      {"r1_y", 1}, {"r2_x", 0}, {"r2_y", 0}};
+  for (const auto& reduction : expected) {
+    const NodeDef* node = nodes[nodes[reduction.first]->input(0)];
+    ASSERT_NE(nullptr, node);
+    EXPECT_EQ("Const", node->op());
+    Tensor value;
+    CHECK(value.FromProto(node->attr().at("value").tensor()));
+    ASSERT_EQ(reduction.second, value.NumElements());
+    if (reduction.second > 0) {
+      EXPECT_EQ(0, value.flat<int>()(0));
+    }
+  }
+}
+
+TEST_F(ConstantFoldingTest, LargeConstantsAreNotCreated) {
+  tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
+  Output dims = ops::Const(scope.WithOpName("dims"), {2048, 2048}, {2});
+  Output value = ops::Const(scope.WithOpName("value"), 1.0f, {});
+  Output fill = ops::Fill(scope.WithOpName("fill"), dims, value);
+  ops::Exp(scope.WithOpName("exp"), fill);
+
+  GrapplerItem item;
+  item.fetch.push_back("exp");
+  TF_CHECK_OK(scope.ToGraphDef(&item.graph));
+
+  ConstantFolding fold;
+  GraphDef output;
+  Status status = fold.Optimize(nullptr, item, &output);
+  TF_EXPECT_OK(status);
+
+  for (const auto& node : output.node()) {
+    if (node.name() == "exp") {
+      EXPECT_EQ("fill", node.input(0));
+    }
+    EXPECT_NE(AddPrefixToNodeName("fill", kConstantFoldingConst), node.name());
+  }
+}
+
 TEST_F(ConstantFoldingTest, SwitchNodes) {
   tensorflow::Scope scope = tensorflow::Scope::NewRootScope();
   ops::Variable v_in(scope.WithOpName("v_in"), {3}, DT_FLOAT);
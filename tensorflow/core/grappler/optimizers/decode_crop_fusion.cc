@@ -0,0 +1,285 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/decode_crop_fusion.h"
+#include <unordered_set>
+#include <vector>
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+const char kDecodeCropFusionPrefix[] = "DecodeCropFusion";
+
+NodeDef* AddInt32Const(const string& name, const Tensor& value,
+                       const string& device, GraphDef* graph) {
+  NodeDef* node = graph->add_node();
+  node->set_name(name);
+  node->set_op("Const");
+  node->set_device(device);
+  AttrValue attr_data_type;
+  attr_data_type.set_type(DT_INT32);
+  node->mutable_attr()->insert({"dtype", attr_data_type});
+  AttrValue attr_tensor;
+  value.AsProtoTensorContent(attr_tensor.mutable_tensor());
+  node->mutable_attr()->insert({"value", attr_tensor});
+  return node;
+}
+
+NodeDef* AddInt32Node(const string& name, const string& op,
+                      const std::vector<string>& inputs, const string& device,
+                      GraphDef* graph) {
+  NodeDef* node = graph->add_node();
+  node->set_name(name);
+  node->set_op(op);
+  node->set_device(device);
+  for (const string& input : inputs) {
+    node->add_input(input);
+  }
+  AttrValue attr_type;
+  attr_type.set_type(DT_INT32);
+  node->mutable_attr()->insert({"T", attr_type});
+  return node;
+}
+
+// Returns true if `node` has the attr `attr_name`, and it is `type`.
+bool HasTypeAttr(const NodeDef& node, const string& attr_name,
+                 DataType type) {
+  auto it = node.attr().find(attr_name);
+  return it != node.attr().end() && it->second.type() == type;
+}
+
+// Returns true if `node` has the attr `attr_name`, and it is `value`.
+bool HasIntAttr(const NodeDef& node, const string& attr_name, int64 value) {
+  auto it = node.attr().find(attr_name);
+  return it != node.attr().end() && it->second.i() == value;
+}
+
+// Returns true if `node` is a Shape node that is only used as the image size
+// of SampleDistortedBoundingBox nodes.
+bool IsShapeOfImageSize(const NodeDef& node, const NodeMap& node_map,
+                        const std::unordered_set<string>& nodes_to_preserve) {
+  if (node.op() != "Shape" || nodes_to_preserve.count(node.name()) > 0) {
+    return false;
+  }
+  for (int i = 1; i < node.input_size(); ++i) {
+    if (!IsControlInput(node.input(i))) {
+      return false;
+    }
+  }
+  const std::set<NodeDef*>& outputs = node_map.GetOutputs(node.name());
+  if (outputs.empty()) {
+    return false;
+  }
+  for (const NodeDef* output : outputs) {
+    if (output->op() != "SampleDistortedBoundingBox") {
+      return false;
+    }
+    for (int i = 1; i < output->input_size(); ++i) {
+      if (NodeName(output->input(i)) == node.name()) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+Status DecodeCropFusion::Optimize(Cluster* cluster, const GrapplerItem& item,
+                                  GraphDef* optimized_graph) {
+  GraphDef graph = item.graph;
+  NodeMap node_map(&graph);
+
+  std::unordered_set<string> nodes_to_preserve;
+  for (const auto& node : item.fetch) {
+    nodes_to_preserve.insert(NodeName(node));
+  }
+  for (const auto& node : item.init_ops) {
+    nodes_to_preserve.insert(NodeName(node));
+  }
+
+  std::unordered_set<string> nodes_to_delete;
+  const int num_nodes = graph.node_size();
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* slice = graph.mutable_node(i);
+    if (slice->op() != "Slice" || slice->input_size() < 3 ||
+        IsControlInput(slice->input(0)) || IsControlInput(slice->input(1)) ||
+        IsControlInput(slice->input(2)) ||
+        !HasTypeAttr(*slice, "Index", DT_INT32)) {
+      continue;
+    }
+
+    // The image must be decoded by a DecodeJpeg node, so that the full
+    // decode can be removed.
+    int position;
+    const string decode_name = ParseNodeName(slice->input(0), &position);
+    const NodeDef* decode = node_map.GetNode(decode_name);
+    if (position != 0 || decode == nullptr || decode->op() != "DecodeJpeg" ||
+        decode->input_size() < 1 || IsControlInput(decode->input(0)) ||
+        nodes_to_preserve.count(decode_name) > 0) {
+      continue;
+    }
+    // Besides the slice, the decoded image may only be used by the Shape
+    // nodes that feed the image size of SampleDistortedBoundingBox nodes,
+    // which only use its height and width. These are computed from the
+    // JPEG header instead, which requires the image not to be downscaled.
+    std::vector<NodeDef*> shapes;
+    bool has_other_outputs = false;
+    for (NodeDef* output : node_map.GetOutputs(decode_name)) {
+      if (output == slice) {
+        continue;
+      }
+      int shape_position;
+      if (output->input_size() > 0 &&
+          ParseNodeName(output->input(0), &shape_position) == decode_name &&
+          shape_position == 0 &&
+          IsShapeOfImageSize(*output, node_map, nodes_to_preserve) &&
+          HasIntAttr(*decode, "ratio", 1)) {
+        shapes.push_back(output);
+      } else {
+        has_other_outputs = true;
+      }
+    }
+    if (has_other_outputs) {
+      continue;
+    }
+
+    // The begin and size of the slice must come from a
+    // SampleDistortedBoundingBox node, which guarantees that they start at
+    // channel 0 and keep all the channels.
+    int begin_position;
+    int size_position;
+    const string bbox_name = ParseNodeName(slice->input(1), &begin_position);
+    const NodeDef* bbox = node_map.GetNode(bbox_name);
+    if (bbox == nullptr || bbox->op() != "SampleDistortedBoundingBox" ||
+        begin_position != 0 ||
+        ParseNodeName(slice->input(2), &size_position) != bbox_name ||
+        size_position != 1) {
+      continue;
+    }
+
+    const string prefix =
+        strings::StrCat(slice->name(), "/", kDecodeCropFusionPrefix);
+    const string crop_window_name = strings::StrCat(prefix, "/crop_window");
+    if (node_map.GetNode(crop_window_name) != nullptr) {
+      continue;
+    }
+    VLOG(1) << "Fusing " << decode_name << " and " << slice->name()
+            << " into a DecodeAndCropJpeg node";
+
+    // crop_window = [begin[0], begin[1], size[0], size[1]].
+    const string& device = decode->device();
+    Tensor zero(DT_INT32, TensorShape({1}));
+    zero.vec<int32>()(0) = 0;
+    Tensor two(DT_INT32, TensorShape({1}));
+    two.vec<int32>()(0) = 2;
+    Tensor axis(DT_INT32, TensorShape({}));
+    axis.scalar<int32>()() = 0;
+    const string zero_name = strings::StrCat(prefix, "/zero");
+    const string two_name = strings::StrCat(prefix, "/two");
+    const string axis_name = strings::StrCat(prefix, "/axis");
+    const string begin_name = strings::StrCat(prefix, "/begin");
+    const string size_name = strings::StrCat(prefix, "/size");
+    AddInt32Const(zero_name, zero, device, &graph);
+    AddInt32Const(two_name, two, device, &graph);
+    AddInt32Const(axis_name, axis, device, &graph);
+    AddInt32Node(begin_name, "Slice", {slice->input(1), zero_name, two_name},
+                 device, &graph)
+        ->mutable_attr()
+        ->insert({"Index", slice->attr().at("Index")});
+    AddInt32Node(size_name, "Slice", {slice->input(2), zero_name, two_name},
+                 device, &graph)
+        ->mutable_attr()
+        ->insert({"Index", slice->attr().at("Index")});
+    NodeDef* crop_window = AddInt32Node(
+        crop_window_name, "ConcatV2", {begin_name, size_name, axis_name},
+        device, &graph);
+    AttrValue attr_n;
+    attr_n.set_i(2);
+    crop_window->mutable_attr()->insert({"N", attr_n});
+    crop_window->mutable_attr()->insert({"Tidx", slice->attr().at("Index")});
+
+    // Turn the slice into the fused node, so that its consumers use the
+    // cropped image, and remove the decode.
+    std::vector<string> control_inputs;
+    for (int j = 1; j < decode->input_size(); ++j) {
+      control_inputs.push_back(decode->input(j));
+    }
+    for (int j = 3; j < slice->input_size(); ++j) {
+      control_inputs.push_back(slice->input(j));
+    }
+    const string contents = decode->input(0);
+    slice->set_op("DecodeAndCropJpeg");
+    slice->set_device(device);
+    *slice->mutable_attr() = decode->attr();
+    slice->clear_input();
+    slice->add_input(contents);
+    slice->add_input(crop_window_name);
+    for (const string& control_input : control_inputs) {
+      slice->add_input(control_input);
+    }
+    for (NodeDef* shape : shapes) {
+      AttrValue attr_output_type;
+      attr_output_type.set_type(HasTypeAttr(*shape, "out_type", DT_INT64)
+                                    ? DT_INT64
+                                    : DT_INT32);
+      std::vector<string> shape_inputs(shape->input().begin() + 1,
+                                       shape->input().end());
+      shape->set_op("ExtractJpegShape");
+      shape->mutable_attr()->clear();
+      shape->mutable_attr()->insert({"output_type", attr_output_type});
+      shape->clear_input();
+      shape->add_input(contents);
+      for (const string& control_input : shape_inputs) {
+        shape->add_input(control_input);
+      }
+      for (const string& control_input : control_inputs) {
+        shape->add_input(control_input);
+      }
+    }
+    nodes_to_delete.insert(decode_name);
+  }
+
+  for (const auto& node : graph.node()) {
+    if (nodes_to_delete.find(node.name()) == nodes_to_delete.end()) {
+      *optimized_graph->add_node() = node;
+    }
+  }
+  VLOG(1) << "Fused " << nodes_to_delete.size()
+          << " JPEG decodes with the crops of their images.";
+
+  *optimized_graph->mutable_library() = item.graph.library();
+  *optimized_graph->mutable_versions() = item.graph.versions();
+
+  return Status::OK();
+}
+
+void DecodeCropFusion::Feedback(Cluster* cluster, const GrapplerItem& item,
+                                const GraphDef& optimized_graph,
+                                double result) {
+  // Nothing to do for DecodeCropFusion.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
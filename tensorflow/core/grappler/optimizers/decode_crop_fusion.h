@@ -0,0 +1,51 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_DECODE_CROP_FUSION_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_DECODE_CROP_FUSION_H_
+
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Replaces the random crops of decoded JPEG images with DecodeAndCropJpeg
+// nodes, which only decode the cropped part of the images. The rewritten
+// pattern is the one of Inception-style data augmentation:
+//
+//   image = DecodeJpeg(contents)
+//   begin, size, _ = SampleDistortedBoundingBox(Shape(image), boxes)
+//   crop = Slice(image, begin, size)
+//
+// DecodeJpeg also decodes PNG and GIF images, unlike DecodeAndCropJpeg, so
+// this rewrite must only be enabled for pipelines that read JPEG images.
+class DecodeCropFusion : public GraphOptimizer {
+ public:
+  DecodeCropFusion() {}
+  ~DecodeCropFusion() override {}
+
+  string name() const override { return "decode_crop_fusion"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_DECODE_CROP_FUSION_H_
@@ -0,0 +1,136 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/decode_crop_fusion.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class DecodeCropFusionTest : public ::testing::Test {
+ protected:
+  // Builds the graph of an Inception-style random crop of a JPEG image, and
+  // returns the decoded image.
+  Output BuildCropGraph(Scope s) {
+    Output contents = ops::Placeholder(s.WithOpName("contents"), DT_STRING);
+    Output image = ops::DecodeJpeg(s.WithOpName("image"), contents,
+                                   ops::DecodeJpeg::Channels(3));
+    Output image_size = ops::Shape(s.WithOpName("image_size"), image);
+    Output boxes =
+        ops::Const(s.WithOpName("boxes"), {0.0f, 0.0f, 1.0f, 1.0f}, {1, 1, 4});
+    auto bbox = ops::SampleDistortedBoundingBox(s.WithOpName("bbox"),
+                                                image_size, boxes);
+    ops::Slice(s.WithOpName("crop"), image, bbox.begin, bbox.size);
+    return image;
+  }
+
+  const NodeDef* FindNode(const GraphDef& graph, const string& name) {
+    for (const NodeDef& node : graph.node()) {
+      if (node.name() == name) {
+        return &node;
+      }
+    }
+    return nullptr;
+  }
+};
+
+TEST_F(DecodeCropFusionTest, FusesRandomCrop) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  BuildCropGraph(s);
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"crop"};
+
+  DecodeCropFusion optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(nullptr, FindNode(output, "image"));
+
+  const NodeDef* crop = FindNode(output, "crop");
+  ASSERT_NE(nullptr, crop);
+  EXPECT_EQ("DecodeAndCropJpeg", crop->op());
+  ASSERT_EQ(2, crop->input_size());
+  EXPECT_EQ("contents", crop->input(0));
+  EXPECT_EQ(3, crop->attr().at("channels").i());
+
+  const NodeDef* crop_window = FindNode(output, NodeName(crop->input(1)));
+  ASSERT_NE(nullptr, crop_window);
+  EXPECT_EQ("ConcatV2", crop_window->op());
+
+  // The size of the image is read from its header instead.
+  const NodeDef* image_size = FindNode(output, "image_size");
+  ASSERT_NE(nullptr, image_size);
+  EXPECT_EQ("ExtractJpegShape", image_size->op());
+  ASSERT_EQ(1, image_size->input_size());
+  EXPECT_EQ("contents", image_size->input(0));
+}
+
+TEST_F(DecodeCropFusionTest, KeepsImageWithOtherUses) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output image = BuildCropGraph(s);
+  ops::Cast(s.WithOpName("float_image"), image, DT_FLOAT);
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"crop", "float_image"};
+
+  DecodeCropFusion optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // The decoded image is used by another node, so it must still be decoded
+  // in full.
+  ASSERT_EQ(item.graph.node_size(), output.node_size());
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    EXPECT_EQ(item.graph.node(i).name(), output.node(i).name());
+    EXPECT_EQ(item.graph.node(i).op(), output.node(i).op());
+  }
+}
+
+TEST_F(DecodeCropFusionTest, KeepsDownscaledImages) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output contents = ops::Placeholder(s.WithOpName("contents"), DT_STRING);
+  Output image = ops::DecodeJpeg(s.WithOpName("image"), contents,
+                                 ops::DecodeJpeg::Ratio(2));
+  Output image_size = ops::Shape(s.WithOpName("image_size"), image);
+  Output boxes =
+      ops::Const(s.WithOpName("boxes"), {0.0f, 0.0f, 1.0f, 1.0f}, {1, 1, 4});
+  auto bbox =
+      ops::SampleDistortedBoundingBox(s.WithOpName("bbox"), image_size, boxes);
+  ops::Slice(s.WithOpName("crop"), image, bbox.begin, bbox.size);
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"crop"};
+
+  DecodeCropFusion optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  // The header only gives the size of the full image.
+  const NodeDef* crop = FindNode(output, "crop");
+  ASSERT_NE(nullptr, crop);
+  EXPECT_EQ("Slice", crop->op());
+  EXPECT_NE(nullptr, FindNode(output, "image"));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -25,7 +25,9 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/layout_optimizer.h"
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/util/device_name_utils.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -123,6 +125,19 @@ class NodeProcessor {
 
   bool IsDimsFour(const NodeDef& node) const { return IsDimsN(node, 4); }
 
+  // The CPU kernels only support NHWC: the nodes placed on a CPU keep their
+  // layout, and the conversions are only added at the boundaries of the GPU
+  // subgraphs. Nodes that aren't placed yet are assumed to run on a GPU.
+  bool IsOnGPU() const {
+    DeviceNameUtils::ParsedName parsed_name;
+    if (node_->device().empty() ||
+        !DeviceNameUtils::ParseFullName(node_->device(), &parsed_name) ||
+        !parsed_name.has_type) {
+      return true;
+    }
+    return str_util::Lowercase(parsed_name.type) == "gpu";
+  }
+
   bool IsNHWC() const {
     if (node_->attr().find("data_format") != node_->attr().end()) {
       if (node_->attr().at("data_format").s().compare("NHWC") == 0) {
@@ -146,7 +161,7 @@ class NodeProcessor {
   }
 
   virtual bool ShouldProcess() const {
-    return IsNHWC() && IsDimsFour(*node_) && HasOutputs();
+    return IsNHWC() && IsDimsFour(*node_) && HasOutputs() && IsOnGPU();
   }
 
   void UpdateAttrDataFormat() {
@@ -234,6 +249,8 @@ class NodeProcessor {
     *node->add_input() = input_name;
     *node->add_input() = NHWCToNCHW ? kPermNHWCToNCHW : kPermNCHWToNHWC;
     node->set_op("Transpose");
+    // Transpose on the GPU, next to the node that uses or produces NCHW.
+    node->set_device(node_->device());
     AttrValue attr_data_type;
     attr_data_type.set_type(data_type);
     node->mutable_attr()->insert({"T", attr_data_type});
@@ -353,7 +370,7 @@ class BiasAddGradProcessor : public NodeProcessor {
  protected:
   bool ShouldProcess() const override {
     auto input = node_map_->GetNode(node_->input(0));
-    if (input) {
+    if (input && IsOnGPU()) {
       if ((IsNHWC() && IsDimsFour(*input)) || IsNodeNCHWToNHWC(input->name())) {
         return true;
       }
@@ -372,7 +389,7 @@ class Conv2DProcessor : public NodeProcessor {
 
  protected:
   bool ShouldProcess() const override {
-    return IsNHWC() && IsDimsFour(*node_) && HasOutputs() &&
+    return IsNHWC() && IsDimsFour(*node_) && HasOutputs() && IsOnGPU() &&
            (!IsGemmUsed() || no_gemm_);
   }
 
@@ -511,7 +528,8 @@ class AgnosticNodeProcessor : public NodeProcessor {
 
  protected:
   bool ShouldProcess() const override {
-    return IsDimsFour(*node_) && HasOutputs() && IsNodeAfterNCHWToNHWC();
+    return IsDimsFour(*node_) && HasOutputs() && IsOnGPU() &&
+           IsNodeAfterNCHWToNHWC();
   }
 
   bool IsNodeAfterNCHWToNHWC() const {
@@ -561,7 +579,8 @@ class BinaryOpProcessor : public AgnosticNodeProcessor {
 
  protected:
   bool ShouldProcess() const override {
-    return IsDimsFour(*node_) && HasOutputs() && IsNodeAfterNCHWToNHWC() &&
+    return IsDimsFour(*node_) && HasOutputs() && IsOnGPU() &&
+           IsNodeAfterNCHWToNHWC() &&
            (Is4DOperateWithND(4) || Is4DOperateWithScalar() ||
             Is4DOperateWithVector());
   }
@@ -667,8 +686,8 @@ class ConcatProcessor : public AgnosticNodeProcessor {
 
  protected:
   bool ShouldProcess() const override {
-    return IsDimsFour(*node_) && HasOutputs() && IsNodeAfterNCHWToNHWC() &&
-           IsAlongDimC();
+    return IsDimsFour(*node_) && HasOutputs() && IsOnGPU() &&
+           IsNodeAfterNCHWToNHWC() && IsAlongDimC();
   }
 
   std::vector<int> GetInputPos() const override {
@@ -834,8 +853,8 @@ class SqueezeProcessor : public AgnosticNodeProcessor {
 
  protected:
   bool ShouldProcess() const override {
-    return IsDimsN(*node_, 2) && HasOutputs() && IsNodeAfterNCHWToNHWC() &&
-           IsInputConvertible() && IsAlongDimHW();
+    return IsDimsN(*node_, 2) && HasOutputs() && IsOnGPU() &&
+           IsNodeAfterNCHWToNHWC() && IsInputConvertible() && IsAlongDimHW();
   }
 
   Status AddLayoutTransposeToOutputs() override { return Status::OK(); }
@@ -884,7 +903,7 @@ class SumProcessor : public AgnosticNodeProcessor {
  protected:
   bool ShouldProcess() const override {
     auto input0 = node_map_->GetNode(node_->input(0));
-    return HasOutputs() && IsNodeAfterNCHWToNHWC() &&
+    return HasOutputs() && IsOnGPU() && IsNodeAfterNCHWToNHWC() &&
            (IsDimsFour(*input0) || IsNodeNCHWToNHWC(input0->name())) &&
            IsAlongDimNHW();
   }
@@ -21,7 +21,8 @@ limitations under the License.
 namespace tensorflow {
 namespace grappler {
 
-// Convert the NHWC layout to NCHW for Conv-related ops on GPUs.
+// Convert the NHWC layout to NCHW for Conv-related ops on GPUs. The nodes
+// placed on CPUs keep the NHWC layout.
 class LayoutOptimizer : public GraphOptimizer {
  public:
   LayoutOptimizer() {}
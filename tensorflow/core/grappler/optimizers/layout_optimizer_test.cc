@@ -200,6 +200,47 @@ TEST_F(LayoutOptimizerTest, NotEqualSizeWithValidPadding) {
       node_map.GetNode("LayoutOptimizerTransposeNHWCToNCHW-Conv2D-Input"));
 }
 
+TEST_F(LayoutOptimizerTest, CPUNodesKeepTheirLayout) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(
+      "/job:localhost/replica:0/task:0/cpu:0");
+  auto conv = SimpleConv2D(&s, 3, 2, "VALID");
+  Output fetch = ops::Identity(s.WithOpName("Fetch"), {conv});
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  LayoutOptimizer optimizer;
+  optimizer.set_num_gpus(1);
+  GraphDef output;
+  Status status = optimizer.Optimize(nullptr, item, &output);
+  NodeMap node_map(&output);
+  EXPECT_FALSE(
+      node_map.GetNode("LayoutOptimizerTransposeNHWCToNCHW-Conv2D-Input"));
+  EXPECT_EQ("NHWC", node_map.GetNode("Conv2D")->attr().at("data_format").s());
+}
+
+TEST_F(LayoutOptimizerTest, TransposesAtGPUBoundary) {
+  const string gpu = "/job:localhost/replica:0/task:0/gpu:0";
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Scope gpu_scope = s.WithDevice(gpu);
+  auto conv = SimpleConv2D(&gpu_scope, 3, 2, "VALID");
+  auto relu = ops::Relu(
+      s.WithOpName("Relu").WithDevice("/job:localhost/replica:0/task:0/cpu:0"),
+      conv);
+  Output fetch = ops::Identity(s.WithOpName("Fetch"), {relu});
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  LayoutOptimizer optimizer;
+  optimizer.set_num_gpus(1);
+  GraphDef output;
+  Status status = optimizer.Optimize(nullptr, item, &output);
+  NodeMap node_map(&output);
+  EXPECT_EQ("NCHW", node_map.GetNode("Conv2D")->attr().at("data_format").s());
+  auto transpose =
+      node_map.GetNode("LayoutOptimizerTransposeNCHWToNHWC-Conv2D-Relu");
+  ASSERT_NE(nullptr, transpose);
+  EXPECT_EQ(gpu, transpose->device());
+  EXPECT_EQ(transpose->name(), node_map.GetNode("Relu")->input(0));
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
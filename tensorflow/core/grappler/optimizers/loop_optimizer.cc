@@ -0,0 +1,656 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
+
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+const char kLoopOptimizer[] = "LoopOptimizer";
+
+string GetFrameName(const NodeDef& enter) {
+  auto it = enter.attr().find("frame_name");
+  return it == enter.attr().end() ? "" : it->second.s();
+}
+
+string AsControlDependency(const string& input) {
+  return strings::StrCat("^", NodeName(input));
+}
+
+bool IsConstantEnter(const NodeDef& node) {
+  if (node.op() != "Enter") {
+    return false;
+  }
+  auto it = node.attr().find("is_constant");
+  return it != node.attr().end() && it->second.b();
+}
+
+// The while loop frames of a graph. The root frame is named "".
+struct Frames {
+  // The frame of each node.
+  std::unordered_map<const NodeDef*, string> frame;
+  // The frame enclosing each loop frame.
+  std::unordered_map<string, string> parent;
+  // An Enter node of each loop frame.
+  std::unordered_map<string, const NodeDef*> enter;
+
+  int Depth(const string& name) const {
+    int depth = 0;
+    for (string f = name; !f.empty(); f = parent.at(f)) {
+      ++depth;
+    }
+    return depth;
+  }
+};
+
+// Infers the frame of the nodes of "graph" the way the executor does, by
+// propagating them from the nodes without inputs, which are in the root
+// frame. Returns false if the frames are inconsistent.
+bool InferFrames(const GraphDef& graph, const NodeMap& node_map,
+                 Frames* frames) {
+  std::deque<const NodeDef*> ready;
+  for (const NodeDef& node : graph.node()) {
+    if (node.input_size() == 0) {
+      frames->frame[&node] = "";
+      ready.push_back(&node);
+    }
+  }
+  while (!ready.empty()) {
+    const NodeDef* node = ready.front();
+    ready.pop_front();
+    const string frame = frames->frame[node];
+    for (const NodeDef* output : node_map.GetOutputs(node->name())) {
+      if (frames->frame.count(output) > 0) {
+        continue;
+      }
+      string output_frame = frame;
+      if (IsEnter(*output)) {
+        output_frame = GetFrameName(*output);
+        if (output_frame.empty()) {
+          return false;
+        }
+        auto it = frames->parent.insert({output_frame, frame});
+        if (it.first->second != frame) {
+          return false;
+        }
+        frames->enter.insert({output_frame, output});
+      } else if (IsExit(*output)) {
+        if (frame.empty()) {
+          return false;
+        }
+        output_frame = frames->parent.at(frame);
+      }
+      frames->frame[output] = output_frame;
+      ready.push_back(output);
+    }
+  }
+  return true;
+}
+
+// Returns true if "node" always computes the same outputs from the same
+// inputs, so that it can be moved out of its loop.
+bool IsHoistable(const NodeDef& node) {
+  if (IsEnter(node) || IsExit(node) || IsMerge(node) || IsSwitch(node) ||
+      IsNextIteration(node) || IsLoopCond(node) ||
+      node.op() == "ControlTrigger") {
+    return false;
+  }
+  const OpDef* op_def = nullptr;
+  if (!OpRegistry::Global()->LookUpOpDef(node.op(), &op_def).ok() ||
+      op_def->is_stateful()) {
+    return false;
+  }
+  // The value behind a reference may be updated by the loop.
+  for (const auto& arg : op_def->input_arg()) {
+    if (arg.is_ref()) return false;
+  }
+  for (const auto& arg : op_def->output_arg()) {
+    if (arg.is_ref()) return false;
+  }
+  // So may the value of a resource, e.g. a variable read by ReadVariableOp
+  // or ResourceGather, which are not stateful themselves.
+  DataTypeVector input_types;
+  DataTypeVector output_types;
+  if (!InOutTypesForNode(node, *op_def, &input_types, &output_types).ok()) {
+    return false;
+  }
+  for (const DataTypeVector* types : {&input_types, &output_types}) {
+    if (std::find(types->begin(), types->end(), DT_RESOURCE) !=
+        types->end()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+class LoopInvariantHoister {
+ public:
+  LoopInvariantHoister(const std::unordered_set<string>& nodes_to_preserve,
+                       GraphDef* graph)
+      : nodes_to_preserve_(nodes_to_preserve), graph_(graph) {}
+
+  // Hoists the invariant nodes of one frame at a time, recomputing the
+  // frames after each change. Returns the number of hoisted nodes.
+  int HoistAll() {
+    for (const NodeDef& node : graph_->node()) {
+      node_names_.insert(node.name());
+    }
+    int num_hoisted = 0;
+    std::unordered_set<string> done;
+    while (true) {
+      NodeMap node_map(graph_);
+      Frames frames;
+      if (!InferFrames(*graph_, node_map, &frames)) {
+        VLOG(1) << "Can't infer the while loop frames of the graph";
+        return num_hoisted;
+      }
+      // Process the innermost loops first.
+      string next;
+      int next_depth = 0;
+      for (const auto& frame : frames.parent) {
+        const int depth = frames.Depth(frame.first);
+        if (done.count(frame.first) == 0 &&
+            (depth > next_depth ||
+             (depth == next_depth && frame.first < next))) {
+          next = frame.first;
+          next_depth = depth;
+        }
+      }
+      if (next.empty()) {
+        return num_hoisted;
+      }
+      done.insert(next);
+      num_hoisted += HoistFrame(next, frames, node_map);
+    }
+  }
+
+ private:
+  int HoistFrame(const string& frame, const Frames& frames,
+                 const NodeMap& node_map);
+  const string& GetEnter(const NodeDef& node, int port,
+                         const NodeDef& frame_enter);
+
+  const std::unordered_set<string>& nodes_to_preserve_;
+  GraphDef* graph_;
+  std::unordered_set<string> node_names_;
+  // The constant Enter nodes created for the outputs of the hoisted nodes,
+  // by frame and output.
+  std::unordered_map<string, string> enters_;
+};
+
+int LoopInvariantHoister::HoistFrame(const string& frame,
+                                     const Frames& frames,
+                                     const NodeMap& node_map) {
+  std::vector<NodeDef*> nodes;
+  for (int i = 0; i < graph_->node_size(); ++i) {
+    NodeDef* node = graph_->mutable_node(i);
+    auto it = frames.frame.find(node);
+    if (it != frames.frame.end() && it->second == frame &&
+        nodes_to_preserve_.count(node->name()) == 0 && IsHoistable(*node)) {
+      nodes.push_back(node);
+    }
+  }
+
+  // A node is invariant if its inputs are constant Enter nodes of the frame
+  // or other invariants. Constants are placed in the frame by a control
+  // dependency, which doesn't matter once they are hoisted.
+  std::unordered_set<const NodeDef*> invariants;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const NodeDef* node : nodes) {
+      if (invariants.count(node) > 0) {
+        continue;
+      }
+      bool invariant = true;
+      for (const string& input : node->input()) {
+        const NodeDef* input_node = node_map.GetNode(NodeName(input));
+        if (input_node == nullptr ||
+            (invariants.count(input_node) == 0 &&
+             !(IsConstantEnter(*input_node) &&
+               GetFrameName(*input_node) == frame) &&
+             !(IsControlInput(input) && IsConstant(*node)))) {
+          invariant = false;
+          break;
+        }
+      }
+      if (invariant) {
+        invariants.insert(node);
+        changed = true;
+      }
+    }
+  }
+
+  // Hoisting a constant or an identity by itself only adds an Enter node, so
+  // only the other invariants and their inputs are hoisted.
+  std::unordered_set<const NodeDef*> hoisted;
+  std::vector<const NodeDef*> to_visit;
+  for (const NodeDef* node : invariants) {
+    if (!IsConstant(*node) && !IsIdentity(*node)) {
+      to_visit.push_back(node);
+    }
+  }
+  while (!to_visit.empty()) {
+    const NodeDef* node = to_visit.back();
+    to_visit.pop_back();
+    if (!hoisted.insert(node).second) {
+      continue;
+    }
+    for (const string& input : node->input()) {
+      const NodeDef* input_node = node_map.GetNode(NodeName(input));
+      if (invariants.count(input_node) > 0) {
+        to_visit.push_back(input_node);
+      }
+    }
+  }
+  if (hoisted.empty()) {
+    return 0;
+  }
+
+  // Redirect the consumers left in the loop to new constant Enter nodes.
+  const NodeDef& frame_enter = *frames.enter.at(frame);
+  for (const NodeDef* node : nodes) {
+    if (hoisted.count(node) == 0) {
+      continue;
+    }
+    for (NodeDef* consumer : node_map.GetOutputs(node->name())) {
+      if (hoisted.count(consumer) > 0) {
+        continue;
+      }
+      for (int i = 0; i < consumer->input_size(); ++i) {
+        int port;
+        const string input = ParseNodeName(consumer->input(i), &port);
+        if (input != node->name()) {
+          continue;
+        }
+        if (port < 0) {
+          *consumer->mutable_input(i) =
+              AsControlDependency(GetEnter(*node, 0, frame_enter));
+        } else {
+          *consumer->mutable_input(i) = GetEnter(*node, port, frame_enter);
+        }
+      }
+    }
+  }
+
+  // Make the hoisted nodes read the values that enter the loop.
+  for (NodeDef* node : nodes) {
+    if (hoisted.count(node) == 0) {
+      continue;
+    }
+    std::vector<string> inputs;
+    std::vector<string> control_inputs;
+    for (const string& input : node->input()) {
+      const NodeDef* input_node = node_map.GetNode(NodeName(input));
+      if (hoisted.count(input_node) > 0) {
+        (IsControlInput(input) ? control_inputs : inputs).push_back(input);
+      } else if (IsConstantEnter(*input_node)) {
+        if (IsControlInput(input)) {
+          control_inputs.push_back(AsControlDependency(input_node->input(0)));
+        } else {
+          inputs.push_back(input_node->input(0));
+        }
+        for (int i = 1; i < input_node->input_size(); ++i) {
+          control_inputs.push_back(input_node->input(i));
+        }
+      }
+      // Otherwise this is the control dependency placing a constant in the
+      // frame.
+    }
+    if (IsConstant(*node) && !frames.parent.at(frame).empty()) {
+      // Place the constant in the enclosing loop instead.
+      control_inputs.push_back(AsControlDependency(frame_enter.input(0)));
+    }
+    node->clear_input();
+    for (const string& input : inputs) {
+      node->add_input(input);
+    }
+    for (const string& input : control_inputs) {
+      node->add_input(input);
+    }
+    VLOG(2) << "Hoisting " << node->name() << " out of " << frame;
+  }
+  VLOG(1) << "Hoisted " << hoisted.size() << " loop invariant nodes out of "
+          << frame;
+  return hoisted.size();
+}
+
+const string& LoopInvariantHoister::GetEnter(const NodeDef& node, int port,
+                                             const NodeDef& frame_enter) {
+  const string frame = GetFrameName(frame_enter);
+  const string output = strings::StrCat(node.name(), ":", port);
+  const string key = strings::StrCat(frame, "/", output);
+  auto it = enters_.find(key);
+  if (it != enters_.end()) {
+    return it->second;
+  }
+  DataTypeVector input_types;
+  DataTypeVector output_types;
+  const OpDef* op_def = nullptr;
+  OpRegistry::Global()->LookUpOpDef(node.op(), &op_def);
+  TF_CHECK_OK(InOutTypesForNode(node, *op_def, &input_types, &output_types));
+
+  const string base_name = AddPrefixToNodeName(
+      port == 0 ? node.name() : strings::StrCat(node.name(), "_", port),
+      kLoopOptimizer);
+  string name = base_name;
+  for (int i = 1; node_names_.count(name) > 0; ++i) {
+    name = strings::StrCat(base_name, "_", i);
+  }
+  node_names_.insert(name);
+
+  NodeDef* enter = graph_->add_node();
+  enter->set_name(name);
+  enter->set_op("Enter");
+  enter->set_device(node.device());
+  enter->add_input(port == 0 ? node.name() : output);
+  (*enter->mutable_attr())["T"].set_type(output_types[port]);
+  (*enter->mutable_attr())["frame_name"].set_s(frame);
+  (*enter->mutable_attr())["is_constant"].set_b(true);
+  auto parallel_iterations = frame_enter.attr().find("parallel_iterations");
+  if (parallel_iterations != frame_enter.attr().end()) {
+    (*enter->mutable_attr())["parallel_iterations"] =
+        parallel_iterations->second;
+  }
+  return enters_[key] = name;
+}
+
+// Returns in "value" the value of "tensor" if it is a boolean scalar.
+bool GetBoolScalar(const TensorProto& tensor, bool* value) {
+  Tensor t;
+  if (tensor.dtype() != DT_BOOL || !t.FromProto(tensor) ||
+      t.NumElements() != 1) {
+    return false;
+  }
+  *value = t.flat<bool>()(0);
+  return true;
+}
+
+// Removes the dead branches of the Switch nodes whose predicate is known.
+class DeadBranchRemover {
+ public:
+  DeadBranchRemover(const std::unordered_set<string>& nodes_to_preserve,
+                    const std::unordered_map<string, bool>& fixed_predicates,
+                    GraphDef* graph)
+      : nodes_to_preserve_(nodes_to_preserve),
+        fixed_predicates_(fixed_predicates),
+        graph_(graph) {}
+
+  // Resolves one Switch node at a time, recomputing the consumers of the nodes
+  // after each change. Returns the number of removed nodes.
+  int RemoveAll() {
+    int num_removed = 0;
+    std::unordered_set<string> done;
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      NodeMap node_map(graph_);
+      for (const NodeDef& node : graph_->node()) {
+        bool predicate;
+        if (!IsSwitch(node) || done.count(node.name()) > 0 ||
+            !GetPredicate(node, node_map, &predicate)) {
+          continue;
+        }
+        done.insert(node.name());
+        const int removed = RemoveDeadBranch(node.name(), predicate, node_map);
+        if (removed >= 0) {
+          num_removed += removed;
+          changed = true;
+          break;
+        }
+      }
+    }
+    return num_removed;
+  }
+
+ private:
+  bool GetPredicate(const NodeDef& switch_node, const NodeMap& node_map,
+                    bool* value) const {
+    if (switch_node.input_size() < 2 || IsControlInput(switch_node.input(1))) {
+      return false;
+    }
+    int port;
+    const string name = ParseNodeName(switch_node.input(1), &port);
+    auto fixed = fixed_predicates_.find(switch_node.input(1));
+    if (fixed == fixed_predicates_.end() && port == 0) {
+      fixed = fixed_predicates_.find(name);
+    }
+    if (fixed != fixed_predicates_.end()) {
+      *value = fixed->second;
+      return true;
+    }
+    const NodeDef* predicate = node_map.GetNode(name);
+    if (predicate == nullptr || !IsConstant(*predicate)) {
+      return false;
+    }
+    auto it = predicate->attr().find("value");
+    return it != predicate->attr().end() &&
+           GetBoolScalar(it->second.tensor(), value);
+  }
+
+  // Returns the number of removed nodes, or -1 if the branch can't be removed.
+  int RemoveDeadBranch(const string& switch_name, bool predicate,
+                       const NodeMap& node_map);
+
+  const std::unordered_set<string>& nodes_to_preserve_;
+  const std::unordered_map<string, bool>& fixed_predicates_;
+  GraphDef* graph_;
+};
+
+int DeadBranchRemover::RemoveDeadBranch(const string& switch_name,
+                                        bool predicate,
+                                        const NodeMap& node_map) {
+  // The Switch forwards its input to output 1 if the predicate is true, and to
+  // output 0 otherwise.
+  const int dead_port = predicate ? 0 : 1;
+  if (nodes_to_preserve_.count(switch_name) > 0) {
+    return -1;
+  }
+  std::unordered_set<const NodeDef*> dead;
+  auto is_dead = [&](const string& input) {
+    int port;
+    const string name = ParseNodeName(input, &port);
+    if (name == switch_name) {
+      return port == dead_port;
+    }
+    return dead.count(node_map.GetNode(name)) > 0;
+  };
+
+  // Propagates the deadness the way the executor does: a node with a dead
+  // input is dead, except for the Merge nodes, which are dead once all their
+  // data inputs are.
+  std::deque<NodeDef*> queue;
+  for (NodeDef* consumer : node_map.GetOutputs(switch_name)) {
+    for (const string& input : consumer->input()) {
+      // The control outputs of a Switch are never dead.
+      if (IsControlInput(input) && NodeName(input) == switch_name) {
+        return -1;
+      }
+    }
+    queue.push_back(consumer);
+  }
+  std::unordered_set<NodeDef*> merges;
+  while (!queue.empty()) {
+    NodeDef* node = queue.front();
+    queue.pop_front();
+    if (dead.count(node) > 0) {
+      continue;
+    }
+    bool has_dead_input = false;
+    int num_dead_data_inputs = 0;
+    int num_data_inputs = 0;
+    for (const string& input : node->input()) {
+      const bool is_control = IsControlInput(input);
+      num_data_inputs += !is_control;
+      if (!is_dead(input)) {
+        continue;
+      }
+      if (IsMerge(*node) && is_control) {
+        return -1;
+      }
+      has_dead_input = true;
+      num_dead_data_inputs += !is_control;
+    }
+    if (IsMerge(*node)) {
+      if (num_dead_data_inputs < num_data_inputs) {
+        if (has_dead_input) {
+          merges.insert(node);
+        }
+        continue;
+      }
+      merges.erase(node);
+    } else if (!has_dead_input) {
+      continue;
+    }
+    if (nodes_to_preserve_.count(node->name()) > 0 || IsEnter(*node) ||
+        IsExit(*node) || IsNextIteration(*node) || IsLoopCond(*node)) {
+      return -1;
+    }
+    dead.insert(node);
+    for (NodeDef* consumer : node_map.GetOutputs(node->name())) {
+      queue.push_back(consumer);
+    }
+  }
+
+  // The value_index output of the Merge nodes would be renumbered.
+  for (NodeDef* merge : merges) {
+    for (const NodeDef* consumer : node_map.GetOutputs(merge->name())) {
+      for (const string& input : consumer->input()) {
+        int port;
+        if (ParseNodeName(input, &port) == merge->name() && port == 1) {
+          return -1;
+        }
+      }
+    }
+  }
+
+  for (NodeDef* merge : merges) {
+    std::vector<string> inputs;
+    int num_data_inputs = 0;
+    for (const string& input : merge->input()) {
+      if (!is_dead(input)) {
+        inputs.push_back(input);
+        num_data_inputs += !IsControlInput(input);
+      }
+    }
+    merge->clear_input();
+    for (const string& input : inputs) {
+      merge->add_input(input);
+    }
+    if (num_data_inputs == 1) {
+      merge->set_op("Identity");
+      merge->mutable_attr()->erase("N");
+    } else {
+      (*merge->mutable_attr())["N"].set_i(num_data_inputs);
+    }
+  }
+
+  // The Switch becomes an Identity of its live output.
+  NodeDef* switch_node = node_map.GetNode(switch_name);
+  const string data_input = switch_node->input(0);
+  std::vector<string> control_inputs;
+  for (int i = 2; i < switch_node->input_size(); ++i) {
+    control_inputs.push_back(switch_node->input(i));
+  }
+  switch_node->set_op("Identity");
+  switch_node->clear_input();
+  switch_node->add_input(data_input);
+  for (const string& input : control_inputs) {
+    switch_node->add_input(input);
+  }
+  const string live_output = strings::StrCat(switch_name, ":", 1 - dead_port);
+  for (NodeDef* consumer : node_map.GetOutputs(switch_name)) {
+    if (dead.count(consumer) > 0) {
+      continue;
+    }
+    for (int i = 0; i < consumer->input_size(); ++i) {
+      if (consumer->input(i) == live_output) {
+        *consumer->mutable_input(i) = switch_name;
+      }
+    }
+  }
+
+  GraphDef kept;
+  for (NodeDef& node : *graph_->mutable_node()) {
+    if (dead.count(&node) == 0) {
+      kept.add_node()->Swap(&node);
+    }
+  }
+  graph_->mutable_node()->Swap(kept.mutable_node());
+  VLOG(2) << "Removed the " << dead.size() << " nodes of the dead branch of "
+          << switch_name;
+  return dead.size();
+}
+
+}  // namespace
+
+Status LoopOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
+                               GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+
+  std::unordered_set<string> nodes_to_preserve;
+  for (const auto& node : item.fetch) {
+    nodes_to_preserve.insert(NodeName(node));
+  }
+  for (const auto& feed : item.feed) {
+    nodes_to_preserve.insert(NodeName(feed.first));
+  }
+  for (const auto& node : item.init_ops) {
+    nodes_to_preserve.insert(NodeName(node));
+  }
+
+  std::unordered_map<string, bool> fixed_predicates;
+  for (const auto& feed : fixed_feeds_) {
+    if (feed.second.dtype() == DT_BOOL && feed.second.NumElements() == 1) {
+      fixed_predicates[feed.first] = feed.second.flat<bool>()(0);
+    }
+  }
+  DeadBranchRemover remover(nodes_to_preserve, fixed_predicates,
+                            optimized_graph);
+  const int num_removed = remover.RemoveAll();
+  VLOG(1) << "Removed " << num_removed << " nodes of dead branches";
+
+  LoopInvariantHoister hoister(nodes_to_preserve, optimized_graph);
+  const int num_hoisted = hoister.HoistAll();
+  VLOG(1) << "Hoisted " << num_hoisted << " nodes out of while loops";
+
+  return Status::OK();
+}
+
+void LoopOptimizer::Feedback(Cluster* cluster, const GrapplerItem& item,
+                             const GraphDef& optimized_graph, double result) {
+  // Nothing to do for LoopOptimizer.
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
@@ -0,0 +1,68 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_LOOP_OPTIMIZER_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_LOOP_OPTIMIZER_H_
+
+#include <utility>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Hoists the loop invariant computations out of the frames of while loops, so
+// that they run once instead of once per iteration. A node is invariant if it
+// is stateless and only depends on the constant Enter nodes of its frame
+// (is_constant=true) and on other invariant nodes. The hoisted nodes read the
+// inputs of the constant Enter nodes directly, and their consumers left in the
+// loop read their outputs through new constant Enter nodes.
+//
+// Nested loops are processed from the innermost one, so that a computation
+// invariant in several of them ends up outside of all of them.
+//
+// It first removes the branches of the conditionals whose predicate is known,
+// i.e. a boolean Const: the Switch node becomes an Identity of its live output,
+// the nodes that only depend on its dead output are deleted, and the Merge
+// nodes joining the branches only keep their live inputs.
+class LoopOptimizer : public GraphOptimizer {
+ public:
+  LoopOptimizer() {}
+  // Like the above, but also resolves the conditionals whose predicate is one
+  // of "fixed_feeds", whose value must be the same for every run of the
+  // optimized graph, e.g. a mode flag set by a serving signature.
+  explicit LoopOptimizer(
+      const std::vector<std::pair<string, Tensor>>& fixed_feeds)
+      : fixed_feeds_(fixed_feeds) {}
+  ~LoopOptimizer() override {}
+
+  string name() const override { return "loop_optimizer"; };
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+  void Feedback(Cluster* cluster, const GrapplerItem& item,
+                const GraphDef& optimized_graph, double result) override;
+
+ private:
+  std::vector<std::pair<string, Tensor>> fixed_feeds_;
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_LOOP_OPTIMIZER_H_
@@ -0,0 +1,319 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class LoopOptimizerTest : public ::testing::Test {
+ protected:
+  NodeDef* AddNode(const string& name, const string& op,
+                   const std::vector<string>& inputs, GraphDef* graph) {
+    NodeDef* node = graph->add_node();
+    node->set_name(name);
+    node->set_op(op);
+    for (const string& input : inputs) {
+      node->add_input(input);
+    }
+    (*node->mutable_attr())["T"].set_type(DT_FLOAT);
+    return node;
+  }
+
+  NodeDef* AddEnter(const string& name, const string& input,
+                    const string& frame, bool is_constant, GraphDef* graph) {
+    NodeDef* node = AddNode(name, "Enter", {input}, graph);
+    (*node->mutable_attr())["frame_name"].set_s(frame);
+    (*node->mutable_attr())["is_constant"].set_b(is_constant);
+    (*node->mutable_attr())["parallel_iterations"].set_i(10);
+    return node;
+  }
+
+  // Adds the nodes of a while loop named "frame" over the input "i", whose
+  // body is the output "frame/Identity".
+  void AddLoop(const string& frame, const string& i, GraphDef* graph) {
+    const string prefix = frame + "/";
+    AddEnter(prefix + "Enter", i, frame, false, graph);
+    AddNode(prefix + "Merge", "Merge",
+            {prefix + "Enter", prefix + "NextIteration"}, graph);
+    AddNode(prefix + "Less", "Less", {prefix + "Merge", prefix + "Merge"},
+            graph);
+    AddNode(prefix + "LoopCond", "LoopCond", {prefix + "Less"}, graph);
+    AddNode(prefix + "Switch", "Switch",
+            {prefix + "Merge", prefix + "LoopCond"}, graph);
+    AddNode(prefix + "Identity", "Identity", {prefix + "Switch:1"}, graph);
+    AddNode(prefix + "Exit", "Exit", {prefix + "Switch"}, graph);
+  }
+
+  // Adds a boolean scalar constant.
+  NodeDef* AddPredicate(const string& name, bool value, GraphDef* graph) {
+    NodeDef* node = AddNode(name, "Const", {}, graph);
+    (*node->mutable_attr())["dtype"].set_type(DT_BOOL);
+    BoolScalar(value).AsProtoTensorContent(
+        (*node->mutable_attr())["value"].mutable_tensor());
+    return node;
+  }
+
+  Tensor BoolScalar(bool value) {
+    Tensor tensor(DT_BOOL, TensorShape({}));
+    tensor.scalar<bool>()() = value;
+    return tensor;
+  }
+
+  const NodeDef* FindNode(const GraphDef& graph, const string& name) {
+    for (const NodeDef& node : graph.node()) {
+      if (node.name() == name) {
+        return &node;
+      }
+    }
+    return nullptr;
+  }
+};
+
+TEST_F(LoopOptimizerTest, HoistsInvariants) {
+  GrapplerItem item;
+  GraphDef* graph = &item.graph;
+  AddNode("i", "Placeholder", {}, graph);
+  AddNode("w", "Placeholder", {}, graph);
+  AddLoop("while", "i", graph);
+  AddEnter("while/Enter_w", "w", "while", true, graph);
+  AddNode("while/perm", "Const", {"^while/Identity"}, graph);
+  AddNode("while/transpose", "Transpose", {"while/Enter_w", "while/perm"},
+          graph);
+  AddNode("while/square", "Square", {"while/transpose"}, graph);
+  AddNode("while/mul", "Mul", {"while/Identity", "while/square"}, graph);
+  AddNode("while/NextIteration", "NextIteration", {"while/mul"}, graph);
+  item.fetch = {"while/Exit"};
+
+  LoopOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  const NodeDef* perm = FindNode(output, "while/perm");
+  ASSERT_NE(nullptr, perm);
+  EXPECT_EQ(0, perm->input_size());
+  const NodeDef* transpose = FindNode(output, "while/transpose");
+  ASSERT_NE(nullptr, transpose);
+  ASSERT_EQ(2, transpose->input_size());
+  EXPECT_EQ("w", transpose->input(0));
+  EXPECT_EQ("while/perm", transpose->input(1));
+  EXPECT_EQ("while/transpose", FindNode(output, "while/square")->input(0));
+
+  const NodeDef* mul = FindNode(output, "while/mul");
+  ASSERT_NE(nullptr, mul);
+  EXPECT_EQ("while/Identity", mul->input(0));
+  const NodeDef* enter = FindNode(output, mul->input(1));
+  ASSERT_NE(nullptr, enter);
+  EXPECT_EQ("Enter", enter->op());
+  EXPECT_EQ("while/square", enter->input(0));
+  EXPECT_EQ("while", enter->attr().at("frame_name").s());
+  EXPECT_TRUE(enter->attr().at("is_constant").b());
+  EXPECT_EQ(10, enter->attr().at("parallel_iterations").i());
+}
+
+TEST_F(LoopOptimizerTest, KeepsVariantAndStatefulNodes) {
+  GrapplerItem item;
+  GraphDef* graph = &item.graph;
+  AddNode("i", "Placeholder", {}, graph);
+  AddNode("x", "Placeholder", {}, graph);
+  AddLoop("while", "i", graph);
+  AddEnter("while/Enter_x", "x", "while", true, graph);
+  AddNode("while/one", "Const", {"^while/Identity"}, graph);
+  AddNode("while/add", "Add", {"while/Identity", "while/one"}, graph);
+  // A fresh random value each iteration.
+  AddNode("while/random", "RandomUniform", {"while/Enter_x"}, graph);
+  AddNode("while/neg", "Neg", {"while/random"}, graph);
+  AddNode("while/sub", "Sub", {"while/add", "while/neg"}, graph);
+  AddNode("while/NextIteration", "NextIteration", {"while/sub"}, graph);
+  item.fetch = {"while/Exit"};
+
+  LoopOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  EXPECT_EQ("^while/Identity", FindNode(output, "while/one")->input(0));
+  EXPECT_EQ("while/Enter_x", FindNode(output, "while/random")->input(0));
+  EXPECT_EQ("while/random", FindNode(output, "while/neg")->input(0));
+}
+
+TEST_F(LoopOptimizerTest, KeepsResourceReads) {
+  GrapplerItem item;
+  GraphDef* graph = &item.graph;
+  AddNode("i", "Placeholder", {}, graph);
+  AddNode("v", "VarHandleOp", {}, graph);
+  AddNode("indices", "Placeholder", {}, graph);
+  AddLoop("while", "i", graph);
+  AddEnter("while/Enter_v", "v", "while", true, graph);
+  AddEnter("while/Enter_indices", "indices", "while", true, graph);
+  // The variable is updated every iteration, so its reads aren't invariant
+  // even though their inputs are constant Enter nodes.
+  NodeDef* assign = AddNode("while/assign", "AssignAddVariableOp",
+                            {"while/Enter_v", "while/Identity"}, graph);
+  (*assign->mutable_attr())["dtype"].set_type(DT_FLOAT);
+  NodeDef* read = AddNode("while/read", "ReadVariableOp",
+                          {"while/Enter_v", "^while/assign"}, graph);
+  (*read->mutable_attr())["dtype"].set_type(DT_FLOAT);
+  NodeDef* gather = AddNode("while/gather", "ResourceGather",
+                            {"while/Enter_v", "while/Enter_indices"}, graph);
+  (*gather->mutable_attr())["dtype"].set_type(DT_FLOAT);
+  (*gather->mutable_attr())["Tindices"].set_type(DT_INT32);
+  AddNode("while/square", "Square", {"while/gather"}, graph);
+  AddNode("while/mul", "Mul", {"while/read", "while/square"}, graph);
+  AddNode("while/NextIteration", "NextIteration", {"while/mul"}, graph);
+  item.fetch = {"while/Exit"};
+
+  LoopOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  EXPECT_EQ("while/Enter_v", FindNode(output, "while/read")->input(0));
+  const NodeDef* output_gather = FindNode(output, "while/gather");
+  EXPECT_EQ("while/Enter_v", output_gather->input(0));
+  EXPECT_EQ("while/Enter_indices", output_gather->input(1));
+  EXPECT_EQ("while/gather", FindNode(output, "while/square")->input(0));
+}
+
+TEST_F(LoopOptimizerTest, HoistsOutOfNestedLoops) {
+  GrapplerItem item;
+  GraphDef* graph = &item.graph;
+  AddNode("i", "Placeholder", {}, graph);
+  AddNode("w", "Placeholder", {}, graph);
+  AddLoop("outer", "i", graph);
+  AddEnter("outer/Enter_w", "w", "outer", true, graph);
+  AddLoop("inner", "outer/Identity", graph);
+  AddEnter("inner/Enter_w", "outer/Enter_w", "inner", true, graph);
+  AddEnter("inner/Enter_i", "outer/Identity", "inner", true, graph);
+  // Invariant in both loops.
+  AddNode("inner/exp", "Exp", {"inner/Enter_w"}, graph);
+  // Only invariant in the inner loop.
+  AddNode("inner/add", "Add", {"inner/Enter_i", "inner/exp"}, graph);
+  AddNode("inner/mul", "Mul", {"inner/Identity", "inner/add"}, graph);
+  AddNode("inner/NextIteration", "NextIteration", {"inner/mul"}, graph);
+  AddNode("outer/NextIteration", "NextIteration", {"inner/Exit"}, graph);
+  item.fetch = {"outer/Exit"};
+
+  LoopOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  const NodeDef* exp = FindNode(output, "inner/exp");
+  ASSERT_NE(nullptr, exp);
+  EXPECT_EQ("w", exp->input(0));
+  const NodeDef* add = FindNode(output, "inner/add");
+  ASSERT_NE(nullptr, add);
+  EXPECT_EQ("outer/Identity", add->input(0));
+  const NodeDef* outer_enter = FindNode(output, add->input(1));
+  ASSERT_NE(nullptr, outer_enter);
+  EXPECT_EQ("outer", outer_enter->attr().at("frame_name").s());
+  EXPECT_EQ("inner/exp", outer_enter->input(0));
+
+  const NodeDef* mul = FindNode(output, "inner/mul");
+  ASSERT_NE(nullptr, mul);
+  const NodeDef* inner_enter = FindNode(output, mul->input(1));
+  ASSERT_NE(nullptr, inner_enter);
+  EXPECT_EQ("inner", inner_enter->attr().at("frame_name").s());
+  EXPECT_EQ("inner/add", inner_enter->input(0));
+}
+
+TEST_F(LoopOptimizerTest, RemovesDeadBranches) {
+  GrapplerItem item;
+  GraphDef* graph = &item.graph;
+  AddNode("x", "Placeholder", {}, graph);
+  AddPredicate("pred", true, graph);
+  AddNode("cond/Switch", "Switch", {"x", "pred"}, graph);
+  AddNode("cond/neg", "Neg", {"cond/Switch"}, graph);
+  AddNode("cond/square", "Square", {"cond/neg"}, graph);
+  AddNode("cond/exp", "Exp", {"cond/Switch:1"}, graph);
+  AddNode("cond/Merge", "Merge", {"cond/square", "cond/exp"}, graph);
+  AddNode("out", "Identity", {"cond/Merge"}, graph);
+  item.fetch = {"out"};
+
+  LoopOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_EQ(nullptr, FindNode(output, "cond/neg"));
+  EXPECT_EQ(nullptr, FindNode(output, "cond/square"));
+  const NodeDef* switch_node = FindNode(output, "cond/Switch");
+  ASSERT_NE(nullptr, switch_node);
+  EXPECT_EQ("Identity", switch_node->op());
+  ASSERT_EQ(1, switch_node->input_size());
+  EXPECT_EQ("x", switch_node->input(0));
+  EXPECT_EQ("cond/Switch", FindNode(output, "cond/exp")->input(0));
+  const NodeDef* merge = FindNode(output, "cond/Merge");
+  ASSERT_NE(nullptr, merge);
+  EXPECT_EQ("Identity", merge->op());
+  ASSERT_EQ(1, merge->input_size());
+  EXPECT_EQ("cond/exp", merge->input(0));
+}
+
+TEST_F(LoopOptimizerTest, RemovesDeadBranchesOfFixedFeeds) {
+  GrapplerItem item;
+  GraphDef* graph = &item.graph;
+  AddNode("x", "Placeholder", {}, graph);
+  AddNode("is_training", "Placeholder", {}, graph);
+  AddNode("cond/Switch", "Switch", {"x", "is_training"}, graph);
+  AddNode("cond/neg", "Neg", {"cond/Switch"}, graph);
+  AddNode("cond/exp", "Exp", {"cond/Switch:1"}, graph);
+  AddNode("cond/Merge", "Merge", {"cond/neg", "cond/exp"}, graph);
+  AddNode("out", "Identity", {"cond/Merge"}, graph);
+  item.fetch = {"out"};
+
+  // Without a fixed value, the predicate is unknown.
+  LoopOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  EXPECT_EQ("Switch", FindNode(output, "cond/Switch")->op());
+
+  LoopOptimizer fixed_optimizer({{"is_training", BoolScalar(false)}});
+  TF_EXPECT_OK(fixed_optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(nullptr, FindNode(output, "cond/exp"));
+  EXPECT_EQ("Identity", FindNode(output, "cond/Switch")->op());
+  EXPECT_EQ("cond/Switch", FindNode(output, "cond/neg")->input(0));
+  EXPECT_EQ("cond/neg", FindNode(output, "cond/Merge")->input(0));
+}
+
+TEST_F(LoopOptimizerTest, KeepsDeadBranchesWithFetchedNodes) {
+  GrapplerItem item;
+  GraphDef* graph = &item.graph;
+  AddNode("x", "Placeholder", {}, graph);
+  AddPredicate("pred", false, graph);
+  AddNode("cond/Switch", "Switch", {"x", "pred"}, graph);
+  AddNode("cond/neg", "Neg", {"cond/Switch"}, graph);
+  AddNode("cond/exp", "Exp", {"cond/Switch:1"}, graph);
+  AddNode("cond/Merge", "Merge", {"cond/neg", "cond/exp"}, graph);
+  item.fetch = {"cond/Merge", "cond/exp"};
+
+  LoopOptimizer optimizer;
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(nullptr, item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  EXPECT_EQ("Switch", FindNode(output, "cond/Switch")->op());
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
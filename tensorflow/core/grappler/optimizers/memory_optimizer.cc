@@ -23,8 +23,12 @@ limitations under the License.
 
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/costs/graph_memory.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/utils.h"
 #include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/op_types.h"
 #include "tensorflow/core/grappler/optimizers/graph_rewriter.h"
 #include "tensorflow/core/grappler/optimizers/static_schedule.h"
 #include "tensorflow/core/grappler/utils.h"
@@ -435,7 +439,8 @@ void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
                  (cheap_to_recompute_ops.count(node.op()) > 0 ||
                   node.attr().count(kRecomputeHint) > 0);
         });
-  } else {  // optimization_level == RewriterConfig::MANUAL
+  } else {
+    // MANUAL, or RECOMPUTATION_HEURISTICS once it has added the hints.
     recomputed_subgraphs =
         GetOpGroupsToRecompute(graph, node_map, [](const NodeDef& node) {
           return !IsTargetOp(node) && node.attr().count(kRecomputeHint) > 0;
@@ -578,12 +583,247 @@ static const NodeDef* FindSwapTrigger(
   return nullptr;
 }
 
+// Looks for the activations that are held in the memory of a GPU at the time
+// it reaches its peak memory usage, although their forward consumers are done
+// and their backward consumers aren't ready to run yet. The inputs of the
+// backward consumers are marked with the '_swap_to_host' attribute, starting
+// with the largest tensors, until the peak fits in the memory of the device.
+static Status IdentifySwappingCandidates(Cluster* cluster,
+                                         const GrapplerItem& item,
+                                         GraphDef* optimized_graph) {
+  if (cluster == nullptr) {
+    // The heuristic needs to know the devices and their memory.
+    return Status::OK();
+  }
+  std::unordered_map<const NodeDef*, Costs::NanoSeconds> execution_times;
+  TF_RETURN_IF_ERROR(
+      EstimateEarliestExecutionTimes(item, cluster, &execution_times));
+  std::unordered_map<string, Costs::NanoSeconds> completion_times;
+  for (const auto& execution_time : execution_times) {
+    completion_times[execution_time.first->name()] = execution_time.second;
+  }
+
+  GraphMemory memory(item);
+  TF_RETURN_IF_ERROR(memory.InferPeakMemoryUsage(cluster, completion_times));
+
+  NodeMap node_map(optimized_graph);
+  for (const auto& device : cluster->GetDevices()) {
+    if (device.second.type() != "GPU") {
+      continue;
+    }
+    const GraphMemory::MemoryUsage& peak =
+        memory.GetPeakMemoryUsage(device.first);
+    const int64 memory_limit = device.second.memory_size();
+    if (memory_limit <= 0 || peak.used_memory <= memory_limit) {
+      continue;
+    }
+    const Costs::NanoSeconds peak_time =
+        memory.GetPeakMemoryUsageTime(device.first);
+    int64 required_savings = peak.used_memory - memory_limit;
+    for (const GraphMemory::LiveTensor& tensor : peak.live_tensors) {
+      if (required_savings <= 0) {
+        break;
+      }
+      const NodeDef* producer = node_map.GetNode(tensor.node);
+      if (producer == nullptr || IsVariable(*producer) ||
+          IsConstant(*producer)) {
+        // Persistent tensors can't be released by swapping them.
+        continue;
+      }
+      bool used_before_peak = false;
+      bool already_swapped = false;
+      std::vector<std::pair<NodeDef*, int>> uses_after_peak;
+      for (NodeDef* consumer : node_map.GetOutputs(tensor.node)) {
+        auto it = completion_times.find(consumer->name());
+        if (it == completion_times.end()) {
+          continue;
+        }
+        for (int i = 0; i < consumer->input_size(); ++i) {
+          int position;
+          const string input = ParseNodeName(consumer->input(i), &position);
+          if (input != tensor.node || position != tensor.output_id) {
+            continue;
+          }
+          if (it->second <= peak_time) {
+            used_before_peak = true;
+          } else {
+            uses_after_peak.emplace_back(consumer, i);
+            if (consumer->attr().count("_swap_to_host") != 0) {
+              already_swapped = true;
+            }
+          }
+        }
+      }
+      if (!used_before_peak || uses_after_peak.empty() || already_swapped) {
+        continue;
+      }
+      for (const auto& use : uses_after_peak) {
+        AttrValue& val = (*use.first->mutable_attr())["_swap_to_host"];
+        val.mutable_list()->add_i(use.second);
+      }
+      VLOG(1) << "Swapping " << tensor.node << ":" << tensor.output_id
+              << " out of " << device.first << " to save "
+              << tensor.memory_used << " bytes";
+      required_savings -= tensor.memory_used;
+    }
+  }
+  return Status::OK();
+}
+
+// Looks for the cheap forward activations that are held in the memory of a
+// GPU at the time it reaches its peak memory usage, waiting for their gradient
+// consumers. Their producers are marked with the '_recompute_hint' attribute,
+// starting with the ones that free the most memory per nanosecond of
+// recomputation estimated by the OpLevelCostEstimator, until the peak fits in
+// the memory of the device.
+static Status IdentifyRecomputationCandidates(Cluster* cluster,
+                                              const GrapplerItem& item,
+                                              GraphDef* optimized_graph) {
+  if (cluster == nullptr) {
+    // The heuristic needs to know the devices and their memory.
+    return Status::OK();
+  }
+  std::unordered_map<const NodeDef*, Costs::NanoSeconds> execution_times;
+  TF_RETURN_IF_ERROR(
+      EstimateEarliestExecutionTimes(item, cluster, &execution_times));
+  std::unordered_map<string, Costs::NanoSeconds> completion_times;
+  for (const auto& execution_time : execution_times) {
+    completion_times[execution_time.first->name()] = execution_time.second;
+  }
+
+  GraphMemory memory(item);
+  TF_RETURN_IF_ERROR(memory.InferPeakMemoryUsage(cluster, completion_times));
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically());
+  std::unordered_map<string, const NodeDef*> name_to_node;
+  for (const NodeDef& node : item.graph.node()) {
+    name_to_node[node.name()] = &node;
+  }
+  const std::unordered_set<string> cheap_to_recompute_ops =
+      GetCheapToRecomputeOps();
+  OpLevelCostEstimator estimator;
+
+  NodeMap node_map(optimized_graph);
+  for (const auto& device : cluster->GetDevices()) {
+    if (device.second.type() != "GPU") {
+      continue;
+    }
+    const GraphMemory::MemoryUsage& peak =
+        memory.GetPeakMemoryUsage(device.first);
+    const int64 memory_limit = device.second.memory_size();
+    if (memory_limit <= 0 || peak.used_memory <= memory_limit) {
+      continue;
+    }
+    const Costs::NanoSeconds peak_time =
+        memory.GetPeakMemoryUsageTime(device.first);
+    std::unordered_set<string> live_at_peak;
+    for (const GraphMemory::LiveTensor& tensor : peak.live_tensors) {
+      live_at_peak.insert(tensor.node);
+    }
+
+    struct Candidate {
+      NodeDef* producer;
+      int64 memory_used;
+      double cost_per_byte;
+    };
+    std::vector<Candidate> candidates;
+    std::unordered_set<string> seen;
+    for (const GraphMemory::LiveTensor& tensor : peak.live_tensors) {
+      NodeDef* producer = node_map.GetNode(tensor.node);
+      if (producer == nullptr || IsTargetOp(*producer) ||
+          (cheap_to_recompute_ops.count(producer->op()) == 0 &&
+           producer->attr().count(kRecomputeHint) == 0) ||
+          !seen.insert(tensor.node).second) {
+        continue;
+      }
+      // The recomputation must not extend the lifetime of its own inputs.
+      bool inputs_held = true;
+      for (const string& input : producer->input()) {
+        if (IsControlInput(input)) {
+          continue;
+        }
+        const NodeDef* input_node = node_map.GetNode(NodeName(input));
+        if (input_node == nullptr ||
+            (live_at_peak.count(input_node->name()) == 0 &&
+             !IsVariable(*input_node) && !IsConstant(*input_node))) {
+          inputs_held = false;
+          break;
+        }
+      }
+      // Only the gradients are rewritten to use the recomputed value, so
+      // there is nothing to save if anything else reads it after the peak.
+      bool used_before_peak = false;
+      bool used_after_peak = false;
+      bool used_after_peak_by_forward_op = false;
+      for (const NodeDef* consumer : node_map.GetOutputs(tensor.node)) {
+        auto it = completion_times.find(consumer->name());
+        if (it == completion_times.end()) {
+          continue;
+        }
+        if (it->second <= peak_time) {
+          used_before_peak = true;
+        } else if (IsTargetOp(*consumer)) {
+          used_after_peak = true;
+        } else {
+          used_after_peak_by_forward_op = true;
+        }
+      }
+      if (!inputs_held || !used_before_peak || !used_after_peak ||
+          used_after_peak_by_forward_op) {
+        continue;
+      }
+      int64 memory_used = 0;
+      for (const GraphMemory::LiveTensor& output : peak.live_tensors) {
+        if (output.node == tensor.node) {
+          memory_used += output.memory_used;
+        }
+      }
+      OpInfo op_info = BuildOpInfoWithoutDevice(
+          *name_to_node.at(tensor.node), name_to_node,
+          properties.GetInputProperties(tensor.node));
+      *op_info.mutable_device() = device.second;
+      const Costs costs = estimator.PredictCosts(op_info);
+      candidates.push_back(
+          {producer, memory_used,
+           static_cast<double>(costs.execution_time.count()) /
+               std::max<int64>(memory_used, 1)});
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const Candidate& a, const Candidate& b) {
+                       return a.cost_per_byte < b.cost_per_byte;
+                     });
+
+    int64 required_savings = peak.used_memory - memory_limit;
+    for (const Candidate& candidate : candidates) {
+      if (required_savings <= 0) {
+        break;
+      }
+      (*candidate.producer->mutable_attr())[kRecomputeHint].set_i(0);
+      VLOG(1) << "Recomputing " << candidate.producer->name() << " on "
+              << device.first << " to save " << candidate.memory_used
+              << " bytes";
+      required_savings -= candidate.memory_used;
+    }
+  }
+  return Status::OK();
+}
+
 Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
                                  GraphDef* optimized_graph) {
   *optimized_graph = item.graph;
 
+  if (optimization_level_ == RewriterConfig::RECOMPUTATION_HEURISTICS) {
+    // The selected nodes are then recomputed like manually hinted ones.
+    TF_RETURN_IF_ERROR(
+        IdentifyRecomputationCandidates(cluster, item, optimized_graph));
+  }
   RecomputationRewritingPass(optimization_level_, optimized_graph);
 
+  if (optimization_level_ == RewriterConfig::SWAPPING_HEURISTICS) {
+    TF_RETURN_IF_ERROR(
+        IdentifySwappingCandidates(cluster, item, optimized_graph));
+  }
+
   // Figure out what needs to be swapped;
   std::unordered_map<NodeDef*, SwapInfo> nodes_to_swap;
   for (auto& node : *optimized_graph->mutable_node()) {
@@ -146,6 +146,51 @@ class MemoryOptimizerTest : public ::testing::Test {
     devices["/job:localhost/replica:0/task:0/cpu:0"] = cpu_device;
     return std::unique_ptr<VirtualCluster>(new VirtualCluster(devices));
   }
+
+  static std::unique_ptr<VirtualCluster> CreateVirtualGpuCluster(
+      int64 memory_size) {
+    DeviceProperties gpu_device;
+    gpu_device.set_type("GPU");
+    gpu_device.set_frequency(1000);
+    gpu_device.set_num_cores(24);
+    gpu_device.set_bandwidth(128);
+    gpu_device.set_memory_size(memory_size);
+    (*gpu_device.mutable_environment())["architecture"] = "6";
+    std::unordered_map<string, DeviceProperties> devices;
+    devices["/job:localhost/replica:0/task:0/gpu:0"] = gpu_device;
+    return std::unique_ptr<VirtualCluster>(new VirtualCluster(devices));
+  }
+
+  // A forward op 'b' whose output is needed again at the very end by 'e'.
+  static GrapplerItem CreateLongLivedActivationItem() {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(
+        "/job:localhost/replica:0/task:0/gpu:0");
+    Output a = ops::Const(s.WithOpName("a"), 0.0f, {10, 10});
+    Output b = ops::AddN(s.WithOpName("b"), {a});
+    Output c = ops::AddN(s.WithOpName("c"), {b});
+    Output d = ops::AddN(s.WithOpName("d"), {c});
+    Output e = ops::AddN(s.WithOpName("e"), {b, d});
+
+    GrapplerItem item;
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    return item;
+  }
+
+  // A cheap forward op 'b' whose output is needed again by the gradient 'e'.
+  static GrapplerItem CreateRecomputableActivationItem() {
+    tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(
+        "/job:localhost/replica:0/task:0/gpu:0");
+    Output a = ops::Const(s.WithOpName("a"), 0.0f, {10, 10});
+    Output b = ops::Relu(s.WithOpName("b"), a);
+    Output c = ops::Exp(s.WithOpName("c"), b);
+    Output d = ops::Exp(s.WithOpName("d"), c);
+    Output e = ops::AddN(s.WithOpName("gradients/e"), {b, d});
+
+    GrapplerItem item;
+    TF_CHECK_OK(s.ToGraphDef(&item.graph));
+    item.fetch = {"gradients/e"};
+    return item;
+  }
 };
 
 TEST_F(MemoryOptimizerTest, SimpleSwapping) {
@@ -193,6 +238,80 @@ TEST_F(MemoryOptimizerTest, SimpleSwapping) {
   EXPECT_EQ("^c", swap_in.input(1));
 }
 
+TEST_F(MemoryOptimizerTest, SwappingHeuristics) {
+  GrapplerItem item = CreateLongLivedActivationItem();
+  // Three 400 byte tensors are live at the peak, and only two of them fit.
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualGpuCluster(1000));
+
+  MemoryOptimizer optimizer(RewriterConfig::SWAPPING_HEURISTICS);
+  GraphDef output;
+  Status status = optimizer.Optimize(cluster.get(), item, &output);
+  TF_EXPECT_OK(status);
+
+  EXPECT_EQ(7, output.node_size());
+  NodeMap node_map(&output);
+  const NodeDef* new_e = node_map.GetNode("e");
+  EXPECT_EQ(2, new_e->input_size());
+  EXPECT_EQ("swap_in_e_0", new_e->input(0));
+  EXPECT_EQ("d", new_e->input(1));
+
+  const NodeDef* swap_out = node_map.GetNode("swap_out_e_0");
+  ASSERT_NE(nullptr, swap_out);
+  EXPECT_EQ("b", swap_out->input(0));
+  const NodeDef* swap_in = node_map.GetNode("swap_in_e_0");
+  ASSERT_NE(nullptr, swap_in);
+  EXPECT_EQ("swap_out_e_0", swap_in->input(0));
+  EXPECT_EQ("^c", swap_in->input(1));
+
+  // The forward use of b still reads it from the device.
+  EXPECT_EQ("b", node_map.GetNode("c")->input(0));
+}
+
+TEST_F(MemoryOptimizerTest, SwappingHeuristicsNotNeeded) {
+  GrapplerItem item = CreateLongLivedActivationItem();
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualGpuCluster(1 << 20));
+
+  MemoryOptimizer optimizer(RewriterConfig::SWAPPING_HEURISTICS);
+  GraphDef output;
+  Status status = optimizer.Optimize(cluster.get(), item, &output);
+  TF_EXPECT_OK(status);
+
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+  for (const NodeDef& node : output.node()) {
+    EXPECT_EQ(0, node.attr().count("_swap_to_host")) << node.name();
+  }
+}
+
+TEST_F(MemoryOptimizerTest, RecomputationHeuristics) {
+  GrapplerItem item = CreateRecomputableActivationItem();
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualGpuCluster(1000));
+
+  MemoryOptimizer optimizer(RewriterConfig::RECOMPUTATION_HEURISTICS);
+  GraphDef output;
+  Status status = optimizer.Optimize(cluster.get(), item, &output);
+  TF_EXPECT_OK(status);
+
+  NodeMap node_map(&output);
+  const NodeDef* recomputed_b = node_map.GetNode("Recomputed/b");
+  ASSERT_NE(nullptr, recomputed_b);
+  EXPECT_EQ("a", recomputed_b->input(0));
+  EXPECT_EQ("Recomputed/b", node_map.GetNode("gradients/e")->input(0));
+  // The forward use of b still reads the original.
+  EXPECT_EQ("b", node_map.GetNode("c")->input(0));
+}
+
+TEST_F(MemoryOptimizerTest, RecomputationHeuristicsNotNeeded) {
+  GrapplerItem item = CreateRecomputableActivationItem();
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualGpuCluster(1 << 20));
+
+  MemoryOptimizer optimizer(RewriterConfig::RECOMPUTATION_HEURISTICS);
+  GraphDef output;
+  Status status = optimizer.Optimize(cluster.get(), item, &output);
+  TF_EXPECT_OK(status);
+
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+}
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
@@ -16,12 +16,17 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/meta_optimizer.h"
 #include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/versions.pb.h"
+#include "tensorflow/core/grappler/optimizers/arithmetic_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/auto_parallel.h"
+#include "tensorflow/core/grappler/optimizers/bias_activation_fusion.h"
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
+#include "tensorflow/core/grappler/optimizers/decode_crop_fusion.h"
 #include "tensorflow/core/grappler/optimizers/graph_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/layout_optimizer.h"
+#include "tensorflow/core/grappler/optimizers/loop_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 #include "tensorflow/core/grappler/optimizers/model_pruner.h"
+#include "tensorflow/core/grappler/optimizers/optimization_cache.h"
 #include "tensorflow/core/grappler/utils/topological_sort.h"
 #include "tensorflow/core/lib/core/status.h"
 
@@ -38,9 +43,18 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::NewOptimizer(
   if (optimizer == "constfold") {
     graph_optimizer.reset(new ConstantFolding());
   }
+  if (optimizer == "arithmetic") {
+    graph_optimizer.reset(new ArithmeticOptimizer());
+  }
+  if (optimizer == "loop") {
+    graph_optimizer.reset(new LoopOptimizer());
+  }
   if (optimizer == "layout") {
     graph_optimizer.reset(new LayoutOptimizer());
   }
+  if (optimizer == "biasactivation") {
+    graph_optimizer.reset(new BiasActivationFusion());
+  }
   if (optimizer == "memory") {
     graph_optimizer.reset(new MemoryOptimizer(RewriterConfig::MANUAL));
   }
@@ -48,6 +62,9 @@ std::unique_ptr<GraphOptimizer> MetaOptimizer::NewOptimizer(
     graph_optimizer.reset(
         new AutoParallel(cfg_.auto_parallel().num_replicas()));
   }
+  if (optimizer == "decodecrop") {
+    graph_optimizer.reset(new DecodeCropFusion());
+  }
   return graph_optimizer;
 }
 
@@ -58,14 +75,30 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
     if (!cfg_.disable_model_pruning()) {
       optimizers.push_back(std::unique_ptr<GraphOptimizer>(new ModelPruner()));
     }
+    if (cfg_.fuse_decode_and_crop()) {
+      optimizers.push_back(
+          std::unique_ptr<GraphOptimizer>(new DecodeCropFusion()));
+    }
     if (cfg_.constant_folding()) {
       optimizers.push_back(
           std::unique_ptr<GraphOptimizer>(new ConstantFolding()));
     }
+    if (cfg_.arithmetic_optimization()) {
+      optimizers.push_back(
+          std::unique_ptr<GraphOptimizer>(new ArithmeticOptimizer()));
+    }
+    if (cfg_.loop_optimization()) {
+      optimizers.push_back(
+          std::unique_ptr<GraphOptimizer>(new LoopOptimizer()));
+    }
     if (cfg_.optimize_tensor_layout()) {
       optimizers.push_back(
           std::unique_ptr<GraphOptimizer>(new LayoutOptimizer()));
     }
+    if (!cfg_.disable_bias_activation_fusion()) {
+      optimizers.push_back(
+          std::unique_ptr<GraphOptimizer>(new BiasActivationFusion()));
+    }
     if (cfg_.memory_optimization() > 0) {
       optimizers.push_back(std::unique_ptr<GraphOptimizer>(
           new MemoryOptimizer(cfg_.memory_optimization())));
@@ -75,8 +108,10 @@ Status MetaOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
           new AutoParallel(cfg_.auto_parallel().num_replicas())));
     }
   } else {
-    std::set<string> available_optimizers = {"pruning", "constfold", "layout",
-                                             "memory", "autoparallel"};
+    std::set<string> available_optimizers = {
+        "pruning",    "constfold",    "arithmetic",   "loop",
+        "layout",     "memory",       "autoparallel", "decodecrop",
+        "biasactivation"};
     for (const auto& optimizer : cfg_.optimizers()) {
       if (available_optimizers.find(optimizer) != available_optimizers.end()) {
         optimizers.push_back(NewOptimizer(optimizer));
@@ -121,14 +156,28 @@ void MetaOptimizer::Feedback(Cluster* cluster, const GrapplerItem& item,
 
 bool MetaOptimizerEnabled(const RewriterConfig& cfg) {
   return cfg.optimize_tensor_layout() || cfg.constant_folding() ||
+         cfg.arithmetic_optimization() || cfg.loop_optimization() ||
          cfg.auto_parallel().enable() || cfg.memory_optimization() > 0 ||
-         !cfg.optimizers().empty();
+         cfg.fuse_decode_and_crop() || !cfg.optimizers().empty();
 }
 
 Status RunMetaOptimizer(const GrapplerItem& item, const RewriterConfig& cfg,
                         Cluster* cluster, GraphDef* optimized_graph) {
+  OptimizationCache* cache = OptimizationCache::Global();
+  string key;
+  if (cache != nullptr) {
+    key = OptimizationCache::Fingerprint(item, cfg, cluster);
+    if (cache->Lookup(key, optimized_graph)) {
+      VLOG(1) << "Reusing the cached optimized graph " << key;
+      return Status::OK();
+    }
+  }
   MetaOptimizer optimizer(cfg);
-  return optimizer.Optimize(cluster, item, optimized_graph);
+  TF_RETURN_IF_ERROR(optimizer.Optimize(cluster, item, optimized_graph));
+  if (cache != nullptr) {
+    cache->Insert(key, *optimized_graph);
+  }
+  return Status::OK();
 }
 
 }  // namespace grappler
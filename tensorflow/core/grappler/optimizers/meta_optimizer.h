@@ -45,6 +45,8 @@ class MetaOptimizer : public GraphOptimizer {
 
 bool MetaOptimizerEnabled(const RewriterConfig& cfg);
 
+// Optimizes item with a MetaOptimizer, or reuses the graph it was optimized
+// into before (see OptimizationCache).
 Status RunMetaOptimizer(const GrapplerItem& item, const RewriterConfig& cfg,
                         Cluster* cluster, GraphDef* optimized_graph);
 
@@ -0,0 +1,212 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimization_cache.h"
+
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/protobuf.h"
+#include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+// Appends the serialization of proto to *out, with the entries of its maps
+// (e.g. the attrs of the nodes) in a deterministic order.
+template <typename T>
+void AppendDeterministicSerialization(const T& proto, string* out) {
+  string serialized;
+  {
+    protobuf::io::StringOutputStream string_stream(&serialized);
+    protobuf::io::CodedOutputStream output_stream(&string_stream);
+    output_stream.SetSerializationDeterministic(true);
+    proto.SerializeToCodedStream(&output_stream);
+  }
+  // Length-prefixed, so that the concatenation is unambiguous.
+  strings::StrAppend(out, serialized.size(), ":", serialized);
+}
+
+void AppendString(const string& s, string* out) {
+  strings::StrAppend(out, s.size(), ":", s);
+}
+
+}  // namespace
+
+OptimizationCache::OptimizationCache(Env* env, const string& cache_dir,
+                                     int64 capacity)
+    : env_(env), cache_dir_(cache_dir), capacity_(capacity) {}
+
+// static
+OptimizationCache* OptimizationCache::Global() {
+  static OptimizationCache* cache = []() -> OptimizationCache* {
+    int64 capacity = 16;
+    Status status =
+        ReadInt64FromEnvVar("TF_GRAPPLER_CACHE_CAPACITY", 16, &capacity);
+    if (!status.ok()) {
+      LOG(ERROR) << status.error_message();
+    }
+    const char* cache_dir = getenv("TF_GRAPPLER_CACHE_DIR");
+    if (capacity <= 0 && (cache_dir == nullptr || cache_dir[0] == '\0')) {
+      return nullptr;
+    }
+    return new OptimizationCache(Env::Default(),
+                                 cache_dir == nullptr ? "" : cache_dir,
+                                 std::max<int64>(capacity, 0));
+  }();
+  return cache;
+}
+
+// static
+string OptimizationCache::Fingerprint(const GrapplerItem& item,
+                                      const RewriterConfig& cfg,
+                                      const Cluster* cluster) {
+  // Graphs cached on disk must not outlive the optimizers that produced
+  // them.
+  string key_material;
+  AppendString(TF_VERSION_STRING, &key_material);
+  AppendString(tf_git_version(), &key_material);
+  AppendDeterministicSerialization(cfg, &key_material);
+  AppendDeterministicSerialization(item.graph, &key_material);
+  // The values of the feeds don't matter to the optimizers, only that they
+  // are fed.
+  strings::StrAppend(&key_material, item.feed.size(), ":");
+  for (const auto& feed : item.feed) {
+    AppendString(feed.first, &key_material);
+    strings::StrAppend(&key_material, feed.second.dtype(), ":");
+    TensorShapeProto shape;
+    feed.second.shape().AsProto(&shape);
+    AppendDeterministicSerialization(shape, &key_material);
+  }
+  strings::StrAppend(&key_material, item.fetch.size(), ":");
+  for (const string& fetch : item.fetch) {
+    AppendString(fetch, &key_material);
+  }
+  strings::StrAppend(&key_material, item.init_ops.size(), ":");
+  for (const string& init_op : item.init_ops) {
+    AppendString(init_op, &key_material);
+  }
+  if (cluster != nullptr) {
+    const auto& devices = cluster->GetDevices();
+    std::vector<string> device_names;
+    device_names.reserve(devices.size());
+    for (const auto& device : devices) {
+      device_names.push_back(device.first);
+    }
+    std::sort(device_names.begin(), device_names.end());
+    strings::StrAppend(&key_material, device_names.size(), ":");
+    for (const string& device_name : device_names) {
+      AppendString(device_name, &key_material);
+      AppendDeterministicSerialization(devices.at(device_name),
+                                       &key_material);
+    }
+  }
+  const Fprint128 fingerprint = Fingerprint128(key_material);
+  return strings::Printf("%016llx%016llx",
+                         static_cast<unsigned long long>(fingerprint.high64),
+                         static_cast<unsigned long long>(fingerprint.low64));
+}
+
+string OptimizationCache::CacheFilename(const string& key) const {
+  return io::JoinPath(cache_dir_, strings::StrCat(key, ".graph"));
+}
+
+bool OptimizationCache::Lookup(const string& key, GraphDef* optimized_graph) {
+  {
+    mutex_lock l(mu_);
+    auto it = graphs_.find(key);
+    if (it != graphs_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second.second);
+      *optimized_graph = it->second.first;
+      return true;
+    }
+  }
+  if (cache_dir_.empty()) {
+    return false;
+  }
+  const string filename = CacheFilename(key);
+  if (!env_->FileExists(filename).ok()) {
+    return false;
+  }
+  GraphDef graph;
+  Status status = ReadBinaryProto(env_, filename, &graph);
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not read the cached optimized graph " << filename
+                 << ": " << status;
+    return false;
+  }
+  VLOG(1) << "Read the optimized graph from " << filename;
+  mutex_lock l(mu_);
+  InsertInMemoryLocked(key, graph);
+  *optimized_graph = std::move(graph);
+  return true;
+}
+
+void OptimizationCache::Insert(const string& key,
+                               const GraphDef& optimized_graph) {
+  if (!cache_dir_.empty()) {
+    // Written to a temporary file first, so that concurrent readers (e.g.
+    // other processes starting up) never see a partial graph.
+    const string filename = CacheFilename(key);
+    const string temp_filename =
+        strings::StrCat(filename, ".tmp", env_->NowMicros());
+    Status status = env_->RecursivelyCreateDir(cache_dir_);
+    if (status.ok()) {
+      status = WriteBinaryProto(env_, temp_filename, optimized_graph);
+    }
+    if (status.ok()) {
+      status = env_->RenameFile(temp_filename, filename);
+    }
+    if (!status.ok()) {
+      LOG(WARNING) << "Could not cache the optimized graph in " << filename
+                   << ": " << status;
+      env_->DeleteFile(temp_filename).IgnoreError();
+    }
+  }
+  mutex_lock l(mu_);
+  InsertInMemoryLocked(key, optimized_graph);
+}
+
+void OptimizationCache::InsertInMemoryLocked(const string& key,
+                                             const GraphDef& optimized_graph) {
+  if (capacity_ == 0) {
+    return;
+  }
+  auto it = graphs_.find(key);
+  if (it != graphs_.end()) {
+    lru_.splice(lru_.begin(), lru_, it->second.second);
+    it->second.first = optimized_graph;
+    return;
+  }
+  if (static_cast<int64>(graphs_.size()) >= capacity_) {
+    graphs_.erase(lru_.back());
+    lru_.pop_back();
+  }
+  lru_.push_front(key);
+  graphs_.emplace(key, std::make_pair(optimized_graph, lru_.begin()));
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
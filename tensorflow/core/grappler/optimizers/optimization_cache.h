@@ -0,0 +1,92 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_GRAPPLER_OPTIMIZERS_OPTIMIZATION_CACHE_H_
+#define TENSORFLOW_GRAPPLER_OPTIMIZERS_OPTIMIZATION_CACHE_H_
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Keeps the graphs optimized by the meta-optimizer, so that optimizing the
+// same graph again (e.g. in every new session, or every time a server
+// restarts) is a lookup. Graphs are keyed by a fingerprint of everything the
+// optimizers depend on: the graph, feeds, fetches and init ops of the item,
+// the devices of the cluster, the rewriter config and the TensorFlow
+// version. The most recently used graphs are kept in memory, and all of them
+// are written to a directory if one is given, which keeps them across
+// processes.
+//
+// This class is thread-safe.
+class OptimizationCache {
+ public:
+  // Keeps up to capacity graphs in memory, and writes them to cache_dir
+  // unless it is empty.
+  OptimizationCache(Env* env, const string& cache_dir, int64 capacity);
+
+  // Returns the cache of the process, or nullptr if it is disabled. Its
+  // capacity is TF_GRAPPLER_CACHE_CAPACITY (16 by default), and its
+  // directory TF_GRAPPLER_CACHE_DIR (none by default). Setting both to
+  // nothing disables it.
+  static OptimizationCache* Global();
+
+  // Returns the key of the graph optimized from item with cfg for cluster,
+  // which may be null.
+  static string Fingerprint(const GrapplerItem& item,
+                            const RewriterConfig& cfg, const Cluster* cluster);
+
+  // Sets *optimized_graph and returns true if the graph of key is cached.
+  bool Lookup(const string& key, GraphDef* optimized_graph);
+
+  // Caches the graph of key.
+  void Insert(const string& key, const GraphDef& optimized_graph);
+
+ private:
+  string CacheFilename(const string& key) const;
+  // Adds the graph of key to the memory cache, evicting the least recently
+  // used graph if it is full.
+  void InsertInMemoryLocked(const string& key, const GraphDef& optimized_graph)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Env* const env_;
+  const string cache_dir_;
+  const int64 capacity_;
+
+  mutex mu_;
+  // The keys of the graphs in memory, the most recently used first.
+  std::list<string> lru_ GUARDED_BY(mu_);
+  std::unordered_map<string, std::pair<GraphDef, std::list<string>::iterator>>
+      graphs_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(OptimizationCache);
+};
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_GRAPPLER_OPTIMIZERS_OPTIMIZATION_CACHE_H_
@@ -0,0 +1,129 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/optimization_cache.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/grappler/clusters/virtual_cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/inputs/trivial_test_graph_input_yielder.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/device_properties.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class OptimizationCacheTest : public ::testing::Test {
+ protected:
+  GrapplerItem MakeItem() {
+    TrivialTestGraphInputYielder fake_input(4, 1, 10, false, {"CPU:0"});
+    GrapplerItem item;
+    CHECK(fake_input.NextItem(&item));
+    return item;
+  }
+
+  GraphDef MakeOptimizedGraph(const string& name) {
+    GraphDef graph;
+    graph.add_node()->set_name(name);
+    return graph;
+  }
+};
+
+TEST_F(OptimizationCacheTest, FingerprintCoversTheInputs) {
+  const GrapplerItem item = MakeItem();
+  RewriterConfig cfg;
+  const string key = OptimizationCache::Fingerprint(item, cfg, nullptr);
+  EXPECT_EQ(key, OptimizationCache::Fingerprint(item, cfg, nullptr));
+
+  GrapplerItem other_graph = item;
+  other_graph.graph.mutable_node(0)->set_device("/cpu:1");
+  EXPECT_NE(key, OptimizationCache::Fingerprint(other_graph, cfg, nullptr));
+
+  GrapplerItem other_fetch = item;
+  other_fetch.fetch.push_back("other");
+  EXPECT_NE(key, OptimizationCache::Fingerprint(other_fetch, cfg, nullptr));
+
+  GrapplerItem other_feed = item;
+  other_feed.feed.emplace_back("other", Tensor(DT_FLOAT, TensorShape({2})));
+  EXPECT_NE(key, OptimizationCache::Fingerprint(other_feed, cfg, nullptr));
+
+  RewriterConfig other_cfg;
+  other_cfg.set_constant_folding(true);
+  EXPECT_NE(key, OptimizationCache::Fingerprint(item, other_cfg, nullptr));
+
+  DeviceProperties cpu_device;
+  cpu_device.set_type("CPU");
+  VirtualCluster cluster({{"/CPU:0", cpu_device}});
+  const string cluster_key =
+      OptimizationCache::Fingerprint(item, cfg, &cluster);
+  EXPECT_NE(key, cluster_key);
+  cpu_device.set_num_cores(4);
+  VirtualCluster other_cluster({{"/CPU:0", cpu_device}});
+  EXPECT_NE(cluster_key,
+            OptimizationCache::Fingerprint(item, cfg, &other_cluster));
+}
+
+TEST_F(OptimizationCacheTest, FingerprintIgnoresTheFeedValues) {
+  GrapplerItem item = MakeItem();
+  item.feed.emplace_back("x", Tensor(DT_FLOAT, TensorShape({2})));
+  item.feed[0].second.flat<float>().setZero();
+  RewriterConfig cfg;
+  const string key = OptimizationCache::Fingerprint(item, cfg, nullptr);
+  item.feed[0].second.flat<float>().setConstant(1.0f);
+  EXPECT_EQ(key, OptimizationCache::Fingerprint(item, cfg, nullptr));
+}
+
+TEST_F(OptimizationCacheTest, EvictsTheLeastRecentlyUsedGraph) {
+  OptimizationCache cache(Env::Default(), "", 2);
+  GraphDef graph;
+  EXPECT_FALSE(cache.Lookup("a", &graph));
+
+  cache.Insert("a", MakeOptimizedGraph("a"));
+  cache.Insert("b", MakeOptimizedGraph("b"));
+  ASSERT_TRUE(cache.Lookup("a", &graph));
+  EXPECT_EQ("a", graph.node(0).name());
+
+  // "b" is the least recently used graph now.
+  cache.Insert("c", MakeOptimizedGraph("c"));
+  EXPECT_FALSE(cache.Lookup("b", &graph));
+  EXPECT_TRUE(cache.Lookup("a", &graph));
+  ASSERT_TRUE(cache.Lookup("c", &graph));
+  EXPECT_EQ("c", graph.node(0).name());
+}
+
+TEST_F(OptimizationCacheTest, KeepsTheGraphsOnDisk) {
+  const string cache_dir =
+      io::JoinPath(testing::TmpDir(), "optimization_cache_test");
+  {
+    OptimizationCache cache(Env::Default(), cache_dir, 0);
+    cache.Insert("a", MakeOptimizedGraph("a"));
+  }
+  OptimizationCache cache(Env::Default(), cache_dir, 1);
+  GraphDef graph;
+  ASSERT_TRUE(cache.Lookup("a", &graph));
+  EXPECT_EQ("a", graph.node(0).name());
+  EXPECT_FALSE(cache.Lookup("b", &graph));
+
+  // The graph read from disk is kept in memory too.
+  TF_CHECK_OK(Env::Default()->DeleteFile(io::JoinPath(cache_dir, "a.graph")));
+  ASSERT_TRUE(cache.Lookup("a", &graph));
+  EXPECT_EQ("a", graph.node(0).name());
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include <limits>
 #include <numeric>
 
 #include "tensorflow/core/kernels/aggregate_ops.h"
@@ -27,6 +28,10 @@ limitations under the License.
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/platform/logging.h"
 
+#if GOOGLE_CUDA
+#include "tensorflow/core/kernels/cuda_device_array.h"
+#endif  // GOOGLE_CUDA
+
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
@@ -35,6 +40,59 @@ typedef Eigen::GpuDevice GPUDevice;
 typedef Eigen::SyclDevice SYCLDevice;
 #endif // TENSORFLOW_USE_SYCL
 
+namespace {
+
+// Sums the inputs into output in a single pass over memory, on the devices
+// and for the types that have an N-ary kernel, which Supports() outputs of
+// num_elements elements.
+template <typename Device, typename T>
+struct AddNInOnePass {
+  static bool Supports(int64 num_elements) { return false; }
+  static void Compute(OpKernelContext* ctx, gtl::ArraySlice<const T*> inputs,
+                      Tensor* output) {}
+};
+
+template <typename T>
+struct AddNInOnePass<CPUDevice, T> {
+  static bool Supports(int64 num_elements) { return true; }
+  static void Compute(OpKernelContext* ctx, gtl::ArraySlice<const T*> inputs,
+                      Tensor* output) {
+    functor::AddNCpuFunctor<T>()(ctx->eigen_device<CPUDevice>(),
+                                 output->flat<T>().data(),
+                                 output->NumElements(), inputs);
+  }
+};
+
+#if GOOGLE_CUDA
+template <typename T>
+struct AddNInOnePassGpu {
+  static bool Supports(int64 num_elements) {
+    return num_elements <= std::numeric_limits<int32>::max();
+  }
+  static void Compute(OpKernelContext* ctx, gtl::ArraySlice<const T*> inputs,
+                      Tensor* output) {
+    CudaDeviceArrayOnHost<const T*> input_ptrs(ctx, inputs.size());
+    OP_REQUIRES_OK(ctx, input_ptrs.Init());
+    for (int i = 0; i < inputs.size(); ++i) {
+      input_ptrs.Set(i, inputs[i]);
+    }
+    OP_REQUIRES_OK(ctx, input_ptrs.Finalize());
+    functor::AddNGpuFunctor<T>()(ctx->eigen_device<GPUDevice>(),
+                                 output->flat<T>().data(),
+                                 static_cast<int32>(output->NumElements()),
+                                 input_ptrs.data());
+  }
+};
+
+#define DECLARE_GPU_SPEC(T) \
+  template <>               \
+  struct AddNInOnePass<GPUDevice, T> : AddNInOnePassGpu<T> {};
+TF_CALL_GPU_NUMBER_TYPES(DECLARE_GPU_SPEC);
+#undef DECLARE_GPU_SPEC
+#endif  // GOOGLE_CUDA
+
+}  // namespace
+
 template <typename Device, typename T>
 class AddNOp : public OpKernel {
  public:
@@ -86,6 +144,20 @@ class AddNOp : public OpKernel {
     functor2(ctx->template eigen_device<Device>(), To, I(0), I(1));
 #else
     static const int kWidth = 8;
+
+    // Past kWidth + 1 inputs the chunked sum below makes several passes over
+    // the output, so sum them all at once where possible.
+    const int64 num_elements = output->NumElements();
+    if (num > kWidth + 1 && num_elements > 0 &&
+        AddNInOnePass<Device, T>::Supports(num_elements)) {
+      gtl::InlinedVector<const T*, 16> inputs(num);
+      for (int i = 0; i < num; ++i) {
+        inputs[i] = ctx->input(input_indices[i]).flat<T>().data();
+      }
+      AddNInOnePass<Device, T>::Compute(ctx, inputs, output);
+      return;
+    }
+
     int r = num % kWidth;
 
     switch (r) {
@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/kernels/cuda_device_array_gpu.h"
 
 namespace tensorflow {
 namespace functor {
@@ -220,6 +221,16 @@ struct Add9EigenImpl {
   }
 };
 
+#if GOOGLE_CUDA
+// Sums the inputs, of size elements each, into out in a single kernel that
+// reads every element of every input once. out may be the first input.
+template <typename T>
+struct AddNGpuFunctor {
+  void operator()(const Eigen::GpuDevice& d, T* out, int32 size,
+                  const CudaDeviceArrayStruct<const T*>& inputs);
+};
+#endif  // GOOGLE_CUDA
+
 }  // namespace functor
 }  // namespace tensorflow
 
@@ -16,8 +16,11 @@ limitations under the License.
 #ifndef TENSORFLOW_KERNELS_AGGREGATE_OPS_CPU_H_
 #define TENSORFLOW_KERNELS_AGGREGATE_OPS_CPU_H_
 
+#include <algorithm>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/lib/gtl/array_slice.h"
 
 #include "tensorflow/core/kernels/aggregate_ops.h"
 
@@ -137,6 +140,43 @@ struct Add9Functor<CPUDevice, T> {
   }
 };
 
+// The output is summed in tiles of this many bytes, which stay in L1 while
+// all the inputs are added to them.
+static const int64 kAddNCpuTileBytes = 8192;
+
+// Sums the inputs, of size elements each, into out one tile at a time, so
+// that out is written once instead of once per chunk of inputs. out may be
+// the first input.
+template <typename T>
+struct AddNCpuFunctor {
+  void operator()(const CPUDevice& d, T* out, int64 size,
+                  gtl::ArraySlice<const T*> inputs) {
+    typedef typename TTypes<T>::UnalignedFlat Flat;
+    typedef typename TTypes<T>::UnalignedConstFlat ConstFlat;
+    const int64 tile_size =
+        std::max<int64>(1, kAddNCpuTileBytes / static_cast<int64>(sizeof(T)));
+    const int64 num_tiles = (size + tile_size - 1) / tile_size;
+    const int64 num_inputs = inputs.size();
+    const Eigen::TensorOpCost cost(
+        num_inputs * tile_size * sizeof(T), tile_size * sizeof(T),
+        (num_inputs - 1) * tile_size * Eigen::TensorOpCost::AddCost<T>());
+    auto sum_tiles = [out, size, tile_size, inputs, num_inputs](int64 first,
+                                                                int64 last) {
+      for (int64 tile = first; tile < last; ++tile) {
+        const int64 start = tile * tile_size;
+        const int64 n = std::min(tile_size, size - start);
+        Flat out_tile(out + start, n);
+        out_tile =
+            ConstFlat(inputs[0] + start, n) + ConstFlat(inputs[1] + start, n);
+        for (int64 i = 2; i < num_inputs; ++i) {
+          out_tile += ConstFlat(inputs[i] + start, n);
+        }
+      }
+    };
+    d.parallelFor(num_tiles, cost, sum_tiles);
+  }
+};
+
 #ifdef TENSORFLOW_USE_SYCL
 // Partial specializations for a SYCLDevice, that uses the Eigen implementation
 // from AddNEigenImpl.
@@ -22,11 +22,33 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/cuda_kernel_helper.h"
 
 namespace tensorflow {
 
 typedef Eigen::GpuDevice GPUDevice;
 
+namespace {
+
+// Sums the inputs element by element, reading the addresses of the inputs
+// from input_ptr_data.
+template <typename T>
+__global__ void AddNKernel(const int32 size,
+                           CudaDeviceArrayStruct<const T*> input_ptr_data,
+                           T* out) {
+  const T** input_ptrs = GetCudaDeviceArrayOnDevice(&input_ptr_data);
+  const int32 num_inputs = input_ptr_data.size;
+  CUDA_1D_KERNEL_LOOP(i, size) {
+    T sum = input_ptrs[0][i];
+    for (int32 j = 1; j < num_inputs; ++j) {
+      sum += input_ptrs[j][i];
+    }
+    out[i] = sum;
+  }
+}
+
+}  // namespace
+
 // Partial specialization for a GPUDevice, that uses the Eigen implementation.
 namespace functor {
 template <typename T>
@@ -139,6 +161,15 @@ struct Add9Functor<GPUDevice, T> {
   }
 };
 
+template <typename T>
+void AddNGpuFunctor<T>::operator()(
+    const GPUDevice& d, T* out, int32 size,
+    const CudaDeviceArrayStruct<const T*>& inputs) {
+  CudaLaunchConfig config = GetCudaLaunchConfig(size, d);
+  AddNKernel<T><<<config.block_count, config.thread_per_block, 0,
+                  d.stream()>>>(size, inputs, out);
+}
+
 }  // end namespace functor
 
 // Instantiate the GPU implementation for GPU number types.
@@ -159,6 +190,14 @@ TF_CALL_complex128(REGISTER_FUNCTORS);
 
 #undef REGISTER_FUNCTORS
 
+// The single-pass kernel is only built for the real types.
+#define REGISTER_ADDN_FUNCTOR(type) \
+  template struct functor::AddNGpuFunctor<type>;
+
+TF_CALL_GPU_NUMBER_TYPES(REGISTER_ADDN_FUNCTOR);
+
+#undef REGISTER_ADDN_FUNCTOR
+
 }  // end namespace tensorflow
 
 #endif  // GOOGLE_CUDA
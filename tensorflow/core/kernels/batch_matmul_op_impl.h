@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/util/work_sharder.h"
 
 #if GOOGLE_CUDA
+#include "tensorflow/core/kernels/gpu_scratch_arena.h"
 #include "tensorflow/core/platform/stream_executor.h"
 #endif  // GOOGLE_CUDA
 
@@ -268,14 +269,21 @@ class CublasScratchAllocator : public perftools::gputools::ScratchAllocator {
   using Stream = ::perftools::gputools::Stream;
   using DeviceMemoryBytes = ::perftools::gputools::DeviceMemory<uint8>;
 
-  CublasScratchAllocator(OpKernelContext* context) : context_(context) {}
+  CublasScratchAllocator(OpKernelContext* context)
+      : context_(context), arena_lease_(context) {}
 
   int64 GetMemoryLimitInBytes(Stream* stream) override { return -1; }
 
   perftools::gputools::port::StatusOr<DeviceMemoryBytes> AllocateBytes(
       Stream* stream, int64 byte_size) override {
-    Tensor temporary_memory;
+    // Reuse the scratch arena of the stream if it is free.
+    uint8* arena_memory = arena_lease_.Allocate(stream, byte_size);
+    if (arena_memory != nullptr) {
+      return perftools::gputools::port::StatusOr<DeviceMemoryBytes>(
+          DeviceMemoryBytes::MakeFromByteSize(arena_memory, byte_size));
+    }
 
+    Tensor temporary_memory;
     Status allocation_status(context_->allocate_temp(
         DT_UINT8, TensorShape({byte_size}), &temporary_memory));
     if (!allocation_status.ok()) {
@@ -293,6 +301,7 @@ class CublasScratchAllocator : public perftools::gputools::ScratchAllocator {
 
  private:
   OpKernelContext* context_;
+  GpuScratchArenaLease arena_lease_;
   std::vector<Tensor> allocated_tensors_;
 };
 }  // namespace
@@ -0,0 +1,53 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/bias_activation_functor.h"
+
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+
+namespace tensorflow {
+
+Status GetFusedActivation(OpKernelConstruction* context,
+                          FusedActivation* activation) {
+  int num_args;
+  TF_RETURN_IF_ERROR(context->GetAttr("num_args", &num_args));
+  std::vector<string> fused_ops;
+  TF_RETURN_IF_ERROR(context->GetAttr("fused_ops", &fused_ops));
+  if (num_args != 1 || fused_ops.empty() || fused_ops.size() > 2 ||
+      fused_ops[0] != "BiasAdd") {
+    return errors::Unimplemented("Unsupported fused ops [",
+                                 str_util::Join(fused_ops, ", "), "] with ",
+                                 num_args, " arguments");
+  }
+  if (fused_ops.size() == 1) {
+    *activation = FusedActivation::kNone;
+  } else if (fused_ops[1] == "Relu") {
+    *activation = FusedActivation::kRelu;
+  } else if (fused_ops[1] == "Relu6") {
+    *activation = FusedActivation::kRelu6;
+  } else if (fused_ops[1] == "Elu") {
+    *activation = FusedActivation::kElu;
+  } else {
+    return errors::Unimplemented("Unsupported fused activation ",
+                                 fused_ops[1]);
+  }
+  return Status::OK();
+}
+
+}  // namespace tensorflow
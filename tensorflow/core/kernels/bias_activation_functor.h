@@ -0,0 +1,115 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_BIAS_ACTIVATION_FUNCTOR_H_
+#define TENSORFLOW_KERNELS_BIAS_ACTIVATION_FUNCTOR_H_
+// Functor definition for the bias and activation of _FusedConv2D and
+// _FusedMatMul, must be compilable by nvcc.
+
+#include <climits>
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+
+class OpKernelConstruction;
+
+// The activation that follows the bias of a fused kernel.
+enum class FusedActivation { kNone, kRelu, kRelu6, kElu };
+
+// Reads the "fused_ops" attr of a fused kernel, which must be "BiasAdd"
+// optionally followed by "Relu", "Relu6" or "Elu", and checks that the kernel
+// has a single extra argument, the bias.
+Status GetFusedActivation(OpKernelConstruction* context,
+                          FusedActivation* activation);
+
+namespace functor {
+
+template <typename Device, typename Output, typename Input>
+void ApplyActivation(const Device& d, FusedActivation activation,
+                     Output output, const Input& input) {
+  typedef typename Output::Scalar T;
+  switch (activation) {
+    case FusedActivation::kNone:
+      output.device(d) = input;
+      break;
+    case FusedActivation::kRelu:
+      output.device(d) = input.cwiseMax(static_cast<T>(0));
+      break;
+    case FusedActivation::kRelu6:
+      output.device(d) =
+          input.cwiseMax(static_cast<T>(0)).cwiseMin(static_cast<T>(6));
+      break;
+    case FusedActivation::kElu:
+      output.device(d) =
+          (input < static_cast<T>(0))
+              .select(input.exp() - input.constant(static_cast<T>(1)), input);
+      break;
+  }
+}
+
+template <typename Device, typename T, typename Index>
+void BiasActivationImpl(const Device& d, T* output_data, const T* bias_data,
+                        Index outer, Index depth, Index inner,
+                        FusedActivation activation) {
+  typedef Eigen::TensorMap<Eigen::Tensor<const T, 1, Eigen::RowMajor, Index>,
+                           Eigen::Aligned>
+      ConstVec;
+  ConstVec bias(bias_data, depth);
+  if (inner == 1) {
+    // The bias is added to the innermost dimension.
+    Eigen::TensorMap<Eigen::Tensor<T, 1, Eigen::RowMajor, Index>,
+                     Eigen::Aligned>
+        output(output_data, outer * depth);
+    Eigen::DSizes<Index, 1> bcast(outer);
+    ApplyActivation(d, activation, output, output + bias.broadcast(bcast));
+  } else {
+    Eigen::TensorMap<Eigen::Tensor<T, 3, Eigen::RowMajor, Index>,
+                     Eigen::Aligned>
+        output(output_data, outer, depth, inner);
+    Eigen::DSizes<Index, 3> bias_shape(1, depth, 1);
+    Eigen::DSizes<Index, 3> bcast(outer, 1, inner);
+    ApplyActivation(d, activation, output,
+                    output + bias.reshape(bias_shape).broadcast(bcast));
+  }
+}
+
+// Functor used by the fused kernels to add the bias and apply the activation
+// in a single pass over the output of the convolution or matrix product.
+template <typename Device, typename T>
+struct BiasActivation {
+  // Adds "bias" to the middle dimension of "output", and applies
+  // "activation", in place.
+  void operator()(const Device& d, typename TTypes<T, 3>::Tensor output,
+                  typename TTypes<T>::ConstVec bias,
+                  FusedActivation activation) {
+    if (output.size() < INT_MAX) {
+      BiasActivationImpl<Device, T, int>(
+          d, output.data(), bias.data(), static_cast<int>(output.dimension(0)),
+          static_cast<int>(output.dimension(1)),
+          static_cast<int>(output.dimension(2)), activation);
+    } else {
+      BiasActivationImpl<Device, T, Eigen::DenseIndex>(
+          d, output.data(), bias.data(), output.dimension(0),
+          output.dimension(1), output.dimension(2), activation);
+    }
+  }
+};
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_BIAS_ACTIVATION_FUNCTOR_H_
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/kernels/reduction_cpu_impl.h"
 #include "tensorflow/core/util/tensor_format.h"
 
 #if GOOGLE_CUDA
@@ -167,6 +168,28 @@ struct AccumulatorType<Eigen::half> {
 template <typename Device, typename T>
 class BiasGradOp;
 
+// Sums the columns of the 'rows' x 'cols' matrix 'in' into 'out' with the
+// column reduction of reduction_cpu_impl.h, when it supports T. Returns false
+// otherwise.
+template <typename T, bool kSupported = functor::MatrixReducerCPU<
+                          Eigen::internal::SumReducer<T>>::kSupported>
+struct BiasGradColumnSum {
+  static bool Run(const CPUDevice& d, const T* in, int64 rows, int64 cols,
+                  T* out) {
+    return false;
+  }
+};
+
+template <typename T>
+struct BiasGradColumnSum<T, true> {
+  static bool Run(const CPUDevice& d, const T* in, int64 rows, int64 cols,
+                  T* out) {
+    functor::ReduceMatrixColumnsCPU<Eigen::internal::SumReducer<T>>(
+        d, in, rows, cols, out);
+    return true;
+  }
+};
+
 template <typename T>
 class BiasGradOp<CPUDevice, T> : public OpKernel {
  public:
@@ -208,7 +231,10 @@ class BiasGradOp<CPUDevice, T> : public OpKernel {
     } else if (output_backprop.NumElements() == 0) {
       // Eigen often crashes by design on empty tensors, but setZero is safe
       output->template flat<T>().setZero();
-    } else {
+    } else if (!BiasGradColumnSum<T>::Run(
+                   context->eigen_device<CPUDevice>(),
+                   output_backprop.flat<T>().data(), batch * height * width,
+                   channel, output->template flat<T>().data())) {
       Eigen::DSizes<int, 2> two_dims(batch * height * width, channel);
 #ifdef EIGEN_HAS_INDEX_LIST
       Eigen::IndexList<Eigen::type2index<0> > reduction_axis;
@@ -12,10 +12,12 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <deque>
 
 #include "tensorflow/core/framework/partial_tensor_shape.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/dataset.h"
+#include "tensorflow/core/kernels/memmapped_dataset_cache.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
@@ -30,7 +32,9 @@ namespace {
 class CacheDatasetOp : public UnaryDatasetOpKernel {
  public:
   explicit CacheDatasetOp(OpKernelConstruction* ctx)
-      : UnaryDatasetOpKernel(ctx) {}
+      : UnaryDatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("num_shards", &num_shards_));
+  }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
                    DatasetBase** output) override {
@@ -42,16 +46,18 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
     if (filename.empty()) {
       *output = new MemoryDataset(input);
     } else {
-      *output = new FileDataset(input, filename, ctx->env());
+      *output = new FileDataset(input, filename, num_shards_, ctx->env());
     }
   }
 
  private:
   class FileDataset : public DatasetBase {
    public:
-    explicit FileDataset(const DatasetBase* input, string filename, Env* env)
+    explicit FileDataset(const DatasetBase* input, string filename,
+                         int64 num_shards, Env* env)
         : input_(input),
           filename_(std::move(filename)),
+          num_shards_(num_shards),
           env_(env),
           num_tensors_(input->output_dtypes().size()),
           tensor_index_padding_size_(StringPaddingSize(num_tensors_)),
@@ -65,9 +71,13 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
 
     ~FileDataset() override { input_->Unref(); }
 
-    std::unique_ptr<IteratorBase> MakeIterator() const override {
-      if (env_->FileExists(strings::StrCat(filename_, ".index")).ok()) {
+    std::unique_ptr<IteratorBase> MakeIteratorInternal() const override {
+      if (env_->FileExists(dataset::MemmappedCacheManifestFilename(filename_))
+              .ok()) {
         return std::unique_ptr<IteratorBase>(new FileReaderIterator(this));
+      } else if (env_->FileExists(strings::StrCat(filename_, ".index")).ok()) {
+        return std::unique_ptr<IteratorBase>(
+            new BundleFileReaderIterator(this));
       } else {
         return std::unique_ptr<IteratorBase>(new FileWriterIterator(this));
       }
@@ -96,62 +106,67 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
     // FileWriterIterator passes through and caches items from the input
     // FileDataset.
     //
-    // This iterator is used when the cache directory is not found on disk. It
-    // creates the cache directory, and passes on the underlying iterator's
-    // elements.
+    // This iterator is used when the cache is not found on disk. It passes on
+    // the underlying iterator's elements, and hands element `i` to the thread
+    // that writes shard `i % num_shards_`, so that the shards are written in
+    // parallel with each other and with the consumer of this iterator.
     class FileWriterIterator : public DatasetIterator<FileDataset> {
      public:
       explicit FileWriterIterator(const FileDataset* dataset)
           : DatasetIterator<FileDataset>(dataset),
             cur_index_(0),
             input_impl_(dataset->input_->MakeIterator()),
-            writer_(dataset->env_, dataset->filename_),
             lockfile_(strings::StrCat(dataset->filename_, ".lockfile")),
             lockfile_created_(false),
             iteration_completed_(false) {}
 
+      ~FileWriterIterator() override {
+        // Signal the writer threads to terminate them. We will then join
+        // those threads when we delete `this->shards_`. A cache that has not
+        // been completed has no manifest, so it will be written again.
+        mutex_lock l(write_mu_);
+        cancelled_ = true;
+        write_cond_var_.notify_all();
+      }
+
       Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
                      bool* end_of_sequence) override {
         mutex_lock l(mu_);
         TF_RETURN_IF_ERROR(EnsureLockFileExists());
-        TF_RETURN_IF_ERROR(writer_.status());
-        if (cur_index_ >= kMaxItems) {
-          // As a courtesy, close the [truncated] cache file.
-          Status s = Finish();
-          if (!s.ok()) {
-            LOG(ERROR) << s;
-          }
-          return errors::InvalidArgument(
-              "Upstream iterator is producing more than ", kMaxItems,
-              " items, which is more than the cache limit.");
-        }
+        TF_RETURN_IF_ERROR(EnsureWriterThreadsStarted());
 
         TF_RETURN_IF_ERROR(
             input_impl_->GetNext(ctx, out_tensors, end_of_sequence));
-        if (*end_of_sequence && out_tensors->empty()) {
-          TF_RETURN_IF_ERROR(Finish());
-          cur_index_++;
-          return Status::OK();
+        if (*end_of_sequence) {
+          return Finish();
         }
         if (out_tensors->size() != dataset()->num_tensors_) {
           return errors::Internal(
               "Upstream iterator returned invalid number of tensors. Expected ",
               dataset()->num_tensors_, " got: ", out_tensors->size());
         }
-        size_t tensor_index = 0;
-        for (const Tensor& t : *out_tensors) {
-          DCHECK_LT(tensor_index, dataset()->num_tensors_);
-          string key = dataset()->FormatName(cur_index_, tensor_index++);
-          TF_RETURN_IF_ERROR(writer_.Add(key, t));
-        }
-        if (*end_of_sequence) {
-          TF_RETURN_IF_ERROR(Finish());
-        }
+        TF_RETURN_IF_ERROR(
+            EnqueueElement(shards_[cur_index_ % shards_.size()].get(),
+                           *out_tensors));
         cur_index_++;
         return Status::OK();
       }
 
      private:
+      // The writer and buffered elements of one shard of the cache.
+      struct Shard {
+        std::unique_ptr<dataset::MemmappedCacheWriter> writer;
+        // Elements waiting to be written, guarded by `write_mu_`.
+        std::deque<std::vector<Tensor>> buffer;
+        // Declared last so that the thread is joined before the writer is
+        // destroyed.
+        std::unique_ptr<Thread> thread;
+      };
+
+      // The maximum number of elements buffered for each shard, which bounds
+      // the memory used when the writer threads fall behind.
+      static const size_t kMaxBufferedElements = 16;
+
       Status EnsureLockFileExists() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         if (iteration_completed_)
           return errors::OutOfRange(
@@ -188,25 +203,201 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
         }
       }
 
+      Status EnsureWriterThreadsStarted() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (!shards_.empty()) {
+          return Status::OK();
+        }
+        std::vector<std::unique_ptr<Shard>> shards(dataset()->num_shards_);
+        for (int64 i = 0; i < dataset()->num_shards_; ++i) {
+          shards[i].reset(new Shard);
+          TF_RETURN_IF_ERROR(dataset::MemmappedCacheWriter::Create(
+              dataset()->env_,
+              dataset::MemmappedCacheShardFilename(
+                  dataset()->filename_, i, dataset()->num_shards_),
+              &shards[i]->writer));
+        }
+        {
+          mutex_lock l(write_mu_);
+          num_active_writers_ = shards.size();
+        }
+        for (auto& shard : shards) {
+          Shard* shard_ptr = shard.get();
+          shard->thread.reset(dataset()->env_->StartThread(
+              {}, "cache_writer_thread",
+              [this, shard_ptr]() { WriterThread(shard_ptr); }));
+        }
+        shards_ = std::move(shards);
+        return Status::OK();
+      }
+
+      // Buffers `element` for writing to `shard`, blocking while that
+      // shard's buffer is full.
+      Status EnqueueElement(Shard* shard, const std::vector<Tensor>& element)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        mutex_lock l(write_mu_);
+        while (write_status_.ok() &&
+               shard->buffer.size() >= kMaxBufferedElements) {
+          write_cond_var_.wait(l);
+        }
+        TF_RETURN_IF_ERROR(write_status_);
+        shard->buffer.push_back(element);
+        write_cond_var_.notify_all();
+        return Status::OK();
+      }
+
+      // Waits for every shard to be written, then publishes the cache by
+      // writing its manifest.
       Status Finish() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
         iteration_completed_ = true;
-        TF_RETURN_IF_ERROR(writer_.Finish());
+        {
+          mutex_lock l(write_mu_);
+          input_finished_ = true;
+          write_cond_var_.notify_all();
+          while (num_active_writers_ > 0) {
+            write_cond_var_.wait(l);
+          }
+          TF_RETURN_IF_ERROR(write_status_);
+        }
+        TF_RETURN_IF_ERROR(dataset::WriteMemmappedCacheManifest(
+            dataset()->env_, dataset()->filename_, dataset()->num_shards_,
+            cur_index_));
         TF_RETURN_IF_ERROR(dataset()->env_->DeleteFile(lockfile_));
         return Status::OK();
       }
 
+      // Writes the elements buffered for `shard` until the input is
+      // exhausted, then closes the shard file.
+      void WriterThread(Shard* shard) {
+        Status s;
+        while (true) {
+          std::vector<Tensor> element;
+          {
+            mutex_lock l(write_mu_);
+            while (!cancelled_ && !input_finished_ && shard->buffer.empty()) {
+              write_cond_var_.wait(l);
+            }
+            if (cancelled_) {
+              return;
+            }
+            if (shard->buffer.empty()) {
+              break;
+            }
+            element = std::move(shard->buffer.front());
+            shard->buffer.pop_front();
+            write_cond_var_.notify_all();
+          }
+          s = shard->writer->Append(element);
+          if (!s.ok()) {
+            break;
+          }
+        }
+        if (s.ok()) {
+          s = shard->writer->Close();
+        }
+        mutex_lock l(write_mu_);
+        write_status_.Update(s);
+        --num_active_writers_;
+        write_cond_var_.notify_all();
+      }
+
       mutex mu_;
       size_t cur_index_ GUARDED_BY(mu_);
       std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
-      BundleWriter writer_ GUARDED_BY(mu_);
       const string lockfile_;
       bool lockfile_created_ GUARDED_BY(mu_);
       bool iteration_completed_ GUARDED_BY(mu_);
+
+      // Coordinates this iterator with the writer threads.
+      mutex write_mu_;
+      condition_variable write_cond_var_;
+      Status write_status_ GUARDED_BY(write_mu_);
+      bool cancelled_ GUARDED_BY(write_mu_) = false;
+      bool input_finished_ GUARDED_BY(write_mu_) = false;
+      size_t num_active_writers_ GUARDED_BY(write_mu_) = 0;
+      // Declared last so that the writer threads are joined before the
+      // state they use is destroyed.
+      std::vector<std::unique_ptr<Shard>> shards_ GUARDED_BY(mu_);
     };  // FileWriterIterator
 
+    // FileReaderIterator reads the elements of a cache written by
+    // FileWriterIterator. The shard files are mapped into memory, and the
+    // tensors that it produces alias those mappings rather than being
+    // copied out of the files.
     class FileReaderIterator : public DatasetIterator<FileDataset> {
      public:
       explicit FileReaderIterator(const FileDataset* dataset)
+          : DatasetIterator<FileDataset>(dataset), cur_index_(0) {}
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(EnsureShardsOpened());
+        if (cur_index_ == num_elements_) {
+          *end_of_sequence = true;
+          return Status::OK();
+        }
+        bool end_of_file;
+        TF_RETURN_IF_ERROR(readers_[cur_index_ % readers_.size()]->ReadElement(
+            out_tensors, &end_of_file));
+        if (end_of_file) {
+          return errors::DataLoss("Cache '", dataset()->filename_,
+                                  "' has fewer elements than its manifest (",
+                                  num_elements_, ")");
+        }
+        if (out_tensors->size() != dataset()->num_tensors_) {
+          return errors::InvalidArgument(
+              "Cache '", dataset()->filename_, "' has elements with ",
+              out_tensors->size(), " components, but expected ",
+              dataset()->num_tensors_);
+        }
+        for (size_t i = 0; i < out_tensors->size(); ++i) {
+          if ((*out_tensors)[i].dtype() != dataset()->output_dtypes()[i]) {
+            return errors::InvalidArgument(
+                "Cache '", dataset()->filename_, "' has a component ", i,
+                " of type ", DataTypeString((*out_tensors)[i].dtype()),
+                ", but expected ",
+                DataTypeString(dataset()->output_dtypes()[i]));
+          }
+        }
+        cur_index_++;
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
+     private:
+      Status EnsureShardsOpened() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (!readers_.empty()) {
+          return Status::OK();
+        }
+        int64 num_shards;
+        TF_RETURN_IF_ERROR(dataset::ReadMemmappedCacheManifest(
+            dataset()->env_, dataset()->filename_, &num_shards,
+            &num_elements_));
+        std::vector<std::unique_ptr<dataset::MemmappedCacheReader>> readers(
+            num_shards);
+        for (int64 i = 0; i < num_shards; ++i) {
+          TF_RETURN_IF_ERROR(dataset::MemmappedCacheReader::Create(
+              dataset()->env_,
+              dataset::MemmappedCacheShardFilename(dataset()->filename_, i,
+                                                   num_shards),
+              &readers[i]));
+        }
+        readers_ = std::move(readers);
+        return Status::OK();
+      }
+
+      mutex mu_;
+      int64 cur_index_ GUARDED_BY(mu_);
+      int64 num_elements_ GUARDED_BY(mu_) = 0;
+      std::vector<std::unique_ptr<dataset::MemmappedCacheReader>> readers_
+          GUARDED_BY(mu_);
+    };  // FileReaderIterator
+
+    // BundleFileReaderIterator reads the elements of a cache that an earlier
+    // version of this op wrote with a BundleWriter.
+    class BundleFileReaderIterator : public DatasetIterator<FileDataset> {
+     public:
+      explicit BundleFileReaderIterator(const FileDataset* dataset)
           : DatasetIterator<FileDataset>(dataset),
             cur_index_(0),
             reader_(dataset->env_, dataset->filename_) {}
@@ -244,10 +435,11 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
       mutex mu_;
       size_t cur_index_ GUARDED_BY(mu_);
       BundleReader reader_ GUARDED_BY(mu_);
-    };  // FileReaderIterator
+    };  // BundleFileReaderIterator
 
     const DatasetBase* const input_;
     const string filename_;
+    const int64 num_shards_;
     Env* const env_;
     const size_t num_tensors_;
     const size_t tensor_index_padding_size_;
@@ -264,7 +456,7 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
 
     ~MemoryDataset() override { input_->Unref(); }
 
-    std::unique_ptr<IteratorBase> MakeIterator() const override {
+    std::unique_ptr<IteratorBase> MakeIteratorInternal() const override {
       mutex_lock l(mu_);
       if (cache_) {
         return std::unique_ptr<IteratorBase>(
@@ -376,7 +568,9 @@ class CacheDatasetOp : public UnaryDatasetOpKernel {
         GUARDED_BY(mu_);
     mutable bool writer_iterator_created_ GUARDED_BY(mu_) = false;
   };  // MemoryDataset
-};    // CacheDatasetOp
+
+  int64 num_shards_;
+};  // CacheDatasetOp
 
 REGISTER_KERNEL_BUILDER(Name("CacheDataset").Device(DEVICE_CPU),
                         CacheDatasetOp);
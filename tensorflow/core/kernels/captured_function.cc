@@ -16,22 +16,308 @@ limitations under the License.
 
 #include <utility>
 
+#include "tensorflow/core/common_runtime/executor.h"
 #include "tensorflow/core/common_runtime/threadpool_device.h"
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/device_attributes.pb.h"
 #include "tensorflow/core/framework/lookup_interface.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/queue_interface.h"
 #include "tensorflow/core/framework/reader_interface.h"
 #include "tensorflow/core/framework/resource_handle.pb_text.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/algorithm.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/graph/graph_constructor.h"
 #include "tensorflow/core/kernels/dataset.h"
 #include "tensorflow/core/kernels/variable_ops.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/notification.h"
 #include "tensorflow/core/public/session_options.h"
 
 
 namespace tensorflow {
 
+// Runs a function by calling the kernels of its (optimized) body in
+// topological order on the calling thread. The per-call state is pooled,
+// so that a call allocates nothing but the tensors of the kernels.
+class CapturedFunction::InlineRunner {
+ public:
+  // Functions with more nodes than this are left to the executor, which
+  // runs independent nodes in parallel.
+  static const int kMaxNodes = 64;
+
+  // Sets `*out_runner` to a runner for the function `f_handle` of `lib`, or
+  // to nullptr if the function can't be run inline.
+  static Status Create(FunctionLibraryRuntime* lib,
+                       FunctionLibraryRuntime::Handle f_handle,
+                       std::unique_ptr<InlineRunner>* out_runner) {
+    out_runner->reset();
+    const FunctionBody* fbody = lib->GetFunctionBody(f_handle);
+    std::unique_ptr<Graph> g(new Graph(lib->GetFunctionLibraryDefinition()));
+    CopyGraph(*fbody->graph, g.get());
+    OptimizeGraph(lib, &g);
+
+    std::vector<Node*> order;
+    GetReversePostOrder(*g, &order);
+    std::unique_ptr<InlineRunner> runner(new InlineRunner(lib));
+    runner->arg_types_ = fbody->arg_types;
+    runner->arg_slots_.resize(fbody->arg_types.size(), -1);
+    runner->ret_slots_.resize(fbody->ret_types.size(), -1);
+
+    // Assign value slots to the outputs of the nodes, and create the
+    // kernels of the nodes other than the arguments and return values.
+    std::vector<int> output_start(g->num_node_ids(), -1);
+    std::vector<const Node*> nodes;
+    std::vector<const Node*> retvals;
+    int num_values = 0;
+    size_t max_inputs = 0;
+    size_t max_outputs = 0;
+    for (const Node* n : order) {
+      if (!n->IsOp()) continue;
+      if (nodes.size() + retvals.size() >= static_cast<size_t>(kMaxNodes) ||
+          n->IsControlFlow() || n->IsSend() || n->IsRecv()) {
+        return Status::OK();
+      }
+      for (int i = 0; i < n->num_inputs(); ++i) {
+        if (IsRefType(n->input_type(i))) return Status::OK();
+      }
+      for (int i = 0; i < n->num_outputs(); ++i) {
+        if (IsRefType(n->output_type(i))) return Status::OK();
+      }
+      if (n->type_string() == "_Retval") {
+        retvals.push_back(n);
+        continue;
+      }
+      output_start[n->id()] = num_values;
+      num_values += n->num_outputs();
+      if (n->type_string() == "_Arg") {
+        int index;
+        TF_RETURN_IF_ERROR(GetNodeAttr(n->def(), "index", &index));
+        if (index < 0 || index >= static_cast<int>(runner->arg_slots_.size())) {
+          return Status::OK();
+        }
+        runner->arg_slots_[index] = output_start[n->id()];
+        continue;
+      }
+      if (n->op_def().is_stateful()) return Status::OK();
+      OpKernel* kernel;
+      if (!lib->CreateKernel(n->def(), &kernel).ok()) {
+        // Let the executor report the error.
+        return Status::OK();
+      }
+      Item item;
+      item.kernel = kernel;
+      item.num_inputs = n->num_inputs();
+      item.output_start = output_start[n->id()];
+      item.num_outputs = n->num_outputs();
+      runner->items_.push_back(item);
+      if (kernel->AsAsync() != nullptr) return Status::OK();
+      nodes.push_back(n);
+      max_inputs = std::max(max_inputs, static_cast<size_t>(item.num_inputs));
+      max_outputs =
+          std::max(max_outputs, static_cast<size_t>(item.num_outputs));
+    }
+
+    // Map the inputs of the nodes and the return values to value slots.
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      Item* item = &runner->items_[i];
+      item->input_start = runner->input_slots_.size();
+      runner->input_slots_.resize(item->input_start + item->num_inputs, -1);
+      for (const Edge* e : nodes[i]->in_edges()) {
+        if (e->IsControlEdge()) continue;
+        const int start = output_start[e->src()->id()];
+        if (start < 0) return Status::OK();
+        runner->input_slots_[item->input_start + e->dst_input()] =
+            start + e->src_output();
+      }
+    }
+    for (const Node* n : retvals) {
+      int index;
+      TF_RETURN_IF_ERROR(GetNodeAttr(n->def(), "index", &index));
+      const Edge* e;
+      TF_RETURN_IF_ERROR(n->input_edge(0, &e));
+      const int start = output_start[e->src()->id()];
+      if (index < 0 ||
+          index >= static_cast<int>(runner->ret_slots_.size()) ||
+          start < 0) {
+        return Status::OK();
+      }
+      runner->ret_slots_[index] = start + e->src_output();
+    }
+    for (int slot : runner->input_slots_) {
+      if (slot < 0) return Status::OK();
+    }
+    for (int slot : runner->ret_slots_) {
+      if (slot < 0) return Status::OK();
+    }
+
+    // A value is moved into its last consumer, so that the kernel can
+    // forward its buffer (as the executor allows), and copied into the
+    // others. Return values are never moved.
+    runner->input_is_last_use_.resize(runner->input_slots_.size());
+    std::vector<bool> used_later(num_values, false);
+    for (int slot : runner->ret_slots_) used_later[slot] = true;
+    for (int i = runner->input_slots_.size() - 1; i >= 0; --i) {
+      const int slot = runner->input_slots_[i];
+      runner->input_is_last_use_[i] = !used_later[slot];
+      used_later[slot] = true;
+    }
+
+    runner->num_values_ = num_values;
+    runner->input_attrs_.resize(max_inputs);
+    runner->output_attrs_.resize(max_outputs);
+    *out_runner = std::move(runner);
+    return Status::OK();
+  }
+
+  ~InlineRunner() {
+    for (const Item& item : items_) {
+      DeleteNonCachedKernel(item.kernel);
+    }
+  }
+
+  // Runs the function on the concatenation of `args` and
+  // `captured_inputs`.
+  Status Run(const FunctionLibraryRuntime::Options& f_opts,
+             gtl::ArraySlice<Tensor> args,
+             gtl::ArraySlice<Tensor> captured_inputs,
+             std::vector<Tensor>* rets) {
+    std::unique_ptr<State> state = GetState();
+    Status s = Run(f_opts, args, captured_inputs, state.get(), rets);
+    for (Tensor& value : state->values) {
+      value = Tensor();
+    }
+    state->input_tensors.clear();
+    ReturnState(std::move(state));
+    return s;
+  }
+
+ private:
+  struct Item {
+    OpKernel* kernel = nullptr;  // Owned.
+    int input_start = 0;         // Index in input_slots_.
+    int num_inputs = 0;
+    int output_start = 0;  // Index in the values of a call.
+    int num_outputs = 0;
+  };
+
+  // The state of a call.
+  struct State {
+    std::vector<Tensor> values;
+    gtl::InlinedVector<Tensor, 4> input_tensors;
+    gtl::InlinedVector<TensorValue, 4> inputs;
+    // Some kernels require a cancellation manager; it is never cancelled.
+    CancellationManager c_mgr;
+  };
+
+  explicit InlineRunner(FunctionLibraryRuntime* lib) : lib_(lib) {}
+
+  Status Run(const FunctionLibraryRuntime::Options& f_opts,
+             gtl::ArraySlice<Tensor> args,
+             gtl::ArraySlice<Tensor> captured_inputs, State* state,
+             std::vector<Tensor>* rets) {
+    if (args.size() + captured_inputs.size() != arg_types_.size()) {
+      return errors::InvalidArgument(
+          "Expects ", arg_types_.size(), " arguments, but ",
+          args.size() + captured_inputs.size(), " is provided");
+    }
+    for (size_t i = 0; i < arg_types_.size(); ++i) {
+      const Tensor& arg = i < args.size() ? args[i]
+                                          : captured_inputs[i - args.size()];
+      if (arg.dtype() != arg_types_[i]) {
+        return errors::InvalidArgument(
+            "Expects arg[", i, "] to be ", DataTypeString(arg_types_[i]),
+            " but ", DataTypeString(arg.dtype()), " is provided");
+      }
+      if (arg_slots_[i] >= 0) state->values[arg_slots_[i]] = arg;
+    }
+
+    Device* device = lib_->device();
+    OpKernelContext::Params params;
+    params.device = device;
+    params.step_id = f_opts.step_id;
+    params.inputs = &state->inputs;
+    params.input_alloc_attrs = &input_attrs_;
+    params.output_attr_array = output_attrs_.data();
+    params.cancellation_manager = &state->c_mgr;
+    params.resource_manager = device->resource_manager();
+    params.step_container = f_opts.step_container;
+    params.function_library = lib_;
+    params.runner = f_opts.runner;
+    for (const Item& item : items_) {
+      state->input_tensors.resize(item.num_inputs);
+      state->inputs.resize(item.num_inputs);
+      for (int i = 0; i < item.num_inputs; ++i) {
+        const int j = item.input_start + i;
+        Tensor* value = &state->values[input_slots_[j]];
+        if (input_is_last_use_[j]) {
+          state->input_tensors[i] = std::move(*value);
+        } else {
+          state->input_tensors[i] = *value;
+        }
+        state->inputs[i] = TensorValue(&state->input_tensors[i]);
+      }
+      params.op_kernel = item.kernel;
+      OpKernelContext ctx(&params, item.num_outputs);
+      device->Compute(item.kernel, &ctx);
+      TF_RETURN_IF_ERROR(ctx.status());
+      for (int i = 0; i < item.num_outputs; ++i) {
+        TensorValue output = ctx.release_output(i);
+        if (output.tensor == nullptr) {
+          return errors::Internal("Missing output ", i, " of ",
+                                  item.kernel->name());
+        }
+        state->values[item.output_start + i] = std::move(*output.tensor);
+        delete output.tensor;
+      }
+      for (Tensor& input : state->input_tensors) {
+        input = Tensor();
+      }
+    }
+
+    rets->resize(ret_slots_.size());
+    for (size_t i = 0; i < ret_slots_.size(); ++i) {
+      (*rets)[i] = state->values[ret_slots_[i]];
+    }
+    return Status::OK();
+  }
+
+  std::unique_ptr<State> GetState() {
+    {
+      mutex_lock l(mu_);
+      if (!free_states_.empty()) {
+        std::unique_ptr<State> state = std::move(free_states_.back());
+        free_states_.pop_back();
+        return state;
+      }
+    }
+    std::unique_ptr<State> state(new State);
+    state->values.resize(num_values_);
+    return state;
+  }
+
+  void ReturnState(std::unique_ptr<State> state) {
+    mutex_lock l(mu_);
+    free_states_.push_back(std::move(state));
+  }
+
+  FunctionLibraryRuntime* const lib_;  // Not owned.
+  DataTypeVector arg_types_;
+  std::vector<int> arg_slots_;  // Value slot of each argument, or -1.
+  std::vector<int> ret_slots_;  // Value slot of each return value.
+  std::vector<Item> items_;     // In topological order.
+  std::vector<int> input_slots_;
+  std::vector<bool> input_is_last_use_;
+  int num_values_ = 0;
+  gtl::InlinedVector<AllocatorAttributes, 4> input_attrs_;
+  std::vector<AllocatorAttributes> output_attrs_;
+
+  mutex mu_;
+  std::vector<std::unique_ptr<State>> free_states_ GUARDED_BY(mu_);
+};
+
 /* static */
 Status CapturedFunction::Create(
     OpKernelContext* ctx, const NameAttrList* func, int graph_def_version,
@@ -93,15 +379,24 @@ Status CapturedFunction::Create(
   TF_RETURN_IF_ERROR(
       lib->Instantiate(func->name(), AttrSlice(&func->attr()), &f_handle));
 
+  std::unique_ptr<InlineRunner> inline_runner;
+  TF_RETURN_IF_ERROR(
+      InlineRunner::Create(lib.get(), f_handle, &inline_runner));
+
   out_function->reset(new CapturedFunction(
       std::move(device), std::move(flib_def), std::move(lib), f_handle,
-      std::move(captured_inputs)));
+      std::move(captured_inputs), std::move(inline_runner)));
   return Status::OK();
 }
 
+CapturedFunction::~CapturedFunction() {}
+
 Status CapturedFunction::Run(FunctionLibraryRuntime::Options f_opts,
                              gtl::ArraySlice<Tensor> args,
                              std::vector<Tensor>* rets) {
+  if (inline_runner_) {
+    return inline_runner_->Run(f_opts, args, captured_inputs_, rets);
+  }
   Notification n;
   Status s;
   auto done_callback = [&n, &s](Status func_status) {
@@ -116,9 +411,6 @@ Status CapturedFunction::Run(FunctionLibraryRuntime::Options f_opts,
   // will be required to plumb it through the `IteratorContext`.
   CancellationManager c_mgr;
   f_opts.cancellation_manager = &c_mgr;
-  // TODO(mrry): Implement a synchronous version of
-  // FunctionLibraryRuntime::Run() that avoids a context switch for small
-  // functions.
   if (captured_inputs_.empty()) {
     lib_->Run(f_opts, f_handle_, args, rets, done_callback);
   } else {
@@ -139,11 +431,13 @@ CapturedFunction::CapturedFunction(
     std::unique_ptr<FunctionLibraryDefinition> flib_def,
     std::unique_ptr<FunctionLibraryRuntime> lib,
     FunctionLibraryRuntime::Handle f_handle,
-    std::vector<Tensor> captured_inputs)
+    std::vector<Tensor> captured_inputs,
+    std::unique_ptr<InlineRunner> inline_runner)
     : device_(std::move(device)),
       flib_def_(std::move(flib_def)),
       lib_(std::move(lib)),
       f_handle_(f_handle),
-      captured_inputs_(std::move(captured_inputs)) {}
+      captured_inputs_(std::move(captured_inputs)),
+      inline_runner_(std::move(inline_runner)) {}
 
 }  // namespace tensorflow
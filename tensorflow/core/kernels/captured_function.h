@@ -50,6 +50,11 @@ class ResourceMgr;
 //
 // TODO(mrry): Clean this up. Investigate whether it would be possible to
 // reuse the session's FunctionLibraryRuntime(s) or Device(s).
+//
+// Small functions made of stateless, synchronous kernels and without
+// control flow (e.g. most `map()` functions) are run inline on the
+// calling thread: their kernels are called in topological order, with
+// no executor, call frame or rendezvous set up per call.
 class CapturedFunction {
  public:
   // NOTE(mrry): The `captured_inputs` are passed by value. For
@@ -59,6 +64,8 @@ class CapturedFunction {
                        std::vector<Tensor> captured_inputs,
                        std::unique_ptr<CapturedFunction>* out_function);
 
+  ~CapturedFunction();
+
   Status Run(FunctionLibraryRuntime::Options f_opts,
              gtl::ArraySlice<Tensor> args, std::vector<Tensor>* rets);
 
@@ -67,17 +74,22 @@ class CapturedFunction {
   ResourceMgr* resource_manager() const { return device_->resource_manager(); }
 
  private:
+  class InlineRunner;
+
   CapturedFunction(std::unique_ptr<Device> device,
                    std::unique_ptr<FunctionLibraryDefinition> flib_def,
                    std::unique_ptr<FunctionLibraryRuntime> lib,
                    FunctionLibraryRuntime::Handle f_handle,
-                   std::vector<Tensor> captured_inputs);
+                   std::vector<Tensor> captured_inputs,
+                   std::unique_ptr<InlineRunner> inline_runner);
 
   const std::unique_ptr<Device> device_;
   const std::unique_ptr<FunctionLibraryDefinition> flib_def_;
   const std::unique_ptr<FunctionLibraryRuntime> lib_;
   const FunctionLibraryRuntime::Handle f_handle_;
   const std::vector<Tensor> captured_inputs_;
+  // Set if the function can be run inline.
+  const std::unique_ptr<InlineRunner> inline_runner_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(CapturedFunction);
 };
@@ -19,6 +19,8 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/constant_op.h"
 
+#include <unordered_map>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -29,6 +31,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/fill_functor.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 
 #ifdef TENSORFLOW_USE_SYCL
 #include "tensorflow/core/common_runtime/sycl/sycl_util.h"
@@ -36,6 +39,29 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// The buffers of the live ConstantOps, with their sizes in bytes.
+mutex constant_buffers_mu(LINKER_INITIALIZED);
+
+std::unordered_map<const void*, size_t>* ConstantBuffers()
+    EXCLUSIVE_LOCKS_REQUIRED(constant_buffers_mu) {
+  static std::unordered_map<const void*, size_t>* buffers =
+      new std::unordered_map<const void*, size_t>;
+  return buffers;
+}
+
+}  // namespace
+
+bool IsConstantOpBuffer(const Tensor& tensor) {
+  if (!DataTypeCanUseMemcpy(tensor.dtype())) return false;
+  const StringPiece data = tensor.tensor_data();
+  if (data.empty()) return false;
+  mutex_lock l(constant_buffers_mu);
+  auto it = ConstantBuffers()->find(data.data());
+  return it != ConstantBuffers()->end() && data.size() <= it->second;
+}
+
 ConstantOp::ConstantOp(OpKernelConstruction* ctx)
     : OpKernel(ctx), tensor_(ctx->output_type(0)) {
   const TensorProto* proto = nullptr;
@@ -48,11 +74,23 @@ ConstantOp::ConstantOp(OpKernelConstruction* ctx)
       errors::InvalidArgument("Type mismatch between value (",
                               DataTypeString(tensor_.dtype()), ") and dtype (",
                               DataTypeString(ctx->output_type(0)), ")"));
+  if (DataTypeCanUseMemcpy(tensor_.dtype()) && tensor_.NumElements() > 0) {
+    mutex_lock l(constant_buffers_mu);
+    registered_ = ConstantBuffers()
+                      ->emplace(tensor_.tensor_data().data(),
+                                tensor_.tensor_data().size())
+                      .second;
+  }
 }
 
 void ConstantOp::Compute(OpKernelContext* ctx) { ctx->set_output(0, tensor_); }
 
-ConstantOp::~ConstantOp() {}
+ConstantOp::~ConstantOp() {
+  if (registered_) {
+    mutex_lock l(constant_buffers_mu);
+    ConstantBuffers()->erase(tensor_.tensor_data().data());
+  }
+}
 
 REGISTER_KERNEL_BUILDER(Name("Const").Device(DEVICE_CPU), ConstantOp);
 
@@ -23,6 +23,11 @@ limitations under the License.
 
 namespace tensorflow {
 
+// Returns true if the buffer of 'tensor' is the value of a ConstantOp. No
+// kernel writes to these buffers, so kernels can cache data derived from the
+// contents of 'tensor' for as long as they hold a reference to it.
+bool IsConstantOpBuffer(const Tensor& tensor);
+
 // ConstantOp returns a tensor specified by ConstantOpDef.
 class ConstantOp : public OpKernel {
  public:
@@ -33,6 +38,7 @@ class ConstantOp : public OpKernel {
 
  private:
   Tensor tensor_;
+  bool registered_ = false;
   TF_DISALLOW_COPY_AND_ASSIGN(ConstantOp);
 };
 
@@ -13,18 +13,52 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include "tensorflow/core/kernels/constant_op.h"
+
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
 
+class ConstantOpTest : public OpsTestBase {};
+
+TEST_F(ConstantOpTest, IsConstantOpBuffer) {
+  Tensor value(DT_FLOAT, TensorShape({2, 3}));
+  value.flat<float>().setRandom();
+  TensorProto proto;
+  value.AsProtoTensorContent(&proto);
+  TF_ASSERT_OK(NodeDefBuilder("const", "Const")
+                   .Attr("dtype", DT_FLOAT)
+                   .Attr("value", proto)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  TF_ASSERT_OK(RunOpKernel());
+
+  const Tensor output = *GetOutput(0);
+  EXPECT_TRUE(IsConstantOpBuffer(output));
+  // A slice at the start of the buffer is constant as well.
+  EXPECT_TRUE(IsConstantOpBuffer(output.Slice(0, 1)));
+  EXPECT_FALSE(IsConstantOpBuffer(output.Slice(1, 2)));
+  EXPECT_FALSE(IsConstantOpBuffer(value));
+
+  // The buffer isn't the value of a ConstantOp anymore once the kernel is
+  // destroyed.
+  context_.reset();
+  kernel_.reset();
+  EXPECT_FALSE(IsConstantOpBuffer(output));
+}
+
 // Returns graph containing "num" const nodes.  If 'sequential' is
 // true, make sure all constants are executed sequentially in the
 // graph by adding control dependencies.
@@ -360,6 +360,8 @@ class Conv2DCustomBackpropFilterOp : public OpKernel {
     const size_t shard_size =
         (target_working_set_size + work_unit_size - 1) / work_unit_size;
 
+    AllocatorAttributes col_buffer_attr;
+    col_buffer_attr.set_scoped_to_step(true);
     Tensor col_buffer;
     OP_REQUIRES_OK(context,
                    context->allocate_temp(
@@ -367,7 +369,7 @@ class Conv2DCustomBackpropFilterOp : public OpKernel {
                        TensorShape({static_cast<int64>(shard_size),
                                     static_cast<int64>(output_image_size),
                                     static_cast<int64>(filter_total_size)}),
-                       &col_buffer));
+                       &col_buffer, col_buffer_attr));
 
     // The input offset corresponding to a single input image.
     const int input_offset = dims.spatial_dims[0].input_size *
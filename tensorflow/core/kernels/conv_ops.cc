@@ -22,12 +22,12 @@ limitations under the License.
 #include <string.h>
 #include <map>
 #include <vector>
-#include "tensorflow/core/framework/numeric_op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_slice.h"
+#include "tensorflow/core/kernels/bias_activation_functor.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/conv_2d.h"
 #include "tensorflow/core/kernels/deep_conv2d.h"
@@ -137,7 +137,8 @@ class LaunchDeepConvOp {
                   int input_cols, int in_depth, int filter_rows,
                   int filter_cols, int pad_rows, int pad_cols, int out_rows,
                   int out_cols, int out_depth, int stride_rows, int stride_cols,
-                  Tensor* output, TensorFormat data_format) {
+                  Tensor* output, TensorFormat data_format,
+                  DeepConv2DFilterCache* filter_cache) {
     return false;
   }
 };
@@ -151,10 +152,9 @@ class LaunchDeepConvOp<CPUDevice, float> {
                   int input_cols, int in_depth, int filter_rows,
                   int filter_cols, int pad_rows, int pad_cols, int out_rows,
                   int out_cols, int out_depth, int stride_rows, int stride_cols,
-                  Tensor* output, TensorFormat data_format) {
-    if (data_format != FORMAT_NHWC ||
-        !CanUseDeepConv2D(stride_rows, stride_cols, filter_rows, filter_cols,
-                          in_depth, out_depth, out_rows, out_cols)) {
+                  Tensor* output, TensorFormat data_format,
+                  DeepConv2DFilterCache* filter_cache) {
+    if (data_format != FORMAT_NHWC) {
       return false;
     }
 
@@ -175,8 +175,22 @@ class LaunchDeepConvOp<CPUDevice, float> {
     auto filter_ptr = filter.template flat<float>().data();
     auto output_ptr = output->template flat<float>().data();
 
+    // Filters that don't change between steps only need to be transformed
+    // once, which makes DeepConv2D worthwhile for more shapes.
+    std::vector<Tensor> packed_filters;
+    const bool constant_filter = filter_cache->Lookup(
+        args, filter_ptr, filter.TotalBytes(), &packed_filters);
+    if (!CanUseDeepConv2D(stride_rows, stride_cols, filter_rows, filter_cols,
+                          in_depth, out_depth, out_rows, out_cols, batch,
+                          constant_filter)) {
+      return false;
+    }
+
     functor::DeepConv2D<CPUDevice, float>()(ctx, args, input_ptr, filter_ptr,
-                                            output_ptr);
+                                            output_ptr, &packed_filters);
+    if (ctx->status().ok()) {
+      filter_cache->Insert(args, packed_filters);
+    }
     return true;
   }
 };
@@ -251,9 +265,9 @@ class LaunchXsmmConvOp<CPUDevice, float> {
 #endif
 
 template <typename Device, typename T>
-class Conv2DOp : public BinaryOp<T> {
+class Conv2DOp : public OpKernel {
  public:
-  explicit Conv2DOp(OpKernelConstruction* context) : BinaryOp<T>(context) {
+  explicit Conv2DOp(OpKernelConstruction* context) : OpKernel(context) {
     OP_REQUIRES_OK(context, context->GetAttr("strides", &strides_));
     string data_format;
     OP_REQUIRES_OK(context, context->GetAttr("data_format", &data_format));
@@ -275,6 +289,14 @@ class Conv2DOp : public BinaryOp<T> {
   }
 
   void Compute(OpKernelContext* context) override {
+    Tensor* output = nullptr;
+    ComputeConv2D(context, &output);
+  }
+
+ protected:
+  // Allocates the output and convolves the first two inputs into it.
+  // *output_ptr is set as soon as the output is allocated.
+  void ComputeConv2D(OpKernelContext* context, Tensor** output_ptr) {
     // Input tensor is of the following dimensions:
     // [ batch, in_rows, in_cols, in_depth ]
 
@@ -356,6 +378,7 @@ class Conv2DOp : public BinaryOp<T> {
     // [ in_batch, out_rows, out_cols, out_depth ]
     Tensor* output = nullptr;
     OP_REQUIRES_OK(context, context->allocate_output(0, out_shape, &output));
+    *output_ptr = output;
 
     VLOG(2) << "Conv2D: in_depth = " << in_depth
             << ", input_cols = " << input_cols
@@ -383,7 +406,8 @@ class Conv2DOp : public BinaryOp<T> {
     if (LaunchDeepConvOp<Device, T>::Run(
             context, input, filter, batch, input_rows, input_cols, in_depth,
             filter_rows, filter_cols, pad_rows, pad_cols, out_rows, out_cols,
-            out_depth, stride_rows, stride_cols, output, data_format_)) {
+            out_depth, stride_rows, stride_cols, output, data_format_,
+            &deep_conv_filter_cache_)) {
       return;
     }
 
@@ -392,6 +416,8 @@ class Conv2DOp : public BinaryOp<T> {
                      BrainPadding2EigenPadding(padding_), output, data_format_);
   }
 
+  TensorFormat data_format() const { return data_format_; }
+
  private:
   std::vector<int32> strides_;
   bool use_cudnn_;
@@ -399,10 +425,60 @@ class Conv2DOp : public BinaryOp<T> {
   TensorFormat data_format_;
   LaunchConv2DOp<Device, T> launcher_;
   bool cudnn_use_autotune_;
+  // Transformed filters of the DeepConv2D path, reused while the filter stays
+  // constant.
+  DeepConv2DFilterCache deep_conv_filter_cache_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(Conv2DOp);
 };
 
+// Conv2D followed by BiasAdd and an optional activation, which are applied in
+// place in a single pass over the output of the convolution, instead of
+// writing and reading the whole output once more for each op.
+template <typename Device, typename T>
+class FusedConv2DOp : public Conv2DOp<Device, T> {
+ public:
+  explicit FusedConv2DOp(OpKernelConstruction* context)
+      : Conv2DOp<Device, T>(context) {
+    OP_REQUIRES_OK(context, GetFusedActivation(context, &activation_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    Tensor* output = nullptr;
+    this->ComputeConv2D(context, &output);
+    if (!context->status().ok() || output == nullptr) {
+      return;
+    }
+
+    const Tensor& bias = context->input(2);
+    const TensorFormat data_format = this->data_format();
+    const int64 depth = GetTensorDim(*output, data_format, 'C');
+    OP_REQUIRES(context,
+                TensorShapeUtils::IsVector(bias.shape()) &&
+                    bias.dim_size(0) == depth,
+                errors::InvalidArgument(
+                    "Must provide as many biases as the output channels: ",
+                    bias.shape().DebugString(), " vs. ",
+                    output->shape().DebugString()));
+    if (output->NumElements() == 0) {
+      return;
+    }
+    const int64 outer = data_format == FORMAT_NHWC
+                            ? output->NumElements() / depth
+                            : GetTensorDim(*output, data_format, 'N');
+    const int64 inner = output->NumElements() / (outer * depth);
+    functor::BiasActivation<Device, T>()(
+        context->eigen_device<Device>(),
+        output->shaped<T, 3>({outer, depth, inner}), bias.vec<T>(),
+        activation_);
+  }
+
+ private:
+  FusedActivation activation_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FusedConv2DOp);
+};
+
 #define REGISTER_CPU(T)                                         \
   REGISTER_KERNEL_BUILDER(                                      \
       Name("Conv2D").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
@@ -415,6 +491,15 @@ TF_CALL_half(REGISTER_CPU);
 TF_CALL_float(REGISTER_CPU);
 #endif  // USE_GEMM_FOR_CONV
 
+#define REGISTER_FUSED_CPU(T)                                         \
+  REGISTER_KERNEL_BUILDER(                                            \
+      Name("_FusedConv2D").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedConv2DOp<CPUDevice, T>);
+
+TF_CALL_half(REGISTER_FUSED_CPU);
+TF_CALL_float(REGISTER_FUSED_CPU);
+#undef REGISTER_FUSED_CPU
+
 // To be used inside depthwise_conv_op.cc.
 template class LaunchConv2DOp<CPUDevice, float>;
 
@@ -766,7 +851,12 @@ namespace functor {
       const std::array<int, 2>& padding_left,                                \
       const std::array<int, 2>& padding_right,                               \
       typename TTypes<T, 4, int>::Tensor out, TensorFormat data_format);     \
-  extern template struct PadInput<GPUDevice, T, int, 4>
+  extern template struct PadInput<GPUDevice, T, int, 4>;                     \
+  template <>                                                                \
+  void BiasActivation<GPUDevice, T>::operator()(                             \
+      const GPUDevice& d, typename TTypes<T, 3>::Tensor output,              \
+      typename TTypes<T>::ConstVec bias, FusedActivation activation);        \
+  extern template struct BiasActivation<GPUDevice, T>
 
 DECLARE_GPU_SPEC(float);
 DECLARE_GPU_SPEC(Eigen::half);
@@ -780,6 +870,12 @@ REGISTER_KERNEL_BUILDER(
 REGISTER_KERNEL_BUILDER(
     Name("Conv2D").Device(DEVICE_GPU).TypeConstraint<float>("T"),
     Conv2DOp<GPUDevice, float>);
+REGISTER_KERNEL_BUILDER(
+    Name("_FusedConv2D").Device(DEVICE_GPU).TypeConstraint<Eigen::half>("T"),
+    FusedConv2DOp<GPUDevice, Eigen::half>);
+REGISTER_KERNEL_BUILDER(
+    Name("_FusedConv2D").Device(DEVICE_GPU).TypeConstraint<float>("T"),
+    FusedConv2DOp<GPUDevice, float>);
 
 // To be used inside depthwise_conv_op.cc.
 template class LaunchConv2DOp<GPUDevice, float>;
@@ -21,13 +21,16 @@ limitations under the License.
 #include <tuple>
 #include <unordered_map>
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/kernels/gpu_scratch_arena.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/stream_executor.h"
+#include "tensorflow/core/util/autotune_cache.h"
 
 namespace tensorflow {
 
@@ -49,13 +52,18 @@ int64 GetCudnnWorkspaceLimit(const string& envvar_in_mb,
                              int64 default_value_in_bytes);
 
 // A class to provide scratch-space allocator for Stream-Executor Cudnn
-// callback. TensorFlow is responsible for releasing the temporary buffers after
-// the kernel finishes.
+// callback. The scratch space comes from the GpuScratchArena of the stream if
+// it is free, so that it is reused across kernel invocations, and from
+// temporary buffers that TensorFlow releases after the kernel finishes
+// otherwise.
 class CudnnScratchAllocator : public perftools::gputools::ScratchAllocator {
  public:
   virtual ~CudnnScratchAllocator() {}
   CudnnScratchAllocator(int64 memory_limit, OpKernelContext* context)
-      : memory_limit_(memory_limit), total_byte_size_(0), context_(context) {}
+      : memory_limit_(memory_limit),
+        total_byte_size_(0),
+        context_(context),
+        arena_lease_(context) {}
   virtual int64 GetMemoryLimitInBytes(
       perftools::gputools::Stream* stream) override {
     return memory_limit_;
@@ -68,6 +76,13 @@ class CudnnScratchAllocator : public perftools::gputools::ScratchAllocator {
       return perftools::gputools::port::StatusOr<
           perftools::gputools::DeviceMemory<uint8>>();
     }
+    uint8* arena_memory = arena_lease_.Allocate(stream, byte_size);
+    if (arena_memory != nullptr) {
+      total_byte_size_ += byte_size;
+      return perftools::gputools::port::StatusOr<
+          perftools::gputools::DeviceMemory<uint8>>(
+          AsDeviceMemory(arena_memory, byte_size));
+    }
     AllocationAttributes allocation_attr;
     allocation_attr.no_retry_on_failure = true;
     Status allocation_status(context_->allocate_temp(
@@ -92,6 +107,7 @@ class CudnnScratchAllocator : public perftools::gputools::ScratchAllocator {
   int64 memory_limit_;
   int64 total_byte_size_;
   OpKernelContext* context_;
+  GpuScratchArenaLease arena_lease_;
   std::vector<Tensor> allocated_tensors_;
 };
 
@@ -132,7 +148,15 @@ class ConvParameters {
   }
   uint64 hash() const { return hash_code_; }
 
+  int device_id() const { return device_id_; }
+
   string ToString() const {
+    return strings::StrCat(ToStringWithoutDevice(), ", ", device_id_);
+  }
+
+  // Like ToString(), without the device ordinal, which is only meaningful
+  // within a process.
+  string ToStringWithoutDevice() const {
     // clang-format off
     return strings::StrCat(
         batch_, ", ", in_depths_, ", ",
@@ -141,7 +165,7 @@ class ConvParameters {
         "(", str_util::Join(filter_, ", "), "), ",
         "(", str_util::Join(stride_, ", "), "), ",
         "(", str_util::Join(padding_, ", "), "), ",
-        dtype_, ", ", device_id_);
+        dtype_);
     // clang-format on
   }
 
@@ -185,6 +209,27 @@ class ConvParameters {
 
 typedef Eigen::GpuDevice GPUDevice;
 
+// Conversions of an autotuned algorithm to and from its representation in the
+// persistent AutotuneCache.
+inline string AutoTuneConfigToString(
+    const perftools::gputools::dnn::AlgorithmConfig& config) {
+  return strings::StrCat(config.algorithm(), " ",
+                         config.algorithm_no_scratch());
+}
+
+inline bool AutoTuneConfigFromString(
+    const string& str, perftools::gputools::dnn::AlgorithmConfig* config) {
+  std::vector<string> fields = str_util::Split(str, ' ');
+  int64 algorithm, algorithm_no_scratch;
+  if (fields.size() != 2 || !strings::safe_strto64(fields[0], &algorithm) ||
+      !strings::safe_strto64(fields[1], &algorithm_no_scratch)) {
+    return false;
+  }
+  *config = perftools::gputools::dnn::AlgorithmConfig(algorithm,
+                                                      algorithm_no_scratch);
+  return true;
+}
+
 // A helper class that looks up the best autotuned config from parameters.
 // Due to the noisy nature of autotune, especially with multiple devices, it
 // only accepts a config if its margin exceeds a threshold.
@@ -195,17 +240,37 @@ typedef Eigen::GpuDevice GPUDevice;
 // back and forth randomly, the expected number of experiments before autotune
 // settles is O(threshold ^ 2). So we recommend that number of warmup runs
 // for any benchmarks.
+//
+// When the AutotuneCache is enabled, the accepted configs are also saved there
+// and the configs that it has are used without autotuning, unless the cache
+// asks for validation. Then they are measured again, and the configs found to
+// be different are reported and replaced.
 template <typename Parameters, typename Config>
 class AutoTuneMap {
  public:
   bool Find(const Parameters& params, Config* config) const {
     mutex_lock lock(mu_);
     auto iter = params_config_map_.find(params);
-    if (iter == params_config_map_.end() ||
-        iter->second.score < min_score_threshold_) {
+    if (iter != params_config_map_.end()) {
+      if (iter->second.score < min_score_threshold_) {
+        return false;
+      }
+      *config = iter->second.config;
+      return true;
+    }
+    AutotuneCache* cache = AutotuneCache::Global();
+    if (cache == nullptr || cache->validate()) {
       return false;
     }
-    *config = iter->second.config;
+    const string key = GetPersistentKey(cache, params);
+    string value;
+    if (key.empty() || !cache->Lookup(key, &value) ||
+        !AutoTuneConfigFromString(value, config)) {
+      return false;
+    }
+    VLOG(1) << GetActionSummary("loads", params, *config);
+    params_config_map_.insert(
+        std::make_pair(params, ValueType{*config, min_score_threshold_}));
     return true;
   }
   void Insert(const ConvParameters& params, const Config& config) {
@@ -235,6 +300,7 @@ class AutoTuneMap {
     }
     if (new_score >= min_score_threshold_) {
       VLOG(1) << GetActionSummary("accepts", params, config);
+      SaveToPersistentCache(params, config);
     }
   }
 
@@ -257,8 +323,46 @@ class AutoTuneMap {
     }
   };
 
+  // Returns the key of 'params' in the persistent cache, or an empty string
+  // if the device hasn't been registered with the cache.
+  string GetPersistentKey(AutotuneCache* cache,
+                          const Parameters& params) const {
+    const string device = cache->DeviceDescription(params.device_id());
+    if (device.empty()) {
+      return string();
+    }
+    return strings::StrCat(name_, ": ", device, ": ",
+                           params.ToStringWithoutDevice());
+  }
+
+  void SaveToPersistentCache(const Parameters& params, const Config& config) {
+    AutotuneCache* cache = AutotuneCache::Global();
+    if (cache == nullptr) {
+      return;
+    }
+    const string key = GetPersistentKey(cache, params);
+    if (key.empty()) {
+      return;
+    }
+    const string value = AutoTuneConfigToString(config);
+    string cached;
+    if (cache->Lookup(key, &cached)) {
+      if (cached == value) {
+        return;
+      }
+      LOG(WARNING) << "The autotune cache " << cache->filename() << " has "
+                   << cached << " for " << key << ", but autotuning chose "
+                   << value;
+    }
+    Status status = cache->Insert(key, value);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to save to the autotune cache "
+                   << cache->filename() << ": " << status.error_message();
+    }
+  }
+
   string GetActionSummary(StringPiece action, const Parameters& params,
-                          const Config& config) {
+                          const Config& config) const {
     return strings::Printf("autotune_map %s %s: %s -> (%s)", name_.c_str(),
                            action.ToString().c_str(), params.ToString().c_str(),
                            config.ToString().c_str());
@@ -269,7 +373,7 @@ class AutoTuneMap {
     Config config;
     int32 score;
   };
-  std::unordered_map<Parameters, ValueType, Hasher> params_config_map_
+  mutable std::unordered_map<Parameters, ValueType, Hasher> params_config_map_
       GUARDED_BY(mu_);
   string name_;
   int32 min_score_threshold_;
@@ -0,0 +1,133 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/cpu_isa_dispatch.h"
+
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+
+namespace tensorflow {
+namespace {
+
+// The implementations of each function, indexed by the CpuIsa they are built
+// for. Missing ones are nullptr.
+typedef std::vector<CpuIsaFunction> RegisteredFunctions;
+
+typedef std::unordered_map<string, RegisteredFunctions> CpuIsaFunctionMap;
+
+const CpuIsa kAllCpuIsas[] = {CpuIsa::kBaseline, CpuIsa::kAvx,
+                              CpuIsa::kAvx2Fma};
+const int kNumCpuIsas = sizeof(kAllCpuIsas) / sizeof(kAllCpuIsas[0]);
+
+mutex* GetCpuIsaFunctionMapLock() {
+  static mutex* lock = new mutex;
+  return lock;
+}
+
+CpuIsaFunctionMap* GetCpuIsaFunctionMap() {
+  static CpuIsaFunctionMap* functions = new CpuIsaFunctionMap;
+  return functions;
+}
+
+}  // namespace
+
+bool CpuSupportsIsa(CpuIsa isa) {
+  switch (isa) {
+    case CpuIsa::kBaseline:
+      return true;
+    case CpuIsa::kAvx:
+      return port::TestCPUFeature(port::CPUFeature::AVX);
+    case CpuIsa::kAvx2Fma:
+      return port::TestCPUFeature(port::CPUFeature::AVX2) &&
+             port::TestCPUFeature(port::CPUFeature::FMA);
+  }
+  return false;
+}
+
+const char* CpuIsaName(CpuIsa isa) {
+  switch (isa) {
+    case CpuIsa::kBaseline:
+      return "baseline";
+    case CpuIsa::kAvx:
+      return "AVX";
+    case CpuIsa::kAvx2Fma:
+      return "AVX2+FMA";
+  }
+  return "unknown";
+}
+
+bool CpuIsaFromName(const string& name, CpuIsa* isa) {
+  for (const CpuIsa candidate : kAllCpuIsas) {
+    if (name == CpuIsaName(candidate)) {
+      *isa = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+void RegisterCpuIsaFunction(const char* name, CpuIsa isa, CpuIsaFunction fn) {
+  if (!CpuSupportsIsa(isa)) {
+    VLOG(1) << "Skipping the " << CpuIsaName(isa) << " implementation of "
+            << name << ", which this CPU doesn't support.";
+    return;
+  }
+  mutex_lock l(*GetCpuIsaFunctionMapLock());
+  RegisteredFunctions& functions = (*GetCpuIsaFunctionMap())[name];
+  functions.resize(kNumCpuIsas, nullptr);
+  functions[static_cast<int>(isa)] = fn;
+}
+
+CpuIsaFunction LookupCpuIsaFunction(const char* name) {
+  mutex_lock l(*GetCpuIsaFunctionMapLock());
+  const CpuIsaFunctionMap* functions = GetCpuIsaFunctionMap();
+  auto it = functions->find(name);
+  if (it == functions->end()) {
+    return nullptr;
+  }
+  for (int i = kNumCpuIsas - 1; i >= 0; --i) {
+    if (it->second[i] != nullptr) {
+      VLOG(1) << "Using the " << CpuIsaName(kAllCpuIsas[i])
+              << " implementation of " << name;
+      return it->second[i];
+    }
+  }
+  return nullptr;
+}
+
+CpuIsaFunction LookupCpuIsaFunction(const char* name, CpuIsa isa) {
+  mutex_lock l(*GetCpuIsaFunctionMapLock());
+  const CpuIsaFunctionMap* functions = GetCpuIsaFunctionMap();
+  auto it = functions->find(name);
+  if (it == functions->end()) {
+    return nullptr;
+  }
+  return it->second[static_cast<int>(isa)];
+}
+
+namespace cpu_isa_dispatch {
+
+CpuIsaFunctionRegistrar::CpuIsaFunctionRegistrar(const char* name,
+                                                 CpuIsa isa,
+                                                 CpuIsaFunction fn) {
+  RegisterCpuIsaFunction(name, isa, fn);
+}
+
+}  // namespace cpu_isa_dispatch
+}  // namespace tensorflow
@@ -0,0 +1,112 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_CPU_ISA_DISPATCH_H_
+#define TENSORFLOW_KERNELS_CPU_ISA_DISPATCH_H_
+
+// Runtime selection of kernel code compiled for several x86 instruction sets.
+//
+// The hot loops of a kernel are moved to a source file that is built once per
+// instruction set with the tf_cpu_isa_library() rule of tensorflow.bzl. Each
+// build registers its entry point under a common name:
+//
+//   REGISTER_CPU_ISA_FUNCTION("MatMulFloat", CpuIsa::TF_CPU_ISA,
+//                             MatMulFloatBlock);
+//
+// and the kernel picks the best one that the CPU supports:
+//
+//   static const auto fn =
+//       LookupCpuIsaFunction<MatMulFloatFn>("MatMulFloat");
+//   if (fn != nullptr) { ... } else { /* Baseline implementation. */ }
+//
+// The registration is skipped for the builds that use instructions the CPU
+// doesn't have, so a single binary can run on the whole range of machines.
+//
+// The instruction set specific sources are compiled with a renamed Eigen
+// namespace, so that their Eigen code doesn't clash with the baseline one at
+// link time. Because of that they must only exchange plain types with the rest
+// of TensorFlow, and only include Eigen and this header.
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// The instruction sets that kernels can be compiled for, from the least to
+// the most capable.
+enum class CpuIsa {
+  kBaseline = 0,  // Whatever the rest of the binary is compiled for.
+  kAvx = 1,
+  kAvx2Fma = 2,  // AVX2 and FMA, i.e. Haswell and newer.
+};
+
+// Returns true if the CPU running this process supports 'isa'.
+bool CpuSupportsIsa(CpuIsa isa);
+
+// Returns the name of 'isa', e.g. "AVX2+FMA".
+const char* CpuIsaName(CpuIsa isa);
+
+// Sets *isa to the instruction set called 'name' by CpuIsaName(). Returns
+// false if there is none.
+bool CpuIsaFromName(const string& name, CpuIsa* isa);
+
+// The type-erased entry points stored by the registry.
+typedef void (*CpuIsaFunction)();
+
+// Registers 'fn' as the implementation of 'name' for 'isa'. Does nothing if
+// the CPU doesn't support 'isa'.
+void RegisterCpuIsaFunction(const char* name, CpuIsa isa, CpuIsaFunction fn);
+
+// Returns the implementation of 'name' for the most capable instruction set
+// supported by the CPU, or nullptr if there is none. Callers should cache the
+// result, as the lookup takes a lock.
+CpuIsaFunction LookupCpuIsaFunction(const char* name);
+
+template <typename Fn>
+Fn LookupCpuIsaFunction(const char* name) {
+  return reinterpret_cast<Fn>(LookupCpuIsaFunction(name));
+}
+
+// Returns the implementation of 'name' for exactly 'isa', or nullptr if there
+// is none or the CPU doesn't support 'isa'. This is for data laid out for one
+// instruction set, e.g. weights packed offline, which only that build of the
+// kernels can read.
+CpuIsaFunction LookupCpuIsaFunction(const char* name, CpuIsa isa);
+
+template <typename Fn>
+Fn LookupCpuIsaFunction(const char* name, CpuIsa isa) {
+  return reinterpret_cast<Fn>(LookupCpuIsaFunction(name, isa));
+}
+
+namespace cpu_isa_dispatch {
+
+class CpuIsaFunctionRegistrar {
+ public:
+  CpuIsaFunctionRegistrar(const char* name, CpuIsa isa, CpuIsaFunction fn);
+};
+
+}  // namespace cpu_isa_dispatch
+
+#define REGISTER_CPU_ISA_FUNCTION(name, isa, fn) \
+  REGISTER_CPU_ISA_FUNCTION_UNIQ_HELPER(__COUNTER__, name, isa, fn)
+#define REGISTER_CPU_ISA_FUNCTION_UNIQ_HELPER(ctr, name, isa, fn) \
+  REGISTER_CPU_ISA_FUNCTION_UNIQ(ctr, name, isa, fn)
+#define REGISTER_CPU_ISA_FUNCTION_UNIQ(ctr, name, isa, fn)                 \
+  static ::tensorflow::cpu_isa_dispatch::CpuIsaFunctionRegistrar          \
+      cpu_isa_function_registrar__body__##ctr##__object(                  \
+          name, isa, reinterpret_cast<::tensorflow::CpuIsaFunction>(fn))
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_CPU_ISA_DISPATCH_H_
@@ -0,0 +1,98 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/cpu_isa_dispatch.h"
+
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+typedef int (*TestFn)();
+
+int Baseline() { return 0; }
+int Avx() { return 1; }
+int Avx2Fma() { return 2; }
+
+REGISTER_CPU_ISA_FUNCTION("CpuIsaDispatchTest", CpuIsa::kAvx2Fma, Avx2Fma);
+REGISTER_CPU_ISA_FUNCTION("CpuIsaDispatchTest", CpuIsa::kBaseline, Baseline);
+REGISTER_CPU_ISA_FUNCTION("CpuIsaDispatchTest", CpuIsa::kAvx, Avx);
+
+TEST(CpuIsaDispatchTest, SupportsBaseline) {
+  EXPECT_TRUE(CpuSupportsIsa(CpuIsa::kBaseline));
+}
+
+TEST(CpuIsaDispatchTest, SupportsIsaFollowsCPUFeatures) {
+  EXPECT_EQ(port::TestCPUFeature(port::CPUFeature::AVX),
+            CpuSupportsIsa(CpuIsa::kAvx));
+  EXPECT_EQ(port::TestCPUFeature(port::CPUFeature::AVX2) &&
+                port::TestCPUFeature(port::CPUFeature::FMA),
+            CpuSupportsIsa(CpuIsa::kAvx2Fma));
+}
+
+TEST(CpuIsaDispatchTest, LooksUpMostCapableSupportedIsa) {
+  TestFn fn = LookupCpuIsaFunction<TestFn>("CpuIsaDispatchTest");
+  ASSERT_NE(nullptr, fn);
+  if (CpuSupportsIsa(CpuIsa::kAvx2Fma)) {
+    EXPECT_EQ(2, fn());
+  } else if (CpuSupportsIsa(CpuIsa::kAvx)) {
+    EXPECT_EQ(1, fn());
+  } else {
+    EXPECT_EQ(0, fn());
+  }
+}
+
+TEST(CpuIsaDispatchTest, LooksUpGivenIsa) {
+  TestFn baseline =
+      LookupCpuIsaFunction<TestFn>("CpuIsaDispatchTest", CpuIsa::kBaseline);
+  ASSERT_NE(nullptr, baseline);
+  EXPECT_EQ(0, baseline());
+  TestFn avx = LookupCpuIsaFunction<TestFn>("CpuIsaDispatchTest", CpuIsa::kAvx);
+  if (CpuSupportsIsa(CpuIsa::kAvx)) {
+    ASSERT_NE(nullptr, avx);
+    EXPECT_EQ(1, avx());
+  } else {
+    EXPECT_EQ(nullptr, avx);
+  }
+  TestFn avx2_fma =
+      LookupCpuIsaFunction<TestFn>("CpuIsaDispatchTest", CpuIsa::kAvx2Fma);
+  if (CpuSupportsIsa(CpuIsa::kAvx2Fma)) {
+    ASSERT_NE(nullptr, avx2_fma);
+    EXPECT_EQ(2, avx2_fma());
+  } else {
+    EXPECT_EQ(nullptr, avx2_fma);
+  }
+}
+
+TEST(CpuIsaDispatchTest, UnknownFunction) {
+  EXPECT_EQ(nullptr, LookupCpuIsaFunction("CpuIsaDispatchTestUnknown"));
+  EXPECT_EQ(nullptr, LookupCpuIsaFunction("CpuIsaDispatchTestUnknown",
+                                          CpuIsa::kBaseline));
+}
+
+TEST(CpuIsaDispatchTest, IsaFromName) {
+  for (const CpuIsa isa :
+       {CpuIsa::kBaseline, CpuIsa::kAvx, CpuIsa::kAvx2Fma}) {
+    CpuIsa parsed;
+    ASSERT_TRUE(CpuIsaFromName(CpuIsaName(isa), &parsed));
+    EXPECT_EQ(isa, parsed);
+  }
+  CpuIsa parsed;
+  EXPECT_FALSE(CpuIsaFromName("AVX-512", &parsed));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -27,6 +27,7 @@ limitations under the License.
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/util/sparse/sparse_tensor.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -210,22 +211,30 @@ class CTCGreedyDecoderOp : public OpKernel {
     // Assumption: the blank index is num_classes - 1
     int blank_index = num_classes - 1;
 
-    // Perform best path decoding
+    // Perform best path decoding, sharding the independent batch entries
+    // across the CPU worker threads.
     std::vector<std::vector<std::vector<int> > > sequences(batch_size);
-    for (int b = 0; b < batch_size; ++b) {
-      sequences[b].resize(1);
-      auto& sequence = sequences[b][0];
-      int prev_indices = -1;
-      for (int t = 0; t < seq_len_t(b); ++t) {
-        int max_class_indices;
-        log_prob_t(b, 0) += -RowMax(input_list_t[t], b, &max_class_indices);
-        if (max_class_indices != blank_index &&
-            !(merge_repeated_ && max_class_indices == prev_indices)) {
-          sequence.push_back(max_class_indices);
+    auto decode = [&](const int64 begin, const int64 end) {
+      for (int b = begin; b < end; ++b) {
+        sequences[b].resize(1);
+        auto& sequence = sequences[b][0];
+        int prev_indices = -1;
+        for (int t = 0; t < seq_len_t(b); ++t) {
+          int max_class_indices;
+          log_prob_t(b, 0) += -RowMax(input_list_t[t], b, &max_class_indices);
+          if (max_class_indices != blank_index &&
+              !(merge_repeated_ && max_class_indices == prev_indices)) {
+            sequence.push_back(max_class_indices);
+          }
+          prev_indices = max_class_indices;
         }
-        prev_indices = max_class_indices;
       }
-    }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    const int64 cost_per_batch_entry = max_time * num_classes;
+    Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+          cost_per_batch_entry, decode);
 
     OP_REQUIRES_OK(
         ctx, decode_helper_.StoreAllDecodedSequences(
@@ -287,34 +296,47 @@ class CTCBeamSearchDecoderOp : public OpKernel {
                                 batch_size, num_classes);
     }
 
-    ctc::CTCBeamSearchDecoder<> beam_search(num_classes, beam_width_,
-                                            &beam_scorer_, 1 /* batch_size */,
-                                            merge_repeated_);
-    Tensor input_chip(DT_FLOAT, TensorShape({num_classes}));
-    auto input_chip_t = input_chip.flat<float>();
-
     std::vector<std::vector<std::vector<int> > > best_paths(batch_size);
-    std::vector<float> log_probs;
+    std::vector<Status> statuses(batch_size);
 
+    // The batch entries are decoded independently, so they are sharded
+    // across the CPU worker threads. Each shard has its own decoder, which
+    // reuses its beams from one batch entry to the next.
     // Assumption: the blank index is num_classes - 1
-    for (int b = 0; b < batch_size; ++b) {
-      auto& best_paths_b = best_paths[b];
-      best_paths_b.resize(decode_helper_.GetTopPaths());
-      for (int t = 0; t < seq_len_t(b); ++t) {
-        input_chip_t = input_list_t[t].chip(b, 0);
-        auto input_bi =
-            Eigen::Map<const Eigen::ArrayXf>(input_chip_t.data(), num_classes);
-        beam_search.Step(input_bi);
-      }
-      OP_REQUIRES_OK(
-          ctx, beam_search.TopPaths(decode_helper_.GetTopPaths(), &best_paths_b,
-                                    &log_probs, merge_repeated_));
+    auto decode = [&](const int64 begin, const int64 end) {
+      ctc::CTCBeamSearchDecoder<> beam_search(num_classes, beam_width_,
+                                              &beam_scorer_, 1 /* batch_size */,
+                                              merge_repeated_);
+      std::vector<float> log_probs;
+      for (int b = begin; b < end; ++b) {
+        auto& best_paths_b = best_paths[b];
+        best_paths_b.resize(decode_helper_.GetTopPaths());
+        for (int t = 0; t < seq_len_t(b); ++t) {
+          // The input of batch entry "b" at time "t" is a contiguous row.
+          auto input_bi = Eigen::Map<const Eigen::ArrayXf>(
+              &input_list_t[t](b, 0), num_classes);
+          beam_search.Step(input_bi);
+        }
+        statuses[b] = beam_search.TopPaths(decode_helper_.GetTopPaths(),
+                                           &best_paths_b, &log_probs,
+                                           merge_repeated_);
+        if (!statuses[b].ok()) return;
 
-      beam_search.Reset();
+        beam_search.Reset();
 
-      for (int bp = 0; bp < decode_helper_.GetTopPaths(); ++bp) {
-        log_prob_t(b, bp) = log_probs[bp];
+        for (int bp = 0; bp < decode_helper_.GetTopPaths(); ++bp) {
+          log_prob_t(b, bp) = log_probs[bp];
+        }
       }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    const int64 cost_per_batch_entry =
+        max_time * num_classes * std::max(beam_width_, 1) * 10;
+    Shard(worker_threads.num_threads, worker_threads.workers, batch_size,
+          cost_per_batch_entry, decode);
+    for (const Status& s : statuses) {
+      OP_REQUIRES_OK(ctx, s);
     }
 
     OP_REQUIRES_OK(ctx, decode_helper_.StoreAllDecodedSequences(
@@ -15,8 +15,223 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/dataset.h"
 
+#include <algorithm>
+
+#include "tensorflow/core/lib/monitoring/counter.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/util/env_var.h"
+
 namespace tensorflow {
 
+namespace {
+
+auto* dataset_elements = monitoring::Counter<1>::New(
+    "/tensorflow/data/elements",
+    "The number of elements produced by each stage of the input pipelines.",
+    "stage");
+
+auto* dataset_self_usecs = monitoring::Counter<1>::New(
+    "/tensorflow/data/self_usecs",
+    "The time spent getting elements from each stage of the input pipelines, "
+    "excluding the time spent in the stages it gets its input from on the "
+    "same thread, in microseconds.",
+    "stage");
+
+auto* dataset_buffer_size = monitoring::Sampler<1>::New(
+    {"/tensorflow/data/buffer_size",
+     "The number of elements buffered by the stages of the input pipelines "
+     "that buffer them (e.g. shuffle and prefetch), each time they produce "
+     "one.",
+     "stage"},
+    {1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 4096, 16384, 65536});
+
+auto* dataset_consumer_wait_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/data/consumer_wait_usecs",
+     "The time ops wait for an element of their iterator, in microseconds.",
+     "op"},
+    {10, 100, 1000, 10000, 100000, 1000000, 10000000});
+
+// The stages of the input pipelines being run on a thread, innermost last.
+struct StageFrame {
+  const string* stage;
+  // The time spent in the stages this one got its input from.
+  int64 child_usecs;
+};
+
+std::vector<StageFrame>* StageFrames() {
+  static thread_local std::vector<StageFrame> frames;
+  return &frames;
+}
+
+// Marks `stage` as the innermost stage being run on the calling thread for
+// the lifetime of the object, and unless `record` is false, adds the time
+// spent in it to its self time.
+class ScopedStage {
+ public:
+  ScopedStage(const string* stage, bool record = true)
+      : record_(record),
+        start_usecs_(record ? Env::Default()->NowMicros() : 0) {
+    StageFrames()->push_back({stage, 0});
+  }
+
+  ~ScopedStage() {
+    std::vector<StageFrame>* frames = StageFrames();
+    const StageFrame frame = frames->back();
+    frames->pop_back();
+    if (!record_) return;
+    const int64 elapsed_usecs = Env::Default()->NowMicros() - start_usecs_;
+    dataset_self_usecs->GetCell(*frame.stage)
+        ->IncrementBy(std::max<int64>(0, elapsed_usecs - frame.child_usecs));
+    if (!frames->empty()) {
+      frames->back().child_usecs += elapsed_usecs;
+    }
+  }
+
+ private:
+  const bool record_;
+  const int64 start_usecs_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedStage);
+};
+
+// Returns the name of the stage of `dataset`, e.g. "Shuffle" for
+// "ShuffleDatasetOp(100, 0, 0)::Dataset".
+string StageName(const DatasetBase* dataset) {
+  const string debug_string = const_cast<DatasetBase*>(dataset)->DebugString();
+  StringPiece name(debug_string);
+  name = name.substr(0, debug_string.find_first_of("(:"));
+  if (!str_util::ConsumeSuffix(&name, "DatasetOp")) {
+    str_util::ConsumeSuffix(&name, "Dataset");
+  }
+  return name.empty() ? debug_string : name.ToString();
+}
+
+// Wraps the iterator of a stage of an input pipeline to record its stats.
+class InstrumentedIterator : public IteratorBase {
+ public:
+  InstrumentedIterator(string stage, std::unique_ptr<IteratorBase> input)
+      : stage_(std::move(stage)),
+        input_(std::move(input)),
+        elements_(dataset_elements->GetCell(stage_)) {}
+
+  Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                 bool* end_of_sequence) override {
+    ScopedStage scoped_stage(&stage_);
+    Status s = input_->GetNext(ctx, out_tensors, end_of_sequence);
+    if (s.ok() && !*end_of_sequence) {
+      elements_->IncrementBy(1);
+    }
+    return s;
+  }
+
+  void GetNextAsync(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                    bool* end_of_sequence, DoneCallback done) override {
+    if (!input_->is_async()) {
+      done(GetNext(ctx, out_tensors, end_of_sequence));
+      return;
+    }
+    ScopedStage scoped_stage(&stage_);
+    monitoring::CounterCell* elements = elements_;
+    input_->GetNextAsync(
+        ctx, out_tensors, end_of_sequence,
+        [elements, end_of_sequence, done](const Status& s) {
+          if (s.ok() && !*end_of_sequence) {
+            elements->IncrementBy(1);
+          }
+          done(s);
+        });
+  }
+
+  bool is_async() const override { return input_->is_async(); }
+
+  Status GetNextMany(IteratorContext* ctx, int64 max_elements,
+                     std::vector<std::vector<Tensor>>* out_elements,
+                     bool* end_of_sequence) override {
+    ScopedStage scoped_stage(&stage_);
+    const size_t num_elements = out_elements->size();
+    Status s =
+        input_->GetNextMany(ctx, max_elements, out_elements, end_of_sequence);
+    elements_->IncrementBy(out_elements->size() - num_elements);
+    return s;
+  }
+
+  const DataTypeVector& output_dtypes() const override {
+    return input_->output_dtypes();
+  }
+
+  const std::vector<PartialTensorShape>& output_shapes() const override {
+    return input_->output_shapes();
+  }
+
+ private:
+  const string stage_;
+  const std::unique_ptr<IteratorBase> input_;
+  monitoring::CounterCell* const elements_;
+};
+
+}  // namespace
+
+bool DatasetStatsEnabled() {
+  static bool enabled = [] {
+    bool enabled = false;
+    Status s = ReadBoolFromEnvVar("TF_DATASET_STATS", false, &enabled);
+    if (!s.ok()) {
+      LOG(ERROR) << s;
+    }
+    return enabled;
+  }();
+  return enabled;
+}
+
+void RecordDatasetBufferSize(int64 num_elements) {
+  if (!DatasetStatsEnabled()) return;
+  const std::vector<StageFrame>* frames = StageFrames();
+  if (frames->empty()) return;
+  dataset_buffer_size->GetCell(*frames->back().stage)->Add(num_elements);
+}
+
+void RecordDatasetConsumerWait(const string& op_name, int64 wait_usecs) {
+  if (!DatasetStatsEnabled()) return;
+  dataset_consumer_wait_usecs->GetCell(op_name)->Add(wait_usecs);
+}
+
+std::unique_ptr<IteratorBase> DatasetBase::MakeIterator() const {
+  if (!DatasetStatsEnabled()) {
+    return MakeIteratorInternal();
+  }
+  // The iterators of the input stages are usually created by the one of
+  // this stage, and get names nested in this one's.
+  const std::vector<StageFrame>* frames = StageFrames();
+  string stage =
+      strings::StrCat(frames->empty() ? "Iterator" : *frames->back().stage,
+                      "::", StageName(this));
+  std::unique_ptr<IteratorBase> iterator;
+  {
+    ScopedStage scoped_stage(&stage, false /* record */);
+    iterator = MakeIteratorInternal();
+  }
+  return std::unique_ptr<IteratorBase>(
+      new InstrumentedIterator(std::move(stage), std::move(iterator)));
+}
+
+Status IteratorBase::GetNextMany(IteratorContext* ctx, int64 max_elements,
+                                 std::vector<std::vector<Tensor>>* out_elements,
+                                 bool* end_of_sequence) {
+  *end_of_sequence = false;
+  for (int64 i = 0; i < max_elements; ++i) {
+    std::vector<Tensor> element;
+    TF_RETURN_IF_ERROR(GetNext(ctx, &element, end_of_sequence));
+    if (*end_of_sequence) {
+      break;
+    }
+    out_elements->emplace_back(std::move(element));
+  }
+  return Status::OK();
+}
+
 void DatasetOpKernel::Compute(OpKernelContext* ctx) {
   DatasetBase* dataset = nullptr;
   MakeDataset(ctx, &dataset);
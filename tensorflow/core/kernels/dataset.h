@@ -15,6 +15,7 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DATASET_H_
 #define THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DATASET_H_
 
+#include <functional>
 #include <memory>
 
 #include "tensorflow/core/framework/resource_mgr.h"
@@ -93,12 +94,50 @@ class IteratorBase {
   // `*out_tensors` will be undefined.
   //
   // This method is thread-safe.
-  //
-  // TODO(mrry): Define `GetNextAsync()` or `GetNextManyAsync()`, and
-  // potentially remove this method.
   virtual Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
                          bool* end_of_sequence) = 0;
 
+  typedef std::function<void(const Status&)> DoneCallback;
+
+  // Asynchronous version of `GetNext()`. `done` is called with the
+  // status once `*out_tensors` and `*end_of_sequence` have been set,
+  // possibly before this method returns. `ctx`, `out_tensors` and
+  // `end_of_sequence` must remain valid until `done` is called.
+  //
+  // The default implementation calls `GetNext()`, and so may block
+  // the calling thread. Iterators that override it to wait for
+  // elements without blocking should also override `is_async()`.
+  //
+  // This method is thread-safe.
+  virtual void GetNextAsync(IteratorContext* ctx,
+                            std::vector<Tensor>* out_tensors,
+                            bool* end_of_sequence, DoneCallback done) {
+    done(GetNext(ctx, out_tensors, end_of_sequence));
+  }
+
+  // Returns true if `GetNextAsync()` never blocks the calling thread
+  // while waiting for an element.
+  virtual bool is_async() const { return false; }
+
+  // Gets up to `max_elements` consecutive outputs from the range that
+  // this iterator is traversing, and appends them to `*out_elements`.
+  //
+  // Fewer than `max_elements` outputs are appended only if the range
+  // ends, in which case `true` will be stored in `*end_of_sequence`,
+  // or if getting an output fails, in which case the error is
+  // returned and the outputs that preceded it remain in
+  // `*out_elements`.
+  //
+  // The default implementation calls `GetNext()` once per output.
+  // Iterators that can produce several outputs more cheaply (e.g.
+  // under one lock acquisition) should override it.
+  //
+  // This method is thread-safe, but outputs appended by one call need
+  // not be consecutive if other threads use the iterator concurrently.
+  virtual Status GetNextMany(IteratorContext* ctx, int64 max_elements,
+                             std::vector<std::vector<Tensor>>* out_elements,
+                             bool* end_of_sequence);
+
   // Returns a vector of DataType values, representing the respective
   // element types of each tuple component in the outputs of this
   // iterator.
@@ -123,7 +162,10 @@ class DatasetBase : public ResourceBase {
   // start.
   //
   // Ownership of the created iterator will be transferred to the caller.
-  virtual std::unique_ptr<IteratorBase> MakeIterator() const = 0;
+  //
+  // If dataset stats are enabled (see `DatasetStatsEnabled()`), the
+  // iterator is instrumented.
+  std::unique_ptr<IteratorBase> MakeIterator() const;
 
   // Returns a vector of DataType values, representing the respective
   // element types of each tuple component in the outputs of this
@@ -134,8 +176,30 @@ class DatasetBase : public ResourceBase {
   // (and possibly partially defined) shapes of each tuple component
   // in the outputs of this dataset.
   virtual const std::vector<PartialTensorShape>& output_shapes() const = 0;
+
+ protected:
+  // Returns a new iterator for iterating over the range of elements in
+  // this dataset. Called by `MakeIterator()`.
+  virtual std::unique_ptr<IteratorBase> MakeIteratorInternal() const = 0;
 };
 
+// Returns true if the TF_DATASET_STATS environment variable is set to true,
+// in which case the iterators export, for each stage of their input
+// pipeline, the number of elements it produces and the time spent in it
+// excluding the stages it gets its input from, through the
+// "/tensorflow/data/*" metrics. Stages are named by their position, e.g.
+// "Iterator::Prefetch::Map".
+bool DatasetStatsEnabled();
+
+// Records that the stage of the input pipeline being run on the calling
+// thread buffers `num_elements` elements. Does nothing unless dataset stats
+// are enabled.
+void RecordDatasetBufferSize(int64 num_elements);
+
+// Records that the op `op_name` waited `wait_usecs` microseconds for an
+// element of its iterator. Does nothing unless dataset stats are enabled.
+void RecordDatasetConsumerWait(const string& op_name, int64 wait_usecs);
+
 // Represents an iterator that is associated with a particular parent dataset.
 template <class DatasetType>
 class DatasetIterator : public IteratorBase {
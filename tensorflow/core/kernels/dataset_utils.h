@@ -0,0 +1,52 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DATASET_UTILS_H_
+#define THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DATASET_UTILS_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/captured_function.h"
+#include "tensorflow/core/kernels/dataset.h"
+
+namespace tensorflow {
+
+namespace dataset {
+
+// Returns a step ID for running a function outside of any step. It is
+// guaranteed not to clash with any Session-generated step ID.
+int64 NewFunctionStepId();
+
+// Applies `captured_func` to `input_element`, and stores an iterator over
+// the dataset that it returns in `*out_iterator`. The function must return
+// a single scalar DT_RESOURCE tensor that refers to a Dataset.
+Status MakeIteratorFromInputElement(
+    IteratorContext* ctx, const std::vector<Tensor>& input_element,
+    CapturedFunction* captured_func,
+    std::unique_ptr<IteratorBase>* out_iterator);
+
+// Copies `element` into the `index`^th slice of `parent` (in the 0th
+// dimension).
+//
+// TODO(mrry): Reconcile this method with the similar method in
+// the queue implementation.
+Status CopyElementToSlice(const Tensor& element, Tensor* parent, int64 index);
+
+}  // namespace dataset
+
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DATASET_UTILS_H_
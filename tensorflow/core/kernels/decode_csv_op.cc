@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 
 // See docs in ../ops/parsing_ops.cc.
+#include <string.h>
+#include <deque>
 #include <vector>
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -21,6 +23,8 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -60,181 +64,227 @@ class DecodeCSVOp : public OpKernel {
     OpOutputList output;
     OP_REQUIRES_OK(ctx, ctx->output_list("output", &output));
 
+    std::vector<Tensor*> outputs(out_type_.size());
     for (int i = 0; i < static_cast<int>(out_type_.size()); ++i) {
-      Tensor* out = nullptr;
-      OP_REQUIRES_OK(ctx, output.allocate(i, records->shape(), &out));
+      OP_REQUIRES_OK(ctx, output.allocate(i, records->shape(), &outputs[i]));
     }
 
-    for (int64 i = 0; i < records_size; ++i) {
-      const StringPiece record(records_t(i));
-      std::vector<string> fields;
-      ExtractFields(ctx, record, &fields);
-      OP_REQUIRES(ctx, fields.size() == out_type_.size(),
-                  errors::InvalidArgument("Expect ", out_type_.size(),
-                                          " fields but have ", fields.size(),
-                                          " in record ", i));
-
-      // Check each field in the record
-      for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
-        const DataType& dtype = out_type_[f];
-        switch (dtype) {
-          case DT_INT32: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-
-              output[f]->flat<int32>()(i) = record_defaults[f].flat<int32>()(0);
-            } else {
-              int32 value;
-              OP_REQUIRES(ctx, strings::safe_strto32(fields[f], &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid int32: ", fields[f]));
-              output[f]->flat<int32>()(i) = value;
-            }
-            break;
+    // Records are parsed independently, so large batches are split across
+    // the worker threads. If several records are invalid, the error of the
+    // first one is reported.
+    mutex mu;
+    Status status;
+    int64 error_record = records_size;
+    auto parse_records = [this, &records_t, &record_defaults, &outputs, &mu,
+                          &status, &error_record](int64 start, int64 limit) {
+      std::vector<StringPiece> fields;
+      std::deque<string> unescaped;
+      for (int64 i = start; i < limit; ++i) {
+        Status s = ParseRecord(i, records_t(i), record_defaults, outputs,
+                               &fields, &unescaped);
+        if (!s.ok()) {
+          mutex_lock l(mu);
+          if (i < error_record) {
+            error_record = i;
+            status = s;
           }
-          case DT_INT64: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-
-              output[f]->flat<int64>()(i) = record_defaults[f].flat<int64>()(0);
-            } else {
-              int64 value;
-              OP_REQUIRES(ctx, strings::safe_strto64(fields[f], &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid int64: ", fields[f]));
-              output[f]->flat<int64>()(i) = value;
+          return;
+        }
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, records_size,
+          kCostPerField * out_type_.size(), parse_records);
+    OP_REQUIRES_OK(ctx, status);
+  }
+
+ private:
+  // A rough number of cycles it takes to extract and convert a field.
+  static constexpr int64 kCostPerField = 100;
+
+  std::vector<DataType> out_type_;
+  char delim_;
+  bool use_quote_delim_;
+
+  // Parses the i^th record into the i^th elements of `outputs`. `fields` and
+  // `unescaped` are scratch space.
+  Status ParseRecord(int64 i, StringPiece record,
+                     const OpInputList& record_defaults,
+                     const std::vector<Tensor*>& outputs,
+                     std::vector<StringPiece>* fields,
+                     std::deque<string>* unescaped) const {
+    TF_RETURN_IF_ERROR(ExtractFields(record, fields, unescaped));
+    if (fields->size() != out_type_.size()) {
+      return errors::InvalidArgument("Expect ", out_type_.size(),
+                                     " fields but have ", fields->size(),
+                                     " in record ", i);
+    }
+
+    // Check each field in the record
+    for (int f = 0; f < static_cast<int>(out_type_.size()); ++f) {
+      const StringPiece field = (*fields)[f];
+      const DataType& dtype = out_type_[f];
+      // If this field is empty, check if default is given:
+      // If yes, use default value; Otherwise report error.
+      if (field.empty() && record_defaults[f].NumElements() != 1) {
+        return errors::InvalidArgument(
+            "Field ", f, " is required but missing in record ", i, "!");
+      }
+      switch (dtype) {
+        case DT_INT32: {
+          if (field.empty()) {
+            outputs[f]->flat<int32>()(i) = record_defaults[f].flat<int32>()(0);
+          } else {
+            int32 value;
+            if (!strings::safe_strto32(field, &value)) {
+              return errors::InvalidArgument("Field ", f, " in record ", i,
+                                             " is not a valid int32: ", field);
             }
-            break;
+            outputs[f]->flat<int32>()(i) = value;
           }
-          case DT_FLOAT: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<float>()(i) = record_defaults[f].flat<float>()(0);
-            } else {
-              float value;
-              OP_REQUIRES(ctx, strings::safe_strtof(fields[f].c_str(), &value),
-                          errors::InvalidArgument(
-                              "Field ", f, " in record ", i,
-                              " is not a valid float: ", fields[f]));
-              output[f]->flat<float>()(i) = value;
+          break;
+        }
+        case DT_INT64: {
+          if (field.empty()) {
+            outputs[f]->flat<int64>()(i) = record_defaults[f].flat<int64>()(0);
+          } else {
+            int64 value;
+            if (!strings::safe_strto64(field, &value)) {
+              return errors::InvalidArgument("Field ", f, " in record ", i,
+                                             " is not a valid int64: ", field);
             }
-            break;
+            outputs[f]->flat<int64>()(i) = value;
           }
-          case DT_STRING: {
-            // If this field is empty, check if default is given:
-            // If yes, use default value; Otherwise report error.
-            if (fields[f].empty()) {
-              OP_REQUIRES(ctx, record_defaults[f].NumElements() == 1,
-                          errors::InvalidArgument(
-                              "Field ", f,
-                              " is required but missing in record ", i, "!"));
-              output[f]->flat<string>()(i) =
-                  record_defaults[f].flat<string>()(0);
-            } else {
-              output[f]->flat<string>()(i) = fields[f];
+          break;
+        }
+        case DT_FLOAT: {
+          if (field.empty()) {
+            outputs[f]->flat<float>()(i) = record_defaults[f].flat<float>()(0);
+          } else {
+            float value;
+            if (!ParseFloat(field, &value)) {
+              return errors::InvalidArgument("Field ", f, " in record ", i,
+                                             " is not a valid float: ", field);
             }
-            break;
+            outputs[f]->flat<float>()(i) = value;
+          }
+          break;
+        }
+        case DT_STRING: {
+          if (field.empty()) {
+            outputs[f]->flat<string>()(i) =
+                record_defaults[f].flat<string>()(0);
+          } else {
+            outputs[f]->flat<string>()(i).assign(field.data(), field.size());
           }
-          default:
-            OP_REQUIRES(ctx, false,
-                        errors::InvalidArgument("csv: data type ", dtype,
-                                                " not supported in field ", f));
+          break;
         }
+        default:
+          return errors::InvalidArgument("csv: data type ", dtype,
+                                         " not supported in field ", f);
       }
     }
+    return Status::OK();
   }
 
- private:
-  std::vector<DataType> out_type_;
-  char delim_;
-  bool use_quote_delim_;
+  // Like strings::safe_strtof(), but without building a string for short
+  // fields.
+  static bool ParseFloat(StringPiece field, float* value) {
+    char buf[64];
+    if (field.size() < sizeof(buf)) {
+      memcpy(buf, field.data(), field.size());
+      buf[field.size()] = '\0';
+      return strings::safe_strtof(buf, value);
+    }
+    return strings::safe_strtof(field.ToString().c_str(), value);
+  }
 
-  void ExtractFields(OpKernelContext* ctx, StringPiece input,
-                     std::vector<string>* result) {
-    int64 current_idx = 0;
-    if (!input.empty()) {
-      while (static_cast<size_t>(current_idx) < input.size()) {
-        if (input[current_idx] == '\n' || input[current_idx] == '\r') {
-          current_idx++;
-          continue;
-        }
+  // Splits `input` into `*fields`. The fields point into `input`, except for
+  // quoted fields with escaped quotes, which are unescaped into
+  // `*unescaped`.
+  Status ExtractFields(StringPiece input, std::vector<StringPiece>* fields,
+                       std::deque<string>* unescaped) const {
+    fields->clear();
+    unescaped->clear();
+    const char* const data = input.data();
+    const size_t size = input.size();
+    size_t current_idx = 0;
+    while (current_idx < size) {
+      if (data[current_idx] == '\n' || data[current_idx] == '\r') {
+        current_idx++;
+        continue;
+      }
 
-        bool quoted = false;
-        if (use_quote_delim_ && input[current_idx] == '"') {
-          quoted = true;
-          current_idx++;
+      if (!use_quote_delim_ || data[current_idx] != '"') {
+        // The body of the field runs up to the next delim or the end. The
+        // scans use memchr(), which is vectorized, rather than a loop over
+        // the characters.
+        const char* start = data + current_idx;
+        const char* end = static_cast<const char*>(
+            memchr(start, delim_, size - current_idx));
+        if (end == nullptr) {
+          end = data + size;
+        }
+        const size_t length = end - start;
+        if ((use_quote_delim_ && memchr(start, '"', length) != nullptr) ||
+            memchr(start, '\n', length) != nullptr ||
+            memchr(start, '\r', length) != nullptr) {
+          return errors::InvalidArgument(
+              "Unquoted fields cannot have quotes/CRLFs inside");
         }
+        fields->emplace_back(start, length);
 
-        // This is the body of the field;
-        string field;
-        if (!quoted) {
-          while (static_cast<size_t>(current_idx) < input.size() &&
-                 input[current_idx] != delim_) {
-            OP_REQUIRES(ctx,
-                        (!use_quote_delim_ || input[current_idx] != '"') &&
-                            input[current_idx] != '\n' &&
-                            input[current_idx] != '\r',
-                        errors::InvalidArgument(
-                            "Unquoted fields cannot have quotes/CRLFs inside"));
-            field += input[current_idx];
+        // Go to next field or the end
+        current_idx += length + 1;
+      } else {
+        current_idx++;
+        const size_t field_start = current_idx;
+        // Set once the field has an escaped quote. The bytes before
+        // `copied_idx` have been appended to it.
+        string* field = nullptr;
+        size_t copied_idx = field_start;
+
+        // Quoted field needs to be ended with '"' and delim or end
+        while (current_idx < size - 1 &&
+               (data[current_idx] != '"' || data[current_idx + 1] != delim_)) {
+          if (data[current_idx] != '"') {
             current_idx++;
+            continue;
           }
-
-          // Go to next field or the end
-          current_idx++;
-        } else if (use_quote_delim_) {
-          // Quoted field needs to be ended with '"' and delim or end
-          while (
-              (static_cast<size_t>(current_idx) < input.size() - 1) &&
-              (input[current_idx] != '"' || input[current_idx + 1] != delim_)) {
-            if (input[current_idx] != '"') {
-              field += input[current_idx];
-              current_idx++;
-            } else {
-              OP_REQUIRES(
-                  ctx, input[current_idx + 1] == '"',
-                  errors::InvalidArgument("Quote inside a string has to be "
-                                          "escaped by another quote"));
-              field += '"';
-              current_idx += 2;
-            }
+          if (data[current_idx + 1] != '"') {
+            return errors::InvalidArgument(
+                "Quote inside a string has to be escaped by another quote");
           }
-
-          OP_REQUIRES(
-              ctx,
-              (static_cast<size_t>(current_idx) < input.size() &&
-               input[current_idx] == '"' &&
-               (static_cast<size_t>(current_idx) == input.size() - 1 ||
-                input[current_idx + 1] == delim_)),
-              errors::InvalidArgument("Quoted field has to end with quote "
-                                      "followed by delim or end"));
-
+          if (field == nullptr) {
+            unescaped->emplace_back();
+            field = &unescaped->back();
+          }
+          // Keep one of the two quotes.
+          field->append(data + copied_idx, current_idx + 1 - copied_idx);
           current_idx += 2;
+          copied_idx = current_idx;
         }
 
-        result->push_back(field);
-      }
+        if (!(current_idx < size && data[current_idx] == '"' &&
+              (current_idx == size - 1 || data[current_idx + 1] == delim_))) {
+          return errors::InvalidArgument(
+              "Quoted field has to end with quote followed by delim or end");
+        }
 
-      // Check if the last field is missing
-      if (input[input.size() - 1] == delim_) result->push_back(string());
+        if (field == nullptr) {
+          fields->emplace_back(data + field_start, current_idx - field_start);
+        } else {
+          field->append(data + copied_idx, current_idx - copied_idx);
+          fields->emplace_back(*field);
+        }
+        current_idx += 2;
+      }
     }
+
+    // Check if the last field is missing
+    if (size > 0 && data[size - 1] == delim_) fields->emplace_back();
+    return Status::OK();
   }
 };
 
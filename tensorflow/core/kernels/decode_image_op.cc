@@ -70,6 +70,9 @@ class DecodeImageOp : public OpKernel {
     // Determine which op we are: jpeg, png, gif, or any
     if (type_string() == "DecodeJpeg") {
       format_ = kJpgFormat;
+    } else if (type_string() == "DecodeAndCropJpeg") {
+      format_ = kJpgFormat;
+      flags_.crop = true;
     } else if (type_string() == "DecodePng") {
       format_ = kPngFormat;
     } else if (type_string() == "DecodeGif") {
@@ -162,6 +165,9 @@ class DecodeImageOp : public OpKernel {
     OP_REQUIRES(context, magic == kPngFormat || channel_bits_ == 8,
                 errors::InvalidArgument(FileFormatString(magic, input),
                                         " does not support uint16 output"));
+    OP_REQUIRES(context, !flags_.crop || magic == kJpgFormat,
+                errors::InvalidArgument("Expected JPEG image, got ",
+                                        FileFormatString(magic, input)));
 
     switch (magic) {
       case kJpgFormat:
@@ -184,12 +190,32 @@ class DecodeImageOp : public OpKernel {
                 errors::InvalidArgument(
                     "channels must be 0, 1, or 3 for JPEG, got ", channels_));
 
+    jpeg::UncompressFlags flags = flags_;
+    if (flags.crop) {
+      const Tensor& crop_window = context->input(1);
+      OP_REQUIRES(context, crop_window.shape() == TensorShape({4}),
+                  errors::InvalidArgument(
+                      "crop_window must have shape [4], got shape ",
+                      crop_window.shape().DebugString()));
+      auto crop_window_vec = crop_window.vec<int32>();
+      flags.crop_y = crop_window_vec(0);
+      flags.crop_x = crop_window_vec(1);
+      flags.crop_height = crop_window_vec(2);
+      flags.crop_width = crop_window_vec(3);
+      OP_REQUIRES(context,
+                  flags.crop_y >= 0 && flags.crop_x >= 0 &&
+                      flags.crop_height > 0 && flags.crop_width > 0,
+                  errors::InvalidArgument(
+                      "Invalid crop window: ",
+                      crop_window.SummarizeValue(4)));
+    }
+
     // Decode jpeg, allocating tensor once the size is known
     Tensor* output = nullptr;
     OP_REQUIRES(
         context,
         jpeg::Uncompress(
-            input.data(), input.size(), flags_, nullptr /* nwarn */,
+            input.data(), input.size(), flags, nullptr /* nwarn */,
             [=, &output](int width, int height, int channels) -> uint8* {
               Status status(context->allocate_output(
                   0,
@@ -204,7 +230,10 @@ class DecodeImageOp : public OpKernel {
               }
               return output->flat<uint8>().data();
             }),
-        errors::InvalidArgument("Invalid JPEG data, size ", input.size()));
+        errors::InvalidArgument(flags.crop
+                                    ? "Invalid JPEG data or crop window, size "
+                                    : "Invalid JPEG data, size ",
+                                input.size()));
   }
 
   void DecodePng(OpKernelContext* context, StringPiece input) {
@@ -307,9 +336,54 @@ class DecodeImageOp : public OpKernel {
   jpeg::UncompressFlags flags_;
 };
 
+// Extract the shape of a JPEG image from its header, without decoding it.
+class ExtractJpegShapeOp : public OpKernel {
+ public:
+  explicit ExtractJpegShapeOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& contents = context->input(0);
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(contents.shape()),
+                errors::InvalidArgument("contents must be scalar, got shape ",
+                                        contents.shape().DebugString()));
+    const StringPiece input = contents.scalar<string>()();
+    OP_REQUIRES(context, input.size() <= std::numeric_limits<int>::max(),
+                errors::InvalidArgument("JPEG contents are too large for int: ",
+                                        input.size()));
+
+    int width, height, components;
+    OP_REQUIRES(
+        context,
+        jpeg::GetImageInfo(input.data(), input.size(), &width, &height,
+                           &components),
+        errors::InvalidArgument("Invalid JPEG data, size ", input.size()));
+
+    Tensor* image_shape = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, TensorShape({3}), &image_shape));
+    // DecodeJpeg converts CMYK images to RGB.
+    if (image_shape->dtype() == DT_INT32) {
+      auto image_shape_vec = image_shape->vec<int32>();
+      image_shape_vec(0) = height;
+      image_shape_vec(1) = width;
+      image_shape_vec(2) = std::min(components, 3);
+    } else {
+      auto image_shape_vec = image_shape->vec<int64>();
+      image_shape_vec(0) = height;
+      image_shape_vec(1) = width;
+      image_shape_vec(2) = std::min(components, 3);
+    }
+  }
+};
+
 REGISTER_KERNEL_BUILDER(Name("DecodeJpeg").Device(DEVICE_CPU), DecodeImageOp);
+REGISTER_KERNEL_BUILDER(Name("DecodeAndCropJpeg").Device(DEVICE_CPU),
+                        DecodeImageOp);
 REGISTER_KERNEL_BUILDER(Name("DecodePng").Device(DEVICE_CPU), DecodeImageOp);
 REGISTER_KERNEL_BUILDER(Name("DecodeGif").Device(DEVICE_CPU), DecodeImageOp);
+REGISTER_KERNEL_BUILDER(Name("ExtractJpegShape").Device(DEVICE_CPU),
+                        ExtractJpegShapeOp);
 
 }  // namespace
 }  // namespace tensorflow
@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/deep_conv2d.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/kernels/winograd_transform.h"
@@ -76,27 +77,33 @@ static int64 GetDirectConvCost(int filter_rows, int filter_cols, int in_depth,
   return filter_rows * filter_cols * in_depth * out_depth * out_rows * out_cols;
 }
 
-// Reads environment variable 'env_var_name'.
-// Returns 'true' if environment variable is enabled, false otherwise.
-static bool ReadBoolFromEnvVar(const char* env_var_name, bool default_val) {
-  const char* tf_env_var_val = getenv(env_var_name);
-  if (tf_env_var_val != nullptr) {
-    StringPiece tf_env_var_val_str(tf_env_var_val);
-    if (tf_env_var_val_str == "0") {
-      return false;
-    }
-    return true;
-  }
-  return default_val;
+static int64 GetFilterTransformCost(int input_tile_rows, int input_tile_cols,
+                                    int filter_rows, int filter_cols,
+                                    int in_depth, int out_depth) {
+  // Each filter is transformed (a MatMul by the filter transform matrix), and
+  // then packed.
+  const int64 input_tile_spatial_size = input_tile_rows * input_tile_cols;
+  return input_tile_spatial_size * (filter_rows * filter_cols + 1) * in_depth *
+         out_depth;
 }
 
+// DeepConv2D is only selected automatically when its estimated cost is below
+// this fraction of the direct convolution cost, as its flops are not as
+// efficient as the direct convolution ones.
+static const double kDeepConvAutoCostRatio = 0.7;
+
+// The filter transforms run on a single thread without vectorization, and so
+// take several times longer than their flop cost suggests.
+static const int64 kFilterTransformCostFactor = 4;
+
 // Returns true if convolution can be computed efficiently by DeepConv2D,
 // returns false otherwise.
 // TODO(andydavis) Add support for other filter sizes and strides.
 // TODO(andydavis) Add support for autotuning.
 bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
                       int filter_cols, int in_depth, int out_depth,
-                      int out_rows, int out_cols) {
+                      int out_rows, int out_cols, int batch,
+                      bool filter_transform_cached) {
   // Check if convolution parameters are supported.
   // TODO(andydavis) Add support for multiple filter sizes and strides.
   if (stride_rows > 1 || stride_cols > 1 || filter_rows != 3 ||
@@ -104,13 +111,17 @@ bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
     return false;
   }
 
-  // Check if deep convolution is enabled by environment variable.
+  // Check if deep convolution is disabled or forced by environment variable:
+  // "0" disables it, any other value uses it whenever its flop cost per image
+  // is lower than the direct convolution one. When unset, it is used if its
+  // total cost, including the filter transforms, is clearly lower.
   // NOTE: IF this environment variable name changes, update conv_ops_test.py.
-  if (!ReadBoolFromEnvVar("TF_USE_DEEP_CONV2D", false)) {
+  const char* env_val = getenv("TF_USE_DEEP_CONV2D");
+  if (env_val != nullptr && StringPiece(env_val) == "0") {
     return false;
   }
+  const bool forced = env_val != nullptr;
 
-  // Check if flop cost of deep convolution is less than direct convolution.
   WinogradTransform<float> t;
   const int64 deep_conv_cost = GetDeepConvCost(
       t.input_shape().rows, t.input_shape().cols, t.output_shape().rows,
@@ -118,13 +129,70 @@ bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
   const int64 direct_conv_cost = GetDirectConvCost(
       filter_rows, filter_cols, in_depth, out_depth, out_rows, out_cols);
 
+  bool use_deep_conv;
+  if (forced) {
+    use_deep_conv = deep_conv_cost < direct_conv_cost;
+  } else {
+    const int64 filter_transform_cost =
+        filter_transform_cached
+            ? 0
+            : kFilterTransformCostFactor *
+                  GetFilterTransformCost(t.input_shape().rows,
+                                         t.input_shape().cols, filter_rows,
+                                         filter_cols, in_depth, out_depth);
+    use_deep_conv =
+        static_cast<double>(batch * deep_conv_cost + filter_transform_cost) <
+        kDeepConvAutoCostRatio * static_cast<double>(batch * direct_conv_cost);
+  }
+
   VLOG(2) << "CanUseDeepConv2D"
           << " deep_conv_cost: " << deep_conv_cost
           << " direct_conv_cost: " << direct_conv_cost
           << " deep_direct_ratio: " << (static_cast<float>(deep_conv_cost) /
                                         static_cast<float>(direct_conv_cost))
-          << " use_deep_conv: " << (deep_conv_cost < direct_conv_cost);
-  return deep_conv_cost < direct_conv_cost;
+          << " filter_transform_cached: " << filter_transform_cached
+          << " use_deep_conv: " << use_deep_conv;
+  return use_deep_conv;
+}
+
+bool DeepConv2DFilterCache::SameShape(const Conv2DArgs& args) const {
+  return filter_rows_ == args.filter_rows && filter_cols_ == args.filter_cols &&
+         in_depth_ == args.in_depth && out_depth_ == args.out_depth;
+}
+
+bool DeepConv2DFilterCache::Lookup(const Conv2DArgs& args, const void* filter,
+                                   int64 filter_bytes,
+                                   std::vector<Tensor>* packed_filters) {
+  mutex_lock l(mu_);
+  if (disabled_) return false;
+  const char* filter_data = static_cast<const char*>(filter);
+  if (filter_.empty() || !SameShape(args)) {
+    // Keep a copy to tell whether the filter is constant at the next lookup.
+    filter_rows_ = args.filter_rows;
+    filter_cols_ = args.filter_cols;
+    in_depth_ = args.in_depth;
+    out_depth_ = args.out_depth;
+    filter_.assign(filter_data, filter_data + filter_bytes);
+    packed_filters_.clear();
+    return false;
+  }
+  if (memcmp(filter_.data(), filter_data, filter_bytes) != 0) {
+    // The filter isn't constant, so stop caching it.
+    VLOG(2) << "DeepConv2DFilterCache disabled";
+    disabled_ = true;
+    std::vector<char>().swap(filter_);
+    packed_filters_.clear();
+    return false;
+  }
+  *packed_filters = packed_filters_;
+  return true;
+}
+
+void DeepConv2DFilterCache::Insert(const Conv2DArgs& args,
+                                   const std::vector<Tensor>& packed_filters) {
+  mutex_lock l(mu_);
+  if (disabled_ || !SameShape(args) || !packed_filters_.empty()) return;
+  packed_filters_ = packed_filters;
 }
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
@@ -922,8 +990,11 @@ namespace functor {
 // in_depth * out_depth).
 // Details:
 // *) Transforms and packs filters from 'filter' in parallel.
-// *) Computes Conv2D parallelized across 'batch' dimension.
-//   *) Each thread loops over images in its batch shard, copying 'num_tiles'
+// *) Reuses the transformed filters from 'packed_filters' when provided, so
+//    that they are only computed once for constant filters.
+// *) Computes Conv2D parallelized across 'batch' and tile rows, so that
+//    single images are computed in parallel too.
+//   *) Each thread loops over the tile rows in its shard, copying 'num_tiles'
 //      input tiles into a local buffer, and computing the Conv2D output of
 //      these tiles by all filters.
 
@@ -935,7 +1006,8 @@ namespace functor {
 template <typename T>
 struct DeepConv2D<CPUDevice, T> {
   void operator()(OpKernelContext* ctx, const Conv2DArgs& args, const T* input,
-                  const T* filter, T* output) {
+                  const T* filter, T* output,
+                  std::vector<Tensor>* packed_filters) {
     // TODO(andydavis) Add function to select transform based on conv params.
     std::unique_ptr<DeepConv2DTransform<T>> transform(new WinogradTransform<T>);
 
@@ -960,24 +1032,30 @@ struct DeepConv2D<CPUDevice, T> {
         std::max(0LL, args.filter_cols - base_filter_rows);
     const int64 filter_shards_col = 1 + (filter_residual_col + 2 - 1) / 2;
 
-    // Allocate buffer for transformed filters.
-    Tensor filter_transform;
-    OP_REQUIRES_OK(
-        ctx, ctx->allocate_temp(
-                 DataTypeToEnum<T>::value,
-                 TensorShape({tile_rows, tile_cols, out_depth,
-                              filter_shards_row, filter_shards_col, in_depth}),
-                 &filter_transform));
-    T* filter_transform_data = filter_transform.template flat<T>().data();
-
-    // Transform filters.
-    TransformFilters<T>()(ctx, args, transform.get(), filter_shards_row,
-                          filter_shards_col, filter, filter_transform_data);
-
-    // Pack filters.
-    std::vector<Tensor> packed_filters(tile_spatial_size);
-    PackFilters<T>()(ctx, args, tile_spatial_size, filter_shards_row,
-                     filter_shards_col, filter_transform_data, &packed_filters);
+    std::vector<Tensor> local_packed_filters;
+    if (packed_filters == nullptr) packed_filters = &local_packed_filters;
+    if (packed_filters->empty()) {
+      packed_filters->resize(tile_spatial_size);
+      // Allocate buffer for transformed filters.
+      Tensor filter_transform;
+      OP_REQUIRES_OK(ctx, ctx->allocate_temp(
+                              DataTypeToEnum<T>::value,
+                              TensorShape({tile_rows, tile_cols, out_depth,
+                                           filter_shards_row, filter_shards_col,
+                                           in_depth}),
+                              &filter_transform));
+      T* filter_transform_data = filter_transform.template flat<T>().data();
+
+      // Transform filters.
+      TransformFilters<T>()(ctx, args, transform.get(), filter_shards_row,
+                            filter_shards_col, filter, filter_transform_data);
+
+      // Pack filters.
+      PackFilters<T>()(ctx, args, tile_spatial_size, filter_shards_row,
+                       filter_shards_col, filter_transform_data,
+                       packed_filters);
+      if (!ctx->status().ok()) return;
+    }
 
     // Allocate buffer for tile transform matrix.
     Tensor tile_transform_matrix_tensor;
@@ -1001,14 +1079,20 @@ struct DeepConv2D<CPUDevice, T> {
     transform->GetOutputTransformMatrix(
         out_tile_spatial_size, tile_spatial_size, output_transform_matrix);
 
-    auto shard = [&ctx, &args, &transform, &packed_filters, &in_depth,
+    const int64 row_tiles =
+        (args.out_rows + out_tile_rows - 1) / out_tile_rows +
+        filter_shards_row - 1;
+    // Output tiles only overlap, and so accumulate into the same outputs, with
+    // sharded filters. Images are then split into a single unit of work.
+    const int64 unit_tile_rows = filter_shards_row == 1 ? 1 : row_tiles;
+    const int64 units_per_image = row_tiles / unit_tile_rows;
+
+    auto shard = [&ctx, &args, &transform, packed_filters, &in_depth,
                   out_depth, tile_rows, tile_cols, out_tile_rows, out_tile_cols,
                   filter_shards_row, filter_shards_col, tile_spatial_size,
-                  &input, &tile_transform_matrix, &output_transform_matrix,
-                  &output](int64 batch_start, int64 batch_limit) {
-      const int64 row_tiles =
-          (args.out_rows + out_tile_rows - 1) / out_tile_rows +
-          filter_shards_row - 1;
+                  row_tiles, unit_tile_rows, units_per_image, &input,
+                  &tile_transform_matrix, &output_transform_matrix,
+                  &output](int64 unit_start, int64 unit_limit) {
       const int64 col_tiles =
           (args.out_cols + out_tile_cols - 1) / out_tile_cols +
           filter_shards_col - 1;
@@ -1116,11 +1200,14 @@ struct DeepConv2D<CPUDevice, T> {
       const int64 tile_stride_rows = transform->output_shape().rows;
       const int64 tile_stride_cols = transform->output_shape().cols;
 
-      for (int64 b = batch_start; b < batch_limit; ++b) {
+      for (int64 unit = unit_start; unit < unit_limit; ++unit) {
+        const int64 b = unit / units_per_image;
         const int64 in_base = b * input_image_size;
         const int64 out_base = b * output_image_size;
 
-        for (int64 tile_r = 0; tile_r < row_tiles; ++tile_r) {
+        const int64 tile_r_start = (unit % units_per_image) * unit_tile_rows;
+        const int64 tile_r_limit = tile_r_start + unit_tile_rows;
+        for (int64 tile_r = tile_r_start; tile_r < tile_r_limit; ++tile_r) {
           const int64 in_r = tile_r * tile_stride_rows - row_pad;
 
           // Process unrolled tiles.
@@ -1128,7 +1215,7 @@ struct DeepConv2D<CPUDevice, T> {
                tile_c += num_tiles) {
             const int64 in_c = tile_c * tile_stride_cols - col_pad;
             ComputeConv2D<T>()(args, transform.get(), conv_state, in_r, in_c,
-                               num_tiles, packed_filters, input + in_base,
+                               num_tiles, *packed_filters, input + in_base,
                                output + out_base);
           }
           // Process remaining tiles.
@@ -1136,7 +1223,7 @@ struct DeepConv2D<CPUDevice, T> {
             const int64 rem_tiles = col_tiles - unroll_col_limit;
             const int64 in_c = unroll_col_limit * tile_stride_cols - col_pad;
             ComputeConv2D<T>()(args, transform.get(), conv_state, in_r, in_c,
-                               rem_tiles, packed_filters, input + in_base,
+                               rem_tiles, *packed_filters, input + in_base,
                                output + out_base);
           }
         }
@@ -1144,9 +1231,10 @@ struct DeepConv2D<CPUDevice, T> {
     };
     auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
     const int64 shard_cost = args.out_rows * args.out_cols * args.out_depth *
-                             tile_spatial_size * args.in_depth;
-    Shard(worker_threads.num_threads, worker_threads.workers, args.batch,
-          shard_cost, shard);
+                             tile_spatial_size * args.in_depth /
+                             units_per_image;
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          args.batch * units_per_image, shard_cost, shard);
   }
 };
 
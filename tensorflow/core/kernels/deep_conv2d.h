@@ -16,7 +16,12 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DEEP_CONV2D_H_
 #define THIRD_PARTY_TENSORFLOW_CORE_KERNELS_DEEP_CONV2D_H_
 
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 
@@ -94,20 +99,60 @@ struct Conv2DArgs {
         out_depth(0) {}
 };
 
+// Keeps the transformed filters of the DeepConv2D calls of a kernel, so that
+// convolutions with constant filters, as in inference, only transform them
+// once. Every lookup compares the filter with a copy of the previous one, and
+// caching stops for good once the filter changes, e.g. during training.
+class DeepConv2DFilterCache {
+ public:
+  DeepConv2DFilterCache() {}
+
+  // Returns true if the 'filter_bytes' bytes at 'filter' are the same filter
+  // as at the previous lookup, i.e. if the filter is likely constant. Sets
+  // 'packed_filters' to its transformed filters if they are cached.
+  bool Lookup(const Conv2DArgs& args, const void* filter, int64 filter_bytes,
+              std::vector<Tensor>* packed_filters);
+
+  // Caches 'packed_filters' as the transformed filters of the last filter
+  // looked up for 'args', unless caching has been stopped since.
+  void Insert(const Conv2DArgs& args,
+              const std::vector<Tensor>& packed_filters);
+
+ private:
+  bool SameShape(const Conv2DArgs& args) const EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  mutex mu_;
+  bool disabled_ GUARDED_BY(mu_) = false;
+  int filter_rows_ GUARDED_BY(mu_) = 0;
+  int filter_cols_ GUARDED_BY(mu_) = 0;
+  int in_depth_ GUARDED_BY(mu_) = 0;
+  int out_depth_ GUARDED_BY(mu_) = 0;
+  std::vector<char> filter_ GUARDED_BY(mu_);
+  std::vector<Tensor> packed_filters_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(DeepConv2DFilterCache);
+};
+
 // Returns true if convolution operation specified by function arguments
 // can use DeepConv2D implementation, and false otherwise.
 // May return false based on parameters, cost, or whether feature is disabled.
+// 'filter_transform_cached' tells whether the transformed filters come from a
+// DeepConv2DFilterCache, or will for the next calls, and so cost nothing.
 bool CanUseDeepConv2D(int stride_rows, int stride_cols, int filter_rows,
                       int filter_cols, int in_depth, int out_depth,
-                      int out_rows, int out_cols);
+                      int out_rows, int out_cols, int batch,
+                      bool filter_transform_cached);
 
 namespace functor {
 
 // Calls DeepConv2D implementation (see deep_conv2d.cc for details).
+// If 'packed_filters' is not null, the transformed filters are read from it
+// when it isn't empty, and stored to it otherwise.
 template <typename Device, typename T>
 struct DeepConv2D {
   void operator()(OpKernelContext* ctx, const Conv2DArgs& args, const T* input,
-                  const T* filter, T* output);
+                  const T* filter, T* output,
+                  std::vector<Tensor>* packed_filters = nullptr);
 };
 
 }  // namespace functor
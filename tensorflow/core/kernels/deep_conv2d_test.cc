@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include "tensorflow/core/kernels/deep_conv2d.h"
 #include "tensorflow/core/kernels/winograd_transform.h"
 #include "tensorflow/core/platform/test.h"
 
@@ -155,5 +156,87 @@ TEST(DeepConv2DTransformTest, WingradOutputTransformMatrix) {
   }
 }
 
+static Conv2DArgs FilterCacheTestArgs() {
+  Conv2DArgs args;
+  args.filter_rows = 3;
+  args.filter_cols = 3;
+  args.in_depth = 2;
+  args.out_depth = 4;
+  return args;
+}
+
+TEST(DeepConv2DFilterCacheTest, CachesConstantFilter) {
+  const Conv2DArgs args = FilterCacheTestArgs();
+  std::vector<float> filter(3 * 3 * 2 * 4, 1.0f);
+  const int64 filter_bytes = filter.size() * sizeof(float);
+  std::vector<Tensor> packed(2, Tensor(DT_FLOAT, TensorShape({8})));
+
+  DeepConv2DFilterCache cache;
+  std::vector<Tensor> found;
+  EXPECT_FALSE(cache.Lookup(args, filter.data(), filter_bytes, &found));
+  cache.Insert(args, packed);
+
+  // The same filter values, at another address.
+  std::vector<float> filter_copy = filter;
+  EXPECT_TRUE(cache.Lookup(args, filter_copy.data(), filter_bytes, &found));
+  ASSERT_EQ(2, found.size());
+  EXPECT_TRUE(found[0].SharesBufferWith(packed[0]));
+  EXPECT_TRUE(found[1].SharesBufferWith(packed[1]));
+}
+
+TEST(DeepConv2DFilterCacheTest, ConstantFilterBeforeInsert) {
+  const Conv2DArgs args = FilterCacheTestArgs();
+  std::vector<float> filter(3 * 3 * 2 * 4, 1.0f);
+  const int64 filter_bytes = filter.size() * sizeof(float);
+
+  DeepConv2DFilterCache cache;
+  std::vector<Tensor> found;
+  EXPECT_FALSE(cache.Lookup(args, filter.data(), filter_bytes, &found));
+  EXPECT_TRUE(cache.Lookup(args, filter.data(), filter_bytes, &found));
+  EXPECT_TRUE(found.empty());
+}
+
+TEST(DeepConv2DFilterCacheTest, StopsCachingChangingFilter) {
+  const Conv2DArgs args = FilterCacheTestArgs();
+  std::vector<float> filter(3 * 3 * 2 * 4, 1.0f);
+  const int64 filter_bytes = filter.size() * sizeof(float);
+  std::vector<Tensor> packed(2, Tensor(DT_FLOAT, TensorShape({8})));
+
+  DeepConv2DFilterCache cache;
+  std::vector<Tensor> found;
+  EXPECT_FALSE(cache.Lookup(args, filter.data(), filter_bytes, &found));
+  cache.Insert(args, packed);
+
+  filter[5] = 2.0f;
+  EXPECT_FALSE(cache.Lookup(args, filter.data(), filter_bytes, &found));
+  EXPECT_TRUE(found.empty());
+
+  // Caching has stopped, even if the filter doesn't change anymore.
+  cache.Insert(args, packed);
+  EXPECT_FALSE(cache.Lookup(args, filter.data(), filter_bytes, &found));
+  EXPECT_FALSE(cache.Lookup(args, filter.data(), filter_bytes, &found));
+  EXPECT_TRUE(found.empty());
+}
+
+TEST(DeepConv2DFilterCacheTest, ShapeChange) {
+  Conv2DArgs args = FilterCacheTestArgs();
+  std::vector<float> filter(3 * 3 * 2 * 4, 1.0f);
+  const int64 filter_bytes = filter.size() * sizeof(float);
+  std::vector<Tensor> packed(2, Tensor(DT_FLOAT, TensorShape({8})));
+
+  DeepConv2DFilterCache cache;
+  std::vector<Tensor> found;
+  EXPECT_FALSE(cache.Lookup(args, filter.data(), filter_bytes, &found));
+  cache.Insert(args, packed);
+
+  // Same bytes, but for another shape.
+  args.in_depth = 4;
+  args.out_depth = 2;
+  EXPECT_FALSE(cache.Lookup(args, filter.data(), filter_bytes, &found));
+  EXPECT_TRUE(found.empty());
+  EXPECT_TRUE(cache.Lookup(args, filter.data(), filter_bytes, &found));
+  EXPECT_TRUE(found.empty());
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -104,7 +104,7 @@ class DenseToSparseBatchDatasetOp : public UnaryDatasetOpKernel {
 
     ~Dataset() override { input_->Unref(); }
 
-    std::unique_ptr<IteratorBase> MakeIterator() const override {
+    std::unique_ptr<IteratorBase> MakeIteratorInternal() const override {
       return std::unique_ptr<IteratorBase>(new Iterator(this));
     }
 
@@ -32,6 +32,10 @@ typedef Eigen::GpuDevice GPUDevice;
 TF_CALL_GPU_NUMBER_TYPES(DEFINE_GPU_KERNELS);
 #undef DEFINE_GPU_KERNELS
 
+// Copies of complex resource variables, see PrepareToUpdateVariable().
+template struct functor::DenseUpdate<GPUDevice, complex64, ASSIGN>;
+template struct functor::DenseUpdate<GPUDevice, complex128, ASSIGN>;
+
 }  // end namespace tensorflow
 
 #endif  // GOOGLE_CUDA
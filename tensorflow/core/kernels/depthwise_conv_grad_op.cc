@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <cmath>
+#include <utility>
 
 #include "tensorflow/core/framework/numeric_op.h"
 #include "tensorflow/core/framework/op_kernel.h"
@@ -29,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/depthwise_conv_op.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/padding.h"
@@ -361,6 +363,75 @@ static void ComputeBackpropInput(const DepthwiseArgs& args,
   }
 }
 
+// Computes the input row 'in_r' of the depthwise conv2d backprop input of one
+// 'out_backprop' image by 'filter' when 'depth_multiplier' is one. Then each
+// input channel only gets gradients from the same output channel, so the
+// channels are vectorized directly from 'out_backprop' and the unpadded
+// 'filter', without copying regions of 'out_backprop' to a buffer first.
+template <typename T>
+static void ComputeBackpropInputMultiplierOne(const DepthwiseArgs& args,
+                                              const int64 in_r,
+                                              const T* out_backprop,
+                                              const T* filter,
+                                              T* in_backprop) {
+  typedef typename Eigen::internal::packet_traits<T>::type Packet;
+  static const int64 kPacketSize = (sizeof(Packet) / sizeof(T));
+  const int64 depth = args.in_depth;
+
+  // The (filter row, output row) pairs of the outputs that read 'in_r'.
+  gtl::InlinedVector<std::pair<int64, int64>, 8> row_taps;
+  for (int64 f_r = 0; f_r < args.filter_rows; ++f_r) {
+    const int64 strided_out_r = in_r + args.pad_rows - f_r;
+    if (strided_out_r < 0 || strided_out_r % args.stride != 0) continue;
+    const int64 out_r = strided_out_r / args.stride;
+    if (out_r < args.out_rows) row_taps.emplace_back(f_r, out_r);
+  }
+
+  gtl::InlinedVector<std::pair<int64, int64>, 8> col_taps;
+  for (int64 in_c = 0; in_c < args.in_cols; ++in_c) {
+    // The (filter column, output column) pairs of the outputs that read
+    // 'in_c'.
+    col_taps.clear();
+    for (int64 f_c = 0; f_c < args.filter_cols; ++f_c) {
+      const int64 strided_out_c = in_c + args.pad_cols - f_c;
+      if (strided_out_c < 0 || strided_out_c % args.stride != 0) continue;
+      const int64 out_c = strided_out_c / args.stride;
+      if (out_c < args.out_cols) col_taps.emplace_back(f_c, out_c);
+    }
+
+    T* out = in_backprop + (in_r * args.in_cols + in_c) * depth;
+    int64 d = 0;
+    for (; d + kPacketSize <= depth; d += kPacketSize) {
+      auto vaccum = Eigen::internal::pset1<Packet>(0);
+      for (const auto& row : row_taps) {
+        for (const auto& col : col_taps) {
+          const T* f =
+              filter + (row.first * args.filter_cols + col.first) * depth + d;
+          const T* g =
+              out_backprop + (row.second * args.out_cols + col.second) * depth +
+              d;
+          vaccum = Eigen::internal::pmadd<Packet>(
+              Eigen::internal::ploadu<Packet>(f),
+              Eigen::internal::ploadu<Packet>(g), vaccum);
+        }
+      }
+      Eigen::internal::pstoreu<T>(out + d, vaccum);
+    }
+    for (; d < depth; ++d) {
+      T accum = 0;
+      for (const auto& row : row_taps) {
+        for (const auto& col : col_taps) {
+          accum +=
+              filter[(row.first * args.filter_cols + col.first) * depth + d] *
+              out_backprop[(row.second * args.out_cols + col.second) * depth +
+                           d];
+        }
+      }
+      out[d] = accum;
+    }
+  }
+}
+
 // Kernels to compute the input backprop for depthwise convolution.
 template <typename Device, typename T>
 struct LaunchDepthwiseConvBackpropInputOp;
@@ -381,6 +452,29 @@ struct LaunchDepthwiseConvBackpropInputOp<CPUDevice, T> {
 
     static const int64 kPacketSize = (sizeof(Packet) / sizeof(T));
 
+    if (args.depth_multiplier == 1) {
+      // Computes rows of 'in_backprop' directly from 'out_backprop' and
+      // 'depthwise_filter'.
+      auto shard = [&args, out_backprop, depthwise_filter, in_backprop](
+          int64 start, int64 limit) {
+        const int64 input_image_size =
+            args.in_rows * args.in_cols * args.in_depth;
+        const int64 output_image_size =
+            args.out_rows * args.out_cols * args.out_depth;
+        for (int64 i = start; i < limit; ++i) {
+          const int64 b = i / args.in_rows;
+          ComputeBackpropInputMultiplierOne<T>(
+              args, i % args.in_rows, out_backprop + b * output_image_size,
+              depthwise_filter, in_backprop + b * input_image_size);
+        }
+      };
+      const int64 shard_cost = args.in_cols * args.out_depth;
+      auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+      Shard(worker_threads.num_threads, worker_threads.workers,
+            args.batch * args.in_rows, shard_cost, shard);
+      return;
+    }
+
     // Pad 'depthwise_filter' to vector register width (if needed).
     const bool pad_filter = (args.out_depth % kPacketSize) == 0 ? false : true;
     Tensor padded_filter;
@@ -737,6 +831,54 @@ static void ComputeBackpropFilter(const DepthwiseArgs& args,
   }
 }
 
+// Accumulates the depthwise conv2d backprop filter of the output row 'out_r'
+// of one image into 'output_buffer' (laid out like in ComputeBackpropFilter)
+// when 'depth_multiplier' is one, reading 'input' directly instead of copying
+// its patches to a buffer first.
+template <typename T>
+static void ComputeBackpropFilterMultiplierOne(
+    const DepthwiseArgs& args, const int64 padded_out_depth_size,
+    const int64 out_r, const T* out_backprop, const T* input,
+    T* output_buffer) {
+  typedef typename Eigen::internal::packet_traits<T>::type Packet;
+  static const int64 kPacketSize = (sizeof(Packet) / sizeof(T));
+  const int64 depth = args.in_depth;
+
+  const int64 in_r_start = out_r * args.stride - args.pad_rows;
+  const int64 f_r_begin = std::max<int64>(0, -in_r_start);
+  const int64 f_r_end =
+      std::min<int64>(args.filter_rows, args.in_rows - in_r_start);
+
+  for (int64 out_c = 0; out_c < args.out_cols; ++out_c) {
+    const int64 in_c_start = out_c * args.stride - args.pad_cols;
+    const int64 f_c_begin = std::max<int64>(0, -in_c_start);
+    const int64 f_c_end =
+        std::min<int64>(args.filter_cols, args.in_cols - in_c_start);
+    const T* g = out_backprop + (out_r * args.out_cols + out_c) * depth;
+
+    for (int64 f_r = f_r_begin; f_r < f_r_end; ++f_r) {
+      for (int64 f_c = f_c_begin; f_c < f_c_end; ++f_c) {
+        const T* in =
+            input + ((in_r_start + f_r) * args.in_cols + in_c_start + f_c) *
+                        depth;
+        T* out = output_buffer +
+                 (f_r * args.filter_cols + f_c) * padded_out_depth_size;
+        int64 d = 0;
+        for (; d + kPacketSize <= depth; d += kPacketSize) {
+          auto out_block = Eigen::internal::ploadu<Packet>(out + d);
+          out_block = Eigen::internal::pmadd<Packet>(
+              Eigen::internal::ploadu<Packet>(g + d),
+              Eigen::internal::ploadu<Packet>(in + d), out_block);
+          Eigen::internal::pstoreu<T>(out + d, out_block);
+        }
+        for (; d < depth; ++d) {
+          out[d] += g[d] * in[d];
+        }
+      }
+    }
+  }
+}
+
 template <typename Device, typename T>
 struct LaunchDepthwiseConvBackpropFilterOp;
 
@@ -798,6 +940,13 @@ struct LaunchDepthwiseConvBackpropFilterOp<CPUDevice, T> {
         memset(output_buffer, 0, padded_filter_size * sizeof(T));
 
         for (int out_r = 0; out_r < args.out_rows; ++out_r) {
+          if (args.depth_multiplier == 1) {
+            ComputeBackpropFilterMultiplierOne<T>(
+                args, padded_out_depth_size, out_r,
+                out_backprop + b * output_image_size,
+                input + b * input_image_size, output_buffer);
+            continue;
+          }
           for (int out_c = 0; out_c < args.out_cols; ++out_c) {
             // Populate 'input_buffer_data' with data from local input region.
             functor::DepthwiseInputCopyOp<T>()(
@@ -141,6 +141,159 @@ struct DepthwiseConv2DKernel {
   }
 };
 
+// Computes the output row 'out_r' of the depthwise conv2d of one 'input' image
+// by 'filter' when 'depth_multiplier' is one. Then each output channel only
+// reads the same channel of the input, so the channels are vectorized
+// directly from 'input' and the unpadded 'filter', without copying patches
+// of the input to an aligned buffer first.
+//
+// The output columns whose filter window is entirely inside the input are
+// computed kOutColTile at a time, so that every filter register is loaded
+// once for all of them.
+template <typename T>
+struct DepthwiseConv2DMultiplierOneKernel {
+  typedef typename Eigen::internal::packet_traits<T>::type Packet;
+  static const int64 kPacketSize = (sizeof(Packet) / sizeof(T));
+  static const int64 kOutColTile = 4;
+
+  static void Run(const DepthwiseArgs& args, const int64 out_r,
+                  const T* input, const T* filter, T* output) {
+    const int64 in_r_start = out_r * args.stride - args.pad_rows;
+    const int64 f_r_begin = std::max<int64>(0, -in_r_start);
+    const int64 f_r_end =
+        std::min<int64>(args.filter_rows, args.in_rows - in_r_start);
+
+    // Output columns [c_begin, c_end) don't read the column padding.
+    const int64 c_begin = std::min<int64>(
+        args.out_cols, (args.pad_cols + args.stride - 1) / args.stride);
+    const int64 last_in_c_start = args.in_cols + args.pad_cols -
+                                  args.filter_cols;
+    const int64 c_end =
+        last_in_c_start < 0
+            ? c_begin
+            : std::max(c_begin, std::min<int64>(
+                                    args.out_cols,
+                                    last_in_c_start / args.stride + 1));
+
+    T* out_row = output + out_r * args.out_cols * args.out_depth;
+    int64 out_c = 0;
+    for (; out_c < c_begin; ++out_c) {
+      RunColumn(args, in_r_start, f_r_begin, f_r_end, out_c, input, filter,
+                out_row);
+    }
+    for (; out_c + kOutColTile <= c_end; out_c += kOutColTile) {
+      RunInteriorTile(args, in_r_start, f_r_begin, f_r_end, out_c, input,
+                      filter, out_row);
+    }
+    for (; out_c < args.out_cols; ++out_c) {
+      RunColumn(args, in_r_start, f_r_begin, f_r_end, out_c, input, filter,
+                out_row);
+    }
+  }
+
+ private:
+  // Computes the output column 'out_c', skipping the taps in the padding.
+  static void RunColumn(const DepthwiseArgs& args, const int64 in_r_start,
+                        const int64 f_r_begin, const int64 f_r_end,
+                        const int64 out_c, const T* input, const T* filter,
+                        T* out_row) {
+    const int64 depth = args.in_depth;
+    const int64 in_c_start = out_c * args.stride - args.pad_cols;
+    const int64 f_c_begin = std::max<int64>(0, -in_c_start);
+    const int64 f_c_end =
+        std::min<int64>(args.filter_cols, args.in_cols - in_c_start);
+    T* out = out_row + out_c * depth;
+
+    int64 d = 0;
+    for (; d + kPacketSize <= depth; d += kPacketSize) {
+      auto vaccum = Eigen::internal::pset1<Packet>(0);
+      for (int64 f_r = f_r_begin; f_r < f_r_end; ++f_r) {
+        const T* in = input + ((in_r_start + f_r) * args.in_cols + in_c_start) *
+                                  depth + d;
+        const T* f = filter + f_r * args.filter_cols * depth + d;
+        for (int64 f_c = f_c_begin; f_c < f_c_end; ++f_c) {
+          vaccum = Eigen::internal::pmadd<Packet>(
+              Eigen::internal::ploadu<Packet>(f + f_c * depth),
+              Eigen::internal::ploadu<Packet>(in + f_c * depth), vaccum);
+        }
+      }
+      Eigen::internal::pstoreu<T>(out + d, vaccum);
+    }
+    for (; d < depth; ++d) {
+      T accum = 0;
+      for (int64 f_r = f_r_begin; f_r < f_r_end; ++f_r) {
+        const T* in = input + ((in_r_start + f_r) * args.in_cols + in_c_start) *
+                                  depth + d;
+        const T* f = filter + f_r * args.filter_cols * depth + d;
+        for (int64 f_c = f_c_begin; f_c < f_c_end; ++f_c) {
+          accum += f[f_c * depth] * in[f_c * depth];
+        }
+      }
+      out[d] = accum;
+    }
+  }
+
+  // Computes the kOutColTile output columns from 'out_c', none of which
+  // reads the column padding.
+  static void RunInteriorTile(const DepthwiseArgs& args,
+                              const int64 in_r_start, const int64 f_r_begin,
+                              const int64 f_r_end, const int64 out_c,
+                              const T* input, const T* filter, T* out_row) {
+    const int64 depth = args.in_depth;
+    const int64 in_c_start = out_c * args.stride - args.pad_cols;
+    const int64 col_stride = args.stride * depth;
+    T* out = out_row + out_c * depth;
+
+    int64 d = 0;
+    for (; d + kPacketSize <= depth; d += kPacketSize) {
+      auto vaccum0 = Eigen::internal::pset1<Packet>(0);
+      auto vaccum1 = Eigen::internal::pset1<Packet>(0);
+      auto vaccum2 = Eigen::internal::pset1<Packet>(0);
+      auto vaccum3 = Eigen::internal::pset1<Packet>(0);
+      for (int64 f_r = f_r_begin; f_r < f_r_end; ++f_r) {
+        const T* in = input + ((in_r_start + f_r) * args.in_cols + in_c_start) *
+                                  depth + d;
+        const T* f = filter + f_r * args.filter_cols * depth + d;
+        for (int64 f_c = 0; f_c < args.filter_cols; ++f_c) {
+          const auto filter_block =
+              Eigen::internal::ploadu<Packet>(f + f_c * depth);
+          const T* in_c = in + f_c * depth;
+          vaccum0 = Eigen::internal::pmadd<Packet>(
+              filter_block, Eigen::internal::ploadu<Packet>(in_c), vaccum0);
+          vaccum1 = Eigen::internal::pmadd<Packet>(
+              filter_block, Eigen::internal::ploadu<Packet>(in_c + col_stride),
+              vaccum1);
+          vaccum2 = Eigen::internal::pmadd<Packet>(
+              filter_block,
+              Eigen::internal::ploadu<Packet>(in_c + 2 * col_stride), vaccum2);
+          vaccum3 = Eigen::internal::pmadd<Packet>(
+              filter_block,
+              Eigen::internal::ploadu<Packet>(in_c + 3 * col_stride), vaccum3);
+        }
+      }
+      Eigen::internal::pstoreu<T>(out + d, vaccum0);
+      Eigen::internal::pstoreu<T>(out + depth + d, vaccum1);
+      Eigen::internal::pstoreu<T>(out + 2 * depth + d, vaccum2);
+      Eigen::internal::pstoreu<T>(out + 3 * depth + d, vaccum3);
+    }
+    for (; d < depth; ++d) {
+      for (int64 t = 0; t < kOutColTile; ++t) {
+        T accum = 0;
+        for (int64 f_r = f_r_begin; f_r < f_r_end; ++f_r) {
+          const T* in =
+              input + ((in_r_start + f_r) * args.in_cols + in_c_start) * depth +
+              t * col_stride + d;
+          const T* f = filter + f_r * args.filter_cols * depth + d;
+          for (int64 f_c = 0; f_c < args.filter_cols; ++f_c) {
+            accum += f[f_c * depth] * in[f_c * depth];
+          }
+        }
+        out[t * depth + d] = accum;
+      }
+    }
+  }
+};
+
 // Computes the depthwise conv2d of 'input' by 'depthwise_filter' and stores
 // the result in 'output'. This implementation trades off copying small patches
 // of the input to achieve better data alignment, which enables vectorized
@@ -149,8 +302,8 @@ struct DepthwiseConv2DKernel {
 //
 // TODO(andydavis) Evaluate the performance of processing multiple input
 // patches in the inner loop.
-// TODO(andydavis) Consider a zero-copy implementation for the case when
-// 'in_depth' is a multiple of register width, and 'depth_multipler' is one.
+// When 'depth_multiplier' is one, no patches are copied, see
+// DepthwiseConv2DMultiplierOneKernel.
 // TODO(andydavis) Evaluate the performance of alternative implementations.
 template <typename T>
 struct LaunchDepthwiseConvOp<CPUDevice, T> {
@@ -164,6 +317,36 @@ struct LaunchDepthwiseConvOp<CPUDevice, T> {
         errors::Unimplemented(
             "Depthwise convolution on CPU is only supported for NHWC format"));
     static const int64 kPacketSize = (sizeof(Packet) / sizeof(T));
+    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
+    const int64 total_shards = args.batch * args.out_rows;
+
+    // Empirically tested to give reasonable performance boosts at batch size 1
+    // without reducing throughput at batch size 32.
+    const float kCostMultiplier = 2.5f;
+
+    // TODO(andydavis): Estimate shard cost (in cycles) based on the number of
+    // flops/loads/stores required to compute one shard.
+    const int64 shard_cost = kCostMultiplier * args.out_cols * args.out_depth;
+
+    if (args.depth_multiplier == 1) {
+      // Computes output rows directly from 'input' and 'depthwise_filter'.
+      auto shard = [&args, input, depthwise_filter, output](int64 start,
+                                                           int64 limit) {
+        const int64 input_image_size =
+            args.in_rows * args.in_cols * args.in_depth;
+        const int64 output_image_size =
+            args.out_rows * args.out_cols * args.out_depth;
+        for (int64 i = start; i < limit; ++i) {
+          const int64 b = i / args.out_rows;
+          DepthwiseConv2DMultiplierOneKernel<T>::Run(
+              args, i % args.out_rows, input + b * input_image_size,
+              depthwise_filter, output + b * output_image_size);
+        }
+      };
+      Shard(worker_threads.num_threads, worker_threads.workers, total_shards,
+            shard_cost, shard);
+      return;
+    }
 
     // Pad 'depthwise_filter' to vector register width (if needed).
     const bool pad_filter = (args.out_depth % kPacketSize) == 0 ? false : true;
@@ -227,17 +410,6 @@ struct LaunchDepthwiseConvOp<CPUDevice, T> {
       }
     };
 
-    const int64 total_shards = args.batch * args.out_rows;
-
-    // Empirically tested to give reasonable performance boosts at batch size 1
-    // without reducing throughput at batch size 32.
-    const float kCostMultiplier = 2.5f;
-
-    // TODO(andydavis): Estimate shard cost (in cycles) based on the number of
-    // flops/loads/stores required to compute one shard.
-    const int64 shard_cost = kCostMultiplier * args.out_cols * args.out_depth;
-
-    auto worker_threads = *(ctx->device()->tensorflow_cpu_worker_threads());
     Shard(worker_threads.num_threads, worker_threads.workers, total_shards,
           shard_cost, shard);
   }
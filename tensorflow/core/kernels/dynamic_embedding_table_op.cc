@@ -0,0 +1,543 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/dynamic_embedding_table_op.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/lookup_table_op.h"
+#include "tensorflow/core/kernels/lookup_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/random/philox_random.h"
+#include "tensorflow/core/lib/random/random_distributions.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace lookup {
+
+namespace {
+
+template <typename K>
+inline uint64 KeySeed(const K& key) {
+  return static_cast<uint64>(key);
+}
+
+inline uint64 KeySeed(const string& key) { return Hash64(key); }
+
+}  // namespace
+
+// DynamicEmbeddingTableBase backed by an unordered_map.
+//
+// IDs that aren't in the table yet are counted in a separate map of
+// candidates until they reach "min_frequency" lookups. When the table is
+// bounded, so is the map of candidates: when it outgrows the table, the counts
+// of all candidates are halved, which forgets the IDs seen only once.
+//
+// Sample use case:
+//
+// DynamicEmbeddingTable<int64, float> table;  // embedding_dim: 64
+// table.Find(ids, &embeddings, zeros);
+// table.ApplyGradients(ids, gradients, learning_rate);
+//
+template <class K, class V>
+class DynamicEmbeddingTable final : public DynamicEmbeddingTableBase {
+ public:
+  DynamicEmbeddingTable(OpKernelContext* ctx, OpKernel* kernel) {
+    int64 embedding_dim;
+    OP_REQUIRES_OK(
+        ctx, GetNodeAttr(kernel->def(), "embedding_dim", &embedding_dim));
+    OP_REQUIRES(ctx, embedding_dim > 0,
+                errors::InvalidArgument("embedding_dim must be positive, got ",
+                                        embedding_dim));
+    embedding_dim_ = embedding_dim;
+    value_shape_ = TensorShape({embedding_dim});
+    OP_REQUIRES_OK(
+        ctx, GetNodeAttr(kernel->def(), "min_frequency", &min_frequency_));
+    OP_REQUIRES_OK(
+        ctx, GetNodeAttr(kernel->def(), "max_num_entries", &max_num_entries_));
+    string eviction_policy;
+    OP_REQUIRES_OK(
+        ctx, GetNodeAttr(kernel->def(), "eviction_policy", &eviction_policy));
+    evict_least_frequent_ = eviction_policy == "lfu";
+    OP_REQUIRES_OK(
+        ctx, GetNodeAttr(kernel->def(), "initial_stddev", &initial_stddev_));
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "seed", &seed_));
+    string optimizer;
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "optimizer", &optimizer));
+    adagrad_ = optimizer == "adagrad";
+    OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "initial_accumulator_value",
+                                    &initial_accumulator_value_));
+  }
+
+  size_t size() const override {
+    mutex_lock l(mu_);
+    return entries_.size();
+  }
+
+  Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+              const Tensor& default_value) override {
+    const auto default_flat = default_value.flat<V>();
+    const auto key_values = key.flat<K>();
+    auto value_values = value->flat_inner_dims<V, 2>();
+
+    mutex_lock l(mu_);
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      const K key_value = SubtleMustCopyUnlessStringOrFloat(key_values(i));
+      const Entry* entry = FindOrAdmit(key_value, default_flat);
+      for (int64 j = 0; j < embedding_dim_; ++j) {
+        value_values(i, j) =
+            entry != nullptr ? entry->values[j] : default_flat(j);
+      }
+    }
+    return Status::OK();
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    mutex_lock l(mu_);
+    DoInsert(keys.flat<K>(), values.flat_inner_dims<V, 2>());
+    return Status::OK();
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    mutex_lock l(mu_);
+    Clear();
+    DoInsert(keys.flat<K>(), values.flat_inner_dims<V, 2>());
+    return Status::OK();
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override {
+    mutex_lock l(mu_);
+    const int64 size = entries_.size();
+    Tensor* keys;
+    Tensor* values;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("keys", TensorShape({size}), &keys));
+    TF_RETURN_IF_ERROR(ctx->allocate_output(
+        "values", TensorShape({size, embedding_dim_}), &values));
+    ExportEntries(keys, values, nullptr, nullptr);
+    return Status::OK();
+  }
+
+  Status ApplyGradients(const Tensor& keys, const Tensor& gradients,
+                        const Tensor& learning_rate) override {
+    const auto key_values = keys.flat<K>();
+    const auto gradient_values = gradients.flat_inner_dims<V, 2>();
+    const V lr = learning_rate.scalar<V>()();
+
+    mutex_lock l(mu_);
+    for (int64 i = 0; i < key_values.size(); ++i) {
+      auto it = entries_.find(SubtleMustCopyUnlessStringOrFloat(key_values(i)));
+      if (it == entries_.end()) continue;
+      V* embedding = it->second.values.data();
+      if (adagrad_) {
+        V* accumulators = embedding + embedding_dim_;
+        for (int64 j = 0; j < embedding_dim_; ++j) {
+          const V g = gradient_values(i, j);
+          accumulators[j] += g * g;
+          embedding[j] -= lr * g / std::sqrt(accumulators[j]);
+        }
+      } else {
+        for (int64 j = 0; j < embedding_dim_; ++j) {
+          embedding[j] -= lr * gradient_values(i, j);
+        }
+      }
+    }
+    return Status::OK();
+  }
+
+  Status ExportState(OpKernelContext* ctx) override {
+    mutex_lock l(mu_);
+    const int64 size = entries_.size();
+    Tensor* keys;
+    Tensor* values;
+    Tensor* frequencies;
+    Tensor* accumulators;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_output("keys", TensorShape({size}), &keys));
+    TF_RETURN_IF_ERROR(ctx->allocate_output(
+        "values", TensorShape({size, embedding_dim_}), &values));
+    TF_RETURN_IF_ERROR(ctx->allocate_output(
+        "frequencies", TensorShape({size}), &frequencies));
+    TF_RETURN_IF_ERROR(ctx->allocate_output(
+        "accumulators", TensorShape({size, adagrad_ ? embedding_dim_ : 0}),
+        &accumulators));
+    ExportEntries(keys, values, frequencies, accumulators);
+    return Status::OK();
+  }
+
+  Status ImportState(const Tensor& keys, const Tensor& values,
+                     const Tensor& frequencies,
+                     const Tensor& accumulators) override {
+    const int64 size = keys.NumElements();
+    if (keys.dims() != 1 ||
+        values.shape() != TensorShape({size, embedding_dim_}) ||
+        frequencies.shape() != TensorShape({size}) ||
+        accumulators.dims() != 2 || accumulators.dim_size(0) != size) {
+      return errors::InvalidArgument(
+          "Expected keys of shape [n], values of shape [n, ", embedding_dim_,
+          "], frequencies of shape [n] and accumulators of shape [n, k], got ",
+          keys.shape().DebugString(), ", ", values.shape().DebugString(), ", ",
+          frequencies.shape().DebugString(), " and ",
+          accumulators.shape().DebugString());
+    }
+    // Accumulators are only restored into Adagrad tables, from Adagrad tables.
+    const bool restore_accumulators =
+        adagrad_ && accumulators.dim_size(1) == embedding_dim_;
+    const auto key_values = keys.flat<K>();
+    const auto value_values = values.matrix<V>();
+    const auto frequency_values = frequencies.flat<int64>();
+    const auto accumulator_values = accumulators.matrix<V>();
+
+    mutex_lock l(mu_);
+    Clear();
+    for (int64 i = 0; i < size; ++i) {
+      Entry* entry = Admit(SubtleMustCopyUnlessStringOrFloat(key_values(i)),
+                           std::max(frequency_values(i), min_frequency_));
+      for (int64 j = 0; j < embedding_dim_; ++j) {
+        entry->values[j] = value_values(i, j);
+      }
+      if (restore_accumulators) {
+        for (int64 j = 0; j < embedding_dim_; ++j) {
+          entry->values[embedding_dim_ + j] = accumulator_values(i, j);
+        }
+      }
+    }
+    return Status::OK();
+  }
+
+  DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  TensorShape key_shape() const final { return TensorShape(); }
+
+  TensorShape value_shape() const override { return value_shape_; }
+
+  int64 MemoryUsed() const override {
+    mutex_lock l(mu_);
+    const int64 entry_bytes = sizeof(K) + sizeof(Entry) +
+                              EntryWidth() * sizeof(V) +
+                              (bounded() ? sizeof(Rank) : 0);
+    return sizeof(*this) + entries_.size() * entry_bytes +
+           candidates_.size() * (sizeof(K) + sizeof(int64));
+  }
+
+ private:
+  struct Entry {
+    // The embedding, followed by its Adagrad accumulators if any.
+    std::vector<V> values;
+    int64 frequency;
+    int64 last_access;
+  };
+
+  // Entries are evicted in increasing order of rank.
+  typedef std::tuple<int64, int64, K> Rank;
+
+  bool bounded() const { return max_num_entries_ > 0; }
+
+  int64 EntryWidth() const {
+    return adagrad_ ? 2 * embedding_dim_ : embedding_dim_;
+  }
+
+  Rank RankOf(const K& key, const Entry& entry) const {
+    if (evict_least_frequent_) {
+      return Rank(entry.frequency, entry.last_access, key);
+    }
+    return Rank(entry.last_access, 0, key);
+  }
+
+  void Clear() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    entries_.clear();
+    candidates_.clear();
+    ranks_.clear();
+  }
+
+  // Records a lookup of "key", and returns its entry if it is in the table or
+  // is admitted by this lookup, or nullptr otherwise.
+  Entry* FindOrAdmit(const K& key, typename TTypes<V>::ConstFlat default_flat)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      Entry* entry = &it->second;
+      if (bounded()) ranks_.erase(RankOf(key, *entry));
+      ++entry->frequency;
+      entry->last_access = ++clock_;
+      if (bounded()) ranks_.insert(RankOf(key, *entry));
+      return entry;
+    }
+    const int64 frequency = ++candidates_[key];
+    if (frequency < min_frequency_) {
+      if (bounded() &&
+          static_cast<int64>(candidates_.size()) > max_num_entries_) {
+        DecayCandidates();
+      }
+      return nullptr;
+    }
+    candidates_.erase(key);
+    Entry* entry = Admit(key, frequency);
+    InitializeEmbedding(key, default_flat, entry);
+    return entry;
+  }
+
+  // Adds an entry for "key", which must not be in the table, evicting another
+  // entry if the table is full. Its embedding is left zero, and its
+  // accumulators are initialized.
+  Entry* Admit(const K& key, int64 frequency) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    if (bounded() && static_cast<int64>(entries_.size()) >= max_num_entries_) {
+      auto victim = ranks_.begin();
+      entries_.erase(std::get<2>(*victim));
+      ranks_.erase(victim);
+    }
+    Entry* entry = &entries_[key];
+    entry->values.assign(embedding_dim_, V());
+    if (adagrad_) {
+      entry->values.resize(2 * embedding_dim_,
+                           static_cast<V>(initial_accumulator_value_));
+    }
+    entry->frequency = frequency;
+    entry->last_access = ++clock_;
+    if (bounded()) ranks_.insert(RankOf(key, *entry));
+    return entry;
+  }
+
+  // Sets the embedding of a newly admitted "key" randomly if the table has an
+  // "initial_stddev", otherwise to "default_flat". The random embedding only
+  // depends on the seed and the key, so it is the same wherever and whenever
+  // the key is admitted.
+  void InitializeEmbedding(const K& key,
+                           typename TTypes<V>::ConstFlat default_flat,
+                           Entry* entry) const {
+    if (initial_stddev_ <= 0) {
+      for (int64 j = 0; j < embedding_dim_; ++j) {
+        entry->values[j] = default_flat(j);
+      }
+      return;
+    }
+    typedef random::NormalDistribution<random::PhiloxRandom, V> Distribution;
+    random::PhiloxRandom generator(static_cast<uint64>(seed_), KeySeed(key));
+    Distribution normal;
+    typename Distribution::ResultType samples;
+    for (int64 j = 0; j < embedding_dim_; ++j) {
+      const int k = j % Distribution::kResultElementCount;
+      if (k == 0) samples = normal(&generator);
+      entry->values[j] = samples[k] * static_cast<V>(initial_stddev_);
+    }
+  }
+
+  void DecayCandidates() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    for (auto it = candidates_.begin(); it != candidates_.end();) {
+      it->second /= 2;
+      if (it->second == 0) {
+        it = candidates_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  // Inserts or overwrites the embeddings of "keys", which are admitted
+  // regardless of their frequency.
+  void DoInsert(typename TTypes<K>::ConstFlat keys,
+                typename TTypes<V, 2>::ConstTensor values)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    for (int64 i = 0; i < keys.size(); ++i) {
+      const K key = SubtleMustCopyUnlessStringOrFloat(keys(i));
+      Entry* entry;
+      auto it = entries_.find(key);
+      if (it != entries_.end()) {
+        entry = &it->second;
+      } else {
+        candidates_.erase(key);
+        entry = Admit(key, min_frequency_);
+      }
+      for (int64 j = 0; j < embedding_dim_; ++j) {
+        entry->values[j] = values(i, j);
+      }
+    }
+  }
+
+  // Writes the entries to the given outputs, each of which may be nullptr.
+  void ExportEntries(Tensor* keys, Tensor* values, Tensor* frequencies,
+                     Tensor* accumulators) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    int64 i = 0;
+    for (auto it = entries_.begin(); it != entries_.end(); ++it, ++i) {
+      const Entry& entry = it->second;
+      keys->flat<K>()(i) = it->first;
+      auto values_matrix = values->matrix<V>();
+      for (int64 j = 0; j < embedding_dim_; ++j) {
+        values_matrix(i, j) = entry.values[j];
+      }
+      if (frequencies != nullptr) {
+        frequencies->flat<int64>()(i) = entry.frequency;
+      }
+      if (accumulators != nullptr && adagrad_) {
+        auto accumulators_matrix = accumulators->matrix<V>();
+        for (int64 j = 0; j < embedding_dim_; ++j) {
+          accumulators_matrix(i, j) = entry.values[embedding_dim_ + j];
+        }
+      }
+    }
+  }
+
+  TensorShape value_shape_;
+  int64 embedding_dim_;
+  int64 min_frequency_;
+  int64 max_num_entries_;
+  bool evict_least_frequent_;
+  float initial_stddev_;
+  int64 seed_;
+  bool adagrad_;
+  float initial_accumulator_value_;
+
+  mutable mutex mu_;
+  std::unordered_map<K, Entry> entries_ GUARDED_BY(mu_);
+  // The number of lookups of the keys that haven't been admitted yet.
+  std::unordered_map<K, int64> candidates_ GUARDED_BY(mu_);
+  // The ranks of the entries, if the table is bounded.
+  std::set<Rank> ranks_ GUARDED_BY(mu_);
+  // Incremented by each access to an entry, for its last_access.
+  int64 clock_ GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace lookup
+
+namespace {
+
+// Gets the DynamicEmbeddingTableBase passed as "table_handle".
+Status GetDynamicEmbeddingTable(OpKernelContext* ctx,
+                                lookup::DynamicEmbeddingTableBase** table) {
+  lookup::LookupInterface* lookup_table;
+  TF_RETURN_IF_ERROR(
+      lookup::GetLookupTable("table_handle", ctx, &lookup_table));
+  *table = lookup_table->GetDynamicEmbeddingTable();
+  if (*table == nullptr) {
+    lookup_table->Unref();
+    return errors::InvalidArgument("Table is not a dynamic embedding table");
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+// Register the DynamicEmbeddingTableV2 op.
+#define REGISTER_KERNEL(key_dtype, value_dtype)                              \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("DynamicEmbeddingTableV2")                                        \
+          .Device(DEVICE_CPU)                                                \
+          .TypeConstraint<key_dtype>("key_dtype")                            \
+          .TypeConstraint<value_dtype>("value_dtype"),                       \
+      LookupTableOp<lookup::DynamicEmbeddingTable<key_dtype, value_dtype>,   \
+                    key_dtype, value_dtype>)
+
+REGISTER_KERNEL(int64, double);
+REGISTER_KERNEL(int64, float);
+REGISTER_KERNEL(string, double);
+REGISTER_KERNEL(string, float);
+
+#undef REGISTER_KERNEL
+
+class DynamicEmbeddingTableApplyGradientsOp : public OpKernel {
+ public:
+  explicit DynamicEmbeddingTableApplyGradientsOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    lookup::DynamicEmbeddingTableBase* table;
+    OP_REQUIRES_OK(ctx, GetDynamicEmbeddingTable(ctx, &table));
+    core::ScopedUnref unref_me(table);
+
+    DataTypeVector expected_inputs = {DT_RESOURCE, table->key_dtype(),
+                                      table->value_dtype(),
+                                      table->value_dtype()};
+    OP_REQUIRES_OK(ctx, ctx->MatchSignature(expected_inputs, {}));
+
+    const Tensor& keys = ctx->input(1);
+    const Tensor& gradients = ctx->input(2);
+    const Tensor& learning_rate = ctx->input(3);
+    OP_REQUIRES_OK(ctx,
+                   table->CheckKeyAndValueTensorsForInsert(keys, gradients));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(learning_rate.shape()),
+                errors::InvalidArgument("learning_rate must be a scalar, got ",
+                                        learning_rate.shape().DebugString()));
+    OP_REQUIRES_OK(ctx, table->ApplyGradients(keys, gradients, learning_rate));
+  }
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("DynamicEmbeddingTableApplyGradientsV2").Device(DEVICE_CPU),
+    DynamicEmbeddingTableApplyGradientsOp);
+
+class DynamicEmbeddingTableExportOp : public OpKernel {
+ public:
+  explicit DynamicEmbeddingTableExportOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    lookup::DynamicEmbeddingTableBase* table;
+    OP_REQUIRES_OK(ctx, GetDynamicEmbeddingTable(ctx, &table));
+    core::ScopedUnref unref_me(table);
+
+    OP_REQUIRES_OK(ctx, table->ExportState(ctx));
+  }
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("DynamicEmbeddingTableExportV2").Device(DEVICE_CPU),
+    DynamicEmbeddingTableExportOp);
+
+class DynamicEmbeddingTableImportOp : public OpKernel {
+ public:
+  explicit DynamicEmbeddingTableImportOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    lookup::DynamicEmbeddingTableBase* table;
+    OP_REQUIRES_OK(ctx, GetDynamicEmbeddingTable(ctx, &table));
+    core::ScopedUnref unref_me(table);
+
+    DataTypeVector expected_inputs = {DT_RESOURCE, table->key_dtype(),
+                                      table->value_dtype(), DT_INT64,
+                                      table->value_dtype()};
+    OP_REQUIRES_OK(ctx, ctx->MatchSignature(expected_inputs, {}));
+
+    int64 memory_used_before = 0;
+    if (ctx->track_allocations()) {
+      memory_used_before = table->MemoryUsed();
+    }
+    OP_REQUIRES_OK(ctx, table->ImportState(ctx->input(1), ctx->input(2),
+                                           ctx->input(3), ctx->input(4)));
+    if (ctx->track_allocations()) {
+      ctx->record_host_persistent_memory_allocation(table->MemoryUsed() -
+                                                    memory_used_before);
+    }
+  }
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("DynamicEmbeddingTableImportV2").Device(DEVICE_CPU),
+    DynamicEmbeddingTableImportOp);
+
+}  // namespace tensorflow
@@ -0,0 +1,61 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_DYNAMIC_EMBEDDING_TABLE_OP_H_
+#define TENSORFLOW_KERNELS_DYNAMIC_EMBEDDING_TABLE_OP_H_
+
+#include "tensorflow/core/framework/lookup_interface.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+
+namespace tensorflow {
+namespace lookup {
+
+// Base class of the tables of DynamicEmbeddingTableV2 ops, with the operations
+// they support beyond LookupInterface.
+//
+// The table maps IDs to embeddings, which are vectors of a fixed size. Find()
+// looks up the embeddings of IDs, and admits the IDs that aren't in the table
+// yet once they have been looked up often enough. Newly admitted embeddings are
+// initialized randomly, or to the default value given to Find(). When the
+// table is full, admitting an ID evicts the least recently or the least
+// frequently used one.
+class DynamicEmbeddingTableBase : public LookupInterface {
+ public:
+  DynamicEmbeddingTableBase* GetDynamicEmbeddingTable() final { return this; }
+
+  // Updates the embeddings of "keys" with "gradients" of the loss with respect
+  // to them, by the optimizer the table was created with. "gradients" has the
+  // shape of "keys" followed by value_shape(). Keys that aren't in the table
+  // are ignored.
+  virtual Status ApplyGradients(const Tensor& keys, const Tensor& gradients,
+                                const Tensor& learning_rate) = 0;
+
+  // Outputs all the entries of the table to the "keys", "values",
+  // "frequencies" and "accumulators" outputs of "ctx", for checkpoints.
+  virtual Status ExportState(OpKernelContext* ctx) = 0;
+
+  // Replaces the entries of the table with those of tensors exported by
+  // ExportState().
+  virtual Status ImportState(const Tensor& keys, const Tensor& values,
+                             const Tensor& frequencies,
+                             const Tensor& accumulators) = 0;
+};
+
+}  // namespace lookup
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_DYNAMIC_EMBEDDING_TABLE_OP_H_
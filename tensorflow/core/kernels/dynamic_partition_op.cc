@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -39,9 +40,14 @@ class DynamicPartitionOp_Shared : public OpKernel {
     //   in the graph?
   }
 
+  // Also stores the partition of each element of partitions in
+  // (*partition_ids)[i], and its position in that partition in
+  // (*output_index)[i].
   void ValidateAndAllocateOutputs(OpKernelContext* c, const Tensor** data,
                                   const Tensor** partitions,
-                                  OpOutputList* Tout) {
+                                  OpOutputList* Tout,
+                                  std::vector<int32>* partition_ids,
+                                  std::vector<int64>* output_index) {
     OP_REQUIRES_OK(c, c->input("data", data));
     OP_REQUIRES_OK(c, c->input("partitions", partitions));
     OP_REQUIRES(
@@ -52,17 +58,22 @@ class DynamicPartitionOp_Shared : public OpKernel {
             "got data.shape = ", (*data)->shape().DebugString(),
             ", partitions.shape = ", (*partitions)->shape().DebugString()));
 
-    // Count how many occurrences of each partition id we have in partitions
-    gtl::InlinedVector<int, 32> partition_count(num_partitions_);
+    // Count how many occurrences of each partition id we have in partitions.
+    // The ids are copied once, so that the copies below don't depend on
+    // partitions staying unchanged.
+    gtl::InlinedVector<int64, 32> partition_count(num_partitions_);
     auto e_partitions = (*partitions)->flat<int32>();
     const int64 N = e_partitions.dimension(0);
+    partition_ids->resize(N);
+    output_index->resize(N);
     for (int64 i = 0; i < N; i++) {
       const int32 p = internal::SubtleMustCopy(e_partitions(i));
       OP_REQUIRES(c, FastBoundsCheck(p, num_partitions_),
                   errors::InvalidArgument(
                       "partitions", SliceDebugString((*partitions)->shape(), i),
                       " = ", p, " is not in [0, ", num_partitions_, ")"));
-      partition_count[p]++;
+      (*partition_ids)[i] = p;
+      (*output_index)[i] = partition_count[p]++;
     }
 
     // Allocate output tensors of the right size
@@ -91,14 +102,19 @@ class DynamicPartitionOp : public DynamicPartitionOp_Shared {
     const Tensor* data;
     const Tensor* partitions;
     OpOutputList outputs;
-    ValidateAndAllocateOutputs(c, &data, &partitions, &outputs);
+    std::vector<int32> partition_ids;
+    std::vector<int64> output_index;
+    ValidateAndAllocateOutputs(c, &data, &partitions, &outputs, &partition_ids,
+                               &output_index);
     if (!c->status().ok()) return;
     if (num_partitions_ == 0 || data->NumElements() == 0) return;
 
-    auto e_partitions = partitions->flat<int32>();
-    const int64 N = e_partitions.dimension(0);
-    gtl::InlinedVector<int, 32> output_index(num_partitions_);
+    const int64 N = partition_ids.size();
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *c->device()->tensorflow_cpu_worker_threads();
 
+    // The destination of every element is known, so the elements are copied
+    // in parallel.
     if (partitions->dims() == data->dims()) {
       // Walk through data and copy the data to the appropriate output tensor
       const auto data_flat = data->flat<T>();
@@ -108,19 +124,14 @@ class DynamicPartitionOp : public DynamicPartitionOp_Shared {
       for (int p = 0; p < num_partitions_; p++) {
         out_vec.push_back(outputs[p]->vec<T>());
       }
-      for (int64 i = 0; i < N; i++) {
-        const int32 p = internal::SubtleMustCopy(e_partitions(i));
-        OP_REQUIRES(
-            c, FastBoundsCheck(p, num_partitions_),
-            errors::InvalidArgument("indices[", i, "] is out of range"));
-        auto oi = output_index[p];
-        OP_REQUIRES(c, FastBoundsCheck(oi, out_vec[p].size()),
-                    errors::InvalidArgument(
-                        "out_vec[", p, "] size: ", out_vec[p].size(),
-                        " is not LTE output_index[", p, "] : ", oi));
-        out_vec[p](oi) = data_flat(i);
-        output_index[p]++;
-      }
+      auto work = [&data_flat, &out_vec, &partition_ids, &output_index](
+                      int64 start, int64 limit) {
+        for (int64 i = start; i < limit; i++) {
+          out_vec[partition_ids[i]](output_index[i]) = data_flat(i);
+        }
+      };
+      Shard(worker_threads.num_threads, worker_threads.workers, N, sizeof(T),
+            work);
     } else {
       // If data has extra dimensions, use Eigen slices
       std::vector<Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>,
@@ -133,25 +144,19 @@ class DynamicPartitionOp : public DynamicPartitionOp_Shared {
       // Walk through data and copy the data to the appropriate output tensor
       const int64 slice_size = data->NumElements() / N;
       const auto data_flat = data->shaped<T, 2>({N, slice_size});
-      Eigen::DSizes<Eigen::DenseIndex, 2> sizes(1, slice_size);
-      for (int64 i = 0; i < N; i++) {
-        // outputs[p][output_index[p]++] = data[i]
-        const int32 p = internal::SubtleMustCopy(e_partitions(i));
-        OP_REQUIRES(
-            c, FastBoundsCheck(p, num_partitions_),
-            errors::InvalidArgument("indices[", i,
-                                    "] has been asynchronously overwitten and "
-                                    "is no longer in range!"));
-        auto oi = output_index[p];
-        OP_REQUIRES(c, FastBoundsCheck(oi, out_flat[p].dimension(0)),
-                    errors::InvalidArgument("Size of output_index: ", oi,
-                                            " is no longer in range."));
-        Eigen::DSizes<Eigen::DenseIndex, 2> out_indices(oi, 0);
-        Eigen::DSizes<Eigen::DenseIndex, 2> data_indices(i, 0);
-        out_flat[p].slice(out_indices, sizes) =
-            data_flat.slice(data_indices, sizes);
-        output_index[p]++;
-      }
+      auto work = [&data_flat, &out_flat, &partition_ids, &output_index,
+                   slice_size](int64 start, int64 limit) {
+        Eigen::DSizes<Eigen::DenseIndex, 2> sizes(1, slice_size);
+        for (int64 i = start; i < limit; i++) {
+          // outputs[p][output_index[p]++] = data[i]
+          Eigen::DSizes<Eigen::DenseIndex, 2> out_indices(output_index[i], 0);
+          Eigen::DSizes<Eigen::DenseIndex, 2> data_indices(i, 0);
+          out_flat[partition_ids[i]].slice(out_indices, sizes) =
+              data_flat.slice(data_indices, sizes);
+        }
+      };
+      Shard(worker_threads.num_threads, worker_threads.workers, N,
+            slice_size * sizeof(T), work);
     }
   }
 };
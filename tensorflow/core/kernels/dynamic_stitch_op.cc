@@ -15,10 +15,14 @@ limitations under the License.
 
 // See docs in ../ops/data_flow_ops.cc.
 
+#include <algorithm>
+#include <vector>
+
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/bounds_check.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -101,40 +105,45 @@ class DynamicStitchOp : public OpKernel {
     if (first_dim_size > 0) {
       auto merged_flat = merged->flat_outer_dims<T>();
       const int slice_size = merged_flat.dimension(1);
+
+      // First pass: find the slice of data that ends up in each row of
+      // merged, which is the last one with its index.
+      std::vector<const T*> sources(first_dim_size, nullptr);
       for (int input_num = 0; input_num < indices_inputs.size(); input_num++) {
         const Tensor& indices = indices_inputs[input_num];
         auto indices_vec = indices.flat<int32>();
         const Tensor& data = data_inputs[input_num];
         auto data_flat =
             data.shaped<T, 2>({indices_vec.dimension(0), slice_size});
+        const T* data_base = data_flat.data();
+        for (int i = 0; i < indices_vec.size(); i++) {
+          int32 index = internal::SubtleMustCopy(indices_vec(i));
+          OP_REQUIRES(
+              c, FastBoundsCheck(index, first_dim_size),
+              errors::InvalidArgument("indices[", i, "] is out of range"));
+          sources[index] = data_base + i * slice_size;
+        }
+      }
 
-        if (DataTypeCanUseMemcpy(DataTypeToEnum<T>::v())) {
-          T* merged_base = &merged_flat(0, 0);
-          const T* data_base = &data_flat(0, 0);
-          const size_t slice_bytes = slice_size * sizeof(T);
-          for (int i = 0; i < indices_vec.size(); i++) {
-            int32 index = internal::SubtleMustCopy(indices_vec(i));
-            OP_REQUIRES(
-                c, FastBoundsCheck(index, first_dim_size),
-                errors::InvalidArgument("indices[", i, "] is out of range"));
-            memcpy(merged_base + index * slice_size, data_base + i * slice_size,
-                   slice_bytes);
-          }
-        } else {
-          Eigen::DSizes<Eigen::DenseIndex, 2> sizes(1, slice_size);
-          for (int i = 0; i < indices_vec.size(); i++) {
-            // Copy slice data[i] to merged[indices[i]]
-            Eigen::DSizes<Eigen::DenseIndex, 2> data_indices(i, 0);
-            int32 index = internal::SubtleMustCopy(indices_vec(i));
-            OP_REQUIRES(
-                c, FastBoundsCheck(index, first_dim_size),
-                errors::InvalidArgument("indices[", i, "] is out of range"));
-            Eigen::DSizes<Eigen::DenseIndex, 2> merged_indices(index, 0);
-            merged_flat.slice(merged_indices, sizes) =
-                data_flat.slice(data_indices, sizes);
+      // Second pass: copy the rows of merged in parallel.
+      T* merged_base = merged_flat.data();
+      auto work = [&sources, merged_base, slice_size](int64 start,
+                                                      int64 limit) {
+        for (int64 row = start; row < limit; row++) {
+          if (sources[row] == nullptr) continue;
+          if (DataTypeCanUseMemcpy(DataTypeToEnum<T>::v())) {
+            memcpy(merged_base + row * slice_size, sources[row],
+                   slice_size * sizeof(T));
+          } else {
+            std::copy_n(sources[row], slice_size,
+                        merged_base + row * slice_size);
           }
         }
-      }
+      };
+      const DeviceBase::CpuWorkerThreads& worker_threads =
+          *c->device()->tensorflow_cpu_worker_threads();
+      Shard(worker_threads.num_threads, worker_threads.workers, first_dim_size,
+            slice_size * sizeof(T), work);
     }
   }
 
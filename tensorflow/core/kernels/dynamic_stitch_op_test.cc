@@ -60,6 +60,22 @@ TEST_F(DynamicStitchOpTest, Simple_OneD) {
   test::ExpectTensorEqual<float>(expected, *GetOutput(0));
 }
 
+TEST_F(DynamicStitchOpTest, DuplicateIndices) {
+  MakeOp(2, DT_STRING);
+
+  // Feed and run. The last slice with an index wins.
+  AddInputFromArray<int32>(TensorShape({3}), {0, 2, 0});
+  AddInputFromArray<int32>(TensorShape({2}), {1, 2});
+  AddInputFromArray<string>(TensorShape({3, 2}), {"a", "b", "c", "d", "e", "f"});
+  AddInputFromArray<string>(TensorShape({2, 2}), {"g", "h", "i", "j"});
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Check the output.
+  Tensor expected(allocator(), DT_STRING, TensorShape({3, 2}));
+  test::FillValues<string>(&expected, {"e", "f", "g", "h", "i", "j"});
+  test::ExpectTensorEqual<string>(expected, *GetOutput(0));
+}
+
 TEST_F(DynamicStitchOpTest, Simple_TwoD) {
   MakeOp(3, DT_FLOAT);
 
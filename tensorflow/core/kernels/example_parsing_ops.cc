@@ -284,11 +284,8 @@ class SingleSequenceExampleParserOp : public OpKernel {
                                         context_dense_defaults.size(), " vs. ",
                                         attrs_.num_context_dense));
 
-    std::vector<bool> required(attrs_.num_context_dense);
     for (int d = 0; d < attrs_.num_context_dense; ++d) {
       const Tensor& def_value = context_dense_defaults[d];
-      required[d] = (def_value.NumElements() == 0);  // No default provided.
-
       if (def_value.NumElements() > 0) {
         OP_REQUIRES(
             ctx, def_value.shape() == attrs_.context_dense_shapes[d],
@@ -335,223 +332,104 @@ class SingleSequenceExampleParserOp : public OpKernel {
     OP_REQUIRES_OK(ctx, ctx->output_list("feature_list_dense_values",
                                          &feature_list_dense_values));
 
-    SequenceExample ex;
-    OP_REQUIRES(
-        ctx, ParseProtoUnlimited(&ex, serialized_t()),
-        errors::InvalidArgument("Could not parse example input, value: '",
-                                serialized_t(), "'"));
-
-    const string& name = (has_debug_name) ? debug_name_t() : "<unknown>";
-    const Features& context = ex.context();
-    const auto& context_dict = context.feature();
-
-    // Context Dense -----------------------------------------------------------
-
-    // Preallocate context_dense_values, since we know their sizes
+    example::FastParseExampleConfig context_config;
     for (int d = 0; d < attrs_.num_context_dense; ++d) {
-      TensorShape out_shape;
-      for (const int dim : attrs_.context_dense_shapes[d].dim_sizes())
-        out_shape.AddDim(dim);
-      Tensor* out = nullptr;
-      OP_REQUIRES_OK(ctx, context_dense_values.allocate(d, out_shape, &out));
+      context_config.dense.push_back(
+          {context_dense_keys_t[d], attrs_.context_dense_types[d],
+           PartialTensorShape(attrs_.context_dense_shapes[d].dim_sizes()),
+           context_dense_defaults[d], false /* variable_length */,
+           static_cast<std::size_t>(
+               attrs_.context_dense_shapes[d].num_elements())});
+    }
+    for (int d = 0; d < attrs_.num_context_sparse; ++d) {
+      context_config.sparse.push_back(
+          {context_sparse_keys_t[d], attrs_.context_sparse_types[d]});
+    }
+    example::FastParseFeatureListConfig feature_list_config;
+    for (int d = 0; d < attrs_.num_feature_list_dense; ++d) {
+      const string& key = feature_list_dense_keys_t[d];
+      feature_list_config.dense.push_back(
+          {key, attrs_.feature_list_dense_types[d],
+           attrs_.feature_list_dense_shapes[d],
+           feature_list_dense_missing_assumed_empty_set.count(key) > 0,
+           static_cast<std::size_t>(
+               attrs_.feature_list_dense_shapes[d].num_elements())});
+    }
+    for (int d = 0; d < attrs_.num_feature_list_sparse; ++d) {
+      feature_list_config.sparse.push_back(
+          {feature_list_sparse_keys_t[d], attrs_.feature_list_sparse_types[d]});
     }
 
-    for (int d = 0; d < attrs_.num_context_dense; ++d) {
-      const string& key = context_dense_keys_t[d];
-      const DataType& dtype = attrs_.context_dense_types[d];
-      const TensorShape& shape = attrs_.context_dense_shapes[d];
+    // Parse the example as a batch of one, and drop the batch dimension from
+    // the results.
+    gtl::ArraySlice<string> slice(&serialized_t(), 1);
+    gtl::ArraySlice<string> names_slice;
+    if (has_debug_name) {
+      names_slice = gtl::ArraySlice<string>(&debug_name_t(), 1);
+    }
+    example::Result context_result;
+    example::FeatureListResult feature_list_result;
+    OP_REQUIRES_OK(
+        ctx, FastParseSequenceExample(
+                 context_config, feature_list_config, slice, names_slice,
+                 ctx->device()->tensorflow_cpu_worker_threads()->workers,
+                 &context_result, &feature_list_result));
 
-      const auto& feature_found = context_dict.find(key);
-      OP_REQUIRES(
-          ctx, (feature_found != context_dict.end()) || !required[d],
-          errors::InvalidArgument("Name: ", name, ", Context feature '", key,
-                                  "' is required but could not be found."));
-      if (feature_found != context_dict.end()) {
-        const Feature& f = feature_found->second;
-        bool types_match;
-        OP_REQUIRES_OK(ctx, CheckTypesMatch(f, dtype, &types_match));
-        OP_REQUIRES(
-            ctx, types_match,
-            errors::InvalidArgument("Name: ", name, ", Context feature: ", key,
-                                    ".  Data types don't match. ",
-                                    "Expected type: ", DataTypeString(dtype),
-                                    "  Feature is: ", ProtoDebugString(f)));
-
-        OP_REQUIRES_OK(ctx, FeatureDenseCopy(0, name, key, dtype, shape, f,
-                                             context_dense_values[d]));
-      } else {
-        RowDenseCopy(0, dtype, context_dense_defaults[d],
-                     context_dense_values[d]);
-      }
+    for (int d = 0; d < attrs_.num_context_dense; ++d) {
+      Tensor values;
+      CHECK(values.CopyFrom(context_result.dense_values[d],
+                            attrs_.context_dense_shapes[d]));
+      context_dense_values.set(d, values);
     }
 
-    // Context Sparse ----------------------------------------------------------
     for (int d = 0; d < attrs_.num_context_sparse; ++d) {
-      const string& key = context_sparse_keys_t[d];
-      const DataType& dtype = attrs_.context_sparse_types[d];
-
-      const auto& feature_found = context_dict.find(key);
-      bool feature_has_data =  // Found key & data type is set
-          (feature_found != context_dict.end() &&
-           (feature_found->second.kind_case() != Feature::KIND_NOT_SET));
-
-      if (feature_has_data) {
-        const Feature& f = feature_found->second;
-        bool types_match;
-        OP_REQUIRES_OK(ctx, CheckTypesMatch(f, dtype, &types_match));
-        OP_REQUIRES(
-            ctx, types_match,
-            errors::InvalidArgument("Name: ", name, ", Context feature: ", key,
-                                    ".  Data types don't match. ",
-                                    "Expected type: ", DataTypeString(dtype),
-                                    "  Feature is: ", ProtoDebugString(f)));
-
-        Tensor feature_values = FeatureSparseCopy(0, key, dtype, f);
-        const int64 num_elements = feature_values.NumElements();
-        TensorShape indices_shape({num_elements, 1});
-        Tensor* sp_indices_d = nullptr;
-        Tensor* sp_shape_d = nullptr;
-        OP_REQUIRES_OK(ctx, context_sparse_indices.allocate(d, indices_shape,
-                                                            &sp_indices_d));
-        context_sparse_values.set(d, feature_values);
-        OP_REQUIRES_OK(ctx, context_sparse_shapes.allocate(d, TensorShape({1}),
-                                                           &sp_shape_d));
-        auto shape_t = sp_shape_d->vec<int64>();
-        shape_t(0) = num_elements;
-        auto indices_t = sp_indices_d->matrix<int64>();
-        std::iota(indices_t.data(), indices_t.data() + num_elements, 0);
-      } else {
-        TensorShape indices_shape({0, 1});
-        TensorShape values_shape({0});
-        Tensor* sp_indices_d = nullptr;
-        Tensor* sp_values_d = nullptr;
-        Tensor* sp_shape_d = nullptr;
-        OP_REQUIRES_OK(ctx, context_sparse_indices.allocate(d, indices_shape,
-                                                            &sp_indices_d));
-        OP_REQUIRES_OK(
-            ctx, context_sparse_values.allocate(d, values_shape, &sp_values_d));
-        OP_REQUIRES_OK(ctx, context_sparse_shapes.allocate(d, TensorShape({1}),
-                                                           &sp_shape_d));
-        auto shape_t = sp_shape_d->vec<int64>();
-        shape_t(0) = 0;
-      }
+      const Tensor& values = context_result.sparse_values[d];
+      const int64 num_elements = values.NumElements();
+      Tensor* sp_indices_d = nullptr;
+      Tensor* sp_shape_d = nullptr;
+      OP_REQUIRES_OK(ctx, context_sparse_indices.allocate(
+                              d, TensorShape({num_elements, 1}),
+                              &sp_indices_d));
+      context_sparse_values.set(d, values);
+      OP_REQUIRES_OK(ctx, context_sparse_shapes.allocate(d, TensorShape({1}),
+                                                         &sp_shape_d));
+      auto shape_t = sp_shape_d->vec<int64>();
+      shape_t(0) = num_elements;
+      auto indices_t = sp_indices_d->matrix<int64>();
+      std::iota(indices_t.data(), indices_t.data() + num_elements, 0);
     }
 
-    // Feature List Dense ------------------------------------------------------
-
-    // Preallocate context_dense_values, since we can infer their
-    // sizes
-    const FeatureLists& feature_lists = ex.feature_lists();
-    const auto& feature_list_dict = feature_lists.feature_list();
-    FeatureList empty_feature_list;  // Placeholder for missing FLs
-
     for (int d = 0; d < attrs_.num_feature_list_dense; ++d) {
-      const string& key = feature_list_dense_keys_t[d];
-      const DataType& dtype = attrs_.feature_list_dense_types[d];
-      const TensorShape& shape = attrs_.feature_list_dense_shapes[d];
-
-      const auto& feature_list_found = feature_list_dict.find(key);
-      bool feature_list_missing =
-          (feature_list_found == feature_list_dict.end());
-      bool feature_list_allowed_missing =
-          (feature_list_dense_missing_assumed_empty_set.count(key) > 0);
-
-      OP_REQUIRES(
-          ctx, !feature_list_missing || feature_list_allowed_missing,
-          errors::InvalidArgument("Name: ", name, ", Feature list '", key,
-                                  "' is required but could not be found.  "
-                                  "Did you mean to include it in "
-                                  "feature_list_dense_missing_assumed_empty or "
-                                  "feature_list_dense_defaults?"));
-
+      const Tensor& batched_values = feature_list_result.dense_values[d];
       TensorShape out_shape;
-      const FeatureList& fl = (feature_list_missing)
-                                  ? empty_feature_list
-                                  : feature_list_found->second;
-      out_shape.AddDim(fl.feature_size());
-      for (const int dim : attrs_.feature_list_dense_shapes[d].dim_sizes()) {
-        out_shape.AddDim(dim);
-      }
-      Tensor* out = nullptr;
-      OP_REQUIRES_OK(ctx,
-                     feature_list_dense_values.allocate(d, out_shape, &out));
-
-      for (int64 t = 0; t < fl.feature_size(); ++t) {
-        const Feature& f = fl.feature(t);
-        bool types_match;
-        OP_REQUIRES_OK(ctx, CheckTypesMatch(f, dtype, &types_match));
-        OP_REQUIRES(
-            ctx, types_match,
-            errors::InvalidArgument(
-                "Name: ", name, ", Feature list: ", key, ", Index: ", t,
-                ".  Data types don't match. ", "Expected type: ",
-                DataTypeString(dtype), "  Feature is: ", ProtoDebugString(f)));
-        OP_REQUIRES_OK(ctx, FeatureDenseCopy(t, name, key, dtype, shape, f,
-                                             feature_list_dense_values[d]));
+      for (int i = 1; i < batched_values.dims(); ++i) {
+        out_shape.AddDim(batched_values.dim_size(i));
       }
+      Tensor values;
+      CHECK(values.CopyFrom(batched_values, out_shape));
+      feature_list_dense_values.set(d, values);
     }
 
-    // Feature List Sparse -----------------------------------------------------
     for (int d = 0; d < attrs_.num_feature_list_sparse; ++d) {
-      const string& key = feature_list_sparse_keys_t[d];
-      const DataType& dtype = attrs_.feature_list_sparse_types[d];
-
-      const auto& feature_list_found = feature_list_dict.find(key);
-      bool feature_list_has_data =  // Found key
-          (feature_list_found != feature_list_dict.end());
-
-      std::vector<Tensor> sparse_values_tmp;
-      int64 feature_list_size = 0;
-      if (feature_list_has_data) {
-        const FeatureList& fl = feature_list_found->second;
-        feature_list_size = fl.feature_size();
-        for (int64 t = 0; t < feature_list_size; ++t) {
-          const Feature& f = fl.feature(t);
-          bool types_match;
-          OP_REQUIRES_OK(ctx, CheckTypesMatch(f, dtype, &types_match));
-          OP_REQUIRES(
-              ctx, f.kind_case() == Feature::KIND_NOT_SET || types_match,
-              errors::InvalidArgument("Name: ", name, ", Feature List: ", key,
-                                      ", Index: ", t,
-                                      ".  Data types don't match. ",
-                                      "Expected type: ", DataTypeString(dtype),
-                                      "  Feature is: ", ProtoDebugString(f)));
-          sparse_values_tmp.push_back(FeatureSparseCopy(t, key, dtype, f));
-        }
-      } else {
-        sparse_values_tmp.push_back(Tensor(dtype, TensorShape({0})));
-      }
-
-      int64 total_num_features = 0;
-      int64 max_num_features = 0;
-      for (int t = 0; t < feature_list_size; ++t) {
-        const Tensor& v = sparse_values_tmp[t];
-        const int64 num_elements = v.shape().num_elements();
-        total_num_features += num_elements;
-        max_num_features = std::max(max_num_features, num_elements);
-      }
-
-      TensorShape indices_shape({total_num_features, 2});
-      TensorShape values_shape({total_num_features});
+      const Tensor& batched_indices = feature_list_result.sparse_indices[d];
+      const int64 num_elements = batched_indices.dim_size(0);
       Tensor* sp_indices_d = nullptr;
-      Tensor* sp_values_d = nullptr;
       Tensor* sp_shape_d = nullptr;
-      OP_REQUIRES_OK(ctx, feature_list_sparse_indices.allocate(d, indices_shape,
-                                                               &sp_indices_d));
-      OP_REQUIRES_OK(ctx, feature_list_sparse_values.allocate(d, values_shape,
-                                                              &sp_values_d));
+      OP_REQUIRES_OK(ctx, feature_list_sparse_indices.allocate(
+                              d, TensorShape({num_elements, 2}),
+                              &sp_indices_d));
+      feature_list_sparse_values.set(d, feature_list_result.sparse_values[d]);
       OP_REQUIRES_OK(ctx, feature_list_sparse_shapes.allocate(
                               d, TensorShape({2}), &sp_shape_d));
+      auto batched_shape_t = feature_list_result.sparse_shapes[d].vec<int64>();
       auto shape_t = sp_shape_d->vec<int64>();
-      shape_t(0) = feature_list_size;
-      shape_t(1) = max_num_features;
-
-      int64 offset = 0;
-
-      for (int t = 0; t < feature_list_size; ++t) {
-        const int64 num_elements = CopyIntoSparseTensor(
-            sparse_values_tmp[t], t, offset, sp_indices_d, sp_values_d);
-        offset += num_elements;
+      shape_t(0) = batched_shape_t(1);
+      shape_t(1) = batched_shape_t(2);
+      auto batched_indices_t = batched_indices.matrix<int64>();
+      auto indices_t = sp_indices_d->matrix<int64>();
+      for (int64 i = 0; i < num_elements; ++i) {
+        indices_t(i, 0) = batched_indices_t(i, 1);
+        indices_t(i, 1) = batched_indices_t(i, 2);
       }
     }
   }
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <algorithm>
 #include <deque>
+#include <memory>
 #include <vector>
 
 #include "tensorflow/core/framework/tensor.h"
@@ -83,18 +84,57 @@ void FIFOQueue::TryEnqueue(const Tuple& tuple, OpKernelContext* ctx,
 }
 
 /* static */
-Status FIFOQueue::GetElementComponentFromBatch(const FIFOQueue::Tuple& tuple,
-                                               int64 index, int component,
-                                               OpKernelContext* ctx,
-                                               PersistentTensor* out_tensor) {
-  TensorShape element_shape(tuple[component].shape());
-  element_shape.RemoveDim(0);
-  Tensor* element_access = nullptr;
-  TF_RETURN_IF_ERROR(ctx->allocate_persistent(
-      tuple[component].dtype(), element_shape, out_tensor, &element_access));
-  TF_RETURN_IF_ERROR(
-      CopySliceToElement(tuple[component], element_access, index));
-  return Status::OK();
+Status FIFOQueue::GetElementsFromBatch(const FIFOQueue::Tuple& tuple,
+                                       OpKernelContext* ctx,
+                                       Tuple* elements) {
+  const int64 batch_size = tuple[0].dim_size(0);
+  int64 element_bytes = 0;
+  for (const Tensor& component : tuple) {
+    element_bytes += component.TotalBytes() / batch_size;
+  }
+  elements->reserve(batch_size * tuple.size());
+  for (int64 index = 0; index < batch_size; ++index) {
+    for (const Tensor& component : tuple) {
+      TensorShape element_shape(component.shape());
+      element_shape.RemoveDim(0);
+      PersistentTensor persistent;
+      Tensor* element_access = nullptr;
+      TF_RETURN_IF_ERROR(ctx->allocate_persistent(
+          component.dtype(), element_shape, &persistent, &element_access));
+      elements->push_back(*element_access);
+    }
+  }
+  return ParallelCopy(
+      ctx, batch_size, element_bytes, [&tuple, elements](int64 index) {
+        Tensor* element = &(*elements)[index * tuple.size()];
+        for (size_t i = 0; i < tuple.size(); ++i) {
+          TF_RETURN_IF_ERROR(CopySliceToElement(tuple[i], &element[i], index));
+        }
+        return Status::OK();
+      });
+}
+
+Status FIFOQueue::BatchElements(OpKernelContext* ctx,
+                                const std::vector<Tuple>& elements,
+                                Tuple* tuple) {
+  const int64 batch_size = elements.size();
+  int64 element_bytes = 0;
+  tuple->reserve(num_components());
+  for (int i = 0; i < num_components(); ++i) {
+    Tensor component;
+    TF_RETURN_IF_ERROR(ctx->allocate_temp(
+        component_dtypes_[i], ManyOutShape(i, batch_size), &component));
+    element_bytes += elements[0][i].TotalBytes();
+    tuple->push_back(component);
+  }
+  return ParallelCopy(
+      ctx, batch_size, element_bytes, [&elements, tuple](int64 index) {
+        for (size_t i = 0; i < tuple->size(); ++i) {
+          TF_RETURN_IF_ERROR(
+              CopyElementToSlice(elements[index][i], &(*tuple)[i], index));
+        }
+        return Status::OK();
+      });
 }
 
 void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
@@ -105,6 +145,16 @@ void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
     return;
   }
 
+  // Split the batch before taking the lock, so that the copies don't hold up
+  // the other users of the queue.
+  Tuple elements;
+  Status s = GetElementsFromBatch(tuple, ctx, &elements);
+  if (!s.ok()) {
+    ctx->SetStatus(s);
+    callback();
+    return;
+  }
+
   CancellationManager* cm = ctx->cancellation_manager();
   CancellationToken token = cm->get_cancellation_token();
   bool already_cancelled;
@@ -115,7 +165,7 @@ void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
     if (!already_cancelled) {
       enqueue_attempts_.emplace_back(
           batch_size, callback, ctx, cm, token,
-          [tuple, this](Attempt* attempt) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+          [this](Attempt* attempt) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
             if (closed_) {
               attempt->context->SetStatus(
                   errors::Cancelled("FIFOQueue '", name_, "' is closed."));
@@ -125,21 +175,22 @@ void FIFOQueue::TryEnqueueMany(const Tuple& tuple, OpKernelContext* ctx,
             while (queues_[0].size() < static_cast<size_t>(capacity_)) {
               result = kProgress;
               const int64 index =
-                  tuple[0].dim_size(0) - attempt->elements_requested;
+                  attempt->tuple.size() / num_components() -
+                  attempt->elements_requested;
               for (int i = 0; i < num_components(); ++i) {
-                PersistentTensor element;
-                attempt->context->SetStatus(GetElementComponentFromBatch(
-                    tuple, index, i, attempt->context, &element));
-                if (!attempt->context->status().ok()) return kComplete;
-                queues_[i].push_back(element);
+                Tensor* element = &attempt->tuple[index * num_components() + i];
+                queues_[i].push_back(PersistentTensor(*element));
+                *element = Tensor();
               }
               --attempt->elements_requested;
               if (attempt->elements_requested == 0) {
+                attempt->tuple.clear();
                 return kComplete;
               }
             }
             return result;
           });
+      enqueue_attempts_.back().tuple.swap(elements);
     }
   }
   if (!already_cancelled) {
@@ -259,32 +310,19 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
 
                 if (closed_ && queue_size < attempt->elements_requested) {
                   // If we don't have enough for a full dequeue, we have
-                  // to reset the attempt tuple.
-                  if (!attempt->tuple.empty()) {
-                    // Restore already-dequeued elements to the front of the
-                    // queue.
-                    for (int64 i = attempt->tuple[0].dim_size(0) -
-                                   attempt->elements_requested - 1;
-                         i >= 0; --i) {
-                      for (int j = 0; j < num_components(); ++j) {
-                        PersistentTensor element;
-                        Status s = GetElementComponentFromBatch(
-                            attempt->tuple, i, j, attempt->context, &element);
-                        if (!s.ok()) {
-                          attempt->context->SetStatus(
-                              errors::DataLoss("Failed to restore element from "
-                                               "partially-dequeued batch "
-                                               "to FIFOQueue: ",
-                                               s.error_message()));
-                        }
-                        queues_[j].push_front(element);
-                      }
+                  // to reset the attempt tuples.
+                  // Restore already-dequeued elements to the front of the
+                  // queue.
+                  for (int64 i = attempt->tuples.size() - 1; i >= 0; --i) {
+                    for (int j = 0; j < num_components(); ++j) {
+                      queues_[j].push_front(
+                          PersistentTensor(attempt->tuples[i][j]));
                     }
                   }
+                  attempt->tuples.clear();
                   if (allow_small_batch && !queues_[0].empty()) {
                     // Request all remaining elements in the queue.
                     queue_size = queues_[0].size();
-                    attempt->tuple.clear();
                     attempt->elements_requested = queue_size;
                   } else {
                     if (allow_small_batch) {
@@ -306,37 +344,27 @@ void FIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
 
                 RunResult result = kNoProgress;
                 for (; queue_size > 0; --queue_size) {
-                  if (attempt->tuple.empty()) {
-                    // Only allocate tuple when we have something to dequeue
-                    // so we don't use excessive memory when there are many
-                    // blocked dequeue attempts waiting.
-                    attempt->tuple.reserve(num_components());
-                    for (int i = 0; i < num_components(); ++i) {
-                      const TensorShape shape =
-                          ManyOutShape(i, attempt->elements_requested);
-                      Tensor element;
-                      attempt->context->SetStatus(
-                          attempt->context->allocate_temp(component_dtypes_[i],
-                                                          shape, &element));
-                      if (!attempt->context->status().ok()) return kComplete;
-                      attempt->tuple.emplace_back(element);
-                    }
-                  }
                   result = kProgress;
                   Tuple tuple;
                   DequeueLocked(attempt->context, &tuple);
-                  const int64 index = attempt->tuple[0].dim_size(0) -
-                                      attempt->elements_requested;
-                  for (int i = 0; i < num_components(); ++i) {
-                    attempt->context->SetStatus(CopyElementToSlice(
-                        tuple[i], &attempt->tuple[i], index));
-                    if (!attempt->context->status().ok()) return kComplete;
-                  }
-                  tuple.clear();
+                  attempt->tuples.push_back(std::move(tuple));
                   --attempt->elements_requested;
                   if (attempt->elements_requested == 0) {
-                    tuple = attempt->tuple;
-                    attempt->done_callback = [callback, tuple]() {
+                    // Only allocate and fill in the batch once mu_ is
+                    // released, so that the copies don't block the other
+                    // users of the queue.
+                    OpKernelContext* ctx = attempt->context;
+                    std::shared_ptr<std::vector<Tuple>> elements(
+                        new std::vector<Tuple>);
+                    elements->swap(attempt->tuples);
+                    attempt->done_callback = [this, ctx, callback,
+                                              elements]() {
+                      Tuple tuple;
+                      Status s = BatchElements(ctx, *elements, &tuple);
+                      if (!s.ok()) {
+                        ctx->SetStatus(s);
+                        tuple.clear();
+                      }
                       callback(tuple);
                     };
                     return kComplete;
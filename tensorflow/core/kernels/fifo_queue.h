@@ -60,10 +60,17 @@ class FIFOQueue : public TypedQueue<std::deque<PersistentTensor> > {
   void DequeueLocked(OpKernelContext* ctx, Tuple* tuple)
       EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
-  static Status GetElementComponentFromBatch(const Tuple& tuple, int64 index,
-                                             int component,
-                                             OpKernelContext* ctx,
-                                             PersistentTensor* out_element);
+  // Copies the slices (in the first dimension) of the components of "tuple"
+  // into newly allocated tensors. Component i of the index^th element is
+  // stored in (*elements)[index * tuple.size() + i].
+  static Status GetElementsFromBatch(const Tuple& tuple, OpKernelContext* ctx,
+                                     Tuple* elements);
+
+  // Allocates the components of "*tuple" and copies "elements" into their
+  // consecutive slices. Must be called without holding mu_.
+  virtual Status BatchElements(OpKernelContext* ctx,
+                               const std::vector<Tuple>& elements,
+                               Tuple* tuple);
 
  private:
   TF_DISALLOW_COPY_AND_ASSIGN(FIFOQueue);
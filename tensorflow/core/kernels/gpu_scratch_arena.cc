@@ -0,0 +1,146 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/gpu_scratch_arena.h"
+
+#include <unordered_map>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+namespace {
+
+bool GpuScratchArenaEnabled() {
+  static const bool enabled = [] {
+    bool enabled = true;
+    Status status = ReadBoolFromEnvVar("TF_GPU_SCRATCH_ARENA", true, &enabled);
+    if (!status.ok()) {
+      LOG(ERROR) << status.error_message();
+    }
+    return enabled;
+  }();
+  return enabled;
+}
+
+int64 RoundUp(int64 value, int64 multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+}  // namespace
+
+const int64 GpuScratchArena::kGrowthGranularity;
+const int64 GpuScratchArenaLease::kAlignment;
+
+// static
+GpuScratchArena* GpuScratchArena::ForStream(const void* stream) {
+  static mutex* mu = new mutex;
+  static auto* arenas = new std::unordered_map<const void*, GpuScratchArena*>;
+  mutex_lock l(*mu);
+  GpuScratchArena*& arena = (*arenas)[stream];
+  if (arena == nullptr) {
+    arena = new GpuScratchArena;
+  }
+  return arena;
+}
+
+bool GpuScratchArena::TryAcquire() {
+  mutex_lock l(mu_);
+  if (in_use_) {
+    return false;
+  }
+  in_use_ = true;
+  return true;
+}
+
+void GpuScratchArena::Release() {
+  mutex_lock l(mu_);
+  DCHECK(in_use_);
+  in_use_ = false;
+}
+
+Status GpuScratchArena::GetBuffer(Allocator* allocator, int64 num_bytes,
+                                  Tensor* buffer) {
+  mutex_lock l(mu_);
+  DCHECK(in_use_);
+  if (size_ < num_bytes) {
+    const int64 new_size = RoundUp(num_bytes, kGrowthGranularity);
+    // Failing to grow only costs the caller a temporary allocation.
+    AllocationAttributes allocation_attr;
+    allocation_attr.no_retry_on_failure = true;
+    Tensor new_buffer(allocator, DT_UINT8, TensorShape({new_size}),
+                      allocation_attr);
+    if (!new_buffer.IsInitialized()) {
+      return errors::ResourceExhausted("Could not grow the scratch arena to ",
+                                       new_size, " bytes");
+    }
+    VLOG(1) << "Grew the scratch arena from " << size_ << " to " << new_size
+            << " bytes";
+    if (allocator_ != nullptr) {
+      allocator_->RecordScratchBytes(-size_);
+    }
+    allocator->RecordScratchBytes(new_size);
+    buffer_ = new_buffer;
+    size_ = new_size;
+    allocator_ = allocator;
+  }
+  *buffer = buffer_;
+  return Status::OK();
+}
+
+GpuScratchArenaLease::~GpuScratchArenaLease() {
+  if (arena_ != nullptr) {
+    arena_->Release();
+  }
+}
+
+uint8* GpuScratchArenaLease::Allocate(const void* stream, int64 num_bytes) {
+  if (!tried_arena_) {
+    tried_arena_ = true;
+    if (GpuScratchArenaEnabled()) {
+      GpuScratchArena* arena = GpuScratchArena::ForStream(stream);
+      if (arena->TryAcquire()) {
+        arena_ = arena;
+      }
+    }
+  }
+  if (arena_ == nullptr) {
+    return nullptr;
+  }
+
+  int64 offset = RoundUp(used_, kAlignment);
+  if (offset + num_bytes > buffer_size_) {
+    // The slices handed out so far stay valid, as this holds on to their
+    // buffer, and the arena grows to fit all of them next time.
+    if (used_ > 0) {
+      outgrown_buffers_.push_back(buffer_);
+    }
+    Tensor buffer;
+    Allocator* allocator =
+        context_->device()->GetAllocator(AllocatorAttributes());
+    if (!arena_->GetBuffer(allocator, offset + num_bytes, &buffer).ok()) {
+      return nullptr;
+    }
+    buffer_ = buffer;
+    buffer_size_ = buffer.NumElements();
+    offset = 0;
+  }
+  used_ = offset + num_bytes;
+  return buffer_.flat<uint8>().data() + offset;
+}
+
+}  // namespace tensorflow
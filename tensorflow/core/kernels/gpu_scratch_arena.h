@@ -0,0 +1,120 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_GPU_SCRATCH_ARENA_H_
+#define TENSORFLOW_KERNELS_GPU_SCRATCH_ARENA_H_
+
+#include <vector>
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A workspace buffer kept alive across kernel invocations for the scratch
+// space of the cuDNN and cuBLAS calls enqueued on one stream. It only grows,
+// to the largest workspace requested so far, so that convolutions stop
+// churning their (often very large) workspaces through the device allocator
+// on every call. Its size is reported as bytes_in_scratch in the stats of the
+// allocator it comes from.
+//
+// Work enqueued on one stream runs in order, so successive users can share
+// the buffer as long as each one is done enqueueing its work before the next
+// one starts: the arena is held by one user at a time.
+//
+// This class is thread-safe.
+class GpuScratchArena {
+ public:
+  // Returns the arena of stream, creating it on first use. Arenas live as
+  // long as the process, like the streams of the GPU devices.
+  static GpuScratchArena* ForStream(const void* stream);
+
+  // Takes hold of the arena, unless another user holds it already, in which
+  // case it returns false.
+  bool TryAcquire();
+
+  // Lets go of the arena. The work that used the buffer has to be enqueued
+  // on the stream by then.
+  void Release();
+
+  // Sets *buffer to the buffer of the arena, after growing it with allocator
+  // if it has fewer than num_bytes bytes. Users must not use a buffer the
+  // arena outgrew after they release it.
+  // REQUIRES: the caller holds the arena.
+  Status GetBuffer(Allocator* allocator, int64 num_bytes, Tensor* buffer);
+
+  int64 size() {
+    mutex_lock l(mu_);
+    return size_;
+  }
+
+  // The arena grows in multiples of this many bytes.
+  static const int64 kGrowthGranularity = 1 << 20;
+
+ private:
+  GpuScratchArena() {}
+
+  mutex mu_;
+  bool in_use_ GUARDED_BY(mu_) = false;
+  Tensor buffer_ GUARDED_BY(mu_);
+  int64 size_ GUARDED_BY(mu_) = 0;
+  Allocator* allocator_ GUARDED_BY(mu_) = nullptr;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GpuScratchArena);
+};
+
+// Hands out the scratch space requested by one ScratchAllocator from the
+// arena of its stream, holding the arena until it is destroyed. Successive
+// requests get successive slices of the buffer, as some calls (e.g. batched
+// cuBLAS GEMMs) use several of them at once. Returns nullptr when the arena
+// is disabled, held by another kernel, or can't grow, so that the caller
+// falls back to allocating temporary tensors.
+//
+// The arena can be disabled by setting TF_GPU_SCRATCH_ARENA=false.
+class GpuScratchArenaLease {
+ public:
+  explicit GpuScratchArenaLease(OpKernelContext* context)
+      : context_(context) {}
+  ~GpuScratchArenaLease();
+
+  // Returns num_bytes of scratch space for work enqueued on stream.
+  uint8* Allocate(const void* stream, int64 num_bytes);
+
+  // Slices of the arena are aligned to this many bytes.
+  static const int64 kAlignment = 256;
+
+ private:
+  OpKernelContext* context_;
+  GpuScratchArena* arena_ = nullptr;
+  bool tried_arena_ = false;
+  // The current buffer of the arena, with used_ bytes handed out so far.
+  Tensor buffer_;
+  int64 buffer_size_ = 0;
+  int64 used_ = 0;
+  // Buffers the arena outgrew while slices of them were handed out.
+  std::vector<Tensor> outgrown_buffers_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(GpuScratchArenaLease);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_GPU_SCRATCH_ARENA_H_
@@ -0,0 +1,125 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/kernels/gpu_scratch_arena.h"
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+// Forwards to the CPU allocator, keeping count of the scratch bytes it is
+// told about.
+class ScratchCountingAllocator : public Allocator {
+ public:
+  string Name() override { return "scratch_counting"; }
+  void* AllocateRaw(size_t alignment, size_t num_bytes) override {
+    ++num_allocs_;
+    return cpu_allocator()->AllocateRaw(alignment, num_bytes);
+  }
+  void DeallocateRaw(void* ptr) override {
+    cpu_allocator()->DeallocateRaw(ptr);
+  }
+  void RecordScratchBytes(int64 num_bytes) override {
+    bytes_in_scratch_ += num_bytes;
+  }
+
+  int num_allocs_ = 0;
+  int64 bytes_in_scratch_ = 0;
+};
+
+class NoMemoryAllocator : public Allocator {
+ public:
+  string Name() override { return "no_memory"; }
+  void* AllocateRaw(size_t /*alignment*/, size_t num_bytes) override {
+    return nullptr;
+  }
+  void DeallocateRaw(void* ptr) override {}
+};
+
+// Arenas live as long as the process, so each test uses streams of its own,
+// and allocators that are never destroyed.
+TEST(GpuScratchArenaTest, OneArenaPerStream) {
+  static int stream_a;
+  static int stream_b;
+  GpuScratchArena* arena_a = GpuScratchArena::ForStream(&stream_a);
+  EXPECT_EQ(arena_a, GpuScratchArena::ForStream(&stream_a));
+  EXPECT_NE(arena_a, GpuScratchArena::ForStream(&stream_b));
+}
+
+TEST(GpuScratchArenaTest, HeldByOneUserAtATime) {
+  static int stream;
+  GpuScratchArena* arena = GpuScratchArena::ForStream(&stream);
+  EXPECT_TRUE(arena->TryAcquire());
+  EXPECT_FALSE(arena->TryAcquire());
+  arena->Release();
+  EXPECT_TRUE(arena->TryAcquire());
+  arena->Release();
+}
+
+TEST(GpuScratchArenaTest, GrowsToTheLargestRequest) {
+  static int stream;
+  GpuScratchArena* arena = GpuScratchArena::ForStream(&stream);
+  ScratchCountingAllocator& allocator = *new ScratchCountingAllocator;
+  ASSERT_TRUE(arena->TryAcquire());
+
+  Tensor buffer;
+  TF_EXPECT_OK(arena->GetBuffer(&allocator, 100, &buffer));
+  EXPECT_EQ(GpuScratchArena::kGrowthGranularity, arena->size());
+  EXPECT_EQ(GpuScratchArena::kGrowthGranularity, buffer.NumElements());
+  EXPECT_EQ(GpuScratchArena::kGrowthGranularity, allocator.bytes_in_scratch_);
+  EXPECT_EQ(1, allocator.num_allocs_);
+
+  // Smaller requests reuse the buffer.
+  Tensor same_buffer;
+  TF_EXPECT_OK(arena->GetBuffer(&allocator, 1000, &same_buffer));
+  EXPECT_EQ(buffer.flat<uint8>().data(), same_buffer.flat<uint8>().data());
+  EXPECT_EQ(1, allocator.num_allocs_);
+
+  Tensor larger_buffer;
+  TF_EXPECT_OK(arena->GetBuffer(
+      &allocator, GpuScratchArena::kGrowthGranularity + 1, &larger_buffer));
+  EXPECT_EQ(2 * GpuScratchArena::kGrowthGranularity, arena->size());
+  EXPECT_EQ(2 * GpuScratchArena::kGrowthGranularity,
+            allocator.bytes_in_scratch_);
+  EXPECT_EQ(2, allocator.num_allocs_);
+  arena->Release();
+}
+
+TEST(GpuScratchArenaTest, FailingToGrowKeepsTheBuffer) {
+  static int stream;
+  GpuScratchArena* arena = GpuScratchArena::ForStream(&stream);
+  ScratchCountingAllocator& allocator = *new ScratchCountingAllocator;
+  NoMemoryAllocator& no_memory_allocator = *new NoMemoryAllocator;
+  ASSERT_TRUE(arena->TryAcquire());
+
+  Tensor buffer;
+  TF_EXPECT_OK(arena->GetBuffer(&allocator, 100, &buffer));
+  Tensor larger_buffer;
+  EXPECT_TRUE(errors::IsResourceExhausted(
+      arena->GetBuffer(&no_memory_allocator,
+                       GpuScratchArena::kGrowthGranularity + 1,
+                       &larger_buffer)));
+  EXPECT_EQ(GpuScratchArena::kGrowthGranularity, arena->size());
+  EXPECT_EQ(GpuScratchArena::kGrowthGranularity, allocator.bytes_in_scratch_);
+  arena->Release();
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -76,16 +76,34 @@ class IteratorResource : public ResourceBase {
         output_dtypes_(output_dtypes),
         output_shapes_(output_shapes) {}
 
-  Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
-                 bool* end_of_sequence) {
+  // Gets the next element with `IteratorBase::GetNextAsync()`. Unless
+  // the iterator never blocks, the call is issued through
+  // `blocking_runner`, so that it does not block the calling thread.
+  void GetNextAsync(
+      IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+      bool* end_of_sequence,
+      const std::function<void(std::function<void()>)>& blocking_runner,
+      IteratorBase::DoneCallback done) {
     std::shared_ptr<IteratorBase> captured_iterator(iterator_);
-    if (captured_iterator) {
-      return captured_iterator->GetNext(ctx, out_tensors, end_of_sequence);
-    } else {
-      return errors::FailedPrecondition(
+    if (!captured_iterator) {
+      done(errors::FailedPrecondition(
           "GetNext() failed because the iterator has not been initialized. "
           "Ensure that you have run the initializer operation for this "
-          "iterator before getting the next element.");
+          "iterator before getting the next element."));
+      return;
+    }
+    // The iterator is kept alive while `GetNextAsync()` runs, even if it
+    // is reset concurrently. `done` does not hold it: a call that the
+    // iterator queued is completed with an error when it is destroyed.
+    auto get_next = [captured_iterator, ctx, out_tensors, end_of_sequence,
+                     done]() {
+      captured_iterator->GetNextAsync(ctx, out_tensors, end_of_sequence,
+                                      done);
+    };
+    if (captured_iterator->is_async()) {
+      get_next();
+    } else {
+      blocking_runner(std::move(get_next));
     }
   }
 
@@ -364,41 +382,69 @@ class IteratorGetNextOp : public AsyncOpKernel {
 
   void ComputeAsync(OpKernelContext* ctx, DoneCallback done) override {
     IteratorResource* iterator;
-    OP_REQUIRES_OK(ctx,
-                   LookupResource(ctx, HandleFromInput(ctx, 0), &iterator));
-
-    // The call to `iterator->GetNext()` may block and depend on an
-    // inter-op thread pool thread, so we issue the call from the
-    // owned thread pool.
-    thread_pool_->Schedule([this, ctx, iterator, done]() {
-      core::ScopedUnref unref_iterator(iterator);
-
-      std::vector<Tensor> components;
-      bool end_of_sequence = false;
-
-      IteratorContext::Params params;
-      params.env = ctx->env();
-      params.step_id = ctx->step_id();
-      params.resource_manager = ctx->resource_manager();
-      params.runner = *(ctx->runner());
-      IteratorContext iter_ctx(std::move(params));
-
-      OP_REQUIRES_OK_ASYNC(
-          ctx, iterator->GetNext(&iter_ctx, &components, &end_of_sequence),
-          done);
-      OP_REQUIRES_ASYNC(ctx, !end_of_sequence,
-                        errors::OutOfRange("End of sequence"), done);
-
-      for (int i = 0; i < components.size(); ++i) {
-        // TODO(mrry): Check that the shapes match the shape attrs.
-        ctx->set_output(i, components[i]);
-      }
-
-      done();
-    });
+    OP_REQUIRES_OK_ASYNC(
+        ctx, LookupResource(ctx, HandleFromInput(ctx, 0), &iterator), done);
+
+    IteratorContext::Params params;
+    params.env = ctx->env();
+    params.step_id = ctx->step_id();
+    params.resource_manager = ctx->resource_manager();
+    params.runner = *(ctx->runner());
+    GetNextState* state = new GetNextState(std::move(params));
+    const int64 start_usecs = ctx->env()->NowMicros();
+
+    // A call to `iterator->GetNext()` may block and depend on an
+    // inter-op thread pool thread, so unless the iterator waits
+    // without blocking we issue the call from the owned thread pool.
+    iterator->GetNextAsync(
+        &state->iter_ctx, &state->components, &state->end_of_sequence,
+        [this](std::function<void()> c) { thread_pool_->Schedule(c); },
+        [ctx, iterator, state, start_usecs, done](const Status& s) {
+          std::unique_ptr<GetNextState> cleanup_state(state);
+          core::ScopedUnref unref_iterator(iterator);
+          RecordDatasetConsumerWait(ctx->op_kernel().name(),
+                                    ctx->env()->NowMicros() - start_usecs);
+
+          OP_REQUIRES_OK_ASYNC(ctx, s, done);
+          OP_REQUIRES_ASYNC(ctx, !state->end_of_sequence,
+                            errors::OutOfRange("End of sequence"), done);
+
+          for (int i = 0; i < state->components.size(); ++i) {
+            // TODO(mrry): Check that the shapes match the shape attrs.
+            const Tensor& component = state->components[i];
+            if (ctx->output_alloc_attr(i).gpu_compatible() &&
+                DataTypeCanUseMemcpy(component.dtype())) {
+              // The component is copied to a GPU next. The dataset allocated
+              // it in pageable memory, so stage it in a buffer that the
+              // output allocator pins, from which the copy is an
+              // asynchronous DMA.
+              Tensor* staged;
+              OP_REQUIRES_OK_ASYNC(
+                  ctx, ctx->allocate_output(i, component.shape(), &staged),
+                  done);
+              StringPiece src = component.tensor_data();
+              memcpy(const_cast<char*>(staged->tensor_data().data()),
+                     src.data(), src.size());
+            } else {
+              ctx->set_output(i, component);
+            }
+          }
+
+          done();
+        });
   }
 
  private:
+  // The arguments of a pending call to `IteratorResource::GetNextAsync()`.
+  struct GetNextState {
+    explicit GetNextState(IteratorContext::Params params)
+        : iter_ctx(std::move(params)) {}
+
+    IteratorContext iter_ctx;
+    std::vector<Tensor> components;
+    bool end_of_sequence = false;
+  };
+
   std::unique_ptr<thread::ThreadPool> thread_pool_;
 };
 
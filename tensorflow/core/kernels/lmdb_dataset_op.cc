@@ -0,0 +1,295 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/dataset.h"
+
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+
+#include "lmdb.h"
+
+namespace tensorflow {
+
+namespace {
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+Status MdbStatus(int mdb_status, const string& filename) {
+  if (mdb_status == MDB_SUCCESS) {
+    return Status::OK();
+  }
+  return errors::Internal("LMDB error reading ", filename, ": ",
+                          mdb_strerror(mdb_status));
+}
+
+StringPiece ToStringPiece(const MDB_val& val) {
+  return StringPiece(static_cast<const char*>(val.mv_data), val.mv_size);
+}
+
+class LMDBDatasetOp : public OpKernel {
+ public:
+  using OpKernel::OpKernel;
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor* filenames_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("filenames", &filenames_tensor));
+    OP_REQUIRES(
+        ctx, filenames_tensor->dims() <= 1,
+        errors::InvalidArgument("`filenames` must be a scalar or a vector."));
+
+    std::vector<string> filenames;
+    filenames.reserve(filenames_tensor->NumElements());
+    for (int i = 0; i < filenames_tensor->NumElements(); ++i) {
+      filenames.push_back(filenames_tensor->flat<string>()(i));
+    }
+
+    const Tensor* start_key_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("start_key", &start_key_tensor));
+    OP_REQUIRES(ctx, start_key_tensor->dims() == 0,
+                errors::InvalidArgument("`start_key` must be a scalar."));
+    const string& start_key = start_key_tensor->scalar<string>()();
+
+    const Tensor* end_key_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("end_key", &end_key_tensor));
+    OP_REQUIRES(ctx, end_key_tensor->dims() == 0,
+                errors::InvalidArgument("`end_key` must be a scalar."));
+    const string& end_key = end_key_tensor->scalar<string>()();
+
+    const Tensor* batch_size_tensor;
+    OP_REQUIRES_OK(ctx, ctx->input("batch_size", &batch_size_tensor));
+    OP_REQUIRES(ctx, batch_size_tensor->dims() == 0,
+                errors::InvalidArgument("`batch_size` must be a scalar."));
+    const int64 batch_size = batch_size_tensor->scalar<int64>()();
+    OP_REQUIRES(
+        ctx, batch_size > 0,
+        errors::InvalidArgument("`batch_size` must be greater than zero."));
+
+    DatasetBase* dataset =
+        new Dataset(std::move(filenames), start_key, end_key, batch_size);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &output));
+    ResourceHandle handle = MakeResourceHandle<DatasetBase>(
+        ctx, ctx->step_container()->name(), name());
+    OP_REQUIRES_OK(ctx, CreateResource(ctx, handle, dataset));
+    output->scalar<ResourceHandle>()() = handle;
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(std::vector<string> filenames, const string& start_key,
+            const string& end_key, int64 batch_size)
+        : filenames_(std::move(filenames)),
+          start_key_(start_key),
+          end_key_(end_key),
+          batch_size_(batch_size) {}
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal() const override {
+      return std::unique_ptr<IteratorBase>(new Iterator(this));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      static DataTypeVector* dtypes =
+          new DataTypeVector({DT_STRING, DT_STRING});
+      return *dtypes;
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      static std::vector<PartialTensorShape>* shapes =
+          new std::vector<PartialTensorShape>({{-1}, {-1}});
+      return *shapes;
+    }
+
+    string DebugString() override { return "LMDBDatasetOp::Dataset"; }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset) {}
+
+      ~Iterator() override {
+        mutex_lock l(mu_);
+        CloseFile();
+      }
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        do {
+          // We are currently processing a file, so walk the cursor over the
+          // next batch of records.
+          if (mdb_cursor_ != nullptr) {
+            // The keys and values point into the memory map of the file,
+            // and stay valid for as long as the read transaction is open,
+            // so they are only copied once, into the output tensors.
+            std::vector<StringPiece> keys;
+            std::vector<StringPiece> values;
+            keys.reserve(dataset()->batch_size_);
+            values.reserve(dataset()->batch_size_);
+            bool at_end = false;
+            while (static_cast<int64>(keys.size()) < dataset()->batch_size_) {
+              TF_RETURN_IF_ERROR(Seek(&at_end));
+              if (at_end) {
+                break;
+              }
+              keys.push_back(ToStringPiece(mdb_key_));
+              values.push_back(ToStringPiece(mdb_value_));
+            }
+            if (!keys.empty()) {
+              Tensor keys_tensor(cpu_allocator(), DT_STRING,
+                                 {static_cast<int64>(keys.size())});
+              Tensor values_tensor(cpu_allocator(), DT_STRING,
+                                   {static_cast<int64>(values.size())});
+              auto keys_flat = keys_tensor.flat<string>();
+              auto values_flat = values_tensor.flat<string>();
+              for (size_t i = 0; i < keys.size(); ++i) {
+                keys_flat(i).assign(keys[i].data(), keys[i].size());
+                values_flat(i).assign(values[i].data(), values[i].size());
+              }
+              out_tensors->emplace_back(std::move(keys_tensor));
+              out_tensors->emplace_back(std::move(values_tensor));
+              if (at_end) {
+                // The records are copied out, so the file can be closed.
+                CloseFile();
+                ++current_file_index_;
+              }
+              *end_of_sequence = false;
+              return Status::OK();
+            }
+
+            // We have reached the end of the key range in the current file,
+            // so maybe move on to next file.
+            CloseFile();
+            ++current_file_index_;
+          }
+
+          // Iteration ends when there are no more files to process.
+          if (current_file_index_ == dataset()->filenames_.size()) {
+            *end_of_sequence = true;
+            return Status::OK();
+          }
+
+          // Actually move on to next file.
+          Status s = OpenFile(ctx->env(),
+                              dataset()->filenames_[current_file_index_]);
+          if (!s.ok()) {
+            CloseFile();
+            return s;
+          }
+        } while (true);
+      }
+
+     private:
+      Status OpenFile(Env* env, const string& filename)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        filename_ = filename;
+        TF_RETURN_IF_ERROR(MdbStatus(mdb_env_create(&mdb_env_), filename_));
+        // MDB_NOTLS lets successive calls run the read transaction on
+        // different threads, as they are serialized by mu_.
+        int flags = MDB_RDONLY | MDB_NOTLS;
+        // Databases are either a directory holding a data.mdb file, or that
+        // data file itself.
+        if (!env->IsDirectory(filename_).ok()) {
+          flags |= MDB_NOSUBDIR;
+        }
+        TF_RETURN_IF_ERROR(MdbStatus(
+            mdb_env_open(mdb_env_, filename_.c_str(), flags, 0664),
+            filename_));
+        TF_RETURN_IF_ERROR(MdbStatus(
+            mdb_txn_begin(mdb_env_, nullptr, MDB_RDONLY, &mdb_txn_),
+            filename_));
+        TF_RETURN_IF_ERROR(
+            MdbStatus(mdb_dbi_open(mdb_txn_, nullptr, 0, &mdb_dbi_),
+                      filename_));
+        TF_RETURN_IF_ERROR(MdbStatus(
+            mdb_cursor_open(mdb_txn_, mdb_dbi_, &mdb_cursor_), filename_));
+        positioned_ = false;
+        return Status::OK();
+      }
+
+      void CloseFile() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (mdb_cursor_ != nullptr) {
+          mdb_cursor_close(mdb_cursor_);
+          mdb_cursor_ = nullptr;
+        }
+        if (mdb_txn_ != nullptr) {
+          mdb_txn_abort(mdb_txn_);
+          mdb_txn_ = nullptr;
+        }
+        if (mdb_env_ != nullptr) {
+          mdb_dbi_close(mdb_env_, mdb_dbi_);
+          mdb_env_close(mdb_env_);
+          mdb_env_ = nullptr;
+        }
+      }
+
+      // Moves the cursor to the next record in the key range, or sets
+      // *at_end if there is none.
+      Status Seek(bool* at_end) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        MDB_cursor_op op = MDB_NEXT;
+        if (!positioned_) {
+          positioned_ = true;
+          if (dataset()->start_key_.empty()) {
+            op = MDB_FIRST;
+          } else {
+            // Positions the cursor at the first key >= start_key.
+            op = MDB_SET_RANGE;
+            mdb_key_.mv_data = const_cast<char*>(dataset()->start_key_.data());
+            mdb_key_.mv_size = dataset()->start_key_.size();
+          }
+        }
+        const int mdb_status =
+            mdb_cursor_get(mdb_cursor_, &mdb_key_, &mdb_value_, op);
+        if (mdb_status == MDB_NOTFOUND) {
+          *at_end = true;
+          return Status::OK();
+        }
+        TF_RETURN_IF_ERROR(MdbStatus(mdb_status, filename_));
+        // Keys are in the lexicographic order of their bytes, which is the
+        // default LMDB order.
+        *at_end = !dataset()->end_key_.empty() &&
+                  ToStringPiece(mdb_key_) >= dataset()->end_key_;
+        return Status::OK();
+      }
+
+      mutex mu_;
+      size_t current_file_index_ GUARDED_BY(mu_) = 0;
+      string filename_ GUARDED_BY(mu_);
+      MDB_env* mdb_env_ GUARDED_BY(mu_) = nullptr;
+      MDB_dbi mdb_dbi_ GUARDED_BY(mu_) = 0;
+      MDB_txn* mdb_txn_ GUARDED_BY(mu_) = nullptr;
+      MDB_cursor* mdb_cursor_ GUARDED_BY(mu_) = nullptr;
+      // Whether the cursor has been moved to the start of the key range.
+      bool positioned_ GUARDED_BY(mu_) = false;
+      MDB_val mdb_key_ GUARDED_BY(mu_);
+      MDB_val mdb_value_ GUARDED_BY(mu_);
+    };
+
+    const std::vector<string> filenames_;
+    const string start_key_;
+    const string end_key_;
+    const int64 batch_size_;
+  };
+};
+
+REGISTER_KERNEL_BUILDER(Name("LMDBDataset").Device(DEVICE_CPU),
+                        LMDBDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
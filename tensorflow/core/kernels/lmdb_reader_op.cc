@@ -81,14 +81,38 @@ class LMDBReader : public ReaderBase {
         return Status::OK();
       }
     }
-    *key = string(static_cast<const char*>(mdb_key_.mv_data),
-                  mdb_key_.mv_size);
-    *value = string(static_cast<const char*>(mdb_value_.mv_data),
-                    mdb_value_.mv_size);
+    key->assign(static_cast<const char*>(mdb_key_.mv_data), mdb_key_.mv_size);
+    value->assign(static_cast<const char*>(mdb_value_.mv_data),
+                  mdb_value_.mv_size);
     *produced = true;
     return Status::OK();
   }
 
+  // Walks the cursor over up to num_records records at once, copying them
+  // straight out of the memory map instead of through ReadLocked.
+  Status ReadUpToLocked(int64 num_records, std::vector<string>* keys,
+                        std::vector<string>* values, int64* num_read,
+                        bool* at_end) override {
+    *num_read = 0;
+    while (*num_read < num_records) {
+      MDB_cursor_op op = MDB_NEXT;
+      if (mdb_cursor_ == nullptr) {
+        MDB_CHECK(mdb_cursor_open(mdb_txn_, mdb_dbi_, &mdb_cursor_));
+        op = MDB_FIRST;
+      }
+      if (Seek(op) == false) {
+        *at_end = true;
+        break;
+      }
+      keys->emplace_back(static_cast<const char*>(mdb_key_.mv_data),
+                         mdb_key_.mv_size);
+      values->emplace_back(static_cast<const char*>(mdb_value_.mv_data),
+                           mdb_value_.mv_size);
+      ++*num_read;
+    }
+    return Status::OK();
+  }
+
   Status ResetLocked() override {
     CHECK_EQ(Seek(MDB_FIRST), true);
     return ReaderBase::ResetLocked();
@@ -16,24 +16,45 @@ limitations under the License.
 #include "tensorflow/core/kernels/lookup_table_op.h"
 #define EIGEN_USE_THREADS
 
+#include <algorithm>
+#include <array>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/kernels/initializable_lookup_table.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/prefetch.h"
+#include "tensorflow/core/util/batch_hash.h"
+#include "tensorflow/core/util/mapped_hash_table.h"
 
 namespace tensorflow {
 namespace lookup {
 
+// The number of independently locked shards of the MutableHashTable* maps.
+// Lookups and inserts of keys in different shards don't contend.
+constexpr int kNumTableShards = 16;
+
+// Returns the shard of "key", in [0, kNumTableShards). The std::hash value is
+// scrambled first, as for integers it is the identity.
+template <class K>
+inline int TableShard(const K& key) {
+  return (static_cast<uint64>(std::hash<K>()(key)) * 0x9E3779B97F4A7C15ULL) >>
+         60;
+}
+
 // Lookup table that wraps an unordered_map, where the key and value data type
 // is specified. Each individual value must be a scalar. If vector values are
 // required, use MutableHashTableOfTensors.
 //
 // This table is mutable and thread safe - Insert can be called at any time.
+// The keys are spread over kNumTableShards maps with their own locks, so that
+// concurrent Find calls don't serialize. Each key is inserted atomically, but
+// a concurrent Find may observe part of an Insert batch.
 //
 // Sample use case:
 //
@@ -49,8 +70,12 @@ class MutableHashTableOfScalars final : public LookupInterface {
   MutableHashTableOfScalars(OpKernelContext* ctx, OpKernel* kernel) {}
 
   size_t size() const override {
-    mutex_lock l(mu_);
-    return table_.size();
+    size_t size = 0;
+    for (const Shard& shard : shards_) {
+      mutex_lock l(shard.mu);
+      size += shard.table.size();
+    }
+    return size;
   }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
@@ -59,11 +84,12 @@ class MutableHashTableOfScalars final : public LookupInterface {
     const auto key_values = key.flat<K>();
     auto value_values = value->flat<V>();
 
-    mutex_lock l(mu_);
     for (int64 i = 0; i < key_values.size(); ++i) {
-      value_values(i) = gtl::FindWithDefault(
-          table_, SubtleMustCopyUnlessStringOrFloat(key_values(i)),
-          default_val);
+      const K key_value = SubtleMustCopyUnlessStringOrFloat(key_values(i));
+      const Shard& shard = shards_[TableShard(key_value)];
+      mutex_lock l(shard.mu);
+      value_values(i) =
+          gtl::FindWithDefault(shard.table, key_value, default_val);
     }
 
     return Status::OK();
@@ -73,13 +99,23 @@ class MutableHashTableOfScalars final : public LookupInterface {
     const auto key_values = keys.flat<K>();
     const auto value_values = values.flat<V>();
 
-    mutex_lock l(mu_);
     if (clear) {
-      table_.clear();
+      std::vector<mutex_lock> locks = LockAllShards();
+      for (Shard& shard : shards_) {
+        shard.table.clear();
+      }
+      for (int64 i = 0; i < key_values.size(); ++i) {
+        const K key_value = SubtleMustCopyUnlessStringOrFloat(key_values(i));
+        gtl::InsertOrUpdate(&shards_[TableShard(key_value)].table, key_value,
+                            SubtleMustCopyUnlessStringOrFloat(value_values(i)));
+      }
+      return Status::OK();
     }
     for (int64 i = 0; i < key_values.size(); ++i) {
-      gtl::InsertOrUpdate(&table_,
-                          SubtleMustCopyUnlessStringOrFloat(key_values(i)),
+      const K key_value = SubtleMustCopyUnlessStringOrFloat(key_values(i));
+      Shard& shard = shards_[TableShard(key_value)];
+      mutex_lock l(shard.mu);
+      gtl::InsertOrUpdate(&shard.table, key_value,
                           SubtleMustCopyUnlessStringOrFloat(value_values(i)));
     }
     return Status::OK();
@@ -96,8 +132,11 @@ class MutableHashTableOfScalars final : public LookupInterface {
   }
 
   Status ExportValues(OpKernelContext* ctx) override {
-    mutex_lock l(mu_);
-    int64 size = table_.size();
+    std::vector<mutex_lock> locks = LockAllShards();
+    int64 size = 0;
+    for (const Shard& shard : shards_) {
+      size += shard.table.size();
+    }
 
     Tensor* keys;
     Tensor* values;
@@ -109,9 +148,11 @@ class MutableHashTableOfScalars final : public LookupInterface {
     auto keys_data = keys->flat<K>();
     auto values_data = values->flat<V>();
     int64 i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      keys_data(i) = it->first;
-      values_data(i) = it->second;
+    for (const Shard& shard : shards_) {
+      for (auto it = shard.table.begin(); it != shard.table.end(); ++it, ++i) {
+        keys_data(i) = it->first;
+        values_data(i) = it->second;
+      }
     }
     return Status::OK();
   }
@@ -125,9 +166,22 @@ class MutableHashTableOfScalars final : public LookupInterface {
   TensorShape value_shape() const override { return TensorShape(); }
 
  private:
-  // TODO(andreasst): consider using a read/write lock or a concurrent map
-  mutable mutex mu_;
-  std::unordered_map<K, V> table_ GUARDED_BY(mu_);
+  struct Shard {
+    mutable mutex mu;
+    std::unordered_map<K, V> table GUARDED_BY(mu);
+  };
+
+  // Locks the shards in order, for operations on the whole table.
+  std::vector<mutex_lock> LockAllShards() const {
+    std::vector<mutex_lock> locks;
+    locks.reserve(kNumTableShards);
+    for (const Shard& shard : shards_) {
+      locks.emplace_back(shard.mu);
+    }
+    return locks;
+  }
+
+  std::array<Shard, kNumTableShards> shards_;
 };
 
 // Lookup table that wraps an unordered_map. Behaves identical to
@@ -145,8 +199,12 @@ class MutableHashTableOfTensors final : public LookupInterface {
   }
 
   size_t size() const override {
-    mutex_lock l(mu_);
-    return table_.size();
+    size_t size = 0;
+    for (const Shard& shard : shards_) {
+      mutex_lock l(shard.mu);
+      size += shard.table.size();
+    }
+    return size;
   }
 
   Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
@@ -156,10 +214,11 @@ class MutableHashTableOfTensors final : public LookupInterface {
     auto value_values = value->flat_inner_dims<V, 2>();
     int64 value_dim = value_shape_.dim_size(0);
 
-    mutex_lock l(mu_);
     for (int64 i = 0; i < key_values.size(); ++i) {
-      ValueArray* value_vec = gtl::FindOrNull(
-          table_, SubtleMustCopyUnlessStringOrFloat(key_values(i)));
+      const K key_value = SubtleMustCopyUnlessStringOrFloat(key_values(i));
+      const Shard& shard = shards_[TableShard(key_value)];
+      mutex_lock l(shard.mu);
+      const ValueArray* value_vec = gtl::FindOrNull(shard.table, key_value);
       if (value_vec != nullptr) {
         for (int64 j = 0; j < value_dim; j++) {
           value_values(i, j) = value_vec->at(j);
@@ -179,9 +238,12 @@ class MutableHashTableOfTensors final : public LookupInterface {
     const auto value_values = values.flat_inner_dims<V, 2>();
     int64 value_dim = value_shape_.dim_size(0);
 
-    mutex_lock l(mu_);
+    std::vector<mutex_lock> locks;
     if (clear) {
-      table_.clear();
+      locks = LockAllShards();
+      for (Shard& shard : shards_) {
+        shard.table.clear();
+      }
     }
     for (int64 i = 0; i < key_values.size(); ++i) {
       ValueArray value_vec;
@@ -189,8 +251,14 @@ class MutableHashTableOfTensors final : public LookupInterface {
         V value = value_values(i, j);
         value_vec.push_back(value);
       }
-      gtl::InsertOrUpdate(
-          &table_, SubtleMustCopyUnlessStringOrFloat(key_values(i)), value_vec);
+      const K key_value = SubtleMustCopyUnlessStringOrFloat(key_values(i));
+      Shard& shard = shards_[TableShard(key_value)];
+      if (clear) {
+        gtl::InsertOrUpdate(&shard.table, key_value, value_vec);
+      } else {
+        mutex_lock l(shard.mu);
+        gtl::InsertOrUpdate(&shard.table, key_value, value_vec);
+      }
     }
     return Status::OK();
   }
@@ -206,8 +274,11 @@ class MutableHashTableOfTensors final : public LookupInterface {
   }
 
   Status ExportValues(OpKernelContext* ctx) override {
-    mutex_lock l(mu_);
-    int64 size = table_.size();
+    std::vector<mutex_lock> locks = LockAllShards();
+    int64 size = 0;
+    for (const Shard& shard : shards_) {
+      size += shard.table.size();
+    }
     int64 value_dim = value_shape_.dim_size(0);
 
     Tensor* keys;
@@ -220,12 +291,13 @@ class MutableHashTableOfTensors final : public LookupInterface {
     auto keys_data = keys->flat<K>();
     auto values_data = values->matrix<V>();
     int64 i = 0;
-    for (auto it = table_.begin(); it != table_.end(); ++it, ++i) {
-      K key = it->first;
-      ValueArray value = it->second;
-      keys_data(i) = key;
-      for (int64 j = 0; j < value_dim; j++) {
-        values_data(i, j) = value[j];
+    for (const Shard& shard : shards_) {
+      for (auto it = shard.table.begin(); it != shard.table.end(); ++it, ++i) {
+        keys_data(i) = it->first;
+        const ValueArray& value = it->second;
+        for (int64 j = 0; j < value_dim; j++) {
+          values_data(i, j) = value[j];
+        }
       }
     }
     return Status::OK();
@@ -240,11 +312,25 @@ class MutableHashTableOfTensors final : public LookupInterface {
   TensorShape value_shape() const override { return value_shape_; }
 
  private:
-  TensorShape value_shape_;
-  // TODO(andreasst): consider using a read/write lock or a concurrent map
-  mutable mutex mu_;
   typedef gtl::InlinedVector<V, 4> ValueArray;
-  std::unordered_map<K, ValueArray> table_ GUARDED_BY(mu_);
+
+  struct Shard {
+    mutable mutex mu;
+    std::unordered_map<K, ValueArray> table GUARDED_BY(mu);
+  };
+
+  // Locks the shards in order, for operations on the whole table.
+  std::vector<mutex_lock> LockAllShards() const {
+    std::vector<mutex_lock> locks;
+    locks.reserve(kNumTableShards);
+    for (const Shard& shard : shards_) {
+      locks.emplace_back(shard.mu);
+    }
+    return locks;
+  }
+
+  TensorShape value_shape_;
+  std::array<Shard, kNumTableShards> shards_;
 };
 
 namespace {
@@ -256,6 +342,18 @@ inline uint64 HashScalar(const T& key) {
 
 inline uint64 HashScalar(const string& key) { return Hash64(key); }
 
+// Sets "hashes[i] = HashScalar(keys[i])" for i in [0, n).
+template <typename T>
+inline void HashScalars(const T* keys, int64 n, uint64* hashes) {
+  for (int64 i = 0; i < n; ++i) {
+    hashes[i] = HashScalar(keys[i]);
+  }
+}
+
+inline void HashScalars(const string* keys, int64 n, uint64* hashes) {
+  HashStrings<Hash64>(keys, n, hashes);
+}
+
 // If the given shape is a scalar return {1} instead. Otherwise leave it alone.
 TensorShape MaybeVectorizeShape(const TensorShape& shape) {
   if (shape.dims() == 0) {
@@ -264,9 +362,86 @@ TensorShape MaybeVectorizeShape(const TensorShape& shape) {
   return shape;
 }
 
+// A reader/writer lock. Writers are preferred: once a writer waits, new
+// readers wait for it, so that a steady stream of lookups cannot starve
+// inserts.
+class LOCKABLE ReaderWriterLock {
+ public:
+  void lock() EXCLUSIVE_LOCK_FUNCTION() {
+    mutex_lock l(mu_);
+    ++num_waiting_writers_;
+    while (has_writer_ || num_readers_ > 0) {
+      cv_.wait(l);
+    }
+    --num_waiting_writers_;
+    has_writer_ = true;
+  }
+
+  void unlock() UNLOCK_FUNCTION() {
+    mutex_lock l(mu_);
+    has_writer_ = false;
+    cv_.notify_all();
+  }
+
+  void lock_shared() SHARED_LOCK_FUNCTION() {
+    mutex_lock l(mu_);
+    while (has_writer_ || num_waiting_writers_ > 0) {
+      cv_.wait(l);
+    }
+    ++num_readers_;
+  }
+
+  void unlock_shared() UNLOCK_FUNCTION() {
+    mutex_lock l(mu_);
+    if (--num_readers_ == 0) {
+      cv_.notify_all();
+    }
+  }
+
+ private:
+  mutex mu_;
+  condition_variable cv_;
+  int num_readers_ = 0;
+  int num_waiting_writers_ = 0;
+  bool has_writer_ = false;
+};
+
+class SCOPED_LOCKABLE ReaderLock {
+ public:
+  explicit ReaderLock(ReaderWriterLock* mu) SHARED_LOCK_FUNCTION(mu)
+      : mu_(mu) {
+    mu_->lock_shared();
+  }
+  ~ReaderLock() UNLOCK_FUNCTION() { mu_->unlock_shared(); }
+
+ private:
+  ReaderWriterLock* const mu_;
+  TF_DISALLOW_COPY_AND_ASSIGN(ReaderLock);
+};
+
+class SCOPED_LOCKABLE WriterLock {
+ public:
+  explicit WriterLock(ReaderWriterLock* mu) EXCLUSIVE_LOCK_FUNCTION(mu)
+      : mu_(mu) {
+    mu_->lock();
+  }
+  ~WriterLock() UNLOCK_FUNCTION() { mu_->unlock(); }
+
+ private:
+  ReaderWriterLock* const mu_;
+  TF_DISALLOW_COPY_AND_ASSIGN(WriterLock);
+};
+
 }  // namespace
 
 // Modeled after densehashtable in https://github.com/sparsehash/sparsehash
+//
+// Find calls share the table's lock; Insert, ImportValues and ExportValues hold
+// it exclusively. When the table grows, the bigger buckets are allocated
+// without holding the lock, and the entries are then moved over incrementally:
+// each Insert moves a slice of the old buckets proportional to its size, and
+// lookups that miss in the new buckets fall back to the old ones until all of
+// them have been moved. This bounds the time an Insert holds the lock.
 template <class K, class V>
 class MutableDenseHashTable final : public LookupInterface {
  public:
@@ -304,11 +479,14 @@ class MutableDenseHashTable final : public LookupInterface {
     int64 initial_num_buckets;
     OP_REQUIRES_OK(ctx, GetNodeAttr(kernel->def(), "initial_num_buckets",
                                     &initial_num_buckets));
-    OP_REQUIRES_OK(ctx, AllocateBuckets(ctx, initial_num_buckets));
+    OP_REQUIRES_OK(ctx, AllocateBuckets(ctx, initial_num_buckets,
+                                        &key_buckets_, &value_buckets_));
+    num_buckets_ = initial_num_buckets;
+    num_entries_ = 0;
   }
 
   size_t size() const override LOCKS_EXCLUDED(mu_) {
-    mutex_lock l(mu_);
+    ReaderLock l(&mu_);
     return num_entries_;
   }
 
@@ -328,47 +506,76 @@ class MutableDenseHashTable final : public LookupInterface {
     auto value_matrix = value->shaped<V, 2>({num_elements, value_size});
     const auto default_flat = default_value.flat<V>();
 
-    mutex_lock l(mu_);
+    ReaderLock l(&mu_);
     const auto key_buckets_matrix =
         key_buckets_.AccessTensor(ctx)->template matrix<K>();
     const auto value_buckets_matrix =
         value_buckets_.AccessTensor(ctx)->template matrix<V>();
+    const bool growing = num_old_buckets_ > 0;
+    const auto old_key_buckets_matrix =
+        growing ? old_key_buckets_.AccessTensor(ctx)->template matrix<K>()
+                : key_buckets_matrix;
+    const auto old_value_buckets_matrix =
+        growing ? old_value_buckets_.AccessTensor(ctx)->template matrix<V>()
+                : value_buckets_matrix;
     const auto empty_key_matrix =
         empty_key_.AccessTensor(ctx)->template shaped<K, 2>({1, key_size});
-    const int64 bit_mask = num_buckets_ - 1;
     // TODO(andreasst): parallelize using work_sharder
-    for (int64 i = 0; i < num_elements; ++i) {
-      const uint64 key_hash = HashKey(key_matrix, i);
-      if (empty_key_hash_ == key_hash &&
-          IsEqualKey(empty_key_matrix, 0, key_matrix, i)) {
-        return errors::InvalidArgument(
-            "Using the empty_key as a table key is not allowed");
+    const int64 bit_mask = num_buckets_ - 1;
+    uint64 key_hashes[kHashBatchSize];
+    for (int64 begin = 0; begin < num_elements; begin += kHashBatchSize) {
+      const int64 end = std::min(num_elements, begin + kHashBatchSize);
+      // Hash the whole batch before probing, and prefetch the buckets the
+      // probes start at, so that their cache misses overlap.
+      if (key_size == 1) {
+        HashScalars(key_matrix.data() + begin, end - begin, key_hashes);
+      } else {
+        for (int64 i = begin; i < end; ++i) {
+          key_hashes[i - begin] = HashKey(key_matrix, i);
+        }
+      }
+      for (int64 i = begin; i < end; ++i) {
+        const int64 bucket_index = key_hashes[i - begin] & bit_mask;
+        port::prefetch<port::PREFETCH_HINT_T0>(
+            &key_buckets_matrix(bucket_index, 0));
+        port::prefetch<port::PREFETCH_HINT_T0>(
+            &value_buckets_matrix(bucket_index, 0));
       }
-      int64 bucket_index = key_hash & bit_mask;
-      int64 num_probes = 0;
-      while (true) {
-        if (IsEqualKey(key_buckets_matrix, bucket_index, key_matrix, i)) {
+      for (int64 i = begin; i < end; ++i) {
+        const uint64 key_hash = key_hashes[i - begin];
+        if (empty_key_hash_ == key_hash &&
+            IsEqualKey(empty_key_matrix, 0, key_matrix, i)) {
+          return errors::InvalidArgument(
+              "Using the empty_key as a table key is not allowed");
+        }
+        int64 bucket_index;
+        bool found;
+        TF_RETURN_IF_ERROR(FindBucket(key_buckets_matrix, num_buckets_,
+                                      key_matrix, i, key_hash,
+                                      empty_key_matrix, &bucket_index,
+                                      &found));
+        // Entries that haven't been moved yet are only in the old buckets.
+        const bool in_old_buckets = !found && growing;
+        if (in_old_buckets) {
+          TF_RETURN_IF_ERROR(FindBucket(old_key_buckets_matrix,
+                                        num_old_buckets_, key_matrix, i,
+                                        key_hash, empty_key_matrix,
+                                        &bucket_index, &found));
+        }
+        if (found) {
+          const auto& buckets_matrix =
+              in_old_buckets ? old_value_buckets_matrix : value_buckets_matrix;
           for (int64 j = 0; j < value_size; ++j) {
             // TODO(andreasst): check if we can get rid of SubtleMustCopy
             // here and elsewhere in this file.
             value_matrix(i, j) = SubtleMustCopyUnlessStringOrFloat(
-                value_buckets_matrix(bucket_index, j));
+                buckets_matrix(bucket_index, j));
           }
-          break;
-        }
-        if (IsEqualKey(key_buckets_matrix, bucket_index, empty_key_matrix, 0)) {
+        } else {
           for (int64 j = 0; j < value_size; ++j) {
             value_matrix(i, j) =
                 SubtleMustCopyUnlessStringOrFloat(default_flat(j));
           }
-          break;
-        }
-        ++num_probes;
-        bucket_index =
-            (bucket_index + num_probes) & bit_mask;  // quadratic probing
-        if (num_probes >= num_buckets_) {
-          return errors::Internal(
-              "Internal error in MutableDenseHashTable lookup");
         }
       }
     }
@@ -384,28 +591,65 @@ class MutableDenseHashTable final : public LookupInterface {
                                      expected_shape.DebugString(), " got ",
                                      key.shape().DebugString());
     }
-    mutex_lock l(mu_);
-    // For simplicity we assume that all keys in the input result in inserts
-    // rather than updates. That means we may grow the table even though we
-    // don't need to. As long as the number of keys inserted in one call is
-    // small compared to the size of the map, the impact of this is minimal.
-    const int64 pending_num_entries = num_entries_ + key.dim_size(0);
-    if (pending_num_entries > num_buckets_ * max_load_factor_) {
-      int64 new_num_buckets = num_buckets_;
-      do {
-        new_num_buckets <<= 1;
-      } while (pending_num_entries > new_num_buckets * max_load_factor_);
-      TF_RETURN_IF_ERROR(Rebucket(ctx, new_num_buckets));
+    const int64 num_inserts = key.dim_size(0);
+    while (true) {
+      int64 num_buckets;
+      int64 new_num_buckets;
+      {
+        WriterLock l(&mu_);
+        // For simplicity we assume that all keys in the input result in
+        // inserts rather than updates. That means we may grow the table even
+        // though we don't need to. As long as the number of keys inserted in
+        // one call is small compared to the size of the map, the impact of
+        // this is minimal.
+        const int64 pending_num_entries = num_entries_ + num_inserts;
+        if (pending_num_entries <= num_buckets_ * max_load_factor_) {
+          TF_RETURN_IF_ERROR(MoveOldBuckets(ctx, num_inserts));
+          return DoInsert(ctx, key, value);
+        }
+        // The previous growth must be complete before the next one starts.
+        // Each Insert moves enough buckets for this to be rare.
+        TF_RETURN_IF_ERROR(MoveOldBuckets(ctx, -1));
+        num_buckets = num_buckets_;
+        new_num_buckets = num_buckets_;
+        do {
+          new_num_buckets <<= 1;
+        } while (pending_num_entries > new_num_buckets * max_load_factor_);
+      }
+
+      // Allocate and clear the new buckets without the lock, so that the
+      // table keeps serving lookups meanwhile.
+      PersistentTensor new_key_buckets;
+      PersistentTensor new_value_buckets;
+      TF_RETURN_IF_ERROR(AllocateBuckets(ctx, new_num_buckets,
+                                         &new_key_buckets, &new_value_buckets));
+
+      WriterLock l(&mu_);
+      if (num_buckets_ != num_buckets || num_old_buckets_ > 0) {
+        // Another Insert or an ImportValues replaced the buckets meanwhile.
+        continue;
+      }
+      old_key_buckets_ = key_buckets_;
+      old_value_buckets_ = value_buckets_;
+      num_old_buckets_ = num_buckets_;
+      next_old_bucket_ = 0;
+      key_buckets_ = new_key_buckets;
+      value_buckets_ = new_value_buckets;
+      num_buckets_ = new_num_buckets;
+      TF_RETURN_IF_ERROR(MoveOldBuckets(ctx, num_inserts));
+      return DoInsert(ctx, key, value);
     }
-    return DoInsert(ctx, key, value, false);
   }
 
   Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
                       const Tensor& values) override LOCKS_EXCLUDED(mu_) {
-    mutex_lock l(mu_);
+    WriterLock l(&mu_);
     num_buckets_ = keys.dim_size(0);
     key_buckets_ = PersistentTensor(keys);
     value_buckets_ = PersistentTensor(values);
+    num_old_buckets_ = 0;
+    old_key_buckets_ = PersistentTensor();
+    old_value_buckets_ = PersistentTensor();
     // Count the number of keys that are not the empty_key. This requires
     // iterating through the whole table but that is OK as we only execute it
     // during checkpoint restore.
@@ -424,7 +668,10 @@ class MutableDenseHashTable final : public LookupInterface {
   }
 
   Status ExportValues(OpKernelContext* ctx) override LOCKS_EXCLUDED(mu_) {
-    mutex_lock l(mu_);
+    WriterLock l(&mu_);
+    // Exports are rare (they are used for checkpoints), so rather than
+    // merging the old and new buckets complete a pending growth.
+    TF_RETURN_IF_ERROR(MoveOldBuckets(ctx, -1));
     Tensor key_buckets_tensor = *key_buckets_.AccessTensor(ctx);
     Tensor value_buckets_tensor = *value_buckets_.AccessTensor(ctx);
     TF_RETURN_IF_ERROR(ctx->set_output("keys", key_buckets_tensor));
@@ -468,8 +715,43 @@ class MutableDenseHashTable final : public LookupInterface {
   TensorShape value_shape() const override { return value_shape_; }
 
  private:
-  Status DoInsert(OpKernelContext* ctx, const Tensor& key, const Tensor& value,
-                  bool ignore_empty_key) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  // The minimum number of old buckets moved by an Insert while the table
+  // grows.
+  static constexpr int64 kMinBucketsToMove = 1024;
+
+  // Probes "key_buckets", which has "num_buckets" buckets, for row "index" of
+  // "key". Sets "*bucket_index" to the bucket holding the key and "*found" to
+  // true, or "*bucket_index" to the empty bucket ending the probe sequence and
+  // "*found" to false.
+  template <typename KeyMatrix, typename EmptyKeyMatrix>
+  Status FindBucket(typename TTypes<K>::Matrix key_buckets, int64 num_buckets,
+                    KeyMatrix key, int64 index, uint64 key_hash,
+                    EmptyKeyMatrix empty_key, int64* bucket_index,
+                    bool* found) const {
+    const int64 bit_mask = num_buckets - 1;
+    *bucket_index = key_hash & bit_mask;
+    int64 num_probes = 0;
+    while (true) {
+      if (IsEqualKey(key_buckets, *bucket_index, key, index)) {
+        *found = true;
+        return Status::OK();
+      }
+      if (IsEqualKey(key_buckets, *bucket_index, empty_key, 0)) {
+        *found = false;
+        return Status::OK();
+      }
+      ++num_probes;
+      *bucket_index =
+          (*bucket_index + num_probes) & bit_mask;  // quadratic probing
+      if (num_probes >= num_buckets) {
+        return errors::Internal(
+            "Internal error in MutableDenseHashTable probe");
+      }
+    }
+  }
+
+  Status DoInsert(OpKernelContext* ctx, const Tensor& key, const Tensor& value)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
     const int64 num_elements = key.dim_size(0);
     const int64 value_size = value_shape_.num_elements();
     const int64 key_size = key_shape_.num_elements();
@@ -480,73 +762,130 @@ class MutableDenseHashTable final : public LookupInterface {
         key_buckets_.AccessTensor(ctx)->template matrix<K>();
     auto value_buckets_matrix =
         value_buckets_.AccessTensor(ctx)->template matrix<V>();
+    const bool growing = num_old_buckets_ > 0;
+    const auto old_key_buckets_matrix =
+        growing ? old_key_buckets_.AccessTensor(ctx)->template matrix<K>()
+                : key_buckets_matrix;
     const auto empty_key_tensor =
         empty_key_.AccessTensor(ctx)->template shaped<K, 2>({1, key_size});
-    const int64 bit_mask = num_buckets_ - 1;
     for (int64 i = 0; i < num_elements; ++i) {
       const uint64 key_hash = HashKey(key_matrix, i);
       if (empty_key_hash_ == key_hash &&
           IsEqualKey(empty_key_tensor, 0, key_matrix, i)) {
-        if (ignore_empty_key) {
-          continue;
-        }
         return errors::InvalidArgument(
             "Using the empty_key as a table key is not allowed");
       }
-      int64 bucket_index = key_hash & bit_mask;
-      int64 num_probes = 0;
-      while (true) {
-        if (IsEqualKey(key_buckets_matrix, bucket_index, key_matrix, i)) {
-          for (int64 j = 0; j < value_size; ++j) {
-            value_buckets_matrix(bucket_index, j) =
-                SubtleMustCopyUnlessStringOrFloat(value_matrix(i, j));
-          }
-          break;
+      int64 bucket_index;
+      bool found;
+      TF_RETURN_IF_ERROR(FindBucket(key_buckets_matrix, num_buckets_,
+                                    key_matrix, i, key_hash, empty_key_tensor,
+                                    &bucket_index, &found));
+      if (!found) {
+        // A key that is still in the old buckets is moved, not added.
+        int64 old_bucket_index;
+        bool found_old = false;
+        if (growing) {
+          TF_RETURN_IF_ERROR(FindBucket(old_key_buckets_matrix,
+                                        num_old_buckets_, key_matrix, i,
+                                        key_hash, empty_key_tensor,
+                                        &old_bucket_index, &found_old));
         }
-        if (IsEqualKey(key_buckets_matrix, bucket_index, empty_key_tensor, 0)) {
+        if (!found_old) {
           ++num_entries_;
-          for (int64 j = 0; j < key_size; ++j) {
-            key_buckets_matrix(bucket_index, j) =
-                SubtleMustCopyUnlessStringOrFloat(key_matrix(i, j));
-          }
-          for (int64 j = 0; j < value_size; ++j) {
-            value_buckets_matrix(bucket_index, j) =
-                SubtleMustCopyUnlessStringOrFloat(value_matrix(i, j));
-          }
-          break;
         }
-        ++num_probes;
-        bucket_index =
-            (bucket_index + num_probes) & bit_mask;  // quadratic probing
-        if (num_probes >= num_buckets_) {
-          return errors::Internal(
-              "Internal error in MutableDenseHashTable insert");
+        for (int64 j = 0; j < key_size; ++j) {
+          key_buckets_matrix(bucket_index, j) =
+              SubtleMustCopyUnlessStringOrFloat(key_matrix(i, j));
         }
       }
+      for (int64 j = 0; j < value_size; ++j) {
+        value_buckets_matrix(bucket_index, j) =
+            SubtleMustCopyUnlessStringOrFloat(value_matrix(i, j));
+      }
     }
     return Status::OK();
   }
 
-  Status AllocateBuckets(OpKernelContext* ctx, int64 new_num_buckets)
+  // Moves the entries of the next old buckets that aren't in the new buckets
+  // yet, while the table grows. An Insert of "num_inserts" keys moves enough
+  // buckets for the growth to complete before the new buckets fill up; a
+  // negative "num_inserts" moves all the remaining ones.
+  Status MoveOldBuckets(OpKernelContext* ctx, int64 num_inserts)
       EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    if (new_num_buckets < 4 ||
-        ((new_num_buckets & (new_num_buckets - 1)) != 0)) {
+    if (num_old_buckets_ == 0) {
+      return Status::OK();
+    }
+    int64 end = num_old_buckets_;
+    if (num_inserts >= 0) {
+      const int64 num_to_move =
+          std::max(kMinBucketsToMove,
+                   static_cast<int64>(2 * num_inserts / max_load_factor_));
+      end = std::min(end, next_old_bucket_ + num_to_move);
+    }
+
+    const int64 value_size = value_shape_.num_elements();
+    const int64 key_size = key_shape_.num_elements();
+    auto key_buckets_matrix =
+        key_buckets_.AccessTensor(ctx)->template matrix<K>();
+    auto value_buckets_matrix =
+        value_buckets_.AccessTensor(ctx)->template matrix<V>();
+    auto old_key_buckets_matrix =
+        old_key_buckets_.AccessTensor(ctx)->template matrix<K>();
+    const auto old_value_buckets_matrix =
+        old_value_buckets_.AccessTensor(ctx)->template matrix<V>();
+    const auto empty_key_tensor =
+        empty_key_.AccessTensor(ctx)->template shaped<K, 2>({1, key_size});
+    for (; next_old_bucket_ < end; ++next_old_bucket_) {
+      const int64 i = next_old_bucket_;
+      if (IsEqualKey(old_key_buckets_matrix, i, empty_key_tensor, 0)) {
+        continue;
+      }
+      int64 bucket_index;
+      bool found;
+      TF_RETURN_IF_ERROR(FindBucket(
+          key_buckets_matrix, num_buckets_, old_key_buckets_matrix, i,
+          HashKey(old_key_buckets_matrix, i), empty_key_tensor, &bucket_index,
+          &found));
+      // A key found in the new buckets was inserted again since the growth
+      // started, and its old value is stale.
+      if (found) continue;
+      for (int64 j = 0; j < key_size; ++j) {
+        key_buckets_matrix(bucket_index, j) =
+            SubtleMustCopyUnlessStringOrFloat(old_key_buckets_matrix(i, j));
+      }
+      for (int64 j = 0; j < value_size; ++j) {
+        value_buckets_matrix(bucket_index, j) =
+            SubtleMustCopyUnlessStringOrFloat(old_value_buckets_matrix(i, j));
+      }
+    }
+    if (next_old_bucket_ == num_old_buckets_) {
+      num_old_buckets_ = 0;
+      old_key_buckets_ = PersistentTensor();
+      old_value_buckets_ = PersistentTensor();
+    }
+    return Status::OK();
+  }
+
+  // Allocates "num_buckets" empty buckets. Does not touch the table's state,
+  // so it can run without holding mu_.
+  Status AllocateBuckets(OpKernelContext* ctx, int64 num_buckets,
+                         PersistentTensor* key_buckets,
+                         PersistentTensor* value_buckets) {
+    if (num_buckets < 4 || ((num_buckets & (num_buckets - 1)) != 0)) {
       return errors::InvalidArgument(
           "Number of buckets must be at least 4 and a power of 2, got: ",
-          new_num_buckets);
+          num_buckets);
     }
-    num_buckets_ = new_num_buckets;
-    num_entries_ = 0;
 
     const int64 key_size = key_shape_.num_elements();
     Tensor* key_buckets_tensor;
     TF_RETURN_IF_ERROR(ctx->allocate_persistent(
-        key_dtype(), TensorShape({num_buckets_, key_size}), &key_buckets_,
+        key_dtype(), TensorShape({num_buckets, key_size}), key_buckets,
         &key_buckets_tensor));
     auto key_buckets_matrix = key_buckets_tensor->matrix<K>();
     const auto empty_key_flat =
         empty_key_.AccessTensor(ctx)->template flat<K>();
-    for (int64 i = 0; i < num_buckets_; ++i) {
+    for (int64 i = 0; i < num_buckets; ++i) {
       for (int64 j = 0; j < key_size; ++j) {
         key_buckets_matrix(i, j) = empty_key_flat(j);
       }
@@ -555,10 +894,10 @@ class MutableDenseHashTable final : public LookupInterface {
     const int64 value_size = value_shape_.num_elements();
     Tensor* value_buckets_tensor;
     TF_RETURN_IF_ERROR(ctx->allocate_persistent(
-        value_dtype(), TensorShape({num_buckets_, value_size}), &value_buckets_,
+        value_dtype(), TensorShape({num_buckets, value_size}), value_buckets,
         &value_buckets_tensor));
     auto value_buckets_matrix = value_buckets_tensor->matrix<V>();
-    for (int64 i = 0; i < num_buckets_; ++i) {
+    for (int64 i = 0; i < num_buckets; ++i) {
       for (int64 j = 0; j < value_size; ++j) {
         // Initialize values to the default value for the type to avoid
         // exposing uninitialized memory in ExportValues().
@@ -568,15 +907,8 @@ class MutableDenseHashTable final : public LookupInterface {
     return Status::OK();
   }
 
-  Status Rebucket(OpKernelContext* ctx, int64 num_new_buckets)
-      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
-    Tensor old_key_buckets = *key_buckets_.AccessTensor(ctx);
-    Tensor old_value_buckets = *value_buckets_.AccessTensor(ctx);
-    TF_RETURN_IF_ERROR(AllocateBuckets(ctx, num_new_buckets));
-    return DoInsert(ctx, old_key_buckets, old_value_buckets, true);
-  }
-
-  uint64 HashKey(typename TTypes<K>::ConstMatrix key, int64 index) const {
+  template <typename KeyMatrix>
+  uint64 HashKey(KeyMatrix key, int64 index) const {
     if (key_shape_.num_elements() == 1) {
       return HashScalar(key(index, 0));
     }
@@ -603,15 +935,184 @@ class MutableDenseHashTable final : public LookupInterface {
   TensorShape key_shape_;
   TensorShape value_shape_;
   float max_load_factor_;
-  mutable mutex mu_;
+  mutable ReaderWriterLock mu_;
   int64 num_entries_ GUARDED_BY(mu_);
   int64 num_buckets_ GUARDED_BY(mu_);
   PersistentTensor key_buckets_ GUARDED_BY(mu_);
   PersistentTensor value_buckets_ GUARDED_BY(mu_);
+  // While the table grows, the previous buckets, of which those before
+  // next_old_bucket_ have been moved to key_buckets_ and value_buckets_.
+  // num_old_buckets_ is 0 otherwise.
+  int64 num_old_buckets_ GUARDED_BY(mu_) = 0;
+  int64 next_old_bucket_ GUARDED_BY(mu_) = 0;
+  PersistentTensor old_key_buckets_ GUARDED_BY(mu_);
+  PersistentTensor old_value_buckets_ GUARDED_BY(mu_);
   PersistentTensor empty_key_;
   uint64 empty_key_hash_;
 };
 
+template <class K, class V>
+constexpr int64 MutableDenseHashTable<K, V>::kMinBucketsToMove;
+
+namespace {
+
+// The key of a MappedHashTableReader lookup.
+inline StringPiece MappedKey(const string& key) { return key; }
+inline int64 MappedKey(int64 key) { return key; }
+inline int64 MappedKey(int32 key) { return key; }
+
+inline uint64 MappedStringHash(const string& key) {
+  return MappedHashTableReader::Hash(key);
+}
+
+// Sets "hashes[i] = MappedHashTableReader::Hash(MappedKey(keys[i]))" for i in
+// [0, n).
+inline void MappedKeyHashes(const string* keys, int64 n, uint64* hashes) {
+  HashStrings<MappedStringHash>(keys, n, hashes);
+}
+
+template <typename K>
+inline void MappedKeyHashes(const K* keys, int64 n, uint64* hashes) {
+  for (int64 i = 0; i < n; ++i) {
+    hashes[i] = MappedHashTableReader::Hash(MappedKey(keys[i]));
+  }
+}
+
+// Reads the value of a MappedHashTableReader bucket.
+inline Status MappedValue(const MappedHashTableReader& reader,
+                          const MappedHashTableBucket& bucket, string* value) {
+  StringPiece piece;
+  TF_RETURN_IF_ERROR(reader.StringValue(bucket, &piece));
+  value->assign(piece.data(), piece.size());
+  return Status::OK();
+}
+
+inline Status MappedValue(const MappedHashTableReader& reader,
+                          const MappedHashTableBucket& bucket, int64* value) {
+  *value = reader.Int64Value(bucket);
+  return Status::OK();
+}
+
+inline Status MappedValue(const MappedHashTableReader& reader,
+                          const MappedHashTableBucket& bucket, int32* value) {
+  *value = static_cast<int32>(reader.Int64Value(bucket));
+  return Status::OK();
+}
+
+inline Status MappedValue(const MappedHashTableReader& reader,
+                          const MappedHashTableBucket& bucket, bool* value) {
+  *value = reader.Int64Value(bucket) != 0;
+  return Status::OK();
+}
+
+inline Status MappedValue(const MappedHashTableReader& reader,
+                          const MappedHashTableBucket& bucket, double* value) {
+  *value = reader.DoubleValue(bucket);
+  return Status::OK();
+}
+
+inline Status MappedValue(const MappedHashTableReader& reader,
+                          const MappedHashTableBucket& bucket, float* value) {
+  *value = static_cast<float>(reader.DoubleValue(bucket));
+  return Status::OK();
+}
+
+}  // namespace
+
+// Immutable lookup table backed by a file in the MappedHashTableReader format,
+// e.g. built by tensorflow/contrib/util:build_mapped_hash_table. The file is
+// memory mapped rather than loaded, so creating the table takes constant time
+// and its pages are shared by all the processes of a host using it.
+//
+// Sample use case:
+//
+// MappedHashTable<string, int64> table;  // Given the file name as input.
+// table.Find(in_t, &out_t, default_t)
+//
+template <class K, class V>
+class MappedHashTable final : public LookupInterface {
+ public:
+  MappedHashTable(OpKernelContext* ctx, OpKernel* kernel) {
+    const Tensor* filename_input;
+    OP_REQUIRES_OK(ctx, ctx->input("filename", &filename_input));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(filename_input->shape()),
+                errors::InvalidArgument("filename must be a scalar, got shape ",
+                                        filename_input->shape().DebugString()));
+    const string& filename = filename_input->scalar<string>()();
+    OP_REQUIRES_OK(ctx,
+                   MappedHashTableReader::Open(ctx->env(), filename, &reader_));
+    OP_REQUIRES(
+        ctx,
+        reader_->key_dtype() == key_dtype() &&
+            reader_->value_dtype() == value_dtype(),
+        errors::InvalidArgument(
+            "Mapped hash table ", filename, " maps ",
+            DataTypeString(reader_->key_dtype()), " to ",
+            DataTypeString(reader_->value_dtype()), ", expected ",
+            DataTypeString(key_dtype()), " to ",
+            DataTypeString(value_dtype())));
+  }
+
+  size_t size() const override { return reader_->size(); }
+
+  Status Find(OpKernelContext* ctx, const Tensor& key, Tensor* value,
+              const Tensor& default_value) override {
+    const V default_val = default_value.flat<V>()(0);
+    const auto key_values = key.flat<K>();
+    auto value_values = value->flat<V>();
+
+    const int64 num_keys = key_values.size();
+    uint64 key_hashes[kHashBatchSize];
+    for (int64 begin = 0; begin < num_keys; begin += kHashBatchSize) {
+      const int64 end = std::min(num_keys, begin + kHashBatchSize);
+      // Hash the whole batch before probing, and prefetch the buckets the
+      // probes start at, so that their cache misses overlap.
+      MappedKeyHashes(key_values.data() + begin, end - begin, key_hashes);
+      for (int64 i = 0; i < end - begin; ++i) {
+        reader_->Prefetch(key_hashes[i]);
+      }
+      for (int64 i = begin; i < end; ++i) {
+        const MappedHashTableBucket* bucket;
+        TF_RETURN_IF_ERROR(reader_->FindWithHash(
+            MappedKey(key_values(i)), key_hashes[i - begin], &bucket));
+        if (bucket == nullptr) {
+          value_values(i) = default_val;
+        } else {
+          TF_RETURN_IF_ERROR(
+              MappedValue(*reader_, *bucket, &value_values(i)));
+        }
+      }
+    }
+    return Status::OK();
+  }
+
+  Status Insert(OpKernelContext* ctx, const Tensor& keys,
+                const Tensor& values) override {
+    return errors::Unimplemented("MappedHashTable is immutable");
+  }
+
+  Status ExportValues(OpKernelContext* ctx) override {
+    return errors::Unimplemented("ExportValues not supported by "
+                                 "MappedHashTable");
+  }
+
+  Status ImportValues(OpKernelContext* ctx, const Tensor& keys,
+                      const Tensor& values) override {
+    return errors::Unimplemented("MappedHashTable is immutable");
+  }
+
+  DataType key_dtype() const override { return DataTypeToEnum<K>::v(); }
+
+  DataType value_dtype() const override { return DataTypeToEnum<V>::v(); }
+
+  TensorShape key_shape() const final { return TensorShape(); }
+
+  TensorShape value_shape() const override { return TensorShape(); }
+
+ private:
+  std::unique_ptr<MappedHashTableReader> reader_;
+};
+
 }  // namespace lookup
 
 // Table lookup op. Perform the lookup operation on the given table.
@@ -870,4 +1371,26 @@ REGISTER_KERNEL(int64, bool);
 
 #undef REGISTER_KERNEL
 
+// Register the MappedHashTable op.
+#define REGISTER_KERNEL(key_dtype, value_dtype)                            \
+  REGISTER_KERNEL_BUILDER(                                                 \
+      Name("MappedHashTableV2")                                            \
+          .Device(DEVICE_CPU)                                              \
+          .TypeConstraint<key_dtype>("key_dtype")                          \
+          .TypeConstraint<value_dtype>("value_dtype"),                     \
+      LookupTableOp<lookup::MappedHashTable<key_dtype, value_dtype>,       \
+                    key_dtype, value_dtype>)
+
+REGISTER_KERNEL(string, double);
+REGISTER_KERNEL(string, float);
+REGISTER_KERNEL(string, int32);
+REGISTER_KERNEL(string, int64);
+REGISTER_KERNEL(string, string);
+REGISTER_KERNEL(string, bool);
+REGISTER_KERNEL(int64, string);
+REGISTER_KERNEL(int64, int64);
+REGISTER_KERNEL(int64, float);
+
+#undef REGISTER_KERNEL
+
 }  // namespace tensorflow
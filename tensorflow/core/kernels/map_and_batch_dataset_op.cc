@@ -0,0 +1,395 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <deque>
+
+#include "tensorflow/core/kernels/dataset.h"
+
+#include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/captured_function.h"
+#include "tensorflow/core/kernels/dataset_utils.h"
+
+namespace tensorflow {
+
+namespace {
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class MapAndBatchDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit MapAndBatchDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx),
+        graph_def_version_(ctx->graph_def_version()) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("f", &func_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    OpInputList inputs;
+    OP_REQUIRES_OK(ctx, ctx->input_list("other_arguments", &inputs));
+    std::vector<Tensor> other_arguments;
+    other_arguments.reserve(inputs.size());
+    for (const Tensor& t : inputs) {
+      other_arguments.push_back(t);
+    }
+
+    int64 batch_size;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument<int64>(ctx, "batch_size", &batch_size));
+    OP_REQUIRES(
+        ctx, batch_size > 0,
+        errors::InvalidArgument("batch_size must be greater than zero."));
+
+    int32 num_threads;
+    OP_REQUIRES_OK(
+        ctx, ParseScalarArgument<int32>(ctx, "num_threads", &num_threads));
+    OP_REQUIRES(
+        ctx, num_threads > 0,
+        errors::InvalidArgument("num_threads must be greater than zero."));
+
+    int64 num_parallel_batches;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "num_parallel_batches",
+                                                   &num_parallel_batches));
+    OP_REQUIRES(ctx, num_parallel_batches > 0,
+                errors::InvalidArgument(
+                    "num_parallel_batches must be greater than zero."));
+
+    std::unique_ptr<CapturedFunction> captured_func;
+    OP_REQUIRES_OK(ctx, CapturedFunction::Create(ctx, func_, graph_def_version_,
+                                                 std::move(other_arguments),
+                                                 &captured_func));
+
+    *output = new Dataset(input, batch_size, num_threads, num_parallel_batches,
+                          output_types_, output_shapes_,
+                          std::move(captured_func));
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(const DatasetBase* input, int64 batch_size, int32 num_threads,
+            int64 num_parallel_batches, const DataTypeVector& output_types,
+            const std::vector<PartialTensorShape>& output_shapes,
+            std::unique_ptr<CapturedFunction> captured_func)
+        : input_(input),
+          batch_size_(batch_size),
+          num_threads_(num_threads),
+          num_parallel_batches_(num_parallel_batches),
+          output_types_(output_types),
+          output_shapes_(output_shapes),
+          captured_func_(std::move(captured_func)) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal() const override {
+      return std::unique_ptr<IteratorBase>(new Iterator(this));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return output_types_;
+    }
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() override { return "MapAndBatchDatasetOp::Dataset"; }
+
+   private:
+    // The iterator fills up to `num_parallel_batches` batches at a time,
+    // using `num_threads` mapper threads. Each mapper thread takes the
+    // next input element and the next slot in the batch being filled,
+    // applies `f` to the element, and copies the result into its slot of
+    // the batch tensors. The batch tensors are allocated by the first
+    // call to finish, using the shapes of its results, so no mapped
+    // element is buffered on its own and the copies run in parallel.
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset),
+            input_impl_(dataset->input_->MakeIterator()) {}
+
+      ~Iterator() override {
+        // Signal the mapper threads, if any, so that they terminate.
+        // We will then join those threads when we delete
+        // `this->mapper_threads_`.
+        {
+          mutex_lock l(mu_);
+          cancelled_ = true;
+          cond_var_.notify_all();
+        }
+        mapper_threads_.clear();
+      }
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        EnsureMapperThreadsStarted(ctx);
+        while (true) {
+          // Wait until the oldest batch is complete, or the input is
+          // exhausted.
+          while (!cancelled_ && !(batches_.empty() && end_of_input_) &&
+                 (batches_.empty() || !IsComplete(batches_.front()))) {
+            cond_var_.wait(l);
+          }
+
+          if (cancelled_) {
+            return errors::Cancelled(
+                "MapAndBatchDatasetOp::Dataset::Iterator::GetNext");
+          }
+
+          if (batches_.empty()) {
+            *end_of_sequence = true;
+            return Status::OK();
+          }
+
+          BatchResult result = std::move(batches_.front());
+          batches_.pop_front();
+          // Wake the mapper threads, in case they have been waiting for
+          // a batch to fill.
+          cond_var_.notify_all();
+
+          if (!result.status.ok()) {
+            // Drop the batch, since some of its slices are missing.
+            *end_of_sequence = false;
+            return result.status;
+          }
+          if (result.num_elements == 0) {
+            // The input was exhausted before any element of this batch
+            // was assigned.
+            continue;
+          }
+
+          for (Tensor& component : result.output) {
+            if (result.num_elements < dataset()->batch_size_) {
+              // The final batch has fewer elements than `batch_size`.
+              component = component.Slice(0, result.num_elements);
+            }
+            out_tensors->emplace_back(std::move(component));
+          }
+          *end_of_sequence = false;
+          return Status::OK();
+        }
+      }
+
+     private:
+      // A batch that is being filled by the mapper threads.
+      struct BatchResult {
+        // The number of input elements assigned to this batch.
+        int64 num_elements = 0;
+        // The number of assigned elements whose results have not been
+        // copied into `output` yet.
+        int64 num_calls = 0;
+        // The first error from getting an input element or applying the
+        // function to it.
+        Status status;
+        // One tensor per tuple component, whose 0th dimension is
+        // `batch_size`. Empty until the first call finishes.
+        std::vector<Tensor> output;
+      };
+
+      bool IsComplete(const BatchResult& result) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        return result.num_calls == 0 &&
+               (result.num_elements == dataset()->batch_size_ ||
+                end_of_input_);
+      }
+
+      bool NeedsNewBatch() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        return batches_.empty() ||
+               batches_.back().num_elements == dataset()->batch_size_;
+      }
+
+      void EnsureMapperThreadsStarted(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (mapper_threads_.empty()) {
+          // `ctx` is only valid for the duration of this call, so the
+          // mapper threads use a copy of it, including its runner for
+          // the function.
+          IteratorContext::Params params;
+          params.env = ctx->env();
+          params.resource_manager = ctx->resource_manager();
+          params.runner = *(ctx->runner());
+          iter_ctx_.reset(new IteratorContext(std::move(params)));
+
+          f_opts_.step_id = dataset::NewFunctionStepId();
+          f_opts_.runner = iter_ctx_->runner();
+
+          for (int i = 0; i < dataset()->num_threads_; ++i) {
+            mapper_threads_.emplace_back(
+                std::unique_ptr<Thread>(ctx->env()->StartThread(
+                    {}, "map_and_batch_thread", [this]() { MapperThread(); })));
+          }
+        }
+      }
+
+      void MapperThread() {
+        while (true) {
+          BatchResult* result;
+          int64 index;
+          std::vector<Tensor> input_args;
+
+          // 1. Acquire the next slot in a batch and the corresponding
+          // input element.
+          {
+            // Only one MapperThread may call GetNext() on the input
+            // iterator at a time, to preserve the ordering of elements.
+            mutex_lock input_lock(input_mu_);
+            {
+              // Wait while every batch in flight has all of its slots
+              // assigned.
+              mutex_lock l(mu_);
+              while (!cancelled_ && !end_of_input_ && NeedsNewBatch() &&
+                     batches_.size() == dataset()->num_parallel_batches_) {
+                cond_var_.wait(l);
+              }
+              if (cancelled_ || end_of_input_) {
+                return;
+              }
+              if (NeedsNewBatch()) {
+                batches_.emplace_back();
+              }
+              result = &batches_.back();
+              index = result->num_elements++;
+              ++result->num_calls;
+            }
+
+            bool end_of_sequence = false;
+            Status s = input_impl_->GetNext(iter_ctx_.get(), &input_args,
+                                            &end_of_sequence);
+            if (!s.ok() || end_of_sequence) {
+              mutex_lock l(mu_);
+              if (s.ok()) {
+                // Give back the slot, so that the batch ends before it.
+                --result->num_elements;
+                end_of_input_ = true;
+              } else {
+                result->status.Update(s);
+              }
+              --result->num_calls;
+              cond_var_.notify_all();
+              if (end_of_input_) {
+                return;
+              }
+              continue;
+            }
+          }
+
+          // 2. Apply the function and copy its results into the batch.
+          std::vector<Tensor> return_values;
+          Status s = dataset()->captured_func_->Run(f_opts_, input_args,
+                                                    &return_values);
+          if (s.ok()) {
+            s = AllocateOutput(result, return_values);
+          }
+          for (size_t i = 0; s.ok() && i < return_values.size(); ++i) {
+            // Concurrent calls write disjoint slices of `result->output`,
+            // which is not modified once allocated.
+            s = dataset::CopyElementToSlice(return_values[i],
+                                            &result->output[i], index);
+          }
+
+          // 3. Signal that the element has been produced.
+          {
+            mutex_lock l(mu_);
+            result->status.Update(s);
+            --result->num_calls;
+            cond_var_.notify_all();
+          }
+        }
+      }
+
+      // Allocates the tensors of `result` using the shapes of
+      // `return_values` if this is the first call to finish, and
+      // otherwise checks that `return_values` match them.
+      Status AllocateOutput(BatchResult* result,
+                            const std::vector<Tensor>& return_values) {
+        mutex_lock l(mu_);
+        if (result->output.empty()) {
+          if (return_values.size() != dataset()->output_types_.size()) {
+            return errors::InvalidArgument(
+                "`f` returned ", return_values.size(),
+                " components, but expected ", dataset()->output_types_.size());
+          }
+          result->output.reserve(return_values.size());
+          for (const Tensor& t : return_values) {
+            TensorShape batch_component_shape({dataset()->batch_size_});
+            batch_component_shape.AppendShape(t.shape());
+            result->output.emplace_back(cpu_allocator(), t.dtype(),
+                                        batch_component_shape);
+          }
+          return Status::OK();
+        }
+
+        if (return_values.size() != result->output.size()) {
+          return errors::InvalidArgument(
+              "`f` returned ", return_values.size(),
+              " components, but expected ", result->output.size());
+        }
+        for (size_t i = 0; i < return_values.size(); ++i) {
+          TensorShape element_shape = result->output[i].shape();
+          element_shape.RemoveDim(0);
+          if (return_values[i].dtype() != result->output[i].dtype() ||
+              return_values[i].shape() != element_shape) {
+            return errors::InvalidArgument(
+                "Cannot batch tensors with different shapes in component ", i,
+                ". First element had shape ", element_shape.DebugString(),
+                " and element ", return_values[i].shape().DebugString());
+          }
+        }
+        return Status::OK();
+      }
+
+      mutex input_mu_;
+      const std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(input_mu_);
+      std::unique_ptr<IteratorContext> iter_ctx_;
+      FunctionLibraryRuntime::Options f_opts_;
+      mutex mu_;
+      condition_variable cond_var_;
+      // `BatchResult` pointers held by the mapper threads remain valid
+      // while batches are appended and removed at the ends of the deque.
+      std::deque<BatchResult> batches_ GUARDED_BY(mu_);
+      bool end_of_input_ GUARDED_BY(mu_) = false;
+      bool cancelled_ GUARDED_BY(mu_) = false;
+      // Declared last so that the threads are joined before the state
+      // they use is destroyed.
+      std::vector<std::unique_ptr<Thread>> mapper_threads_;
+    };
+
+    const DatasetBase* const input_;
+    const int64 batch_size_;
+    const int32 num_threads_;
+    const int64 num_parallel_batches_;
+    const DataTypeVector output_types_;
+    const std::vector<PartialTensorShape> output_shapes_;
+    const std::unique_ptr<CapturedFunction> captured_func_;
+  };
+
+  const int graph_def_version_;
+  DataTypeVector output_types_;
+  std::vector<PartialTensorShape> output_shapes_;
+  const NameAttrList* func_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("MapAndBatchDataset").Device(DEVICE_CPU),
+                        MapAndBatchDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
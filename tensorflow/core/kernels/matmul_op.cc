@@ -19,10 +19,18 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/matmul_op.h"
 
+#include "tensorflow/core/framework/bfloat16.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/kernels/bias_activation_functor.h"
+#include "tensorflow/core/kernels/constant_op.h"
+#include "tensorflow/core/kernels/cpu_isa_dispatch.h"
 #include "tensorflow/core/kernels/fill_functor.h"
+#include "tensorflow/core/kernels/matmul_op_isa.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 #if GOOGLE_CUDA
 #include "cuda/include/cuda.h"
@@ -145,6 +153,260 @@ struct LaunchMatMulBase {
 template <typename T>
 struct LaunchMatMulCPU : LaunchMatMulBase<CPUDevice, T> {};
 
+// Keeps the 'b' operand of a MatMul packed for the MatMulFloatPacked kernels
+// (see matmul_op_isa.h) while it is the same constant, so that it isn't
+// repacked at every step. The cache holds a reference to 'b', so that its
+// buffer can't be reused for another tensor.
+class MatMulPackedRhsCache {
+ public:
+  MatMulPackedRhsCache() {}
+
+  // Sets 'packed_b' to op(b) packed, packing it at the first call for 'b'.
+  // Returns false if 'b' isn't the value of a Const op, since other tensors
+  // may be updated in place, e.g. variables.
+  bool Get(OpKernelContext* ctx, const Tensor& b, bool transpose_b,
+           Tensor* packed_b);
+
+ private:
+  mutex mu_;
+  Tensor b_ GUARDED_BY(mu_);
+  PersistentTensor packed_b_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MatMulPackedRhsCache);
+};
+
+// Runs MatMul with the packed form of a constant 'b' from 'cache'. Returns
+// false if that isn't possible, and does nothing then.
+template <typename Device, typename T>
+struct LaunchMatMulPacked {
+  static bool Run(
+      OpKernelContext* ctx, const Tensor& a, const Tensor& b,
+      const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair,
+      MatMulPackedRhsCache* cache, Tensor* out) {
+    return false;
+  }
+};
+
+namespace {
+// The packed kernels split 'a' by blocks of this many rows, as well as 'b' by
+// column blocks, to have enough work for all the threads.
+const int64 kMatMulPackedRowBlock = 64;
+
+// Computes the m x n 'out' = op(a) * op(b) with 'matmul' on the CPU worker
+// threads, op(b) being k x n and packed into 'packed_b' by the MatMulFloatPackB
+// kernel of the same build as 'matmul'.
+void MatMulFloatPackedInParallel(OpKernelContext* ctx,
+                                 MatMulFloatPackedIsaFn matmul, const Tensor& a,
+                                 bool transpose_a, const Tensor& packed_b,
+                                 int64 m, int64 n, int64 k, Tensor* out) {
+  const int64 lda = a.dim_size(1);
+  const float* a_data = a.flat<float>().data();
+  const float* packed_b_data = packed_b.flat<float>().data();
+  float* out_data = out->flat<float>().data();
+  const int64 num_row_blocks =
+      (m + kMatMulPackedRowBlock - 1) / kMatMulPackedRowBlock;
+  const int64 num_col_blocks =
+      (n + kMatMulFloatPackedBlockCols - 1) / kMatMulFloatPackedBlockCols;
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *(ctx->device()->tensorflow_cpu_worker_threads());
+  // Work units are ordered by row block, to pack each block of 'a' once in
+  // most shards.
+  Shard(worker_threads.num_threads, worker_threads.workers,
+        num_row_blocks * num_col_blocks,
+        kMatMulPackedRowBlock * kMatMulFloatPackedBlockCols * k,
+        [&](int64 start, int64 limit) {
+          while (start < limit) {
+            const int64 row_block = start / num_col_blocks;
+            const int64 col_block = start % num_col_blocks;
+            const int64 col_limit =
+                std::min(num_col_blocks, col_block + limit - start);
+            const int64 row = row_block * kMatMulPackedRowBlock;
+            const int64 rows = std::min(kMatMulPackedRowBlock, m - row);
+            matmul(rows, n, k, transpose_a ? a_data + row : a_data + row * lda,
+                   lda, transpose_a, packed_b_data, col_block, col_limit,
+                   out_data + row * n, n);
+            start += col_limit - col_block;
+          }
+        });
+}
+}  // namespace
+
+#ifndef TENSORFLOW_USE_LIBXSMM
+namespace {
+// Runs the float MatMul kernel compiled for the most capable instruction set
+// of this CPU (see cpu_isa_dispatch.h), splitting the longer dimension of the
+// output across the CPU worker threads. Returns false if the binary has no
+// such kernel for this CPU, or for matrix-vector products, which
+// LaunchMatMulBase handles better.
+bool LaunchMatMulFloatIsa(
+    OpKernelContext* ctx, const Tensor& a, const Tensor& b,
+    const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair,
+    Tensor* out) {
+  static const MatMulFloatIsaFn matmul =
+      LookupCpuIsaFunction<MatMulFloatIsaFn>(kMatMulFloatIsaFunction);
+  const int64 m = out->dim_size(0);
+  const int64 n = out->dim_size(1);
+  if (matmul == nullptr || m == 1 || n == 1) {
+    return false;
+  }
+  const bool transpose_a = dim_pair[0].first == 0;
+  const bool transpose_b = dim_pair[0].second == 1;
+  const int64 k = a.dim_size(dim_pair[0].first);
+  const int64 lda = a.dim_size(1);
+  const int64 ldb = b.dim_size(1);
+  const float* a_data = a.flat<float>().data();
+  const float* b_data = b.flat<float>().data();
+  float* out_data = out->flat<float>().data();
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *(ctx->device()->tensorflow_cpu_worker_threads());
+  if (m >= n) {
+    Shard(worker_threads.num_threads, worker_threads.workers, m, n * k,
+          [&](int64 start, int64 limit) {
+            matmul(limit - start, n, k,
+                   transpose_a ? a_data + start : a_data + start * lda, lda,
+                   transpose_a, b_data, ldb, transpose_b, out_data + start * n,
+                   n);
+          });
+  } else {
+    Shard(worker_threads.num_threads, worker_threads.workers, n, m * k,
+          [&](int64 start, int64 limit) {
+            matmul(m, limit - start, k, a_data, lda, transpose_a,
+                   transpose_b ? b_data + start * ldb : b_data + start, ldb,
+                   transpose_b, out_data + start, n);
+          });
+  }
+  return true;
+}
+}  // namespace
+
+bool MatMulPackedRhsCache::Get(OpKernelContext* ctx, const Tensor& b,
+                               bool transpose_b, Tensor* packed_b) {
+  static const MatMulFloatPackedSizeIsaFn packed_size =
+      LookupCpuIsaFunction<MatMulFloatPackedSizeIsaFn>(
+          kMatMulFloatPackedSizeIsaFunction);
+  static const MatMulFloatPackBIsaFn pack_b =
+      LookupCpuIsaFunction<MatMulFloatPackBIsaFn>(kMatMulFloatPackBIsaFunction);
+  if (packed_size == nullptr || pack_b == nullptr || !IsConstantOpBuffer(b)) {
+    return false;
+  }
+  mutex_lock l(mu_);
+  if (b_.IsInitialized() && b_.shape() == b.shape() &&
+      b_.tensor_data().data() == b.tensor_data().data()) {
+    *packed_b = *packed_b_.AccessTensor(ctx);
+    return true;
+  }
+
+  const int64 k = b.dim_size(transpose_b ? 1 : 0);
+  const int64 n = b.dim_size(transpose_b ? 0 : 1);
+  Tensor* packed = nullptr;
+  PersistentTensor new_packed_b;
+  Status s = ctx->allocate_persistent(
+      DT_FLOAT, TensorShape({packed_size(n, k)}), &new_packed_b, &packed);
+  if (!s.ok()) {
+    // Not worth failing the op for, as the unpacked kernels work too.
+    return false;
+  }
+  const float* b_data = b.flat<float>().data();
+  float* packed_data = packed->flat<float>().data();
+  const int64 num_blocks =
+      (n + kMatMulFloatPackedBlockCols - 1) / kMatMulFloatPackedBlockCols;
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *(ctx->device()->tensorflow_cpu_worker_threads());
+  Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+        kMatMulFloatPackedBlockCols * k, [&](int64 start, int64 limit) {
+          pack_b(n, k, b_data, b.dim_size(1), transpose_b, start, limit,
+                 packed_data);
+        });
+  b_ = b;
+  packed_b_ = new_packed_b;
+  *packed_b = *packed;
+  return true;
+}
+
+template <>
+struct LaunchMatMulPacked<CPUDevice, float> {
+  static bool Run(
+      OpKernelContext* ctx, const Tensor& a, const Tensor& b,
+      const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair,
+      MatMulPackedRhsCache* cache, Tensor* out) {
+    static const MatMulFloatPackedIsaFn matmul =
+        LookupCpuIsaFunction<MatMulFloatPackedIsaFn>(
+            kMatMulFloatPackedIsaFunction);
+    const int64 m = out->dim_size(0);
+    const int64 n = out->dim_size(1);
+    // Matrix-vector products don't pack 'b' in the first place.
+    if (matmul == nullptr || m == 1 || n == 1) {
+      return false;
+    }
+    const bool transpose_a = dim_pair[0].first == 0;
+    const bool transpose_b = dim_pair[0].second == 1;
+    Tensor packed_b;
+    if (!cache->Get(ctx, b, transpose_b, &packed_b)) {
+      return false;
+    }
+    MatMulFloatPackedInParallel(ctx, matmul, a, transpose_a, packed_b, m, n,
+                                a.dim_size(dim_pair[0].first), out);
+    return true;
+  }
+};
+
+template <>
+struct LaunchMatMulCPU<float> : LaunchMatMulBase<CPUDevice, float> {
+  static void launch(
+      OpKernelContext* ctx, OpKernel* kernel, const Tensor& a, const Tensor& b,
+      const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair,
+      Tensor* out) {
+    if (!LaunchMatMulFloatIsa(ctx, a, b, dim_pair, out)) {
+      LaunchMatMulBase<CPUDevice, float>::launch(ctx, kernel, a, b, dim_pair,
+                                                 out);
+    }
+  }
+};
+#endif  // TENSORFLOW_USE_LIBXSMM
+
+// Converts 'n' elements from 'src' to 'dst' with 'convert' on the CPU worker
+// threads.
+template <typename Src, typename Dst>
+void ParallelConvert(OpKernelContext* ctx, const Src* src, Dst* dst, int64 n,
+                     void (*convert)(const Src*, Dst*, int64)) {
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads.num_threads, worker_threads.workers, n,
+        sizeof(float) + sizeof(bfloat16),
+        [src, dst, convert](int64 start, int64 limit) {
+          convert(src + start, dst + start, limit - start);
+        });
+}
+
+// bfloat16 has no arithmetic of its own, so the operands are widened to float
+// and multiplied by the float kernels (including the ISA-specific ones), which
+// accumulate in float. Only the product is rounded back to bfloat16.
+template <>
+struct LaunchMatMulCPU<bfloat16> {
+  static void launch(
+      OpKernelContext* ctx, OpKernel* kernel, const Tensor& a, const Tensor& b,
+      const Eigen::array<Eigen::IndexPair<Eigen::DenseIndex>, 1>& dim_pair,
+      Tensor* out) {
+    Tensor a_float, b_float, out_float;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(DT_FLOAT, a.shape(), &a_float));
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(DT_FLOAT, b.shape(), &b_float));
+    OP_REQUIRES_OK(ctx,
+                   ctx->allocate_temp(DT_FLOAT, out->shape(), &out_float));
+    ParallelConvert(ctx, a.flat<bfloat16>().data(),
+                    a_float.flat<float>().data(), a.NumElements(),
+                    BFloat16ToFloat);
+    ParallelConvert(ctx, b.flat<bfloat16>().data(),
+                    b_float.flat<float>().data(), b.NumElements(),
+                    BFloat16ToFloat);
+    LaunchMatMulCPU<float>::launch(ctx, kernel, a_float, b_float, dim_pair,
+                                   &out_float);
+    if (!ctx->status().ok()) return;
+    ParallelConvert(ctx, out_float.flat<float>().data(),
+                    out->flat<bfloat16>().data(), out->NumElements(),
+                    FloatToBFloat16);
+  }
+};
+
 template <typename T, bool USE_CUBLAS>
 struct LaunchMatMul<CPUDevice, T, USE_CUBLAS> : public LaunchMatMulCPU<T> {};
 
@@ -263,6 +525,14 @@ class MatMulOp : public OpKernel {
   }
 
   void Compute(OpKernelContext* ctx) override {
+    Tensor* out = nullptr;
+    ComputeMatMul(ctx, &out);
+  }
+
+ protected:
+  // Allocates the output and multiplies the first two inputs into it.
+  // *output_ptr is set as soon as the output is allocated.
+  void ComputeMatMul(OpKernelContext* ctx, Tensor** output_ptr) {
     const Tensor& a = ctx->input(0);
     const Tensor& b = ctx->input(1);
 
@@ -286,6 +556,7 @@ class MatMulOp : public OpKernel {
         {a.dim_size(a_dim_remaining), b.dim_size(b_dim_remaining)});
     Tensor* out = nullptr;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(0, out_shape, &out));
+    *output_ptr = out;
 
     if (out->NumElements() == 0) {
       // If a has shape [0, x] or b has shape [x, 0], the output shape
@@ -302,12 +573,130 @@ class MatMulOp : public OpKernel {
       return;
     }
 
+    if (LaunchMatMulPacked<Device, T>::Run(ctx, a, b, dim_pair,
+                                           &packed_b_cache_, out)) {
+      return;
+    }
+
     LaunchMatMul<Device, T, USE_CUBLAS>::launch(ctx, this, a, b, dim_pair, out);
   }
 
  private:
   bool transpose_a_;
   bool transpose_b_;
+  MatMulPackedRhsCache packed_b_cache_;
+};
+
+// MatMul followed by BiasAdd and an optional activation, which are applied in
+// place in a single pass over the product.
+template <typename Device, typename T, bool USE_CUBLAS>
+class FusedMatMulOp : public MatMulOp<Device, T, USE_CUBLAS> {
+ public:
+  explicit FusedMatMulOp(OpKernelConstruction* ctx)
+      : MatMulOp<Device, T, USE_CUBLAS>(ctx) {
+    OP_REQUIRES_OK(ctx, GetFusedActivation(ctx, &activation_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    Tensor* out = nullptr;
+    this->ComputeMatMul(ctx, &out);
+    if (!ctx->status().ok() || out == nullptr) {
+      return;
+    }
+
+    const Tensor& bias = ctx->input(2);
+    const int64 n = out->dim_size(1);
+    OP_REQUIRES(ctx,
+                TensorShapeUtils::IsVector(bias.shape()) &&
+                    bias.dim_size(0) == n,
+                errors::InvalidArgument(
+                    "Must provide as many biases as the output columns: ",
+                    bias.shape().DebugString(), " vs. ",
+                    out->shape().DebugString()));
+    if (out->NumElements() == 0) {
+      return;
+    }
+    functor::BiasActivation<Device, T>()(
+        ctx->eigen_device<Device>(),
+        out->shaped<T, 3>({out->dim_size(0), n, 1}), bias.vec<T>(),
+        activation_);
+  }
+
+ private:
+  FusedActivation activation_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FusedMatMulOp);
+};
+
+// MatMul with a 'b' packed offline for the MatMulFloatPacked kernels of one
+// instruction set, see the pack_matmul_weights graph transform.
+class PackedMatMulOp : public OpKernel {
+ public:
+  explicit PackedMatMulOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("transpose_a", &transpose_a_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("n", &n_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("k", &k_));
+    string isa_name;
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("isa", &isa_name));
+    CpuIsa isa;
+    OP_REQUIRES(ctx, CpuIsaFromName(isa_name, &isa),
+                errors::InvalidArgument("Unknown instruction set: ", isa_name));
+    packed_size_ = LookupCpuIsaFunction<MatMulFloatPackedSizeIsaFn>(
+        kMatMulFloatPackedSizeIsaFunction, isa);
+    matmul_ = LookupCpuIsaFunction<MatMulFloatPackedIsaFn>(
+        kMatMulFloatPackedIsaFunction, isa);
+    OP_REQUIRES(
+        ctx, packed_size_ != nullptr && matmul_ != nullptr,
+        errors::FailedPrecondition(
+            "The weights of ", name(), " are packed for ", isa_name,
+            ", which this CPU or binary doesn't support. Pack them again "
+            "for this CPU with the pack_matmul_weights graph transform."));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& a = ctx->input(0);
+    const Tensor& packed_b = ctx->input(1);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrix(a.shape()),
+                errors::InvalidArgument("In[0] is not a matrix"));
+    OP_REQUIRES(ctx, a.dim_size(transpose_a_ ? 0 : 1) == k_,
+                errors::InvalidArgument(
+                    "Matrix size-incompatible: In[0]: ",
+                    a.shape().DebugString(), ", k: ", k_));
+    OP_REQUIRES(ctx,
+                TensorShapeUtils::IsVector(packed_b.shape()) &&
+                    packed_b.NumElements() == packed_size_(n_, k_),
+                errors::InvalidArgument(
+                    "packed_b must be a vector of ", packed_size_(n_, k_),
+                    " floats for a ", k_, " x ", n_,
+                    " matrix, but got shape ", packed_b.shape().DebugString()));
+
+    const int64 m = a.dim_size(transpose_a_ ? 1 : 0);
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({m, n_}), &out));
+    if (m == 0) {
+      return;
+    }
+
+    // The kernels need the aligned buffers that the allocators give, which
+    // slices of a larger tensor may not have.
+    Tensor aligned_packed_b = packed_b;
+    if (!packed_b.IsAligned()) {
+      OP_REQUIRES_OK(ctx, ctx->allocate_temp(DT_FLOAT, packed_b.shape(),
+                                             &aligned_packed_b));
+      aligned_packed_b.flat<float>() = packed_b.unaligned_flat<float>();
+    }
+    MatMulFloatPackedInParallel(ctx, matmul_, a, transpose_a_,
+                                aligned_packed_b, m, n_, k_, out);
+  }
+
+ private:
+  bool transpose_a_;
+  int64 n_;
+  int64 k_;
+  MatMulFloatPackedSizeIsaFn packed_size_;
+  MatMulFloatPackedIsaFn matmul_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PackedMatMulOp);
 };
 
 namespace functor {
@@ -338,6 +727,20 @@ struct MatMulFunctor<SYCLDevice, T> {
 };
 #endif  // TENSORFLOW_USE_SYCL
 
+#if GOOGLE_CUDA
+// Forward declarations of the functor specializations for GPU.
+#define DECLARE_GPU_SPEC(T)                                              \
+  template <>                                                            \
+  void BiasActivation<GPUDevice, T>::operator()(                         \
+      const GPUDevice& d, typename TTypes<T, 3>::Tensor output,          \
+      typename TTypes<T>::ConstVec bias, FusedActivation activation);    \
+  extern template struct BiasActivation<GPUDevice, T>;
+DECLARE_GPU_SPEC(Eigen::half);
+DECLARE_GPU_SPEC(float);
+DECLARE_GPU_SPEC(double);
+#undef DECLARE_GPU_SPEC
+#endif  // GOOGLE_CUDA
+
 }  // end namespace functor
 
 #define REGISTER_CPU(T)                                                        \
@@ -368,20 +771,43 @@ TF_CALL_int32(REGISTER_CPU);
 TF_CALL_float(REGISTER_CPU);
 TF_CALL_double(REGISTER_CPU);
 TF_CALL_half(REGISTER_CPU);
+TF_CALL_bfloat16(REGISTER_CPU);
 
 TF_CALL_int32(REGISTER_CPU);
 TF_CALL_complex64(REGISTER_CPU);
 TF_CALL_complex128(REGISTER_CPU);
 #endif
 
+#define REGISTER_FUSED_CPU(T)                                         \
+  REGISTER_KERNEL_BUILDER(                                            \
+      Name("_FusedMatMul").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedMatMulOp<CPUDevice, T, false /* cublas, ignored for CPU */>);
+
+TF_CALL_half(REGISTER_FUSED_CPU);
+TF_CALL_float(REGISTER_FUSED_CPU);
+TF_CALL_double(REGISTER_FUSED_CPU);
+#undef REGISTER_FUSED_CPU
+
+REGISTER_KERNEL_BUILDER(Name("PackedMatMul").Device(DEVICE_CPU),
+                        PackedMatMulOp);
+
 #if GOOGLE_CUDA
+#define REGISTER_FUSED_GPU(T)                                         \
+  REGISTER_KERNEL_BUILDER(                                            \
+      Name("_FusedMatMul").Device(DEVICE_GPU).TypeConstraint<T>("T"), \
+      FusedMatMulOp<GPUDevice, T, true /* cublas */>);
+
 TF_CALL_float(REGISTER_GPU);
 TF_CALL_double(REGISTER_GPU);
 TF_CALL_complex64(REGISTER_GPU);
 TF_CALL_complex128(REGISTER_GPU);
+TF_CALL_float(REGISTER_FUSED_GPU);
+TF_CALL_double(REGISTER_FUSED_GPU);
 #if CUDA_VERSION >= 7050
 TF_CALL_half(REGISTER_GPU);
+TF_CALL_half(REGISTER_FUSED_GPU);
 #endif
+#undef REGISTER_FUSED_GPU
 #endif  // GOOGLE_CUDA
 
 #ifdef TENSORFLOW_USE_SYCL
@@ -0,0 +1,203 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// MatMul kernels built once per instruction set by tf_cpu_isa_library(), which
+// defines TF_CPU_ISA. Only Eigen and plain types may be used here, see
+// cpu_isa_dispatch.h.
+
+#ifdef TF_CPU_ISA
+
+#include "tensorflow/core/kernels/matmul_op_isa.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "tensorflow/core/kernels/cpu_isa_dispatch.h"
+
+namespace tensorflow {
+namespace {
+
+typedef Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>
+    Matrix;
+typedef Eigen::Map<Matrix, Eigen::Unaligned, Eigen::OuterStride<>> MatrixMap;
+typedef Eigen::Map<const Matrix, Eigen::Unaligned, Eigen::OuterStride<>>
+    ConstMatrixMap;
+
+void MatMulFloat(int64 m, int64 n, int64 k, const float* a, int64 lda,
+                 bool transpose_a, const float* b, int64 ldb, bool transpose_b,
+                 float* out, int64 ldo) {
+  MatrixMap c(out, m, n, Eigen::OuterStride<>(ldo));
+  if (transpose_a) {
+    ConstMatrixMap a_t(a, k, m, Eigen::OuterStride<>(lda));
+    if (transpose_b) {
+      ConstMatrixMap b_t(b, n, k, Eigen::OuterStride<>(ldb));
+      c.noalias() = a_t.transpose() * b_t.transpose();
+    } else {
+      ConstMatrixMap b_m(b, k, n, Eigen::OuterStride<>(ldb));
+      c.noalias() = a_t.transpose() * b_m;
+    }
+  } else {
+    ConstMatrixMap a_m(a, m, k, Eigen::OuterStride<>(lda));
+    if (transpose_b) {
+      ConstMatrixMap b_t(b, n, k, Eigen::OuterStride<>(ldb));
+      c.noalias() = a_m * b_t.transpose();
+    } else {
+      ConstMatrixMap b_m(b, k, n, Eigen::OuterStride<>(ldb));
+      c.noalias() = a_m * b_m;
+    }
+  }
+}
+
+// The packed kernels compute out^T = op(b)^T * op(a)^T with the Eigen GEMM
+// building blocks, op(b)^T being the left-hand side packed in advance. Each
+// column block of op(b) is packed as consecutive panels of kPackedDepth rows
+// of op(b), aligned to kPackedAlignment floats.
+typedef Eigen::internal::gebp_traits<float, float> Traits;
+
+const int64 kPackedDepth = 256;
+const int64 kPackedAlignment = 16;
+
+int64 RoundUpToAlignment(int64 size) {
+  return (size + kPackedAlignment - 1) / kPackedAlignment * kPackedAlignment;
+}
+
+// Returns the number of floats of the packed column block of 'cols' columns.
+int64 PackedBlockSize(int64 cols, int64 k) {
+  int64 size = 0;
+  for (int64 depth = 0; depth < k; depth += kPackedDepth) {
+    size += RoundUpToAlignment(cols * std::min(kPackedDepth, k - depth));
+  }
+  return size;
+}
+
+int64 MatMulFloatPackedSize(int64 n, int64 k) {
+  const int64 full_blocks = n / kMatMulFloatPackedBlockCols;
+  const int64 last_cols = n - full_blocks * kMatMulFloatPackedBlockCols;
+  // Full blocks have no padding, as kMatMulFloatPackedBlockCols is a multiple
+  // of kPackedAlignment.
+  return full_blocks * kMatMulFloatPackedBlockCols * k +
+         PackedBlockSize(last_cols, k);
+}
+
+template <int StorageOrder>
+void PackLhs(const float* lhs, int64 stride, int64 rows, int64 depth,
+             float* block) {
+  typedef Eigen::internal::const_blas_data_mapper<float, int64, StorageOrder>
+      LhsMapper;
+  Eigen::internal::gemm_pack_lhs<float, int64, LhsMapper, Traits::mr,
+                                 Traits::LhsProgress, StorageOrder>
+      pack_lhs;
+  pack_lhs(block, LhsMapper(lhs, stride), depth, rows);
+}
+
+template <int StorageOrder>
+void PackRhs(const float* rhs, int64 stride, int64 depth, int64 cols,
+             float* block) {
+  typedef Eigen::internal::const_blas_data_mapper<float, int64, StorageOrder>
+      RhsMapper;
+  Eigen::internal::gemm_pack_rhs<float, int64, RhsMapper, Traits::nr,
+                                 StorageOrder>
+      pack_rhs;
+  pack_rhs(block, RhsMapper(rhs, stride), depth, cols);
+}
+
+void MatMulFloatPackB(int64 n, int64 k, const float* b, int64 ldb,
+                      bool transpose_b, int64 block_start, int64 block_limit,
+                      float* packed_b) {
+  for (int64 block = block_start; block < block_limit; ++block) {
+    const int64 col = block * kMatMulFloatPackedBlockCols;
+    const int64 cols = std::min(kMatMulFloatPackedBlockCols, n - col);
+    float* packed = packed_b + col * k;
+    for (int64 depth = 0; depth < k; depth += kPackedDepth) {
+      const int64 depth_size = std::min(kPackedDepth, k - depth);
+      // op(b)^T is row-major if 'b' is stored transposed, column-major
+      // otherwise.
+      if (transpose_b) {
+        PackLhs<Eigen::RowMajor>(b + col * ldb + depth, ldb, cols, depth_size,
+                                 packed);
+      } else {
+        PackLhs<Eigen::ColMajor>(b + depth * ldb + col, ldb, cols, depth_size,
+                                 packed);
+      }
+      packed += RoundUpToAlignment(cols * depth_size);
+    }
+  }
+}
+
+void MatMulFloatPacked(int64 m, int64 n, int64 k, const float* a, int64 lda,
+                       bool transpose_a, const float* packed_b,
+                       int64 block_start, int64 block_limit, float* out,
+                       int64 ldo) {
+  typedef Eigen::internal::blas_data_mapper<float, int64, Eigen::ColMajor>
+      OutputMapper;
+  Eigen::internal::gebp_kernel<float, float, int64, OutputMapper, Traits::mr,
+                               Traits::nr, false, false>
+      gebp;
+
+  // Packs op(a)^T, which is row-major if 'a' is stored transposed.
+  std::vector<float, Eigen::aligned_allocator<float>> packed_a(
+      RoundUpToAlignment(m) * k);
+  for (int64 depth = 0; depth < k; depth += kPackedDepth) {
+    const int64 depth_size = std::min(kPackedDepth, k - depth);
+    float* packed = packed_a.data() + RoundUpToAlignment(m) * depth;
+    if (transpose_a) {
+      PackRhs<Eigen::RowMajor>(a + depth * lda, lda, depth_size, m, packed);
+    } else {
+      PackRhs<Eigen::ColMajor>(a + depth, lda, depth_size, m, packed);
+    }
+  }
+
+  for (int64 block = block_start; block < block_limit; ++block) {
+    const int64 col = block * kMatMulFloatPackedBlockCols;
+    const int64 cols = std::min(kMatMulFloatPackedBlockCols, n - col);
+    for (int64 i = 0; i < m; ++i) {
+      memset(out + i * ldo + col, 0, cols * sizeof(float));
+    }
+    const OutputMapper out_mapper(out + col, ldo);
+    const float* packed = packed_b + col * k;
+    for (int64 depth = 0; depth < k; depth += kPackedDepth) {
+      const int64 depth_size = std::min(kPackedDepth, k - depth);
+      gebp(out_mapper, packed,
+           packed_a.data() + RoundUpToAlignment(m) * depth, cols, depth_size,
+           m, 1.0f);
+      packed += RoundUpToAlignment(cols * depth_size);
+    }
+  }
+}
+
+// Checks that the types of the kernels match the interface.
+const MatMulFloatIsaFn kMatMulFloat = MatMulFloat;
+const MatMulFloatPackedSizeIsaFn kMatMulFloatPackedSize =
+    MatMulFloatPackedSize;
+const MatMulFloatPackBIsaFn kMatMulFloatPackB = MatMulFloatPackB;
+const MatMulFloatPackedIsaFn kMatMulFloatPacked = MatMulFloatPacked;
+
+}  // namespace
+
+REGISTER_CPU_ISA_FUNCTION(kMatMulFloatIsaFunction, CpuIsa::TF_CPU_ISA,
+                          kMatMulFloat);
+REGISTER_CPU_ISA_FUNCTION(kMatMulFloatPackedSizeIsaFunction,
+                          CpuIsa::TF_CPU_ISA, kMatMulFloatPackedSize);
+REGISTER_CPU_ISA_FUNCTION(kMatMulFloatPackBIsaFunction, CpuIsa::TF_CPU_ISA,
+                          kMatMulFloatPackB);
+REGISTER_CPU_ISA_FUNCTION(kMatMulFloatPackedIsaFunction, CpuIsa::TF_CPU_ISA,
+                          kMatMulFloatPacked);
+
+}  // namespace tensorflow
+
+#endif  // TF_CPU_ISA
@@ -0,0 +1,70 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_MATMUL_OP_ISA_H_
+#define TENSORFLOW_KERNELS_MATMUL_OP_ISA_H_
+
+// Interface of the MatMul kernels compiled for several instruction sets, see
+// cpu_isa_dispatch.h.
+
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// The name under which the float MatMul kernels are registered.
+constexpr char kMatMulFloatIsaFunction[] = "MatMulFloat";
+
+// Computes out = op(a) * op(b) on the calling thread, where op(a) is m x k and
+// op(b) is k x n. All the matrices are row-major, and 'lda', 'ldb' and 'ldo'
+// are the distances between their rows. If 'transpose_a' is true, 'a' is
+// stored as a k x m matrix, and likewise for 'b'.
+typedef void (*MatMulFloatIsaFn)(int64 m, int64 n, int64 k, const float* a,
+                                 int64 lda, bool transpose_a, const float* b,
+                                 int64 ldb, bool transpose_b, float* out,
+                                 int64 ldo);
+
+// The names of the float MatMul kernels that take op(b) packed beforehand, so
+// that constant operands are only packed once. The three must come from the
+// same build, as the packed layout depends on the instruction set.
+constexpr char kMatMulFloatPackedSizeIsaFunction[] = "MatMulFloatPackedSize";
+constexpr char kMatMulFloatPackBIsaFunction[] = "MatMulFloatPackB";
+constexpr char kMatMulFloatPackedIsaFunction[] = "MatMulFloatPacked";
+
+// op(b) is packed by blocks of this many columns, which are packed and
+// multiplied independently.
+constexpr int64 kMatMulFloatPackedBlockCols = 96;
+
+// Returns the number of floats of the packed form of a k x n op(b).
+typedef int64 (*MatMulFloatPackedSizeIsaFn)(int64 n, int64 k);
+
+// Packs the column blocks [block_start, block_limit) of the k x n op(b) into
+// 'packed_b', which holds the whole packed op(b) and must be 64-byte aligned.
+typedef void (*MatMulFloatPackBIsaFn)(int64 n, int64 k, const float* b,
+                                      int64 ldb, bool transpose_b,
+                                      int64 block_start, int64 block_limit,
+                                      float* packed_b);
+
+// Computes the column blocks [block_start, block_limit) of
+// out = op(a) * op(b) on the calling thread, with op(b) packed by
+// MatMulFloatPackB.
+typedef void (*MatMulFloatPackedIsaFn)(int64 m, int64 n, int64 k,
+                                       const float* a, int64 lda,
+                                       bool transpose_a, const float* packed_b,
+                                       int64 block_start, int64 block_limit,
+                                       float* out, int64 ldo);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_MATMUL_OP_ISA_H_
@@ -13,12 +13,190 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include "tensorflow/cc/client/client_session.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/math_ops.h"
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/cpu_isa_dispatch.h"
+#include "tensorflow/core/kernels/matmul_op_isa.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
+namespace {
+
+// Compares MatMul with a constant 'b', which CPU kernels may keep packed
+// across steps, with MatMul with the same 'b' fed at every step.
+void TestConstantRhs(int m, int k, int n, bool transpose_a,
+                     bool transpose_b) {
+  Scope root = Scope::NewRootScope();
+  Tensor a(DT_FLOAT,
+           transpose_a ? TensorShape({k, m}) : TensorShape({m, k}));
+  a.flat<float>().setRandom();
+  Tensor b(DT_FLOAT,
+           transpose_b ? TensorShape({n, k}) : TensorShape({k, n}));
+  b.flat<float>().setRandom();
+
+  auto a_in = ops::Placeholder(root, DT_FLOAT);
+  auto b_in = ops::Placeholder(root, DT_FLOAT);
+  auto b_const = ops::Const(root, Input::Initializer(b));
+  const auto attrs =
+      ops::MatMul::TransposeA(transpose_a).TransposeB(transpose_b);
+  auto with_const = ops::MatMul(root, a_in, b_const, attrs);
+  auto with_fed = ops::MatMul(root, a_in, b_in, attrs);
+  TF_ASSERT_OK(root.status());
+
+  ClientSession session(root);
+  for (int step = 0; step < 3; ++step) {
+    a.flat<float>().setRandom();
+    std::vector<Tensor> outputs;
+    TF_ASSERT_OK(session.Run({{a_in, a}, {b_in, b}}, {with_const, with_fed},
+                             &outputs));
+    test::ExpectTensorNear<float>(outputs[1], outputs[0], 1e-4);
+  }
+}
+
+TEST(MatMulOpTest, ConstantRhs) {
+  for (int transpose_a = 0; transpose_a < 2; ++transpose_a) {
+    for (int transpose_b = 0; transpose_b < 2; ++transpose_b) {
+      TestConstantRhs(2, 3, 4, transpose_a, transpose_b);
+      TestConstantRhs(8, 300, 200, transpose_a, transpose_b);
+      TestConstantRhs(129, 257, 97, transpose_a, transpose_b);
+    }
+  }
+}
+
+// Compares a bfloat16 MatMul with a float one. The inputs are small
+// integers and the sums stay below 256, so both products are exact.
+void TestBFloat16(int m, int k, int n, bool transpose_a, bool transpose_b) {
+  Scope root = Scope::NewRootScope();
+  Tensor a(DT_FLOAT,
+           transpose_a ? TensorShape({k, m}) : TensorShape({m, k}));
+  auto a_flat = a.flat<float>();
+  for (int64 i = 0; i < a_flat.size(); ++i) a_flat(i) = i % 3 - 1.0f;
+  Tensor b(DT_FLOAT,
+           transpose_b ? TensorShape({n, k}) : TensorShape({k, n}));
+  auto b_flat = b.flat<float>();
+  for (int64 i = 0; i < b_flat.size(); ++i) b_flat(i) = i % 5 - 2.0f;
+
+  const auto attrs =
+      ops::MatMul::TransposeA(transpose_a).TransposeB(transpose_b);
+  auto expected = ops::MatMul(root, ops::Const(root, Input::Initializer(a)),
+                              ops::Const(root, Input::Initializer(b)), attrs);
+  auto a_bf16 =
+      ops::Cast(root, ops::Const(root, Input::Initializer(a)), DT_BFLOAT16);
+  auto b_bf16 =
+      ops::Cast(root, ops::Const(root, Input::Initializer(b)), DT_BFLOAT16);
+  auto actual =
+      ops::Cast(root, ops::MatMul(root, a_bf16, b_bf16, attrs), DT_FLOAT);
+  TF_ASSERT_OK(root.status());
+
+  ClientSession session(root);
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session.Run({expected, actual}, &outputs));
+  test::ExpectTensorEqual<float>(outputs[0], outputs[1]);
+}
+
+TEST(MatMulOpTest, BFloat16) {
+  for (int transpose_a = 0; transpose_a < 2; ++transpose_a) {
+    for (int transpose_b = 0; transpose_b < 2; ++transpose_b) {
+      TestBFloat16(2, 3, 4, transpose_a, transpose_b);
+      TestBFloat16(8, 100, 200, transpose_a, transpose_b);
+      TestBFloat16(129, 97, 65, transpose_a, transpose_b);
+    }
+  }
+}
+
+// Compares PackedMatMul with MatMul, packing 'b' with the kernels of the most
+// capable instruction set of this CPU.
+void TestPackedMatMul(int m, int k, int n, bool transpose_a, bool transpose_b) {
+  const CpuIsa isa = LookupCpuIsaFunction(kMatMulFloatPackBIsaFunction,
+                                          CpuIsa::kAvx2Fma) != nullptr
+                         ? CpuIsa::kAvx2Fma
+                         : CpuIsa::kAvx;
+  const MatMulFloatPackedSizeIsaFn packed_size =
+      LookupCpuIsaFunction<MatMulFloatPackedSizeIsaFn>(
+          kMatMulFloatPackedSizeIsaFunction, isa);
+  const MatMulFloatPackBIsaFn pack_b =
+      LookupCpuIsaFunction<MatMulFloatPackBIsaFn>(kMatMulFloatPackBIsaFunction,
+                                                  isa);
+  ASSERT_NE(nullptr, packed_size);
+  ASSERT_NE(nullptr, pack_b);
+
+  Scope root = Scope::NewRootScope();
+  Tensor a(DT_FLOAT,
+           transpose_a ? TensorShape({k, m}) : TensorShape({m, k}));
+  a.flat<float>().setRandom();
+  Tensor b(DT_FLOAT,
+           transpose_b ? TensorShape({n, k}) : TensorShape({k, n}));
+  b.flat<float>().setRandom();
+  Tensor packed_b(DT_FLOAT, TensorShape({packed_size(n, k)}));
+  pack_b(n, k, b.flat<float>().data(), b.dim_size(1), transpose_b, 0,
+         (n + kMatMulFloatPackedBlockCols - 1) / kMatMulFloatPackedBlockCols,
+         packed_b.flat<float>().data());
+
+  auto expected = ops::MatMul(
+      root, ops::Const(root, Input::Initializer(a)),
+      ops::Const(root, Input::Initializer(b)),
+      ops::MatMul::TransposeA(transpose_a).TransposeB(transpose_b));
+  auto actual = ops::PackedMatMul(
+      root, ops::Const(root, Input::Initializer(a)),
+      ops::Const(root, Input::Initializer(packed_b)), n, k, CpuIsaName(isa),
+      ops::PackedMatMul::TransposeA(transpose_a));
+  TF_ASSERT_OK(root.status());
+
+  ClientSession session(root);
+  std::vector<Tensor> outputs;
+  TF_ASSERT_OK(session.Run({expected, actual}, &outputs));
+  test::ExpectTensorNear<float>(outputs[0], outputs[1], 1e-3);
+}
+
+TEST(MatMulOpTest, PackedMatMul) {
+  if (LookupCpuIsaFunction(kMatMulFloatPackBIsaFunction) == nullptr) {
+    LOG(INFO) << "Skipping the test, as there are no packed MatMul kernels "
+                 "for this CPU";
+    return;
+  }
+  for (int transpose_a = 0; transpose_a < 2; ++transpose_a) {
+    for (int transpose_b = 0; transpose_b < 2; ++transpose_b) {
+      TestPackedMatMul(1, 3, 4, transpose_a, transpose_b);
+      TestPackedMatMul(8, 300, 200, transpose_a, transpose_b);
+      TestPackedMatMul(129, 257, 97, transpose_a, transpose_b);
+    }
+  }
+}
+
+TEST(MatMulOpTest, PackedMatMulErrors) {
+  Scope root = Scope::NewRootScope();
+  auto a = ops::Const(root, {{1.0f, 2.0f}});
+  auto unknown_isa =
+      ops::PackedMatMul(root, a, ops::Const(root, {1.0f, 2.0f}), 1, 2, "SSE9");
+  TF_ASSERT_OK(root.status());
+  ClientSession session(root);
+  std::vector<Tensor> outputs;
+  Status s = session.Run({unknown_isa}, &outputs);
+  EXPECT_EQ(error::INVALID_ARGUMENT, s.code());
+  EXPECT_TRUE(
+      StringPiece(s.error_message()).contains("Unknown instruction set"))
+      << s;
+
+  if (LookupCpuIsaFunction(kMatMulFloatPackBIsaFunction, CpuIsa::kAvx) !=
+      nullptr) {
+    auto wrong_size =
+        ops::PackedMatMul(root, a, ops::Const(root, {1.0f, 2.0f}), 1, 2, "AVX");
+    TF_ASSERT_OK(root.status());
+    s = session.Run({wrong_size}, &outputs);
+    EXPECT_EQ(error::INVALID_ARGUMENT, s.code());
+    EXPECT_TRUE(StringPiece(s.error_message()).contains("packed_b must be"))
+        << s;
+  }
+}
+
+}  // namespace
 
 template <typename T>
 static Graph* Matmul(int m, int k, int n, bool transpose_a, bool transpose_b,
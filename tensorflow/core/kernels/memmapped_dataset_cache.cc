@@ -0,0 +1,338 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/memmapped_dataset_cache.h"
+
+#include <string.h>
+
+#include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/coding.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/raw_coding.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/lib/strings/stringprintf.h"
+
+namespace tensorflow {
+
+// A buffer that aliases part of a memory region holding a cache file, and
+// keeps that region alive.
+class MemmappedTensorBuffer : public TensorBuffer {
+ public:
+  MemmappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                        const char* data, size_t len)
+      : region_(std::move(region)), data_(data), len_(len) {}
+
+  void* data() const override { return const_cast<char*>(data_); }
+  size_t size() const override { return len_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(static_cast<int64>(len_));
+    proto->set_allocator_name("MemmappedTensorBuffer");
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data_));
+  }
+
+  // Prevents input forwarding from writing into the read-only region.
+  bool OwnsMemory() const override { return false; }
+
+  Tensor MakeTensor(DataType dtype, const TensorShape& shape) {
+    CHECK_EQ(len_, shape.num_elements() * DataTypeSize(dtype));
+    return Tensor(dtype, shape, this);
+  }
+
+ private:
+  ~MemmappedTensorBuffer() override {}
+
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const char* const data_;
+  const size_t len_;
+};
+
+namespace dataset {
+
+namespace {
+
+constexpr char kShardMagic[] = "TFDSCAC1";
+constexpr char kManifestMagic[] = "TFDSMAN1";
+constexpr size_t kMagicSize = 8;
+constexpr uint64 kAlignment = Allocator::kAllocatorAlignment;
+
+uint64 AlignedOffset(uint64 offset) {
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// Holds the contents of a file that could not be mapped into memory.
+class StringMemoryRegion : public ReadOnlyMemoryRegion {
+ public:
+  explicit StringMemoryRegion(string data) : data_(std::move(data)) {}
+
+  const void* data() override { return data_.data(); }
+  uint64 length() override { return data_.size(); }
+
+ private:
+  const string data_;
+};
+
+}  // namespace
+
+string MemmappedCacheShardFilename(StringPiece prefix, int64 shard,
+                                   int64 num_shards) {
+  return strings::StrCat(prefix,
+                         strings::Printf(".cache-%05lld-of-%05lld",
+                                         static_cast<long long>(shard),
+                                         static_cast<long long>(num_shards)));
+}
+
+string MemmappedCacheManifestFilename(StringPiece prefix) {
+  return strings::StrCat(prefix, ".cache-manifest");
+}
+
+Status WriteMemmappedCacheManifest(Env* env, StringPiece prefix,
+                                   int64 num_shards, int64 num_elements) {
+  string contents(kManifestMagic, kMagicSize);
+  core::PutFixed64(&contents, num_shards);
+  core::PutFixed64(&contents, num_elements);
+  // Write to a temporary file first, so that a reader never sees a partial
+  // manifest.
+  const string filename = MemmappedCacheManifestFilename(prefix);
+  const string tmp_filename = strings::StrCat(filename, ".tmp");
+  TF_RETURN_IF_ERROR(WriteStringToFile(env, tmp_filename, contents));
+  return env->RenameFile(tmp_filename, filename);
+}
+
+Status ReadMemmappedCacheManifest(Env* env, StringPiece prefix,
+                                  int64* num_shards, int64* num_elements) {
+  const string filename = MemmappedCacheManifestFilename(prefix);
+  string contents;
+  TF_RETURN_IF_ERROR(ReadFileToString(env, filename, &contents));
+  if (contents.size() != kMagicSize + 16 ||
+      memcmp(contents.data(), kManifestMagic, kMagicSize) != 0) {
+    return errors::DataLoss("Invalid cache manifest: ", filename);
+  }
+  *num_shards = core::DecodeFixed64(contents.data() + kMagicSize);
+  *num_elements = core::DecodeFixed64(contents.data() + kMagicSize + 8);
+  if (*num_shards <= 0 || *num_elements < 0) {
+    return errors::DataLoss("Invalid cache manifest: ", filename);
+  }
+  return Status::OK();
+}
+
+MemmappedCacheWriter::MemmappedCacheWriter(std::unique_ptr<WritableFile> file)
+    : file_(std::move(file)) {}
+
+Status MemmappedCacheWriter::Create(
+    Env* env, const string& filename,
+    std::unique_ptr<MemmappedCacheWriter>* writer) {
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(filename, &file));
+  writer->reset(new MemmappedCacheWriter(std::move(file)));
+  TF_RETURN_IF_ERROR((*writer)->Write(StringPiece(kShardMagic, kMagicSize)));
+  return (*writer)->PadToAlignment();
+}
+
+Status MemmappedCacheWriter::Append(const std::vector<Tensor>& element) {
+  string header;
+  core::PutFixed32(&header, element.size());
+  TF_RETURN_IF_ERROR(Write(header));
+  for (const Tensor& t : element) {
+    const bool is_string = t.dtype() == DT_STRING;
+    if (!is_string && !DataTypeCanUseMemcpy(t.dtype())) {
+      return errors::Unimplemented("Cannot cache a tensor of type ",
+                                   DataTypeString(t.dtype()));
+    }
+    header.clear();
+    core::PutFixed32(&header, t.dtype());
+    core::PutFixed32(&header, t.dims());
+    for (int i = 0; i < t.dims(); ++i) {
+      core::PutFixed64(&header, t.dim_size(i));
+    }
+    if (is_string) {
+      // The lengths of the strings, followed by their contents.
+      auto strings = t.flat<string>();
+      string lengths;
+      uint64 num_bytes = 0;
+      for (int64 i = 0; i < strings.size(); ++i) {
+        core::PutFixed64(&lengths, strings(i).size());
+        num_bytes += strings(i).size();
+      }
+      core::PutFixed64(&header, lengths.size() + num_bytes);
+      TF_RETURN_IF_ERROR(Write(header));
+      TF_RETURN_IF_ERROR(PadToAlignment());
+      TF_RETURN_IF_ERROR(Write(lengths));
+      for (int64 i = 0; i < strings.size(); ++i) {
+        TF_RETURN_IF_ERROR(Write(strings(i)));
+      }
+    } else {
+      const StringPiece data = t.tensor_data();
+      core::PutFixed64(&header, data.size());
+      TF_RETURN_IF_ERROR(Write(header));
+      TF_RETURN_IF_ERROR(PadToAlignment());
+      TF_RETURN_IF_ERROR(Write(data));
+    }
+  }
+  return Status::OK();
+}
+
+Status MemmappedCacheWriter::Close() { return file_->Close(); }
+
+Status MemmappedCacheWriter::Write(StringPiece data) {
+  TF_RETURN_IF_ERROR(file_->Append(data));
+  offset_ += data.size();
+  return Status::OK();
+}
+
+Status MemmappedCacheWriter::PadToAlignment() {
+  const uint64 padding = AlignedOffset(offset_) - offset_;
+  if (padding == 0) {
+    return Status::OK();
+  }
+  return Write(string(padding, '\0'));
+}
+
+MemmappedCacheReader::MemmappedCacheReader(
+    string filename, std::shared_ptr<ReadOnlyMemoryRegion> region,
+    uint64 offset)
+    : filename_(std::move(filename)),
+      region_(std::move(region)),
+      offset_(offset) {}
+
+Status MemmappedCacheReader::Create(
+    Env* env, const string& filename,
+    std::unique_ptr<MemmappedCacheReader>* reader) {
+  std::unique_ptr<ReadOnlyMemoryRegion> region;
+  Status s = env->NewReadOnlyMemoryRegionFromFile(filename, &region);
+  if (errors::IsUnimplemented(s)) {
+    string contents;
+    TF_RETURN_IF_ERROR(ReadFileToString(env, filename, &contents));
+    region.reset(new StringMemoryRegion(std::move(contents)));
+  } else {
+    TF_RETURN_IF_ERROR(s);
+  }
+  if (region->length() < kMagicSize ||
+      memcmp(region->data(), kShardMagic, kMagicSize) != 0) {
+    return errors::DataLoss("Invalid cache file: ", filename);
+  }
+  reader->reset(new MemmappedCacheReader(
+      filename, std::shared_ptr<ReadOnlyMemoryRegion>(std::move(region)),
+      kMagicSize));
+  return (*reader)->SkipToAlignment();
+}
+
+Status MemmappedCacheReader::ReadElement(std::vector<Tensor>* element,
+                                         bool* end_of_file) {
+  if (offset_ == region_->length()) {
+    *end_of_file = true;
+    return Status::OK();
+  }
+  *end_of_file = false;
+  const char* data;
+  TF_RETURN_IF_ERROR(ReadBytes(4, &data));
+  const uint32 num_components = core::DecodeFixed32(data);
+  element->clear();
+  element->resize(num_components);
+  for (uint32 i = 0; i < num_components; ++i) {
+    TF_RETURN_IF_ERROR(ReadTensor(&(*element)[i]));
+  }
+  return Status::OK();
+}
+
+Status MemmappedCacheReader::ReadTensor(Tensor* tensor) {
+  const char* data;
+  TF_RETURN_IF_ERROR(ReadBytes(8, &data));
+  const DataType dtype = static_cast<DataType>(core::DecodeFixed32(data));
+  const uint32 dims = core::DecodeFixed32(data + 4);
+  if (dtype != DT_STRING && !DataTypeCanUseMemcpy(dtype)) {
+    return errors::DataLoss("Invalid tensor type ", dtype, " in cache file: ",
+                            filename_);
+  }
+  TF_RETURN_IF_ERROR(ReadBytes(8 * static_cast<uint64>(dims), &data));
+  std::vector<int64> dim_sizes(dims);
+  for (uint32 i = 0; i < dims; ++i) {
+    dim_sizes[i] = core::DecodeFixed64(data + 8 * i);
+  }
+  TensorShape shape;
+  TF_RETURN_IF_ERROR(TensorShapeUtils::MakeShape(dim_sizes, &shape));
+  TF_RETURN_IF_ERROR(ReadBytes(8, &data));
+  const uint64 num_bytes = core::DecodeFixed64(data);
+  TF_RETURN_IF_ERROR(SkipToAlignment());
+  TF_RETURN_IF_ERROR(ReadBytes(num_bytes, &data));
+
+  const int64 num_elements = shape.num_elements();
+  if (dtype == DT_STRING) {
+    if (num_bytes < 8 * static_cast<uint64>(num_elements)) {
+      return errors::DataLoss("Truncated string tensor in cache file: ",
+                              filename_);
+    }
+    Tensor t(DT_STRING, shape);
+    auto strings = t.flat<string>();
+    const char* contents = data + 8 * num_elements;
+    const char* const limit = data + num_bytes;
+    for (int64 i = 0; i < num_elements; ++i) {
+      const uint64 length = core::DecodeFixed64(data + 8 * i);
+      if (length > static_cast<uint64>(limit - contents)) {
+        return errors::DataLoss("Truncated string tensor in cache file: ",
+                                filename_);
+      }
+      strings(i).assign(contents, length);
+      contents += length;
+    }
+    *tensor = std::move(t);
+    return Status::OK();
+  }
+
+  if (num_bytes !=
+      static_cast<uint64>(num_elements) * DataTypeSize(dtype)) {
+    return errors::DataLoss("Tensor of shape ", shape.DebugString(),
+                            " has an invalid size (", num_bytes,
+                            " bytes) in cache file: ", filename_);
+  }
+  if (num_bytes == 0) {
+    *tensor = Tensor(dtype, shape);
+  } else if (reinterpret_cast<uintptr_t>(data) % kAlignment == 0) {
+    MemmappedTensorBuffer* buf =
+        new MemmappedTensorBuffer(region_, data, num_bytes);
+    *tensor = buf->MakeTensor(dtype, shape);
+    buf->Unref();
+  } else {
+    // The contents were read into memory that is not suitably aligned, so
+    // copy them into a new tensor.
+    Tensor t(dtype, shape);
+    memcpy(const_cast<char*>(t.tensor_data().data()), data, num_bytes);
+    *tensor = std::move(t);
+  }
+  return Status::OK();
+}
+
+Status MemmappedCacheReader::ReadBytes(uint64 n, const char** data) {
+  if (n > region_->length() - offset_) {
+    return errors::DataLoss("Truncated cache file: ", filename_);
+  }
+  *data = static_cast<const char*>(region_->data()) + offset_;
+  offset_ += n;
+  return Status::OK();
+}
+
+Status MemmappedCacheReader::SkipToAlignment() {
+  const uint64 offset = AlignedOffset(offset_);
+  if (offset > region_->length()) {
+    return errors::DataLoss("Truncated cache file: ", filename_);
+  }
+  offset_ = offset;
+  return Status::OK();
+}
+
+}  // namespace dataset
+}  // namespace tensorflow
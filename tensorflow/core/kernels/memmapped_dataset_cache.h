@@ -0,0 +1,117 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef THIRD_PARTY_TENSORFLOW_CORE_KERNELS_MEMMAPPED_DATASET_CACHE_H_
+#define THIRD_PARTY_TENSORFLOW_CORE_KERNELS_MEMMAPPED_DATASET_CACHE_H_
+
+#include <memory>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace dataset {
+
+// A file cache of a dataset comprises `num_shards` shard files, which hold
+// the elements of the dataset in round-robin order, and a manifest, which is
+// written once every shard is complete.
+//
+// A shard file is a header followed by the elements written to it. Each
+// element is a component count followed by its components, and each
+// component is its dtype, shape and byte size followed by its data. The data
+// of every component starts at a multiple of `Allocator::kAllocatorAlignment`,
+// so that a reader can return tensors that alias a memory mapping of the file.
+
+// Returns the name of shard `shard` of `num_shards` of the cache at `prefix`.
+string MemmappedCacheShardFilename(StringPiece prefix, int64 shard,
+                                   int64 num_shards);
+
+// Returns the name of the manifest of the cache at `prefix`. The cache is
+// complete if and only if this file exists.
+string MemmappedCacheManifestFilename(StringPiece prefix);
+
+// Atomically writes the manifest of the cache at `prefix`.
+Status WriteMemmappedCacheManifest(Env* env, StringPiece prefix,
+                                   int64 num_shards, int64 num_elements);
+
+// Reads the manifest of the cache at `prefix`.
+Status ReadMemmappedCacheManifest(Env* env, StringPiece prefix,
+                                  int64* num_shards, int64* num_elements);
+
+// Appends elements to one shard file of a cache. Not thread-safe.
+class MemmappedCacheWriter {
+ public:
+  // Creates (or truncates) the shard file `filename`, and writes its header.
+  static Status Create(Env* env, const string& filename,
+                       std::unique_ptr<MemmappedCacheWriter>* writer);
+
+  // Appends `element` to the file. Only tensors of types that can be
+  // memcpy-ed and `DT_STRING` tensors can be written.
+  Status Append(const std::vector<Tensor>& element);
+
+  // Flushes and closes the file.
+  Status Close();
+
+ private:
+  explicit MemmappedCacheWriter(std::unique_ptr<WritableFile> file);
+
+  Status Write(StringPiece data);
+  Status PadToAlignment();
+
+  std::unique_ptr<WritableFile> file_;
+  uint64 offset_ = 0;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemmappedCacheWriter);
+};
+
+// Reads elements from one shard file of a cache, in the order that they were
+// appended. Not thread-safe.
+//
+// The file is mapped into memory with `Env::NewReadOnlyMemoryRegionFromFile()`
+// (or, on file systems that do not support that, read into memory), and the
+// tensors of types that can be memcpy-ed alias the mapping, which remains
+// valid until the last of them is destroyed. `DT_STRING` tensors are copied.
+class MemmappedCacheReader {
+ public:
+  static Status Create(Env* env, const string& filename,
+                       std::unique_ptr<MemmappedCacheReader>* reader);
+
+  // Reads the next element into `element`, or sets `*end_of_file` to true if
+  // every element has been read.
+  Status ReadElement(std::vector<Tensor>* element, bool* end_of_file);
+
+ private:
+  MemmappedCacheReader(string filename,
+                       std::shared_ptr<ReadOnlyMemoryRegion> region,
+                       uint64 offset);
+
+  Status ReadTensor(Tensor* tensor);
+  Status ReadBytes(uint64 n, const char** data);
+  Status SkipToAlignment();
+
+  const string filename_;
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  uint64 offset_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MemmappedCacheReader);
+};
+
+}  // namespace dataset
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_CORE_KERNELS_MEMMAPPED_DATASET_CACHE_H_
@@ -0,0 +1,159 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/kernels/memmapped_dataset_cache.h"
+
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace dataset {
+namespace {
+
+string Prefix(const string& name) {
+  return io::JoinPath(testing::TmpDir(), name);
+}
+
+std::vector<std::vector<Tensor>> TestElements() {
+  std::vector<std::vector<Tensor>> elements;
+  for (int i = 0; i < 3; ++i) {
+    elements.push_back(
+        {test::AsScalar<int64>(i),
+         test::AsTensor<float>({1.0f * i, 2.0f * i, 3.0f * i}, {3, 1}),
+         test::AsTensor<string>({"", strings::StrCat("element ", i)}),
+         Tensor(DT_DOUBLE, TensorShape({0, 2}))});
+  }
+  return elements;
+}
+
+void WriteShard(const string& filename,
+                const std::vector<std::vector<Tensor>>& elements) {
+  std::unique_ptr<MemmappedCacheWriter> writer;
+  TF_ASSERT_OK(
+      MemmappedCacheWriter::Create(Env::Default(), filename, &writer));
+  for (const auto& element : elements) {
+    TF_ASSERT_OK(writer->Append(element));
+  }
+  TF_ASSERT_OK(writer->Close());
+}
+
+TEST(MemmappedDatasetCacheTest, RoundTrip) {
+  const string filename =
+      MemmappedCacheShardFilename(Prefix("round_trip"), 0, 1);
+  const std::vector<std::vector<Tensor>> elements = TestElements();
+  WriteShard(filename, elements);
+
+  std::vector<std::vector<Tensor>> read_elements;
+  {
+    std::unique_ptr<MemmappedCacheReader> reader;
+    TF_ASSERT_OK(
+        MemmappedCacheReader::Create(Env::Default(), filename, &reader));
+    while (true) {
+      std::vector<Tensor> element;
+      bool end_of_file;
+      TF_ASSERT_OK(reader->ReadElement(&element, &end_of_file));
+      if (end_of_file) {
+        break;
+      }
+      read_elements.push_back(std::move(element));
+    }
+  }
+
+  // The tensors remain valid after the reader is destroyed.
+  ASSERT_EQ(elements.size(), read_elements.size());
+  for (int i = 0; i < elements.size(); ++i) {
+    ASSERT_EQ(elements[i].size(), read_elements[i].size());
+    test::ExpectTensorEqual<int64>(elements[i][0], read_elements[i][0]);
+    test::ExpectTensorEqual<float>(elements[i][1], read_elements[i][1]);
+    test::ExpectTensorEqual<string>(elements[i][2], read_elements[i][2]);
+    test::ExpectTensorEqual<double>(elements[i][3], read_elements[i][3]);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(
+                     read_elements[i][1].tensor_data().data()) %
+                     Allocator::kAllocatorAlignment);
+  }
+}
+
+TEST(MemmappedDatasetCacheTest, EmptyShard) {
+  const string filename = MemmappedCacheShardFilename(Prefix("empty"), 0, 1);
+  WriteShard(filename, {});
+
+  std::unique_ptr<MemmappedCacheReader> reader;
+  TF_ASSERT_OK(MemmappedCacheReader::Create(Env::Default(), filename, &reader));
+  std::vector<Tensor> element;
+  bool end_of_file;
+  TF_ASSERT_OK(reader->ReadElement(&element, &end_of_file));
+  EXPECT_TRUE(end_of_file);
+}
+
+TEST(MemmappedDatasetCacheTest, TruncatedShard) {
+  const string filename =
+      MemmappedCacheShardFilename(Prefix("truncated"), 0, 1);
+  WriteShard(filename, TestElements());
+  string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), filename, &contents));
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename,
+                                 contents.substr(0, contents.size() - 1)));
+
+  std::unique_ptr<MemmappedCacheReader> reader;
+  TF_ASSERT_OK(MemmappedCacheReader::Create(Env::Default(), filename, &reader));
+  Status s;
+  bool end_of_file = false;
+  while (s.ok() && !end_of_file) {
+    std::vector<Tensor> element;
+    s = reader->ReadElement(&element, &end_of_file);
+  }
+  EXPECT_TRUE(errors::IsDataLoss(s)) << s;
+}
+
+TEST(MemmappedDatasetCacheTest, InvalidShard) {
+  const string filename = MemmappedCacheShardFilename(Prefix("invalid"), 0, 1);
+  TF_ASSERT_OK(
+      WriteStringToFile(Env::Default(), filename, "not a cache file"));
+  std::unique_ptr<MemmappedCacheReader> reader;
+  EXPECT_TRUE(errors::IsDataLoss(
+      MemmappedCacheReader::Create(Env::Default(), filename, &reader)));
+}
+
+TEST(MemmappedDatasetCacheTest, UnsupportedType) {
+  std::unique_ptr<MemmappedCacheWriter> writer;
+  TF_ASSERT_OK(MemmappedCacheWriter::Create(
+      Env::Default(), MemmappedCacheShardFilename(Prefix("unsupported"), 0, 1),
+      &writer));
+  EXPECT_TRUE(errors::IsUnimplemented(
+      writer->Append({Tensor(DT_RESOURCE, TensorShape({}))})));
+}
+
+TEST(MemmappedDatasetCacheTest, Manifest) {
+  const string prefix = Prefix("manifest");
+  int64 num_shards;
+  int64 num_elements;
+  EXPECT_TRUE(errors::IsNotFound(ReadMemmappedCacheManifest(
+      Env::Default(), prefix, &num_shards, &num_elements)));
+
+  TF_ASSERT_OK(WriteMemmappedCacheManifest(Env::Default(), prefix, 4, 37));
+  TF_ASSERT_OK(ReadMemmappedCacheManifest(Env::Default(), prefix, &num_shards,
+                                          &num_elements));
+  EXPECT_EQ(4, num_shards);
+  EXPECT_EQ(37, num_elements);
+  EXPECT_EQ(prefix + ".cache-00001-of-00004",
+            MemmappedCacheShardFilename(prefix, 1, 4));
+}
+
+}  // namespace
+}  // namespace dataset
+}  // namespace tensorflow
@@ -182,29 +182,31 @@ struct FloatDepthwiseConvKernel<true, 0, 1> {
   static void Run(int num_output_pixels, int input_depth, int depth_multiplier,
                   const float* input_ptr, int input_ptr_increment,
                   const float* filter_ptr, float* acc_buffer_ptr) {
-    // Handle one output pixel at a time.
-    for (int outp = 0; outp < num_output_pixels; outp++) {
-      const float* local_filter_ptr = filter_ptr;
-      const float* local_input_ptr = input_ptr;
-      int ic = 0;
-      // Handle 16 input channels at a time.
-      for (; ic <= input_depth - 16; ic += 16) {
-        // Load the filters
-        float32x4_t filter[4];
-        for (int i = 0; i < 4; i++) {
-          filter[i] = vld1q_f32(local_filter_ptr + 4 * i);
-        }
-        local_filter_ptr += 16;
+    // The output depth is the input depth, so the accumulators of successive
+    // output pixels are input_depth apart. Each block of input channels keeps
+    // its filters in registers while it walks along the output pixels, which
+    // matters for strided convolutions where the input pixels aren't reused.
+    int ic = 0;
+    // Handle 16 input channels at a time.
+    for (; ic <= input_depth - 16; ic += 16) {
+      // Load the filters
+      float32x4_t filter[4];
+      for (int i = 0; i < 4; i++) {
+        filter[i] = vld1q_f32(filter_ptr + ic + 4 * i);
+      }
+      const float* local_input_ptr = input_ptr + ic;
+      float* local_acc_buffer_ptr = acc_buffer_ptr + ic;
+      for (int outp = 0; outp < num_output_pixels; outp++) {
         // Load the inputs
         float32x4_t input[4];
         for (int i = 0; i < 4; i++) {
           input[i] = vld1q_f32(local_input_ptr + 4 * i);
         }
-        local_input_ptr += 16;
+        local_input_ptr += input_ptr_increment;
         // Load the accumulators from acc_buffer
         float32x4_t acc[4];
         for (int i = 0; i < 4; i++) {
-          acc[i] = vld1q_f32(acc_buffer_ptr + 4 * i);
+          acc[i] = vld1q_f32(local_acc_buffer_ptr + 4 * i);
         }
         // Multiply-accumulate
         for (int i = 0; i < 4; i++) {
@@ -212,36 +214,61 @@ struct FloatDepthwiseConvKernel<true, 0, 1> {
         }
         // Store the accumulators back to acc_buffer
         for (int i = 0; i < 4; i++) {
-          vst1q_f32(acc_buffer_ptr + 4 * i, acc[i]);
+          vst1q_f32(local_acc_buffer_ptr + 4 * i, acc[i]);
         }
-        acc_buffer_ptr += 16;
+        local_acc_buffer_ptr += input_depth;
       }
-      // Handle 4 input channels at a time.
-      for (; ic <= input_depth - 4; ic += 4) {
-        // Load the filters
-        float32x4_t filter;
-        filter = vld1q_f32(local_filter_ptr);
-        local_filter_ptr += 4;
+    }
+    // Handle 4 input channels at a time.
+    for (; ic <= input_depth - 4; ic += 4) {
+      // Load the filters
+      const float32x4_t filter = vld1q_f32(filter_ptr + ic);
+      const float* local_input_ptr = input_ptr + ic;
+      float* local_acc_buffer_ptr = acc_buffer_ptr + ic;
+      int outp = 0;
+      // Handle 2 output pixels at a time.
+      for (; outp <= num_output_pixels - 2; outp += 2) {
         // Load the inputs
-        float32x4_t input;
-        input = vld1q_f32(local_input_ptr);
-        local_input_ptr += 4;
+        float32x4_t input[2];
+        for (int i = 0; i < 2; i++) {
+          input[i] = vld1q_f32(local_input_ptr + i * input_ptr_increment);
+        }
+        local_input_ptr += 2 * input_ptr_increment;
         // Load the accumulators from acc_buffer
-        float32x4_t acc;
-        acc = vld1q_f32(acc_buffer_ptr);
+        float32x4_t acc[2];
+        for (int i = 0; i < 2; i++) {
+          acc[i] = vld1q_f32(local_acc_buffer_ptr + i * input_depth);
+        }
         // Multiply-accumulate
-        acc = vmlaq_f32(acc, input, filter);
+        for (int i = 0; i < 2; i++) {
+          acc[i] = vmlaq_f32(acc[i], input[i], filter);
+        }
         // Store the accumulators back to acc_buffer
-        vst1q_f32(acc_buffer_ptr, acc);
-        acc_buffer_ptr += 4;
+        for (int i = 0; i < 2; i++) {
+          vst1q_f32(local_acc_buffer_ptr + i * input_depth, acc[i]);
+        }
+        local_acc_buffer_ptr += 2 * input_depth;
       }
-      // Handle one input channel at a time.
-      for (; ic < input_depth; ic++) {
-        const float input_val = *local_input_ptr++;
-        const float filter_val = *local_filter_ptr++;
-        *acc_buffer_ptr++ += filter_val * input_val;
+      // Handle one output pixel at a time.
+      for (; outp < num_output_pixels; outp++) {
+        const float32x4_t input = vld1q_f32(local_input_ptr);
+        local_input_ptr += input_ptr_increment;
+        float32x4_t acc = vld1q_f32(local_acc_buffer_ptr);
+        acc = vmlaq_f32(acc, input, filter);
+        vst1q_f32(local_acc_buffer_ptr, acc);
+        local_acc_buffer_ptr += input_depth;
+      }
+    }
+    // Handle one input channel at a time.
+    for (; ic < input_depth; ic++) {
+      const float filter_val = filter_ptr[ic];
+      const float* local_input_ptr = input_ptr + ic;
+      float* local_acc_buffer_ptr = acc_buffer_ptr + ic;
+      for (int outp = 0; outp < num_output_pixels; outp++) {
+        *local_acc_buffer_ptr += filter_val * *local_input_ptr;
+        local_input_ptr += input_ptr_increment;
+        local_acc_buffer_ptr += input_depth;
       }
-      input_ptr += input_ptr_increment;
     }
   }
 };
@@ -549,12 +576,17 @@ inline void DepthwiseConvInitAccBuffer(int num_output_pixels, int output_depth,
   }
 }
 
+// Computes the output rows [first_row, last_row) of a DepthwiseConv, where
+// the rows of all the batches are numbered one after the other. Disjoint
+// ranges of rows can be computed concurrently.
 template <FusedActivationFunctionType Ac>
-void DepthwiseConv(const float* input_data, const Dims<4>& input_dims,
-                   const float* filter_data, const Dims<4>& filter_dims,
-                   const float* bias_data, const Dims<4>& bias_dims, int stride,
-                   int pad_width, int pad_height, int depth_multiplier,
-                   float* output_data, const Dims<4>& output_dims) {
+void DepthwiseConvRows(const float* input_data, const Dims<4>& input_dims,
+                       const float* filter_data, const Dims<4>& filter_dims,
+                       const float* bias_data, const Dims<4>& bias_dims,
+                       int stride, int pad_width, int pad_height,
+                       int depth_multiplier, float* output_data,
+                       const Dims<4>& output_dims, int first_row,
+                       int last_row) {
   gemmlowp::ScopedProfilingLabel label("DepthwiseConv");
   static_assert(Ac == FusedActivationFunctionType::kNone ||
                     Ac == FusedActivationFunctionType::kRelu ||
@@ -625,100 +657,115 @@ void DepthwiseConv(const float* input_data, const Dims<4>& input_dims,
 #undef TF_NEON_USE_DEPTHWISECONV_KERNEL
 
   // Now that we have determined row_accum_func, we can start work.
-  float* output_ptr = output_data;
-  for (int b = 0; b < batches; ++b) {
-    for (int out_y = 0; out_y < output_height; ++out_y) {
-      const int in_y_origin = (out_y * stride) - pad_height;
-      const int filter_y_start = std::max(0, -in_y_origin);
-      const int filter_y_end =
-          std::min(filter_height, input_height - in_y_origin);
-      for (int out_x_buffer_start = 0; out_x_buffer_start < output_width;
-           out_x_buffer_start += kOutputPixelsInAccBuffer) {
-        const int out_x_buffer_end = std::min(
-            output_width, out_x_buffer_start + kOutputPixelsInAccBuffer);
-        // We call a 'pixel' a group of activation that share all but the
-        // 'depth'/'channel' coordinate. num_output_pixels is the number of
-        // output pixels that we will accumulate in this loop iteration.
-        const int num_output_pixels = out_x_buffer_end - out_x_buffer_start;
-        // Initialize our local accumulator with the bias values, so we don't
-        // have to add them later.
-        DepthwiseConvInitAccBuffer(num_output_pixels, output_depth, bias_data,
-                                   acc_buffer);
-        // Accumulation loop. Most of the time should be spent in here.
-        for (int filter_y = filter_y_start; filter_y < filter_y_end;
-             ++filter_y) {
-          const int in_y = in_y_origin + filter_y;
-          row_accum_func(stride, input_depth, input_width,
-                         input_data + in_y * input_dims.strides[2] +
-                             b * input_dims.strides[3],
-                         pad_width, depth_multiplier, filter_width,
-                         filter_data + filter_y * filter_dims.strides[2],
-                         out_x_buffer_start, out_x_buffer_end, output_depth,
-                         acc_buffer);
-        }
-        // Finished accumulating. Now store to destination.
-        const int num_output_values = output_depth * num_output_pixels;
-        int i = 0;
+  DCHECK_LE(0, first_row);
+  DCHECK_LE(last_row, batches * output_height);
+  float* output_ptr = output_data + first_row * output_dims.strides[2];
+  for (int row = first_row; row < last_row; ++row) {
+    const int b = row / output_height;
+    const int out_y = row % output_height;
+    const int in_y_origin = (out_y * stride) - pad_height;
+    const int filter_y_start = std::max(0, -in_y_origin);
+    const int filter_y_end =
+        std::min(filter_height, input_height - in_y_origin);
+    for (int out_x_buffer_start = 0; out_x_buffer_start < output_width;
+         out_x_buffer_start += kOutputPixelsInAccBuffer) {
+      const int out_x_buffer_end = std::min(
+          output_width, out_x_buffer_start + kOutputPixelsInAccBuffer);
+      // We call a 'pixel' a group of activation that share all but the
+      // 'depth'/'channel' coordinate. num_output_pixels is the number of
+      // output pixels that we will accumulate in this loop iteration.
+      const int num_output_pixels = out_x_buffer_end - out_x_buffer_start;
+      // Initialize our local accumulator with the bias values, so we don't
+      // have to add them later.
+      DepthwiseConvInitAccBuffer(num_output_pixels, output_depth, bias_data,
+                                 acc_buffer);
+      // Accumulation loop. Most of the time should be spent in here.
+      for (int filter_y = filter_y_start; filter_y < filter_y_end;
+           ++filter_y) {
+        const int in_y = in_y_origin + filter_y;
+        row_accum_func(stride, input_depth, input_width,
+                       input_data + in_y * input_dims.strides[2] +
+                           b * input_dims.strides[3],
+                       pad_width, depth_multiplier, filter_width,
+                       filter_data + filter_y * filter_dims.strides[2],
+                       out_x_buffer_start, out_x_buffer_end, output_depth,
+                       acc_buffer);
+      }
+      // Finished accumulating. Now store to destination.
+      const int num_output_values = output_depth * num_output_pixels;
+      int i = 0;
 // TODO(benoitjacob) optimized code goes here
 #ifdef USE_NEON
-        // Handle 16 values at a time
-        for (; i <= num_output_values - 16; i += 16) {
-          float32x4_t acc[4];
+      // Handle 16 values at a time
+      for (; i <= num_output_values - 16; i += 16) {
+        float32x4_t acc[4];
+        for (int k = 0; k < 4; k++) {
+          acc[k] = vld1q_f32(acc_buffer + i + 4 * k);
+        }
+        if (Ac == FusedActivationFunctionType::kRelu) {
           for (int k = 0; k < 4; k++) {
-            acc[k] = vld1q_f32(acc_buffer + i + 4 * k);
+            acc[k] = vmaxq_f32(vdupq_n_f32(0.f), acc[k]);
           }
-          if (Ac == FusedActivationFunctionType::kRelu) {
-            for (int k = 0; k < 4; k++) {
-              acc[k] = vmaxq_f32(vdupq_n_f32(0.f), acc[k]);
-            }
-          } else if (Ac == FusedActivationFunctionType::kRelu6) {
-            for (int k = 0; k < 4; k++) {
-              acc[k] = vmaxq_f32(vdupq_n_f32(0.f),
-                                 vminq_f32(vdupq_n_f32(6.f), acc[k]));
-            }
-          } else if (Ac == FusedActivationFunctionType::kRelu1) {
-            for (int k = 0; k < 4; k++) {
-              acc[k] = vmaxq_f32(vdupq_n_f32(-1.f),
-                                 vminq_f32(vdupq_n_f32(1.f), acc[k]));
-            }
+        } else if (Ac == FusedActivationFunctionType::kRelu6) {
+          for (int k = 0; k < 4; k++) {
+            acc[k] = vmaxq_f32(vdupq_n_f32(0.f),
+                               vminq_f32(vdupq_n_f32(6.f), acc[k]));
           }
+        } else if (Ac == FusedActivationFunctionType::kRelu1) {
           for (int k = 0; k < 4; k++) {
-            vst1q_f32(output_ptr + 4 * k, acc[k]);
+            acc[k] = vmaxq_f32(vdupq_n_f32(-1.f),
+                               vminq_f32(vdupq_n_f32(1.f), acc[k]));
           }
-          output_ptr += 16;
         }
-        // Handle 4 values at a time
-        for (; i <= num_output_values - 4; i += 4) {
-          float32x4_t acc = vld1q_f32(acc_buffer + i);
-          if (Ac == FusedActivationFunctionType::kRelu) {
-            acc = vmaxq_f32(vdupq_n_f32(0.f), acc);
-          } else if (Ac == FusedActivationFunctionType::kRelu6) {
-            acc = vmaxq_f32(vdupq_n_f32(0.f), vminq_f32(vdupq_n_f32(6.f), acc));
-          } else if (Ac == FusedActivationFunctionType::kRelu1) {
-            acc =
-                vmaxq_f32(vdupq_n_f32(-1.f), vminq_f32(vdupq_n_f32(1.f), acc));
-          }
-          vst1q_f32(output_ptr, acc);
-          output_ptr += 4;
+        for (int k = 0; k < 4; k++) {
+          vst1q_f32(output_ptr + 4 * k, acc[k]);
         }
+        output_ptr += 16;
+      }
+      // Handle 4 values at a time
+      for (; i <= num_output_values - 4; i += 4) {
+        float32x4_t acc = vld1q_f32(acc_buffer + i);
+        if (Ac == FusedActivationFunctionType::kRelu) {
+          acc = vmaxq_f32(vdupq_n_f32(0.f), acc);
+        } else if (Ac == FusedActivationFunctionType::kRelu6) {
+          acc = vmaxq_f32(vdupq_n_f32(0.f), vminq_f32(vdupq_n_f32(6.f), acc));
+        } else if (Ac == FusedActivationFunctionType::kRelu1) {
+          acc =
+              vmaxq_f32(vdupq_n_f32(-1.f), vminq_f32(vdupq_n_f32(1.f), acc));
+        }
+        vst1q_f32(output_ptr, acc);
+        output_ptr += 4;
+      }
 #endif
-        // Handle leftover values, one by one. This is very slow.
-        for (; i < num_output_values; i++) {
-          float acc = acc_buffer[i];
-          if (Ac == FusedActivationFunctionType::kRelu) {
-            acc = std::max(0.f, acc);
-          } else if (Ac == FusedActivationFunctionType::kRelu6) {
-            acc = std::max(0.f, std::min(6.f, acc));
-          } else if (Ac == FusedActivationFunctionType::kRelu1) {
-            acc = std::max(-1.f, std::min(1.f, acc));
-          }
-          *output_ptr++ = acc;
+      // Handle leftover values, one by one. This is very slow.
+      for (; i < num_output_values; i++) {
+        float acc = acc_buffer[i];
+        if (Ac == FusedActivationFunctionType::kRelu) {
+          acc = std::max(0.f, acc);
+        } else if (Ac == FusedActivationFunctionType::kRelu6) {
+          acc = std::max(0.f, std::min(6.f, acc));
+        } else if (Ac == FusedActivationFunctionType::kRelu1) {
+          acc = std::max(-1.f, std::min(1.f, acc));
         }
+        *output_ptr++ = acc;
       }
     }
   }
 }
 
+template <FusedActivationFunctionType Ac>
+void DepthwiseConv(const float* input_data, const Dims<4>& input_dims,
+                   const float* filter_data, const Dims<4>& filter_dims,
+                   const float* bias_data, const Dims<4>& bias_dims, int stride,
+                   int pad_width, int pad_height, int depth_multiplier,
+                   float* output_data, const Dims<4>& output_dims) {
+  DepthwiseConvRows<Ac>(
+      input_data, input_dims, filter_data, filter_dims, bias_data, bias_dims,
+      stride, pad_width, pad_height, depth_multiplier, output_data,
+      output_dims, 0,
+      ArraySize(output_dims, 3) * ArraySize(output_dims, 2));
+}
+
 }  // end namespace neon
 }  // end namespace tensorflow
 
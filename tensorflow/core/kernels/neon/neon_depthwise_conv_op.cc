@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/padding.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -131,10 +132,20 @@ class NeonDepthwiseConv2dNativeOp : public BinaryOp<float> {
         bias_size * sizeof(float), Allocator::kAllocatorAlignment));
     memset(bias_ptr, 0, bias_size * sizeof(float));
 
-    neon::DepthwiseConv<neon::FusedActivationFunctionType::kNone>(
-        input_ptr, input_neon_dims, filter_ptr, filter_neon_dims, bias_ptr,
-        bias_neon_dims, stride, pad_cols, pad_rows, depth_multiplier,
-        output_ptr, ToNeonDims(out_shape));
+    const auto output_neon_dims = ToNeonDims(out_shape);
+
+    // The output rows of all the batches are computed in parallel.
+    auto shard = [&](int64 start, int64 limit) {
+      neon::DepthwiseConvRows<neon::FusedActivationFunctionType::kNone>(
+          input_ptr, input_neon_dims, filter_ptr, filter_neon_dims, bias_ptr,
+          bias_neon_dims, stride, pad_cols, pad_rows, depth_multiplier,
+          output_ptr, output_neon_dims, start, limit);
+    };
+    const int64 cost_per_row =
+        out_cols * out_depth * filter_rows * filter_cols;
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          batch * out_rows, cost_per_row, shard);
 
     port::AlignedFree(bias_ptr);
   }
@@ -16,6 +16,7 @@ limitations under the License.
 // See docs in ../ops/data_flow_ops.cc.
 
 #include <deque>
+#include <memory>
 #include <vector>
 
 #include "tensorflow/core/framework/register_types.h"
@@ -52,18 +53,6 @@ Status PaddingFIFOQueue::Initialize() {
   return Status::OK();
 }
 
-/* static */
-Status PaddingFIFOQueue::GetElementComponent(
-    const PaddingFIFOQueue::Tuple& tuple, int component, OpKernelContext* ctx,
-    PersistentTensor* out_tensor) {
-  TensorShape element_shape(tuple[component].shape());
-  Tensor* element_access = nullptr;
-  TF_RETURN_IF_ERROR(ctx->allocate_persistent(
-      tuple[component].dtype(), element_shape, out_tensor, &element_access));
-  *element_access = tuple[component];
-  return Status::OK();
-}
-
 void PaddingFIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
                                       bool allow_small_batch,
                                       CallbackWithTuple callback) {
@@ -101,28 +90,17 @@ void PaddingFIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
             if (closed_ && queue_size < attempt->elements_requested) {
               // If we don't have enough for a full dequeue, we have
               // to reset the attempt tuple.
-              if (!attempt->tuples.empty()) {
-                // Restore already-dequeued elements to the front of the queue.
-                for (int64 i = attempt->tuples.size() - 1; i >= 0; --i) {
-                  for (int j = 0; j < num_components(); ++j) {
-                    PersistentTensor element;
-                    Status s = GetElementComponent(attempt->tuples[i], j,
-                                                   attempt->context, &element);
-                    if (!s.ok()) {
-                      attempt->context->SetStatus(
-                          errors::DataLoss("Failed to restore element from "
-                                           "partially-dequeued batch "
-                                           "to PaddingFIFOQueue: ",
-                                           s.error_message()));
-                    }
-                    queues_[j].push_front(element);
-                  }
+              // Restore already-dequeued elements to the front of the queue.
+              for (int64 i = attempt->tuples.size() - 1; i >= 0; --i) {
+                for (int j = 0; j < num_components(); ++j) {
+                  queues_[j].push_front(
+                      PersistentTensor(attempt->tuples[i][j]));
                 }
               }
+              attempt->tuples.clear();
               if (allow_small_batch && !queues_[0].empty()) {
                 // Request all remaining elements in the queue.
                 queue_size = queues_[0].size();
-                attempt->tuples.clear();
                 attempt->elements_requested = queue_size;
               } else {
                 if (allow_small_batch) {
@@ -147,73 +125,23 @@ void PaddingFIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
               result = kProgress;
               Tuple tuple;
               DequeueLocked(attempt->context, &tuple);
-              attempt->tuples.push_back(tuple);
-              tuple.clear();
+              attempt->tuples.push_back(std::move(tuple));
               --attempt->elements_requested;
 
               if (attempt->elements_requested == 0) {
-                // Finished.  Allocate attempt->tuple and
-                // copy from attempt->tuples to attempt->tuple.
-                attempt->tuple.reserve(num_components());
-                const std::vector<Tuple>& tuples = attempt->tuples;
-
-                std::vector<bool> dynamic_shape;
-                const int64 batch_size = tuples.size();
-
-                for (int i = 0; i < num_components(); ++i) {
-                  const PartialTensorShape partial_shape =
-                      PartialTensorShape({batch_size})
-                          .Concatenate(partial_shapes_[i]);
-                  TensorShape shape({batch_size});
-
-                  for (int j = 0; j < partial_shape.dims() - 1; ++j) {
-                    if (partial_shape.dim_size(j + 1) > -1) {
-                      shape.AddDim(partial_shape.dim_size(j + 1));
-                    } else {
-                      // Expand sizes to match.
-                      int64 max_val = 0;
-                      for (const Tuple& t : tuples) {
-                        max_val = std::max(max_val, t[i].shape().dim_size(j));
-                      }
-                      shape.AddDim(max_val);
-                    }
-                  }
-
-                  Tensor element;
-                  attempt->context->SetStatus(attempt->context->allocate_temp(
-                      component_dtypes_[i], shape, &element));
-                  if (!attempt->context->status().ok()) return kComplete;
-
-                  bool has_dynamic_shape = !partial_shape.IsFullyDefined();
-                  if (has_dynamic_shape) {
-                    // Set all values to zero because not all values
-                    // will get written over.
-                    attempt->context->SetStatus(SetElementZero(&element));
-                    if (!attempt->context->status().ok()) return kComplete;
-                  }
-
-                  dynamic_shape.push_back(has_dynamic_shape);
-
-                  // TODO(ebrevdo): should this be a persistent tensor?
-                  attempt->tuple.emplace_back(element);
-                }
-
-                for (size_t index = 0; index < tuples.size(); ++index) {
-                  for (int i = 0; i < num_components(); ++i) {
-                    if (dynamic_shape[i]) {
-                      // Slightly slower copy operation
-                      attempt->context->SetStatus(CopyElementToLargerSlice(
-                          tuples[index][i], &attempt->tuple[i], index));
-                    } else {
-                      attempt->context->SetStatus(CopyElementToSlice(
-                          tuples[index][i], &attempt->tuple[i], index));
-                    }
-                    if (!attempt->context->status().ok()) return kComplete;
+                // Finished.  The batch is padded and filled in by
+                // BatchElements() once mu_ is released.
+                OpKernelContext* ctx = attempt->context;
+                std::shared_ptr<std::vector<Tuple>> elements(
+                    new std::vector<Tuple>);
+                elements->swap(attempt->tuples);
+                attempt->done_callback = [this, ctx, callback, elements]() {
+                  Tuple tuple;
+                  Status s = BatchElements(ctx, *elements, &tuple);
+                  if (!s.ok()) {
+                    ctx->SetStatus(s);
+                    tuple.clear();
                   }
-                }
-                tuple = attempt->tuple;
-                attempt->tuples.clear();
-                attempt->done_callback = [callback, tuple]() {
                   callback(tuple);
                 };
                 return kComplete;
@@ -231,6 +159,65 @@ void PaddingFIFOQueue::TryDequeueMany(int num_elements, OpKernelContext* ctx,
   }
 }
 
+Status PaddingFIFOQueue::BatchElements(OpKernelContext* ctx,
+                                       const std::vector<Tuple>& elements,
+                                       Tuple* tuple) {
+  std::vector<bool> dynamic_shape;
+  const int64 batch_size = elements.size();
+  int64 element_bytes = 0;
+  tuple->reserve(num_components());
+
+  for (int i = 0; i < num_components(); ++i) {
+    const PartialTensorShape partial_shape =
+        PartialTensorShape({batch_size}).Concatenate(partial_shapes_[i]);
+    TensorShape shape({batch_size});
+
+    for (int j = 0; j < partial_shape.dims() - 1; ++j) {
+      if (partial_shape.dim_size(j + 1) > -1) {
+        shape.AddDim(partial_shape.dim_size(j + 1));
+      } else {
+        // Expand sizes to match.
+        int64 max_val = 0;
+        for (const Tuple& t : elements) {
+          max_val = std::max(max_val, t[i].shape().dim_size(j));
+        }
+        shape.AddDim(max_val);
+      }
+    }
+
+    Tensor component;
+    TF_RETURN_IF_ERROR(
+        ctx->allocate_temp(component_dtypes_[i], shape, &component));
+    dynamic_shape.push_back(!partial_shape.IsFullyDefined());
+    element_bytes += component.TotalBytes() / batch_size;
+
+    // TODO(ebrevdo): should this be a persistent tensor?
+    tuple->push_back(component);
+  }
+
+  // Each slice is zeroed only if its element is smaller than it, right
+  // before the element is copied in, rather than zeroing the whole batch up
+  // front.
+  return ParallelCopy(
+      ctx, batch_size, element_bytes,
+      [&elements, &dynamic_shape, batch_size, tuple](int64 index) {
+        for (size_t i = 0; i < tuple->size(); ++i) {
+          const Tensor& element = elements[index][i];
+          Tensor* component = &(*tuple)[i];
+          if (!dynamic_shape[i] ||
+              element.NumElements() == component->NumElements() / batch_size) {
+            TF_RETURN_IF_ERROR(CopyElementToSlice(element, component, index));
+          } else {
+            // Slightly slower copy operation
+            TF_RETURN_IF_ERROR(SetSliceZero(component, index));
+            TF_RETURN_IF_ERROR(
+                CopyElementToLargerSlice(element, component, index));
+          }
+        }
+        return Status::OK();
+      });
+}
+
 Status PaddingFIFOQueue::ValidateTuple(const Tuple& tuple) {
   TF_RETURN_IF_ERROR(ValidateTupleCommon(tuple));
   for (size_t i = 0; i < tuple.size(); ++i) {
@@ -379,16 +366,16 @@ Status PaddingFIFOQueue::CopyElementToLargerSlice(const Tensor& element,
 }
 
 // Static method
-Status PaddingFIFOQueue::SetElementZero(Tensor* element) {
-#define HANDLE_TYPE(T)                                \
-  if (element->dtype() == DataTypeToEnum<T>::value) { \
-    element->flat<T>().setConstant(T());              \
-    return Status::OK();                              \
+Status PaddingFIFOQueue::SetSliceZero(Tensor* parent, int64 index) {
+#define HANDLE_TYPE(T)                                             \
+  if (parent->dtype() == DataTypeToEnum<T>::value) {               \
+    parent->flat_outer_dims<T>().chip(index, 0).setConstant(T()); \
+    return Status::OK();                                           \
   }
   TF_CALL_ALL_TYPES(HANDLE_TYPE);
 #undef HANDLE_TYPE
-  return errors::Unimplemented("SetElementZero Unhandled data type: ",
-                               element->dtype());
+  return errors::Unimplemented("SetSliceZero Unhandled data type: ",
+                               parent->dtype());
 }
 
 std::vector<TensorShape> PaddingFIFOQueue::ConvertShapesPartialDimensionsToZero(
@@ -59,8 +59,13 @@ class PaddingFIFOQueue : public FIFOQueue {
   static std::vector<TensorShape> ConvertShapesPartialDimensionsToZero(
       const gtl::ArraySlice<PartialTensorShape>& partial_shapes);
 
-  // Sets the values in the given element to zero.
-  static Status SetElementZero(Tensor* element);
+  // Pads the elements to the largest size of each unknown dimension.
+  Status BatchElements(OpKernelContext* ctx, const std::vector<Tuple>& elements,
+                       Tuple* tuple) override;
+
+  // Sets the values in the index^th slice (in the first dimension) of parent
+  // to zero.
+  static Status SetSliceZero(Tensor* parent, int64 index);
 
   // Copies element into the index^th slice (in the first dimension)
   // of parent.  Allows for the parent's slice to have a larger size
@@ -74,10 +79,6 @@ class PaddingFIFOQueue : public FIFOQueue {
  private:
   ~PaddingFIFOQueue() override {}
 
-  static Status GetElementComponent(const PaddingFIFOQueue::Tuple& tuple,
-                                    int component, OpKernelContext* ctx,
-                                    PersistentTensor* out_tensor);
-
   static Status IsSameSizeExceptZerosInFirst(const TensorShape& first,
                                              const TensorShape& second);
 
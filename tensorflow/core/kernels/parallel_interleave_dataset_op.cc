@@ -0,0 +1,386 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <deque>
+
+#include "tensorflow/core/kernels/dataset.h"
+
+#include "tensorflow/core/common_runtime/function.h"
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/captured_function.h"
+#include "tensorflow/core/kernels/dataset_utils.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+
+namespace tensorflow {
+
+namespace {
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class ParallelInterleaveDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit ParallelInterleaveDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx),
+        graph_def_version_(ctx->graph_def_version()) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("f", &func_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    OpInputList inputs;
+    OP_REQUIRES_OK(ctx, ctx->input_list("other_arguments", &inputs));
+    std::vector<Tensor> other_arguments;
+    other_arguments.reserve(inputs.size());
+    for (const Tensor& t : inputs) {
+      other_arguments.push_back(t);
+    }
+
+    int64 cycle_length;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument(ctx, "cycle_length", &cycle_length));
+    OP_REQUIRES(ctx, cycle_length > 0,
+                errors::InvalidArgument("`cycle_length` must be > 0"));
+
+    int64 block_length;
+    OP_REQUIRES_OK(ctx,
+                   ParseScalarArgument(ctx, "block_length", &block_length));
+    OP_REQUIRES(ctx, block_length > 0,
+                errors::InvalidArgument("`block_length` must be > 0"));
+
+    bool sloppy;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, "sloppy", &sloppy));
+
+    int64 buffer_output_elements;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, "buffer_output_elements",
+                                            &buffer_output_elements));
+    OP_REQUIRES(
+        ctx, buffer_output_elements > 0,
+        errors::InvalidArgument("`buffer_output_elements` must be > 0"));
+
+    std::unique_ptr<CapturedFunction> captured_func;
+    OP_REQUIRES_OK(ctx, CapturedFunction::Create(ctx, func_, graph_def_version_,
+                                                 std::move(other_arguments),
+                                                 &captured_func));
+
+    *output = new Dataset(input, std::move(captured_func), cycle_length,
+                          block_length, sloppy, buffer_output_elements,
+                          output_types_, output_shapes_);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(const DatasetBase* input,
+            std::unique_ptr<CapturedFunction> captured_func,
+            int64 cycle_length, int64 block_length, bool sloppy,
+            int64 buffer_output_elements, const DataTypeVector& output_types,
+            const std::vector<PartialTensorShape>& output_shapes)
+        : input_(input),
+          captured_func_(std::move(captured_func)),
+          cycle_length_(cycle_length),
+          block_length_(block_length),
+          sloppy_(sloppy),
+          buffer_output_elements_(buffer_output_elements),
+          output_types_(output_types),
+          output_shapes_(output_shapes) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal() const override {
+      return std::unique_ptr<IteratorBase>(new Iterator(this));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return output_types_;
+    }
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() override {
+      return "ParallelInterleaveDatasetOp::Dataset";
+    }
+
+   private:
+    // The iterator runs one worker thread per slot of the cycle. When a
+    // slot is opened, its worker applies `f` to an input element and
+    // buffers up to `buffer_output_elements` elements of the resulting
+    // dataset, so that the `cycle_length` datasets are read concurrently.
+    //
+    // `GetNext()` visits the slots in order, taking `block_length`
+    // elements from each. When it finds that the dataset in a slot is
+    // exhausted, it reopens the slot with the next input element and
+    // moves on to the next slot, which gives the new worker a full cycle
+    // to produce its first elements. Because slots are only reopened by
+    // `GetNext()`, the order of the output is deterministic unless
+    // `sloppy` is true, in which case `GetNext()` takes an element from
+    // any other slot rather than waiting for the current one.
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset),
+            input_impl_(dataset->input_->MakeIterator()),
+            workers_(dataset->cycle_length_) {}
+
+      ~Iterator() override {
+        {
+          mutex_lock l(mu_);
+          cancelled_ = true;
+          for (WorkerState& worker : workers_) {
+            worker.cond_var.notify_all();
+          }
+        }
+        // Join the worker threads before destroying the state they use.
+        worker_threads_.clear();
+      }
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(EnsureWorkerThreadsStarted(ctx));
+        while (true) {
+          if (num_open_ == 0 && end_of_input_) {
+            *end_of_sequence = true;
+            return Status::OK();
+          }
+
+          WorkerState* current = &workers_[cycle_index_];
+          if (!current->is_open) {
+            // Open the slot with the next input element (if any) and
+            // move on, so that its worker has a full cycle to start.
+            TF_RETURN_IF_ERROR(OpenSlot(ctx, current));
+            AdvanceToNextInCycle();
+            continue;
+          }
+
+          if (!current->outputs.empty()) {
+            Status s = ConsumeElement(current, out_tensors, end_of_sequence);
+            if (++block_index_ == dataset()->block_length_) {
+              AdvanceToNextInCycle();
+            }
+            return s;
+          }
+
+          if (current->is_producing) {
+            if (dataset()->sloppy_) {
+              for (WorkerState& worker : workers_) {
+                if (worker.is_open && !worker.outputs.empty()) {
+                  return ConsumeElement(&worker, out_tensors,
+                                        end_of_sequence);
+                }
+              }
+            }
+            consumer_cond_var_.wait(l);
+            continue;
+          }
+
+          // The dataset in the current slot is exhausted, so the slot
+          // will be reopened on the next iteration.
+          current->is_open = false;
+          --num_open_;
+        }
+      }
+
+     private:
+      // An element produced by a worker thread, comprising a status and
+      // (if that status is OK) the element's components.
+      struct OutputElement {
+        Status status;
+        std::vector<Tensor> output;
+      };
+
+      struct WorkerState {
+        // The input element that the worker thread should apply `f` to,
+        // when it is not producing.
+        std::vector<Tensor> input;
+        // True from the time that `GetNext()` opens the slot until
+        // `GetNext()` observes that its dataset is exhausted.
+        bool is_open = false;
+        // True while the worker thread may add to `outputs`.
+        bool is_producing = false;
+        // Elements produced by the worker thread that have not been
+        // consumed yet.
+        std::deque<OutputElement> outputs;
+        // Notifies the worker thread of a new input element, of space in
+        // `outputs`, or of cancellation.
+        condition_variable cond_var;
+      };
+
+      Status EnsureWorkerThreadsStarted(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (worker_threads_.empty()) {
+          // `ctx` is only valid for the duration of this call, so the
+          // worker threads use a copy of it, including its runner for
+          // the functions that they call.
+          IteratorContext::Params params;
+          params.env = ctx->env();
+          params.resource_manager = ctx->resource_manager();
+          params.runner = *(ctx->runner());
+          iter_ctx_.reset(new IteratorContext(std::move(params)));
+          worker_threads_.reserve(dataset()->cycle_length_);
+          for (int64 i = 0; i < dataset()->cycle_length_; ++i) {
+            worker_threads_.emplace_back(ctx->env()->StartThread(
+                {}, strings::StrCat("parallel_interleave_worker_", i),
+                [this, i]() { WorkerThread(&workers_[i]); }));
+          }
+          // Open every slot up front, so that the workers start reading
+          // concurrently. If this fails, `GetNext()` opens the remaining
+          // slots when it reaches them.
+          for (int64 i = 0; i < dataset()->cycle_length_; ++i) {
+            TF_RETURN_IF_ERROR(OpenSlot(ctx, &workers_[i]));
+          }
+        }
+        return Status::OK();
+      }
+
+      // Hands the next input element, if any, to the worker for `slot`.
+      Status OpenSlot(IteratorContext* ctx, WorkerState* slot)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (end_of_input_) {
+          return Status::OK();
+        }
+        std::vector<Tensor> args;
+        TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &args, &end_of_input_));
+        if (end_of_input_) {
+          return Status::OK();
+        }
+        slot->input = std::move(args);
+        slot->is_open = true;
+        slot->is_producing = true;
+        ++num_open_;
+        slot->cond_var.notify_one();
+        return Status::OK();
+      }
+
+      void AdvanceToNextInCycle() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        block_index_ = 0;
+        cycle_index_ = (cycle_index_ + 1) % dataset()->cycle_length_;
+      }
+
+      Status ConsumeElement(WorkerState* worker,
+                            std::vector<Tensor>* out_tensors,
+                            bool* end_of_sequence)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        Status s = worker->outputs.front().status;
+        if (s.ok()) {
+          *out_tensors = std::move(worker->outputs.front().output);
+        }
+        worker->outputs.pop_front();
+        *end_of_sequence = false;
+        // Wake the worker thread, in case it has been waiting for space.
+        worker->cond_var.notify_one();
+        return s;
+      }
+
+      void WorkerThread(WorkerState* worker) {
+        while (true) {
+          // 1. Wait for an input element.
+          std::vector<Tensor> input;
+          {
+            mutex_lock l(mu_);
+            while (!cancelled_ && !worker->is_producing) {
+              worker->cond_var.wait(l);
+            }
+            if (cancelled_) {
+              return;
+            }
+            input.swap(worker->input);
+          }
+
+          // 2. Read the dataset that `f` returns for the input element,
+          // blocking while `outputs` is full. The worker owns `iterator`,
+          // so we do not hold `mu_` while it produces an element.
+          std::unique_ptr<IteratorBase> iterator;
+          Status s = dataset::MakeIteratorFromInputElement(
+              iter_ctx_.get(), input, dataset()->captured_func_.get(),
+              &iterator);
+          if (!s.ok()) {
+            mutex_lock l(mu_);
+            worker->outputs.push_back({s, {}});
+          }
+          while (iterator) {
+            {
+              mutex_lock l(mu_);
+              while (!cancelled_ && worker->outputs.size() >=
+                                        dataset()->buffer_output_elements_) {
+                worker->cond_var.wait(l);
+              }
+              if (cancelled_) {
+                return;
+              }
+            }
+
+            OutputElement element;
+            bool end_of_sequence = false;
+            element.status = iterator->GetNext(
+                iter_ctx_.get(), &element.output, &end_of_sequence);
+            if (element.status.ok() && end_of_sequence) {
+              break;
+            }
+            mutex_lock l(mu_);
+            worker->outputs.push_back(std::move(element));
+            consumer_cond_var_.notify_all();
+          }
+          iterator.reset();
+
+          // 3. Signal that the dataset is exhausted.
+          mutex_lock l(mu_);
+          worker->is_producing = false;
+          consumer_cond_var_.notify_all();
+        }
+      }
+
+      mutex mu_;
+      const std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+      std::unique_ptr<IteratorContext> iter_ctx_;
+      condition_variable consumer_cond_var_;
+      std::vector<WorkerState> workers_ GUARDED_BY(mu_);
+      size_t cycle_index_ GUARDED_BY(mu_) = 0;
+      int64 block_index_ GUARDED_BY(mu_) = 0;
+      int64 num_open_ GUARDED_BY(mu_) = 0;
+      bool end_of_input_ GUARDED_BY(mu_) = false;
+      bool cancelled_ GUARDED_BY(mu_) = false;
+      // Declared last so that the threads are joined before the state
+      // they use is destroyed.
+      std::vector<std::unique_ptr<Thread>> worker_threads_;
+    };
+
+    const DatasetBase* const input_;
+    const std::unique_ptr<CapturedFunction> captured_func_;
+    const int64 cycle_length_;
+    const int64 block_length_;
+    const bool sloppy_;
+    const int64 buffer_output_elements_;
+    const DataTypeVector output_types_;
+    const std::vector<PartialTensorShape> output_shapes_;
+  };
+
+  const int graph_def_version_;
+  DataTypeVector output_types_;
+  std::vector<PartialTensorShape> output_shapes_;
+  const NameAttrList* func_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("ParallelInterleaveDataset").Device(DEVICE_CPU),
+                        ParallelInterleaveDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
@@ -129,7 +129,7 @@ class ParallelMapDatasetOp : public OpKernel {
 
     ~Dataset() override { input_->Unref(); }
 
-    std::unique_ptr<IteratorBase> MakeIterator() const override {
+    std::unique_ptr<IteratorBase> MakeIteratorInternal() const override {
       return std::unique_ptr<IteratorBase>(new Iterator(this));
     }
 
@@ -171,14 +171,37 @@ class ParallelMapDatasetOp : public OpKernel {
                      bool* end_of_sequence) override {
         mutex_lock l(output_mu_);
         TF_RETURN_IF_ERROR(EnsureMapperThreadsStarted(ctx));
+        return GetNextLocked(&l, out_tensors, end_of_sequence);
+      }
 
+      Status GetNextMany(IteratorContext* ctx, int64 max_elements,
+                         std::vector<std::vector<Tensor>>* out_elements,
+                         bool* end_of_sequence) override {
+        mutex_lock l(output_mu_);
+        TF_RETURN_IF_ERROR(EnsureMapperThreadsStarted(ctx));
+        *end_of_sequence = false;
+        for (int64 i = 0; i < max_elements; ++i) {
+          std::vector<Tensor> element;
+          TF_RETURN_IF_ERROR(GetNextLocked(&l, &element, end_of_sequence));
+          if (*end_of_sequence) {
+            break;
+          }
+          out_elements->emplace_back(std::move(element));
+        }
+        return Status::OK();
+      }
+
+     private:
+      Status GetNextLocked(mutex_lock* l, std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence)
+          EXCLUSIVE_LOCKS_REQUIRED(output_mu_) {
         while (true) {
           // 1. Wait until the next element in the output queue has
           // been produced, or we are shutting down.
           while (
               !cancelled_ && active_threads_ > 0 &&
               (output_buffer_.empty() || !output_buffer_.front().is_produced)) {
-            cond_var_.wait(l);
+            cond_var_.wait(*l);
           }
 
           if (cancelled_) {
@@ -208,7 +231,6 @@ class ParallelMapDatasetOp : public OpKernel {
         }
       }
 
-     private:
       // An output queue element comprises a bool (which indicates
       // whether the element has been produced yet) and a vector of
       // tensors (which contains the tuple of tensors if the bool is
@@ -0,0 +1,280 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <algorithm>
+
+#include "tensorflow/core/kernels/dataset.h"
+
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/util/example_proto_fast_parsing.h"
+
+namespace tensorflow {
+
+namespace {
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class ParseExampleDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit ParseExampleDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("sparse_keys", &sparse_keys_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("dense_keys", &dense_keys_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("sparse_types", &sparse_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("Tdense", &dense_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("dense_shapes", &dense_shapes_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+    OP_REQUIRES(ctx, sparse_keys_.size() == sparse_types_.size(),
+                errors::InvalidArgument(
+                    "len(sparse_keys) != len(sparse_types): ",
+                    sparse_keys_.size(), " vs. ", sparse_types_.size()));
+    OP_REQUIRES(ctx, dense_keys_.size() == dense_types_.size(),
+                errors::InvalidArgument("len(dense_keys) != len(Tdense): ",
+                                        dense_keys_.size(), " vs. ",
+                                        dense_types_.size()));
+    OP_REQUIRES(ctx, dense_keys_.size() == dense_shapes_.size(),
+                errors::InvalidArgument(
+                    "len(dense_keys) != len(dense_shapes): ",
+                    dense_keys_.size(), " vs. ", dense_shapes_.size()));
+
+    // As in `ParseSingleExampleAttrs`, a dense shape may only have an
+    // unknown first dimension, which makes the feature variable-length.
+    for (int d = 0; d < dense_shapes_.size(); ++d) {
+      const PartialTensorShape& shape = dense_shapes_[d];
+      bool shape_ok = shape.dims() != -1;
+      for (int i = 1; shape_ok && i < shape.dims(); ++i) {
+        shape_ok = shape.dim_size(i) != -1;
+      }
+      OP_REQUIRES(
+          ctx, shape_ok,
+          errors::InvalidArgument(
+              "dense_shapes[", d, "] has unknown rank or unknown inner "
+              "dimensions: ",
+              shape.DebugString()));
+      TensorShape dense_shape;
+      if (shape.dims() > 0 && shape.dim_size(0) == -1) {
+        variable_length_.push_back(true);
+        for (int i = 1; i < shape.dims(); ++i) {
+          dense_shape.AddDim(shape.dim_size(i));
+        }
+      } else {
+        variable_length_.push_back(false);
+        shape.AsTensorShape(&dense_shape);
+      }
+      elements_per_stride_.push_back(dense_shape.num_elements());
+    }
+
+    // The components of an output element follow the features in order of
+    // their keys. A dense feature has one component, and a sparse feature
+    // has three: its indices, values and dense shape.
+    std::vector<std::pair<string, int>> keys;
+    for (int d = 0; d < dense_keys_.size(); ++d) {
+      keys.emplace_back(dense_keys_[d], d);
+    }
+    for (int s = 0; s < sparse_keys_.size(); ++s) {
+      keys.emplace_back(sparse_keys_[s], ~s);
+    }
+    std::sort(keys.begin(), keys.end());
+    for (int i = 1; i < keys.size(); ++i) {
+      OP_REQUIRES(ctx, keys[i - 1].first != keys[i].first,
+                  errors::InvalidArgument("Duplicate feature key: ",
+                                          keys[i].first));
+    }
+    for (const auto& key : keys) {
+      output_order_.push_back(key.second);
+    }
+    const size_t num_components = dense_keys_.size() + 3 * sparse_keys_.size();
+    OP_REQUIRES(ctx, output_types_.size() == num_components,
+                errors::InvalidArgument(
+                    "Expected ", num_components, " output_types, but got ",
+                    output_types_.size()));
+  }
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    OP_REQUIRES(ctx,
+                input->output_dtypes() == DataTypeVector({DT_STRING}) &&
+                    input->output_shapes()[0].IsCompatibleWith(
+                        PartialTensorShape({-1})),
+                errors::InvalidArgument(
+                    "`input_dataset` must produce vectors of serialized "
+                    "Example protos."));
+
+    int64 num_parallel_calls;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "num_parallel_calls",
+                                                   &num_parallel_calls));
+    OP_REQUIRES(ctx, num_parallel_calls > 0,
+                errors::InvalidArgument(
+                    "num_parallel_calls must be greater than zero."));
+
+    OpInputList dense_defaults;
+    OP_REQUIRES_OK(ctx, ctx->input_list("dense_defaults", &dense_defaults));
+
+    example::FastParseExampleConfig config;
+    for (int d = 0; d < dense_keys_.size(); ++d) {
+      const Tensor& def_value = dense_defaults[d];
+      if (variable_length_[d]) {
+        OP_REQUIRES(ctx, def_value.NumElements() == 1,
+                    errors::InvalidArgument(
+                        "dense_shape[", d, "] is a variable length shape: ",
+                        dense_shapes_[d].DebugString(),
+                        ", therefore def_value[", d,
+                        "] must contain a single element (the padding "
+                        "element).  But its shape is: ",
+                        def_value.shape().DebugString()));
+      } else if (def_value.NumElements() > 0) {
+        OP_REQUIRES(ctx, dense_shapes_[d].IsCompatibleWith(def_value.shape()),
+                    errors::InvalidArgument(
+                        "def_value[", d,
+                        "].shape() == ", def_value.shape().DebugString(),
+                        " is not compatible with dense_shapes_[", d,
+                        "] == ", dense_shapes_[d].DebugString()));
+      }
+      config.dense.push_back({dense_keys_[d], dense_types_[d],
+                              dense_shapes_[d], def_value, variable_length_[d],
+                              elements_per_stride_[d]});
+    }
+    for (int s = 0; s < sparse_keys_.size(); ++s) {
+      config.sparse.push_back({sparse_keys_[s], sparse_types_[s]});
+    }
+
+    *output = new Dataset(input, std::move(config), num_parallel_calls,
+                          output_order_, output_types_, output_shapes_);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(const DatasetBase* input, example::FastParseExampleConfig config,
+            int64 num_parallel_calls, const std::vector<int>& output_order,
+            const DataTypeVector& output_types,
+            const std::vector<PartialTensorShape>& output_shapes)
+        : input_(input),
+          config_(std::move(config)),
+          num_parallel_calls_(num_parallel_calls),
+          output_order_(output_order),
+          output_types_(output_types),
+          output_shapes_(output_shapes) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal() const override {
+      return std::unique_ptr<IteratorBase>(new Iterator(this));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return output_types_;
+    }
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return output_shapes_;
+    }
+
+    string DebugString() override { return "ParseExampleDatasetOp::Dataset"; }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset),
+            input_impl_(dataset->input_->MakeIterator()) {}
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        std::vector<Tensor> input;
+        thread::ThreadPool* thread_pool;
+        {
+          mutex_lock l(mu_);
+          TF_RETURN_IF_ERROR(
+              input_impl_->GetNext(ctx, &input, end_of_sequence));
+          if (*end_of_sequence) {
+            return Status::OK();
+          }
+          if (!thread_pool_) {
+            thread_pool_.reset(new thread::ThreadPool(
+                ctx->env(), "parse_example_dataset",
+                dataset()->num_parallel_calls_));
+          }
+          thread_pool = thread_pool_.get();
+        }
+
+        // Parse the batch outside the lock, so that concurrent calls can
+        // parse different batches.
+        const Tensor& serialized = input[0];
+        if (!TensorShapeUtils::IsVector(serialized.shape())) {
+          return errors::InvalidArgument(
+              "Expected a vector of serialized Example protos, got shape: ",
+              serialized.shape().DebugString());
+        }
+        auto serialized_t = serialized.flat<string>();
+        gtl::ArraySlice<string> slice(serialized_t.data(),
+                                      serialized_t.size());
+        example::Result result;
+        TF_RETURN_IF_ERROR(example::FastParseExample(
+            dataset()->config_, slice, {}, thread_pool, &result));
+
+        out_tensors->reserve(dataset()->output_types_.size());
+        for (int index : dataset()->output_order_) {
+          if (index >= 0) {
+            out_tensors->push_back(std::move(result.dense_values[index]));
+          } else {
+            const int s = ~index;
+            out_tensors->push_back(std::move(result.sparse_indices[s]));
+            out_tensors->push_back(std::move(result.sparse_values[s]));
+            out_tensors->push_back(std::move(result.sparse_shapes[s]));
+          }
+        }
+        *end_of_sequence = false;
+        return Status::OK();
+      }
+
+     private:
+      mutex mu_;
+      const std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+      std::unique_ptr<thread::ThreadPool> thread_pool_ GUARDED_BY(mu_);
+    };
+
+    const DatasetBase* const input_;
+    const example::FastParseExampleConfig config_;
+    const int64 num_parallel_calls_;
+    const std::vector<int> output_order_;
+    const DataTypeVector output_types_;
+    const std::vector<PartialTensorShape> output_shapes_;
+  };
+
+  std::vector<string> sparse_keys_;
+  std::vector<string> dense_keys_;
+  DataTypeVector sparse_types_;
+  DataTypeVector dense_types_;
+  std::vector<PartialTensorShape> dense_shapes_;
+  std::vector<bool> variable_length_;
+  std::vector<std::size_t> elements_per_stride_;
+  // Indices of the features in output order: a non-negative value `d` is
+  // the dense feature `d`, and a negative value `~s` the sparse feature `s`.
+  std::vector<int> output_order_;
+  DataTypeVector output_types_;
+  std::vector<PartialTensorShape> output_shapes_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("ParseExampleDataset").Device(DEVICE_CPU),
+                        ParseExampleDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
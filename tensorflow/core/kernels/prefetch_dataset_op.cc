@@ -0,0 +1,309 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <deque>
+#include <functional>
+
+#include "tensorflow/core/kernels/dataset.h"
+
+#include "tensorflow/core/framework/partial_tensor_shape.h"
+#include "tensorflow/core/framework/tensor.h"
+
+namespace tensorflow {
+
+namespace {
+
+// See documentation in ../ops/dataset_ops.cc for a high-level
+// description of the following op.
+
+class PrefetchDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit PrefetchDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {}
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    int64 buffer_size;
+    OP_REQUIRES_OK(
+        ctx, ParseScalarArgument<int64>(ctx, "buffer_size", &buffer_size));
+    OP_REQUIRES(
+        ctx, buffer_size > 0,
+        errors::InvalidArgument("buffer_size must be greater than zero."));
+
+    *output = new Dataset(input, buffer_size);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(const DatasetBase* input, int64 buffer_size)
+        : input_(input), buffer_size_(buffer_size) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal() const override {
+      return std::unique_ptr<IteratorBase>(new Iterator(this));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return input_->output_dtypes();
+    }
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return input_->output_shapes();
+    }
+
+    string DebugString() override { return "PrefetchDatasetOp::Dataset"; }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset),
+            input_impl_(dataset->input_->MakeIterator()) {}
+
+      ~Iterator() override {
+        // Signal the prefetch thread to terminate it. We will then
+        // join that thread when we delete `this->prefetch_thread_`.
+        //
+        // TODO(mrry): Replace this cancellation logic with a
+        // CancellationManager. The syntax would be more heavyweight,
+        // but it would be possible to thread a cancellation manager
+        // through the IteratorContext to upstream,
+        // potentially-blocking iterators, when we add these.
+        std::deque<PendingGetNext> pending;
+        {
+          mutex_lock l(mu_);
+          cancelled_ = true;
+          pending.swap(pending_);
+          cond_var_.notify_all();
+        }
+        for (PendingGetNext& p : pending) {
+          p.done(errors::Cancelled(
+              "PrefetchDatasetOp::Dataset::Iterator::GetNextAsync"));
+        }
+      }
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(EnsurePrefetchThreadStarted(ctx));
+        WaitForElement(&l);
+        return ConsumeElement(out_tensors, end_of_sequence);
+      }
+
+      void GetNextAsync(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                        bool* end_of_sequence, DoneCallback done) override {
+        Status s;
+        {
+          mutex_lock l(mu_);
+          s = EnsurePrefetchThreadStarted(ctx);
+          if (s.ok() && !cancelled_ && !prefetch_thread_finished_ &&
+              buffer_.empty()) {
+            // The prefetch thread will hand the next element to `done`.
+            pending_.push_back({out_tensors, end_of_sequence, std::move(done)});
+            return;
+          }
+          if (s.ok()) {
+            s = ConsumeElement(out_tensors, end_of_sequence);
+          }
+        }
+        done(s);
+      }
+
+      bool is_async() const override { return true; }
+
+      Status GetNextMany(IteratorContext* ctx, int64 max_elements,
+                         std::vector<std::vector<Tensor>>* out_elements,
+                         bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        TF_RETURN_IF_ERROR(EnsurePrefetchThreadStarted(ctx));
+        *end_of_sequence = false;
+        for (int64 i = 0; i < max_elements; ++i) {
+          WaitForElement(&l);
+          std::vector<Tensor> element;
+          TF_RETURN_IF_ERROR(ConsumeElement(&element, end_of_sequence));
+          if (*end_of_sequence) {
+            break;
+          }
+          out_elements->emplace_back(std::move(element));
+        }
+        return Status::OK();
+      }
+
+     private:
+      // A buffer element comprises a status and (if that status is
+      // OK) a vector of tensors, representing an element of the input
+      // dataset.
+      struct BufferElement {
+        // The producer sets `status` if getting the input element fails.
+        Status status;
+        // The buffered data element.
+        std::vector<Tensor> value;
+      };
+
+      // A call to `GetNextAsync()` waiting for the prefetch thread to
+      // produce an element.
+      struct PendingGetNext {
+        std::vector<Tensor>* out_tensors;
+        bool* end_of_sequence;
+        DoneCallback done;
+      };
+
+      // Waits until the next element in the buffer has been produced,
+      // or the input is exhausted, or we are shutting down.
+      void WaitForElement(mutex_lock* l) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        while (!cancelled_ && !prefetch_thread_finished_ && buffer_.empty()) {
+          cond_var_.wait(*l);
+        }
+      }
+
+      // Takes the next element from the buffer, once WaitForElement()
+      // has returned.
+      Status ConsumeElement(std::vector<Tensor>* out_tensors,
+                            bool* end_of_sequence)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (cancelled_) {
+          return errors::Cancelled(
+              "PrefetchDatasetOp::Dataset::Iterator::GetNext");
+        }
+
+        if (!buffer_.empty()) {
+          RecordDatasetBufferSize(buffer_.size());
+          // Forward the status from computing the element, and (if we
+          // successfully got an element) the output values.
+          Status s = buffer_.front().status;
+          if (s.ok()) {
+            *out_tensors = std::move(buffer_.front().value);
+          }
+          buffer_.pop_front();
+          *end_of_sequence = false;
+
+          // Wake the prefetch thread, in case it has been waiting for
+          // space in the buffer.
+          cond_var_.notify_all();
+          return s;
+        }
+
+        *end_of_sequence = true;
+        return Status::OK();
+      }
+
+      Status EnsurePrefetchThreadStarted(IteratorContext* ctx)
+          EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        if (!prefetch_thread_) {
+          // `ctx` is only valid for the duration of this call, so the
+          // prefetch thread reads from the input with a copy of it,
+          // including its runner for any functions the input calls.
+          IteratorContext::Params params;
+          params.env = ctx->env();
+          params.resource_manager = ctx->resource_manager();
+          params.runner = *(ctx->runner());
+          iter_ctx_.reset(new IteratorContext(std::move(params)));
+          prefetch_thread_.reset(ctx->env()->StartThread(
+              {}, "prefetch_thread", [this]() { PrefetchThread(); }));
+        }
+        return Status::OK();
+      }
+
+      // Fills `buffer_` with elements of the input, blocking while it
+      // holds `dataset()->buffer_size_` elements.
+      void PrefetchThread() {
+        while (true) {
+          // 1. Wait for a slot in the buffer.
+          {
+            mutex_lock l(mu_);
+            while (!cancelled_ && buffer_.size() == dataset()->buffer_size_) {
+              cond_var_.wait(l);
+            }
+
+            if (cancelled_) {
+              return;
+            }
+          }
+
+          // 2. Read the next element. Only this thread uses
+          // `input_impl_` once it has started, so we do not hold `mu_`
+          // while the input produces an element.
+          BufferElement buffer_element;
+          bool end_of_sequence;
+          buffer_element.status = input_impl_->GetNext(
+              iter_ctx_.get(), &buffer_element.value, &end_of_sequence);
+          if (buffer_element.status.ok() && end_of_sequence) {
+            std::deque<PendingGetNext> pending;
+            {
+              mutex_lock l(mu_);
+              prefetch_thread_finished_ = true;
+              pending.swap(pending_);
+              cond_var_.notify_all();
+            }
+            for (PendingGetNext& p : pending) {
+              *p.end_of_sequence = true;
+              Complete(std::move(p.done), Status::OK());
+            }
+            return;
+          }
+
+          // 3. Hand the element to a waiting GetNextAsync() call, or
+          // signal that it has been buffered.
+          PendingGetNext pending;
+          {
+            mutex_lock l(mu_);
+            if (pending_.empty()) {
+              buffer_.push_back(std::move(buffer_element));
+              cond_var_.notify_all();
+              continue;
+            }
+            pending = std::move(pending_.front());
+            pending_.pop_front();
+          }
+          if (buffer_element.status.ok()) {
+            *pending.out_tensors = std::move(buffer_element.value);
+          }
+          *pending.end_of_sequence = false;
+          Complete(std::move(pending.done), buffer_element.status);
+        }
+      }
+
+      // Runs `done` through the runner of the iterator context, so
+      // that the consumer does not run on the prefetch thread.
+      void Complete(DoneCallback done, const Status& s) {
+        (*iter_ctx_->runner())(std::bind(std::move(done), s));
+      }
+
+      const std::unique_ptr<IteratorBase> input_impl_;
+      std::unique_ptr<IteratorContext> iter_ctx_;
+      mutex mu_;
+      condition_variable cond_var_;
+      std::deque<BufferElement> buffer_ GUARDED_BY(mu_);
+      bool cancelled_ GUARDED_BY(mu_) = false;
+      bool prefetch_thread_finished_ GUARDED_BY(mu_) = false;
+      std::deque<PendingGetNext> pending_ GUARDED_BY(mu_);
+      // Declared last so that the thread is joined before the state it
+      // uses is destroyed.
+      std::unique_ptr<Thread> prefetch_thread_ GUARDED_BY(mu_);
+    };
+
+    const DatasetBase* const input_;
+    const int64 buffer_size_;
+  };
+};
+
+REGISTER_KERNEL_BUILDER(Name("PrefetchDataset").Device(DEVICE_CPU),
+                        PrefetchDatasetOp);
+
+}  // namespace
+
+}  // namespace tensorflow
@@ -23,13 +23,16 @@ limitations under the License.
 #include "tensorflow/core/kernels/meta_support.h"
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/kernels/requantize.h"
 #include "tensorflow/core/lib/core/errors.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
-template <class T1, class T2, class T3>
+// If RequantizeOutput is true, the T3 results are requantized into the eight
+// bit range given by two extra inputs before they're output.
+template <class T1, class T2, class T3, bool RequantizeOutput = false>
 class QuantizedBiasAddOp : public OpKernel {
  public:
   explicit QuantizedBiasAddOp(OpKernelConstruction* context)
@@ -57,9 +60,26 @@ class QuantizedBiasAddOp : public OpKernel {
             "of the input tensor: ",
             bias.shape().DebugString(), " vs. ", input.shape().DebugString()));
 
+    float requested_output_min = 0.0f;
+    float requested_output_max = 0.0f;
+    if (RequantizeOutput) {
+      requested_output_min = context->input(6).flat<float>()(0);
+      requested_output_max = context->input(7).flat<float>()(0);
+      OP_REQUIRES_OK(context, ValidateRequantizeRange(requested_output_min,
+                                                      requested_output_max));
+    }
+
     Tensor* output = nullptr;
-    OP_REQUIRES_OK(context,
-                   context->allocate_output(0, input.shape(), &output));
+    Tensor unrequantized_output;
+    if (RequantizeOutput) {
+      OP_REQUIRES_OK(context, context->allocate_temp(
+                                  DataTypeToEnum<T3>::v(), input.shape(),
+                                  &unrequantized_output));
+      output = &unrequantized_output;
+    } else {
+      OP_REQUIRES_OK(context,
+                     context->allocate_output(0, input.shape(), &output));
+    }
 
     float total_min;
     float total_max;
@@ -81,6 +101,17 @@ class QuantizedBiasAddOp : public OpKernel {
           input_max, bias, bias_min, bias_max, output, &total_min, &total_max);
     }
 
+    if (RequantizeOutput) {
+      Tensor* requantized_output = nullptr;
+      OP_REQUIRES_OK(context, context->allocate_output(0, input.shape(),
+                                                       &requantized_output));
+      RequantizeTensor<T3, quint8>(context, unrequantized_output, total_min,
+                                   total_max, requested_output_min,
+                                   requested_output_max, requantized_output);
+      total_min = requested_output_min;
+      total_max = requested_output_max;
+    }
+
     Tensor* output_min = nullptr;
     OP_REQUIRES_OK(context, context->allocate_output(1, {}, &output_min));
     output_min->flat<float>()(0) = total_min;
@@ -103,4 +134,10 @@ REGISTER_KERNEL_BUILDER(Name("QuantizedBiasAdd")
                             .TypeConstraint<qint8>("T2")
                             .TypeConstraint<qint32>("out_type"),
                         QuantizedBiasAddOp<qint8, qint8, qint32>);
+REGISTER_KERNEL_BUILDER(Name("QuantizedBiasAddAndRequantize")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<quint8>("T1")
+                            .TypeConstraint<quint8>("T2")
+                            .TypeConstraint<quint8>("out_type"),
+                        QuantizedBiasAddOp<quint8, quint8, qint32, true>);
 }  // namespace tensorflow
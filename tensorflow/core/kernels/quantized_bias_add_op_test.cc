@@ -87,6 +87,59 @@ TEST_F(QuantizedBiasAddTest, Small) {
   test::ExpectTensorNear<float>(expected_float, output_float, 0.2);
 }
 
+TEST_F(QuantizedBiasAddTest, SmallAndRequantize) {
+  TF_ASSERT_OK(NodeDefBuilder("quantized_bias_add_op",
+                              "QuantizedBiasAddAndRequantize")
+                   .Input(FakeInput(DT_QUINT8))
+                   .Input(FakeInput(DT_QUINT8))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("out_type", DataTypeToEnum<quint8>::v())
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  const float input_min = 0.0f;
+  const float input_max = 60.0f;
+  Tensor input_float(DT_FLOAT, {2, 3});
+  test::FillValues<float>(&input_float,
+                          {10.0f, 20.0f, 30.0f, 40.0f, 50.0f, 60.0f});
+  Tensor input_quantized =
+      FloatTensorToQuantized<quint8>(input_float, input_min, input_max);
+
+  const float bias_min = 0.0f;
+  const float bias_max = 3.0f;
+  Tensor bias_float(DT_FLOAT, {3});
+  test::FillValues<float>(&bias_float, {1.0f, 2.0f, 3.0f});
+  Tensor bias_quantized =
+      FloatTensorToQuantized<quint8>(bias_float, bias_min, bias_max);
+
+  const float requested_min = 0.0f;
+  const float requested_max = 70.0f;
+  AddInputFromArray<quint8>(input_quantized.shape(),
+                            input_quantized.flat<quint8>());
+  AddInputFromArray<quint8>(bias_quantized.shape(),
+                            bias_quantized.flat<quint8>());
+  AddInputFromArray<float>(TensorShape({1}), {input_min});
+  AddInputFromArray<float>(TensorShape({1}), {input_max});
+  AddInputFromArray<float>(TensorShape({1}), {bias_min});
+  AddInputFromArray<float>(TensorShape({1}), {bias_max});
+  AddInputFromArray<float>(TensorShape({1}), {requested_min});
+  AddInputFromArray<float>(TensorShape({1}), {requested_max});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ(requested_min, GetOutput(1)->flat<float>()(0));
+  EXPECT_EQ(requested_max, GetOutput(2)->flat<float>()(0));
+
+  Tensor expected_float(DT_FLOAT, {2, 3});
+  test::FillValues<float>(&expected_float,
+                          {11.0f, 22.0f, 33.0f, 41.0f, 52.0f, 63.0f});
+  Tensor output_float = QuantizedTensorToFloat<quint8>(
+      *GetOutput(0), requested_min, requested_max);
+  test::ExpectTensorNear<float>(expected_float, output_float, 0.5);
+}
+
 TEST_F(QuantizedBiasAddTest, RealData) {
   TF_ASSERT_OK(NodeDefBuilder("quantized_bias_add_op", "QuantizedBiasAdd")
                    .Input(FakeInput(DT_QUINT8))
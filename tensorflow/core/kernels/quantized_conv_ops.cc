@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/ops_util.h"
 #include "tensorflow/core/kernels/quantization_utils.h"
 #include "tensorflow/core/kernels/reference_gemm.h"
+#include "tensorflow/core/kernels/requantize.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/util/padding.h"
 
@@ -439,8 +440,13 @@ class Im2ColConvFunctor {
   }
 };
 
+// If RequantizeOutput is true, the T3 results are requantized into the eight
+// bit range given by two extra inputs before they're output, so that graphs
+// with frozen requantization ranges don't have to pass the full bit depth
+// results on to a separate Requantize op.
 template <class T1, class T2, class T3,
-          template <class TF1, class TF2, class TF3> class ConvFunctor>
+          template <class TF1, class TF2, class TF3> class ConvFunctor,
+          bool RequantizeOutput = false>
 class QuantizedConv2DOp : public OpKernel {
  public:
   explicit QuantizedConv2DOp(OpKernelConstruction* context)
@@ -489,6 +495,15 @@ class QuantizedConv2DOp : public OpKernel {
     const int32 mult_output = 1;
     const int32 shift_output = 0;
 
+    float requested_output_min = 0.0f;
+    float requested_output_max = 0.0f;
+    if (RequantizeOutput) {
+      requested_output_min = context->input(6).flat<float>()(0);
+      requested_output_max = context->input(7).flat<float>()(0);
+      OP_REQUIRES_OK(context, ValidateRequantizeRange(requested_output_min,
+                                                      requested_output_max));
+    }
+
     // The last dimension for input is in_depth. It must be the same as the
     // filter's in_depth.
     const int64 in_depth = input.dim_size(3);
@@ -533,8 +548,18 @@ class QuantizedConv2DOp : public OpKernel {
 
     // Output tensor is of the following dimensions:
     // [ in_batch, out_rows, out_cols, out_depth ]
+    // When the output is requantized, the convolution writes to a temporary
+    // of the same shape instead.
     Tensor* output = nullptr;
-    OP_REQUIRES_OK(context, context->allocate_output(0, out_shape, &output));
+    Tensor conv_output;
+    if (RequantizeOutput) {
+      OP_REQUIRES_OK(context,
+                     context->allocate_temp(DataTypeToEnum<T3>::v(), out_shape,
+                                            &conv_output));
+      output = &conv_output;
+    } else {
+      OP_REQUIRES_OK(context, context->allocate_output(0, out_shape, &output));
+    }
 
     // This will call different implementations (e.g. reference or optimized)
     // depending on the template parameter.
@@ -551,6 +576,17 @@ class QuantizedConv2DOp : public OpKernel {
         min_input, max_input, min_filter, max_filter, &min_output_value,
         &max_output_value);
 
+    if (RequantizeOutput) {
+      Tensor* requantized_output = nullptr;
+      OP_REQUIRES_OK(context, context->allocate_output(0, out_shape,
+                                                       &requantized_output));
+      RequantizeTensor<T3, quint8>(context, conv_output, min_output_value,
+                                   max_output_value, requested_output_min,
+                                   requested_output_max, requantized_output);
+      min_output_value = requested_output_min;
+      max_output_value = requested_output_max;
+    }
+
     Tensor* output_min = nullptr;
     OP_REQUIRES_OK(context, context->allocate_output(1, {}, &output_min));
     output_min->flat<float>()(0) = min_output_value;
@@ -575,4 +611,12 @@ REGISTER_KERNEL_BUILDER(
         .TypeConstraint<qint32>("out_type"),
     QuantizedConv2DOp<quint8, quint8, qint32, Im2ColConvFunctor>);
 
+REGISTER_KERNEL_BUILDER(
+    Name("QuantizedConv2DAndRequantize")
+        .Device(DEVICE_CPU)
+        .TypeConstraint<quint8>("Tinput")
+        .TypeConstraint<quint8>("Tfilter")
+        .TypeConstraint<quint8>("out_type"),
+    QuantizedConv2DOp<quint8, quint8, qint32, Im2ColConvFunctor, true>);
+
 }  // namespace tensorflow
@@ -131,6 +131,64 @@ TEST_F(QuantizedConv2DTest, Small) {
   test::ExpectTensorNear<float>(expected_float, output_float, 1.0);
 }
 
+TEST_F(QuantizedConv2DTest, SmallAndRequantize) {
+  const int stride = 1;
+  TF_ASSERT_OK(
+      NodeDefBuilder("quantized_conv_op", "QuantizedConv2DAndRequantize")
+          .Input(FakeInput(DT_QUINT8))
+          .Input(FakeInput(DT_QUINT8))
+          .Input(FakeInput(DT_FLOAT))
+          .Input(FakeInput(DT_FLOAT))
+          .Input(FakeInput(DT_FLOAT))
+          .Input(FakeInput(DT_FLOAT))
+          .Input(FakeInput(DT_FLOAT))
+          .Input(FakeInput(DT_FLOAT))
+          .Attr("out_type", DataTypeToEnum<quint8>::v())
+          .Attr("strides", {1, stride, stride, 1})
+          .Attr("padding", "SAME")
+          .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+
+  // Uses the same image and filter as the Small test, but asks for the
+  // results as eight bit values covering [0, 400].
+  const float image_min = 0.0f;
+  const float image_max = 12.0f;
+  Tensor image_float(DT_FLOAT, {1, 3, 4, 1});
+  test::FillValues<float>(&image_float,
+                          {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12});
+  Tensor image_quantized =
+      FloatTensorToQuantized<quint8>(image_float, image_min, image_max);
+  const float filter_min = 1.0f;
+  const float filter_max = 9.0f;
+  Tensor filter_float(DT_FLOAT, {3, 3, 1, 1});
+  test::FillValues<float>(&filter_float, {1, 4, 7, 2, 5, 8, 3, 6, 9});
+  Tensor filter_quantized =
+      FloatTensorToQuantized<quint8>(filter_float, filter_min, filter_max);
+  const float requested_min = 0.0f;
+  const float requested_max = 400.0f;
+
+  AddInputFromArray<quint8>(image_quantized.shape(),
+                            image_quantized.flat<quint8>());
+  AddInputFromArray<quint8>(filter_quantized.shape(),
+                            filter_quantized.flat<quint8>());
+  AddInputFromArray<float>(TensorShape({1}), {image_min});
+  AddInputFromArray<float>(TensorShape({1}), {image_max});
+  AddInputFromArray<float>(TensorShape({1}), {filter_min});
+  AddInputFromArray<float>(TensorShape({1}), {filter_max});
+  AddInputFromArray<float>(TensorShape({1}), {requested_min});
+  AddInputFromArray<float>(TensorShape({1}), {requested_max});
+  TF_ASSERT_OK(RunOpKernel());
+  EXPECT_EQ(requested_min, GetOutput(1)->flat<float>()(0));
+  EXPECT_EQ(requested_max, GetOutput(2)->flat<float>()(0));
+
+  Tensor expected_float(DT_FLOAT, TensorShape({1, 3, 4, 1}));
+  test::FillValues<float>(&expected_float, {105, 150, 183, 95, 235, 312, 357,
+                                            178, 187, 234, 261, 121});
+  Tensor output_float = QuantizedTensorToFloat<quint8>(
+      *GetOutput(0), requested_min, requested_max);
+  test::ExpectTensorNear<float>(expected_float, output_float, 2.0);
+}
+
 TEST_F(QuantizedConv2DTest, Small32Bit) {
   const int stride = 1;
   TF_ASSERT_OK(NodeDefBuilder("quantized_conv_op", "QuantizedConv2D")
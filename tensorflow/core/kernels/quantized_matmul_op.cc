@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/meta_support.h"
 #include "tensorflow/core/kernels/quantization_utils.h"
 #include "tensorflow/core/kernels/reference_gemm.h"
+#include "tensorflow/core/kernels/requantize.h"
 #include "tensorflow/core/lib/core/errors.h"
 
 namespace tensorflow {
@@ -63,7 +64,9 @@ void GemmlowpMultiply(OpKernelContext* op_context, const quint8* a_data,
   TF_ANNOTATE_MEMORY_IS_INITIALIZED(c_data_as_int32, m * n * sizeof(int32));
 }
 
-template <class T1, class T2, class Toutput>
+// If RequantizeOutput is true, the Toutput results are requantized into the
+// eight bit range given by two extra inputs before they're output.
+template <class T1, class T2, class Toutput, bool RequantizeOutput = false>
 class QuantizedMatMulOp : public OpKernel {
  public:
   explicit QuantizedMatMulOp(OpKernelConstruction* context)
@@ -93,6 +96,15 @@ class QuantizedMatMulOp : public OpKernel {
     const int32 mult_c = 1;
     const int32 shift_c = 0;
 
+    float requested_output_min = 0.0f;
+    float requested_output_max = 0.0f;
+    if (RequantizeOutput) {
+      requested_output_min = context->input(6).flat<float>()(0);
+      requested_output_max = context->input(7).flat<float>()(0);
+      OP_REQUIRES_OK(context, ValidateRequantizeRange(requested_output_min,
+                                                      requested_output_max));
+    }
+
     // Check that the dimensions of the two matrices are valid.
     OP_REQUIRES(context, TensorShapeUtils::IsMatrix(a.shape()),
                 errors::InvalidArgument("In[0] is not a matrix"));
@@ -117,7 +129,15 @@ class QuantizedMatMulOp : public OpKernel {
     TensorShape out_shape(
         {a.dim_size(a_dim_remaining), b.dim_size(b_dim_remaining)});
     Tensor* c = nullptr;
-    OP_REQUIRES_OK(context, context->allocate_output(0, out_shape, &c));
+    Tensor c_unrequantized;
+    if (RequantizeOutput) {
+      OP_REQUIRES_OK(context,
+                     context->allocate_temp(DataTypeToEnum<Toutput>::v(),
+                                            out_shape, &c_unrequantized));
+      c = &c_unrequantized;
+    } else {
+      OP_REQUIRES_OK(context, context->allocate_output(0, out_shape, &c));
+    }
     CHECK(c);
 
     const T1* a_data = a.flat<T1>().data();
@@ -177,6 +197,18 @@ class QuantizedMatMulOp : public OpKernel {
     float max_c_value;
     QuantizationRangeForMultiplication<T1, T2, Toutput>(
         min_a, max_a, min_b, max_b, &min_c_value, &max_c_value);
+
+    if (RequantizeOutput) {
+      Tensor* requantized_c = nullptr;
+      OP_REQUIRES_OK(context,
+                     context->allocate_output(0, out_shape, &requantized_c));
+      RequantizeTensor<Toutput, quint8>(context, c_unrequantized, min_c_value,
+                                        max_c_value, requested_output_min,
+                                        requested_output_max, requantized_c);
+      min_c_value = requested_output_min;
+      max_c_value = requested_output_max;
+    }
+
     Tensor* c_min = nullptr;
     OP_REQUIRES_OK(context, context->allocate_output(1, {}, &c_min));
     c_min->flat<float>()(0) = min_c_value;
@@ -198,4 +230,11 @@ REGISTER_KERNEL_BUILDER(Name("QuantizedMatMul")
                             .TypeConstraint<qint32>("Toutput"),
                         QuantizedMatMulOp<quint8, quint8, qint32>);
 
+REGISTER_KERNEL_BUILDER(Name("QuantizedMatMulAndRequantize")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<quint8>("T1")
+                            .TypeConstraint<quint8>("T2")
+                            .TypeConstraint<quint8>("Toutput"),
+                        QuantizedMatMulOp<quint8, quint8, qint32, true>);
+
 }  // namespace tensorflow
@@ -82,6 +82,69 @@ TEST_F(QuantizedMatMulTest, Small_NoParams) {
   test::ExpectTensorEqual<qint32>(expected, *GetOutput(0));
 }
 
+// Runs the same matrices as Small_NoParams through the version with a fused
+// Requantize, into a range where each eight bit level is one unit.
+TEST_F(QuantizedMatMulTest, Small_AndRequantize) {
+  TF_ASSERT_OK(
+      NodeDefBuilder("quantized_mat_mul_op", "QuantizedMatMulAndRequantize")
+          .Input(FakeInput(DT_QUINT8))
+          .Input(FakeInput(DT_QUINT8))
+          .Input(FakeInput(DT_FLOAT))
+          .Input(FakeInput(DT_FLOAT))
+          .Input(FakeInput(DT_FLOAT))
+          .Input(FakeInput(DT_FLOAT))
+          .Input(FakeInput(DT_FLOAT))
+          .Input(FakeInput(DT_FLOAT))
+          .Attr("Toutput", DataTypeToEnum<quint8>::v())
+          .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<quint8>(TensorShape({2, 3}), {1, 2, 3, 4, 5, 6});
+  AddInputFromArray<quint8>(TensorShape({3, 4}),
+                            {7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18});
+  AddInputFromArray<float>(TensorShape({1}), {0});
+  AddInputFromArray<float>(TensorShape({1}), {255.0f});
+  AddInputFromArray<float>(TensorShape({1}), {0});
+  AddInputFromArray<float>(TensorShape({1}), {255.0f});
+  AddInputFromArray<float>(TensorShape({1}), {0});
+  AddInputFromArray<float>(TensorShape({1}), {255.0f});
+
+  TF_ASSERT_OK(RunOpKernel());
+  Tensor expected(allocator(), DT_QUINT8, TensorShape({2, 4}));
+  test::FillValues<quint8>(&expected, {74, 80, 86, 92, 173, 188, 203, 218});
+  test::ExpectTensorEqual<quint8>(expected, *GetOutput(0));
+  EXPECT_EQ(0.0f, GetOutput(1)->flat<float>()(0));
+  EXPECT_EQ(255.0f, GetOutput(2)->flat<float>()(0));
+}
+
+TEST_F(QuantizedMatMulTest, Small_AndRequantizeBadRange) {
+  TF_ASSERT_OK(
+      NodeDefBuilder("quantized_mat_mul_op", "QuantizedMatMulAndRequantize")
+          .Input(FakeInput(DT_QUINT8))
+          .Input(FakeInput(DT_QUINT8))
+          .Input(FakeInput(DT_FLOAT))
+          .Input(FakeInput(DT_FLOAT))
+          .Input(FakeInput(DT_FLOAT))
+          .Input(FakeInput(DT_FLOAT))
+          .Input(FakeInput(DT_FLOAT))
+          .Input(FakeInput(DT_FLOAT))
+          .Attr("Toutput", DataTypeToEnum<quint8>::v())
+          .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddInputFromArray<quint8>(TensorShape({1, 1}), {1});
+  AddInputFromArray<quint8>(TensorShape({1, 1}), {1});
+  AddInputFromArray<float>(TensorShape({1}), {0});
+  AddInputFromArray<float>(TensorShape({1}), {255.0f});
+  AddInputFromArray<float>(TensorShape({1}), {0});
+  AddInputFromArray<float>(TensorShape({1}), {255.0f});
+  AddInputFromArray<float>(TensorShape({1}), {1.0f});
+  AddInputFromArray<float>(TensorShape({1}), {255.0f});
+  Status status = RunOpKernel();
+  EXPECT_EQ(error::INVALID_ARGUMENT, status.code());
+  EXPECT_TRUE(StringPiece(status.error_message())
+                  .contains("requested_output_min must be <= 0"))
+      << status;
+}
+
 // This test multiplies two 1x1 8bit matrices, and compares the
 // results with hand-calculated expectations.
 TEST_F(QuantizedMatMulTest, VerySmall_WithParams) {
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -412,4 +413,27 @@ Status QueueBase::CopyElementToSlice(const Tensor& element, Tensor* parent,
                                element.dtype());
 }
 
+// Static method
+Status QueueBase::ParallelCopy(OpKernelContext* ctx, int64 batch_size,
+                               int64 element_bytes,
+                               const std::function<Status(int64)>& copy) {
+  mutex mu;
+  Status status;
+  auto work = [&copy, &mu, &status](int64 start, int64 limit) {
+    for (int64 index = start; index < limit; ++index) {
+      Status s = copy(index);
+      if (!s.ok()) {
+        mutex_lock l(mu);
+        status.Update(s);
+        return;
+      }
+    }
+  };
+  const DeviceBase::CpuWorkerThreads* worker_threads =
+      ctx->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads->num_threads, worker_threads->workers, batch_size,
+        element_bytes, work);
+  return status;
+}
+
 }  // namespace tensorflow
@@ -82,6 +82,13 @@ class QueueBase : public QueueInterface {
   static Status CopyElementToSlice(const Tensor& element, Tensor* parent,
                                    int64 index);
 
+  // Calls copy(index) for every index in [0, batch_size), in parallel on the
+  // CPU worker threads of ctx, and returns one of the errors it returned.
+  // "element_bytes" is the number of bytes each call copies.
+  static Status ParallelCopy(OpKernelContext* ctx, int64 batch_size,
+                             int64 element_bytes,
+                             const std::function<Status(int64)>& copy);
+
  protected:
   enum Action { kEnqueue, kDequeue };
   enum RunResult { kNoProgress, kProgress, kComplete };
@@ -156,8 +163,9 @@ class QueueBase : public QueueInterface {
     CancellationToken cancellation_token;
     RunCallback run_callback;  // must be run while holding mu_
     bool is_cancelled;
+    // The elements still to be enqueued, or the elements dequeued so far, in
+    // the form that the implementation chooses.
     Tuple tuple;
-    // tuples is used by some implementations allowing dynamic shapes.
     std::vector<Tuple> tuples;
 
     Attempt(int32 elements_requested, DoneCallback done_callback,
@@ -84,9 +84,26 @@ struct FillPhiloxRandomTask<Distribution, false> {
     gen.Skip(start_group);
     int64 offset = start_group * kGroupSize;
 
-    // First fill all the full-size groups
+    // First fill all the full-size groups, kGroupsPerIteration at a time.
+    // The samples of consecutive groups only depend on each other through
+    // the counter increment, so generating them together lets the compiler
+    // interleave their Philox rounds. The groups are generated in the same
+    // order either way, which keeps the results unchanged.
+    static const int kGroupsPerIteration = 4;
     int64 limit_group_full = std::min(limit_group, size / kGroupSize);
-    for (int64 index = start_group; index < limit_group_full; ++index) {
+    int64 index = start_group;
+    for (; index + kGroupsPerIteration <= limit_group_full;
+         index += kGroupsPerIteration) {
+      typename Distribution::ResultType samples[kGroupsPerIteration];
+      for (int i = 0; i < kGroupsPerIteration; ++i) {
+        samples[i] = dist(&gen);
+      }
+      for (int i = 0; i < kGroupsPerIteration; ++i) {
+        std::copy(&samples[i][0], &samples[i][0] + kGroupSize, data + offset);
+        offset += kGroupSize;
+      }
+    }
+    for (; index < limit_group_full; ++index) {
       auto samples = dist(&gen);
       std::copy(&samples[0], &samples[0] + kGroupSize, data + offset);
       offset += kGroupSize;
@@ -49,7 +49,7 @@ class RangeDatasetOp : public DatasetOpKernel {
     Dataset(int64 start, int64 stop, int64 step)
         : start_(start), stop_(stop), step_(step) {}
 
-    std::unique_ptr<IteratorBase> MakeIterator() const override {
+    std::unique_ptr<IteratorBase> MakeIteratorInternal() const override {
       return std::unique_ptr<IteratorBase>(new Iterator(this));
     }
 
@@ -58,7 +58,7 @@ class TextLineDatasetOp : public OpKernel {
     explicit Dataset(std::vector<string> filenames)
         : filenames_(std::move(filenames)) {}
 
-    std::unique_ptr<IteratorBase> MakeIterator() const override {
+    std::unique_ptr<IteratorBase> MakeIteratorInternal() const override {
       return std::unique_ptr<IteratorBase>(new Iterator(this));
     }
 
@@ -195,7 +195,7 @@ class FixedLengthRecordDatasetOp : public OpKernel {
           record_bytes_(record_bytes),
           footer_bytes_(footer_bytes) {}
 
-    std::unique_ptr<IteratorBase> MakeIterator() const override {
+    std::unique_ptr<IteratorBase> MakeIteratorInternal() const override {
       return std::unique_ptr<IteratorBase>(new Iterator(this));
     }
 
@@ -291,7 +291,10 @@ REGISTER_KERNEL_BUILDER(Name("FixedLengthRecordDataset").Device(DEVICE_CPU),
 
 class TFRecordDatasetOp : public OpKernel {
  public:
-  using OpKernel::OpKernel;
+  explicit TFRecordDatasetOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("buffer_size", &buffer_size_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("verify_checksums", &verify_checksums_));
+  }
 
   void Compute(OpKernelContext* ctx) override {
     const Tensor* filenames_tensor;
@@ -315,7 +318,13 @@ class TFRecordDatasetOp : public OpKernel {
     const string& compression_type =
         compression_type_tensor->scalar<string>()();
 
-    DatasetBase* dataset = new Dataset(std::move(filenames), compression_type);
+    io::RecordReaderOptions options =
+        io::RecordReaderOptions::CreateRecordReaderOptions(compression_type);
+    options.buffer_size = buffer_size_;
+    options.read_ahead = buffer_size_ > 0;
+    options.verify_checksums = verify_checksums_;
+
+    DatasetBase* dataset = new Dataset(std::move(filenames), options);
     Tensor* output = nullptr;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(0, TensorShape({}), &output));
     ResourceHandle handle = MakeResourceHandle<DatasetBase>(
@@ -328,12 +337,10 @@ class TFRecordDatasetOp : public OpKernel {
   class Dataset : public DatasetBase {
    public:
     explicit Dataset(std::vector<string> filenames,
-                     const string& compression_type)
-        : filenames_(std::move(filenames)),
-          options_(io::RecordReaderOptions::CreateRecordReaderOptions(
-              compression_type)) {}
+                     const io::RecordReaderOptions& options)
+        : filenames_(std::move(filenames)), options_(options) {}
 
-    std::unique_ptr<IteratorBase> MakeIterator() const override {
+    std::unique_ptr<IteratorBase> MakeIteratorInternal() const override {
       return std::unique_ptr<IteratorBase>(new Iterator(this));
     }
 
@@ -410,6 +417,9 @@ class TFRecordDatasetOp : public OpKernel {
     const std::vector<string> filenames_;
     io::RecordReaderOptions options_;
   };
+
+  int64 buffer_size_;
+  bool verify_checksums_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("TFRecordDataset").Device(DEVICE_CPU),
@@ -191,7 +191,7 @@ void RecordYielder::ShardLoop(Shard* shard) {
       shard->status = errors::InvalidArgument("Can't open ", filename);
       break;
     }
-    io::RecordReader rdr(file.get());
+    io::RecordReader rdr(file.get(), opts_.reader_options);
     uint64 offset = 0;
     string record;
     while (true) {
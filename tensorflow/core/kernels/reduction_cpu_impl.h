@@ -0,0 +1,251 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_REDUCTION_CPU_IMPL_H_
+#define TENSORFLOW_KERNELS_REDUCTION_CPU_IMPL_H_
+
+// Multi-threaded CPU reductions of a row-major matrix along one dimension,
+// for the Sum, Mean, Max and Min reducers.
+//
+// Eigen's generic tensor reduction handles these two cases poorly: reducing
+// the columns of a tall matrix walks the input one column at a time, and
+// reducing short rows pays the per-output overhead of the generic evaluator.
+// Here rows are reduced with the vectorized reductions of Eigen::Array, and
+// columns are reduced by adding whole rows into an accumulator block that
+// stays in L1, with long columns split between threads into partial results
+// that are combined at the end.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace functor {
+
+// The scalar types handled by ReduceMatrixRowsCPU() and
+// ReduceMatrixColumnsCPU().
+template <typename T>
+struct IsMatrixReducerCPUType {
+  static const bool value = false;
+};
+template <>
+struct IsMatrixReducerCPUType<float> {
+  static const bool value = true;
+};
+template <>
+struct IsMatrixReducerCPUType<double> {
+  static const bool value = true;
+};
+template <>
+struct IsMatrixReducerCPUType<int32> {
+  static const bool value = true;
+};
+template <>
+struct IsMatrixReducerCPUType<int64> {
+  static const bool value = true;
+};
+
+// The operations of a reducer on Eigen arrays. 'kSupported' is false for the
+// reducers and types that the matrix reductions don't handle.
+template <typename Reducer>
+struct MatrixReducerCPU {
+  static const bool kSupported = false;
+};
+
+template <typename T>
+struct MatrixReducerCPU<Eigen::internal::SumReducer<T>> {
+  static const bool kSupported = IsMatrixReducerCPUType<T>::value;
+  template <typename Acc, typename In>
+  static void Accumulate(Acc* acc, const In& in) {
+    *acc += in;
+  }
+  template <typename In>
+  static T Reduce(const In& in) {
+    return in.sum();
+  }
+  // Turns the reduction of 'count' values into the result.
+  static T Finalize(T value, int64 count) { return value; }
+  template <typename Acc>
+  static void Finalize(Acc* acc, int64 count) {}
+};
+
+template <typename T>
+struct MatrixReducerCPU<Eigen::internal::MeanReducer<T>>
+    : MatrixReducerCPU<Eigen::internal::SumReducer<T>> {
+  static T Finalize(T value, int64 count) {
+    return value / static_cast<T>(count);
+  }
+  template <typename Acc>
+  static void Finalize(Acc* acc, int64 count) {
+    *acc /= static_cast<T>(count);
+  }
+};
+
+template <typename T>
+struct MatrixReducerCPU<Eigen::internal::MaxReducer<T>> {
+  static const bool kSupported = IsMatrixReducerCPUType<T>::value;
+  template <typename Acc, typename In>
+  static void Accumulate(Acc* acc, const In& in) {
+    *acc = acc->max(in);
+  }
+  template <typename In>
+  static T Reduce(const In& in) {
+    return in.maxCoeff();
+  }
+  static T Finalize(T value, int64 count) { return value; }
+  template <typename Acc>
+  static void Finalize(Acc* acc, int64 count) {}
+};
+
+template <typename T>
+struct MatrixReducerCPU<Eigen::internal::MinReducer<T>> {
+  static const bool kSupported = IsMatrixReducerCPUType<T>::value;
+  template <typename Acc, typename In>
+  static void Accumulate(Acc* acc, const In& in) {
+    *acc = acc->min(in);
+  }
+  template <typename In>
+  static T Reduce(const In& in) {
+    return in.minCoeff();
+  }
+  static T Finalize(T value, int64 count) { return value; }
+  template <typename Acc>
+  static void Finalize(Acc* acc, int64 count) {}
+};
+
+// Reduces every row of the 'rows' x 'cols' row-major matrix 'in' into 'out'.
+// Both dimensions must be positive.
+template <typename Reducer, typename T>
+void ReduceMatrixRowsCPU(const Eigen::ThreadPoolDevice& d, const T* in,
+                         int64 rows, int64 cols, T* out) {
+  typedef MatrixReducerCPU<Reducer> R;
+  typedef Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>> ConstArray;
+  const Eigen::TensorOpCost cost(cols * sizeof(T), sizeof(T),
+                                 cols * Eigen::TensorOpCost::AddCost<T>());
+  d.parallelFor(rows, cost, [in, cols, out](int64 first, int64 last) {
+    for (int64 row = first; row < last; ++row) {
+      out[row] = R::Finalize(R::Reduce(ConstArray(in + row * cols, cols)),
+                             cols);
+    }
+  });
+}
+
+// Columns are reduced in blocks of this many columns, whose accumulators fit
+// in L1.
+static const int64 kReduceColumnBlock = 1024;
+
+// Columns are only split between threads into pieces of at least this many
+// elements.
+static const int64 kReduceColumnMinShardSize = 16384;
+
+// Reduces every column of the 'rows' x 'cols' row-major matrix 'in' into
+// 'out'. Both dimensions must be positive.
+template <typename Reducer, typename T>
+void ReduceMatrixColumnsCPU(const Eigen::ThreadPoolDevice& d, const T* in,
+                            int64 rows, int64 cols, T* out) {
+  typedef MatrixReducerCPU<Reducer> R;
+  typedef Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>> ConstArray;
+  typedef Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>> Array;
+
+  const int64 block_cols = std::min(cols, kReduceColumnBlock);
+  const int64 col_blocks = (cols + block_cols - 1) / block_cols;
+  // Split the rows between threads if there aren't enough column blocks to
+  // keep them busy.
+  int64 row_shards = std::min<int64>(
+      (d.numThreads() + col_blocks - 1) / col_blocks,
+      std::max<int64>(1, rows * block_cols / kReduceColumnMinShardSize));
+  const int64 shard_rows = (rows + row_shards - 1) / row_shards;
+  row_shards = (rows + shard_rows - 1) / shard_rows;
+
+  // Rows narrower than half a block are accumulated in groups.
+  const int64 group_rows = col_blocks == 1 ? kReduceColumnBlock / cols : 1;
+
+  // Every shard of rows reduces into its own row of 'partial', unless there
+  // is only one.
+  Eigen::Array<T, Eigen::Dynamic, 1> partial;
+  if (row_shards > 1) {
+    partial.resize(row_shards * cols);
+  }
+  T* partial_data = partial.data();
+
+  const Eigen::TensorOpCost cost(
+      shard_rows * block_cols * sizeof(T), block_cols * sizeof(T),
+      shard_rows * block_cols * Eigen::TensorOpCost::AddCost<T>());
+  d.parallelFor(row_shards * col_blocks, cost, [&](int64 first, int64 last) {
+    for (int64 unit = first; unit < last; ++unit) {
+      const int64 shard = unit / col_blocks;
+      const int64 col_begin = (unit % col_blocks) * block_cols;
+      const int64 size = std::min(block_cols, cols - col_begin);
+      const int64 row_begin = shard * shard_rows;
+      const int64 row_end = std::min(rows, row_begin + shard_rows);
+      T* dst = row_shards > 1 ? partial_data + shard * cols : out;
+      Array acc(dst + col_begin, size);
+      int64 row = row_begin;
+      if (group_rows > 1 && row_end - row_begin >= 2 * group_rows) {
+        // Narrow matrix: accumulate groups of consecutive rows as if they
+        // were single long rows, then fold the group into one row.
+        const int64 group_size = group_rows * cols;
+        Eigen::Array<T, Eigen::Dynamic, 1> group_acc =
+            ConstArray(in + row * cols, group_size);
+        for (row += group_rows; row + group_rows <= row_end;
+             row += group_rows) {
+          R::Accumulate(&group_acc, ConstArray(in + row * cols, group_size));
+        }
+        acc = group_acc.head(cols);
+        for (int64 i = 1; i < group_rows; ++i) {
+          R::Accumulate(&acc, group_acc.segment(i * cols, cols));
+        }
+      } else {
+        acc = ConstArray(in + row * cols + col_begin, size);
+        ++row;
+      }
+      for (; row < row_end; ++row) {
+        R::Accumulate(&acc, ConstArray(in + row * cols + col_begin, size));
+      }
+      if (row_shards == 1) {
+        R::Finalize(&acc, rows);
+      }
+    }
+  });
+  if (row_shards == 1) {
+    return;
+  }
+
+  const Eigen::TensorOpCost combine_cost(
+      row_shards * block_cols * sizeof(T), block_cols * sizeof(T),
+      row_shards * block_cols * Eigen::TensorOpCost::AddCost<T>());
+  d.parallelFor(col_blocks, combine_cost, [&](int64 first, int64 last) {
+    for (int64 block = first; block < last; ++block) {
+      const int64 col_begin = block * block_cols;
+      const int64 size = std::min(block_cols, cols - col_begin);
+      Array acc(out + col_begin, size);
+      acc = ConstArray(partial_data + col_begin, size);
+      for (int64 shard = 1; shard < row_shards; ++shard) {
+        R::Accumulate(
+            &acc, ConstArray(partial_data + shard * cols + col_begin, size));
+      }
+      R::Finalize(&acc, rows);
+    }
+  });
+}
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_REDUCTION_CPU_IMPL_H_
@@ -30,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/reduction_cpu_impl.h"
 #include "tensorflow/core/kernels/reduction_ops.h"
 #include "tensorflow/core/kernels/transpose_functor.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -271,9 +272,50 @@ struct ReduceFunctorBase {
   }
 };
 
+// Reductions of a matrix along one dimension use the kernels of
+// reduction_cpu_impl.h when they support the reducer, and Eigen otherwise.
+template <typename Reducer,
+          bool kSupported = MatrixReducerCPU<Reducer>::kSupported>
+struct ReduceMatrixCPU {
+  template <typename OUT_T, typename IN_T, typename ReductionAxes>
+  static bool Reduce(const CPUDevice& d, OUT_T out, IN_T in,
+                     const ReductionAxes& reduction_axes) {
+    return false;
+  }
+};
+
+template <typename Reducer>
+struct ReduceMatrixCPU<Reducer, true> {
+  template <typename OUT_T, typename IN_T, typename ReductionAxes>
+  static bool Reduce(const CPUDevice& d, OUT_T out, IN_T in,
+                     const ReductionAxes& reduction_axes) {
+    if (static_cast<int>(IN_T::NumDimensions) != 2 ||
+        static_cast<int>(OUT_T::NumDimensions) != 1 || in.size() == 0) {
+      return false;
+    }
+    if (reduction_axes[0] == 0) {
+      ReduceMatrixColumnsCPU<Reducer>(d, in.data(), in.dimension(0),
+                                      in.dimension(1), out.data());
+    } else {
+      ReduceMatrixRowsCPU<Reducer>(d, in.data(), in.dimension(0),
+                                   in.dimension(1), out.data());
+    }
+    return true;
+  }
+};
+
 template <typename Reducer>
 struct ReduceFunctor<CPUDevice, Reducer>
-        : ReduceFunctorBase<CPUDevice, Reducer>{};
+    : ReduceFunctorBase<CPUDevice, Reducer> {
+  template <typename OUT_T, typename IN_T, typename ReductionAxes>
+  static void Reduce(const CPUDevice& d, OUT_T out, IN_T in,
+                     const ReductionAxes& reduction_axes,
+                     const Reducer& reducer) {
+    if (!ReduceMatrixCPU<Reducer>::Reduce(d, out, in, reduction_axes)) {
+      ReduceEigenImpl(d, out, in, reduction_axes, reducer);
+    }
+  }
+};
 #if TENSORFLOW_USE_SYCL
 template <typename Reducer>
 struct ReduceFunctor<SYCLDevice, Reducer>
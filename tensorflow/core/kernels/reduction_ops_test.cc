@@ -13,13 +13,104 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+#include <vector>
+
 #include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 
+class ReductionOpTest : public OpsTestBase {
+ protected:
+  // Reduces a 'rows' x 'cols' matrix with 'reduce' along 'axis', and compares
+  // the result with a reduction done element by element.
+  template <typename T>
+  void TestMatrix(const string& reduce, int rows, int cols, int axis) {
+    TF_ASSERT_OK(NodeDefBuilder("reduce", reduce)
+                     .Input(FakeInput(DataTypeToEnum<T>::value))
+                     .Input(FakeInput(DT_INT32))
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    // Small integers and quarters, so that float sums are exact whatever the
+    // order of the additions.
+    std::vector<T> data(rows * cols);
+    for (int i = 0; i < rows * cols; ++i) {
+      data[i] = static_cast<T>((i * 37 + 11) % 101 - 50) / T(1 + i % 2);
+    }
+    AddInputFromArray<T>(TensorShape({rows, cols}), data);
+    AddInputFromArray<int32>(TensorShape({}), {axis});
+    TF_ASSERT_OK(RunOpKernel());
+
+    const int outer = axis == 0 ? cols : rows;
+    const int inner = axis == 0 ? rows : cols;
+    Tensor expected(allocator(), DataTypeToEnum<T>::value,
+                    TensorShape({outer}));
+    for (int o = 0; o < outer; ++o) {
+      T result = T(0);
+      for (int i = 0; i < inner; ++i) {
+        const T value = axis == 0 ? data[i * cols + o] : data[o * cols + i];
+        if (i == 0) {
+          result = value;
+        } else if (reduce == "Max") {
+          result = std::max(result, value);
+        } else if (reduce == "Min") {
+          result = std::min(result, value);
+        } else {
+          result += value;
+        }
+      }
+      if (reduce == "Mean") {
+        result /= static_cast<T>(inner);
+      }
+      expected.flat<T>()(o) = result;
+    }
+    test::ExpectTensorEqual<T>(expected, *GetOutput(0));
+  }
+
+  template <typename T>
+  void TestShapes(const string& reduce) {
+    const std::vector<std::pair<int, int>> shapes = {
+        {1, 1},   {1, 7},      {7, 1},    {3, 1500}, {1500, 3},
+        {4000, 2}, {100, 1029}, {513, 64}, {2, 5000}};
+    for (const auto& shape : shapes) {
+      for (int axis = 0; axis < 2; ++axis) {
+        inputs_.clear();
+        gtl::STLDeleteElements(&tensors_);
+        TestMatrix<T>(reduce, shape.first, shape.second, axis);
+      }
+    }
+  }
+};
+
+TEST_F(ReductionOpTest, Sum) {
+  TestShapes<float>("Sum");
+  TestShapes<double>("Sum");
+  TestShapes<int32>("Sum");
+  TestShapes<int64>("Sum");
+}
+
+TEST_F(ReductionOpTest, Mean) {
+  TestShapes<float>("Mean");
+  TestShapes<int32>("Mean");
+}
+
+TEST_F(ReductionOpTest, Max) {
+  TestShapes<float>("Max");
+  TestShapes<int64>("Max");
+}
+
+TEST_F(ReductionOpTest, Min) {
+  TestShapes<double>("Min");
+  TestShapes<int32>("Min");
+}
+
 // Creates a Graph which "reduce"s a 3D float tensor of "num" elements
 // into a scalar.
 static Graph* ToScalar(const string& reduce, int num) {
@@ -64,6 +155,64 @@ static void BM_Mean3DToScalarCPU(int iters, int num) {
 }
 BENCHMARK(BM_Mean3DToScalarCPU)->Range(1 << 13, 1 << 20);
 
+// Creates a Graph which reduces a 2D float tensor of shape 'rows' x 'cols'
+// along 'axis'.
+static Graph* ToVector(const string& reduce, int rows, int cols, int axis) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor data(DT_FLOAT, TensorShape({rows, cols}));
+  data.flat<float>().setRandom();
+  Tensor axes(DT_INT32, TensorShape({}));
+  axes.scalar<int32>()() = axis;
+  test::graph::Reduce(g, reduce, test::graph::Constant(g, data),
+                      test::graph::Constant(g, axes));
+  return g;
+}
+
+static void ReduceMatrix(int iters, const string& device, const string& reduce,
+                         int rows, int cols, int axis) {
+  const int64 num = static_cast<int64>(rows) * cols;
+  testing::ItemsProcessed(static_cast<int64>(iters) * num);
+  testing::BytesProcessed(static_cast<int64>(iters) * num * sizeof(float));
+  test::Benchmark(device, ToVector(reduce, rows, cols, axis)).Run(iters);
+}
+
+// Reductions of the rows of a matrix, e.g. over the classes of a batch.
+static void BM_Sum2DRowsCPU(int iters, int rows, int cols) {
+  ReduceMatrix(iters, "cpu", "Sum", rows, cols, 1);
+}
+BENCHMARK(BM_Sum2DRowsCPU)
+    ->ArgPair(8192, 8)
+    ->ArgPair(8192, 128)
+    ->ArgPair(1024, 4096)
+    ->ArgPair(8, 1 << 20);
+
+static void BM_Max2DRowsCPU(int iters, int rows, int cols) {
+  ReduceMatrix(iters, "cpu", "Max", rows, cols, 1);
+}
+BENCHMARK(BM_Max2DRowsCPU)->ArgPair(8192, 8)->ArgPair(1024, 4096);
+
+// Reductions of the columns of a matrix, e.g. BiasAddGrad or a mean over the
+// batch.
+static void BM_Sum2DColumnsCPU(int iters, int rows, int cols) {
+  ReduceMatrix(iters, "cpu", "Sum", rows, cols, 0);
+}
+BENCHMARK(BM_Sum2DColumnsCPU)
+    ->ArgPair(1 << 20, 2)
+    ->ArgPair(65536, 32)
+    ->ArgPair(8192, 256)
+    ->ArgPair(4096, 4096)
+    ->ArgPair(8, 1 << 20);
+
+static void BM_Mean2DColumnsCPU(int iters, int rows, int cols) {
+  ReduceMatrix(iters, "cpu", "Mean", rows, cols, 0);
+}
+BENCHMARK(BM_Mean2DColumnsCPU)->ArgPair(65536, 32)->ArgPair(4096, 4096);
+
+static void BM_Min2DColumnsCPU(int iters, int rows, int cols) {
+  ReduceMatrix(iters, "cpu", "Min", rows, cols, 0);
+}
+BENCHMARK(BM_Min2DColumnsCPU)->ArgPair(65536, 32)->ArgPair(4096, 4096);
+
 static void BM_Sum3DToScalarGPU(int iters, int num) {
   ReduceToScalar(iters, "gpu", "Sum", num);
 }
@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/remote_fused_graph_execute_utils.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -80,6 +81,10 @@ class RemoteFusedGraphExecuteOp : public OpKernel {
         << ", gt input count = " << execute_info_.graph_input_node_name_size()
         << ", type count = " << input_types_.size();
 
+    // The executor keeps one set of inputs and outputs for the graph, so
+    // concurrent steps take turns to fill, execute and read it.
+    mutex_lock l(mu_);
+
     // 3. Send first data type inputs into remote processor
     for (int i = 0; i < graph_input_count; ++i) {
       const Tensor& input_tensor = ctx->input(i);
@@ -123,6 +128,7 @@ class RemoteFusedGraphExecuteOp : public OpKernel {
 
  private:
   RemoteFusedGraphExecuteInfo execute_info_;
+  mutex mu_;
   std::unique_ptr<IRemoteFusedGraphExecutor> remote_fused_graph_executor_;
   DataTypeVector input_types_;
   DataTypeVector output_types_;
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/remote_fused_graph_execute_utils.h"
 
 #include <algorithm>
+#include <deque>
 #include <queue>
 #include <utility>
 
@@ -760,7 +761,7 @@ RemoteFusedGraphExecuteUtils::BuildRemoteFusedGraphExecuteOpNode(
     // Determine one cluster border
     std::vector<string>& border_inputs = std::get<1>(ci);
     std::vector<string>& border_outputs = std::get<2>(ci);
-    for (const string& node_name : node_names) {
+    for (const string& node_name : std::get<0>(ci)) {
       Node* node = FindMutableNodeByName(node_name, &graph);
       CHECK_NOTNULL(node);
       int input_count = 0;
@@ -1035,17 +1036,145 @@ RemoteFusedGraphExecuteUtils::BuildRemoteFusedGraphExecuteOpNode(
   TF_RETURN_IF_ERROR(RemoteFusedGraphExecuteUtils::ClusterizeNodes(
       subgraph_nodes, input_graph_def, &ci_vec));
 
+  // No edge joins two clusters, so the borders found in input_graph_def are
+  // still valid once the clusters before each one are fused.
+  GraphDef graph_def = input_graph_def;
   for (int i = 0; i < ci_vec.size(); ++i) {
     const string remote_fused_graph_node_name =
         strings::StrCat(remote_fused_graph_node_name_prefix, "/", i);
-    TF_RETURN_IF_ERROR(FuseCluster(input_graph_def, inputs, outputs,
+    TF_RETURN_IF_ERROR(FuseCluster(graph_def, inputs, outputs,
                                    remote_fused_graph_node_name, ci_vec.at(i),
                                    remote_fused_graph_executor_name,
                                    require_shape_type, output_graph_def));
+    graph_def = *output_graph_def;
+  }
+  if (ci_vec.empty()) {
+    *output_graph_def = input_graph_def;
   }
   return Status::OK();
 }
 
+/* static */ Status RemoteFusedGraphExecuteUtils::FuseRemoteGraphByOpTypes(
+    const GraphDef& input_graph_def, const std::vector<string>& inputs,
+    const std::vector<string>& outputs,
+    const string& remote_fused_graph_node_name_prefix,
+    const std::unordered_set<string>& fused_op_types,
+    const string& remote_fused_graph_executor_name,
+    const bool require_shape_type, GraphDef* output_graph_def) {
+  Graph graph(OpRegistry::Global());
+  ShapeRefiner shape_refiner(graph.versions().producer(), graph.op_registry());
+  TF_RETURN_IF_ERROR(
+      ImportGraphDef({}, input_graph_def, &graph, &shape_refiner));
+
+  const std::unordered_set<string> input_node_names =
+      BuildNodeSetFromNodeNamesAndPorts(inputs);
+  std::unordered_set<string> fused_node_names;
+  for (const Node* node : graph.nodes()) {
+    if (node->IsOp() && fused_op_types.count(node->type_string()) > 0 &&
+        input_node_names.count(node->name()) <= 0) {
+      fused_node_names.emplace(node->name());
+    }
+  }
+
+  // A fused node must take either all or none of its inputs from its
+  // subgraph, an input from outside must be the only output of its node,
+  // and so must a graph output.  Besides, no path may leave a subgraph and
+  // come back to it, as the fused node would depend on itself.  Nodes
+  // breaking those rules stay on the CPU until no fused node breaks them.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const Node* node : graph.nodes()) {
+      if (fused_node_names.count(node->name()) <= 0) {
+        continue;
+      }
+      int inside_count = 0;
+      bool fusable = true;
+      for (const Edge* in_edge : node->in_edges()) {
+        const Node* src_node = in_edge->src();
+        if (src_node->IsSource() ||
+            fused_node_names.count(src_node->name()) > 0) {
+          ++inside_count;
+        } else if (src_node->num_outputs() != 1) {
+          fusable = false;
+        }
+      }
+      if (inside_count != 0 && inside_count != node->in_edges().size()) {
+        fusable = false;
+      }
+      for (const Edge* out_edge : node->out_edges()) {
+        if (out_edge->dst()->IsSink() && node->num_outputs() != 1) {
+          fusable = false;
+        }
+      }
+      if (!fusable) {
+        VLOG(1) << "Leave " << node->name() << " on the CPU.";
+        fused_node_names.erase(node->name());
+        changed = true;
+      }
+    }
+    if (changed) {
+      continue;
+    }
+
+    std::unordered_set<string> clustered;
+    for (const Node* node : graph.nodes()) {
+      if (fused_node_names.count(node->name()) <= 0 ||
+          !clustered.insert(node->name()).second) {
+        continue;
+      }
+      // Collect the subgraph of node, and the nodes outside of it which
+      // consume its outputs.
+      std::unordered_set<const Node*> cluster{node};
+      std::deque<const Node*> queue{node};
+      std::deque<const Node*> consumers;
+      while (!queue.empty()) {
+        const Node* member = queue.front();
+        queue.pop_front();
+        for (const Node* in : member->in_nodes()) {
+          if (fused_node_names.count(in->name()) > 0 &&
+              cluster.insert(in).second) {
+            clustered.insert(in->name());
+            queue.push_back(in);
+          }
+        }
+        for (const Node* out : member->out_nodes()) {
+          if (fused_node_names.count(out->name()) > 0) {
+            if (cluster.insert(out).second) {
+              clustered.insert(out->name());
+              queue.push_back(out);
+            }
+          } else {
+            consumers.push_back(out);
+          }
+        }
+      }
+      // Members reachable from the consumers go back to the CPU.
+      std::unordered_set<const Node*> visited;
+      while (!consumers.empty()) {
+        const Node* consumer = consumers.front();
+        consumers.pop_front();
+        if (!visited.insert(consumer).second) {
+          continue;
+        }
+        for (const Node* out : consumer->out_nodes()) {
+          if (cluster.count(out) > 0 &&
+              fused_node_names.erase(out->name()) > 0) {
+            VLOG(1) << "Leave " << out->name() << " on the CPU.";
+            changed = true;
+          }
+          consumers.push_back(out);
+        }
+      }
+    }
+  }
+
+  return FuseRemoteGraphByNodeNames(
+      input_graph_def, inputs, outputs, remote_fused_graph_node_name_prefix,
+      fused_node_names, remote_fused_graph_executor_name, require_shape_type,
+      output_graph_def);
+}
+
 /* static */ Status RemoteFusedGraphExecuteUtils::FuseRemoteGraphByBorder(
     const GraphDef& input_graph_def, const std::vector<string>& inputs,
     const std::vector<string>& outputs,
@@ -53,6 +53,8 @@ class RemoteFusedGraphExecuteUtils {
       TRANSFORM_ARG_REMOTE_FUSED_GRAPH_NODE_NAME =
           "remote_fused_graph_node_name";
   static constexpr const char* const TRANSFORM_ARG_FUSED_NODES = "fused_nodes";
+  static constexpr const char* const TRANSFORM_ARG_FUSED_OP_TYPES =
+      "fused_op_types";
   static constexpr const char* const TRANSFORM_ARG_BORDER_INPUTS =
       "border_inputs";
   static constexpr const char* const TRANSFORM_ARG_BORDER_OUTPUTS =
@@ -230,6 +232,18 @@ class RemoteFusedGraphExecuteUtils {
       const string& remote_graph_executor_name, const bool require_shape_type,
       GraphDef* output_graph_def);
 
+  // Fuse the nodes whose op types are in fused_op_types.  Each connected
+  // group of those nodes is fused into its own RemoteFusedGraphExecuteOp
+  // node, and the other nodes run on the CPU between them.  Nodes which
+  // can't be on the border of a fused subgraph also stay on the CPU.
+  static Status FuseRemoteGraphByOpTypes(
+      const GraphDef& input_graph_def, const std::vector<string>& inputs,
+      const std::vector<string>& outputs,
+      const string& remote_fused_graph_node_name_prefix,
+      const std::unordered_set<string>& fused_op_types,
+      const string& remote_fused_graph_executor_name,
+      const bool require_shape_type, GraphDef* output_graph_def);
+
   // Place arguments to fuse remote graph.
   static Status PlaceRemoteGraphArguments(
       const std::vector<string>& inputs, const std::vector<string>& outputs,
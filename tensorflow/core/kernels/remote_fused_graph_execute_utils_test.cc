@@ -483,6 +483,12 @@ TEST(RemoteFusedGraphExecuteUtils, ClusterizeNodes) {
   TF_ASSERT_OK(RemoteFusedGraphExecuteUtils::ClusterizeNodes(
       {"A", "B", "D", "E", "F", "G"}, graph_def, &ci_vec));
   ASSERT_EQ(2, ci_vec.size());
+  // The border of each cluster only has its own inputs and outputs.
+  for (const ClusterInfo& ci : ci_vec) {
+    EXPECT_EQ(3, std::get<0>(ci).size()) << DumpInOutNames(ci_vec);
+    EXPECT_EQ(0, std::get<1>(ci).size()) << DumpInOutNames(ci_vec);
+    EXPECT_EQ(1, std::get<2>(ci).size()) << DumpInOutNames(ci_vec);
+  }
 }
 
 TEST(RemoteFusedGraphExecuteUtils, BuildSubgraphDefByInOut) {
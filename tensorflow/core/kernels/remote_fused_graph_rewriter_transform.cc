@@ -36,6 +36,23 @@ remote_fused_graph_executor_name="executor" \
 remote_fused_graph_node_name="node_name" \
 )'
 
+// Specify remote graph by op types.  Each connected group of nodes of those
+// types is fused into its own node, and the other nodes stay on the CPU.
+bazel-bin/tensorflow/tools/graph_transforms/transform_graph \
+--in_graph=/tmp/tensorflow_inception_v3_stripped_optimized_quantized.pb \
+--out_graph=\
+/tmp/tensorflow_inception_v3_stripped_optimized_quantized_fused_hexagon.pb \
+--inputs='Mul' \
+--outputs='softmax' \
+--transforms='\
+fuse_remote_graph(
+input_types="float" \
+input_shapes="1,299,299,3" \
+fused_op_types="QuantizedConv2D,QuantizedMaxPool,Requantize",
+remote_fused_graph_executor_name="executor" \
+remote_fused_graph_node_name="node_name" \
+)'
+
 // Specify remote graph by border inputs and outputs
 bazel-bin/tensorflow/tools/graph_transforms/transform_graph \
 --in_graph=/tmp/tensorflow_inception_v3_stripped_optimized_quantized.pb \
@@ -148,6 +165,11 @@ Status FuseRemoteGraph(const GraphDef& input_graph_def,
                                       &mutable_input_graph_def));
   }
 
+  string fused_op_types_str;
+  TF_RETURN_IF_ERROR(context.GetOneStringParameter(
+      RemoteFusedGraphExecuteUtils::TRANSFORM_ARG_FUSED_OP_TYPES, "",
+      &fused_op_types_str));
+
   const bool require_shape_type = !input_types_str.empty();
   if (!fused_nodes_str.empty()) {
     const std::vector<string> fused_node_name_vector =
@@ -158,6 +180,15 @@ Status FuseRemoteGraph(const GraphDef& input_graph_def,
         mutable_input_graph_def, inputs, outputs, remote_fused_graph_node_name,
         fused_node_names, remote_graph_executor_name, require_shape_type,
         output_graph_def));
+  } else if (!fused_op_types_str.empty()) {
+    const std::vector<string> fused_op_type_vector =
+        str_util::Split(fused_op_types_str, ",");
+    const std::unordered_set<string> fused_op_types(
+        fused_op_type_vector.begin(), fused_op_type_vector.end());
+    TF_RETURN_IF_ERROR(RemoteFusedGraphExecuteUtils::FuseRemoteGraphByOpTypes(
+        mutable_input_graph_def, inputs, outputs, remote_fused_graph_node_name,
+        fused_op_types, remote_graph_executor_name, require_shape_type,
+        output_graph_def));
   } else if (!border_inputs_str.empty() && !border_outputs_str.empty()) {
     const std::vector<string> border_inputs =
         str_util::Split(border_inputs_str, ",");
@@ -96,6 +96,12 @@ class FuseRemoteGraphMultipleAddOpsRewriterTest : public ::testing::Test {
            {fused_node_names_str_}}));
     }
 
+    if (!fused_op_types_str_.empty()) {
+      context.params.insert(std::pair<string, std::vector<string>>(
+          {RemoteFusedGraphExecuteUtils::TRANSFORM_ARG_FUSED_OP_TYPES,
+           {fused_op_types_str_}}));
+    }
+
     if (!border_inputs_str_.empty()) {
       context.params.insert(std::pair<string, std::vector<string>>(
           {RemoteFusedGraphExecuteUtils::TRANSFORM_ARG_BORDER_INPUTS,
@@ -160,6 +166,7 @@ class FuseRemoteGraphMultipleAddOpsRewriterTest : public ::testing::Test {
   GraphDef input_graph_def_with_fuse_args_;
   GraphDef output_graph_def_;
   string fused_node_names_str_;
+  string fused_op_types_str_;
   string border_inputs_str_;
   string border_outputs_str_;
 };
@@ -194,6 +201,23 @@ TEST_F(FuseRemoteGraphMultipleAddOpsRewriterTest,
   CheckGraph(3, 1);
 }
 
+TEST_F(FuseRemoteGraphMultipleAddOpsRewriterTest,
+       FuseRemoteGraphByOpTypesWithShapeType_Add) {
+  SetInputShapeType();
+  fused_op_types_str_ = "Add";
+  TF_ASSERT_OK(Fuse());
+  // H, I, J and K mix inputs from inside and outside of a subgraph, or
+  // would make one depend on itself, so only F and G are fused.
+  CheckGraph(11, 2);
+}
+
+TEST_F(FuseRemoteGraphMultipleAddOpsRewriterTest,
+       FuseRemoteGraphByOpTypesWithoutShapeType_Add) {
+  fused_op_types_str_ = "Add";
+  TF_ASSERT_OK(Fuse());
+  CheckGraph(11, 2);
+}
+
 TEST_F(FuseRemoteGraphMultipleAddOpsRewriterTest,
        FuseRemoteGraphByBorderWithShapeType_FCG_J) {
   SetInputShapeType();
@@ -50,7 +50,7 @@ class RepeatDatasetOp : public UnaryDatasetOpKernel {
 
     ~Dataset() override { input_->Unref(); }
 
-    std::unique_ptr<IteratorBase> MakeIterator() const override {
+    std::unique_ptr<IteratorBase> MakeIteratorInternal() const override {
       if (count_ < 0) {
         return std::unique_ptr<IteratorBase>(new ForeverIterator(this));
       } else if (count_ == 0) {
@@ -24,8 +24,8 @@ limitations under the License.
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/type_traits.h"
 #include "tensorflow/core/framework/types.h"
-#include "tensorflow/core/kernels/meta_support.h"
 #include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/kernels/requantize.h"
 #include "tensorflow/core/lib/core/errors.h"
 
 namespace tensorflow {
@@ -51,20 +51,12 @@ class RequantizeOp : public OpKernel {
     Tensor* output_max = nullptr;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(2, TensorShape({}), &output_max));
 
-    OP_REQUIRES(
-        ctx, requested_output_min_float <= 0.0f,
-        errors::InvalidArgument("requested_output_min must be <= 0, but got ",
-                                requested_output_min_float));
-    OP_REQUIRES(
-        ctx, requested_output_max_float >= requested_output_min_float,
-        errors::InvalidArgument(
-            "requested_output_max must be >= requested_output_min, but got ",
-            requested_output_max_float, " and ", requested_output_min_float));
-
-    auto input_array = input.flat<T1>();
+    OP_REQUIRES_OK(ctx, ValidateRequantizeRange(requested_output_min_float,
+                                                requested_output_max_float));
 
 #if 0
     // This is the reference, non-eigen implementation:
+    auto input_array = input.flat<T1>();
     auto output_array = output->flat<T2>();
     RequantizeManyInNewRange<T1, T2>(
         input_array.data(), input_array.size(),
@@ -73,21 +65,9 @@ class RequantizeOp : public OpKernel {
         output_array.data());
 #endif
 
-    if (input_array.size() > 0) {
-      if (meta::IsSupportedAndEnabled() && std::is_same<T1, qint32>() &&
-          std::is_same<T2, quint8>()) {
-        auto input_i32_array = input.flat<qint32>();
-        meta::Requantize(ctx, input_i32_array.data(), input_i32_array.size(),
-                         input_min_float, input_max_float,
-                         requested_output_min_float, requested_output_max_float,
-                         output->flat<quint8>().data());
-      } else {
-        RequantizeManyInNewRangeUsingEigen<T1, T2>(
-            ctx->eigen_device<CPUDevice>(), input, input_min_float,
-            input_max_float, requested_output_min_float,
-            requested_output_max_float, output);
-      }
-    }
+    RequantizeTensor<T1, T2>(ctx, input, input_min_float, input_max_float,
+                             requested_output_min_float,
+                             requested_output_max_float, output);
 
     output_min->flat<float>().setConstant(requested_output_min_float);
     output_max->flat<float>().setConstant(requested_output_max_float);
@@ -0,0 +1,73 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_REQUANTIZE_H_
+#define TENSORFLOW_KERNELS_REQUANTIZE_H_
+
+#include <type_traits>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/meta_support.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+// Checks that [requested_output_min, requested_output_max] is a range that
+// higher bit depth results can be requantized into. Shared by Requantize and
+// the ops that have a Requantize fused into their output.
+inline Status ValidateRequantizeRange(float requested_output_min,
+                                      float requested_output_max) {
+  if (!(requested_output_min <= 0.0f)) {
+    return errors::InvalidArgument(
+        "requested_output_min must be <= 0, but got ", requested_output_min);
+  }
+  if (!(requested_output_max >= requested_output_min)) {
+    return errors::InvalidArgument(
+        "requested_output_max must be >= requested_output_min, but got ",
+        requested_output_max, " and ", requested_output_min);
+  }
+  return Status::OK();
+}
+
+// Converts 'input', whose quantized values represent [input_min, input_max],
+// into the preallocated 'output' of the same shape, whose values represent
+// [requested_output_min, requested_output_max].
+template <class T1, class T2>
+void RequantizeTensor(OpKernelContext* context, const Tensor& input,
+                      float input_min, float input_max,
+                      float requested_output_min, float requested_output_max,
+                      Tensor* output) {
+  if (input.NumElements() == 0) {
+    return;
+  }
+  if (meta::IsSupportedAndEnabled() && std::is_same<T1, qint32>() &&
+      std::is_same<T2, quint8>()) {
+    auto input_i32_array = input.flat<qint32>();
+    meta::Requantize(context, input_i32_array.data(), input_i32_array.size(),
+                     input_min, input_max, requested_output_min,
+                     requested_output_max, output->flat<quint8>().data());
+  } else {
+    RequantizeManyInNewRangeUsingEigen<T1, T2>(
+        context->eigen_device<Eigen::ThreadPoolDevice>(), input, input_min,
+        input_max, requested_output_min, requested_output_max, output);
+  }
+}
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_REQUANTIZE_H_
@@ -18,7 +18,9 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/resize_bilinear_op.h"
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -28,42 +30,15 @@ limitations under the License.
 #include "tensorflow/core/kernels/image_resizer_state.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
-template <typename Device, typename T>
-class ResizeBilinearOp : public OpKernel {
- public:
-  explicit ResizeBilinearOp(OpKernelConstruction* context) : OpKernel(context) {
-    OP_REQUIRES_OK(context, context->GetAttr("align_corners", &align_corners_));
-  }
-
-  void Compute(OpKernelContext* context) override {
-    const Tensor& input = context->input(0);
-    ImageResizerState st(align_corners_);
-    st.ValidateAndCreateOutput(context, input);
-
-    if (!context->status().ok()) return;
-
-    // Return if the output is empty.
-    if (st.output->NumElements() == 0) return;
-
-    typename TTypes<T, 4>::ConstTensor image_data = input.tensor<T, 4>();
-    typename TTypes<float, 4>::Tensor output_data =
-        st.output->tensor<float, 4>();
-
-    functor::ResizeBilinear<Device, T>()(context->eigen_device<Device>(),
-                                         image_data, st.height_scale,
-                                         st.width_scale, output_data);
-  }
-
- private:
-  bool align_corners_;
-};
-
 namespace {
 // Compute the interpolation indices only once.
 struct CachedInterpolation {
@@ -88,156 +63,243 @@ inline void compute_interpolation_weights(const int64 out_size,
   }
 }
 
-/**
- * Computes the bilinear interpolation from the appropriate 4 float points
- * and the linear interpolation weights.
- */
-inline float compute_lerp(const float top_left, const float top_right,
-                          const float bottom_left, const float bottom_right,
-                          const float x_lerp, const float y_lerp) {
-  const float top = top_left + (top_right - top_left) * x_lerp;
-  const float bottom = bottom_left + (bottom_right - bottom_left) * x_lerp;
-  return top + (bottom - top) * y_lerp;
+// The interpolation weights of a resize, which only depend on the shapes of
+// its input and output.
+struct InterpolationTables {
+  int64 in_height;
+  int64 in_width;
+  int64 out_height;
+  int64 out_width;
+  int64 channels;
+  float height_scale;
+  float width_scale;
+  // The lower and upper indices of `xs` are scaled by the number of channels,
+  // to avoid a multiplication during iteration.
+  std::vector<CachedInterpolation> xs;
+  std::vector<CachedInterpolation> ys;
+
+  bool Matches(int64 in_height, int64 in_width, int64 out_height,
+               int64 out_width, int64 channels, float height_scale,
+               float width_scale) const {
+    return this->in_height == in_height && this->in_width == in_width &&
+           this->out_height == out_height && this->out_width == out_width &&
+           this->channels == channels && this->height_scale == height_scale &&
+           this->width_scale == width_scale;
+  }
+};
+
+std::shared_ptr<const InterpolationTables> NewInterpolationTables(
+    int64 in_height, int64 in_width, int64 out_height, int64 out_width,
+    int64 channels, float height_scale, float width_scale) {
+  std::shared_ptr<InterpolationTables> tables(new InterpolationTables);
+  tables->in_height = in_height;
+  tables->in_width = in_width;
+  tables->out_height = out_height;
+  tables->out_width = out_width;
+  tables->channels = channels;
+  tables->height_scale = height_scale;
+  tables->width_scale = width_scale;
+  tables->ys.resize(out_height + 1);
+  tables->xs.resize(out_width + 1);
+
+  // Compute the cached interpolation weights on the x and y dimensions.
+  compute_interpolation_weights(out_height, in_height, height_scale,
+                                tables->ys.data());
+  compute_interpolation_weights(out_width, in_width, width_scale,
+                                tables->xs.data());
+
+  // Scale x interpolation weights to avoid a multiplication during iteration.
+  for (int i = 0; i < tables->xs.size(); ++i) {
+    tables->xs[i].lower *= channels;
+    tables->xs[i].upper *= channels;
+  }
+  return std::move(tables);
 }
 
+// Interpolates the input row `input` horizontally into the `out_width` pixels
+// of `output`.
 template <typename T>
-void resize_image(
-    typename TTypes<T, 4>::ConstTensor images, const int batch_size,
-    const int64 in_height, const int64 in_width, const int64 out_height,
-    const int64 out_width, const int channels,
-    const std::vector<CachedInterpolation>& xs,
-    const std::vector<CachedInterpolation>& ys,
-    typename TTypes<float, 4>::Tensor output) TF_ATTRIBUTE_NOINLINE;
+inline void interpolate_row(const T* input, const CachedInterpolation* xs,
+                            const int64 out_width, const int channels,
+                            float* output) {
+  if (channels == 3) {
+    for (int64 x = 0; x < out_width; ++x) {
+      const int64 xs_lower = xs[x].lower;
+      const int64 xs_upper = xs[x].upper;
+      const float xs_lerp = xs[x].lerp;
+
+      const float left0(input[xs_lower + 0]);
+      const float right0(input[xs_upper + 0]);
+      const float left1(input[xs_lower + 1]);
+      const float right1(input[xs_upper + 1]);
+      const float left2(input[xs_lower + 2]);
+      const float right2(input[xs_upper + 2]);
+
+      output[x * 3 + 0] = left0 + (right0 - left0) * xs_lerp;
+      output[x * 3 + 1] = left1 + (right1 - left1) * xs_lerp;
+      output[x * 3 + 2] = left2 + (right2 - left2) * xs_lerp;
+    }
+  } else {
+    for (int64 x = 0; x < out_width; ++x) {
+      const int64 xs_lower = xs[x].lower;
+      const int64 xs_upper = xs[x].upper;
+      const float xs_lerp = xs[x].lerp;
+      for (int c = 0; c < channels; ++c) {
+        const float left(input[xs_lower + c]);
+        const float right(input[xs_upper + c]);
+        output[x * channels + c] = left + (right - left) * xs_lerp;
+      }
+    }
+  }
+}
+
+// Resizes the output rows [start, limit) of `output`, where row `r` is row
+// `r % out_height` of image `r / out_height` of the batch.
+//
+// The input rows are first interpolated horizontally, and each output row is
+// then a vectorized linear interpolation of two of them. Consecutive output
+// rows usually interpolate the same input rows when upsampling, so the last
+// two horizontally interpolated rows are kept and reused.
 template <typename T>
-void resize_image(typename TTypes<T, 4>::ConstTensor images,
-                  const int batch_size, const int64 in_height,
-                  const int64 in_width, const int64 out_height,
-                  const int64 out_width, const int channels,
-                  const std::vector<CachedInterpolation>& xs_vec,
-                  const std::vector<CachedInterpolation>& ys,
-                  typename TTypes<float, 4>::Tensor output) {
-  const int64 in_row_size = in_width * channels;
-  const int64 in_batch_num_values = in_height * in_row_size;
+void resize_image_rows(typename TTypes<T, 4>::ConstTensor images,
+                       const InterpolationTables& tables, const int64 start,
+                       const int64 limit,
+                       typename TTypes<float, 4>::Tensor output) {
+  const int64 in_height = tables.in_height;
+  const int64 out_height = tables.out_height;
+  const int64 out_width = tables.out_width;
+  const int channels = tables.channels;
+  const int64 in_row_size = tables.in_width * channels;
   const int64 out_row_size = out_width * channels;
-
-  const T* input_b_ptr = images.data();
-  const CachedInterpolation* xs = xs_vec.data();
-
-  if (channels == 3) {
-    float* output_y_ptr = output.data();
-    for (int b = 0; b < batch_size; ++b) {
-      for (int64 y = 0; y < out_height; ++y) {
-        const T* ys_input_lower_ptr = input_b_ptr + ys[y].lower * in_row_size;
-        const T* ys_input_upper_ptr = input_b_ptr + ys[y].upper * in_row_size;
-        const float ys_lerp = ys[y].lerp;
-        for (int64 x = 0; x < out_width; ++x) {
-          const int64 xs_lower = xs[x].lower;
-          const int64 xs_upper = xs[x].upper;
-          const float xs_lerp = xs[x].lerp;
-
-          // Read channel 0.
-          const float top_left0(ys_input_lower_ptr[xs_lower + 0]);
-          const float top_right0(ys_input_lower_ptr[xs_upper + 0]);
-          const float bottom_left0(ys_input_upper_ptr[xs_lower + 0]);
-          const float bottom_right0(ys_input_upper_ptr[xs_upper + 0]);
-
-          // Read channel 1.
-          const float top_left1(ys_input_lower_ptr[xs_lower + 1]);
-          const float top_right1(ys_input_lower_ptr[xs_upper + 1]);
-          const float bottom_left1(ys_input_upper_ptr[xs_lower + 1]);
-          const float bottom_right1(ys_input_upper_ptr[xs_upper + 1]);
-
-          // Read channel 2.
-          const float top_left2(ys_input_lower_ptr[xs_lower + 2]);
-          const float top_right2(ys_input_lower_ptr[xs_upper + 2]);
-          const float bottom_left2(ys_input_upper_ptr[xs_lower + 2]);
-          const float bottom_right2(ys_input_upper_ptr[xs_upper + 2]);
-
-          // Compute output.
-          output_y_ptr[x * channels + 0] =
-              compute_lerp(top_left0, top_right0, bottom_left0, bottom_right0,
-                           xs_lerp, ys_lerp);
-          output_y_ptr[x * channels + 1] =
-              compute_lerp(top_left1, top_right1, bottom_left1, bottom_right1,
-                           xs_lerp, ys_lerp);
-          output_y_ptr[x * channels + 2] =
-              compute_lerp(top_left2, top_right2, bottom_left2, bottom_right2,
-                           xs_lerp, ys_lerp);
-        }
-        output_y_ptr += out_row_size;
+  const CachedInterpolation* xs = tables.xs.data();
+  const CachedInterpolation* ys = tables.ys.data();
+
+  typedef Eigen::Map<Eigen::Array<float, Eigen::Dynamic, 1>> Row;
+  typedef Eigen::Map<const Eigen::Array<float, Eigen::Dynamic, 1>> ConstRow;
+  std::vector<float> buffer(2 * out_row_size);
+  float* top = buffer.data();
+  float* bottom = top + out_row_size;
+  // The input rows in `top` and `bottom`, as indices in the whole batch.
+  int64 top_row = -1;
+  int64 bottom_row = -1;
+
+  const T* input_data = images.data();
+  float* output_y_ptr = output.data() + start * out_row_size;
+  for (int64 row = start; row < limit; ++row) {
+    const int64 b = row / out_height;
+    const int64 y = row % out_height;
+    const int64 lower_row = b * in_height + ys[y].lower;
+    const int64 upper_row = b * in_height + ys[y].upper;
+    if (lower_row != top_row) {
+      if (lower_row == bottom_row) {
+        std::swap(top, bottom);
+        std::swap(top_row, bottom_row);
+      } else {
+        interpolate_row(input_data + lower_row * in_row_size, xs, out_width,
+                        channels, top);
+        top_row = lower_row;
       }
-      input_b_ptr += in_batch_num_values;
     }
-  } else {
-    float* output_y_ptr = output.data();
-    for (int b = 0; b < batch_size; ++b) {
-      for (int64 y = 0; y < out_height; ++y) {
-        const T* ys_input_lower_ptr = input_b_ptr + ys[y].lower * in_row_size;
-        const T* ys_input_upper_ptr = input_b_ptr + ys[y].upper * in_row_size;
-        const float ys_lerp = ys[y].lerp;
-        for (int64 x = 0; x < out_width; ++x) {
-          auto xs_lower = xs[x].lower;
-          auto xs_upper = xs[x].upper;
-          auto xs_lerp = xs[x].lerp;
-          for (int c = 0; c < channels; ++c) {
-            const float top_left(ys_input_lower_ptr[xs_lower + c]);
-            const float top_right(ys_input_lower_ptr[xs_upper + c]);
-            const float bottom_left(ys_input_upper_ptr[xs_lower + c]);
-            const float bottom_right(ys_input_upper_ptr[xs_upper + c]);
-            output_y_ptr[x * channels + c] =
-                compute_lerp(top_left, top_right, bottom_left, bottom_right,
-                             xs_lerp, ys_lerp);
-          }
-        }
-        output_y_ptr += out_row_size;
+    if (upper_row != bottom_row) {
+      if (upper_row == top_row) {
+        std::copy(top, top + out_row_size, bottom);
+      } else {
+        interpolate_row(input_data + upper_row * in_row_size, xs, out_width,
+                        channels, bottom);
       }
-      input_b_ptr += in_batch_num_values;
+      bottom_row = upper_row;
     }
+    ConstRow top_values(top, out_row_size);
+    ConstRow bottom_values(bottom, out_row_size);
+    Row(output_y_ptr, out_row_size) =
+        top_values + (bottom_values - top_values) * ys[y].lerp;
+    output_y_ptr += out_row_size;
   }
 }
 
 }  // namespace
 
-// Partial specialization of ResizeBilinear functor for a CPUDevice.
-namespace functor {
-template <typename T>
-struct ResizeBilinear<CPUDevice, T> {
-  void operator()(const CPUDevice& d, typename TTypes<T, 4>::ConstTensor images,
-                  const float height_scale, const float width_scale,
-                  typename TTypes<float, 4>::Tensor output) {
-    const int batch_size = images.dimension(0);
+template <typename Device, typename T>
+class ResizeBilinearOp : public OpKernel {
+ public:
+  explicit ResizeBilinearOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("align_corners", &align_corners_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    ImageResizerState st(align_corners_);
+    st.ValidateAndCreateOutput(context, input);
+
+    if (!context->status().ok()) return;
+
+    // Return if the output is empty.
+    if (st.output->NumElements() == 0) return;
+
+    typename TTypes<T, 4>::ConstTensor image_data = input.tensor<T, 4>();
+    typename TTypes<float, 4>::Tensor output_data =
+        st.output->tensor<float, 4>();
+
+    Resize(context, context->eigen_device<Device>(), image_data,
+           st.height_scale, st.width_scale, output_data);
+  }
+
+ private:
+  void Resize(OpKernelContext* context, const GPUDevice& d,
+              typename TTypes<T, 4>::ConstTensor images,
+              const float height_scale, const float width_scale,
+              typename TTypes<float, 4>::Tensor output) {
+    functor::ResizeBilinear<GPUDevice, T>()(d, images, height_scale,
+                                            width_scale, output);
+  }
+
+  // On CPU, the interpolation tables are cached across calls with the same
+  // shapes, and the output rows of the whole batch are sharded across the
+  // worker threads.
+  void Resize(OpKernelContext* context, const CPUDevice& d,
+              typename TTypes<T, 4>::ConstTensor images,
+              const float height_scale, const float width_scale,
+              typename TTypes<float, 4>::Tensor output) {
+    const int64 batch_size = images.dimension(0);
     const int64 in_height = images.dimension(1);
     const int64 in_width = images.dimension(2);
-    const int channels = images.dimension(3);
-
+    const int64 channels = images.dimension(3);
     const int64 out_height = output.dimension(1);
     const int64 out_width = output.dimension(2);
 
     // Handle no-op resizes efficiently.
     if (out_height == in_height && out_width == in_width) {
-      output = images.template cast<float>();
+      output.device(d) = images.template cast<float>();
       return;
     }
 
-    std::vector<CachedInterpolation> ys(out_height + 1);
-    std::vector<CachedInterpolation> xs(out_width + 1);
-
-    // Compute the cached interpolation weights on the x and y dimensions.
-    compute_interpolation_weights(out_height, in_height, height_scale,
-                                  ys.data());
-    compute_interpolation_weights(out_width, in_width, width_scale, xs.data());
-
-    // Scale x interpolation weights to avoid a multiplication during iteration.
-    for (int i = 0; i < xs.size(); ++i) {
-      xs[i].lower *= channels;
-      xs[i].upper *= channels;
+    std::shared_ptr<const InterpolationTables> tables;
+    {
+      mutex_lock l(mu_);
+      if (tables_ == nullptr ||
+          !tables_->Matches(in_height, in_width, out_height, out_width,
+                            channels, height_scale, width_scale)) {
+        tables_ = NewInterpolationTables(in_height, in_width, out_height,
+                                         out_width, channels, height_scale,
+                                         width_scale);
+      }
+      tables = tables_;
     }
 
-    resize_image<T>(images, batch_size, in_height, in_width, out_height,
-                    out_width, channels, xs, ys, output);
+    // Each output value costs a horizontal and a vertical interpolation.
+    const int64 cost_per_row = out_width * channels * 10;
+    auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
+    Shard(worker_threads.num_threads, worker_threads.workers,
+          batch_size * out_height, cost_per_row,
+          [&images, &tables, &output](int64 start, int64 limit) {
+            resize_image_rows<T>(images, *tables, start, limit, output);
+          });
   }
+
+  bool align_corners_;
+  mutex mu_;
+  std::shared_ptr<const InterpolationTables> tables_ GUARDED_BY(mu_);
 };
-}  // namespace functor
 
 template <typename Device, typename T>
 class ResizeBilinearOpGrad : public OpKernel {
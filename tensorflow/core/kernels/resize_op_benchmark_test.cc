@@ -54,4 +54,42 @@ BM_ResizeDev(gpu, ResizeNearestNeighbor, 10, 499, 499);
 BM_ResizeDev(cpu, ResizeBilinear, 10, 499, 499);
 BM_ResizeDev(gpu, ResizeBilinear, 10, 499, 499);
 
+// Resizes decoded uint8 images to the input size of a model, as is done in
+// input pipelines.
+static Graph* BM_ResizeImages(const char* algorithm, int batches, int height,
+                              int width, int out_height, int out_width) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Tensor in(DT_UINT8, TensorShape({batches, height, width, 3}));
+  in.flat<uint8>().setRandom();
+
+  Tensor out_size(DT_INT32, TensorShape({2}));
+  auto out_size_flat = out_size.flat<int32>();
+  out_size_flat(0) = out_height;
+  out_size_flat(1) = out_width;
+
+  Node* ret;
+  Status s = NodeBuilder(g->NewName("n"), algorithm)
+                 .Input(test::graph::Constant(g, in))
+                 .Input(test::graph::Constant(g, out_size))
+                 .Finalize(g, &ret);
+  assert(s.ok());
+  return g;
+}
+
+#define BM_ResizeImagesDev(DEVICE, ALGORITHM, B, H, W, OH, OW)               \
+  static void                                                                \
+      BM_ResizeImages_##ALGORITHM##_##DEVICE##_##B##_##H##_##W##_##OH##_##OW( \
+          int iters) {                                                       \
+    testing::ItemsProcessed(iters* B* OH* OW * 3);                           \
+    test::Benchmark(#DEVICE, BM_ResizeImages(#ALGORITHM, B, H, W, OH, OW))   \
+        .Run(iters);                                                         \
+  }                                                                          \
+  BENCHMARK(                                                                 \
+      BM_ResizeImages_##ALGORITHM##_##DEVICE##_##B##_##H##_##W##_##OH##_##OW)
+
+BM_ResizeImagesDev(cpu, ResizeBilinear, 1, 375, 500, 224, 224);
+BM_ResizeImagesDev(cpu, ResizeBilinear, 32, 375, 500, 224, 224);
+BM_ResizeImagesDev(cpu, ResizeBilinear, 1, 375, 500, 299, 299);
+BM_ResizeImagesDev(cpu, ResizeBilinear, 32, 375, 500, 299, 299);
+
 }  // namespace tensorflow
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/dense_update_ops.h"
 #include "tensorflow/core/kernels/gather_functor.h"
 #include "tensorflow/core/kernels/scatter_functor.h"
+#include "tensorflow/core/kernels/training_op_helpers.h"
 #include "tensorflow/core/kernels/variable_ops.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/platform/mem.h"
@@ -41,19 +42,24 @@ class ReadVariableOp : public OpKernel {
 
   void Compute(OpKernelContext* ctx) override {
     Var* variable = nullptr;
-    ResourceHandle handle = HandleFromInput(ctx, 0);
+    const ResourceHandle& handle = ctx->input(0).flat<ResourceHandle>()(0);
     OP_REQUIRES(
-        ctx, LookupResource(ctx, handle, &variable).ok(),
+        ctx, cache_.Lookup(ctx, handle, &variable).ok(),
         errors::NotFound("Attempted to read a nonexistent variable. "
                          "This usually means that the variable was not "
                          "initialized. Container: ",
                          handle.container(), ", name: ", handle.name()));
 
     core::ScopedUnref s(variable);
-    // TODO(apassos): It's possible to do copy-on-write here instead of always
-    // copying by coordinating with the writing code. Do this. This will also
-    // obviate the need to hold a lock here.
+    // The output shares the variable's buffer. The updates that write the
+    // buffer in place copy it first while it is shared (see
+    // PrepareToUpdateVariable()), so the value read doesn't change, unless
+    // the variable is also updated without locking.
     mutex_lock ml(*variable->mu());
+    if (!variable->copy_on_read_mode()) {
+      ctx->set_output(0, *variable->tensor());
+      return;
+    }
     Tensor* out = nullptr;
     OP_REQUIRES_OK(ctx,
                    ctx->allocate_output(0, variable->tensor()->shape(), &out));
@@ -61,6 +67,9 @@ class ReadVariableOp : public OpKernel {
     const Tensor& t = *variable->tensor();
     copy_functor(ctx->eigen_device<Device>(), out->flat<T>(), t.flat<T>());
   }
+
+ private:
+  ResourceLookupCache<Var> cache_;
 };
 
 // TODO(apassos) register for the GPU as well.
@@ -104,11 +113,13 @@ class UnsafeReadVariableOp : public OpKernel {
 
   void Compute(OpKernelContext* ctx) override {
     Var* variable = nullptr;
-    OP_REQUIRES_OK(ctx,
-                   LookupResource(ctx, HandleFromInput(ctx, 0), &variable));
+    OP_REQUIRES_OK(ctx, cache_.Lookup(ctx, 0, &variable));
     core::ScopedUnref s(variable);
     ctx->set_output(0, *variable->tensor());
   }
+
+ private:
+  ResourceLookupCache<Var> cache_;
 };
 
 REGISTER_KERNEL_BUILDER(Name("_UnsafeReadVariable").Device(DEVICE_CPU),
@@ -185,7 +196,10 @@ class AssignVariableOp : public OpKernel {
     const Tensor& value = context->input(1);
     // TODO(apassos): should check that the declared shapes are compatible
     // somewhere, probably.
-    if (!variable->tensor()->shape().IsSameSize(value.shape())) {
+    // A buffer that reads still share is replaced rather than overwritten.
+    if (!variable->tensor()->shape().IsSameSize(value.shape()) ||
+        (!variable->tensor()->RefCountIsOne() &&
+         !variable->copy_on_read_mode())) {
       PersistentTensor unused;
       Tensor* tmp;
       AllocatorAttributes attr;
@@ -198,6 +212,7 @@ class AssignVariableOp : public OpKernel {
     functor::DenseUpdate<Device, T, ASSIGN> copy_functor;
     copy_functor(context->eigen_device<Device>(), variable->tensor()->flat<T>(),
                  value.flat<T>());
+    variable->MarkAllRowsDirty();
   }
 
  private:
@@ -241,21 +256,21 @@ class AssignUpdateVariableOp : public OpKernel {
 
   void Compute(OpKernelContext* context) override {
     Var* variable = nullptr;
-    OP_REQUIRES_OK(context, LookupResource(context, HandleFromInput(context, 0),
-                                           &variable));
+    OP_REQUIRES_OK(context, cache_.Lookup(context, 0, &variable));
     core::ScopedUnref s(variable);
 
-    // TODO(apassos): holding a lock and copying is unnecessary if we are the
-    // last user of the value tensor. This should essentially always be the
-    // case, yet the refcount is usually 2 instead of 1. Figure out what needs
-    // to change in the code to make this not be the case, so we can safely take
-    // ownership.
     mutex_lock ml(*variable->mu());
+    OP_REQUIRES_OK(context,
+                   PrepareToUpdateVariable<Device, T>(context, variable));
     const Tensor& value = context->input(1);
     functor::DenseUpdate<Device, T, Op> update_functor;
     update_functor(context->eigen_device<Device>(),
                    variable->tensor()->flat<T>(), value.flat<T>());
+    variable->MarkAllRowsDirty();
   }
+
+ private:
+  ResourceLookupCache<Var> cache_;
 };
 
 #define REGISTER_KERNELS(type)                                     \
@@ -315,6 +330,41 @@ REGISTER_KERNEL_BUILDER(Name("VarIsInitializedOp")
                         IsResourceInitialized<Var>);
 #endif  // GOOGLE_CUDA
 
+class ResourceTakeDirtyRowsOp : public OpKernel {
+ public:
+  explicit ResourceTakeDirtyRowsOp(OpKernelConstruction* c) : OpKernel(c) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    Var* variable = nullptr;
+    OP_REQUIRES_OK(ctx,
+                   LookupResource(ctx, HandleFromInput(ctx, 0), &variable));
+    core::ScopedUnref s(variable);
+    int64 num_rows;
+    {
+      mutex_lock ml(*variable->mu());
+      OP_REQUIRES(ctx, variable->tensor()->dims() > 0,
+                  errors::InvalidArgument("Variable must be at least 1-D"));
+      num_rows = variable->tensor()->dim_size(0);
+    }
+    const std::vector<int64> rows = variable->TakeDirtyRows(num_rows);
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(
+                            0, TensorShape({static_cast<int64>(rows.size())}),
+                            &out));
+    std::copy(rows.begin(), rows.end(), out->vec<int64>().data());
+  }
+};
+REGISTER_KERNEL_BUILDER(Name("ResourceTakeDirtyRows").Device(DEVICE_CPU),
+                        ResourceTakeDirtyRowsOp);
+
+#if GOOGLE_CUDA
+REGISTER_KERNEL_BUILDER(Name("ResourceTakeDirtyRows")
+                            .Device(DEVICE_GPU)
+                            .HostMemory("resource")
+                            .HostMemory("rows"),
+                        ResourceTakeDirtyRowsOp);
+#endif  // GOOGLE_CUDA
+
 template <typename Device, typename T, typename Index>
 class ResourceGatherOp : public OpKernel {
  public:
@@ -322,7 +372,7 @@ class ResourceGatherOp : public OpKernel {
 
   void Compute(OpKernelContext* c) override {
     Var* v = nullptr;
-    OP_REQUIRES_OK(c, LookupResource(c, HandleFromInput(c, 0), &v));
+    OP_REQUIRES_OK(c, cache_.Lookup(c, 0, &v));
     mutex_lock ml(*v->mu());
     const Tensor& params = *v->tensor();
     const Tensor& indices = c->input(1);
@@ -363,6 +413,9 @@ class ResourceGatherOp : public OpKernel {
               indices_flat(bad_i), " is not in [0, ", params.dim_size(0), ")"));
     }
   }
+
+ private:
+  ResourceLookupCache<Var> cache_;
 };
 
 #define REGISTER_GATHER_FULL(dev, type, index_type)                    \
@@ -394,8 +447,9 @@ class ResourceScatterUpdateOp : public OpKernel {
 
   void Compute(OpKernelContext* c) override {
     Var* v = nullptr;
-    OP_REQUIRES_OK(c, LookupResource(c, HandleFromInput(c, 0), &v));
+    OP_REQUIRES_OK(c, cache_.Lookup(c, 0, &v));
     mutex_lock ml(*v->mu());
+    OP_REQUIRES_OK(c, PrepareToUpdateVariable<Device, T>(c, v));
     Tensor* params = v->tensor();
     const Tensor& indices = c->input(1);
     const Tensor& updates = c->input(2);
@@ -428,8 +482,17 @@ class ResourceScatterUpdateOp : public OpKernel {
                       "indices", SliceDebugString(indices.shape(), bad_i),
                       " = ", indices_flat(bad_i), " is not in [0, ",
                       params->dim_size(0), ")"));
+      // The indices of GPU kernels are in device memory.
+      if (std::is_same<Device, Eigen::ThreadPoolDevice>::value) {
+        v->MarkDirtyRows<Index>(indices);
+      } else {
+        v->MarkAllRowsDirty();
+      }
     }
   }
+
+ private:
+  ResourceLookupCache<Var> cache_;
 };
 
 #define REGISTER_SCATTER_KERNEL_INDEX(type, index_type, dev, name, op) \
@@ -242,22 +242,35 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
   BundleReader reader(Env::Default(), prefix_string);
   TF_RETURN_IF_ERROR(reader.status());
 
-  // TODO(zongheng): potential optimization: one Seek() in first lookup.
-  // TODO(zongheng): consider measuring speed and issuing concurrent lookups
-  // within a fixed memory budget.
+  // The restored tensors are typically copied to GPUs next, which can DMA them
+  // straight from pinned memory.
+  AllocatorAttributes alloc_attr;
+  alloc_attr.set_gpu_compatible(true);
+
+  // Reads the slices one by one, and the full tensors all together at the end.
+  std::vector<string> full_tensor_names;
+  std::vector<Tensor*> full_tensors;
+  DataType restored_dtype;
   TensorShape restored_full_shape;
   Tensor* restored_tensor = nullptr;
   for (size_t i = 0; i < tensor_names_flat.size(); ++i) {
     const string& tensor_name = tensor_names_flat(i);
     const string& shape_and_slice = shape_and_slices_flat(i);
-    TF_RETURN_IF_ERROR(
-        reader.LookupTensorShape(tensor_name, &restored_full_shape));
+    TF_RETURN_IF_ERROR(reader.LookupDtypeAndShape(tensor_name, &restored_dtype,
+                                                  &restored_full_shape));
+    if (dtypes[i] != restored_dtype) {
+      return errors::InvalidArgument(
+          "tensor_name = ", tensor_name, "; expected dtype ",
+          DataTypeString(dtypes[i]), " does not equal restored dtype ",
+          DataTypeString(restored_dtype));
+    }
 
     if (shape_and_slice.empty()) {
       // Lookup the full tensor.
-      TF_RETURN_IF_ERROR(
-          context->allocate_output(i, restored_full_shape, &restored_tensor));
-      TF_RETURN_IF_ERROR(reader.Lookup(tensor_name, restored_tensor));
+      TF_RETURN_IF_ERROR(context->allocate_output(
+          i, restored_full_shape, &restored_tensor, alloc_attr));
+      full_tensor_names.push_back(tensor_name);
+      full_tensors.push_back(restored_tensor);
     } else {
       // Lookup the slice.
       TensorShape parsed_full_shape;
@@ -275,18 +288,16 @@ Status RestoreTensorsV2(OpKernelContext* context, const Tensor& prefix,
             restored_full_shape.DebugString());
       }
 
-      TF_RETURN_IF_ERROR(
-          context->allocate_output(i, parsed_slice_shape, &restored_tensor));
+      TF_RETURN_IF_ERROR(context->allocate_output(
+          i, parsed_slice_shape, &restored_tensor, alloc_attr));
       TF_RETURN_IF_ERROR(
           reader.LookupSlice(tensor_name, parsed_slice, restored_tensor));
     }
-    if (dtypes[i] != restored_tensor->dtype()) {
-      return errors::InvalidArgument(
-          "tensor_name = ", tensor_name, "; expected dtype ",
-          DataTypeString(dtypes[i]), " does not equal restored dtype ",
-          DataTypeString(restored_tensor->dtype()));
-    }
   }
+  // Reads the data files in parallel, coalescing the reads of small tensors.
+  TF_RETURN_IF_ERROR(reader.LookupMany(
+      full_tensor_names, full_tensors,
+      context->device()->tensorflow_cpu_worker_threads()->workers));
   return Status::OK();
 }
 
@@ -15,19 +15,26 @@ limitations under the License.
 
 // See docs in ../ops/io_ops.cc.
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/resource_mgr.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/kernels/save_restore_tensor.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/tensor_bundle/tensor_bundle.h"
@@ -85,12 +92,57 @@ void ValidateInputs(bool is_save_op, OpKernelContext* context,
   }
 }
 
+// Writes "tensors" to the V2 checkpoint "prefix", as specified by the
+// "tensor_names" and "shape_and_slices" inputs of a SaveV2 op.
+Status WriteTensors(const string& prefix, const Tensor& tensor_names,
+                    const Tensor& shape_and_slices,
+                    const std::vector<Tensor>& tensors, int num_shards) {
+  const auto& tensor_names_flat = tensor_names.flat<string>();
+  const auto& shape_and_slices_flat = shape_and_slices.flat<string>();
+
+  // Aligns the tensor data so that the bundle can be memory mapped on load.
+  BundleWriter::Options writer_options;
+  writer_options.data_alignment = Allocator::kAllocatorAlignment;
+  writer_options.num_shards = num_shards;
+  BundleWriter writer(Env::Default(), prefix, writer_options);
+  TF_RETURN_IF_ERROR(writer.status());
+  VLOG(1) << "BundleWriter, prefix_string: " << prefix;
+
+  for (int i = 0; i < tensors.size(); ++i) {
+    const string& tensor_name = tensor_names_flat(i);
+    const Tensor& tensor = tensors[i];
+
+    if (!shape_and_slices_flat(i).empty()) {
+      const string& shape_spec = shape_and_slices_flat(i);
+      TensorShape shape;
+      TensorSlice slice(tensor.dims());
+      TensorShape slice_shape;
+
+      TF_RETURN_IF_ERROR(checkpoint::ParseShapeAndSlice(shape_spec, &shape,
+                                                        &slice, &slice_shape));
+      if (!slice_shape.IsSameSize(tensor.shape())) {
+        return errors::InvalidArgument(
+            "Slice in shape_and_slice specification does not match the shape "
+            "of the tensor to  save: ",
+            shape_spec, ", tensor: ", tensor.shape().DebugString());
+      }
+
+      TF_RETURN_IF_ERROR(writer.AddSlice(tensor_name, shape, slice, tensor));
+    } else {
+      TF_RETURN_IF_ERROR(writer.Add(tensor_name, tensor));
+    }
+  }
+  return writer.Finish();
+}
+
 }  // namespace
 
 // Saves a list of named tensors using the tensor bundle library.
 class SaveV2 : public OpKernel {
  public:
-  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {}
+  explicit SaveV2(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_shards", &num_shards_));
+  }
 
   void Compute(OpKernelContext* context) override {
     const Tensor& prefix = context->input(0);
@@ -98,47 +150,169 @@ class SaveV2 : public OpKernel {
     const Tensor& shape_and_slices = context->input(2);
     ValidateInputs(true /* is save op */, context, prefix, tensor_names,
                    shape_and_slices);
+    if (!context->status().ok()) return;
 
     const int kFixedInputs = 3;  // Prefix, tensor names, shape_and_slices.
-    const int num_tensors = static_cast<int>(tensor_names.NumElements());
-    const string& prefix_string = prefix.scalar<string>()();
-    const auto& tensor_names_flat = tensor_names.flat<string>();
-    const auto& shape_and_slices_flat = shape_and_slices.flat<string>();
-
-    BundleWriter writer(Env::Default(), prefix_string);
-    OP_REQUIRES_OK(context, writer.status());
-    VLOG(1) << "BundleWriter, prefix_string: " << prefix_string;
-
-    for (int i = 0; i < num_tensors; ++i) {
-      const string& tensor_name = tensor_names_flat(i);
-      const Tensor& tensor = context->input(i + kFixedInputs);
-
-      if (!shape_and_slices_flat(i).empty()) {
-        const string& shape_spec = shape_and_slices_flat(i);
-        TensorShape shape;
-        TensorSlice slice(tensor.dims());
-        TensorShape slice_shape;
-
-        OP_REQUIRES_OK(context, checkpoint::ParseShapeAndSlice(
-                                    shape_spec, &shape, &slice, &slice_shape));
-        OP_REQUIRES(context, slice_shape.IsSameSize(tensor.shape()),
-                    errors::InvalidArgument("Slice in shape_and_slice "
-                                            "specification does not match the "
-                                            "shape of the tensor to  save: ",
-                                            shape_spec, ", tensor: ",
-                                            tensor.shape().DebugString()));
-
-        OP_REQUIRES_OK(context,
-                       writer.AddSlice(tensor_name, shape, slice, tensor));
-      } else {
-        OP_REQUIRES_OK(context, writer.Add(tensor_name, tensor));
-      }
+    std::vector<Tensor> tensors;
+    for (int i = kFixedInputs; i < context->num_inputs(); ++i) {
+      tensors.push_back(context->input(i));
     }
-    OP_REQUIRES_OK(context, writer.Finish());
+    OP_REQUIRES_OK(context,
+                   WriteTensors(prefix.scalar<string>()(), tensor_names,
+                                shape_and_slices, tensors, num_shards_));
   }
+
+ private:
+  // The number of data files of the bundle.
+  int num_shards_;
 };
 REGISTER_KERNEL_BUILDER(Name("SaveV2").Device(DEVICE_CPU), SaveV2);
 
+namespace {
+
+// Writes the checkpoints of the AsyncSaveV2 ops of a device, one at a time, on
+// a background thread.
+class AsyncSaveWriter : public ResourceBase {
+ public:
+  AsyncSaveWriter()
+      : thread_(new thread::ThreadPool(Env::Default(), "async_save", 1)) {}
+
+  // Waits for the pending save, if any, and returns the error of any save
+  // that failed since the last call to Wait().
+  Status Wait() {
+    mutex_lock l(mu_);
+    while (num_pending_ > 0) {
+      done_cv_.wait(l);
+    }
+    return TakeStatus();
+  }
+
+  // Returns the number of pending saves and the error of any save that failed
+  // since the last call to Wait() or Poll().
+  Status Poll(int64* num_pending) {
+    mutex_lock l(mu_);
+    *num_pending = num_pending_;
+    return TakeStatus();
+  }
+
+  // Runs "save" on the background thread.
+  void Schedule(std::function<Status()> save) {
+    {
+      mutex_lock l(mu_);
+      ++num_pending_;
+    }
+    thread_->Schedule([this, save]() {
+      const Status s = save();
+      mutex_lock l(mu_);
+      status_.Update(s);
+      --num_pending_;
+      done_cv_.notify_all();
+    });
+  }
+
+  string DebugString() override { return "AsyncSaveWriter"; }
+
+ private:
+  Status TakeStatus() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    Status s = status_;
+    status_ = Status::OK();
+    return s;
+  }
+
+  mutex mu_;
+  condition_variable done_cv_;
+  int64 num_pending_ GUARDED_BY(mu_) = 0;
+  Status status_ GUARDED_BY(mu_);
+  // Destroyed first, which waits for the pending save.
+  std::unique_ptr<thread::ThreadPool> thread_;
+};
+
+// The AsyncSaveWriter shared by the ops of the device of "context".
+Status GetAsyncSaveWriter(OpKernelContext* context, AsyncSaveWriter** writer) {
+  ResourceMgr* rm = context->resource_manager();
+  return rm->LookupOrCreate<AsyncSaveWriter>(
+      rm->default_container(), "_async_save_writer", writer,
+      [](AsyncSaveWriter** ret) {
+        *ret = new AsyncSaveWriter;
+        return Status::OK();
+      });
+}
+
+}  // namespace
+
+// Like SaveV2, but only copies the tensors, and writes them in the background.
+class AsyncSaveV2 : public OpKernel {
+ public:
+  explicit AsyncSaveV2(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("num_shards", &num_shards_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& prefix = context->input(0);
+    const Tensor& tensor_names = context->input(1);
+    const Tensor& shape_and_slices = context->input(2);
+    ValidateInputs(true /* is save op */, context, prefix, tensor_names,
+                   shape_and_slices);
+    if (!context->status().ok()) return;
+
+    AsyncSaveWriter* writer;
+    OP_REQUIRES_OK(context, GetAsyncSaveWriter(context, &writer));
+    core::ScopedUnref unref(writer);
+    // At most one save is pending, so that at most two snapshots are held.
+    OP_REQUIRES_OK(context, writer->Wait());
+
+    // The variables may be updated as soon as the op returns.  The names and
+    // slices are not, so they are shared.
+    const int kFixedInputs = 3;  // Prefix, tensor names, shape_and_slices.
+    std::vector<Tensor> snapshot;
+    for (int i = kFixedInputs; i < context->num_inputs(); ++i) {
+      snapshot.push_back(tensor::DeepCopy(context->input(i)));
+    }
+    const string prefix_string = prefix.scalar<string>()();
+    const int num_shards = num_shards_;
+    writer->Schedule([prefix_string, tensor_names, shape_and_slices, snapshot,
+                      num_shards]() {
+      return WriteTensors(prefix_string, tensor_names, shape_and_slices,
+                          snapshot, num_shards);
+    });
+  }
+
+ private:
+  // The number of data files of the bundle.
+  int num_shards_;
+};
+REGISTER_KERNEL_BUILDER(Name("AsyncSaveV2").Device(DEVICE_CPU), AsyncSaveV2);
+
+// Waits for, or checks on, the checkpoints of the AsyncSaveV2 ops.
+class WaitForAsyncSaves : public OpKernel {
+ public:
+  explicit WaitForAsyncSaves(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("block", &block_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    AsyncSaveWriter* writer;
+    OP_REQUIRES_OK(context, GetAsyncSaveWriter(context, &writer));
+    core::ScopedUnref unref(writer);
+    int64 num_pending = 0;
+    if (block_) {
+      OP_REQUIRES_OK(context, writer->Wait());
+    } else {
+      OP_REQUIRES_OK(context, writer->Poll(&num_pending));
+    }
+    Tensor* output;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, TensorShape({}), &output));
+    output->scalar<int64>()() = num_pending;
+  }
+
+ private:
+  bool block_;
+};
+REGISTER_KERNEL_BUILDER(Name("WaitForAsyncSaves").Device(DEVICE_CPU),
+                        WaitForAsyncSaves);
+
 // Restores a list of named tensors from a tensor bundle (V2 checkpoint format).
 class RestoreV2 : public OpKernel {
  public:
@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/core/framework/node_def_builder.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/kernels/ops_testutil.h"
@@ -339,5 +340,71 @@ TEST_F(SaveV2OpTest, Simple) {
   }
 }
 
+class AsyncSaveV2OpTest : public OpsTestBase {
+ protected:
+  // Saves "tensor_a" and "tensor_b" to "prefix" in the background.
+  void RunSave(const string& prefix, const Tensor& a, const Tensor& b) {
+    TF_ASSERT_OK(NodeDefBuilder("save", "AsyncSaveV2")
+                     .Input(FakeInput())  // prefix
+                     .Input(FakeInput())  // tensor_names
+                     .Input(FakeInput())  // shape_and_slices
+                     .Input(FakeInput({DT_FLOAT, DT_INT64}))  // tensors
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    inputs_.clear();
+    AddInputFromArray<string>(TensorShape({}), {prefix});
+    AddInputFromArray<string>(TensorShape({2}), {"tensor_a", "tensor_b"});
+    AddInputFromArray<string>(TensorShape({2}), {"", ""});
+    AddInputFromArray<float>(a.shape(), a.flat<float>());
+    AddInputFromArray<int64>(b.shape(), b.flat<int64>());
+    TF_ASSERT_OK(RunOpKernel());
+  }
+
+  Status RunWait(bool block, int64* num_pending) {
+    TF_CHECK_OK(NodeDefBuilder("wait", "WaitForAsyncSaves")
+                    .Attr("block", block)
+                    .Finalize(node_def()));
+    TF_CHECK_OK(InitOp());
+    inputs_.clear();
+    TF_RETURN_IF_ERROR(RunOpKernel());
+    *num_pending = GetOutput(0)->scalar<int64>()();
+    return Status::OK();
+  }
+};
+
+TEST_F(AsyncSaveV2OpTest, Simple) {
+  const string prefix = io::JoinPath(testing::TmpDir(), "async_simple");
+  RunSave(prefix, test::AsTensor<float>({1, 2, 3}),
+          test::AsTensor<int64>({4, 5}));
+  // The op only took a snapshot of its inputs.
+  mutable_input(3).tensor->flat<float>().setZero();
+
+  int64 num_pending;
+  TF_ASSERT_OK(RunWait(false, &num_pending));
+  EXPECT_LE(num_pending, 1);
+  TF_ASSERT_OK(RunWait(true, &num_pending));
+  EXPECT_EQ(0, num_pending);
+
+  BundleReader reader(Env::Default(), prefix);
+  TF_ASSERT_OK(reader.status());
+  Tensor val;
+  TF_ASSERT_OK(reader.Lookup("tensor_a", &val));
+  test::ExpectTensorEqual<float>(test::AsTensor<float>({1, 2, 3}), val);
+  TF_ASSERT_OK(reader.Lookup("tensor_b", &val));
+  test::ExpectTensorEqual<int64>(test::AsTensor<int64>({4, 5}), val);
+}
+
+TEST_F(AsyncSaveV2OpTest, ReportsErrorsOnce) {
+  // The directory of the prefix can't be created under a file.
+  const string file = io::JoinPath(testing::TmpDir(), "async_not_a_dir");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), file, "x"));
+  RunSave(io::JoinPath(file, "ckpt"), test::AsTensor<float>({1}),
+          test::AsTensor<int64>({2}));
+
+  int64 num_pending;
+  EXPECT_FALSE(RunWait(true, &num_pending).ok());
+  TF_EXPECT_OK(RunWait(true, &num_pending));
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -60,3 +60,26 @@ TF_CALL_GPU_NUMBER_TYPES_NO_HALF(DECLARE_GPU_SPECS);
 #include "tensorflow/core/kernels/scatter_functor.h"
 
 #endif  // GOOGLE_CUDA
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+namespace scatter_op {
+namespace internal {
+
+int NumScatterThreads(OpKernelContext* c) {
+  return c->device()->tensorflow_cpu_worker_threads()->num_threads;
+}
+
+void ParallelForScatter(OpKernelContext* c, int64 total, int64 cost_per_unit,
+                        const std::function<void(int64, int64)>& work) {
+  const DeviceBase::CpuWorkerThreads& worker_threads =
+      *c->device()->tensorflow_cpu_worker_threads();
+  Shard(worker_threads.num_threads, worker_threads.workers, total,
+        cost_per_unit, work);
+}
+
+}  // namespace internal
+}  // namespace scatter_op
+}  // namespace tensorflow
@@ -16,7 +16,10 @@ limitations under the License.
 #ifndef TENSORFLOW_KERNELS_SCATTER_FUNCTOR_H_
 #define TENSORFLOW_KERNELS_SCATTER_FUNCTOR_H_
 
+#include <algorithm>
+#include <functional>
 #include <type_traits>
+#include <vector>
 
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/kernels/bounds_check.h"
@@ -119,6 +122,79 @@ struct AssignSYCL<scatter_op::UpdateOp::DIV> {
 };
 #endif // TENSORFLOW_USE_SYCL
 
+// Scatters with fewer updated elements than this are applied on the calling
+// thread.
+constexpr int64 kMinParallelScatterElements = 1 << 16;
+
+// The number of threads that a scatter on the CPU may be split across.
+int NumScatterThreads(OpKernelContext* c);
+
+// Runs work(start, limit) for ranges covering [0, total) on the CPU worker
+// threads of c. cost_per_unit is the rough cost of each unit.
+void ParallelForScatter(OpKernelContext* c, int64 total, int64 cost_per_unit,
+                        const std::function<void(int64, int64)>& work);
+
+// Calls apply(i, indices(i)) for each i in [0, N), unless some index is not
+// in [0, limit), in which case it returns the position of the first such
+// index. Returns -1 otherwise.
+//
+// Large scatters are applied in parallel. The indices are first bucketed by
+// ranges of consecutive rows, and each bucket is then applied by a single
+// thread in the order of the indices. Updates to the same row therefore
+// happen in the same order as they would serially, and never race.
+template <typename Index, typename Apply>
+Index ScatterCPU(OpKernelContext* c, typename TTypes<Index>::ConstFlat indices,
+                 Index limit, int64 slice_size, Apply apply) {
+  const Index N = static_cast<Index>(indices.size());
+  const int64 num_buckets = std::min<int64>(NumScatterThreads(c), limit);
+  if (num_buckets <= 1 ||
+      static_cast<int64>(N) * slice_size < kMinParallelScatterElements) {
+    for (Index i = 0; i < N; i++) {
+      // Grab the index and check its validity.  An earlier version of the
+      // code checked it and then grabbed it from memory a second time, which
+      // was a security risk since it could have changed in between.
+      const Index index = ::tensorflow::internal::SubtleMustCopy(indices(i));
+      if (!FastBoundsCheck(index, limit)) return i;
+      apply(i, index);
+    }
+    return -1;
+  }
+
+  // First pass: copy and check the indices, and count those in each bucket.
+  // All the indices are checked before any update is applied.
+  const int64 rows_per_bucket = (limit + num_buckets - 1) / num_buckets;
+  std::vector<Index> safe_indices(N);
+  std::vector<int64> bucket_starts(num_buckets + 1, 0);
+  for (Index i = 0; i < N; i++) {
+    const Index index = ::tensorflow::internal::SubtleMustCopy(indices(i));
+    if (!FastBoundsCheck(index, limit)) return i;
+    safe_indices[i] = index;
+    ++bucket_starts[index / rows_per_bucket + 1];
+  }
+  for (int64 b = 0; b < num_buckets; ++b) {
+    bucket_starts[b + 1] += bucket_starts[b];
+  }
+  // Stable, so that each bucket keeps the order of its indices.
+  std::vector<Index> order(N);
+  std::vector<int64> next(bucket_starts.begin(), bucket_starts.end() - 1);
+  for (Index i = 0; i < N; i++) {
+    order[next[safe_indices[i] / rows_per_bucket]++] = i;
+  }
+
+  // Second pass: apply the buckets in parallel.
+  ParallelForScatter(
+      c, num_buckets, static_cast<int64>(N) * slice_size / num_buckets,
+      [&apply, &safe_indices, &bucket_starts, &order](int64 first_bucket,
+                                                      int64 end_bucket) {
+        for (int64 k = bucket_starts[first_bucket];
+             k < bucket_starts[end_bucket]; ++k) {
+          const Index i = order[k];
+          apply(i, safe_indices[i]);
+        }
+      });
+  return -1;
+}
+
 }  // namespace internal
 }  // namespace scatter_op
 
@@ -179,6 +255,24 @@ struct ScatterFunctorBase <SYCLDevice, T, Index, op> {
 };
 #endif // TENSORFLOW_USE_SYCL
 
+template <typename T, typename Index, scatter_op::UpdateOp op>
+struct ScatterFunctorBase<CPUDevice, T, Index, op> {
+  Index operator()(OpKernelContext* c, const CPUDevice& d,
+                   typename TTypes<T>::Matrix params,
+                   typename TTypes<T>::ConstMatrix updates,
+                   typename TTypes<Index>::ConstFlat indices) {
+    // indices and params sizes were validated in DoCompute().
+    const Index limit = static_cast<Index>(params.dimension(0));
+    return scatter_op::internal::ScatterCPU<Index>(
+        c, indices, limit, updates.dimension(1),
+        [&params, &updates](Index i, Index index) {
+          // Copy last Ndim-1 dimensions of updates[i] to params[index]
+          scatter_op::internal::Assign<op>::Run(params.template chip<0>(index),
+                                                updates.template chip<0>(i));
+        });
+  }
+};
+
 template <typename T, typename Index>
 struct ScatterFunctorBase<CPUDevice, T, Index, scatter_op::UpdateOp::ASSIGN> {
   Index operator()(OpKernelContext* c, const CPUDevice& d,
@@ -186,32 +280,24 @@ struct ScatterFunctorBase<CPUDevice, T, Index, scatter_op::UpdateOp::ASSIGN> {
                    typename TTypes<T>::ConstMatrix updates,
                    typename TTypes<Index>::ConstFlat indices) {
     // indices and params sizes were validated in DoCompute().
-    const Index N = static_cast<Index>(indices.size());
     const Index limit = static_cast<Index>(params.dimension(0));
     if (!std::is_same<T, string>::value) {
-      for (Index i = 0; i < N; i++) {
-        // Grab the index and check its validity.  An earlier version of the
-        // code checked it and then grabbed it from memory a second time, which
-        // was a security risk since it could have changed in between.
-        const Index index = ::tensorflow::internal::SubtleMustCopy(indices(i));
-        if (!FastBoundsCheck(index, limit)) return i;
-        memmove(params.data() + index * params.dimension(1),
-                updates.data() + i * updates.dimension(1),
-                updates.dimension(1) * sizeof(T));
-      }
+      return scatter_op::internal::ScatterCPU<Index>(
+          c, indices, limit, updates.dimension(1),
+          [&params, &updates](Index i, Index index) {
+            memmove(params.data() + index * params.dimension(1),
+                    updates.data() + i * updates.dimension(1),
+                    updates.dimension(1) * sizeof(T));
+          });
     } else {
-      for (Index i = 0; i < N; i++) {
-        // Grab the index and check its validity.  An earlier version of the
-        // code checked it and then grabbed it from memory a second time, which
-        // was a security risk since it could have changed in between.
-        const Index index = ::tensorflow::internal::SubtleMustCopy(indices(i));
-        if (!FastBoundsCheck(index, limit)) return i;
-        // Copy last Ndim-1 dimensions of updates[i] to params[index]
-        scatter_op::internal::Assign<scatter_op::UpdateOp::ASSIGN>::Run(
-            params.template chip<0>(index), updates.template chip<0>(i));
-      }
+      return scatter_op::internal::ScatterCPU<Index>(
+          c, indices, limit, updates.dimension(1),
+          [&params, &updates](Index i, Index index) {
+            // Copy last Ndim-1 dimensions of updates[i] to params[index]
+            scatter_op::internal::Assign<scatter_op::UpdateOp::ASSIGN>::Run(
+                params.template chip<0>(index), updates.template chip<0>(i));
+          });
     }
-    return -1;
   }
 };
 
@@ -159,6 +159,38 @@ TEST_F(ScatterUpdateOpTest, HigherRank) {
   test::ExpectTensorEqual<float>(expected, params_tensor);
 }
 
+TEST_F(ScatterUpdateOpTest, LargeWithDuplicates) {
+  MakeOp(DT_FLOAT_REF, DT_INT32);
+
+  // Large enough to be applied in parallel. Later updates of a row win.
+  const int kRows = 64;
+  const int kCols = 1024;
+  const int kIndices = 256;
+  std::vector<int32> indices(kIndices);
+  std::vector<float> updates(kIndices * kCols);
+  std::vector<float> expected_values(kRows * kCols, 0);
+  for (int i = 0; i < kIndices; ++i) {
+    indices[i] = (i * 37) % kRows;
+    for (int j = 0; j < kCols; ++j) {
+      updates[i * kCols + j] = i * kCols + j;
+      expected_values[indices[i] * kCols + j] = i * kCols + j;
+    }
+  }
+
+  // Feed and run
+  AddInputFromArray<float>(TensorShape({kRows, kCols}),
+                           std::vector<float>(kRows * kCols, 0));
+  AddInputFromArray<int32>(TensorShape({kIndices}), indices);
+  AddInputFromArray<float>(TensorShape({kIndices, kCols}), updates);
+  TF_ASSERT_OK(RunOpKernel());
+
+  // Check the new state of the input
+  Tensor params_tensor = *mutable_input(0).tensor;
+  Tensor expected(allocator(), DT_FLOAT, TensorShape({kRows, kCols}));
+  test::FillValues<float>(&expected, expected_values);
+  test::ExpectTensorEqual<float>(expected, params_tensor);
+}
+
 TEST_F(ScatterUpdateOpTest, Error_IndexOutOfRange) {
   MakeOp(DT_FLOAT_REF, DT_INT32);
 
@@ -18,6 +18,7 @@ limitations under the License.
 #define EIGEN_USE_THREADS
 
 #include "tensorflow/core/kernels/segment_reduction_ops.h"
+#include <algorithm>
 #include <vector>
 #include "third_party/eigen3/Eigen/Core"
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
@@ -30,7 +31,10 @@ limitations under the License.
 #include "tensorflow/core/kernels/bounds_check.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/util/util.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -229,8 +233,121 @@ REGISTER_COMPLEX_CPU_KERNELS_ALL(complex128);
 
 namespace functor {
 
+// Reductions of the UnsortedSegment CPU functors, which combine a row of data,
+// or a partial output row, into an output row.
+struct UnsortedSegmentSumReducerCPU {
+  template <typename Output, typename Input>
+  void operator()(Output out, const Input& in) const {
+    out += in;
+  }
+};
+
+struct UnsortedSegmentMaxReducerCPU {
+  template <typename Output, typename Input>
+  void operator()(Output out, const Input& in) const {
+    out = in.cwiseMax(out);
+  }
+};
+
+// Reduces the rows of `data_flat` into the rows of `output` given by
+// `segment_ids`, starting from `initial_value`.
+//
+// Large reductions are split across the CPU worker threads.  When there are
+// few output rows compared to the rows of data, each thread reduces a range
+// of the rows of data into its own partial output, and the partial outputs
+// are then reduced into the output.  Otherwise, each thread reduces all the
+// rows of data that go to a range of the output rows, which only requires
+// every thread to read all the segment ids.
+template <typename T, typename Index, typename Reducer>
+void UnsortedSegmentReduceCPU(OpKernelContext* ctx, const Index output_rows,
+                              const TensorShape& segment_ids_shape,
+                              typename TTypes<Index>::ConstFlat segment_ids,
+                              typename TTypes<T, 2>::ConstTensor data_flat,
+                              const T initial_value, Reducer reducer,
+                              typename TTypes<T, 2>::Tensor output) {
+  const int64 N = segment_ids.dimension(0);
+  const int64 num_col = data_flat.dimension(1);
+  // Check all the segment ids first, so that the error does not depend on
+  // how the reduction is split.
+  for (int64 i = 0; i < N; ++i) {
+    Index j = internal::SubtleMustCopy(segment_ids(i));
+    OP_REQUIRES(ctx, FastBoundsCheck(j, output_rows),
+                errors::InvalidArgument(
+                    "segment_ids", SliceDebugString(segment_ids_shape, i),
+                    " = ", j, " is out of range [0, ", output_rows, ")"));
+  }
+
+  // Below this many elements of data, the reduction is not worth splitting.
+  static const int64 kMinParallelElements = 1 << 15;
+  auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+  const int64 num_blocks =
+      std::min<int64>(worker_threads->num_threads, N * num_col / 8192);
+  if (N * num_col < kMinParallelElements || num_blocks <= 1) {
+    output.setConstant(initial_value);
+    for (int64 i = 0; i < N; ++i) {
+      const Index j = internal::SubtleMustCopy(segment_ids(i));
+      if (!FastBoundsCheck(j, output_rows)) continue;
+      reducer(output.template chip<0>(j), data_flat.template chip<0>(i));
+    }
+    return;
+  }
+
+  // Each block of work is one unit of Shard, so that they are all run in
+  // parallel.
+  const int64 cost_per_block = N * num_col / num_blocks * sizeof(T);
+  if (output_rows * num_blocks <= N) {
+    Tensor partials;
+    OP_REQUIRES_OK(ctx, ctx->allocate_temp(
+                            DataTypeToEnum<T>::value,
+                            TensorShape({num_blocks * output_rows, num_col}),
+                            &partials));
+    auto partials_flat = partials.matrix<T>();
+    partials_flat.setConstant(initial_value);
+    auto reduce_data = [&](int64 begin_block, int64 end_block) {
+      for (int64 block = begin_block; block < end_block; ++block) {
+        const int64 offset = block * output_rows;
+        for (int64 i = N * block / num_blocks;
+             i < N * (block + 1) / num_blocks; ++i) {
+          const Index j = internal::SubtleMustCopy(segment_ids(i));
+          if (!FastBoundsCheck(j, output_rows)) continue;
+          reducer(partials_flat.template chip<0>(offset + j),
+                  data_flat.template chip<0>(i));
+        }
+      }
+    };
+    Shard(worker_threads->num_threads, worker_threads->workers, num_blocks,
+          cost_per_block, reduce_data);
+
+    auto reduce_partials = [&](int64 begin_row, int64 end_row) {
+      for (int64 j = begin_row; j < end_row; ++j) {
+        output.template chip<0>(j) = partials_flat.template chip<0>(j);
+        for (int64 block = 1; block < num_blocks; ++block) {
+          reducer(output.template chip<0>(j),
+                  partials_flat.template chip<0>(block * output_rows + j));
+        }
+      }
+    };
+    Shard(worker_threads->num_threads, worker_threads->workers, output_rows,
+          num_blocks * num_col * sizeof(T), reduce_partials);
+  } else {
+    auto reduce_rows = [&](int64 begin_block, int64 end_block) {
+      const int64 begin_row = output_rows * begin_block / num_blocks;
+      const int64 end_row = output_rows * end_block / num_blocks;
+      for (int64 j = begin_row; j < end_row; ++j) {
+        output.template chip<0>(j).setConstant(initial_value);
+      }
+      for (int64 i = 0; i < N; ++i) {
+        const Index j = internal::SubtleMustCopy(segment_ids(i));
+        if (j < begin_row || j >= end_row) continue;
+        reducer(output.template chip<0>(j), data_flat.template chip<0>(i));
+      }
+    };
+    Shard(worker_threads->num_threads, worker_threads->workers, num_blocks,
+          cost_per_block, reduce_rows);
+  }
+}
+
 // UnsortedSegmentSumFunctor implementation for CPUDevice.
-// todo: Remove duplicate code in UnsortedSegmentSumFunctor and UnsortedSegmentMaxFunctor.
 template <typename T, typename Index>
 struct UnsortedSegmentSumFunctor<CPUDevice, T, Index>
     : UnsortedSegmentBaseFunctor<CPUDevice, T, Index> {
@@ -239,20 +356,15 @@ struct UnsortedSegmentSumFunctor<CPUDevice, T, Index>
                   typename TTypes<Index>::ConstFlat segment_ids,
                   const Index data_size, const T* data,
                   typename TTypes<T, 2>::Tensor output) override {
-    output.setZero();
     if (data_size == 0) {
+      output.setZero();
       return;
     }
     const int64 N = segment_ids.dimension(0);
     auto data_flat = typename TTypes<T, 2>::ConstTensor(data, N, data_size / N);
-    for (int64 i = 0; i < N; ++i) {
-      Index j = internal::SubtleMustCopy(segment_ids(i));
-      OP_REQUIRES(ctx, FastBoundsCheck(j, output_rows),
-                  errors::InvalidArgument(
-                      "segment_ids", SliceDebugString(segment_ids_shape, i),
-                      " = ", j, " is out of range [0, ", output_rows, ")"));
-      output.template chip<0>(j) += data_flat.template chip<0>(i);
-    }
+    UnsortedSegmentReduceCPU<T, Index>(ctx, output_rows, segment_ids_shape,
+                                       segment_ids, data_flat, T(0),
+                                       UnsortedSegmentSumReducerCPU(), output);
   }
 };
 // UnsortedSegmentMaxFunctor implementation for CPUDevice.
@@ -264,21 +376,16 @@ struct UnsortedSegmentMaxFunctor<CPUDevice, T, Index>
                   typename TTypes<Index>::ConstFlat segment_ids,
                   const Index data_size, const T* data,
                   typename TTypes<T, 2>::Tensor output) override {
-    output.setConstant(std::numeric_limits<T>::lowest());
     if (data_size == 0) {
+      output.setConstant(std::numeric_limits<T>::lowest());
       return;
     }
     const int64 N = segment_ids.dimension(0);
     auto data_flat = typename TTypes<T, 2>::ConstTensor(data, N, data_size / N);
-    for (int64 i = 0; i < N; ++i) {
-      Index j = internal::SubtleMustCopy(segment_ids(i));
-      OP_REQUIRES(ctx, FastBoundsCheck(j, output_rows),
-                  errors::InvalidArgument(
-                      "segment_ids", SliceDebugString(segment_ids_shape, i),
-                      " = ", j, " is out of range [0, ", output_rows, ")"));
-      output.template chip<0>(j) =
-          data_flat.template chip<0>(i).cwiseMax(output.template chip<0>(j));
-    }
+    UnsortedSegmentReduceCPU<T, Index>(
+        ctx, output_rows, segment_ids_shape, segment_ids, data_flat,
+        std::numeric_limits<T>::lowest(), UnsortedSegmentMaxReducerCPU(),
+        output);
   }
 };
 }  // namespace functor
@@ -468,9 +575,13 @@ class SparseSegmentReductionOpBase : public OpKernel {
                 errors::InvalidArgument("segment ids must be >= 0"));
     auto output_flat = output->flat_outer_dims<T>();
 
+    // Find the segments, and check that segment_ids are increasing, before
+    // the segments are reduced in parallel. segment_starts[k] is the offset
+    // in indices of the k-th non empty segment, and segment_starts has a last
+    // entry for the end of indices.
+    std::vector<int64> segment_starts;
+    std::vector<OutputRow> segment_rows;
     int64 start = 0, end = 1;
-    // Index from which the output is not initialized.
-    OutputRow uninitialized_index = 0;
     OutputRow out_index = internal::SubtleMustCopy(segment_vec(start));
 
     while (true) {
@@ -495,31 +606,71 @@ class SparseSegmentReductionOpBase : public OpKernel {
               "Segment id ", out_index, " out of range [0, ", output_rows,
               "), possibly because 'segment_ids' input is not sorted."));
 
-      // If there is a gap between two indices, we need to set that gap to the
-      // default value.
-      if (out_index > uninitialized_index) {
-        Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
-            out_index - uninitialized_index, num_col);
-        Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>, Eigen::Unaligned>
-            gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
-        gap_slice.setConstant(default_value_);
-      }
-
-      auto out = output_flat.template chip<0>(out_index);
-      const int bad_offset =
-          Reduce(input_flat, indices_vec, start, end - start, out);
-      OP_REQUIRES(context, bad_offset < 0,
-                  errors::InvalidArgument(
-                      "Bad: indices[", start + bad_offset, "] == ",
-                      indices_vec(start + bad_offset), " out of range [0, ",
-                      input_flat.dimension(0), ")"));
-
+      segment_starts.push_back(start);
+      segment_rows.push_back(out_index);
       if (end >= num_indices) break;
       start = end;
       ++end;
-      uninitialized_index = out_index + 1;
       out_index = next_index;
     }
+    segment_starts.push_back(num_indices);
+
+    // Each segment is reduced directly from the rows of input into its output
+    // row, without gathering them first.  The offset in indices of the first
+    // bad index is reported, to give the same error as a sequential loop.
+    const int64 num_segments = segment_rows.size();
+    mutex mu;
+    int64 bad_index = num_indices;
+    auto reduce_segments = [&](int64 begin_segment, int64 end_segment) {
+      for (int64 k = begin_segment; k < end_segment; ++k) {
+        const int64 segment_start = segment_starts[k];
+        const int64 segment_end = segment_starts[k + 1];
+        // Prefetch the rows of the next segment, which are at arbitrary
+        // places in input, while the rows of this one are reduced.
+        if (k + 1 < end_segment) {
+          for (int64 i = segment_end; i < segment_starts[k + 2]; ++i) {
+            const Index index = internal::SubtleMustCopy(indices_vec(i));
+            if (FastBoundsCheck(index, input_flat.dimension(0))) {
+              port::prefetch<port::PREFETCH_HINT_T0>(&input_flat(index, 0));
+            }
+          }
+        }
+
+        // If there is a gap between two segments, we need to set that gap to
+        // the default value.
+        const OutputRow uninitialized_index =
+            k == 0 ? 0 : segment_rows[k - 1] + 1;
+        if (segment_rows[k] > uninitialized_index) {
+          Eigen::DSizes<Eigen::DenseIndex, 2> gap_slice_shape(
+              segment_rows[k] - uninitialized_index, num_col);
+          Eigen::TensorMap<Eigen::Tensor<T, 2, Eigen::RowMajor>,
+                           Eigen::Unaligned>
+              gap_slice(&output_flat(uninitialized_index, 0), gap_slice_shape);
+          gap_slice.setConstant(default_value_);
+        }
+
+        auto out = output_flat.template chip<0>(segment_rows[k]);
+        const int64 bad_offset =
+            Reduce(input_flat, indices_vec, segment_start,
+                   segment_end - segment_start, out);
+        if (bad_offset >= 0) {
+          mutex_lock l(mu);
+          bad_index = std::min(bad_index, segment_start + bad_offset);
+          return;
+        }
+      }
+    };
+    const int64 cost_per_segment =
+        (num_indices / num_segments + 1) * num_col * sizeof(T);
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads->num_threads, worker_threads->workers, num_segments,
+          cost_per_segment, reduce_segments);
+
+    OP_REQUIRES(context, bad_index == num_indices,
+                errors::InvalidArgument(
+                    "Bad: indices[", bad_index, "] == ",
+                    indices_vec(bad_index), " out of range [0, ",
+                    input_flat.dimension(0), ")"));
   }
 
  private:
@@ -166,4 +166,94 @@ static void BM_SparseSegmentMeanGrad_High(int iters, int size) {
 BENCHMARK(BM_SparseSegmentMeanGrad_Low)->Arg(1000)->Arg(100000);
 BENCHMARK(BM_SparseSegmentMeanGrad_High)->Arg(1000)->Arg(100000);
 
+// Looks up and combines the embeddings of a batch of sparse features, with
+// `ids_per_example` ids per example.
+static void SparseSegmentSumHelper(int iters, int ids_per_example, int dim) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+
+  const int kBatchSize = 512;
+  const int kVocabSize = 100000;
+  const int kNumIndices = kBatchSize * ids_per_example;
+  Tensor indices(DT_INT32, TensorShape({kNumIndices}));
+  auto indices_flat = indices.flat<int32>();
+  Tensor segments(DT_INT32, TensorShape({kNumIndices}));
+  auto segments_flat = segments.flat<int32>();
+  for (int i = 0; i < kNumIndices; ++i) {
+    indices_flat(i) = (i * 7919) % kVocabSize;
+    segments_flat(i) = i / ids_per_example;
+  }
+
+  Tensor params(DT_FLOAT, TensorShape({kVocabSize, dim}));
+  params.flat<float>().setRandom();
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "SparseSegmentSum")
+                  .Input(test::graph::Constant(g, params))
+                  .Input(test::graph::Constant(g, indices))
+                  .Input(test::graph::Constant(g, segments))
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &node));
+
+  testing::UseRealTime();
+  testing::BytesProcessed(static_cast<int64>(iters) * kNumIndices * dim *
+                          sizeof(float));
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+static void BM_SparseSegmentSum_Dim16(int iters, int ids_per_example) {
+  return SparseSegmentSumHelper(iters, ids_per_example, 16);
+}
+
+static void BM_SparseSegmentSum_Dim128(int iters, int ids_per_example) {
+  return SparseSegmentSumHelper(iters, ids_per_example, 128);
+}
+
+BENCHMARK(BM_SparseSegmentSum_Dim16)->Arg(1)->Arg(10)->Arg(100);
+BENCHMARK(BM_SparseSegmentSum_Dim128)->Arg(1)->Arg(10)->Arg(100);
+
+// Sums `num_rows` rows of 128 floats into `num_segments` unsorted segments.
+static void UnsortedSegmentSumHelper(int iters, int num_rows,
+                                     int num_segments) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+
+  const int kDim = 128;
+  Tensor data(DT_FLOAT, TensorShape({num_rows, kDim}));
+  data.flat<float>().setRandom();
+  Tensor segment_ids(DT_INT32, TensorShape({num_rows}));
+  auto segment_ids_flat = segment_ids.flat<int32>();
+  for (int i = 0; i < num_rows; ++i) {
+    segment_ids_flat(i) = (i * 7919) % num_segments;
+  }
+  Tensor num_segments_t(DT_INT32, TensorShape({}));
+  num_segments_t.scalar<int32>()() = num_segments;
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "UnsortedSegmentSum")
+                  .Input(test::graph::Constant(g, data))
+                  .Input(test::graph::Constant(g, segment_ids))
+                  .Input(test::graph::Constant(g, num_segments_t))
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &node));
+
+  testing::UseRealTime();
+  testing::BytesProcessed(static_cast<int64>(iters) * num_rows * kDim *
+                          sizeof(float));
+  testing::StartTiming();
+  test::Benchmark("cpu", g).Run(iters);
+}
+
+static void BM_UnsortedSegmentSum_FewSegments(int iters, int num_rows) {
+  return UnsortedSegmentSumHelper(iters, num_rows, 16);
+}
+
+static void BM_UnsortedSegmentSum_ManySegments(int iters, int num_rows) {
+  return UnsortedSegmentSumHelper(iters, num_rows, num_rows / 2);
+}
+
+BENCHMARK(BM_UnsortedSegmentSum_FewSegments)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_UnsortedSegmentSum_ManySegments)->Arg(1000)->Arg(100000);
+
 }  // namespace tensorflow
@@ -50,11 +50,11 @@ SendOp::SendOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
                         reinterpret_cast<int64*>(&send_device_incarnation)));
   string tensor_name;
   OP_REQUIRES_OK(ctx, ctx->GetAttr("tensor_name", &tensor_name));
-  key_prefix_ = GetRendezvousKeyPrefix(send_device, recv_device,
-                                       send_device_incarnation, tensor_name);
+  const string key_prefix = GetRendezvousKeyPrefix(
+      send_device, recv_device, send_device_incarnation, tensor_name);
   // The vast majority of Send nodes are outside any loop context, so
   // proactively cache the rendezvous key for the top-level.
-  GetRendezvousKey(key_prefix_, {0, 0}, &parsed_key_.buf_);
+  GetRendezvousKey(key_prefix, {0, 0}, &parsed_key_.buf_);
   OP_REQUIRES_OK(ctx, Rendezvous::ParseKey(parsed_key_.buf_, &parsed_key_));
 }
 
@@ -79,11 +79,8 @@ void SendOp::Compute(OpKernelContext* ctx) {
                                            ctx->is_input_dead()));
   } else {
     Rendezvous::ParsedKey in_loop_parsed;
-    GetRendezvousKey(key_prefix_, ctx->frame_iter(), &in_loop_parsed.buf_);
+    parsed_key_.WithFrameIter(ctx->frame_iter(), &in_loop_parsed);
     VLOG(2) << "Send " << in_loop_parsed.buf_;
-    OP_REQUIRES_OK(ctx,
-                   Rendezvous::ParseKey(in_loop_parsed.buf_, &in_loop_parsed));
-
     OP_REQUIRES_OK(ctx,
                    ctx->rendezvous()->Send(in_loop_parsed, args, ctx->input(0),
                                            ctx->is_input_dead()));
@@ -114,11 +111,11 @@ RecvOp::RecvOp(OpKernelConstruction* ctx) : AsyncOpKernel(ctx) {
                         reinterpret_cast<int64*>(&send_device_incarnation)));
   string tensor_name;
   OP_REQUIRES_OK(ctx, ctx->GetAttr("tensor_name", &tensor_name));
-  key_prefix_ = GetRendezvousKeyPrefix(send_device, recv_device,
-                                       send_device_incarnation, tensor_name);
+  const string key_prefix = GetRendezvousKeyPrefix(
+      send_device, recv_device, send_device_incarnation, tensor_name);
   // The vast majority of Recv nodes are outside any loop context, so
   // proactively cache the rendezvous key for the top-level.
-  GetRendezvousKey(key_prefix_, {0, 0}, &parsed_key_.buf_);
+  GetRendezvousKey(key_prefix, {0, 0}, &parsed_key_.buf_);
   OP_REQUIRES_OK(ctx, Rendezvous::ParseKey(parsed_key_.buf_, &parsed_key_));
 }
 
@@ -156,11 +153,8 @@ void RecvOp::ComputeAsync(OpKernelContext* ctx, DoneCallback done) {
     ctx->rendezvous()->RecvAsync(parsed_key_, args, std::move(done_cb));
   } else {
     Rendezvous::ParsedKey in_loop_parsed;
-    GetRendezvousKey(key_prefix_, ctx->frame_iter(), &in_loop_parsed.buf_);
+    parsed_key_.WithFrameIter(ctx->frame_iter(), &in_loop_parsed);
     VLOG(2) << "Recv " << in_loop_parsed.buf_;
-    OP_REQUIRES_OK_ASYNC(
-        ctx, Rendezvous::ParseKey(in_loop_parsed.buf_, &in_loop_parsed), done);
-
     ctx->rendezvous()->RecvAsync(in_loop_parsed, args, std::move(done_cb));
   }
 }
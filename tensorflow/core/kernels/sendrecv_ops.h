@@ -27,7 +27,8 @@ class SendOp : public OpKernel {
   void Compute(OpKernelContext* ctx) override;
 
  private:
-  string key_prefix_;
+  // The key of the top-level frame, from which the keys of frames of loops
+  // are derived.
   Rendezvous::ParsedKey parsed_key_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(SendOp);
@@ -39,7 +40,8 @@ class RecvOp : public AsyncOpKernel {
   void ComputeAsync(OpKernelContext* ctx, DoneCallback done) override;
 
  private:
-  string key_prefix_;
+  // The key of the top-level frame, from which the keys of frames of loops
+  // are derived.
   Rendezvous::ParsedKey parsed_key_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(RecvOp);
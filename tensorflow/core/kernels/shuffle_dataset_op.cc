@@ -62,7 +62,7 @@ class ShuffleDatasetOp : public UnaryDatasetOpKernel {
 
     ~Dataset() override { input_->Unref(); }
 
-    std::unique_ptr<IteratorBase> MakeIterator() const override {
+    std::unique_ptr<IteratorBase> MakeIteratorInternal() const override {
       return std::unique_ptr<IteratorBase>(new Iterator(this));
     }
 
@@ -111,6 +111,7 @@ class ShuffleDatasetOp : public UnaryDatasetOpKernel {
         }
 
         if (!buffer_.empty()) {
+          RecordDatasetBufferSize(buffer_.size());
           *end_of_sequence = false;
           // Choose an element to produce uniformly at random, and
           // swap the last element into its place in the buffer.
@@ -145,6 +146,153 @@ class ShuffleDatasetOp : public UnaryDatasetOpKernel {
 REGISTER_KERNEL_BUILDER(Name("ShuffleDataset").Device(DEVICE_CPU),
                         ShuffleDatasetOp);
 
+// Unlike a `ShuffleDataset` followed by a `RepeatDataset`, whose buffer
+// drains at the end of every epoch and then refills from scratch, this
+// dataset fills its buffer from the next epoch as soon as the current one
+// ends, so elements of consecutive epochs can be mixed.
+class ShuffleAndRepeatDatasetOp : public UnaryDatasetOpKernel {
+ public:
+  explicit ShuffleAndRepeatDatasetOp(OpKernelConstruction* ctx)
+      : UnaryDatasetOpKernel(ctx) {}
+
+  void MakeDataset(OpKernelContext* ctx, DatasetBase* input,
+                   DatasetBase** output) override {
+    int64 buffer_size;
+    OP_REQUIRES_OK(
+        ctx, ParseScalarArgument<int64>(ctx, "buffer_size", &buffer_size));
+    OP_REQUIRES(
+        ctx, buffer_size > 0,
+        errors::InvalidArgument("buffer_size must be greater than zero."));
+
+    int64 seed;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "seed", &seed));
+
+    int64 seed2;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "seed2", &seed2));
+
+    int64 count;
+    OP_REQUIRES_OK(ctx, ParseScalarArgument<int64>(ctx, "count", &count));
+
+    *output = new Dataset(input, buffer_size, seed, seed2, count);
+  }
+
+ private:
+  class Dataset : public DatasetBase {
+   public:
+    Dataset(const DatasetBase* input, int64 buffer_size, int64 seed,
+            int64 seed2, int64 count)
+        : input_(input),
+          buffer_size_(buffer_size),
+          seed_(seed),
+          seed2_(seed2),
+          count_(count) {
+      input_->Ref();
+    }
+
+    ~Dataset() override { input_->Unref(); }
+
+    std::unique_ptr<IteratorBase> MakeIteratorInternal() const override {
+      return std::unique_ptr<IteratorBase>(new Iterator(this));
+    }
+
+    const DataTypeVector& output_dtypes() const override {
+      return input_->output_dtypes();
+    }
+
+    const std::vector<PartialTensorShape>& output_shapes() const override {
+      return input_->output_shapes();
+    }
+
+    string DebugString() override {
+      return strings::StrCat("ShuffleAndRepeatDatasetOp(", buffer_size_, ", ",
+                             seed_, ", ", seed2_, ", ", count_, ")::Dataset");
+    }
+
+   private:
+    class Iterator : public DatasetIterator<Dataset> {
+     public:
+      explicit Iterator(const Dataset* dataset)
+          : DatasetIterator<Dataset>(dataset),
+            generator_(&parent_generator_) {
+        if (dataset->count_ != 0) {
+          input_impl_ = dataset->input_->MakeIterator();
+        }
+        buffer_.reserve(dataset->buffer_size_);
+        int64 seed = dataset->seed_;
+        int64 seed2 = dataset->seed2_;
+        if (seed == 0 && seed2 == 0) {
+          // If both seeds are unspecified, use completely random seeds.
+          seed = random::New64();
+          seed2 = random::New64();
+        }
+        parent_generator_ = random::PhiloxRandom(seed, seed2);
+      }
+
+      Status GetNext(IteratorContext* ctx, std::vector<Tensor>* out_tensors,
+                     bool* end_of_sequence) override {
+        mutex_lock l(mu_);
+        while (input_impl_ && buffer_.size() < dataset()->buffer_size_) {
+          std::vector<Tensor> input_element;
+          bool end_of_input_sequence;
+          TF_RETURN_IF_ERROR(input_impl_->GetNext(ctx, &input_element,
+                                                  &end_of_input_sequence));
+          if (!end_of_input_sequence) {
+            buffer_.emplace_back(std::move(input_element));
+            epoch_is_empty_ = false;
+            continue;
+          }
+          // Start the next epoch, unless this was the last one. An empty
+          // epoch ends the sequence, because every later epoch would be
+          // empty too.
+          ++epoch_;
+          if (epoch_is_empty_ ||
+              (dataset()->count_ > 0 && epoch_ >= dataset()->count_)) {
+            input_impl_.reset();
+          } else {
+            input_impl_ = dataset()->input_->MakeIterator();
+            epoch_is_empty_ = true;
+          }
+        }
+
+        if (!buffer_.empty()) {
+          RecordDatasetBufferSize(buffer_.size());
+          *end_of_sequence = false;
+          // Choose an element to produce uniformly at random, and
+          // swap the last element into its place in the buffer.
+          int64 index = generator_() % buffer_.size();
+          *out_tensors = std::move(buffer_[index]);
+          std::swap(buffer_[index], buffer_.back());
+          buffer_.pop_back();
+        } else {
+          DCHECK(!input_impl_);
+          *end_of_sequence = true;
+        }
+        return Status::OK();
+      }
+
+     private:
+      mutex mu_;
+      std::vector<std::vector<Tensor>> buffer_ GUARDED_BY(mu_);
+      // Null once the last epoch has ended.
+      std::unique_ptr<IteratorBase> input_impl_ GUARDED_BY(mu_);
+      int64 epoch_ GUARDED_BY(mu_) = 0;
+      bool epoch_is_empty_ GUARDED_BY(mu_) = true;
+      random::PhiloxRandom parent_generator_ GUARDED_BY(mu_);
+      random::SingleSampleAdapter<random::PhiloxRandom> generator_
+          GUARDED_BY(mu_);
+    };
+
+    const DatasetBase* const input_;
+    const int64 buffer_size_;
+    const int64 seed_;
+    const int64 seed2_;
+    const int64 count_;
+  };
+};
+
+REGISTER_KERNEL_BUILDER(Name("ShuffleAndRepeatDataset").Device(DEVICE_CPU),
+                        ShuffleAndRepeatDatasetOp);
+
 }  // namespace
 
 }  // namespace tensorflow
@@ -48,7 +48,7 @@ class SkipDatasetOp : public UnaryDatasetOpKernel {
 
     ~Dataset() override { input_->Unref(); }
 
-    std::unique_ptr<IteratorBase> MakeIterator() const override {
+    std::unique_ptr<IteratorBase> MakeIteratorInternal() const override {
       if (count_ < 0) {
         return std::unique_ptr<IteratorBase>(new EmptyIterator(this));
       }  else if (count_ == 0) {
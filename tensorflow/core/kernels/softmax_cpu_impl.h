@@ -0,0 +1,303 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_KERNELS_SOFTMAX_CPU_IMPL_H_
+#define TENSORFLOW_KERNELS_SOFTMAX_CPU_IMPL_H_
+
+// Row-wise softmax for the CPU, shared by the Softmax, LogSoftmax and
+// SoftmaxCrossEntropyWithLogits kernels.
+//
+// The Eigen implementations in softmax_op_functor.h and xent_op.h evaluate
+// the maximum, the shifted logits, their exponentials and the sum as separate
+// tensor expressions, so every row goes through memory four to five times.
+// Here each row is read once to compute its maximum and the sum of
+// exp(x - max) together (rescaling the sum whenever the maximum grows), and
+// once more to write the outputs, in chunks small enough to stay in L1.
+// Rows are spread over the threads of the device; when there are fewer rows
+// than threads, long rows are also split into segments whose partial results
+// are combined.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "third_party/eigen3/Eigen/Core"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace softmax_cpu {
+
+// Number of elements of a row that are processed at a time.
+static const int64 kChunkSize = 1024;
+
+// Rows are only split into segments that are at least this long.
+static const int64 kMinSegmentSize = 16384;
+
+// The maximum of a range of logits, and the sum of exp(x - max) over it.
+template <typename T>
+struct RowStats {
+  T max = -std::numeric_limits<T>::infinity();
+  T sum = T(0);
+
+  // Folds logits[0, size) into the statistics. If 'exps' isn't nullptr, also
+  // stores exp(x - m) into it, where m is the maximum of the statistics after
+  // every chunk, and stores these maxima into 'chunk_maxima'. 'exps' may
+  // alias 'logits'.
+  void Accumulate(const T* logits, int64 size, T* exps, T* chunk_maxima) {
+    typedef Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>> ConstArray;
+    typedef Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>> Array;
+    for (int64 start = 0; start < size; start += kChunkSize) {
+      const int64 chunk_size = std::min(kChunkSize, size - start);
+      ConstArray chunk(logits + start, chunk_size);
+      const T chunk_max = chunk.maxCoeff();
+      if (chunk_max > max) {
+        sum *= std::exp(max - chunk_max);
+        max = chunk_max;
+      }
+      if (exps != nullptr) {
+        Array chunk_exps(exps + start, chunk_size);
+        chunk_exps = (chunk - max).exp();
+        sum += chunk_exps.sum();
+        chunk_maxima[start / kChunkSize] = max;
+      } else {
+        sum += (chunk - max).exp().sum();
+      }
+    }
+  }
+
+  // Folds the statistics of another range into these ones.
+  void Merge(const RowStats& other) {
+    if (!(other.sum > T(0))) {
+      return;
+    }
+    if (!(sum > T(0))) {
+      *this = other;
+      return;
+    }
+    const T new_max = std::max(max, other.max);
+    sum = sum * std::exp(max - new_max) +
+          other.sum * std::exp(other.max - new_max);
+    max = new_max;
+  }
+};
+
+inline int64 ChunksPerRow(int64 classes) {
+  return (classes + kChunkSize - 1) / kChunkSize;
+}
+
+// Computes the statistics of every row of the 'batch' x 'classes' row-major
+// matrix 'logits', then calls
+//
+//   T output(int64 row, int64 begin, int64 end, const RowStats<T>& stats)
+//
+// to produce the outputs of the columns [begin, end) of 'row'. The calls may
+// run concurrently, and for one row they may be split over several ranges
+// that start at multiples of kChunkSize. The values they return are summed
+// for every row into 'row_results', unless it is nullptr. 'output' may
+// overwrite the logits it has been given.
+//
+// If 'exps' isn't nullptr, the first pass also stores the exponentials of the
+// logits into this 'batch' x 'classes' matrix, as described in
+// RowStats::Accumulate(), with the maxima of the chunks of every row at
+// 'chunk_maxima' + row * ChunksPerRow(classes).
+template <typename T, typename OutputFn>
+void RowwiseSoftmax(const Eigen::ThreadPoolDevice& d, const T* logits,
+                    int64 batch, int64 classes, int64 bytes_per_element,
+                    T* exps, T* chunk_maxima, const OutputFn& output,
+                    T* row_results) {
+  if (batch == 0) {
+    return;
+  }
+  const int num_threads = d.numThreads();
+  int64 segments = 1;
+  if (batch < num_threads && classes >= 2 * kMinSegmentSize) {
+    segments = std::min<int64>((num_threads + batch - 1) / batch,
+                               classes / kMinSegmentSize);
+  }
+  const int64 chunks_per_row = ChunksPerRow(classes);
+  const int64 segment_size =
+      (chunks_per_row + segments - 1) / segments * kChunkSize;
+  segments = (classes + segment_size - 1) / segment_size;
+  const double exp_cost =
+      Eigen::internal::functor_traits<Eigen::internal::scalar_exp_op<T>>::Cost;
+
+  if (segments == 1) {
+    const Eigen::TensorOpCost cost(
+        classes * bytes_per_element, classes * sizeof(T),
+        classes * (2 * exp_cost + 2 * Eigen::TensorOpCost::AddCost<T>()));
+    d.parallelFor(batch, cost, [&](int64 first, int64 last) {
+      for (int64 row = first; row < last; ++row) {
+        RowStats<T> stats;
+        if (exps != nullptr) {
+          stats.Accumulate(logits + row * classes, classes,
+                           exps + row * classes,
+                           chunk_maxima + row * chunks_per_row);
+        } else {
+          stats.Accumulate(logits + row * classes, classes, nullptr, nullptr);
+        }
+        const T result = output(row, 0, classes, stats);
+        if (row_results != nullptr) {
+          row_results[row] = result;
+        }
+      }
+    });
+    return;
+  }
+
+  // Fewer rows than threads: split every row into 'segments' ranges.
+  const int64 units = batch * segments;
+  std::vector<RowStats<T>> partial_stats(units);
+  const Eigen::TensorOpCost stats_cost(
+      segment_size * sizeof(T), 0,
+      segment_size * (exp_cost + 2 * Eigen::TensorOpCost::AddCost<T>()));
+  d.parallelFor(units, stats_cost, [&](int64 first, int64 last) {
+    for (int64 unit = first; unit < last; ++unit) {
+      const int64 row = unit / segments;
+      const int64 begin = (unit % segments) * segment_size;
+      const int64 end = std::min(classes, begin + segment_size);
+      const int64 offset = row * classes + begin;
+      if (exps != nullptr) {
+        partial_stats[unit].Accumulate(
+            logits + offset, end - begin, exps + offset,
+            chunk_maxima + row * chunks_per_row + begin / kChunkSize);
+      } else {
+        partial_stats[unit].Accumulate(logits + offset, end - begin, nullptr,
+                                       nullptr);
+      }
+    }
+  });
+  for (int64 row = 0; row < batch; ++row) {
+    for (int64 s = 1; s < segments; ++s) {
+      partial_stats[row * segments].Merge(partial_stats[row * segments + s]);
+    }
+  }
+
+  std::vector<T> partial_results(units);
+  const Eigen::TensorOpCost output_cost(
+      segment_size * bytes_per_element, segment_size * sizeof(T),
+      segment_size * (exp_cost + 2 * Eigen::TensorOpCost::AddCost<T>()));
+  d.parallelFor(units, output_cost, [&](int64 first, int64 last) {
+    for (int64 unit = first; unit < last; ++unit) {
+      const int64 row = unit / segments;
+      const int64 begin = (unit % segments) * segment_size;
+      const int64 end = std::min(classes, begin + segment_size);
+      partial_results[unit] =
+          output(row, begin, end, partial_stats[row * segments]);
+    }
+  });
+  if (row_results != nullptr) {
+    for (int64 row = 0; row < batch; ++row) {
+      T result = T(0);
+      for (int64 s = 0; s < segments; ++s) {
+        result += partial_results[row * segments + s];
+      }
+      row_results[row] = result;
+    }
+  }
+}
+
+// Computes softmax (or log-softmax if 'log' is true) of every row of
+// 'logits'. 'softmax' may alias 'logits'.
+//
+// For softmax the first pass already stores the exponentials into 'softmax',
+// so that the second one only has to rescale them, with a single exp per
+// chunk rather than per element.
+template <typename T>
+void Softmax(const Eigen::ThreadPoolDevice& d,
+             typename TTypes<T>::ConstMatrix logits,
+             typename TTypes<T>::Matrix softmax, const bool log) {
+  typedef Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>> ConstArray;
+  typedef Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>> Array;
+  const int64 batch = logits.dimension(0);
+  const int64 classes = logits.dimension(1);
+  const T* in = logits.data();
+  T* out = softmax.data();
+  if (log) {
+    auto output = [in, out, classes](int64 row, int64 begin, int64 end,
+                                     const RowStats<T>& stats) {
+      const T log_offset = stats.max + std::log(stats.sum);
+      for (int64 start = begin; start < end; start += kChunkSize) {
+        const int64 offset = row * classes + start;
+        const int64 size = std::min(kChunkSize, end - start);
+        Array(out + offset, size) = ConstArray(in + offset, size) - log_offset;
+      }
+      return T(0);
+    };
+    RowwiseSoftmax<T>(d, in, batch, classes, sizeof(T), nullptr, nullptr,
+                      output, nullptr);
+    return;
+  }
+  const int64 chunks_per_row = ChunksPerRow(classes);
+  std::vector<T> chunk_maxima(batch * chunks_per_row);
+  const T* maxima = chunk_maxima.data();
+  auto output = [out, maxima, classes, chunks_per_row](
+      int64 row, int64 begin, int64 end, const RowStats<T>& stats) {
+    const T inv_sum = T(1) / stats.sum;
+    for (int64 start = begin; start < end; start += kChunkSize) {
+      const int64 offset = row * classes + start;
+      const int64 size = std::min(kChunkSize, end - start);
+      const T chunk_max = maxima[row * chunks_per_row + start / kChunkSize];
+      Array(out + offset, size) *= std::exp(chunk_max - stats.max) * inv_sum;
+    }
+    return T(0);
+  };
+  RowwiseSoftmax<T>(d, in, batch, classes, sizeof(T), out,
+                    chunk_maxima.data(), output, nullptr);
+}
+
+// Computes the cross entropy loss of every row of 'logits' against 'labels',
+// and its gradient with respect to the logits. 'backprop' may alias 'logits'.
+template <typename T>
+void SoftmaxCrossEntropy(const Eigen::ThreadPoolDevice& d,
+                         typename TTypes<T>::ConstMatrix logits,
+                         typename TTypes<T>::ConstMatrix labels,
+                         typename TTypes<T>::Vec loss,
+                         typename TTypes<T>::Matrix backprop) {
+  typedef Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>> ConstArray;
+  typedef Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>> Array;
+  const int64 classes = logits.dimension(1);
+  const T* in = logits.data();
+  const T* lab = labels.data();
+  T* out = backprop.data();
+  auto output = [in, lab, out, classes](int64 row, int64 begin, int64 end,
+                                        const RowStats<T>& stats) {
+    const T inv_sum = T(1) / stats.sum;
+    const T log_sum = std::log(stats.sum);
+    T row_loss = T(0);
+    for (int64 start = begin; start < end; start += kChunkSize) {
+      const int64 offset = row * classes + start;
+      const int64 size = std::min(kChunkSize, end - start);
+      ConstArray x(in + offset, size);
+      ConstArray l(lab + offset, size);
+      Array y(out + offset, size);
+      // The loss has to be taken before 'y' overwrites 'x'.
+      row_loss += (l * (log_sum - (x - stats.max))).sum();
+      y = (x - stats.max).exp() * inv_sum - l;
+    }
+    return row_loss;
+  };
+  RowwiseSoftmax<T>(d, in, logits.dimension(0), classes, 2 * sizeof(T),
+                    nullptr, nullptr, output, loss.data());
+}
+
+}  // namespace softmax_cpu
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_KERNELS_SOFTMAX_CPU_IMPL_H_
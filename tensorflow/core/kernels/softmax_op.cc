@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/softmax_cpu_impl.h"
 
 namespace tensorflow {
 
@@ -45,6 +46,19 @@ struct SoftmaxFunctorBase {
 template <typename T>
 struct SoftmaxFunctor<CPUDevice, T> : SoftmaxFunctorBase<CPUDevice, T> {};
 
+// float and double use the fused row-wise implementation instead.
+template <typename T>
+struct SoftmaxFunctorCPU {
+  void operator()(const CPUDevice& d, typename TTypes<T>::ConstMatrix logits,
+                  typename TTypes<T>::Matrix softmax, const bool log) {
+    softmax_cpu::Softmax<T>(d, logits, softmax, log);
+  }
+};
+template <>
+struct SoftmaxFunctor<CPUDevice, float> : SoftmaxFunctorCPU<float> {};
+template <>
+struct SoftmaxFunctor<CPUDevice, double> : SoftmaxFunctorCPU<double> {};
+
 #ifdef TENSORFLOW_USE_SYCL
 template <typename T>
 struct SoftmaxFunctor<SYCLDevice, T> : SoftmaxFunctorBase<SYCLDevice, T> {};
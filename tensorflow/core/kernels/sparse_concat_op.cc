@@ -127,11 +127,13 @@ class SparseConcatOp : public OpKernel {
       sp_inputs.emplace_back(tensor::DeepCopy(inds[i]),
                              tensor::DeepCopy(vals[i]), current_shape,
                              std_order);
-      sp_inputs[i].Reorder<T>(concat_order);
+      sp_inputs[i].Reorder<T>(
+          concat_order, context->device()->tensorflow_cpu_worker_threads());
     }
 
     sparse::SparseTensor concat = sparse::SparseTensor::Concat<T>(sp_inputs);
-    concat.Reorder<T>(std_order);
+    concat.Reorder<T>(std_order,
+                      context->device()->tensorflow_cpu_worker_threads());
 
     context->set_output(0, concat.indices());
     context->set_output(1, concat.values());
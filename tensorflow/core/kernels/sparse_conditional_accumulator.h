@@ -16,7 +16,13 @@ limitations under the License.
 #ifndef TENSORFLOW_KERNELS_SPARSE_CONDITIONAL_ACCUMULATOR_H_
 #define TENSORFLOW_KERNELS_SPARSE_CONDITIONAL_ACCUMULATOR_H_
 
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "tensorflow/core/kernels/typed_conditional_accumulator_base.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
@@ -42,6 +48,13 @@ namespace tensorflow {
  * SparseConditionalAccumulator is the datatype-dependent templated sub-class of
  * ConditionalAccumulatorBase. It implements the virtual arithmetic methods that
  * are used by for aggregating, averaging, allocating, returning indexed slices.
+ *
+ * The accumulated slices are kept in a buffer of rows in the order their
+ * indices were first seen, with a hash index from slice index to row, so
+ * that applying a gradient costs time in the size of the gradient rather
+ * than in that of the accumulated gradient. Duplicated indices are summed
+ * into one row as they arrive. The rows are summed, averaged and returned
+ * (in increasing index order) on the CPU worker threads.
  */
 template <typename Device, typename T>
 class SparseConditionalAccumulator
@@ -68,9 +81,15 @@ class SparseConditionalAccumulator
   };
 
  protected:
+  // The index of each row of the accumulated gradient, and the number of
+  // gradients summed into it.
   std::vector<int64>* accum_idx_vec_ = nullptr;
   std::vector<int>* count_element_ = nullptr;
+  // The row of each index of the accumulated gradient.
+  std::unordered_map<int64, int64> idx_to_row_;
 
+  // The rows of the accumulated gradient. Only the first
+  // accum_idx_vec_->size() rows are in use; the others are spare capacity.
   Tensor* accum_val_ = nullptr;
   PersistentTensor* accum_val_persistent_ = nullptr;
 
@@ -158,32 +177,14 @@ class SparseConditionalAccumulator
   void AllocateAndAssignToAccumGradFunction(
       OpKernelContext* ctx,
       std::tuple<const Tensor*, const Tensor*, const Tensor*>* grad) override {
-    const Tensor* grad_idx = std::get<0>(*grad);
-    const Tensor* grad_val = std::get<1>(*grad);
-
-    const int64 nnz = grad_idx->dim_size(0);
-
-    // Assign indices
-    if (accum_idx_vec_ != nullptr) delete accum_idx_vec_;
-    accum_idx_vec_ = new std::vector<int64>();
-    accum_idx_vec_->reserve(nnz);
-    for (int i = 0; i < nnz; i++) {
-      accum_idx_vec_->push_back(grad_idx->vec<int64>()(i));
-    }
-
-    // Assign values to accum_val_tensor
-    // TODO(b/32704451): Don't just ignore the ::tensorflow::Status object!
-    ctx->allocate_persistent(dtype_, grad_val->shape(), accum_val_persistent_,
-                             &accum_val_)
-        .IgnoreError();
-    accum_val_->flat<T>().device(ctx->template eigen_device<Device>()) =
-        grad_val->flat<T>();
-
-    // Assign count_element_
-    if (count_element_ != nullptr) {
-      delete count_element_;
-    }
-    count_element_ = new std::vector<int>(nnz, 1);
+    // Start from an empty accumulated gradient, which keeps the rows of the
+    // previous one as spare capacity.
+    if (accum_idx_vec_ == nullptr) accum_idx_vec_ = new std::vector<int64>();
+    if (count_element_ == nullptr) count_element_ = new std::vector<int>();
+    accum_idx_vec_->clear();
+    count_element_->clear();
+    idx_to_row_.clear();
+    AddToAccumGradFunction(ctx, grad);
 
     // Do not need shape; Assume that the op has checked that the shapes match,
     // so grad's shape == shape_
@@ -192,128 +193,75 @@ class SparseConditionalAccumulator
   void AddToAccumGradFunction(
       OpKernelContext* ctx,
       std::tuple<const Tensor*, const Tensor*, const Tensor*>* grad) override {
-    // Modeled after third_party/tensorflow/core/kernels/sparse_add_op
-
     const Tensor* grad_idx = std::get<0>(*grad);
     const Tensor* grad_val = std::get<1>(*grad);
+    const auto grad_idx_vec = grad_idx->vec<int64>();
 
-    const int64 accum_nnz = accum_idx_vec_->size();
+    const int64 old_nnz = accum_idx_vec_->size();
     const int64 grad_nnz = grad_idx->dim_size(0);
 
-    // Source enumerates the origin of a non-zero element: whether it is from
-    // the new gradient, the accumulated gradient, or the sum of both.
-    enum Source { from_accum, from_grad, from_accum_and_grad };
-
-    // (1) do a pass over inputs, and append values and indices to vectors
-    std::vector<std::tuple<Source, int64, int64>> entries_to_copy;
-    entries_to_copy.reserve(accum_nnz + grad_nnz);
-
-    // Pass over all non-zero elements of both the gradient and the accumulated
-    // value, to identify where each non-zero element of the sum comes from.
-    // The input and output indexed slices are assumed to be ordered along
-    // increasing dimension number.
-    int64 i = 0, j = 0;
-    int64 sum_nnz = 0;
-    while (i < accum_nnz && j < grad_nnz) {
-      sum_nnz++;
-      switch (cmp(accum_idx_vec_, grad_idx, i, j)) {
-        case -1:
-          entries_to_copy.emplace_back(from_accum, i, -1);
-          ++i;
-          break;
-        case 0:
-          entries_to_copy.emplace_back(from_accum_and_grad, i, j);
-          ++i;
-          ++j;
-          break;
-        case 1:
-          entries_to_copy.emplace_back(from_grad, -1, j);
-          ++j;
-          break;
+    // (1) Find the row of the accumulated gradient for each row of the
+    // gradient, adding rows for the indices not accumulated yet.
+    std::vector<std::pair<int64, int64>> targets;  // (accum row, grad row)
+    targets.reserve(grad_nnz);
+    for (int64 j = 0; j < grad_nnz; ++j) {
+      auto it = idx_to_row_.insert(
+          {grad_idx_vec(j), static_cast<int64>(accum_idx_vec_->size())});
+      if (it.second) accum_idx_vec_->push_back(grad_idx_vec(j));
+      targets.emplace_back(it.first->second, j);
+    }
+    const int64 sum_nnz = accum_idx_vec_->size();
+    if (!ReserveRows(ctx, grad_val->shape(), old_nnz, sum_nnz)) {
+      for (int64 i = old_nnz; i < sum_nnz; ++i) {
+        idx_to_row_.erase(accum_idx_vec_->at(i));
       }
+      accum_idx_vec_->resize(old_nnz);
+      return;
     }
 
-    // Handle leftovers
-    while (i < accum_nnz) {
-      sum_nnz++;
-      entries_to_copy.emplace_back(from_accum, i, -1);
-      ++i;
-    }
-    while (j < grad_nnz) {
-      sum_nnz++;
-      entries_to_copy.emplace_back(from_grad, -1, j);
-      ++j;
+    // Group the rows of the gradient by accumulator row, and count the
+    // gradient once for each of the rows it touches.
+    std::sort(targets.begin(), targets.end());
+    count_element_->resize(sum_nnz, 0);
+    for (int64 k = 0; k < grad_nnz; ++k) {
+      if (k == 0 || targets[k].first != targets[k - 1].first) {
+        ++(*count_element_)[targets[k].first];
+      }
     }
 
-    // (2) Copy or sum the non-zero elements into sum_indices and sum_tensor
-    std::vector<int64>* sum_indices_vec = new std::vector<int64>();
-    sum_indices_vec->reserve(sum_nnz);
-
-    std::vector<int>* sum_counts = new std::vector<int>();
-    sum_counts->reserve(sum_nnz);
-
-    Tensor* sum_tensor = nullptr;
-    PersistentTensor* tensor_sum_persistent = new PersistentTensor();
-
-    TensorShape sum_shape = grad_val->shape();
-    sum_shape.set_dim(0, sum_nnz);
-
-    OP_REQUIRES_OK(
-        ctx, ctx->allocate_persistent(dtype_, sum_shape, tensor_sum_persistent,
-                                      &sum_tensor));
-    auto sum_flat = sum_tensor->flat_outer_dims<T>();
+    // (2) Sum the rows of the gradient into the accumulator. Each group is
+    // summed by the shard that holds its first row, so no row is written
+    // by two threads.
     auto accum_flat = accum_val_->flat_outer_dims<T>();
     auto grad_flat = grad_val->flat_outer_dims<T>();
-
     const int64 num_col = grad_flat.dimension(1);
-
     Eigen::DSizes<Eigen::DenseIndex, 1> slice_shape(num_col);
-
-    for (i = 0; i < sum_nnz; ++i) {
-      const Source src = std::get<0>(entries_to_copy[i]);
-      const int64 idx_a = std::get<1>(entries_to_copy[i]);
-      const int64 idx_b = std::get<2>(entries_to_copy[i]);
-      T* sum_slice_ptr = &sum_flat(i, 0);
-      SliceT sum_slice(sum_slice_ptr, slice_shape);
-      if (src == from_accum) {
-        // Element comes from accumulator; directly copy data structures over
-        sum_indices_vec->push_back(accum_idx_vec_->at(idx_a));
-        T* accum_slice_ptr = &accum_flat(idx_a, 0);
-        SliceT accum_slice(accum_slice_ptr, slice_shape);
-        sum_slice = accum_slice;
-        sum_counts->push_back(count_element_->at(idx_a));
-      } else if (src == from_accum_and_grad) {
-        // Element is a sum of accumulated value and new gradient;
-        // compute sum here
-        sum_indices_vec->push_back(accum_idx_vec_->at(idx_a));
-        const T* grad_slice_ptr = &grad_flat(idx_b, 0);
-        SliceConstT grad_slice(grad_slice_ptr, slice_shape);
-        T* accum_slice_ptr = &accum_flat(idx_a, 0);
+    auto starts_group = [&targets, grad_nnz](int64 k) {
+      return k == 0 || k == grad_nnz ||
+             targets[k].first != targets[k - 1].first;
+    };
+    auto add_rows = [&](int64 begin, int64 end) {
+      while (begin < end && !starts_group(begin)) ++begin;
+      if (begin == end) return;
+      while (!starts_group(end)) ++end;
+      for (int64 k = begin; k < end; ++k) {
+        const int64 row = targets[k].first;
+        T* accum_slice_ptr = &accum_flat(row, 0);
         SliceT accum_slice(accum_slice_ptr, slice_shape);
-        sum_slice = grad_slice + accum_slice;
-        sum_counts->push_back(count_element_->at(idx_a) + 1);
-      } else if (src == from_grad) {
-        // Element comes from new gradient; make a copy of indices and values
-        sum_indices_vec->push_back(grad_idx->vec<int64>()(idx_b));
-        const T* grad_slice_ptr = &grad_flat(idx_b, 0);
+        const T* grad_slice_ptr = &grad_flat(targets[k].second, 0);
         SliceConstT grad_slice(grad_slice_ptr, slice_shape);
-        sum_slice = grad_slice;
-        sum_counts->push_back(1);
+        if (row >= old_nnz && starts_group(k)) {
+          // Element comes from new gradient; make a copy of values
+          accum_slice = grad_slice;
+        } else {
+          accum_slice = accum_slice + grad_slice;
+        }
       }
-    }
-
-    // (3) Keep output, i.e., switch pointers to point to new data structures
-    // representing the sum
-    // Indices
-    if (accum_idx_vec_ != nullptr) delete accum_idx_vec_;
-    accum_idx_vec_ = sum_indices_vec;
-    // Values
-    accum_val_ = sum_tensor;
-    delete accum_val_persistent_;
-    accum_val_persistent_ = tensor_sum_persistent;
-    // Counts
-    if (count_element_ != nullptr) delete count_element_;
-    count_element_ = sum_counts;
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, grad_nnz,
+          num_col, add_rows);
 
     // No need to copy shape, since shape remains the same after sum.
   }
@@ -322,33 +270,29 @@ class SparseConditionalAccumulator
       EXCLUSIVE_LOCKS_REQUIRED(this->mu_) {
     const int64 nnz = count_element_->size();
     auto accum_flat = accum_val_->flat_outer_dims<T>();
-    std::vector<T> count_typet;
-    std::transform(count_element_->begin(), count_element_->end(),
-                   std::back_inserter(count_typet),
-                   TypeConverter<T, int>::ConvertUToT);
-
-    // Option 1: divide all by counter
-    /*
-    std::transform(
-        &accum_flat(0,0), &accum_flat(nnz,0), &accum_flat(0,0),
-        std::bind2nd(std::divides<T>(),
-                     TypeConverter<T, int>::ConvertUToT(this->counter_)));
-    */
-
-    // Option 2: average element-wise
-    Eigen::DSizes<Eigen::DenseIndex, 1> slice_shape(accum_flat.dimension(1));
-    for (int64 i = 0; i < nnz; i++) {
-      T* accum_slice_ptr = &accum_flat(i, 0);
-      SliceT accum_slice(accum_slice_ptr, slice_shape);
-      accum_slice.device(ctx->template eigen_device<Device>()) =
-          accum_slice / count_typet[i];
-    }
+    const int64 num_col = accum_flat.dimension(1);
+
+    // Average element-wise, since each row may have been summed from a
+    // different number of gradients.
+    Eigen::DSizes<Eigen::DenseIndex, 1> slice_shape(num_col);
+    auto divide_rows = [this, &accum_flat, &slice_shape](int64 begin,
+                                                         int64 end) {
+      for (int64 i = begin; i < end; i++) {
+        T* accum_slice_ptr = &accum_flat(i, 0);
+        SliceT accum_slice(accum_slice_ptr, slice_shape);
+        accum_slice = accum_slice / TypeConverter<T, int>::ConvertUToT(
+                                        count_element_->at(i));
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, nnz, num_col,
+          divide_rows);
   }
 
   bool SetOutput(OpKernelContext* ctx) override {
     bool is_successful = true;
-    if (is_successful) is_successful = ReturnIdxTensor(ctx);
-    if (is_successful) is_successful = ReturnValTensor(ctx);
+    if (is_successful) is_successful = ReturnIdxAndValTensors(ctx);
     if (is_successful) is_successful = ReturnShapeTensor(ctx);
     return is_successful;
   }
@@ -407,33 +351,78 @@ class SparseConditionalAccumulator
   }
 
  private:
-  inline int cmp(std::vector<int64>* a_idx, const Tensor* b_idx,
-                 const int64 a_row, const int64 b_row) {
-    const int64 a = a_idx->at(a_row);
-    const int64 b = b_idx->vec<int64>()(b_row);
-    if (a < b) {
-      return -1;
-    } else if (a > b) {
-      return 1;
+  // Makes accum_val_ hold at least "num_rows" rows of the inner dimensions
+  // of "grad_shape", keeping its first "num_used" rows. Grows it
+  // geometrically so that the cost of copying the rows is amortized. A
+  // tensor is always allocated, even for no rows, since the inner
+  // dimensions of accum_val_ are those of the accumulated gradient.
+  bool ReserveRows(OpKernelContext* ctx, const TensorShape& grad_shape,
+                   int64 num_used, int64 num_rows) {
+    int64 capacity = -1;
+    if (accum_val_ != nullptr && accum_val_->dims() == grad_shape.dims()) {
+      capacity = accum_val_->dim_size(0);
+      for (int i = 1; i < grad_shape.dims(); ++i) {
+        if (accum_val_->dim_size(i) != grad_shape.dim_size(i)) capacity = -1;
+      }
     }
-    return 0;
+    if (num_rows <= capacity) return true;
+
+    TensorShape new_shape = grad_shape;
+    new_shape.set_dim(0, std::max(num_rows, 2 * capacity));
+    PersistentTensor* new_persistent = new PersistentTensor();
+    Tensor* new_val = nullptr;
+    Status s = ctx->allocate_persistent(dtype_, new_shape, new_persistent,
+                                        &new_val);
+    if (!s.ok()) {
+      delete new_persistent;
+      ctx->CtxFailureWithWarning(s);
+      return false;
+    }
+    if (num_used > 0) {
+      auto accum_flat = accum_val_->flat_outer_dims<T>();
+      const int64 num_col = accum_flat.dimension(1);
+      std::copy_n(accum_flat.data(), num_used * num_col,
+                  new_val->flat_outer_dims<T>().data());
+    }
+    accum_val_ = new_val;
+    delete accum_val_persistent_;
+    accum_val_persistent_ = new_persistent;
+    return true;
   }
 
-  inline bool ReturnIdxTensor(OpKernelContext* ctx) {
-    Tensor* idx_tensor;
+  // Returns the accumulated indices in increasing order with their rows.
+  inline bool ReturnIdxAndValTensors(OpKernelContext* ctx) {
     const int64 nnz = accum_idx_vec_->size();
+    std::vector<std::pair<int64, int64>> order;  // (index, accum row)
+    order.reserve(nnz);
+    for (int64 i = 0; i < nnz; ++i) {
+      order.emplace_back(accum_idx_vec_->at(i), i);
+    }
+    std::sort(order.begin(), order.end());
+
+    Tensor* idx_tensor;
     OP_REQUIRES_OK_BOOLEAN(ctx, ctx->allocate_output(0, {nnz}, &idx_tensor));
+    TensorShape val_shape = accum_val_->shape();
+    val_shape.set_dim(0, nnz);
+    Tensor* val_tensor;
+    OP_REQUIRES_OK_BOOLEAN(ctx,
+                           ctx->allocate_output(1, val_shape, &val_tensor));
     // If allocate_output fails, OP_REQUIRES_OK_BOOLEAN will short-circuit
     // the remaining code and just return false
     auto idx_tensor_vec = idx_tensor->vec<int64>();
-    for (int i = 0; i < nnz; ++i) {
-      idx_tensor_vec(i) = accum_idx_vec_->at(i);
-    }
-    return true;
-  }
-
-  inline bool ReturnValTensor(OpKernelContext* ctx) {
-    ctx->set_output(1, *accum_val_);
+    auto val_flat = val_tensor->flat_outer_dims<T>();
+    auto accum_flat = accum_val_->flat_outer_dims<T>();
+    const int64 num_col = accum_flat.dimension(1);
+    auto copy_rows = [&](int64 begin, int64 end) {
+      for (int64 k = begin; k < end; ++k) {
+        idx_tensor_vec(k) = order[k].first;
+        std::copy_n(&accum_flat(order[k].second, 0), num_col, &val_flat(k, 0));
+      }
+    };
+    const DeviceBase::CpuWorkerThreads& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    Shard(worker_threads.num_threads, worker_threads.workers, nnz, num_col,
+          copy_rows);
     return true;
   }
 
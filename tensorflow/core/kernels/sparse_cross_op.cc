@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/util/batch_hash.h"
 #include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
@@ -47,14 +48,20 @@ class ColumnInterface {
 };
 
 // A column that is backed by a sparse tensor.
+//
+// When crossing by hash, "fingerprints" holds the Fingerprint64 of each of the
+// string values, so that a feature is fingerprinted once rather than once per
+// cross it is part of.
 template <typename InternalType>
 class SparseTensorColumn : public ColumnInterface<InternalType> {
  public:
   SparseTensorColumn(const Tensor& values, std::vector<int64> feature_counts,
-                     std::vector<int64> feature_start_indices)
+                     std::vector<int64> feature_start_indices,
+                     std::vector<uint64> fingerprints)
       : values_(values),
         feature_counts_(std::move(feature_counts)),
-        feature_start_indices_(std::move(feature_start_indices)) {
+        feature_start_indices_(std::move(feature_start_indices)),
+        fingerprints_(std::move(fingerprints)) {
     CHECK_EQ(feature_counts_.size(), feature_start_indices_.size());
   }
 
@@ -70,14 +77,14 @@ class SparseTensorColumn : public ColumnInterface<InternalType> {
   const Tensor& values_;
   std::vector<int64> feature_counts_;
   std::vector<int64> feature_start_indices_;
+  std::vector<uint64> fingerprints_;
 };
 
 // InternalType is int64 only when using HashCrosser.
 template <>
 int64 SparseTensorColumn<int64>::Feature(int64 batch, int64 n) const {
   const int64 start = feature_start_indices_[batch];
-  if (DT_STRING == values_.dtype())
-    return Fingerprint64(values_.vec<string>().data()[start + n]);
+  if (DT_STRING == values_.dtype()) return fingerprints_[start + n];
   return values_.vec<int64>().data()[start + n];
 }
 
@@ -97,11 +104,13 @@ StringPiece SparseTensorColumn<StringPiece>::Feature(int64 batch,
   return values_.vec<string>().data()[start + n];
 }
 
-// A column that is backed by a dense tensor.
+// A column that is backed by a dense tensor. "fingerprints" is as for
+// SparseTensorColumn, in row-major order.
 template <typename InternalType>
 class DenseTensorColumn : public ColumnInterface<InternalType> {
  public:
-  explicit DenseTensorColumn(const Tensor& tensor) : tensor_(tensor) {}
+  DenseTensorColumn(const Tensor& tensor, std::vector<uint64> fingerprints)
+      : tensor_(tensor), fingerprints_(std::move(fingerprints)) {}
 
   int64 FeatureCount(int64 batch) const override { return tensor_.dim_size(1); }
 
@@ -111,13 +120,15 @@ class DenseTensorColumn : public ColumnInterface<InternalType> {
 
  private:
   const Tensor& tensor_;
+  std::vector<uint64> fingerprints_;
 };
 
 // InternalType is int64 only when using HashCrosser.
 template <>
 int64 DenseTensorColumn<int64>::Feature(int64 batch, int64 n) const {
-  if (DT_STRING == tensor_.dtype())
-    return Fingerprint64(tensor_.matrix<string>()(batch, n));
+  if (DT_STRING == tensor_.dtype()) {
+    return fingerprints_[batch * tensor_.dim_size(1) + n];
+  }
   return tensor_.matrix<int64>()(batch, n);
 }
 
@@ -312,7 +323,7 @@ class SparseCrossOp : public OpKernel {
                   dense_list_in);
 
     std::vector<std::unique_ptr<ColumnInterface<InternalType>>> columns =
-        GenerateColumnsFromInput(indices_list_in, values_list_in,
+        GenerateColumnsFromInput(context, indices_list_in, values_list_in,
                                  shapes_list_in, dense_list_in);
 
     typename CrossTraits<HASHED_OUTPUT, InternalType>::Crosser
@@ -442,7 +453,8 @@ class SparseCrossOp : public OpKernel {
 
   // Generate the columns given the sparse and dense inputs.
   std::vector<std::unique_ptr<ColumnInterface<InternalType>>>
-  GenerateColumnsFromInput(const OpInputList& indices_list_in,
+  GenerateColumnsFromInput(OpKernelContext* context,
+                           const OpInputList& indices_list_in,
                            const OpInputList& values_list_in,
                            const OpInputList& shapes_list_in,
                            const OpInputList& dense_list_in) {
@@ -462,16 +474,38 @@ class SparseCrossOp : public OpKernel {
     for (int i = 0; i < values_list_in.size(); ++i) {
       columns.emplace_back(new SparseTensorColumn<InternalType>(
           values_list_in[i], std::move(feature_counts[i]),
-          std::move(feature_start_indices[i])));
+          std::move(feature_start_indices[i]),
+          FingerprintStrings(context, values_list_in[i])));
     }
     for (int i = 0; i < dense_list_in.size(); ++i) {
-      columns.emplace_back(
-          new DenseTensorColumn<InternalType>(dense_list_in[i]));
+      columns.emplace_back(new DenseTensorColumn<InternalType>(
+          dense_list_in[i], FingerprintStrings(context, dense_list_in[i])));
     }
 
     return columns;
   }
 
+  // Returns the Fingerprint64 of each of the strings of "values" when crossing
+  // by hash, or nothing otherwise.
+  std::vector<uint64> FingerprintStrings(OpKernelContext* context,
+                                         const Tensor& values) {
+    if (!HASHED_OUTPUT || values.dtype() != DT_STRING) {
+      return {};
+    }
+    const string* strings = values.flat<string>().data();
+    std::vector<uint64> fingerprints(values.NumElements());
+    auto* worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    // Roughly the cycles to fingerprint a short string.
+    const int kCostPerUnit = 100;
+    Shard(worker_threads->num_threads, worker_threads->workers,
+          fingerprints.size(), kCostPerUnit,
+          [strings, &fingerprints](int64 begin, int64 end) {
+            HashStrings<Fingerprint64>(strings + begin, end - begin,
+                                       fingerprints.data() + begin);
+          });
+    return fingerprints;
+  }
+
   // Extracts data about the features and populates feature data.
   void ExtractFeatureData(
       const OpInputList& indices_list_in, int64 batch_size,
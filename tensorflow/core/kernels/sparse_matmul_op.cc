@@ -33,6 +33,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
+#include "tensorflow/core/lib/hash/hash.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -761,8 +762,65 @@ class SparseMatMul {
   using MatrixMapR = BasicMatrixMap<TR>;
 
  public:
-  // Not used; added to match interface of LibxsmmSparseMatMul
-  struct TensorInfoCache {};
+  // Keeps the sparse encoding of the left matrix of the previous call, so that
+  // the slices whose contents didn't change since are not encoded again. The
+  // contents of every slice are fingerprinted, since a buffer may be updated
+  // in place, e.g. when the sparse operand is a variable. Slowly changing
+  // operands, such as pruned weights, are then mostly reused across steps.
+  class TensorInfoCache {
+   public:
+    // The slices of a matrix with the fingerprints of their contents.
+    struct Entry {
+      ~Entry() { Reset(0, 0, false, 0); }
+
+      // Returns true if the slices were created for the same layout.
+      bool Matches(int rows, int cols, bool transpose, int slice_cols) const {
+        return !mat_slices.empty() && rows == num_rows && cols == num_cols &&
+               transpose == is_transpose && slice_cols == slice_num_cols;
+      }
+
+      // Deletes the slices, and sets the layout of the next ones.
+      void Reset(int rows, int cols, bool transpose, int slice_cols) {
+        for (auto& slices : mat_slices) {
+          gtl::STLDeleteElements(&slices);
+        }
+        mat_slices.clear();
+        fingerprints.clear();
+        num_rows = rows;
+        num_cols = cols;
+        is_transpose = transpose;
+        slice_num_cols = slice_cols;
+      }
+
+      int num_rows = 0;
+      int num_cols = 0;
+      bool is_transpose = false;
+      int slice_num_cols = 0;
+      std::vector<std::vector<SparseSlice<TL>*>> mat_slices;
+      std::vector<std::vector<uint64>> fingerprints;
+    };
+
+    TensorInfoCache() {}
+
+    // Removes and returns the cached entry. Returns an empty entry if there is
+    // none, e.g. because a concurrent call is using it.
+    std::unique_ptr<Entry> TakeEntry() LOCKS_EXCLUDED(mu_) {
+      mutex_lock l(mu_);
+      if (entry_ == nullptr) return std::unique_ptr<Entry>(new Entry);
+      return std::move(entry_);
+    }
+
+    void ReturnEntry(std::unique_ptr<Entry> entry) LOCKS_EXCLUDED(mu_) {
+      mutex_lock l(mu_);
+      entry_ = std::move(entry);
+    }
+
+   private:
+    mutex mu_;
+    std::unique_ptr<Entry> entry_ GUARDED_BY(mu_);
+
+    TF_DISALLOW_COPY_AND_ASSIGN(TensorInfoCache);
+  };
 
   // Perform matrix multiplication of "left" and "right", and store the result
   // in *"output".
@@ -787,13 +845,25 @@ class SparseMatMul {
   // "mat_slices". "mat" is broken into a grid with sizes "slice_num_rows" and
   // "slice_num_cols", each grid element is converted into a SparseSlice and
   // stored in mat_slices. "slice_block_size" is used to perform further column
-  // blocking of each slice.
+  // blocking of each slice. If "fingerprints" is not null, the fingerprint of
+  // each grid element is stored in it, and if "reuse" is true, mat_slices and
+  // fingerprints hold the slices of a previous call with the same layout, and
+  // only the slices whose fingerprints changed are encoded again.
   static inline std::unique_ptr<BlockingCounter> CreateSparseSlices(
       const ConstMatrixMapL& mat, bool transpose, int slice_num_rows,
       int slice_block_size, int slice_num_cols,
       std::vector<std::vector<SparseSlice<TL>*>>* mat_slices,
+      std::vector<std::vector<uint64>>* fingerprints, bool reuse,
       const DeviceBase::CpuWorkerThreads* thread_pool);
 
+  // Returns the fingerprint of the contents of the slice of "mat" that is
+  // encoded by "sparse_slice" at column "col_offset". "mat" is the matrix
+  // passed to SparseSlice::Initialize.
+  static inline uint64 FingerprintSlice(const ConstMatrixMapL& mat,
+                                        bool transpose,
+                                        const SparseSlice<TL>& sparse_slice,
+                                        int col_offset);
+
   // This function chops "mat" along column dimension into pieces with at most N
   // columns, and concatenates the pieces one after the other in "buffer". It
   // returns the list of the pieces in "slices". It returns a BlockingCounter
@@ -1115,6 +1185,7 @@ SparseMatMul<TL, TR>::CreateSparseSlices(
     const typename SparseMatMul<TL, TR>::ConstMatrixMapL& mat, bool transpose,
     int slice_num_rows, int slice_block_size, int slice_num_cols,
     std::vector<std::vector<SparseSlice<TL>*>>* mat_slices,
+    std::vector<std::vector<uint64>>* fingerprints, bool reuse,
     const DeviceBase::CpuWorkerThreads* thread_pool) {
   const int mat_num_rows = transpose ? mat.dimension(1) : mat.dimension(0);
   const int mat_num_cols = transpose ? mat.dimension(0) : mat.dimension(1);
@@ -1122,22 +1193,46 @@ SparseMatMul<TL, TR>::CreateSparseSlices(
       std::max(1, (mat_num_rows + slice_num_rows - 1) / slice_num_rows);
   const int num_slices_dim1 =
       std::max(1, (mat_num_cols + slice_num_cols - 1) / slice_num_cols);
+  DCHECK(!reuse || fingerprints != nullptr);
   mat_slices->resize(num_slices_dim0);
+  if (fingerprints != nullptr) {
+    fingerprints->resize(num_slices_dim0);
+  }
   BlockingCounter* counter =
       new BlockingCounter(num_slices_dim0 * num_slices_dim1);
-  auto work = [counter, transpose](SparseSlice<TL>* sparse_slice,
-                                   SparseMatMul<TL, TR>::ConstMatrixMapL* slice,
-                                   int col_offset) {
+  auto work = [counter, transpose, reuse](
+                  SparseSlice<TL>* sparse_slice,
+                  SparseMatMul<TL, TR>::ConstMatrixMapL* slice, int col_offset,
+                  uint64* fingerprint) {
+    if (reuse) {
+      const uint64 new_fingerprint =
+          FingerprintSlice(*slice, transpose, *sparse_slice, col_offset);
+      if (new_fingerprint == *fingerprint) {
+        delete slice;
+        counter->DecrementCount();
+        return;
+      }
+      *fingerprint = new_fingerprint;
+      sparse_slice->Clear();
+    }
     if (transpose) {
       sparse_slice->template Initialize<true>(*slice, col_offset);
     } else {
       sparse_slice->template Initialize<false>(*slice, col_offset);
     }
+    if (!reuse && fingerprint != nullptr) {
+      // The slice was just read, so this should mostly hit the cache.
+      *fingerprint =
+          FingerprintSlice(*slice, transpose, *sparse_slice, col_offset);
+    }
     delete slice;
     counter->DecrementCount();
   };
   for (int i = 0; i < num_slices_dim0; ++i) {
     (*mat_slices)[i].resize(num_slices_dim1);
+    if (fingerprints != nullptr) {
+      (*fingerprints)[i].resize(num_slices_dim1);
+    }
     int num_rows =
         std::min<int>(slice_num_rows, mat_num_rows - i * slice_num_rows);
     for (int j = 0; j < num_slices_dim1; ++j) {
@@ -1152,15 +1247,40 @@ SparseMatMul<TL, TR>::CreateSparseSlices(
         slice = new SparseMatMul<TL, TR>::ConstMatrixMapL(
             &mat(i * slice_num_rows, 0), d);
       }
-      auto* sparse_slice =
-          new SparseSlice<TL>(num_rows, num_cols, slice_block_size);
-      (*mat_slices)[i][j] = sparse_slice;
-      thread_pool->workers->Schedule(
-          [=]() { work(sparse_slice, slice, slice_num_cols * j); });
+      SparseSlice<TL>* sparse_slice = (*mat_slices)[i][j];
+      if (!reuse) {
+        sparse_slice =
+            new SparseSlice<TL>(num_rows, num_cols, slice_block_size);
+        (*mat_slices)[i][j] = sparse_slice;
+      }
+      uint64* fingerprint =
+          fingerprints != nullptr ? &(*fingerprints)[i][j] : nullptr;
+      thread_pool->workers->Schedule([=]() {
+        work(sparse_slice, slice, slice_num_cols * j, fingerprint);
+      });
     }
   }
   return std::unique_ptr<BlockingCounter>(counter);
 }
+
+template <typename TL, typename TR>
+inline uint64 SparseMatMul<TL, TR>::FingerprintSlice(
+    const typename SparseMatMul<TL, TR>::ConstMatrixMapL& mat, bool transpose,
+    const SparseSlice<TL>& sparse_slice, int col_offset) {
+  // Hash the contiguous runs of the slice in memory: its rows, or the rows of
+  // mat if it is implicitly transposed.
+  uint64 fingerprint = 0;
+  const int num_runs =
+      transpose ? sparse_slice.num_cols : sparse_slice.num_rows;
+  const int run_size =
+      transpose ? sparse_slice.num_rows : sparse_slice.num_cols;
+  for (int i = 0; i < num_runs; ++i) {
+    const TL* run = transpose ? &mat(col_offset + i, 0) : &mat(i, col_offset);
+    fingerprint = Hash64(reinterpret_cast<const char*>(run),
+                         run_size * sizeof(TL), fingerprint);
+  }
+  return fingerprint;
+}
 #define LOAD(x) Eigen::internal::ploadu<Packet>((x));
 #define INTERLEAVE(x) Eigen::internal::pinterleave4x64<Packet>(x);
 #define STORE(x, y) Eigen::internal::pstoreu<float>(x, y);
@@ -1532,7 +1652,7 @@ inline void LibxsmmSparseMatMul<TL, TR>::Compute(
 //    {l_i} and JB elements from {r_j} and compute the IB * JB inner products.
 template <typename TL, typename TR>
 inline void SparseMatMul<TL, TR>::Compute(
-    typename SparseMatMul<TL, TR>::TensorInfoCache* /*cache*/,
+    typename SparseMatMul<TL, TR>::TensorInfoCache* cache,
     const typename SparseMatMul<TL, TR>::ConstMatrixMapL& left,
     const typename SparseMatMul<TL, TR>::ConstMatrixMapR& right,
     bool transpose_left, const DeviceBase::CpuWorkerThreads* thread_pool,
@@ -1541,11 +1661,24 @@ inline void SparseMatMul<TL, TR>::Compute(
   int KR, NR, KL, JB, IB;
   ComputeBlockSizes(left, right, transpose_left, num_threads, &KR, &NR, &KL,
                     &JB, &IB);
-  // Slice the left matrix
-  std::vector<std::vector<SparseSlice<TL>*>> left_slices;
-  std::unique_ptr<BlockingCounter> sparse_slice_counter =
-      CreateSparseSlices(ConstMatrixMapL(left.data(), left.dimensions()),
-                         transpose_left, M, K, KL, &left_slices, thread_pool);
+  // Slice the left matrix, reusing the unchanged slices of the previous call
+  // if there is a cache.
+  std::unique_ptr<typename TensorInfoCache::Entry> left_entry(
+      cache != nullptr ? cache->TakeEntry()
+                       : std::unique_ptr<typename TensorInfoCache::Entry>(
+                             new typename TensorInfoCache::Entry));
+  const bool reuse = left_entry->Matches(left.dimension(0), left.dimension(1),
+                                         transpose_left, KL);
+  if (!reuse) {
+    left_entry->Reset(left.dimension(0), left.dimension(1), transpose_left, KL);
+  }
+  std::vector<std::vector<SparseSlice<TL>*>>& left_slices =
+      left_entry->mat_slices;
+  std::unique_ptr<BlockingCounter> sparse_slice_counter = CreateSparseSlices(
+      ConstMatrixMapL(left.data(), left.dimensions()), transpose_left, M, K,
+      KL, &left_slices,
+      cache != nullptr ? &left_entry->fingerprints : nullptr, reuse,
+      thread_pool);
   const int num_left_slices = left_slices.size();
 
   const int right_dim0 = right.dimension(0);
@@ -1620,8 +1753,12 @@ inline void SparseMatMul<TL, TR>::Compute(
       right_slices.clear();
     }
   }
-  for (auto& left_slice : left_slices) {
-    gtl::STLDeleteElements(&left_slice);
+  if (sparse_slice_counter) {
+    // There were no blocks of right, e.g. it has no columns.
+    sparse_slice_counter->Wait();
+  }
+  if (cache != nullptr) {
+    cache->ReturnEntry(std::move(left_entry));
   }
 }
 
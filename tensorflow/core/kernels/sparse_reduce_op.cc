@@ -214,7 +214,8 @@ class SparseReduceOp : public OpKernel {
 
     // Each group maps one-on-one onto a value in the reduced tensor.
     // g.group() provides the coordinates of a particular reduced value.
-    sp.Reorder<T>(reduction.reorder_dims);
+    sp.Reorder<T>(reduction.reorder_dims,
+                  ctx->device()->tensorflow_cpu_worker_threads());
     for (const auto &g : sp.group(reduction.group_by_dims)) {
       Op::template Run<T>(ctx, reduced_val, g.template values<T>());
       const int64 idx = CoordinatesToFlatIndex(g.group(), output_strides);
@@ -265,7 +266,8 @@ class SparseReduceSparseOp : public OpKernel {
     ReduceDetails reduction = SparseTensorReduceHelper(
         sp, reduction_axes_t->flat<int32>(), keep_dims_);
 
-    sp.Reorder<T>(reduction.reorder_dims);
+    sp.Reorder<T>(reduction.reorder_dims,
+                  ctx->device()->tensorflow_cpu_worker_threads());
     // Count nnzs in the output SparseTensor.
     int64 nnz = 0;
     auto iter = sp.group(reduction.group_by_dims);
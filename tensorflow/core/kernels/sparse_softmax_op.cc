@@ -87,7 +87,8 @@ class SparseSoftmaxOp : public OpKernel {
     const ArraySlice<int64> kReorderDims(dims);
     // All but the last dim -- the class dimension to be max-reduced along.
     const ArraySlice<int64> kGroupByDims(kReorderDims, 0, rank - 1);
-    st.Reorder<T>(kReorderDims);
+    st.Reorder<T>(kReorderDims,
+                  context->device()->tensorflow_cpu_worker_threads());
     int count = 0;
 
     // The SparseTensor has logical shape [..., b, c], where the
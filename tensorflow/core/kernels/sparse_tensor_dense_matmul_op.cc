@@ -19,6 +19,8 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/sparse_tensor_dense_matmul_op.h"
 
+#include <vector>
+
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/kernels/bounds_check.h"
@@ -243,6 +245,9 @@ template <typename T, typename Tindices, bool ADJ_A, bool ADJ_B>
 struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
   // Vectorize certain operations above this size.
   static const std::size_t kNumVectorize = 32;
+  // Shard the product over the rows of the output above this nnz(a) *
+  // output.shape[1].
+  static const std::size_t kMinShardedWork = 1 << 16;
 
   static Status Compute(const CPUDevice& d, typename TTypes<T>::Matrix out,
                         typename TTypes<Tindices>::ConstMatrix a_indices,
@@ -256,9 +261,9 @@ struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
 
     out.setZero();
 
-    // TODO(ebrevdo): After many failed experiments, can't find a multi-threaded
-    // approach that achieves the performance of the single threaded
-    // one.  Perhaps Eigen threadpool implementation is just too slow?
+    if (d.numThreads() > 1 && nnz * rhs_right >= kMinShardedWork) {
+      return ComputeSharded(d, out, a_indices, a_values, b);
+    }
 
     if (rhs_right < kNumVectorize) {
       // Disable vectorization if the RHS of output is too small
@@ -312,6 +317,88 @@ struct SparseTensorDenseMatMulFunctor<CPUDevice, T, Tindices, ADJ_A, ADJ_B> {
     }
     return Status::OK();
   }
+
+ private:
+  // Converts a to compressed sparse rows, keeping the order of the nonzeros
+  // within each row, and computes the rows of the output in parallel. Each
+  // output row accumulates its products in the same order as the sequential
+  // loops above.
+  static Status ComputeSharded(const CPUDevice& d,
+                               typename TTypes<T>::Matrix out,
+                               typename TTypes<Tindices>::ConstMatrix a_indices,
+                               typename TTypes<T>::ConstVec a_values,
+                               typename TTypes<T>::ConstMatrix b) {
+    const std::size_t nnz = a_values.size();
+    const std::size_t rhs_right = (ADJ_B ? b.dimension(0) : b.dimension(1));
+    const std::size_t lhs_right = (ADJ_B ? b.dimension(1) : b.dimension(0));
+    const int lhs_index_a = ADJ_A ? 1 : 0;
+    const int rhs_index_a = ADJ_A ? 0 : 1;
+    const int64 num_rows = out.dimension(0);
+
+    // The indices are copied once, so that later reads can't go out of
+    // bounds if a_indices is modified concurrently.
+    std::vector<Tindices> rows(nnz);
+    std::vector<int64> row_starts(num_rows + 1, 0);
+    for (std::size_t i = 0; i < nnz; ++i) {
+      const Tindices m = internal::SubtleMustCopy(a_indices(i, lhs_index_a));
+      if (!FastBoundsCheck(m, num_rows)) {
+        return MOutOfBoundsError(m, i, lhs_index_a, num_rows);
+      }
+      rows[i] = m;
+      ++row_starts[m + 1];
+    }
+    for (int64 m = 0; m < num_rows; ++m) {
+      row_starts[m + 1] += row_starts[m];
+    }
+    std::vector<Tindices> cols(nnz);
+    std::vector<T> values(nnz);
+    {
+      std::vector<int64> next(row_starts.begin(), row_starts.end() - 1);
+      for (std::size_t i = 0; i < nnz; ++i) {
+        const Tindices k = internal::SubtleMustCopy(a_indices(i, rhs_index_a));
+        if (!FastBoundsCheck(k, lhs_right)) {
+          return KOutOfBoundsError(k, i, rhs_index_a, lhs_right);
+        }
+        const int64 j = next[rows[i]]++;
+        cols[j] = k;
+        values[j] = ADJ_A ? MaybeConj(a_values(i)) : a_values(i);
+      }
+    }
+
+    const double products_per_row =
+        static_cast<double>(nnz) * rhs_right / num_rows;
+    const Eigen::TensorOpCost cost(products_per_row * sizeof(T),
+                                   rhs_right * sizeof(T),
+                                   2 * products_per_row);
+    if (ADJ_B) {
+      // Perform transpose and conjugation on B once, since we chip out B's
+      // columns in the nnz loop.
+      Eigen::array<int, 2> shuffle({1, 0});  // preserve dimension order
+      Eigen::Tensor<T, 2, Eigen::ColMajor> col_major_conj_b =
+          b.swap_layout().shuffle(shuffle).conjugate();
+      ComputeRows(d, cost, row_starts, cols, values, col_major_conj_b, out);
+    } else {
+      ComputeRows(d, cost, row_starts, cols, values, b, out);
+    }
+    return Status::OK();
+  }
+
+  template <typename BMatrix>
+  static void ComputeRows(const CPUDevice& d, const Eigen::TensorOpCost& cost,
+                          const std::vector<int64>& row_starts,
+                          const std::vector<Tindices>& cols,
+                          const std::vector<T>& values, const BMatrix& b_passed,
+                          typename TTypes<T>::Matrix out) {
+    const int b_chip_index = ADJ_B ? 1 : 0;
+    d.parallelFor(out.dimension(0), cost, [&](int64 begin, int64 end) {
+      for (int64 m = begin; m < end; ++m) {
+        for (int64 j = row_starts[m]; j < row_starts[m + 1]; ++j) {
+          out.template chip<0>(m) +=
+              b_passed.template chip<b_chip_index>(cols[j]) * values[j];
+        }
+      }
+    });
+  }
 };
 
 }  // namespace functor
@@ -38,7 +38,7 @@ class Dataset : public DatasetBase {
                  {-1},
                  {sparse_tensor.dims() - 1}}) {}
 
-  std::unique_ptr<IteratorBase> MakeIterator() const override {
+  std::unique_ptr<IteratorBase> MakeIteratorInternal() const override {
     return std::unique_ptr<IteratorBase>(new Iterator(this));
   }
 
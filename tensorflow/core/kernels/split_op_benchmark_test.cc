@@ -0,0 +1,72 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session_options.h"
+
+namespace tensorflow {
+
+// Splits a [kDim0, dim1] float tensor into "num_split" equal pieces along
+// "split_dim", with "num_threads" intra-op threads.
+static void SplitHelper(int iters, int split_dim, int dim1, int num_split,
+                        int num_threads) {
+  testing::StopTiming();
+  Graph* g = new Graph(OpRegistry::Global());
+  const int kDim0 = 512;
+  Tensor split_dim_tensor(DT_INT32, TensorShape({}));
+  split_dim_tensor.scalar<int32>()() = split_dim;
+  Tensor in(DT_FLOAT, TensorShape({kDim0, dim1}));
+  in.flat<float>().setRandom();
+
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "Split")
+                  .Input(test::graph::Constant(g, split_dim_tensor))
+                  .Input(test::graph::Constant(g, in))
+                  .Attr("num_split", num_split)
+                  .Attr("T", DT_FLOAT)
+                  .Finalize(g, &node));
+
+  testing::BytesProcessed(static_cast<int64>(iters) * kDim0 * dim1 *
+                          sizeof(float));
+  SessionOptions options;
+  options.config.set_intra_op_parallelism_threads(num_threads);
+  options.config.set_inter_op_parallelism_threads(1);
+  testing::StartTiming();
+  test::Benchmark("cpu", g, &options).Run(iters);
+  testing::UseRealTime();
+}
+
+#define BM_SPLIT(SPLIT_DIM, NUM_SPLIT, THREADS)                             \
+  static void BM_SplitDim##SPLIT_DIM##_##NUM_SPLIT##_CPU##THREADS(int iters, \
+                                                                  int dim1) { \
+    SplitHelper(iters, SPLIT_DIM, dim1, NUM_SPLIT, THREADS);                 \
+  }                                                                          \
+  BENCHMARK(BM_SplitDim##SPLIT_DIM##_##NUM_SPLIT##_CPU##THREADS)             \
+      ->Arg(256)                                                             \
+      ->Arg(4096)                                                            \
+      ->Arg(65536)
+
+BM_SPLIT(0, 4, 1);
+BM_SPLIT(0, 4, 4);
+BM_SPLIT(1, 4, 1);
+BM_SPLIT(1, 4, 4);
+BM_SPLIT(1, 64, 1);
+BM_SPLIT(1, 64, 4);
+
+}  // end namespace tensorflow
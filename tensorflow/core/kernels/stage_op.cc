@@ -40,6 +40,8 @@ class Buffer : public ResourceBase {
   std::size_t capacity_;
   std::size_t memory_limit_;
   std::size_t current_bytes_;
+  bool closed_;
+  bool cancel_pending_puts_;
   std::mutex mu_;
   std::condition_variable non_empty_cond_var_;
   std::condition_variable full_cond_var_;
@@ -78,12 +80,20 @@ class Buffer : public ResourceBase {
  public:
   // public methods
   explicit Buffer(std::size_t capacity, std::size_t memory_limit)
-      : capacity_(capacity), memory_limit_(memory_limit), current_bytes_(0) {}
+      : capacity_(capacity),
+        memory_limit_(memory_limit),
+        current_bytes_(0),
+        closed_(false),
+        cancel_pending_puts_(false) {}
 
   // the Buffer takes ownership of the Tuple
   Status Put(Tuple* tuple) {
     std::unique_lock<std::mutex> lock(mu_);
 
+    if (closed_) {
+      return errors::Cancelled("Staging Area is closed.");
+    }
+
     std::size_t tuple_bytes = GetTupleBytes(*tuple);
 
     // Sanity check so that we don't block for ever below
@@ -97,6 +107,7 @@ class Buffer : public ResourceBase {
     // If buffer capacity is bounded wait until elements have been removed
     if(IsBounded()) {
       full_cond_var_.wait(lock, [tuple_bytes, this]() {
+        if (cancel_pending_puts_) return true;
         // If there's a memory limit, check if there's space for insertion
         bool memory_limit_valid = memory_limit_ > 0 ?
             !WouldExceedMemoryLimit(tuple_bytes) : true;
@@ -106,6 +117,9 @@ class Buffer : public ResourceBase {
         // Stop waiting upon success for both conditions
         return capacity_valid && memory_limit_valid;
       });
+      if (cancel_pending_puts_) {
+        return errors::Cancelled("Staging Area was closed while inserting.");
+      }
     }
 
     // Update bytes in the Staging Area
@@ -122,12 +136,17 @@ class Buffer : public ResourceBase {
     return Status::OK();
   }
 
-  // Get tuple at front of the buffer
-  void Get(Tuple* tuple) {  // TODO(zhifengc): Support cancellation.
+  // Get tuple at front of the buffer. Fails with OutOfRange once the buffer
+  // is closed and empty.
+  Status Get(Tuple* tuple) {  // TODO(zhifengc): Support cancellation.
     std::unique_lock<std::mutex> lock(mu_);
 
     // Wait for data if the buffer is empty
-    non_empty_cond_var_.wait(lock, [this]() { return !buf_.empty(); });
+    non_empty_cond_var_.wait(lock,
+                             [this]() { return !buf_.empty() || closed_; });
+    if (buf_.empty()) {
+      return errors::OutOfRange("Staging Area is closed and has no elements.");
+    }
 
     // Move data into the output tuple
     *tuple = std::move(buf_.front());
@@ -137,6 +156,7 @@ class Buffer : public ResourceBase {
     current_bytes_ -= GetTupleBytes(*tuple);
 
     notify_inserters_if_bounded(&lock);
+    return Status::OK();
   }
 
   // Return tuple at index
@@ -144,8 +164,13 @@ class Buffer : public ResourceBase {
     std::unique_lock<std::mutex> lock(mu_);
 
     // Wait if the requested index is not available
-    non_empty_cond_var_.wait(
-        lock, [index, this]() { return index < this->buf_.size(); });
+    non_empty_cond_var_.wait(lock, [index, this]() {
+      return index < this->buf_.size() || closed_;
+    });
+    if (index >= buf_.size()) {
+      return errors::OutOfRange("Staging Area is closed and has only ",
+                                buf_.size(), " elements.");
+    }
 
     // Place tensors in the output tuple
     for (const auto& tensor : buf_[index]) {
@@ -169,6 +194,18 @@ class Buffer : public ResourceBase {
     notify_inserters_if_bounded(&lock);
   }
 
+  // Makes puts fail and gets fail once the buffer is empty. If
+  // 'cancel_pending_puts', the puts that wait for space fail too.
+  void Close(bool cancel_pending_puts) {
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      closed_ = true;
+      cancel_pending_puts_ = cancel_pending_puts_ || cancel_pending_puts;
+    }
+    non_empty_cond_var_.notify_all();
+    full_cond_var_.notify_all();
+  }
+
   string DebugString() override {
     std::unique_lock<std::mutex> lock(mu_);
     return strings::StrCat("Staging size: ", buf_.size());
@@ -236,7 +273,7 @@ class UnstageOp : public OpKernel {
     core::ScopedUnref scope(buf);
     Buffer::Tuple tuple;
 
-    buf->Get(&tuple);
+    OP_REQUIRES_OK(ctx, buf->Get(&tuple));
 
     OP_REQUIRES(ctx, tuple.size() == (size_t)ctx->num_outputs(),
         errors::InvalidArgument("Mismatch stage/unstage: ", tuple.size(),
@@ -348,5 +385,31 @@ REGISTER_KERNEL_BUILDER(Name("StageClear").Device(DEVICE_GPU), StageClearOp);
 REGISTER_KERNEL_BUILDER(Name("StageClear").Device(DEVICE_SYCL), StageClearOp);
 #endif // TENSORFLOW_USE_SYCL
 
+class StageCloseOp : public OpKernel {
+ public:
+  explicit StageCloseOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("cancel_pending_enqueues",
+                                     &cancel_pending_enqueues_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    Buffer* buf = nullptr;
+    OP_REQUIRES_OK(ctx, GetBuffer(ctx, def(), &buf));
+    core::ScopedUnref scope(buf);
+
+    buf->Close(cancel_pending_enqueues_);
+  }
+
+ private:
+  bool cancel_pending_enqueues_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("StageClose").Device(DEVICE_CPU), StageCloseOp);
+#if GOOGLE_CUDA
+REGISTER_KERNEL_BUILDER(Name("StageClose").Device(DEVICE_GPU), StageCloseOp);
+#endif
+#ifdef TENSORFLOW_USE_SYCL
+REGISTER_KERNEL_BUILDER(Name("StageClose").Device(DEVICE_SYCL), StageCloseOp);
+#endif // TENSORFLOW_USE_SYCL
 
 }  // namespace tensorflow
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_KERNELS_STRING_TO_HASH_BUCKET_OP_H_
 #define TENSORFLOW_CORE_KERNELS_STRING_TO_HASH_BUCKET_OP_H_
 
+#include <algorithm>
 #include <string>
 
 #include "tensorflow/core/framework/op_kernel.h"
@@ -23,6 +24,7 @@ limitations under the License.
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/util/batch_hash.h"
 
 namespace tensorflow {
 
@@ -44,14 +46,18 @@ class StringToHashBucketOp : public OpKernel {
                                             &output_tensor));
     auto output_flat = output_tensor->flat<int64>();
 
-    typedef decltype(input_flat.size()) Index;
-    for (Index i = 0; i < input_flat.size(); ++i) {
-      const uint64 input_hash = hash(input_flat(i));
-      const uint64 bucket_id = input_hash % num_buckets_;
-      // The number of buckets is always in the positive range of int64 so is
-      // the resulting bucket_id. Casting the bucket_id from uint64 to int64 is
-      // safe.
-      output_flat(i) = static_cast<int64>(bucket_id);
+    const int64 size = input_flat.size();
+    uint64 input_hashes[kHashBatchSize];
+    for (int64 begin = 0; begin < size; begin += kHashBatchSize) {
+      const int64 batch_size = std::min(kHashBatchSize, size - begin);
+      HashStrings<hash>(input_flat.data() + begin, batch_size, input_hashes);
+      for (int64 i = 0; i < batch_size; ++i) {
+        const uint64 bucket_id = input_hashes[i] % num_buckets_;
+        // The number of buckets is always in the positive range of int64 so
+        // is the resulting bucket_id. Casting the bucket_id from uint64 to
+        // int64 is safe.
+        output_flat(begin + i) = static_cast<int64>(bucket_id);
+      }
     }
   }
 
@@ -329,10 +329,26 @@ class TensorArray : public ResourceBase {
   // to the rhs to access its mutex.
   Status CopyShapesFrom(TensorArray* rhs);
 
+  // Records that the elements just written by an unpack, scatter or split
+  // are slices of 'backing', so that pack, gather and concat can return
+  // views of it when they read those elements back in order.
+  void SetBacking(const Tensor& backing) {
+    mutex_lock l(mu_);
+    backing_ = backing;
+  }
+
+  // Returns the tensor recorded by SetBacking(), if it may still back some
+  // elements, and an uninitialized Tensor otherwise.
+  Tensor Backing() {
+    mutex_lock l(mu_);
+    return backing_;
+  }
+
   // Clear the TensorArray, including any Tensor references, and mark as closed.
   void ClearAndMarkClosed() {
     mutex_lock l(mu_);
     tensors_.clear();
+    backing_ = Tensor();
     closed_ = true;
   }
 
@@ -423,6 +439,11 @@ class TensorArray : public ResourceBase {
   };
   // The list of underlying PersistentTensors and states.
   std::vector<TensorAndState> tensors_ GUARDED_BY(mu_);
+
+  // The tensor that the elements written by the last unpack, scatter or
+  // split are slices of, if they are. Elements are checked to still point
+  // into it before a view of it replaces them.
+  Tensor backing_ GUARDED_BY(mu_);
 };
 
 template <typename Device, typename T>
@@ -568,6 +589,9 @@ Status TensorArray::LockedRead(OpKernelContext* ctx, const int32 index,
   if (clear_after_read_) {
     t.tensor = PersistentTensor();
     t.cleared = true;
+    // The elements can't all be read back anymore, so don't keep the whole
+    // backing tensor alive for them.
+    backing_ = Tensor();
   }
   t.read = true;
   return Status::OK();
@@ -95,6 +95,59 @@ Status SetupFlowControlInputs(OpKernelContext* ctx, bool set_output) {
   return Status::OK();
 }
 
+// Returns true if 'value' has elements and its slices [start, limit) along
+// dimension 0 are aligned for every consecutive pair of 'boundaries'.
+bool SlicesAreAligned(const Tensor& value,
+                      const std::vector<int64>& boundaries) {
+  if (value.NumElements() == 0) return false;
+  for (size_t i = 1; i < boundaries.size(); ++i) {
+    if (!value.Slice(boundaries[i - 1], boundaries[i]).IsAligned()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Sets *output to the part of 'backing' that the non-empty 'values' cover,
+// with shape 'output_shape', if they are consecutive whole-row slices of it
+// in order and that part is aligned. Returns false otherwise.
+template <typename T>
+bool ViewOfBacking(const Tensor& backing,
+                   const std::vector<const Tensor*>& values,
+                   const TensorShape& output_shape, Tensor* output) {
+  if (!backing.IsInitialized() ||
+      backing.dtype() != DataTypeToEnum<T>::v() || backing.dims() == 0 ||
+      backing.NumElements() == 0 || output_shape.num_elements() == 0) {
+    return false;
+  }
+  const int64 row_elements = backing.NumElements() / backing.dim_size(0);
+  const uintptr_t begin =
+      reinterpret_cast<uintptr_t>(backing.unaligned_flat<T>().data());
+  const uintptr_t end = begin + backing.NumElements() * sizeof(T);
+
+  uintptr_t first = 0;
+  uintptr_t next = 0;
+  for (const Tensor* value : values) {
+    if (value->NumElements() == 0) continue;
+    const uintptr_t data =
+        reinterpret_cast<uintptr_t>(value->unaligned_flat<T>().data());
+    if (first == 0) {
+      if (data < begin || data >= end) return false;
+      first = next = data;
+    }
+    if (data != next) return false;
+    next += value->NumElements() * sizeof(T);
+    if (next > end) return false;
+  }
+  const int64 row_bytes = row_elements * sizeof(T);
+  if ((first - begin) % row_bytes != 0 || (next - begin) % row_bytes != 0) {
+    return false;
+  }
+  const Tensor view =
+      backing.Slice((first - begin) / row_bytes, (next - begin) / row_bytes);
+  return view.IsAligned() && output->CopyFrom(view, output_shape);
+}
+
 // CREATION *******************************************************************
 
 // Virtual class for shared behavior between TensorArrayOp and
@@ -629,6 +682,27 @@ class TensorArrayPackOrGatherOp : public OpKernel {
     TensorShape output_shape(value_0_t->shape());
     output_shape.InsertDim(0, num_indices);
 
+    std::vector<const Tensor*> value_tensors(num_indices);
+    value_tensors[0] = value_0_t;
+    for (int i = 1; i < num_indices; ++i) {
+      value_tensors[i] = values[i].AccessTensor(ctx);
+      OP_REQUIRES(
+          ctx, value_0_t->shape() == value_tensors[i]->shape(),
+          errors::InvalidArgument(
+              "TensorArray has inconsistent shapes.  Index 0 has shape: ",
+              value_0_t->shape().DebugString(), " but index ", i,
+              " has shape: ", value_tensors[i]->shape().DebugString()));
+    }
+
+    // Elements unpacked or scattered from one tensor and read back in order
+    // are returned without a copy.
+    Tensor view;
+    if (ViewOfBacking<T>(tensor_array->Backing(), value_tensors, output_shape,
+                         &view)) {
+      ctx->set_output(0, view);
+      return;
+    }
+
     Tensor* output_tensor = nullptr;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(0, output_shape, &output_tensor));
 
@@ -642,18 +716,7 @@ class TensorArrayPackOrGatherOp : public OpKernel {
     auto output_flat =
         output_tensor->shaped<T, 2>({1, output_shape.num_elements()});
 
-    // Insert the first value
-    input_tensors_flat.emplace_back(new ConstMatrix(
-        value_0_t->shaped<T, 2>({1, value_0_t->NumElements()})));
-
-    for (int i = 1; i < num_indices; ++i) {
-      const Tensor* value_t = values[i].AccessTensor(ctx);
-      OP_REQUIRES(
-          ctx, value_0_t->shape() == value_t->shape(),
-          errors::InvalidArgument(
-              "TensorArray has inconsistent shapes.  Index 0 has shape: ",
-              value_0_t->shape().DebugString(), " but index ", i,
-              " has shape: ", value_t->shape().DebugString()));
+    for (const Tensor* value_t : value_tensors) {
       input_tensors_flat.emplace_back(
           new ConstMatrix(value_t->shaped<T, 2>({1, value_t->NumElements()})));
     }
@@ -875,6 +938,15 @@ class TensorArrayConcatOp : public OpKernel {
       }
     }
 
+    // Elements split from one tensor and read back in order are returned
+    // without a copy.
+    Tensor view;
+    if (ViewOfBacking<T>(tensor_array->Backing(), value_tensors, output_shape,
+                         &view)) {
+      ctx->set_output(0, view);
+      return;
+    }
+
     Tensor* output_tensor = nullptr;
     OP_REQUIRES_OK(ctx, ctx->allocate_output(0, output_shape, &output_tensor));
     ConstMatrixVector input_tensors_flat;
@@ -1084,9 +1156,23 @@ class TensorArrayUnpackOrScatterOp : public OpKernel {
     std::vector<PersistentTensor> write_values;
     write_values.reserve(num_values);
 
+    // If they are aligned, the elements are slices of the value rather than
+    // copies, and reading them back in order needs no copy either.
+    std::vector<int64> boundaries(num_values + 1);
+    std::iota(boundaries.begin(), boundaries.end(), 0);
+    const bool use_slices = SlicesAreAligned(*tensor_value, boundaries);
+
     for (int i = 0; i < num_values; ++i) {
-      Tensor* tensor_value_i;
       PersistentTensor persistent_tensor;
+      if (use_slices) {
+        Tensor slice;
+        CHECK(slice.CopyFrom(tensor_value->Slice(i, i + 1), element_shape));
+        persistent_tensor = PersistentTensor(slice);
+        write_values.push_back(persistent_tensor);
+        continue;
+      }
+
+      Tensor* tensor_value_i;
       OP_REQUIRES_OK(
           ctx, ctx->allocate_persistent(tensor_array->ElemType(), element_shape,
                                         &persistent_tensor, &tensor_value_i));
@@ -1111,6 +1197,7 @@ class TensorArrayUnpackOrScatterOp : public OpKernel {
     Status s = tensor_array->WriteOrAggregateMany<Device, T>(ctx, write_indices,
                                                              &write_values);
     OP_REQUIRES_OK(ctx, s);
+    if (use_slices) tensor_array->SetBacking(*tensor_value);
   }
 };
 
@@ -1268,11 +1355,25 @@ class TensorArraySplitOp : public OpKernel {
     std::vector<PersistentTensor> write_values;
     write_values.reserve(array_size);
 
+    // If they are aligned, the elements are slices of the value rather than
+    // copies, and concatenating them back in order needs no copy either.
+    std::vector<int64> boundaries(1, 0);
+    boundaries.insert(boundaries.end(), cumulative_lengths.begin(),
+                      cumulative_lengths.end());
+    const bool use_slices = SlicesAreAligned(*tensor_value, boundaries);
+
     for (int i = 0; i < array_size; ++i) {
       Tensor* tensor_value_i;
       PersistentTensor persistent_tensor;
 
       int64 previous_length = (i == 0) ? 0 : cumulative_lengths[i - 1];
+      if (use_slices) {
+        persistent_tensor = PersistentTensor(
+            tensor_value->Slice(previous_length, cumulative_lengths[i]));
+        write_values.push_back(persistent_tensor);
+        continue;
+      }
+
       Eigen::DSizes<Eigen::DenseIndex, 3> indices{0, previous_length, 0};
       Eigen::DSizes<Eigen::DenseIndex, 3> sizes{1, tensor_lengths_t(i),
                                                 elements_per_row};
@@ -1302,6 +1403,7 @@ class TensorArraySplitOp : public OpKernel {
     Status s = tensor_array->WriteOrAggregateMany<Device, T>(ctx, indices,
                                                              &write_values);
     OP_REQUIRES_OK(ctx, s);
+    if (use_slices) tensor_array->SetBacking(*tensor_value);
   }
 };
 
@@ -27,20 +27,17 @@ namespace tensorflow {
 
 class TFRecordReader : public ReaderBase {
  public:
-  TFRecordReader(const string& node_name, const string& compression_type,
-                 Env* env)
+  TFRecordReader(const string& node_name,
+                 const io::RecordReaderOptions& options, Env* env)
       : ReaderBase(strings::StrCat("TFRecordReader '", node_name, "'")),
         env_(env),
         offset_(0),
-        compression_type_(compression_type) {}
+        options_(options) {}
 
   Status OnWorkStartedLocked() override {
     offset_ = 0;
     TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(current_work(), &file_));
-
-    io::RecordReaderOptions options =
-        io::RecordReaderOptions::CreateRecordReaderOptions(compression_type_);
-    reader_.reset(new io::RecordReader(file_.get(), options));
+    reader_.reset(new io::RecordReader(file_.get(), options_));
     return Status::OK();
   }
 
@@ -77,7 +74,7 @@ class TFRecordReader : public ReaderBase {
   uint64 offset_;
   std::unique_ptr<RandomAccessFile> file_;
   std::unique_ptr<io::RecordReader> reader_;
-  string compression_type_ = "";
+  const io::RecordReaderOptions options_;
 };
 
 class TFRecordReaderOp : public ReaderOpKernel {
@@ -89,9 +86,20 @@ class TFRecordReaderOp : public ReaderOpKernel {
     string compression_type;
     OP_REQUIRES_OK(context,
                    context->GetAttr("compression_type", &compression_type));
+    int64 buffer_size;
+    OP_REQUIRES_OK(context, context->GetAttr("buffer_size", &buffer_size));
+    bool verify_checksums;
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("verify_checksums", &verify_checksums));
+
+    io::RecordReaderOptions options =
+        io::RecordReaderOptions::CreateRecordReaderOptions(compression_type);
+    options.buffer_size = buffer_size;
+    options.read_ahead = buffer_size > 0;
+    options.verify_checksums = verify_checksums;
 
-    SetReaderFactory([this, compression_type, env]() {
-      return new TFRecordReader(name(), compression_type, env);
+    SetReaderFactory([this, options, env]() {
+      return new TFRecordReader(name(), options, env);
     });
   }
 };
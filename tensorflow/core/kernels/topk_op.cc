@@ -17,6 +17,8 @@ limitations under the License.
 
 #define EIGEN_USE_THREADS
 
+#include "tensorflow/core/kernels/topk_op.h"
+
 #include <algorithm>
 #include <numeric>
 #include <vector>
@@ -33,56 +35,15 @@ namespace tensorflow {
 typedef Eigen::ThreadPoolDevice CPUDevice;
 typedef Eigen::GpuDevice GPUDevice;
 
-template <typename T>
-class TopK : public OpKernel {
- public:
-  explicit TopK(OpKernelConstruction* context) : OpKernel(context) {
-    OP_REQUIRES_OK(context, context->GetAttr("sorted", &sorted_));
-    if (num_inputs() < 2) {  // k is an attr (TopK).
-      OP_REQUIRES_OK(context, context->GetAttr("k", &k_));
-    } else {  // k is an input (TopKV2), so we won't know it until Compute.
-      k_ = -1;
-    }
-  }
-
-  void Compute(OpKernelContext* context) override {
-    int k = k_;
-    if (num_inputs() >= 2) {
-      const auto& k_in = context->input(1);
-      OP_REQUIRES(context, TensorShapeUtils::IsScalar(k_in.shape()),
-                  errors::InvalidArgument("k must be scalar, got shape ",
-                                          k_in.shape().DebugString()));
-      k = k_in.scalar<int32>()();
-    }
-    OP_REQUIRES(context, k >= 0,
-                errors::InvalidArgument("Need k >= 0, got ", k));
-    const auto& input_in = context->input(0);
-    OP_REQUIRES(context, input_in.dims() >= 1,
-                errors::InvalidArgument("input must be >= 1-D, got shape ",
-                                        input_in.shape().DebugString()));
-    OP_REQUIRES(context, input_in.dim_size(input_in.dims() - 1) >= k,
-                errors::InvalidArgument("input must have at least k columns"));
-
-    const auto& input = input_in.flat_inner_dims<T>();
-
-    const int64 num_rows = input.dimension(0);  // generally batch_size
-    const int64 num_cols = input.dimension(1);
-
-    TensorShape output_shape = input_in.shape();
-    output_shape.set_dim(input_in.dims() - 1, k);
-    Tensor* values_out = nullptr;
-    OP_REQUIRES_OK(context,
-                   context->allocate_output(0, output_shape, &values_out));
-    Tensor* indices_out = nullptr;
-    OP_REQUIRES_OK(context,
-                   context->allocate_output(1, output_shape, &indices_out));
-
-    // Nothing to do for top-nothing.
-    if (k == 0) return;
-
-    auto values = values_out->flat_inner_dims<T>();
-    auto indices = indices_out->flat_inner_dims<int32>();
+namespace functor {
 
+template <typename T>
+struct TopKFunctor<CPUDevice, T> {
+  static EIGEN_ALWAYS_INLINE Status
+  Compute(OpKernelContext* context, bool sorted, int k,
+          const typename TTypes<T, 2>::ConstTensor& input, const int64 num_rows,
+          const int64 num_cols, typename TTypes<T, 2>::Tensor values,
+          typename TTypes<int, 2>::Tensor indices) {
     const CPUDevice& d = context->eigen_device<CPUDevice>();
 
     // Special case for k == 1.
@@ -108,7 +69,7 @@ class TopK : public OpKernel {
         }
       }
 
-      return;
+      return Status::OK();
     }
 
     auto SortIndices = [&, context](int start_batch, int limit_batch) {
@@ -136,7 +97,7 @@ class TopK : public OpKernel {
           }
 
           int32 i = 0;
-          if (sorted_) {
+          if (sorted) {
             std::unique_ptr<std::vector<int32>> top_k(filter.Extract());
             for (auto top_k_it = top_k->begin(); top_k_it != top_k->end();
                  ++top_k_it, ++i) {
@@ -170,6 +131,64 @@ class TopK : public OpKernel {
     auto worker_threads = *(context->device()->tensorflow_cpu_worker_threads());
     Shard(worker_threads.num_threads, worker_threads.workers, num_rows,
           total_cost, SortIndices);
+    return Status::OK();
+  }
+};
+
+}  // namespace functor
+
+template <typename Device, typename T>
+class TopK : public OpKernel {
+ public:
+  explicit TopK(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("sorted", &sorted_));
+    if (num_inputs() < 2) {  // k is an attr (TopK).
+      OP_REQUIRES_OK(context, context->GetAttr("k", &k_));
+    } else {  // k is an input (TopKV2), so we won't know it until Compute.
+      k_ = -1;
+    }
+  }
+
+  void Compute(OpKernelContext* context) override {
+    int k = k_;
+    if (num_inputs() >= 2) {
+      const auto& k_in = context->input(1);
+      OP_REQUIRES(context, TensorShapeUtils::IsScalar(k_in.shape()),
+                  errors::InvalidArgument("k must be scalar, got shape ",
+                                          k_in.shape().DebugString()));
+      k = k_in.scalar<int32>()();
+    }
+    OP_REQUIRES(context, k >= 0,
+                errors::InvalidArgument("Need k >= 0, got ", k));
+    const auto& input_in = context->input(0);
+    OP_REQUIRES(context, input_in.dims() >= 1,
+                errors::InvalidArgument("input must be >= 1-D, got shape ",
+                                        input_in.shape().DebugString()));
+    OP_REQUIRES(context, input_in.dim_size(input_in.dims() - 1) >= k,
+                errors::InvalidArgument("input must have at least k columns"));
+
+    const auto& input = input_in.flat_inner_dims<T>();
+
+    const int64 num_rows = input.dimension(0);  // generally batch_size
+    const int64 num_cols = input.dimension(1);
+
+    TensorShape output_shape = input_in.shape();
+    output_shape.set_dim(input_in.dims() - 1, k);
+    Tensor* values_out = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, output_shape, &values_out));
+    Tensor* indices_out = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(1, output_shape, &indices_out));
+
+    // Nothing to do for top-nothing.
+    if (k == 0) return;
+
+    auto values = values_out->flat_inner_dims<T>();
+    auto indices = indices_out->flat_inner_dims<int32>();
+    Status s = functor::TopKFunctor<Device, T>::Compute(
+        context, sorted_, k, input, num_rows, num_cols, values, indices);
+    OP_REQUIRES_OK(context, s);
   }
 
  private:
@@ -177,16 +196,55 @@ class TopK : public OpKernel {
   bool sorted_;
 };
 
-#define REGISTER_KERNELS_NAME(name, type) \
-  REGISTER_KERNEL_BUILDER(                \
-      Name(#name).Device(DEVICE_CPU).TypeConstraint<type>("T"), TopK<type>)
+#define REGISTER_KERNELS_NAME(name, type)                       \
+  REGISTER_KERNEL_BUILDER(                                      \
+      Name(#name).Device(DEVICE_CPU).TypeConstraint<type>("T"), \
+      TopK<CPUDevice, type>)
 
 #define REGISTER_KERNELS(type)       \
   REGISTER_KERNELS_NAME(TopK, type); \
   REGISTER_KERNELS_NAME(TopKV2, type)
 
 TF_CALL_REAL_NUMBER_TYPES(REGISTER_KERNELS);
-#undef REGISTER_KERNELS_TO_NAME
+#undef REGISTER_KERNELS_NAME
 #undef REGISTER_KERNELS
 
+#if GOOGLE_CUDA
+
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                                  \
+  template <>                                                                \
+  Status TopKFunctor<GPUDevice, T>::Compute(                                 \
+      OpKernelContext* context, bool sorted, int k,                          \
+      const typename TTypes<T, 2>::ConstTensor& input, const int64 num_rows, \
+      const int64 num_cols, typename TTypes<T, 2>::Tensor values,            \
+      typename TTypes<int, 2>::Tensor indices);                              \
+  extern template struct TopKFunctor<GPUDevice, T>;
+
+TF_CALL_GPU_NUMBER_TYPES(DECLARE_GPU_SPEC);
+TF_CALL_int32(DECLARE_GPU_SPEC);
+TF_CALL_int64(DECLARE_GPU_SPEC);
+
+#undef DECLARE_GPU_SPEC
+
+}  // namespace functor
+
+#define REGISTER_KERNELS(type)                                   \
+  REGISTER_KERNEL_BUILDER(                                       \
+      Name("TopK").Device(DEVICE_GPU).TypeConstraint<type>("T"), \
+      TopK<GPUDevice, type>)                                     \
+  REGISTER_KERNEL_BUILDER(Name("TopKV2")                         \
+                              .Device(DEVICE_GPU)                \
+                              .TypeConstraint<type>("T")         \
+                              .HostMemory("k"),                  \
+                          TopK<GPUDevice, type>)
+
+TF_CALL_GPU_NUMBER_TYPES(REGISTER_KERNELS);
+TF_CALL_int32(REGISTER_KERNELS);
+TF_CALL_int64(REGISTER_KERNELS);
+#undef REGISTER_KERNELS
+
+#endif  // GOOGLE_CUDA
+
 }  // namespace tensorflow
@@ -0,0 +1,356 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA
+
+#define EIGEN_USE_GPU
+
+#include "tensorflow/core/kernels/topk_op.h"
+
+#include <limits>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/util/cuda_kernel_helper.h"
+
+namespace tensorflow {
+
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace {
+
+// Maps the values of T to unsigned keys with the same order, so that values
+// can be compared as keys, and selected one radix digit at a time.
+template <typename T>
+struct RadixKey;
+
+template <>
+struct RadixKey<float> {
+  typedef uint32 Type;
+  __device__ static Type Get(float value) {
+    const uint32 bits = __float_as_uint(value);
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+  }
+};
+
+template <>
+struct RadixKey<double> {
+  typedef uint64 Type;
+  __device__ static Type Get(double value) {
+    const uint64 bits = static_cast<uint64>(__double_as_longlong(value));
+    return (bits & 0x8000000000000000ull) ? ~bits
+                                          : (bits | 0x8000000000000000ull);
+  }
+};
+
+template <>
+struct RadixKey<Eigen::half> {
+  typedef uint16 Type;
+  __device__ static Type Get(Eigen::half value) {
+    const uint16 bits = value.x;
+    return (bits & 0x8000u) ? static_cast<uint16>(~bits)
+                            : static_cast<uint16>(bits | 0x8000u);
+  }
+};
+
+template <>
+struct RadixKey<int32> {
+  typedef uint32 Type;
+  __device__ static Type Get(int32 value) {
+    return static_cast<uint32>(value) ^ 0x80000000u;
+  }
+};
+
+template <>
+struct RadixKey<int64> {
+  typedef uint64 Type;
+  __device__ static Type Get(int64 value) {
+    return static_cast<uint64>(value) ^ 0x8000000000000000ull;
+  }
+};
+
+// Returns true if the element (key_a, index_a) comes before (key_b, index_b)
+// in the output: larger values first, then lower indices.  Negative indices
+// mark missing elements, which come last.
+template <typename Key>
+__device__ inline bool ComesBefore(Key key_a, int32 index_a, Key key_b,
+                                   int32 index_b) {
+  if (index_a < 0) return false;
+  if (index_b < 0) return true;
+  if (key_a != key_b) return key_a > key_b;
+  return index_a < index_b;
+}
+
+// For small k, every thread of the block of a row keeps the k largest of the
+// elements it reads, sorted in shared memory, and the block then merges the
+// lists of its threads one output at a time.
+const int kMaxHeapK = 16;
+const int kHeapBlockSize = 128;
+
+template <typename T>
+__global__ void __launch_bounds__(kHeapBlockSize)
+    TopKSmallKernel(const T* input, int num_cols, int k, T* values,
+                    int32* indices) {
+  typedef typename RadixKey<T>::Type Key;
+  __shared__ Key keys[kHeapBlockSize * kMaxHeapK];
+  __shared__ int32 positions[kHeapBlockSize * kMaxHeapK];
+  __shared__ Key best_keys[kHeapBlockSize];
+  __shared__ int32 best_positions[kHeapBlockSize];
+  __shared__ int32 best_threads[kHeapBlockSize];
+
+  const int tid = threadIdx.x;
+  const T* row_input = input + static_cast<int64>(blockIdx.x) * num_cols;
+  Key* thread_keys = keys + tid * kMaxHeapK;
+  int32* thread_positions = positions + tid * kMaxHeapK;
+
+  // The elements are read in increasing order of index, so an element only
+  // replaces a smaller one, to keep the lowest indices of equal values.
+  int size = 0;
+  for (int c = tid; c < num_cols; c += kHeapBlockSize) {
+    const Key key = RadixKey<T>::Get(row_input[c]);
+    if (size < k || key > thread_keys[size - 1]) {
+      int i = size < k ? size++ : k - 1;
+      while (i > 0 && thread_keys[i - 1] < key) {
+        thread_keys[i] = thread_keys[i - 1];
+        thread_positions[i] = thread_positions[i - 1];
+        --i;
+      }
+      thread_keys[i] = key;
+      thread_positions[i] = c;
+    }
+  }
+
+  T* row_values = values + static_cast<int64>(blockIdx.x) * k;
+  int32* row_indices = indices + static_cast<int64>(blockIdx.x) * k;
+  int head = 0;
+  for (int out = 0; out < k; ++out) {
+    best_keys[tid] = head < size ? thread_keys[head] : Key(0);
+    best_positions[tid] = head < size ? thread_positions[head] : -1;
+    best_threads[tid] = tid;
+    __syncthreads();
+    for (int stride = kHeapBlockSize / 2; stride > 0; stride /= 2) {
+      if (tid < stride &&
+          ComesBefore(best_keys[tid + stride], best_positions[tid + stride],
+                      best_keys[tid], best_positions[tid])) {
+        best_keys[tid] = best_keys[tid + stride];
+        best_positions[tid] = best_positions[tid + stride];
+        best_threads[tid] = best_threads[tid + stride];
+      }
+      __syncthreads();
+    }
+    if (tid == 0) {
+      row_values[out] = row_input[best_positions[0]];
+      row_indices[out] = best_positions[0];
+    }
+    if (tid == best_threads[0]) {
+      ++head;
+    }
+    __syncthreads();
+  }
+}
+
+// Returns the exclusive prefix sum of `value` over the threads of the block,
+// and stores the total in `*total`.  `scratch` holds one int32 per thread.
+__device__ inline int32 BlockExclusiveSum(int32 value, int32* scratch,
+                                          int32* total) {
+  const int tid = threadIdx.x;
+  scratch[tid] = value;
+  __syncthreads();
+  for (int offset = 1; offset < blockDim.x; offset *= 2) {
+    const int32 other = tid >= offset ? scratch[tid - offset] : 0;
+    __syncthreads();
+    scratch[tid] += other;
+    __syncthreads();
+  }
+  const int32 inclusive = scratch[tid];
+  *total = scratch[blockDim.x - 1];
+  __syncthreads();
+  return inclusive - value;
+}
+
+// For large k, the block of a row finds the k-th largest value with a radix
+// select over the keys of the row, 8 bits at a time, and then writes the
+// larger values and as many of the equal ones as needed, in index order.  If
+// `sorted`, the selected elements are then sorted with a bitonic sort.
+const int kRadixBlockSize = 256;
+const int kRadixBits = 8;
+const int kRadixSize = 1 << kRadixBits;
+
+template <typename T>
+__global__ void __launch_bounds__(kRadixBlockSize)
+    TopKLargeKernel(const T* input, int num_cols, int k, bool sorted,
+                    T* values, int32* indices) {
+  typedef typename RadixKey<T>::Type Key;
+  __shared__ int32 histogram[kRadixSize];
+  __shared__ Key shared_prefix;
+  __shared__ int32 shared_remaining;
+  __shared__ int32 scratch[kRadixBlockSize];
+
+  const int tid = threadIdx.x;
+  const T* row_input = input + static_cast<int64>(blockIdx.x) * num_cols;
+  T* row_values = values + static_cast<int64>(blockIdx.x) * k;
+  int32* row_indices = indices + static_cast<int64>(blockIdx.x) * k;
+
+  // Find the key of the k-th largest value, and how many of the elements
+  // with that key are in the top k.
+  Key prefix = 0;
+  Key prefix_mask = 0;
+  int32 remaining = k;
+  for (int shift = sizeof(Key) * 8 - kRadixBits; shift >= 0;
+       shift -= kRadixBits) {
+    for (int i = tid; i < kRadixSize; i += kRadixBlockSize) {
+      histogram[i] = 0;
+    }
+    __syncthreads();
+    for (int c = tid; c < num_cols; c += kRadixBlockSize) {
+      const Key key = RadixKey<T>::Get(row_input[c]);
+      if ((key & prefix_mask) == prefix) {
+        atomicAdd(&histogram[(key >> shift) & (kRadixSize - 1)], 1);
+      }
+    }
+    __syncthreads();
+    if (tid == 0) {
+      int32 count = 0;
+      int digit = kRadixSize - 1;
+      for (; digit > 0; --digit) {
+        if (count + histogram[digit] >= remaining) break;
+        count += histogram[digit];
+      }
+      shared_prefix = prefix | (static_cast<Key>(digit) << shift);
+      shared_remaining = remaining - count;
+    }
+    __syncthreads();
+    prefix = shared_prefix;
+    remaining = shared_remaining;
+    prefix_mask |= static_cast<Key>(kRadixSize - 1) << shift;
+  }
+  const Key kth_key = prefix;
+
+  // Write the selected elements in index order.
+  int32 num_written = 0;
+  int32 num_equal_seen = 0;
+  for (int base = 0; base < num_cols && num_written < k;
+       base += kRadixBlockSize) {
+    const int c = base + tid;
+    Key key = 0;
+    if (c < num_cols) key = RadixKey<T>::Get(row_input[c]);
+    const bool is_greater = c < num_cols && key > kth_key;
+    const bool is_equal = c < num_cols && key == kth_key;
+    int32 num_equal;
+    const int32 equal_rank =
+        BlockExclusiveSum(is_equal ? 1 : 0, scratch, &num_equal);
+    const bool is_selected =
+        is_greater || (is_equal && num_equal_seen + equal_rank < remaining);
+    int32 num_selected;
+    const int32 position =
+        BlockExclusiveSum(is_selected ? 1 : 0, scratch, &num_selected);
+    if (is_selected) {
+      row_values[num_written + position] = row_input[c];
+      row_indices[num_written + position] = c;
+    }
+    num_written += num_selected;
+    num_equal_seen += num_equal;
+  }
+  if (!sorted) return;
+  __syncthreads();
+
+  // Bitonic sort of the k selected elements in place, larger values first.
+  // Every compare and swap moves the element that comes first to the lower
+  // position, so positions past k can be treated as missing elements.
+  int size = 1;
+  while (size < k) size *= 2;
+  for (int block_size = 2; block_size <= size; block_size *= 2) {
+    for (int stride = block_size / 2; stride > 0; stride /= 2) {
+      for (int i = tid; i < size; i += kRadixBlockSize) {
+        // On the first step of a block, elements are compared with their
+        // mirror in the block, and then with the element `stride` away.
+        const int j = stride == block_size / 2 ? i ^ (block_size - 1)
+                                               : i ^ stride;
+        if (j > i && j < k) {
+          const Key key_i = RadixKey<T>::Get(row_values[i]);
+          const Key key_j = RadixKey<T>::Get(row_values[j]);
+          if (ComesBefore(key_j, row_indices[j], key_i, row_indices[i])) {
+            const T value = row_values[i];
+            row_values[i] = row_values[j];
+            row_values[j] = value;
+            const int32 index = row_indices[i];
+            row_indices[i] = row_indices[j];
+            row_indices[j] = index;
+          }
+        }
+      }
+      __syncthreads();
+    }
+  }
+}
+
+}  // namespace
+
+namespace functor {
+
+template <typename T>
+Status LaunchTopK(OpKernelContext* context, bool sorted, int k,
+                  const typename TTypes<T, 2>::ConstTensor& input,
+                  const int64 num_rows, const int64 num_cols,
+                  typename TTypes<T, 2>::Tensor values,
+                  typename TTypes<int, 2>::Tensor indices) {
+  if (num_cols > std::numeric_limits<int32>::max()) {
+    return errors::InvalidArgument("TopK on GPU supports at most ",
+                                   std::numeric_limits<int32>::max(),
+                                   " columns, got ", num_cols);
+  }
+  if (num_rows == 0) return Status::OK();
+  const GPUDevice& d = context->eigen_device<GPUDevice>();
+  if (k <= kMaxHeapK) {
+    TopKSmallKernel<T><<<num_rows, kHeapBlockSize, 0, d.stream()>>>(
+        input.data(), static_cast<int>(num_cols), k, values.data(),
+        indices.data());
+  } else {
+    TopKLargeKernel<T><<<num_rows, kRadixBlockSize, 0, d.stream()>>>(
+        input.data(), static_cast<int>(num_cols), k, sorted, values.data(),
+        indices.data());
+  }
+  const cudaError_t err = cudaGetLastError();
+  if (err != cudaSuccess) {
+    return errors::Internal("Could not launch TopK kernel: ",
+                            cudaGetErrorString(err));
+  }
+  return Status::OK();
+}
+
+#define DEFINE_GPU_SPEC(T)                                                   \
+  template <>                                                                \
+  Status TopKFunctor<GPUDevice, T>::Compute(                                 \
+      OpKernelContext* context, bool sorted, int k,                          \
+      const typename TTypes<T, 2>::ConstTensor& input, const int64 num_rows, \
+      const int64 num_cols, typename TTypes<T, 2>::Tensor values,            \
+      typename TTypes<int, 2>::Tensor indices) {                             \
+    return LaunchTopK<T>(context, sorted, k, input, num_rows, num_cols,      \
+                         values, indices);                                   \
+  }                                                                          \
+  template struct TopKFunctor<GPUDevice, T>;
+
+TF_CALL_GPU_NUMBER_TYPES(DEFINE_GPU_SPEC);
+TF_CALL_int32(DEFINE_GPU_SPEC);
+TF_CALL_int64(DEFINE_GPU_SPEC);
+
+#undef DEFINE_GPU_SPEC
+
+}  // namespace functor
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA
@@ -14,6 +14,9 @@ limitations under the License.
 ==============================================================================*/
 
 #include "tensorflow/core/kernels/training_op_helpers.h"
+
+#include <algorithm>
+
 #include "tensorflow/core/kernels/variable_ops.h"
 
 namespace tensorflow {
@@ -45,52 +48,59 @@ std::vector<mutex_lock> MaybeLockVariableInputMutexesInOrder(
     return locks;
   }
   std::vector<mutex*> mutexes;
-  std::vector<int> acquire_order;
+  mutexes.reserve(input_ids.size());
   for (auto input : input_ids) {
     mutex* mutex = GetTrainingVariableMutex(ctx, input);
-    // Only lock each mutex once if duplicates exist (n^2 but n is 2 or 3).
-    if (std::find(mutexes.begin(), mutexes.end(), mutex) == mutexes.end()) {
-      acquire_order.push_back(mutexes.size());
+    if (mutex != nullptr) {
       mutexes.push_back(mutex);
     }
   }
-  std::sort(acquire_order.begin(), acquire_order.end(),
-            [&mutexes](int a, int b) { return mutexes[a] < mutexes[b]; });
-
-  for (auto input : acquire_order) {
-    mutex* mu = GetTrainingVariableMutex(ctx, input);
-    if (mu != nullptr) {
-      locks.emplace_back(*mu);
-    }
+  // Sorting also brings duplicates together, so that they are locked once.
+  std::sort(mutexes.begin(), mutexes.end());
+  mutexes.erase(std::unique(mutexes.begin(), mutexes.end()), mutexes.end());
+  locks.reserve(mutexes.size());
+  for (mutex* mu : mutexes) {
+    locks.emplace_back(*mu);
   }
   return locks;
 }
 
-Status GetInputTensorFromVariable(OpKernelContext* ctx, int input,
-                                  bool lock_held, Tensor* out) {
-  if (ctx->input_dtype(input) == DT_RESOURCE) {
+void MaybeForwardRefInputToRefOutput(OpKernelContext* ctx, int input,
+                                     int output) {
+  if (ctx->input_dtype(input) != DT_RESOURCE) {
+    ctx->forward_ref_input_to_ref_output(input, output);
+  }
+}
+
+template <typename Index>
+void MarkDirtyRows(OpKernelContext* ctx, const std::vector<int>& input_ids,
+                   const Tensor& indices) {
+  for (int input : input_ids) {
+    if (ctx->input_dtype(input) != DT_RESOURCE) continue;
     Var* var;
     if (LookupResource(ctx, HandleFromInput(ctx, input), &var).ok()) {
-      if (lock_held) {
-        *out = *var->tensor();
-      } else {
-        mutex_lock ml(*var->mu());
-        *out = *var->tensor();
-      }
-      return Status::OK();
-    } else {
-      return errors::Internal("Invalid variable reference.");
+      core::ScopedUnref unref(var);
+      var->MarkDirtyRows<Index>(indices);
     }
   }
-  *out = ctx->mutable_input(input, lock_held);
-  return Status::OK();
 }
 
-void MaybeForwardRefInputToRefOutput(OpKernelContext* ctx, int input,
-                                     int output) {
-  if (ctx->input_dtype(input) != DT_RESOURCE) {
-    ctx->forward_ref_input_to_ref_output(input, output);
+void MarkAllRowsDirty(OpKernelContext* ctx, const std::vector<int>& input_ids) {
+  for (int input : input_ids) {
+    if (ctx->input_dtype(input) != DT_RESOURCE) continue;
+    Var* var;
+    if (LookupResource(ctx, HandleFromInput(ctx, input), &var).ok()) {
+      core::ScopedUnref unref(var);
+      var->MarkAllRowsDirty();
+    }
   }
 }
 
+template void MarkDirtyRows<int32>(OpKernelContext* ctx,
+                                   const std::vector<int>& input_ids,
+                                   const Tensor& indices);
+template void MarkDirtyRows<int64>(OpKernelContext* ctx,
+                                   const std::vector<int>& input_ids,
+                                   const Tensor& indices);
+
 }  // end namespace tensorflow
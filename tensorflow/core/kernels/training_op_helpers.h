@@ -17,20 +17,112 @@ limitations under the License.
 #define TENSORFLOW_KERNELS_TRAINING_OP_HELPERS_H_
 
 #include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/kernels/dense_update_ops.h"
+#include "tensorflow/core/kernels/variable_ops.h"
 
 namespace tensorflow {
 
+#if GOOGLE_CUDA
+typedef Eigen::GpuDevice GPUDevice;
+
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                 \
+  template <>                                               \
+  void DenseUpdate<GPUDevice, T, ASSIGN>::operator()(       \
+      const GPUDevice& d, typename TTypes<T>::Flat lhs,     \
+      typename TTypes<T>::ConstFlat rhs);                   \
+  extern template struct DenseUpdate<GPUDevice, T, ASSIGN>;
+TF_CALL_GPU_NUMBER_TYPES(DECLARE_GPU_SPEC);
+TF_CALL_complex64(DECLARE_GPU_SPEC);
+TF_CALL_complex128(DECLARE_GPU_SPEC);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+#endif  // GOOGLE_CUDA
+
 mutex* GetTrainingVariableMutex(OpKernelContext* ctx, int input);
 
 std::vector<mutex_lock> MaybeLockVariableInputMutexesInOrder(
     OpKernelContext* ctx, bool do_lock, const std::vector<int>& input_ids);
 
+// Resource variable reads return the variable's buffer rather than a copy
+// (see ReadVariableOp), so the variable must be passed here, with its mutex
+// held, before it is updated in place. If other tensors share its buffer,
+// the variable is given a copy of its own, so that the values that were read
+// don't change. Variables in copy-on-read mode are left alone, since their
+// buffer may be shared by unlocked updates that still write to it.
+template <typename Device, typename T>
+Status PrepareToUpdateVariable(OpKernelContext* ctx, Var* var) {
+  Tensor* tensor = var->tensor();
+  if (var->copy_on_read_mode() || !tensor->IsInitialized() ||
+      tensor->NumElements() == 0 || tensor->RefCountIsOne()) {
+    return Status::OK();
+  }
+  PersistentTensor unused;
+  Tensor* copy;
+  AllocatorAttributes attr;
+  attr.set_gpu_compatible(true);
+  attr.set_nic_compatible(true);
+  TF_RETURN_IF_ERROR(ctx->allocate_persistent(
+      tensor->dtype(), tensor->shape(), &unused, &copy, attr));
+  const Tensor& shared = *tensor;
+  functor::DenseUpdate<Device, T, ASSIGN> copy_functor;
+  copy_functor(ctx->eigen_device<Device>(), copy->flat<T>(),
+               shared.flat<T>());
+  *tensor = *copy;
+  return Status::OK();
+}
+
+// Sets *out to the tensor of "var" for an update that is written after the
+// variable's mutex, which must be held here, is released. The variable is
+// switched to copy-on-read mode first (see Var::copy_on_read_mode()).
+template <typename Device, typename T>
+Status PrepareToUpdateVariableUnlocked(OpKernelContext* ctx, Var* var,
+                                       Tensor* out) {
+  TF_RETURN_IF_ERROR(PrepareToUpdateVariable<Device, T>(ctx, var));
+  var->set_copy_on_read_mode();
+  *out = *var->tensor();
+  return Status::OK();
+}
+
+// Sets *out to the tensor of the variable (ref or resource) of input "input",
+// to be updated in place. A resource variable is first given a buffer of its
+// own (see PrepareToUpdateVariable()).
+template <typename Device, typename T>
 Status GetInputTensorFromVariable(OpKernelContext* ctx, int input,
-                                  bool lock_held, Tensor* out);
+                                  bool lock_held, Tensor* out) {
+  if (ctx->input_dtype(input) != DT_RESOURCE) {
+    *out = ctx->mutable_input(input, lock_held);
+    return Status::OK();
+  }
+  Var* var;
+  if (!LookupResource(ctx, HandleFromInput(ctx, input), &var).ok()) {
+    return errors::Internal("Invalid variable reference.");
+  }
+  core::ScopedUnref unref(var);
+  if (lock_held) {
+    TF_RETURN_IF_ERROR(PrepareToUpdateVariable<Device, T>(ctx, var));
+    *out = *var->tensor();
+  } else {
+    mutex_lock ml(*var->mu());
+    TF_RETURN_IF_ERROR(
+        PrepareToUpdateVariableUnlocked<Device, T>(ctx, var, out));
+  }
+  return Status::OK();
+}
 
 void MaybeForwardRefInputToRefOutput(OpKernelContext* ctx, int input,
                                      int output);
 
+// Record that the rows "indices" (or all rows) of the resource variables of
+// "input_ids" were updated, for incremental checkpoints (see
+// Var::TakeDirtyRows()).  Ref variables are not tracked.
+template <typename Index>
+void MarkDirtyRows(OpKernelContext* ctx, const std::vector<int>& input_ids,
+                   const Tensor& indices);
+void MarkAllRowsDirty(OpKernelContext* ctx, const std::vector<int>& input_ids);
+
 }  // end namespace tensorflow
 
 #endif  // TENSORFLOW_KERNELS_TRAINING_OP_HELPERS_H_
@@ -17,6 +17,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/training_ops.h"
 #include <algorithm>
+#include <numeric>
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/kernels/bounds_check.h"
@@ -298,6 +299,43 @@ struct ApplyAdamSYCL {
 template <typename T>
 struct ApplyAdam<CPUDevice, T> : ApplyAdamNonCuda<CPUDevice, T> {};
 
+template <typename T>
+struct MultiApplyMomentum<CPUDevice, T> {
+  void operator()(const CPUDevice& d,
+                  const std::vector<typename TTypes<T>::Flat>& var,
+                  const std::vector<typename TTypes<T>::Flat>& accum,
+                  typename TTypes<T>::ConstScalar lr,
+                  const std::vector<typename TTypes<T>::ConstFlat>& grad,
+                  typename TTypes<T>::ConstScalar momentum, bool use_nesterov) {
+    for (size_t i = 0; i < var.size(); ++i) {
+      ApplyMomentum<CPUDevice, T>()(d, var[i], accum[i], lr, grad[i],
+                                    momentum, use_nesterov);
+    }
+  }
+};
+
+template <typename T>
+struct MultiApplyAdam<CPUDevice, T> {
+  void operator()(const CPUDevice& d,
+                  const std::vector<typename TTypes<T>::Flat>& var,
+                  const std::vector<typename TTypes<T>::Flat>& m,
+                  const std::vector<typename TTypes<T>::Flat>& v,
+                  typename TTypes<T>::ConstScalar beta1_power,
+                  typename TTypes<T>::ConstScalar beta2_power,
+                  typename TTypes<T>::ConstScalar lr,
+                  typename TTypes<T>::ConstScalar beta1,
+                  typename TTypes<T>::ConstScalar beta2,
+                  typename TTypes<T>::ConstScalar epsilon,
+                  const std::vector<typename TTypes<T>::ConstFlat>& grad,
+                  bool use_nesterov) {
+    for (size_t i = 0; i < var.size(); ++i) {
+      ApplyAdam<CPUDevice, T>()(d, var[i], m[i], v[i], beta1_power,
+                                beta2_power, lr, beta1, beta2, epsilon,
+                                grad[i], use_nesterov);
+    }
+  }
+};
+
 template <typename T>
 struct ApplyRMSProp<CPUDevice, T> {
   void operator()(const CPUDevice& d, typename TTypes<T>::Flat var,
@@ -346,8 +384,8 @@ class ApplyGradientDescentOp : public OpKernel {
     auto locks =
         MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_, {0});
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
 
     OP_REQUIRES(
         ctx, var.IsInitialized(),
@@ -368,6 +406,7 @@ class ApplyGradientDescentOp : public OpKernel {
     functor::ApplyGradientDescent<Device, T>()(
         device, var.flat<T>(), alpha.scalar<T>(), delta.flat<T>());
 
+    MarkAllRowsDirty(ctx, {0});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -386,7 +425,8 @@ class ApplyGradientDescentOp < SYCLDevice, T > : public OpKernel {
   void Compute(OpKernelContext* ctx) override {
     auto locks = MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_, {0});
     Tensor var;
-    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<SYCLDevice, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
 
     OP_REQUIRES(
         ctx, var.IsInitialized(),
@@ -412,6 +452,7 @@ class ApplyGradientDescentOp < SYCLDevice, T > : public OpKernel {
     functor::ApplyGradientDescentSYCL<T>()(device, var.flat<T>(),
         alpha, delta.flat<T>());
 
+    MarkAllRowsDirty(ctx, {0});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -476,7 +517,8 @@ class ApplyDelayCompensatedGradientDescentOp : public OpKernel {
   void Compute(OpKernelContext* ctx) override {
     auto locks = MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_, {0, 4});
     Tensor var;
-    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     OP_REQUIRES(
         ctx, var.IsInitialized(),
         errors::FailedPrecondition(
@@ -496,7 +538,8 @@ class ApplyDelayCompensatedGradientDescentOp : public OpKernel {
                 errors::InvalidArgument("lambda is not a scalar: ",
                                         lambda.shape().DebugString()));
     Tensor shadow;
-    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable(ctx, 4, use_exclusive_lock_, &shadow));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 4, use_exclusive_lock_, &shadow));
     OP_REQUIRES(
         ctx, shadow.shape().IsSameSize(var.shape()),
         errors::InvalidArgument("shadow and var do not have the same shape",
@@ -509,6 +552,7 @@ class ApplyDelayCompensatedGradientDescentOp : public OpKernel {
         lambda.scalar<T>(), shadow.flat<T>()
     );
 
+    MarkAllRowsDirty(ctx, {0, 4});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -555,6 +599,7 @@ class ApplyAdadeltaOp : public OpKernel {
       if (!ctx->status().ok()) return;
       DoCompute(ctx);
     }
+    MarkAllRowsDirty(ctx, {0, 1, 2});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -563,14 +608,14 @@ class ApplyAdadeltaOp : public OpKernel {
 
   void DoValidate(OpKernelContext* ctx) {
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     Tensor accum;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 1, use_exclusive_lock_, &accum));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 1, use_exclusive_lock_, &accum));
     Tensor accum_update;
-    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable(ctx, 2, use_exclusive_lock_,
-                                                   &accum_update));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 2, use_exclusive_lock_, &accum_update));
 
     OP_REQUIRES(
         ctx, var.IsInitialized(),
@@ -617,14 +662,14 @@ class ApplyAdadeltaOp : public OpKernel {
   void DoCompute(OpKernelContext* ctx) {
     const Device& device = ctx->template eigen_device<Device>();
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     Tensor accum;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 1, use_exclusive_lock_, &accum));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 1, use_exclusive_lock_, &accum));
     Tensor accum_update;
-    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable(ctx, 2, use_exclusive_lock_,
-                                                   &accum_update));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 2, use_exclusive_lock_, &accum_update));
 
     const Tensor& lr = ctx->input(3);
     const Tensor& rho = ctx->input(4);
@@ -700,14 +745,14 @@ class SparseApplyAdadeltaOp : public OpKernel {
       mu_var->lock();
     }
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     Tensor accum_grad;
-    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable(ctx, 1, use_exclusive_lock_,
-                                                   &accum_grad));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 1, use_exclusive_lock_, &accum_grad));
     Tensor accum_update;
-    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable(ctx, 2, use_exclusive_lock_,
-                                                   &accum_update));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 2, use_exclusive_lock_, &accum_update));
     OP_REQUIRES(
         ctx, var.IsInitialized(),
         errors::FailedPrecondition(
@@ -803,6 +848,7 @@ class SparseApplyAdadeltaOp : public OpKernel {
       mu_var->unlock();
     }
 
+    MarkDirtyRows<Tindex>(ctx, {0, 1, 2}, indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -845,8 +891,8 @@ class ApplyProximalGradientDescentOp : public OpKernel {
     auto locks =
         MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_, {0});
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
 
     OP_REQUIRES(
         ctx, var.IsInitialized(),
@@ -879,6 +925,7 @@ class ApplyProximalGradientDescentOp : public OpKernel {
         device, var.flat<T>(), alpha.scalar<T>(), l1.scalar<T>(),
         l2.scalar<T>(), delta.flat<T>());
 
+    MarkAllRowsDirty(ctx, {0});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -914,8 +961,8 @@ class SparseApplyProximalGradientDescentOp : public OpKernel {
     auto locks =
         MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_, {0, 1});
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     OP_REQUIRES(ctx, TensorShapeUtils::IsVectorOrHigher(var.shape()),
                 errors::InvalidArgument("var must be at least 1 dimensional"));
 
@@ -1022,6 +1069,7 @@ class SparseApplyProximalGradientDescentOp : public OpKernel {
       }
     }
 
+    MarkDirtyRows<Tindex>(ctx, {0}, indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -1058,11 +1106,11 @@ class ApplyAdagradOp : public OpKernel {
     auto locks =
         MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_, {0, 1});
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     Tensor accum;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 1, use_exclusive_lock_, &accum));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 1, use_exclusive_lock_, &accum));
     OP_REQUIRES(
         ctx, var.IsInitialized(),
         errors::FailedPrecondition(
@@ -1091,6 +1139,7 @@ class ApplyAdagradOp : public OpKernel {
     functor::ApplyAdagrad<Device, T>()(device, var.flat<T>(), accum.flat<T>(),
                                        lr.scalar<T>(), grad.flat<T>());
 
+    MarkAllRowsDirty(ctx, {0, 1});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -1151,11 +1200,11 @@ class ApplyProximalAdagradOp : public OpKernel {
     auto locks =
         MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_, {0, 1});
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     Tensor accum;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 1, use_exclusive_lock_, &accum));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 1, use_exclusive_lock_, &accum));
     OP_REQUIRES(
         ctx, var.IsInitialized(),
         errors::FailedPrecondition(
@@ -1201,6 +1250,7 @@ class ApplyProximalAdagradOp : public OpKernel {
         device, var.flat<T>(), accum.flat<T>(), lr.scalar<T>(), l1.scalar<T>(),
         l2.scalar<T>(), grad.flat<T>());
 
+    MarkAllRowsDirty(ctx, {0, 1});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -1258,11 +1308,11 @@ class SparseApplyAdagradOp : public OpKernel {
     auto locks =
         MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_, {0, 1});
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     Tensor accum;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 1, use_exclusive_lock_, &accum));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 1, use_exclusive_lock_, &accum));
     OP_REQUIRES(
         ctx, var.IsInitialized(),
         errors::FailedPrecondition(
@@ -1350,6 +1400,7 @@ class SparseApplyAdagradOp : public OpKernel {
       }
     }
 
+    MarkDirtyRows<Tindex>(ctx, {0, 1}, indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -1392,11 +1443,11 @@ class SparseApplyProximalAdagradOp : public OpKernel {
     auto locks =
         MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_, {0, 1});
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     Tensor accum;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 1, use_exclusive_lock_, &accum));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 1, use_exclusive_lock_, &accum));
     OP_REQUIRES(
         ctx, var.IsInitialized(),
         errors::FailedPrecondition(
@@ -1528,6 +1579,7 @@ class SparseApplyProximalAdagradOp : public OpKernel {
       }
     }
 
+    MarkDirtyRows<Tindex>(ctx, {0, 1}, indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -1564,14 +1616,15 @@ class ApplyAdagradDAOp : public OpKernel {
     auto locks =
         MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_, {0, 1});
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     Tensor gradient_accum;
-    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable(ctx, 1, use_exclusive_lock_,
-                                                   &gradient_accum));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 1, use_exclusive_lock_, &gradient_accum));
     Tensor gradient_squared_accum;
-    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable(ctx, 2, use_exclusive_lock_,
-                                                   &gradient_squared_accum));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 2, use_exclusive_lock_,
+                            &gradient_squared_accum));
     OP_REQUIRES(
         ctx, var.IsInitialized(),
         errors::FailedPrecondition(
@@ -1628,6 +1681,7 @@ class ApplyAdagradDAOp : public OpKernel {
         global_step.scalar<int64>()(), l1.scalar<T>(), l2.scalar<T>(),
         grad.flat<T>());
 
+    MarkAllRowsDirty(ctx, {0, 1, 2});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -1666,14 +1720,15 @@ class SparseApplyAdagradDAOp : public OpKernel {
     auto locks =
         MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_, {0, 1});
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     Tensor gradient_accum;
-    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable(ctx, 1, use_exclusive_lock_,
-                                                   &gradient_accum));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 1, use_exclusive_lock_, &gradient_accum));
     Tensor gradient_squared_accum;
-    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable(ctx, 2, use_exclusive_lock_,
-                                                   &gradient_squared_accum));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 2, use_exclusive_lock_,
+                            &gradient_squared_accum));
     OP_REQUIRES(
         ctx, var.IsInitialized(),
         errors::FailedPrecondition(
@@ -1823,6 +1878,7 @@ class SparseApplyAdagradDAOp : public OpKernel {
       }
     }
 
+    MarkDirtyRows<Tindex>(ctx, {0, 1, 2}, indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -1863,14 +1919,14 @@ class ApplyFtrlOp : public OpKernel {
                                                       {0, 1, 2});
 
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     Tensor accum;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 1, use_exclusive_lock_, &accum));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 1, use_exclusive_lock_, &accum));
     Tensor linear;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 2, use_exclusive_lock_, &linear));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 2, use_exclusive_lock_, &linear));
     OP_REQUIRES(
         ctx, var.IsInitialized(),
         errors::FailedPrecondition(
@@ -1935,6 +1991,7 @@ class ApplyFtrlOp : public OpKernel {
                                     lr.scalar<T>(), l1.scalar<T>(),
                                     l2.scalar<T>(), lr_power.scalar<T>());
 
+    MarkAllRowsDirty(ctx, {0, 1, 2});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -1977,14 +2034,14 @@ class SparseApplyFtrlOp : public OpKernel {
     auto locks = MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_,
                                                       {0, 1, 2});
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     Tensor accum;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 1, use_exclusive_lock_, &accum));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 1, use_exclusive_lock_, &accum));
     Tensor linear;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 2, use_exclusive_lock_, &linear));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 2, use_exclusive_lock_, &linear));
     OP_REQUIRES(
         ctx, var.IsInitialized(),
         errors::FailedPrecondition(
@@ -2146,6 +2203,7 @@ class SparseApplyFtrlOp : public OpKernel {
       }
     }
 
+    MarkDirtyRows<Tindex>(ctx, {0, 1, 2}, indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -2188,11 +2246,11 @@ class ApplyMomentumOp : public OpKernel {
         MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_, {0, 1});
 
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     Tensor accum;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 1, use_exclusive_lock_, &accum));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 1, use_exclusive_lock_, &accum));
     OP_REQUIRES(
         ctx, var.IsInitialized(),
         errors::FailedPrecondition(
@@ -2226,6 +2284,7 @@ class ApplyMomentumOp : public OpKernel {
     functor::ApplyMomentum<Device, T>()(device, var.flat<T>(), accum.flat<T>(),
                                         lr.scalar<T>(), grad.flat<T>(),
                                         momentum.scalar<T>(), use_nesterov_);
+    MarkAllRowsDirty(ctx, {0, 1});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -2277,6 +2336,152 @@ REGISTER_KERNELS(GPU, double);
 #undef REGISTER_CPU_KERNELS
 #undef REGISTER_KERNELS
 
+// Gets the N variables of the list input that starts at 'first_input' into
+// '*vars' and checks that they are initialized.
+static Status GetMultiApplyVariables(OpKernelContext* ctx, int first_input,
+                                     int n, bool lock_held,
+                                     std::vector<Tensor>* vars) {
+  vars->resize(n);
+  for (int i = 0; i < n; ++i) {
+    TF_RETURN_IF_ERROR(GetInputTensorFromVariable<Device, T>(
+                           ctx, first_input + i, lock_held, &(*vars)[i]));
+    if (!(*vars)[i].IsInitialized()) {
+      return errors::FailedPrecondition(
+          "Attempting to use uninitialized variables: ",
+          ctx->op_kernel().def().input(first_input + i));
+    }
+  }
+  return Status::OK();
+}
+
+// Checks that the i-th tensors of 'slots' and 'grad' have the shape of
+// 'vars[i]'.
+static Status CheckMultiApplyShapes(
+    const std::vector<Tensor>& vars,
+    const std::vector<const std::vector<Tensor>*>& slots,
+    const OpInputList& grad) {
+  for (size_t i = 0; i < vars.size(); ++i) {
+    for (const std::vector<Tensor>* slot : slots) {
+      if (!vars[i].shape().IsSameSize((*slot)[i].shape())) {
+        return errors::InvalidArgument(
+            "var and its slot do not have the same shape",
+            vars[i].shape().DebugString(), " ",
+            (*slot)[i].shape().DebugString());
+      }
+    }
+    if (!vars[i].shape().IsSameSize(grad[i].shape())) {
+      return errors::InvalidArgument("var and grad do not have the same shape",
+                                     vars[i].shape().DebugString(), " ",
+                                     grad[i].shape().DebugString());
+    }
+  }
+  return Status::OK();
+}
+
+template <typename T>
+static std::vector<typename TTypes<T>::Flat> FlatTensors(
+    std::vector<Tensor>* tensors) {
+  std::vector<typename TTypes<T>::Flat> flats;
+  flats.reserve(tensors->size());
+  for (Tensor& t : *tensors) {
+    flats.push_back(t.flat<T>());
+  }
+  return flats;
+}
+
+template <typename T>
+static std::vector<typename TTypes<T>::ConstFlat> FlatTensors(
+    const OpInputList& tensors) {
+  std::vector<typename TTypes<T>::ConstFlat> flats;
+  flats.reserve(tensors.size());
+  for (const Tensor& t : tensors) {
+    flats.push_back(t.flat<T>());
+  }
+  return flats;
+}
+
+template <typename Device, typename T>
+class MultiApplyMomentumOp : public OpKernel {
+ public:
+  explicit MultiApplyMomentumOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_nesterov", &use_nesterov_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("N", &n_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    std::vector<int> variable_inputs(2 * n_);
+    std::iota(variable_inputs.begin(), variable_inputs.end(), 0);
+    auto locks = MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_,
+                                                      variable_inputs);
+
+    std::vector<Tensor> var;
+    OP_REQUIRES_OK(ctx, GetMultiApplyVariables(ctx, 0, n_, use_exclusive_lock_,
+                                               &var));
+    std::vector<Tensor> accum;
+    OP_REQUIRES_OK(ctx, GetMultiApplyVariables(ctx, n_, n_,
+                                               use_exclusive_lock_, &accum));
+    const Tensor& lr = ctx->input(2 * n_);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(lr.shape()),
+                errors::InvalidArgument("lr is not a scalar: ",
+                                        lr.shape().DebugString()));
+    OpInputList grad;
+    OP_REQUIRES_OK(ctx, ctx->input_list("grad", &grad));
+    OP_REQUIRES_OK(ctx, CheckMultiApplyShapes(var, {&accum}, grad));
+    const Tensor& momentum = ctx->input(3 * n_ + 1);
+    OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(momentum.shape()),
+                errors::InvalidArgument("momentum is not a scalar: ",
+                                        momentum.shape().DebugString()));
+
+    const Device& device = ctx->template eigen_device<Device>();
+    functor::MultiApplyMomentum<Device, T>()(
+        device, FlatTensors<T>(&var), FlatTensors<T>(&accum), lr.scalar<T>(),
+        FlatTensors<T>(grad), momentum.scalar<T>(), use_nesterov_);
+    MarkAllRowsDirty(ctx, variable_inputs);
+  }
+
+ private:
+  bool use_exclusive_lock_;
+  bool use_nesterov_;
+  int n_;
+};
+
+#define REGISTER_KERNELS(D, T)                                               \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("_MultiApplyMomentum").Device(DEVICE_##D).TypeConstraint<T>("T"), \
+      MultiApplyMomentumOp<D##Device, T>);
+#define REGISTER_CPU_KERNELS(T) REGISTER_KERNELS(CPU, T);
+
+TF_CALL_half(REGISTER_CPU_KERNELS);
+TF_CALL_float(REGISTER_CPU_KERNELS);
+TF_CALL_double(REGISTER_CPU_KERNELS);
+
+#if GOOGLE_CUDA
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                         \
+  template <>                                                       \
+  void MultiApplyMomentum<GPUDevice, T>::operator()(                \
+      const GPUDevice& d,                                           \
+      const std::vector<typename TTypes<T>::Flat>& var,             \
+      const std::vector<typename TTypes<T>::Flat>& accum,           \
+      typename TTypes<T>::ConstScalar lr,                           \
+      const std::vector<typename TTypes<T>::ConstFlat>& grad,       \
+      typename TTypes<T>::ConstScalar momentum, bool use_nesterov); \
+  extern template struct MultiApplyMomentum<GPUDevice, T>;
+DECLARE_GPU_SPEC(Eigen::half);
+DECLARE_GPU_SPEC(float);
+DECLARE_GPU_SPEC(double);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+REGISTER_KERNELS(GPU, Eigen::half);
+REGISTER_KERNELS(GPU, float);
+REGISTER_KERNELS(GPU, double);
+#endif
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_KERNELS
+
 // Note, this op works on cpu only.
 template <typename T, typename Tindex>
 class SparseApplyMomentumOp : public OpKernel {
@@ -2291,11 +2496,11 @@ class SparseApplyMomentumOp : public OpKernel {
         MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_, {0, 1});
 
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     Tensor accum;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 1, use_exclusive_lock_, &accum));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 1, use_exclusive_lock_, &accum));
     OP_REQUIRES(
         ctx, var.IsInitialized(),
         errors::FailedPrecondition(
@@ -2365,6 +2570,7 @@ class SparseApplyMomentumOp : public OpKernel {
       }
     }
 
+    MarkDirtyRows<Tindex>(ctx, {0, 1}, indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -2408,14 +2614,14 @@ class ApplyAdamOp : public OpKernel {
                                                       {0, 1, 2});
 
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     Tensor m;
-    OP_REQUIRES_OK(ctx,
-                   GetInputTensorFromVariable(ctx, 1, use_exclusive_lock_, &m));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 1, use_exclusive_lock_, &m));
     Tensor v;
-    OP_REQUIRES_OK(ctx,
-                   GetInputTensorFromVariable(ctx, 2, use_exclusive_lock_, &v));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 2, use_exclusive_lock_, &v));
     OP_REQUIRES(
         ctx, var.IsInitialized(),
         errors::FailedPrecondition(
@@ -2477,6 +2683,7 @@ class ApplyAdamOp : public OpKernel {
         beta1.scalar<T>(), beta2.scalar<T>(), epsilon.scalar<T>(),
         grad.flat<T>(), use_nesterov_);
 
+    MarkAllRowsDirty(ctx, {0, 1, 2});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -2497,11 +2704,14 @@ class ApplyAdamOp < SYCLDevice, T> : public OpKernel {
     auto locks = MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_, {0, 1, 2});
 
     Tensor var;
-    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<SYCLDevice, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     Tensor m;
-    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable(ctx, 1, use_exclusive_lock_, &m));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<SYCLDevice, T>(
+                            ctx, 1, use_exclusive_lock_, &m));
     Tensor v;
-    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable(ctx, 2, use_exclusive_lock_, &v));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<SYCLDevice, T>(
+                            ctx, 2, use_exclusive_lock_, &v));
     OP_REQUIRES(
         ctx, var.IsInitialized(),
         errors::FailedPrecondition(
@@ -2591,6 +2801,7 @@ class ApplyAdamOp < SYCLDevice, T> : public OpKernel {
                                     beta1, beta2,
                                     epsilon, grad.flat<T>());
 
+    MarkAllRowsDirty(ctx, {0, 1, 2});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -2655,6 +2866,105 @@ REGISTER_KERNELS(GPU, double);
 #undef REGISTER_CPU_KERNELS
 #undef REGISTER_KERNELS
 
+template <typename Device, typename T>
+class MultiApplyAdamOp : public OpKernel {
+ public:
+  explicit MultiApplyAdamOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_nesterov", &use_nesterov_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("N", &n_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    std::vector<int> variable_inputs(3 * n_);
+    std::iota(variable_inputs.begin(), variable_inputs.end(), 0);
+    auto locks = MaybeLockVariableInputMutexesInOrder(ctx, use_exclusive_lock_,
+                                                      variable_inputs);
+
+    std::vector<Tensor> var;
+    OP_REQUIRES_OK(ctx, GetMultiApplyVariables(ctx, 0, n_, use_exclusive_lock_,
+                                               &var));
+    std::vector<Tensor> m;
+    OP_REQUIRES_OK(
+        ctx, GetMultiApplyVariables(ctx, n_, n_, use_exclusive_lock_, &m));
+    std::vector<Tensor> v;
+    OP_REQUIRES_OK(ctx, GetMultiApplyVariables(ctx, 2 * n_, n_,
+                                               use_exclusive_lock_, &v));
+
+    const Tensor& beta1_power = ctx->input(3 * n_);
+    const Tensor& beta2_power = ctx->input(3 * n_ + 1);
+    const Tensor& lr = ctx->input(3 * n_ + 2);
+    const Tensor& beta1 = ctx->input(3 * n_ + 3);
+    const Tensor& beta2 = ctx->input(3 * n_ + 4);
+    const Tensor& epsilon = ctx->input(3 * n_ + 5);
+    for (int i = 3 * n_; i < 3 * n_ + 6; ++i) {
+      OP_REQUIRES(ctx, TensorShapeUtils::IsScalar(ctx->input(i).shape()),
+                  errors::InvalidArgument(
+                      def().input(i), " is not a scalar: ",
+                      ctx->input(i).shape().DebugString()));
+    }
+
+    OpInputList grad;
+    OP_REQUIRES_OK(ctx, ctx->input_list("grad", &grad));
+    OP_REQUIRES_OK(ctx, CheckMultiApplyShapes(var, {&m, &v}, grad));
+
+    const Device& device = ctx->template eigen_device<Device>();
+    functor::MultiApplyAdam<Device, T>()(
+        device, FlatTensors<T>(&var), FlatTensors<T>(&m), FlatTensors<T>(&v),
+        beta1_power.scalar<T>(), beta2_power.scalar<T>(), lr.scalar<T>(),
+        beta1.scalar<T>(), beta2.scalar<T>(), epsilon.scalar<T>(),
+        FlatTensors<T>(grad), use_nesterov_);
+    MarkAllRowsDirty(ctx, variable_inputs);
+  }
+
+ private:
+  bool use_exclusive_lock_;
+  bool use_nesterov_;
+  int n_;
+};
+
+#define REGISTER_KERNELS(D, T)                                           \
+  REGISTER_KERNEL_BUILDER(                                               \
+      Name("_MultiApplyAdam").Device(DEVICE_##D).TypeConstraint<T>("T"), \
+      MultiApplyAdamOp<D##Device, T>);
+#define REGISTER_CPU_KERNELS(T) REGISTER_KERNELS(CPU, T);
+
+TF_CALL_half(REGISTER_CPU_KERNELS);
+TF_CALL_float(REGISTER_CPU_KERNELS);
+TF_CALL_double(REGISTER_CPU_KERNELS);
+
+#if GOOGLE_CUDA
+// Forward declarations of the functor specializations for GPU.
+namespace functor {
+#define DECLARE_GPU_SPEC(T)                                    \
+  template <>                                                  \
+  void MultiApplyAdam<GPUDevice, T>::operator()(               \
+      const GPUDevice& d,                                      \
+      const std::vector<typename TTypes<T>::Flat>& var,        \
+      const std::vector<typename TTypes<T>::Flat>& m,          \
+      const std::vector<typename TTypes<T>::Flat>& v,          \
+      typename TTypes<T>::ConstScalar beta1_power,             \
+      typename TTypes<T>::ConstScalar beta2_power,             \
+      typename TTypes<T>::ConstScalar lr,                      \
+      typename TTypes<T>::ConstScalar beta1,                   \
+      typename TTypes<T>::ConstScalar beta2,                   \
+      typename TTypes<T>::ConstScalar epsilon,                 \
+      const std::vector<typename TTypes<T>::ConstFlat>& grad,  \
+      bool use_nesterov);                                      \
+  extern template struct MultiApplyAdam<GPUDevice, T>;
+DECLARE_GPU_SPEC(Eigen::half);
+DECLARE_GPU_SPEC(float);
+DECLARE_GPU_SPEC(double);
+#undef DECLARE_GPU_SPEC
+}  // namespace functor
+
+REGISTER_KERNELS(GPU, Eigen::half);
+REGISTER_KERNELS(GPU, float);
+REGISTER_KERNELS(GPU, double);
+#endif
+#undef REGISTER_CPU_KERNELS
+#undef REGISTER_KERNELS
+
 template <typename Device, typename T>
 class ApplyRMSPropOp : public OpKernel {
  public:
@@ -2667,14 +2977,14 @@ class ApplyRMSPropOp : public OpKernel {
                                                       {0, 1, 2});
 
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     Tensor ms;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 1, use_exclusive_lock_, &ms));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 1, use_exclusive_lock_, &ms));
     Tensor mom;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 2, use_exclusive_lock_, &mom));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 2, use_exclusive_lock_, &mom));
 
     OP_REQUIRES(
         ctx, var.IsInitialized(),
@@ -2730,6 +3040,7 @@ class ApplyRMSPropOp : public OpKernel {
                                        rho.scalar<T>(), momentum.scalar<T>(),
                                        epsilon.scalar<T>(), grad.flat<T>());
 
+    MarkAllRowsDirty(ctx, {0, 1, 2});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -2749,17 +3060,17 @@ class ApplyCenteredRMSPropOp : public OpKernel {
                                                       {0, 1, 2, 3});
 
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     Tensor mg;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 1, use_exclusive_lock_, &mg));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 1, use_exclusive_lock_, &mg));
     Tensor ms;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 2, use_exclusive_lock_, &ms));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 2, use_exclusive_lock_, &ms));
     Tensor mom;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 3, use_exclusive_lock_, &mom));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 3, use_exclusive_lock_, &mom));
 
     OP_REQUIRES(
         ctx, var.IsInitialized(),
@@ -2823,6 +3134,7 @@ class ApplyCenteredRMSPropOp : public OpKernel {
         device, var.flat<T>(), mg.flat<T>(), ms.flat<T>(), mom.flat<T>(),
         lr.scalar<T>(), rho.scalar<T>(), momentum.scalar<T>(),
         epsilon.scalar<T>(), grad.flat<T>());
+    MarkAllRowsDirty(ctx, {0, 1, 2, 3});
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -2910,14 +3222,14 @@ class SparseApplyRMSPropOp : public OpKernel {
                                                       {0, 1, 2});
 
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     Tensor ms;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 1, use_exclusive_lock_, &ms));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 1, use_exclusive_lock_, &ms));
     Tensor mom;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 2, use_exclusive_lock_, &mom));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 2, use_exclusive_lock_, &mom));
 
     OP_REQUIRES(
         ctx, var.IsInitialized(),
@@ -3018,6 +3330,7 @@ class SparseApplyRMSPropOp : public OpKernel {
       }
     }
 
+    MarkDirtyRows<Tindex>(ctx, {0, 1, 2}, indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
@@ -3039,17 +3352,17 @@ class SparseApplyCenteredRMSPropOp : public OpKernel {
                                                       {0, 1, 2, 3});
 
     Tensor var;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 0, use_exclusive_lock_, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 0, use_exclusive_lock_, &var));
     Tensor mg;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 1, use_exclusive_lock_, &mg));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 1, use_exclusive_lock_, &mg));
     Tensor ms;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 2, use_exclusive_lock_, &ms));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 2, use_exclusive_lock_, &ms));
     Tensor mom;
-    OP_REQUIRES_OK(
-        ctx, GetInputTensorFromVariable(ctx, 3, use_exclusive_lock_, &mom));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<CPUDevice, T>(
+                            ctx, 3, use_exclusive_lock_, &mom));
 
     OP_REQUIRES(
         ctx, var.IsInitialized(),
@@ -3159,6 +3472,7 @@ class SparseApplyCenteredRMSPropOp : public OpKernel {
       }
     }
 
+    MarkDirtyRows<Tindex>(ctx, {0, 1, 2, 3}, indices);
     MaybeForwardRefInputToRefOutput(ctx, 0, 0);
   }
 
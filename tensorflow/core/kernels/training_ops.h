@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_KERNELS_TRAINING_OPS_H_
 #define TENSORFLOW_KERNELS_TRAINING_OPS_H_
 
+#include <vector>
+
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/platform/types.h"
@@ -135,6 +137,35 @@ struct ApplyAdam {
                   typename TTypes<T>::ConstFlat grad, bool use_nesterov);
 };
 
+// The MultiApplyXYZ functors apply ApplyXYZ to many variables with the same
+// hyperparameters. The i-th elements of the vectors belong to the i-th
+// variable.
+template <typename Device, typename T>
+struct MultiApplyMomentum {
+  void operator()(const Device& d,
+                  const std::vector<typename TTypes<T>::Flat>& var,
+                  const std::vector<typename TTypes<T>::Flat>& accum,
+                  typename TTypes<T>::ConstScalar lr,
+                  const std::vector<typename TTypes<T>::ConstFlat>& grad,
+                  typename TTypes<T>::ConstScalar momentum, bool use_nesterov);
+};
+
+template <typename Device, typename T>
+struct MultiApplyAdam {
+  void operator()(const Device& d,
+                  const std::vector<typename TTypes<T>::Flat>& var,
+                  const std::vector<typename TTypes<T>::Flat>& m,
+                  const std::vector<typename TTypes<T>::Flat>& v,
+                  typename TTypes<T>::ConstScalar beta1_power,
+                  typename TTypes<T>::ConstScalar beta2_power,
+                  typename TTypes<T>::ConstScalar lr,
+                  typename TTypes<T>::ConstScalar beta1,
+                  typename TTypes<T>::ConstScalar beta2,
+                  typename TTypes<T>::ConstScalar epsilon,
+                  const std::vector<typename TTypes<T>::ConstFlat>& grad,
+                  bool use_nesterov);
+};
+
 template <typename Device, typename T>
 struct ApplyRMSProp {
   void operator()(const Device& d, typename TTypes<T>::Flat var,
@@ -19,6 +19,7 @@ limitations under the License.
 
 #include "tensorflow/core/kernels/training_ops.h"
 #include "tensorflow/core/framework/register_types.h"
+#include "tensorflow/core/util/cuda_kernel_helper.h"
 
 namespace tensorflow {
 
@@ -193,6 +194,150 @@ struct ApplyCenteredRMSProp<GPUDevice, T> {
   }
 };
 
+// The MultiApply functors update up to this many variables per launch. The
+// tables of pointers are passed as kernel arguments, which are limited to 4KB.
+static const int kMaxTensorsPerLaunch = 64;
+
+template <typename T, int kNumSlots>
+struct MultiApplyArgs {
+  T* var[kMaxTensorsPerLaunch];
+  T* slots[kNumSlots][kMaxTensorsPerLaunch];
+  const T* grad[kMaxTensorsPerLaunch];
+  int64 size[kMaxTensorsPerLaunch];
+};
+
+// Every row of blocks, blockIdx.y, updates one variable with a grid-stride
+// loop, so that a single launch updates variables of any sizes.
+template <typename T>
+__global__ void MultiApplyMomentumKernel(MultiApplyArgs<T, 1> args,
+                                         const T* __restrict__ lr_ptr,
+                                         const T* __restrict__ momentum_ptr,
+                                         bool use_nesterov) {
+  const int t = blockIdx.y;
+  T* __restrict__ var = args.var[t];
+  T* __restrict__ accum = args.slots[0][t];
+  const T* __restrict__ grad = args.grad[t];
+  const int64 size = args.size[t];
+  const T lr = *lr_ptr;
+  const T momentum = *momentum_ptr;
+  for (int64 i = blockIdx.x * static_cast<int64>(blockDim.x) + threadIdx.x;
+       i < size; i += static_cast<int64>(blockDim.x) * gridDim.x) {
+    const T g = grad[i];
+    const T a = accum[i] * momentum + g;
+    accum[i] = a;
+    if (use_nesterov) {
+      var[i] -= g * lr + a * momentum * lr;
+    } else {
+      var[i] -= a * lr;
+    }
+  }
+}
+
+template <typename T>
+__global__ void MultiApplyAdamKernel(
+    MultiApplyArgs<T, 2> args, const T* __restrict__ beta1_power_ptr,
+    const T* __restrict__ beta2_power_ptr, const T* __restrict__ lr_ptr,
+    const T* __restrict__ beta1_ptr, const T* __restrict__ beta2_ptr,
+    const T* __restrict__ epsilon_ptr, bool use_nesterov) {
+  const int t = blockIdx.y;
+  T* __restrict__ var = args.var[t];
+  T* __restrict__ m = args.slots[0][t];
+  T* __restrict__ v = args.slots[1][t];
+  const T* __restrict__ grad = args.grad[t];
+  const int64 size = args.size[t];
+  const T one(1);
+  const T beta1 = *beta1_ptr;
+  const T beta2 = *beta2_ptr;
+  const T epsilon = *epsilon_ptr;
+  const T alpha = *lr_ptr * Eigen::numext::sqrt(one - *beta2_power_ptr) /
+                  (one - *beta1_power_ptr);
+  for (int64 i = blockIdx.x * static_cast<int64>(blockDim.x) + threadIdx.x;
+       i < size; i += static_cast<int64>(blockDim.x) * gridDim.x) {
+    const T g = grad[i];
+    const T m_i = m[i] + (g - m[i]) * (one - beta1);
+    const T v_i = v[i] + (g * g - v[i]) * (one - beta2);
+    m[i] = m_i;
+    v[i] = v_i;
+    if (use_nesterov) {
+      var[i] -= ((g * (one - beta1) + beta1 * m_i) * alpha) /
+                (Eigen::numext::sqrt(v_i) + epsilon);
+    } else {
+      var[i] -= (m_i * alpha) / (Eigen::numext::sqrt(v_i) + epsilon);
+    }
+  }
+}
+
+// Launches 'kernel' with 'extra_args' for every group of up to
+// kMaxTensorsPerLaunch variables.
+template <typename T, int kNumSlots, typename Kernel, typename... ExtraArgs>
+void LaunchMultiApply(
+    const GPUDevice& d, const std::vector<typename TTypes<T>::Flat>& var,
+    const std::vector<const std::vector<typename TTypes<T>::Flat>*>& slots,
+    const std::vector<typename TTypes<T>::ConstFlat>& grad, Kernel kernel,
+    ExtraArgs... extra_args) {
+  const int kThreadsPerBlock = 256;
+  const int max_blocks = std::max(1, d.getNumCudaMultiProcessors() *
+                                         d.maxCudaThreadsPerMultiProcessor() /
+                                         kThreadsPerBlock);
+  const int num_tensors = var.size();
+  for (int begin = 0; begin < num_tensors; begin += kMaxTensorsPerLaunch) {
+    const int count = std::min(kMaxTensorsPerLaunch, num_tensors - begin);
+    MultiApplyArgs<T, kNumSlots> args;
+    int64 max_size = 0;
+    for (int i = 0; i < count; ++i) {
+      args.var[i] = var[begin + i].data();
+      for (int s = 0; s < kNumSlots; ++s) {
+        args.slots[s][i] = (*slots[s])[begin + i].data();
+      }
+      args.grad[i] = grad[begin + i].data();
+      args.size[i] = var[begin + i].size();
+      max_size = std::max(max_size, args.size[i]);
+    }
+    if (max_size == 0) {
+      continue;
+    }
+    const dim3 blocks(
+        std::min<int64>(max_blocks, DIV_UP(max_size, kThreadsPerBlock)),
+        count);
+    kernel<<<blocks, kThreadsPerBlock, 0, d.stream()>>>(args, extra_args...);
+  }
+}
+
+template <typename T>
+struct MultiApplyMomentum<GPUDevice, T> {
+  void operator()(const GPUDevice& d,
+                  const std::vector<typename TTypes<T>::Flat>& var,
+                  const std::vector<typename TTypes<T>::Flat>& accum,
+                  typename TTypes<T>::ConstScalar lr,
+                  const std::vector<typename TTypes<T>::ConstFlat>& grad,
+                  typename TTypes<T>::ConstScalar momentum, bool use_nesterov) {
+    LaunchMultiApply<T, 1>(d, var, {&accum}, grad,
+                           MultiApplyMomentumKernel<T>, lr.data(),
+                           momentum.data(), use_nesterov);
+  }
+};
+
+template <typename T>
+struct MultiApplyAdam<GPUDevice, T> {
+  void operator()(const GPUDevice& d,
+                  const std::vector<typename TTypes<T>::Flat>& var,
+                  const std::vector<typename TTypes<T>::Flat>& m,
+                  const std::vector<typename TTypes<T>::Flat>& v,
+                  typename TTypes<T>::ConstScalar beta1_power,
+                  typename TTypes<T>::ConstScalar beta2_power,
+                  typename TTypes<T>::ConstScalar lr,
+                  typename TTypes<T>::ConstScalar beta1,
+                  typename TTypes<T>::ConstScalar beta2,
+                  typename TTypes<T>::ConstScalar epsilon,
+                  const std::vector<typename TTypes<T>::ConstFlat>& grad,
+                  bool use_nesterov) {
+    LaunchMultiApply<T, 2>(d, var, {&m, &v}, grad, MultiApplyAdamKernel<T>,
+                           beta1_power.data(), beta2_power.data(), lr.data(),
+                           beta1.data(), beta2.data(), epsilon.data(),
+                           use_nesterov);
+  }
+};
+
 }  // namespace functor
 
 template struct functor::ApplyGradientDescent<GPUDevice, Eigen::half>;
@@ -215,6 +360,14 @@ template struct functor::ApplyAdam<GPUDevice, Eigen::half>;
 template struct functor::ApplyAdam<GPUDevice, float>;
 template struct functor::ApplyAdam<GPUDevice, double>;
 
+template struct functor::MultiApplyMomentum<GPUDevice, Eigen::half>;
+template struct functor::MultiApplyMomentum<GPUDevice, float>;
+template struct functor::MultiApplyMomentum<GPUDevice, double>;
+
+template struct functor::MultiApplyAdam<GPUDevice, Eigen::half>;
+template struct functor::MultiApplyAdam<GPUDevice, float>;
+template struct functor::MultiApplyAdam<GPUDevice, double>;
+
 template struct functor::ApplyRMSProp<GPUDevice, Eigen::half>;
 template struct functor::ApplyRMSProp<GPUDevice, float>;
 template struct functor::ApplyRMSProp<GPUDevice, double>;
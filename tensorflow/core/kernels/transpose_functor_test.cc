@@ -0,0 +1,190 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/core/kernels/transpose_functor.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/common_runtime/eigen_thread_pool.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+class TransposeFunctorTest : public ::testing::Test {
+ protected:
+  TransposeFunctorTest()
+      : threadpool_(Env::Default(), "test", 4 /* num_threads */),
+        wrapper_(&threadpool_),
+        device_(&wrapper_, 4 /* num_threads */) {}
+
+  // Transposes a tensor of 'shape' with distinct values according to 'perm',
+  // and compares the result with an element by element transpose.
+  template <typename T>
+  void TestTranspose(const TensorShape& shape,
+                     const std::vector<int32>& perm) {
+    const int ndims = shape.dims();
+    Tensor in(DataTypeToEnum<T>::value, shape);
+    auto in_flat = in.flat<T>();
+    for (int64 i = 0; i < in_flat.size(); ++i) {
+      in_flat(i) = static_cast<T>(i);
+    }
+    TensorShape out_shape;
+    for (int i = 0; i < ndims; ++i) {
+      out_shape.AddDim(shape.dim_size(perm[i]));
+    }
+
+    Tensor expected(DataTypeToEnum<T>::value, out_shape);
+    auto expected_flat = expected.flat<T>();
+    gtl::InlinedVector<int64, 8> in_strides(ndims);
+    internal::ComputeStride(shape, in_strides.data());
+    gtl::InlinedVector<int64, 8> out_strides(ndims);
+    internal::ComputeStride(out_shape, out_strides.data());
+    for (int64 o = 0; o < expected_flat.size(); ++o) {
+      int64 i = 0;
+      int64 t = o;
+      for (int d = 0; d < ndims; ++d) {
+        i += (t / out_strides[d]) * in_strides[perm[d]];
+        t %= out_strides[d];
+      }
+      expected_flat(o) = in_flat(i);
+    }
+
+    Tensor out(DataTypeToEnum<T>::value, out_shape);
+    TF_EXPECT_OK(DoTranspose(device_, in, perm, &out));
+    test::ExpectTensorEqual<T>(expected, out);
+  }
+
+  template <typename T>
+  void TestAllPermutations(const TensorShape& shape) {
+    std::vector<int32> perm(shape.dims());
+    for (int i = 0; i < shape.dims(); ++i) perm[i] = i;
+    do {
+      TestTranspose<T>(shape, perm);
+    } while (std::next_permutation(perm.begin(), perm.end()));
+  }
+
+  thread::ThreadPool threadpool_;
+  EigenThreadPoolWrapper wrapper_;
+  CPUDevice device_;
+};
+
+TEST_F(TransposeFunctorTest, Matrix) {
+  TestTranspose<float>({1, 1}, {1, 0});
+  TestTranspose<float>({7, 13}, {1, 0});
+  TestTranspose<float>({64, 64}, {1, 0});
+  TestTranspose<float>({100, 37}, {1, 0});
+  TestTranspose<double>({100, 37}, {1, 0});
+  TestTranspose<int64>({33, 65}, {1, 0});
+  TestTranspose<uint8>({100, 37}, {1, 0});
+  TestTranspose<int16>({45, 71}, {1, 0});
+  TestTranspose<complex128>({45, 71}, {1, 0});
+}
+
+TEST_F(TransposeFunctorTest, ImageLayouts) {
+  // NHWC -> NCHW and NCHW -> NHWC.
+  TestTranspose<float>({2, 17, 19, 3}, {0, 3, 1, 2});
+  TestTranspose<float>({2, 3, 17, 19}, {0, 2, 3, 1});
+  TestTranspose<float>({4, 9, 9, 64}, {0, 3, 1, 2});
+  TestTranspose<double>({4, 64, 9, 9}, {0, 2, 3, 1});
+  TestTranspose<uint8>({2, 33, 35, 3}, {0, 3, 1, 2});
+}
+
+TEST_F(TransposeFunctorTest, AllPermutations) {
+  TestAllPermutations<float>({3, 4, 5});
+  TestAllPermutations<float>({2, 3, 4, 5});
+  TestAllPermutations<double>({13, 1, 9, 6});
+  TestAllPermutations<uint8>({2, 3, 4, 5});
+  TestAllPermutations<int32>({2, 3, 1, 4, 3});
+  TestAllPermutations<complex64>({3, 7, 5});
+}
+
+TEST_F(TransposeFunctorTest, HighRank) {
+  TestTranspose<float>({2, 3, 2, 3, 2, 3, 2}, {6, 4, 2, 0, 1, 3, 5});
+  TestTranspose<float>({2, 3, 2, 3, 2, 3, 2}, {1, 0, 3, 2, 5, 4, 6});
+  TestTranspose<int64>({3, 2, 1, 5, 2, 1, 4}, {3, 5, 0, 6, 1, 2, 4});
+}
+
+TEST_F(TransposeFunctorTest, Strings) {
+  Tensor in(DT_STRING, TensorShape({2, 3}));
+  test::FillValues<string>(&in, {"a", "b", "c", "d", "e", "f"});
+  Tensor out(DT_STRING, TensorShape({3, 2}));
+  TF_EXPECT_OK(DoTranspose(device_, in, {1, 0}, &out));
+  Tensor expected(DT_STRING, TensorShape({3, 2}));
+  test::FillValues<string>(&expected, {"a", "d", "b", "e", "c", "f"});
+  test::ExpectTensorEqual<string>(expected, out);
+}
+
+template <typename T>
+static void BM_Transpose(int iters, const TensorShape& shape,
+                         const std::vector<int32>& perm) {
+  testing::StopTiming();
+  const int num_threads = port::NumSchedulableCPUs();
+  thread::ThreadPool threadpool(Env::Default(), "test", num_threads);
+  EigenThreadPoolWrapper wrapper(&threadpool);
+  CPUDevice device(&wrapper, num_threads);
+  Tensor in(DataTypeToEnum<T>::value, shape);
+  in.flat<T>().setZero();
+  TensorShape out_shape;
+  for (int i = 0; i < shape.dims(); ++i) {
+    out_shape.AddDim(shape.dim_size(perm[i]));
+  }
+  Tensor out(DataTypeToEnum<T>::value, out_shape);
+  testing::BytesProcessed(static_cast<int64>(iters) * in.TotalBytes() * 2);
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(DoTranspose(device, in, perm, &out));
+  }
+}
+
+static void BM_Transpose2D(int iters, int arg) {
+  BM_Transpose<float>(iters, {arg, arg}, {1, 0});
+}
+BENCHMARK(BM_Transpose2D)->Arg(128)->Arg(1024)->Arg(4096);
+
+static void BM_TransposeNHWCToNCHW(int iters, int arg) {
+  BM_Transpose<float>(iters, {32, arg, arg, 64}, {0, 3, 1, 2});
+}
+BENCHMARK(BM_TransposeNHWCToNCHW)->Arg(14)->Arg(56);
+
+static void BM_TransposeNCHWToNHWC(int iters, int arg) {
+  BM_Transpose<float>(iters, {32, 64, arg, arg}, {0, 2, 3, 1});
+}
+BENCHMARK(BM_TransposeNCHWToNHWC)->Arg(14)->Arg(56);
+
+static void BM_TransposeReverse(int iters, int arg) {
+  BM_Transpose<float>(iters, {arg, arg, arg}, {2, 1, 0});
+}
+BENCHMARK(BM_TransposeReverse)->Arg(64)->Arg(128);
+
+static void BM_TransposeInnerRows(int iters, int arg) {
+  BM_Transpose<double>(iters, {arg, 64, 64}, {1, 0, 2});
+}
+BENCHMARK(BM_TransposeInnerRows)->Arg(64)->Arg(256);
+
+}  // namespace
+}  // namespace tensorflow
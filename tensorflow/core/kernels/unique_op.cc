@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
@@ -21,11 +22,32 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/gtl/flatmap.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
 
+namespace {
+
+// Below this many elements, Unique runs on a single thread.
+const int64 kMinParallelUniqueElements = 1 << 16;
+
+// The maximum number of hash partitions of a parallel Unique, so that the
+// partition of every element fits in a byte.
+const int kMaxUniquePartitions = 256;
+
+// Returns the hash partition of `value`, out of `num_partitions`.  The hash
+// is mixed first, since std::hash is the identity for integers.
+template <typename T>
+inline uint8 UniquePartition(const T& value, int num_partitions) {
+  const uint64 h = static_cast<uint64>(std::hash<T>()(value)) *
+                   0x9E3779B97F4A7C15ull;
+  return static_cast<uint8>((h >> 32) % num_partitions);
+}
+
+}  // namespace
+
 template <typename T>
 class UniqueOp : public OpKernel {
  public:
@@ -50,6 +72,12 @@ class UniqueOp : public OpKernel {
                                 {0}, 1, input.shape(), &idx));
     auto idx_vec = idx->template vec<int32>();
 
+    auto worker_threads = context->device()->tensorflow_cpu_worker_threads();
+    if (N >= kMinParallelUniqueElements && worker_threads->num_threads > 1) {
+      ComputeParallel(context, Tin, idx_vec, *worker_threads);
+      return;
+    }
+
     gtl::FlatMap<T, int32> uniq(N);
     for (int64 i = 0, j = 0; i < N; ++i) {
       auto it = uniq.insert(std::make_pair(Tin(i), j));
@@ -78,6 +106,113 @@ class UniqueOp : public OpKernel {
       }
     }
   }
+
+ private:
+  // Computes Unique with the elements partitioned by hash across the worker
+  // threads.  Each partition has its own table, which gives local ids to its
+  // unique elements in the order of their first occurrence.  The global ids,
+  // which follow the same order in the whole input, are then found from the
+  // positions of the first occurrences, in parallel over blocks of the input.
+  void ComputeParallel(OpKernelContext* context,
+                       typename TTypes<T>::ConstVec Tin,
+                       typename TTypes<int32>::Vec idx_vec,
+                       const DeviceBase::CpuWorkerThreads& worker_threads) {
+    const int64 N = static_cast<int64>(Tin.size());
+    const int num_partitions =
+        std::min(worker_threads.num_threads, kMaxUniquePartitions);
+    const int64 num_blocks = 4 * worker_threads.num_threads;
+    auto block_begin = [N, num_blocks](int64 block) {
+      return N * block / num_blocks;
+    };
+
+    // The partition of every element, and whether it is the first occurrence
+    // of its value.
+    std::vector<uint8> partitions(N);
+    std::vector<uint8> is_first(N, 0);
+    Shard(worker_threads.num_threads, worker_threads.workers, N, 50,
+          [&Tin, &partitions, num_partitions](int64 start, int64 limit) {
+            for (int64 i = start; i < limit; ++i) {
+              partitions[i] = UniquePartition(Tin(i), num_partitions);
+            }
+          });
+
+    // Local ids are written to idx_vec, and replaced by the global ids below.
+    const bool with_counts = num_outputs() > 2;
+    std::vector<std::vector<int32>> counts(num_partitions);
+    std::vector<std::vector<int32>> global_ids(num_partitions);
+    Shard(worker_threads.num_threads, worker_threads.workers, num_partitions,
+          N * 50, [&](int64 start, int64 limit) {
+            for (int64 p = start; p < limit; ++p) {
+              gtl::FlatMap<T, int32> uniq(N / num_partitions);
+              int32 j = 0;
+              for (int64 i = 0; i < N; ++i) {
+                if (partitions[i] != p) continue;
+                auto it = uniq.insert(std::make_pair(Tin(i), j));
+                idx_vec(i) = it.first->second;
+                if (it.second) {
+                  is_first[i] = 1;
+                  ++j;
+                  if (with_counts) counts[p].push_back(0);
+                }
+                if (with_counts) ++counts[p][it.first->second];
+              }
+              global_ids[p].resize(j);
+            }
+          });
+
+    // The global id of the first unique element of every block.
+    std::vector<int32> block_ids(num_blocks + 1, 0);
+    const int64 cost_per_block = N / num_blocks * 5;
+    Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+          cost_per_block, [&](int64 start, int64 limit) {
+            for (int64 b = start; b < limit; ++b) {
+              int32 num_firsts = 0;
+              for (int64 i = block_begin(b); i < block_begin(b + 1); ++i) {
+                num_firsts += is_first[i];
+              }
+              block_ids[b + 1] = num_firsts;
+            }
+          });
+    for (int64 b = 0; b < num_blocks; ++b) {
+      block_ids[b + 1] += block_ids[b];
+    }
+    const int64 uniq_size = block_ids[num_blocks];
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({uniq_size}), &output));
+    auto output_vec = output->template vec<T>();
+    Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+          cost_per_block, [&](int64 start, int64 limit) {
+            for (int64 b = start; b < limit; ++b) {
+              int32 id = block_ids[b];
+              for (int64 i = block_begin(b); i < block_begin(b + 1); ++i) {
+                if (is_first[i]) {
+                  global_ids[partitions[i]][idx_vec(i)] = id;
+                  output_vec(id) = Tin(i);
+                  ++id;
+                }
+              }
+            }
+          });
+    Shard(worker_threads.num_threads, worker_threads.workers, N, 5,
+          [&](int64 start, int64 limit) {
+            for (int64 i = start; i < limit; ++i) {
+              idx_vec(i) = global_ids[partitions[i]][idx_vec(i)];
+            }
+          });
+
+    if (with_counts) {
+      OP_REQUIRES_OK(context, context->allocate_output(
+                                  2, TensorShape({uniq_size}), &output));
+      auto count_output_vec = output->template vec<int32>();
+      for (int p = 0; p < num_partitions; ++p) {
+        for (int32 j = 0; j < counts[p].size(); ++j) {
+          count_output_vec(global_ids[p][j]) = counts[p][j];
+        }
+      }
+    }
+  }
 };
 
 #define REGISTER_UNIQUE(type)                                    \
@@ -16,10 +16,15 @@ limitations under the License.
 #ifndef TENSORFLOW_KERNELS_VARIABLE_OPS_H_
 #define TENSORFLOW_KERNELS_VARIABLE_OPS_H_
 
+#include <atomic>
+#include <numeric>
+#include <vector>
+
 #include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/resource_mgr.h"
+#include "tensorflow/core/lib/core/bits.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/mutex.h"
@@ -34,6 +39,64 @@ class Var : public ResourceBase {
   mutex* mu() { return &mu_; }
   Tensor* tensor() { return &tensor_; }
 
+  // Once TakeDirtyRows() has been called, the updates of a resource variable
+  // record the rows they update, so that incremental checkpoints can save only
+  // those.  The Mark*() functions must be called after the update.
+
+  // Records that the rows "indices" (a tensor of Index) were updated.
+  template <typename Index>
+  void MarkDirtyRows(const Tensor& indices) {
+    if (!track_dirty_rows_.load()) return;
+    const auto indices_flat = indices.flat<Index>();
+    mutex_lock l(dirty_mu_);
+    for (int64 i = 0; i < indices_flat.size(); ++i) {
+      const int64 row = indices_flat(i);
+      if (row < 0) continue;
+      const size_t word = row / 64;
+      if (word >= dirty_rows_.size()) dirty_rows_.resize(word + 1, 0);
+      dirty_rows_[word] |= uint64{1} << (row % 64);
+    }
+  }
+
+  // Records that the whole variable was updated.
+  void MarkAllRowsDirty() {
+    if (!track_dirty_rows_.load()) return;
+    mutex_lock l(dirty_mu_);
+    all_rows_dirty_ = true;
+  }
+
+  // Returns the rows marked since the last call, in increasing order, and
+  // clears them.  The values of the rows must be read after the call.  The
+  // first call starts the tracking, and returns all the "num_rows" rows.
+  std::vector<int64> TakeDirtyRows(int64 num_rows) {
+    std::vector<int64> rows;
+    mutex_lock l(dirty_mu_);
+    if (!track_dirty_rows_.load() || all_rows_dirty_) {
+      track_dirty_rows_.store(true);
+      all_rows_dirty_ = false;
+      dirty_rows_.clear();
+      rows.resize(num_rows);
+      std::iota(rows.begin(), rows.end(), 0);
+      return rows;
+    }
+    for (size_t word = 0; word < dirty_rows_.size(); ++word) {
+      for (uint64 bits = dirty_rows_[word]; bits != 0; bits &= bits - 1) {
+        const int64 row = word * 64 + Log2Floor64(bits & (~bits + 1));
+        if (row < num_rows) rows.push_back(row);
+      }
+      dirty_rows_[word] = 0;
+    }
+    return rows;
+  }
+
+  // Reads share the variable's buffer until the variable is updated without
+  // its mutex held (e.g. by a training op with use_locking=False).  From then
+  // on, reads copy the buffer, and updates write it in place even while it
+  // is shared, since the unlocked updates still write through the buffer
+  // they got.  See PrepareToUpdateVariable().
+  bool copy_on_read_mode() const { return copy_on_read_mode_.load(); }
+  void set_copy_on_read_mode() { copy_on_read_mode_.store(true); }
+
   string DebugString() override {
     return strings::StrCat(DataTypeString(tensor_.dtype()), "/",
                            tensor_.shape().DebugString());
@@ -42,6 +105,13 @@ class Var : public ResourceBase {
  private:
   mutex mu_;
   Tensor tensor_;
+  std::atomic<bool> copy_on_read_mode_{false};
+
+  std::atomic<bool> track_dirty_rows_{false};
+  mutex dirty_mu_;
+  // The rows marked since the last TakeDirtyRows(), as a bitmap.
+  std::vector<uint64> dirty_rows_ GUARDED_BY(dirty_mu_);
+  bool all_rows_dirty_ GUARDED_BY(dirty_mu_) = false;
 
   ~Var() override {}
   TF_DISALLOW_COPY_AND_ASSIGN(Var);
@@ -31,6 +31,12 @@ limitations under the License.
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
 
+#if GOOGLE_CUDA
+#include "tensorflow/core/common_runtime/gpu/gpu_event_mgr.h"
+#include "tensorflow/core/platform/cuda.h"
+#include "tensorflow/core/platform/stream_executor.h"
+#endif  // GOOGLE_CUDA
+
 namespace tensorflow {
 
 typedef Eigen::ThreadPoolDevice CPUDevice;
@@ -96,4 +102,116 @@ class WhereOp : public OpKernel {
 
 REGISTER_WHERE();
 
+#if GOOGLE_CUDA
+
+// Counts the true elements on the device, and only copies that count back to
+// the host, to allocate the output. The indices are then written from an
+// EventMgr callback once the count arrives, so that the host doesn't block on
+// the stream, and the input never leaves the device.
+class WhereGPUOp : public AsyncOpKernel {
+ public:
+  explicit WhereGPUOp(OpKernelConstruction* context) : AsyncOpKernel(context) {}
+
+  void ComputeAsync(OpKernelContext* context, DoneCallback done) override {
+    const Tensor& input = context->input(0);
+    const int input_dims = input.dims();
+    OP_REQUIRES_ASYNC(context, input_dims >= 1 && input_dims <= 5,
+                      errors::InvalidArgument(
+                          "WhereOp : Unhandled input dimensions: ", input_dims),
+                      done);
+
+    const int64 num_tiles =
+        (input.NumElements() + functor::kWhereGpuTileSize - 1) /
+        functor::kWhereGpuTileSize;
+    if (num_tiles == 0) {
+      Tensor* output = nullptr;
+      OP_REQUIRES_OK_ASYNC(
+          context,
+          context->allocate_output(0, TensorShape({0, input_dims}), &output),
+          done);
+      done();
+      return;
+    }
+
+    auto* stream = context->op_device_context()->stream();
+    OP_REQUIRES_ASYNC(context, stream,
+                      errors::Internal("No GPU stream available."), done);
+
+    Tensor tile_offsets;
+    OP_REQUIRES_OK_ASYNC(context,
+                         context->allocate_temp(DT_INT64,
+                                                TensorShape({num_tiles}),
+                                                &tile_offsets),
+                         done);
+    Tensor num_true;
+    OP_REQUIRES_OK_ASYNC(
+        context,
+        context->allocate_temp(DT_INT64, TensorShape({}), &num_true), done);
+    functor::WhereGpuCountTrue::Compute(
+        context->eigen_device<GPUDevice>(), input.flat<bool>(),
+        tile_offsets.vec<int64>(), num_true.scalar<int64>());
+
+    AllocatorAttributes attr;
+    attr.set_on_host(true);
+    attr.set_gpu_compatible(true);
+    Tensor num_true_host;
+    OP_REQUIRES_OK_ASYNC(context,
+                         context->allocate_temp(DT_INT64, TensorShape({}),
+                                                &num_true_host, attr),
+                         done);
+    perftools::gputools::DeviceMemoryBase num_true_ptr(
+        num_true.scalar<int64>().data(), sizeof(int64));
+    OP_REQUIRES_ASYNC(
+        context,
+        stream
+            ->ThenMemcpy(num_true_host.scalar<int64>().data(), num_true_ptr,
+                         sizeof(int64))
+            .ok(),
+        errors::Internal("Failed to copy the number of true elements from "
+                         "device to host"),
+        done);
+
+    auto write_indices = [context, input, tile_offsets, num_true_host,
+                          input_dims, done]() {
+      // Launching the kernels from the EventMgr thread needs the GPU context.
+      perftools::gputools::cuda::ScopedActivateExecutorContext
+          scoped_activation(context->op_device_context()->stream()->parent());
+      const int64 num_true = num_true_host.scalar<int64>()();
+      Tensor* output = nullptr;
+      OP_REQUIRES_OK_ASYNC(
+          context,
+          context->allocate_output(0, TensorShape({num_true, input_dims}),
+                                   &output),
+          done);
+
+#define HANDLE_DIM(NDIM)                                                   \
+  case NDIM:                                                               \
+    functor::WhereGpu<NDIM>::Compute(                                      \
+        context->eigen_device<GPUDevice>(), input.tensor<bool, NDIM>(),    \
+        tile_offsets.vec<int64>(), output->matrix<int64>());               \
+    break;
+
+      switch (input_dims) {
+        HANDLE_DIM(1);
+        HANDLE_DIM(2);
+        HANDLE_DIM(3);
+        HANDLE_DIM(4);
+        HANDLE_DIM(5);
+      }
+#undef HANDLE_DIM
+
+      done();
+    };
+    context->device()->tensorflow_gpu_device_info()->event_mgr->ThenExecute(
+        stream, std::move(write_indices));
+  }
+
+ private:
+  TF_DISALLOW_COPY_AND_ASSIGN(WhereGPUOp);
+};
+
+REGISTER_KERNEL_BUILDER(Name("Where").Device(DEVICE_GPU), WhereGPUOp);
+
+#endif  // GOOGLE_CUDA
+
 }  // namespace tensorflow
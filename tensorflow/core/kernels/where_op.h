@@ -76,6 +76,33 @@ struct Where {
   }
 };
 
+#if GOOGLE_CUDA
+typedef Eigen::GpuDevice GPUDevice;
+
+// The GPU kernels split the input into tiles of kWhereGpuTileSize
+// consecutive elements, with one thread block per tile.
+constexpr int kWhereGpuBlockSize = 256;
+constexpr int kWhereGpuTileSize = kWhereGpuBlockSize * 8;
+
+// Sets tile_offsets(i) to the number of true elements before the i-th tile
+// of input, and num_true to the number of true elements overall.
+struct WhereGpuCountTrue {
+  static void Compute(const GPUDevice& d, TTypes<bool>::ConstFlat input,
+                      TTypes<int64>::Vec tile_offsets,
+                      TTypes<int64>::Scalar num_true);
+};
+
+// Writes the row-major indices of the true elements of input into output,
+// given the tile_offsets computed by WhereGpuCountTrue.
+template <int NDIM>
+struct WhereGpu {
+  static void Compute(const GPUDevice& d,
+                      typename TTypes<bool, NDIM>::ConstTensor input,
+                      TTypes<int64>::ConstVec tile_offsets,
+                      TTypes<int64>::Matrix output);
+};
+#endif  // GOOGLE_CUDA
+
 }  // namespace functor
 
 }  // namespace tensorflow
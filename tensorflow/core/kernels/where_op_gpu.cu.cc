@@ -0,0 +1,170 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if GOOGLE_CUDA
+
+#define EIGEN_USE_GPU
+
+#include "tensorflow/core/kernels/where_op.h"
+
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+namespace functor {
+
+namespace {
+
+// Number of threads of the single block that scans the tile counts.
+constexpr int kWhereGpuScanBlockSize = 1024;
+
+// Returns the sum of the values of this thread and all the threads before it
+// in the block, using temp as scratch space for blockDim.x values. Once it
+// returns, temp[blockDim.x - 1] holds the sum over the whole block, until the
+// next __syncthreads().
+template <typename T>
+__device__ T BlockInclusiveSum(T value, T* temp) {
+  const int tid = threadIdx.x;
+  temp[tid] = value;
+  __syncthreads();
+  for (int offset = 1; offset < blockDim.x; offset *= 2) {
+    const T addend = (tid >= offset) ? temp[tid - offset] : T(0);
+    __syncthreads();
+    temp[tid] += addend;
+    __syncthreads();
+  }
+  return temp[tid];
+}
+
+// Counts the true elements of each tile of input into tile_counts.
+__global__ void WhereCountTilesKernel(const bool* input, const int64 size,
+                                      int64* tile_counts) {
+  __shared__ int32 temp[kWhereGpuBlockSize];
+  const int64 tile_start = static_cast<int64>(blockIdx.x) * kWhereGpuTileSize;
+  int32 count = 0;
+  for (int i = threadIdx.x; i < kWhereGpuTileSize; i += kWhereGpuBlockSize) {
+    const int64 index = tile_start + i;
+    if (index < size && input[index]) {
+      ++count;
+    }
+  }
+  const int32 tile_count = BlockInclusiveSum(count, temp);
+  if (threadIdx.x == kWhereGpuBlockSize - 1) {
+    tile_counts[blockIdx.x] = tile_count;
+  }
+}
+
+// Turns the tile counts into their exclusive prefix sum in place, and writes
+// the overall sum to num_true. Runs as a single block, which walks through
+// the counts in runs of kWhereGpuScanBlockSize.
+__global__ void WhereScanTilesKernel(int64* tile_offsets,
+                                     const int64 num_tiles, int64* num_true) {
+  __shared__ int64 temp[kWhereGpuScanBlockSize];
+  int64 carry = 0;
+  for (int64 start = 0; start < num_tiles; start += kWhereGpuScanBlockSize) {
+    const int64 i = start + threadIdx.x;
+    const int64 count = (i < num_tiles) ? tile_offsets[i] : 0;
+    const int64 inclusive = BlockInclusiveSum(count, temp);
+    if (i < num_tiles) {
+      tile_offsets[i] = carry + inclusive - count;
+    }
+    carry += temp[kWhereGpuScanBlockSize - 1];
+    __syncthreads();
+  }
+  if (threadIdx.x == 0) {
+    *num_true = carry;
+  }
+}
+
+// Writes the row-major indices of the true elements of each tile of input,
+// starting at the output row given by tile_offsets. The tile is processed in
+// runs of one element per thread, to keep the reads coalesced, and a block
+// wide prefix sum over each run orders the writes.
+template <int NDIM>
+__global__ void WhereWriteIndicesKernel(
+    const bool* input, const int64 size, const int64* tile_offsets,
+    const Eigen::DSizes<Eigen::DenseIndex, NDIM> strides, int64* output) {
+  __shared__ int32 temp[kWhereGpuBlockSize];
+  const int64 tile_start = static_cast<int64>(blockIdx.x) * kWhereGpuTileSize;
+  int64 row = tile_offsets[blockIdx.x];
+  for (int i = 0; i < kWhereGpuTileSize; i += kWhereGpuBlockSize) {
+    if (tile_start + i >= size) {
+      break;
+    }
+    const int64 index = tile_start + i + threadIdx.x;
+    const int32 is_true = (index < size && input[index]) ? 1 : 0;
+    const int32 inclusive = BlockInclusiveSum(is_true, temp);
+    if (is_true) {
+      int64* output_row = output + (row + inclusive - 1) * NDIM;
+      int64 remainder = index;
+      for (int d = 0; d < NDIM; ++d) {
+        output_row[d] = remainder / strides[d];
+        remainder %= strides[d];
+      }
+    }
+    row += temp[kWhereGpuBlockSize - 1];
+    __syncthreads();
+  }
+}
+
+}  // namespace
+
+void WhereGpuCountTrue::Compute(const GPUDevice& d,
+                                TTypes<bool>::ConstFlat input,
+                                TTypes<int64>::Vec tile_offsets,
+                                TTypes<int64>::Scalar num_true) {
+  const int64 num_tiles = tile_offsets.size();
+  if (num_tiles == 0) {
+    num_true.device(d) = num_true.constant(0);
+    return;
+  }
+  WhereCountTilesKernel<<<num_tiles, kWhereGpuBlockSize, 0, d.stream()>>>(
+      input.data(), input.size(), tile_offsets.data());
+  WhereScanTilesKernel<<<1, kWhereGpuScanBlockSize, 0, d.stream()>>>(
+      tile_offsets.data(), num_tiles, num_true.data());
+}
+
+template <int NDIM>
+void WhereGpu<NDIM>::Compute(const GPUDevice& d,
+                             typename TTypes<bool, NDIM>::ConstTensor input,
+                             TTypes<int64>::ConstVec tile_offsets,
+                             TTypes<int64>::Matrix output) {
+  if (output.dimension(0) == 0) {
+    return;
+  }
+  const Eigen::DSizes<Eigen::DenseIndex, NDIM> dims = input.dimensions();
+  Eigen::DSizes<Eigen::DenseIndex, NDIM> strides;
+  strides[NDIM - 1] = 1;
+  for (int i = NDIM - 2; i >= 0; --i) {
+    strides[i] = strides[i + 1] * dims[i + 1];
+  }
+  WhereWriteIndicesKernel<NDIM>
+      <<<tile_offsets.size(), kWhereGpuBlockSize, 0, d.stream()>>>(
+          input.data(), input.size(), tile_offsets.data(), strides,
+          output.data());
+}
+
+template struct WhereGpu<1>;
+template struct WhereGpu<2>;
+template struct WhereGpu<3>;
+template struct WhereGpu<4>;
+template struct WhereGpu<5>;
+
+}  // namespace functor
+
+}  // namespace tensorflow
+
+#endif  // GOOGLE_CUDA
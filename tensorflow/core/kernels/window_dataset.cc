@@ -26,7 +26,7 @@ class WindowDataset : public DatasetBase {
         output_types_(std::move(output_types)),
         output_shapes_(std::move(output_shapes)) {}
 
-  std::unique_ptr<IteratorBase> MakeIterator() const override {
+  std::unique_ptr<IteratorBase> MakeIteratorInternal() const override {
     return std::unique_ptr<IteratorBase>(new Iterator(this));
   }
 
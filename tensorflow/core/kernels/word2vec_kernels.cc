@@ -13,6 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <algorithm>
+#include <memory>
+
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
@@ -23,11 +26,10 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/util/guarded_philox_random.h"
+#include "tensorflow/core/util/work_sharder.h"
 
 namespace tensorflow {
 
-// Number of examples to precalculate.
-const int kPrecalc = 3000;
 // Number of words to read into a sentence before processing.
 const int kSentenceSize = 1000;
 
@@ -48,8 +50,7 @@ bool ScanWord(StringPiece* input, string* word) {
 
 class SkipgramOp : public OpKernel {
  public:
-  explicit SkipgramOp(OpKernelConstruction* ctx)
-      : OpKernel(ctx), rng_(&philox_) {
+  explicit SkipgramOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
     string filename;
     OP_REQUIRES_OK(ctx, ctx->GetAttr("filename", &filename));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("batch_size", &batch_size_));
@@ -58,13 +59,21 @@ class SkipgramOp : public OpKernel {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("subsample", &subsample_));
     OP_REQUIRES_OK(ctx, Init(ctx->env(), filename));
 
+    // The corpus is split into contiguous ranges, each read by its own
+    // cursor and random number generator, so that a batch can be filled by
+    // several threads at once. The number of shards only depends on the
+    // worker pool, the batch and the corpus, so a given setup always
+    // produces the same examples.
+    const int num_threads =
+        ctx->device()->tensorflow_cpu_worker_threads()->num_threads;
+    const int64 num_shards = std::max<int64>(
+        1, std::min<int64>({num_threads, batch_size_,
+                            corpus_size_ / kSentenceSize}));
     mutex_lock l(mu_);
-    example_pos_ = corpus_size_;
-    label_pos_ = corpus_size_;
-    label_limit_ = corpus_size_;
-    sentence_index_ = kSentenceSize;
-    for (int i = 0; i < kPrecalc; ++i) {
-      NextExample(&precalc_examples_[i].input, &precalc_examples_[i].label);
+    for (int64 i = 0; i < num_shards; ++i) {
+      shards_.emplace_back(
+          new CorpusShard(i, corpus_size_ * i / num_shards,
+                          corpus_size_ * (i + 1) / num_shards));
     }
   }
 
@@ -78,21 +87,46 @@ class SkipgramOp : public OpKernel {
     auto Tlabels = labels.flat<int32>();
     {
       mutex_lock l(mu_);
-      for (int i = 0; i < batch_size_; ++i) {
-        Texamples(i) = precalc_examples_[precalc_index_].input;
-        Tlabels(i) = precalc_examples_[precalc_index_].label;
-        precalc_index_++;
-        if (precalc_index_ >= kPrecalc) {
-          precalc_index_ = 0;
-          for (int j = 0; j < kPrecalc; ++j) {
-            NextExample(&precalc_examples_[j].input,
-                        &precalc_examples_[j].label);
+      // Shard i fills the i-th run of the batch. When the batch doesn't
+      // split evenly, the extra examples go to a rotating set of shards, so
+      // that all of them advance through their part of the corpus at the
+      // same rate.
+      const int64 num_shards = shards_.size();
+      std::vector<int64> limits(num_shards + 1, 0);
+      for (int64 i = 0; i < num_shards; ++i) {
+        const bool extra =
+            (i - first_extra_shard_ + num_shards) % num_shards <
+            batch_size_ % num_shards;
+        limits[i + 1] = limits[i] + batch_size_ / num_shards + (extra ? 1 : 0);
+      }
+      first_extra_shard_ =
+          (first_extra_shard_ + batch_size_ % num_shards) % num_shards;
+      const std::unique_ptr<CorpusShard>* shards = shards_.data();
+      auto fill = [this, shards, &limits, &Texamples, &Tlabels](int64 begin,
+                                                                int64 end) {
+        for (int64 i = begin; i < end; ++i) {
+          for (int64 j = limits[i]; j < limits[i + 1]; ++j) {
+            NextExample(shards[i].get(), &Texamples(j), &Tlabels(j));
           }
         }
+      };
+      auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+      // Each example costs a few random numbers, plus reading a new sentence
+      // every so often.
+      const int64 cost_per_shard = 50 * batch_size_ / num_shards;
+      Shard(worker_threads->num_threads, worker_threads->workers, num_shards,
+            cost_per_shard, fill);
+
+      // An epoch is only over once every shard made it through its range.
+      int32 epoch = shards_[0]->current_epoch;
+      int64 words_processed = 0;
+      for (const auto& shard : shards_) {
+        epoch = std::min(epoch, shard->current_epoch);
+        words_processed += shard->total_words_processed;
       }
       words_per_epoch.scalar<int64>()() = corpus_size_;
-      current_epoch.scalar<int32>()() = current_epoch_;
-      total_words_processed.scalar<int64>()() = total_words_processed_;
+      current_epoch.scalar<int32>()() = epoch;
+      total_words_processed.scalar<int64>()() = words_processed;
     }
     ctx->set_output(0, word_);
     ctx->set_output(1, freq_);
@@ -104,9 +138,30 @@ class SkipgramOp : public OpKernel {
   }
 
  private:
-  struct Example {
-    int32 input;
-    int32 label;
+  // A cursor over the [begin, end) range of corpus_. Only one thread at a
+  // time works on a shard, with mu_ held by the Compute() it belongs to.
+  struct CorpusShard {
+    CorpusShard(int64 index, int32 begin, int32 end)
+        : begin(begin),
+          end(end),
+          philox(index),
+          rng(&philox),
+          example_pos(end),
+          label_pos(end),
+          label_limit(end),
+          sentence(kSentenceSize) {}
+
+    const int32 begin;
+    const int32 end;
+    random::PhiloxRandom philox;
+    random::SimplePhilox rng;
+    int32 current_epoch = -1;
+    int64 total_words_processed = 0;
+    int32 example_pos;
+    int32 label_pos;
+    int32 label_limit;
+    std::vector<int32> sentence;
+    int sentence_index = kSentenceSize;
   };
 
   int32 batch_size_ = 0;
@@ -118,62 +173,53 @@ class SkipgramOp : public OpKernel {
   Tensor freq_;
   int64 corpus_size_ = 0;
   std::vector<int32> corpus_;
-  std::vector<Example> precalc_examples_;
-  int precalc_index_ = 0;
-  std::vector<int32> sentence_;
-  int sentence_index_ = 0;
 
   mutex mu_;
-  random::PhiloxRandom philox_ GUARDED_BY(mu_);
-  random::SimplePhilox rng_ GUARDED_BY(mu_);
-  int32 current_epoch_ GUARDED_BY(mu_) = -1;
-  int64 total_words_processed_ GUARDED_BY(mu_) = 0;
-  int32 example_pos_ GUARDED_BY(mu_);
-  int32 label_pos_ GUARDED_BY(mu_);
-  int32 label_limit_ GUARDED_BY(mu_);
-
-  // {example_pos_, label_pos_} is the cursor for the next example.
-  // example_pos_ wraps around at the end of corpus_. For each
-  // example, we randomly generate [label_pos_, label_limit) for
-  // labels.
-  void NextExample(int32* example, int32* label) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  std::vector<std::unique_ptr<CorpusShard>> shards_ GUARDED_BY(mu_);
+  int64 first_extra_shard_ GUARDED_BY(mu_) = 0;
+
+  // {example_pos, label_pos} is the shard's cursor for the next example.
+  // example_pos wraps around at the end of the shard's range. For each
+  // example, we randomly generate [label_pos, label_limit) for labels.
+  void NextExample(CorpusShard* shard, int32* example, int32* label) const {
     while (true) {
-      if (label_pos_ >= label_limit_) {
-        ++total_words_processed_;
-        ++sentence_index_;
-        if (sentence_index_ >= kSentenceSize) {
-          sentence_index_ = 0;
-          for (int i = 0; i < kSentenceSize; ++i, ++example_pos_) {
-            if (example_pos_ >= corpus_size_) {
-              ++current_epoch_;
-              example_pos_ = 0;
+      if (shard->label_pos >= shard->label_limit) {
+        ++shard->total_words_processed;
+        ++shard->sentence_index;
+        if (shard->sentence_index >= kSentenceSize) {
+          shard->sentence_index = 0;
+          for (int i = 0; i < kSentenceSize; ++i, ++shard->example_pos) {
+            if (shard->example_pos >= shard->end) {
+              ++shard->current_epoch;
+              shard->example_pos = shard->begin;
             }
             if (subsample_ > 0) {
-              int32 word_freq = freq_.flat<int32>()(corpus_[example_pos_]);
+              int32 word_freq =
+                  freq_.flat<int32>()(corpus_[shard->example_pos]);
               // See Eq. 5 in http://arxiv.org/abs/1310.4546
               float keep_prob =
                   (std::sqrt(word_freq / (subsample_ * corpus_size_)) + 1) *
                   (subsample_ * corpus_size_) / word_freq;
-              if (rng_.RandFloat() > keep_prob) {
+              if (shard->rng.RandFloat() > keep_prob) {
                 i--;
                 continue;
               }
             }
-            sentence_[i] = corpus_[example_pos_];
+            shard->sentence[i] = corpus_[shard->example_pos];
           }
         }
-        const int32 skip = 1 + rng_.Uniform(window_size_);
-        label_pos_ = std::max<int32>(0, sentence_index_ - skip);
-        label_limit_ =
-            std::min<int32>(kSentenceSize, sentence_index_ + skip + 1);
+        const int32 skip = 1 + shard->rng.Uniform(window_size_);
+        shard->label_pos = std::max<int32>(0, shard->sentence_index - skip);
+        shard->label_limit =
+            std::min<int32>(kSentenceSize, shard->sentence_index + skip + 1);
       }
-      if (sentence_index_ != label_pos_) {
+      if (shard->sentence_index != shard->label_pos) {
         break;
       }
-      ++label_pos_;
+      ++shard->label_pos;
     }
-    *example = sentence_[sentence_index_];
-    *label = sentence_[label_pos_++];
+    *example = shard->sentence[shard->sentence_index];
+    *label = shard->sentence[shard->label_pos++];
   }
 
   Status Init(Env* env, const string& filename) {
@@ -230,8 +276,6 @@ class SkipgramOp : public OpKernel {
     while (ScanWord(&input, &w)) {
       corpus_.push_back(gtl::FindWithDefault(word_id, w, kUnkId));
     }
-    precalc_examples_.resize(kPrecalc);
-    sentence_.resize(kSentenceSize);
     return Status::OK();
   }
 };
@@ -288,60 +332,89 @@ class NegTrainOp : public OpKernel {
                 errors::InvalidArgument("vocab_size mismatches: ", vocab_size,
                                         " vs. ", sampler_->num()));
 
-    // Gradient accumulator for v_in.
-    Tensor buf(DT_FLOAT, TensorShape({dims}));
-    auto Tbuf = buf.flat<float>();
-
-    // Scalar buffer to hold sigmoid(+/- dot).
-    Tensor g_buf(DT_FLOAT, TensorShape({}));
-    auto g = g_buf.scalar<float>();
+    // The examples are trained on in Hogwild! style
+    // (https://arxiv.org/abs/1106.5730): the batch is split into blocks that
+    // run in parallel and update w_in and w_out without any locking. Each
+    // example only touches a handful of rows, so concurrent updates of the
+    // same row are rare, and lost ones barely slow down convergence.
+    auto worker_threads = ctx->device()->tensorflow_cpu_worker_threads();
+    const int64 num_blocks = std::max<int64>(
+        1, std::min<int64>(batch_size, worker_threads->num_threads));
 
     // The following loop needs 2 random 32-bit values per negative
     // sample.  We reserve 8 values per sample just in case the
-    // underlying implementation changes.
-    auto rnd = base_.ReserveSamples32(batch_size * num_samples_ * 8);
-    random::SimplePhilox srnd(&rnd);
-
-    for (int64 i = 0; i < batch_size; ++i) {
-      const int32 example = Texamples(i);
-      DCHECK(0 <= example && example < vocab_size) << example;
-      const int32 label = Tlabels(i);
-      DCHECK(0 <= label && label < vocab_size) << label;
-      auto v_in = Tw_in.chip<0>(example);
-
-      // Positive: example predicts label.
-      //   forward: x = v_in' * v_out
-      //            l = log(sigmoid(x))
-      //   backward: dl/dx = g = sigmoid(-x)
-      //             dl/d(v_in) = g * v_out'
-      //             dl/d(v_out) = v_in' * g
-      {
-        auto v_out = Tw_out.chip<0>(label);
-        auto dot = (v_in * v_out).sum();
-        g = (dot.exp() + 1.f).inverse();
-        Tbuf = v_out * (g() * lr);
-        v_out += v_in * (g() * lr);
-      }
+    // underlying implementation changes. The reservations are made upfront,
+    // so that each block gets its own generator.
+    std::vector<random::PhiloxRandom> rnds;
+    rnds.reserve(num_blocks);
+    for (int64 b = 0; b < num_blocks; ++b) {
+      const int64 block_size = (batch_size * (b + 1)) / num_blocks -
+                               (batch_size * b) / num_blocks;
+      rnds.push_back(base_.ReserveSamples32(block_size * num_samples_ * 8));
+    }
 
-      // Negative samples:
-      //   forward: x = v_in' * v_sample
-      //            l = log(sigmoid(-x))
-      //   backward: dl/dx = g = -sigmoid(x)
-      //             dl/d(v_in) = g * v_out'
-      //             dl/d(v_out) = v_in' * g
-      for (int j = 0; j < num_samples_; ++j) {
-        const int sample = sampler_->Sample(&srnd);
-        if (sample == label) continue;  // Skip.
-        auto v_sample = Tw_out.chip<0>(sample);
-        auto dot = (v_in * v_sample).sum();
-        g = -((-dot).exp() + 1.f).inverse();
-        Tbuf += v_sample * (g() * lr);
-        v_sample += v_in * (g() * lr);
-      }
+    auto train = [this, &rnds, &Tw_in, &Tw_out, &Texamples, &Tlabels, lr,
+                  vocab_size, dims, batch_size, num_blocks](int64 begin_block,
+                                                            int64 end_block) {
+      // Gradient accumulator for v_in.
+      Tensor buf(DT_FLOAT, TensorShape({dims}));
+      auto Tbuf = buf.flat<float>();
+
+      // Scalar buffer to hold sigmoid(+/- dot).
+      Tensor g_buf(DT_FLOAT, TensorShape({}));
+      auto g = g_buf.scalar<float>();
+
+      for (int64 b = begin_block; b < end_block; ++b) {
+        random::SimplePhilox srnd(&rnds[b]);
+        const int64 begin = (batch_size * b) / num_blocks;
+        const int64 end = (batch_size * (b + 1)) / num_blocks;
+        for (int64 i = begin; i < end; ++i) {
+          const int32 example = Texamples(i);
+          DCHECK(0 <= example && example < vocab_size) << example;
+          const int32 label = Tlabels(i);
+          DCHECK(0 <= label && label < vocab_size) << label;
+          auto v_in = Tw_in.chip<0>(example);
+
+          // Positive: example predicts label.
+          //   forward: x = v_in' * v_out
+          //            l = log(sigmoid(x))
+          //   backward: dl/dx = g = sigmoid(-x)
+          //             dl/d(v_in) = g * v_out'
+          //             dl/d(v_out) = v_in' * g
+          {
+            auto v_out = Tw_out.chip<0>(label);
+            auto dot = (v_in * v_out).sum();
+            g = (dot.exp() + 1.f).inverse();
+            Tbuf = v_out * (g() * lr);
+            v_out += v_in * (g() * lr);
+          }
 
-      // Applies the gradient on v_in.
-      v_in += Tbuf;
-    }
+          // Negative samples:
+          //   forward: x = v_in' * v_sample
+          //            l = log(sigmoid(-x))
+          //   backward: dl/dx = g = -sigmoid(x)
+          //             dl/d(v_in) = g * v_out'
+          //             dl/d(v_out) = v_in' * g
+          for (int j = 0; j < num_samples_; ++j) {
+            const int sample = sampler_->Sample(&srnd);
+            if (sample == label) continue;  // Skip.
+            auto v_sample = Tw_out.chip<0>(sample);
+            auto dot = (v_in * v_sample).sum();
+            g = -((-dot).exp() + 1.f).inverse();
+            Tbuf += v_sample * (g() * lr);
+            v_sample += v_in * (g() * lr);
+          }
+
+          // Applies the gradient on v_in.
+          v_in += Tbuf;
+        }
+      }
+    };
+    // Each example takes a few passes over (num_samples_ + 1) rows.
+    const int64 cost_per_block =
+        (batch_size / num_blocks + 1) * (num_samples_ + 1) * dims * 8;
+    Shard(worker_threads->num_threads, worker_threads->workers, num_blocks,
+          cost_per_block, train);
   }
 
  private:
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/core/framework/register_types.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/kernels/softmax_cpu_impl.h"
 
 namespace tensorflow {
 
@@ -92,6 +93,23 @@ struct XentFunctorBase {
 template <typename T>
 struct XentFunctor<CPUDevice, T> : XentFunctorBase<CPUDevice, T> {};
 
+// float and double use the fused row-wise implementation instead, which
+// doesn't need the scratch space.
+template <typename T>
+struct XentFunctorCPU {
+  void operator()(const CPUDevice& d, typename TTypes<T>::ConstMatrix logits,
+                  typename TTypes<T>::ConstMatrix labels,
+                  typename TTypes<T>::Matrix scratch,
+                  typename TTypes<T>::Vec loss,
+                  typename TTypes<T>::Matrix backprop) {
+    softmax_cpu::SoftmaxCrossEntropy<T>(d, logits, labels, loss, backprop);
+  }
+};
+template <>
+struct XentFunctor<CPUDevice, float> : XentFunctorCPU<float> {};
+template <>
+struct XentFunctor<CPUDevice, double> : XentFunctorCPU<double> {};
+
 #ifdef TENSORFLOW_USE_SYCL
 template <typename T>
 struct XentFunctor<SYCLDevice, T> : XentFunctorBase<SYCLDevice, T> {};
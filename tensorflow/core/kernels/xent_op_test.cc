@@ -58,4 +58,7 @@ BM_XentDev(16, 10000, cpu);
 BM_XentDev(32, 10000, cpu);
 BM_XentDev(64, 10000, cpu);
 
+/// A single long row, which the CPU kernel splits over several threads
+BM_XentDev(1, 100000, cpu);
+
 }  // end namespace tensorflow
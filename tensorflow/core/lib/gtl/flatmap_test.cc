@@ -20,7 +20,10 @@ limitations under the License.
 #include <unordered_map>
 #include <vector>
 #include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/types.h"
 
 namespace tensorflow {
@@ -688,6 +691,102 @@ TEST(FlatMap, UniqueMapIter) {
   EXPECT_EQ(val_sum, key_sum + (kCount * kValueDelta));
 }
 
+// Benchmarks against std::unordered_map, with keys like the runtime's: dense
+// ids (e.g. node and edge ids), and node names.
+
+std::vector<int64> IdKeys(int start, int limit) {
+  std::vector<int64> keys;
+  for (int i = start; i < limit; i++) keys.push_back(i);
+  return keys;
+}
+
+std::vector<string> NameKeys(int start, int limit) {
+  std::vector<string> keys;
+  for (int i = start; i < limit; i++) {
+    keys.push_back(strings::StrCat("gradients/layer_", i % 16, "/MatMul_", i));
+  }
+  return keys;
+}
+
+// Inserts the keys [0,n) into new maps.
+template <typename Map, typename Key>
+void BenchmarkInsert(int iters, int n,
+                     std::vector<Key> (*make_keys)(int, int)) {
+  testing::StopTiming();
+  const std::vector<Key> keys = make_keys(0, n);
+  testing::StartTiming();
+  while (iters > 0) {
+    Map map;
+    for (int i = 0; i < n && iters > 0; i++, iters--) {
+      map[keys[i]] = i;
+    }
+  }
+}
+
+// Looks up the keys [start,start+n) in a map of the keys [0,n).
+template <typename Map, typename Key>
+void BenchmarkFind(int iters, int n, int start,
+                   std::vector<Key> (*make_keys)(int, int)) {
+  testing::StopTiming();
+  const std::vector<Key> keys = make_keys(0, n);
+  const std::vector<Key> lookups = make_keys(start, start + n);
+  Map map;
+  for (int i = 0; i < n; i++) map[keys[i]] = i;
+  testing::StartTiming();
+  int64 found = 0;
+  for (int i = 0; i < iters; i++) {
+    found += map.count(lookups[i % n]);
+  }
+  testing::StopTiming();
+  VLOG(1) << found;
+}
+
+typedef FlatMap<int64, int64> FlatIdMap;
+typedef std::unordered_map<int64, int64> StdIdMap;
+typedef FlatMap<string, int64> FlatNameMap;
+typedef std::unordered_map<string, int64> StdNameMap;
+
+static void BM_FlatMapIdInsert(int iters, int n) {
+  BenchmarkInsert<FlatIdMap>(iters, n, IdKeys);
+}
+static void BM_UnorderedMapIdInsert(int iters, int n) {
+  BenchmarkInsert<StdIdMap>(iters, n, IdKeys);
+}
+static void BM_FlatMapIdFind(int iters, int n) {
+  BenchmarkFind<FlatIdMap>(iters, n, 0, IdKeys);
+}
+static void BM_UnorderedMapIdFind(int iters, int n) {
+  BenchmarkFind<StdIdMap>(iters, n, 0, IdKeys);
+}
+static void BM_FlatMapNameInsert(int iters, int n) {
+  BenchmarkInsert<FlatNameMap>(iters, n, NameKeys);
+}
+static void BM_UnorderedMapNameInsert(int iters, int n) {
+  BenchmarkInsert<StdNameMap>(iters, n, NameKeys);
+}
+static void BM_FlatMapNameFind(int iters, int n) {
+  BenchmarkFind<FlatNameMap>(iters, n, 0, NameKeys);
+}
+static void BM_UnorderedMapNameFind(int iters, int n) {
+  BenchmarkFind<StdNameMap>(iters, n, 0, NameKeys);
+}
+static void BM_FlatMapNameMiss(int iters, int n) {
+  BenchmarkFind<FlatNameMap>(iters, n, n, NameKeys);
+}
+static void BM_UnorderedMapNameMiss(int iters, int n) {
+  BenchmarkFind<StdNameMap>(iters, n, n, NameKeys);
+}
+BENCHMARK(BM_FlatMapIdInsert)->Arg(10)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_UnorderedMapIdInsert)->Arg(10)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_FlatMapIdFind)->Arg(10)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_UnorderedMapIdFind)->Arg(10)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_FlatMapNameInsert)->Arg(10)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_UnorderedMapNameInsert)->Arg(10)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_FlatMapNameFind)->Arg(10)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_UnorderedMapNameFind)->Arg(10)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_FlatMapNameMiss)->Arg(10)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_UnorderedMapNameMiss)->Arg(10)->Arg(1000)->Arg(100000);
+
 }  // namespace
 }  // namespace gtl
 }  // namespace tensorflow
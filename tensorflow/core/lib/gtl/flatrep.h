@@ -18,6 +18,8 @@ limitations under the License.
 
 #include <string.h>
 #include <utility>
+#include "tensorflow/core/lib/core/bits.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/prefetch.h"
 #include "tensorflow/core/platform/types.h"
 
@@ -39,6 +41,11 @@ namespace internal {
 //      These hash bits can be used to avoid potentially expensive
 //      key comparisons.
 //
+// Lookups probe a whole bucket at a time: the kWidth markers of a bucket
+// are loaded as one word and compared against the marker of the key in
+// parallel, so that only the keys with a matching marker are compared.
+// A probe sequence ends at the first bucket with an empty entry.
+//
 // FlatMap passes in a bucket that contains keys and values, FlatSet
 // passes in a bucket that does not contain values.
 template <typename Key, typename Bucket, class Hash, class Eq>
@@ -47,6 +54,7 @@ class FlatRep {
   // kWidth is the number of entries stored in a bucket.
   static const uint32 kBase = 3;
   static const uint32 kWidth = (1 << kBase);
+  static_assert(kWidth == sizeof(uint64), "Markers must fill one word");
 
   FlatRep(size_t N, const Hash& hf, const Eq& eq) : hash_(hf), equal_(eq) {
     Init(N);
@@ -117,22 +125,24 @@ class FlatRep {
 
   // Hash value is partitioned as follows:
   // 1. Bottom 8 bits are stored in bucket to help speed up comparisons.
-  // 2. Next 3 bits give index inside bucket.
-  // 3. Remaining bits give bucket number.
+  // 2. Remaining bits give the first bucket number to probe.
 
   // Find bucket/index for key k.
   SearchResult Find(const Key& k) const {
-    size_t h = hash_(k);
+    size_t h = Mix(hash_(k));
     const uint32 marker = Marker(h & 0xff);
-    size_t index = (h >> 8) & mask_;  // Holds bucket num and index-in-bucket
-    uint32 num_probes = 1;            // Needed for quadratic probing
+    size_t index = (h >> 8) & bucket_mask();  // Bucket num
+    uint32 num_probes = 1;                    // Needed for quadratic probing
     while (true) {
-      uint32 bi = index & (kWidth - 1);
-      Bucket* b = &array_[index >> kBase];
-      const uint32 x = b->marker[bi];
-      if (x == marker && equal_(b->key(bi), k)) {
-        return {true, b, bi};
-      } else if (x == kEmpty) {
+      Bucket* b = &array_[index];
+      const uint64 markers = LoadMarkers(b);
+      for (uint64 m = Match(markers, marker); m != 0; m &= m - 1) {
+        const uint32 bi = FirstMatch(m);
+        if (equal_(b->key(bi), k)) {
+          return {true, b, bi};
+        }
+      }
+      if (Match(markers, kEmpty) != 0) {
         return {false, nullptr, 0};
       }
       index = NextIndex(index, num_probes);
@@ -147,29 +157,39 @@ class FlatRep {
   // below to use an rvalue constructor if available.
   template <typename KeyType>
   SearchResult FindOrInsert(KeyType&& k) {
-    size_t h = hash_(k);
+    size_t h = Mix(hash_(k));
     const uint32 marker = Marker(h & 0xff);
-    size_t index = (h >> 8) & mask_;  // Holds bucket num and index-in-bucket
-    uint32 num_probes = 1;            // Needed for quadratic probing
-    Bucket* del = nullptr;            // First encountered deletion for kInsert
+    size_t index = (h >> 8) & bucket_mask();  // Bucket num
+    uint32 num_probes = 1;                    // Needed for quadratic probing
+    Bucket* del = nullptr;  // First encountered deletion for kInsert
     uint32 di = 0;
     while (true) {
-      uint32 bi = index & (kWidth - 1);
-      Bucket* b = &array_[index >> kBase];
-      const uint32 x = b->marker[bi];
-      if (x == marker && equal_(b->key(bi), k)) {
-        return {true, b, bi};
-      } else if (!del && x == kDeleted) {
+      Bucket* b = &array_[index];
+      const uint64 markers = LoadMarkers(b);
+      for (uint64 m = Match(markers, marker); m != 0; m &= m - 1) {
+        const uint32 bi = FirstMatch(m);
+        if (equal_(b->key(bi), k)) {
+          return {true, b, bi};
+        }
+      }
+      if (!del) {
         // Remember deleted index to use for insertion.
-        del = b;
-        di = bi;
-      } else if (x == kEmpty) {
+        const uint64 m = Match(markers, kDeleted);
+        if (m != 0) {
+          del = b;
+          di = FirstMatch(m);
+        }
+      }
+      const uint64 empty = Match(markers, kEmpty);
+      if (empty != 0) {
+        uint32 bi;
         if (del) {
           // Store in the first deleted slot we encountered
           b = del;
           bi = di;
           deleted_--;  // not_empty_ does not change
         } else {
+          bi = FirstMatch(empty);
           not_empty_++;
         }
         b->marker[bi] = marker;
@@ -183,18 +203,24 @@ class FlatRep {
 
   void Erase(Bucket* b, uint32 i) {
     b->Destroy(i);
-    b->marker[i] = kDeleted;
-    deleted_++;
+    if (Match(LoadMarkers(b), kEmpty) != 0) {
+      // Probe sequences end at b, so none continues past it, and the entry
+      // can be emptied instead of remaining as a deletion.
+      b->marker[i] = kEmpty;
+      not_empty_--;
+    } else {
+      b->marker[i] = kDeleted;
+      deleted_++;
+    }
     grow_ = 0;  // Consider shrinking on next insert
   }
 
   void Prefetch(const Key& k) const {
-    size_t h = hash_(k);
-    size_t index = (h >> 8) & mask_;  // Holds bucket num and index-in-bucket
-    uint32 bi = index & (kWidth - 1);
-    Bucket* b = &array_[index >> kBase];
-    port::prefetch<port::PREFETCH_HINT_T0>(&b->marker[bi]);
-    port::prefetch<port::PREFETCH_HINT_T0>(&b->storage.key[bi]);
+    size_t h = Mix(hash_(k));
+    size_t index = (h >> 8) & bucket_mask();  // Bucket num
+    Bucket* b = &array_[index];
+    port::prefetch<port::PREFETCH_HINT_T0>(&b->marker[0]);
+    port::prefetch<port::PREFETCH_HINT_T0>(&b->storage.key[0]);
   }
 
   inline void MaybeResize() {
@@ -238,6 +264,42 @@ class FlatRep {
   // store in Bucket::marker[].
   static uint32 Marker(uint32 hb) { return hb + (hb < 2 ? 2 : 0); }
 
+  // Spreads the bits of the user-supplied hash, which may be weak: e.g.
+  // std::hash of an integer is the integer, so that dense keys would share
+  // their markers and first buckets.
+  static size_t Mix(size_t h) {
+    uint64 x = h;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    return static_cast<size_t>(x);
+  }
+
+  size_t bucket_mask() const { return mask_ >> kBase; }
+
+  // Returns the markers of the entries of b, entry i in byte i of the word
+  // in memory order.
+  static uint64 LoadMarkers(const Bucket* b) {
+    uint64 markers;
+    memcpy(&markers, b->marker, sizeof(markers));
+    return markers;
+  }
+
+  // Returns a word with the high bit set in exactly the bytes of markers
+  // equal to marker, and all other bits clear.
+  static uint64 Match(uint64 markers, uint32 marker) {
+    const uint64 kLow7 = 0x7f7f7f7f7f7f7f7full;
+    const uint64 x = markers ^ (0x0101010101010101ull * marker);
+    return ~(((x & kLow7) + kLow7) | x | kLow7);
+  }
+
+  // Returns the index of the entry of the lowest set bit of a non-zero
+  // result of Match.
+  static uint32 FirstMatch(uint64 m) {
+    const uint32 byte = Log2Floor64(m & (~m + 1)) >> 3;
+    return port::kLittleEndian ? byte : kWidth - 1 - byte;
+  }
+
   void Init(size_t N) {
     // Make enough room for N elements.
     size_t lg = 0;  // Smallest table is just one bucket.
@@ -299,15 +361,15 @@ class FlatRep {
   // in the table.
   template <typename Copier>
   void FreshInsert(Bucket* src, uint32 src_index, Copier copier) {
-    size_t h = hash_(src->key(src_index));
+    size_t h = Mix(hash_(src->key(src_index)));
     const uint32 marker = Marker(h & 0xff);
-    size_t index = (h >> 8) & mask_;  // Holds bucket num and index-in-bucket
-    uint32 num_probes = 1;            // Needed for quadratic probing
+    size_t index = (h >> 8) & bucket_mask();  // Bucket num
+    uint32 num_probes = 1;                    // Needed for quadratic probing
     while (true) {
-      uint32 bi = index & (kWidth - 1);
-      Bucket* b = &array_[index >> kBase];
-      const uint32 x = b->marker[bi];
-      if (x == 0) {
+      Bucket* b = &array_[index];
+      const uint64 empty = Match(LoadMarkers(b), kEmpty);
+      if (empty != 0) {
+        const uint32 bi = FirstMatch(empty);
         b->marker[bi] = marker;
         not_empty_++;
         copier(b, bi, src, src_index);
@@ -319,8 +381,8 @@ class FlatRep {
   }
 
   inline size_t NextIndex(size_t i, uint32 num_probes) const {
-    // Quadratic probing.
-    return (i + num_probes) & mask_;
+    // Quadratic probing over buckets.
+    return (i + num_probes) & bucket_mask();
   }
 };
 
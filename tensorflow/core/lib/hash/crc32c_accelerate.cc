@@ -15,8 +15,10 @@ limitations under the License.
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
-// SSE4.2 accelerated CRC32c.
+// CRC32c accelerated with the SSE4.2 crc32 instructions on x86-64, and with
+// the ARMv8 CRC32 instructions on aarch64 Linux.
 
 // See if the SSE4.2 crc32c instruction is available.
 #undef USE_SSE_CRC32C
@@ -37,14 +39,30 @@ limitations under the License.
 #undef USE_SSE_CRC32C
 #endif
 
+// See if the ARMv8 crc32c instructions are available. Whether the CPU
+// implements them is only known at run time, through the hwcaps of Linux.
+#undef USE_ARM_CRC32C
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32) && \
+    defined(__linux__) && !defined(__ARM_BIG_ENDIAN)
+#define USE_ARM_CRC32C 1
+#endif
+
 #ifdef USE_SSE_CRC32C
 #include <nmmintrin.h>
 #endif
 
+#ifdef USE_ARM_CRC32C
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#endif
+
 namespace tensorflow {
 namespace crc32c {
 
-#ifndef USE_SSE_CRC32C
+#if !defined(USE_SSE_CRC32C) && !defined(USE_ARM_CRC32C)
 
 bool CanAccelerate() { return false; }
 uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
@@ -54,8 +72,128 @@ uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
 
 #else
 
-// SSE4.2 optimized crc32c computation.
+namespace {
+
+#ifdef USE_SSE_CRC32C
+inline uint32_t Crc32cByte(uint32_t crc, uint8_t v) {
+  return _mm_crc32_u8(crc, v);
+}
+inline uint32_t Crc32cWord(uint32_t crc, uint64_t v) {
+  return static_cast<uint32_t>(_mm_crc32_u64(crc, v));
+}
+#else
+inline uint32_t Crc32cByte(uint32_t crc, uint8_t v) {
+  return __crc32cb(crc, v);
+}
+inline uint32_t Crc32cWord(uint32_t crc, uint64_t v) {
+  return __crc32cd(crc, v);
+}
+#endif
+
+inline uint64_t LoadWord(const uint8_t *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// The crc32 instructions take three cycles, but a new one can start every
+// cycle. A single chain of them is thus limited to a third of the possible
+// throughput, so large buffers are processed as three interleaved streams
+// of consecutive blocks, whose crcs are then combined. Long blocks amortize
+// the combination, and short blocks shorten the remainder processed by a
+// single chain.
+const size_t kLongBlock = 8192;
+const size_t kShortBlock = 256;
+
+// The (reflected) Castagnoli polynomial.
+const uint32_t kPolynomial = 0x82f63b78u;
+
+// Returns the product of the 32x32 matrix over GF(2) "mat", given by its
+// columns, and "vec".
+uint32_t Gf2MatrixTimes(const uint32_t *mat, uint32_t vec) {
+  uint32_t sum = 0;
+  for (; vec != 0; vec >>= 1, ++mat) {
+    if (vec & 1) sum ^= *mat;
+  }
+  return sum;
+}
+
+// Sets "mat" to its square.
+void Gf2MatrixSquare(uint32_t *mat) {
+  uint32_t square[32];
+  for (int n = 0; n < 32; ++n) square[n] = Gf2MatrixTimes(mat, mat[n]);
+  memcpy(mat, square, sizeof(square));
+}
+
+// Shifts a crc register over "len" zero bytes. Since the crc is linear,
+// the crc of the concatenation of a and b is the crc of a shifted over the
+// length of b, xor the crc of b computed from a zero register.
+class ZerosShift {
+ public:
+  explicit ZerosShift(size_t len) {
+    // The operator for one zero bit, squared three times to one zero byte.
+    uint32_t op[32];
+    op[0] = kPolynomial;
+    for (int n = 1; n < 32; ++n) op[n] = 1u << (n - 1);
+    for (int i = 0; i < 3; ++i) Gf2MatrixSquare(op);
+
+    // Compose the powers of two of the operator for the bits of "len".
+    uint32_t shift[32];
+    for (int n = 0; n < 32; ++n) shift[n] = 1u << n;
+    while (len != 0) {
+      if (len & 1) {
+        for (int n = 0; n < 32; ++n) shift[n] = Gf2MatrixTimes(op, shift[n]);
+      }
+      len >>= 1;
+      if (len != 0) Gf2MatrixSquare(op);
+    }
+
+    for (int k = 0; k < 4; ++k) {
+      for (uint32_t b = 0; b < 256; ++b) {
+        table_[k][b] = Gf2MatrixTimes(shift, b << (8 * k));
+      }
+    }
+  }
+
+  uint32_t operator()(uint32_t crc) const {
+    return table_[0][crc & 0xff] ^ table_[1][(crc >> 8) & 0xff] ^
+           table_[2][(crc >> 16) & 0xff] ^ table_[3][crc >> 24];
+  }
+
+ private:
+  uint32_t table_[4][256];
+};
+
+// Extends "crc" with consecutive groups of three blocks of "block" bytes
+// of p, while they fit before e. p must be 8-byte aligned.
+inline uint32_t ExtendThreeWay(uint32_t crc, size_t block,
+                               const ZerosShift &shift, const uint8_t **p,
+                               const uint8_t *e) {
+  while (static_cast<size_t>(e - *p) >= 3 * block) {
+    const uint8_t *q = *p;
+    const uint8_t *end = q + block;
+    uint32_t crc0 = crc;
+    uint32_t crc1 = 0;
+    uint32_t crc2 = 0;
+    do {
+      crc0 = Crc32cWord(crc0, LoadWord(q));
+      crc1 = Crc32cWord(crc1, LoadWord(q + block));
+      crc2 = Crc32cWord(crc2, LoadWord(q + 2 * block));
+      q += 8;
+    } while (q != end);
+    crc = shift(shift(crc0) ^ crc1) ^ crc2;
+    *p += 3 * block;
+  }
+  return crc;
+}
+
+}  // namespace
+
+#ifdef USE_SSE_CRC32C
 bool CanAccelerate() { return __builtin_cpu_supports("sse4.2"); }
+#else
+bool CanAccelerate() { return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0; }
+#endif
 
 uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
   const uint8_t *p = reinterpret_cast<const uint8_t *>(buf);
@@ -70,23 +208,29 @@ uint32_t AcceleratedExtend(uint32_t crc, const char *buf, size_t size) {
   if (x <= e) {
     // Process bytes until finished or p is 8-byte aligned
     while (p != x) {
-      l = _mm_crc32_u8(l, *p);
+      l = Crc32cByte(l, *p);
       p++;
     }
   }
 
+  // Process large buffers as three streams.
+  if (static_cast<size_t>(e - p) >= 3 * kShortBlock) {
+    static const ZerosShift *long_shift = new ZerosShift(kLongBlock);
+    static const ZerosShift *short_shift = new ZerosShift(kShortBlock);
+    l = ExtendThreeWay(l, kLongBlock, *long_shift, &p, e);
+    l = ExtendThreeWay(l, kShortBlock, *short_shift, &p, e);
+  }
+
   // Process bytes 16 at a time
-  uint64_t l64 = l;
   while ((e - p) >= 16) {
-    l64 = _mm_crc32_u64(l64, *reinterpret_cast<const uint64_t *>(p));
-    l64 = _mm_crc32_u64(l64, *reinterpret_cast<const uint64_t *>(p + 8));
+    l = Crc32cWord(l, LoadWord(p));
+    l = Crc32cWord(l, LoadWord(p + 8));
     p += 16;
   }
 
   // Process remaining bytes one at a time.
-  l = l64;
   while (p < e) {
-    l = _mm_crc32_u8(l, *p);
+    l = Crc32cByte(l, *p);
     p++;
   }
 
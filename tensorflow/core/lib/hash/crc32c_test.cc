@@ -62,6 +62,43 @@ TEST(CRC, Extend) {
   ASSERT_EQ(Value("hello world", 11), Extend(Value("hello ", 6), "world", 5));
 }
 
+// Computes the crc one bit at a time.
+static uint32 BitwiseValue(const char* data, size_t n) {
+  uint32 crc = 0xffffffffu;
+  for (size_t i = 0; i < n; i++) {
+    crc ^= static_cast<uint8>(data[i]);
+    for (int k = 0; k < 8; k++) {
+      crc = (crc >> 1) ^ (0x82f63b78u & (0u - (crc & 1)));
+    }
+  }
+  return crc ^ 0xffffffffu;
+}
+
+TEST(CRC, LargeUnaligned) {
+  // Covers the sizes at which the accelerated code changes strategy.
+  const size_t kSizes[] = {0,    1,     15,    16,    767,   768,
+                           769,  24575, 24576, 24577, 25357, 100000};
+  std::string input(100000 + 8, 0);
+  uint32 x = 1;
+  for (size_t i = 0; i < input.size(); i++) {
+    x = x * 1103515245 + 12345;
+    input[i] = static_cast<char>(x >> 24);
+  }
+  for (size_t size : kSizes) {
+    for (size_t offset = 0; offset < 8; offset++) {
+      const char* data = input.data() + offset;
+      const uint32 expected = BitwiseValue(data, size);
+      ASSERT_EQ(expected, Value(data, size)) << size << " " << offset;
+      const size_t split = size / 3 + offset;
+      if (split <= size) {
+        ASSERT_EQ(expected,
+                  Extend(Value(data, split), data + split, size - split))
+            << size << " " << offset;
+      }
+    }
+  }
+}
+
 TEST(CRC, Mask) {
   uint32 crc = Value("foo", 3);
   ASSERT_NE(crc, Mask(crc));
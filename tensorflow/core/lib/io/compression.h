@@ -16,12 +16,19 @@ limitations under the License.
 #ifndef THIRD_PARTY_TENSORFLOW_CORE_LIB_IO_COMPRESSION_H_
 #define THIRD_PARTY_TENSORFLOW_CORE_LIB_IO_COMPRESSION_H_
 
+#include <stddef.h>
+
 namespace tensorflow {
 namespace io {
 namespace compression {
 
 extern const char kNone[];
 extern const char kGzip[];
+extern const char kSnappy[];
+
+// The largest number of uncompressed bytes in each independently compressed
+// block of a SNAPPY compressed record file.
+constexpr size_t kSnappyBlockSize = 256 << 10;
 
 }
 }
@@ -16,17 +16,196 @@ limitations under the License.
 #include "tensorflow/core/lib/io/record_reader.h"
 
 #include <limits.h>
+#include <string.h>
+
+#include <algorithm>
 
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
 #include "tensorflow/core/lib/io/compression.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
+#if !defined(IS_SLIM_BUILD)
+#include "tensorflow/core/lib/io/snappy/snappy_inputbuffer.h"
+#include "tensorflow/core/lib/io/zlib_inputstream.h"
+#endif  // IS_SLIM_BUILD
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 
 namespace tensorflow {
 namespace io {
 
+namespace {
+
+// Chunks are read from offsets that are a multiple of this, where possible.
+constexpr uint64 kReadAlignment = 4096;
+
+// A RandomAccessFile that serves reads of `file` from a chunk of at least
+// `buffer_size` bytes. If `read_ahead` is true, the chunk that follows the
+// current chunk is read on a background thread, so that a sequential reader
+// rarely waits for `file`.
+class BufferedRandomAccessFile : public RandomAccessFile {
+ public:
+  BufferedRandomAccessFile(RandomAccessFile* file, size_t buffer_size,
+                           bool read_ahead)
+      : file_(file), buffer_size_(buffer_size), read_ahead_(read_ahead) {}
+
+  ~BufferedRandomAccessFile() override {
+    {
+      mutex_lock l(mu_);
+      cancelled_ = true;
+      cond_var_.notify_all();
+    }
+    // Join the read-ahead thread before the chunks are destroyed.
+    read_ahead_thread_.reset();
+  }
+
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    mutex_lock l(mu_);
+    size_t copied = 0;
+    Status s;
+    while (copied < n) {
+      const uint64 pos = offset + copied;
+      if (!Contains(current_, pos)) {
+        if (pos >= eof_offset_) {
+          break;
+        }
+        s = FillCurrent(pos, &l);
+        if (!s.ok() || !Contains(current_, pos)) {
+          break;
+        }
+      }
+      // Copy into `scratch`, since another call may replace the chunk
+      // before the caller has used `*result`.
+      const size_t start = pos - current_.offset;
+      const size_t len = std::min(n - copied, current_.data.size() - start);
+      memcpy(scratch + copied, current_.data.data() + start, len);
+      copied += len;
+    }
+    *result = StringPiece(scratch, copied);
+    TF_RETURN_IF_ERROR(s);
+    if (copied < n) {
+      return errors::OutOfRange("Read less bytes than requested");
+    }
+    return Status::OK();
+  }
+
+ private:
+  // A contiguous part of `file_`.
+  struct Chunk {
+    uint64 offset = 0;
+    string data;
+  };
+
+  // The state of `next_`.
+  enum ReadAheadState { kIdle, kRequested, kReading, kDone };
+
+  static bool Contains(const Chunk& chunk, uint64 pos) {
+    return pos >= chunk.offset && pos - chunk.offset < chunk.data.size();
+  }
+
+  // Reads the chunk of `buffer_size_` bytes at `offset` into `*chunk`. A
+  // chunk that is shorter than `buffer_size_` ends at the end of the file.
+  Status ReadChunk(uint64 offset, Chunk* chunk) const {
+    chunk->offset = offset;
+    chunk->data.resize(buffer_size_);
+    StringPiece data;
+    Status s = file_->Read(offset, buffer_size_, &data, &chunk->data[0]);
+    if (data.data() != chunk->data.data()) {
+      memmove(&chunk->data[0], data.data(), data.size());
+    }
+    chunk->data.resize(data.size());
+    if (errors::IsOutOfRange(s)) {
+      s = Status::OK();
+    }
+    return s;
+  }
+
+  // Makes `current_` a chunk that contains `pos`, unless `pos` is at or
+  // beyond the end of the file.
+  Status FillCurrent(uint64 pos, mutex_lock* l) const
+      EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    // Wait for any outstanding read ahead, which owns `next_`.
+    while (next_state_ == kRequested || next_state_ == kReading) {
+      cond_var_.wait(*l);
+    }
+    if (next_state_ == kDone && Contains(next_, pos)) {
+      // Sequential reads: the chunk has already been read ahead.
+      next_state_ = kIdle;
+      std::swap(current_, next_);
+      if (!next_status_.ok()) {
+        current_.data.clear();
+        return next_status_;
+      }
+    } else {
+      next_state_ = kIdle;
+      // Start a random read at an aligned offset, if the chunk will still
+      // contain `pos`.
+      const uint64 start =
+          buffer_size_ > kReadAlignment ? pos - pos % kReadAlignment : pos;
+      Status s = ReadChunk(start, &current_);
+      if (!s.ok()) {
+        current_.data.clear();
+        return s;
+      }
+    }
+    const uint64 limit = current_.offset + current_.data.size();
+    if (current_.data.size() < buffer_size_) {
+      eof_offset_ = limit;
+    } else if (read_ahead_) {
+      next_.offset = limit;
+      next_state_ = kRequested;
+      if (!read_ahead_thread_) {
+        read_ahead_thread_.reset(Env::Default()->StartThread(
+            {}, "record_read_ahead", [this]() { ReadAheadThread(); }));
+      }
+      cond_var_.notify_all();
+    }
+    return Status::OK();
+  }
+
+  void ReadAheadThread() const {
+    while (true) {
+      {
+        mutex_lock l(mu_);
+        while (!cancelled_ && next_state_ != kRequested) {
+          cond_var_.wait(l);
+        }
+        if (cancelled_) {
+          return;
+        }
+        next_state_ = kReading;
+      }
+      // `next_` is only used by this thread while it is being read, so
+      // read without holding `mu_`.
+      Status s = ReadChunk(next_.offset, &next_);
+      mutex_lock l(mu_);
+      next_status_ = s;
+      next_state_ = kDone;
+      cond_var_.notify_all();
+    }
+  }
+
+  RandomAccessFile* const file_;
+  const size_t buffer_size_;
+  const bool read_ahead_;
+
+  mutable mutex mu_;
+  mutable condition_variable cond_var_;
+  mutable Chunk current_ GUARDED_BY(mu_);
+  mutable Chunk next_;
+  mutable ReadAheadState next_state_ GUARDED_BY(mu_) = kIdle;
+  mutable Status next_status_ GUARDED_BY(mu_);
+  // The offset of the end of the file, once a read has reached it.
+  mutable uint64 eof_offset_ GUARDED_BY(mu_) = kuint64max;
+  mutable bool cancelled_ GUARDED_BY(mu_) = false;
+  mutable std::unique_ptr<Thread> read_ahead_thread_ GUARDED_BY(mu_);
+};
+
+}  // namespace
+
 RecordReaderOptions RecordReaderOptions::CreateRecordReaderOptions(
     const string& compression_type) {
   RecordReaderOptions options;
@@ -45,6 +224,12 @@ RecordReaderOptions RecordReaderOptions::CreateRecordReaderOptions(
                << " No compression will be used.";
 #else
     options.zlib_options = io::ZlibCompressionOptions::GZIP();
+#endif  // IS_SLIM_BUILD
+  } else if (compression_type == compression::kSnappy) {
+    options.compression_type = io::RecordReaderOptions::SNAPPY_COMPRESSION;
+#if defined(IS_SLIM_BUILD)
+    LOG(ERROR) << "Compression is not supported but compression_type is set."
+               << " No compression will be used.";
 #endif  // IS_SLIM_BUILD
   } else if (compression_type != compression::kNone) {
     LOG(ERROR) << "Unsupported compression_type:" << compression_type
@@ -56,15 +241,31 @@ RecordReaderOptions RecordReaderOptions::CreateRecordReaderOptions(
 RecordReader::RecordReader(RandomAccessFile* file,
                            const RecordReaderOptions& options)
     : src_(file), options_(options) {
+  if (options.buffer_size > 0) {
+    buffered_src_.reset(new BufferedRandomAccessFile(
+        file, options.buffer_size, options.read_ahead));
+    src_ = buffered_src_.get();
+  }
   if (options.compression_type == RecordReaderOptions::ZLIB_COMPRESSION) {
 // We don't have zlib available on all embedded platforms, so fail.
 #if defined(IS_SLIM_BUILD)
     LOG(FATAL) << "Zlib compression is unsupported on mobile platforms.";
 #else   // IS_SLIM_BUILD
-    random_input_stream_.reset(new RandomAccessInputStream(file));
-    zlib_input_stream_.reset(new ZlibInputStream(
+    random_input_stream_.reset(new RandomAccessInputStream(src_));
+    input_stream_.reset(new ZlibInputStream(
         random_input_stream_.get(), options.zlib_options.input_buffer_size,
         options.zlib_options.output_buffer_size, options.zlib_options));
+#endif  // IS_SLIM_BUILD
+  } else if (options.compression_type ==
+             RecordReaderOptions::SNAPPY_COMPRESSION) {
+#if defined(IS_SLIM_BUILD)
+    LOG(FATAL) << "Snappy compression is unsupported on mobile platforms.";
+#else   // IS_SLIM_BUILD
+    // The input buffer must hold a whole compressed block and its 4 byte
+    // length, and snappy output is at most 32 + n + n / 6 bytes long.
+    input_stream_.reset(new SnappyInputBuffer(src_,
+                                              2 * compression::kSnappyBlockSize,
+                                              compression::kSnappyBlockSize));
 #endif  // IS_SLIM_BUILD
   } else if (options.compression_type == RecordReaderOptions::NONE) {
     // Nothing to do.
@@ -74,7 +275,7 @@ RecordReader::RecordReader(RandomAccessFile* file,
 }
 
 RecordReader::~RecordReader() {
-  zlib_input_stream_.reset(nullptr);
+  input_stream_.reset(nullptr);
   random_input_stream_.reset(nullptr);
 }
 
@@ -91,15 +292,15 @@ Status RecordReader::ReadChecksummed(uint64 offset, size_t n,
   storage->resize(expected);
 
 #if !defined(IS_SLIM_BUILD)
-  if (zlib_input_stream_) {
-    // If we have a zlib compressed buffer, we assume that the
+  if (input_stream_) {
+    // If we have a compressed buffer, we assume that the
     // file is being read sequentially, and we use the underlying
     // implementation to read the data.
     //
     // No checks are done to validate that the file is being read
-    // sequentially.  At some point the zlib input buffer may support
+    // sequentially.  At some point the compressed input buffers may support
     // seeking, possibly inefficiently.
-    TF_RETURN_IF_ERROR(zlib_input_stream_->ReadNBytes(expected, storage));
+    TF_RETURN_IF_ERROR(input_stream_->ReadNBytes(expected, storage));
 
     if (storage->size() != expected) {
       if (storage->empty()) {
@@ -110,7 +311,8 @@ Status RecordReader::ReadChecksummed(uint64 offset, size_t n,
     }
 
     uint32 masked_crc = core::DecodeFixed32(storage->data() + n);
-    if (crc32c::Unmask(masked_crc) != crc32c::Value(storage->data(), n)) {
+    if (options_.verify_checksums &&
+        crc32c::Unmask(masked_crc) != crc32c::Value(storage->data(), n)) {
       return errors::DataLoss("corrupted record at ", offset);
     }
     *result = StringPiece(storage->data(), n);
@@ -128,7 +330,8 @@ Status RecordReader::ReadChecksummed(uint64 offset, size_t n,
       }
     }
     uint32 masked_crc = core::DecodeFixed32(data.data() + n);
-    if (crc32c::Unmask(masked_crc) != crc32c::Value(data.data(), n)) {
+    if (options_.verify_checksums &&
+        crc32c::Unmask(masked_crc) != crc32c::Value(data.data(), n)) {
       return errors::DataLoss("corrupted record at ", offset);
     }
     *result = StringPiece(data.data(), n);
@@ -16,12 +16,14 @@ limitations under the License.
 #ifndef TENSORFLOW_LIB_IO_RECORD_READER_H_
 #define TENSORFLOW_LIB_IO_RECORD_READER_H_
 
+#include <memory>
+
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
 #if !defined(IS_SLIM_BUILD)
+#include "tensorflow/core/lib/io/inputstream_interface.h"
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
-#include "tensorflow/core/lib/io/zlib_inputstream.h"
 #endif  // IS_SLIM_BUILD
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/types.h"
@@ -34,12 +36,30 @@ namespace io {
 
 class RecordReaderOptions {
  public:
-  enum CompressionType { NONE = 0, ZLIB_COMPRESSION = 1 };
+  enum CompressionType {
+    NONE = 0,
+    ZLIB_COMPRESSION = 1,
+    SNAPPY_COMPRESSION = 2
+  };
   CompressionType compression_type = NONE;
 
   static RecordReaderOptions CreateRecordReaderOptions(
       const string& compression_type);
 
+  // If positive, the file is read in chunks of at least this many bytes,
+  // rather than with one small read for each record's length and another for
+  // its data, which is much faster on file systems with a high latency.
+  int64 buffer_size = 0;
+
+  // If true, and `buffer_size` is positive, the chunk that follows the last
+  // chunk read is read on a background thread while the records in that
+  // chunk are parsed.
+  bool read_ahead = false;
+
+  // If false, the CRCs of the lengths and data of records are not checked.
+  // Only use this for trusted data.
+  bool verify_checksums = true;
+
 #if !defined(IS_SLIM_BUILD)
   // Options specific to zlib compression.
   ZlibCompressionOptions zlib_options;
@@ -66,9 +86,13 @@ class RecordReader {
 
   RandomAccessFile* src_;
   RecordReaderOptions options_;
+  // Set if `options_.buffer_size` is positive, in which case `src_` points
+  // to it.
+  std::unique_ptr<RandomAccessFile> buffered_src_;
 #if !defined(IS_SLIM_BUILD)
   std::unique_ptr<RandomAccessInputStream> random_input_stream_;
-  std::unique_ptr<ZlibInputStream> zlib_input_stream_;
+  // Set if the file is compressed.
+  std::unique_ptr<InputStreamInterface> input_stream_;
 #endif  // IS_SLIM_BUILD
 
   TF_DISALLOW_COPY_AND_ASSIGN(RecordReader);
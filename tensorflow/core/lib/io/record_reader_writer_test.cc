@@ -105,4 +105,163 @@ TEST(RecordReaderWriterTest, TestZlib) {
   }
 }
 
+TEST(RecordReaderWriterTest, TestSnappy) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_snappy_test";
+
+  // Includes a record that spans several compressed blocks.
+  std::vector<string> records = {"abc", "defg", ""};
+  string large_record;
+  for (int i = 0; i < 1 << 20; ++i) {
+    large_record.push_back((i * 7919) % 251);
+  }
+  records.push_back(large_record);
+  records.push_back("hij");
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+
+    io::RecordWriterOptions options =
+        io::RecordWriterOptions::CreateRecordWriterOptions("SNAPPY");
+    EXPECT_EQ(io::RecordWriterOptions::SNAPPY_COMPRESSION,
+              options.compression_type);
+    io::RecordWriter writer(file.get(), options);
+    for (size_t i = 0; i < records.size(); ++i) {
+      TF_EXPECT_OK(writer.WriteRecord(records[i]));
+      if (i == 1) {
+        TF_CHECK_OK(writer.Flush());
+      }
+    }
+    TF_CHECK_OK(writer.Close());
+  }
+
+  {
+    std::unique_ptr<RandomAccessFile> read_file;
+    // Read it back with the RecordReader.
+    TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+    io::RecordReaderOptions options =
+        io::RecordReaderOptions::CreateRecordReaderOptions("SNAPPY");
+    EXPECT_EQ(io::RecordReaderOptions::SNAPPY_COMPRESSION,
+              options.compression_type);
+    io::RecordReader reader(read_file.get(), options);
+    uint64 offset = 0;
+    string record;
+    for (const string& expected : records) {
+      TF_CHECK_OK(reader.ReadRecord(&offset, &record));
+      EXPECT_EQ(expected, record);
+    }
+    EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+  }
+}
+
+// Writes records of varying sizes to `fname`, and returns them.
+static std::vector<string> WriteTestRecords(const string& fname,
+                                            const io::RecordWriterOptions&
+                                                options) {
+  std::vector<string> records;
+  for (int i = 0; i < 200; ++i) {
+    records.push_back(string((i * 37) % 5000, 'a' + i % 26));
+  }
+  std::unique_ptr<WritableFile> file;
+  TF_CHECK_OK(Env::Default()->NewWritableFile(fname, &file));
+  io::RecordWriter writer(file.get(), options);
+  for (const string& record : records) {
+    TF_CHECK_OK(writer.WriteRecord(record));
+  }
+  TF_CHECK_OK(writer.Flush());
+  return records;
+}
+
+TEST(RecordReaderWriterTest, TestBufferedReads) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_buffered_test";
+  const std::vector<string> records =
+      WriteTestRecords(fname, io::RecordWriterOptions());
+
+  for (int buffer_size : {1, 7, 4096, 5000, 65536, 1 << 22}) {
+    for (bool read_ahead : {false, true}) {
+      std::unique_ptr<RandomAccessFile> read_file;
+      TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+      io::RecordReaderOptions options;
+      options.buffer_size = buffer_size;
+      options.read_ahead = read_ahead;
+      io::RecordReader reader(read_file.get(), options);
+      uint64 offset = 0;
+      std::vector<uint64> offsets;
+      string record;
+      for (const string& expected : records) {
+        offsets.push_back(offset);
+        TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+        EXPECT_EQ(expected, record);
+      }
+      EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+
+      // Records can still be read at arbitrary offsets.
+      for (int i : {150, 3, 199, 0, 100, 101}) {
+        offset = offsets[i];
+        TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+        EXPECT_EQ(records[i], record);
+      }
+    }
+  }
+}
+
+TEST(RecordReaderWriterTest, TestBufferedZlibReads) {
+  Env* env = Env::Default();
+  string fname =
+      testing::TmpDir() + "/record_reader_writer_buffered_zlib_test";
+  io::RecordWriterOptions writer_options;
+  writer_options.compression_type = io::RecordWriterOptions::ZLIB_COMPRESSION;
+  const std::vector<string> records = WriteTestRecords(fname, writer_options);
+
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+  io::RecordReaderOptions options;
+  options.compression_type = io::RecordReaderOptions::ZLIB_COMPRESSION;
+  options.buffer_size = 1024;
+  options.read_ahead = true;
+  io::RecordReader reader(read_file.get(), options);
+  uint64 offset = 0;
+  string record;
+  for (const string& expected : records) {
+    TF_ASSERT_OK(reader.ReadRecord(&offset, &record));
+    EXPECT_EQ(expected, record);
+  }
+  EXPECT_TRUE(errors::IsOutOfRange(reader.ReadRecord(&offset, &record)));
+}
+
+TEST(RecordReaderWriterTest, TestSkipChecksumVerification) {
+  Env* env = Env::Default();
+  string fname = testing::TmpDir() + "/record_reader_writer_checksum_test";
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(env->NewWritableFile(fname, &file));
+    io::RecordWriter writer(file.get());
+    TF_EXPECT_OK(writer.WriteRecord("abc"));
+    TF_CHECK_OK(writer.Flush());
+  }
+  // Corrupt the data of the record, which follows its 12-byte header.
+  string contents;
+  TF_CHECK_OK(ReadFileToString(env, fname, &contents));
+  contents[12] = 'x';
+  TF_CHECK_OK(WriteStringToFile(env, fname, contents));
+
+  std::unique_ptr<RandomAccessFile> read_file;
+  TF_CHECK_OK(env->NewRandomAccessFile(fname, &read_file));
+  for (bool verify_checksums : {true, false}) {
+    io::RecordReaderOptions options;
+    options.verify_checksums = verify_checksums;
+    io::RecordReader reader(read_file.get(), options);
+    uint64 offset = 0;
+    string record;
+    Status s = reader.ReadRecord(&offset, &record);
+    if (verify_checksums) {
+      EXPECT_TRUE(errors::IsDataLoss(s)) << s;
+    } else {
+      TF_EXPECT_OK(s);
+      EXPECT_EQ("xbc", record);
+    }
+  }
+}
+
 }  // namespace tensorflow
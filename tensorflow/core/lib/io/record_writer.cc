@@ -26,6 +26,10 @@ namespace {
 bool IsZlibCompressed(RecordWriterOptions options) {
   return options.compression_type == RecordWriterOptions::ZLIB_COMPRESSION;
 }
+
+bool IsSnappyCompressed(RecordWriterOptions options) {
+  return options.compression_type == RecordWriterOptions::SNAPPY_COMPRESSION;
+}
 }  // namespace
 
 RecordWriterOptions RecordWriterOptions::CreateRecordWriterOptions(
@@ -46,6 +50,12 @@ RecordWriterOptions RecordWriterOptions::CreateRecordWriterOptions(
                << " No compression will be used.";
 #else
     options.zlib_options = io::ZlibCompressionOptions::GZIP();
+#endif  // IS_SLIM_BUILD
+  } else if (compression_type == compression::kSnappy) {
+    options.compression_type = io::RecordWriterOptions::SNAPPY_COMPRESSION;
+#if defined(IS_SLIM_BUILD)
+    LOG(ERROR) << "Compression is not supported but compression_type is set."
+               << " No compression will be used.";
 #endif  // IS_SLIM_BUILD
   } else if (compression_type != compression::kNone) {
     LOG(ERROR) << "Unsupported compression_type:" << compression_type
@@ -71,6 +81,13 @@ RecordWriter::RecordWriter(WritableFile* dest,
                  << s.ToString();
     }
     dest_ = zlib_output_buffer;
+#endif  // IS_SLIM_BUILD
+  } else if (IsSnappyCompressed(options)) {
+#if defined(IS_SLIM_BUILD)
+    LOG(FATAL) << "Snappy compression is unsupported on mobile platforms.";
+#else   // IS_SLIM_BUILD
+    snappy_output_buffer_.reset(new SnappyOutputBuffer(
+        dest, compression::kSnappyBlockSize, compression::kSnappyBlockSize));
 #endif  // IS_SLIM_BUILD
   } else if (options.compression_type == RecordWriterOptions::NONE) {
     // Nothing to do
@@ -105,9 +122,26 @@ Status RecordWriter::WriteRecord(StringPiece data) {
   char footer[sizeof(uint32)];
   core::EncodeFixed32(footer, MaskedCrc(data.data(), data.size()));
 
-  TF_RETURN_IF_ERROR(dest_->Append(StringPiece(header, sizeof(header))));
-  TF_RETURN_IF_ERROR(dest_->Append(data));
-  return dest_->Append(StringPiece(footer, sizeof(footer)));
+  TF_RETURN_IF_ERROR(Append(StringPiece(header, sizeof(header))));
+  TF_RETURN_IF_ERROR(Append(data));
+  return Append(StringPiece(footer, sizeof(footer)));
+}
+
+Status RecordWriter::Append(StringPiece data) {
+#if !defined(IS_SLIM_BUILD)
+  if (snappy_output_buffer_) {
+    // SnappyOutputBuffer compresses a write that does not fit in its input
+    // buffer as a block of its own, so split the data to keep every block
+    // small enough for the reader's buffers.
+    while (data.size() > compression::kSnappyBlockSize) {
+      TF_RETURN_IF_ERROR(snappy_output_buffer_->Write(
+          StringPiece(data.data(), compression::kSnappyBlockSize)));
+      data.remove_prefix(compression::kSnappyBlockSize);
+    }
+    return snappy_output_buffer_->Write(data);
+  }
+#endif  // IS_SLIM_BUILD
+  return dest_->Append(data);
 }
 
 Status RecordWriter::Close() {
@@ -118,6 +152,12 @@ Status RecordWriter::Close() {
     dest_ = nullptr;
     return s;
   }
+  if (snappy_output_buffer_) {
+    Status s = snappy_output_buffer_->Flush();
+    snappy_output_buffer_.reset();
+    dest_ = nullptr;
+    return s;
+  }
 #endif  // IS_SLIM_BUILD
   return Status::OK();
 }
@@ -126,6 +166,11 @@ Status RecordWriter::Flush() {
   if (IsZlibCompressed(options_)) {
     return dest_->Flush();
   }
+#if !defined(IS_SLIM_BUILD)
+  if (snappy_output_buffer_) {
+    return snappy_output_buffer_->Flush();
+  }
+#endif  // IS_SLIM_BUILD
   return Status::OK();
 }
 
@@ -105,7 +105,11 @@ Status SnappyInputBuffer::Inflate() {
   DCHECK_EQ(avail_out_, 0);
 
   // Output buffer must be large enough to fit the uncompressed block.
-  DCHECK_GE(output_buffer_capacity_, uncompressed_length);
+  if (uncompressed_length > output_buffer_capacity_) {
+    return errors::DataLoss("Uncompressed block of ", uncompressed_length,
+                            " bytes does not fit in the output buffer of ",
+                            output_buffer_capacity_, " bytes.");
+  }
   next_out_ = output_buffer_.get();
 
   bool status = port::Snappy_Uncompress(next_in_, compressed_block_length,
@@ -159,8 +159,52 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
     return nullptr;
   }
 
+  // Restrict decoding to the crop window, if requested.
+  JDIMENSION target_output_width = cinfo.output_width;
+  JDIMENSION target_output_height = cinfo.output_height;
+  JDIMENSION first_scanline = 0;
+  // The offset of the crop window in the decoded scanlines, in pixels.
+  JDIMENSION crop_offset = 0;
+  if (flags.crop) {
+    if (flags.crop_x < 0 || flags.crop_y < 0 || flags.crop_width <= 0 ||
+        flags.crop_height <= 0 ||
+        flags.crop_x + flags.crop_width > cinfo.output_width ||
+        flags.crop_y + flags.crop_height > cinfo.output_height) {
+      LOG(ERROR) << "Invalid crop window: x=" << flags.crop_x
+                 << ", y=" << flags.crop_y << ", width=" << flags.crop_width
+                 << ", height=" << flags.crop_height << " for a "
+                 << cinfo.output_width << " x " << cinfo.output_height
+                 << " image";
+      jpeg_destroy_decompress(&cinfo);
+      return nullptr;
+    }
+    target_output_width = flags.crop_width;
+    target_output_height = flags.crop_height;
+    first_scanline = flags.crop_y;
+#if defined(LIBJPEG_TURBO_VERSION)
+    // libjpeg-turbo can only decode whole iMCU columns, so it moves the left
+    // edge of the window to an iMCU boundary and widens it accordingly, and
+    // updates cinfo.output_width to the width of the decoded scanlines.
+    JDIMENSION crop_x = flags.crop_x;
+    JDIMENSION crop_width = flags.crop_width;
+    jpeg_crop_scanline(&cinfo, &crop_x, &crop_width);
+    crop_offset = flags.crop_x - crop_x;
+    if (first_scanline > 0 &&
+        jpeg_skip_scanlines(&cinfo, first_scanline) != first_scanline) {
+      LOG(ERROR) << "Premature end of JPEG data. Failed to skip to line "
+                 << first_scanline << "/" << cinfo.output_height;
+      jpeg_destroy_decompress(&cinfo);
+      return nullptr;
+    }
+#else
+    // Without libjpeg-turbo, whole scanlines are decoded, and the ones above
+    // the window are decoded and discarded below.
+    crop_offset = flags.crop_x;
+#endif
+  }
+
   // check for compatible stride
-  const int min_stride = cinfo.output_width * components * sizeof(JSAMPLE);
+  const int min_stride = target_output_width * components * sizeof(JSAMPLE);
   if (stride == 0) {
     stride = min_stride;
   } else if (stride < min_stride) {
@@ -170,34 +214,55 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
   }
 
   // Remember stride and height for use in Uncompress
-  argball->height_ = cinfo.output_height;
+  argball->height_ = target_output_height;
   argball->stride_ = stride;
 
   uint8* const dstdata = argball->allocate_output_(
-      cinfo.output_width, cinfo.output_height, components);
+      target_output_width, target_output_height, components);
   if (dstdata == nullptr) {
     jpeg_destroy_decompress(&cinfo);
     return nullptr;
   }
   JSAMPLE* output_line = static_cast<JSAMPLE*>(dstdata);
 
-  // Temporary buffer used for CMYK -> RGB conversion.
+  // Temporary buffer used for CMYK -> RGB conversion, and for the decoded
+  // scanlines when they are wider than the crop window.
   const bool use_cmyk = (cinfo.out_color_space == JCS_CMYK);
-  tempdata = use_cmyk ? new JSAMPLE[cinfo.output_width * 4] : nullptr;
+  const int line_components = use_cmyk ? 4 : components;
+  const bool use_tempdata =
+      use_cmyk || cinfo.output_width != target_output_width;
+  tempdata = use_tempdata
+                 ? new JSAMPLE[cinfo.output_width * line_components]
+                 : nullptr;
+  const JSAMPLE* const cropped_tempdata =
+      use_tempdata ? tempdata + crop_offset * line_components : nullptr;
+
+#if !defined(LIBJPEG_TURBO_VERSION)
+  while (cinfo.output_scanline < first_scanline) {
+    if (jpeg_read_scanlines(&cinfo, &tempdata, 1) == 0) {
+      LOG(ERROR) << "Premature end of JPEG data. Failed to skip to line "
+                 << first_scanline << "/" << cinfo.output_height;
+      delete[] tempdata;
+      jpeg_destroy_decompress(&cinfo);
+      return nullptr;
+    }
+  }
+#endif
 
   // If there is an error reading a line, this aborts the reading.
   // Save the fraction of the image that has been read.
-  argball->height_read_ = cinfo.output_height;
-  while (cinfo.output_scanline < cinfo.output_height) {
+  argball->height_read_ = target_output_height;
+  const JDIMENSION last_scanline = first_scanline + target_output_height;
+  while (cinfo.output_scanline < last_scanline) {
     int num_lines_read = 0;
-    if (cinfo.out_color_space == JCS_CMYK) {
+    if (use_cmyk) {
       num_lines_read = jpeg_read_scanlines(&cinfo, &tempdata, 1);
       // Convert CMYK to RGB
-      for (size_t i = 0; i < cinfo.output_width; ++i) {
-        int c = tempdata[4 * i + 0];
-        int m = tempdata[4 * i + 1];
-        int y = tempdata[4 * i + 2];
-        int k = tempdata[4 * i + 3];
+      for (size_t i = 0; i < target_output_width; ++i) {
+        int c = cropped_tempdata[4 * i + 0];
+        int m = cropped_tempdata[4 * i + 1];
+        int y = cropped_tempdata[4 * i + 2];
+        int k = cropped_tempdata[4 * i + 3];
         int r, g, b;
         if (cinfo.saw_Adobe_marker) {
           r = (k * c) / 255;
@@ -212,6 +277,11 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
         output_line[3 * i + 1] = g;
         output_line[3 * i + 2] = b;
       }
+    } else if (use_tempdata) {
+      num_lines_read = jpeg_read_scanlines(&cinfo, &tempdata, 1);
+      if (num_lines_read > 0) {
+        memcpy(output_line, cropped_tempdata, min_stride);
+      }
     } else {
       num_lines_read = jpeg_read_scanlines(&cinfo, &output_line, 1);
     }
@@ -220,11 +290,11 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
       LOG(ERROR) << "Premature end of JPEG data. Stopped at line "
                  << cinfo.output_scanline << "/" << cinfo.output_height;
       if (!flags.try_recover_truncated_jpeg) {
-        argball->height_read_ = cinfo.output_scanline;
+        argball->height_read_ = cinfo.output_scanline - first_scanline;
         error = JPEGERRORS_UNEXPECTED_END_OF_DATA;
       } else {
-        for (size_t line = cinfo.output_scanline; line < cinfo.output_height;
-             ++line) {
+        for (size_t line = cinfo.output_scanline - first_scanline;
+             line < target_output_height; ++line) {
           if (line == 0) {
             // If even the first line is missing, fill with black color
             memset(output_line, 0, min_stride);
@@ -235,7 +305,7 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
           output_line += stride;
         }
         argball->height_read_ =
-            cinfo.output_height;  // consider all lines as read
+            target_output_height;  // consider all lines as read
         // prevent error-on-exit in libjpeg:
         cinfo.output_scanline = cinfo.output_height;
       }
@@ -254,17 +324,17 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
   if (components == 4) {
     // Start on the last line.
     JSAMPLE* scanlineptr = static_cast<JSAMPLE*>(
-        dstdata + static_cast<int64>(cinfo.output_height - 1) * stride);
+        dstdata + static_cast<int64>(target_output_height - 1) * stride);
     const JSAMPLE kOpaque = -1;  // All ones appropriate for JSAMPLE.
-    const int right_rgb = (cinfo.output_width - 1) * 3;
-    const int right_rgba = (cinfo.output_width - 1) * 4;
+    const int right_rgb = (target_output_width - 1) * 3;
+    const int right_rgba = (target_output_width - 1) * 4;
 
-    for (int y = cinfo.output_height; y-- > 0;) {
+    for (int y = target_output_height; y-- > 0;) {
       // We do all the transformations in place, going backwards for each row.
       const JSAMPLE* rgb_pixel = scanlineptr + right_rgb;
       JSAMPLE* rgba_pixel = scanlineptr + right_rgba;
       scanlineptr -= stride;
-      for (int x = cinfo.output_width; x-- > 0;
+      for (int x = target_output_width; x-- > 0;
            rgba_pixel -= 4, rgb_pixel -= 3) {
         // We copy the 3 bytes at rgb_pixel into the 4 bytes at rgba_pixel
         // The "a" channel is set to be opaque.
@@ -309,7 +379,12 @@ uint8* UncompressLow(const void* srcdata, FewerArgsForCompiler* argball) {
   // Handle errors in JPEG
   switch (error) {
     case JPEGERRORS_OK:
-      jpeg_finish_decompress(&cinfo);
+      if (cinfo.output_scanline < cinfo.output_height) {
+        // The scanlines below the crop window are not needed.
+        jpeg_abort(reinterpret_cast<j_common_ptr>(&cinfo));
+      } else {
+        jpeg_finish_decompress(&cinfo);
+      }
       break;
     case JPEGERRORS_UNEXPECTED_END_OF_DATA:
     case JPEGERRORS_BAD_PARAM:
@@ -410,7 +485,9 @@ bool GetImageInfo(const void* srcdata, int datasize, int* width, int* height,
   SetSrc(&cinfo, srcdata, datasize, false);
 
   jpeg_read_header(&cinfo, TRUE);
-  jpeg_start_decompress(&cinfo);  // required to transfer image size to cinfo
+  // Computes the image size without starting decompression, which would
+  // decode the whole image for multi-scan (e.g. progressive) files.
+  jpeg_calc_output_dimensions(&cinfo);
   if (width) *width = cinfo.output_width;
   if (height) *height = cinfo.output_height;
   if (components) *components = cinfo.output_components;
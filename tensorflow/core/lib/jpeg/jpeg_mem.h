@@ -61,6 +61,17 @@ struct UncompressFlags {
   //
   // Setting this has a quality/speed trade-off implication.
   J_DCT_METHOD dct_method = JDCT_DEFAULT;
+
+  // If true, only the crop window below is decoded and returned.  The window
+  // is given in the coordinates of the image scaled down by `ratio`, and must
+  // lie within it.  The scanlines above the window are skipped without being
+  // decoded, decoding stops after its last scanline, and only the iMCU columns
+  // that overlap it are decoded.
+  bool crop = false;
+  int crop_x = 0;
+  int crop_y = 0;
+  int crop_width = 0;
+  int crop_height = 0;
 };
 
 // Uncompress some raw JPEG data given by the pointer srcdata and the length
@@ -82,6 +82,12 @@ void TestJPEG(Env* env, const string& jpegfile) {
   flags.min_acceptable_fraction = 1.0;
   imgdata.reset(Uncompress(temp, fsize, flags, &w, &h, &c, nullptr));
   CHECK(imgdata != nullptr);
+
+  // The header gives the same size.
+  int info_w, info_h;
+  CHECK(GetImageInfo(temp, fsize, &info_w, &info_h, nullptr));
+  CHECK_EQ(w, info_w);
+  CHECK_EQ(h, info_h);
 }
 
 TEST(JpegMemTest, Jpeg) {
@@ -95,6 +101,78 @@ TEST(JpegMemTest, Jpeg) {
   TestJPEG(env, data_path + "jpeg_merge_test1_cmyk.jpg");
 }
 
+// Checks that decoding a crop window gives the same pixels as decoding the
+// whole image and cropping it afterwards.
+void TestCropAndDecodeJpeg(Env* env, const string& jpegfile,
+                           const UncompressFlags& default_flags) {
+  string jpeg;
+  ReadFileToStringOrDie(env, jpegfile, &jpeg);
+  const int fsize = jpeg.size();
+  const uint8* const temp = bit_cast<const uint8*>(jpeg.data());
+
+  int w, h, c;
+  std::unique_ptr<uint8[]> imgdata(
+      Uncompress(temp, fsize, default_flags, &w, &h, &c, nullptr));
+  CHECK(imgdata != nullptr);
+
+  const struct {
+    int x, y, width, height;
+  } crops[] = {{0, 0, w, h},
+               {0, 0, 1, 1},
+               {w - 1, h - 1, 1, 1},
+               {13, 7, w / 2, h / 3},
+               {w / 3, h / 2, w - w / 3, h - h / 2}};
+  for (const auto& crop : crops) {
+    UncompressFlags flags = default_flags;
+    flags.crop = true;
+    flags.crop_x = crop.x;
+    flags.crop_y = crop.y;
+    flags.crop_width = crop.width;
+    flags.crop_height = crop.height;
+    int cw, ch, cc;
+    std::unique_ptr<uint8[]> cropped(
+        Uncompress(temp, fsize, flags, &cw, &ch, &cc, nullptr));
+    ASSERT_TRUE(cropped != nullptr);
+    EXPECT_EQ(crop.width, cw);
+    EXPECT_EQ(crop.height, ch);
+    EXPECT_EQ(c, cc);
+    for (int i = 0; i < crop.height; ++i) {
+      const uint8* expected =
+          imgdata.get() + ((crop.y + i) * w + crop.x) * c;
+      const uint8* actual = cropped.get() + i * crop.width * c;
+      ASSERT_EQ(0, memcmp(expected, actual, crop.width * c))
+          << jpegfile << ": line " << i << " of the crop window at ("
+          << crop.x << ", " << crop.y << ")";
+    }
+  }
+
+  // Crop windows that do not lie within the image are rejected.
+  UncompressFlags flags = default_flags;
+  flags.crop = true;
+  flags.crop_x = w / 2;
+  flags.crop_y = 0;
+  flags.crop_width = w / 2 + 1;
+  flags.crop_height = h;
+  imgdata.reset(Uncompress(temp, fsize, flags, &w, &h, &c, nullptr));
+  EXPECT_TRUE(imgdata == nullptr);
+}
+
+TEST(JpegMemTest, CropAndDecodeJpeg) {
+  Env* env = Env::Default();
+  const string data_path = kTestData;
+  UncompressFlags flags;
+
+  TestCropAndDecodeJpeg(env, data_path + "jpeg_merge_test1.jpg", flags);
+  TestCropAndDecodeJpeg(env, data_path + "jpeg_merge_test1_cmyk.jpg", flags);
+
+  flags.components = 1;
+  TestCropAndDecodeJpeg(env, data_path + "jpeg_merge_test1.jpg", flags);
+
+  flags.components = 3;
+  flags.ratio = 2;
+  TestCropAndDecodeJpeg(env, data_path + "jpeg_merge_test1.jpg", flags);
+}
+
 TEST(JpegMemTest, Jpeg2) {
   // create known data, for size in_w x in_h
   const int in_w = 256;
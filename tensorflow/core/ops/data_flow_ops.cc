@@ -2083,6 +2083,25 @@ REGISTER_OP("StageClear")
 Op removes all elements in the underlying container.
     )doc");
 
+REGISTER_OP("StageClose")
+    .Attr("cancel_pending_enqueues: bool = false")
+    .Attr("capacity: int >= 0 = 0")
+    .Attr("memory_limit: int >= 0 = 0")
+    .Attr("dtypes: list(type)")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .SetShapeFn(shape_inference::NoOutputs)
+    .SetIsStateful()
+    .Doc(R"doc(
+Closes the underlying container.
+
+Subsequent Stage ops fail, and Unstage ops fail with OutOfRange once the
+remaining elements have been removed. Stage ops that wait for space keep
+waiting, unless `cancel_pending_enqueues` is true, in which case they fail.
+
+cancel_pending_enqueues: If true, also fails the pending Stage ops.
+    )doc");
+
 // UnorderedMap
 REGISTER_OP("MapStage")
     .Input("key: int64")
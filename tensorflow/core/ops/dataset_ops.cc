@@ -119,6 +119,24 @@ count: A scalar representing the number of elements from the `input_dataset`
   that should be skipped.  If count is -1, skips everything.
 )doc");
 
+REGISTER_OP("PrefetchDataset")
+    .Input("input_dataset: resource")
+    .Input("buffer_size: int64")
+    .Output("handle: resource")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that asynchronously prefetches elements from `input_dataset`.
+
+An iterator over this dataset reads elements from `input_dataset` on a
+background thread, so that producing an element overlaps with the
+consumption of the previous ones.
+
+buffer_size: The maximum number of elements to buffer in an iterator over
+  this dataset.
+)doc");
+
 REGISTER_OP("MapDataset")
     .Input("input_dataset: resource")
     .Input("other_arguments: Targuments")
@@ -132,6 +150,33 @@ REGISTER_OP("MapDataset")
 Creates a dataset that applies `f` to the outputs of `input_dataset`.
 )doc");
 
+REGISTER_OP("MapAndBatchDataset")
+    .Input("input_dataset: resource")
+    .Input("other_arguments: Targuments")
+    .Input("batch_size: int64")
+    .Input("num_threads: int32")
+    .Input("num_parallel_batches: int64")
+    .Output("handle: resource")
+    .Attr("f: func")
+    .Attr("Targuments: list(type) >= 0")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that maps `f` over `input_dataset` and batches the results.
+
+Unlike a "BatchDataset" of a "ParallelMapDataset", this dataset copies the
+result of each call to `f` directly into its slice of the batch, on the thread
+that ran `f`.
+
+batch_size: A scalar representing the number of elements to accumulate in a
+  batch.
+num_threads: The number of threads to use to process elements from
+  `input_dataset`.
+num_parallel_batches: The maximum number of batches to fill (and buffer)
+  concurrently.
+)doc");
+
 REGISTER_OP("ParallelMapDataset")
     .Input("input_dataset: resource")
     .Input("other_arguments: Targuments")
@@ -177,6 +222,72 @@ f: A function mapping elements of `input_dataset`, concatenated with
   `output_types` and `output_shapes`.
 )doc");
 
+REGISTER_OP("ParseExampleDataset")
+    .Input("input_dataset: resource")
+    .Input("num_parallel_calls: int64")
+    .Input("dense_defaults: Tdense")
+    .Output("handle: resource")
+    .Attr("sparse_keys: list(string) >= 0")
+    .Attr("dense_keys: list(string) >= 0")
+    .Attr("sparse_types: list({float,int64,string}) >= 0")
+    .Attr("Tdense: list({float,int64,string}) >= 0")
+    .Attr("dense_shapes: list(shape) >= 0")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that parses batches of serialized `Example` protos.
+
+Each element of `input_dataset` must be a vector of serialized `Example`
+protos, which is parsed as by "ParseExample". The components of each output
+element follow the features in the order of their keys: a dense feature has
+one component, and a sparse feature has three (its indices, values and dense
+shape).
+
+num_parallel_calls: The number of threads to use to parse each batch.
+dense_defaults: A list of Ndense Tensors (some may be empty), as in
+  "ParseExample".
+sparse_keys: A list of the keys of the sparse features.
+dense_keys: A list of the keys of the dense features.
+sparse_types: A list of the types of the sparse features.
+dense_shapes: A list of the shapes of the dense features, as in
+  "ParseExample".
+)doc");
+
+REGISTER_OP("ParallelInterleaveDataset")
+    .Input("input_dataset: resource")
+    .Input("other_arguments: Targuments")
+    .Input("cycle_length: int64")
+    .Input("block_length: int64")
+    .Input("sloppy: bool")
+    .Input("buffer_output_elements: int64")
+    .Output("handle: resource")
+    .Attr("f: func")
+    .Attr("Targuments: list(type) >= 0")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that applies `f` to the outputs of `input_dataset`.
+
+Like a "FlatMapDataset", the `f` in ParallelInterleaveDataset is expected
+to return a Dataset resource. Instead of flattening the results one after
+another, this dataset reads from `cycle_length` of them at a time, each on
+its own thread, and interleaves their elements in blocks of `block_length`.
+
+f: A function mapping elements of `input_dataset`, concatenated with
+  `other_arguments`, to a Dataset resource that contains elements matching
+  `output_types` and `output_shapes`.
+cycle_length: The number of datasets returned by `f` that are read
+  concurrently.
+block_length: The number of consecutive elements to take from each of
+  those datasets before moving on to the next one.
+sloppy: If true, elements may be produced out of order when the next
+  dataset in the cycle has no element ready.
+buffer_output_elements: The maximum number of elements to buffer from each
+  of the datasets that are read concurrently.
+)doc");
+
 REGISTER_OP("GroupByWindowDataset")
     .Input("input_dataset: resource")
     .Input("key_func_other_arguments: Tkey_func_other_arguments")
@@ -326,12 +437,41 @@ seed: A scalar seed for the random number generator. If either seed or
 seed2: A second scalar seed to avoid seed collision.
 )doc");
 
+REGISTER_OP("ShuffleAndRepeatDataset")
+    .Input("input_dataset: resource")
+    .Input("buffer_size: int64")
+    .Input("seed: int64")
+    .Input("seed2: int64")
+    .Input("count: int64")
+    .Output("handle: resource")
+    .Attr("output_types: list(type) >= 1")
+    .Attr("output_shapes: list(shape) >= 1")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that shuffles and repeats elements from `input_dataset`.
+
+Unlike a "ShuffleDataset" followed by a "RepeatDataset", the buffer is filled
+from the next repetition as soon as the current one ends, rather than drained
+at the end of each repetition.
+
+buffer_size: The number of output elements to buffer in an iterator over
+  this dataset. Compare with the `min_after_dequeue` attr when creating a
+  `RandomShuffleQueue`.
+seed: A scalar seed for the random number generator. If either seed or
+  seed2 is set to be non-zero, the random number generator is seeded
+  by the given seed.  Otherwise, a random seed is used.
+seed2: A second scalar seed to avoid seed collision.
+count: A scalar representing the number of times the underlying dataset
+  should be repeated. The default is `-1`, which results in infinite repetition.
+)doc");
+
 REGISTER_OP("CacheDataset")
     .Input("input_dataset: resource")
     .Input("filename: string")
     .Output("handle: resource")
     .Attr("output_types: list(type) >= 1")
     .Attr("output_shapes: list(shape) >= 1")
+    .Attr("num_shards: int >= 1 = 1")
     .SetShapeFn(shape_inference::ScalarShape)
     .Doc(R"doc(
 Creates a dataset that caches elements from `input_dataset`.
@@ -341,8 +481,14 @@ cache already exists, the cache will be used. If the cache is inappropriate
 (e.g. cannot be opened, contains tensors of the wrong shape / size), an error
 will the returned when used.
 
+A file cache is written as `num_shards` files, each by its own thread, and is
+read back through a read-only memory mapping of those files, so that the cached
+tensors need not be copied.
+
 filename: A path on the filesystem where we should cache the dataset. Note: this
   will be a directory.
+num_shards: The number of files that a file cache is written to. Element `i`
+  of the input is written to file `i % num_shards`.
 )doc");
 
 REGISTER_OP("TextLineDataset")
@@ -382,6 +528,8 @@ REGISTER_OP("TFRecordDataset")
     .Input("filenames: string")
     .Input("compression_type: string")
     .Output("handle: resource")
+    .Attr("buffer_size: int >= 0 = 0")
+    .Attr("verify_checksums: bool = true")
     .SetShapeFn(shape_inference::ScalarShape)
     .Doc(R"doc(
 Creates a dataset that emits the records from one or more TFRecord files.
@@ -389,7 +537,34 @@ Creates a dataset that emits the records from one or more TFRecord files.
 filenames: A scalar or vector containing the name(s) of the file(s) to be
   read.
 compression_type: A scalar containing either (i) the empty string (no
-  compression), (ii) "ZLIB", or (iii) "GZIP".
+  compression), (ii) "ZLIB", (iii) "GZIP", or (iv) "SNAPPY".
+buffer_size: The number of bytes to read from each file at a time. If greater
+  than zero, the next block of each file is read ahead in the background.
+verify_checksums: If false, the CRC32C checksums of the records are not
+  verified.
+)doc");
+
+REGISTER_OP("LMDBDataset")
+    .Input("filenames: string")
+    .Input("start_key: string")
+    .Input("end_key: string")
+    .Input("batch_size: int64")
+    .Output("handle: resource")
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Creates a dataset that emits batches of the records of one or more LMDB files.
+
+Each element is a pair of string vectors, holding the keys and values of up
+to `batch_size` consecutive records of one file, in key order.
+
+filenames: A scalar or vector containing the name(s) of the file(s) to be
+  read. Each one is either an LMDB directory or its data file.
+start_key: A scalar containing the first key to read from each file, or the
+  empty string to read from its first record.
+end_key: A scalar containing the key at which to stop reading each file
+  (exclusive), or the empty string to read up to its last record.
+batch_size: A scalar representing the maximum number of records in each
+  element.
 )doc");
 
 REGISTER_OP("Iterator")
@@ -405,6 +405,94 @@ dct_method: string specifying a hint about the algorithm used for
 image: 3-D with shape `[height, width, channels]`..
 )doc");
 
+// --------------------------------------------------------------------------
+REGISTER_OP("DecodeAndCropJpeg")
+    .Input("contents: string")
+    .Input("crop_window: int32")
+    .Attr("channels: int = 0")
+    .Attr("ratio: int = 1")
+    .Attr("fancy_upscaling: bool = true")
+    .Attr("try_recover_truncated: bool = false")
+    .Attr("acceptable_fraction: float = 1.0")
+    .Attr("dct_method: string = ''")
+    .Output("image: uint8")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle crop_window;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &crop_window));
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(c->WithValue(c->Dim(crop_window, 0), 4, &unused));
+      TF_RETURN_IF_ERROR(DecodeImageShapeFn(c));
+
+      // Use the size of the crop window, if it is known.
+      const Tensor* crop_window_tensor = c->input_tensor(1);
+      if (crop_window_tensor != nullptr) {
+        auto crop_window_vec = crop_window_tensor->vec<int32>();
+        const int32 crop_height = crop_window_vec(2);
+        const int32 crop_width = crop_window_vec(3);
+        if (crop_height <= 0 || crop_width <= 0) {
+          return errors::InvalidArgument(
+              "crop_window must have a positive height and width, got ",
+              crop_height, " and ", crop_width);
+        }
+        c->set_output(0, c->MakeShape({c->MakeDim(crop_height),
+                                       c->MakeDim(crop_width),
+                                       c->Dim(c->output(0), 2)}));
+      }
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Decode and crop a JPEG-encoded image to a uint8 tensor.
+
+Equivalent to `DecodeJpeg` followed by cropping the result to `crop_window`,
+but only the part of the image that overlaps the crop window is decoded, which
+is much faster when the window is small compared to the image.
+
+The attrs have the same meaning as those of `DecodeJpeg`.  Unlike `DecodeJpeg`,
+this op only decodes JPEG images.
+
+contents: 0-D.  The JPEG-encoded image.
+crop_window: 1-D.  The crop window: [crop_y, crop_x, crop_height, crop_width],
+  in the coordinates of the image downscaled by `ratio`.  It must lie within
+  the image.
+channels: Number of color channels for the decoded image.
+ratio: Downscaling ratio.
+fancy_upscaling: If true use a slower but nicer upscaling of the
+  chroma planes (yuv420/422 only).
+try_recover_truncated:  If true try to recover an image from truncated input.
+acceptable_fraction: The minimum required fraction of lines before a truncated
+  input is accepted.
+dct_method: string specifying a hint about the algorithm used for
+  decompression.  Defaults to "" which maps to a system-specific
+  default.  Currently valid values are ["INTEGER_FAST",
+  "INTEGER_ACCURATE"].  The hint may be ignored (e.g., the internal
+  jpeg library changes to a version that does not have that specific
+  option.)
+image: 3-D with shape `[crop_height, crop_width, channels]`.
+)doc");
+
+// --------------------------------------------------------------------------
+REGISTER_OP("ExtractJpegShape")
+    .Input("contents: string")
+    .Output("image_shape: output_type")
+    .Attr("output_type: {int32, int64} = DT_INT32")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      c->set_output(0, c->Vector(3));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Extract the shape information of a JPEG-encoded image.
+
+This op only parses the image header, so it is much faster than DecodeJpeg.
+
+contents: 0-D. The JPEG-encoded image.
+image_shape: 1-D. The image shape with format [height, width, channels], as
+  returned by `DecodeJpeg` with `channels` set to 0.
+output_type: (Optional) The output type of the operation (int32 or int64).
+  Defaults to int32.
+)doc");
+
 // --------------------------------------------------------------------------
 REGISTER_OP("EncodeJpeg")
     .Input("image: uint8")
@@ -90,6 +90,43 @@ TEST(ImageOpsTest, DecodeImage_ShapeFn) {
   }
 }
 
+TEST(ImageOpsTest, DecodeAndCropJpeg_ShapeFn) {
+  ShapeInferenceTestOp op("DecodeAndCropJpeg");
+  TF_ASSERT_OK(NodeDefBuilder("test", "DecodeAndCropJpeg")
+                   .Input({"a", 0, DT_STRING})
+                   .Input({"b", 0, DT_INT32})
+                   .Attr("channels", 3)
+                   .Finalize(&op.node_def));
+
+  // Rank and size checks.
+  INFER_ERROR("Shape must be rank 0 but is rank 1", op, "[1];[4]");
+  INFER_ERROR("Shape must be rank 1 but is rank 0", op, "[];[]");
+  INFER_ERROR("Dimension must be 4 but is 3", op, "[];[3]");
+
+  // The size of the crop window is unknown.
+  INFER_OK(op, "[];[4]", "[?,?,3]");
+
+  // The size of the crop window is known.
+  Tensor crop_window = test::AsTensor<int32>({1, 2, 20, 30});
+  op.input_tensors.resize(2);
+  op.input_tensors[1] = &crop_window;
+  INFER_OK(op, "[];[4]", "[20,30,3]");
+
+  crop_window = test::AsTensor<int32>({1, 2, 0, 30});
+  INFER_ERROR("crop_window must have a positive height and width", op,
+              "[];[4]");
+}
+
+TEST(ImageOpsTest, ExtractJpegShape_ShapeFn) {
+  ShapeInferenceTestOp op("ExtractJpegShape");
+
+  // Rank check.
+  INFER_ERROR("Shape must be rank 0 but is rank 1", op, "[1]");
+
+  // Only specify input.
+  INFER_OK(op, "?", "[3]");
+}
+
 TEST(ImageOpsTest, EncodeImage_ShapeFn) {
   for (const char* op_name : {"EncodeJpeg", "EncodePng"}) {
     ShapeInferenceTestOp op(op_name);
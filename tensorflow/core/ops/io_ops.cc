@@ -62,6 +62,7 @@ REGISTER_OP("SaveV2")
     .Input("shape_and_slices: string")
     .Input("tensors: dtypes")
     .Attr("dtypes: list(type)")
+    .Attr("num_shards: int >= 1 = 1")
     .SetIsStateful()
     .SetShapeFn([](InferenceContext* c) {
       ShapeHandle unused;
@@ -94,6 +95,66 @@ tensor_names: shape {N}. The names of the tensors to be saved.
 shape_and_slices: shape {N}.  The slice specs of the tensors to be saved.
   Empty strings indicate that they are non-partitioned tensors.
 tensors: `N` tensors to save.
+num_shards: The number of data files to split the tensors across, balanced by
+  size.  The data files are written in parallel, one thread each.
+)doc");
+
+REGISTER_OP("AsyncSaveV2")
+    .Input("prefix: string")
+    .Input("tensor_names: string")
+    .Input("shape_and_slices: string")
+    .Input("tensors: dtypes")
+    .Attr("dtypes: list(type)")
+    .Attr("num_shards: int >= 1 = 1")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      ShapeHandle s;
+      DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      for (int i = 1; i <= 2; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 1, &s));
+        TF_RETURN_IF_ERROR(
+            c->WithValue(c->Dim(s, 0), c->num_inputs() - 3, &unused_dim));
+      }
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Saves tensors in V2 checkpoint format, in the background.
+
+Like SaveV2, but only copies the tensors before returning, and writes the copies
+to the checkpoint on a background thread.  The checkpoint is complete once a
+WaitForAsyncSaves op on the same device has returned.
+
+At most one checkpoint is written at a time: the op first waits for the
+previous checkpoint of the device, and fails if it or any other background
+write failed since the last WaitForAsyncSaves.  Errors of this checkpoint are
+likewise returned by the next AsyncSaveV2 or WaitForAsyncSaves op.
+
+prefix: Must have a single element. The prefix of the V2 checkpoint to which we
+  write the tensors.
+tensor_names: shape {N}. The names of the tensors to be saved.
+shape_and_slices: shape {N}.  The slice specs of the tensors to be saved.
+  Empty strings indicate that they are non-partitioned tensors.
+tensors: `N` tensors to save.
+num_shards: The number of data files to split the tensors across, balanced by
+  size.  The data files are written in parallel, one thread each.
+)doc");
+
+REGISTER_OP("WaitForAsyncSaves")
+    .Output("num_pending: int64")
+    .Attr("block: bool = true")
+    .SetIsStateful()
+    .SetShapeFn(shape_inference::ScalarShape)
+    .Doc(R"doc(
+Waits for, or checks on, the checkpoints written by AsyncSaveV2.
+
+Fails if a background write of the AsyncSaveV2 ops of the device failed since
+the last WaitForAsyncSaves op.
+
+block: Whether to wait until the pending checkpoint, if any, is complete.
+num_pending: The number of checkpoints still being written: 0 if "block",
+  otherwise 0 or 1.
 )doc");
 
 REGISTER_OP("RestoreV2")
@@ -498,6 +559,8 @@ REGISTER_OP("TFRecordReader")
     .Attr("container: string = ''")
     .Attr("shared_name: string = ''")
     .Attr("compression_type: string = ''")
+    .Attr("buffer_size: int >= 0 = 0")
+    .Attr("verify_checksums: bool = true")
     .SetIsStateful()
     .SetShapeFn(TwoElementOutput)
     .Doc(R"doc(
@@ -508,6 +571,11 @@ container: If non-empty, this reader is placed in the given container.
         Otherwise, a default container is used.
 shared_name: If non-empty, this reader is named in the given bucket
              with this shared_name. Otherwise, the node name is used instead.
+buffer_size: The number of bytes to read from each file at a time. If greater
+             than zero, the next block of the file is read ahead in the
+             background.
+verify_checksums: If false, the CRC32C checksums of the records are not
+                  verified.
 )doc");
 
 REGISTER_OP("TFRecordReaderV2")
@@ -515,6 +583,8 @@ REGISTER_OP("TFRecordReaderV2")
     .Attr("container: string = ''")
     .Attr("shared_name: string = ''")
     .Attr("compression_type: string = ''")
+    .Attr("buffer_size: int >= 0 = 0")
+    .Attr("verify_checksums: bool = true")
     .SetIsStateful()
     .SetShapeFn(shape_inference::ScalarShape)
     .Doc(R"doc(
@@ -525,6 +595,11 @@ container: If non-empty, this reader is placed in the given container.
         Otherwise, a default container is used.
 shared_name: If non-empty, this reader is named in the given bucket
              with this shared_name. Otherwise, the node name is used instead.
+buffer_size: The number of bytes to read from each file at a time. If greater
+             than zero, the next block of the file is read ahead in the
+             background.
+verify_checksums: If false, the CRC32C checksums of the records are not
+                  verified.
 )doc");
 
 REGISTER_OP("LMDBReader")
@@ -543,6 +543,181 @@ max_load_factor: The maximum ratio between number of entries and number of
   buckets before growing the table. Must be between 0 and 1.
 )doc");
 
+REGISTER_OP("MappedHashTableV2")
+    .Input("filename: string")
+    .Output("table_handle: resource")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("use_node_name_sharing: bool = false")
+    .Attr("key_dtype: type")
+    .Attr("value_dtype: type")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      c->set_output(0, c->Scalar());
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Creates an immutable hash table from a memory mapped file.
+
+The file must be in the mapped hash table format, built e.g. by
+tensorflow/contrib/util:build_mapped_hash_table. It is used in place rather
+than loaded, so creating the table takes constant time, and the memory of the
+table is shared by all the processes of a host that use the same file. Keys and
+values must be scalars.
+
+filename: Name of the mapped hash table file.
+table_handle: Handle to a table.
+container: If non-empty, this table is placed in the given container.
+  Otherwise, a default container is used.
+shared_name: If non-empty, this table is shared under the given name across
+  multiple sessions.
+use_node_name_sharing: If true and shared_name is empty, the table is shared
+  using the node name.
+key_dtype: Type of the table keys. Must match the file.
+value_dtype: Type of the table values. Must match the file.
+)doc");
+
+REGISTER_OP("DynamicEmbeddingTableV2")
+    .Output("table_handle: resource")
+    .Attr("container: string = ''")
+    .Attr("shared_name: string = ''")
+    .Attr("use_node_name_sharing: bool = false")
+    .Attr("key_dtype: type")
+    .Attr("value_dtype: type")
+    .Attr("embedding_dim: int >= 1")
+    .Attr("min_frequency: int >= 1 = 1")
+    .Attr("max_num_entries: int >= 0 = 0")
+    .Attr("eviction_policy: {'lru', 'lfu'} = 'lru'")
+    .Attr("initial_stddev: float = 0")
+    .Attr("seed: int = 0")
+    .Attr("optimizer: {'sgd', 'adagrad'} = 'sgd'")
+    .Attr("initial_accumulator_value: float = 0.1")
+    .SetIsStateful()
+    .SetShapeFn(ScalarOutput)
+    .Doc(R"doc(
+Creates an empty table of embeddings for a sparse space of IDs.
+
+Looking up an ID that isn't in the table counts it, and admits it once it has
+been looked up `min_frequency` times. Until then, the lookup returns the
+default value. A newly admitted ID gets a random embedding if `initial_stddev`
+is positive, otherwise the default value.
+
+If `max_num_entries` is positive, admitting an ID into a full table evicts the
+least recently used ID, or the least frequently used one if `eviction_policy`
+is 'lfu'.
+
+The embeddings are trained in place by DynamicEmbeddingTableApplyGradientsV2,
+and checkpointed with DynamicEmbeddingTableExportV2 and
+DynamicEmbeddingTableImportV2.
+
+table_handle: Handle to a table.
+container: If non-empty, this table is placed in the given container.
+  Otherwise, a default container is used.
+shared_name: If non-empty, this table is shared under the given name across
+  multiple sessions.
+use_node_name_sharing: If true and shared_name is empty, the table is shared
+  using the node name.
+key_dtype: Type of the table keys.
+value_dtype: Type of the table values.
+embedding_dim: The size of the embeddings.
+min_frequency: The number of lookups of an ID before it is admitted.
+max_num_entries: The maximum number of IDs in the table, or 0 for no limit.
+eviction_policy: Which ID to evict from a full table, 'lru' or 'lfu'.
+initial_stddev: The standard deviation of the random initial embeddings.
+seed: The seed of the random initial embeddings, which only depend on the seed
+  and the ID.
+optimizer: The optimizer of DynamicEmbeddingTableApplyGradientsV2, 'sgd' or
+  'adagrad'.
+initial_accumulator_value: The initial Adagrad accumulators.
+)doc");
+
+REGISTER_OP("DynamicEmbeddingTableApplyGradientsV2")
+    .Input("table_handle: resource")
+    .Input("keys: Tkeys")
+    .Input("gradients: Tvalues")
+    .Input("learning_rate: Tvalues")
+    .Attr("Tkeys: type")
+    .Attr("Tvalues: type")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 0, &unused));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Updates the embeddings of a dynamic embedding table by their gradients.
+
+The update is made by the optimizer the table was created with. Keys that are
+not in the table are ignored.
+
+table_handle: Handle to the table.
+keys: Any shape. Keys of the embeddings to update.
+gradients: The gradients of the loss with respect to the embeddings of `keys`,
+  of shape `keys.shape + [embedding_dim]`.
+learning_rate: Scaling factor. Must be a scalar.
+)doc");
+
+REGISTER_OP("DynamicEmbeddingTableExportV2")
+    .Input("table_handle: resource")
+    .Output("keys: Tkeys")
+    .Output("values: Tvalues")
+    .Output("frequencies: int64")
+    .Output("accumulators: Tvalues")
+    .Attr("Tkeys: type")
+    .Attr("Tvalues: type")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle handle;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &handle));
+      DimensionHandle size = c->UnknownDim();
+      c->set_output(0, c->Vector(size));
+      c->set_output(1, c->Matrix(size, c->UnknownDim()));
+      c->set_output(2, c->Vector(size));
+      c->set_output(3, c->Matrix(size, c->UnknownDim()));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Outputs all the entries of a dynamic embedding table.
+
+table_handle: Handle to the table.
+keys: Vector of all keys present in the table.
+values: Matrix of the embeddings of `keys`.
+frequencies: Vector of the number of lookups of `keys`.
+accumulators: Matrix of the Adagrad accumulators of `keys`, with no columns
+  if the table is not trained by Adagrad.
+)doc");
+
+REGISTER_OP("DynamicEmbeddingTableImportV2")
+    .Input("table_handle: resource")
+    .Input("keys: Tkeys")
+    .Input("values: Tvalues")
+    .Input("frequencies: int64")
+    .Input("accumulators: Tvalues")
+    .Attr("Tkeys: type")
+    .Attr("Tvalues: type")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 2, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(3), 1, &unused));
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(4), 2, &unused));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Replaces the entries of a dynamic embedding table.
+
+The inputs are as output by DynamicEmbeddingTableExportV2. Accumulators are
+only restored into tables trained by Adagrad, from such tables.
+
+table_handle: Handle to the table.
+keys: Vector of keys.
+values: Matrix of the embeddings of `keys`.
+frequencies: Vector of the number of lookups of `keys`.
+accumulators: Matrix of the Adagrad accumulators of `keys`.
+)doc");
+
 REGISTER_OP("InitializeTable")
     .Input("table_handle: Ref(string)")
     .Input("keys: Tkey")
@@ -1073,7 +1073,7 @@ REGISTER_OP("MatMul")
     .Output("product: T")
     .Attr("transpose_a: bool = false")
     .Attr("transpose_b: bool = false")
-    .Attr("T: {half, float, double, int32, complex64, complex128}")
+    .Attr("T: {bfloat16, half, float, double, int32, complex64, complex128}")
     .SetShapeFn(shape_inference::MatMulShape)
     .Doc(R"doc(
 Multiply the matrix "a" by the matrix "b".
@@ -1090,6 +1090,72 @@ transpose_a: If true, "a" is transposed before multiplication.
 transpose_b: If true, "b" is transposed before multiplication.
 )doc");
 
+REGISTER_OP("_FusedMatMul")
+    .Input("a: T")
+    .Input("b: T")
+    .Input("args: num_args * T")
+    .Output("product: T")
+    .Attr("transpose_a: bool = false")
+    .Attr("transpose_b: bool = false")
+    .Attr("T: {half, float, double}")
+    .Attr("num_args: int >= 0")
+    .Attr("fused_ops: list(string) = []")
+    .SetShapeFn(shape_inference::MatMulShape)
+    .Doc(R"doc(
+Multiplies the matrix "a" by the matrix "b" like MatMul, followed by the ops in
+`fused_ops`.
+
+The supported `fused_ops` are "BiasAdd", whose bias is the only element of
+`args`, optionally followed by "Relu", "Relu6" or "Elu". They are applied in a
+single pass over the product.
+
+NOTE Do not invoke this operator directly in Python. A grappler pass is
+expected to create these operators.
+)doc");
+
+REGISTER_OP("PackedMatMul")
+    .Input("a: float")
+    .Input("packed_b: float")
+    .Output("product: float")
+    .Attr("transpose_a: bool = false")
+    .Attr("n: int >= 1")
+    .Attr("k: int >= 1")
+    .Attr("isa: string")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle a;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 2, &a));
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &unused));
+      bool transpose_a;
+      int64 n;
+      int64 k;
+      TF_RETURN_IF_ERROR(c->GetAttr("transpose_a", &transpose_a));
+      TF_RETURN_IF_ERROR(c->GetAttr("n", &n));
+      TF_RETURN_IF_ERROR(c->GetAttr("k", &k));
+      DimensionHandle unused_dim;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(a, transpose_a ? 0 : 1), c->MakeDim(k), &unused_dim));
+      c->set_output(0, c->Matrix(c->Dim(a, transpose_a ? 1 : 0), n));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Multiply the matrix "a" by a constant matrix "b" packed for the CPU kernels.
+
+`packed_b` holds the k x n matrix "b" (after being transposed if needed) in the
+blocked layout that the float MatMul kernels compiled for `isa` compute on. It
+is produced offline by the `pack_matmul_weights` graph transform, so that
+frozen graphs don't pack their weights at every step. The op only runs on CPUs
+that support `isa`.
+
+a: The left-hand side, whose inner dimension (after being transposed if
+  transpose_a is true) must be k.
+packed_b: The packed "b", flattened.
+transpose_a: If true, "a" is transposed before multiplication.
+n: The number of columns of "b".
+k: The number of rows of "b".
+isa: The instruction set that `packed_b` is packed for, "AVX" or "AVX2+FMA".
+)doc");
+
 REGISTER_OP("SparseMatMul")
     .Input("a: Ta")
     .Input("b: Tb")
@@ -2257,6 +2323,58 @@ Tactivation: The type of output produced by activation function
 
 )doc");
 
+REGISTER_OP("QuantizedMatMulAndRequantize")
+    .Input("a: T1")
+    .Input("b: T2")
+    .Input("min_a: float")
+    .Input("max_a: float")
+    .Input("min_b: float")
+    .Input("max_b: float")
+    .Input("requested_output_min: float")
+    .Input("requested_output_max: float")
+    .Output("out: Toutput")
+    .Output("min_out: float")
+    .Output("max_out: float")
+    .Attr("T1: quantizedtype")
+    .Attr("T2: quantizedtype")
+    .Attr("Toutput: quantizedtype = DT_QUINT8")
+    .Attr("transpose_a: bool = false")
+    .Attr("transpose_b: bool = false")
+    .SetShapeFn([](InferenceContext* c) {
+      TF_RETURN_IF_ERROR(shape_inference::MatMulShape(c));
+      ShapeHandle unused;
+      for (int i = 2; i < 8; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+      }
+      c->set_output(1, c->Scalar());
+      c->set_output(2, c->Scalar());
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Perform a quantized matrix multiplication of `a` by `b`, then requantize it.
+
+This is equivalent to a QuantizedMatMul followed by a Requantize with the given
+requested range, but avoids passing the 32-bit results between two ops. It's
+typically produced by the fuse_quantized_requantizes graph transform from graphs
+whose requantization ranges have been frozen.
+
+a: Must be a two-dimensional tensor.
+b: Must be a two-dimensional tensor.
+transpose_a: If true, `a` is transposed before multiplication.
+transpose_b: If true, `b` is transposed before multiplication.
+min_a: The float value that the lowest quantized `a` value represents.
+max_a: The float value that the highest quantized `a` value represents.
+min_b: The float value that the lowest quantized `b` value represents.
+max_b: The float value that the highest quantized `b` value represents.
+requested_output_min: The float value that the lowest quantized output value
+  represents.
+requested_output_max: The float value that the highest quantized output value
+  represents.
+min_out: The requested_output_min value is copied into this output.
+max_out: The requested_output_max value is copied into this output.
+
+)doc");
+
 REGISTER_OP("QuantizedMul")
     .Input("x: T1")
     .Input("y: T2")
@@ -552,6 +552,30 @@ data_format: Specify the data format of the input and output data. With the
         [batch, channels, height, width].
 )doc");
 
+REGISTER_OP("_FusedConv2D")
+    .Input("input: T")
+    .Input("filter: T")
+    .Input("args: num_args * T")
+    .Output("output: T")
+    .Attr("T: {half, float}")
+    .Attr("num_args: int >= 0")
+    .Attr("strides: list(int)")
+    .Attr("use_cudnn_on_gpu: bool = true")
+    .Attr(GetPaddingAttrString())
+    .Attr(GetConvnetDataFormatAttrString())
+    .Attr("fused_ops: list(string) = []")
+    .SetShapeFn(shape_inference::Conv2DShape)
+    .Doc(R"doc(
+Computes a 2-D convolution like Conv2D, followed by the ops in `fused_ops`.
+
+The supported `fused_ops` are "BiasAdd", whose bias is the only element of
+`args`, optionally followed by "Relu", "Relu6" or "Elu". They are applied in a
+single pass over the output of the convolution.
+
+NOTE Do not invoke this operator directly in Python. A grappler pass is
+expected to create these operators.
+)doc");
+
 REGISTER_OP("Conv2DBackpropInput")
     .Input("input_sizes: int32")
     .Input("filter: T")
@@ -2373,6 +2397,54 @@ max_out: The float value that the highest quantized output value represents.
 
 )doc");
 
+REGISTER_OP("QuantizedBiasAddAndRequantize")
+    .Input("input: T1")
+    .Input("bias: T2")
+    .Input("min_input: float")
+    .Input("max_input: float")
+    .Input("min_bias: float")
+    .Input("max_bias: float")
+    .Input("requested_output_min: float")
+    .Input("requested_output_max: float")
+    .Output("output: out_type")
+    .Output("min_out: float")
+    .Output("max_out: float")
+    .Attr("T1: quantizedtype")
+    .Attr("T2: quantizedtype")
+    .Attr("out_type: quantizedtype = DT_QUINT8")
+    .SetShapeFn([](InferenceContext* c) {
+      TF_RETURN_IF_ERROR(shape_inference::BiasAddShape(c));
+      ShapeHandle unused;
+      for (int i = 2; i < 8; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+      }
+      c->set_output(1, c->Scalar());
+      c->set_output(2, c->Scalar());
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Adds Tensor 'bias' to Tensor 'input' and requantizes the sums to eight bits.
+
+Broadcasts the values of bias on dimensions 0..N-2 of 'input'. This is
+equivalent to a QuantizedBiasAdd followed by a Requantize with the
+given requested range, but avoids passing the 32-bit sums between two ops.
+It's typically produced by the fuse_quantized_requantizes graph transform from
+graphs whose requantization ranges have been frozen.
+
+bias: A 1D bias Tensor with size matching the last dimension of 'input'.
+min_input: The float value that the lowest quantized input value represents.
+max_input: The float value that the highest quantized input value represents.
+min_bias: The float value that the lowest quantized bias value represents.
+max_bias: The float value that the highest quantized bias value represents.
+requested_output_min: The float value that the lowest quantized output value
+  represents.
+requested_output_max: The float value that the highest quantized output value
+  represents.
+min_out: The requested_output_min value is copied into this output.
+max_out: The requested_output_max value is copied into this output.
+
+)doc");
+
 REGISTER_OP("QuantizedConv2D")
     .Input("input: Tinput")
     .Input("filter: Tfilter")
@@ -2419,6 +2491,58 @@ max_output: The float value that the highest quantized output value represents.
 
 )doc");
 
+REGISTER_OP("QuantizedConv2DAndRequantize")
+    .Input("input: Tinput")
+    .Input("filter: Tfilter")
+    .Input("min_input: float")
+    .Input("max_input: float")
+    .Input("min_filter: float")
+    .Input("max_filter: float")
+    .Input("requested_output_min: float")
+    .Input("requested_output_max: float")
+    .Output("output: out_type")
+    .Output("min_output: float")
+    .Output("max_output: float")
+    .Attr("Tinput: quantizedtype")
+    .Attr("Tfilter: quantizedtype")
+    .Attr("out_type: quantizedtype = DT_QUINT8")
+    .Attr("strides: list(int)")
+    .Attr(GetPaddingAttrString())
+    .SetShapeFn([](InferenceContext* c) {
+      TF_RETURN_IF_ERROR(shape_inference::Conv2DShape(c));
+      ShapeHandle unused;
+      for (int i = 2; i < 8; ++i) {
+        TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+      }
+      c->set_output(1, c->Scalar());
+      c->set_output(2, c->Scalar());
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Computes a quantized 2D convolution and requantizes it into a given range.
+
+This is equivalent to a QuantizedConv2D followed by a Requantize with the given
+requested range, but avoids passing the 32-bit results between two ops. It's
+typically produced by the fuse_quantized_requantizes graph transform from graphs
+whose requantization ranges have been frozen.
+
+filter: filter's input_depth dimension must match input's depth dimensions.
+strides: The stride of the sliding window for each dimension of the input
+  tensor.
+padding: The type of padding algorithm to use.
+min_input: The float value that the lowest quantized input value represents.
+max_input: The float value that the highest quantized input value represents.
+min_filter: The float value that the lowest quantized filter value represents.
+max_filter: The float value that the highest quantized filter value represents.
+requested_output_min: The float value that the lowest quantized output value
+  represents.
+requested_output_max: The float value that the highest quantized output value
+  represents.
+min_output: The requested_output_min value is copied into this output.
+max_output: The requested_output_max value is copied into this output.
+
+)doc");
+
 REGISTER_OP("QuantizedMaxPool")
     .Input("input: T")
     .Input("min_input: float")
@@ -216,6 +216,30 @@ is_initialized: a scalar boolean which is true if the variable has been
 initialized.
 )doc");
 
+REGISTER_OP("ResourceTakeDirtyRows")
+    .Input("resource: resource")
+    .Output("rows: int64")
+    .SetIsStateful()
+    .SetShapeFn([](InferenceContext* c) {
+      c->set_output(0, c->Vector(InferenceContext::kUnknownDim));
+      return Status::OK();
+    })
+    .Doc(R"doc(
+Returns the rows of a variable updated since the last call, and clears them.
+
+Used to write incremental checkpoints of large, sparsely updated variables such
+as embeddings: gathering `rows` from the variable (with a control dependency on
+this op) gives the rows that changed since the previous checkpoint, which can be
+written over it on restore, e.g. with `DynamicStitch`.
+
+The first call starts tracking the updates of the variable and returns all its
+rows. Updates that don't have row indices (like assignments and dense training
+ops) make the next call return all the rows as well.
+
+resource: handle to a variable of at least 1 dimension.
+rows: the indices of the rows updated since the last call, in increasing order.
+)doc");
+
 REGISTER_OP("ResourceGather")
     .Input("resource: resource")
     .Input("indices: Tindices")
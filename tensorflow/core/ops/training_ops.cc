@@ -1103,6 +1103,47 @@ var - lr * momentum * accum, so in the end, the var you get is actually
 var - lr * momentum * accum.
 )doc");
 
+static Status MultiApplyMomentumShapeFn(InferenceContext* c) {
+  int n;
+  TF_RETURN_IF_ERROR(c->GetAttr("N", &n));
+  ShapeHandle unused;
+  for (int i = 0; i < n; ++i) {
+    ShapeHandle s = c->input(i);                                    // var
+    TF_RETURN_IF_ERROR(c->Merge(s, c->input(n + i), &s));           // accum
+    TF_RETURN_IF_ERROR(c->Merge(s, c->input(2 * n + 1 + i), &s));  // grad
+  }
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(2 * n), 0, &unused));      // lr
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(3 * n + 1), 0, &unused));  // momentum
+  return Status::OK();
+}
+
+REGISTER_OP("_MultiApplyMomentum")
+    .Input("var: Ref(N * T)")
+    .Input("accum: Ref(N * T)")
+    .Input("lr: T")
+    .Input("grad: N * T")
+    .Input("momentum: T")
+    .Attr("N: int >= 1")
+    .Attr("T: numbertype")
+    .Attr("use_locking: bool = false")
+    .Attr("use_nesterov: bool = false")
+    .SetShapeFn(MultiApplyMomentumShapeFn)
+    .Doc(R"doc(
+Applies ApplyMomentum to N variables at once, with the same lr and momentum.
+Inserted by the graph optimizer in place of independent ApplyMomentum ops, so
+that devices can update all the variables with a few kernel launches.
+
+var: Should be from Variables.
+accum: Should be from Variables, one for every var.
+lr: Scaling factor. Must be a scalar.
+grad: The gradients, one for every var.
+momentum: Momentum. Must be a scalar.
+use_locking: If `True`, updating of the var and accum tensors will be protected
+  by a lock; otherwise the behavior is undefined, but may exhibit less
+  contention.
+use_nesterov: If `True`, uses the nesterov update.
+)doc");
+
 REGISTER_OP("ResourceSparseApplyMomentum")
     .Input("var: resource")
     .Input("accum: resource")
@@ -1243,6 +1284,60 @@ use_locking: If `True`, updating of the var, m, and v tensors will be protected
 use_nesterov: If `True`, uses the nesterov update.
 )doc");
 
+static Status MultiApplyAdamShapeFn(InferenceContext* c) {
+  int n;
+  TF_RETURN_IF_ERROR(c->GetAttr("N", &n));
+  ShapeHandle unused;
+  for (int i = 0; i < n; ++i) {
+    ShapeHandle s = c->input(i);                                    // var
+    TF_RETURN_IF_ERROR(c->Merge(s, c->input(n + i), &s));           // m
+    TF_RETURN_IF_ERROR(c->Merge(s, c->input(2 * n + i), &s));       // v
+    TF_RETURN_IF_ERROR(c->Merge(s, c->input(3 * n + 6 + i), &s));  // grad
+  }
+  // beta1_power, beta2_power, lr, beta1, beta2 and epsilon.
+  for (int i = 3 * n; i < 3 * n + 6; ++i) {
+    TF_RETURN_IF_ERROR(c->WithRank(c->input(i), 0, &unused));
+  }
+  return Status::OK();
+}
+
+REGISTER_OP("_MultiApplyAdam")
+    .Input("var: Ref(N * T)")
+    .Input("m: Ref(N * T)")
+    .Input("v: Ref(N * T)")
+    .Input("beta1_power: T")
+    .Input("beta2_power: T")
+    .Input("lr: T")
+    .Input("beta1: T")
+    .Input("beta2: T")
+    .Input("epsilon: T")
+    .Input("grad: N * T")
+    .Attr("N: int >= 1")
+    .Attr("T: numbertype")
+    .Attr("use_locking: bool = false")
+    .Attr("use_nesterov: bool = false")
+    .SetShapeFn(MultiApplyAdamShapeFn)
+    .Doc(R"doc(
+Applies ApplyAdam to N variables at once, with the same hyperparameters.
+Inserted by the graph optimizer in place of independent ApplyAdam ops, so that
+devices can update all the variables with a few kernel launches.
+
+var: Should be from Variables.
+m: Should be from Variables, one for every var.
+v: Should be from Variables, one for every var.
+beta1_power: Must be a scalar.
+beta2_power: Must be a scalar.
+lr: Scaling factor. Must be a scalar.
+beta1: Momentum factor. Must be a scalar.
+beta2: Momentum factor. Must be a scalar.
+epsilon: Ridge term. Must be a scalar.
+grad: The gradients, one for every var.
+use_locking: If `True`, updating of the var, m, and v tensors will be protected
+  by a lock; otherwise the behavior is undefined, but may exhibit less
+  contention.
+use_nesterov: If `True`, uses the nesterov update.
+)doc");
+
 static Status ApplyRMSPropShapeFn(InferenceContext* c, bool sparse) {
   ShapeHandle unused;
   ShapeHandle s = ShapeOrHandleShape(c, 0);                       // var
@@ -0,0 +1,175 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cloud/file_block_cache.h"
+#include <algorithm>
+#include <cstring>
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
+
+namespace tensorflow {
+
+FileBlockCache::FileBlockCache(size_t block_size, uint64 max_bytes,
+                               int num_fetch_threads,
+                               BlockFetcher block_fetcher, Env* env)
+    : block_size_(block_size),
+      max_bytes_(max_bytes),
+      block_fetcher_(std::move(block_fetcher)) {
+  CHECK_GT(block_size_, 0);
+  if (num_fetch_threads > 1) {
+    fetch_pool_.reset(
+        new thread::ThreadPool(env, "file_block_cache", num_fetch_threads));
+  }
+}
+
+Status FileBlockCache::Read(const string& filename, size_t offset, size_t n,
+                            char* buffer, size_t* bytes_transferred) {
+  *bytes_transferred = 0;
+  if (n == 0) {
+    return Status::OK();
+  }
+  const size_t start = offset - offset % block_size_;
+  const size_t finish = offset + n;
+
+  // Look up every block that the read overlaps, and claim the ones that are
+  // neither cached nor being fetched by another read.
+  std::vector<std::shared_ptr<Block>> blocks;
+  std::vector<std::pair<Key, std::shared_ptr<Block>>> to_fetch;
+  {
+    mutex_lock lock(mu_);
+    for (size_t pos = start; pos < finish; pos += block_size_) {
+      Key key = std::make_pair(filename, pos);
+      std::shared_ptr<Block>& block = block_map_[key];
+      if (!block) {
+        block = std::make_shared<Block>();
+        to_fetch.emplace_back(std::move(key), block);
+      } else if (block->fetched) {
+        lru_list_.splice(lru_list_.begin(), lru_list_, block->lru_iterator);
+      }
+      blocks.push_back(block);
+    }
+  }
+
+  if (fetch_pool_ && to_fetch.size() > 1) {
+    // Fetch the first block on the calling thread, and the others on the
+    // fetch threads.
+    BlockingCounter counter(to_fetch.size() - 1);
+    for (size_t i = 1; i < to_fetch.size(); ++i) {
+      fetch_pool_->Schedule([this, &to_fetch, &counter, i]() {
+        FetchBlock(to_fetch[i].first, to_fetch[i].second);
+        counter.DecrementCount();
+      });
+    }
+    FetchBlock(to_fetch[0].first, to_fetch[0].second);
+    counter.Wait();
+  } else {
+    for (const auto& key_and_block : to_fetch) {
+      FetchBlock(key_and_block.first, key_and_block.second);
+    }
+  }
+
+  // Wait for the blocks that other reads are fetching.
+  {
+    mutex_lock lock(mu_);
+    for (const auto& block : blocks) {
+      while (!block->fetched) {
+        fetched_cond_var_.wait(lock);
+      }
+    }
+  }
+
+  // A fetched block is immutable, so it can be copied without the lock.
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    const Block& block = *blocks[i];
+    TF_RETURN_IF_ERROR(block.status);
+    const size_t pos = start + i * block_size_;
+    const size_t begin = std::max(pos, offset) - pos;
+    if (begin >= block.data.size()) {
+      break;
+    }
+    const size_t end = std::min(block.data.size(), finish - pos);
+    std::memcpy(buffer + *bytes_transferred, block.data.data() + begin,
+                end - begin);
+    *bytes_transferred += end - begin;
+    if (block.data.size() < block_size_) {
+      // The block is the last one of the file.
+      break;
+    }
+  }
+  return Status::OK();
+}
+
+void FileBlockCache::FetchBlock(const Key& key,
+                                const std::shared_ptr<Block>& block) {
+  std::vector<char> data;
+  Status status = block_fetcher_(key.first, key.second, block_size_, &data);
+  if (status.ok() && data.size() > block_size_) {
+    status = errors::Internal("Fetched ", data.size(), " bytes of ", key.first,
+                              " at offset ", key.second, ", but expected at "
+                              "most ", block_size_, " bytes.");
+  }
+
+  mutex_lock lock(mu_);
+  block->data.swap(data);
+  block->status = status;
+  block->fetched = true;
+  // The block may have been removed (and even replaced) by `RemoveFile()`
+  // while it was being fetched, in which case it is returned to the reads
+  // that are waiting for it but not cached.
+  auto it = block_map_.find(key);
+  if (it != block_map_.end() && it->second == block) {
+    if (status.ok() && !block->data.empty()) {
+      lru_list_.push_front(key);
+      block->lru_iterator = lru_list_.begin();
+      cache_size_ += block->data.size();
+      Trim();
+    } else {
+      // Failed fetches are not cached, so that the next read retries them,
+      // and neither are the empty blocks past the end of a file, which would
+      // otherwise never be evicted.
+      block_map_.erase(it);
+    }
+  }
+  fetched_cond_var_.notify_all();
+}
+
+void FileBlockCache::Trim() {
+  while (cache_size_ > max_bytes_ && !lru_list_.empty()) {
+    auto it = block_map_.find(lru_list_.back());
+    cache_size_ -= it->second->data.size();
+    block_map_.erase(it);
+    lru_list_.pop_back();
+  }
+}
+
+void FileBlockCache::RemoveFile(const string& filename) {
+  mutex_lock lock(mu_);
+  auto it = block_map_.lower_bound(std::make_pair(filename, size_t{0}));
+  while (it != block_map_.end() && it->first.first == filename) {
+    const Block& block = *it->second;
+    if (block.fetched) {
+      cache_size_ -= block.data.size();
+      lru_list_.erase(block.lru_iterator);
+    }
+    it = block_map_.erase(it);
+  }
+}
+
+uint64 FileBlockCache::CacheSize() const {
+  mutex_lock lock(mu_);
+  return cache_size_;
+}
+
+}  // namespace tensorflow
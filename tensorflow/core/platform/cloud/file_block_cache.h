@@ -0,0 +1,115 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_PLATFORM_CLOUD_FILE_BLOCK_CACHE_H_
+#define TENSORFLOW_CORE_PLATFORM_CLOUD_FILE_BLOCK_CACHE_H_
+
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+/// \brief An LRU cache of fixed-size blocks of remote files.
+///
+/// The cache is shared by all the files of a file system: blocks are keyed by
+/// the name of their file and their offset in it, and the least recently used
+/// blocks are evicted once the cache holds more than `max_bytes` bytes.
+///
+/// The blocks that a read needs and that are not cached are fetched
+/// concurrently, on up to `num_fetch_threads` threads. A block that is being
+/// fetched is not fetched again by concurrent reads, which wait for it
+/// instead. This class is thread-safe.
+class FileBlockCache {
+ public:
+  /// The callback that fetches `n` bytes at `offset` of the file `filename`
+  /// into `out`, which is cleared first. Fewer bytes than requested are
+  /// returned only at the end of the file. It is called concurrently.
+  typedef std::function<Status(const string& filename, size_t offset,
+                               size_t n, std::vector<char>* out)>
+      BlockFetcher;
+
+  FileBlockCache(size_t block_size, uint64 max_bytes, int num_fetch_threads,
+                 BlockFetcher block_fetcher, Env* env = Env::Default());
+
+  /// \brief Reads `n` bytes at `offset` of the file `filename` into `buffer`.
+  ///
+  /// Sets `*bytes_transferred` to the number of bytes read, which is less
+  /// than `n` only if the end of the file was reached.
+  Status Read(const string& filename, size_t offset, size_t n, char* buffer,
+              size_t* bytes_transferred);
+
+  /// Evicts the blocks of the file `filename`, e.g. after it was modified.
+  void RemoveFile(const string& filename) LOCKS_EXCLUDED(mu_);
+
+  size_t block_size() const { return block_size_; }
+  uint64 max_bytes() const { return max_bytes_; }
+
+  /// The number of bytes of the blocks in the cache.
+  uint64 CacheSize() const LOCKS_EXCLUDED(mu_);
+
+ private:
+  /// A block is identified by its file name and its offset in that file.
+  typedef std::pair<string, size_t> Key;
+
+  struct Block {
+    std::vector<char> data;
+    /// True once the block has been fetched, successfully or not.
+    bool fetched = false;
+    Status status;
+    /// The position of the block in `lru_list_`, if `fetched` is true and the
+    /// block is in `block_map_`.
+    std::list<Key>::iterator lru_iterator;
+  };
+
+  /// Fetches `block`, and publishes the result to the other reads.
+  void FetchBlock(const Key& key, const std::shared_ptr<Block>& block)
+      LOCKS_EXCLUDED(mu_);
+
+  /// Evicts least recently used blocks until the cache fits in `max_bytes_`.
+  void Trim() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const size_t block_size_;
+  const uint64 max_bytes_;
+  const BlockFetcher block_fetcher_;
+
+  mutable mutex mu_;
+  condition_variable fetched_cond_var_;
+  std::map<Key, std::shared_ptr<Block>> block_map_ GUARDED_BY(mu_);
+  /// The keys of the fetched blocks, the most recently used first.
+  std::list<Key> lru_list_ GUARDED_BY(mu_);
+  uint64 cache_size_ GUARDED_BY(mu_) = 0;
+
+  /// Used to fetch the blocks of a read in parallel, if `num_fetch_threads`
+  /// is greater than one.
+  std::unique_ptr<thread::ThreadPool> fetch_pool_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(FileBlockCache);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_PLATFORM_CLOUD_FILE_BLOCK_CACHE_H_
@@ -0,0 +1,204 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/cloud/file_block_cache.h"
+#include <map>
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+/// A fake file system that records the blocks that are fetched from it.
+class FakeFiles {
+ public:
+  FileBlockCache::BlockFetcher fetcher() {
+    return [this](const string& filename, size_t offset, size_t n,
+                  std::vector<char>* out) {
+      {
+        mutex_lock lock(mu_);
+        fetches_.emplace_back(filename, offset);
+      }
+      auto it = files_.find(filename);
+      if (it == files_.end()) {
+        return errors::NotFound(filename);
+      }
+      out->clear();
+      const string& contents = it->second;
+      if (offset < contents.size()) {
+        const size_t end = std::min(contents.size(), offset + n);
+        out->insert(out->end(), contents.begin() + offset,
+                    contents.begin() + end);
+      }
+      return Status::OK();
+    };
+  }
+
+  std::vector<std::pair<string, size_t>> fetches() {
+    mutex_lock lock(mu_);
+    return fetches_;
+  }
+
+  void set_contents(const string& filename, const string& contents) {
+    files_[filename] = contents;
+  }
+
+ private:
+  std::map<string, string> files_;
+  mutex mu_;
+  std::vector<std::pair<string, size_t>> fetches_ GUARDED_BY(mu_);
+};
+
+string ReadString(FileBlockCache* cache, const string& filename,
+                  size_t offset, size_t n) {
+  std::vector<char> buffer(n);
+  size_t bytes_transferred;
+  TF_EXPECT_OK(
+      cache->Read(filename, offset, n, buffer.data(), &bytes_transferred));
+  return string(buffer.data(), bytes_transferred);
+}
+
+TEST(FileBlockCacheTest, ReadsSpanningBlocks) {
+  FakeFiles files;
+  files.set_contents("a", "0123456789abcdefghij");
+  FileBlockCache cache(4, 100, 1, files.fetcher());
+
+  EXPECT_EQ("0123", ReadString(&cache, "a", 0, 4));
+  EXPECT_EQ("3456789a", ReadString(&cache, "a", 3, 8));
+  EXPECT_EQ("ghij", ReadString(&cache, "a", 16, 10));
+  EXPECT_EQ("", ReadString(&cache, "a", 20, 4));
+  EXPECT_EQ("", ReadString(&cache, "a", 5, 0));
+
+  // Every block was fetched once, except for the empty blocks past the end
+  // of the file, which are not cached.
+  EXPECT_EQ((std::vector<std::pair<string, size_t>>{{"a", 0},
+                                                    {"a", 4},
+                                                    {"a", 8},
+                                                    {"a", 16},
+                                                    {"a", 20},
+                                                    {"a", 24},
+                                                    {"a", 20}}),
+            files.fetches());
+  EXPECT_EQ(16, cache.CacheSize());
+}
+
+TEST(FileBlockCacheTest, SharedAcrossFiles) {
+  FakeFiles files;
+  files.set_contents("a", "aaaaaaaa");
+  files.set_contents("b", "bbbbbbbb");
+  FileBlockCache cache(4, 100, 1, files.fetcher());
+
+  EXPECT_EQ("aaaa", ReadString(&cache, "a", 2, 4));
+  EXPECT_EQ("bbbb", ReadString(&cache, "b", 2, 4));
+  EXPECT_EQ("aaaa", ReadString(&cache, "a", 4, 4));
+  EXPECT_EQ(4, files.fetches().size());
+  EXPECT_EQ(16, cache.CacheSize());
+}
+
+TEST(FileBlockCacheTest, EvictsLeastRecentlyUsed) {
+  FakeFiles files;
+  files.set_contents("a", "0123456789ab");
+  FileBlockCache cache(4, 8, 1, files.fetcher());
+
+  EXPECT_EQ("0123", ReadString(&cache, "a", 0, 4));
+  EXPECT_EQ("4567", ReadString(&cache, "a", 4, 4));
+  // Make the first block the most recently used, so that reading the third
+  // block evicts the second one.
+  EXPECT_EQ("0123", ReadString(&cache, "a", 0, 4));
+  EXPECT_EQ("89ab", ReadString(&cache, "a", 8, 4));
+  EXPECT_EQ(8, cache.CacheSize());
+  EXPECT_EQ("0123", ReadString(&cache, "a", 0, 4));
+  EXPECT_EQ("4567", ReadString(&cache, "a", 4, 4));
+  EXPECT_EQ((std::vector<std::pair<string, size_t>>{
+                {"a", 0}, {"a", 4}, {"a", 8}, {"a", 4}}),
+            files.fetches());
+}
+
+TEST(FileBlockCacheTest, ReadLargerThanCache) {
+  FakeFiles files;
+  files.set_contents("a", "0123456789ab");
+  FileBlockCache cache(4, 4, 1, files.fetcher());
+
+  EXPECT_EQ("0123456789ab", ReadString(&cache, "a", 0, 12));
+  EXPECT_EQ(4, cache.CacheSize());
+}
+
+TEST(FileBlockCacheTest, RemoveFile) {
+  FakeFiles files;
+  files.set_contents("a", "aaaa");
+  files.set_contents("b", "bbbb");
+  FileBlockCache cache(4, 100, 1, files.fetcher());
+
+  EXPECT_EQ("aaaa", ReadString(&cache, "a", 0, 4));
+  EXPECT_EQ("bbbb", ReadString(&cache, "b", 0, 4));
+  files.set_contents("a", "AAAA");
+  cache.RemoveFile("a");
+  EXPECT_EQ(4, cache.CacheSize());
+  EXPECT_EQ("AAAA", ReadString(&cache, "a", 0, 4));
+  EXPECT_EQ("bbbb", ReadString(&cache, "b", 0, 4));
+  EXPECT_EQ(3, files.fetches().size());
+}
+
+TEST(FileBlockCacheTest, FailedFetchesAreNotCached) {
+  FakeFiles files;
+  FileBlockCache cache(4, 100, 1, files.fetcher());
+
+  char buffer[4];
+  size_t bytes_transferred;
+  EXPECT_TRUE(errors::IsNotFound(
+      cache.Read("a", 0, 4, buffer, &bytes_transferred)));
+  files.set_contents("a", "aaaa");
+  EXPECT_EQ("aaaa", ReadString(&cache, "a", 0, 4));
+  EXPECT_EQ(2, files.fetches().size());
+}
+
+TEST(FileBlockCacheTest, FetchesBlocksInParallel) {
+  // The fetcher only returns once all the blocks of the read are being
+  // fetched, so the read only completes if they are fetched concurrently.
+  BlockingCounter counter(4);
+  FakeFiles files;
+  files.set_contents("a", "0123456789abcdef");
+  FileBlockCache::BlockFetcher fetcher = files.fetcher();
+  FileBlockCache cache(
+      4, 100, 4, [&counter, &fetcher](const string& filename, size_t offset,
+                                      size_t n, std::vector<char>* out) {
+        counter.DecrementCount();
+        counter.Wait();
+        return fetcher(filename, offset, n, out);
+      });
+
+  EXPECT_EQ("0123456789abcdef", ReadString(&cache, "a", 0, 16));
+  EXPECT_EQ(4, files.fetches().size());
+}
+
+TEST(FileBlockCacheTest, ConcurrentReadsOfTheSameBlock) {
+  FakeFiles files;
+  files.set_contents("a", "0123456789abcdef");
+  FileBlockCache cache(16, 100, 1, files.fetcher());
+  {
+    thread::ThreadPool pool(Env::Default(), "test", 8);
+    for (int i = 0; i < 8; ++i) {
+      pool.Schedule([&cache]() {
+        EXPECT_EQ("0123456789abcdef", ReadString(&cache, "a", 0, 16));
+      });
+    }
+  }
+  EXPECT_EQ(1, files.fetches().size());
+}
+
+}  // namespace
+}  // namespace tensorflow
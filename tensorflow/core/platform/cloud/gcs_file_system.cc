@@ -23,16 +23,20 @@ limitations under the License.
 #include <fstream>
 #include <vector>
 #include "include/json/json.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/cloud/file_block_cache.h"
 #include "tensorflow/core/platform/cloud/google_auth_provider.h"
 #include "tensorflow/core/platform/cloud/retrying_utils.h"
 #include "tensorflow/core/platform/cloud/time_util.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/thread_annotations.h"
@@ -54,6 +58,35 @@ constexpr uint64 kUploadRetryDelayMicros = 1000000L;
 constexpr uint64 HTTP_CODE_RESUME_INCOMPLETE = 308;
 // The environment variable that overrides the size of the readahead buffer.
 constexpr char kReadaheadBufferSize[] = "GCS_READAHEAD_BUFFER_SIZE_BYTES";
+// The environment variable that overrides the block size of the read cache.
+// If it is 0, the read cache is disabled, and every random access file has
+// its own readahead buffer instead.
+constexpr char kBlockSize[] = "GCS_READ_CACHE_BLOCK_SIZE_BYTES";
+// The default block size of the read cache.
+constexpr size_t kDefaultBlockSize = 16 * 1024 * 1024;
+// The environment variable that overrides the capacity of the read cache.
+constexpr char kMaxCacheSize[] = "GCS_READ_CACHE_MAX_SIZE_BYTES";
+// The default capacity of the read cache.
+constexpr uint64 kDefaultMaxCacheSize = 256 * 1024 * 1024;
+// The environment variable that overrides the number of blocks of a read
+// that are fetched concurrently.
+constexpr char kNumFetchThreads[] = "GCS_READ_CACHE_NUM_FETCH_THREADS";
+// The default number of blocks of a read that are fetched concurrently.
+constexpr int kDefaultNumFetchThreads = 8;
+// The environment variable that sets the size from which files are uploaded
+// as parallel composite uploads. If it is unset or 0, they never are.
+constexpr char kCompositeUploadThreshold[] =
+    "GCS_COMPOSITE_UPLOAD_THRESHOLD_BYTES";
+// The environment variable that overrides the maximum number of components of
+// a composite upload.
+constexpr char kCompositeUploadMaxComponents[] =
+    "GCS_COMPOSITE_UPLOAD_MAX_COMPONENTS";
+// The environment variable that overrides the number of components of a
+// composite upload that are uploaded concurrently.
+constexpr char kCompositeUploadNumThreads[] =
+    "GCS_COMPOSITE_UPLOAD_NUM_THREADS";
+// The maximum number of objects that a single GCS compose request accepts.
+constexpr int kMaxComposeComponents = 32;
 
 // The file statistics returned by Stat() for directories.
 const FileStatistics DIRECTORY_STAT(0, 0, true);
@@ -103,6 +136,15 @@ Status ParseGcsPath(StringPiece fname, bool empty_object_ok, string* bucket,
   return Status::OK();
 }
 
+/// \brief Returns the name of a GCS object in the block cache.
+///
+/// The name is built from the bucket and the object, rather than taken from
+/// the path that the caller passed, so that every path to an object has the
+/// same blocks.
+string GcsPathForCache(const string& bucket, const string& object) {
+  return strings::StrCat("gs://", bucket, "/", object);
+}
+
 /// Appends a trailing slash if the name doesn't already have one.
 string MaybeAppendSlash(const string& name) {
   if (name.empty()) {
@@ -300,6 +342,37 @@ class GcsRandomAccessFile : public RandomAccessFile {
   mutable size_t buffer_start_offset_ GUARDED_BY(mu_) = 0;
 };
 
+/// A GCS-based implementation of a random access file that reads through the
+/// block cache shared by all the files of a file system.
+class GcsCachedRandomAccessFile : public RandomAccessFile {
+ public:
+  GcsCachedRandomAccessFile(const string& filename,
+                            FileBlockCache* file_block_cache)
+      : filename_(filename), file_block_cache_(file_block_cache) {}
+
+  /// The implementation of reads with the block cache. Thread-safe.
+  Status Read(uint64 offset, size_t n, StringPiece* result,
+              char* scratch) const override {
+    *result = StringPiece();
+    size_t bytes_transferred;
+    TF_RETURN_IF_ERROR(file_block_cache_->Read(filename_, offset, n, scratch,
+                                               &bytes_transferred));
+    *result = StringPiece(scratch, bytes_transferred);
+    if (bytes_transferred < n) {
+      // This is not an error per se. The RandomAccessFile interface expects
+      // that Read returns OutOfRange if fewer bytes were read than requested.
+      return errors::OutOfRange("EOF reached, ", result->size(),
+                                " bytes were read out of ", n,
+                                " bytes requested.");
+    }
+    return Status::OK();
+  }
+
+ private:
+  const string filename_;
+  FileBlockCache* const file_block_cache_;
+};
+
 /// \brief GCS-based implementation of a writeable file.
 ///
 /// Since GCS objects are immutable, this implementation writes to a local
@@ -309,11 +382,16 @@ class GcsWritableFile : public WritableFile {
   GcsWritableFile(const string& bucket, const string& object,
                   AuthProvider* auth_provider,
                   HttpRequest::Factory* http_request_factory,
+                  FileBlockCache* file_block_cache,
+                  const GcsFileSystem::CompositeUploadOptions&
+                      composite_upload_options,
                   int64 initial_retry_delay_usec)
       : bucket_(bucket),
         object_(object),
         auth_provider_(auth_provider),
         http_request_factory_(http_request_factory),
+        file_block_cache_(file_block_cache),
+        composite_upload_options_(composite_upload_options),
         sync_needed_(true),
         initial_retry_delay_usec_(initial_retry_delay_usec) {
     if (GetTmpFilename(&tmp_content_filename_).ok()) {
@@ -331,11 +409,16 @@ class GcsWritableFile : public WritableFile {
                   AuthProvider* auth_provider,
                   const string& tmp_content_filename,
                   HttpRequest::Factory* http_request_factory,
+                  FileBlockCache* file_block_cache,
+                  const GcsFileSystem::CompositeUploadOptions&
+                      composite_upload_options,
                   int64 initial_retry_delay_usec)
       : bucket_(bucket),
         object_(object),
         auth_provider_(auth_provider),
         http_request_factory_(http_request_factory),
+        file_block_cache_(file_block_cache),
+        composite_upload_options_(composite_upload_options),
         sync_needed_(true),
         initial_retry_delay_usec_(initial_retry_delay_usec) {
     tmp_content_filename_ = tmp_content_filename;
@@ -376,6 +459,10 @@ class GcsWritableFile : public WritableFile {
     if (status.ok()) {
       sync_needed_ = false;
     }
+    if (file_block_cache_) {
+      // Even a failed upload may have modified the object.
+      file_block_cache_->RemoveFile(GcsPathForCache(bucket_, object_));
+    }
     return status;
   }
 
@@ -392,6 +479,13 @@ class GcsWritableFile : public WritableFile {
       return errors::Internal(
           "Could not write to the internal temporary file.");
     }
+    uint64 file_size;
+    TF_RETURN_IF_ERROR(GetCurrentFileSize(&file_size));
+    if (composite_upload_options_.threshold_bytes > 0 &&
+        file_size >= composite_upload_options_.threshold_bytes &&
+        composite_upload_options_.max_components > 1) {
+      return CompositeUpload(file_size);
+    }
     string session_uri;
     TF_RETURN_IF_ERROR(CreateNewUploadSession(&session_uri));
     uint64 already_uploaded = 0;
@@ -558,6 +652,148 @@ class GcsWritableFile : public WritableFile {
     return Status::OK();
   }
 
+  /// \brief Uploads the file as parallel component objects, and composes them.
+  ///
+  /// The components are deleted afterwards, whether the upload succeeded
+  /// or not.
+  Status CompositeUpload(uint64 file_size) {
+    const int max_components = std::min(
+        composite_upload_options_.max_components, kMaxComposeComponents);
+    const uint64 component_size =
+        (file_size + max_components - 1) / max_components;
+    const int num_components =
+        (file_size + component_size - 1) / component_size;
+    std::vector<string> component_names;
+    for (int i = 0; i < num_components; ++i) {
+      component_names.push_back(strings::StrCat(
+          object_, ".composite-upload-", i, "-of-", num_components));
+    }
+
+    std::vector<Status> statuses(num_components);
+    auto upload_component = [this, file_size, component_size,
+                             &component_names, &statuses](int i) {
+      const uint64 offset = i * component_size;
+      const uint64 size = std::min(component_size, file_size - offset);
+      statuses[i] = RetryingUtils::CallWithRetries(
+          [this, &component_names, i, offset, size]() {
+            return UploadComponent(component_names[i], offset, size);
+          },
+          initial_retry_delay_usec_);
+    };
+    const int num_threads =
+        std::min(composite_upload_options_.num_threads, num_components);
+    if (num_threads > 1) {
+      thread::ThreadPool pool(Env::Default(), "gcs_composite_upload",
+                              num_threads);
+      BlockingCounter counter(num_components);
+      for (int i = 0; i < num_components; ++i) {
+        pool.Schedule([&upload_component, &counter, i]() {
+          upload_component(i);
+          counter.DecrementCount();
+        });
+      }
+      counter.Wait();
+    } else {
+      for (int i = 0; i < num_components; ++i) {
+        upload_component(i);
+      }
+    }
+
+    Status status;
+    for (const Status& component_status : statuses) {
+      status.Update(component_status);
+    }
+    if (status.ok()) {
+      status = RetryingUtils::CallWithRetries(
+          [this, &component_names]() {
+            return ComposeComponents(component_names);
+          },
+          initial_retry_delay_usec_);
+    }
+    for (const string& component_name : component_names) {
+      const Status delete_status = DeleteComponent(component_name);
+      if (!delete_status.ok()) {
+        LOG(WARNING) << "Could not delete the temporary object gs://"
+                     << bucket_ << "/" << component_name << ": "
+                     << delete_status;
+      }
+    }
+    return status;
+  }
+
+  /// Uploads `size` bytes at `offset` of the file as the object `name`.
+  Status UploadComponent(const string& name, uint64 offset, uint64 size) {
+    string data(size, '\0');
+    std::ifstream infile(tmp_content_filename_, std::ifstream::binary);
+    infile.seekg(offset);
+    infile.read(&data[0], size);
+    if (!infile.good()) {
+      return errors::Internal(
+          "Could not read from the internal temporary file.");
+    }
+
+    string auth_token;
+    TF_RETURN_IF_ERROR(AuthProvider::GetToken(auth_provider_, &auth_token));
+
+    std::vector<char> output_buffer;
+    std::unique_ptr<HttpRequest> request(http_request_factory_->Create());
+    TF_RETURN_IF_ERROR(request->Init());
+    TF_RETURN_IF_ERROR(request->SetUri(strings::StrCat(
+        kGcsUploadUriBase, "b/", bucket_, "/o?uploadType=media&name=",
+        request->EscapeString(name))));
+    TF_RETURN_IF_ERROR(request->AddAuthBearerHeader(auth_token));
+    TF_RETURN_IF_ERROR(request->SetPostFromBuffer(data.data(), data.size()));
+    TF_RETURN_IF_ERROR(request->SetResultBuffer(&output_buffer));
+    TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when uploading gs://",
+                                    bucket_, "/", name);
+    return Status::OK();
+  }
+
+  /// Composes the objects `component_names`, in order, into the object.
+  Status ComposeComponents(const std::vector<string>& component_names) {
+    Json::Value compose_request;
+    Json::Value& source_objects = compose_request["sourceObjects"];
+    for (const string& component_name : component_names) {
+      Json::Value source_object;
+      source_object["name"] = component_name;
+      source_objects.append(source_object);
+    }
+    compose_request["destination"]["contentType"] =
+        "application/octet-stream";
+    const string body = Json::FastWriter().write(compose_request);
+
+    string auth_token;
+    TF_RETURN_IF_ERROR(AuthProvider::GetToken(auth_provider_, &auth_token));
+
+    std::vector<char> output_buffer;
+    std::unique_ptr<HttpRequest> request(http_request_factory_->Create());
+    TF_RETURN_IF_ERROR(request->Init());
+    TF_RETURN_IF_ERROR(request->SetUri(
+        strings::StrCat(kGcsUriBase, "b/", bucket_, "/o/",
+                        request->EscapeString(object_), "/compose")));
+    TF_RETURN_IF_ERROR(request->AddAuthBearerHeader(auth_token));
+    TF_RETURN_IF_ERROR(
+        request->AddHeader("Content-Type", "application/json"));
+    TF_RETURN_IF_ERROR(request->SetPostFromBuffer(body.data(), body.size()));
+    TF_RETURN_IF_ERROR(request->SetResultBuffer(&output_buffer));
+    TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when composing ",
+                                    GetGcsPath());
+    return Status::OK();
+  }
+
+  Status DeleteComponent(const string& name) {
+    string auth_token;
+    TF_RETURN_IF_ERROR(AuthProvider::GetToken(auth_provider_, &auth_token));
+
+    std::unique_ptr<HttpRequest> request(http_request_factory_->Create());
+    TF_RETURN_IF_ERROR(request->Init());
+    TF_RETURN_IF_ERROR(request->SetUri(strings::StrCat(
+        kGcsUriBase, "b/", bucket_, "/o/", request->EscapeString(name))));
+    TF_RETURN_IF_ERROR(request->AddAuthBearerHeader(auth_token));
+    TF_RETURN_IF_ERROR(request->SetDeleteRequest());
+    return request->Send();
+  }
+
   string GetGcsPath() const {
     return strings::StrCat("gs://", bucket_, "/", object_);
   }
@@ -568,6 +804,8 @@ class GcsWritableFile : public WritableFile {
   string tmp_content_filename_;
   std::ofstream outfile_;
   HttpRequest::Factory* http_request_factory_;
+  FileBlockCache* file_block_cache_;  // not owned, may be null
+  const GcsFileSystem::CompositeUploadOptions composite_upload_options_;
   bool sync_needed_;  // whether there is buffered data that needs to be synced
   int64 initial_retry_delay_usec_;
 };
@@ -596,21 +834,109 @@ GcsFileSystem::GcsFileSystem()
       read_ahead_bytes_ = value;
     }
   }
+  // Apply the overrides for the read cache if they are provided.
+  uint64 block_size = kDefaultBlockSize;
+  uint64 max_bytes = kDefaultMaxCacheSize;
+  int64 num_fetch_threads = kDefaultNumFetchThreads;
+  uint64 value;
+  int64 signed_value;
+  const char* block_size_env = std::getenv(kBlockSize);
+  if (block_size_env && strings::safe_strtou64(block_size_env, &value)) {
+    block_size = value;
+  }
+  const char* max_bytes_env = std::getenv(kMaxCacheSize);
+  if (max_bytes_env && strings::safe_strtou64(max_bytes_env, &value)) {
+    max_bytes = value;
+  }
+  const char* num_fetch_threads_env = std::getenv(kNumFetchThreads);
+  if (num_fetch_threads_env &&
+      strings::safe_strto64(num_fetch_threads_env, &signed_value)) {
+    num_fetch_threads = signed_value;
+  }
+  MaybeCreateFileBlockCache(block_size, max_bytes, num_fetch_threads);
+  // Apply the overrides for composite uploads if they are provided.
+  const char* threshold_env = std::getenv(kCompositeUploadThreshold);
+  if (threshold_env && strings::safe_strtou64(threshold_env, &value)) {
+    composite_upload_options_.threshold_bytes = value;
+  }
+  const char* max_components_env = std::getenv(kCompositeUploadMaxComponents);
+  if (max_components_env &&
+      strings::safe_strto64(max_components_env, &signed_value)) {
+    composite_upload_options_.max_components = signed_value;
+  }
+  const char* num_threads_env = std::getenv(kCompositeUploadNumThreads);
+  if (num_threads_env &&
+      strings::safe_strto64(num_threads_env, &signed_value)) {
+    composite_upload_options_.num_threads = signed_value;
+  }
 }
 
 GcsFileSystem::GcsFileSystem(
     std::unique_ptr<AuthProvider> auth_provider,
     std::unique_ptr<HttpRequest::Factory> http_request_factory,
     size_t read_ahead_bytes, int64 initial_retry_delay_usec)
+    : GcsFileSystem(std::move(auth_provider), std::move(http_request_factory),
+                    read_ahead_bytes, 0 /* block size */, 0 /* max bytes */,
+                    0 /* num fetch threads */, initial_retry_delay_usec) {}
+
+GcsFileSystem::GcsFileSystem(
+    std::unique_ptr<AuthProvider> auth_provider,
+    std::unique_ptr<HttpRequest::Factory> http_request_factory,
+    size_t read_ahead_bytes, size_t block_size, uint64 max_bytes,
+    int num_fetch_threads, int64 initial_retry_delay_usec)
     : auth_provider_(std::move(auth_provider)),
       http_request_factory_(std::move(http_request_factory)),
       read_ahead_bytes_(read_ahead_bytes),
-      initial_retry_delay_usec_(initial_retry_delay_usec) {}
+      initial_retry_delay_usec_(initial_retry_delay_usec) {
+  MaybeCreateFileBlockCache(block_size, max_bytes, num_fetch_threads);
+}
+
+void GcsFileSystem::MaybeCreateFileBlockCache(size_t block_size,
+                                              uint64 max_bytes,
+                                              int num_fetch_threads) {
+  if (block_size == 0 || max_bytes == 0) {
+    return;
+  }
+  // The fetcher may be called after the constructor returns, but not after
+  // the cache, which the file system owns, is destroyed.
+  file_block_cache_.reset(new FileBlockCache(
+      block_size, max_bytes, num_fetch_threads,
+      [this](const string& filename, size_t offset, size_t n,
+             std::vector<char>* out) {
+        return LoadBufferFromGCS(filename, offset, n, out);
+      }));
+}
+
+Status GcsFileSystem::LoadBufferFromGCS(const string& filename, size_t offset,
+                                        size_t n, std::vector<char>* out) {
+  string bucket, object;
+  TF_RETURN_IF_ERROR(ParseGcsPath(filename, false, &bucket, &object));
+
+  string auth_token;
+  TF_RETURN_IF_ERROR(AuthProvider::GetToken(auth_provider_.get(), &auth_token));
+
+  std::unique_ptr<HttpRequest> request(http_request_factory_->Create());
+  TF_RETURN_IF_ERROR(request->Init());
+  TF_RETURN_IF_ERROR(
+      request->SetUri(strings::StrCat("https://", kStorageHost, "/", bucket,
+                                      "/", request->EscapeString(object))));
+  TF_RETURN_IF_ERROR(request->AddAuthBearerHeader(auth_token));
+  TF_RETURN_IF_ERROR(request->SetRange(offset, offset + n - 1));
+  TF_RETURN_IF_ERROR(request->SetResultBuffer(out));
+  TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when reading ",
+                                  filename);
+  return Status::OK();
+}
 
 Status GcsFileSystem::NewRandomAccessFile(
     const string& fname, std::unique_ptr<RandomAccessFile>* result) {
   string bucket, object;
   TF_RETURN_IF_ERROR(ParseGcsPath(fname, false, &bucket, &object));
+  if (file_block_cache_) {
+    result->reset(new GcsCachedRandomAccessFile(
+        GcsPathForCache(bucket, object), file_block_cache_.get()));
+    return Status::OK();
+  }
   result->reset(new GcsRandomAccessFile(bucket, object, auth_provider_.get(),
                                         http_request_factory_.get(),
                                         read_ahead_bytes_));
@@ -623,6 +949,8 @@ Status GcsFileSystem::NewWritableFile(const string& fname,
   TF_RETURN_IF_ERROR(ParseGcsPath(fname, false, &bucket, &object));
   result->reset(new GcsWritableFile(bucket, object, auth_provider_.get(),
                                     http_request_factory_.get(),
+                                    file_block_cache_.get(),
+                                    composite_upload_options_,
                                     initial_retry_delay_usec_));
   return Status::OK();
 }
@@ -663,7 +991,8 @@ Status GcsFileSystem::NewAppendableFile(const string& fname,
   TF_RETURN_IF_ERROR(ParseGcsPath(fname, false, &bucket, &object));
   result->reset(new GcsWritableFile(
       bucket, object, auth_provider_.get(), old_content_filename,
-      http_request_factory_.get(), initial_retry_delay_usec_));
+      http_request_factory_.get(), file_block_cache_.get(),
+      composite_upload_options_, initial_retry_delay_usec_));
   return Status::OK();
 }
 
@@ -1005,6 +1334,9 @@ Status GcsFileSystem::DeleteFile(const string& fname) {
   TF_RETURN_IF_ERROR(request->AddAuthBearerHeader(auth_token));
   TF_RETURN_IF_ERROR(request->SetDeleteRequest());
   TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when deleting ", fname);
+  if (file_block_cache_) {
+    file_block_cache_->RemoveFile(GcsPathForCache(bucket, object));
+  }
   return Status::OK();
 }
 
@@ -1100,6 +1432,10 @@ Status GcsFileSystem::RenameObject(const string& src, const string& target) {
   TF_RETURN_IF_ERROR(request->SetResultBuffer(&output_buffer));
   TF_RETURN_WITH_CONTEXT_IF_ERROR(request->Send(), " when renaming ", src,
                                   " to ", target);
+  if (file_block_cache_) {
+    file_block_cache_->RemoveFile(
+        GcsPathForCache(target_bucket, target_object));
+  }
 
   Json::Value root;
   StringPiece response_piece =
@@ -20,6 +20,7 @@ limitations under the License.
 #include <vector>
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/cloud/auth_provider.h"
+#include "tensorflow/core/platform/cloud/file_block_cache.h"
 #include "tensorflow/core/platform/cloud/http_request.h"
 #include "tensorflow/core/platform/cloud/retrying_file_system.h"
 #include "tensorflow/core/platform/file_system.h"
@@ -32,10 +33,36 @@ namespace tensorflow {
 /// which adds retry logic to GCS operations.
 class GcsFileSystem : public FileSystem {
  public:
+  /// \brief Options for parallel composite uploads of writable files.
+  ///
+  /// A file of at least `threshold_bytes` bytes is uploaded as up to
+  /// `max_components` component objects, on up to `num_threads` threads,
+  /// which are then composed into the destination object and deleted. Each
+  /// upload thread buffers its component in memory. Composite objects have a
+  /// CRC32C checksum but no MD5 hash.
+  struct CompositeUploadOptions {
+    /// If 0, files are always uploaded as a single stream.
+    uint64 threshold_bytes = 0;
+    /// At most 32, the number of objects that GCS composes at once.
+    int max_components = 32;
+    int num_threads = 8;
+  };
+
   GcsFileSystem();
   GcsFileSystem(std::unique_ptr<AuthProvider> auth_provider,
                 std::unique_ptr<HttpRequest::Factory> http_request_factory,
                 size_t read_ahead_bytes, int64 initial_retry_delay_usec);
+  /// \brief Creates a file system that reads through a block cache.
+  ///
+  /// The cache, which is shared by all the random access files of the file
+  /// system, holds up to `max_bytes` bytes in blocks of `block_size` bytes,
+  /// and fetches up to `num_fetch_threads` blocks of a read concurrently. If
+  /// `block_size` or `max_bytes` is 0, every random access file has its own
+  /// buffer of `read_ahead_bytes` bytes instead.
+  GcsFileSystem(std::unique_ptr<AuthProvider> auth_provider,
+                std::unique_ptr<HttpRequest::Factory> http_request_factory,
+                size_t read_ahead_bytes, size_t block_size, uint64 max_bytes,
+                int num_fetch_threads, int64 initial_retry_delay_usec);
 
   Status NewRandomAccessFile(
       const string& filename,
@@ -75,6 +102,18 @@ class GcsFileSystem : public FileSystem {
   Status DeleteRecursively(const string& dirname, int64* undeleted_files,
                            int64* undeleted_dirs) override;
   size_t get_readahead_buffer_size() const { return read_ahead_bytes_; }
+  size_t block_size() const {
+    return file_block_cache_ ? file_block_cache_->block_size() : 0;
+  }
+  uint64 max_bytes() const {
+    return file_block_cache_ ? file_block_cache_->max_bytes() : 0;
+  }
+  const CompositeUploadOptions& composite_upload_options() const {
+    return composite_upload_options_;
+  }
+  void set_composite_upload_options(const CompositeUploadOptions& options) {
+    composite_upload_options_ = options;
+  }
 
  private:
   /// \brief Checks if the bucket exists. Returns OK if the check succeeded.
@@ -108,6 +147,16 @@ class GcsFileSystem : public FileSystem {
                        FileStatistics* stat);
   Status RenameObject(const string& src, const string& target);
 
+  /// Creates `file_block_cache_`, unless `block_size` or `max_bytes` is 0.
+  void MaybeCreateFileBlockCache(size_t block_size, uint64 max_bytes,
+                                 int num_fetch_threads);
+
+  /// \brief Reads `n` bytes at `offset` of the object `filename` into `out`.
+  ///
+  /// This is the block fetcher of `file_block_cache_`.
+  Status LoadBufferFromGCS(const string& filename, size_t offset, size_t n,
+                           std::vector<char>* out);
+
   std::unique_ptr<AuthProvider> auth_provider_;
   std::unique_ptr<HttpRequest::Factory> http_request_factory_;
 
@@ -118,6 +167,12 @@ class GcsFileSystem : public FileSystem {
   // The initial delay for exponential backoffs when retrying failed calls.
   const int64 initial_retry_delay_usec_ = 1000000L;
 
+  CompositeUploadOptions composite_upload_options_;
+
+  // The block cache shared by the random access files, if enabled. It is
+  // declared last, so that it is destroyed before the members it reads with.
+  std::unique_ptr<FileBlockCache> file_block_cache_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(GcsFileSystem);
 };
 
@@ -192,6 +192,103 @@ TEST(GcsFileSystemTest, NewRandomAccessFile_WithReadAhead) {
   EXPECT_EQ("0123", result);
 }
 
+TEST(GcsFileSystemTest, NewRandomAccessFile_WithBlockCache) {
+  // The blocks of the two files share the cache, which fits two blocks.
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/file1.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 0-7\n",
+           "01234567"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/file1.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 8-15\n",
+           "89ab"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/file2.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 0-7\n",
+           "ABCDEFGH"),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/file1.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 0-7\n",
+           "01234567")});
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      0 /* read ahead bytes */, 8 /* block size */, 16 /* max bytes */,
+      1 /* num fetch threads */, 0 /* initial retry delay */);
+
+  std::unique_ptr<RandomAccessFile> file1;
+  TF_EXPECT_OK(fs.NewRandomAccessFile("gs://bucket/file1.txt", &file1));
+  std::unique_ptr<RandomAccessFile> file2;
+  TF_EXPECT_OK(fs.NewRandomAccessFile("gs://bucket/file2.txt", &file2));
+
+  char scratch[10];
+  StringPiece result;
+
+  // Read from the first block of file1, which is then cached.
+  TF_EXPECT_OK(file1->Read(0, 4, &result, scratch));
+  EXPECT_EQ("0123", result);
+  TF_EXPECT_OK(file1->Read(2, 4, &result, scratch));
+  EXPECT_EQ("2345", result);
+
+  // Read across the end of file1, which is in its second block.
+  EXPECT_EQ(errors::Code::OUT_OF_RANGE,
+            file1->Read(6, 10, &result, scratch).code());
+  EXPECT_EQ("6789ab", result);
+
+  // The second block of file1 is still cached, but reading file2 evicts the
+  // first one, which was used least recently.
+  TF_EXPECT_OK(file2->Read(4, 4, &result, scratch));
+  EXPECT_EQ("EFGH", result);
+  TF_EXPECT_OK(file1->Read(8, 2, &result, scratch));
+  EXPECT_EQ("89", result);
+  TF_EXPECT_OK(file1->Read(0, 2, &result, scratch));
+  EXPECT_EQ("01", result);
+}
+
+TEST(GcsFileSystemTest, NewRandomAccessFile_WithBlockCache_DeleteFile) {
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/file.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 0-7\n",
+           "01234567"),
+       new FakeHttpRequest("Uri: https://www.googleapis.com/storage/v1/b"
+                           "/bucket/o/file.txt\n"
+                           "Auth Token: fake_token\n"
+                           "Delete: yes\n",
+                           ""),
+       new FakeHttpRequest(
+           "Uri: https://storage.googleapis.com/bucket/file.txt\n"
+           "Auth Token: fake_token\n"
+           "Range: 0-7\n",
+           "",
+           errors::NotFound("404"), 404)});
+  GcsFileSystem fs(
+      std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+      std::unique_ptr<HttpRequest::Factory>(
+          new FakeHttpRequestFactory(&requests)),
+      0 /* read ahead bytes */, 8 /* block size */, 16 /* max bytes */,
+      1 /* num fetch threads */, 0 /* initial retry delay */);
+
+  std::unique_ptr<RandomAccessFile> file;
+  TF_EXPECT_OK(fs.NewRandomAccessFile("gs://bucket/file.txt", &file));
+
+  char scratch[4];
+  StringPiece result;
+  TF_EXPECT_OK(file->Read(0, 4, &result, scratch));
+  EXPECT_EQ("0123", result);
+
+  // Deleting the file evicts its blocks.
+  TF_EXPECT_OK(fs.DeleteFile("gs://bucket/file.txt"));
+  EXPECT_EQ(errors::Code::NOT_FOUND, file->Read(0, 4, &result, scratch).code());
+}
+
 TEST(GcsFileSystemTest, NewRandomAccessFile_NoObjectName) {
   std::vector<HttpRequest*> requests;
   GcsFileSystem fs(std::unique_ptr<AuthProvider>(new FakeAuthProvider),
@@ -236,6 +333,159 @@ TEST(GcsFileSystemTest, NewWritableFile) {
   TF_EXPECT_OK(file->Close());
 }
 
+TEST(GcsFileSystemTest, NewWritableFile_CompositeUpload) {
+  string compose_body;
+  std::vector<HttpRequest*> requests;
+  const char* components[] = {"0123", "4567", "89"};
+  for (int i = 0; i < 3; ++i) {
+    requests.push_back(new FakeHttpRequest(
+        strings::StrCat("Uri: https://www.googleapis.com/upload/storage/v1/b/"
+                        "bucket/o?uploadType=media&name=path%2Fwriteable.txt."
+                        "composite-upload-",
+                        i, "-of-3\n"
+                        "Auth Token: fake_token\n"
+                        "Post body: ",
+                        components[i], "\n"),
+        ""));
+  }
+  requests.push_back(new FakeHttpRequest(
+      "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/"
+      "path%2Fwriteable.txt/compose\n"
+      "Auth Token: fake_token\n"
+      "Header Content-Type: application/json\n",
+      "", &compose_body));
+  for (int i = 0; i < 3; ++i) {
+    requests.push_back(new FakeHttpRequest(
+        strings::StrCat("Uri: https://www.googleapis.com/storage/v1/b/bucket/"
+                        "o/path%2Fwriteable.txt.composite-upload-",
+                        i, "-of-3\n"
+                        "Auth Token: fake_token\n"
+                        "Delete: yes\n"),
+        ""));
+  }
+  GcsFileSystem fs(std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+                   std::unique_ptr<HttpRequest::Factory>(
+                       new FakeHttpRequestFactory(&requests)),
+                   0 /* read ahead bytes */, 0 /* initial retry delay */);
+  GcsFileSystem::CompositeUploadOptions options;
+  options.threshold_bytes = 10;
+  options.max_components = 3;
+  options.num_threads = 1;
+  fs.set_composite_upload_options(options);
+
+  std::unique_ptr<WritableFile> file;
+  TF_EXPECT_OK(fs.NewWritableFile("gs://bucket/path/writeable.txt", &file));
+
+  TF_EXPECT_OK(file->Append("01234"));
+  TF_EXPECT_OK(file->Append("56789"));
+  TF_EXPECT_OK(file->Close());
+  EXPECT_EQ(
+      "{\"destination\":{\"contentType\":\"application/octet-stream\"},"
+      "\"sourceObjects\":[{\"name\":\"path/writeable.txt.composite-upload-"
+      "0-of-3\"},{\"name\":\"path/writeable.txt.composite-upload-1-of-3\"},"
+      "{\"name\":\"path/writeable.txt.composite-upload-2-of-3\"}]}\n",
+      compose_body);
+}
+
+TEST(GcsFileSystemTest, NewWritableFile_CompositeUploadBelowThreshold) {
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+           "uploadType=resumable&name=path%2Fwriteable.txt\n"
+           "Auth Token: fake_token\n"
+           "Header X-Upload-Content-Length: 9\n"
+           "Post: yes\n",
+           "", {{"Location", "https://custom/upload/location"}}),
+       new FakeHttpRequest("Uri: https://custom/upload/location\n"
+                           "Auth Token: fake_token\n"
+                           "Header Content-Range: bytes 0-8/9\n"
+                           "Put body: content1,\n",
+                           "")});
+  GcsFileSystem fs(std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+                   std::unique_ptr<HttpRequest::Factory>(
+                       new FakeHttpRequestFactory(&requests)),
+                   0 /* read ahead bytes */, 0 /* initial retry delay */);
+  GcsFileSystem::CompositeUploadOptions options;
+  options.threshold_bytes = 10;
+  fs.set_composite_upload_options(options);
+
+  std::unique_ptr<WritableFile> file;
+  TF_EXPECT_OK(fs.NewWritableFile("gs://bucket/path/writeable.txt", &file));
+  TF_EXPECT_OK(file->Append("content1,"));
+  TF_EXPECT_OK(file->Close());
+}
+
+TEST(GcsFileSystemTest, NewWritableFile_CompositeUploadComponentFails) {
+  // The components are deleted even if one of them cannot be uploaded.
+  std::vector<HttpRequest*> requests(
+      {new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+           "uploadType=media&name=file.txt.composite-upload-0-of-2\n"
+           "Auth Token: fake_token\n"
+           "Post body: ab\n",
+           "", errors::PermissionDenied("403"), 403),
+       new FakeHttpRequest(
+           "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+           "uploadType=media&name=file.txt.composite-upload-1-of-2\n"
+           "Auth Token: fake_token\n"
+           "Post body: c\n",
+           ""),
+       new FakeHttpRequest("Uri: https://www.googleapis.com/storage/v1/b/"
+                           "bucket/o/file.txt.composite-upload-0-of-2\n"
+                           "Auth Token: fake_token\n"
+                           "Delete: yes\n",
+                           "", errors::NotFound("404"), 404),
+       new FakeHttpRequest("Uri: https://www.googleapis.com/storage/v1/b/"
+                           "bucket/o/file.txt.composite-upload-1-of-2\n"
+                           "Auth Token: fake_token\n"
+                           "Delete: yes\n",
+                           "")});
+  // The file is uploaded again when it is closed.
+  string compose_body;
+  requests.push_back(new FakeHttpRequest(
+      "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+      "uploadType=media&name=file.txt.composite-upload-0-of-2\n"
+      "Auth Token: fake_token\n"
+      "Post body: ab\n",
+      ""));
+  requests.push_back(new FakeHttpRequest(
+      "Uri: https://www.googleapis.com/upload/storage/v1/b/bucket/o?"
+      "uploadType=media&name=file.txt.composite-upload-1-of-2\n"
+      "Auth Token: fake_token\n"
+      "Post body: c\n",
+      ""));
+  requests.push_back(new FakeHttpRequest(
+      "Uri: https://www.googleapis.com/storage/v1/b/bucket/o/file.txt/"
+      "compose\n"
+      "Auth Token: fake_token\n"
+      "Header Content-Type: application/json\n",
+      "", &compose_body));
+  for (int i = 0; i < 2; ++i) {
+    requests.push_back(new FakeHttpRequest(
+        strings::StrCat("Uri: https://www.googleapis.com/storage/v1/b/"
+                        "bucket/o/file.txt.composite-upload-",
+                        i, "-of-2\n"
+                        "Auth Token: fake_token\n"
+                        "Delete: yes\n"),
+        ""));
+  }
+  GcsFileSystem fs(std::unique_ptr<AuthProvider>(new FakeAuthProvider),
+                   std::unique_ptr<HttpRequest::Factory>(
+                       new FakeHttpRequestFactory(&requests)),
+                   0 /* read ahead bytes */, 0 /* initial retry delay */);
+  GcsFileSystem::CompositeUploadOptions options;
+  options.threshold_bytes = 1;
+  options.max_components = 2;
+  options.num_threads = 1;
+  fs.set_composite_upload_options(options);
+
+  std::unique_ptr<WritableFile> file;
+  TF_EXPECT_OK(fs.NewWritableFile("gs://bucket/file.txt", &file));
+  TF_EXPECT_OK(file->Append("abc"));
+  EXPECT_EQ(errors::Code::PERMISSION_DENIED, file->Sync().code());
+  TF_EXPECT_OK(file->Close());
+}
+
 TEST(GcsFileSystemTest, NewWritableFile_ResumeUploadSucceeds) {
   std::vector<HttpRequest*> requests(
       {new FakeHttpRequest(
@@ -1626,5 +1876,43 @@ TEST(GcsFileSystemTest, OverrideReadaheadBufferSize) {
   EXPECT_EQ(123456789L, fs2.get_readahead_buffer_size());
 }
 
+TEST(GcsFileSystemTest, OverrideReadCache) {
+  GcsFileSystem fs1;
+  EXPECT_EQ(16 * 1024 * 1024, fs1.block_size());
+  EXPECT_EQ(256 * 1024 * 1024, fs1.max_bytes());
+
+  setenv("GCS_READ_CACHE_BLOCK_SIZE_BYTES", "1234", 1);
+  setenv("GCS_READ_CACHE_MAX_SIZE_BYTES", "123456", 1);
+  GcsFileSystem fs2;
+  EXPECT_EQ(1234, fs2.block_size());
+  EXPECT_EQ(123456, fs2.max_bytes());
+
+  // A block size of 0 disables the cache.
+  setenv("GCS_READ_CACHE_BLOCK_SIZE_BYTES", "0", 1);
+  GcsFileSystem fs3;
+  EXPECT_EQ(0, fs3.block_size());
+  EXPECT_EQ(0, fs3.max_bytes());
+
+  unsetenv("GCS_READ_CACHE_BLOCK_SIZE_BYTES");
+  unsetenv("GCS_READ_CACHE_MAX_SIZE_BYTES");
+}
+
+TEST(GcsFileSystemTest, OverrideCompositeUploadOptions) {
+  GcsFileSystem fs1;
+  EXPECT_EQ(0, fs1.composite_upload_options().threshold_bytes);
+
+  setenv("GCS_COMPOSITE_UPLOAD_THRESHOLD_BYTES", "1000000", 1);
+  setenv("GCS_COMPOSITE_UPLOAD_MAX_COMPONENTS", "16", 1);
+  setenv("GCS_COMPOSITE_UPLOAD_NUM_THREADS", "4", 1);
+  GcsFileSystem fs2;
+  EXPECT_EQ(1000000, fs2.composite_upload_options().threshold_bytes);
+  EXPECT_EQ(16, fs2.composite_upload_options().max_components);
+  EXPECT_EQ(4, fs2.composite_upload_options().num_threads);
+
+  unsetenv("GCS_COMPOSITE_UPLOAD_THRESHOLD_BYTES");
+  unsetenv("GCS_COMPOSITE_UPLOAD_MAX_COMPONENTS");
+  unsetenv("GCS_COMPOSITE_UPLOAD_NUM_THREADS");
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_PLATFORM_CPU_INFO_H_
 
 #include <string>
+#include <vector>
 
 #if defined(PLATFORM_WINDOWS)
 #include "tensorflow/core/platform/windows/cpu_info.h"
@@ -34,6 +35,11 @@ constexpr bool kLittleEndian = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
 // software can change it dynamically.
 int NumSchedulableCPUs();
 
+// Restricts the calling thread to the given CPUs, numbered like in
+// sched_setaffinity(2). Returns false if the platform doesn't support it or
+// none of the CPUs is usable.
+bool SetThreadCPUAffinity(const std::vector<int>& cpus);
+
 // Mostly ISA related features that we care about
 enum CPUFeature {
   // Do not change numeric assignments.
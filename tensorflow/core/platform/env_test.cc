@@ -82,6 +82,47 @@ TEST_F(DefaultEnvTest, IncompleteReadOutOfRange) {
   EXPECT_EQ(input, result);
 }
 
+TEST_F(DefaultEnvTest, ReadBatch) {
+  const string filename = io::JoinPath(BaseDir(), "read_batch");
+  const string input = CreateTestFile(env_, filename, 100);
+  std::unique_ptr<RandomAccessFile> f;
+  TF_EXPECT_OK(env_->NewRandomAccessFile(filename, &f));
+
+  // Adjacent, overlapping, empty and out of range requests, out of order.
+  const std::vector<std::pair<uint64, size_t>> ranges = {
+      {40, 20}, {0, 10}, {10, 30}, {5, 10}, {60, 0}, {90, 20}, {60, 30}};
+  std::vector<string> scratch(ranges.size());
+  std::vector<Status> statuses(ranges.size());
+  std::vector<string> results(ranges.size());
+  std::vector<int> calls(ranges.size(), 0);
+  std::vector<RandomAccessFile::ReadRequest> requests;
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    scratch[i].resize(ranges[i].second);
+    RandomAccessFile::ReadRequest request;
+    request.offset = ranges[i].first;
+    request.n = ranges[i].second;
+    request.scratch = &scratch[i][0];
+    request.done = [i, &statuses, &results, &calls](const Status& s,
+                                                    StringPiece result) {
+      statuses[i] = s;
+      results[i] = result.ToString();
+      ++calls[i];
+    };
+    requests.push_back(request);
+  }
+  f->ReadBatch(requests);
+
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    EXPECT_EQ(1, calls[i]);
+    EXPECT_EQ(input.substr(ranges[i].first, ranges[i].second), results[i]);
+    if (ranges[i].first + ranges[i].second > input.size()) {
+      EXPECT_EQ(error::OUT_OF_RANGE, statuses[i].code());
+    } else {
+      TF_EXPECT_OK(statuses[i]);
+    }
+  }
+}
+
 TEST_F(DefaultEnvTest, ReadFileToString) {
   for (const int length : {0, 1, 1212, 2553, 4928, 8196, 9000, (1 << 20) - 1,
                            1 << 20, (1 << 20) + 1}) {
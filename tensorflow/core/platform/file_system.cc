@@ -72,6 +72,14 @@ Status FileSystem::IsDirectory(const string& name) {
 
 RandomAccessFile::~RandomAccessFile() {}
 
+void RandomAccessFile::ReadBatch(std::vector<ReadRequest> requests) const {
+  for (ReadRequest& request : requests) {
+    StringPiece result;
+    Status s = Read(request.offset, request.n, &result, request.scratch);
+    request.done(s, result);
+  }
+}
+
 WritableFile::~WritableFile() {}
 
 FileSystemRegistry::~FileSystemRegistry() {}
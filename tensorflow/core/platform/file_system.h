@@ -235,6 +235,30 @@ class RandomAccessFile {
   virtual Status Read(uint64 offset, size_t n, StringPiece* result,
                       char* scratch) const = 0;
 
+  /// \brief A single range of a batch passed to `ReadBatch`.
+  struct ReadRequest {
+    uint64 offset = 0;
+    size_t n = 0;
+    /// Must be live until `done` is called, and point to at least `n` bytes.
+    char* scratch = nullptr;
+    /// Called exactly once, with the status and result that
+    /// `Read(offset, n, &result, scratch)` would have produced.
+    std::function<void(const Status&, StringPiece)> done;
+  };
+
+  /// \brief Reads all the ranges in `requests`, and calls the `done`
+  /// callback of each as its read completes.
+  ///
+  /// The callbacks may be called in any order, from any thread, and
+  /// before `ReadBatch` returns. The requests may overlap.
+  ///
+  /// The default implementation calls `Read` for each request in turn.
+  /// Implementations override it when they can serve several ranges with
+  /// fewer round trips.
+  ///
+  /// Safe for concurrent use by multiple threads.
+  virtual void ReadBatch(std::vector<ReadRequest> requests) const;
+
  private:
   TF_DISALLOW_COPY_AND_ASSIGN(RandomAccessFile);
 };
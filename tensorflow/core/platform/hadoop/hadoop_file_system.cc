@@ -17,8 +17,14 @@ limitations under the License.
 
 #include <errno.h>
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/monitoring/sampler.h"
+#include "tensorflow/core/lib/strings/numbers.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/file_system.h"
@@ -29,6 +35,28 @@ limitations under the License.
 
 namespace tensorflow {
 
+namespace {
+
+// The environment variable that overrides the size of the per-file
+// read-ahead buffer. Read-ahead is disabled by default.
+constexpr char kReadaheadBufferSize[] = "HDFS_READAHEAD_BUFFER_SIZE_BYTES";
+// The environment variables that enable hedged reads in the HDFS client: once
+// a read from a datanode takes longer than the threshold, the client issues
+// the same read to another replica and uses whichever answers first.
+constexpr char kHedgedReadThreadpoolSize[] = "HDFS_HEDGED_READ_THREADPOOL_SIZE";
+constexpr char kHedgedReadThresholdMillis[] =
+    "HDFS_HEDGED_READ_THRESHOLD_MILLIS";
+
+auto* hdfs_read_usecs = monitoring::Sampler<1>::New(
+    {"/tensorflow/core/hdfs/read_usecs",
+     "The time taken by the reads from HDFS files that were not served from a "
+     "read-ahead buffer, in microseconds.",
+     "namenode"},
+    {10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000,
+     200000, 500000, 1000000, 2000000, 5000000, 10000000});
+
+}  // namespace
+
 template <typename R, typename... Args>
 Status BindFunc(void* handle, const char* name,
                 std::function<R(Args...)>* func) {
@@ -57,6 +85,8 @@ class LibHDFS {
   std::function<hdfsFS(hdfsBuilder*)> hdfsBuilderConnect;
   std::function<hdfsBuilder*()> hdfsNewBuilder;
   std::function<void(hdfsBuilder*, const char*)> hdfsBuilderSetNameNode;
+  std::function<int(hdfsBuilder*, const char*, const char*)>
+      hdfsBuilderConfSetStr;
   std::function<int(const char*, char**)> hdfsConfGetStr;
   std::function<void(hdfsBuilder*, const char* kerbTicketCachePath)>
       hdfsBuilderSetKerbTicketCachePath;
@@ -85,6 +115,7 @@ class LibHDFS {
       BIND_HDFS_FUNC(hdfsBuilderConnect);
       BIND_HDFS_FUNC(hdfsNewBuilder);
       BIND_HDFS_FUNC(hdfsBuilderSetNameNode);
+      BIND_HDFS_FUNC(hdfsBuilderConfSetStr);
       BIND_HDFS_FUNC(hdfsConfGetStr);
       BIND_HDFS_FUNC(hdfsBuilderSetKerbTicketCachePath);
       BIND_HDFS_FUNC(hdfsCloseFile);
@@ -130,7 +161,22 @@ class LibHDFS {
   void* handle_ = nullptr;
 };
 
-HadoopFileSystem::HadoopFileSystem() : hdfs_(LibHDFS::Load()) {}
+HadoopFileSystem::HadoopFileSystem() : hdfs_(LibHDFS::Load()) {
+  const char* readahead_buffer_size = std::getenv(kReadaheadBufferSize);
+  uint64 value;
+  if (readahead_buffer_size &&
+      strings::safe_strtou64(readahead_buffer_size, &value)) {
+    read_ahead_bytes_ = value;
+  }
+  const char* threadpool_size = std::getenv(kHedgedReadThreadpoolSize);
+  if (threadpool_size) {
+    hedged_read_threadpool_size_ = threadpool_size;
+  }
+  const char* threshold_millis = std::getenv(kHedgedReadThresholdMillis);
+  if (threshold_millis) {
+    hedged_read_threshold_millis_ = threshold_millis;
+  }
+}
 
 HadoopFileSystem::~HadoopFileSystem() {}
 
@@ -164,6 +210,18 @@ Status HadoopFileSystem::Connect(StringPiece fname, hdfsFS* fs) {
   } else {
     hdfs_->hdfsBuilderSetNameNode(builder, nn.c_str());
   }
+  // hdfsBuilderConfSetStr() only keeps pointers to the values, which must
+  // outlive the builder. The members do.
+  if (!hedged_read_threadpool_size_.empty()) {
+    hdfs_->hdfsBuilderConfSetStr(builder,
+                                 "dfs.client.hedged.read.threadpool.size",
+                                 hedged_read_threadpool_size_.c_str());
+  }
+  if (!hedged_read_threshold_millis_.empty()) {
+    hdfs_->hdfsBuilderConfSetStr(builder,
+                                 "dfs.client.hedged.read.threshold.millis",
+                                 hedged_read_threshold_millis_.c_str());
+  }
   char* ticket_cache_path = getenv("KERB_TICKET_CACHE_PATH");
   if (ticket_cache_path != nullptr) {
     hdfs_->hdfsBuilderSetKerbTicketCachePath(builder, ticket_cache_path);
@@ -184,12 +242,18 @@ string HadoopFileSystem::TranslateName(const string& name) const {
 class HDFSRandomAccessFile : public RandomAccessFile {
  public:
   HDFSRandomAccessFile(const string& filename, const string& hdfs_filename,
-                       LibHDFS* hdfs, hdfsFS fs, hdfsFile file)
+                       LibHDFS* hdfs, hdfsFS fs, hdfsFile file,
+                       size_t read_ahead_bytes)
       : filename_(filename),
         hdfs_filename_(hdfs_filename),
         hdfs_(hdfs),
         fs_(fs),
-        file_(file) {}
+        read_ahead_bytes_(read_ahead_bytes),
+        file_(file) {
+    StringPiece scheme, namenode, path;
+    io::ParseURI(filename, &scheme, &namenode, &path);
+    read_usecs_ = hdfs_read_usecs->GetCell(namenode.ToString());
+  }
 
   ~HDFSRandomAccessFile() override {
     if (file_ != nullptr) {
@@ -198,8 +262,50 @@ class HDFSRandomAccessFile : public RandomAccessFile {
     }
   }
 
+  // Serves the reads from a read-ahead buffer of the following bytes of the
+  // file, if read-ahead is enabled. Reads are then serialized, so this suits
+  // files read sequentially by one reader at a time.
   Status Read(uint64 offset, size_t n, StringPiece* result,
               char* scratch) const override {
+    if (read_ahead_bytes_ == 0) {
+      return ReadFromHDFS(offset, n, result, scratch);
+    }
+
+    mutex_lock lock(buffer_mu_);
+    if (offset >= buffer_start_offset_ &&
+        offset + n <= buffer_start_offset_ + buffer_.size()) {
+      // The requested range can be filled from the buffer.
+      std::memcpy(scratch, buffer_.data() + (offset - buffer_start_offset_),
+                  n);
+      *result = StringPiece(scratch, n);
+      return Status::OK();
+    }
+
+    // Refill the buffer starting at the requested range. The buffer is
+    // emptied if reading fails, so that it stays consistent.
+    buffer_start_offset_ = offset;
+    buffer_.resize(n + read_ahead_bytes_);
+    StringPiece data;
+    Status s = ReadFromHDFS(offset, buffer_.size(), &data, buffer_.data());
+    if (!s.ok() && !errors::IsOutOfRange(s)) {
+      buffer_.clear();
+      return s;
+    }
+    buffer_.resize(data.size());
+
+    const size_t copy_size = std::min(n, buffer_.size());
+    std::memcpy(scratch, buffer_.data(), copy_size);
+    *result = StringPiece(scratch, copy_size);
+    if (copy_size < n) {
+      return Status(error::OUT_OF_RANGE, "Read less bytes than requested");
+    }
+    return Status::OK();
+  }
+
+ private:
+  Status ReadFromHDFS(uint64 offset, size_t n, StringPiece* result,
+                      char* scratch) const {
+    const uint64 start_usecs = Env::Default()->NowMicros();
     Status s;
     char* dst = scratch;
     bool eof_retried = false;
@@ -238,17 +344,26 @@ class HDFSRandomAccessFile : public RandomAccessFile {
       }
     }
     *result = StringPiece(scratch, dst - scratch);
+    read_usecs_->Add(Env::Default()->NowMicros() - start_usecs);
     return s;
   }
 
- private:
   string filename_;
   string hdfs_filename_;
   LibHDFS* hdfs_;
   hdfsFS fs_;
+  const size_t read_ahead_bytes_;
+  monitoring::SamplerCell* read_usecs_;
 
   mutable mutex mu_;
   mutable hdfsFile file_ GUARDED_BY(mu_);
+
+  // The buffer-related members need to be mutable, because they are modified
+  // by the const Read() method.
+  mutable mutex buffer_mu_;
+  mutable std::vector<char> buffer_ GUARDED_BY(buffer_mu_);
+  // The file offset of the first buffered byte.
+  mutable uint64 buffer_start_offset_ GUARDED_BY(buffer_mu_) = 0;
 };
 
 Status HadoopFileSystem::NewRandomAccessFile(
@@ -261,8 +376,8 @@ Status HadoopFileSystem::NewRandomAccessFile(
   if (file == nullptr) {
     return IOError(fname, errno);
   }
-  result->reset(
-      new HDFSRandomAccessFile(fname, TranslateName(fname), hdfs_, fs, file));
+  result->reset(new HDFSRandomAccessFile(fname, TranslateName(fname), hdfs_, fs,
+                                         file, read_ahead_bytes_));
   return Status::OK();
 }
 
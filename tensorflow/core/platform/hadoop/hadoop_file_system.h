@@ -66,6 +66,13 @@ class HadoopFileSystem : public FileSystem {
  private:
   Status Connect(StringPiece fname, hdfsFS* fs);
   LibHDFS* hdfs_;
+
+  // The size of the read-ahead buffer of each random access file, or 0 to
+  // read from HDFS on every Read().
+  size_t read_ahead_bytes_ = 0;
+  // The HDFS client configuration of hedged reads, if set.
+  string hedged_read_threadpool_size_;
+  string hedged_read_threshold_millis_;
 };
 
 }  // namespace tensorflow
@@ -89,6 +89,35 @@ TEST_F(HadoopFileSystemTest, RandomAccessFile) {
   EXPECT_EQ(content.substr(2, 4), result);
 }
 
+TEST_F(HadoopFileSystemTest, RandomAccessFileWithReadAhead) {
+  const string fname = TmpDir("RandomAccessFileWithReadAhead");
+  const string content = "abcdefghijklmn";
+  TF_ASSERT_OK(WriteString(fname, content));
+
+  setenv("HDFS_READAHEAD_BUFFER_SIZE_BYTES", "5", 1);
+  HadoopFileSystem read_ahead_hdfs;
+  unsetenv("HDFS_READAHEAD_BUFFER_SIZE_BYTES");
+  std::unique_ptr<RandomAccessFile> reader;
+  TF_EXPECT_OK(read_ahead_hdfs.NewRandomAccessFile(fname, &reader));
+
+  string got;
+  got.resize(4);
+  StringPiece result;
+  // Fills the buffer with "abcdefghi".
+  TF_EXPECT_OK(reader->Read(0, 4, &result, gtl::string_as_array(&got)));
+  EXPECT_EQ(content.substr(0, 4), result);
+  // Served from the buffer.
+  TF_EXPECT_OK(reader->Read(4, 4, &result, gtl::string_as_array(&got)));
+  EXPECT_EQ(content.substr(4, 4), result);
+  // Refills the buffer with "ijklmn".
+  TF_EXPECT_OK(reader->Read(8, 4, &result, gtl::string_as_array(&got)));
+  EXPECT_EQ(content.substr(8, 4), result);
+  // Reads past EOF.
+  EXPECT_EQ(error::OUT_OF_RANGE,
+            reader->Read(12, 4, &result, gtl::string_as_array(&got)).code());
+  EXPECT_EQ(content.substr(12), result);
+}
+
 TEST_F(HadoopFileSystemTest, WritableFile) {
   std::unique_ptr<WritableFile> writer;
   const string fname = TmpDir("WritableFile");
@@ -0,0 +1,58 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_PLATFORM_NUMA_H_
+#define TENSORFLOW_PLATFORM_NUMA_H_
+
+#include "tensorflow/core/platform/platform.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace port {
+
+// The node of a thread or allocation that isn't bound to any NUMA node.
+constexpr int kNUMANoAffinity = -1;
+
+// Returns true iff the host has more than one NUMA node and this platform
+// can bind threads and memory to them. If false, the other functions behave
+// as if there were a single node 0 holding all the schedulable CPUs.
+bool NUMAEnabled();
+
+// Returns the number of NUMA nodes with CPUs this process may be scheduled
+// on, at least 1. The nodes are numbered from 0.
+int NUMANumNodes();
+
+// Returns the number of CPUs of the given node that this process may be
+// scheduled on.
+int NUMANumSchedulableCPUs(int node);
+
+// Restricts the calling thread to the schedulable CPUs of the given node, or
+// lifts the restriction if node is kNUMANoAffinity.
+void NUMASetThreadNodeAffinity(int node);
+
+// Returns the node the calling thread is restricted to, or kNUMANoAffinity.
+int NUMAGetThreadNodeAffinity();
+
+// Allocates size bytes whose pages are placed in the memory of the given
+// node, and that are aligned to minimum_alignment, a power of 2. Returns
+// nullptr on failure. The memory must be freed with NUMAFree() and the same
+// size.
+void* NUMAMalloc(int node, size_t size, int minimum_alignment);
+void NUMAFree(void* ptr, size_t size);
+
+}  // namespace port
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_PLATFORM_NUMA_H_
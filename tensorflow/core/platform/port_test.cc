@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/test.h"
 
 namespace tensorflow {
@@ -33,6 +34,38 @@ TEST(Port, AlignedMalloc) {
   }
 }
 
+TEST(Port, SetThreadCPUAffinity) {
+  EXPECT_FALSE(SetThreadCPUAffinity({}));
+  EXPECT_FALSE(SetThreadCPUAffinity({-1}));
+}
+
+TEST(Port, NUMAMalloc) {
+  for (int node = kNUMANoAffinity; node < NUMANumNodes(); ++node) {
+    for (size_t alignment = 1; alignment <= 1 << 20; alignment <<= 1) {
+      void* p = NUMAMalloc(node, 1000, alignment);
+      ASSERT_TRUE(p != nullptr) << "NUMAMalloc(" << node << ", 1000, "
+                                << alignment << ")";
+      uintptr_t pval = reinterpret_cast<uintptr_t>(p);
+      EXPECT_EQ(pval % alignment, 0);
+      memset(p, 0, 1000);
+      NUMAFree(p, 1000);
+    }
+  }
+}
+
+TEST(Port, NUMAThreadNodeAffinity) {
+  thread::ThreadPool pool(Env::Default(), "test", 1);
+  for (int node = 0; node < NUMANumNodes(); ++node) {
+    EXPECT_GT(NUMANumSchedulableCPUs(node), 0);
+    pool.Schedule([node]() {
+      NUMASetThreadNodeAffinity(node);
+      EXPECT_EQ(NUMAGetThreadNodeAffinity(),
+                NUMAEnabled() ? node : kNUMANoAffinity);
+      NUMASetThreadNodeAffinity(kNUMANoAffinity);
+    });
+  }
+}
+
 TEST(ConditionVariable, WaitForMilliseconds_Timeout) {
   mutex m;
   mutex_lock l(m);
@@ -29,9 +29,11 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/lib/core/error_codes.pb.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/load_library.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/posix/posix_file_system.h"
 
 namespace tensorflow {
@@ -40,10 +42,20 @@ namespace {
 
 class StdThread : public Thread {
  public:
-  // name and thread_options are both ignored.
+  // The stack and guard sizes in thread_options are ignored.
   StdThread(const ThreadOptions& thread_options, const string& name,
             std::function<void()> fn)
-      : thread_(fn) {}
+      : thread_([thread_options, name, fn]() {
+          if (!thread_options.cpu_affinity.empty()) {
+            if (!port::SetThreadCPUAffinity(thread_options.cpu_affinity)) {
+              LOG(WARNING) << "Could not set the CPU affinity of thread "
+                           << name;
+            }
+          } else if (thread_options.numa_node != port::kNUMANoAffinity) {
+            port::NUMASetThreadNodeAffinity(thread_options.numa_node);
+          }
+          fn();
+        }) {}
   ~StdThread() override { thread_.join(); }
 
  private:
@@ -20,15 +20,21 @@ limitations under the License.
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/numa.h"
 #include "tensorflow/core/platform/snappy.h"
 #include "tensorflow/core/platform/types.h"
 #if defined(__linux__) && !defined(__ANDROID__)
 #include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #endif
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <algorithm>
+#include <vector>
 #ifdef SNAPPY
 #include "snappy.h"
 #endif
@@ -66,6 +72,199 @@ int NumSchedulableCPUs() {
   return kDefaultCores;
 }
 
+bool SetThreadCPUAffinity(const std::vector<int>& cpus) {
+#if defined(__linux__) && !defined(__ANDROID__)
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  for (int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &cpuset);
+  }
+  return CPU_COUNT(&cpuset) > 0 &&
+         sched_setaffinity(0, sizeof(cpu_set_t), &cpuset) == 0;
+#else
+  return false;
+#endif
+}
+
+#if defined(__linux__) && !defined(__ANDROID__) && defined(SYS_mbind)
+namespace {
+
+// The NUMA nodes with CPUs this process may be scheduled on, read once from
+// sysfs.
+struct NUMATopology {
+  // The kernel's number of each node.
+  std::vector<int> node_ids;
+  // The schedulable CPUs of each node.
+  std::vector<cpu_set_t> node_cpus;
+  // The CPUs the process could be scheduled on at startup.
+  cpu_set_t process_cpus;
+};
+
+// Parses a sysfs list like "0-3,8,10-11" into *ids.
+void ParseSysfsList(const char* list, std::vector<int>* ids) {
+  const char* p = list;
+  while (*p != '\0' && *p != '\n') {
+    char* end;
+    const long first = strtol(p, &end, 10);
+    if (end == p) return;
+    long last = first;
+    p = end;
+    if (*p == '-') {
+      last = strtol(p + 1, &end, 10);
+      p = end;
+    }
+    for (long id = first; id <= last; ++id) ids->push_back(id);
+    if (*p == ',') ++p;
+  }
+}
+
+bool ReadSysfsList(const char* path, std::vector<int>* ids) {
+  FILE* f = fopen(path, "r");
+  if (f == nullptr) return false;
+  char list[4096];
+  const bool ok = fgets(list, sizeof(list), f) != nullptr;
+  fclose(f);
+  if (ok) ParseSysfsList(list, ids);
+  return ok;
+}
+
+const NUMATopology& GetNUMATopology() {
+  static const NUMATopology* topology = [] {
+    NUMATopology* t = new NUMATopology;
+    CPU_ZERO(&t->process_cpus);
+    if (sched_getaffinity(0, sizeof(cpu_set_t), &t->process_cpus) != 0) {
+      return t;
+    }
+    std::vector<int> online;
+    ReadSysfsList("/sys/devices/system/node/online", &online);
+    for (int id : online) {
+      char path[64];
+      snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+               id);
+      std::vector<int> cpus;
+      if (!ReadSysfsList(path, &cpus)) continue;
+      cpu_set_t node_cpus;
+      CPU_ZERO(&node_cpus);
+      for (int cpu : cpus) {
+        if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &t->process_cpus)) {
+          CPU_SET(cpu, &node_cpus);
+        }
+      }
+      if (CPU_COUNT(&node_cpus) == 0) continue;
+      t->node_ids.push_back(id);
+      t->node_cpus.push_back(node_cpus);
+    }
+    return t;
+  }();
+  return *topology;
+}
+
+// Allocations are whole pages, which mbind places on a node.
+size_t NUMAAllocationSize(size_t size) {
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  return std::max<size_t>(1, (size + page_size - 1) / page_size) * page_size;
+}
+
+}  // namespace
+
+bool NUMAEnabled() { return GetNUMATopology().node_ids.size() > 1; }
+
+int NUMANumNodes() {
+  return NUMAEnabled() ? GetNUMATopology().node_ids.size() : 1;
+}
+
+int NUMANumSchedulableCPUs(int node) {
+  if (!NUMAEnabled()) return NumSchedulableCPUs();
+  return CPU_COUNT(&GetNUMATopology().node_cpus[node]);
+}
+
+void NUMASetThreadNodeAffinity(int node) {
+  if (!NUMAEnabled()) return;
+  const NUMATopology& topology = GetNUMATopology();
+  const cpu_set_t& cpus = node == kNUMANoAffinity ? topology.process_cpus
+                                                  : topology.node_cpus[node];
+  if (sched_setaffinity(0, sizeof(cpu_set_t), &cpus) != 0) {
+    LOG(WARNING) << "Could not bind thread to NUMA node " << node << ": "
+                 << strerror(errno);
+  }
+}
+
+int NUMAGetThreadNodeAffinity() {
+  if (!NUMAEnabled()) return kNUMANoAffinity;
+  cpu_set_t cpus;
+  if (sched_getaffinity(0, sizeof(cpu_set_t), &cpus) != 0) {
+    return kNUMANoAffinity;
+  }
+  const NUMATopology& topology = GetNUMATopology();
+  for (int node = 0; node < topology.node_cpus.size(); ++node) {
+    cpu_set_t on_node;
+    CPU_AND(&on_node, &cpus, &topology.node_cpus[node]);
+    if (CPU_EQUAL(&on_node, &cpus)) return node;
+  }
+  return kNUMANoAffinity;
+}
+
+void* NUMAMalloc(int node, size_t size, int minimum_alignment) {
+  if (!NUMAEnabled()) return AlignedMalloc(size, minimum_alignment);
+  // Maps enough pages to align the allocation, then unmaps the rest.
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  const size_t alignment = std::max<size_t>(page_size, minimum_alignment);
+  const size_t length = NUMAAllocationSize(size);
+  const size_t mapped_length = length + alignment - page_size;
+  void* mapped = mmap(nullptr, mapped_length, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapped == MAP_FAILED) return nullptr;
+  const uintptr_t mapped_start = reinterpret_cast<uintptr_t>(mapped);
+  const uintptr_t start = (mapped_start + alignment - 1) & ~(alignment - 1);
+  if (start > mapped_start) {
+    munmap(mapped, start - mapped_start);
+  }
+  const uintptr_t mapped_end = mapped_start + mapped_length;
+  if (mapped_end > start + length) {
+    munmap(reinterpret_cast<void*>(start + length),
+           mapped_end - (start + length));
+  }
+
+  // The pages are not touched yet, so binding them places all of them.
+  if (node == kNUMANoAffinity) return reinterpret_cast<void*>(start);
+  const int id = GetNUMATopology().node_ids[node];
+  const int bits_per_word = 8 * sizeof(unsigned long);
+  std::vector<unsigned long> node_mask(id / bits_per_word + 1);
+  node_mask[id / bits_per_word] |= 1UL << (id % bits_per_word);
+  constexpr int kMPolBind = 2;  // MPOL_BIND from <numaif.h>.
+  if (syscall(SYS_mbind, start, length, kMPolBind, node_mask.data(),
+              node_mask.size() * bits_per_word + 1, 0) != 0) {
+    VLOG(1) << "Could not bind memory to NUMA node " << node << ": "
+            << strerror(errno);
+  }
+  return reinterpret_cast<void*>(start);
+}
+
+void NUMAFree(void* ptr, size_t size) {
+  if (!NUMAEnabled()) {
+    AlignedFree(ptr);
+    return;
+  }
+  munmap(ptr, NUMAAllocationSize(size));
+}
+#else
+bool NUMAEnabled() { return false; }
+
+int NUMANumNodes() { return 1; }
+
+int NUMANumSchedulableCPUs(int node) { return NumSchedulableCPUs(); }
+
+void NUMASetThreadNodeAffinity(int node) {}
+
+int NUMAGetThreadNodeAffinity() { return kNUMANoAffinity; }
+
+void* NUMAMalloc(int node, size_t size, int minimum_alignment) {
+  return AlignedMalloc(size, minimum_alignment);
+}
+
+void NUMAFree(void* ptr, size_t size) { AlignedFree(ptr); }
+#endif
+
 void* AlignedMalloc(size_t size, int minimum_alignment) {
 #if defined(__ANDROID__)
   return memalign(minimum_alignment, size);
@@ -16,14 +16,18 @@ limitations under the License.
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <stdio.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 #include "tensorflow/core/lib/core/error_codes.pb.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -66,6 +70,50 @@ class PosixRandomAccessFile : public RandomAccessFile {
     *result = StringPiece(scratch, dst - scratch);
     return s;
   }
+
+#if defined(__linux__) && !defined(__ANDROID__)
+  // Serves each run of adjacent requests with a single preadv() call.
+  // Requests that the call does not complete in full are retried with Read().
+  void ReadBatch(std::vector<ReadRequest> requests) const override {
+    std::sort(requests.begin(), requests.end(),
+              [](const ReadRequest& a, const ReadRequest& b) {
+                return a.offset < b.offset;
+              });
+    std::vector<struct iovec> iov;
+    size_t begin = 0;
+    while (begin < requests.size()) {
+      size_t end = begin + 1;
+      while (end < requests.size() &&
+             end - begin < static_cast<size_t>(IOV_MAX) &&
+             requests[end].offset ==
+                 requests[end - 1].offset + requests[end - 1].n) {
+        ++end;
+      }
+      iov.resize(end - begin);
+      for (size_t i = begin; i < end; ++i) {
+        iov[i - begin].iov_base = requests[i].scratch;
+        iov[i - begin].iov_len = requests[i].n;
+      }
+      ssize_t r = preadv(fd_, iov.data(), iov.size(),
+                         static_cast<off_t>(requests[begin].offset));
+      size_t remaining = r > 0 ? r : 0;
+      for (size_t i = begin; i < end; ++i) {
+        ReadRequest& request = requests[i];
+        StringPiece result;
+        Status s;
+        if (remaining >= request.n) {
+          result = StringPiece(request.scratch, request.n);
+          remaining -= request.n;
+        } else {
+          remaining = 0;
+          s = Read(request.offset, request.n, &result, request.scratch);
+        }
+        request.done(s, result);
+      }
+      begin = end;
+    }
+  }
+#endif
 };
 
 class PosixWritableFile : public WritableFile {
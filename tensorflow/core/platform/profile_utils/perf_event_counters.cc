@@ -0,0 +1,124 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/profile_utils/perf_event_counters.h"
+
+#include <memory>
+
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#include "tensorflow/core/platform/logging.h"
+
+namespace tensorflow {
+namespace profile_utils {
+
+#if defined(__linux__) && !defined(__ANDROID__)
+namespace {
+
+// Opens the hardware event "config" of the calling thread, in the group led
+// by "group_fd", or as the disabled leader of a new group if it is -1.
+int OpenEvent(uint64 config, int group_fd) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = config;
+  attr.disabled = group_fd == -1 ? 1 : 0;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+  return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0 /* pid */,
+                                  -1 /* cpu */, group_fd, 0 /* flags */));
+}
+
+}  // namespace
+
+PerfEventCounters::~PerfEventCounters() {
+  for (int fd : fds_) {
+    if (fd >= 0) close(fd);
+  }
+}
+
+/* static */ PerfEventCounters* PerfEventCounters::Open() {
+  static const uint64 kEvents[kNumEvents] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_REFERENCES, PERF_COUNT_HW_CACHE_MISSES};
+  std::unique_ptr<PerfEventCounters> counters(new PerfEventCounters);
+  for (int i = 0; i < kNumEvents; ++i) {
+    counters->fds_[i] = OpenEvent(kEvents[i], i == 0 ? -1 : counters->fds_[0]);
+    if (counters->fds_[i] < 0) {
+      static bool logged = false;
+      if (!logged) {
+        logged = true;
+        LOG(WARNING) << "Hardware performance counters are unavailable: "
+                     << strerror(errno) << ". See "
+                     << "/proc/sys/kernel/perf_event_paranoid.";
+      }
+      return nullptr;
+    }
+  }
+  if (ioctl(counters->fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) <
+      0) {
+    return nullptr;
+  }
+  return counters.release();
+}
+
+bool PerfEventCounters::Read(Counts* counts) const {
+  // The layout of PERF_FORMAT_GROUP reads.
+  struct {
+    uint64 nr;
+    uint64 values[kNumEvents];
+  } data;
+  if (read(fds_[0], &data, sizeof(data)) != sizeof(data) ||
+      data.nr != kNumEvents) {
+    return false;
+  }
+  counts->cpu_cycles = data.values[0];
+  counts->instructions = data.values[1];
+  counts->cache_references = data.values[2];
+  counts->cache_misses = data.values[3];
+  return true;
+}
+
+#else
+
+PerfEventCounters::~PerfEventCounters() {}
+
+/* static */ PerfEventCounters* PerfEventCounters::Open() { return nullptr; }
+
+bool PerfEventCounters::Read(Counts* counts) const { return false; }
+
+#endif
+
+/* static */ PerfEventCounters* PerfEventCounters::ForCurrentThread() {
+  thread_local bool opened = false;
+  thread_local std::unique_ptr<PerfEventCounters> counters;
+  if (!opened) {
+    opened = true;
+    counters.reset(Open());
+  }
+  return counters.get();
+}
+
+}  // namespace profile_utils
+}  // namespace tensorflow
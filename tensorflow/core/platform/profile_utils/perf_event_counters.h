@@ -0,0 +1,75 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// Hardware performance counters of the calling thread, read through the
+// Linux perf_event interface.
+
+#ifndef TENSORFLOW_PLATFORM_PROFILEUTILS_PERF_EVENT_COUNTERS_H__
+#define TENSORFLOW_PLATFORM_PROFILEUTILS_PERF_EVENT_COUNTERS_H__
+
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+namespace profile_utils {
+
+// Counts the CPU cycles, instructions, and last level cache references and
+// misses of one thread, in user mode. The counters are read together, so
+// that ratios of their differences (e.g. instructions per cycle) are
+// consistent.
+//
+// The counters are unavailable on other platforms than Linux, and when the
+// kernel doesn't permit unprivileged processes to use them (see
+// /proc/sys/kernel/perf_event_paranoid).
+class PerfEventCounters {
+ public:
+  struct Counts {
+    int64 cpu_cycles = 0;
+    int64 instructions = 0;
+    int64 cache_references = 0;
+    int64 cache_misses = 0;
+  };
+
+  ~PerfEventCounters();
+
+  // Returns the counters of the calling thread, opened on the first call on
+  // the thread, or nullptr if they are unavailable. The counters are owned by
+  // the thread and closed when it exits.
+  static PerfEventCounters* ForCurrentThread();
+
+  // Sets "*counts" to the counts since the counters were opened. Must be
+  // called on the thread that owns the counters. Returns false if they
+  // can't be read.
+  bool Read(Counts* counts) const;
+
+ private:
+  enum { kNumEvents = 4 };
+
+  PerfEventCounters() {}
+
+  // Opens the counters of the calling thread, or returns nullptr.
+  static PerfEventCounters* Open();
+
+  // The file descriptors of the events, the first one leading the group.
+  int fds_[kNumEvents] = {-1, -1, -1, -1};
+
+  TF_DISALLOW_COPY_AND_ASSIGN(PerfEventCounters);
+};
+
+}  // namespace profile_utils
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_PLATFORM_PROFILEUTILS_PERF_EVENT_COUNTERS_H__
@@ -0,0 +1,49 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/platform/profile_utils/perf_event_counters.h"
+
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace profile_utils {
+namespace {
+
+TEST(PerfEventCountersTest, CountsIncrease) {
+  PerfEventCounters* counters = PerfEventCounters::ForCurrentThread();
+  if (counters == nullptr) {
+    LOG(INFO) << "Hardware performance counters are unavailable, skipping.";
+    return;
+  }
+  EXPECT_EQ(counters, PerfEventCounters::ForCurrentThread());
+
+  PerfEventCounters::Counts start;
+  ASSERT_TRUE(counters->Read(&start));
+  volatile int64 sum = 0;
+  for (int i = 0; i < 1000000; ++i) {
+    sum += i;
+  }
+  PerfEventCounters::Counts end;
+  ASSERT_TRUE(counters->Read(&end));
+  EXPECT_GT(end.instructions, start.instructions + 1000000);
+  EXPECT_GT(end.cpu_cycles, start.cpu_cycles);
+  EXPECT_GE(end.cache_references, start.cache_references);
+  EXPECT_GE(end.cache_misses, start.cache_misses);
+}
+
+}  // namespace
+}  // namespace profile_utils
+}  // namespace tensorflow
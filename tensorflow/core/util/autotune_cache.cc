@@ -0,0 +1,221 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/autotune_cache.h"
+
+#include <stdlib.h>
+#include <iterator>
+
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/random/random.h"
+#include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+
+namespace {
+
+const char kHeader[] = "# TensorFlow autotune cache, version 1";
+
+}  // namespace
+
+AutotuneCache::AutotuneCache(Env* env, const string& filename,
+                             int64 max_entries, bool validate)
+    : env_(env),
+      filename_(filename),
+      max_entries_(max_entries),
+      validate_(validate) {}
+
+AutotuneCache* AutotuneCache::Global() {
+  static AutotuneCache* instance = []() -> AutotuneCache* {
+    const char* filename = getenv("TF_AUTOTUNE_CACHE_FILE");
+    if (filename == nullptr || filename[0] == '\0') {
+      return nullptr;
+    }
+    int64 max_entries;
+    Status status = ReadInt64FromEnvVar("TF_AUTOTUNE_CACHE_MAX_ENTRIES",
+                                        10000, &max_entries);
+    if (!status.ok()) {
+      LOG(ERROR) << status.error_message();
+    }
+    bool validate;
+    status = ReadBoolFromEnvVar("TF_AUTOTUNE_CACHE_VALIDATE", false, &validate);
+    if (!status.ok()) {
+      LOG(ERROR) << status.error_message();
+    }
+    Env* env = Env::Default();
+    string path = filename;
+    if (env->IsDirectory(path).ok()) {
+      path = io::JoinPath(path, "autotune_cache");
+    }
+    AutotuneCache* cache = new AutotuneCache(env, path, max_entries, validate);
+    status = cache->Load();
+    if (!status.ok()) {
+      LOG(WARNING) << "Ignoring the autotune cache " << path << ": "
+                   << status.error_message();
+    } else {
+      VLOG(1) << "Loaded " << cache->size() << " entries from the autotune "
+              << "cache " << path;
+    }
+    return cache;
+  }();
+  return instance;
+}
+
+Status AutotuneCache::Parse(const string& contents, EntryList* entries) {
+  for (StringPiece line : str_util::Split(contents, '\n')) {
+    if (line.empty() || line.starts_with("#")) {
+      continue;
+    }
+    std::vector<string> fields = str_util::Split(line, '\t');
+    if (fields.size() != 2 || fields[0].empty()) {
+      return errors::DataLoss("Malformed autotune cache entry: ", line);
+    }
+    entries->emplace_back(fields[0], fields[1]);
+  }
+  return Status::OK();
+}
+
+Status AutotuneCache::Load() {
+  if (!env_->FileExists(filename_).ok()) {
+    return Status::OK();
+  }
+  string contents;
+  TF_RETURN_IF_ERROR(ReadFileToString(env_, filename_, &contents));
+  EntryList entries;
+  TF_RETURN_IF_ERROR(Parse(contents, &entries));
+  mutex_lock l(mu_);
+  for (const auto& entry : entries) {
+    InsertLocked(entry.first, entry.second);
+  }
+  TrimLocked();
+  return Status::OK();
+}
+
+bool AutotuneCache::Lookup(const string& key, string* value) const {
+  mutex_lock l(mu_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return false;
+  }
+  *value = it->second->second;
+  return true;
+}
+
+Status AutotuneCache::Insert(const string& key, const string& value) {
+  if (key.empty() || key.find_first_of("\t\n") != string::npos ||
+      value.find_first_of("\t\n") != string::npos) {
+    return errors::InvalidArgument("Invalid autotune cache entry: ", key);
+  }
+  {
+    mutex_lock l(mu_);
+    InsertLocked(key, value);
+    inserted_[key] = value;
+    TrimLocked();
+  }
+  return Save();
+}
+
+Status AutotuneCache::Save() {
+  EntryList file_entries;
+  if (env_->FileExists(filename_).ok()) {
+    string contents;
+    Status status = ReadFileToString(env_, filename_, &contents);
+    if (status.ok()) {
+      status = Parse(contents, &file_entries);
+    }
+    if (!status.ok()) {
+      LOG(WARNING) << "Overwriting the autotune cache " << filename_ << ": "
+                   << status.error_message();
+      file_entries.clear();
+    }
+  }
+
+  mutex_lock l(mu_);
+  // The entries loaded earlier are the oldest, then come the ones of the file,
+  // which other processes may have updated, and then the ones this process
+  // measured.
+  EntryList previous;
+  previous.swap(entries_);
+  index_.clear();
+  for (const auto& entry : previous) {
+    if (inserted_.count(entry.first) == 0) {
+      InsertLocked(entry.first, entry.second);
+    }
+  }
+  for (const auto& entry : file_entries) {
+    if (inserted_.count(entry.first) == 0) {
+      InsertLocked(entry.first, entry.second);
+    }
+  }
+  for (const auto& entry : previous) {
+    if (inserted_.count(entry.first) != 0) {
+      InsertLocked(entry.first, entry.second);
+    }
+  }
+  TrimLocked();
+
+  string contents = strings::StrCat(kHeader, "\n");
+  for (const auto& entry : entries_) {
+    strings::StrAppend(&contents, entry.first, "\t", entry.second, "\n");
+  }
+  // Write to a file of our own and rename it, so that readers never see a
+  // partially written cache.
+  const string tmp_filename =
+      strings::StrCat(filename_, ".tmp", strings::Hex(random::New64()));
+  TF_RETURN_IF_ERROR(WriteStringToFile(env_, tmp_filename, contents));
+  Status status = env_->RenameFile(tmp_filename, filename_);
+  if (!status.ok()) {
+    env_->DeleteFile(tmp_filename).IgnoreError();
+  }
+  return status;
+}
+
+int64 AutotuneCache::size() const {
+  mutex_lock l(mu_);
+  return entries_.size();
+}
+
+void AutotuneCache::RegisterDevice(int device_id, const string& description) {
+  mutex_lock l(mu_);
+  devices_[device_id] = description;
+}
+
+string AutotuneCache::DeviceDescription(int device_id) const {
+  mutex_lock l(mu_);
+  auto it = devices_.find(device_id);
+  return it == devices_.end() ? string() : it->second;
+}
+
+void AutotuneCache::InsertLocked(const string& key, const string& value) {
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    entries_.erase(it->second);
+  }
+  entries_.emplace_back(key, value);
+  index_[key] = std::prev(entries_.end());
+}
+
+void AutotuneCache::TrimLocked() {
+  while (static_cast<int64>(entries_.size()) > max_entries_) {
+    index_.erase(entries_.front().first);
+    entries_.pop_front();
+  }
+}
+
+}  // namespace tensorflow
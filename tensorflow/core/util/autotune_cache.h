@@ -0,0 +1,126 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Autotuning results kept in a file, so that new processes can reuse the
+// choices that earlier ones measured instead of autotuning again.
+
+#ifndef TENSORFLOW_UTIL_AUTOTUNE_CACHE_H_
+#define TENSORFLOW_UTIL_AUTOTUNE_CACHE_H_
+
+#include <list>
+#include <unordered_map>
+
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// A map from strings to strings that is backed by a file shared between
+// processes. Keys must identify everything the result depends on, e.g. the
+// kernel, the device model, the library version and the problem shape, and
+// neither keys nor values may contain tabs or newlines.
+//
+// The process-wide instance returned by Global() is configured with these
+// environment variables:
+//
+//   TF_AUTOTUNE_CACHE_FILE: the file to use. If it is a directory, the cache
+//     is the file "autotune_cache" inside it. The cache is disabled if unset.
+//   TF_AUTOTUNE_CACHE_MAX_ENTRIES: the maximum number of entries kept in the
+//     file, 10000 by default. The oldest entries are dropped first.
+//   TF_AUTOTUNE_CACHE_VALIDATE: if true, users of the cache should autotune
+//     anyway and report the entries that disagree with their measurements.
+//
+// The file is read when the cache is created. Every insertion merges the
+// entries of the file, which other processes may have added to, with the
+// ones of this process, and replaces the file atomically, so that the results
+// survive even if the process doesn't exit cleanly. When two processes save
+// at the same time, the entries that only one of them has may be lost; they
+// are measured again by the next process that needs them.
+class AutotuneCache {
+ public:
+  // Creates a cache backed by 'filename' that keeps at most 'max_entries'
+  // entries. Call Load() to read the existing entries.
+  AutotuneCache(Env* env, const string& filename, int64 max_entries,
+                bool validate);
+
+  // Returns the cache configured by the environment, or nullptr if it is
+  // disabled. The first call loads the file.
+  static AutotuneCache* Global();
+
+  // Reads the entries of the file. A missing file is an empty cache.
+  Status Load();
+
+  // Looks up 'key', and returns true and sets '*value' if it is present.
+  bool Lookup(const string& key, string* value) const;
+
+  // Adds or replaces the entry for 'key', and saves the cache.
+  Status Insert(const string& key, const string& value);
+
+  // Merges the entries of the file with the ones of this process, and
+  // replaces the file with the result.
+  Status Save();
+
+  // True if cached results should be measured again and compared.
+  bool validate() const { return validate_; }
+
+  const string& filename() const { return filename_; }
+
+  // Number of entries in memory.
+  int64 size() const;
+
+  // Associates a description of the device with StreamExecutor ordinal
+  // 'device_id', e.g. its model and the version of its DNN library. Devices
+  // register themselves when they are initialized, so that kernels can build
+  // keys that are valid across processes.
+  void RegisterDevice(int device_id, const string& description);
+
+  // Returns the description registered for 'device_id', or an empty string.
+  string DeviceDescription(int device_id) const;
+
+ private:
+  typedef std::list<std::pair<string, string>> EntryList;
+
+  // Parses 'contents' into 'entries', from the oldest to the newest.
+  static Status Parse(const string& contents, EntryList* entries);
+
+  // Adds or moves 'key' to the newest end of entries_, with 'value'.
+  void InsertLocked(const string& key, const string& value)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Drops the oldest entries beyond max_entries_.
+  void TrimLocked() EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  Env* const env_;
+  const string filename_;
+  const int64 max_entries_;
+  const bool validate_;
+
+  mutable mutex mu_;
+  // All the entries, from the oldest to the newest, and an index into them.
+  EntryList entries_ GUARDED_BY(mu_);
+  std::unordered_map<string, EntryList::iterator> index_ GUARDED_BY(mu_);
+  // The keys inserted by this process, which take precedence over the file.
+  std::unordered_map<string, string> inserted_ GUARDED_BY(mu_);
+  std::unordered_map<int, string> devices_ GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AutotuneCache);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_UTIL_AUTOTUNE_CACHE_H_
@@ -0,0 +1,127 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/autotune_cache.h"
+
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+string TestFilename(const string& name) {
+  const string filename = io::JoinPath(testing::TmpDir(), name);
+  Env::Default()->DeleteFile(filename).IgnoreError();
+  return filename;
+}
+
+TEST(AutotuneCacheTest, MissingFileIsEmpty) {
+  AutotuneCache cache(Env::Default(), TestFilename("missing"), 10, false);
+  TF_EXPECT_OK(cache.Load());
+  EXPECT_EQ(0, cache.size());
+  string value;
+  EXPECT_FALSE(cache.Lookup("a", &value));
+}
+
+TEST(AutotuneCacheTest, InsertSavesToFile) {
+  const string filename = TestFilename("insert");
+  AutotuneCache cache(Env::Default(), filename, 10, false);
+  TF_EXPECT_OK(cache.Load());
+  TF_EXPECT_OK(cache.Insert("conv a", "1, 2"));
+  TF_EXPECT_OK(cache.Insert("conv b", "3, -1"));
+  TF_EXPECT_OK(cache.Insert("conv a", "4, 5"));
+  string value;
+  EXPECT_TRUE(cache.Lookup("conv a", &value));
+  EXPECT_EQ("4, 5", value);
+
+  AutotuneCache reloaded(Env::Default(), filename, 10, false);
+  TF_EXPECT_OK(reloaded.Load());
+  EXPECT_EQ(2, reloaded.size());
+  EXPECT_TRUE(reloaded.Lookup("conv a", &value));
+  EXPECT_EQ("4, 5", value);
+  EXPECT_TRUE(reloaded.Lookup("conv b", &value));
+  EXPECT_EQ("3, -1", value);
+}
+
+TEST(AutotuneCacheTest, MergesWithOtherProcesses) {
+  const string filename = TestFilename("merge");
+  AutotuneCache first(Env::Default(), filename, 10, false);
+  AutotuneCache second(Env::Default(), filename, 10, false);
+  TF_EXPECT_OK(first.Load());
+  TF_EXPECT_OK(second.Load());
+  TF_EXPECT_OK(first.Insert("a", "1"));
+  TF_EXPECT_OK(second.Insert("b", "2"));
+  TF_EXPECT_OK(second.Insert("a", "3"));
+  // The entries of this process win over the ones of the file.
+  TF_EXPECT_OK(first.Save());
+
+  AutotuneCache reloaded(Env::Default(), filename, 10, false);
+  TF_EXPECT_OK(reloaded.Load());
+  string value;
+  EXPECT_TRUE(reloaded.Lookup("a", &value));
+  EXPECT_EQ("1", value);
+  EXPECT_TRUE(reloaded.Lookup("b", &value));
+  EXPECT_EQ("2", value);
+}
+
+TEST(AutotuneCacheTest, DropsOldestEntries) {
+  const string filename = TestFilename("trim");
+  AutotuneCache cache(Env::Default(), filename, 2, false);
+  TF_EXPECT_OK(cache.Insert("a", "1"));
+  TF_EXPECT_OK(cache.Insert("b", "2"));
+  TF_EXPECT_OK(cache.Insert("c", "3"));
+  EXPECT_EQ(2, cache.size());
+
+  AutotuneCache reloaded(Env::Default(), filename, 10, false);
+  TF_EXPECT_OK(reloaded.Load());
+  string value;
+  EXPECT_FALSE(reloaded.Lookup("a", &value));
+  EXPECT_TRUE(reloaded.Lookup("b", &value));
+  EXPECT_TRUE(reloaded.Lookup("c", &value));
+}
+
+TEST(AutotuneCacheTest, RejectsInvalidEntries) {
+  AutotuneCache cache(Env::Default(), TestFilename("invalid"), 10, false);
+  EXPECT_FALSE(cache.Insert("", "1").ok());
+  EXPECT_FALSE(cache.Insert("a\tb", "1").ok());
+  EXPECT_FALSE(cache.Insert("a", "1\n").ok());
+  EXPECT_EQ(0, cache.size());
+}
+
+TEST(AutotuneCacheTest, MalformedFile) {
+  const string filename = TestFilename("malformed");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), filename, "a\t1\nbad\n"));
+  AutotuneCache cache(Env::Default(), filename, 10, false);
+  EXPECT_FALSE(cache.Load().ok());
+  // Saving replaces the malformed file.
+  TF_EXPECT_OK(cache.Insert("b", "2"));
+  AutotuneCache reloaded(Env::Default(), filename, 10, false);
+  TF_EXPECT_OK(reloaded.Load());
+  EXPECT_EQ(1, reloaded.size());
+}
+
+TEST(AutotuneCacheTest, Devices) {
+  AutotuneCache cache(Env::Default(), TestFilename("devices"), 10, true);
+  EXPECT_TRUE(cache.validate());
+  EXPECT_EQ("", cache.DeviceDescription(0));
+  cache.RegisterDevice(1, "Tesla K80, dnn 6021");
+  EXPECT_EQ("Tesla K80, dnn 6021", cache.DeviceDescription(1));
+  EXPECT_EQ("", cache.DeviceDescription(0));
+}
+
+}  // namespace
+}  // namespace tensorflow
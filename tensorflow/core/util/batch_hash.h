@@ -0,0 +1,60 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Helpers for hashing many string keys at once.
+//
+// Kernels which hash a key and then use the hash immediately, e.g. to probe a
+// table, stall on a cache miss per key: first on the bytes of the key, which
+// std::string stores out of line unless it is short, then on the bucket the
+// hash selects. Hashing a batch of keys before using any of the hashes lets
+// both kinds of misses be prefetched and overlap each other.
+
+#ifndef TENSORFLOW_UTIL_BATCH_HASH_H_
+#define TENSORFLOW_UTIL_BATCH_HASH_H_
+
+#include <string>
+
+#include "tensorflow/core/platform/prefetch.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+// The number of keys to hash before using their hashes. The hashes of a batch
+// fit in L1, and the prefetches of a batch in the line fill buffers of current
+// CPUs several times over.
+constexpr int64 kHashBatchSize = 64;
+
+// How many keys ahead of the one being hashed HashStrings() prefetches.
+constexpr int64 kHashPrefetchDistance = 4;
+
+// Sets "hashes[i] = hash(keys[i])" for i in [0, n). Returns the same hashes as
+// calling "hash" on each key, whose bytes are prefetched a few keys ahead.
+template <uint64 hash(const string&)>
+void HashStrings(const string* keys, int64 n, uint64* hashes) {
+  for (int64 i = 0; i < n && i < kHashPrefetchDistance; ++i) {
+    port::prefetch<port::PREFETCH_HINT_T0>(keys[i].data());
+  }
+  for (int64 i = 0; i < n; ++i) {
+    if (i + kHashPrefetchDistance < n) {
+      port::prefetch<port::PREFETCH_HINT_T0>(
+          keys[i + kHashPrefetchDistance].data());
+    }
+    hashes[i] = hash(keys[i]);
+  }
+}
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_UTIL_BATCH_HASH_H_
@@ -0,0 +1,48 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/batch_hash.h"
+
+#include <vector>
+
+#include "tensorflow/core/lib/hash/hash.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+TEST(BatchHashTest, MatchesHashingEachKey) {
+  std::vector<string> keys;
+  for (int i = 0; i < 100; ++i) {
+    // Both short strings, stored inline, and long ones.
+    keys.push_back(string(i, 'a' + i % 26));
+  }
+  const std::vector<int64> sizes = {0, 1, kHashPrefetchDistance, 100};
+  for (const int64 n : sizes) {
+    std::vector<uint64> hashes(n);
+    HashStrings<Fingerprint64>(keys.data(), n, hashes.data());
+    for (int64 i = 0; i < n; ++i) {
+      EXPECT_EQ(Fingerprint64(keys[i]), hashes[i]) << i;
+    }
+    HashStrings<Hash64>(keys.data(), n, hashes.data());
+    for (int64 i = 0; i < n; ++i) {
+      EXPECT_EQ(Hash64(keys[i]), hashes[i]) << i;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -75,6 +75,32 @@ struct BeamEntry {
       ++ci;
     }
   }
+  // Like PopulateChildren(L), but reuses the L entries of "*storage",
+  // released by ReleaseChildren(), instead of allocating new ones.
+  void PopulateChildren(int L, std::vector<BeamEntry>* storage) {
+    CHECK(!HasChildren());
+    CHECK_EQ(storage->size(), L);
+    children.swap(*storage);
+    int ci = 0;
+    for (auto& c : children) {
+      c.parent = this;
+      c.label = ci;
+      c.oldp.Reset();
+      c.newp.Reset();
+      c.state = CTCBeamState();
+      ++ci;
+    }
+  }
+  // Moves the children of this entry and of all its descendants to
+  // "*storage", so that PopulateChildren() can reuse them.
+  void ReleaseChildren(std::vector<std::vector<BeamEntry>>* storage) {
+    if (!HasChildren()) return;
+    for (auto& c : children) {
+      c.ReleaseChildren(storage);
+    }
+    storage->emplace_back();
+    storage->back().swap(children);
+  }
   inline std::vector<BeamEntry>* Children() {
     CHECK(HasChildren());
     return &children;
@@ -87,6 +87,8 @@ class CTCBeamSearchDecoder : public CTCDecoder {
         beam_width_(beam_width),
         leaves_(beam_width),
         beam_scorer_(CHECK_NOTNULL(scorer)) {
+    leaves_.reserve(beam_width + 1);
+    branches_.reserve(beam_width);
     Reset();
   }
 
@@ -113,7 +115,8 @@ class CTCBeamSearchDecoder : public CTCDecoder {
     label_selection_margin_ = label_selection_margin;
   }
 
-  // Reset the beam search
+  // Reset the beam search. The memory of the beams is kept for the next
+  // search.
   void Reset();
 
   // Extract the top n paths at current time step
@@ -136,10 +139,22 @@ class CTCBeamSearchDecoder : public CTCDecoder {
   int label_selection_size_ = 0;       // zero means unlimited
   float label_selection_margin_ = -1;  // -1 means unlimited.
 
+  // Populates the children of "b", reusing released ones if possible.
+  void PopulateChildren(BeamEntry* b);
+
   gtl::TopN<BeamEntry*, CTCBeamComparer> leaves_;
   std::unique_ptr<BeamEntry> beam_root_;
   BaseBeamScorer<CTCBeamState>* beam_scorer_;
 
+  // The children of the beams of previous searches, reused by the next ones
+  // so that a decoder allocates beams only while it grows.
+  std::vector<std::vector<BeamEntry>> children_storage_;
+
+  // Scratch buffers of Step(), kept to avoid allocating them at each step.
+  std::vector<BeamEntry*> branches_;
+  Eigen::ArrayXf input_;
+  std::vector<float> label_selection_input_;
+
   TF_DISALLOW_COPY_AND_ASSIGN(CTCBeamSearchDecoder);
 };
 
@@ -174,10 +189,9 @@ Status CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Decode(
     }  // for (int t...
 
     // O(n * log(n))
-    std::unique_ptr<std::vector<BeamEntry*>> branches(leaves_.Extract());
+    leaves_.ExtractNondestructive(&branches_);
     leaves_.Reset();
-    for (int i = 0; i < branches->size(); ++i) {
-      BeamEntry* entry = (*branches)[i];
+    for (BeamEntry* entry : branches_) {
       beam_scorer_->ExpandStateEnd(&entry->state);
       entry->newp.total +=
           beam_scorer_->GetStateEndExpansionScore(entry->state);
@@ -206,14 +220,16 @@ template <typename CTCBeamState, typename CTCBeamComparer>
 template <typename Vector>
 void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Step(
     const Vector& raw_input) {
-  Eigen::ArrayXf input = raw_input;
+  Eigen::ArrayXf& input = input_;
+  input = raw_input;
   // Remove the max for stability when performing log-prob calculations.
   input -= input.maxCoeff();
 
   // Minimum allowed input value for label selection:
   float label_selection_input_min = -std::numeric_limits<float>::infinity();
   if (label_selection_size_ > 0 && label_selection_size_ < input.size()) {
-    std::vector<float> input_copy(input.data(), input.data() + input.size());
+    std::vector<float>& input_copy = label_selection_input_;
+    input_copy.assign(input.data(), input.data() + input.size());
     std::nth_element(input_copy.begin(),
                      input_copy.begin() + label_selection_size_ - 1,
                      input_copy.end(), [](float a, float b) { return a > b; });
@@ -228,15 +244,15 @@ void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Step(
   // Extract the beams sorted in decreasing new probability
   CHECK_EQ(num_classes_, input.size());
 
-  std::unique_ptr<std::vector<BeamEntry*>> branches(leaves_.Extract());
+  leaves_.ExtractNondestructive(&branches_);
   leaves_.Reset();
 
-  for (BeamEntry* b : *branches) {
+  for (BeamEntry* b : branches_) {
     // P(.. @ t) becomes the new P(.. @ t-1)
     b->oldp = b->newp;
   }
 
-  for (BeamEntry* b : *branches) {
+  for (BeamEntry* b : branches_) {
     if (b->parent != nullptr) {  // if not the root
       if (b->parent->Active()) {
         // If last two sequence characters are identical:
@@ -270,7 +286,7 @@ void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Step(
   // originally in descending newp order and we copied newp to oldp.
 
   // Grow new leaves
-  for (BeamEntry* b : *branches) {
+  for (BeamEntry* b : branches_) {
     // A new leaf (represented by its BeamProbability) is a candidate
     // iff its total probability is nonzero and either the beam list
     // isn't full, or the lowest probability entry in the beam has a
@@ -286,7 +302,7 @@ void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Step(
     }
 
     if (!b->HasChildren()) {
-      b->PopulateChildren(num_classes_ - 1);
+      PopulateChildren(b);
     }
 
     for (BeamEntry& c : *b->Children()) {
@@ -334,8 +350,12 @@ void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Reset() {
   leaves_.Reset();
 
   // This beam root, and all of its children, will be in memory until
-  // the next reset.
-  beam_root_.reset(new BeamEntry(nullptr, -1, num_classes_ - 1, -1));
+  // the next reset, which releases the children for reuse.
+  if (beam_root_ != nullptr) {
+    beam_root_->ReleaseChildren(&children_storage_);
+  }
+  beam_root_.reset(new BeamEntry);
+  PopulateChildren(beam_root_.get());
   beam_root_->newp.total = 0.0;  // ln(1)
   beam_root_->newp.blank = 0.0;  // ln(1)
 
@@ -346,6 +366,17 @@ void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::Reset() {
   beam_scorer_->InitializeState(&beam_root_->state);
 }
 
+template <typename CTCBeamState, typename CTCBeamComparer>
+void CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::PopulateChildren(
+    BeamEntry* b) {
+  if (children_storage_.empty()) {
+    b->PopulateChildren(num_classes_ - 1);
+  } else {
+    b->PopulateChildren(num_classes_ - 1, &children_storage_.back());
+    children_storage_.pop_back();
+  }
+}
+
 template <typename CTCBeamState, typename CTCBeamComparer>
 Status CTCBeamSearchDecoder<CTCBeamState, CTCBeamComparer>::TopPaths(
     int n, std::vector<std::vector<int>>* paths, std::vector<float>* log_probs,
@@ -178,6 +178,16 @@ TEST(CtcBeamSearch, DecodingWithAndWithoutDictionary) {
   for (int path = 0; path < top_paths; ++path) {
     EXPECT_EQ(dict_outputs[path][0], expected_dict_output[0][path]);
   }
+
+  // Decoding again reuses the beams of the previous decoding, which must not
+  // leak into the results.
+  EXPECT_TRUE(decoder.Decode(seq_len, inputs, &outputs, &scores).ok());
+  EXPECT_TRUE(
+      dictionary_decoder.Decode(seq_len, inputs, &dict_outputs, &scores).ok());
+  for (int path = 0; path < top_paths; ++path) {
+    EXPECT_EQ(outputs[path][0], expected_output[0][path]);
+    EXPECT_EQ(dict_outputs[path][0], expected_dict_output[0][path]);
+  }
 }
 
 TEST(CtcBeamSearch, AllBeamElementsHaveFiniteScores) {
@@ -17,6 +17,9 @@ limitations under the License.
 
 #include <stddef.h>  // for NULL
 
+#include <algorithm>
+#include <vector>
+
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/strcat.h"
@@ -33,7 +36,38 @@ EventsWriter::EventsWriter(const string& file_prefix)
     // TODO(jeff,sanjay): Pass in env and use that here instead of Env::Default
     : env_(Env::Default()),
       file_prefix_(file_prefix),
-      num_outstanding_events_(0) {}
+      num_outstanding_events_(0),
+      async_(false) {}
+
+EventsWriter::EventsWriter(const string& file_prefix,
+                           const AsyncOptions& options)
+    : env_(Env::Default()),
+      file_prefix_(file_prefix),
+      num_outstanding_events_(0),
+      async_(true),
+      async_options_(options) {
+  thread_.reset(env_->StartThread(ThreadOptions(), "events_writer",
+                                  [this]() { WriteQueuedEvents(); }));
+}
+
+EventsWriter::~EventsWriter() {
+  Close();
+  if (async_) {
+    {
+      mutex_lock l(mu_);
+      stopping_ = true;
+    }
+    events_queued_.notify_all();
+    // Joins the background thread.
+    thread_.reset();
+  }
+}
+
+bool EventsWriter::InitWithSuffix(const string& suffix) {
+  mutex_lock l(file_mu_);
+  file_suffix_ = suffix;
+  return InitIfNeeded();
+}
 
 bool EventsWriter::InitIfNeeded() {
   if (recordio_writer_ != nullptr) {
@@ -76,13 +110,16 @@ bool EventsWriter::InitIfNeeded() {
     Event event;
     event.set_wall_time(time_in_seconds);
     event.set_file_version(strings::StrCat(kVersionPrefix, kCurrentVersion));
-    WriteEvent(event);
-    Flush();
+    string record;
+    event.AppendToString(&record);
+    WriteSerializedEventNow(record);
+    FlushNow();
   }
   return true;
 }
 
 string EventsWriter::FileName() {
+  mutex_lock l(file_mu_);
   if (filename_.empty()) {
     InitIfNeeded();
   }
@@ -90,14 +127,31 @@ string EventsWriter::FileName() {
 }
 
 void EventsWriter::WriteSerializedEvent(StringPiece event_str) {
+  if (!async_) {
+    mutex_lock l(file_mu_);
+    WriteSerializedEventNow(event_str);
+    return;
+  }
+  const size_t max_queued_events =
+      std::max(1, async_options_.max_queued_events);
+  mutex_lock l(mu_);
+  while (queue_.size() >= max_queued_events) {
+    events_written_.wait(l);
+  }
+  queue_.emplace_back(event_str.data(), event_str.size());
+  ++num_queued_;
+  events_queued_.notify_one();
+}
+
+bool EventsWriter::WriteSerializedEventNow(StringPiece event_str) {
   if (recordio_writer_ == nullptr) {
     if (!InitIfNeeded()) {
       LOG(ERROR) << "Write failed because file could not be opened.";
-      return;
+      return false;
     }
   }
   num_outstanding_events_++;
-  recordio_writer_->WriteRecord(event_str).IgnoreError();
+  return recordio_writer_->WriteRecord(event_str).ok();
 }
 
 // NOTE(touts); This is NOT the function called by the Python code.
@@ -109,6 +163,23 @@ void EventsWriter::WriteEvent(const Event& event) {
 }
 
 bool EventsWriter::Flush() {
+  if (!async_) {
+    mutex_lock l(file_mu_);
+    return FlushNow();
+  }
+  mutex_lock l(mu_);
+  const int64 target = num_queued_;
+  flush_target_ = std::max(flush_target_, target);
+  events_queued_.notify_one();
+  while (num_flushed_ < target) {
+    events_written_.wait(l);
+  }
+  const bool ok = ok_since_flush_;
+  ok_since_flush_ = true;
+  return ok;
+}
+
+bool EventsWriter::FlushNow() {
   if (num_outstanding_events_ == 0) return true;
   CHECK(recordio_file_ != nullptr) << "Unexpected NULL file";
 
@@ -138,7 +209,15 @@ bool EventsWriter::Flush() {
 }
 
 bool EventsWriter::Close() {
-  bool return_value = Flush();
+  // In async mode, the queued events are flushed by the background thread
+  // first.
+  const bool flushed = !async_ || Flush();
+  mutex_lock l(file_mu_);
+  return CloseNow() && flushed;
+}
+
+bool EventsWriter::CloseNow() {
+  bool return_value = FlushNow();
   if (recordio_file_ != nullptr) {
     Status s = recordio_file_->Close();
     if (!s.ok()) {
@@ -153,6 +232,87 @@ bool EventsWriter::Close() {
   return return_value;
 }
 
+void EventsWriter::WriteQueuedEvents() {
+  // The time at which the oldest unflushed event was written, or 0 if all the
+  // events are flushed, and the bytes written since the last flush. Only this
+  // thread uses them.
+  int64 unflushed_since_micros = 0;
+  int64 unflushed_bytes = 0;
+  std::vector<string> batch;
+  while (true) {
+    bool flush_requested;
+    {
+      mutex_lock l(mu_);
+      while (queue_.empty() && !stopping_ && flush_target_ <= num_flushed_) {
+        if (unflushed_since_micros == 0) {
+          events_queued_.wait(l);
+          continue;
+        }
+        const int64 wait_micros =
+            unflushed_since_micros + async_options_.flush_interval_micros -
+            static_cast<int64>(env_->NowMicros());
+        if (wait_micros <= 0) break;
+        WaitForMilliseconds(&l, &events_queued_, wait_micros / 1000 + 1);
+      }
+      int64 batch_bytes = 0;
+      while (!queue_.empty() &&
+             (batch.empty() ||
+              batch_bytes + static_cast<int64>(queue_.front().size()) <=
+                  async_options_.max_batch_bytes)) {
+        batch_bytes += queue_.front().size();
+        batch.push_back(std::move(queue_.front()));
+        queue_.pop_front();
+      }
+      if (!batch.empty()) {
+        // There is room in the queue again.
+        events_written_.notify_all();
+      }
+      flush_requested =
+          stopping_ || (flush_target_ > num_flushed_ &&
+                        flush_target_ <= num_written_ +
+                                             static_cast<int64>(batch.size()));
+    }
+
+    bool ok = true;
+    bool flushed = false;
+    {
+      mutex_lock l(file_mu_);
+      for (const string& event : batch) {
+        ok = WriteSerializedEventNow(event) && ok;
+        unflushed_bytes += event.size();
+      }
+      const int64 now_micros = static_cast<int64>(env_->NowMicros());
+      if (!batch.empty() && unflushed_since_micros == 0) {
+        unflushed_since_micros = now_micros;
+      }
+      if (flush_requested ||
+          unflushed_bytes >= async_options_.max_unflushed_bytes ||
+          (unflushed_since_micros != 0 &&
+           now_micros - unflushed_since_micros >=
+               async_options_.flush_interval_micros)) {
+        ok = FlushNow() && ok;
+        flushed = true;
+        unflushed_since_micros = 0;
+        unflushed_bytes = 0;
+      }
+    }
+
+    mutex_lock l(mu_);
+    num_written_ += batch.size();
+    batch.clear();
+    if (flushed) {
+      num_flushed_ = num_written_;
+    }
+    if (!ok) {
+      ok_since_flush_ = false;
+    }
+    events_written_.notify_all();
+    if (stopping_ && queue_.empty() && num_flushed_ == num_written_) {
+      return;
+    }
+  }
+}
+
 bool EventsWriter::FileHasDisappeared() {
   if (env_->FileExists(filename_).ok()) {
     return false;
@@ -16,11 +16,14 @@ limitations under the License.
 #ifndef TENSORFLOW_UTIL_EVENTS_WRITER_H_
 #define TENSORFLOW_UTIL_EVENTS_WRITER_H_
 
+#include <deque>
 #include <memory>
 #include <string>
 #include "tensorflow/core/lib/io/record_writer.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/util/event.pb.h"
 
@@ -32,6 +35,19 @@ class EventsWriter {
   // Prefix of version string present in the first entry of every event file.
   static constexpr const char* kVersionPrefix = "brain.Event:";
   static constexpr const int kCurrentVersion = 2;
+
+  // Options of an EventsWriter that writes in the background.
+  struct AsyncOptions {
+    // Write*() blocks while this many events are waiting to be written.
+    int max_queued_events = 1024;
+    // The background thread takes the queued events by batches of up to this
+    // many bytes, and only considers flushing after each batch.
+    int64 max_batch_bytes = 1 << 20;
+    // Unflushed events are flushed once they are this old...
+    int64 flush_interval_micros = 120 * 1000 * 1000;
+    // ... or once this many bytes haven't been flushed.
+    int64 max_unflushed_bytes = 16 << 20;
+  };
 #endif
 
   // Events files typically have a name of the form
@@ -43,7 +59,15 @@ class EventsWriter {
   // Note that it is not recommended to simultaneously have two
   // EventWriters writing to the same file_prefix.
   explicit EventsWriter(const string& file_prefix);
-  ~EventsWriter() { Close(); }  // Autoclose in destructor.
+#ifndef SWIG
+  // Creates an EventsWriter whose Write*() methods only queue the events. A
+  // background thread writes them and flushes the file as 'options' say, so
+  // that slow file systems, e.g. GCS or HDFS, don't hold up the callers.
+  // Flush() and Close() still wait until all the queued events are flushed.
+  // All the methods may then be called from several threads.
+  EventsWriter(const string& file_prefix, const AsyncOptions& options);
+#endif
+  ~EventsWriter();  // Autoclose in destructor.
 
   // Sets the event file filename and opens file for writing.  If not called by
   // user, will be invoked automatically by a call to FileName() or Write*().
@@ -52,10 +76,7 @@ class EventsWriter {
   // but has since disappeared (e.g. deleted by another process), this will open
   // a new file with a new timestamp in its filename.
   bool Init() { return InitWithSuffix(""); }
-  bool InitWithSuffix(const string& suffix) {
-    file_suffix_ = suffix;
-    return InitIfNeeded();
-  }
+  bool InitWithSuffix(const string& suffix);
 
   // Returns the filename for the current events file:
   // filename_ = [file_prefix_].out.events.[timestamp].[hostname][suffix]
@@ -74,7 +95,8 @@ class EventsWriter {
   // and/or check for success.
   //   Flush() pushes outstanding events to disk.  Returns false if the
   // events file could not be created, or if the file exists but could not
-  // be written too.
+  // be written too.  With AsyncOptions, this covers the events that were
+  // queued before the call, and the failures since the previous Flush().
   //   Close() calls Flush() and then closes the current events file.
   // Returns true only if both the flush and the closure were successful.
   bool Flush();
@@ -84,6 +106,15 @@ class EventsWriter {
   bool FileHasDisappeared();  // True if event_file_path_ does not exist.
   bool InitIfNeeded();
 
+  // The synchronous implementations of the public methods. In async mode,
+  // they are called with file_mu_ held, mostly by the background thread.
+  bool WriteSerializedEventNow(StringPiece event_str);
+  bool FlushNow();
+  bool CloseNow();
+
+  // The body of the background thread of async mode.
+  void WriteQueuedEvents();
+
   Env* env_;
   const string file_prefix_;
   string file_suffix_;
@@ -91,6 +122,33 @@ class EventsWriter {
   std::unique_ptr<WritableFile> recordio_file_;
   std::unique_ptr<io::RecordWriter> recordio_writer_;
   int num_outstanding_events_;
+
+#ifndef SWIG
+  // The state of async mode, which is only used if async_ is true.
+  const bool async_;
+  const AsyncOptions async_options_;
+  // Serializes the accesses to the file and the members above.
+  mutex file_mu_;
+  mutex mu_;
+  // Signaled when events are queued, a flush is requested, or the writer is
+  // destroyed, for the background thread.
+  condition_variable events_queued_;
+  // Signaled when events have been taken out of the queue or flushed.
+  condition_variable events_written_;
+  std::deque<string> queue_ GUARDED_BY(mu_);
+  // The number of events queued since the creation of the writer, and of the
+  // first ones of those that have been written, and flushed.
+  int64 num_queued_ GUARDED_BY(mu_) = 0;
+  int64 num_written_ GUARDED_BY(mu_) = 0;
+  int64 num_flushed_ GUARDED_BY(mu_) = 0;
+  // The number of first events that pending Flush() calls wait for.
+  int64 flush_target_ GUARDED_BY(mu_) = 0;
+  // False if a write or flush failed since the last Flush().
+  bool ok_since_flush_ GUARDED_BY(mu_) = true;
+  bool stopping_ GUARDED_BY(mu_) = false;
+  std::unique_ptr<Thread> thread_;
+#endif
+
   TF_DISALLOW_COPY_AND_ASSIGN(EventsWriter);
 };
 
@@ -16,6 +16,9 @@ limitations under the License.
 #include "tensorflow/core/util/events_writer.h"
 
 #include <math.h>
+#include <memory>
+#include <vector>
+
 #include "tensorflow/core/framework/summary.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/status.h"
@@ -104,6 +107,22 @@ void VerifyFile(const string& filename) {
   delete reader;
 }
 
+// Returns the number of events in the file, or -1 if it can't be read.
+int CountEvents(const string& filename) {
+  std::unique_ptr<RandomAccessFile> event_file;
+  if (!env()->NewRandomAccessFile(filename, &event_file).ok()) {
+    return -1;
+  }
+  io::RecordReader reader(event_file.get());
+  uint64 offset = 0;
+  int num_events = 0;
+  Event event;
+  while (ReadEventProto(&reader, &offset, &event)) {
+    ++num_events;
+  }
+  return num_events;
+}
+
 string GetDirName(const string& suffix) {
   return io::JoinPath(testing::TmpDir(), suffix);
 }
@@ -207,5 +226,96 @@ TEST(EventWriter, FileDeletionBeforeWriting) {
   VerifyFile(filename1);
 }
 
+TEST(EventWriter, AsyncWriteFlush) {
+  string file_prefix = GetDirName("/asyncwriteflush_test");
+  EventsWriter writer(file_prefix, EventsWriter::AsyncOptions());
+  WriteFile(&writer);
+  EXPECT_TRUE(writer.Flush());
+  string filename = writer.FileName();
+  VerifyFile(filename);
+}
+
+TEST(EventWriter, AsyncWriteDelete) {
+  string file_prefix = GetDirName("/asyncwritedelete_test");
+  EventsWriter* writer =
+      new EventsWriter(file_prefix, EventsWriter::AsyncOptions());
+  WriteFile(writer);
+  string filename = writer->FileName();
+  delete writer;
+  VerifyFile(filename);
+}
+
+TEST(EventWriter, AsyncFailFlush) {
+  string file_prefix = GetDirName("/asyncfailflush_test");
+  EventsWriter writer(file_prefix, EventsWriter::AsyncOptions());
+  string filename = writer.FileName();
+  TF_ASSERT_OK(env()->DeleteFile(filename));
+  WriteFile(&writer);
+  EXPECT_FALSE(writer.Flush());
+  // The failure is only reported once.
+  EXPECT_TRUE(writer.Flush());
+}
+
+TEST(EventWriter, AsyncFlushesPeriodically) {
+  string file_prefix = GetDirName("/asyncflushesperiodically_test");
+  EventsWriter::AsyncOptions options;
+  options.flush_interval_micros = 10 * 1000;
+  EventsWriter writer(file_prefix, options);
+  WriteFile(&writer);
+  string filename = writer.FileName();
+  // The file version event and the two written ones.
+  for (int i = 0; i < 1000 && CountEvents(filename) < 3; ++i) {
+    env()->SleepForMicroseconds(10 * 1000);
+  }
+  EXPECT_EQ(3, CountEvents(filename));
+  EXPECT_TRUE(writer.Close());
+  VerifyFile(filename);
+}
+
+TEST(EventWriter, AsyncFlushesBySize) {
+  string file_prefix = GetDirName("/asyncflushesbysize_test");
+  EventsWriter::AsyncOptions options;
+  options.max_unflushed_bytes = 1;
+  EventsWriter writer(file_prefix, options);
+  WriteFile(&writer);
+  string filename = writer.FileName();
+  for (int i = 0; i < 1000 && CountEvents(filename) < 3; ++i) {
+    env()->SleepForMicroseconds(10 * 1000);
+  }
+  EXPECT_EQ(3, CountEvents(filename));
+  EXPECT_TRUE(writer.Close());
+  VerifyFile(filename);
+}
+
+TEST(EventWriter, AsyncManyThreads) {
+  string file_prefix = GetDirName("/asyncmanythreads_test");
+  EventsWriter::AsyncOptions options;
+  // Small enough for the writers to block on the queue.
+  options.max_queued_events = 2;
+  options.max_batch_bytes = 64;
+  EventsWriter writer(file_prefix, options);
+  const int kNumThreads = 4;
+  const int kEventsPerThread = 100;
+  {
+    std::vector<std::unique_ptr<Thread>> threads;
+    for (int t = 0; t < kNumThreads; ++t) {
+      threads.emplace_back(env()->StartThread(
+          ThreadOptions(), "events_writer_test", [&writer, t]() {
+            for (int i = 0; i < kEventsPerThread; ++i) {
+              WriteSimpleValue(&writer, 1234, t * kEventsPerThread + i, "foo",
+                               i);
+              if (i % 10 == 0) {
+                EXPECT_TRUE(writer.Flush());
+              }
+            }
+          }));
+    }
+  }
+  EXPECT_TRUE(writer.Close());
+  string filename = writer.FileName();
+  EXPECT_EQ(1 + kNumThreads * kEventsPerThread, CountEvents(filename));
+  TF_ASSERT_OK(env()->DeleteFile(filename));
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -213,6 +213,11 @@ class Feature {
 using FeatureMapEntry = std::pair<StringPiece, Feature>;
 using Example = std::vector<FeatureMapEntry>;
 
+// The serialized FeatureList of a feature_lists map entry is only parsed into
+// its steps once the entry turns out to be in the config.
+using FeatureListMapEntry = std::pair<StringPiece, StringPiece>;
+using FeatureLists = std::vector<FeatureListMapEntry>;
+
 }  // namespace parsed
 
 inline bool SkipExtraneousTag(protobuf::io::CodedInputStream* stream) {
@@ -320,6 +325,80 @@ bool ParseExample(StringPiece serialized, parsed::Example* example) {
   return ParseExample(&stream, example);
 }
 
+bool ParseFeatureListMapEntry(
+    protobuf::io::CodedInputStream* stream,
+    parsed::FeatureListMapEntry* feature_list_map_entry) {
+  DCHECK(stream != nullptr);
+  DCHECK(feature_list_map_entry != nullptr);
+  uint32 length;
+  if (!stream->ReadVarint32(&length)) return false;
+  auto limit = stream->PushLimit(length);
+  if (!stream->ExpectTag(kDelimitedTag(1))) return false;
+  if (!ParseString(stream, &feature_list_map_entry->first)) return false;
+  if (!stream->ExpectTag(kDelimitedTag(2))) return false;
+  if (!ParseString(stream, &feature_list_map_entry->second)) return false;
+  if (!stream->ExpectAtEnd()) return false;
+  stream->PopLimit(limit);
+  return true;
+}
+
+bool ParseFeatureLists(protobuf::io::CodedInputStream* stream,
+                       parsed::FeatureLists* feature_lists) {
+  DCHECK(stream != nullptr);
+  DCHECK(feature_lists != nullptr);
+  uint32 length;
+  if (!stream->ReadVarint32(&length)) return false;
+  auto limit = stream->PushLimit(length);
+  while (!stream->ExpectAtEnd()) {
+    parsed::FeatureListMapEntry feature_list_map_entry;
+    if (!stream->ExpectTag(kDelimitedTag(1))) return false;
+    if (!ParseFeatureListMapEntry(stream, &feature_list_map_entry)) {
+      return false;
+    }
+    feature_lists->push_back(feature_list_map_entry);
+  }
+  stream->PopLimit(limit);
+  return true;
+}
+
+// Collects the feature lists of a serialized SequenceExample. Its context is
+// skipped, as it is parsed by ParseExample, which in turn skips the feature
+// lists: both messages keep their features in field 1.
+bool ParseSequenceExampleFeatureLists(StringPiece serialized,
+                                      parsed::FeatureLists* feature_lists) {
+  DCHECK(feature_lists != nullptr);
+  protobuf::io::CodedInputStream stream(
+      reinterpret_cast<const uint8*>(serialized.data()), serialized.size());
+  EnableAliasing(&stream);
+  while (!stream.ExpectAtEnd()) {
+    if (!stream.ExpectTag(kDelimitedTag(2))) {
+      if (!SkipExtraneousTag(&stream)) return false;
+      continue;
+    }
+    if (!ParseFeatureLists(&stream, feature_lists)) return false;
+  }
+  return true;
+}
+
+// Splits a serialized FeatureList into its steps.
+bool ParseFeatureList(StringPiece serialized,
+                      std::vector<parsed::Feature>* steps) {
+  DCHECK(steps != nullptr);
+  protobuf::io::CodedInputStream stream(
+      reinterpret_cast<const uint8*>(serialized.data()), serialized.size());
+  EnableAliasing(&stream);
+  while (!stream.ExpectAtEnd()) {
+    if (!stream.ExpectTag(kDelimitedTag(1))) {
+      if (!SkipExtraneousTag(&stream)) return false;
+      continue;
+    }
+    StringPiece step;
+    if (!ParseString(&stream, &step)) return false;
+    steps->emplace_back(step);
+  }
+  return true;
+}
+
 }  // namespace
 
 bool TestFastParse(const string& serialized, Example* example) {
@@ -764,6 +843,62 @@ Status CheckConfigDataType(DataType dtype) {
   }
 }
 
+// Builds the index from the hashes of the feature names of config to the
+// sub-configs, reseeding hasher until no two of them collide. ConfigT is
+// FastParseExampleConfig or FastParseFeatureListConfig.
+template <typename ConfigT>
+Status BuildConfigIndex(
+    const ConfigT& config, SeededHasher* hasher,
+    PresizedCuckooMap<std::pair<size_t, Type>>* config_index) {
+  const size_t config_size = config.dense.size() + config.sparse.size();
+  bool ok = true;
+  for (size_t i = 0; i < 1000; ++i) {
+    for (size_t d = 0; d < config.dense.size(); ++d) {
+      ok &= config_index->InsertUnique((*hasher)(config.dense[d].feature_name),
+                                       {d, Type::Dense});
+    }
+    for (size_t d = 0; d < config.sparse.size(); ++d) {
+      ok &= config_index->InsertUnique(
+          (*hasher)(config.sparse[d].feature_name), {d, Type::Sparse});
+    }
+    if (ok) break;
+    LOG(WARNING) << "Collision found. This should happen only if you have "
+                    "around 2^32 entries in your config.";
+    hasher->seed++;
+    config_index->Clear(config_size);
+  }
+  if (!ok) {
+    return errors::Internal(
+        "Could not avoid collision. This should not happen.");
+  }
+  return Status::OK();
+}
+
+// Returns the number of minibatches to split serialized into. In main regime
+// each minibatch is around kMiniBatchSizeBytes bytes; 'special logic' below
+// covers the small and big regimes.
+size_t NumMiniBatches(gtl::ArraySlice<string> serialized) {
+  // This parameter affects performance in a big and data-dependent way.
+  const size_t kMiniBatchSizeBytes = 50000;
+
+  size_t result = 0;
+  size_t minibatch_bytes = 0;
+  for (size_t i = 0; i < serialized.size(); i++) {
+    if (minibatch_bytes == 0) {  // start minibatch
+      result++;
+    }
+    minibatch_bytes += serialized[i].size() + 1;
+    if (minibatch_bytes > kMiniBatchSizeBytes) {
+      minibatch_bytes = 0;
+    }
+  }
+  // 'special logic'
+  const size_t min_minibatches = std::min<size_t>(8, serialized.size());
+  const size_t max_minibatches = 64;
+  return std::max<size_t>(min_minibatches,
+                          std::min<size_t>(max_minibatches, result));
+}
+
 template <typename T>
 const SmallVector<T>& GetListFromBuffer(const SparseBuffer& buffer);
 
@@ -833,6 +968,196 @@ void FillAndCopyVarLen(
   }
 }
 
+using FeatureListConfig = FastParseFeatureListConfig;
+
+struct FeatureListBuffer {
+  // Values of all the steps, with one entry of example_end_indices per step
+  // rather than per example.
+  SparseBuffer steps;
+
+  // Steps of example i are steps from example_end_steps[i-1] to
+  // example_end_steps[i]-1.
+  std::vector<size_t> example_end_steps;
+};
+
+size_t NumValuesInBuffer(const SparseBuffer& buffer, DataType dtype) {
+  switch (dtype) {
+    case DT_INT64:
+      return buffer.int64_list.size();
+    case DT_FLOAT:
+      return buffer.float_list.size();
+    case DT_STRING:
+      return buffer.bytes_list.size();
+    default:
+      CHECK(false) << "Should not happen.";
+      return 0;
+  }
+}
+
+bool ParseFeatureIntoBuffer(DataType dtype, parsed::Feature* feature,
+                            SparseBuffer* buffer) {
+  switch (dtype) {
+    case DT_INT64:
+      return feature->ParseInt64List(&buffer->int64_list);
+    case DT_FLOAT:
+      return feature->ParseFloatList(&buffer->float_list);
+    case DT_STRING:
+      return feature->ParseBytesList(&buffer->bytes_list);
+    default:
+      CHECK(false) << "Should not happen.";
+      return false;
+  }
+}
+
+Status FastParseSerializedFeatureLists(
+    const string& serialized_example, const string& example_name,
+    const FeatureListConfig& config,
+    const PresizedCuckooMap<std::pair<size_t, Type>>& config_index,
+    SeededHasher hasher, std::vector<FeatureListBuffer>* output_dense,
+    std::vector<FeatureListBuffer>* output_sparse) {
+  DCHECK(output_dense != nullptr);
+  DCHECK(output_sparse != nullptr);
+  parsed::FeatureLists feature_lists;
+  if (!ParseSequenceExampleFeatureLists(serialized_example, &feature_lists)) {
+    return errors::InvalidArgument("Could not parse example input, value: '",
+                                   serialized_example, "'");
+  }
+  std::vector<bool> dense_feature_list_found(config.dense.size(), false);
+  std::vector<bool> sparse_feature_list_found(config.sparse.size(), false);
+  std::vector<parsed::Feature> steps;
+
+  const size_t num_feature_lists = feature_lists.size();
+  for (size_t i = 0; i < num_feature_lists; ++i) {
+    // Like for features, the last entry in the map overwrites all the
+    // previous ones.
+    const parsed::FeatureListMapEntry& name_and_feature_list =
+        feature_lists[num_feature_lists - i - 1];
+    const StringPiece feature_list_name = name_and_feature_list.first;
+
+    std::pair<size_t, Type> d_and_type;
+    uint64 h = hasher(feature_list_name);
+    if (!config_index.Find(h, &d_and_type)) continue;
+
+    size_t d = d_and_type.first;
+    bool is_dense = d_and_type.second == Type::Dense;
+
+    // Testing for PresizedCuckooMap collision.
+    const string& config_feature_list_name =
+        is_dense ? config.dense[d].feature_name : config.sparse[d].feature_name;
+    if (feature_list_name != config_feature_list_name) continue;
+
+    std::vector<bool>& found =
+        is_dense ? dense_feature_list_found : sparse_feature_list_found;
+    if (found[d]) continue;
+    found[d] = true;
+
+    const DataType dtype =
+        is_dense ? config.dense[d].dtype : config.sparse[d].dtype;
+    SparseBuffer& out =
+        is_dense ? (*output_dense)[d].steps : (*output_sparse)[d].steps;
+
+    steps.clear();
+    if (!ParseFeatureList(name_and_feature_list.second, &steps)) {
+      return errors::InvalidArgument(
+          "Name: ", example_name, ", Feature list: ", feature_list_name,
+          ".  Can't parse serialized SequenceExample.");
+    }
+    for (size_t t = 0; t < steps.size(); ++t) {
+      auto step_error = [&](StringPiece suffix) {
+        return errors::InvalidArgument("Name: ", example_name,
+                                       ", Feature list: ", feature_list_name,
+                                       ", Index: ", t, ".  ", suffix);
+      };
+
+      parsed::Feature& step = steps[t];
+      const StringPiece serialized_step = step.GetSerialized();
+      DataType step_dtype;
+      TF_RETURN_IF_ERROR(step.ParseDataType(&step_dtype));
+      // Sparse feature lists may have steps without any values.
+      if (step_dtype != DT_INVALID || is_dense) {
+        if (step_dtype != dtype) {
+          // Only parse the step with the full proto parser to report it.
+          Feature feature;
+          feature.ParseFromArray(serialized_step.data(),
+                                 serialized_step.size());
+          return step_error(strings::StrCat(
+              "Data types don't match. Expected type: ", DataTypeString(dtype),
+              "  Feature is: ", ProtoDebugString(feature)));
+        }
+        const size_t num_values_before = NumValuesInBuffer(out, dtype);
+        if (!ParseFeatureIntoBuffer(dtype, &step, &out)) {
+          return step_error("Can't parse serialized SequenceExample.");
+        }
+        const size_t num_values =
+            NumValuesInBuffer(out, dtype) - num_values_before;
+        if (is_dense && num_values != config.dense[d].elements_per_step) {
+          return errors::InvalidArgument(
+              "Name: ", example_name, ", Key: ", feature_list_name,
+              ", Index: ", t, ".  Number of ",
+              (dtype == DT_STRING ? "bytes" : DataTypeString(dtype)),
+              " values != expected.  values size: ", num_values,
+              " but output shape: ", config.dense[d].shape.DebugString());
+        }
+      }
+      out.example_end_indices.push_back(NumValuesInBuffer(out, dtype));
+    }
+  }
+
+  for (size_t d = 0; d < config.dense.size(); ++d) {
+    if (!dense_feature_list_found[d] &&
+        !config.dense[d].missing_assumed_empty) {
+      return errors::InvalidArgument(
+          "Name: ", example_name, ", Feature list '",
+          config.dense[d].feature_name,
+          "' is required but could not be found.  "
+          "Did you mean to include it in "
+          "feature_list_dense_missing_assumed_empty or "
+          "feature_list_dense_defaults?");
+    }
+    FeatureListBuffer& out = (*output_dense)[d];
+    out.example_end_steps.push_back(out.steps.example_end_indices.size());
+  }
+  for (size_t d = 0; d < config.sparse.size(); ++d) {
+    FeatureListBuffer& out = (*output_sparse)[d];
+    out.example_end_steps.push_back(out.steps.example_end_indices.size());
+  }
+
+  return Status::OK();
+}
+
+// Copies the steps of every example in buffers into its row of values,
+// leaving T() as padding after the last step, and sets lengths to the number
+// of steps of each example.
+template <typename T>
+void FillAndCopyFeatureList(
+    const size_t d, const size_t max_num_steps, const size_t elements_per_step,
+    const std::vector<std::vector<FeatureListBuffer>>& buffers, Tensor* values,
+    Tensor* lengths) {
+  T* data = values->flat<T>().data();
+  std::fill(data, data + values->NumElements(), T());
+  auto lengths_t = lengths->flat<int64>();
+  const size_t example_stride = max_num_steps * elements_per_step;
+
+  size_t example_index = 0;
+  for (const std::vector<FeatureListBuffer>& minibatch_buffers : buffers) {
+    const FeatureListBuffer& buffer = minibatch_buffers[d];
+    const auto& list = GetListFromBuffer<T>(buffer.steps);
+    const std::vector<size_t>& step_end_indices =
+        buffer.steps.example_end_indices;
+    size_t first_step = 0;
+    for (const size_t end_step : buffer.example_end_steps) {
+      const size_t begin =
+          first_step == 0 ? 0 : step_end_indices[first_step - 1];
+      const size_t end = end_step == 0 ? 0 : step_end_indices[end_step - 1];
+      CopyOrMoveBlock(list.begin() + begin, list.begin() + end,
+                      data + example_index * example_stride);
+      lengths_t(example_index) = end_step - first_step;
+      first_step = end_step;
+      ++example_index;
+    }
+  }
+}
+
 }  // namespace
 
 Status FastParseExample(const Config& config,
@@ -848,30 +1173,10 @@ Status FastParseExample(const Config& config,
     TF_RETURN_IF_ERROR(CheckConfigDataType(c.dtype));
   }
 
-  size_t config_size = config.dense.size() + config.sparse.size();
   SeededHasher hasher;
-  // Build config index.
-  PresizedCuckooMap<std::pair<size_t, Type>> config_index(config_size);
-  bool ok = true;
-  for (size_t i = 0; i < 1000; ++i) {
-    for (size_t d = 0; d < config.dense.size(); ++d) {
-      ok &= config_index.InsertUnique(hasher(config.dense[d].feature_name),
-                                      {d, Type::Dense});
-    }
-    for (size_t d = 0; d < config.sparse.size(); ++d) {
-      ok &= config_index.InsertUnique(hasher(config.sparse[d].feature_name),
-                                      {d, Type::Sparse});
-    }
-    if (ok) break;
-    LOG(WARNING) << "Collision found. This should happen only if you have "
-                    "around 2^32 entries in your config.";
-    hasher.seed++;
-    config_index.Clear(config_size);
-  }
-  if (!ok) {
-    return errors::Internal(
-        "Could not avoid collision. This should not happen.");
-  }
+  PresizedCuckooMap<std::pair<size_t, Type>> config_index(
+      config.dense.size() + config.sparse.size());
+  TF_RETURN_IF_ERROR(BuildConfigIndex(config, &hasher, &config_index));
 
   // Allocate dense output for fixed length dense values
   // (variable-length dense and sparse have to be buffered).
@@ -886,30 +1191,7 @@ Status FastParseExample(const Config& config,
     fixed_dense_values[d] = Tensor(config.dense[d].dtype, out_shape);
   }
 
-  // This parameter affects performance in a big and data-dependent way.
-  const size_t kMiniBatchSizeBytes = 50000;
-
-  // Calculate number of minibatches.
-  // In main regime make each minibatch around kMiniBatchSizeBytes bytes.
-  // Apply 'special logic' below for small and big regimes.
-  const size_t num_minibatches = [&] {
-    size_t result = 0;
-    size_t minibatch_bytes = 0;
-    for (size_t i = 0; i < serialized.size(); i++) {
-      if (minibatch_bytes == 0) {  // start minibatch
-        result++;
-      }
-      minibatch_bytes += serialized[i].size() + 1;
-      if (minibatch_bytes > kMiniBatchSizeBytes) {
-        minibatch_bytes = 0;
-      }
-    }
-    // 'special logic'
-    const size_t min_minibatches = std::min<size_t>(8, serialized.size());
-    const size_t max_minibatches = 64;
-    return std::max<size_t>(min_minibatches,
-                            std::min<size_t>(max_minibatches, result));
-  }();
+  const size_t num_minibatches = NumMiniBatches(serialized);
 
   auto first_example_of_minibatch = [&](size_t minibatch) -> size_t {
     return (serialized.size() * minibatch) / num_minibatches;
@@ -1098,5 +1380,197 @@ Status FastParseExample(const Config& config,
   return Status::OK();
 }
 
+Status FastParseSequenceExample(
+    const FastParseExampleConfig& context_config,
+    const FastParseFeatureListConfig& feature_list_config,
+    gtl::ArraySlice<string> serialized, gtl::ArraySlice<string> example_names,
+    thread::ThreadPool* thread_pool, Result* context_result,
+    FeatureListResult* feature_list_result) {
+  DCHECK(context_result != nullptr);
+  DCHECK(feature_list_result != nullptr);
+  TF_RETURN_IF_ERROR(FastParseExample(context_config, serialized,
+                                      example_names, thread_pool,
+                                      context_result));
+
+  const FeatureListConfig& config = feature_list_config;
+  for (auto& c : config.sparse) {
+    TF_RETURN_IF_ERROR(CheckConfigDataType(c.dtype));
+  }
+  for (auto& c : config.dense) {
+    TF_RETURN_IF_ERROR(CheckConfigDataType(c.dtype));
+  }
+
+  SeededHasher hasher;
+  PresizedCuckooMap<std::pair<size_t, Type>> config_index(
+      config.dense.size() + config.sparse.size());
+  TF_RETURN_IF_ERROR(BuildConfigIndex(config, &hasher, &config_index));
+
+  const size_t num_minibatches = NumMiniBatches(serialized);
+  auto first_example_of_minibatch = [&](size_t minibatch) -> size_t {
+    return (serialized.size() * minibatch) / num_minibatches;
+  };
+
+  // Do minibatches in parallel.
+  std::vector<std::vector<FeatureListBuffer>> dense_buffers(num_minibatches);
+  std::vector<std::vector<FeatureListBuffer>> sparse_buffers(num_minibatches);
+  std::vector<Status> status_of_minibatch(num_minibatches);
+  auto ProcessMiniBatch = [&](size_t minibatch) {
+    dense_buffers[minibatch].resize(config.dense.size());
+    sparse_buffers[minibatch].resize(config.sparse.size());
+    size_t start = first_example_of_minibatch(minibatch);
+    size_t end = first_example_of_minibatch(minibatch + 1);
+    for (size_t e = start; e < end; ++e) {
+      status_of_minibatch[minibatch] = FastParseSerializedFeatureLists(
+          serialized[e],
+          (!example_names.empty() ? example_names[e] : "<unknown>"), config,
+          config_index, hasher, &dense_buffers[minibatch],
+          &sparse_buffers[minibatch]);
+      if (!status_of_minibatch[minibatch].ok()) break;
+    }
+  };
+
+  ParallelFor(ProcessMiniBatch, num_minibatches, thread_pool);
+
+  for (Status& status : status_of_minibatch) {
+    TF_RETURN_IF_ERROR(status);
+  }
+
+  const size_t batch_size = serialized.size();
+
+  // Pad the dense feature lists of all examples to the same number of steps.
+  for (size_t d = 0; d < config.dense.size(); ++d) {
+    size_t max_num_steps = 0;
+    for (const auto& minibatch_buffers : dense_buffers) {
+      size_t first_step = 0;
+      for (const size_t end_step : minibatch_buffers[d].example_end_steps) {
+        max_num_steps = std::max(max_num_steps, end_step - first_step);
+        first_step = end_step;
+      }
+    }
+
+    TensorShape values_shape({static_cast<int64>(batch_size),
+                              static_cast<int64>(max_num_steps)});
+    for (const int64 dim : config.dense[d].shape.dim_sizes()) {
+      values_shape.AddDim(dim);
+    }
+    Tensor values(config.dense[d].dtype, values_shape);
+    Tensor lengths(DT_INT64, TensorShape({static_cast<int64>(batch_size)}));
+    const size_t elements_per_step = config.dense[d].elements_per_step;
+
+    switch (config.dense[d].dtype) {
+      case DT_INT64: {
+        FillAndCopyFeatureList<int64>(d, max_num_steps, elements_per_step,
+                                      dense_buffers, &values, &lengths);
+        break;
+      }
+      case DT_FLOAT: {
+        FillAndCopyFeatureList<float>(d, max_num_steps, elements_per_step,
+                                      dense_buffers, &values, &lengths);
+        break;
+      }
+      case DT_STRING: {
+        FillAndCopyFeatureList<string>(d, max_num_steps, elements_per_step,
+                                       dense_buffers, &values, &lengths);
+        break;
+      }
+      default:
+        CHECK(false) << "Should not happen.";
+    }
+    feature_list_result->dense_values.push_back(std::move(values));
+    feature_list_result->dense_lengths.push_back(std::move(lengths));
+  }
+
+  // Merge the sparse feature lists from all minibatches.
+  for (size_t d = 0; d < config.sparse.size(); ++d) {
+    size_t total_num_values = 0;
+    size_t max_num_steps = 0;
+    size_t max_num_values = 0;
+    for (const auto& minibatch_buffers : sparse_buffers) {
+      const FeatureListBuffer& buffer = minibatch_buffers[d];
+      const std::vector<size_t>& step_end_indices =
+          buffer.steps.example_end_indices;
+      if (!step_end_indices.empty()) {
+        total_num_values += step_end_indices.back();
+      }
+      size_t first_step = 0;
+      for (const size_t end_step : buffer.example_end_steps) {
+        max_num_steps = std::max(max_num_steps, end_step - first_step);
+        first_step = end_step;
+      }
+      size_t step_begin = 0;
+      for (const size_t step_end : step_end_indices) {
+        max_num_values = std::max(max_num_values, step_end - step_begin);
+        step_begin = step_end;
+      }
+    }
+
+    feature_list_result->sparse_indices.emplace_back(
+        DT_INT64, TensorShape({static_cast<int64>(total_num_values), 3}));
+    auto indices_t = feature_list_result->sparse_indices.back().matrix<int64>();
+    feature_list_result->sparse_values.emplace_back(
+        config.sparse[d].dtype,
+        TensorShape({static_cast<int64>(total_num_values)}));
+    Tensor* values = &feature_list_result->sparse_values.back();
+    feature_list_result->sparse_shapes.emplace_back(DT_INT64,
+                                                    TensorShape({3}));
+    auto shapes_t = feature_list_result->sparse_shapes.back().vec<int64>();
+    shapes_t(0) = batch_size;
+    shapes_t(1) = max_num_steps;
+    shapes_t(2) = max_num_values;
+
+    size_t offset = 0;
+    for (size_t i = 0; i < sparse_buffers.size(); ++i) {
+      FeatureListBuffer& buffer = sparse_buffers[i][d];
+      const std::vector<size_t>& step_end_indices =
+          buffer.steps.example_end_indices;
+
+      // Update indices.
+      size_t example_index = first_example_of_minibatch(i);
+      size_t value = 0;
+      size_t first_step = 0;
+      for (const size_t end_step : buffer.example_end_steps) {
+        for (size_t s = first_step; s < end_step; ++s) {
+          for (size_t value_index = 0; value < step_end_indices[s];
+               ++value, ++value_index) {
+            indices_t(offset + value, 0) = example_index;
+            indices_t(offset + value, 1) = s - first_step;
+            indices_t(offset + value, 2) = value_index;
+          }
+        }
+        first_step = end_step;
+        ++example_index;
+      }
+
+      // Copy values over.
+      switch (config.sparse[d].dtype) {
+        case DT_INT64: {
+          std::copy(buffer.steps.int64_list.begin(),
+                    buffer.steps.int64_list.end(),
+                    values->flat<int64>().data() + offset);
+          break;
+        }
+        case DT_FLOAT: {
+          std::copy(buffer.steps.float_list.begin(),
+                    buffer.steps.float_list.end(),
+                    values->flat<float>().data() + offset);
+          break;
+        }
+        case DT_STRING: {
+          std::move(buffer.steps.bytes_list.begin(),
+                    buffer.steps.bytes_list.end(),
+                    values->flat<string>().data() + offset);
+          break;
+        }
+        default:
+          CHECK(false) << "Should not happen.";
+      }
+
+      offset += value;
+    }
+  }
+
+  return Status::OK();
+}
+
 }  // namespace example
 }  // namespace tensorflow
@@ -79,6 +79,60 @@ Status FastParseExample(const FastParseExampleConfig& config,
                         gtl::ArraySlice<string> example_names,
                         thread::ThreadPool* thread_pool, Result* result);
 
+// FastParseFeatureListConfig defines how to parse the feature lists of a
+// SequenceExample, the same way FastParseExampleConfig does for the features
+// of an Example. Every step of a dense feature list has to hold exactly
+// elements_per_step values of the given shape, while the steps of a sparse
+// feature list may hold any number of values, none included.
+struct FastParseFeatureListConfig {
+  struct Dense {
+    string feature_name;
+    DataType dtype;
+    // Shape of the values of each step.
+    TensorShape shape;
+    // Whether a missing feature list is parsed as one with no steps, rather
+    // than as an error.
+    bool missing_assumed_empty;
+    std::size_t elements_per_step;
+  };
+
+  struct Sparse {
+    string feature_name;
+    DataType dtype;
+  };
+
+  std::vector<Dense> dense;
+  std::vector<Sparse> sparse;
+};
+
+// The feature lists of a batch of SequenceExample protos.
+// Dense feature lists are [batch_size, max_num_steps] + shape, padded with
+// zeros or empty strings after the last step of each example, and
+// dense_lengths holds the number of steps of each example as a [batch_size]
+// int64 vector.
+// Sparse feature lists have [num_values, 3] indices of (example, step, value
+// in step), and [batch_size, max_num_steps, max_num_values_per_step] shapes.
+struct FeatureListResult {
+  std::vector<Tensor> sparse_indices;
+  std::vector<Tensor> sparse_values;
+  std::vector<Tensor> sparse_shapes;
+  std::vector<Tensor> dense_values;
+  std::vector<Tensor> dense_lengths;
+};
+
+// Parses a batch of serialized SequenceExample protos. Their contexts are
+// parsed into context_result by FastParseExample, according to
+// context_config, and their feature lists into feature_list_result,
+// according to feature_list_config. Like FastParseExample, it splits the
+// batch into minibatches, which are parsed in parallel on thread_pool.
+// example_names have the same meaning as for FastParseExample.
+Status FastParseSequenceExample(
+    const FastParseExampleConfig& context_config,
+    const FastParseFeatureListConfig& feature_list_config,
+    gtl::ArraySlice<string> serialized, gtl::ArraySlice<string> example_names,
+    thread::ThreadPool* thread_pool, Result* context_result,
+    FeatureListResult* feature_list_result);
+
 // This function parses serialized Example and populates given example.
 // It uses the same specialized parser as FastParseExample which is efficient.
 // But then constructs Example which is relatively slow.
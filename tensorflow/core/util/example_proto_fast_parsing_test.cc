@@ -16,6 +16,9 @@ limitations under the License.
 
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/random/philox_random.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/platform/protobuf.h"
@@ -372,6 +375,192 @@ TEST(TestFastParseExample, Empty) {
   EXPECT_TRUE(status.ok()) << status;
 }
 
+void AddFloatStep(std::initializer_list<float> values, FeatureList* list) {
+  auto* float_list = list->add_feature()->mutable_float_list();
+  for (float value : values) float_list->add_value(value);
+}
+
+void AddInt64Step(std::initializer_list<int64> values, FeatureList* list) {
+  auto* int64_list = list->add_feature()->mutable_int64_list();
+  for (int64 value : values) int64_list->add_value(value);
+}
+
+std::vector<string> MakeSerializedSequenceExamples() {
+  SequenceExample first;
+  auto& first_context = *first.mutable_context()->mutable_feature();
+  first_context["length"].mutable_int64_list()->add_value(3);
+  first_context["tags"].mutable_bytes_list()->add_value("a");
+  first_context["tags"].mutable_bytes_list()->add_value("b");
+  auto& first_lists = *first.mutable_feature_lists()->mutable_feature_list();
+  AddFloatStep({1, 2}, &first_lists["frames"]);
+  AddFloatStep({3, 4}, &first_lists["frames"]);
+  AddFloatStep({5, 6}, &first_lists["frames"]);
+  AddInt64Step({7}, &first_lists["ids"]);
+  first_lists["ids"].add_feature();
+  AddInt64Step({8, 9}, &first_lists["ids"]);
+
+  SequenceExample second;
+  (*second.mutable_context()->mutable_feature())["length"]
+      .mutable_int64_list()
+      ->add_value(1);
+  auto& second_lists = *second.mutable_feature_lists()->mutable_feature_list();
+  AddFloatStep({10, 11}, &second_lists["frames"]);
+
+  return {Serialize(first), Serialize(second)};
+}
+
+void MakeSequenceExampleConfigs(FastParseExampleConfig* context_config,
+                                FastParseFeatureListConfig* config) {
+  Tensor no_default;
+  context_config->dense.push_back(
+      {"length", DT_INT64, PartialTensorShape({}), no_default, false, 1});
+  context_config->sparse.push_back({"tags", DT_STRING});
+  config->dense.push_back(
+      {"frames", DT_FLOAT, TensorShape({2}), false /* missing_assumed_empty */,
+       2});
+  config->sparse.push_back({"ids", DT_INT64});
+}
+
+TEST(TestFastParseSequenceExample, ContextAndFeatureLists) {
+  const std::vector<string> serialized = MakeSerializedSequenceExamples();
+  FastParseExampleConfig context_config;
+  FastParseFeatureListConfig config;
+  MakeSequenceExampleConfigs(&context_config, &config);
+
+  Result context_result;
+  FeatureListResult result;
+  TF_ASSERT_OK(FastParseSequenceExample(context_config, config, serialized,
+                                        gtl::ArraySlice<string>(), nullptr,
+                                        &context_result, &result));
+
+  test::ExpectTensorEqual<int64>(context_result.dense_values[0],
+                                 test::AsTensor<int64>({3, 1}));
+  test::ExpectTensorEqual<int64>(context_result.sparse_indices[0],
+                                 test::AsTensor<int64>({0, 0, 0, 1}, {2, 2}));
+  test::ExpectTensorEqual<string>(context_result.sparse_values[0],
+                                  test::AsTensor<string>({"a", "b"}));
+
+  test::ExpectTensorEqual<float>(
+      result.dense_values[0],
+      test::AsTensor<float>({1, 2, 3, 4, 5, 6, 10, 11, 0, 0, 0, 0},
+                            {2, 3, 2}));
+  test::ExpectTensorEqual<int64>(result.dense_lengths[0],
+                                 test::AsTensor<int64>({3, 1}));
+
+  test::ExpectTensorEqual<int64>(
+      result.sparse_indices[0],
+      test::AsTensor<int64>({0, 0, 0, 0, 2, 0, 0, 2, 1}, {3, 3}));
+  test::ExpectTensorEqual<int64>(result.sparse_values[0],
+                                 test::AsTensor<int64>({7, 8, 9}));
+  test::ExpectTensorEqual<int64>(result.sparse_shapes[0],
+                                 test::AsTensor<int64>({2, 3, 2}));
+}
+
+TEST(TestFastParseSequenceExample, ManyMinibatches) {
+  const std::vector<string> examples = MakeSerializedSequenceExamples();
+  std::vector<string> serialized;
+  for (int i = 0; i < 100; ++i) {
+    serialized.push_back(examples[i % 2]);
+  }
+  FastParseExampleConfig context_config;
+  FastParseFeatureListConfig config;
+  MakeSequenceExampleConfigs(&context_config, &config);
+
+  thread::ThreadPool thread_pool(Env::Default(), "test", 4);
+  Result context_result;
+  FeatureListResult result;
+  TF_ASSERT_OK(FastParseSequenceExample(context_config, config, serialized,
+                                        gtl::ArraySlice<string>(),
+                                        &thread_pool, &context_result,
+                                        &result));
+
+  ASSERT_EQ(TensorShape({100, 3, 2}), result.dense_values[0].shape());
+  auto lengths_t = result.dense_lengths[0].vec<int64>();
+  auto values_t = result.dense_values[0].tensor<float, 3>();
+  for (int e = 0; e < 100; ++e) {
+    EXPECT_EQ(e % 2 == 0 ? 3 : 1, lengths_t(e));
+    EXPECT_EQ(e % 2 == 0 ? 1 : 10, values_t(e, 0, 0));
+    EXPECT_EQ(e % 2 == 0 ? 6 : 0, values_t(e, 2, 1));
+  }
+  ASSERT_EQ(TensorShape({150, 3}), result.sparse_indices[0].shape());
+  auto indices_t = result.sparse_indices[0].matrix<int64>();
+  EXPECT_EQ(98, indices_t(147, 0));
+  EXPECT_EQ(2, indices_t(149, 1));
+  EXPECT_EQ(1, indices_t(149, 2));
+}
+
+TEST(TestFastParseSequenceExample, MissingDenseFeatureList) {
+  SequenceExample example;
+  (*example.mutable_context()->mutable_feature())["length"]
+      .mutable_int64_list()
+      ->add_value(0);
+  const std::vector<string> serialized = {Serialize(example)};
+  const std::vector<string> names = {"in0"};
+  FastParseExampleConfig context_config;
+  FastParseFeatureListConfig config;
+  MakeSequenceExampleConfigs(&context_config, &config);
+
+  {
+    Result context_result;
+    FeatureListResult result;
+    Status status =
+        FastParseSequenceExample(context_config, config, serialized, names,
+                                 nullptr, &context_result, &result);
+    EXPECT_TRUE(StringPiece(status.error_message())
+                    .contains("Name: in0, Feature list 'frames' is required"))
+        << status;
+  }
+
+  config.dense[0].missing_assumed_empty = true;
+  Result context_result;
+  FeatureListResult result;
+  TF_ASSERT_OK(FastParseSequenceExample(context_config, config, serialized,
+                                        names, nullptr, &context_result,
+                                        &result));
+  EXPECT_EQ(TensorShape({1, 0, 2}), result.dense_values[0].shape());
+  test::ExpectTensorEqual<int64>(result.dense_lengths[0],
+                                 test::AsTensor<int64>({0}));
+  test::ExpectTensorEqual<int64>(result.sparse_shapes[0],
+                                 test::AsTensor<int64>({1, 0, 0}));
+}
+
+TEST(TestFastParseSequenceExample, InvalidSteps) {
+  FastParseExampleConfig context_config;
+  FastParseFeatureListConfig config;
+  MakeSequenceExampleConfigs(&context_config, &config);
+  context_config.dense.clear();
+
+  SequenceExample wrong_size;
+  auto& wrong_size_lists =
+      *wrong_size.mutable_feature_lists()->mutable_feature_list();
+  AddFloatStep({1, 2}, &wrong_size_lists["frames"]);
+  AddFloatStep({3, 4, 5}, &wrong_size_lists["frames"]);
+
+  SequenceExample wrong_type;
+  auto& wrong_type_lists =
+      *wrong_type.mutable_feature_lists()->mutable_feature_list();
+  AddFloatStep({1, 2}, &wrong_type_lists["frames"]);
+  AddFloatStep({3}, &wrong_type_lists["ids"]);
+
+  const std::vector<std::pair<SequenceExample, string>> cases = {
+      {wrong_size,
+       "Key: frames, Index: 1.  Number of float values != expected.  "
+       "values size: 3 but output shape: [2]"},
+      {wrong_type,
+       "Feature list: ids, Index: 0.  Data types don't match. "
+       "Expected type: int64"},
+  };
+  for (const auto& c : cases) {
+    Result context_result;
+    FeatureListResult result;
+    Status status = FastParseSequenceExample(
+        context_config, config, {Serialize(c.first)},
+        gtl::ArraySlice<string>(), nullptr, &context_result, &result);
+    EXPECT_TRUE(StringPiece(status.error_message()).contains(c.second))
+        << status;
+  }
+}
+
 }  // namespace
 
 }  // namespace example
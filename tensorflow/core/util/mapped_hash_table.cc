@@ -0,0 +1,360 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/mapped_hash_table.h"
+
+#include <cstring>
+
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/hash/hash.h"
+
+namespace tensorflow {
+
+namespace {
+
+// "TFMHTBL1", read as a little-endian integer.
+const uint64 kMagic = 0x314c4254484d4654ULL;
+const uint32 kVersion = 1;
+
+bool IsSupportedKeyType(DataType dtype) {
+  return dtype == DT_STRING || dtype == DT_INT64 || dtype == DT_INT32;
+}
+
+bool IsSupportedValueType(DataType dtype) {
+  return dtype == DT_STRING || dtype == DT_INT64 || dtype == DT_INT32 ||
+         dtype == DT_BOOL || dtype == DT_DOUBLE || dtype == DT_FLOAT;
+}
+
+bool IsFloatingPoint(DataType dtype) {
+  return dtype == DT_DOUBLE || dtype == DT_FLOAT;
+}
+
+uint64 DoubleBits(double value) {
+  uint64 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+}  // namespace
+
+uint64 MappedHashTableReader::Hash(StringPiece key) {
+  return Hash64(key.data(), key.size());
+}
+
+uint64 MappedHashTableReader::Hash(int64 key) {
+  return Hash64(reinterpret_cast<const char*>(&key), sizeof(key));
+}
+
+Status MappedHashTableReader::Open(
+    Env* env, const string& filename,
+    std::unique_ptr<MappedHashTableReader>* reader) {
+  std::unique_ptr<MappedHashTableReader> r(new MappedHashTableReader);
+  TF_RETURN_IF_ERROR(
+      env->NewReadOnlyMemoryRegionFromFile(filename, &r->region_));
+  const char* data = static_cast<const char*>(r->region_->data());
+  const uint64 length = r->region_->length();
+  if (length < sizeof(MappedHashTableHeader)) {
+    return errors::DataLoss("Mapped hash table ", filename, " is truncated");
+  }
+  const MappedHashTableHeader* header =
+      reinterpret_cast<const MappedHashTableHeader*>(data);
+  if (header->magic != kMagic) {
+    return errors::DataLoss(filename, " is not a mapped hash table");
+  }
+  if (header->version != kVersion) {
+    return errors::Unimplemented("Mapped hash table ", filename,
+                                 " has unsupported version ", header->version);
+  }
+  const DataType key_dtype = static_cast<DataType>(header->key_dtype);
+  const DataType value_dtype = static_cast<DataType>(header->value_dtype);
+  if (!IsSupportedKeyType(key_dtype) || !IsSupportedValueType(value_dtype)) {
+    return errors::DataLoss("Mapped hash table ", filename,
+                            " has unsupported key or value types ",
+                            header->key_dtype, " and ", header->value_dtype);
+  }
+  const uint64 num_buckets = header->num_buckets;
+  if (num_buckets == 0 || (num_buckets & (num_buckets - 1)) != 0 ||
+      header->num_entries > num_buckets) {
+    return errors::DataLoss("Mapped hash table ", filename,
+                            " has an invalid number of buckets ", num_buckets);
+  }
+  if (header->buckets_offset % alignof(MappedHashTableBucket) != 0 ||
+      header->buckets_offset > length ||
+      num_buckets > (length - header->buckets_offset) /
+                        sizeof(MappedHashTableBucket) ||
+      header->strings_offset > length ||
+      header->strings_size > length - header->strings_offset) {
+    return errors::DataLoss("Mapped hash table ", filename,
+                            " is truncated or corrupted");
+  }
+  r->header_ = header;
+  r->buckets_ = reinterpret_cast<const MappedHashTableBucket*>(
+      data + header->buckets_offset);
+  r->strings_ = data + header->strings_offset;
+  r->key_dtype_ = key_dtype;
+  r->value_dtype_ = value_dtype;
+  *reader = std::move(r);
+  return Status::OK();
+}
+
+Status MappedHashTableReader::GetString(uint64 offset, uint32 size,
+                                        StringPiece* value) const {
+  if (offset > header_->strings_size ||
+      size > header_->strings_size - offset) {
+    return errors::DataLoss("Mapped hash table string out of bounds");
+  }
+  *value = StringPiece(strings_ + offset, size);
+  return Status::OK();
+}
+
+Status MappedHashTableReader::Find(StringPiece key,
+                                   const MappedHashTableBucket** bucket) const {
+  return FindWithHash(key, Hash(key), bucket);
+}
+
+Status MappedHashTableReader::Find(int64 key,
+                                   const MappedHashTableBucket** bucket) const {
+  return FindWithHash(key, Hash(key), bucket);
+}
+
+Status MappedHashTableReader::FindWithHash(
+    StringPiece key, uint64 key_hash,
+    const MappedHashTableBucket** bucket) const {
+  if (key_dtype_ != DT_STRING) {
+    return errors::InvalidArgument("Expected ", DataTypeString(key_dtype_),
+                                   " keys, got a string");
+  }
+  const uint64 bit_mask = header_->num_buckets - 1;
+  uint64 index = key_hash & bit_mask;
+  for (uint64 i = 0; i < header_->num_buckets; ++i) {
+    const MappedHashTableBucket& b = buckets_[index];
+    if (b.key_size == MappedHashTableBucket::kEmptyBucket) break;
+    if (b.key_hash == key_hash) {
+      StringPiece bucket_key;
+      TF_RETURN_IF_ERROR(GetString(b.key, b.key_size, &bucket_key));
+      if (bucket_key == key) {
+        *bucket = &b;
+        return Status::OK();
+      }
+    }
+    index = (index + 1) & bit_mask;
+  }
+  *bucket = nullptr;
+  return Status::OK();
+}
+
+Status MappedHashTableReader::FindWithHash(
+    int64 key, uint64 key_hash, const MappedHashTableBucket** bucket) const {
+  if (key_dtype_ == DT_STRING) {
+    return errors::InvalidArgument("Expected string keys, got an integer");
+  }
+  const uint64 bit_mask = header_->num_buckets - 1;
+  uint64 index = key_hash & bit_mask;
+  for (uint64 i = 0; i < header_->num_buckets; ++i) {
+    const MappedHashTableBucket& b = buckets_[index];
+    if (b.key_size == MappedHashTableBucket::kEmptyBucket) break;
+    if (b.key == static_cast<uint64>(key)) {
+      *bucket = &b;
+      return Status::OK();
+    }
+    index = (index + 1) & bit_mask;
+  }
+  *bucket = nullptr;
+  return Status::OK();
+}
+
+double MappedHashTableReader::DoubleValue(
+    const MappedHashTableBucket& bucket) const {
+  double value;
+  memcpy(&value, &bucket.value, sizeof(value));
+  return value;
+}
+
+Status MappedHashTableReader::StringValue(const MappedHashTableBucket& bucket,
+                                          StringPiece* value) const {
+  return GetString(bucket.value, bucket.value_size, value);
+}
+
+Status MappedHashTableWriter::Create(
+    DataType key_dtype, DataType value_dtype,
+    std::unique_ptr<MappedHashTableWriter>* writer) {
+  if (!IsSupportedKeyType(key_dtype)) {
+    return errors::InvalidArgument("Unsupported mapped hash table key type ",
+                                   DataTypeString(key_dtype));
+  }
+  if (!IsSupportedValueType(value_dtype)) {
+    return errors::InvalidArgument("Unsupported mapped hash table value type ",
+                                   DataTypeString(value_dtype));
+  }
+  writer->reset(new MappedHashTableWriter(key_dtype, value_dtype));
+  return Status::OK();
+}
+
+Status MappedHashTableWriter::Add(const Tensor& keys, const Tensor& values) {
+  if (keys.dtype() != key_dtype_ || values.dtype() != value_dtype_) {
+    return errors::InvalidArgument(
+        "Expected keys and values of types ", DataTypeString(key_dtype_),
+        " and ", DataTypeString(value_dtype_), ", got ",
+        DataTypeString(keys.dtype()), " and ", DataTypeString(values.dtype()));
+  }
+  if (!keys.shape().IsSameSize(values.shape())) {
+    return errors::InvalidArgument(
+        "Expected keys and values of the same shape, got shapes ",
+        keys.shape().DebugString(), " and ", values.shape().DebugString());
+  }
+  const int64 num_entries = keys.NumElements();
+  entries_.reserve(entries_.size() + num_entries);
+  for (int64 i = 0; i < num_entries; ++i) {
+    MappedHashTableBucket entry;
+    entry.key_size = 0;
+    entry.value_size = 0;
+    switch (key_dtype_) {
+      case DT_STRING: {
+        const string& key = keys.flat<string>()(i);
+        if (key.size() >= MappedHashTableBucket::kEmptyBucket) {
+          return errors::InvalidArgument("Key of ", key.size(),
+                                         " bytes is too long");
+        }
+        entry.key_hash = MappedHashTableReader::Hash(key);
+        entry.key = strings_.size();
+        entry.key_size = key.size();
+        strings_.append(key);
+        break;
+      }
+      case DT_INT64:
+        entry.key_hash = MappedHashTableReader::Hash(keys.flat<int64>()(i));
+        entry.key = keys.flat<int64>()(i);
+        break;
+      default:
+        entry.key_hash = MappedHashTableReader::Hash(
+            static_cast<int64>(keys.flat<int32>()(i)));
+        entry.key = static_cast<int64>(keys.flat<int32>()(i));
+        break;
+    }
+    switch (value_dtype_) {
+      case DT_STRING: {
+        const string& value = values.flat<string>()(i);
+        if (value.size() >= MappedHashTableBucket::kEmptyBucket) {
+          return errors::InvalidArgument("Value of ", value.size(),
+                                         " bytes is too long");
+        }
+        entry.value = strings_.size();
+        entry.value_size = value.size();
+        strings_.append(value);
+        break;
+      }
+      case DT_INT64:
+        entry.value = values.flat<int64>()(i);
+        break;
+      case DT_INT32:
+        entry.value = static_cast<int64>(values.flat<int32>()(i));
+        break;
+      case DT_BOOL:
+        entry.value = values.flat<bool>()(i) ? 1 : 0;
+        break;
+      case DT_DOUBLE:
+        entry.value = DoubleBits(values.flat<double>()(i));
+        break;
+      default:
+        entry.value = DoubleBits(values.flat<float>()(i));
+        break;
+    }
+    entries_.push_back(entry);
+  }
+  return Status::OK();
+}
+
+bool MappedHashTableWriter::KeysEqual(const MappedHashTableBucket& a,
+                                      const MappedHashTableBucket& b) const {
+  if (key_dtype_ == DT_STRING) {
+    return a.key_hash == b.key_hash &&
+           GetString(a.key, a.key_size) == GetString(b.key, b.key_size);
+  }
+  return a.key == b.key;
+}
+
+bool MappedHashTableWriter::ValuesEqual(const MappedHashTableBucket& a,
+                                        const MappedHashTableBucket& b) const {
+  if (value_dtype_ == DT_STRING) {
+    return GetString(a.value, a.value_size) == GetString(b.value, b.value_size);
+  }
+  if (IsFloatingPoint(value_dtype_)) {
+    double a_value, b_value;
+    memcpy(&a_value, &a.value, sizeof(a_value));
+    memcpy(&b_value, &b.value, sizeof(b_value));
+    return a_value == b_value;
+  }
+  return a.value == b.value;
+}
+
+Status MappedHashTableWriter::Finish(Env* env, const string& filename) {
+  uint64 num_buckets = 1;
+  while (num_buckets < 2 * entries_.size()) {
+    num_buckets <<= 1;
+  }
+  MappedHashTableBucket empty_bucket;
+  memset(&empty_bucket, 0, sizeof(empty_bucket));
+  empty_bucket.key_size = MappedHashTableBucket::kEmptyBucket;
+  std::vector<MappedHashTableBucket> buckets(num_buckets, empty_bucket);
+
+  const uint64 bit_mask = num_buckets - 1;
+  uint64 num_entries = 0;
+  for (const MappedHashTableBucket& entry : entries_) {
+    uint64 index = entry.key_hash & bit_mask;
+    while (true) {
+      MappedHashTableBucket& bucket = buckets[index];
+      if (bucket.key_size == MappedHashTableBucket::kEmptyBucket) {
+        bucket = entry;
+        ++num_entries;
+        break;
+      }
+      if (KeysEqual(bucket, entry)) {
+        if (!ValuesEqual(bucket, entry)) {
+          return errors::FailedPrecondition(
+              "Mapped hash table ", filename,
+              " has different values for the same key");
+        }
+        break;
+      }
+      index = (index + 1) & bit_mask;
+    }
+  }
+
+  MappedHashTableHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = kMagic;
+  header.version = kVersion;
+  header.key_dtype = key_dtype_;
+  header.value_dtype = value_dtype_;
+  header.num_entries = num_entries;
+  header.num_buckets = num_buckets;
+  header.buckets_offset = sizeof(header);
+  header.strings_offset =
+      header.buckets_offset + num_buckets * sizeof(MappedHashTableBucket);
+  header.strings_size = strings_.size();
+
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(filename, &file));
+  TF_RETURN_IF_ERROR(file->Append(
+      StringPiece(reinterpret_cast<const char*>(&header), sizeof(header))));
+  TF_RETURN_IF_ERROR(file->Append(
+      StringPiece(reinterpret_cast<const char*>(buckets.data()),
+                  num_buckets * sizeof(MappedHashTableBucket))));
+  TF_RETURN_IF_ERROR(file->Append(strings_));
+  return file->Close();
+}
+
+}  // namespace tensorflow
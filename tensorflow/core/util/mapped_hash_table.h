@@ -0,0 +1,186 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A file format for static hash tables that are used in place, from a read-only
+// memory mapping, rather than parsed into the heap. Opening a table is O(1),
+// and the pages of a table are shared by all the processes of a host that map
+// it.
+//
+// The file consists of:
+//  - A MappedHashTableHeader.
+//  - "num_buckets" (a power of 2) MappedHashTableBuckets, at "buckets_offset".
+//    Keys are placed by linear probing from "Hash(key) & (num_buckets - 1)",
+//    at a load factor of at most 1/2, so a lookup typically reads one or two
+//    consecutive buckets.
+//  - The bytes of the string keys and values, at "strings_offset".
+//
+// Integers are stored in the byte order of the host that wrote the file.
+//
+// Keys are strings or int64s. Values are int64s (also used for int32 and bool),
+// doubles (also used for float) or strings.
+
+#ifndef TENSORFLOW_CORE_UTIL_MAPPED_HASH_TABLE_H_
+#define TENSORFLOW_CORE_UTIL_MAPPED_HASH_TABLE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/macros.h"
+#include "tensorflow/core/platform/prefetch.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+
+struct MappedHashTableHeader {
+  uint64 magic;
+  uint32 version;
+  // The DataTypes of the keys and values.
+  uint32 key_dtype;
+  uint32 value_dtype;
+  uint32 reserved;
+  uint64 num_entries;
+  uint64 num_buckets;
+  uint64 buckets_offset;
+  uint64 strings_offset;
+  uint64 strings_size;
+};
+
+struct MappedHashTableBucket {
+  // MappedHashTableReader::Hash() of the key.
+  uint64 key_hash;
+  // The key if it is an int64, otherwise the offset of its bytes in the
+  // strings section.
+  uint64 key;
+  // The value if it is an int64 or the bits of a double, otherwise the offset
+  // of its bytes in the strings section.
+  uint64 value;
+  // The sizes of string keys and values. kEmptyBucket in empty buckets.
+  uint32 key_size;
+  uint32 value_size;
+
+  static const uint32 kEmptyBucket = ~0U;
+};
+
+// Reads a mapped hash table file.
+//
+// This class is thread-safe.
+class MappedHashTableReader {
+ public:
+  // Maps "filename", and checks its header.
+  static Status Open(Env* env, const string& filename,
+                     std::unique_ptr<MappedHashTableReader>* reader);
+
+  DataType key_dtype() const { return key_dtype_; }
+  DataType value_dtype() const { return value_dtype_; }
+  int64 size() const { return header_->num_entries; }
+
+  // Sets "*bucket" to the bucket holding "key", or to nullptr if the table
+  // doesn't contain it. Use the overload matching key_dtype().
+  Status Find(StringPiece key, const MappedHashTableBucket** bucket) const;
+  Status Find(int64 key, const MappedHashTableBucket** bucket) const;
+
+  // Like Find(), given the Hash() of "key".
+  Status FindWithHash(StringPiece key, uint64 key_hash,
+                      const MappedHashTableBucket** bucket) const;
+  Status FindWithHash(int64 key, uint64 key_hash,
+                      const MappedHashTableBucket** bucket) const;
+
+  // Prefetches the bucket that Find() starts probing at for a key of hash
+  // "key_hash", so that the lookups of a batch of keys hashed up front don't
+  // each wait for their bucket in turn.
+  void Prefetch(uint64 key_hash) const {
+    port::prefetch<port::PREFETCH_HINT_T0>(
+        &buckets_[key_hash & (header_->num_buckets - 1)]);
+  }
+
+  // The value of a bucket, for the respective value_dtype()s.
+  int64 Int64Value(const MappedHashTableBucket& bucket) const {
+    return static_cast<int64>(bucket.value);
+  }
+  double DoubleValue(const MappedHashTableBucket& bucket) const;
+  Status StringValue(const MappedHashTableBucket& bucket,
+                     StringPiece* value) const;
+
+  // The hashes the buckets are placed by.
+  static uint64 Hash(StringPiece key);
+  static uint64 Hash(int64 key);
+
+ private:
+  MappedHashTableReader() {}
+
+  // Returns the string of "size" bytes at "offset" of the strings section.
+  Status GetString(uint64 offset, uint32 size, StringPiece* value) const;
+
+  std::unique_ptr<ReadOnlyMemoryRegion> region_;
+  const MappedHashTableHeader* header_ = nullptr;
+  const MappedHashTableBucket* buckets_ = nullptr;
+  const char* strings_ = nullptr;
+  DataType key_dtype_;
+  DataType value_dtype_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MappedHashTableReader);
+};
+
+// Builds a mapped hash table file.
+//
+// Entries are accumulated in memory, and the file is laid out by Finish(). A
+// key may be added several times with the same value.
+class MappedHashTableWriter {
+ public:
+  // Supported key types: DT_STRING, DT_INT64 and DT_INT32. Supported value
+  // types: DT_STRING, DT_INT64, DT_INT32, DT_BOOL, DT_DOUBLE and DT_FLOAT.
+  static Status Create(DataType key_dtype, DataType value_dtype,
+                       std::unique_ptr<MappedHashTableWriter>* writer);
+
+  // Adds the entries "keys[i]" -> "values[i]". The tensors must have the same
+  // shape, and the writer's key and value types.
+  Status Add(const Tensor& keys, const Tensor& values);
+
+  // Writes the table to "filename".
+  Status Finish(Env* env, const string& filename);
+
+ private:
+  MappedHashTableWriter(DataType key_dtype, DataType value_dtype)
+      : key_dtype_(key_dtype), value_dtype_(value_dtype) {}
+
+  // Returns the string of a key or value in strings_.
+  StringPiece GetString(uint64 offset, uint32 size) const {
+    return StringPiece(strings_.data() + offset, size);
+  }
+
+  // Whether the keys or values of the buckets "a" and "b" are equal.
+  bool KeysEqual(const MappedHashTableBucket& a,
+                 const MappedHashTableBucket& b) const;
+  bool ValuesEqual(const MappedHashTableBucket& a,
+                   const MappedHashTableBucket& b) const;
+
+  const DataType key_dtype_;
+  const DataType value_dtype_;
+  // The entries added so far, as buckets.
+  std::vector<MappedHashTableBucket> entries_;
+  string strings_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(MappedHashTableWriter);
+};
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_UTIL_MAPPED_HASH_TABLE_H_
@@ -0,0 +1,160 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/mapped_hash_table.h"
+
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+string TablePath(const string& name) {
+  return io::JoinPath(testing::TmpDir(), name);
+}
+
+TEST(MappedHashTableTest, StringToInt64) {
+  const string path = TablePath("string_to_int64");
+  std::unique_ptr<MappedHashTableWriter> writer;
+  TF_ASSERT_OK(MappedHashTableWriter::Create(DT_STRING, DT_INT64, &writer));
+  std::vector<string> keys;
+  std::vector<int64> values;
+  for (int i = 0; i < 1000; ++i) {
+    keys.push_back(strings::StrCat("key", i));
+    values.push_back(i * 3);
+  }
+  TF_ASSERT_OK(writer->Add(test::AsTensor<string>(keys),
+                           test::AsTensor<int64>(values)));
+  TF_ASSERT_OK(writer->Finish(Env::Default(), path));
+
+  std::unique_ptr<MappedHashTableReader> reader;
+  TF_ASSERT_OK(MappedHashTableReader::Open(Env::Default(), path, &reader));
+  EXPECT_EQ(DT_STRING, reader->key_dtype());
+  EXPECT_EQ(DT_INT64, reader->value_dtype());
+  EXPECT_EQ(1000, reader->size());
+  for (int i = 0; i < 1000; ++i) {
+    const MappedHashTableBucket* bucket;
+    TF_ASSERT_OK(reader->Find(keys[i], &bucket));
+    ASSERT_NE(nullptr, bucket);
+    EXPECT_EQ(i * 3, reader->Int64Value(*bucket));
+  }
+  const MappedHashTableBucket* bucket;
+  TF_ASSERT_OK(reader->Find("missing", &bucket));
+  EXPECT_EQ(nullptr, bucket);
+  EXPECT_FALSE(reader->Find(int64{1}, &bucket).ok());
+}
+
+TEST(MappedHashTableTest, Int64ToString) {
+  const string path = TablePath("int64_to_string");
+  std::unique_ptr<MappedHashTableWriter> writer;
+  TF_ASSERT_OK(MappedHashTableWriter::Create(DT_INT64, DT_STRING, &writer));
+  TF_ASSERT_OK(writer->Add(test::AsTensor<int64>({-7, 0, 42}),
+                           test::AsTensor<string>({"a", "", "forty two"})));
+  TF_ASSERT_OK(writer->Finish(Env::Default(), path));
+
+  std::unique_ptr<MappedHashTableReader> reader;
+  TF_ASSERT_OK(MappedHashTableReader::Open(Env::Default(), path, &reader));
+  EXPECT_EQ(3, reader->size());
+  const MappedHashTableBucket* bucket;
+  StringPiece value;
+  TF_ASSERT_OK(reader->Find(42, &bucket));
+  ASSERT_NE(nullptr, bucket);
+  TF_ASSERT_OK(reader->StringValue(*bucket, &value));
+  EXPECT_EQ("forty two", value);
+  TF_ASSERT_OK(reader->Find(0, &bucket));
+  ASSERT_NE(nullptr, bucket);
+  TF_ASSERT_OK(reader->StringValue(*bucket, &value));
+  EXPECT_EQ("", value);
+  TF_ASSERT_OK(reader->Find(-7, &bucket));
+  ASSERT_NE(nullptr, bucket);
+  TF_ASSERT_OK(reader->StringValue(*bucket, &value));
+  EXPECT_EQ("a", value);
+  TF_ASSERT_OK(reader->Find(7, &bucket));
+  EXPECT_EQ(nullptr, bucket);
+}
+
+TEST(MappedHashTableTest, FloatValues) {
+  const string path = TablePath("string_to_float");
+  std::unique_ptr<MappedHashTableWriter> writer;
+  TF_ASSERT_OK(MappedHashTableWriter::Create(DT_STRING, DT_FLOAT, &writer));
+  TF_ASSERT_OK(writer->Add(test::AsTensor<string>({"pi", "e"}),
+                           test::AsTensor<float>({3.14f, 2.72f})));
+  TF_ASSERT_OK(writer->Finish(Env::Default(), path));
+
+  std::unique_ptr<MappedHashTableReader> reader;
+  TF_ASSERT_OK(MappedHashTableReader::Open(Env::Default(), path, &reader));
+  const MappedHashTableBucket* bucket;
+  TF_ASSERT_OK(reader->Find("pi", &bucket));
+  ASSERT_NE(nullptr, bucket);
+  EXPECT_EQ(3.14f, static_cast<float>(reader->DoubleValue(*bucket)));
+}
+
+TEST(MappedHashTableTest, EmptyTable) {
+  const string path = TablePath("empty");
+  std::unique_ptr<MappedHashTableWriter> writer;
+  TF_ASSERT_OK(MappedHashTableWriter::Create(DT_INT64, DT_INT64, &writer));
+  TF_ASSERT_OK(writer->Finish(Env::Default(), path));
+
+  std::unique_ptr<MappedHashTableReader> reader;
+  TF_ASSERT_OK(MappedHashTableReader::Open(Env::Default(), path, &reader));
+  EXPECT_EQ(0, reader->size());
+  const MappedHashTableBucket* bucket;
+  TF_ASSERT_OK(reader->Find(1, &bucket));
+  EXPECT_EQ(nullptr, bucket);
+}
+
+TEST(MappedHashTableTest, DuplicateKeys) {
+  std::unique_ptr<MappedHashTableWriter> writer;
+  TF_ASSERT_OK(MappedHashTableWriter::Create(DT_STRING, DT_INT64, &writer));
+  TF_ASSERT_OK(writer->Add(test::AsTensor<string>({"a", "b", "a"}),
+                           test::AsTensor<int64>({1, 2, 1})));
+  TF_ASSERT_OK(writer->Finish(Env::Default(), TablePath("duplicates")));
+
+  std::unique_ptr<MappedHashTableReader> reader;
+  TF_ASSERT_OK(MappedHashTableReader::Open(Env::Default(),
+                                           TablePath("duplicates"), &reader));
+  EXPECT_EQ(2, reader->size());
+
+  TF_ASSERT_OK(writer->Add(test::AsTensor<string>({"b"}),
+                           test::AsTensor<int64>({3})));
+  EXPECT_FALSE(writer->Finish(Env::Default(), TablePath("conflict")).ok());
+}
+
+TEST(MappedHashTableTest, InvalidInputs) {
+  std::unique_ptr<MappedHashTableWriter> writer;
+  EXPECT_FALSE(
+      MappedHashTableWriter::Create(DT_FLOAT, DT_INT64, &writer).ok());
+  TF_ASSERT_OK(MappedHashTableWriter::Create(DT_STRING, DT_INT64, &writer));
+  EXPECT_FALSE(writer
+                   ->Add(test::AsTensor<string>({"a", "b"}),
+                         test::AsTensor<int64>({1}))
+                   .ok());
+  EXPECT_FALSE(writer
+                   ->Add(test::AsTensor<string>({"a"}),
+                         test::AsTensor<int32>({1}))
+                   .ok());
+
+  const string path = TablePath("not_a_table");
+  TF_ASSERT_OK(WriteStringToFile(Env::Default(), path,
+                                 string(sizeof(MappedHashTableHeader), 'x')));
+  std::unique_ptr<MappedHashTableReader> reader;
+  EXPECT_FALSE(MappedHashTableReader::Open(Env::Default(), path, &reader).ok());
+}
+
+}  // namespace
+}  // namespace tensorflow
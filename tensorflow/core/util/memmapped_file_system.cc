@@ -234,6 +234,19 @@ Status MemmappedFileSystem::InitializeFromFile(Env* env,
   return Status::OK();
 }
 
+void MemmappedFileSystem::Prefault() const {
+  if (!mapped_memory_) return;
+  // Reading one byte per page is enough to fault the pages in, and works for
+  // any Env's memory regions.
+  static constexpr uint64 kPageSize = 4096;
+  const volatile uint8* memory =
+      reinterpret_cast<const volatile uint8*>(mapped_memory_->data());
+  const uint64 length = mapped_memory_->length();
+  for (uint64 offset = 0; offset < length; offset += kPageSize) {
+    (void)memory[offset];
+  }
+}
+
 bool MemmappedFileSystem::IsMemmappedPackageFilename(const string& filename) {
   return StringPiece(filename).starts_with(kMemmappedPackagePrefix);
 }
@@ -294,4 +307,13 @@ Status MemmappedEnv::InitializeFromFile(const string& package_filename) {
   return status;
 }
 
+Status MemmappedEnv::Prefault() {
+  if (!memmapped_file_system_) {
+    return errors::FailedPrecondition(
+        "MemmappedEnv is not initialized from a file.");
+  }
+  memmapped_file_system_->Prefault();
+  return Status::OK();
+}
+
 }  // namespace tensorflow
@@ -98,6 +98,10 @@ class MemmappedFileSystem : public FileSystem {
   // Initializes filesystem from a file in memmapped format.
   Status InitializeFromFile(Env* env, const string& filename);
 
+  // Reads every page of the package, so that the first runs of a graph don't
+  // wait for its tensors to be paged in.
+  void Prefault() const;
+
   // Checks if the filename has a correct prefix.
   static bool IsMemmappedPackageFilename(const string& filename);
 
@@ -129,6 +133,8 @@ class MemmappedEnv : public EnvWrapper {
                               FileSystem** result) override;
   Status GetRegisteredFileSystemSchemes(std::vector<string>* schemes) override;
   Status InitializeFromFile(const string& filename);
+  // Prefaults the package (see MemmappedFileSystem::Prefault()).
+  Status Prefault();
 
  protected:
   std::unique_ptr<MemmappedFileSystem> memmapped_file_system_;
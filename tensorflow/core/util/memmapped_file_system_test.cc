@@ -109,6 +109,39 @@ TEST(MemmappedFileSystemTest, SimpleTest) {
             memmapped_env.FileExists("bla-bla-bla").code());
 }
 
+TEST(MemmappedFileSystemTest, PageAlignedTensors) {
+  const string filename =
+      io::JoinPath(testing::TmpDir(), "memmapped_env_page_aligned_test");
+  Tensor small_tensor(DT_FLOAT, TensorShape({3}));
+  test::FillFn<float>(&small_tensor, [](int i) { return i; });
+  {
+    MemmappedFileSystemWriter writer;
+    TF_ASSERT_OK(writer.InitializeToFile(Env::Default(), filename));
+    TF_ASSERT_OK(writer.SaveTensor(small_tensor, kTensor1FileName,
+                                   MemmappedFileSystemWriter::kPageAlignment));
+    TF_ASSERT_OK(writer.SaveTensor(small_tensor, kTensor2FileName,
+                                   MemmappedFileSystemWriter::kPageAlignment));
+    EXPECT_EQ(error::INVALID_ARGUMENT,
+              writer.SaveTensor(small_tensor, kTensor2FileName, 100).code());
+    TF_ASSERT_OK(writer.FlushAndClose());
+  }
+
+  MemmappedEnv memmapped_env(Env::Default());
+  EXPECT_EQ(error::FAILED_PRECONDITION, memmapped_env.Prefault().code());
+  TF_ASSERT_OK(memmapped_env.InitializeFromFile(filename));
+  TF_ASSERT_OK(memmapped_env.Prefault());
+  for (const char* name : {kTensor1FileName, kTensor2FileName}) {
+    std::unique_ptr<ReadOnlyMemoryRegion> memory_region;
+    TF_ASSERT_OK(
+        memmapped_env.NewReadOnlyMemoryRegionFromFile(name, &memory_region));
+    EXPECT_EQ(0, reinterpret_cast<intptr_t>(memory_region->data()) %
+                     MemmappedFileSystemWriter::kPageAlignment);
+    EXPECT_EQ(small_tensor.tensor_data(),
+              StringPiece(static_cast<const char*>(memory_region->data()),
+                          small_tensor.TotalBytes()));
+  }
+}
+
 TEST(MemmappedFileSystemTest, NotInitalized) {
   MemmappedEnv memmapped_env(Env::Default());
   std::unique_ptr<ReadOnlyMemoryRegion> memory_region;
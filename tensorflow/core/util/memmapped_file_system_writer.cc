@@ -27,8 +27,16 @@ Status MemmappedFileSystemWriter::InitializeToFile(Env* env,
   return status;
 }
 
+constexpr uint64 MemmappedFileSystemWriter::kPageAlignment;
+
 Status MemmappedFileSystemWriter::SaveTensor(const Tensor& tensor,
                                              const string& element_name) {
+  return SaveTensor(tensor, element_name, Allocator::kAllocatorAlignment);
+}
+
+Status MemmappedFileSystemWriter::SaveTensor(const Tensor& tensor,
+                                             const string& element_name,
+                                             uint64 alignment) {
   if (!output_file_) {
     return errors::FailedPrecondition(
         "MemmappedEnvWritter: saving tensor into not opened file");
@@ -45,8 +53,13 @@ Status MemmappedFileSystemWriter::SaveTensor(const Tensor& tensor,
     return errors::InvalidArgument(
         "MemmappedEnvWritter: saving tensor with 0 size");
   }
+  if (alignment == 0 || alignment % Allocator::kAllocatorAlignment != 0) {
+    return errors::InvalidArgument(
+        "MemmappedEnvWritter: tensor alignment ", alignment,
+        " is not a multiple of ", Allocator::kAllocatorAlignment);
+  }
   // Adds pad for correct alignment after memmapping.
-  TF_RETURN_IF_ERROR(AdjustAlignment(Allocator::kAllocatorAlignment));
+  TF_RETURN_IF_ERROR(AdjustAlignment(alignment));
   AddToDirectoryElement(element_name);
   const auto result = output_file_->Append(tensor_data);
   if (result.ok()) {
@@ -29,10 +29,18 @@ namespace tensorflow {
 // MemmappedFileSystem.
 class MemmappedFileSystemWriter {
  public:
+  // An alignment of tensors that lets each tensor of a package be paged in,
+  // advised or shared on its own.
+  static constexpr uint64 kPageAlignment = 4096;
+
   MemmappedFileSystemWriter() = default;
   ~MemmappedFileSystemWriter() = default;
   Status InitializeToFile(Env* env, const string& filename);
+  // Saves the data of "tensor" at an offset aligned to "alignment", which must
+  // be a multiple of Allocator::kAllocatorAlignment (the default).
   Status SaveTensor(const Tensor& tensor, const string& element_name);
+  Status SaveTensor(const Tensor& tensor, const string& element_name,
+                    uint64 alignment);
   Status SaveProtobuf(const protobuf::MessageLite& message,
                       const string& element_name);
   // Writes out the directory of regions and closes the output file.
@@ -0,0 +1,204 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/util/sparse/sparse_tensor.h"
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+#include "tensorflow/core/util/overflow.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+namespace sparse {
+
+namespace {
+
+typedef gtl::ArraySlice<int64> VarDimArray;
+
+// Fewer indices than this are sorted with std::sort.
+constexpr int64 kMinRadixSortEntries = 1 << 12;
+
+// Every pass of the radix sort sorts the keys by kRadixBits of their bits.
+constexpr int kRadixBits = 8;
+constexpr int64 kRadixBuckets = 1 << kRadixBits;
+
+// Each thread counts and scatters at least this many keys in a pass.
+constexpr int64 kMinRadixChunkEntries = 1 << 14;
+
+// Runs work(chunk, start, limit) for each of the num_chunks equal chunks of
+// [0, total), in parallel if there is more than one. The chunks are the same
+// at every call, so the passes of the radix sort can keep counts per chunk.
+void ForEachChunk(const DeviceBase::CpuWorkerThreads* worker_threads,
+                  int64 total, int num_chunks,
+                  const std::function<void(int, int64, int64)>& work) {
+  const int64 chunk_size = (total + num_chunks - 1) / num_chunks;
+  auto run = [&work, total, chunk_size](int64 first, int64 last) {
+    for (int64 chunk = first; chunk < last; ++chunk) {
+      work(chunk, std::min(total, chunk * chunk_size),
+           std::min(total, (chunk + 1) * chunk_size));
+    }
+  };
+  if (num_chunks == 1) {
+    run(0, 1);
+    return;
+  }
+  // Every chunk is costly enough to get its own shard.
+  Shard(worker_threads->num_threads, worker_threads->workers, num_chunks,
+        chunk_size * kRadixBuckets, run);
+}
+
+// Sorts the rows of ix by their offsets in the row-major dense tensor of the
+// given shape with its dimensions permuted by order, which order the indices
+// like DimComparator does. The sort is an LSD radix sort on the offsets.
+//
+// Returns false, leaving *reorder unchanged, if the dense tensor has more
+// than 2^63 elements or an index is out of bounds, so that the offsets don't
+// order the indices.
+bool RadixSortIndices(const TTypes<int64>::Matrix& ix, const VarDimArray& order,
+                      const VarDimArray& shape,
+                      const DeviceBase::CpuWorkerThreads* worker_threads,
+                      std::vector<int64>* reorder) {
+  const int dims = order.size();
+  gtl::InlinedVector<int64, 8> strides(dims);
+  int64 num_elements = 1;
+  for (int di = dims - 1; di >= 0; --di) {
+    const int64 size = shape[order[di]];
+    if (size <= 0) return false;
+    strides[di] = num_elements;
+    num_elements = MultiplyWithoutOverflow(num_elements, size);
+    if (num_elements < 0) return false;
+  }
+
+  const int64 N = reorder->size();
+  int num_chunks = 1;
+  if (worker_threads != nullptr) {
+    num_chunks = static_cast<int>(std::max<int64>(
+        1, std::min<int64>(worker_threads->num_threads,
+                           N / kMinRadixChunkEntries)));
+  }
+
+  std::vector<int64> keys(N);
+  std::vector<char> in_bounds(num_chunks, true);
+  ForEachChunk(worker_threads, N, num_chunks,
+               [&ix, &order, &shape, &strides, &keys, &in_bounds, dims](
+                   int chunk, int64 start, int64 limit) {
+                 for (int64 n = start; n < limit; ++n) {
+                   int64 key = 0;
+                   for (int di = 0; di < dims; ++di) {
+                     const int64 d = order[di];
+                     const int64 i = ix(n, d);
+                     if (i < 0 || i >= shape[d]) {
+                       in_bounds[chunk] = false;
+                       return;
+                     }
+                     key += i * strides[di];
+                   }
+                   keys[n] = key;
+                 }
+               });
+  for (const char chunk_in_bounds : in_bounds) {
+    if (!chunk_in_bounds) return false;
+  }
+
+  // Only the digits of the largest offset need to be sorted.
+  int num_passes = 0;
+  for (int64 max_key = num_elements - 1; max_key > 0; max_key >>= kRadixBits) {
+    ++num_passes;
+  }
+
+  std::vector<int64> sorted_keys(N);
+  std::vector<int64> sorted_reorder(N);
+  std::vector<int64> offsets(num_chunks * kRadixBuckets);
+  for (int pass = 0; pass < num_passes; ++pass) {
+    const int shift = pass * kRadixBits;
+    std::fill(offsets.begin(), offsets.end(), 0);
+    ForEachChunk(worker_threads, N, num_chunks,
+                 [&keys, &offsets, shift](int chunk, int64 start, int64 limit) {
+                   int64* counts = &offsets[chunk * kRadixBuckets];
+                   for (int64 n = start; n < limit; ++n) {
+                     ++counts[(keys[n] >> shift) & (kRadixBuckets - 1)];
+                   }
+                 });
+
+    // Turns the counts into the first position of each digit in each chunk.
+    // Within a digit, the chunks keep their order, so the sort is stable.
+    int64 position = 0;
+    for (int64 digit = 0; digit < kRadixBuckets; ++digit) {
+      for (int chunk = 0; chunk < num_chunks; ++chunk) {
+        const int64 count = offsets[chunk * kRadixBuckets + digit];
+        offsets[chunk * kRadixBuckets + digit] = position;
+        position += count;
+      }
+    }
+
+    ForEachChunk(worker_threads, N, num_chunks,
+                 [&keys, &offsets, &sorted_keys, &sorted_reorder, reorder,
+                  shift](int chunk, int64 start, int64 limit) {
+                   int64* next = &offsets[chunk * kRadixBuckets];
+                   for (int64 n = start; n < limit; ++n) {
+                     const int64 to =
+                         next[(keys[n] >> shift) & (kRadixBuckets - 1)]++;
+                     sorted_keys[to] = keys[n];
+                     sorted_reorder[to] = (*reorder)[n];
+                   }
+                 });
+    keys.swap(sorted_keys);
+    reorder->swap(sorted_reorder);
+  }
+  return true;
+}
+
+}  // namespace
+
+void SparseTensor::SortIndices(
+    const VarDimArray& order,
+    const DeviceBase::CpuWorkerThreads* worker_threads,
+    std::vector<int64>* reorder) {
+  auto ix_t = ix_.matrix<int64>();
+
+  reorder->resize(num_entries());
+  std::iota(reorder->begin(), reorder->end(), 0);
+
+  if (reorder->size() >= kMinRadixSortEntries &&
+      RadixSortIndices(ix_t, order, shape(), worker_threads, reorder)) {
+    return;
+  }
+
+  switch (order.size()) {
+#define CASE_SORT(ORDER_SIZE)                                    \
+  case ORDER_SIZE: {                                             \
+    FixedDimComparator<ORDER_SIZE> sorter(ix_t, order, shape()); \
+    std::sort(reorder->begin(), reorder->end(), sorter);         \
+    break;                                                       \
+  }
+    CASE_SORT(0);
+    CASE_SORT(1);
+    CASE_SORT(2);
+    CASE_SORT(3);
+    CASE_SORT(4);
+    CASE_SORT(5);
+#undef CASE_SORT
+    default: {
+      DimComparator sorter(ix_t, order, shape());
+      std::sort(reorder->begin(), reorder->end(), sorter);
+    }
+  }
+}
+
+}  // namespace sparse
+}  // namespace tensorflow
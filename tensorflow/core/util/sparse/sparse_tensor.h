@@ -21,6 +21,7 @@ limitations under the License.
 #include <vector>
 
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+#include "tensorflow/core/framework/device_base.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/framework/types.h"
@@ -101,8 +102,10 @@ class SparseTensor {
   VarDimArray order() const { return order_; }
 
   // Resorts the indices and values according to the dimensions in order.
+  // If worker_threads is not null, the indices are sorted on its threads.
   template <typename T>
-  void Reorder(const VarDimArray& order);
+  void Reorder(const VarDimArray& order,
+               const DeviceBase::CpuWorkerThreads* worker_threads = nullptr);
 
   // Returns a group iterable that can be used for clumping indices
   // and values according to the group indices of interest.
@@ -181,6 +184,12 @@ class SparseTensor {
     return vec;
   }
 
+  // Helper for Reorder(): sets *reorder to the rows of the indices, sorted
+  // according to the dimensions in order.
+  void SortIndices(const VarDimArray& order,
+                   const DeviceBase::CpuWorkerThreads* worker_threads,
+                   std::vector<int64>* reorder);
+
   // Helper for IndicesValid()
   inline Status IndexValid(const TTypes<int64>::ConstMatrix& ix_t,
                            int n) const {
@@ -273,39 +282,20 @@ class SparseTensor {
 };
 
 // This operation updates the indices and values Tensor rows, so it is
-// an in-place algorithm.  It requires O(N log N) time and O(N)
-// temporary space.
+// an in-place algorithm.  It requires O(N) time (O(N log N) if the dense
+// shape has more than 2^63 elements) and O(N) temporary space.
 template <typename T>
-void SparseTensor::Reorder(const VarDimArray& order) {
+void SparseTensor::Reorder(const VarDimArray& order,
+                           const DeviceBase::CpuWorkerThreads* worker_threads) {
   CHECK_EQ(DataTypeToEnum<T>::v(), dtype())
       << "Reorder requested with the wrong datatype";
   CHECK_EQ(order.size(), dims_) << "Order length must be SparseTensor rank";
   auto ix_t = ix_.matrix<int64>();
   auto vals_t = vals_.vec<T>();
 
-  std::vector<int64> reorder(num_entries());
-  std::iota(reorder.begin(), reorder.end(), 0);
-
   // Sort to get order of indices
-  switch (order.size()) {
-#define CASE_SORT(ORDER_SIZE)                                    \
-  case ORDER_SIZE: {                                             \
-    FixedDimComparator<ORDER_SIZE> sorter(ix_t, order, shape()); \
-    std::sort(reorder.begin(), reorder.end(), sorter);           \
-    break;                                                       \
-  }
-    CASE_SORT(0);
-    CASE_SORT(1);
-    CASE_SORT(2);
-    CASE_SORT(3);
-    CASE_SORT(4);
-    CASE_SORT(5);
-#undef CASE_SORT
-    default: {
-      DimComparator sorter(ix_t, order, shape());
-      std::sort(reorder.begin(), reorder.end(), sorter);
-    }
-  }
+  std::vector<int64> reorder;
+  SortIndices(order, worker_threads, &reorder);
 
   // We have a forward reordering, but what we'll need is a
   // permutation (the inverse).  This can be calculated with O(1)
@@ -21,9 +21,12 @@ limitations under the License.
 #include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/random/simple_philox.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/platform/test_benchmark.h"
 
@@ -626,6 +629,51 @@ TEST(SparseTensorTest, Dim0SparseTensorToDenseTensor) {
   EXPECT_EQ(dense.scalar<int32>()(), 5);
 }
 
+// Reorders enough random indices to be radix sorted, with and without worker
+// threads, and with an out-of-bounds index that makes Reorder fall back to
+// std::sort.
+TEST(SparseTensorTest, ReorderLarge) {
+  const int64 N = 100000;
+  const int NDIM = 3;
+  thread::ThreadPool pool(Env::Default(), "reorder", 4);
+  DeviceBase::CpuWorkerThreads worker_threads;
+  worker_threads.num_threads = 4;
+  worker_threads.workers = &pool;
+
+  for (const bool out_of_bounds : {false, true}) {
+    for (const bool use_threads : {false, true}) {
+      random::PhiloxRandom philox(301, 17);
+      random::SimplePhilox rnd(&philox);
+      Tensor ix(DT_INT64, TensorShape({N, NDIM}));
+      Tensor vals(DT_INT64, TensorShape({N}));
+      auto ix_t = ix.matrix<int64>();
+      auto vals_t = vals.vec<int64>();
+      for (int64 i = 0; i < N; ++i) {
+        for (int d = 0; d < NDIM; ++d) ix_t(i, d) = rnd.Uniform(100);
+        vals_t(i) = i;
+      }
+      if (out_of_bounds) ix_t(N / 2, 0) = 1000;
+      const Tensor original_ix = tensor::DeepCopy(ix);
+      const auto original_ix_t = original_ix.matrix<int64>();
+
+      SparseTensor st(ix, vals, TensorShape({100, 200, 300}), {0, 1, 2});
+      const std::vector<int64> order = {2, 0, 1};
+      st.Reorder<int64>(order, use_threads ? &worker_threads : nullptr);
+
+      for (int64 i = 0; i < N; ++i) {
+        for (int d = 0; d < NDIM; ++d) {
+          ASSERT_EQ(original_ix_t(vals_t(i), d), ix_t(i, d));
+        }
+        if (i == 0) continue;
+        for (const int64 d : order) {
+          ASSERT_LE(ix_t(i - 1, d), ix_t(i, d));
+          if (ix_t(i - 1, d) < ix_t(i, d)) break;
+        }
+      }
+    }
+  }
+}
+
 static void BM_SparseReorderFloat(int iters, int N32, int NDIM32) {
   random::PhiloxRandom philox(301, 17);
   random::SimplePhilox rnd(&philox);
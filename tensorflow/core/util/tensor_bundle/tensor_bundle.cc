@@ -25,8 +25,10 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb_text.h"
 #include "tensorflow/core/framework/versions.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/lib/core/coding.h"
 #include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/map_util.h"
 #include "tensorflow/core/lib/gtl/stl_util.h"
 #include "tensorflow/core/lib/hash/crc32c.h"
@@ -34,6 +36,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/table_builder.h"
 #include "tensorflow/core/lib/random/random.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow/core/util/tensor_slice_util.h"
 
@@ -222,6 +225,52 @@ Status ReadInputByChunk(const RandomAccessFile* file, size_t offset,
   return Status::OK();
 }
 
+// LookupMany() reads tensors of at most this many bytes together with their
+// neighbors in the data file, in reads of at most kMaxCoalescedReadBytes.  The
+// gaps between the tensors (alignment padding, or tensors that are not looked
+// up) are read too, up to kMaxCoalescedGapBytes each.
+const uint64 kMaxCoalescedTensorBytes = 1 << 20;
+const uint64 kMaxCoalescedReadBytes = 16 << 20;
+const uint64 kMaxCoalescedGapBytes = 64 << 10;
+
+// A read of one or more tensors from bytes [offset, offset + size) of a data
+// file.
+struct CoalescedRead {
+  const RandomAccessFile* file;
+  uint64 offset;
+  uint64 size;
+  std::vector<std::pair<const BundleEntryProto*, Tensor*>> tensors;
+};
+
+// Reads the tensors of "read", and validates their checksums.
+Status RunCoalescedRead(const CoalescedRead& read) {
+  // A single tensor is read in place.
+  std::unique_ptr<char[]> staging;
+  char* data = GetBackingBuffer(*read.tensors[0].second);
+  if (read.tensors.size() > 1) {
+    staging.reset(new char[read.size]);
+    data = staging.get();
+  }
+  TF_RETURN_IF_ERROR(ReadInputByChunk(read.file, read.offset, read.size,
+                                      8 << 20 /* 8MB buffer */, data));
+  for (const auto& p : read.tensors) {
+    const BundleEntryProto& entry = *p.first;
+    char* backing_buffer = GetBackingBuffer(*p.second);
+    if (staging) {
+      memcpy(backing_buffer, data + (entry.offset() - read.offset),
+             entry.size());
+    }
+    const uint32 actual_crc32c = crc32c::Value(backing_buffer, entry.size());
+    if (crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+      return errors::DataLoss(
+          "Checksum does not match: stored ",
+          strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+          " vs. calculated on the restored bytes ", actual_crc32c);
+    }
+  }
+  return Status::OK();
+}
+
 // Returns whether "slice_spec" is a full slice, with respect to the full shape.
 //
 // This can happen say, when "slice_spec" is
@@ -265,29 +314,69 @@ table::Options TableBuilderOptions() {
   return o;
 }
 
+// A buffer that aliases part of a memory mapping of a data file, and keeps the
+// mapping alive.
+class MappedTensorBuffer : public TensorBuffer {
+ public:
+  MappedTensorBuffer(std::shared_ptr<ReadOnlyMemoryRegion> region,
+                     const char* data, size_t len)
+      : region_(std::move(region)), data_(data), len_(len) {}
+
+  void* data() const override { return const_cast<char*>(data_); }
+  size_t size() const override { return len_; }
+  TensorBuffer* root_buffer() override { return this; }
+  void FillAllocationDescription(AllocationDescription* proto) const override {
+    proto->set_requested_bytes(static_cast<int64>(len_));
+    proto->set_allocator_name("MappedTensorBuffer");
+    proto->set_ptr(reinterpret_cast<uintptr_t>(data_));
+  }
+
+  // Prevents input forwarding from writing into the read-only mapping.
+  bool OwnsMemory() const override { return false; }
+
+ private:
+  ~MappedTensorBuffer() override {}
+
+  const std::shared_ptr<ReadOnlyMemoryRegion> region_;
+  const char* const data_;
+  const size_t len_;
+};
+
 }  // namespace
 
-BundleWriter::BundleWriter(Env* env, StringPiece prefix)
+BundleWriter::BundleWriter(Env* env, StringPiece prefix, const Options& options)
     : env_(env),
+      options_(options),
       prefix_(prefix.ToString()),
       tmp_metadata_path_(strings::StrCat(MetaFilename(prefix_), ".tempstate",
-                                         random::New64())),
-      tmp_data_path_(strings::StrCat(DataFilename(prefix_, 0, 1), ".tempstate",
-                                     random::New64())),
-      out_(nullptr),
-      size_(0) {
+                                         random::New64())) {
+  if (options_.num_shards < 1) {
+    status_ = errors::InvalidArgument("BundleWriter needs at least one shard, "
+                                      "got ",
+                                      options_.num_shards);
+    return;
+  }
   status_ = env_->CreateDir(io::Dirname(prefix_).ToString());
   if (!status_.ok() && !errors::IsAlreadyExists(status_)) {
     return;
   }
-  const string filename = DataFilename(prefix_, 0, 1);
+  status_ = Status::OK();
+  if (options_.num_shards == 1) {
+    data_files_.resize(1);
+    status_ = OpenDataFile(0, 1, &data_files_[0]);
+  }
+}
+
+Status BundleWriter::OpenDataFile(int shard_id, int num_shards,
+                                  DataFile* file) {
+  file->tmp_path = strings::StrCat(DataFilename(prefix_, shard_id, num_shards),
+                                   ".tempstate", random::New64());
   std::unique_ptr<WritableFile> wrapper;
-  status_ = env_->NewWritableFile(tmp_data_path_, &wrapper);
-  if (!status_.ok()) return;
-  out_ = std::unique_ptr<FileOutputBuffer>(
+  TF_RETURN_IF_ERROR(env_->NewWritableFile(file->tmp_path, &wrapper));
+  file->out = std::unique_ptr<FileOutputBuffer>(
       new FileOutputBuffer(wrapper.release(), 8 << 20 /* 8MB write buffer */));
-
-  VLOG(1) << "Writing to file " << tmp_data_path_;
+  VLOG(1) << "Writing to file " << file->tmp_path;
+  return Status::OK();
 }
 
 Status BundleWriter::Add(StringPiece key, const Tensor& val) {
@@ -302,26 +391,99 @@ Status BundleWriter::Add(StringPiece key, const Tensor& val) {
   BundleEntryProto* entry = &entries_[key_string];
   entry->set_dtype(val.dtype());
   val.shape().AsProto(entry->mutable_shape());
-  entry->set_shard_id(0);
-  entry->set_offset(size_);
+  if (options_.num_shards > 1) {
+    // Shares the buffer of "val" until Finish() writes it.
+    pending_.emplace_back(entry, val);
+    return Status::OK();
+  }
+  status_ = WriteTensorToFile(val, 0, &data_files_[0], entry);
+  return status_;
+}
+
+Status BundleWriter::WriteTensorToFile(const Tensor& val, int shard_id,
+                                       DataFile* file,
+                                       BundleEntryProto* entry) {
+  // Pads the data file so that the tensor's data is aligned, if requested.
+  if (val.dtype() != DT_STRING && options_.data_alignment > 1) {
+    const int64 padding = (options_.data_alignment -
+                           file->size % options_.data_alignment) %
+                          options_.data_alignment;
+    if (padding > 0) {
+      TF_RETURN_IF_ERROR(file->out->Append(string(padding, '\0')));
+      file->size += padding;
+    }
+  }
+
+  entry->set_shard_id(shard_id);
+  entry->set_offset(file->size);
 
   // Updates the data file.
   size_t data_bytes_written = 0;
   uint32 crc32c = 0;
-  out_->clear_crc32c();
+  file->out->clear_crc32c();
   if (val.dtype() != DT_STRING) {
-    status_ = WriteTensor(val, out_.get(), &data_bytes_written);
-    crc32c = out_->crc32c();
+    TF_RETURN_IF_ERROR(WriteTensor(val, file->out.get(), &data_bytes_written));
+    crc32c = file->out->crc32c();
   } else {
-    status_ = WriteStringTensor(val, out_.get(), &data_bytes_written, &crc32c);
+    TF_RETURN_IF_ERROR(WriteStringTensor(val, file->out.get(),
+                                         &data_bytes_written, &crc32c));
   }
 
-  if (status_.ok()) {
-    entry->set_size(data_bytes_written);
-    entry->set_crc32c(crc32c::Mask(crc32c));
-    size_ += data_bytes_written;
+  entry->set_size(data_bytes_written);
+  entry->set_crc32c(crc32c::Mask(crc32c));
+  file->size += data_bytes_written;
+  return Status::OK();
+}
+
+Status BundleWriter::WritePendingTensors() {
+  // No data file is left empty, but there is at least one.
+  const int num_shards = static_cast<int>(std::max<size_t>(
+      1, std::min<size_t>(options_.num_shards, pending_.size())));
+  data_files_.resize(num_shards);
+  for (int i = 0; i < num_shards; ++i) {
+    TF_RETURN_IF_ERROR(OpenDataFile(i, num_shards, &data_files_[i]));
   }
-  return status_;
+
+  // Assigns the largest tensors first, each to the shard with the fewest bytes
+  // so far.
+  std::vector<int> order(pending_.size());
+  for (int i = 0; i < order.size(); ++i) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+    return pending_[a].second.TotalBytes() > pending_[b].second.TotalBytes();
+  });
+  std::vector<std::vector<int>> shard_tensors(num_shards);
+  std::vector<int64> shard_bytes(num_shards, 0);
+  for (int i : order) {
+    const int shard = std::min_element(shard_bytes.begin(), shard_bytes.end()) -
+                      shard_bytes.begin();
+    shard_tensors[shard].push_back(i);
+    shard_bytes[shard] += pending_[i].second.TotalBytes();
+  }
+
+  // Each thread only touches its own data file and the entries of its own
+  // tensors, so the writes need no synchronization.  The
+  // checksums are computed on the writing threads.
+  std::vector<Status> statuses(num_shards);
+  {
+    thread::ThreadPool pool(env_, "bundle_writer", num_shards);
+    for (int shard = 0; shard < num_shards; ++shard) {
+      pool.Schedule([this, shard, &shard_tensors, &statuses]() {
+        // Writes the tensors of the shard in the order they were added.
+        std::vector<int>& tensors = shard_tensors[shard];
+        std::sort(tensors.begin(), tensors.end());
+        for (int i : tensors) {
+          statuses[shard] =
+              WriteTensorToFile(pending_[i].second, shard,
+                                &data_files_[shard], pending_[i].first);
+          if (!statuses[shard].ok()) return;
+        }
+      });
+    }
+  }
+  pending_.clear();
+  Status status;
+  for (const Status& s : statuses) status.Update(s);
+  return status;
 }
 
 Status BundleWriter::AddSlice(StringPiece full_tensor_key,
@@ -368,16 +530,27 @@ Status BundleWriter::AddSlice(StringPiece full_tensor_key,
 // TODO(zongheng): on metadata write failure or !status_.ok(), consider removing
 // the orphaned data file.
 Status BundleWriter::Finish() {
-  if (out_) {
-    status_.Update(out_->Close());
-    out_ = nullptr;
+  if (status_.ok() && options_.num_shards > 1) {
+    status_ = WritePendingTensors();
+  }
+  const int num_shards = data_files_.size();
+  for (int i = 0; i < num_shards; ++i) {
+    DataFile* file = &data_files_[i];
+    if (!file->out) continue;
+    status_.Update(file->out->Close());
+    file->out = nullptr;
+  }
+  for (int i = 0; i < num_shards; ++i) {
+    const DataFile& file = data_files_[i];
+    if (file.tmp_path.empty()) continue;
     if (status_.ok()) {
-      status_ = Env::Default()->RenameFile(tmp_data_path_,
-                                           DataFilename(prefix_, 0, 1));
+      status_ = Env::Default()->RenameFile(
+          file.tmp_path, DataFilename(prefix_, i, num_shards));
     } else {
-      Env::Default()->DeleteFile(tmp_data_path_).IgnoreError();
+      Env::Default()->DeleteFile(file.tmp_path).IgnoreError();
     }
   }
+  data_files_.clear();
   if (!status_.ok()) return status_;
   // Build key -> BundleEntryProto table.
   std::unique_ptr<WritableFile> file;
@@ -391,7 +564,7 @@ Status BundleWriter::Finish() {
     table::TableBuilder builder(options, file.get());
     // Header entry.
     BundleHeaderProto header;
-    header.set_num_shards(1);
+    header.set_num_shards(num_shards);
     header.set_endianness(BundleHeaderProto::LITTLE);
     if (!port::kLittleEndian) header.set_endianness(BundleHeaderProto::BIG);
     VersionDef* version = header.mutable_version();
@@ -493,6 +666,13 @@ static Status MergeOneBundle(Env* env, StringPiece prefix,
     iter->Next();
   }
 
+  // Renumbers all the data files of the bundle, including any that no entry
+  // refers to, so that the merged bundle has exactly "num_shards" of them.
+  for (int i = 0; i < num_shards; ++i) {
+    merge_state->shard_ids.insert({DataFilename(prefix, i, num_shards),
+                                   merge_state->shard_ids.size()});
+  }
+
   // Loops through the non-header to-merge entries.
   BundleEntryProto to_merge_entry;
   for (; iter->Valid(); iter->Next()) {
@@ -531,10 +711,14 @@ static Status MergeOneBundle(Env* env, StringPiece prefix,
     }
 
     // Key doesn't duplicate: a fresh tensor/slice entry.
-    auto result = merge_state->shard_ids.insert(
-        {DataFilename(prefix, to_merge_entry.shard_id(), num_shards),
-         merge_state->shard_ids.size()});
-    to_merge_entry.set_shard_id(result.first->second);
+    const auto shard_iter = merge_state->shard_ids.find(
+        DataFilename(prefix, to_merge_entry.shard_id(), num_shards));
+    if (shard_iter == merge_state->shard_ids.end()) {
+      return errors::DataLoss("Shard id ", to_merge_entry.shard_id(),
+                              " of tensor ", key, " out of range in ",
+                              filename);
+    }
+    to_merge_entry.set_shard_id(shard_iter->second);
     merge_state->entries[key] = to_merge_entry;
   }
   return Status::OK();
@@ -671,6 +855,21 @@ Status BundleReader::GetBundleEntryProto(StringPiece key,
   return Status::OK();
 }
 
+Status BundleReader::GetDataFile(int32 shard_id,
+                                 io::InputBuffer** buffered_file) {
+  *buffered_file = data_[shard_id];
+  if (*buffered_file == nullptr) {
+    std::unique_ptr<RandomAccessFile> file = nullptr;
+    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
+        DataFilename(prefix_, shard_id, num_shards_), &file));
+    *buffered_file =
+        new io::InputBuffer(file.release(), 256 << 10 /* 256KB buffer */);
+    // The InputBuffer and RandomAccessFile objects are both released in dtor.
+    data_[shard_id] = *buffered_file;
+  }
+  return Status::OK();
+}
+
 Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
   Tensor* ret = val;
   const TensorShape stored_shape(TensorShape(entry.shape()));
@@ -700,18 +899,8 @@ Status BundleReader::GetValue(const BundleEntryProto& entry, Tensor* val) {
     }
   }
 
-  // Open the data file if it has not been opened.
-  io::InputBuffer* buffered_file = data_[entry.shard_id()];
-  if (buffered_file == nullptr) {
-    std::unique_ptr<RandomAccessFile> file = nullptr;
-    TF_RETURN_IF_ERROR(env_->NewRandomAccessFile(
-        DataFilename(prefix_, entry.shard_id(), num_shards_), &file));
-    buffered_file =
-        new io::InputBuffer(file.release(), 256 << 10 /* 256KB buffer */);
-    // The InputBuffer and RandomAccessFile objects are both released in dtor.
-    data_[entry.shard_id()] = buffered_file;
-  }
-  CHECK(buffered_file != nullptr);
+  io::InputBuffer* buffered_file;
+  TF_RETURN_IF_ERROR(GetDataFile(entry.shard_id(), &buffered_file));
 
   TF_RETURN_IF_ERROR(buffered_file->Seek(entry.offset()));
   uint32 actual_crc32c = 0;
@@ -757,6 +946,63 @@ Status BundleReader::Lookup(StringPiece key, Tensor* val) {
   }
 }
 
+Status BundleReader::LookupAliased(StringPiece key, Tensor* val) {
+  CHECK(val != nullptr);
+  BundleEntryProto entry;
+  TF_RETURN_IF_ERROR(GetBundleEntryProto(key, &entry));
+  const TensorShape stored_shape(entry.shape());
+  const bool can_alias = entry.slices().empty() &&
+                         DataTypeCanUseMemcpy(entry.dtype()) &&
+                         stored_shape.num_elements() > 0;
+  if (!can_alias) {
+    *val = Tensor();
+    return Lookup(key, val);
+  }
+
+  // Maps the data file if it has not been mapped.  A file system that cannot
+  // map files is not an error; the tensor is then read as by Lookup().
+  std::shared_ptr<ReadOnlyMemoryRegion>& region =
+      mapped_data_[entry.shard_id()];
+  if (region == nullptr) {
+    std::unique_ptr<ReadOnlyMemoryRegion> new_region;
+    const Status status = env_->NewReadOnlyMemoryRegionFromFile(
+        DataFilename(prefix_, entry.shard_id(), num_shards_), &new_region);
+    if (!status.ok()) {
+      VLOG(1) << "Unable to map data file " << entry.shard_id() << " of "
+              << prefix_ << ", reading it instead: " << status;
+      mapped_data_.erase(entry.shard_id());
+      *val = Tensor();
+      return Lookup(key, val);
+    }
+    region.reset(new_region.release());
+  }
+
+  const size_t expected_size =
+      stored_shape.num_elements() * DataTypeSize(entry.dtype());
+  if (entry.size() != expected_size) {
+    return errors::DataLoss("Invalid size in bundle entry: key ", key,
+                            "; stored size ", entry.size(),
+                            "; expected size ", expected_size);
+  }
+  if (entry.offset() + entry.size() > region->length()) {
+    return errors::DataLoss("Bundle entry ", key, " at offset ",
+                            entry.offset(), " of size ", entry.size(),
+                            " extends past the end of its data file");
+  }
+  const char* data =
+      static_cast<const char*>(region->data()) + entry.offset();
+  if (reinterpret_cast<uintptr_t>(data) % EIGEN_MAX_ALIGN_BYTES != 0) {
+    *val = Tensor();
+    return Lookup(key, val);
+  }
+
+  MappedTensorBuffer* buffer =
+      new MappedTensorBuffer(region, data, entry.size());
+  *val = Tensor(entry.dtype(), stored_shape, buffer);
+  buffer->Unref();
+  return Status::OK();
+}
+
 Status BundleReader::ReadCurrent(Tensor* val) {
   CHECK(val != nullptr);
   BundleEntryProto entry;
@@ -795,6 +1041,83 @@ Status BundleReader::LookupSlice(StringPiece full_tensor_key,
   return GetSliceValue(full_tensor_key, entry, slice_spec, val);
 }
 
+Status BundleReader::LookupMany(gtl::ArraySlice<string> keys,
+                                gtl::ArraySlice<Tensor*> vals,
+                                thread::ThreadPool* pool) {
+  CHECK_EQ(keys.size(), vals.size());
+  std::vector<BundleEntryProto> entries(keys.size());
+  std::vector<int> to_read;
+  for (int i = 0; i < keys.size(); ++i) {
+    BundleEntryProto* entry = &entries[i];
+    TF_RETURN_IF_ERROR(GetBundleEntryProto(keys[i], entry));
+    if (!entry->slices().empty() || !DataTypeCanUseMemcpy(entry->dtype())) {
+      TF_RETURN_IF_ERROR(Lookup(keys[i], vals[i]));
+      continue;
+    }
+    Tensor* val = vals[i];
+    if (val->NumElements() == 0) {
+      *val = Tensor(entry->dtype(), TensorShape(entry->shape()));
+    }
+    if (entry->size() != val->TotalBytes()) {
+      return errors::DataLoss("Invalid size in bundle entry: key ", keys[i],
+                              "; stored size ", entry->size(),
+                              "; expected size ", val->TotalBytes());
+    }
+    if (entry->size() > 0) to_read.push_back(i);
+  }
+
+  // Groups the tensors by data file, in the order of their data.
+  std::sort(to_read.begin(), to_read.end(), [&entries](int a, int b) {
+    return std::make_pair(entries[a].shard_id(), entries[a].offset()) <
+           std::make_pair(entries[b].shard_id(), entries[b].offset());
+  });
+  std::vector<CoalescedRead> reads;
+  for (int i : to_read) {
+    const BundleEntryProto& entry = entries[i];
+    CoalescedRead* last = reads.empty() ? nullptr : &reads.back();
+    io::InputBuffer* buffered_file;
+    TF_RETURN_IF_ERROR(GetDataFile(entry.shard_id(), &buffered_file));
+    const RandomAccessFile* file = buffered_file->file();
+    const uint64 end = entry.offset() + entry.size();
+    // Only reads of small tensors are extended; a larger one is read alone.
+    if (last != nullptr && last->file == file &&
+        entry.size() <= kMaxCoalescedTensorBytes &&
+        last->tensors[0].first->size() <= kMaxCoalescedTensorBytes &&
+        entry.offset() >= last->offset + last->size &&
+        entry.offset() - (last->offset + last->size) <= kMaxCoalescedGapBytes &&
+        end - last->offset <= kMaxCoalescedReadBytes) {
+      last->size = end - last->offset;
+    } else {
+      reads.push_back({file, entry.offset(), entry.size(), {}});
+      last = &reads.back();
+    }
+    last->tensors.emplace_back(&entry, vals[i]);
+  }
+
+  if (pool == nullptr || reads.size() <= 1) {
+    for (const CoalescedRead& read : reads) {
+      TF_RETURN_IF_ERROR(RunCoalescedRead(read));
+    }
+    return Status::OK();
+  }
+  // Only the RandomAccessFiles, which are thread-safe, are shared by the reads.
+  mutex mu;
+  Status status;
+  BlockingCounter counter(reads.size());
+  for (const CoalescedRead& read : reads) {
+    pool->Schedule([&read, &mu, &status, &counter]() {
+      const Status s = RunCoalescedRead(read);
+      {
+        mutex_lock l(mu);
+        status.Update(s);
+      }
+      counter.DecrementCount();
+    });
+  }
+  counter.Wait();
+  return status;
+}
+
 Status BundleReader::GetSliceValue(StringPiece full_tensor_key,
                                    const BundleEntryProto& full_tensor_entry,
                                    const TensorSlice& slice_spec, Tensor* val) {
@@ -873,6 +1196,15 @@ Status BundleReader::GetSliceValue(StringPiece full_tensor_key,
       return status_;
     }
 
+    // Reads the overlap straight from the data file, without holding the
+    // whole stored slice in memory.
+    if (DataTypeCanUseMemcpy(stored_slice_entry.dtype())) {
+      status_ = GetSliceValueRanges(stored_slice_entry, full_shape,
+                                    stored_slice, slice_spec, val);
+      if (!status_.ok()) return status_;
+      continue;
+    }
+
     Tensor stored_slice_tensor(stored_slice_entry.dtype(), stored_slice_shape);
     status_ = GetValue(stored_slice_entry, &stored_slice_tensor);
     if (!status_.ok()) return status_;
@@ -909,6 +1241,114 @@ Status BundleReader::GetSliceValue(StringPiece full_tensor_key,
   return Status::OK();
 }
 
+Status BundleReader::GetSliceValueRanges(const BundleEntryProto& entry,
+                                         const TensorShape& full_shape,
+                                         const TensorSlice& stored_slice,
+                                         const TensorSlice& slice_spec,
+                                         Tensor* val) {
+  TensorSlice overlap;
+  if (!stored_slice.Intersect(slice_spec, &overlap)) return Status::OK();
+
+  // The start and length of the slices in each dimension.
+  const int dims = full_shape.dims();
+  std::vector<int64> stored_start(dims), stored_length(dims);
+  std::vector<int64> val_start(dims), val_length(dims);
+  std::vector<int64> overlap_start(dims), overlap_length(dims);
+  const auto get_extent = [&full_shape](const TensorSlice& slice, int d,
+                                        int64* start, int64* length) {
+    *start = slice.IsFullAt(d) ? 0 : slice.start(d);
+    *length = slice.IsFullAt(d) ? full_shape.dim_size(d) : slice.length(d);
+  };
+  int64 stored_elements = 1;
+  int64 overlap_elements = 1;
+  bool covers_stored_slice = true;
+  for (int d = 0; d < dims; ++d) {
+    get_extent(stored_slice, d, &stored_start[d], &stored_length[d]);
+    get_extent(slice_spec, d, &val_start[d], &val_length[d]);
+    get_extent(overlap, d, &overlap_start[d], &overlap_length[d]);
+    stored_elements *= stored_length[d];
+    overlap_elements *= overlap_length[d];
+    covers_stored_slice &= overlap_length[d] == stored_length[d];
+  }
+  const size_t element_size = DataTypeSize(entry.dtype());
+  if (entry.size() != stored_elements * element_size) {
+    return errors::DataLoss("Invalid size in bundle entry: key ", key(),
+                            "; stored size ", entry.size(),
+                            "; expected size ", stored_elements * element_size);
+  }
+
+  if (overlap_elements == 0) return Status::OK();
+
+  // The overlap is read in runs of elements contiguous in both the stored
+  // slice and "val": the innermost dimensions that the overlap covers in both,
+  // and a range of the next one.  The runs are read in file order.
+  int run_dim = dims;
+  int64 run_elements = 1;
+  while (run_dim > 0) {
+    --run_dim;
+    run_elements *= overlap_length[run_dim];
+    if (overlap_length[run_dim] != stored_length[run_dim] ||
+        overlap_length[run_dim] != val_length[run_dim]) {
+      break;
+    }
+  }
+  const size_t run_bytes = run_elements * element_size;
+  std::vector<int64> stored_stride(dims, 1), val_stride(dims, 1);
+  for (int d = dims - 2; d >= 0; --d) {
+    stored_stride[d] = stored_stride[d + 1] * stored_length[d + 1];
+    val_stride[d] = val_stride[d + 1] * val_length[d + 1];
+  }
+
+  io::InputBuffer* buffered_file;
+  TF_RETURN_IF_ERROR(GetDataFile(entry.shard_id(), &buffered_file));
+  char* val_data = const_cast<char*>(val->tensor_data().data());
+  uint32 actual_crc32c = 0;
+  // The index of the current run in the dimensions before "run_dim".
+  std::vector<int64> index(run_dim, 0);
+  while (true) {
+    int64 stored_offset = 0;
+    int64 val_offset = 0;
+    for (int d = 0; d < dims; ++d) {
+      const int64 i = overlap_start[d] + (d < run_dim ? index[d] : 0);
+      stored_offset += (i - stored_start[d]) * stored_stride[d];
+      val_offset += (i - val_start[d]) * val_stride[d];
+    }
+    char* destination = val_data + val_offset * element_size;
+    const int64 file_offset = entry.offset() + stored_offset * element_size;
+    // Small runs, as for a few columns of each row, go through the buffer of
+    // the data file, so that neighboring runs are read together.
+    if (run_bytes < (64 << 10)) {
+      TF_RETURN_IF_ERROR(buffered_file->Seek(file_offset));
+      size_t bytes_read;
+      TF_RETURN_IF_ERROR(
+          buffered_file->ReadNBytes(run_bytes, destination, &bytes_read));
+    } else {
+      TF_RETURN_IF_ERROR(ReadInputByChunk(buffered_file->file(), file_offset,
+                                          run_bytes, 8 << 20 /* 8MB buffer */,
+                                          destination));
+    }
+    if (covers_stored_slice) {
+      actual_crc32c = crc32c::Extend(actual_crc32c, destination, run_bytes);
+    }
+
+    int d = run_dim - 1;
+    for (; d >= 0; --d) {
+      if (++index[d] < overlap_length[d]) break;
+      index[d] = 0;
+    }
+    if (d < 0) break;
+  }
+
+  if (covers_stored_slice &&
+      crc32c::Unmask(entry.crc32c()) != actual_crc32c) {
+    return errors::DataLoss(
+        "Checksum does not match: stored ",
+        strings::Printf("%08u", crc32c::Unmask(entry.crc32c())),
+        " vs. calculated on the restored bytes ", actual_crc32c);
+  }
+  return Status::OK();
+}
+
 bool BundleReader::Contains(StringPiece key) {
   Seek(key);
   return Valid() && (this->key() == key);
@@ -39,7 +39,8 @@ limitations under the License.
 //   reader.Lookup("name", &tensor);
 //
 // A tensor bundle can be built using BundleWriter.  Each BundleWriter builds a
-// single data file bundle.  Multiple bundles can then be merged by
+// bundle of one data file, or of several written in parallel (see
+// BundleWriter::Options::num_shards).  Multiple bundles can then be merged by
 // MergeBundles() without reading and writing large chunk of data: it reads the
 // metadata files and outputs a single merged metadata.  Typical usage:
 //
@@ -64,13 +65,17 @@ limitations under the License.
 #include "tensorflow/core/protobuf/tensor_bundle.pb.h"
 
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_slice.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/array_slice.h"
 #include "tensorflow/core/lib/io/inputbuffer.h"
 #include "tensorflow/core/lib/io/table.h"
@@ -107,7 +112,20 @@ extern const char* const kHeaderEntryKey;
 // All threads accessing the same BundleWriter must synchronize.
 class BundleWriter {
  public:
-  BundleWriter(Env* env, StringPiece prefix);
+  struct Options {
+    Options() {}
+    // If larger than 1, the data of each non-string tensor starts at a multiple
+    // of this many bytes in the data file, so that a memory mapping of the file
+    // can back the tensor directly (see BundleReader::LookupAliased()).
+    int64 data_alignment = 1;
+    // The number of data files the tensors are split across.  With more than
+    // one, Add() only records the tensors, and Finish() balances them across
+    // the data files by size and writes the files in parallel, one thread
+    // each.  The added tensors must not be modified until Finish() returns.
+    int num_shards = 1;
+  };
+  BundleWriter(Env* env, StringPiece prefix,
+               const Options& options = Options());
 
   // Adds the tensor "val" under key "key".
   // Across calls "key" must be unique but can be added in any order.
@@ -139,13 +157,33 @@ class BundleWriter {
   Status status() const { return status_; }
 
  private:
+  // A data file being written.
+  struct DataFile {
+    string tmp_path;
+    std::unique_ptr<FileOutputBuffer> out;
+    int64 size = 0;  // Number of bytes written into "out".
+  };
+
+  // Creates the data file of shard "shard_id" out of "num_shards".
+  Status OpenDataFile(int shard_id, int num_shards, DataFile* file);
+
+  // Appends "val" to "file", and records where in "entry".
+  Status WriteTensorToFile(const Tensor& val, int shard_id, DataFile* file,
+                           BundleEntryProto* entry);
+
+  // Writes the tensors recorded by Add() to the data files in parallel.
+  Status WritePendingTensors();
+
   Env* const env_;  // Not owned.
+  const Options options_;
   const string prefix_;
   const string tmp_metadata_path_;
-  const string tmp_data_path_;
-  std::unique_ptr<FileOutputBuffer> out_;
-  int64 size_;  // Number of bytes written into out_.
+  // Indexed by shard id.  Opened by the constructor if there is one shard,
+  // otherwise by WritePendingTensors().
+  std::vector<DataFile> data_files_;
   std::map<string, BundleEntryProto> entries_;
+  // With several shards, the tensors to write and their entries.
+  std::vector<std::pair<BundleEntryProto*, Tensor>> pending_;
   Status status_;
 
   TF_DISALLOW_COPY_AND_ASSIGN(BundleWriter);
@@ -210,6 +248,18 @@ class BundleReader {
   // REQUIRES: status().ok()
   Status Lookup(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
 
+  // Like Lookup(), but sets "val" to a new tensor that aliases a read-only
+  // memory mapping of the data file instead of reading into a buffer, when the
+  // tensor is neither partitioned nor of type string, its data is suitably
+  // aligned in the file, and "env" can map the file.  Otherwise falls back to
+  // Lookup() into a newly allocated tensor.  The mapping stays alive as long as
+  // any tensor aliasing it, even after the reader is destroyed.
+  //
+  // Aliased tensors are read-only, and their pages are only read when used, so
+  // the stored checksum is not validated for them.
+  // REQUIRES: status().ok()
+  Status LookupAliased(StringPiece key, Tensor* val) TF_MUST_USE_RESULT;
+
   // Looks up the tensor pointed to by the internal iterator.
   //
   // On error, "val" may contain nonsense data.
@@ -231,10 +281,25 @@ class BundleReader {
   // Looks up a specific slice of a partitioned tensor.
   // It is only required that the stored slices cover the requested slice,
   // namely "slice_spec" is a subset of the union of the stored slices.
+  //
+  // Unless they are of type string, only the parts of the stored slices that
+  // overlap "slice_spec" are read, directly into "val", so this works for
+  // small slices of tensors that don't fit in memory.  The stored checksum of
+  // a slice is then only validated if "slice_spec" covers all of it.
   // REQUIRES: status().ok()
   Status LookupSlice(StringPiece full_tensor_key, const TensorSlice& slice_spec,
                      Tensor* val) TF_MUST_USE_RESULT;
 
+  // Looks up the tensors keyed by "keys" into "vals", like a Lookup() of each,
+  // but reads the data files concurrently on "pool" (if not null), and reads
+  // adjacent small tensors of a data file together.  Partitioned and string
+  // tensors are read one at a time, before the others.
+  //
+  // On error, "vals" may contain nonsense data.
+  // REQUIRES: status().ok() && keys.size() == vals.size()
+  Status LookupMany(gtl::ArraySlice<string> keys, gtl::ArraySlice<Tensor*> vals,
+                    thread::ThreadPool* pool) TF_MUST_USE_RESULT;
+
   // Seeks to the first position in the bundle whose key is no less than "key".
   // REQUIRES: status().ok()
   void Seek(StringPiece key) { return iter_->Seek(key); }
@@ -261,6 +326,10 @@ class BundleReader {
   Status GetBundleEntryProto(StringPiece key,
                              BundleEntryProto* entry) TF_MUST_USE_RESULT;
 
+  // Opens the data file of shard "shard_id", if it has not been opened.
+  Status GetDataFile(int32 shard_id,
+                     io::InputBuffer** buffered_file) TF_MUST_USE_RESULT;
+
   // Reads the tensor value described by the metadata proto "entry".
   // Usage for "val" follows the comment of "Lookup()".
   Status GetValue(const BundleEntryProto& entry,
@@ -274,6 +343,16 @@ class BundleReader {
                        const TensorSlice& slice_spec,
                        Tensor* val) TF_MUST_USE_RESULT;
 
+  // Reads the part of the stored slice "stored_slice" of a tensor of shape
+  // "full_shape", with metadata proto "entry", that overlaps "slice_spec" into
+  // "val", the tensor of "slice_spec".
+  // REQUIRES: DataTypeCanUseMemcpy(entry.dtype())
+  Status GetSliceValueRanges(const BundleEntryProto& entry,
+                             const TensorShape& full_shape,
+                             const TensorSlice& stored_slice,
+                             const TensorSlice& slice_spec,
+                             Tensor* val) TF_MUST_USE_RESULT;
+
   Env* env_;  // Not owned.
   const string prefix_;
 
@@ -284,6 +363,10 @@ class BundleReader {
   // Owned the InputBuffer objects and their underlying RandomAccessFile's.
   std::unordered_map<int32, io::InputBuffer*> data_;
 
+  // Memory mappings of the data files, opened on demand by LookupAliased().
+  std::unordered_map<int32, std::shared_ptr<ReadOnlyMemoryRegion>>
+      mapped_data_;
+
   // Maps each partitioned tensor's key to its stored slices (represented in a
   // TensorSliceSet).  Populated on-demand.
   std::unordered_map<string, checkpoint::TensorSliceSet*> tensor_slices_;
@@ -18,6 +18,7 @@ limitations under the License.
 #include <random>
 #include <vector>
 
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/framework/versions.pb.h"
@@ -364,6 +365,51 @@ TEST(TensorBundleTest, PartitionedVariables) {
   }
 }
 
+TEST(TensorBundleTest, RepartitionedSlices) {
+  // A [6, 4, 3] tensor of 0, 1, 2, ... saved in two slices along dimension 0,
+  // and read back in slices of other dimensions.
+  const TensorShape kFullShape({6, 4, 3});
+  Tensor full(DT_INT32, kFullShape);
+  test::FillFn<int32>(&full, [](int i) { return i; });
+  const auto full_tensor = full.tensor<int32, 3>();
+  {
+    BundleWriter writer(Env::Default(), Prefix("repartitioned"));
+    for (const char* spec : {"0,4:-:-", "4,2:-:-"}) {
+      const TensorSlice slice = TensorSlice::ParseOrDie(spec);
+      Tensor slice_val(DT_INT32, TensorShape({slice.length(0), 4, 3}));
+      slice_val.tensor<int32, 3>() = full_tensor.slice(
+          Eigen::DSizes<Eigen::DenseIndex, 3>(slice.start(0), 0, 0),
+          Eigen::DSizes<Eigen::DenseIndex, 3>(slice.length(0), 4, 3));
+      TF_ASSERT_OK(writer.AddSlice("foo", kFullShape, slice, slice_val));
+    }
+    // A tensor saved whole, read in slices.
+    TF_ASSERT_OK(writer.Add("bar", full));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  BundleReader reader(Env::Default(), Prefix("repartitioned"));
+  TF_ASSERT_OK(reader.status());
+  for (const char* key : {"foo", "bar"}) {
+    for (const char* spec : {"-:-:-", "3,2:-:-", "2,3:1,2:-", "-:-:1,1",
+                             "1,4:0,3:2,1", "5,1:3,1:-", "3,1:-:0,2"}) {
+      const TensorSlice slice = TensorSlice::ParseOrDie(spec);
+      TensorShape slice_shape;
+      TF_ASSERT_OK(slice.SliceTensorShape(kFullShape, &slice_shape));
+      Tensor expected(DT_INT32, slice_shape);
+      Eigen::DSizes<Eigen::DenseIndex, 3> start, length;
+      for (int d = 0; d < 3; ++d) {
+        start[d] = slice.IsFullAt(d) ? 0 : slice.start(d);
+        length[d] = slice_shape.dim_size(d);
+      }
+      expected.tensor<int32, 3>() = full_tensor.slice(start, length);
+
+      Tensor val(DT_INT32, slice_shape);
+      TF_ASSERT_OK(reader.LookupSlice(key, slice, &val)) << key << " " << spec;
+      test::ExpectTensorEqual<int32>(expected, val);
+    }
+  }
+}
+
 TEST(TensorBundleTest, EquivalentSliceTest) {
   const TensorShape kFullShape({5, 10});
   const Tensor kExpected(Constant<float>(1., kFullShape));
@@ -460,6 +506,181 @@ TEST(TensorBundleTest, StringTensors) {
   }
 }
 
+TEST(TensorBundleTest, LookupAliased) {
+  BundleWriter::Options options;
+  options.data_alignment = Allocator::kAllocatorAlignment;
+  {
+    BundleWriter writer(Env::Default(), Prefix("aliased"), options);
+    // The odd number of bytes in "int8s" would misalign the tensors after it
+    // without padding.
+    TF_EXPECT_OK(writer.Add("int8s", Constant<int8>(1, TensorShape({3}))));
+    TF_EXPECT_OK(writer.Add("strs", test::AsTensor<string>({"a", "bc"})));
+    TF_EXPECT_OK(writer.Add("floats", Constant_2x3<float>(16.18)));
+    TF_EXPECT_OK(writer.Add("doubles", Constant_2x3<double>(2.5)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  Tensor floats;
+  Tensor strs;
+  {
+    BundleReader reader(Env::Default(), Prefix("aliased"));
+    TF_ASSERT_OK(reader.status());
+    Expect<int8>(&reader, "int8s", Constant<int8>(1, TensorShape({3})));
+    Expect<double>(&reader, "doubles", Constant_2x3<double>(2.5));
+
+    // Aliased lookups of the same key share the mapped data.
+    Tensor floats_again;
+    TF_ASSERT_OK(reader.LookupAliased("floats", &floats));
+    TF_ASSERT_OK(reader.LookupAliased("floats", &floats_again));
+    EXPECT_EQ(floats.tensor_data().data(), floats_again.tensor_data().data());
+
+    // String tensors can't alias the data file, and are read instead.
+    TF_ASSERT_OK(reader.LookupAliased("strs", &strs));
+  }
+  // The aliased tensors outlive the reader.
+  test::ExpectTensorEqual<float>(floats, Constant_2x3<float>(16.18));
+  test::ExpectTensorEqual<string>(strs, test::AsTensor<string>({"a", "bc"}));
+}
+
+TEST(TensorBundleTest, LookupAliasedUnalignedData) {
+  {
+    BundleWriter writer(Env::Default(), Prefix("unaligned"));
+    TF_EXPECT_OK(writer.Add("int8s", Constant<int8>(1, TensorShape({3}))));
+    TF_EXPECT_OK(writer.Add("floats", Constant_2x3<float>(16.18)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  BundleReader reader(Env::Default(), Prefix("unaligned"));
+  TF_ASSERT_OK(reader.status());
+  // Misaligned tensors are read into new buffers instead.
+  Tensor floats;
+  TF_ASSERT_OK(reader.LookupAliased("floats", &floats));
+  test::ExpectTensorEqual<float>(floats, Constant_2x3<float>(16.18));
+}
+
+TEST(TensorBundleTest, MultipleDataFiles) {
+  Env* env = Env::Default();
+  BundleWriter::Options options;
+  options.data_alignment = Allocator::kAllocatorAlignment;
+  options.num_shards = 3;
+  {
+    BundleWriter writer(env, Prefix("multi"), options);
+    TF_EXPECT_OK(writer.Add("big", Constant<float>(1, TensorShape({1000}))));
+    TF_EXPECT_OK(writer.Add("strs", test::AsTensor<string>({"a", "bc"})));
+    for (int i = 0; i < 4; ++i) {
+      TF_EXPECT_OK(writer.Add(strings::StrCat("small", i),
+                              Constant<int8>(i, TensorShape({3}))));
+    }
+    TF_ASSERT_OK(writer.Finish());
+  }
+  for (int i = 0; i < 3; ++i) {
+    TF_EXPECT_OK(env->FileExists(DataFilename(Prefix("multi"), i, 3)));
+  }
+  auto ExpectTensors = [](BundleReader* reader) {
+    Expect<float>(reader, "big", Constant<float>(1, TensorShape({1000})));
+    Expect<string>(reader, "strs", test::AsTensor<string>({"a", "bc"}));
+    for (int i = 0; i < 4; ++i) {
+      Expect<int8>(reader, strings::StrCat("small", i),
+                   Constant<int8>(i, TensorShape({3})));
+    }
+  };
+  {
+    BundleReader reader(env, Prefix("multi"));
+    TF_ASSERT_OK(reader.status());
+    ExpectTensors(&reader);
+  }
+
+  // Merging renames the data files of both bundles.
+  {
+    BundleWriter writer(env, Prefix("single"));
+    TF_EXPECT_OK(writer.Add("other", Constant_2x3<double>(2.5)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  const string merged = Prefix("multi_merged");
+  TF_ASSERT_OK(MergeBundles(env, {Prefix("multi"), Prefix("single")}, merged));
+  for (int i = 0; i < 4; ++i) {
+    TF_EXPECT_OK(env->FileExists(DataFilename(merged, i, 4)));
+  }
+  BundleReader reader(env, merged);
+  TF_ASSERT_OK(reader.status());
+  ExpectTensors(&reader);
+  Expect<double>(&reader, "other", Constant_2x3<double>(2.5));
+}
+
+TEST(TensorBundleTest, MoreDataFilesThanTensors) {
+  BundleWriter::Options options;
+  options.num_shards = 8;
+  {
+    BundleWriter writer(Env::Default(), Prefix("few_tensors"), options);
+    TF_EXPECT_OK(writer.Add("a", Constant_2x3<int32>(1)));
+    TF_EXPECT_OK(writer.Add("b", Constant_2x3<int32>(2)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+  // No data file is left empty.
+  TF_EXPECT_OK(
+      Env::Default()->FileExists(DataFilename(Prefix("few_tensors"), 1, 2)));
+  BundleReader reader(Env::Default(), Prefix("few_tensors"));
+  TF_ASSERT_OK(reader.status());
+  Expect<int32>(&reader, "a", Constant_2x3<int32>(1));
+  Expect<int32>(&reader, "b", Constant_2x3<int32>(2));
+}
+
+TEST(TensorBundleTest, LookupMany) {
+  BundleWriter::Options options;
+  options.num_shards = 2;
+  {
+    BundleWriter writer(Env::Default(), Prefix("lookup_many"), options);
+    for (int i = 0; i < 10; ++i) {
+      TF_EXPECT_OK(writer.Add(strings::StrCat("small", i),
+                              Constant<int32>(i, TensorShape({3}))));
+    }
+    // Larger than the reads small tensors are coalesced into.
+    TF_EXPECT_OK(
+        writer.Add("big", Constant<float>(2.5, TensorShape({1 << 22}))));
+    TF_EXPECT_OK(writer.Add("strs", test::AsTensor<string>({"a", "bc"})));
+    TF_EXPECT_OK(writer.AddSlice("part", TensorShape({4, 3}),
+                                 TensorSlice::ParseOrDie("0,2:-"),
+                                 Constant_2x3<int64>(7)));
+    TF_EXPECT_OK(writer.AddSlice("part", TensorShape({4, 3}),
+                                 TensorSlice::ParseOrDie("2,2:-"),
+                                 Constant_2x3<int64>(8)));
+    TF_ASSERT_OK(writer.Finish());
+  }
+
+  thread::ThreadPool pool(Env::Default(), "test", 4);
+  const std::vector<thread::ThreadPool*> pools = {&pool, nullptr};
+  for (thread::ThreadPool* p : pools) {
+    BundleReader reader(Env::Default(), Prefix("lookup_many"));
+    TF_ASSERT_OK(reader.status());
+    // Skips some of the small tensors, leaving gaps between the others.
+    std::vector<string> keys = {"big", "strs", "part"};
+    std::vector<Tensor> vals = {Tensor(DT_FLOAT, TensorShape({1 << 22})),
+                                Tensor(DT_STRING, TensorShape({2})),
+                                Tensor(DT_INT64, TensorShape({4, 3}))};
+    for (int i = 0; i < 10; i += 3) {
+      keys.push_back(strings::StrCat("small", i));
+      vals.push_back(Tensor(DT_INT32, TensorShape({3})));
+    }
+    std::vector<Tensor*> val_ptrs;
+    for (Tensor& val : vals) val_ptrs.push_back(&val);
+    TF_ASSERT_OK(reader.LookupMany(keys, val_ptrs, p));
+
+    test::ExpectTensorEqual<float>(
+        Constant<float>(2.5, TensorShape({1 << 22})), vals[0]);
+    test::ExpectTensorEqual<string>(test::AsTensor<string>({"a", "bc"}),
+                                    vals[1]);
+    test::ExpectTensorEqual<int64>(
+        test::AsTensor<int64>({7, 7, 7, 7, 7, 7, 8, 8, 8, 8, 8, 8},
+                              TensorShape({4, 3})),
+        vals[2]);
+    for (int i = 0; i < 10; i += 3) {
+      test::ExpectTensorEqual<int32>(Constant<int32>(i, TensorShape({3})),
+                                     vals[3 + i / 3]);
+    }
+
+    std::vector<Tensor*> missing = {&vals[0]};
+    EXPECT_TRUE(errors::IsNotFound(reader.LookupMany({"missing"}, missing, p)));
+  }
+}
+
 TEST(TensorBundleTest, DirectoryStructure) {
   Env* env = Env::Default();
   // Writes two bundles.
@@ -15,17 +15,35 @@ limitations under the License.
 
 #include "tensorflow/core/util/work_sharder.h"
 
+#include <atomic>
+#include <memory>
+
 #include "tensorflow/core/lib/core/blocking_counter.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 
+namespace {
+
+thread_local int per_thread_max_parallelism = kint32max;
+
+}  // namespace
+
+void SetPerThreadMaxParallelism(int max_parallelism) {
+  CHECK_GE(max_parallelism, 1);
+  per_thread_max_parallelism = max_parallelism;
+}
+
+int GetPerThreadMaxParallelism() { return per_thread_max_parallelism; }
+
 void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
            int64 cost_per_unit, std::function<void(int64, int64)> work) {
   CHECK_GE(total, 0);
   if (total == 0) {
     return;
   }
+  max_parallelism = std::min(max_parallelism, GetPerThreadMaxParallelism());
   if (max_parallelism <= 1) {
     // Just inline the whole work since we only have 1 thread (core).
     work(0, total);
@@ -74,4 +92,52 @@ void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
   counter.Wait();
 }
 
+namespace {
+
+// The units of a ShardWithRunner() call.  Shared with the closures, which
+// may only start once the call has returned.
+struct RunnerShards {
+  RunnerShards(int64 total, std::function<void(int64)> work)
+      : total(total), work(std::move(work)) {}
+
+  // Does units until none is left.
+  void Run() {
+    for (int64 i = next.fetch_add(1); i < total; i = next.fetch_add(1)) {
+      work(i);
+      mutex_lock l(mu);
+      if (++num_done == total) done.notify_all();
+    }
+  }
+
+  const int64 total;
+  const std::function<void(int64)> work;
+  std::atomic<int64> next{0};
+  mutex mu;
+  condition_variable done;
+  int64 num_done GUARDED_BY(mu) = 0;
+};
+
+}  // namespace
+
+void ShardWithRunner(int max_parallelism,
+                     std::function<void(std::function<void()>)> runner,
+                     int64 total, std::function<void(int64)> work) {
+  CHECK_GE(total, 0);
+  const int64 num_closures = std::min<int64>(max_parallelism, total) - 1;
+  if (num_closures <= 0 || runner == nullptr) {
+    for (int64 i = 0; i < total; ++i) work(i);
+    return;
+  }
+  auto shards = std::make_shared<RunnerShards>(total, std::move(work));
+  for (int64 k = 0; k < num_closures; ++k) {
+    runner([shards]() { shards->Run(); });
+  }
+  shards->Run();
+  // The units still pending were taken by closures that are running.
+  mutex_lock l(shards->mu);
+  while (shards->num_done < total) {
+    shards->done.wait(l);
+  }
+}
+
 }  // end namespace tensorflow
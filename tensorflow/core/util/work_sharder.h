@@ -45,9 +45,50 @@ namespace tensorflow {
 // REQUIRES: workers != nullptr
 // REQUIRES: total >= 0
 // REQUIRES: cost_per_unit >= 0
+//
+// The parallelism is further bounded by GetPerThreadMaxParallelism().
 void Shard(int max_parallelism, thread::ThreadPool* workers, int64 total,
            int64 cost_per_unit, std::function<void(int64, int64)> work);
 
+// Limits the parallelism of the intra-op work started on the calling thread:
+// Shard() and DeviceBase::eigen_cpu_device() use at most "max_parallelism"
+// threads there.  The executor sets it while running the kernels of a step
+// with RunOptions.max_intra_op_parallelism.
+// REQUIRES: max_parallelism >= 1
+void SetPerThreadMaxParallelism(int max_parallelism);
+
+// Returns the limit set by SetPerThreadMaxParallelism() on the calling thread,
+// or kint32max if there is none.
+int GetPerThreadMaxParallelism();
+
+// Sets the per-thread maximum parallelism of the calling thread for its
+// lifetime, and restores the previous one on destruction.
+class ScopedPerThreadMaxParallelism {
+ public:
+  explicit ScopedPerThreadMaxParallelism(int max_parallelism)
+      : previous_(GetPerThreadMaxParallelism()) {
+    SetPerThreadMaxParallelism(max_parallelism);
+  }
+
+  ~ScopedPerThreadMaxParallelism() { SetPerThreadMaxParallelism(previous_); }
+
+ private:
+  const int previous_;
+};
+
+// Calls work(i) for each i in [0, total), on the calling thread and on up
+// to "max_parallelism - 1" closures passed to "runner".  The units are
+// handed out one at a time to whichever thread asks first, and the
+// calling thread keeps taking them until none is left, so it never waits
+// for a closure that hasn't started.  Unlike Shard(), this makes it safe
+// to call from a thread of the pool that "runner" schedules on.  Meant
+// for a few large units of work, e.g. building one graph per device.
+//
+// REQUIRES: total >= 0
+void ShardWithRunner(int max_parallelism,
+                     std::function<void(std::function<void()>)> runner,
+                     int64 total, std::function<void(int64)> work);
+
 }  // end namespace tensorflow
 
 #endif  // TENSORFLOW_UTIL_WORK_SHARDER_H_
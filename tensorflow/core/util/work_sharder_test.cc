@@ -76,6 +76,58 @@ TEST(Shard, OverflowTest) {
   }
 }
 
+TEST(Shard, PerThreadMaxParallelism) {
+  thread::ThreadPool threads(Env::Default(), "test", 16);
+  EXPECT_EQ(kint32max, GetPerThreadMaxParallelism());
+  {
+    ScopedPerThreadMaxParallelism limit(2);
+    EXPECT_EQ(2, GetPerThreadMaxParallelism());
+    mutex mu;
+    int64 num_shards = 0;
+    Shard(16, &threads, 1000, 1000000, [&mu, &num_shards](int64, int64) {
+      mutex_lock l(mu);
+      ++num_shards;
+    });
+    EXPECT_EQ(2, num_shards);
+    {
+      ScopedPerThreadMaxParallelism inner_limit(1);
+      EXPECT_EQ(1, GetPerThreadMaxParallelism());
+    }
+    EXPECT_EQ(2, GetPerThreadMaxParallelism());
+  }
+  EXPECT_EQ(kint32max, GetPerThreadMaxParallelism());
+}
+
+TEST(ShardWithRunner, Basic) {
+  thread::ThreadPool threads(Env::Default(), "test", 4);
+  auto runner = [&threads](std::function<void()> fn) {
+    threads.Schedule(std::move(fn));
+  };
+  for (auto max_parallelism : {0, 1, 2, 4, 16}) {
+    for (auto total : {0, 1, 3, 10, 100}) {
+      std::vector<std::atomic<int>> work(total);
+      for (auto& w : work) w = 0;
+      ShardWithRunner(max_parallelism, runner, total,
+                      [&work](int64 i) { ++work[i]; });
+      for (const auto& w : work) EXPECT_EQ(1, w);
+    }
+  }
+}
+
+TEST(ShardWithRunner, DoesNotWaitForClosuresThatDontStart) {
+  // The closures only run once the call has returned, as if they were
+  // queued behind the caller on a busy pool.
+  std::vector<std::function<void()>> closures;
+  int64 num_done = 0;
+  ShardWithRunner(
+      4, [&closures](std::function<void()> fn) { closures.push_back(fn); },
+      10, [&num_done](int64 i) { ++num_done; });
+  EXPECT_EQ(10, num_done);
+  EXPECT_EQ(3, closures.size());
+  for (auto& fn : closures) fn();
+  EXPECT_EQ(10, num_done);
+}
+
 void BM_Sharding(int iters, int arg) {
   thread::ThreadPool threads(Env::Default(), "test", 16);
   const int64 total = 1LL << 30;
@@ -199,6 +199,43 @@ public final class Tensor implements AutoCloseable {
     return t;
   }
 
+  /**
+   * Create a Tensor that shares the memory of a direct buffer.
+   *
+   * <p>Unlike {@link #create(DataType, long[], ByteBuffer)}, this does not copy the data: the
+   * Tensor is backed by the memory of {@code data} between its position and its limit, which must
+   * hold the tensor's elements in native byte order (see {@link ByteOrder#nativeOrder()}). This
+   * saves a copy when feeding large tensors to {@link Session.Runner#feed(String, Tensor)}. The
+   * buffer is kept from being garbage collected until both the Tensor is closed and TensorFlow no
+   * longer uses it, and changes made to its contents in the meantime are visible to TensorFlow.
+   *
+   * <p>TensorFlow copies the data after all if the memory of {@code data} is not aligned the way
+   * it requires, which buffers returned by {@link ByteBuffer#allocateDirect(int)} may not be.
+   *
+   * @param dataType the tensor datatype, which must not be {@link DataType#STRING}.
+   * @param shape the tensor shape.
+   * @param data a direct buffer containing the tensor data.
+   * @throws IllegalArgumentException If {@code data} is not a direct buffer, or if the tensor
+   *     datatype or shape is not compatible with it
+   */
+  public static Tensor wrap(DataType dataType, long[] shape, ByteBuffer data) {
+    if (!data.isDirect()) {
+      throw new IllegalArgumentException("only direct buffers can be wrapped by a Tensor");
+    }
+    int elemBytes = elemByteSize(dataType);
+    if (data.remaining() != numElements(shape) * elemBytes) {
+      throw new IllegalArgumentException(
+          String.format(
+              "ByteBuffer with %d bytes is not compatible with a %s Tensor with shape %s",
+              data.remaining(), dataType.toString(), Arrays.toString(shape)));
+    }
+    Tensor t = new Tensor();
+    t.dtype = dataType;
+    t.shapeCopy = Arrays.copyOf(shape, shape.length);
+    t.nativeHandle = allocateForDirectBuffer(t.dtype.c(), t.shapeCopy, data.slice());
+    return t;
+  }
+
   // Helper function to allocate a Tensor for the create() methods that create a Tensor from
   // a java.nio.Buffer.
   private static Tensor allocateForBuffer(DataType dataType, long[] shape, int nBuffered) {
@@ -440,6 +477,20 @@ public final class Tensor implements AutoCloseable {
     dst.put(src);
   }
 
+  /**
+   * Returns a read-only view of the tensor data, in native byte order.
+   *
+   * <p>Unlike the {@code writeTo} methods, this does not copy the data, which is useful to read
+   * large tensors fetched by {@link Session.Runner#run()}. The tensor data may be shared with the
+   * graph it was fetched from, hence the view is read-only.
+   *
+   * <p><b>WARNING:</b> The view is only valid until {@link #close()} is called. Accessing it
+   * afterwards reads freed memory.
+   */
+  public ByteBuffer asReadOnlyBuffer() {
+    return buffer().asReadOnlyBuffer().order(ByteOrder.nativeOrder());
+  }
+
   /** Returns a string describing the type and shape of the Tensor. */
   @Override
   public String toString() {
@@ -596,6 +647,8 @@ public final class Tensor implements AutoCloseable {
 
   private static native long allocateScalarBytes(byte[] value);
 
+  private static native long allocateForDirectBuffer(int dtype, long[] shape, ByteBuffer data);
+
   private static native void delete(long handle);
 
   private static native ByteBuffer buffer(long handle);
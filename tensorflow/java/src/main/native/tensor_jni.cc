@@ -62,6 +62,36 @@ size_t elemByteSize(TF_DataType dtype) {
   }
 }
 
+// Keeps a direct java.nio.ByteBuffer reachable, and so its memory allocated,
+// for as long as a TF_Tensor created over that memory is alive.
+struct PinnedBuffer {
+  JavaVM* vm;
+  jobject buffer;  // A global reference.
+};
+
+// The TF_NewTensor deallocator of tensors that wrap a direct buffer.
+void releasePinnedBuffer(void* data, size_t len, void* arg) {
+  PinnedBuffer* pinned = static_cast<PinnedBuffer*>(arg);
+  // The last reference to the tensor may be dropped on one of the threads of
+  // the TensorFlow runtime, which the JVM does not know about yet.
+  JNIEnv* env = nullptr;
+  bool attached = false;
+  if (pinned->vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) ==
+      JNI_EDETACHED) {
+#ifdef __ANDROID__
+    pinned->vm->AttachCurrentThread(&env, nullptr);
+#else
+    pinned->vm->AttachCurrentThread(reinterpret_cast<void**>(&env), nullptr);
+#endif
+    attached = true;
+  }
+  env->DeleteGlobalRef(pinned->buffer);
+  if (attached) {
+    pinned->vm->DetachCurrentThread();
+  }
+  delete pinned;
+}
+
 // Write a Java scalar object (java.lang.Integer etc.) to a TF_Tensor.
 void writeScalar(JNIEnv* env, jobject src, TF_DataType dtype, void* dst,
                  size_t dst_size) {
@@ -284,6 +314,34 @@ JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocateScalarBytes(
   return reinterpret_cast<jlong>(t);
 }
 
+JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocateForDirectBuffer(
+    JNIEnv* env, jclass clazz, jint dtype, jlongArray shape, jobject buffer) {
+  void* data = env->GetDirectBufferAddress(buffer);
+  if (data == nullptr) {
+    throwException(env, kIllegalArgumentException,
+                   "the buffer of a wrapped Tensor must be a direct buffer");
+    return 0;
+  }
+  const size_t sz = static_cast<size_t>(env->GetDirectBufferCapacity(buffer));
+  int num_dims = static_cast<int>(env->GetArrayLength(shape));
+  std::unique_ptr<int64_t[]> dims(new int64_t[num_dims]);
+  if (num_dims > 0) {
+    jlong* src = env->GetLongArrayElements(shape, nullptr);
+    for (int i = 0; i < num_dims; ++i) {
+      dims[i] = static_cast<int64_t>(src[i]);
+    }
+    env->ReleaseLongArrayElements(shape, src, JNI_ABORT);
+  }
+  PinnedBuffer* pinned = new PinnedBuffer;
+  env->GetJavaVM(&pinned->vm);
+  pinned->buffer = env->NewGlobalRef(buffer);
+  // TF_NewTensor copies the data instead if it is not aligned the way
+  // TensorFlow needs, and releases the buffer right away.
+  TF_Tensor* t = TF_NewTensor(static_cast<TF_DataType>(dtype), dims.get(),
+                              num_dims, data, sz, releasePinnedBuffer, pinned);
+  return reinterpret_cast<jlong>(t);
+}
+
 JNIEXPORT void JNICALL Java_org_tensorflow_Tensor_delete(JNIEnv* env,
                                                          jclass clazz,
                                                          jlong handle) {
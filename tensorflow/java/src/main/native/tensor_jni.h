@@ -38,6 +38,14 @@ JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocate(JNIEnv *, jclass,
 JNIEXPORT jlong JNICALL
 Java_org_tensorflow_Tensor_allocateScalarBytes(JNIEnv *, jclass, jbyteArray);
 
+/*
+ * Class:     org_tensorflow_Tensor
+ * Method:    allocateForDirectBuffer
+ * Signature: (I[JLjava/nio/ByteBuffer;)J
+ */
+JNIEXPORT jlong JNICALL Java_org_tensorflow_Tensor_allocateForDirectBuffer(
+    JNIEnv *, jclass, jint, jlongArray, jobject);
+
 /*
  * Class:     org_tensorflow_Tensor
  * Method:    delete
@@ -158,6 +158,62 @@ public class TensorTest {
     }
   }
 
+  @Test
+  public void wrapDirectBuffer() {
+    float[][] matrix = {{1f, 2f, 3f}, {4f, 5f, 6f}};
+    ByteBuffer buf = ByteBuffer.allocateDirect(8 + 6 * 4).order(ByteOrder.nativeOrder());
+    buf.putLong(42L); // Only the data past the position is wrapped.
+    for (float[] row : matrix) {
+      for (float f : row) {
+        buf.putFloat(f);
+      }
+    }
+    buf.position(8);
+    try (Tensor t = Tensor.wrap(DataType.FLOAT, new long[] {2, 3}, buf)) {
+      assertEquals(DataType.FLOAT, t.dataType());
+      assertArrayEquals(new long[] {2, 3}, t.shape());
+      assertEquals(6 * 4, t.numBytes());
+      assertArrayEquals(matrix, t.copyTo(new float[2][3]));
+    }
+    // The buffer itself is left as it was.
+    assertEquals(8, buf.position());
+  }
+
+  @Test
+  public void failWrapOnIncompatibleBuffer() {
+    try (Tensor t = Tensor.wrap(DataType.INT32, new long[] {2}, ByteBuffer.allocate(8))) {
+      fail("should fail on wrapping a buffer that is not direct");
+    } catch (IllegalArgumentException e) {
+      // The expected exception.
+    }
+    try (Tensor t = Tensor.wrap(DataType.INT32, new long[] {3}, ByteBuffer.allocateDirect(8))) {
+      fail("should fail on wrapping a buffer of the wrong size");
+    } catch (IllegalArgumentException e) {
+      // The expected exception.
+    }
+    try (Tensor t = Tensor.wrap(DataType.STRING, new long[] {}, ByteBuffer.allocateDirect(8))) {
+      fail("should fail on wrapping a buffer for a STRING tensor");
+    } catch (IllegalArgumentException e) {
+      // The expected exception.
+    }
+  }
+
+  @Test
+  public void asReadOnlyBuffer() {
+    long[] longs = {1L, 2L, 3L};
+    try (Tensor t = Tensor.create(longs)) {
+      ByteBuffer view = t.asReadOnlyBuffer();
+      assertTrue(view.isReadOnly());
+      assertTrue(view.isDirect());
+      assertEquals(ByteOrder.nativeOrder(), view.order());
+      assertEquals(t.numBytes(), view.remaining());
+      LongBuffer values = view.asLongBuffer();
+      for (int i = 0; i < longs.length; ++i) {
+        assertEquals(longs[i], values.get(i));
+      }
+    }
+  }
+
   @Test
   public void writeTo() {
     int[] ints = {1, 2, 3};
@@ -16,6 +16,26 @@ limitations under the License.
 %include "tensorflow/python/lib/core/strings.i"
 %include "tensorflow/python/platform/base.i"
 
+// Writing and flushing may take long on remote file systems, during which the
+// other threads, e.g. the training loop, should run.
+%feature("except") tensorflow::EventsWriter::WriteSerializedEvent {
+  Py_BEGIN_ALLOW_THREADS
+  $action
+  Py_END_ALLOW_THREADS
+}
+
+%feature("except") tensorflow::EventsWriter::Flush {
+  Py_BEGIN_ALLOW_THREADS
+  $action
+  Py_END_ALLOW_THREADS
+}
+
+%feature("except") tensorflow::EventsWriter::Close {
+  Py_BEGIN_ALLOW_THREADS
+  $action
+  Py_END_ALLOW_THREADS
+}
+
 %{
 #include "tensorflow/core/util/events_writer.h"
 #include "tensorflow/core/util/event.pb.h"
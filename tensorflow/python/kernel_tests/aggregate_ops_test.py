@@ -61,6 +61,23 @@ class AddNTest(test.TestCase):
           tol = 5e-3 if dtype == dtypes.float16 else 5e-7
           self.assertAllClose(expected, actual, rtol=tol, atol=tol)
 
+  def testAddNManyInputs(self):
+    # Past 9 inputs, AddN sums all of them in a single pass over the output,
+    # tile by tile on the CPU. Use shapes that span several tiles, and one
+    # that ends in a partial tile.
+    np.random.seed(12345)
+    with self.test_session(use_gpu=True) as sess:
+      for dtype in [dtypes.float16, dtypes.float32, dtypes.float64]:
+        # Keep the rounding errors of float16 sums in check.
+        counts = [11, 17] if dtype == dtypes.float16 else [11, 17, 64]
+        for count in counts:
+          for shape in [(3,), (100, 257)]:
+            data = [self._buildData(shape, dtype) for _ in range(count)]
+            actual = sess.run(math_ops.add_n(data))
+            expected = np.sum(np.stack(data).astype(np.float64), axis=0)
+            tol = 1e-1 if dtype == dtypes.float16 else 5e-5
+            self.assertAllClose(expected, actual, rtol=tol, atol=tol)
+
   def testUnknownShapes(self):
     np.random.seed(12345)
     with self.test_session(use_gpu=True) as sess:
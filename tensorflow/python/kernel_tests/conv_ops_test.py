@@ -1350,6 +1350,13 @@ class DeepConv2DTest(test.TestCase):
 
       self.assertAllClose(values_expect, values_test, rtol=1e-5, atol=1e-5)
 
+      # When the variable is unset, DeepConv2D is selected by its cost model,
+      # and uses the transformed filters cached by the previous run.
+      del os.environ["TF_USE_DEEP_CONV2D"]
+      values_auto = sess.run([conv])
+
+      self.assertAllClose(values_expect, values_auto, rtol=1e-5, atol=1e-5)
+
   def _RunTestCases(self, conv_strides, padding):
     input_sizes = [[5, 5, 5, 1248], [3, 17, 17, 192], [2, 35, 35, 288],
                    [2, 6, 8, 517], [2, 7, 4, 81], [3, 11, 3, 77]]
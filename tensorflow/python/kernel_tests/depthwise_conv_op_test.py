@@ -39,14 +39,15 @@ def ConfigsToTest():
   """
   input_sizes = [[4, 5, 5, 48], [4, 8, 8, 84], [4, 17, 17, 48], [4, 9, 27, 8],
                  [4, 31, 31, 7], [4, 35, 35, 2], [4, 147, 147, 2],
-                 [3, 299, 299, 3], [5, 183, 183, 1]]
+                 [3, 299, 299, 3], [5, 183, 183, 1], [2, 20, 23, 19]]
   filter_sizes = [[1, 1, 48, 2], [1, 3, 84, 1], [3, 1, 48, 4], [3, 3, 8, 1],
                   [3, 3, 7, 1], [5, 5, 2, 1], [3, 3, 2, 8], [2, 2, 3,
-                                                             8], [5, 5, 1, 2]]
+                                                             8], [5, 5, 1, 2],
+                  [3, 3, 19, 1]]
   out_sizes = [[4, 5, 5, 96], [4, 8, 8, 84], [4, 17, 17, 192], [4, 9, 27, 8],
                [4, 31, 31, 7], [4, 35, 35, 2], [4, 49, 49, 16],
-               [3, 150, 150, 24], [5, 92, 92, 2]]
-  strides = [1, 1, 1, 1, 1, 1, 3, 2, 2]
+               [3, 150, 150, 24], [5, 92, 92, 2], [2, 10, 12, 19]]
+  strides = [1, 1, 1, 1, 1, 1, 3, 2, 2, 2]
   # pylint: disable=invalid-name
   VALID = "VALID"
   SAME = "SAME"
@@ -68,17 +69,17 @@ def CheckGradConfigsToTest():
     convolution parameters.
   """
   input_sizes = [[2, 5, 8, 1], [4, 5, 5, 1], [2, 4, 4, 2], [1, 15, 15, 2],
-                 [2, 15, 16, 1]]
+                 [2, 15, 16, 1], [2, 7, 9, 5]]
   filter_sizes = [[4, 4, 1, 2], [2, 2, 1, 2], [3, 1, 2, 2], [1, 3, 2, 1],
-                  [3, 3, 1, 2]]
+                  [3, 3, 1, 2], [3, 3, 5, 1]]
   out_sizes = [[2, 5, 8, 2], [4, 2, 2, 2], [2, 4, 4, 4], [1, 15, 15, 2],
-               [2, 5, 5, 2]]
-  strides = [1, 2, 1, 1, 3]
+               [2, 5, 5, 2], [2, 4, 5, 5]]
+  strides = [1, 2, 1, 1, 3, 2]
   # pylint: disable=invalid-name
   VALID = "VALID"
   SAME = "SAME"
   # pylint: enable=invalid-name
-  paddings = [SAME, VALID, SAME, SAME, VALID]
+  paddings = [SAME, VALID, SAME, SAME, VALID, SAME]
   for i, f, o, s, p in zip(input_sizes, filter_sizes, out_sizes, strides,
                            paddings):
     yield i, f, o, s, p
@@ -36,12 +36,14 @@ def ConfigsToTest():
     convolution parameters.
   """
   input_sizes = [[4, 5, 5, 48], [4, 8, 8, 84], [4, 17, 17, 48], [4, 35, 35, 2],
-                 [4, 147, 147, 2], [3, 299, 299, 3], [5, 183, 183, 1]]
+                 [4, 147, 147, 2], [3, 299, 299, 3], [5, 183, 183, 1],
+                 [2, 20, 23, 35]]
   filter_sizes = [[1, 1, 48, 2], [1, 3, 84, 1], [3, 1, 48, 4], [5, 5, 2, 1],
-                  [3, 3, 2, 8], [2, 2, 3, 8], [5, 5, 1, 2]]
+                  [3, 3, 2, 8], [2, 2, 3, 8], [5, 5, 1, 2], [3, 3, 35, 1]]
   out_sizes = [[4, 5, 5, 96], [4, 8, 8, 84], [4, 17, 17, 192], [4, 35, 35, 2],
-               [4, 49, 49, 16], [3, 150, 150, 24], [5, 92, 92, 2]]
-  strides = [1, 1, 1, 1, 3, 2, 2]
+               [4, 49, 49, 16], [3, 150, 150, 24], [5, 92, 92, 2],
+               [2, 10, 12, 35]]
+  strides = [1, 1, 1, 1, 3, 2, 2, 2]
   # pylint: disable=invalid-name
   VALID = "VALID"
   SAME = "SAME"
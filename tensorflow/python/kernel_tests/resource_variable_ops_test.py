@@ -32,6 +32,7 @@ from tensorflow.python.ops import resource_variable_ops
 from tensorflow.python.ops import variable_scope
 from tensorflow.python.ops import variables
 from tensorflow.python.platform import test
+from tensorflow.python.training import training_ops
 
 
 class ResourceVariableOpsTest(test_util.TensorFlowTestCase):
@@ -92,6 +93,68 @@ class ResourceVariableOpsTest(test_util.TensorFlowTestCase):
       read = resource_variable_ops.read_variable_op(handle, dtype=dtypes.int32)
       self.assertEqual(read.eval(), 2)
 
+  def testReadSurvivesAssignAdd(self):
+    with self.test_session() as session:
+      handle = resource_variable_ops.var_handle_op(dtype=dtypes.int32, shape=[])
+      create = resource_variable_ops.assign_variable_op(
+          handle, constant_op.constant(1, dtype=dtypes.int32))
+      with ops.control_dependencies([create]):
+        first_read = resource_variable_ops.read_variable_op(
+            handle, dtype=dtypes.int32)
+      with ops.control_dependencies([first_read]):
+        write = resource_variable_ops.assign_add_variable_op(
+            handle, constant_op.constant(1, dtype=dtypes.int32))
+      with ops.control_dependencies([write]):
+        second_read = resource_variable_ops.read_variable_op(
+            handle, dtype=dtypes.int32)
+      f, s = session.run([first_read, second_read])
+      self.assertEqual(f, 1)
+      self.assertEqual(s, 2)
+
+  def testConcurrentUnlockedAppliesAreNotLost(self):
+    num_threads = 4
+    num_applies = 200
+    with self.test_session() as session:
+      var = resource_variable_ops.var_handle_op(
+          dtype=dtypes.float32, shape=[num_threads, 8])
+      accum = resource_variable_ops.var_handle_op(
+          dtype=dtypes.float32, shape=[num_threads, 8])
+      session.run([
+          resource_variable_ops.assign_variable_op(
+              var, array_ops.zeros([num_threads, 8])),
+          resource_variable_ops.assign_variable_op(
+              accum, array_ops.zeros([num_threads, 8]))
+      ])
+      # Each thread updates its own row, so an update can only be lost if an
+      # apply writes to a buffer that the variable no longer holds.
+      applies = [
+          training_ops.resource_sparse_apply_momentum(
+              var, accum, constant_op.constant(1.0),
+              array_ops.ones([1, 8]), constant_op.constant([i]),
+              constant_op.constant(0.0), use_locking=False)
+          for i in range(num_threads)
+      ]
+      read = resource_variable_ops.read_variable_op(var, dtype=dtypes.float32)
+
+      def apply_loop(apply_op):
+        for _ in range(num_applies):
+          session.run(apply_op)
+
+      def read_loop():
+        for _ in range(num_applies):
+          session.run(read)
+
+      threads = [self.checkedThread(target=apply_loop, args=(apply_op,))
+                 for apply_op in applies]
+      threads.append(self.checkedThread(target=read_loop))
+      for t in threads:
+        t.start()
+      for t in threads:
+        t.join()
+      self.assertAllEqual(
+          np.full([num_threads, 8], -num_applies, dtype=np.float32),
+          read.eval())
+
   def testScatterAdd(self):
     with self.test_session():
       handle = resource_variable_ops.var_handle_op(
@@ -103,6 +166,25 @@ class ResourceVariableOpsTest(test_util.TensorFlowTestCase):
       read = resource_variable_ops.read_variable_op(handle, dtype=dtypes.int32)
       self.assertEqual(read.eval(), [[3]])
 
+  def testTakeDirtyRows(self):
+    with self.test_session():
+      handle = resource_variable_ops.var_handle_op(
+          dtype=dtypes.int32, shape=[6, 1])
+      resource_variable_ops.assign_variable_op(
+          handle, constant_op.constant([[0]] * 6, dtype=dtypes.int32)).run()
+      take = resource_variable_ops.resource_take_dirty_rows(handle)
+      # The first call returns all the rows.
+      self.assertAllEqual([0, 1, 2, 3, 4, 5], take.eval())
+      self.assertAllEqual([], take.eval())
+      resource_variable_ops.resource_scatter_add(
+          handle, [4, 1, 4],
+          constant_op.constant([[1]] * 3, dtype=dtypes.int32)).run()
+      self.assertAllEqual([1, 4], take.eval())
+      resource_variable_ops.assign_add_variable_op(
+          handle, constant_op.constant([[1]] * 6, dtype=dtypes.int32)).run()
+      self.assertAllEqual([0, 1, 2, 3, 4, 5], take.eval())
+      self.assertAllEqual([], take.eval())
+
   def testGPU(self):
     with self.test_session(use_gpu=True) as sess:
       abc = variable_scope.get_variable(
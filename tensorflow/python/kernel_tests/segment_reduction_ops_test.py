@@ -320,6 +320,36 @@ class UnsortedSegmentSumTest(SegmentReductionHelper):
             r"segment_ids\[0,0\] = %d is out of range \[0, 2\)" % bad[0][0]):
           unsorted.eval()
 
+  def testLargeValues(self):
+    # Large enough for the reduction to be split across threads, with few
+    # segments and with many segments.
+    num_rows = 4000
+    for num_segments in 10, 6000:
+      indices = np.random.randint(0, num_segments, num_rows)
+      with self.test_session(use_gpu=False):
+        tf_x, np_x = self._input([num_rows, 32], dtype=dtypes_lib.float32)
+        np_sum = np.zeros([num_segments, 32], dtype=np.float32)
+        np.add.at(np_sum, indices, np_x)
+        np_max = np.full([num_segments, 32], np.finfo(np.float32).min,
+                         dtype=np.float32)
+        np.maximum.at(np_max, indices, np_x)
+        tf_sum = math_ops.unsorted_segment_sum(
+            data=tf_x, segment_ids=indices, num_segments=num_segments)
+        tf_max = math_ops.unsorted_segment_max(
+            data=tf_x, segment_ids=indices, num_segments=num_segments)
+        self.assertAllClose(np_sum, tf_sum.eval())
+        self.assertAllClose(np_max, tf_max.eval())
+
+  def testBadIndicesLarge(self):
+    indices = np.zeros([4000], dtype=np.int32)
+    indices[3000] = 10
+    with self.test_session(use_gpu=False):
+      unsorted = math_ops.unsorted_segment_sum(
+          np.ones([4000, 32], dtype=np.float32), indices, num_segments=10)
+      with self.assertRaisesOpError(
+          r"segment_ids\[3000\] = 10 is out of range \[0, 10\)"):
+        unsorted.eval()
+
   def testEmptySecondDimension(self):
     dtypes = [
         np.float32, np.float64, np.int64, np.int32, np.complex64, np.complex128
@@ -431,6 +461,26 @@ class SparseSegmentReductionOpTest(SparseSegmentReductionHelper):
         tf_ans = s.eval()
         self.assertAllClose(np_ans, tf_ans)
 
+  def testValuesManySegments(self):
+    # Enough segments, with holes between them, for the reduction to be split
+    # across threads.
+    ops_list = [(np.add, None, math_ops.sparse_segment_sum),
+                (self._mean_cum_op, self._mean_reduce_op,
+                 math_ops.sparse_segment_mean)]
+    segment_indices = []
+    for i in range(2000):
+      for _ in range(i % 5):
+        segment_indices.append(2 * i + 1)
+    with self.test_session(use_gpu=False):
+      tf_indices, np_indices, tf_x, np_x = self._sparse_input(
+          [1000, 64], len(segment_indices), dtype=dtypes_lib.float32)
+      for np_op1, np_op2, tf_op in ops_list:
+        np_ans = self._sparseSegmentReduce(np_x, np_indices, segment_indices,
+                                           np_op1, np_op2)
+        s = tf_op(data=tf_x, indices=tf_indices, segment_ids=segment_indices)
+        tf_ans = s.eval()
+        self.assertAllClose(np_ans, tf_ans)
+
   def testValid(self):
     # Baseline for the test*Invalid* methods below.
     tf_x, _ = self._input([10, 4], dtype=dtypes_lib.float32)
@@ -466,6 +516,20 @@ class SparseSegmentReductionOpTest(SparseSegmentReductionHelper):
             r"indices\[3\] == 10 out of range \[0, 10\)"):
           s.eval()
 
+  def testIndicesInvalidManySegments(self):
+    tf_x, _ = self._input([10, 4], dtype=dtypes_lib.float32)
+    ops_list = [math_ops.sparse_segment_sum, math_ops.sparse_segment_mean]
+    segment_indices = list(range(5000))
+    tf_indices = [i % 10 for i in range(5000)]
+    tf_indices[3000] = 10
+    tf_indices[4000] = -1
+    with self.test_session(use_gpu=False):
+      for tf_op in ops_list:
+        s = tf_op(data=tf_x, indices=tf_indices, segment_ids=segment_indices)
+        with self.assertRaisesOpError(
+            r"indices\[3000\] == 10 out of range \[0, 10\)"):
+          s.eval()
+
   def testSegmentsInvalid2(self):
     tf_x, _ = self._input([10, 4], dtype=dtypes_lib.float32)
     ops_list = [math_ops.sparse_segment_sum, math_ops.sparse_segment_mean]
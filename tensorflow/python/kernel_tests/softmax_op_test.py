@@ -193,6 +193,17 @@ class SoftmaxTest(test.TestCase):
           tf_softmax = sess.run(y, feed_dict={x: ones})
         self.assertAllClose(tf_softmax, np_softmax)
 
+  def testLongRows(self):
+    # Rows longer than the chunks and segments that the CPU kernel splits
+    # them into, with the maximum in different places.
+    np.random.seed(1)
+    for shape in [(3, 1025), (1, 40000), (2, 100000)]:
+      for dtype in [np.float32, np.float64]:
+        features = (10 * np.random.randn(*shape)).astype(dtype)
+        features[0, -1] = 50.
+        self._testSoftmax(features, use_gpu=False)
+        self._testSoftmax(features, log=True, use_gpu=False)
+
 
 if __name__ == "__main__":
   test.main()
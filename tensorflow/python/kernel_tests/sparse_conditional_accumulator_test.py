@@ -222,6 +222,69 @@ class IndexedSlicesConditionalAccumulatorTest(test.TestCase):
       self.assertAllEqual(val.values, [[5, 5], [0, 20], [30, 0]])
       self.assertAllEqual(val.dense_shape, [-1, 2])
 
+  def testAccumulatorEmptyFirstGrad(self):
+    with self.test_session() as sess:
+      q = data_flow_ops.SparseConditionalAccumulator(
+          dtypes_lib.float32, name="Q", shape=())
+
+      empty_indices = np.array([], dtype=np.int64)
+      empty_values = np.zeros([0, 2], dtype=np.float32)
+      q.apply_grad(empty_indices, empty_values, [3, 2], local_step=0).run()
+
+      val = sess.run(q.take_indexed_slices_grad(1))
+      self.assertAllEqual(val.indices, [])
+      self.assertAllEqual(val.values.shape, [0, 2])
+      self.assertAllEqual(val.dense_shape, [-1, 2])
+
+      q.apply_grad(empty_indices, empty_values, [3, 2], local_step=1).run()
+      q.apply_grad(
+          [1], np.array([[1, 2]]).astype(np.float32), [3, 2],
+          local_step=1).run()
+
+      val = sess.run(q.take_indexed_slices_grad(2))
+      self.assertAllEqual(val.indices, [1])
+      self.assertAllEqual(val.values, [[1, 2]])
+      self.assertAllEqual(val.dense_shape, [-1, 2])
+
+  def testAccumulatorDuplicateIndices(self):
+    with self.test_session() as sess:
+      q = data_flow_ops.SparseConditionalAccumulator(
+          dtypes_lib.float32, name="Q", shape=())
+
+      # The rows of one gradient with the same index are summed, and count
+      # as a single gradient for that index.
+      q.apply_grad(
+          [2, 0, 2],
+          np.array([[1, 2], [5, 5], [3, 4]]).astype(np.float32), [3, 2]).run()
+      q.apply_grad([2], np.array([[2, 2]]).astype(np.float32), [3, 2]).run()
+
+      val = sess.run(q.take_indexed_slices_grad(2))
+      self.assertAllEqual(val.indices, [0, 2])
+      self.assertAllEqual(val.values, [[5, 5], [3, 4]])
+      self.assertAllEqual(val.dense_shape, [-1, 2])
+
+  def testAccumulatorGrowsAcrossTakeGrad(self):
+    with self.test_session() as sess:
+      q = data_flow_ops.SparseConditionalAccumulator(
+          dtypes_lib.float32, name="Q", shape=())
+
+      # Each round accumulates more rows than the buffer kept from the
+      # previous round holds, then fewer.
+      for step, num_rows in enumerate([1, 3, 10, 2]):
+        indices = list(range(num_rows - 1, -1, -1))
+        values = np.array(
+            [[i, 10 * i] for i in indices]).astype(np.float32)
+        q.apply_grad(indices, values, [-1, 2], local_step=step).run()
+        q.apply_grad(
+            indices[:1], values[:1] + 2, [-1, 2], local_step=step).run()
+
+        val = sess.run(q.take_indexed_slices_grad(2))
+        expected = np.array(
+            [[i, 10 * i] for i in range(num_rows)]).astype(np.float32)
+        expected[-1] += 1
+        self.assertAllEqual(val.indices, list(range(num_rows)))
+        self.assertAllEqual(val.values, expected)
+
   def testParallelApplyGrad(self):
     with self.test_session() as sess:
       q = data_flow_ops.SparseConditionalAccumulator(
@@ -24,6 +24,8 @@ from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
 from tensorflow.python.ops import gradient_checker
 from tensorflow.python.ops import math_ops
+from tensorflow.python.ops import state_ops
+from tensorflow.python.ops import variables
 from tensorflow.python.platform import test
 
 
@@ -125,6 +127,30 @@ class SparseMatMulTest(test.TestCase):
                     x_dtype=x_dtype,
                     y_dtype=y_dtype)
 
+  # Tests that a sparse operand updated in place between calls is encoded
+  # again.
+  def testUpdatedInPlace(self):
+    for tr_a in [True, False]:
+      x = RandMatrix(300, 200, tr_a)
+      x[np.abs(x) < 0.4] = 0
+      y = RandMatrix(200, 100, False)
+      with self.test_session(use_gpu=False) as sess:
+        tf_x = variables.Variable(x)
+        tf_ans = math_ops.matmul(tf_x, y, transpose_a=tr_a, a_is_sparse=True)
+        new_rows = RandMatrix(2, x.shape[1], False)
+        update = state_ops.scatter_update(tf_x, [5, 150], new_rows)
+        variables.global_variables_initializer().run()
+        np_x = np.transpose(x) if tr_a else x
+        self.assertAllClose(np.dot(np_x, y), tf_ans.eval(), rtol=1e-4,
+                            atol=1e-4)
+        self.assertAllClose(np.dot(np_x, y), tf_ans.eval(), rtol=1e-4,
+                            atol=1e-4)
+        sess.run(update)
+        x[[5, 150]] = new_rows
+        np_x = np.transpose(x) if tr_a else x
+        self.assertAllClose(np.dot(np_x, y), tf_ans.eval(), rtol=1e-4,
+                            atol=1e-4)
+
 
 class MatMulGradientTest(test.TestCase):
 
@@ -17,6 +17,7 @@ from __future__ import division
 from __future__ import print_function
 
 from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import errors
 from tensorflow.python.framework import ops
 from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import data_flow_ops
@@ -155,6 +156,29 @@ class StageTest(test.TestCase):
       sess.run(clear)
       self.assertEqual(sess.run(size), 0)
 
+  def testClose(self):
+    with ops.Graph().as_default() as G:
+      with ops.device('/cpu:0'):
+        x = array_ops.placeholder(dtypes.float32)
+      with ops.device(test.gpu_device_name()):
+        stager = data_flow_ops.StagingArea([dtypes.float32])
+        stage = stager.put([x])
+        ret = stager.get()
+        close = stager.close()
+
+    G.finalize()
+
+    with self.test_session(use_gpu=True, graph=G) as sess:
+      sess.run(stage, feed_dict={x: 1})
+      sess.run(stage, feed_dict={x: 2})
+      sess.run(close)
+      with self.assertRaisesOpError('closed'):
+        sess.run(stage, feed_dict={x: 3})
+      self.assertEqual(1, sess.run(ret))
+      self.assertEqual(2, sess.run(ret))
+      with self.assertRaises(errors.OutOfRangeError):
+        sess.run(ret)
+
   def testCapacity(self):
     capacity = 3
 
@@ -277,6 +277,31 @@ class TensorArrayTest(test.TestCase):
     self._testTensorArraySplitRead(dtypes.complex128)
     self._testTensorArraySplitRead(dtypes.string)
 
+  def testTensorArrayUnstackStackAndSplitConcatRoundTrip(self):
+    with self.test_session(use_gpu=True) as session:
+      # Rows of 16 floats are aligned, so the elements are views of x.
+      x = np.arange(8 * 16).astype(np.float32).reshape([8, 16])
+      ta = tensor_array_ops.TensorArray(
+          dtype=dtypes.float32, size=8, clear_after_read=False)
+      w0 = ta.unstack(x)
+      stacked = w0.stack()
+      middle = w0.gather([2, 3, 4])
+      reversed_rows = w0.gather([7, 6, 5, 4, 3, 2, 1, 0])
+      plus_one = w0.stack() + 1.0
+
+      ta = tensor_array_ops.TensorArray(
+          dtype=dtypes.float32, size=3, infer_shape=False)
+      w1 = ta.split(x, lengths=constant_op.constant([2, 0, 6]))
+      concatenated = w1.concat()
+
+      results = session.run(
+          [stacked, middle, reversed_rows, plus_one, concatenated])
+      self.assertAllEqual(x, results[0])
+      self.assertAllEqual(x[2:5], results[1])
+      self.assertAllEqual(x[::-1], results[2])
+      self.assertAllEqual(x + 1.0, results[3])
+      self.assertAllEqual(x, results[4])
+
   def testTensorGradArrayWriteRead(self):
     with self.test_session(use_gpu=True) as session:
       ta = tensor_array_ops.TensorArray(
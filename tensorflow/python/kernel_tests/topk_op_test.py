@@ -77,6 +77,47 @@ class TopKTest(test.TestCase):
     k = constant_op.constant(3)
     self._validateTopK(inputs, k, [19, 18, 17], [11, 3, 7])
 
+  def _validateTopKOnDevices(self, inputs, k):
+    rows = np.arange(inputs.shape[0])[:, np.newaxis]
+    expected_indices = np.argsort(-inputs, axis=-1)[:, :k]
+    expected_values = inputs[rows, expected_indices]
+    for use_gpu in False, True:
+      for sorted in True, False:
+        with self.test_session(use_gpu=use_gpu):
+          values_op, indices_op = nn_ops.top_k(inputs, k, sorted=sorted)
+          values, indices = values_op.eval(), indices_op.eval()
+        if sorted:
+          self.assertAllEqual(expected_indices, indices)
+          self.assertAllEqual(expected_values, values)
+        else:
+          # Only the set of the top k elements is defined.
+          self.assertAllEqual(np.sort(expected_indices), np.sort(indices))
+          self.assertAllEqual(inputs[rows, indices], values)
+
+  def _distinctInputs(self, num_rows, num_cols, dtype):
+    return np.array([np.random.permutation(num_cols) - num_cols // 2
+                     for _ in range(num_rows)]).astype(dtype)
+
+  def testTopKOnDevicesSmallK(self):
+    np.random.seed(1)
+    for dtype in np.float32, np.float64, np.int32:
+      inputs = self._distinctInputs(10, 1000, dtype)
+      for k in 1, 5, 16:
+        self._validateTopKOnDevices(inputs, k)
+
+  def testTopKOnDevicesLargeK(self):
+    np.random.seed(2)
+    for dtype in np.float32, np.float64, np.int64:
+      inputs = self._distinctInputs(7, 1000, dtype)
+      for k in 17, 100, 1000:
+        self._validateTopKOnDevices(inputs, k)
+
+  def testTopKOnDevicesFractions(self):
+    np.random.seed(3)
+    inputs = (self._distinctInputs(3, 50, np.float32) / 7.0).astype(np.float32)
+    for k in 3, 20:
+      self._validateTopKOnDevices(inputs, k)
+
   def testKNegative(self):
     inputs = [[0.1, 0.2], [0.3, 0.4]]
     with self.test_session():
@@ -49,6 +49,18 @@ class UniqueTest(test.TestCase):
     for i in range(len(x)):
       self.assertEqual(x[i], tf_y[tf_idx[i]].decode('ascii'))
 
+  def testLargeInt64(self):
+    # Large enough to be split across threads.
+    x = np.random.randint(0, high=50000, size=200000).astype(np.int64)
+    with self.test_session() as sess:
+      y, idx = array_ops.unique(x)
+      tf_y, tf_idx = sess.run([y, idx])
+
+    # The unique elements are in the order of their first occurrence.
+    _, first = np.unique(x, return_index=True)
+    self.assertAllEqual(x[np.sort(first)], tf_y)
+    self.assertAllEqual(x, tf_y[tf_idx])
+
 
 class UniqueWithCountsTest(test.TestCase):
 
@@ -81,6 +93,18 @@ class UniqueWithCountsTest(test.TestCase):
       v = [1 if x[i] == value.decode('ascii') else 0 for i in range(7000)]
       self.assertEqual(count, sum(v))
 
+  def testLargeInt64(self):
+    x = np.random.randint(0, high=50000, size=200000).astype(np.int64)
+    with self.test_session() as sess:
+      y, idx, count = array_ops.unique_with_counts(x)
+      tf_y, tf_idx, tf_count = sess.run([y, idx, count])
+
+    _, first, np_count = np.unique(x, return_index=True, return_counts=True)
+    order = np.argsort(first)
+    self.assertAllEqual(x[first[order]], tf_y)
+    self.assertAllEqual(x, tf_y[tf_idx])
+    self.assertAllEqual(np_count[order], tf_count)
+
 
 if __name__ == '__main__':
   test.main()
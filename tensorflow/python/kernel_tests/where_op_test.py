@@ -18,17 +18,25 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import itertools
+import sys
+
 import numpy as np
 
+from tensorflow.python.client import session
 from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
 from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import random_ops
+from tensorflow.python.ops import variables
 from tensorflow.python.platform import test
 
 
 class WhereOpTest(test.TestCase):
 
   def _testWhere(self, x, truth, expected_err_re=None):
-    with self.test_session():
+    with self.test_session(use_gpu=True):
       ans = array_ops.where(x)
       self.assertEqual([None, x.ndim], ans.get_shape().as_list())
       if expected_err_re is None:
@@ -64,6 +72,20 @@ class WhereOpTest(test.TestCase):
 
     self._testWhere(x, truth)
 
+  def testRandomInputs(self):
+    np.random.seed(7)
+    # Sizes around and across the tiles the GPU kernels work on.
+    for shape in [(1,), (17,), (2048,), (2049,), (3, 5000), (7, 11, 13),
+                  (2, 3, 4, 5), (2, 3, 4, 5, 6), (1000, 1000)]:
+      for p in [0.0, 0.01, 0.5, 1.0]:
+        x = np.random.rand(*shape) < p
+        self._testWhere(x, np.argwhere(x))
+
+  def testEmptyInput(self):
+    for shape in [(0,), (3, 0), (0, 4, 5)]:
+      x = np.zeros(shape, dtype=np.bool)
+      self._testWhere(x, np.zeros((0, len(shape)), dtype=np.int64))
+
   def testThreeArgument(self):
     x = np.array([[-2, 3, -1], [1, -3, -3]])
     np_val = np.where(x > 0, x * x, -x)
@@ -72,5 +94,32 @@ class WhereOpTest(test.TestCase):
     self.assertAllEqual(tf_val, np_val)
 
 
+class WhereBenchmark(test.Benchmark):
+
+  def benchmarkWhere(self):
+    for (m, n, p, use_gpu) in itertools.product(
+        [10], [10, 100, 1000, 10000], [0.01, 0.5, 0.99], [False, True]):
+      if use_gpu and not test.is_gpu_available():
+        continue
+      name = "m_%d_n_%d_p_%g_use_gpu_%s" % (m, n, p, use_gpu)
+      device = "/%s:0" % ("gpu" if use_gpu else "cpu")
+      with ops.Graph().as_default():
+        with ops.device(device):
+          x = random_ops.random_uniform((m, n), dtype=dtypes.float32) <= p
+          v = variables.Variable(x)
+          op = array_ops.where(v)
+        with session.Session() as sess:
+          sess.run(v.initializer)
+          r = self.run_op_benchmark(sess, op, min_iters=100, name=name)
+          gb_processed_input = m * n / 1.0e9
+          # The output holds two int64 indices per true element.
+          gb_processed_output = 2 * 8 * m * n * p / 1.0e9
+          gb_processed = gb_processed_input + gb_processed_output
+          throughput = gb_processed / r["wall_time"]
+          print("Benchmark: %s \t wall_time: %0.03g s \t "
+                "Throughput: %0.03g GB/s" % (name, r["wall_time"], throughput))
+          sys.stdout.flush()
+
+
 if __name__ == "__main__":
   test.main()
@@ -156,6 +156,17 @@ class XentTest(test.TestCase):
         np.array([[1., 1., 1., 1.], [1., 2., 3., 4.]]).astype(np.float64),
         np.array([[0., 0., 0., 1.], [0., .5, .5, 0.]]).astype(np.float64))
 
+  def testLongRows(self):
+    # Rows longer than the chunks and segments that the CPU kernel splits
+    # them into.
+    np.random.seed(1)
+    for shape in [(3, 1025), (1, 40000), (2, 100000)]:
+      for dtype in [np.float32, np.float64]:
+        features = (10 * np.random.randn(*shape)).astype(dtype)
+        labels = np.random.rand(*shape).astype(dtype)
+        labels /= np.sum(labels, axis=1, keepdims=True)
+        self._testXent(features, labels, use_gpu=False)
+
   def testGradient(self):
     with self.test_session() as sess:
       l = constant_op.constant(
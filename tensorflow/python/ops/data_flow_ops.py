@@ -1757,6 +1757,31 @@ class StagingArea(BaseStagingArea):
                         dtypes=self._dtypes, capacity=self._capacity,
                         memory_limit=self._memory_limit)
 
+  def close(self, cancel_pending_enqueues=False, name=None):
+    """Closes the staging area.
+
+    After closing, `put()` fails, and `get()` fails with `OutOfRangeError` once
+    the remaining elements have been gotten. Pending `put()`s that wait for
+    space keep waiting, unless `cancel_pending_enqueues` is true.
+
+    This lets a `tf.train.QueueRunner` fill the staging area, like a queue.
+
+    Args:
+      cancel_pending_enqueues: (Optional.) A boolean, defaulting to
+        `False`. If true, the pending `put()`s fail too.
+      name: A name for the operation (optional)
+
+    Returns:
+        The created op
+    """
+    if name is None:
+      name = "%s_close" % self._name
+
+    return gen_data_flow_ops.stage_close(
+        name=name, shared_name=self._name, dtypes=self._dtypes,
+        capacity=self._capacity, memory_limit=self._memory_limit,
+        cancel_pending_enqueues=cancel_pending_enqueues)
+
 class MapStagingArea(BaseStagingArea):
   """
   A `MapStagingArea` is a TensorFlow data structure that stores tensors across
@@ -21,6 +21,8 @@ See the @{$python/image} guide.
 @@decode_bmp
 @@decode_gif
 @@decode_jpeg
+@@decode_and_crop_jpeg
+@@extract_jpeg_shape
 @@encode_jpeg
 @@decode_png
 @@encode_png
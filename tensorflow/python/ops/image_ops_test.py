@@ -2377,6 +2377,47 @@ class JpegTest(test_util.TensorFlowTestCase):
       self.assertGreaterEqual(len(jpeg0), 5000)
       self.assertLessEqual(len(jpeg0), 6000)
 
+  def testDecodeAndCrop(self):
+    # Decoding a crop window gives the same pixels as cropping the decoded
+    # image.
+    path = ("tensorflow/core/lib/jpeg/testdata/"
+            "jpeg_merge_test1.jpg")
+    with self.test_session(use_gpu=True) as sess:
+      jpeg0 = io_ops.read_file(path)
+      image0 = image_ops.decode_jpeg(jpeg0)
+      for crop_window in [[0, 0, 256, 128], [19, 7, 100, 50],
+                          [255, 127, 1, 1]]:
+        image1 = image_ops.decode_and_crop_jpeg(jpeg0, crop_window)
+        y, x, h, w = crop_window
+        self.assertEqual([h, w, None], image1.get_shape().as_list())
+        image0_value, image1_value = sess.run([image0, image1])
+        self.assertAllEqual(image0_value[y:y + h, x:x + w, :], image1_value)
+
+      # The crop window must lie within the image.
+      with self.assertRaisesOpError("Invalid JPEG data or crop window"):
+        sess.run(image_ops.decode_and_crop_jpeg(jpeg0, [200, 0, 100, 128]))
+
+  def testExtractJpegShape(self):
+    # Read a real jpeg and verify shape.
+    path = ("tensorflow/core/lib/jpeg/testdata/"
+            "jpeg_merge_test1.jpg")
+    with self.test_session(use_gpu=True) as sess:
+      jpeg = io_ops.read_file(path)
+      # Extract shape without decoding.
+      [image_shape] = sess.run([image_ops.extract_jpeg_shape(jpeg)])
+      self.assertEqual(image_shape.tolist(), [256, 128, 3])
+
+  def testExtractJpegShapeforCmyk(self):
+    # Read a cmyk jpeg image, and verify its shape.
+    path = ("tensorflow/core/lib/jpeg/testdata/"
+            "jpeg_merge_test1_cmyk.jpg")
+    with self.test_session(use_gpu=True) as sess:
+      jpeg = io_ops.read_file(path)
+      [image_shape] = sess.run(
+          [image_ops.extract_jpeg_shape(jpeg, output_type=dtypes.int64)])
+      # CMYK images are decoded as RGB.
+      self.assertEqual(image_shape.tolist(), [256, 128, 3])
+
   def testSyntheticFasterAlgorithm(self):
     with self.test_session(use_gpu=True) as sess:
       # Encode it, then decode it, then encode it
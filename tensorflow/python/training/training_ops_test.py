@@ -29,6 +29,7 @@ from tensorflow.python.framework.test_util import TensorFlowTestCase
 from tensorflow.python.ops import resource_variable_ops  # pylint: disable=unused-import
 from tensorflow.python.ops import variables
 from tensorflow.python.platform import googletest
+from tensorflow.python.training import gen_training_ops
 from tensorflow.python.training import training_ops
 
 
@@ -282,6 +283,54 @@ class TrainingOpsTest(TensorFlowTestCase):
       self.assertShapeEqual(out, apply_adam)
       self.assertAllCloseAccordingToType(new_var, out)
 
+  def testMultiApplyMomentum(self):
+    for dtype, use_gpu in itertools.product([np.float32, np.float64],
+                                            [False, True]):
+      self.setUp()
+      with self.test_session(use_gpu=use_gpu):
+        xs = [np.arange(10).astype(dtype), np.arange(3).astype(dtype)]
+        accums = [np.ones(10).astype(dtype), np.zeros(3).astype(dtype)]
+        grads = [np.arange(10).astype(dtype), np.ones(3).astype(dtype)]
+        lr = np.array(0.1, dtype=dtype)
+        momentum = np.array(0.9, dtype=dtype)
+        var_ts = [variables.Variable(x) for x in xs]
+        accum_ts = [variables.Variable(a) for a in accums]
+        variables.global_variables_initializer().run()
+
+        gen_training_ops._multi_apply_momentum(var_ts, accum_ts, lr, grads,
+                                               momentum).run()
+        for x, accum, grad, var_t, accum_t in zip(xs, accums, grads, var_ts,
+                                                  accum_ts):
+          new_accum = accum * momentum + grad
+          self.assertAllCloseAccordingToType(new_accum, accum_t.eval())
+          self.assertAllCloseAccordingToType(x - lr * new_accum, var_t.eval())
+
+  def testMultiApplyAdam(self):
+    for dtype, use_gpu in itertools.product([np.float32, np.float64],
+                                            [False, True]):
+      self.setUp()
+      with self.test_session(use_gpu=use_gpu):
+        xs = [np.arange(100).astype(dtype), np.arange(5).astype(dtype)]
+        ms = [np.arange(1, 101).astype(dtype), np.ones(5).astype(dtype)]
+        vs = [np.arange(101, 201).astype(dtype), np.ones(5).astype(dtype)]
+        grads = [np.arange(100).astype(dtype), np.arange(5).astype(dtype)]
+        beta1 = np.array(0.9, dtype=dtype)
+        beta2 = np.array(0.999, dtype=dtype)
+        lr = np.array(0.001, dtype=dtype)
+        epsilon = np.array(1e-8, dtype=dtype)
+        var_ts = [variables.Variable(x) for x in xs]
+        m_ts = [variables.Variable(m) for m in ms]
+        v_ts = [variables.Variable(v) for v in vs]
+        variables.global_variables_initializer().run()
+
+        gen_training_ops._multi_apply_adam(var_ts, m_ts, v_ts, beta1, beta2,
+                                           lr, beta1, beta2, epsilon,
+                                           grads).run()
+        for x, m, v, grad, var_t in zip(xs, ms, vs, grads, var_ts):
+          new_var, _, _ = self._adamUpdateNumpy(x, grad, 1, m, v, lr, beta1,
+                                                beta2, epsilon)
+          self.assertAllCloseAccordingToType(new_var, var_t.eval())
+
   def _adamUpdateNumpy(self, param, g_t, t, m, v, alpha, beta1, beta2, epsilon):
     alpha_t = alpha * np.sqrt(1 - beta2**t) / (1 - beta1**t)
 
@@ -393,6 +393,10 @@ port::Status CudnnSupport::Init() {
                                    ToString(status))};
 }
 
+port::StatusOr<string> CudnnSupport::GetVersion() {
+  return port::StrCat(::cudnnGetVersion());
+}
+
 // Turns a BatchDescriptor structure into a cudnn tensor handle within a scope.
 class ScopedTensorDescriptor {
  public:
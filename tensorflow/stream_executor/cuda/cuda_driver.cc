@@ -1091,6 +1091,99 @@ CUDADriver::ContextGetSharedMemConfig(CudaContext* context) {
   return true;
 }
 
+#if CUDA_VERSION >= 10000
+/* static */ port::Status CUDADriver::StreamBeginCapture(CudaContext* context,
+                                                        CUstream stream) {
+  ScopedActivateContext activation{context};
+#if CUDA_VERSION >= 10010
+  CUresult res =
+      cuStreamBeginCapture(stream, CU_STREAM_CAPTURE_MODE_THREAD_LOCAL);
+#else
+  CUresult res = cuStreamBeginCapture(stream);
+#endif
+  if (res != CUDA_SUCCESS) {
+    return port::Status{
+        port::error::INTERNAL,
+        port::Printf("could not begin capturing CUDA stream %p: %s", stream,
+                     ToString(res).c_str())};
+  }
+  return port::Status::OK();
+}
+
+/* static */ port::StatusOr<CUgraph> CUDADriver::StreamEndCapture(
+    CudaContext* context, CUstream stream) {
+  ScopedActivateContext activation{context};
+  CUgraph graph = nullptr;
+  CUresult res = cuStreamEndCapture(stream, &graph);
+  if (res != CUDA_SUCCESS) {
+    return port::Status{
+        port::error::INTERNAL,
+        port::Printf("could not end capturing CUDA stream %p: %s", stream,
+                     ToString(res).c_str())};
+  }
+  return graph;
+}
+
+/* static */ port::StatusOr<CUgraphExec> CUDADriver::GraphInstantiate(
+    CudaContext* context, CUgraph graph) {
+  ScopedActivateContext activation{context};
+  CUgraphExec exec = nullptr;
+#if CUDA_VERSION >= 12000
+  CUresult res = cuGraphInstantiate(&exec, graph, 0 /* = flags */);
+#else
+  CUresult res = cuGraphInstantiate(&exec, graph, nullptr /* = errorNode */,
+                                    nullptr /* = logBuffer */,
+                                    0 /* = bufferSize */);
+#endif
+  if (res != CUDA_SUCCESS) {
+    return port::Status{port::error::INTERNAL,
+                        port::Printf("could not instantiate CUDA graph %p: %s",
+                                     graph, ToString(res).c_str())};
+  }
+  return exec;
+}
+
+/* static */ port::Status CUDADriver::GraphLaunch(CudaContext* context,
+                                                 CUgraphExec exec,
+                                                 CUstream stream) {
+  ScopedActivateContext activation{context};
+  CUresult res = cuGraphLaunch(exec, stream);
+  if (res != CUDA_SUCCESS) {
+    return port::Status{
+        port::error::INTERNAL,
+        port::Printf("could not launch CUDA graph %p on stream %p: %s", exec,
+                     stream, ToString(res).c_str())};
+  }
+  return port::Status::OK();
+}
+
+/* static */ void CUDADriver::DestroyGraph(CudaContext* context,
+                                          CUgraph graph) {
+  if (graph == nullptr) {
+    return;
+  }
+  ScopedActivateContext activation{context};
+  CUresult res = cuGraphDestroy(graph);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to destroy CUDA graph " << graph << ": "
+               << ToString(res);
+  }
+}
+
+/* static */ void CUDADriver::DestroyGraphExec(CudaContext* context,
+                                              CUgraphExec exec) {
+  if (exec == nullptr) {
+    return;
+  }
+  ScopedActivateContext activation{context};
+  CUresult res = cuGraphExecDestroy(exec);
+  if (res != CUDA_SUCCESS) {
+    LOG(ERROR) << "failed to destroy executable CUDA graph " << exec << ": "
+               << ToString(res);
+  }
+}
+#endif  // CUDA_VERSION >= 10000
+
 /* static */ bool CUDADriver::SynchronizeContext(CudaContext* context) {
   ScopedActivateContext activation{context};
   CUresult res = cuCtxSynchronize();
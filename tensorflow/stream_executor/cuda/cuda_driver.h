@@ -296,6 +296,40 @@ class CUDADriver {
   static bool WaitStreamOnEvent(CudaContext* context, CUstream stream,
                                 CUevent event);
 
+#if CUDA_VERSION >= 10000
+  // -- Stream capture and CUDA graphs.
+
+  // Starts capturing the work that the calling thread enqueues onto stream
+  // into a graph, instead of running it, via cuStreamBeginCapture.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__STREAM.html
+  static port::Status StreamBeginCapture(CudaContext* context,
+                                         CUstream stream);
+
+  // Ends the capture started by StreamBeginCapture on stream and returns the
+  // graph of the captured work, via cuStreamEndCapture. The caller owns the
+  // graph and must destroy it with DestroyGraph.
+  static port::StatusOr<CUgraph> StreamEndCapture(CudaContext* context,
+                                                  CUstream stream);
+
+  // Creates an executable graph from graph, via cuGraphInstantiate. The
+  // caller owns it and must destroy it with DestroyGraphExec.
+  // http://docs.nvidia.com/cuda/cuda-driver-api/group__CUDA__GRAPH.html
+  static port::StatusOr<CUgraphExec> GraphInstantiate(CudaContext* context,
+                                                      CUgraph graph);
+
+  // Enqueues all the work of exec onto stream with a single launch, via
+  // cuGraphLaunch. The work reads and writes the same memory as when it was
+  // captured.
+  static port::Status GraphLaunch(CudaContext* context, CUgraphExec exec,
+                                  CUstream stream);
+
+  // Destroys graph, via cuGraphDestroy.
+  static void DestroyGraph(CudaContext* context, CUgraph graph);
+
+  // Destroys exec, via cuGraphExecDestroy.
+  static void DestroyGraphExec(CudaContext* context, CUgraphExec exec);
+#endif  // CUDA_VERSION >= 10000
+
   // Blocks the calling thread until the operations enqueued onto stream have
   // been completed, via cuStreamSynchronize.
   //
@@ -839,6 +839,13 @@ class DnnSupport {
 
   virtual port::Status Init() = 0;
 
+  // Returns the version of the library that implements the operations, e.g.
+  // "6021" for cuDNN 6.0.21.
+  virtual port::StatusOr<string> GetVersion() {
+    return port::Status{port::error::UNIMPLEMENTED,
+                        "GetVersion is unimplemented"};
+  }
+
   // Performs a single-precision forward batch normalization operation onto
   // the stream.
   //
@@ -697,6 +697,57 @@ def tf_kernel_library(name,
       **kwargs)
 
 
+# The instruction sets that tf_cpu_isa_library() compiles for, mapped to their
+# CpuIsa enumerator in tensorflow/core/kernels/cpu_isa_dispatch.h and to the
+# flags that enable them.
+_CPU_ISAS = {
+    "avx": ("kAvx", ["-mavx"]),
+    "avx2_fma": ("kAvx2Fma", ["-mavx2", "-mfma"]),
+}
+
+def tf_cpu_isa_library(name, srcs, hdrs=None, deps=None, copts=tf_copts(),
+                       **kwargs):
+  """A rule to build kernel code once per x86 instruction set.
+
+  Creates one cc_library per entry of _CPU_ISAS, named <name>_<isa>, and a
+  cc_library <name> that depends on all of them. Each build of srcs defines
+  TF_CPU_ISA to the CpuIsa enumerator of its instruction set, and should use it
+  to register its entry points with REGISTER_CPU_ISA_FUNCTION, see
+  tensorflow/core/kernels/cpu_isa_dispatch.h. The Eigen namespace is renamed
+  in each build, so that the Eigen code they instantiate doesn't get mixed up
+  at link time.
+
+  On other platforms, srcs are compiled once without TF_CPU_ISA, and should be
+  empty then.
+  """
+  if not hdrs:
+    hdrs = []
+  if not deps:
+    deps = []
+  isa_libs = []
+  for isa, (enumerator, isa_copts) in _CPU_ISAS.items():
+    isa_flags = isa_copts + [
+        "-DTF_CPU_ISA=" + enumerator,
+        "-DEigen=Eigen_" + isa,
+        "-DEIGEN_DONT_PARALLELIZE",
+    ]
+    native.cc_library(
+        name=name + "_" + isa,
+        srcs=srcs,
+        hdrs=hdrs,
+        copts=copts + select({
+            clean_dep("//tensorflow:linux_x86_64"): isa_flags,
+            clean_dep("//tensorflow:darwin"): isa_flags,
+            "//conditions:default": [],
+        }),
+        deps=deps,
+        linkstatic=1,
+        alwayslink=1,
+        **kwargs)
+    isa_libs.append(":" + name + "_" + isa)
+  native.cc_library(name=name, hdrs=hdrs, deps=isa_libs, **kwargs)
+
+
 def tf_mkl_kernel_library(name,
                           prefix=None,
                           srcs=None,
@@ -20,8 +20,10 @@ limitations under the License.
 
 #include "tensorflow/tools/benchmark/benchmark_model.h"
 
+#include <atomic>
 #include <cstdlib>
 #include <memory>
+#include <random>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -32,11 +34,14 @@ limitations under the License.
 #include "tensorflow/core/graph/algorithm.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/graph/graph_constructor.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/init_main.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/platform.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session.h"
@@ -50,6 +55,12 @@ namespace benchmark_model {
 Status InitializeSession(int num_threads, const string& graph,
                          std::unique_ptr<Session>* session,
                          std::unique_ptr<GraphDef>* graph_def) {
+  return InitializeSession(num_threads, -1, graph, session, graph_def);
+}
+
+Status InitializeSession(int num_threads, int num_inter_op_threads,
+                         const string& graph, std::unique_ptr<Session>* session,
+                         std::unique_ptr<GraphDef>* graph_def) {
   LOG(INFO) << "Loading TensorFlow.";
 
   tensorflow::SessionOptions options;
@@ -57,6 +68,9 @@ Status InitializeSession(int num_threads, const string& graph,
   if (num_threads > 0) {
     config.set_intra_op_parallelism_threads(num_threads);
   }
+  if (num_inter_op_threads > 0) {
+    config.set_inter_op_parallelism_threads(num_inter_op_threads);
+  }
   LOG(INFO) << "Got config, " << config.device_count_size() << " devices";
 
   session->reset(tensorflow::NewSession(options));
@@ -288,6 +302,86 @@ Status TimeMultipleRuns(double sleep_seconds, int num_runs,
   return Status::OK();
 }
 
+Status RunLoadTest(const LoadTestOptions& options,
+                   const std::vector<InputLayerInfo>& inputs,
+                   const std::vector<string>& outputs, Session* session,
+                   LoadTestResults* results) {
+  if (options.num_clients <= 0) {
+    return errors::InvalidArgument("A load test needs at least one client");
+  }
+  LOG(INFO) << "Running load test of " << options.num_requests
+            << " requests from " << options.num_clients << " clients"
+            << (options.target_qps > 0
+                    ? strings::StrCat(" at ", options.target_qps, " QPS")
+                    : "");
+
+  Env* env = Env::Default();
+  results->latency_us.Clear();
+  mutex mu;
+  int64 num_errors = 0;
+  Status first_error;
+  const auto run_request = [&](int64 arrival_us) {
+    int64 unused_time_us;
+    const Status s =
+        RunBenchmark(inputs, outputs, session, nullptr, &unused_time_us);
+    results->latency_us.Add(env->NowMicros() - arrival_us);
+    if (!s.ok()) {
+      mutex_lock l(mu);
+      ++num_errors;
+      if (first_error.ok()) first_error = s;
+    }
+  };
+
+  const int64 start_us = env->NowMicros();
+  {
+    thread::ThreadPool clients(env, "benchmark_client", options.num_clients);
+    if (options.target_qps > 0) {
+      std::mt19937_64 rng(301);
+      std::exponential_distribution<double> interarrival_s(options.target_qps);
+      double arrival_us = start_us;
+      for (int i = 0; i < options.num_requests; ++i) {
+        arrival_us += interarrival_s(rng) * 1e6;
+        const int64 now_us = env->NowMicros();
+        if (arrival_us > now_us) {
+          env->SleepForMicroseconds(static_cast<int64>(arrival_us) - now_us);
+        }
+        const int64 request_arrival_us = arrival_us;
+        clients.Schedule([&run_request, request_arrival_us]() {
+          run_request(request_arrival_us);
+        });
+      }
+    } else {
+      std::atomic<int> next_request(0);
+      for (int i = 0; i < options.num_clients; ++i) {
+        clients.Schedule([&]() {
+          while (next_request++ < options.num_requests) {
+            run_request(env->NowMicros());
+          }
+        });
+      }
+    }
+    // Destroying the pool waits for the requests.
+  }
+  results->wall_time_seconds = (env->NowMicros() - start_us) / 1000000.0;
+  results->num_requests = options.num_requests;
+  results->num_errors = num_errors;
+  return first_error;
+}
+
+namespace {
+
+string LoadTestSummary(const LoadTestResults& results) {
+  return strings::StrCat(
+      results.num_requests, " requests in ", results.wall_time_seconds,
+      "s, throughput: ", results.num_requests / results.wall_time_seconds,
+      " QPS, latency in us: p50 ", results.latency_us.Percentile(50), " p90 ",
+      results.latency_us.Percentile(90), " p99 ",
+      results.latency_us.Percentile(99), " p99.9 ",
+      results.latency_us.Percentile(99.9), ", errors: ", results.num_errors);
+}
+
+}  // namespace
+
 int Main(int argc, char** argv) {
   string graph = "/data/local/tmp/tensorflow_inception_graph.pb";
   string input_layer_string = "input:0";
@@ -311,6 +405,11 @@ int Main(int argc, char** argv) {
   bool show_summary = true;
   bool show_flops = false;
   int warmup_runs = 2;
+  int num_inter_op_threads = -1;
+  int num_clients = 0;
+  float target_qps = 0;
+  string intra_op_threads_sweep = "";
+  string inter_op_threads_sweep = "";
 
   std::vector<Flag> flag_list = {
       Flag("graph", &graph, "graph file name"),
@@ -340,6 +439,19 @@ int Main(int argc, char** argv) {
            "whether to show a summary of the stats"),
       Flag("show_flops", &show_flops, "whether to estimate the model's FLOPs"),
       Flag("warmup_runs", &warmup_runs, "how many runs to initialize model"),
+      Flag("num_inter_op_threads", &num_inter_op_threads,
+           "number of inter-op threads"),
+      Flag("num_clients", &num_clients,
+           "if positive, run a load test of num_runs requests from this many "
+           "concurrent clients instead of sequential runs"),
+      Flag("target_qps", &target_qps,
+           "if positive, requests of the load test arrive at this average rate "
+           "(Poisson arrivals) rather than back to back"),
+      Flag("intra_op_threads_sweep", &intra_op_threads_sweep,
+           "comma-separated numbers of threads to run the load test with"),
+      Flag("inter_op_threads_sweep", &inter_op_threads_sweep,
+           "comma-separated numbers of inter-op threads to run the load test "
+           "with"),
   };
   string usage = Flags::Usage(argv[0], flag_list);
   const bool parse_result = Flags::Parse(&argc, argv, flag_list);
@@ -391,12 +503,19 @@ int Main(int argc, char** argv) {
   LOG(INFO) << "Output prefix: [" << output_prefix << "]";
   LOG(INFO) << "Show sizes: [" << show_sizes << "]";
   LOG(INFO) << "Warmup runs: [" << warmup_runs << "]";
+  LOG(INFO) << "Num clients: [" << num_clients << "]";
+  LOG(INFO) << "Target QPS: [" << target_qps << "]";
+
+  if (target_qps > 0 && num_clients <= 0) {
+    LOG(ERROR) << "--target_qps requires --num_clients";
+    return -1;
+  }
 
   std::unique_ptr<Session> session;
   std::unique_ptr<StatSummarizer> stats;
   std::unique_ptr<GraphDef> graph_def;
-  Status initialize_status =
-      InitializeSession(num_threads, graph, &session, &graph_def);
+  Status initialize_status = InitializeSession(
+      num_threads, num_inter_op_threads, graph, &session, &graph_def);
   if (!initialize_status.ok()) {
     return -1;
   }
@@ -441,6 +560,53 @@ int Main(int argc, char** argv) {
     inputs.push_back(input);
   }
 
+  if (num_clients > 0) {
+    std::vector<int32> intra_op_threads = {num_threads};
+    std::vector<int32> inter_op_threads = {num_inter_op_threads};
+    if ((!intra_op_threads_sweep.empty() &&
+         !str_util::SplitAndParseAsInts(intra_op_threads_sweep, ',',
+                                        &intra_op_threads)) ||
+        (!inter_op_threads_sweep.empty() &&
+         !str_util::SplitAndParseAsInts(inter_op_threads_sweep, ',',
+                                        &inter_op_threads))) {
+      LOG(ERROR) << "Invalid thread sweep: --intra_op_threads_sweep="
+                 << intra_op_threads_sweep
+                 << " --inter_op_threads_sweep=" << inter_op_threads_sweep;
+      return -1;
+    }
+    LoadTestOptions load_options;
+    load_options.num_requests = num_runs;
+    load_options.num_clients = num_clients;
+    load_options.target_qps = target_qps;
+    for (int32 intra_op : intra_op_threads) {
+      for (int32 inter_op : inter_op_threads) {
+        // Each configuration gets a fresh session.
+        session.reset();
+        if (!InitializeSession(intra_op, inter_op, graph, &session, &graph_def)
+                 .ok()) {
+          return -1;
+        }
+        int64 warmup_time_us;
+        if (warmup_runs > 0 &&
+            !TimeMultipleRuns(0.0, warmup_runs, inputs, output_layers,
+                              session.get(), nullptr, &warmup_time_us)
+                 .ok()) {
+          return -1;
+        }
+        LoadTestResults results;
+        const Status load_status = RunLoadTest(
+            load_options, inputs, output_layers, session.get(), &results);
+        if (!load_status.ok()) {
+          LOG(ERROR) << "Load test failed with " << load_status;
+        }
+        LOG(INFO) << "Load test with " << intra_op << " intra-op threads and "
+                  << inter_op << " inter-op threads: "
+                  << LoadTestSummary(results);
+      }
+    }
+    return 0;
+  }
+
   // If requested, run through the graph first to preinitialize everything
   // before the benchmarking runs.
   int64 warmup_time_us = 0;
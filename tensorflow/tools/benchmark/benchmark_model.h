@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_TOOLS_BENCHMARK_BENCHMARK_MODEL_H_
 #define TENSORFLOW_TOOLS_BENCHMARK_BENCHMARK_MODEL_H_
 
+#include "tensorflow/core/lib/histogram/histogram.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/util/stat_summarizer.h"
 
@@ -35,6 +36,11 @@ Status InitializeSession(int num_threads, const string& graph,
                          std::unique_ptr<Session>* session,
                          std::unique_ptr<GraphDef>* graph_def);
 
+// Like above, also setting the number of inter-op threads if it is positive.
+Status InitializeSession(int num_threads, int num_inter_op_threads,
+                         const string& graph, std::unique_ptr<Session>* session,
+                         std::unique_ptr<GraphDef>* graph_def);
+
 // Does a single run of the model that's been loaded into the given session.
 Status RunBenchmark(const std::vector<InputLayerInfo>& inputs,
                     const std::vector<string>& outputs, Session* session,
@@ -46,6 +52,36 @@ Status TimeMultipleRuns(double sleep_seconds, int num_runs,
                         const std::vector<string>& outputs, Session* session,
                         StatSummarizer* stats, int64* total_time_us);
 
+// How RunLoadTest() sends requests.
+struct LoadTestOptions {
+  // The number of requests to send.
+  int num_requests = 100;
+  // The number of clients sending requests concurrently.  Without
+  // "target_qps", each client sends its next request as soon as the previous
+  // one completes (closed loop).
+  int num_clients = 1;
+  // If positive, requests arrive at this average rate, as a Poisson process,
+  // whether or not the previous ones have completed (open loop).  Requests
+  // that arrive while all the clients are busy wait for one.
+  double target_qps = 0;
+};
+
+struct LoadTestResults {
+  int64 num_requests = 0;
+  int64 num_errors = 0;
+  double wall_time_seconds = 0;
+  // The latencies of the requests in microseconds, from their arrival, so
+  // including the time they waited for a client.
+  histogram::ThreadSafeHistogram latency_us;
+};
+
+// Sends requests to the model concurrently, to measure its throughput and
+// latency under load.  Returns the first error of a request, if any.
+Status RunLoadTest(const LoadTestOptions& options,
+                   const std::vector<InputLayerInfo>& inputs,
+                   const std::vector<string>& outputs, Session* session,
+                   LoadTestResults* results);
+
 // Handles all setup and argument parsing.
 int Main(int argc, char** argv);
 
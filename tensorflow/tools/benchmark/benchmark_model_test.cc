@@ -26,16 +26,14 @@ limitations under the License.
 namespace tensorflow {
 namespace {
 
-TEST(BenchmarkModelTest, InitializeAndRun) {
-  const string dir = testing::TmpDir();
-  const string filename_pb = io::JoinPath(dir, "graphdef.pb");
-
-  // Create a simple graph and write it to filename_pb.
+// Writes a graph multiplying "input" by a constant to "filename_pb".
+void CreateTestGraph(const string& filename_pb,
+                     benchmark_model::InputLayerInfo* input,
+                     string* output_name) {
   const int input_width = 400;
   const int input_height = 10;
-  benchmark_model::InputLayerInfo input;
-  input.shape = TensorShape({input_width, input_height});
-  input.data_type = DT_FLOAT;
+  input->shape = TensorShape({input_width, input_height});
+  input->data_type = DT_FLOAT;
   const TensorShape constant_shape({input_height, input_width});
 
   Tensor constant_tensor(DT_FLOAT, constant_shape);
@@ -43,10 +41,10 @@ TEST(BenchmarkModelTest, InitializeAndRun) {
 
   auto root = Scope::NewRootScope().ExitOnError();
   auto placeholder =
-      ops::Placeholder(root, DT_FLOAT, ops::Placeholder::Shape(input.shape));
-  input.name = placeholder.node()->name();
+      ops::Placeholder(root, DT_FLOAT, ops::Placeholder::Shape(input->shape));
+  input->name = placeholder.node()->name();
   auto m = ops::MatMul(root, placeholder, constant_tensor);
-  const string output_name = m.node()->name();
+  *output_name = m.node()->name();
 
   GraphDef graph_def;
   TF_ASSERT_OK(root.ToGraphDef(&graph_def));
@@ -54,6 +52,16 @@ TEST(BenchmarkModelTest, InitializeAndRun) {
   graph_def.SerializeToString(&graph_def_serialized);
   TF_ASSERT_OK(
       WriteStringToFile(Env::Default(), filename_pb, graph_def_serialized));
+}
+
+TEST(BenchmarkModelTest, InitializeAndRun) {
+  const string dir = testing::TmpDir();
+  const string filename_pb = io::JoinPath(dir, "graphdef.pb");
+
+  // Create a simple graph and write it to filename_pb.
+  benchmark_model::InputLayerInfo input;
+  string output_name;
+  CreateTestGraph(filename_pb, &input, &output_name);
 
   std::unique_ptr<Session> session;
   std::unique_ptr<GraphDef> loaded_graph_def;
@@ -66,5 +74,43 @@ TEST(BenchmarkModelTest, InitializeAndRun) {
       0.0, 10, {input}, {output_name}, session.get(), stats.get(), &time));
 }
 
+TEST(BenchmarkModelTest, LoadTest) {
+  const string filename_pb =
+      io::JoinPath(testing::TmpDir(), "load_test_graphdef.pb");
+  benchmark_model::InputLayerInfo input;
+  string output_name;
+  CreateTestGraph(filename_pb, &input, &output_name);
+
+  std::unique_ptr<Session> session;
+  std::unique_ptr<GraphDef> loaded_graph_def;
+  TF_ASSERT_OK(benchmark_model::InitializeSession(2, 2, filename_pb, &session,
+                                                  &loaded_graph_def));
+
+  // Closed loop.
+  benchmark_model::LoadTestOptions options;
+  options.num_requests = 20;
+  options.num_clients = 4;
+  benchmark_model::LoadTestResults results;
+  TF_ASSERT_OK(benchmark_model::RunLoadTest(options, {input}, {output_name},
+                                            session.get(), &results));
+  EXPECT_EQ(20, results.num_requests);
+  EXPECT_EQ(0, results.num_errors);
+  EXPECT_GT(results.wall_time_seconds, 0);
+  EXPECT_GT(results.latency_us.Percentile(99), 0);
+
+  // Open loop, at a rate that takes about 0.1s.
+  options.target_qps = 200;
+  TF_ASSERT_OK(benchmark_model::RunLoadTest(options, {input}, {output_name},
+                                            session.get(), &results));
+  EXPECT_EQ(0, results.num_errors);
+
+  // Failing requests are counted.
+  TF_ASSERT_OK(session->Close());
+  EXPECT_FALSE(benchmark_model::RunLoadTest(options, {input}, {output_name},
+                                            session.get(), &results)
+                   .ok());
+  EXPECT_EQ(20, results.num_errors);
+}
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,185 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+namespace {
+
+// Describes how a quantized op with 32-bit results maps onto its version with
+// a fused Requantize.
+struct FusedRequantizeInfo {
+  // The name of the fused op.
+  string fused_name;
+  // The attributes holding the eight bit input types, which the fused kernels
+  // only support as quint8.
+  std::vector<string> input_type_attrs;
+  // The attribute holding the 32-bit output type on the unfused op, and the
+  // requantized output type on the fused one.
+  string output_type_attr;
+  // Other attributes to copy directly over.
+  std::vector<string> attrs_to_copy;
+};
+
+const std::map<string, FusedRequantizeInfo>& GetFusedRequantizeOps() {
+  static const std::map<string, FusedRequantizeInfo> op_map = {
+      {"QuantizedBiasAdd",
+       {"QuantizedBiasAddAndRequantize", {"T1", "T2"}, "out_type", {}}},
+      {"QuantizedConv2D",
+       {"QuantizedConv2DAndRequantize",
+        {"Tinput", "Tfilter"},
+        "out_type",
+        {"strides", "padding"}}},
+      {"QuantizedMatMul",
+       {"QuantizedMatMulAndRequantize",
+        {"T1", "T2"},
+        "Toutput",
+        {"transpose_a", "transpose_b"}}},
+  };
+  return op_map;
+}
+
+bool HasTypeAttr(const NodeDef& node, const string& attr_name,
+                 DataType expected_type) {
+  DataType type;
+  return GetNodeAttr(node, attr_name, &type).ok() && (type == expected_type);
+}
+
+// Returns true if the Requantize node reads all three of the quantized node's
+// outputs in order, and the fused kernels support all of the types involved.
+bool CanFuseRequantize(const NodeDef& quantized_node,
+                       const NodeDef& requantize_node,
+                       const FusedRequantizeInfo& info) {
+  for (int i = 0; i < 3; ++i) {
+    string prefix;
+    string node_name;
+    string suffix;
+    NodeNamePartsFromInput(requantize_node.input(i), &prefix, &node_name,
+                           &suffix);
+    const bool is_expected_output =
+        (i == 0) ? (suffix.empty() || (suffix == ":0"))
+                 : (suffix == strings::StrCat(":", i));
+    if (!prefix.empty() || (node_name != quantized_node.name()) ||
+        !is_expected_output) {
+      return false;
+    }
+  }
+  for (const string& attr_name : info.input_type_attrs) {
+    if (!HasTypeAttr(quantized_node, attr_name, DT_QUINT8)) {
+      return false;
+    }
+  }
+  return HasTypeAttr(quantized_node, info.output_type_attr, DT_QINT32) &&
+         HasTypeAttr(requantize_node, "Tinput", DT_QINT32) &&
+         HasTypeAttr(requantize_node, "out_type", DT_QUINT8);
+}
+
+}  // namespace
+
+// Once freeze_requantization_ranges has replaced the RequantizationRange ops
+// with constants, every QuantizedConv2D, QuantizedMatMul, or QuantizedBiasAdd
+// is followed by a Requantize with a fixed range. This merges those pairs into
+// the fused versions of the ops, so that the 32-bit results never have to
+// leave the kernel, and the graph keeps passing eight bit values from one
+// quantized op to the next.
+Status FuseQuantizedRequantizes(const GraphDef& input_graph_def,
+                                const TransformFuncContext& context,
+                                GraphDef* output_graph_def) {
+  const string quantized_ops =
+      "QuantizedBiasAdd|QuantizedConv2D|QuantizedMatMul";
+  GraphDef replaced_graph_def;
+  TF_RETURN_IF_ERROR(ReplaceMatchingOpTypes(
+      input_graph_def,  // clang-format off
+      {"Requantize",
+        {
+          {quantized_ops},
+          {quantized_ops},
+          {quantized_ops},
+          {"Const"},
+          {"Const"},
+        }
+      },  // clang-format on
+      [](const NodeMatch& match, const std::set<string>& input_nodes,
+         const std::set<string>& output_nodes,
+         std::vector<NodeDef>* new_nodes) {
+        const NodeDef& requantize_node = match.node;
+        const NodeDef& quantized_node = match.inputs[0].node;
+        const NodeDef& requested_min_node = match.inputs[3].node;
+        const NodeDef& requested_max_node = match.inputs[4].node;
+        const FusedRequantizeInfo& info =
+            GetFusedRequantizeOps().at(quantized_node.op());
+
+        // If anything else reads the 32-bit results, they have to stay as
+        // they are.
+        if (output_nodes.count(quantized_node.name()) ||
+            !CanFuseRequantize(quantized_node, requantize_node, info)) {
+          MatchedNodesAsArray(match, new_nodes);
+          return Status::OK();
+        }
+
+        new_nodes->push_back(requested_min_node);
+        new_nodes->push_back(requested_max_node);
+
+        // The fused op takes over the Requantize's name, so that its
+        // consumers don't need to be rewired.
+        NodeDef fused_node;
+        fused_node.set_op(info.fused_name);
+        fused_node.set_name(requantize_node.name());
+        fused_node.set_device(quantized_node.device());
+        std::vector<string> control_inputs;
+        for (const NodeDef* node : {&quantized_node, &requantize_node}) {
+          for (const string& input : node->input()) {
+            if (StringPiece(input).starts_with("^")) {
+              control_inputs.push_back(input);
+            }
+          }
+        }
+        for (const string& input : quantized_node.input()) {
+          if (!StringPiece(input).starts_with("^")) {
+            AddNodeInput(input, &fused_node);
+          }
+        }
+        AddNodeInput(requantize_node.input(3), &fused_node);
+        AddNodeInput(requantize_node.input(4), &fused_node);
+        for (const string& input : control_inputs) {
+          AddNodeInput(input, &fused_node);
+        }
+        for (const string& attr_name : info.input_type_attrs) {
+          CopyNodeAttr(quantized_node, attr_name, attr_name, &fused_node);
+        }
+        for (const string& attr_name : info.attrs_to_copy) {
+          CopyNodeAttr(quantized_node, attr_name, attr_name, &fused_node);
+        }
+        SetNodeAttr(info.output_type_attr, DT_QUINT8, &fused_node);
+        new_nodes->push_back(fused_node);
+
+        return Status::OK();
+      },
+      {}, &replaced_graph_def));
+  *output_graph_def = replaced_graph_def;
+  return Status::OK();
+}
+
+REGISTER_GRAPH_TRANSFORM("fuse_quantized_requantizes",
+                         FuseQuantizedRequantizes);
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
@@ -0,0 +1,384 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#define EIGEN_USE_THREADS
+
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/nn_ops.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/quantization_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+// Declare here, so we don't need a public header.
+Status FuseQuantizedRequantizes(const GraphDef& input_graph_def,
+                                const TransformFuncContext& context,
+                                GraphDef* output_graph_def);
+Status QuantizeNodes(const GraphDef& input_graph_def,
+                     const TransformFuncContext& context,
+                     GraphDef* output_graph_def);
+Status FreezeRequantizationRanges(const GraphDef& input_graph_def,
+                                  const TransformFuncContext& context,
+                                  GraphDef* output_graph_def);
+
+namespace {
+
+using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+Output QuantizedConst(const Scope& scope, const string& name,
+                      const TensorShape& shape, float min, float max,
+                      const std::function<float(int)>& fn) {
+  Tensor float_tensor(DT_FLOAT, shape);
+  test::FillFn<float>(&float_tensor, fn);
+  return Const(scope.WithOpName(name),
+               Input::Initializer(
+                   FloatTensorToQuantized<quint8>(float_tensor, min, max)));
+}
+
+Output FloatConst(const Scope& scope, const string& name, float value) {
+  return Const(scope.WithOpName(name), value);
+}
+
+// Builds a float Conv2D, BiasAdd, Relu, and MatMul model with the given
+// sizes, feeding from a Placeholder called "input" and producing "output".
+void BuildFloatModel(int batch, int image_size, int depth, int filter_count,
+                     int hidden_size, GraphDef* graph_def) {
+  Scope root = Scope::NewRootScope();
+
+  Output input =
+      Placeholder(root.WithOpName("input"), DT_FLOAT,
+                  Placeholder::Shape({batch, image_size, image_size, depth}));
+
+  Tensor filter_tensor(DT_FLOAT, TensorShape({3, 3, depth, filter_count}));
+  test::FillFn<float>(&filter_tensor,
+                      [](int i) { return ((i % 11) - 5) / 5.0f; });
+  Output filter =
+      Const(root.WithOpName("filter"), Input::Initializer(filter_tensor));
+  Output conv = Conv2D(root.WithOpName("conv"), input, filter, {1, 1, 1, 1},
+                       "SAME");
+
+  Tensor bias_tensor(DT_FLOAT, TensorShape({filter_count}));
+  test::FillFn<float>(&bias_tensor, [](int i) { return ((i % 5) - 2) / 2.0f; });
+  Output bias = Const(root.WithOpName("bias"), Input::Initializer(bias_tensor));
+  Output bias_add = BiasAdd(root.WithOpName("bias_add"), conv, bias);
+  Output relu = Relu(root.WithOpName("relu"), bias_add);
+
+  Output flat = Reshape(root.WithOpName("flat"), relu,
+                        {batch, image_size * image_size * filter_count});
+  Tensor weights_tensor(
+      DT_FLOAT,
+      TensorShape({image_size * image_size * filter_count, hidden_size}));
+  test::FillFn<float>(&weights_tensor,
+                      [](int i) { return ((i % 7) - 3) / 30.0f; });
+  Output weights =
+      Const(root.WithOpName("weights"), Input::Initializer(weights_tensor));
+  MatMul(root.WithOpName("output"), flat, weights);
+
+  TF_CHECK_OK(root.ToGraphDef(graph_def));
+}
+
+// Quantizes the float model, freezes the requantization ranges to the ones
+// seen when running it on the given input, and fuses the Requantizes.
+void BuildFusedEightBitModel(const GraphDef& float_graph_def,
+                             const Tensor& input, const string& log_name,
+                             GraphDef* fused_graph_def) {
+  TransformFuncContext context;
+  context.input_names = {"input"};
+  context.output_names = {"output"};
+  GraphDef quantized_graph_def;
+  TF_CHECK_OK(QuantizeNodes(float_graph_def, context, &quantized_graph_def));
+
+  std::vector<string> range_names;
+  for (const NodeDef& node : quantized_graph_def.node()) {
+    if (node.op() == "RequantizationRange") {
+      range_names.push_back(node.name() + ":0");
+      range_names.push_back(node.name() + ":1");
+    }
+  }
+  std::unique_ptr<Session> session(NewSession(SessionOptions()));
+  TF_CHECK_OK(session->Create(quantized_graph_def));
+  std::vector<Tensor> ranges;
+  TF_CHECK_OK(session->Run({{"input", input}}, range_names, {}, &ranges));
+
+  // This is the same format that insert_logging produces.
+  const string log_file_name = io::JoinPath(testing::TmpDir(), log_name);
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_CHECK_OK(Env::Default()->NewWritableFile(log_file_name, &file));
+    for (int i = 0; i < range_names.size(); i += 2) {
+      TF_CHECK_OK(file->Append(strings::StrCat(
+          ";", NodeNameFromInput(range_names[i]),
+          "__print__;__requant_min_max:[", ranges[i].flat<float>()(0), "][",
+          ranges[i + 1].flat<float>()(0), "]\n")));
+    }
+    TF_CHECK_OK(file->Close());
+  }
+
+  context.params["min_max_log_file"] = {log_file_name};
+  GraphDef frozen_graph_def;
+  TF_CHECK_OK(FreezeRequantizationRanges(quantized_graph_def, context,
+                                         &frozen_graph_def));
+  TF_CHECK_OK(
+      FuseQuantizedRequantizes(frozen_graph_def, context, fused_graph_def));
+}
+
+Tensor ModelInput(int batch, int image_size, int depth) {
+  Tensor input(DT_FLOAT, TensorShape({batch, image_size, image_size, depth}));
+  test::FillFn<float>(&input, [](int i) { return (i % 13) / 13.0f; });
+  return input;
+}
+
+}  // namespace
+
+class FuseQuantizedRequantizesTest : public ::testing::Test {
+ protected:
+  // Checks that the Requantize following the quantized op called
+  // "quantized_op" has been fused into a single node called "requantize",
+  // and that the fused graph produces the same results as the original.
+  void TestFusion(const Scope& root, const string& fused_op) {
+    GraphDef graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&graph_def));
+
+    GraphDef fused_graph_def;
+    TF_ASSERT_OK(
+        FuseQuantizedRequantizes(graph_def, {{}, {"output"}}, &fused_graph_def));
+
+    std::map<string, const NodeDef*> node_map;
+    MapNamesToNodes(fused_graph_def, &node_map);
+    EXPECT_EQ(0, node_map.count("quantized_op"));
+    ASSERT_EQ(1, node_map.count("requantize"));
+    EXPECT_EQ(fused_op, node_map.at("requantize")->op());
+    for (const NodeDef& node : fused_graph_def.node()) {
+      EXPECT_NE("Requantize", node.op()) << node.name();
+    }
+
+    std::unique_ptr<Session> original_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(original_session->Create(graph_def));
+    std::vector<Tensor> original_outputs;
+    TF_ASSERT_OK(original_session->Run({}, {"output"}, {}, &original_outputs));
+
+    std::unique_ptr<Session> fused_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(fused_session->Create(fused_graph_def));
+    std::vector<Tensor> fused_outputs;
+    TF_ASSERT_OK(fused_session->Run({}, {"output"}, {}, &fused_outputs));
+
+    test::ExpectTensorEqual<float>(original_outputs[0], fused_outputs[0]);
+  }
+
+  void AddRequantizeAndOutput(const Scope& root, Input quantized_output,
+                              Input quantized_min, Input quantized_max) {
+    Requantize requantize(root.WithOpName("requantize"), quantized_output,
+                          quantized_min, quantized_max,
+                          FloatConst(root, "requested_min", -20.0f),
+                          FloatConst(root, "requested_max", 30.0f), DT_QUINT8);
+    Dequantize(root.WithOpName("output"), requantize.output,
+               requantize.output_min, requantize.output_max);
+  }
+
+  void TestFuseQuantizedConv2D() {
+    Scope root = Scope::NewRootScope();
+    Output input = QuantizedConst(root, "input", {1, 4, 5, 2}, 0.0f, 1.0f,
+                                  [](int i) { return (i % 7) / 7.0f; });
+    Output filter = QuantizedConst(root, "filter", {3, 3, 2, 3}, -1.0f, 1.0f,
+                                   [](int i) { return ((i % 5) - 2) / 2.0f; });
+    QuantizedConv2D conv(root.WithOpName("quantized_op"), input, filter,
+                         FloatConst(root, "input_min", 0.0f),
+                         FloatConst(root, "input_max", 1.0f),
+                         FloatConst(root, "filter_min", -1.0f),
+                         FloatConst(root, "filter_max", 1.0f), {1, 2, 2, 1},
+                         "SAME");
+    AddRequantizeAndOutput(root, conv.output, conv.min_output,
+                           conv.max_output);
+    TestFusion(root, "QuantizedConv2DAndRequantize");
+  }
+
+  void TestFuseQuantizedMatMul() {
+    Scope root = Scope::NewRootScope();
+    Output a = QuantizedConst(root, "a", {3, 4}, 0.0f, 2.0f,
+                              [](int i) { return (i % 9) / 4.5f; });
+    Output b = QuantizedConst(root, "b", {2, 4}, -1.0f, 1.0f,
+                              [](int i) { return ((i % 3) - 1) / 1.0f; });
+    QuantizedMatMul matmul(root.WithOpName("quantized_op"), a, b,
+                           FloatConst(root, "a_min", 0.0f),
+                           FloatConst(root, "a_max", 2.0f),
+                           FloatConst(root, "b_min", -1.0f),
+                           FloatConst(root, "b_max", 1.0f),
+                           QuantizedMatMul::TransposeB(true));
+    AddRequantizeAndOutput(root, matmul.out, matmul.min_out, matmul.max_out);
+    TestFusion(root, "QuantizedMatMulAndRequantize");
+  }
+
+  void TestFuseQuantizedBiasAdd() {
+    Scope root = Scope::NewRootScope();
+    Output input = QuantizedConst(root, "input", {2, 3, 4}, -10.0f, 10.0f,
+                                  [](int i) { return (i % 21) - 10.0f; });
+    Output bias = QuantizedConst(root, "bias", {4}, -5.0f, 5.0f,
+                                 [](int i) { return i - 2.0f; });
+    QuantizedBiasAdd bias_add(root.WithOpName("quantized_op"), input, bias,
+                              FloatConst(root, "input_min", -10.0f),
+                              FloatConst(root, "input_max", 10.0f),
+                              FloatConst(root, "bias_min", -5.0f),
+                              FloatConst(root, "bias_max", 5.0f), DT_QINT32);
+    AddRequantizeAndOutput(root, bias_add.output, bias_add.min_out,
+                           bias_add.max_out);
+    TestFusion(root, "QuantizedBiasAddAndRequantize");
+  }
+
+  void TestKeepSharedResults() {
+    Scope root = Scope::NewRootScope();
+    Output a = QuantizedConst(root, "a", {2, 2}, 0.0f, 1.0f,
+                              [](int i) { return i / 4.0f; });
+    Output b = QuantizedConst(root, "b", {2, 2}, 0.0f, 1.0f,
+                              [](int i) { return i / 4.0f; });
+    QuantizedMatMul matmul(root.WithOpName("quantized_op"), a, b,
+                           FloatConst(root, "a_min", 0.0f),
+                           FloatConst(root, "a_max", 1.0f),
+                           FloatConst(root, "b_min", 0.0f),
+                           FloatConst(root, "b_max", 1.0f));
+    AddRequantizeAndOutput(root, matmul.out, matmul.min_out, matmul.max_out);
+    // The 32-bit results are also used elsewhere, so the op must stay.
+    Dequantize(root.WithOpName("other_output"), matmul.out, matmul.min_out,
+               matmul.max_out);
+
+    GraphDef graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&graph_def));
+    GraphDef fused_graph_def;
+    TF_ASSERT_OK(FuseQuantizedRequantizes(
+        graph_def, {{}, {"output", "other_output"}}, &fused_graph_def));
+
+    std::map<string, const NodeDef*> node_map;
+    MapNamesToNodes(fused_graph_def, &node_map);
+    ASSERT_EQ(1, node_map.count("quantized_op"));
+    EXPECT_EQ("QuantizedMatMul", node_map.at("quantized_op")->op());
+    ASSERT_EQ(1, node_map.count("requantize"));
+    EXPECT_EQ("Requantize", node_map.at("requantize")->op());
+  }
+
+  void TestEightBitModelEndToEnd() {
+    GraphDef float_graph_def;
+    BuildFloatModel(1, 6, 3, 4, 5, &float_graph_def);
+    const Tensor input = ModelInput(1, 6, 3);
+    GraphDef fused_graph_def;
+    BuildFusedEightBitModel(float_graph_def, input, "fused_min_max_log.txt",
+                            &fused_graph_def);
+
+    // There shouldn't be any 32-bit results left between the ops, or any
+    // conversions back to float before the end of the model.
+    int fused_op_count = 0;
+    for (const NodeDef& node : fused_graph_def.node()) {
+      EXPECT_NE("Requantize", node.op()) << node.name();
+      EXPECT_NE("RequantizationRange", node.op()) << node.name();
+      if (StringPiece(node.op()).ends_with("AndRequantize")) {
+        ++fused_op_count;
+      }
+    }
+    EXPECT_EQ(3, fused_op_count);
+    int dequantize_count = 0;
+    for (const NodeDef& node : fused_graph_def.node()) {
+      if (node.op() == "Dequantize") {
+        ++dequantize_count;
+      }
+    }
+    EXPECT_EQ(1, dequantize_count);
+
+    std::unique_ptr<Session> float_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(float_session->Create(float_graph_def));
+    std::vector<Tensor> float_outputs;
+    TF_ASSERT_OK(
+        float_session->Run({{"input", input}}, {"output"}, {}, &float_outputs));
+
+    std::unique_ptr<Session> fused_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(fused_session->Create(fused_graph_def));
+    std::vector<Tensor> fused_outputs;
+    TF_ASSERT_OK(
+        fused_session->Run({{"input", input}}, {"output"}, {}, &fused_outputs));
+
+    test::ExpectTensorNear<float>(float_outputs[0], fused_outputs[0], 1.0);
+  }
+};
+
+TEST_F(FuseQuantizedRequantizesTest, TestFuseQuantizedConv2D) {
+  TestFuseQuantizedConv2D();
+}
+
+TEST_F(FuseQuantizedRequantizesTest, TestFuseQuantizedMatMul) {
+  TestFuseQuantizedMatMul();
+}
+
+TEST_F(FuseQuantizedRequantizesTest, TestFuseQuantizedBiasAdd) {
+  TestFuseQuantizedBiasAdd();
+}
+
+TEST_F(FuseQuantizedRequantizesTest, TestKeepSharedResults) {
+  TestKeepSharedResults();
+}
+
+TEST_F(FuseQuantizedRequantizesTest, TestEightBitModelEndToEnd) {
+  TestEightBitModelEndToEnd();
+}
+
+// Compares the float model with its fused eight bit version, on an input big
+// enough for the convolution and matrix multiply to dominate.
+static void BM_ConvBiasReluMatMul(int iters, bool eight_bit) {
+  testing::StopTiming();
+  const int batch = 8;
+  const int image_size = 32;
+  const int depth = 16;
+  GraphDef float_graph_def;
+  BuildFloatModel(batch, image_size, depth, 32, 64, &float_graph_def);
+  const Tensor input = ModelInput(batch, image_size, depth);
+  GraphDef graph_def;
+  if (eight_bit) {
+    BuildFusedEightBitModel(float_graph_def, input, "bm_min_max_log.txt",
+                            &graph_def);
+  } else {
+    graph_def = float_graph_def;
+  }
+
+  std::unique_ptr<Session> session(NewSession(SessionOptions()));
+  TF_CHECK_OK(session->Create(graph_def));
+  std::vector<Tensor> outputs;
+  // Warms up the kernels and any of their persistent buffers.
+  TF_CHECK_OK(session->Run({{"input", input}}, {"output"}, {}, &outputs));
+  testing::ItemsProcessed(static_cast<int64>(iters) * batch);
+  testing::UseRealTime();
+  testing::StartTiming();
+  for (int i = 0; i < iters; ++i) {
+    TF_CHECK_OK(session->Run({{"input", input}}, {"output"}, {}, &outputs));
+  }
+  testing::StopTiming();
+}
+
+static void BM_FloatConvBiasReluMatMul(int iters) {
+  BM_ConvBiasReluMatMul(iters, false);
+}
+BENCHMARK(BM_FloatConvBiasReluMatMul);
+
+static void BM_EightBitConvBiasReluMatMul(int iters) {
+  BM_ConvBiasReluMatMul(iters, true);
+}
+BENCHMARK(BM_EightBitConvBiasReluMatMul);
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
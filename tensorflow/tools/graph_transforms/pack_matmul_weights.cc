@@ -0,0 +1,155 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/kernels/cpu_isa_dispatch.h"
+#include "tensorflow/core/kernels/matmul_op_isa.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+namespace {
+
+// Sets *isa to the instruction set named by the "isa" parameter, or to the
+// most capable one this machine has packed MatMul kernels for if it's empty.
+Status GetPackingIsa(const TransformFuncContext& context, CpuIsa* isa) {
+  string isa_name;
+  TF_RETURN_IF_ERROR(context.GetOneStringParameter("isa", "", &isa_name));
+  if (!isa_name.empty()) {
+    if (!CpuIsaFromName(isa_name, isa)) {
+      return errors::InvalidArgument("Unknown instruction set: ", isa_name,
+                                     ", expected \"AVX\" or \"AVX2+FMA\"");
+    }
+    return Status::OK();
+  }
+  for (const CpuIsa candidate : {CpuIsa::kAvx2Fma, CpuIsa::kAvx}) {
+    if (LookupCpuIsaFunction(kMatMulFloatPackBIsaFunction, candidate) !=
+        nullptr) {
+      *isa = candidate;
+      return Status::OK();
+    }
+  }
+  return errors::FailedPrecondition(
+      "This machine has no packed MatMul kernels to pack the weights with");
+}
+
+}  // namespace
+
+// Replaces every float MatMul with a constant 'b' by a PackedMatMul, whose
+// 'b' is packed offline into the blocked layout that the MatMul kernels for
+// the "isa" instruction set compute on. The packing is done with those
+// kernels, so this has to run on a machine that supports "isa", and the
+// resulting graph only runs on such machines.
+Status PackMatMulWeights(const GraphDef& input_graph_def,
+                         const TransformFuncContext& context,
+                         GraphDef* output_graph_def) {
+  CpuIsa isa;
+  TF_RETURN_IF_ERROR(GetPackingIsa(context, &isa));
+  const MatMulFloatPackedSizeIsaFn packed_size =
+      LookupCpuIsaFunction<MatMulFloatPackedSizeIsaFn>(
+          kMatMulFloatPackedSizeIsaFunction, isa);
+  const MatMulFloatPackBIsaFn pack_b =
+      LookupCpuIsaFunction<MatMulFloatPackBIsaFn>(kMatMulFloatPackBIsaFunction,
+                                                  isa);
+  if (packed_size == nullptr || pack_b == nullptr) {
+    return errors::FailedPrecondition(
+        "Packing weights for ", CpuIsaName(isa),
+        " must be done on a machine that supports it");
+  }
+
+  GraphDef replaced_graph_def;
+  TF_RETURN_IF_ERROR(ReplaceMatchingOpTypes(
+      input_graph_def,  // clang-format off
+      {"MatMul",
+        {
+          {"*"},
+          {"Const"},
+        }
+      },  // clang-format on
+      [isa, packed_size, pack_b](const NodeMatch& match,
+                                 const std::set<string>& input_nodes,
+                                 const std::set<string>& output_nodes,
+                                 std::vector<NodeDef>* new_nodes) {
+        const NodeDef& matmul_node = match.node;
+        const NodeDef& input_node = match.inputs[0].node;
+        const NodeDef& weights_node = match.inputs[1].node;
+
+        DataType type;
+        TF_RETURN_IF_ERROR(GetNodeAttr(matmul_node, "T", &type));
+        const Tensor weights = GetNodeTensorAttr(weights_node, "value");
+        if (type != DT_FLOAT || weights.dtype() != DT_FLOAT ||
+            weights.dims() != 2 || weights.NumElements() == 0) {
+          MatchedNodesAsArray(match, new_nodes);
+          return Status::OK();
+        }
+
+        new_nodes->push_back(input_node);
+        // Other nodes may still need the unpacked weights.
+        if (output_nodes.count(weights_node.name())) {
+          new_nodes->push_back(weights_node);
+        }
+
+        bool transpose_a;
+        bool transpose_b;
+        TF_RETURN_IF_ERROR(
+            GetNodeAttr(matmul_node, "transpose_a", &transpose_a));
+        TF_RETURN_IF_ERROR(
+            GetNodeAttr(matmul_node, "transpose_b", &transpose_b));
+        const int64 k = weights.dim_size(transpose_b ? 1 : 0);
+        const int64 n = weights.dim_size(transpose_b ? 0 : 1);
+        Tensor packed_weights(DT_FLOAT, TensorShape({packed_size(n, k)}));
+        const int64 num_blocks =
+            (n + kMatMulFloatPackedBlockCols - 1) / kMatMulFloatPackedBlockCols;
+        pack_b(n, k, weights.flat<float>().data(), weights.dim_size(1),
+               transpose_b, 0, num_blocks, packed_weights.flat<float>().data());
+
+        NodeDef packed_weights_node;
+        packed_weights_node.set_op("Const");
+        packed_weights_node.set_name(matmul_node.name() + "_packed_weights");
+        packed_weights_node.set_device(weights_node.device());
+        SetNodeAttr("dtype", DT_FLOAT, &packed_weights_node);
+        SetNodeTensorAttr<float>("value", packed_weights, &packed_weights_node);
+        new_nodes->push_back(packed_weights_node);
+
+        NodeDef packed_matmul_node;
+        packed_matmul_node.set_op("PackedMatMul");
+        packed_matmul_node.set_name(matmul_node.name());
+        packed_matmul_node.set_device(matmul_node.device());
+        AddNodeInput(matmul_node.input(0), &packed_matmul_node);
+        AddNodeInput(packed_weights_node.name(), &packed_matmul_node);
+        for (int i = 2; i < matmul_node.input_size(); ++i) {
+          AddNodeInput(matmul_node.input(i), &packed_matmul_node);
+        }
+        SetNodeAttr("transpose_a", transpose_a, &packed_matmul_node);
+        SetNodeAttr("n", n, &packed_matmul_node);
+        SetNodeAttr("k", k, &packed_matmul_node);
+        SetNodeAttr("isa", CpuIsaName(isa), &packed_matmul_node);
+        new_nodes->push_back(packed_matmul_node);
+
+        return Status::OK();
+      },
+      {}, &replaced_graph_def));
+  *output_graph_def = replaced_graph_def;
+  return Status::OK();
+}
+
+REGISTER_GRAPH_TRANSFORM("pack_matmul_weights", PackMatMulWeights);
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
@@ -0,0 +1,190 @@
+/* Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/cpu_isa_dispatch.h"
+#include "tensorflow/core/kernels/matmul_op_isa.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/public/session.h"
+#include "tensorflow/tools/graph_transforms/transform_utils.h"
+
+namespace tensorflow {
+namespace graph_transforms {
+
+// Declare here, so we don't need a public header.
+Status PackMatMulWeights(const GraphDef& input_graph_def,
+                         const TransformFuncContext& context,
+                         GraphDef* output_graph_def);
+
+class PackMatMulWeightsTest : public ::testing::Test {
+ protected:
+  // The packed kernels are only built for x86 CPUs with AVX and up.
+  bool HasPackedKernels() {
+    if (LookupCpuIsaFunction(kMatMulFloatPackBIsaFunction) == nullptr) {
+      LOG(INFO) << "Skipping the test, as there are no packed MatMul kernels "
+                   "for this CPU";
+      return false;
+    }
+    return true;
+  }
+
+  void TestPackMatMulWeights(int m, int k, int n, bool transpose_a,
+                             bool transpose_b) {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    Tensor input_data(DT_FLOAT, transpose_a ? TensorShape({k, m})
+                                            : TensorShape({m, k}));
+    input_data.flat<float>().setRandom();
+    Output input_op = Placeholder(root.WithOpName("input_op"), DT_FLOAT);
+
+    Tensor weights_data(DT_FLOAT, transpose_b ? TensorShape({n, k})
+                                              : TensorShape({k, n}));
+    weights_data.flat<float>().setRandom();
+    Output weights_op =
+        Const(root.WithOpName("weights_op"), Input::Initializer(weights_data));
+
+    Output matmul_op = MatMul(
+        root.WithOpName("output"), input_op, weights_op,
+        MatMul::TransposeA(transpose_a).TransposeB(transpose_b));
+
+    GraphDef original_graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&original_graph_def));
+
+    std::unique_ptr<Session> original_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(original_session->Create(original_graph_def));
+    std::vector<Tensor> original_outputs;
+    TF_ASSERT_OK(original_session->Run({{"input_op", input_data}}, {"output"},
+                                       {}, &original_outputs));
+
+    GraphDef packed_graph_def;
+    TF_ASSERT_OK(PackMatMulWeights(original_graph_def,
+                                   {{"input_op"}, {"output"}},
+                                   &packed_graph_def));
+
+    std::unique_ptr<Session> packed_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(packed_session->Create(packed_graph_def));
+    std::vector<Tensor> packed_outputs;
+    TF_ASSERT_OK(packed_session->Run({{"input_op", input_data}}, {"output"},
+                                     {}, &packed_outputs));
+
+    test::ExpectTensorNear<float>(original_outputs[0], packed_outputs[0],
+                                  1e-3);
+
+    int packed_matmul_count = 0;
+    for (const NodeDef& node : packed_graph_def.node()) {
+      EXPECT_NE("MatMul", node.op());
+      EXPECT_NE("weights_op", node.name());
+      if (node.op() == "PackedMatMul") {
+        ++packed_matmul_count;
+      }
+    }
+    EXPECT_EQ(1, packed_matmul_count);
+  }
+
+  void TestKeepSharedWeights() {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    Tensor input_data(DT_FLOAT, TensorShape({4, 3}));
+    input_data.flat<float>().setRandom();
+    Output input_op = Placeholder(root.WithOpName("input_op"), DT_FLOAT);
+
+    Tensor weights_data(DT_FLOAT, TensorShape({3, 3}));
+    weights_data.flat<float>().setRandom();
+    Output weights_op =
+        Const(root.WithOpName("weights_op"), Input::Initializer(weights_data));
+
+    Output matmul_op =
+        MatMul(root.WithOpName("matmul_op"), input_op, weights_op);
+    Output add_op = Add(root.WithOpName("output"), matmul_op, weights_op);
+
+    GraphDef original_graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&original_graph_def));
+
+    std::unique_ptr<Session> original_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(original_session->Create(original_graph_def));
+    std::vector<Tensor> original_outputs;
+    TF_ASSERT_OK(original_session->Run({{"input_op", input_data}}, {"output"},
+                                       {}, &original_outputs));
+
+    GraphDef packed_graph_def;
+    TF_ASSERT_OK(PackMatMulWeights(original_graph_def,
+                                   {{"input_op"}, {"output"}},
+                                   &packed_graph_def));
+
+    std::unique_ptr<Session> packed_session(NewSession(SessionOptions()));
+    TF_ASSERT_OK(packed_session->Create(packed_graph_def));
+    std::vector<Tensor> packed_outputs;
+    TF_ASSERT_OK(packed_session->Run({{"input_op", input_data}}, {"output"},
+                                     {}, &packed_outputs));
+
+    test::ExpectTensorNear<float>(original_outputs[0], packed_outputs[0],
+                                  1e-5);
+
+    std::map<string, const NodeDef*> node_map;
+    MapNamesToNodes(packed_graph_def, &node_map);
+    ASSERT_EQ(1, node_map.count("weights_op"));
+    EXPECT_EQ("Const", node_map.at("weights_op")->op());
+    ASSERT_EQ(1, node_map.count("matmul_op"));
+    EXPECT_EQ("PackedMatMul", node_map.at("matmul_op")->op());
+  }
+
+  void TestUnknownIsa() {
+    auto root = tensorflow::Scope::NewRootScope();
+    using namespace ::tensorflow::ops;  // NOLINT(build/namespaces)
+
+    Output input_op = Placeholder(root.WithOpName("input_op"), DT_FLOAT);
+    Output weights_op = Const(root.WithOpName("weights_op"),
+                              {{1.0f, 2.0f}, {3.0f, 4.0f}});
+    Output matmul_op = MatMul(root.WithOpName("output"), input_op, weights_op);
+
+    GraphDef original_graph_def;
+    TF_ASSERT_OK(root.ToGraphDef(&original_graph_def));
+
+    TransformFuncContext context;
+    context.input_names = {"input_op"};
+    context.output_names = {"output"};
+    context.params["isa"] = {"AVX-512"};
+    GraphDef packed_graph_def;
+    EXPECT_FALSE(
+        PackMatMulWeights(original_graph_def, context, &packed_graph_def)
+            .ok());
+  }
+};
+
+TEST_F(PackMatMulWeightsTest, TestPackMatMulWeights) {
+  if (!HasPackedKernels()) return;
+  for (int transpose_a = 0; transpose_a < 2; ++transpose_a) {
+    for (int transpose_b = 0; transpose_b < 2; ++transpose_b) {
+      TestPackMatMulWeights(1, 3, 4, transpose_a, transpose_b);
+      TestPackMatMulWeights(8, 300, 200, transpose_a, transpose_b);
+      TestPackMatMulWeights(129, 257, 97, transpose_a, transpose_b);
+    }
+  }
+}
+
+TEST_F(PackMatMulWeightsTest, TestKeepSharedWeights) {
+  if (!HasPackedKernels()) return;
+  TestKeepSharedWeights();
+}
+
+TEST_F(PackMatMulWeightsTest, TestUnknownIsa) { TestUnknownIsa(); }
+
+}  // namespace graph_transforms
+}  // namespace tensorflow
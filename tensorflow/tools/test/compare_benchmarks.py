@@ -0,0 +1,95 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Flags the benchmarks that regressed against a baseline.
+
+Compares TestResults written by run_and_gather_logs (e.g. the kernel
+benchmarks of //tensorflow/tools/test:kernel_benchmarks) and exits with a
+non-zero status if any benchmark got slower than the threshold allows:
+
+  compare_benchmarks --baseline=base/*.json --current=new/*.json
+"""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import argparse
+import sys
+
+from tensorflow.python.platform import app
+from tensorflow.python.platform import gfile
+from tensorflow.tools.test import compare_benchmarks_lib
+
+FLAGS = None
+
+
+def _load(patterns):
+  results = []
+  for pattern in patterns.split(","):
+    for path in sorted(gfile.Glob(pattern)):
+      results.append(compare_benchmarks_lib.load_test_results(path))
+  return results
+
+
+def main(unused_args):
+  comparisons = compare_benchmarks_lib.compare(
+      _load(FLAGS.baseline),
+      _load(FLAGS.current),
+      threshold=FLAGS.threshold,
+      min_time=FLAGS.min_time_us * 1e-6)
+  print(compare_benchmarks_lib.format_comparisons(comparisons))
+  failing = [compare_benchmarks_lib.REGRESSION]
+  if FLAGS.fail_on_missing:
+    failing.append(compare_benchmarks_lib.MISSING)
+  num_failures = sum(1 for c in comparisons if c.status in failing)
+  if num_failures:
+    print("%d of %d benchmarks regressed or are missing." %
+          (num_failures, len(comparisons)))
+    sys.exit(1)
+
+
+if __name__ == "__main__":
+  parser = argparse.ArgumentParser()
+  parser.register(
+      "type", "bool", lambda v: v.lower() in ("true", "t", "y", "yes"))
+  parser.add_argument(
+      "--baseline",
+      type=str,
+      default="",
+      help="Comma-separated globs of the baseline TestResults files.")
+  parser.add_argument(
+      "--current",
+      type=str,
+      default="",
+      help="Comma-separated globs of the TestResults files to check.")
+  parser.add_argument(
+      "--threshold",
+      type=float,
+      default=0.1,
+      help="The relative slowdown above which a benchmark regressed.")
+  parser.add_argument(
+      "--min_time_us",
+      type=float,
+      default=1.0,
+      help="Benchmarks faster than this per iteration are not compared.")
+  parser.add_argument(
+      "--fail_on_missing",
+      type="bool",
+      nargs="?",
+      const=True,
+      default=False,
+      help="Whether benchmarks missing from the current results fail.")
+  FLAGS, unparsed = parser.parse_known_args()
+  app.run(main=main, argv=[sys.argv[0]] + unparsed)
@@ -0,0 +1,137 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Library for comparing benchmark TestResults against a baseline."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import collections
+
+from google.protobuf import json_format
+from google.protobuf import text_format
+
+from tensorflow.core.util import test_log_pb2
+from tensorflow.python.platform import gfile
+
+# The statuses of a benchmark in a comparison.
+OK = "OK"
+REGRESSION = "REGRESSION"
+IMPROVEMENT = "IMPROVEMENT"
+MISSING = "MISSING"
+NEW = "NEW"
+
+# The comparison of one benchmark. The times are wall times per iteration, in
+# seconds, or None if the benchmark is not in the respective results.
+BenchmarkComparison = collections.namedtuple(
+    "BenchmarkComparison",
+    ["name", "baseline_time", "current_time", "ratio", "status"])
+
+
+def load_test_results(path):
+  """Reads a TestResults proto, as written by run_and_gather_logs.
+
+  Args:
+    path: A file holding the proto in JSON (if the name ends with ".json"),
+      binary or text format.
+
+  Returns:
+    A test_log_pb2.TestResults proto.
+  """
+  results = test_log_pb2.TestResults()
+  content = gfile.GFile(path, "rb").read()
+  if path.endswith(".json"):
+    json_format.Parse(content, results)
+    return results
+  try:
+    results.ParseFromString(content)
+  except Exception:  # pylint: disable=broad-except
+    results = test_log_pb2.TestResults()
+    text_format.Merge(content, results)
+  return results
+
+
+def per_iteration_times(test_results_list):
+  """Returns the wall time per iteration of every benchmark entry.
+
+  Args:
+    test_results_list: A list of TestResults protos.
+
+  Returns:
+    A dict from "target:benchmark" names to seconds per iteration.
+  """
+  times = {}
+  for results in test_results_list:
+    for entry in results.entries.entry:
+      name = "%s:%s" % (results.target, entry.name)
+      times[name] = entry.wall_time / max(entry.iters, 1)
+  return times
+
+
+def compare(baseline, current, threshold=0.1, min_time=0.0):
+  """Compares the benchmarks of "current" to those of "baseline".
+
+  A benchmark regresses if its wall time per iteration grew by more than
+  "threshold" (a fraction of the baseline time), and improves if it
+  shrank by as much.
+
+  Args:
+    baseline: A list of TestResults protos.
+    current: A list of TestResults protos.
+    threshold: The relative change below which a benchmark is OK.
+    min_time: Benchmarks faster than this many seconds per iteration in both
+      results are always OK, as their timings are too noisy to compare.
+
+  Returns:
+    A list of BenchmarkComparisons, sorted by name.
+  """
+  baseline_times = per_iteration_times(baseline)
+  current_times = per_iteration_times(current)
+  comparisons = []
+  for name in sorted(set(baseline_times) | set(current_times)):
+    baseline_time = baseline_times.get(name)
+    current_time = current_times.get(name)
+    ratio = None
+    if baseline_time is None:
+      status = NEW
+    elif current_time is None:
+      status = MISSING
+    else:
+      ratio = current_time / baseline_time if baseline_time > 0 else 1.0
+      if max(baseline_time, current_time) < min_time:
+        status = OK
+      elif ratio > 1 + threshold:
+        status = REGRESSION
+      elif ratio < 1 / (1 + threshold):
+        status = IMPROVEMENT
+      else:
+        status = OK
+    comparisons.append(
+        BenchmarkComparison(name, baseline_time, current_time, ratio, status))
+  return comparisons
+
+
+def format_comparisons(comparisons):
+  """Returns a table of "comparisons", one line per benchmark."""
+
+  def format_time(t):
+    return "-" if t is None else "%.3fus" % (t * 1e6)
+
+  lines = []
+  for c in comparisons:
+    ratio = "-" if c.ratio is None else "%.3f" % c.ratio
+    lines.append("%-12s %12s %12s %8s  %s" % (c.status, format_time(
+        c.baseline_time), format_time(c.current_time), ratio, c.name))
+  return "\n".join(lines)
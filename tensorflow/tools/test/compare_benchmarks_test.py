@@ -0,0 +1,89 @@
+# Copyright 2017 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for compare_benchmarks_lib."""
+
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import os
+
+from google.protobuf import json_format
+
+from tensorflow.core.util import test_log_pb2
+from tensorflow.python.platform import gfile
+from tensorflow.python.platform import googletest
+from tensorflow.tools.test import compare_benchmarks_lib
+
+
+def _results(target, times):
+  results = test_log_pb2.TestResults()
+  results.target = target
+  for name, (iters, wall_time) in times.items():
+    entry = results.entries.entry.add()
+    entry.name = name
+    entry.iters = iters
+    entry.wall_time = wall_time
+  return results
+
+
+class CompareBenchmarksTest(googletest.TestCase):
+
+  def testCompare(self):
+    baseline = _results("//k:test", {
+        "BM_Same": (100, 1.0),
+        "BM_Slower": (100, 1.0),
+        "BM_Faster": (100, 1.0),
+        "BM_Gone": (10, 1.0),
+        "BM_Tiny": (1000000, 0.1),
+    })
+    # Per iteration: 10ms, 15ms, 5ms, and 0.3us instead of 0.1us.
+    current = _results("//k:test", {
+        "BM_Same": (200, 2.0),
+        "BM_Slower": (100, 1.5),
+        "BM_Faster": (200, 1.0),
+        "BM_New": (10, 1.0),
+        "BM_Tiny": (1000000, 0.3),
+    })
+    comparisons = compare_benchmarks_lib.compare(
+        [baseline], [current], threshold=0.1, min_time=1e-6)
+    statuses = {c.name: c.status for c in comparisons}
+    self.assertEqual({
+        "//k:test:BM_Same": compare_benchmarks_lib.OK,
+        "//k:test:BM_Slower": compare_benchmarks_lib.REGRESSION,
+        "//k:test:BM_Faster": compare_benchmarks_lib.IMPROVEMENT,
+        "//k:test:BM_Gone": compare_benchmarks_lib.MISSING,
+        "//k:test:BM_New": compare_benchmarks_lib.NEW,
+        "//k:test:BM_Tiny": compare_benchmarks_lib.OK,
+    }, statuses)
+    slower = [c for c in comparisons if c.name == "//k:test:BM_Slower"][0]
+    self.assertAlmostEqual(1.5, slower.ratio)
+    self.assertIn("REGRESSION",
+                  compare_benchmarks_lib.format_comparisons(comparisons))
+
+  def testLoadTestResults(self):
+    results = _results("//k:test", {"BM_A": (10, 2.0)})
+    json_path = os.path.join(googletest.GetTempDir(), "results.json")
+    gfile.GFile(json_path, "w").write(json_format.MessageToJson(results))
+    binary_path = os.path.join(googletest.GetTempDir(), "results.pb")
+    gfile.GFile(binary_path, "wb").write(results.SerializeToString())
+    self.assertEqual(results,
+                     compare_benchmarks_lib.load_test_results(json_path))
+    self.assertEqual(results,
+                     compare_benchmarks_lib.load_test_results(binary_path))
+
+
+if __name__ == "__main__":
+  googletest.main()
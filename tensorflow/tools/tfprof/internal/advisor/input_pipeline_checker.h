@@ -0,0 +1,123 @@
+/* Copyright 2016 The TensorFlow Authors All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+// This checker checks how long the steps wait for their input pipelines.
+#ifndef THIRD_PARTY_TENSORFLOW_TOOLS_TFPROF_INTERNAL_ADVISOR_INPUT_PIPELINE_CHECKER_H_
+#define THIRD_PARTY_TENSORFLOW_TOOLS_TFPROF_INTERNAL_ADVISOR_INPUT_PIPELINE_CHECKER_H_
+
+#include "tensorflow/tools/tfprof/internal/advisor/checker.h"
+
+namespace tensorflow {
+namespace tfprof {
+
+class InputPipelineChecker : public Checker {
+ public:
+  string name() override { return "InputPipelineChecker"; }
+
+ private:
+  // The span of a step, and the time its ops spent getting input elements.
+  struct StepInput {
+    int64 start_micros = 0;
+    int64 end_micros = 0;
+    int64 input_micros = 0;
+  };
+
+  std::vector<string> Check(const TFStats* stats) override {
+    if (!stats) {
+      fprintf(stderr, "Missing profiles (e.g. graph, run_meta). Skip %s\n",
+              name().c_str());
+      return reports_;
+    }
+    for (const auto& n : stats->nodes()) {
+      BuildStepInputs(n.second.get());
+    }
+    return CheckInternal();
+  }
+
+  std::vector<string> CheckInternal() {
+    if (slowest_input_node_.empty()) {
+      return reports_;
+    }
+    int64 step_micros = 0;
+    int64 input_micros = 0;
+    for (const auto& s : step_inputs_) {
+      step_micros += s.second.end_micros - s.second.start_micros;
+      input_micros += s.second.input_micros;
+    }
+    if (step_micros <= 0) {
+      return reports_;
+    }
+    double input_fraction = 1.0 * input_micros / step_micros;
+    int level = input_fraction >= 0.5 ? 2 : (input_fraction >= 0.1 ? 1 : 0);
+    string report = strings::Printf(
+        "%s: Steps spend %.2f of their time waiting for input, most of it in "
+        "%s (%lld us per step).",
+        kLevel[level], input_fraction, slowest_input_node_.c_str(),
+        slowest_input_micros_ / static_cast<int64>(step_inputs_.size()));
+    if (level > 0) {
+      strings::StrAppend(&report,
+                         " The input pipeline is likely a bottleneck. Run "
+                         "with TF_DATASET_STATS=1 to find its slowest stage "
+                         "in the /tensorflow/data/ metrics.");
+    }
+    reports_.push_back(report);
+    return reports_;
+  }
+
+  static bool IsInputOp(const TFGraphNode* node) {
+    static const char* const kInputOps[] = {
+        "IteratorGetNext",   "QueueDequeue",     "QueueDequeueV2",
+        "QueueDequeueMany",  "QueueDequeueManyV2", "QueueDequeueUpTo",
+        "QueueDequeueUpToV2"};
+    for (const char* op : kInputOps) {
+      if (node->op_types().find(op) != node->op_types().end()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void BuildStepInputs(const TFGraphNode* node) {
+    const bool is_input_op = IsInputOp(node);
+    int64 node_input_micros = 0;
+    for (const auto& step_exec : node->all_op_execs()) {
+      const ExecStep& exec = step_exec.second;
+      StepInput& step = step_inputs_[step_exec.first];
+      if (exec.all_start_micros() != 0 &&
+          (step.start_micros == 0 ||
+           exec.all_start_micros() < step.start_micros)) {
+        step.start_micros = exec.all_start_micros();
+      }
+      step.end_micros = std::max(step.end_micros, exec.latest_end_micros());
+      if (is_input_op) {
+        step.input_micros += exec.exec_micros();
+        node_input_micros += exec.exec_micros();
+      }
+    }
+    if (is_input_op && node_input_micros > slowest_input_micros_) {
+      slowest_input_micros_ = node_input_micros;
+      slowest_input_node_ = node->name();
+    }
+  }
+
+  std::map<int64, StepInput> step_inputs_;
+  string slowest_input_node_;
+  int64 slowest_input_micros_ = 0;
+  std::vector<string> reports_;
+};
+
+}  // namespace tfprof
+}  // namespace tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_TOOLS_TFPROF_INTERNAL_ADVISOR_INPUT_PIPELINE_CHECKER_H_
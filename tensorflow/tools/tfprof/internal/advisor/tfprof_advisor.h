@@ -18,6 +18,7 @@ limitations under the License.
 
 #include "tensorflow/tools/tfprof/internal/advisor/accelerator_utilization_checker.h"
 #include "tensorflow/tools/tfprof/internal/advisor/checker.h"
+#include "tensorflow/tools/tfprof/internal/advisor/input_pipeline_checker.h"
 #include "tensorflow/tools/tfprof/internal/advisor/internal_checker_runner.h"
 #include "tensorflow/tools/tfprof/internal/advisor/operation_checker.h"
 
@@ -37,6 +38,8 @@ class Advisor {
     reports[au_checker.name()] = au_checker.Run(stats_);
     OperationChecker op_checker;
     reports[op_checker.name()] = op_checker.Run(stats_);
+    InputPipelineChecker input_checker;
+    reports[input_checker.name()] = input_checker.Run(stats_);
 
     for (const auto& checker_r : reports) {
       fprintf(stdout, "%s reports:\n", checker_r.first.c_str());
@@ -31,6 +31,9 @@ class TFProfAdvisorTest : public ::testing::Test {
     stats_->AddNodeForTest(
         "n1", CreateNode("n1", "Conv2D", {{"data_format", "NHWC"}}, 10, 2));
     stats_->AddNodeForTest("n2", CreateNode("n2", "Conv2D", {}, 20, 2));
+    stats_->AddNodeForTest(
+        "n3", CreateNode("n3", "IteratorGetNext", {}, 1, 8,
+                         "/job:localhost/replica:0/task:0/cpu:0"));
     advisor_.reset(new Advisor(stats_.get()));
   }
 
@@ -38,7 +41,8 @@ class TFProfAdvisorTest : public ::testing::Test {
                                           const string& type,
                                           std::map<string, string> attrs,
                                           int64 start_miros,
-                                          int64 end_rel_micros) {
+                                          int64 end_rel_micros,
+                                          const string& device = "") {
     node_defs_.push_back(std::unique_ptr<NodeDef>(new NodeDef()));
     NodeDef* def = node_defs_.back().get();
 
@@ -52,6 +56,10 @@ class TFProfAdvisorTest : public ::testing::Test {
     NodeExecStats node_stat;
     node_stat.set_all_start_micros(start_miros);
     node_stat.set_op_end_rel_micros(end_rel_micros);
+    if (!device.empty()) {
+      node->AddStepStat(0, device, node_stat);
+      return node;
+    }
     node->AddStepStat(0, "/job:localhost/replica:0/task:0/gpu:0", node_stat);
     node->AddStepStat(0, "/job:localhost/replica:0/task:0/gpu:0:stream:all",
                       node_stat);
@@ -69,6 +77,7 @@ TEST_F(TFProfAdvisorTest, Basics) {
   std::map<string, std::vector<string>> reports = advisor_->Advise();
   EXPECT_TRUE(reports.find("AcceleratorUtilizationChecker") != reports.end());
   EXPECT_TRUE(reports.find("OperationChecker") != reports.end());
+  EXPECT_TRUE(reports.find("InputPipelineChecker") != reports.end());
 }
 
 TEST_F(TFProfAdvisorTest, OperationChecker) {
@@ -84,5 +93,13 @@ TEST_F(TFProfAdvisorTest, UtilizationChecker) {
                   .contains("low utilization"));
 }
 
+TEST_F(TFProfAdvisorTest, InputPipelineChecker) {
+  std::map<string, std::vector<string>> reports = advisor_->Advise();
+  EXPECT_EQ(reports["InputPipelineChecker"].size(), 1);
+  EXPECT_TRUE(StringPiece(reports["InputPipelineChecker"][0]).contains("n3"));
+  EXPECT_TRUE(StringPiece(reports["InputPipelineChecker"][0])
+                  .contains("bottleneck"));
+}
+
 }  // namespace tfprof
 }  // namespace tensorflow
@@ -266,6 +266,9 @@ string TFCode::FormatNode(CodeNode* node, const Options& opts, int64 indent) {
   }
   std::vector<string> time_attrs = FormatTimes(node, opts);
   attrs.insert(attrs.end(), time_attrs.begin(), time_attrs.end());
+  if (opts.select.find(kShown[11]) != opts.select.end()) {
+    attrs.push_back(FormatCounters(node->node->counters()));
+  }
 
   if (opts.select.find(kShown[5]) != opts.select.end() &&
       !node->node->devices().empty()) {
@@ -47,8 +47,20 @@ bool IsCanonicalDevice(const string& device) { return CountAsCPUTime(device); }
 // For ops on cpu:
 // It will only appear as cpu:0.
 
+void AddCounters(const NodeExecCounters& counters, NodeExecCounters* total) {
+  total->set_cycles(total->cycles() + counters.cycles());
+  total->set_cpu_cycles(total->cpu_cycles() + counters.cpu_cycles());
+  total->set_instructions(total->instructions() + counters.instructions());
+  total->set_cache_references(total->cache_references() +
+                              counters.cache_references());
+  total->set_cache_misses(total->cache_misses() + counters.cache_misses());
+}
+
 void ExecStep::AddTimeStats(const string& dev, const NodeExecStats& step_stat) {
   devices_.insert(dev);
+  if (step_stat.has_counters()) {
+    AddCounters(step_stat.counters(), &counters_);
+  }
   if (step_stat.all_start_micros() > 0) {
     if (all_start_micros_ > 0) {
       all_start_micros_ = std::min(
@@ -42,6 +42,9 @@ TensorShapeProto VecToShapeProto(const std::vector<int64> shape_vec);
 
 class TFGraphNode;
 
+// Adds the hardware event counts "counters" to "*total".
+void AddCounters(const NodeExecCounters& counters, NodeExecCounters* total);
+
 class ExecStep {
  public:
   ExecStep(TFGraphNode* node)
@@ -87,6 +90,9 @@ class ExecStep {
   }
   int64 allocator_bytes_in_use() const { return allocator_bytes_in_use_; }
 
+  // The hardware event counts of all executions of the op in the step.
+  const NodeExecCounters& counters() const { return counters_; }
+
  private:
   TFGraphNode* node;
   // The earliest/latest time including scheduling and execution.
@@ -118,6 +124,7 @@ class ExecStep {
   int64 allocator_bytes_in_use_;
   // output_idx -> {output_bytes, memory_ptr}
   std::map<int64, std::pair<int64, uint64>> output_bytes_;
+  NodeExecCounters counters_;
 };
 
 class TFGraphNode {
@@ -228,6 +235,32 @@ class TFGraphNode {
     return total_micros / execs_.size();
   }
 
+  // These are the hardware event counts of a step, or average of
+  // multiple step, when step < 0.
+  NodeExecCounters counters(int64 step) const {
+    // Empty when no RunMetadata is provided.
+    if (execs_.empty()) {
+      return NodeExecCounters();
+    }
+    if (step >= 0) {
+      auto exec = execs_.find(step);
+      CHECK(exec != execs_.end());
+      return exec->second.counters();
+    }
+
+    NodeExecCounters total;
+    for (const auto& exec : execs_) {
+      AddCounters(exec.second.counters(), &total);
+    }
+    const int64 num_steps = execs_.size();
+    total.set_cycles(total.cycles() / num_steps);
+    total.set_cpu_cycles(total.cpu_cycles() / num_steps);
+    total.set_instructions(total.instructions() / num_steps);
+    total.set_cache_references(total.cache_references() / num_steps);
+    total.set_cache_misses(total.cache_misses() / num_steps);
+    return total;
+  }
+
   // This is cpu computation time of a step, or average of
   // multiple step, when step < 0.
   int64 cpu_exec_micros(int64 step) const {
@@ -319,7 +352,7 @@ class TFGraphNode {
   }
 
   int64 float_ops() const { return float_ops_; }
-  const CodeDef& code() { return code_; }
+  const CodeDef& code() const { return code_; }
   string canonical_device() const { return canonical_device_; }
   string host_device() const { return host_device_; }
   const std::set<string>& op_types() const { return op_types_; }
@@ -381,6 +414,7 @@ class TFMultiGraphNode {
     exec_micros_ = 0;
     accelerator_exec_micros_ = 0;
     cpu_exec_micros_ = 0;
+    counters_.Clear();
 
     requested_bytes_ = 0;
     float_ops_ = 0;
@@ -401,6 +435,7 @@ class TFMultiGraphNode {
       exec_micros_ += node->exec_micros(step);
       accelerator_exec_micros_ += node->accelerator_exec_micros(step);
       cpu_exec_micros_ += node->cpu_exec_micros(step);
+      AddCounters(node->counters(step), &counters_);
 
       requested_bytes_ += node->requested_bytes(step);
       float_ops_ += node->float_ops();
@@ -439,6 +474,7 @@ class TFMultiGraphNode {
   int64 exec_micros() const { return exec_micros_; }
   int64 accelerator_exec_micros() const { return accelerator_exec_micros_; }
   int64 cpu_exec_micros() const { return cpu_exec_micros_; }
+  const NodeExecCounters& counters() const { return counters_; }
 
   int64 requested_bytes() const { return requested_bytes_; }
 
@@ -483,6 +519,7 @@ class TFMultiGraphNode {
   int64 exec_micros_;
   int64 accelerator_exec_micros_;
   int64 cpu_exec_micros_;
+  NodeExecCounters counters_;
 
   int64 requested_bytes_;
   int64 float_ops_;
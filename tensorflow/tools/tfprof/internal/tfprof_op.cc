@@ -234,6 +234,9 @@ string TFOp::FormatNode(OpNode* node, OpNode* root, const Options& opts) {
       opts.select.find(kShown[1]) == opts.select.end()) {
     attrs.push_back(FormatCPUExecTime(node, root));
   }
+  if (opts.select.find(kShown[11]) != opts.select.end()) {
+    attrs.push_back(FormatCounters(node->node->counters()));
+  }
   if (opts.select.find(kShown[2]) != opts.select.end()) {
     double accu_pct = 0.0;
     double pct = 0.0;
@@ -56,7 +56,7 @@ static const char* const kOrderBy[] = {
 static const char* const kShown[] = {
     "bytes",     "micros",   "params",     "float_ops",    "tensor_value",
     "device",    "op_types", "occurrence", "input_shapes", "accelerator_micros",
-    "cpu_micros"};
+    "cpu_micros", "hw_counters"};
 
 static const char* const kCmds[] = {
     "scope", "graph", "code", "op", "set", "help",
@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/tools/tfprof/internal/tfprof_timeline.h"
 
+#include <algorithm>
+#include <iterator>
 #include <utility>
 
 #include "tensorflow/core/lib/core/status.h"
@@ -34,6 +36,45 @@ string GetTimeDevName(const string& dev) {
 string GetMemoryLaneName(const string& dev) {
   return strings::StrCat("mem usage on:", dev);
 }
+
+// The code location that created the op of "node": the innermost frame of
+// its trace outside of the TensorFlow Python library, if there is one.
+string GetCodeLocation(const GraphNode* node) {
+  const CodeDef& code = node->node->code();
+  for (int i = code.traces_size() - 1; i >= 0; --i) {
+    const CodeDef::Trace& trace = code.traces(i);
+    if (trace.file().find("tensorflow/python/") == trace.file().npos ||
+        i == 0) {
+      return strings::StrCat(trace.file(), ":", trace.lineno());
+    }
+  }
+  return "";
+}
+
+// The "/job:<job>/replica:<replica>/task:<task>" prefix of "dev", or "" if
+// it doesn't name a task.
+string GetTaskName(const string& dev) {
+  size_t pos = dev.find("/task:");
+  if (pos == dev.npos) return "";
+  return dev.substr(0, dev.find('/', pos + 1));
+}
+
+// If "node" receives a tensor on "dev" from a device of another task, returns
+// the sending device. The execution of such a receive is mostly the time it
+// waits for the other task.
+string GetCrossTaskSendDevice(const GraphNode* node, const string& dev) {
+  const string& op = node->node->op();
+  if (op != "_Recv" && op != "_HostRecv") return "";
+  auto attr = node->node->op_attrs().find("send_device");
+  if (attr == node->node->op_attrs().end()) return "";
+  const string& send_device = attr->second->s();
+  const string send_task = GetTaskName(send_device);
+  if (send_task.empty() || send_task == GetTaskName(dev)) return "";
+  return send_device;
+}
+
+// The number of live tensors listed for each device at its peak.
+const int kMaxPeakTensors = 20;
 }  // namespace
 
 Json::Value ChromeTraceFormatter::CreateEvent(const string& ph,
@@ -125,6 +166,8 @@ void MemoryTracker::TrackNode(int64 step, const GraphNode* node) {
     dev.earliest_ref[tensor_name] = node->node->all_start_micros(step);
     dev.tensor_size[tensor_name] =
         node->node->accelerator_persistent_bytes(step);
+    dev.producer[tensor_name] = node->name();
+    dev.producer_code[tensor_name] = GetCodeLocation(node);
     // TODO(xpan): Need latest_ref?
   }
   if (node->node->accelerator_temp_bytes(step)) {
@@ -132,6 +175,8 @@ void MemoryTracker::TrackNode(int64 step, const GraphNode* node) {
     dev.earliest_ref[tensor_name] = node->node->all_start_micros(step);
     dev.latest_ref[tensor_name] = end_micros;
     dev.tensor_size[tensor_name] = node->node->accelerator_temp_bytes(step);
+    dev.producer[tensor_name] = node->name();
+    dev.producer_code[tensor_name] = GetCodeLocation(node);
   }
   if (node->node->allocator_bytes_in_use(step) > 0) {
     dev.allocator_stats[end_micros] = node->node->allocator_bytes_in_use(step);
@@ -163,6 +208,8 @@ void MemoryTracker::TrackNodeConnection(int64 step, const GraphNode* node,
 
   src_dev.tensor_size[tensor_name] = output_bytes;
   src_dev.earliest_ref[tensor_name] = src->node->all_start_micros(step);
+  src_dev.producer[tensor_name] = src->name();
+  src_dev.producer_code[tensor_name] = GetCodeLocation(src);
 
   int64 src_end_micros = src->node->latest_end_micros(step);
 
@@ -177,6 +224,9 @@ void MemoryTracker::TrackNodeConnection(int64 step, const GraphNode* node,
         strings::StrCat(tensor_name, node->node->canonical_device());
     dest_dev.tensor_size[dest_tensor_name] = output_bytes;
     dest_dev.earliest_ref[dest_tensor_name] = transfer_micros;
+    dest_dev.producer[dest_tensor_name] = src->name();
+    dest_dev.producer_code[dest_tensor_name] =
+        src_dev.producer_code[tensor_name];
     dest_dev.latest_ref[dest_tensor_name] =
         std::max(dest_dev.latest_ref[dest_tensor_name],
                  node->node->latest_end_micros(step));
@@ -186,6 +236,91 @@ void MemoryTracker::TrackNodeConnection(int64 step, const GraphNode* node,
   }
 }
 
+MemoryTracker::Peak MemoryTracker::FindPeak(const Device& dev) {
+  // Sweep the changes of the live bytes in time order. At equal times, the
+  // allocations go first: a tensor released at the time another one is
+  // allocated is still referenced then.
+  std::map<int64, std::pair<int64, int64>> changes;  // time->{alloc, free}
+  for (const auto& size : dev.tensor_size) {
+    auto earliest = dev.earliest_ref.find(size.first);
+    if (earliest == dev.earliest_ref.end()) continue;
+    changes[earliest->second].first += size.second;
+    auto latest = dev.latest_ref.find(size.first);
+    if (latest != dev.latest_ref.end()) {
+      changes[latest->second].second += size.second;
+    }
+  }
+  Peak peak;
+  int64 live_bytes = 0;
+  for (const auto& change : changes) {
+    live_bytes += change.second.first;
+    if (live_bytes > peak.live_bytes) {
+      peak.live_bytes = live_bytes;
+      peak.micros = change.first;
+    }
+    live_bytes -= change.second.second;
+  }
+
+  for (const auto& size : dev.tensor_size) {
+    auto earliest = dev.earliest_ref.find(size.first);
+    if (earliest == dev.earliest_ref.end() || earliest->second > peak.micros) {
+      continue;
+    }
+    auto latest = dev.latest_ref.find(size.first);
+    if (latest != dev.latest_ref.end() && latest->second < peak.micros) {
+      continue;
+    }
+    LiveTensor tensor;
+    tensor.name = size.first;
+    tensor.bytes = size.second;
+    auto producer = dev.producer.find(size.first);
+    if (producer != dev.producer.end()) tensor.producer = producer->second;
+    auto code = dev.producer_code.find(size.first);
+    if (code != dev.producer_code.end()) tensor.producer_code = code->second;
+    peak.tensors.push_back(tensor);
+  }
+  std::sort(peak.tensors.begin(), peak.tensors.end(),
+            [](const LiveTensor& a, const LiveTensor& b) {
+              return a.bytes > b.bytes;
+            });
+
+  // The last allocator measurement at or before the peak.
+  auto stats = dev.allocator_stats.upper_bound(peak.micros);
+  if (stats != dev.allocator_stats.begin()) {
+    peak.allocator_bytes = std::prev(stats)->second;
+  }
+  for (const auto& s : dev.allocator_stats) {
+    peak.max_allocator_bytes = std::max(peak.max_allocator_bytes, s.second);
+  }
+  return peak;
+}
+
+void Timeline::ReportMemoryPeaks() {
+  for (const auto& dev : mem_tracker_.devices()) {
+    const MemoryTracker::Peak peak = MemoryTracker::FindPeak(dev.second);
+    if (peak.live_bytes == 0) continue;
+    fprintf(stdout, "\nPeak memory on %s at %s: %s in %zu live tensors.\n",
+            dev.first.c_str(), FormatTime(peak.micros).c_str(),
+            FormatMemory(peak.live_bytes).c_str(), peak.tensors.size());
+    if (peak.allocator_bytes > 0) {
+      fprintf(stdout,
+              "Allocator in use at the peak: %s (max %s), of which %s not "
+              "held by live tensors (fragmentation or untracked).\n",
+              FormatMemory(peak.allocator_bytes).c_str(),
+              FormatMemory(peak.max_allocator_bytes).c_str(),
+              FormatMemory(std::max<int64>(
+                               peak.allocator_bytes - peak.live_bytes, 0))
+                  .c_str());
+    }
+    for (int i = 0; i < peak.tensors.size() && i < kMaxPeakTensors; ++i) {
+      const MemoryTracker::LiveTensor& tensor = peak.tensors[i];
+      fprintf(stdout, "  %10s  %s %s\n", FormatMemory(tensor.bytes).c_str(),
+              tensor.producer.c_str(), tensor.producer_code.c_str());
+    }
+  }
+  fflush(stdout);
+}
+
 void Timeline::AllocateTimeNodes(GraphNode* gnode) {
   if (gnode->Trackable(step_)) {
     TrackNode(gnode);
@@ -258,9 +393,16 @@ void Timeline::GenerateGraphTimeline(const std::vector<GraphNode*>& gnodes) {
         Json::Value args(Json::objectValue);
         args["name"] = Json::Value(tnode->name());
         args["op"] = Json::Value(tnode->name());
-        chrome_formatter_.EmitRegion(node.first, tnode->exec_micros,
-                                     process.first, lane.first, "Op",
-                                     tnode->name(), args);
+        // Waits for other tasks get their own category, so that they can be
+        // told apart from computation in merged distributed timelines.
+        const string send_device =
+            GetCrossTaskSendDevice(tnode->node, tnode->process->device);
+        if (!send_device.empty()) {
+          args["send_device"] = Json::Value(send_device);
+        }
+        chrome_formatter_.EmitRegion(
+            node.first, tnode->exec_micros, process.first, lane.first,
+            send_device.empty() ? "Op" : "CrossTaskWait", tnode->name(), args);
         // Flow is a directed arrow pointing from src to dst.
         // TODO(xpan): Disable flow to reduce json file size for now. Need
         // to think of a better way to make flow interpretable.
@@ -287,6 +429,7 @@ void Timeline::GenerateGraphTimeline(const std::vector<GraphNode*>& gnodes) {
                                     alloc_stats.second);
     }
   }
+  ReportMemoryPeaks();
   OutputTimeline();
 }
 
@@ -102,8 +102,39 @@ class MemoryTracker {
     std::map<string, int64> latest_ref;
     // ground truth memory stats. time->bytes.
     std::map<int64, int64> allocator_stats;
+    // The node that produced each tensor, and the code location that created
+    // it (empty without code traces).
+    std::map<string, string> producer;
+    std::map<string, string> producer_code;
   };
 
+  // A tensor live at the peak of the memory usage of a device.
+  struct LiveTensor {
+    string name;
+    string producer;
+    string producer_code;
+    int64 bytes;
+  };
+
+  // The peak of the predicted memory usage of a device.
+  struct Peak {
+    // The time of the peak, and the total bytes of the tensors live then.
+    int64 micros = 0;
+    int64 live_bytes = 0;
+    // The allocator ground truth at the peak, and its maximum over the step.
+    // The bytes in use at the peak but not held by live tensors are
+    // fragmentation and untracked allocations.
+    int64 allocator_bytes = 0;
+    int64 max_allocator_bytes = 0;
+    // The tensors live at the peak, largest first.
+    std::vector<LiveTensor> tensors;
+  };
+
+  // Finds the time when the tensors of "dev" live at once are the largest.
+  // A tensor is live from its earliest to its latest reference, or to the end
+  // of the step if it has no latest reference (e.g. persistent tensors).
+  static Peak FindPeak(const Device& dev);
+
   void TrackNode(int64 step, const GraphNode* node);
 
   void TrackNodeConnection(int64 step, const GraphNode* node,
@@ -171,6 +202,10 @@ class Timeline {
 
   void AllocateTimeNodes(GraphNode* gnode);
 
+  // Prints the peak memory usage of every device, with the tensors live at
+  // the peak and their producers.
+  void ReportMemoryPeaks();
+
   void AllocateLanes();
 
   int64 AllocatePID();
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/tools/tfprof/internal/tfprof_constants.h"
 #include "tensorflow/tools/tfprof/internal/tfprof_options.h"
+#include "tensorflow/tools/tfprof/internal/tfprof_timeline.h"
 #include "tensorflow/tools/tfprof/internal/tfprof_utils.h"
 #include "tensorflow/tools/tfprof/tfprof_log.pb.h"
 #include "tensorflow/tools/tfprof/tfprof_output.pb.h"
@@ -85,6 +86,30 @@ TEST_F(TFProfTimelineTest, ScopeView) {
   EXPECT_EQ(10135186027625211652ull, Hash64(dump_str));
 }
 
+TEST(MemoryTrackerTest, FindPeak) {
+  MemoryTracker::Device dev;
+  // "a" is live over [0, 10], "b" over [5, 20], "c" over [12, 15] and the
+  // persistent "d" from 8 on.
+  dev.tensor_size = {{"a", 100}, {"b", 50}, {"c", 200}, {"d", 10}};
+  dev.earliest_ref = {{"a", 0}, {"b", 5}, {"c", 12}, {"d", 8}};
+  dev.latest_ref = {{"a", 10}, {"b", 20}, {"c", 15}};
+  dev.producer = {{"a", "A"}, {"b", "B"}, {"c", "C"}, {"d", "D"}};
+  dev.producer_code = {{"c", "model.py:12"}};
+  dev.allocator_stats = {{0, 100}, {12, 300}, {16, 400}};
+
+  const MemoryTracker::Peak peak = MemoryTracker::FindPeak(dev);
+  EXPECT_EQ(12, peak.micros);
+  EXPECT_EQ(260, peak.live_bytes);
+  EXPECT_EQ(300, peak.allocator_bytes);
+  EXPECT_EQ(400, peak.max_allocator_bytes);
+  ASSERT_EQ(3, peak.tensors.size());
+  EXPECT_EQ("c", peak.tensors[0].name);
+  EXPECT_EQ("C", peak.tensors[0].producer);
+  EXPECT_EQ("model.py:12", peak.tensors[0].producer_code);
+  EXPECT_EQ("b", peak.tensors[1].name);
+  EXPECT_EQ("d", peak.tensors[2].name);
+}
+
 // TODO(xpan): tfprof_log is too large to include in testdata when adding
 // code traces.
 
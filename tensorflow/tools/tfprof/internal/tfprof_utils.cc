@@ -61,6 +61,26 @@ string FormatMemory(int64 bytes) {
   }
 }
 
+string FormatCounters(const NodeExecCounters& counters) {
+  string ipc = "N/A";
+  if (counters.cpu_cycles() > 0) {
+    ipc = strings::Printf(
+        "%.2f", static_cast<double>(counters.instructions()) /
+                    counters.cpu_cycles());
+  }
+  string cache_misses = "N/A";
+  if (counters.cache_references() > 0) {
+    cache_misses =
+        strings::Printf("%.2f%%", 100.0 * counters.cache_misses() /
+                                      counters.cache_references());
+  }
+  return strings::Printf("%s cycles, %s IPC, %s cache misses",
+                         counters.cycles() > 0
+                             ? FormatNumber(counters.cycles()).c_str()
+                             : "N/A",
+                         ipc.c_str(), cache_misses.c_str());
+}
+
 string FormatShapes(const std::vector<int64>& shape) {
   return str_util::Join(shape, "x");
 }
@@ -321,7 +341,7 @@ void PrintHelp() {
       "op statistics matching -account_type_regexes recursively.\n\n"
       "  -select: Comma-separated list of metrics to show: [bytes|micros|"
       "accelerator_micros|cpu_micros|params|float_ops|tensor_value|device|"
-      "op_types|input_shapes]."
+      "op_types|input_shapes|hw_counters]."
       "\n\n"
       "  -dump_to_file: Dump the output to a file, instead of terminal.\n\n"
       ""
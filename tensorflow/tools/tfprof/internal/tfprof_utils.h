@@ -20,6 +20,7 @@ limitations under the License.
 #include <vector>
 
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/step_stats.pb.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/protobuf/config.pb.h"
@@ -35,6 +36,10 @@ string FormatMemory(int64 bytes);
 
 string FormatShapes(const std::vector<int64>& shapes);
 
+// Formats the cycles, instructions per cycle and cache miss rate of
+// "counters", or "N/A" for the ones that weren't counted.
+string FormatCounters(const NodeExecCounters& counters);
+
 tensorflow::Status ParseCmdLine(const string& line, string* cmd,
                                 tensorflow::tfprof::Options* opts);
 